@@ -58,22 +58,42 @@
 
 #ifndef CO_USE_GLOBALS
     #include <stdlib.h> /*  for malloc, free */
+    #include <string.h> /*  for memset */
     static uint32_t CO_memoryUsed = 0; /* informative */
 #endif
 
+/* If defined, CO_new() places all objects into one memory block, see
+ * CO_setArena(). */
+/* #define CO_USE_ARENA */
+#ifdef CO_USE_ARENA
+  #ifdef CO_USE_GLOBALS
+    #error CO_USE_ARENA can not be used with CO_USE_GLOBALS
+  #endif
+  #ifndef CO_ARENA_ALIGN
+    #define CO_ARENA_ALIGN      8U  /* alignment of each group of objects */
+  #endif
+    #define CO_ARENA_ROUND(size) (((size) + (CO_ARENA_ALIGN - 1U)) & ~(uint32_t)(CO_ARENA_ALIGN - 1U))
+    static uint8_t             *CO_arenaBuffer = NULL;  /* from CO_setArena() */
+    static uint32_t             CO_arenaBufferSize = 0;
+#endif
+
+/* Memory footprint, see CO_getMemoryInfo() */
+    static CO_memoryInfo_t      CO_memoryInfo[CO_MEM_NO_GROUPS];
+
+
+/* Number of OD extensions, see CO_OD_EXTENSIONS_SPARSE */
+#ifdef CO_OD_EXTENSIONS_SPARSE
+    #define CO_NO_OD_EXT        CO_OD_EXTENSIONS_SIZE
+#else
+    #define CO_NO_OD_EXT        CO_OD_NoOfElements
+#endif
+
 
 /* Global variables ***********************************************************/
     extern const CO_OD_entry_t CO_OD[CO_OD_NoOfElements];  /* Object Dictionary array */
-    static CO_t COO;
     CO_t *CO = NULL;
 
-    static CO_CANrx_t          *CO_CANmodule_rxArray0;
-    static CO_CANtx_t          *CO_CANmodule_txArray0;
-    static CO_OD_extension_t   *CO_SDO_ODExtensions;
-    static CO_HBconsNode_t     *CO_HBcons_monitoredNodes;
 #if CO_NO_TRACE > 0
-    static uint32_t            *CO_traceTimeBuffers[CO_NO_TRACE];
-    static int32_t             *CO_traceValueBuffers[CO_NO_TRACE];
   #ifdef CO_USE_GLOBALS
   #ifndef CO_TRACE_BUFFER_SIZE_FIXED
     #define CO_TRACE_BUFFER_SIZE_FIXED 100
@@ -109,6 +129,12 @@
     #endif
     #define CO_NO_HB_PROD      1                                      /*  Producer Heartbeat Cont */
     #define CO_NO_DAISY        1                                      /*  Daisy Chain */
+    #ifndef CO_NO_TIME
+        #define CO_NO_TIME     0
+    #endif
+    #ifndef CO_NO_EM_CONS
+        #define CO_NO_EM_CONS  0
+    #endif
 
     #define CO_RXCAN_NMT       0                                      /*  index for NMT message */
     #define CO_RXCAN_SYNC      1                                      /*  index for SYNC message */
@@ -118,8 +144,10 @@
     #define CO_RXCAN_CONS_HB  (CO_RXCAN_SDO_CLI+CO_NO_SDO_CLIENT)     /*  start index for Heartbeat Consumer messages */
     #define CO_RXCAN_DAISY    (CO_RXCAN_CONS_HB+CO_NO_HB_CONS)        /*  index for Daisychain Event message */
     #define CO_RXCAN_LSS      (CO_RXCAN_DAISY+CO_NO_DAISY)            /*  index for LSS rx message */
+    #define CO_RXCAN_TIME     (CO_RXCAN_LSS+CO_NO_LSS_SERVER+CO_NO_LSS_CLIENT) /*  index for TIME message */
+    #define CO_RXCAN_EM_CONS  (CO_RXCAN_TIME+CO_NO_TIME)              /*  index for Emergency messages of all nodes */
     /* total number of received CAN messages */
-    #define CO_RXCAN_NO_MSGS (1+CO_NO_SYNC+CO_NO_RPDO+CO_NO_SDO_SERVER+CO_NO_SDO_CLIENT+CO_NO_HB_CONS+CO_NO_LSS_SERVER+CO_NO_LSS_CLIENT+CO_NO_DAISY)
+    #define CO_RXCAN_NO_MSGS (1+CO_NO_SYNC+CO_NO_RPDO+CO_NO_SDO_SERVER+CO_NO_SDO_CLIENT+CO_NO_HB_CONS+CO_NO_LSS_SERVER+CO_NO_LSS_CLIENT+CO_NO_DAISY+CO_NO_TIME+CO_NO_EM_CONS)
 
     #define CO_TXCAN_NMT       0                                      /*  index for NMT master message */
     #define CO_TXCAN_SYNC      CO_TXCAN_NMT+CO_NO_NMT_MASTER          /*  index for SYNC message */
@@ -130,8 +158,15 @@
     #define CO_TXCAN_HB       (CO_TXCAN_SDO_CLI+CO_NO_SDO_CLIENT)     /*  index for Heartbeat message */
     #define CO_TXCAN_DAISY    (CO_TXCAN_HB+CO_NO_HB_PROD)             /*  index for Daisychain Event message */
     #define CO_TXCAN_LSS      (CO_TXCAN_DAISY+CO_NO_DAISY)            /*  index for LSS tx message */
+#ifdef CO_SDO_FAST_EXPEDITED
+    #define CO_NO_SDO_FAST     CO_NO_SDO_SERVER                       /*  SDO server fast path response */
+#else
+    #define CO_NO_SDO_FAST     0
+#endif
+    #define CO_TXCAN_SDO_FAST (CO_TXCAN_LSS+CO_NO_LSS_SERVER+CO_NO_LSS_CLIENT) /*  start index for SDO server fast path response */
+    #define CO_TXCAN_TIME     (CO_TXCAN_SDO_FAST+CO_NO_SDO_FAST)      /*  index for TIME message */
     /* total number of transmitted CAN messages */
-    #define CO_TXCAN_NO_MSGS (CO_NO_NMT_MASTER+CO_NO_SYNC+CO_NO_EMERGENCY+CO_NO_TPDO+CO_NO_SDO_SERVER+CO_NO_SDO_CLIENT+CO_NO_HB_PROD+CO_NO_LSS_SERVER+CO_NO_LSS_CLIENT+CO_NO_DAISY)
+    #define CO_TXCAN_NO_MSGS (CO_NO_NMT_MASTER+CO_NO_SYNC+CO_NO_EMERGENCY+CO_NO_TPDO+CO_NO_SDO_SERVER+CO_NO_SDO_CLIENT+CO_NO_HB_PROD+CO_NO_LSS_SERVER+CO_NO_LSS_CLIENT+CO_NO_DAISY+CO_NO_SDO_FAST+CO_NO_TIME)
 
 
 #ifdef CO_USE_GLOBALS
@@ -139,7 +174,7 @@
     static CO_CANrx_t           COO_CANmodule_rxArray0[CO_RXCAN_NO_MSGS];
     static CO_CANtx_t           COO_CANmodule_txArray0[CO_TXCAN_NO_MSGS];
     static CO_SDO_t             COO_SDO[CO_NO_SDO_SERVER];
-    static CO_OD_extension_t    COO_SDO_ODExtensions[CO_OD_NoOfElements];
+    static CO_OD_extension_t    COO_SDO_ODExtensions[CO_NO_OD_EXT];
     static CO_EM_t              COO_EM;
     static CO_EMpr_t            COO_EMpr;
     static CO_NMT_t             COO_NMT;
@@ -160,6 +195,9 @@
 #if CO_DAISY_PRODUCER == 1
     static CO_DaisyProducer_t   CO0_DaisyProducer;
 #endif
+#if CO_NO_TIME == 1
+    static CO_TIME_t            COO_TIME;
+#endif
 #if CO_NO_SDO_CLIENT != 0
     static CO_SDOclient_t       COO_SDOclient[CO_NO_SDO_CLIENT];
 #endif
@@ -171,16 +209,181 @@
 #endif
 
 
-/* Helper function for NMT master *********************************************/
+#ifdef CO_USE_STATISTICS
+/* sub indexes, see CO_getStatistics() */
+#define CO_STAT_SUB_SERVICES    15
+#define CO_STAT_SUB_RPDO       (CO_STAT_SUB_SERVICES+1)
+#define CO_STAT_SUB_TPDO       (CO_STAT_SUB_RPDO+3*CO_NO_RPDO)
+#define CO_STAT_SUB_BUS        (CO_STAT_SUB_TPDO+3*CO_NO_TPDO)
+#define CO_STAT_SUB_END        (CO_STAT_SUB_BUS+3)
+#if CO_STAT_SUB_END > 256
+    #error Too many PDOs for CANopen statistics record.
+#endif
+#endif
+
+#ifdef CO_TPDO_SYNC_BUCKETS
+#define CO_TPDO_BUCKET_END  0xFFFFU
+#endif
+
+
+/* State of one CANopen instance **********************************************/
+/*
+ * Everything, what CO_process(), CO_process_SYNC_RPDO() and CO_process_TPDO()
+ * use, is kept here, so instances from CO_newInstance() can be processed
+ * independently from each other. CO_t is the first member, pointer to it is
+ * also pointer to the instance.
+ */
+typedef struct{
+    CO_t                CO;                     /* public part, see CANopen.h */
+    CO_CANrx_t         *CANmodule_rxArray0;
+    CO_CANtx_t         *CANmodule_txArray0;
+    CO_OD_extension_t  *SDO_ODExtensions;
+    CO_HBconsNode_t    *HBcons_monitoredNodes;
+#if CO_NO_TRACE > 0
+    uint32_t           *traceTimeBuffers[CO_NO_TRACE];
+    int32_t            *traceValueBuffers[CO_NO_TRACE];
+    uint32_t            traceBufferSize[CO_NO_TRACE];
+#endif
+#ifdef CO_USE_ARENA
+    uint8_t            *arena;                  /* memory block used by the objects */
+#endif
+
+    /* Object dictionary, see CO_getODvariable(). The default instance uses
+     * CO_OD and the global variables, other instances own copies of them. */
+    const CO_OD_entry_t *OD;
+    CO_OD_entry_t      *ODentries;              /* own copy of CO_OD or NULL */
+    CO_OD_entryRecord_t *ODrecords;             /* own copies of all records or NULL */
+    struct sCO_OD_RAM  *ODram;
+    struct sCO_OD_EEPROM *ODeeprom;
+    struct sCO_OD_ROM  *ODrom;
+    bool_t              ODramExternal;          /* ODram from CO_setODmemory() */
+    bool_t              ODeepromExternal;       /* ODeeprom from CO_setODmemory() */
+
+#ifdef CO_USE_STATISTICS
+    /* CAN message counters per buffer index */
+    uint32_t            statisticsRxCount[CO_RXCAN_NO_MSGS];
+    uint32_t            statisticsTxCount[CO_TXCAN_NO_MSGS];
+    CO_statistics_t     statisticsCAN;
+    uint16_t            TPDOloadLimit;          /* from CO_setTPDOloadLimit() */
+#endif
+#ifdef CO_OD_PROFILING
+    /* Accesses per OD entry, parallel to the OD, see CO_SDO_initProfile() */
+    CO_OD_profile_t     ODProfile[CO_OD_NoOfElements];
+#endif
+#ifdef CO_OD_COLUMNS
+    /* Object dictionary in column layout, see CO_SDO_initColumns() */
+    CO_OD_columns_t     ODColumns;
+    uint16_t            ODColumnsIndex[CO_OD_NoOfElements];
+    uint8_t             ODColumnsMaxSubIndex[CO_OD_NoOfElements];
+    uint16_t            ODColumnsAttribute[CO_OD_NoOfElements];
+    uint16_t            ODColumnsLength[CO_OD_NoOfElements];
+    void               *ODColumnsData[CO_OD_NoOfElements];
+    CO_OD_columnMember_t ODColumnsMembers[CO_OD_COLUMNS_MEMBERS];
+#endif
+#ifdef CO_SDO_TRANSFER_LOG
+    /* Transfers of all SDO servers, see CO_SDO_initTransferLog() */
+    CO_SDO_transferLog_t SDOtransferLog;
+    CO_SDO_transferRecord_t SDOtransferRecords[CO_SDO_TRANSFER_LOG_SIZE];
+#endif
+#ifdef CO_OD_FIND_TABLE
+    /* Lookup table of the OD, shared by all SDO servers */
+    uint16_t            ODFindTable[CO_OD_FIND_TABLE_SIZE];
+#endif
+#ifdef CO_SDO_RX_RING_SIZE
+    /* Queued requests of each SDO server, see CO_SDO_initRxRing() */
+    CO_rxRing_t         SDOrxRing[CO_NO_SDO_SERVER];
+    CO_rxRingMsg_t      SDOrxRingMsgs[CO_NO_SDO_SERVER][CO_SDO_RX_RING_SIZE];
+#endif
+
+    /* Set of SDO servers with ongoing transfer or new request */
+    uint32_t            SDOactive[(CO_NO_SDO_SERVER + 31) / 32];
+    volatile void      *SDOactiveNew;
+
+#ifdef CO_RPDO_DEADLINE
+    /* Reception deadline monitoring of all RPDOs, see CO_RPDO_setDeadline() */
+    CO_RPDOdeadline_t   RPDOdeadline;
+#endif
+
+    /* Lists of enabled PDOs, indexes into CO->RPDO and CO->TPDO */
+    uint16_t            RPDOactive[CO_NO_RPDO]; /* asynchronous, then synchronous */
+    uint16_t            RPDOactiveAsync;        /* end of asynchronous RPDOs */
+    uint16_t            RPDOactiveCount;
+    uint16_t            TPDOactive[CO_NO_TPDO]; /* event driven, acyclic, cyclic */
+    uint16_t            TPDOactiveEvent;        /* end of event driven TPDOs */
+    uint16_t            TPDOactiveAcyclic;      /* end of synchronous acyclic TPDOs */
+    uint16_t            TPDOactiveCount;
+    volatile void      *PDOconfigNew;
+
+    /* Send budget of event driven TPDOs, see CO_setTPDObudget() */
+    uint16_t            TPDObudgetBurst;        /* size of the token bucket */
+    uint16_t            TPDObudgetPeriod;       /* time per token in 100 us, 0 = no budget */
+    uint16_t            TPDObudgetTokens;
+    uint32_t            TPDObudgetTimer;        /* time since the last token in us */
+
+#ifdef CO_TPDO_SYNC_BUCKETS
+    /* Synchronous cyclic TPDOs by SYNC cycle, in which they are due next */
+    uint16_t            TPDObucket[256];        /* first TPDO due in SYNC cycle */
+    uint16_t            TPDObucketNext[CO_NO_TPDO]; /* next TPDO in the same bucket */
+    uint8_t             TPDObucketDue[CO_NO_TPDO];  /* SYNC cycle, in which TPDO is due */
+    uint16_t            TPDObucketWaiting;      /* TPDOs waiting for SYNC start value */
+    uint8_t             TPDObucketCycle;        /* current SYNC cycle */
+#endif
+
+#ifdef CO_TPDO_PRESTAGE
+    /* Synchronous TPDOs staged for the next SYNC, see CO_TPDOstageProcess() */
+    uint16_t            TPDOstaged[CO_NO_TPDO];
+    uint16_t            TPDOstagedCount;        /* changed inside CO_LOCK_OD() */
+#endif
+
 #if CO_NO_NMT_MASTER == 1
-    CO_CANtx_t *NMTM_txBuff = 0;
+    CO_CANtx_t         *NMTM_txBuff;
+    CO_NMTmaster_t      NMTmaster;              /* see CO->NMTmaster */
+#endif
+#if CO_NO_EM_CONS == 1
+    CO_EMconsumer_t     EMcons;                 /* see CO->EMcons */
+#endif
+    uint16_t            ms50;                   /* timer for CO_NMT_blinkingProcess50ms() */
+}CO_instance_t;
+
+#define CO_INSTANCE(CO)     ((CO_instance_t *)(CO))
+
+    static CO_instance_t        COO;            /* default instance, see CO_new() */
+
+
+/* Helper function for pre-staged TPDOs, see CO_TPDO_PRESTAGE *****************/
+#ifdef CO_TPDO_PRESTAGE
+#ifndef CO_LOCK_OD_RX
+#error CO_TPDO_PRESTAGE requires CO_LOCK_OD_RX() from CO_driver.h, see drvTemplate
+#endif
+/*
+ * Send staged TPDOs, called by the SYNC object right after SYNC reception or
+ * transmission.
+ */
+static void CO_TPDOreleaseStaged(void *object){
+    CO_t *CO = (CO_t*)object;
+    CO_instance_t *inst = CO_INSTANCE(CO);
+    uint16_t i;
+
+    CO_LOCK_OD_RX();
+    for(i=0; i<inst->TPDOstagedCount; i++){
+        CO_TPDO_release(CO->TPDO[inst->TPDOstaged[i]], CO->SYNC);
+    }
+    inst->TPDOstagedCount = 0;
+    CO_UNLOCK_OD_RX();
+}
+#endif
 
+
+/* Helper function for NMT master *********************************************/
+#if CO_NO_NMT_MASTER == 1
     static CO_ReturnError_t CO_sendNMTcommandInternal(
             CO_t      *CO,
             uint8_t    command,
             uint8_t    nodeID,
             bool_t     ignoreBcst)
     {
+        CO_CANtx_t *NMTM_txBuff = CO_INSTANCE(CO)->NMTM_txBuff;
+
         if(NMTM_txBuff == 0){
             /* error, CO_CANtxBufferInit() was not called for this buffer. */
             return CO_ERROR_TX_UNCONFIGURED; /* -11 */
@@ -232,253 +435,830 @@
 #endif
 
 
+/* Set one entry of the memory footprint table */
+static void CO_memoryInfoSet(CO_memoryGroup_t group, const char *name, uint16_t count, uint32_t size){
+    CO_memoryInfo[group].name = name;
+    CO_memoryInfo[group].count = count;
+    CO_memoryInfo[group].size = size * count;
+}
+
+/* Calculate memory footprint of all objects from their sizes */
+static void CO_memoryInfoInit(void){
+#if CO_NO_TRACE > 0
+    uint32_t traceBufSize = 0;
+    int16_t i;
+#endif
+
+    CO_memoryInfoSet(CO_MEM_CANMODULE,    "CANmodule",    1,                  sizeof(CO_CANmodule_t));
+    CO_memoryInfoSet(CO_MEM_CANRX,        "CANrx",        CO_RXCAN_NO_MSGS,   sizeof(CO_CANrx_t));
+    CO_memoryInfoSet(CO_MEM_CANTX,        "CANtx",        CO_TXCAN_NO_MSGS,   sizeof(CO_CANtx_t));
+    CO_memoryInfoSet(CO_MEM_SYNC,         "SYNC",         1,                  sizeof(CO_SYNC_t));
+    CO_memoryInfoSet(CO_MEM_RPDO,         "RPDO",         CO_NO_RPDO,         sizeof(CO_RPDO_t));
+    CO_memoryInfoSet(CO_MEM_TPDO,         "TPDO",         CO_NO_TPDO,         sizeof(CO_TPDO_t));
+    CO_memoryInfoSet(CO_MEM_NMT,          "NMT",          1,                  sizeof(CO_NMT_t));
+    CO_memoryInfoSet(CO_MEM_HBCONS,       "HBcons",       1,                  sizeof(CO_HBconsumer_t));
+    CO_memoryInfoSet(CO_MEM_HBCONS_NODES, "HBconsNodes",  CO_NO_HB_CONS,      sizeof(CO_HBconsNode_t));
+    CO_memoryInfoSet(CO_MEM_EM,           "EM",           1,                  sizeof(CO_EM_t));
+    CO_memoryInfoSet(CO_MEM_EMPR,         "EMpr",         1,                  sizeof(CO_EMpr_t));
+    CO_memoryInfoSet(CO_MEM_SDO,          "SDO",          CO_NO_SDO_SERVER,   sizeof(CO_SDO_t));
+    CO_memoryInfoSet(CO_MEM_OD_EXT,       "ODextensions", CO_NO_OD_EXT,       sizeof(CO_OD_extension_t));
+#if CO_NO_SDO_CLIENT != 0
+    CO_memoryInfoSet(CO_MEM_SDO_CLIENT,   "SDOclient",    CO_NO_SDO_CLIENT,   sizeof(CO_SDOclient_t));
+#else
+    CO_memoryInfoSet(CO_MEM_SDO_CLIENT,   "SDOclient",    0,                  0);
+#endif
+#if CO_NO_LSS_SERVER == 1
+    CO_memoryInfoSet(CO_MEM_LSS,          "LSSslave",     1,                  sizeof(CO_LSSslave_t));
+#elif CO_NO_LSS_CLIENT == 1
+    CO_memoryInfoSet(CO_MEM_LSS,          "LSSmaster",    1,                  sizeof(CO_LSSmaster_t));
+#else
+    CO_memoryInfoSet(CO_MEM_LSS,          "LSS",          0,                  0);
+#endif
+#if CO_DAISY_CONSUMER == 1
+    CO_memoryInfoSet(CO_MEM_DAISY,        "DaisyConsumer",1,                  sizeof(CO_DaisyConsumer_t));
+#elif CO_DAISY_PRODUCER == 1
+    CO_memoryInfoSet(CO_MEM_DAISY,        "DaisyProducer",1,                  sizeof(CO_DaisyProducer_t));
+#else
+    CO_memoryInfoSet(CO_MEM_DAISY,        "Daisy",        0,                  0);
+#endif
+#if CO_NO_TIME == 1
+    CO_memoryInfoSet(CO_MEM_TIME,         "TIME",         1,                  sizeof(CO_TIME_t));
+#else
+    CO_memoryInfoSet(CO_MEM_TIME,         "TIME",         0,                  0);
+#endif
 #if CO_NO_TRACE > 0
-static uint32_t CO_traceBufferSize[CO_NO_TRACE];
+    for(i=0; i<CO_NO_TRACE; i++) {
+  #ifdef CO_USE_GLOBALS
+        traceBufSize += CO_TRACE_BUFFER_SIZE_FIXED;
+  #else
+        traceBufSize += OD_traceConfig[i].size;
+  #endif
+    }
+    CO_memoryInfoSet(CO_MEM_TRACE,        "trace",        CO_NO_TRACE,        sizeof(CO_trace_t));
+    CO_memoryInfoSet(CO_MEM_TRACE_BUF,    "traceBuffers", CO_NO_TRACE,        0);
+    CO_memoryInfo[CO_MEM_TRACE_BUF].size = traceBufSize * (sizeof(uint32_t) + sizeof(int32_t));
+#else
+    CO_memoryInfoSet(CO_MEM_TRACE,        "trace",        0,                  0);
+    CO_memoryInfoSet(CO_MEM_TRACE_BUF,    "traceBuffers", 0,                  0);
 #endif
+}
+
 
 /******************************************************************************/
-CO_ReturnError_t CO_new(void)
-{
+uint32_t CO_getMemoryInfo(const CO_memoryInfo_t **info){
+    uint32_t total = 0;
     int16_t i;
-#ifndef CO_USE_GLOBALS
-    uint16_t errCnt;
-#endif
 
-    /* Verify parameters from CO_OD */
-    if(   sizeof(OD_TPDOCommunicationParameter_t) != sizeof(CO_TPDOCommPar_t)
-       || sizeof(OD_TPDOMappingParameter_t) != sizeof(CO_TPDOMapPar_t)
-       || sizeof(OD_RPDOCommunicationParameter_t) != sizeof(CO_RPDOCommPar_t)
-       || sizeof(OD_RPDOMappingParameter_t) != sizeof(CO_RPDOMapPar_t))
-    {
-        return CO_ERROR_PARAMETERS;
+    for(i=0; i<CO_MEM_NO_GROUPS; i++){
+        total += CO_memoryInfo[i].size;
     }
+    if(info != NULL){
+        *info = CO_memoryInfo;
+    }
+    return total;
+}
 
-    #if CO_NO_SDO_CLIENT != 0
-    if(sizeof(OD_SDOClientParameter_t) != sizeof(CO_SDOclientPar_t)){
-        return CO_ERROR_PARAMETERS;
+
+/* Object dictionary of the instance ******************************************/
+/*
+ * Address of the variable _p_ from the global object dictionary at the same
+ * place in the object dictionary of the instance. Other addresses are
+ * returned unchanged.
+ */
+static void *CO_ODrelocate(const CO_instance_t *inst, const void *p){
+    uintptr_t a = (uintptr_t)p;
+
+    if(a >= (uintptr_t)&CO_OD_RAM && a < (uintptr_t)(&CO_OD_RAM + 1)){
+        return (uint8_t *)inst->ODram + (a - (uintptr_t)&CO_OD_RAM);
     }
-    #endif
+    if(a >= (uintptr_t)&CO_OD_EEPROM && a < (uintptr_t)(&CO_OD_EEPROM + 1)){
+        return (uint8_t *)inst->ODeeprom + (a - (uintptr_t)&CO_OD_EEPROM);
+    }
+    if(a >= (uintptr_t)&CO_OD_ROM && a < (uintptr_t)(&CO_OD_ROM + 1)){
+        return (uint8_t *)inst->ODrom + (a - (uintptr_t)&CO_OD_ROM);
+    }
+    return (void *)p;
+}
 
+/* Variable _var_ of type _type_ from the object dictionary of the instance */
+#define CO_OD_VAR(inst, type, var)  (*(type *)CO_ODrelocate((inst), &(var)))
 
-    /* Initialize CANopen object */
-#ifdef CO_USE_GLOBALS
-    CO = &COO;
 
-    CO->CANmodule[0]                    = &COO_CANmodule;
-    CO_CANmodule_rxArray0               = &COO_CANmodule_rxArray0[0];
-    CO_CANmodule_txArray0               = &COO_CANmodule_txArray0[0];
-    for(i=0; i<CO_NO_SDO_SERVER; i++)
-        CO->SDO[i]                      = &COO_SDO[i];
-    CO_SDO_ODExtensions                 = &COO_SDO_ODExtensions[0];
-    CO->em                              = &COO_EM;
-    CO->emPr                            = &COO_EMpr;
-    CO->NMT                             = &COO_NMT;
-    CO->SYNC                            = &COO_SYNC;
-    for(i=0; i<CO_NO_RPDO; i++)
-        CO->RPDO[i]                     = &COO_RPDO[i];
-    for(i=0; i<CO_NO_TPDO; i++)
-        CO->TPDO[i]                     = &COO_TPDO[i];
-    CO->HBcons                          = &COO_HBcons;
-    CO_HBcons_monitoredNodes            = &COO_HBcons_monitoredNodes[0];
-  #if CO_NO_LSS_SERVER == 1
-    CO->LSSslave                        = &CO0_LSSslave;
-  #endif
-  #if CO_NO_LSS_CLIENT == 1
-    CO->LSSmaster                       = &CO0_LSSmaster;
-  #endif
-#if CO_DAISY_CONSUMER == 1
-    CO->DaisyConsumer                   = &CO0_DaisyConsumer;
-#endif
-#if CO_DAISY_PRODUCER == 1
-    CO->DaisyProducer                   = &CO0_DaisyProducer;
-#endif
-  #if CO_NO_SDO_CLIENT != 0
-    for(i=0; i<CO_NO_SDO_CLIENT; i++) {
-      CO->SDOclient[i]                  = &COO_SDOclient[i];
+/* Use CO_OD and the global variables as object dictionary of the instance */
+static void CO_ODdefault(CO_instance_t *inst){
+    inst->OD = &CO_OD[0];
+    inst->ODentries = NULL;
+    inst->ODrecords = NULL;
+    inst->ODram = &CO_OD_RAM;
+    inst->ODeeprom = &CO_OD_EEPROM;
+    inst->ODrom = &CO_OD_ROM;
+    inst->ODramExternal = false;
+    inst->ODeepromExternal = false;
+}
+
+
+#ifndef CO_USE_GLOBALS
+/*
+ * Create own object dictionary of the instance.
+ *
+ * Variables are initialized with the current values of the global variables.
+ * CO_OD and all records are copied and their data pointers are relocated to
+ * the own variables.
+ */
+static CO_ReturnError_t CO_ODnew(CO_instance_t *inst){
+    uint32_t noRecords = 0;
+    uint32_t r;
+    uint16_t i;
+    uint16_t j;
+
+    for(i=0; i<CO_OD_NoOfElements; i++){
+        if(CO_OD[i].attribute == 0U && CO_OD[i].maxSubIndex > 0U && CO_OD[i].pData != NULL){
+            noRecords += CO_OD[i].maxSubIndex + 1U;
+        }
     }
-  #endif
-  #if CO_NO_TRACE > 0
-    for(i=0; i<CO_NO_TRACE; i++) {
-        CO->trace[i]                    = &COO_trace[i];
-        CO_traceTimeBuffers[i]          = &COO_traceTimeBuffers[i][0];
-        CO_traceValueBuffers[i]         = &COO_traceValueBuffers[i][0];
-        CO_traceBufferSize[i]           = CO_TRACE_BUFFER_SIZE_FIXED;
+
+    inst->ODram     = (struct sCO_OD_RAM *)     malloc(sizeof(struct sCO_OD_RAM));
+    inst->ODeeprom  = (struct sCO_OD_EEPROM *)  malloc(sizeof(struct sCO_OD_EEPROM));
+    inst->ODrom     = (struct sCO_OD_ROM *)     malloc(sizeof(struct sCO_OD_ROM));
+    inst->ODentries = (CO_OD_entry_t *)         calloc(CO_OD_NoOfElements, sizeof(CO_OD_entry_t));
+    inst->ODrecords = (CO_OD_entryRecord_t *)   calloc(noRecords + 1U, sizeof(CO_OD_entryRecord_t));
+    inst->OD = inst->ODentries;
+    if(inst->ODram == NULL || inst->ODeeprom == NULL || inst->ODrom == NULL ||
+       inst->ODentries == NULL || inst->ODrecords == NULL)
+    {
+        return CO_ERROR_OUT_OF_MEMORY;
     }
-  #endif
-#else
-    if(CO == NULL){    /* Use malloc only once */
-        CO = &COO;
-        CO->CANmodule[0]                    = (CO_CANmodule_t *)    calloc(1, sizeof(CO_CANmodule_t));
-        CO_CANmodule_rxArray0               = (CO_CANrx_t *)        calloc(CO_RXCAN_NO_MSGS, sizeof(CO_CANrx_t));
-        CO_CANmodule_txArray0               = (CO_CANtx_t *)        calloc(CO_TXCAN_NO_MSGS, sizeof(CO_CANtx_t));
-        for(i=0; i<CO_NO_SDO_SERVER; i++){
-            CO->SDO[i]                      = (CO_SDO_t *)          calloc(1, sizeof(CO_SDO_t));
+
+    *inst->ODram = CO_OD_RAM;
+    *inst->ODeeprom = CO_OD_EEPROM;
+    *inst->ODrom = CO_OD_ROM;
+
+    r = 0;
+    for(i=0; i<CO_OD_NoOfElements; i++){
+        CO_OD_entry_t *entry = &inst->ODentries[i];
+
+        *entry = CO_OD[i];
+        if(entry->attribute == 0U && entry->maxSubIndex > 0U && entry->pData != NULL){
+            const CO_OD_entryRecord_t *record = (const CO_OD_entryRecord_t *)CO_OD[i].pData;
+
+            for(j=0; j<=entry->maxSubIndex; j++){
+                inst->ODrecords[r + j] = record[j];
+                inst->ODrecords[r + j].pData = CO_ODrelocate(inst, record[j].pData);
+            }
+            entry->pData = &inst->ODrecords[r];
+            r += entry->maxSubIndex + 1U;
         }
-        CO_SDO_ODExtensions                 = (CO_OD_extension_t*)  calloc(CO_OD_NoOfElements, sizeof(CO_OD_extension_t));
-        CO->em                              = (CO_EM_t *)           calloc(1, sizeof(CO_EM_t));
-        CO->emPr                            = (CO_EMpr_t *)         calloc(1, sizeof(CO_EMpr_t));
-        CO->NMT                             = (CO_NMT_t *)          calloc(1, sizeof(CO_NMT_t));
-        CO->SYNC                            = (CO_SYNC_t *)         calloc(1, sizeof(CO_SYNC_t));
-        for(i=0; i<CO_NO_RPDO; i++){
-            CO->RPDO[i]                     = (CO_RPDO_t *)         calloc(1, sizeof(CO_RPDO_t));
+        else{
+            entry->pData = CO_ODrelocate(inst, CO_OD[i].pData);
         }
-        for(i=0; i<CO_NO_TPDO; i++){
-            CO->TPDO[i]                     = (CO_TPDO_t *)         calloc(1, sizeof(CO_TPDO_t));
-        }
-        CO->HBcons                          = (CO_HBconsumer_t *)   calloc(1, sizeof(CO_HBconsumer_t));
-        CO_HBcons_monitoredNodes            = (CO_HBconsNode_t *)   calloc(CO_NO_HB_CONS, sizeof(CO_HBconsNode_t));
-      #if CO_NO_LSS_SERVER == 1
-        CO->LSSslave                        = (CO_LSSslave_t *)     calloc(1, sizeof(CO_LSSslave_t));
-      #endif
-      #if CO_NO_LSS_CLIENT == 1
-        CO->LSSmaster                       = (CO_LSSmaster_t *)    calloc(1, sizeof(CO_LSSmaster_t));
-      #endif
-      #if CO_DAISY_CONSUMER == 1
-        CO->DaisyConsumer                   = (CO_DaisyConsumer_t *)calloc(1, sizeof(CO_DaisyConsumer_t));
-      #endif
-      #if CO_DAISY_PRODUCER == 1
-        CO->DaisyProducer                   = (CO_DaisyProducer_t *)calloc(1, sizeof(CO_DaisyProducer_t));
-      #endif
-      #if CO_NO_SDO_CLIENT != 0
-        for(i=0; i<CO_NO_SDO_CLIENT; i++){
-            CO->SDOclient[i]                = (CO_SDOclient_t *)    calloc(1, sizeof(CO_SDOclient_t));
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/* Free own object dictionary of the instance */
+static void CO_ODfree(CO_instance_t *inst){
+    if(inst->ODram == &CO_OD_RAM){
+        return;     /* default object dictionary */
+    }
+    free(inst->ODrecords);
+    free(inst->ODentries);
+    free(inst->ODrom);
+    if(!inst->ODeepromExternal){
+        free(inst->ODeeprom);
+    }
+    if(!inst->ODramExternal){
+        free(inst->ODram);
+    }
+    CO_ODdefault(inst);
+}
+
+
+/*
+ * Redirect data pointers of the own object dictionary of the instance, which
+ * point into _size_ bytes at _from_, to the same place at _to_.
+ */
+static void CO_ODredirect(CO_instance_t *inst, const void *from, void *to, size_t size){
+    uintptr_t f = (uintptr_t)from;
+    uint16_t i;
+    uint16_t j;
+
+    for(i=0; i<CO_OD_NoOfElements; i++){
+        CO_OD_entry_t *entry = &inst->ODentries[i];
+
+        if(entry->attribute == 0U && entry->maxSubIndex > 0U && entry->pData != NULL){
+            CO_OD_entryRecord_t *record = (CO_OD_entryRecord_t *)entry->pData;
+
+            for(j=0; j<=entry->maxSubIndex; j++){
+                uintptr_t a = (uintptr_t)record[j].pData;
+
+                if(a >= f && a < f + size){
+                    record[j].pData = (uint8_t *)to + (a - f);
+                }
+            }
         }
-      #endif
-      #if CO_NO_TRACE > 0
-        for(i=0; i<CO_NO_TRACE; i++) {
-            CO->trace[i]                    = (CO_trace_t *)        calloc(1, sizeof(CO_trace_t));
-            CO_traceTimeBuffers[i]          = (uint32_t *)          calloc(OD_traceConfig[i].size, sizeof(uint32_t));
-            CO_traceValueBuffers[i]         = (int32_t *)           calloc(OD_traceConfig[i].size, sizeof(int32_t));
-            if(CO_traceTimeBuffers[i] != NULL && CO_traceValueBuffers[i] != NULL) {
-                CO_traceBufferSize[i] = OD_traceConfig[i].size;
-            } else {
-                CO_traceBufferSize[i] = 0;
+        else{
+            uintptr_t a = (uintptr_t)entry->pData;
+
+            if(a >= f && a < f + size){
+                entry->pData = (uint8_t *)to + (a - f);
             }
         }
-      #endif
-    }
-
-    CO_memoryUsed = sizeof(CO_CANmodule_t)
-                  + sizeof(CO_CANrx_t) * CO_RXCAN_NO_MSGS
-                  + sizeof(CO_CANtx_t) * CO_TXCAN_NO_MSGS
-                  + sizeof(CO_SDO_t) * CO_NO_SDO_SERVER
-                  + sizeof(CO_OD_extension_t) * CO_OD_NoOfElements
-                  + sizeof(CO_EM_t)
-                  + sizeof(CO_EMpr_t)
-                  + sizeof(CO_NMT_t)
-                  + sizeof(CO_SYNC_t)
-                  + sizeof(CO_RPDO_t) * CO_NO_RPDO
-                  + sizeof(CO_TPDO_t) * CO_NO_TPDO
-                  + sizeof(CO_HBconsumer_t)
-                  + sizeof(CO_HBconsNode_t) * CO_NO_HB_CONS
-  #if CO_NO_LSS_SERVER == 1
-                  + sizeof(CO_LSSslave_t)
-  #endif
-  #if CO_NO_LSS_CLIENT == 1
-                  + sizeof(CO_LSSmaster_t)
-  #endif
-  #if CO_DAISY_CONSUMER == 1
-                  + sizeof(CO_DaisyProducer_t)
-  #endif
-  #if CO_DAISY_PRODUCER == 1
-                  + sizeof(CO_DaisyConsumer_t)
-  #endif
-  #if CO_NO_SDO_CLIENT != 0
-                  + sizeof(CO_SDOclient_t) * CO_NO_SDO_CLIENT
-  #endif
-                  + 0;
-  #if CO_NO_TRACE > 0
-    CO_memoryUsed += sizeof(CO_trace_t) * CO_NO_TRACE;
-    for(i=0; i<CO_NO_TRACE; i++) {
-        CO_memoryUsed += CO_traceBufferSize[i] * 8;
     }
-  #endif
+}
 
-    errCnt = 0;
-    if(CO->CANmodule[0]                 == NULL) errCnt++;
-    if(CO_CANmodule_rxArray0            == NULL) errCnt++;
-    if(CO_CANmodule_txArray0            == NULL) errCnt++;
-    for(i=0; i<CO_NO_SDO_SERVER; i++){
-        if(CO->SDO[i]                   == NULL) errCnt++;
-    }
-    if(CO_SDO_ODExtensions              == NULL) errCnt++;
-    if(CO->em                           == NULL) errCnt++;
-    if(CO->emPr                         == NULL) errCnt++;
-    if(CO->NMT                          == NULL) errCnt++;
-    if(CO->SYNC                         == NULL) errCnt++;
-    for(i=0; i<CO_NO_RPDO; i++){
-        if(CO->RPDO[i]                  == NULL) errCnt++;
+
+/******************************************************************************/
+CO_ReturnError_t CO_setODmemory(CO_t *CO, void *ODram, void *ODeeprom){
+    CO_instance_t *inst;
+
+    if(CO == NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
     }
-    for(i=0; i<CO_NO_TPDO; i++){
-        if(CO->TPDO[i]                  == NULL) errCnt++;
+    inst = CO_INSTANCE(CO);
+    if(inst->ODentries == NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;   /* default object dictionary */
     }
-    if(CO->HBcons                       == NULL) errCnt++;
-    if(CO_HBcons_monitoredNodes         == NULL) errCnt++;
-  #if CO_NO_LSS_SERVER == 1
-    if(CO->LSSslave                     == NULL) errCnt++;
-  #endif
-  #if CO_NO_LSS_CLIENT == 1
-    if(CO->LSSmaster                    == NULL) errCnt++;
-  #endif
-  #if CO_DAISY_CONSUMER == 1
-    if(CO->DaisyConsumer                == NULL) errCnt++;
-  #endif
-  #if CO_DAISY_PRODUCER == 1
-    if(CO->DaisyProducer                == NULL) errCnt++;
-  #endif
-  #if CO_NO_SDO_CLIENT != 0
-    for(i=0; i<CO_NO_SDO_CLIENT; i++){
-        if(CO->SDOclient[i]             == NULL) errCnt++;
+
+    if(ODram != NULL && ODram != (void *)inst->ODram){
+        memcpy(ODram, inst->ODram, sizeof(struct sCO_OD_RAM));
+        CO_ODredirect(inst, inst->ODram, ODram, sizeof(struct sCO_OD_RAM));
+        if(!inst->ODramExternal){
+            free(inst->ODram);
+        }
+        inst->ODram = (struct sCO_OD_RAM *)ODram;
+        inst->ODramExternal = true;
     }
-  #endif
-  #if CO_NO_TRACE > 0
-    for(i=0; i<CO_NO_TRACE; i++) {
-        if(CO->trace[i]                 == NULL) errCnt++;
+    if(ODeeprom != NULL && ODeeprom != (void *)inst->ODeeprom){
+        memcpy(ODeeprom, inst->ODeeprom, sizeof(struct sCO_OD_EEPROM));
+        CO_ODredirect(inst, inst->ODeeprom, ODeeprom, sizeof(struct sCO_OD_EEPROM));
+        if(!inst->ODeepromExternal){
+            free(inst->ODeeprom);
+        }
+        inst->ODeeprom = (struct sCO_OD_EEPROM *)ODeeprom;
+        inst->ODeepromExternal = true;
     }
-  #endif
 
-    if(errCnt != 0) return CO_ERROR_OUT_OF_MEMORY;
-#endif
     return CO_ERROR_NO;
 }
+#endif
 
 
 /******************************************************************************/
-CO_ReturnError_t CO_CANinit(
-        int32_t                 CANbaseAddress,
-        uint16_t                bitRate)
-{
-    CO_ReturnError_t err;
-
-    CO->CANmodule[0]->CANnormal = false;
-    CO_CANsetConfigurationMode(CANbaseAddress);
+void *CO_getODvariable(CO_t *CO, const void *variable){
+    if(CO == NULL){
+        return NULL;
+    }
+    return CO_ODrelocate(CO_INSTANCE(CO), variable);
+}
 
-    err = CO_CANmodule_init(
-            CO->CANmodule[0],
-            CANbaseAddress,
-            CO_CANmodule_rxArray0,
-            CO_RXCAN_NO_MSGS,
-            CO_CANmodule_txArray0,
-            CO_TXCAN_NO_MSGS,
-            bitRate);
 
-    return err;
+#ifdef CO_USE_ARENA
+/******************************************************************************/
+void CO_setArena(void *buffer, uint32_t size){
+    CO_arenaBuffer = (uint8_t *)buffer;
+    CO_arenaBufferSize = size;
 }
 
 
 /******************************************************************************/
-#if CO_NO_LSS_SERVER == 1
-CO_ReturnError_t CO_LSSinit(
+uint32_t CO_getArenaSize(void){
+    uint32_t size = 0;
+    int16_t i;
+
+    CO_memoryInfoInit();
+    for(i=0; i<CO_MEM_NO_GROUPS; i++){
+        size += CO_ARENA_ROUND(CO_memoryInfo[i].size);
+    }
+    return size;
+}
+
+
+/* Take memory for one group of objects from the arena */
+static void *CO_arenaTake(uint8_t **next, CO_memoryGroup_t group){
+    void *p = (void *)*next;
+
+    *next += CO_ARENA_ROUND(CO_memoryInfo[group].size);
+    return p;
+}
+
+
+/*
+ * Place all objects of the instance into one memory block, in order of
+ * CO_memoryGroup_t. Block is allocated, if buffer is NULL.
+ */
+static CO_ReturnError_t CO_arenaNew(CO_instance_t *inst, uint8_t *buffer, uint32_t bufferSize){
+    CO_t *CO = &inst->CO;
+    uint32_t size = CO_getArenaSize();
+    uint8_t *next;
+    int16_t i;
+
+    if(buffer != NULL){
+        if(bufferSize < size || ((uintptr_t)buffer % CO_ARENA_ALIGN) != 0U){
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+        memset(buffer, 0, size);
+        inst->arena = buffer;
+    }
+    else{
+        inst->arena = (uint8_t *) calloc(1, size);
+        if(inst->arena == NULL){
+            return CO_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    next = inst->arena;
+
+    CO->CANmodule[0]            = (CO_CANmodule_t *)    CO_arenaTake(&next, CO_MEM_CANMODULE);
+    inst->CANmodule_rxArray0    = (CO_CANrx_t *)        CO_arenaTake(&next, CO_MEM_CANRX);
+    inst->CANmodule_txArray0    = (CO_CANtx_t *)        CO_arenaTake(&next, CO_MEM_CANTX);
+    CO->SYNC                    = (CO_SYNC_t *)         CO_arenaTake(&next, CO_MEM_SYNC);
+    {
+        CO_RPDO_t *RPDO         = (CO_RPDO_t *)         CO_arenaTake(&next, CO_MEM_RPDO);
+        for(i=0; i<CO_NO_RPDO; i++){
+            CO->RPDO[i]         = &RPDO[i];
+        }
+    }
+    {
+        CO_TPDO_t *TPDO         = (CO_TPDO_t *)         CO_arenaTake(&next, CO_MEM_TPDO);
+        for(i=0; i<CO_NO_TPDO; i++){
+            CO->TPDO[i]         = &TPDO[i];
+        }
+    }
+    CO->NMT                     = (CO_NMT_t *)          CO_arenaTake(&next, CO_MEM_NMT);
+    CO->HBcons                  = (CO_HBconsumer_t *)   CO_arenaTake(&next, CO_MEM_HBCONS);
+    inst->HBcons_monitoredNodes = (CO_HBconsNode_t *)   CO_arenaTake(&next, CO_MEM_HBCONS_NODES);
+    CO->em                      = (CO_EM_t *)           CO_arenaTake(&next, CO_MEM_EM);
+    CO->emPr                    = (CO_EMpr_t *)         CO_arenaTake(&next, CO_MEM_EMPR);
+    {
+        CO_SDO_t *SDO           = (CO_SDO_t *)          CO_arenaTake(&next, CO_MEM_SDO);
+        for(i=0; i<CO_NO_SDO_SERVER; i++){
+            CO->SDO[i]          = &SDO[i];
+        }
+    }
+    inst->SDO_ODExtensions      = (CO_OD_extension_t *) CO_arenaTake(&next, CO_MEM_OD_EXT);
+  #if CO_NO_SDO_CLIENT != 0
+    {
+        CO_SDOclient_t *SDOclient = (CO_SDOclient_t *)  CO_arenaTake(&next, CO_MEM_SDO_CLIENT);
+        for(i=0; i<CO_NO_SDO_CLIENT; i++){
+            CO->SDOclient[i]    = &SDOclient[i];
+        }
+    }
+  #endif
+  #if CO_NO_LSS_SERVER == 1
+    CO->LSSslave                = (CO_LSSslave_t *)     CO_arenaTake(&next, CO_MEM_LSS);
+  #elif CO_NO_LSS_CLIENT == 1
+    CO->LSSmaster               = (CO_LSSmaster_t *)    CO_arenaTake(&next, CO_MEM_LSS);
+  #endif
+  #if CO_DAISY_CONSUMER == 1
+    CO->DaisyConsumer           = (CO_DaisyConsumer_t *)CO_arenaTake(&next, CO_MEM_DAISY);
+  #elif CO_DAISY_PRODUCER == 1
+    CO->DaisyProducer           = (CO_DaisyProducer_t *)CO_arenaTake(&next, CO_MEM_DAISY);
+  #endif
+  #if CO_NO_TIME == 1
+    CO->TIME                    = (CO_TIME_t *)         CO_arenaTake(&next, CO_MEM_TIME);
+  #endif
+  #if CO_NO_TRACE > 0
+    {
+        CO_trace_t *trace       = (CO_trace_t *)        CO_arenaTake(&next, CO_MEM_TRACE);
+        uint8_t *buf            = (uint8_t *)           CO_arenaTake(&next, CO_MEM_TRACE_BUF);
+        for(i=0; i<CO_NO_TRACE; i++) {
+            CO->trace[i]        = &trace[i];
+            inst->traceBufferSize[i] = OD_traceConfig[i].size;
+            inst->traceTimeBuffers[i] = (uint32_t *)buf;
+            buf += inst->traceBufferSize[i] * sizeof(uint32_t);
+            inst->traceValueBuffers[i] = (int32_t *)buf;
+            buf += inst->traceBufferSize[i] * sizeof(int32_t);
+        }
+    }
+  #endif
+
+    return CO_ERROR_NO;
+}
+#endif
+
+
+/* Verify parameters from CO_OD */
+static CO_ReturnError_t CO_verifyOD(void){
+    if(   sizeof(OD_TPDOCommunicationParameter_t) != sizeof(CO_TPDOCommPar_t)
+       || sizeof(OD_TPDOMappingParameter_t) != sizeof(CO_TPDOMapPar_t)
+       || sizeof(OD_RPDOCommunicationParameter_t) != sizeof(CO_RPDOCommPar_t)
+       || sizeof(OD_RPDOMappingParameter_t) != sizeof(CO_RPDOMapPar_t))
+    {
+        return CO_ERROR_PARAMETERS;
+    }
+
+    #if CO_NO_SDO_CLIENT != 0
+    if(sizeof(OD_SDOClientParameter_t) != sizeof(CO_SDOclientPar_t)){
+        return CO_ERROR_PARAMETERS;
+    }
+    #endif
+
+    return CO_ERROR_NO;
+}
+
+
+#ifndef CO_USE_GLOBALS
+#ifndef CO_USE_ARENA
+/* Allocate all objects of the instance with calloc() */
+static void CO_instanceAlloc(CO_instance_t *inst){
+    CO_t *CO = &inst->CO;
+    int16_t i;
+
+    CO->CANmodule[0]                    = (CO_CANmodule_t *)    calloc(1, sizeof(CO_CANmodule_t));
+    inst->CANmodule_rxArray0            = (CO_CANrx_t *)        calloc(CO_RXCAN_NO_MSGS, sizeof(CO_CANrx_t));
+    inst->CANmodule_txArray0            = (CO_CANtx_t *)        calloc(CO_TXCAN_NO_MSGS, sizeof(CO_CANtx_t));
+    for(i=0; i<CO_NO_SDO_SERVER; i++){
+        CO->SDO[i]                      = (CO_SDO_t *)          calloc(1, sizeof(CO_SDO_t));
+    }
+    inst->SDO_ODExtensions              = (CO_OD_extension_t*)  calloc(CO_NO_OD_EXT, sizeof(CO_OD_extension_t));
+    CO->em                              = (CO_EM_t *)           calloc(1, sizeof(CO_EM_t));
+    CO->emPr                            = (CO_EMpr_t *)         calloc(1, sizeof(CO_EMpr_t));
+    CO->NMT                             = (CO_NMT_t *)          calloc(1, sizeof(CO_NMT_t));
+    CO->SYNC                            = (CO_SYNC_t *)         calloc(1, sizeof(CO_SYNC_t));
+    for(i=0; i<CO_NO_RPDO; i++){
+        CO->RPDO[i]                     = (CO_RPDO_t *)         calloc(1, sizeof(CO_RPDO_t));
+    }
+    for(i=0; i<CO_NO_TPDO; i++){
+        CO->TPDO[i]                     = (CO_TPDO_t *)         calloc(1, sizeof(CO_TPDO_t));
+    }
+    CO->HBcons                          = (CO_HBconsumer_t *)   calloc(1, sizeof(CO_HBconsumer_t));
+    inst->HBcons_monitoredNodes         = (CO_HBconsNode_t *)   calloc(CO_NO_HB_CONS, sizeof(CO_HBconsNode_t));
+  #if CO_NO_LSS_SERVER == 1
+    CO->LSSslave                        = (CO_LSSslave_t *)     calloc(1, sizeof(CO_LSSslave_t));
+  #endif
+  #if CO_NO_LSS_CLIENT == 1
+    CO->LSSmaster                       = (CO_LSSmaster_t *)    calloc(1, sizeof(CO_LSSmaster_t));
+  #endif
+  #if CO_DAISY_CONSUMER == 1
+    CO->DaisyConsumer                   = (CO_DaisyConsumer_t *)calloc(1, sizeof(CO_DaisyConsumer_t));
+  #endif
+  #if CO_DAISY_PRODUCER == 1
+    CO->DaisyProducer                   = (CO_DaisyProducer_t *)calloc(1, sizeof(CO_DaisyProducer_t));
+  #endif
+  #if CO_NO_TIME == 1
+    CO->TIME                            = (CO_TIME_t *)         calloc(1, sizeof(CO_TIME_t));
+  #endif
+  #if CO_NO_SDO_CLIENT != 0
+    for(i=0; i<CO_NO_SDO_CLIENT; i++){
+        CO->SDOclient[i]                = (CO_SDOclient_t *)    calloc(1, sizeof(CO_SDOclient_t));
+    }
+  #endif
+  #if CO_NO_TRACE > 0
+    for(i=0; i<CO_NO_TRACE; i++) {
+        CO->trace[i]                    = (CO_trace_t *)        calloc(1, sizeof(CO_trace_t));
+        inst->traceTimeBuffers[i]       = (uint32_t *)          calloc(OD_traceConfig[i].size, sizeof(uint32_t));
+        inst->traceValueBuffers[i]      = (int32_t *)           calloc(OD_traceConfig[i].size, sizeof(int32_t));
+        if(inst->traceTimeBuffers[i] != NULL && inst->traceValueBuffers[i] != NULL) {
+            inst->traceBufferSize[i] = OD_traceConfig[i].size;
+        } else {
+            inst->traceBufferSize[i] = 0;
+        }
+    }
+  #endif
+}
+#endif /* CO_USE_ARENA */
+
+
+/* Verify, that all objects of the instance are allocated */
+static CO_ReturnError_t CO_instanceVerify(const CO_instance_t *inst){
+    const CO_t *CO = &inst->CO;
+    uint16_t errCnt = 0;
+    int16_t i;
+
+    if(CO->CANmodule[0]                 == NULL) errCnt++;
+    if(inst->CANmodule_rxArray0         == NULL) errCnt++;
+    if(inst->CANmodule_txArray0         == NULL) errCnt++;
+    for(i=0; i<CO_NO_SDO_SERVER; i++){
+        if(CO->SDO[i]                   == NULL) errCnt++;
+    }
+    if(inst->SDO_ODExtensions           == NULL) errCnt++;
+    if(CO->em                           == NULL) errCnt++;
+    if(CO->emPr                         == NULL) errCnt++;
+    if(CO->NMT                          == NULL) errCnt++;
+    if(CO->SYNC                         == NULL) errCnt++;
+    for(i=0; i<CO_NO_RPDO; i++){
+        if(CO->RPDO[i]                  == NULL) errCnt++;
+    }
+    for(i=0; i<CO_NO_TPDO; i++){
+        if(CO->TPDO[i]                  == NULL) errCnt++;
+    }
+    if(CO->HBcons                       == NULL) errCnt++;
+    if(inst->HBcons_monitoredNodes      == NULL) errCnt++;
+  #if CO_NO_LSS_SERVER == 1
+    if(CO->LSSslave                     == NULL) errCnt++;
+  #endif
+  #if CO_NO_LSS_CLIENT == 1
+    if(CO->LSSmaster                    == NULL) errCnt++;
+  #endif
+  #if CO_DAISY_CONSUMER == 1
+    if(CO->DaisyConsumer                == NULL) errCnt++;
+  #endif
+  #if CO_DAISY_PRODUCER == 1
+    if(CO->DaisyProducer                == NULL) errCnt++;
+  #endif
+  #if CO_NO_TIME == 1
+    if(CO->TIME                         == NULL) errCnt++;
+  #endif
+  #if CO_NO_SDO_CLIENT != 0
+    for(i=0; i<CO_NO_SDO_CLIENT; i++){
+        if(CO->SDOclient[i]             == NULL) errCnt++;
+    }
+  #endif
+  #if CO_NO_TRACE > 0
+    for(i=0; i<CO_NO_TRACE; i++) {
+        if(CO->trace[i]                 == NULL) errCnt++;
+    }
+  #endif
+
+    return (errCnt != 0) ? CO_ERROR_OUT_OF_MEMORY : CO_ERROR_NO;
+}
+
+
+/* Free all objects of the instance, free(NULL) is allowed */
+static void CO_instanceFree(CO_instance_t *inst){
+  #ifndef CO_USE_ARENA
+    CO_t *CO = &inst->CO;
+    int16_t i;
+  #endif
+
+  #ifdef CO_USE_STATISTICS
+    CO_statistics_remove(&inst->statisticsCAN);
+  #endif
+    CO_ODfree(inst);
+
+  #ifdef CO_USE_ARENA
+    if(inst->arena != CO_arenaBuffer){
+        free(inst->arena);
+    }
+    inst->arena = NULL;
+  #else
+  #if CO_NO_TRACE > 0
+    for(i=0; i<CO_NO_TRACE; i++) {
+        free(CO->trace[i]);
+        free(inst->traceTimeBuffers[i]);
+        free(inst->traceValueBuffers[i]);
+    }
+  #endif
+  #if CO_NO_SDO_CLIENT != 0
+    for(i=0; i<CO_NO_SDO_CLIENT; i++) {
+        free(CO->SDOclient[i]);
+    }
+  #endif
+  #if CO_NO_LSS_SERVER == 1
+    free(CO->LSSslave);
+  #endif
+  #if CO_NO_LSS_CLIENT == 1
+    free(CO->LSSmaster);
+  #endif
+  #if CO_DAISY_CONSUMER == 1
+    free(CO->DaisyConsumer);
+  #endif
+  #if CO_DAISY_PRODUCER == 1
+    free(CO->DaisyProducer);
+  #endif
+  #if CO_NO_TIME == 1
+    free(CO->TIME);
+  #endif
+    free(inst->HBcons_monitoredNodes);
+    free(CO->HBcons);
+    for(i=0; i<CO_NO_RPDO; i++){
+        free(CO->RPDO[i]);
+    }
+    for(i=0; i<CO_NO_TPDO; i++){
+        free(CO->TPDO[i]);
+    }
+    free(CO->SYNC);
+    free(CO->NMT);
+    free(CO->emPr);
+    free(CO->em);
+    free(inst->SDO_ODExtensions);
+    for(i=0; i<CO_NO_SDO_SERVER; i++){
+        free(CO->SDO[i]);
+    }
+    free(inst->CANmodule_txArray0);
+    free(inst->CANmodule_rxArray0);
+    free(CO->CANmodule[0]);
+  #endif
+}
+#endif /* CO_USE_GLOBALS */
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_new(void)
+{
+    CO_ReturnError_t err;
+#ifdef CO_USE_GLOBALS
+    int16_t i;
+#endif
+
+    err = CO_verifyOD();
+    if(err != CO_ERROR_NO) return err;
+
+
+    /* Initialize CANopen object */
+#ifdef CO_USE_GLOBALS
+    CO = &COO.CO;
+
+    CO->CANmodule[0]                    = &COO_CANmodule;
+    COO.CANmodule_rxArray0              = &COO_CANmodule_rxArray0[0];
+    COO.CANmodule_txArray0              = &COO_CANmodule_txArray0[0];
+    for(i=0; i<CO_NO_SDO_SERVER; i++)
+        CO->SDO[i]                      = &COO_SDO[i];
+    COO.SDO_ODExtensions                = &COO_SDO_ODExtensions[0];
+    CO->em                              = &COO_EM;
+    CO->emPr                            = &COO_EMpr;
+    CO->NMT                             = &COO_NMT;
+    CO->SYNC                            = &COO_SYNC;
+    for(i=0; i<CO_NO_RPDO; i++)
+        CO->RPDO[i]                     = &COO_RPDO[i];
+    for(i=0; i<CO_NO_TPDO; i++)
+        CO->TPDO[i]                     = &COO_TPDO[i];
+    CO->HBcons                          = &COO_HBcons;
+    COO.HBcons_monitoredNodes           = &COO_HBcons_monitoredNodes[0];
+  #if CO_NO_LSS_SERVER == 1
+    CO->LSSslave                        = &CO0_LSSslave;
+  #endif
+  #if CO_NO_LSS_CLIENT == 1
+    CO->LSSmaster                       = &CO0_LSSmaster;
+  #endif
+#if CO_DAISY_CONSUMER == 1
+    CO->DaisyConsumer                   = &CO0_DaisyConsumer;
+#endif
+#if CO_DAISY_PRODUCER == 1
+    CO->DaisyProducer                   = &CO0_DaisyProducer;
+#endif
+  #if CO_NO_TIME == 1
+    CO->TIME                            = &COO_TIME;
+  #endif
+  #if CO_NO_SDO_CLIENT != 0
+    for(i=0; i<CO_NO_SDO_CLIENT; i++) {
+      CO->SDOclient[i]                  = &COO_SDOclient[i];
+    }
+  #endif
+  #if CO_NO_TRACE > 0
+    for(i=0; i<CO_NO_TRACE; i++) {
+        CO->trace[i]                    = &COO_trace[i];
+        COO.traceTimeBuffers[i]         = &COO_traceTimeBuffers[i][0];
+        COO.traceValueBuffers[i]        = &COO_traceValueBuffers[i][0];
+        COO.traceBufferSize[i]          = CO_TRACE_BUFFER_SIZE_FIXED;
+    }
+  #endif
+    CO_ODdefault(&COO);
+    CO_memoryInfoInit();
+#else
+    if(CO == NULL){    /* Use malloc only once */
+        CO_ODdefault(&COO);
+  #ifdef CO_USE_ARENA
+        err = CO_arenaNew(&COO, CO_arenaBuffer, CO_arenaBufferSize);
+        if(err != CO_ERROR_NO) return err;
+  #else
+        CO_instanceAlloc(&COO);
+  #endif
+        CO = &COO.CO;
+    }
+
+    CO_memoryInfoInit();
+    CO_memoryUsed = CO_getMemoryInfo(NULL);
+
+    err = CO_instanceVerify(&COO);
+#endif
+    return err;
+}
+
+
+#ifndef CO_USE_GLOBALS
+/* Pointer to the default instance is not valid any more */
+static void CO_clearDefault(void){
+    CO = NULL;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_newInstance(CO_t **pCO)
+{
+    CO_instance_t *inst;
+    CO_ReturnError_t err;
+
+    if(pCO == NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    *pCO = NULL;
+
+    err = CO_verifyOD();
+    if(err != CO_ERROR_NO) return err;
+
+    inst = (CO_instance_t *) calloc(1, sizeof(CO_instance_t));
+    if(inst == NULL){
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+
+    CO_memoryInfoInit();
+  #ifdef CO_USE_ARENA
+    err = CO_arenaNew(inst, NULL, 0);
+  #else
+    CO_instanceAlloc(inst);
+    err = CO_instanceVerify(inst);
+  #endif
+    if(err == CO_ERROR_NO){
+        err = CO_ODnew(inst);
+    }
+    if(err != CO_ERROR_NO){
+        CO_instanceFree(inst);
+        free(inst);
+        return err;
+    }
+
+    *pCO = &inst->CO;
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_deleteInstance(CO_t *CO, int32_t CANbaseAddress){
+    CO_instance_t *inst = CO_INSTANCE(CO);
+
+    if(CO == NULL){
+        return;
+    }
+
+    CO_CANsetConfigurationMode(CANbaseAddress);
+    CO_CANmodule_disable(CO->CANmodule[0]);
+
+    CO_instanceFree(inst);
+    if(inst == &COO){
+        /* default instance is allocated again by CO_new() */
+        memset(&COO, 0, sizeof(COO));
+        CO_ODdefault(&COO);
+        CO_clearDefault();
+    }
+    else{
+        free(inst);
+    }
+}
+#endif
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANinitInstance(
+        CO_t                   *CO,
+        int32_t                 CANbaseAddress,
+        uint16_t                bitRate)
+{
+    CO_instance_t *inst = CO_INSTANCE(CO);
+    CO_ReturnError_t err;
+
+    CO->CANmodule[0]->CANnormal = false;
+    CO_CANsetConfigurationMode(CANbaseAddress);
+
+    err = CO_CANmodule_init(
+            CO->CANmodule[0],
+            CANbaseAddress,
+            inst->CANmodule_rxArray0,
+            CO_RXCAN_NO_MSGS,
+            inst->CANmodule_txArray0,
+            CO_TXCAN_NO_MSGS,
+            bitRate);
+
+#ifdef CO_USE_STATISTICS
+    CO_statistics_init(
+            &inst->statisticsCAN,
+            CO->CANmodule[0],
+            inst->statisticsRxCount,
+            CO_RXCAN_NO_MSGS,
+            inst->statisticsTxCount,
+            CO_TXCAN_NO_MSGS,
+            bitRate);
+#endif
+
+    return err;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANinit(
+        int32_t                 CANbaseAddress,
+        uint16_t                bitRate)
+{
+    return CO_CANinitInstance(CO, CANbaseAddress, bitRate);
+}
+
+
+/******************************************************************************/
+#if CO_NO_LSS_SERVER == 1
+CO_ReturnError_t CO_LSSinitInstance(
+        CO_t                   *CO,
         uint8_t                 nodeId,
         uint16_t                bitRate)
 {
+    const OD_identity_t *identity = (const OD_identity_t *)CO_ODrelocate(CO_INSTANCE(CO), &OD_identity);
     CO_LSS_address_t lssAddress;
     CO_ReturnError_t err;
 
-    lssAddress.identity.productCode = OD_identity.productCode;
-    lssAddress.identity.revisionNumber = OD_identity.revisionNumber;
-    lssAddress.identity.serialNumber = OD_identity.serialNumber;
-    lssAddress.identity.vendorID = OD_identity.vendorID;
+    lssAddress.identity.productCode = identity->productCode;
+    lssAddress.identity.revisionNumber = identity->revisionNumber;
+    lssAddress.identity.serialNumber = identity->serialNumber;
+    lssAddress.identity.vendorID = identity->vendorID;
     err = CO_LSSslave_init(
             CO->LSSslave,
             lssAddress,
@@ -493,13 +1273,24 @@ CO_ReturnError_t CO_LSSinit(
 
     return err;
 }
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_LSSinit(
+        uint8_t                 nodeId,
+        uint16_t                bitRate)
+{
+    return CO_LSSinitInstance(CO, nodeId, bitRate);
+}
 #endif /* CO_NO_LSS_SERVER == 1 */
 
 
 /******************************************************************************/
-CO_ReturnError_t CO_CANopenInit(
+CO_ReturnError_t CO_CANopenInitInstance(
+        CO_t                   *CO,
         uint8_t                 nodeId)
 {
+    CO_instance_t *inst = CO_INSTANCE(CO);
     int16_t i;
     CO_ReturnError_t err;
 
@@ -508,6 +1299,27 @@ CO_ReturnError_t CO_CANopenInit(
         return CO_ERROR_PARAMETERS;
     }
 
+#ifdef CO_OD_COLUMNS
+    /* from the final object dictionary of the instance, see CO_setODmemory() */
+    err = CO_OD_columnsBuild(
+            &inst->ODColumns,
+            inst->OD,
+            CO_OD_NoOfElements,
+            inst->ODColumnsIndex,
+            inst->ODColumnsMaxSubIndex,
+            inst->ODColumnsAttribute,
+            inst->ODColumnsLength,
+            inst->ODColumnsData,
+            inst->ODColumnsMembers,
+            CO_OD_COLUMNS_MEMBERS);
+    if(err){return err;}
+#endif
+#ifdef CO_SDO_TRANSFER_LOG
+    /* head and count are kept over communication reset */
+    inst->SDOtransferLog.records = inst->SDOtransferRecords;
+    inst->SDOtransferLog.size = CO_SDO_TRANSFER_LOG_SIZE;
+#endif
+
     for (i=0; i<CO_NO_SDO_SERVER; i++)
     {
         uint32_t COB_IDClientToServer;
@@ -517,8 +1329,8 @@ CO_ReturnError_t CO_CANopenInit(
             COB_IDClientToServer = CO_CAN_ID_RSDO + nodeId;
             COB_IDServerToClient = CO_CAN_ID_TSDO + nodeId;
         }else{
-            COB_IDClientToServer = OD_SDOServerParameter[i].COB_IDClientToServer;
-            COB_IDServerToClient = OD_SDOServerParameter[i].COB_IDServerToClient;
+            COB_IDClientToServer = CO_OD_VAR(inst, uint32_t, OD_SDOServerParameter[i].COB_IDClientToServer);
+            COB_IDServerToClient = CO_OD_VAR(inst, uint32_t, OD_SDOServerParameter[i].COB_IDServerToClient);
         }
 
         err = CO_SDO_init(
@@ -527,27 +1339,60 @@ CO_ReturnError_t CO_CANopenInit(
                 COB_IDServerToClient,
                 OD_H1200_SDO_SERVER_PARAM+i,
                 i==0 ? 0 : CO->SDO[0],
-               &CO_OD[0],
+                inst->OD,
                 CO_OD_NoOfElements,
-                CO_SDO_ODExtensions,
+                inst->SDO_ODExtensions,
                 nodeId,
                 CO->CANmodule[0],
                 CO_RXCAN_SDO_SRV+i,
                 CO->CANmodule[0],
                 CO_TXCAN_SDO_SRV+i);
+
+        CO_SDO_initActiveFlag(CO->SDO[i], &inst->SDOactiveNew);
+#ifdef CO_OD_FIND_TABLE
+        CO_SDO_initFindTable(CO->SDO[i], inst->ODFindTable);
+#endif
+#ifdef CO_OD_PROFILING
+        CO_SDO_initProfile(CO->SDO[i], inst->ODProfile);
+#endif
+#ifdef CO_OD_COLUMNS
+        CO_SDO_initColumns(CO->SDO[i], &inst->ODColumns);
+#endif
+#ifdef CO_SDO_TRANSFER_LOG
+        CO_SDO_initTransferLog(CO->SDO[i], &inst->SDOtransferLog);
+#endif
+#ifdef CO_SDO_RX_RING_SIZE
+        if(err == CO_ERROR_NO){
+            err = CO_rxRing_init(&inst->SDOrxRing[i], inst->SDOrxRingMsgs[i], CO_SDO_RX_RING_SIZE);
+        }
+        if(err == CO_ERROR_NO){
+            CO_SDO_initRxRing(CO->SDO[i], &inst->SDOrxRing[i]);
+        }
+#endif
+#ifdef CO_SDO_FAST_EXPEDITED
+        if(err == CO_ERROR_NO){
+            err = CO_SDO_initFastPath(CO->SDO[i], CO->CANmodule[0], CO_TXCAN_SDO_FAST+i);
+        }
+#endif
     }
 
     if(err){return err;}
 
+    /* SDO servers are processed only after new request */
+    for(i=0; i<((CO_NO_SDO_SERVER + 31) / 32); i++){
+        inst->SDOactive[i] = 0U;
+    }
+    CLEAR_CANrxNew(inst->SDOactiveNew);
+
 
     err = CO_EM_init(
             CO->em,
             CO->emPr,
             CO->SDO[0],
-           &OD_errorStatusBits[0],
+            (uint8_t *)CO_ODrelocate(inst, &OD_errorStatusBits[0]),
             ODL_errorStatusBits_stringLength,
-           &OD_errorRegister,
-           &OD_preDefinedErrorField[0],
+            (uint8_t *)CO_ODrelocate(inst, &OD_errorRegister),
+            (uint32_t *)CO_ODrelocate(inst, &OD_preDefinedErrorField[0]),
             ODL_preDefinedErrorField_arrayLength,
             CO->CANmodule[0],
             CO_TXCAN_EMERG,
@@ -572,7 +1417,7 @@ CO_ReturnError_t CO_CANopenInit(
 
 
 #if CO_NO_NMT_MASTER == 1
-    NMTM_txBuff = CO_CANtxBufferInit(/* return pointer to 8-byte CAN data buffer, which should be populated */
+    inst->NMTM_txBuff = CO_CANtxBufferInit(/* return pointer to 8-byte CAN data buffer, which should be populated */
             CO->CANmodule[0], /* pointer to CAN module used for sending this message */
             CO_TXCAN_NMT,     /* index of specific buffer inside CAN module */
             0x0000,           /* CAN identifier */
@@ -627,9 +1472,9 @@ CO_ReturnError_t CO_CANopenInit(
             CO->em,
             CO->SDO[0],
            &CO->NMT->operatingState,
-            OD_COB_ID_SYNCMessage,
-            OD_communicationCyclePeriod,
-            OD_synchronousCounterOverflowValue,
+            CO_OD_VAR(inst, uint32_t, OD_COB_ID_SYNCMessage),
+            CO_OD_VAR(inst, uint32_t, OD_communicationCyclePeriod),
+            CO_OD_VAR(inst, uint8_t, OD_synchronousCounterOverflowValue),
             CO->CANmodule[0],
             CO_RXCAN_SYNC,
             CO->CANmodule[0],
@@ -637,6 +1482,21 @@ CO_ReturnError_t CO_CANopenInit(
 
     if(err){return err;}
 
+#if CO_NO_TIME == 1
+    err = CO_TIME_init(
+            CO->TIME,
+            CO->em,
+            CO->SDO[0],
+           &CO->NMT->operatingState,
+            CO_OD_VAR(inst, uint32_t, OD_COB_ID_TIME),
+            CO_TIME_PRODUCER_INTERVAL_MS,
+            CO->CANmodule[0],
+            CO_RXCAN_TIME,
+            CO->CANmodule[0],
+            CO_TXCAN_TIME);
+
+    if(err){return err;}
+#endif
 
     for(i=0; i<CO_NO_RPDO; i++){
         CO_CANmodule_t *CANdevRx = CO->CANmodule[0];
@@ -651,8 +1511,8 @@ CO_ReturnError_t CO_CANopenInit(
                 nodeId,
                 ((i<4) ? (CO_CAN_ID_RPDO_1+i*0x100) : 0),
                 0,
-                (CO_RPDOCommPar_t*) &OD_RPDOCommunicationParameter[i],
-                (CO_RPDOMapPar_t*) &OD_RPDOMappingParameter[i],
+                (CO_RPDOCommPar_t*) CO_ODrelocate(inst, &OD_RPDOCommunicationParameter[i]),
+                (CO_RPDOMapPar_t*) CO_ODrelocate(inst, &OD_RPDOMappingParameter[i]),
                 OD_H1400_RXPDO_1_PARAM+i,
                 OD_H1600_RXPDO_1_MAPPING+i,
                 CANdevRx,
@@ -661,6 +1521,12 @@ CO_ReturnError_t CO_CANopenInit(
         if(err){return err;}
     }
 
+#ifdef CO_RPDO_DEADLINE
+    err = CO_RPDOdeadline_init(&inst->RPDOdeadline, CO->em, CO->RPDO, CO_NO_RPDO);
+    if(err){return err;}
+    CO->RPDOdeadline = &inst->RPDOdeadline;
+#endif
+
 
     for(i=0; i<CO_NO_TPDO; i++){
         err = CO_TPDO_init(
@@ -671,8 +1537,8 @@ CO_ReturnError_t CO_CANopenInit(
                 nodeId,
                 ((i<4) ? (CO_CAN_ID_TPDO_1+i*0x100) : 0),
                 0,
-                (CO_TPDOCommPar_t*) &OD_TPDOCommunicationParameter[i],
-                (CO_TPDOMapPar_t*) &OD_TPDOMappingParameter[i],
+                (CO_TPDOCommPar_t*) CO_ODrelocate(inst, &OD_TPDOCommunicationParameter[i]),
+                (CO_TPDOMapPar_t*) CO_ODrelocate(inst, &OD_TPDOMappingParameter[i]),
                 OD_H1800_TXPDO_1_PARAM+i,
                 OD_H1A00_TXPDO_1_MAPPING+i,
                 CO->CANmodule[0],
@@ -681,13 +1547,28 @@ CO_ReturnError_t CO_CANopenInit(
         if(err){return err;}
     }
 
+    /* PDOs are processed from lists of enabled PDOs, built on next process */
+    for(i=0; i<CO_NO_RPDO; i++){
+        CO_RPDO_initConfigFlag(CO->RPDO[i], &inst->PDOconfigNew);
+    }
+    for(i=0; i<CO_NO_TPDO; i++){
+        CO_TPDO_initConfigFlag(CO->TPDO[i], &inst->PDOconfigNew);
+    }
+    inst->RPDOactiveCount = 0;
+    inst->TPDOactiveCount = 0;
+    SET_CANrxNew(inst->PDOconfigNew);
+#ifdef CO_TPDO_PRESTAGE
+    inst->TPDOstagedCount = 0;
+    CO_SYNC_initCallbackSync(CO->SYNC, (void*)CO, CO_TPDOreleaseStaged);
+#endif
+
 
     err = CO_HBconsumer_init(
             CO->HBcons,
             CO->em,
             CO->SDO[0],
-           &OD_consumerHeartbeatTime[0],
-            CO_HBcons_monitoredNodes,
+            (uint32_t *)CO_ODrelocate(inst, &OD_consumerHeartbeatTime[0]),
+            inst->HBcons_monitoredNodes,
             CO_NO_HB_CONS,
             CO->CANmodule[0],
             CO_RXCAN_CONS_HB);
@@ -695,6 +1576,31 @@ CO_ReturnError_t CO_CANopenInit(
     if(err){return err;}
 
 
+#if CO_NO_NMT_MASTER == 1
+    CO->NMTmaster = &inst->NMTmaster;
+    err = CO_NMTmaster_init(
+            CO->NMTmaster,
+            CO->HBcons,
+            nodeId,
+            CO->CANmodule[0],
+            CO_TXCAN_NMT);
+
+    if(err){return err;}
+#endif
+
+
+#if CO_NO_EM_CONS == 1
+    CO->EMcons = &inst->EMcons;
+    err = CO_EMconsumer_init(
+            CO->EMcons,
+            nodeId,
+            CO->CANmodule[0],
+            CO_RXCAN_EM_CONS);
+
+    if(err){return err;}
+#endif
+
+
 #if CO_NO_SDO_CLIENT != 0
 
     for(i=0; i<CO_NO_SDO_CLIENT; i++){
@@ -702,7 +1608,7 @@ CO_ReturnError_t CO_CANopenInit(
         err = CO_SDOclient_init(
                 CO->SDOclient[i],
                 CO->SDO[0],
-                (CO_SDOclientPar_t*) &OD_SDOClientParameter[i],
+                (CO_SDOclientPar_t*) CO_ODrelocate(inst, &OD_SDOClientParameter[i]),
                 CO->CANmodule[0],
                 CO_RXCAN_SDO_CLI+i,
                 CO->CANmodule[0],
@@ -716,30 +1622,89 @@ CO_ReturnError_t CO_CANopenInit(
 
 #if CO_NO_TRACE > 0
     for(i=0; i<CO_NO_TRACE; i++) {
+        OD_traceConfig_t *traceConfig = (OD_traceConfig_t *)CO_ODrelocate(inst, &OD_traceConfig[i]);
+        OD_trace_t *trace = (OD_trace_t *)CO_ODrelocate(inst, &OD_trace[i]);
+
         CO_trace_init(
             CO->trace[i],
             CO->SDO[0],
-            OD_traceConfig[i].axisNo,
-            CO_traceTimeBuffers[i],
-            CO_traceValueBuffers[i],
-            CO_traceBufferSize[i],
-            &OD_traceConfig[i].map,
-            &OD_traceConfig[i].format,
-            &OD_traceConfig[i].trigger,
-            &OD_traceConfig[i].threshold,
-            &OD_trace[i].value,
-            &OD_trace[i].min,
-            &OD_trace[i].max,
-            &OD_trace[i].triggerTime,
+            traceConfig->axisNo,
+            inst->traceTimeBuffers[i],
+            inst->traceValueBuffers[i],
+            inst->traceBufferSize[i],
+            &traceConfig->map,
+            &traceConfig->format,
+            &traceConfig->trigger,
+            &traceConfig->threshold,
+            &trace->value,
+            &trace->min,
+            &trace->max,
+            &trace->triggerTime,
             OD_INDEX_TRACE_CONFIG + i,
             OD_INDEX_TRACE + i);
     }
+    CO->traceGroup = NULL;
 #endif
 
     return CO_ERROR_NO;
 }
 
 
+/******************************************************************************/
+CO_ReturnError_t CO_CANopenInit(
+        uint8_t                 nodeId)
+{
+    return CO_CANopenInitInstance(CO, nodeId);
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANopenResetCommInstance(
+        CO_t                   *CO,
+        uint8_t                 nodeId)
+{
+    CO_CANmodule_t *CANmodule;
+    CO_ReturnError_t err;
+
+    if(CO == NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    CANmodule = CO->CANmodule[0];
+
+    /* CAN driver, its buffers and the Object dictionary are kept. Objects are
+     * initialized again over their previous state, which also registers CAN
+     * identifiers from the actual communication parameters. */
+    CANmodule->CANnormal = false;
+    CO_CANclearPendingSyncPDOs(CANmodule);
+
+    err = CO_CANopenInitInstance(CO, nodeId);
+
+    /* Some drivers apply receive filters here */
+    CO_CANsetNormalMode(CANmodule);
+
+    return err;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANopenResetComm(
+        uint8_t                 nodeId)
+{
+    return CO_CANopenResetCommInstance(CO, nodeId);
+}
+
+
+/******************************************************************************/
+void CO_delete(int32_t CANbaseAddress){
+#ifdef CO_USE_GLOBALS
+    CO_CANsetConfigurationMode(CANbaseAddress);
+    CO_CANmodule_disable(CO->CANmodule[0]);
+#else
+    CO_deleteInstance(CO, CANbaseAddress);
+#endif
+}
+
+
 /******************************************************************************/
 CO_ReturnError_t CO_init(
         int32_t                 CANbaseAddress,
@@ -770,122 +1735,379 @@ CO_ReturnError_t CO_init(
 
 
 /******************************************************************************/
-void CO_delete(int32_t CANbaseAddress){
-#ifndef CO_USE_GLOBALS
-    int16_t i;
-#endif
+CO_NMT_reset_cmd_t CO_process(
+        CO_t                   *CO,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
+{
+    CO_instance_t *inst = CO_INSTANCE(CO);
+    uint8_t i;
+    bool_t NMTisPreOrOperational = false;
+    CO_NMT_reset_cmd_t reset = CO_RESET_NOT;
 
-    CO_CANsetConfigurationMode(CANbaseAddress);
-    CO_CANmodule_disable(CO->CANmodule[0]);
+    CO_TP_BEGIN(CO_TP_PROCESS, 0);
 
-#ifndef CO_USE_GLOBALS
-  #if CO_NO_TRACE > 0
-      for(i=0; i<CO_NO_TRACE; i++) {
-          free(CO->trace[i]);
-          free(CO_traceTimeBuffers[i]);
-          free(CO_traceValueBuffers[i]);
-      }
-  #endif
-  #if CO_NO_SDO_CLIENT == 1
-      for(i=0; i<CO_NO_SDO_CLIENT; i++) {
-          free(CO->SDOclient[i]);
-      }
-  #endif
-  #if CO_NO_LSS_SERVER == 1
-    free(CO->LSSslave);
-  #endif
-  #if CO_NO_LSS_CLIENT == 1
-    free(CO->LSSmaster);
-  #if CO_DAISY_CONSUMER == 1
-    free(CO->DaisyConsumer);
-  #endif
-  #if CO_DAISY_PRODUCER == 1
-    free(CO->DaisyProducer);
-  #endif
-  #endif
-    free(CO_HBcons_monitoredNodes);
-    free(CO->HBcons);
-    for(i=0; i<CO_NO_RPDO; i++){
-        free(CO->RPDO[i]);
+    if(CO->NMT->operatingState == CO_NMT_PRE_OPERATIONAL || CO->NMT->operatingState == CO_NMT_OPERATIONAL)
+        NMTisPreOrOperational = true;
+
+#ifndef CO_NMT_NO_LEDS
+    inst->ms50 += timeDifference_ms;
+    while(inst->ms50 >= 50){
+        inst->ms50 -= 50;
+        CO_NMT_blinkingProcess50ms(CO->NMT);
     }
-    for(i=0; i<CO_NO_TPDO; i++){
-        free(CO->TPDO[i]);
+    if(timerNext_ms != NULL){
+        if(*timerNext_ms > (50 - inst->ms50)){
+            *timerNext_ms = 50 - inst->ms50;
+        }
     }
-    free(CO->SYNC);
-    free(CO->NMT);
-    free(CO->emPr);
-    free(CO->em);
-    free(CO_SDO_ODExtensions);
+#endif
+
+
+    /* add SDO servers with new request to the active set */
+    if(IS_CANrxNew(inst->SDOactiveNew)){
+        CLEAR_CANrxNew(inst->SDOactiveNew);
+        for(i=0; i<CO_NO_SDO_SERVER; i++){
+            if(IS_CANrxNew(CO->SDO[i]->CANrxNew)){
+                inst->SDOactive[i / 32U] |= 1UL << (i % 32U);
+            }
+        }
+    }
+
+    /* process active SDO servers, remove idle ones from the set */
     for(i=0; i<CO_NO_SDO_SERVER; i++){
-        free(CO->SDO[i]);
+        uint32_t mask = 1UL << (i % 32U);
+
+        if((inst->SDOactive[i / 32U] & mask) == 0U){
+            continue;
+        }
+
+        CO_SDO_process(
+                CO->SDO[i],
+                NMTisPreOrOperational,
+                timeDifference_ms,
+                1000,
+                timerNext_ms);
+
+        if((CO->SDO[i]->state == CO_SDO_ST_IDLE) && (!IS_CANrxNew(CO->SDO[i]->CANrxNew)) &&
+           ((CO->SDO[i]->rxRing == NULL) || CO_rxRing_isEmpty(CO->SDO[i]->rxRing))){
+            inst->SDOactive[i / 32U] &= ~mask;
+        }
+    }
+
+    CO_EM_process(
+            CO->emPr,
+            NMTisPreOrOperational,
+            timeDifference_ms * 10,
+            CO_OD_VAR(inst, uint16_t, OD_inhibitTimeEMCY),
+            timerNext_ms);
+
+
+    reset = CO_NMT_process(
+            CO->NMT,
+            timeDifference_ms,
+            CO_OD_VAR(inst, uint16_t, OD_producerHeartbeatTime),
+            CO_OD_VAR(inst, uint32_t, OD_NMTStartup),
+            CO_OD_VAR(inst, uint8_t, OD_errorRegister),
+            (const uint8_t *)CO_ODrelocate(inst, &OD_errorBehavior[0]),
+            timerNext_ms);
+
+
+    CO_HBconsumer_process(
+            CO->HBcons,
+            NMTisPreOrOperational,
+            timeDifference_ms,
+            timerNext_ms);
+
+#if CO_NO_TIME == 1
+    CO_TIME_process(
+            CO->TIME,
+            timeDifference_ms,
+            timerNext_ms);
+#endif
+
+#if CO_NO_NMT_MASTER == 1
+    CO_NMTmaster_process(
+            CO->NMTmaster,
+            timerNext_ms);
+#endif
+
+#if CO_NO_EM_CONS == 1
+    CO_EMconsumer_process(
+            CO->EMcons,
+            timeDifference_ms);
+#endif
+
+    CO_TP_END(CO_TP_PROCESS, 0);
+
+    return reset;
+}
+
+
+#ifdef CO_TPDO_SYNC_BUCKETS
+/*
+ * Put TPDO into the bucket of the SYNC cycle, in which it is due.
+ */
+static void CO_TPDObucketInsert(CO_instance_t *inst, uint16_t idx, uint8_t due){
+    inst->TPDObucketDue[idx] = due;
+    inst->TPDObucketNext[idx] = inst->TPDObucket[due];
+    inst->TPDObucket[due] = idx;
+}
+
+
+/*
+ * Rebuild buckets from the list of synchronous cyclic TPDOs.
+ *
+ * Running TPDOs keep their SYNC cycle. New TPDOs (_syncCounter_ 255) without
+ * SYNC start value are placed into the least loaded bucket within their
+ * period, others wait for the SYNC start value (_syncCounter_ 254).
+ */
+static void CO_TPDObucketBuild(CO_t *CO){
+    CO_instance_t *inst = CO_INSTANCE(CO);
+    uint16_t i;
+
+    for(i=0; i<256; i++){
+        inst->TPDObucket[i] = CO_TPDO_BUCKET_END;
+    }
+    inst->TPDObucketWaiting = CO_TPDO_BUCKET_END;
+
+    for(i=inst->TPDOactiveAcyclic; i<inst->TPDOactiveCount; i++){
+        uint16_t idx = inst->TPDOactive[i];
+        CO_TPDO_t *TPDO = CO->TPDO[idx];
+        uint8_t transmissionType = TPDO->TPDOCommPar->transmissionType;
+
+        if(TPDO->syncCounter == 255){
+            if(CO->SYNC->counterOverflowValue && TPDO->TPDOCommPar->SYNCStartValue){
+                TPDO->syncCounter = 254;
+            }
+            else{
+                uint8_t p;
+                uint8_t best = transmissionType;
+                uint16_t bestLoad = 0xFFFFU;
+
+                /* first transmission not later than by CO_TPDO_process() */
+                for(p=1; p<=transmissionType; p++){
+                    uint16_t load = 0;
+                    uint16_t j;
+
+                    for(j=inst->TPDObucket[(uint8_t)(inst->TPDObucketCycle+p)]; j!=CO_TPDO_BUCKET_END; j=inst->TPDObucketNext[j]){
+                        load++;
+                    }
+                    if(load < bestLoad){
+                        bestLoad = load;
+                        best = p;
+                    }
+                    if(load == 0){
+                        break;
+                    }
+                }
+                inst->TPDObucketDue[idx] = (uint8_t)(inst->TPDObucketCycle + best);
+                TPDO->syncCounter = transmissionType;
+            }
+        }
+
+        if(TPDO->syncCounter == 254){
+            inst->TPDObucketNext[idx] = inst->TPDObucketWaiting;
+            inst->TPDObucketWaiting = idx;
+        }
+        else{
+            CO_TPDObucketInsert(inst, idx, inst->TPDObucketDue[idx]);
+        }
     }
-    free(CO_CANmodule_txArray0);
-    free(CO_CANmodule_rxArray0);
-    free(CO->CANmodule[0]);
-    CO = NULL;
-#endif
 }
 
 
-/******************************************************************************/
-CO_NMT_reset_cmd_t CO_process(
-        CO_t                   *CO,
-        uint16_t                timeDifference_ms,
-        uint16_t               *timerNext_ms)
-{
-    uint8_t i;
-    bool_t NMTisPreOrOperational = false;
-    CO_NMT_reset_cmd_t reset = CO_RESET_NOT;
-    static uint16_t ms50 = 0;
-
-    if(CO->NMT->operatingState == CO_NMT_PRE_OPERATIONAL || CO->NMT->operatingState == CO_NMT_OPERATIONAL)
-        NMTisPreOrOperational = true;
+/*
+ * Send synchronous cyclic TPDOs, which are due in this SYNC cycle.
+ */
+static void CO_TPDObucketProcess(CO_t *CO){
+    CO_instance_t *inst = CO_INSTANCE(CO);
+    uint16_t idx;
+    uint16_t next;
+    uint16_t *prev;
+    uint8_t cycle = ++inst->TPDObucketCycle;
+
+    /* TPDOs waiting for SYNC start value */
+    prev = &inst->TPDObucketWaiting;
+    for(idx=inst->TPDObucketWaiting; idx!=CO_TPDO_BUCKET_END; idx=next){
+        CO_TPDO_t *TPDO = CO->TPDO[idx];
+        uint8_t transmissionType = TPDO->TPDOCommPar->transmissionType;
+
+        next = inst->TPDObucketNext[idx];
+        if(transmissionType == 0 || transmissionType > 240){
+            /* transmission type changed, buckets are rebuilt in the next call */
+            SET_CANrxNew(inst->PDOconfigNew);
+            prev = &inst->TPDObucketNext[idx];
+        }
+        else if(CO->SYNC->counter == TPDO->TPDOCommPar->SYNCStartValue){
+            *prev = next;
+            TPDO->syncCounter = transmissionType;
+            /* manual TPDO handling is done by user application, keep the
+             * TPDO scheduled anyway */
+            if(!CO_TPDO_isManualControl(TPDO)){
+                (void)CO_TPDOsendSync(TPDO, CO->SYNC);
+            }
+            CO_TPDObucketInsert(inst, idx, (uint8_t)(cycle + transmissionType));
+        }
+        else{
+            prev = &inst->TPDObucketNext[idx];
+        }
+    }
 
-    ms50 += timeDifference_ms;
-    if(ms50 >= 50){
-        ms50 -= 50;
-        CO_NMT_blinkingProcess50ms(CO->NMT);
+    /* TPDOs due in this SYNC cycle */
+    idx = inst->TPDObucket[cycle];
+    inst->TPDObucket[cycle] = CO_TPDO_BUCKET_END;
+    for(; idx!=CO_TPDO_BUCKET_END; idx=next){
+        CO_TPDO_t *TPDO = CO->TPDO[idx];
+        uint8_t transmissionType = TPDO->TPDOCommPar->transmissionType;
+
+        next = inst->TPDObucketNext[idx];
+        if(transmissionType == 0 || transmissionType > 240){
+            SET_CANrxNew(inst->PDOconfigNew);
+            CO_TPDObucketInsert(inst, idx, cycle);
+            continue;
+        }
+        if(!CO_TPDO_isManualControl(TPDO)){
+            (void)CO_TPDOsendSync(TPDO, CO->SYNC);
+        }
+        CO_TPDObucketInsert(inst, idx, (uint8_t)(cycle + transmissionType));
     }
-    if(timerNext_ms != NULL){
-        if(*timerNext_ms > 50){
-            *timerNext_ms = 50;
+}
+#endif
+
+
+#ifdef CO_TPDO_PRESTAGE
+/*
+ * Stage synchronous TPDOs, which will be due with the next SYNC.
+ *
+ * The list is empty while it is rebuilt, TPDOs are then sent after the SYNC.
+ */
+static void CO_TPDOstageProcess(CO_t *CO){
+    CO_instance_t *inst = CO_INSTANCE(CO);
+    uint16_t i;
+    uint16_t n = 0;
+
+    CO_LOCK_OD();
+    inst->TPDOstagedCount = 0;
+    CO_UNLOCK_OD();
+
+    for(i=inst->TPDOactiveEvent; i<inst->TPDOactiveCount; i++){
+        uint16_t idx = inst->TPDOactive[i];
+        CO_TPDO_t *TPDO = CO->TPDO[idx];
+        uint8_t transmissionType = TPDO->TPDOCommPar->transmissionType;
+        bool_t due;
+
+        if(transmissionType == 0){
+            due = TPDO->sendRequest != 0;
+        }
+        else if(transmissionType > 240){
+            due = false;
+        }
+#ifdef CO_TPDO_SYNC_BUCKETS
+        else{
+            /* not waiting for SYNC start value and in the next bucket */
+            due = TPDO->syncCounter < 254 &&
+                  inst->TPDObucketDue[idx] == (uint8_t)(inst->TPDObucketCycle + 1);
+        }
+#else
+        else if(TPDO->syncCounter == 255){
+            /* first SYNC, if SYNC start value is not in use */
+            due = transmissionType == 1 &&
+                  !(CO->SYNC->counterOverflowValue && TPDO->TPDOCommPar->SYNCStartValue);
+        }
+        else{
+            due = TPDO->syncCounter == 1;
+        }
+#endif
+
+        if(CO_TPDO_stage(TPDO, due)){
+            inst->TPDOstaged[n++] = idx;
         }
     }
 
+    CO_LOCK_OD();
+    inst->TPDOstagedCount = n;
+    CO_UNLOCK_OD();
+}
+#endif
 
-    for(i=0; i<CO_NO_SDO_SERVER; i++){
-        CO_SDO_process(
-                CO->SDO[i],
-                NMTisPreOrOperational,
-                timeDifference_ms,
-                1000,
-                timerNext_ms);
+
+/*
+ * Rebuild lists of enabled PDOs, if configuration of any PDO has changed.
+ *
+ * Transmission type of TPDO is written to the Object Dictionary after the
+ * flag is set, so configuration is verified again, if transmission type does
+ * not match the syncFlag yet.
+ */
+static void CO_PDOupdateActive(CO_t *CO){
+    CO_instance_t *inst = CO_INSTANCE(CO);
+    uint16_t i;
+    uint16_t n;
+    bool_t pending = false;
+
+    if(!IS_CANrxNew(inst->PDOconfigNew)){
+        return;
     }
+    CLEAR_CANrxNew(inst->PDOconfigNew);
 
-    CO_EM_process(
-            CO->emPr,
-            NMTisPreOrOperational,
-            timeDifference_ms * 10,
-            OD_inhibitTimeEMCY,
-            timerNext_ms);
+    n = 0;
+    for(i=0; i<CO_NO_RPDO; i++){
+        if(CO->RPDO[i]->valid && !CO->RPDO[i]->synchronous){
+            inst->RPDOactive[n++] = i;
+        }
+    }
+    inst->RPDOactiveAsync = n;
+    for(i=0; i<CO_NO_RPDO; i++){
+        if(CO->RPDO[i]->valid && CO->RPDO[i]->synchronous){
+            inst->RPDOactive[n++] = i;
+        }
+    }
+    inst->RPDOactiveCount = n;
+#ifdef CO_RPDO_DEADLINE
+    CO_RPDOdeadline_rearm(&inst->RPDOdeadline);
+#endif
 
+    n = 0;
+    for(i=0; i<CO_NO_TPDO; i++){
+        CO_TPDO_t *TPDO = CO->TPDO[i];
 
-    reset = CO_NMT_process(
-            CO->NMT,
-            timeDifference_ms,
-            OD_producerHeartbeatTime,
-            OD_NMTStartup,
-            OD_errorRegister,
-            OD_errorBehavior,
-            timerNext_ms);
+        if(TPDO->valid && (TPDO->TPDOCommPar->transmissionType <= 240) != (TPDO->CANtxBuff->syncFlag != 0)){
+            pending = true;
+        }
+        if(TPDO->valid && TPDO->TPDOCommPar->transmissionType > 240){
+            uint16_t j;
+
+            /* sorted by CAN identifier, so the send budget goes to the most
+             * urgent TPDOs first */
+            for(j=n++; j>0 && CO->TPDO[inst->TPDOactive[j-1]]->CAN_ID > TPDO->CAN_ID; j--){
+                inst->TPDOactive[j] = inst->TPDOactive[j-1];
+            }
+            inst->TPDOactive[j] = i;
+        }
+    }
+    inst->TPDOactiveEvent = n;
+    for(i=0; i<CO_NO_TPDO; i++){
+        if(CO->TPDO[i]->valid && CO->TPDO[i]->TPDOCommPar->transmissionType == 0){
+            inst->TPDOactive[n++] = i;
+        }
+    }
+    inst->TPDOactiveAcyclic = n;
+    for(i=0; i<CO_NO_TPDO; i++){
+        uint8_t transmissionType = CO->TPDO[i]->TPDOCommPar->transmissionType;
 
+        if(CO->TPDO[i]->valid && transmissionType != 0 && transmissionType <= 240){
+            inst->TPDOactive[n++] = i;
+        }
+    }
+    inst->TPDOactiveCount = n;
 
-    CO_HBconsumer_process(
-            CO->HBcons,
-            NMTisPreOrOperational,
-            timeDifference_ms);
+#ifdef CO_TPDO_SYNC_BUCKETS
+    CO_TPDObucketBuild(CO);
+#endif
 
-    return reset;
+    if(pending){
+        SET_CANrxNew(inst->PDOconfigNew);
+    }
 }
 
 
@@ -894,10 +2116,21 @@ bool_t CO_process_SYNC_RPDO(
         CO_t                   *CO,
         uint32_t                timeDifference_us)
 {
-    int16_t i;
+    CO_instance_t *inst = CO_INSTANCE(CO);
+    uint16_t i;
+    uint16_t n;
     bool_t syncWas = false;
 
-    switch(CO_SYNC_process(CO->SYNC, timeDifference_us, OD_synchronousWindowLength)){
+    CO_TP_BEGIN(CO_TP_PROCESS_SYNC_RPDO, 0);
+
+#ifdef CO_USE_STATISTICS
+    /* time base is advanced by the instance, which was initialized first */
+    if(CO_statistics == &inst->statisticsCAN){
+        CO_statistics_addTime(timeDifference_us);
+    }
+#endif
+
+    switch(CO_SYNC_process(CO->SYNC, timeDifference_us, CO_OD_VAR(inst, uint32_t, OD_synchronousWindowLength))){
         case 1:     //immediately after the SYNC message
             syncWas = true;
             break;
@@ -906,9 +2139,40 @@ bool_t CO_process_SYNC_RPDO(
             break;
     }
 
-    for(i=0; i<CO_NO_RPDO; i++){
-        CO_RPDO_process(CO->RPDO[i], syncWas);
+    CO_PDOupdateActive(CO);
+
+    /* Synchronous RPDOs are processed after SYNC only. In other NMT states
+     * they are processed always, so received messages are discarded. */
+    n = (syncWas || CO->NMT->operatingState != CO_NMT_OPERATIONAL) ?
+        inst->RPDOactiveCount : inst->RPDOactiveAsync;
+    for(i=0; i<n; i++){
+        CO_RPDO_process(CO->RPDO[inst->RPDOactive[i]], syncWas);
+    }
+
+#ifdef CO_RPDO_DEADLINE
+    CO_RPDOdeadline_process(&inst->RPDOdeadline,
+            CO->NMT->operatingState == CO_NMT_OPERATIONAL, timeDifference_us);
+#endif
+
+#if CO_NO_TRACE > 0
+    {
+        /* sample trace groups after the received synchronous RPDOs */
+        CO_traceGroup_t *group;
+
+        for(group = CO->traceGroup; group != NULL; group = group->next){
+            CO_traceGroup_process(group, syncWas, timeDifference_us);
+        }
+
+        /* release traces, which wait for SYNC */
+        if(syncWas){
+            for(i=0; i<CO_NO_TRACE; i++){
+                CO_trace_sync(CO->trace[i], CO->SYNC->counter);
+            }
+        }
     }
+#endif
+
+    CO_TP_END(CO_TP_PROCESS_SYNC_RPDO, 0);
 
     return syncWas;
 }
@@ -920,19 +2184,135 @@ void CO_process_TPDO(
         bool_t                  syncWas,
         uint32_t                timeDifference_us)
 {
-    int16_t i;
+    CO_instance_t *inst = CO_INSTANCE(CO);
+    uint16_t i;
+    uint16_t n;
+#ifdef CO_USE_STATISTICS
+    bool_t busLoadHigh;
+#endif
 
-    for(i=0; i<CO_NO_TPDO; i++){
-        if(CO_TPDO_isManualControl(CO->TPDO[i])) {
+    CO_TP_BEGIN(CO_TP_PROCESS_TPDO, 0);
+
+    CO_PDOupdateActive(CO);
+
+    /* refill send budget of event driven TPDOs */
+    if(inst->TPDObudgetPeriod != 0U){
+        uint32_t period = (uint32_t)inst->TPDObudgetPeriod * 100U;
+
+        inst->TPDObudgetTimer += timeDifference_us;
+        if(inst->TPDObudgetTimer >= period){
+            uint32_t tokens = inst->TPDObudgetTokens + inst->TPDObudgetTimer / period;
+
+            inst->TPDObudgetTimer %= period;
+            if(tokens >= inst->TPDObudgetBurst){
+                tokens = inst->TPDObudgetBurst;
+                inst->TPDObudgetTimer = 0;
+            }
+            inst->TPDObudgetTokens = (uint16_t)tokens;
+        }
+    }
+
+#ifdef CO_USE_STATISTICS
+    busLoadHigh = inst->TPDOloadLimit != 0U &&
+        CO_statistics_busLoad(&inst->statisticsCAN, CO_STAT_BUS_100MS) >= inst->TPDOloadLimit;
+    for(i=0; i<inst->TPDOactiveEvent; i++){
+        CO_TPDO_t *TPDO = CO->TPDO[inst->TPDOactive[i]];
+        TPDO->deferSend = busLoadHigh && TPDO->deferrable;
+    }
+#endif
+
+    /* Synchronous cyclic TPDOs are processed after SYNC only, change of state
+     * is verified for event driven and synchronous acyclic TPDOs. */
+#ifdef CO_TPDO_SYNC_BUCKETS
+    /* synchronous cyclic TPDOs are processed from buckets */
+    if(syncWas && CO->NMT->operatingState == CO_NMT_OPERATIONAL){
+        CO_TPDObucketProcess(CO);
+    }
+    n = inst->TPDOactiveAcyclic;
+#else
+    n = syncWas ? inst->TPDOactiveCount : inst->TPDOactiveAcyclic;
+#endif
+
+#ifdef TPDO_COS_DIRTY_FLAGS
+    /* Latch dirty flags of all TPDOs first, variable may be mapped to more
+     * than one TPDO. Flags are taken over atomically, writes after latching
+     * are detected in the next call. */
+    for(i=0; i<inst->TPDOactiveAcyclic; i++){
+        CO_TPDOlatchCOSdirty(CO->TPDO[inst->TPDOactive[i]]);
+    }
+    for(i=0; i<inst->TPDOactiveAcyclic; i++){
+        CO_TPDO_t *TPDO = CO->TPDO[inst->TPDOactive[i]];
+        TPDO->COSdirty = CO_TPDOisCOSdirty(TPDO);
+    }
+    for(i=0; i<inst->TPDOactiveAcyclic; i++){
+        CO_TPDOclearCOSdirty(CO->TPDO[inst->TPDOactive[i]]);
+    }
+#endif
+
+    /* Verify change of state of event driven and synchronous acyclic TPDOs,
+     * in blocks of CO_TPDO_COS_BULK */
+    {
+        CO_TPDO_t *cosTPDO[CO_TPDO_COS_BULK];
+        uint16_t cosCount = 0;
+
+        for(i=0; i<inst->TPDOactiveAcyclic; i++){
+            CO_TPDO_t *TPDO = CO->TPDO[inst->TPDOactive[i]];
+
+            /* manual TPDO handling is done by user application */
+#ifdef TPDO_COS_DIRTY_FLAGS
+            if(!TPDO->sendRequest && TPDO->COSdirty && !CO_TPDO_isManualControl(TPDO)){
+#else
+            if(!TPDO->sendRequest && !CO_TPDO_isManualControl(TPDO)){
+#endif
+                cosTPDO[cosCount++] = TPDO;
+            }
+            if(cosCount == CO_TPDO_COS_BULK ||
+               (cosCount > 0U && (i + 1U) == inst->TPDOactiveAcyclic)){
+                uint16_t cosList[CO_TPDO_COS_BULK];
+                uint16_t j, m;
+
+                m = CO_TPDOisCOSbulk(cosTPDO, cosCount, cosList);
+                for(j=0; j<m; j++){
+                    cosTPDO[cosList[j]]->sendRequest = 1;
+                }
+                cosCount = 0;
+            }
+        }
+    }
+
+    for(i=0; i<n; i++){
+        CO_TPDO_t *TPDO = CO->TPDO[inst->TPDOactive[i]];
+        uint8_t transmissionType = TPDO->TPDOCommPar->transmissionType;
+
+        /* transmission type changed, list is rebuilt in the next call */
+        if((i < inst->TPDOactiveEvent) ? (transmissionType <= 240) :
+           (i < inst->TPDOactiveAcyclic) ? (transmissionType != 0) :
+           (transmissionType == 0 || transmissionType > 240)){
+            SET_CANrxNew(inst->PDOconfigNew);
+        }
+
+        if(CO_TPDO_isManualControl(TPDO)) {
             /* TPDO handling is done by user application */
             continue;
         }
-        if(!CO->TPDO[i]->sendRequest) {
-            /* Verify PDO Change of State */
-            CO->TPDO[i]->sendRequest = CO_TPDOisCOS(CO->TPDO[i]);
+        if(i < inst->TPDOactiveEvent && inst->TPDObudgetPeriod != 0U){
+            /* event driven TPDOs are sorted by CAN identifier, lower ones
+             * take the tokens first */
+            TPDO->budgetBlocked = inst->TPDObudgetTokens == 0U;
+            if(CO_TPDO_process(TPDO, CO->SYNC, syncWas, timeDifference_us) == CO_ERROR_NO){
+                inst->TPDObudgetTokens--;
+            }
+        }
+        else{
+            CO_TPDO_process(TPDO, CO->SYNC, syncWas, timeDifference_us);
         }
-        CO_TPDO_process(CO->TPDO[i], CO->SYNC, syncWas, timeDifference_us);
     }
+
+#ifdef CO_TPDO_PRESTAGE
+    CO_TPDOstageProcess(CO);
+#endif
+
+    CO_TP_END(CO_TP_PROCESS_TPDO, 0);
 }
 
 
@@ -974,3 +2354,287 @@ CO_TPDO_t* CO_get_TPDO(
   }
   return NULL;
 }
+
+
+/******************************************************************************/
+void CO_setTPDObudget(
+        CO_t                   *CO,
+        uint16_t                burst,
+        uint16_t                period)
+{
+    CO_instance_t *inst = CO_INSTANCE(CO);
+    int16_t i;
+
+    if(CO == NULL){
+        return;
+    }
+
+    inst->TPDObudgetBurst = burst;
+    inst->TPDObudgetPeriod = (burst != 0U) ? period : 0U;
+    inst->TPDObudgetTokens = burst;
+    inst->TPDObudgetTimer = 0;
+    for(i=0; i<CO_NO_TPDO; i++){
+        CO->TPDO[i]->budgetBlocked = false;
+    }
+}
+
+
+/******************************************************************************/
+CO_SDO_abortCode_t CO_ODF_TPDObudget(CO_ODF_arg_t *ODF_arg){
+    CO_t *CO_this = (CO_t*) ODF_arg->object;
+    CO_instance_t *inst = CO_INSTANCE(CO_this);
+    uint16_t burst = inst->TPDObudgetBurst;
+    uint16_t period = inst->TPDObudgetPeriod;
+
+    if(ODF_arg->subIndex == 0U){
+        return CO_SDO_AB_NONE;
+    }
+    if(ODF_arg->subIndex > 2U){
+        return CO_SDO_AB_SUB_UNKNOWN;
+    }
+    if(ODF_arg->dataLength != 2U){
+        return CO_SDO_AB_TYPE_MISMATCH;
+    }
+
+    if(ODF_arg->reading){
+        CO_setUint16(ODF_arg->data, (ODF_arg->subIndex == 1U) ? burst : period);
+    }
+    else{
+        if(ODF_arg->subIndex == 1U){
+            burst = CO_getUint16(ODF_arg->data);
+        }
+        else{
+            period = CO_getUint16(ODF_arg->data);
+        }
+        CO_setTPDObudget(CO_this, burst, period);
+    }
+
+    return CO_SDO_AB_NONE;
+}
+
+
+#ifdef CO_USE_STATISTICS
+/******************************************************************************/
+static uint32_t CO_statisticsSum(const uint32_t count[], uint16_t first, uint16_t number){
+    uint32_t sum = 0;
+    uint16_t i;
+
+    for(i=first; i<(first+number); i++){
+        sum += count[i];
+    }
+    return sum;
+}
+
+
+/******************************************************************************/
+bool_t CO_getStatistics(
+        CO_t                   *CO,
+        uint8_t                 subIndex,
+        uint32_t               *value)
+{
+    const uint32_t *rx;
+    const uint32_t *tx;
+    uint32_t val = 0;
+
+    if(CO == NULL || value == NULL || subIndex >= CO_STAT_SUB_END){
+        return false;
+    }
+    rx = CO_INSTANCE(CO)->statisticsRxCount;
+    tx = CO_INSTANCE(CO)->statisticsTxCount;
+
+    switch(subIndex){
+        case 0:  val = CO_STAT_SUB_END - 1; break;
+        case 1:  val = rx[CO_RXCAN_NMT]; break;
+        case 2:  val = CO_statisticsSum(tx, CO_TXCAN_NMT, CO_NO_NMT_MASTER); break;
+        case 3:  val = CO_statisticsSum(rx, CO_RXCAN_SYNC, CO_NO_SYNC); break;
+        case 4:  val = CO_statisticsSum(tx, CO_TXCAN_SYNC, CO_NO_SYNC); break;
+        case 5:  val = CO_statisticsSum(tx, CO_TXCAN_EMERG, CO_NO_EMERGENCY); break;
+        case 6:  val = CO_statisticsSum(rx, CO_RXCAN_CONS_HB, CO_NO_HB_CONS); break;
+        case 7:  val = CO_statisticsSum(tx, CO_TXCAN_HB, CO_NO_HB_PROD); break;
+        case 8:  val = CO_statisticsSum(rx, CO_RXCAN_SDO_SRV, CO_NO_SDO_SERVER); break;
+        case 9:  val = CO_statisticsSum(tx, CO_TXCAN_SDO_SRV, CO_NO_SDO_SERVER)
+                     + CO_statisticsSum(tx, CO_TXCAN_SDO_FAST, CO_NO_SDO_FAST); break;
+        case 10: val = CO_statisticsSum(rx, CO_RXCAN_SDO_CLI, CO_NO_SDO_CLIENT); break;
+        case 11: val = CO_statisticsSum(tx, CO_TXCAN_SDO_CLI, CO_NO_SDO_CLIENT); break;
+        case 12: val = CO_statisticsSum(rx, CO_RXCAN_LSS, CO_NO_LSS_SERVER+CO_NO_LSS_CLIENT); break;
+        case 13: val = CO_statisticsSum(tx, CO_TXCAN_LSS, CO_NO_LSS_SERVER+CO_NO_LSS_CLIENT); break;
+        case 14: val = CO_statisticsSum(rx, CO_RXCAN_DAISY, CO_NO_DAISY); break;
+        case 15: val = CO_statisticsSum(tx, CO_TXCAN_DAISY, CO_NO_DAISY); break;
+        default:
+            if(subIndex >= CO_STAT_SUB_BUS){
+                val = CO_statistics_busLoad(&CO_INSTANCE(CO)->statisticsCAN,
+                        (CO_statistics_busWindow_t)(subIndex - CO_STAT_SUB_BUS));
+            }
+            else if(subIndex < CO_STAT_SUB_TPDO){
+                uint16_t i = (subIndex - CO_STAT_SUB_RPDO) / 3;
+                const CO_RPDO_t *RPDO = CO->RPDO[i];
+
+                switch((subIndex - CO_STAT_SUB_RPDO) % 3){
+                    case 0:  val = rx[CO_RXCAN_RPDO+i]; break;
+                    case 1:  val = RPDO->latency_us; break;
+                    default: val = RPDO->missedCount; break;
+                }
+            }
+            else{
+                uint16_t i = (subIndex - CO_STAT_SUB_TPDO) / 3;
+                const CO_TPDO_t *TPDO = CO->TPDO[i];
+
+                switch((subIndex - CO_STAT_SUB_TPDO) % 3){
+                    case 0:  val = tx[CO_TXCAN_TPDO+i]; break;
+                    case 1:  val = TPDO->latency_us; break;
+                    default: val = TPDO->missedCount; break;
+                }
+            }
+            break;
+    }
+
+    *value = val;
+    return true;
+}
+
+
+/******************************************************************************/
+void CO_setTPDOloadLimit(CO_t *CO, uint16_t limit){
+    if(CO != NULL){
+        CO_INSTANCE(CO)->TPDOloadLimit = limit;
+    }
+}
+
+
+/******************************************************************************/
+void CO_resetStatistics(CO_t *CO){
+    int16_t i;
+
+    if(CO == NULL){
+        return;
+    }
+
+    CO_statistics_reset(&CO_INSTANCE(CO)->statisticsCAN);
+    for(i=0; i<CO_NO_RPDO; i++){
+        CO->RPDO[i]->latency_us = 0;
+        CO->RPDO[i]->missedCount = 0;
+    }
+    for(i=0; i<CO_NO_TPDO; i++){
+        CO->TPDO[i]->latency_us = 0;
+        CO->TPDO[i]->missedCount = 0;
+    }
+}
+
+
+/******************************************************************************/
+CO_SDO_abortCode_t CO_ODF_statistics(CO_ODF_arg_t *ODF_arg){
+    CO_t *CO_this = (CO_t*) ODF_arg->object;
+    uint32_t value;
+
+    if(!CO_getStatistics(CO_this, ODF_arg->subIndex, &value)){
+        return CO_SDO_AB_SUB_UNKNOWN;
+    }
+
+    if(ODF_arg->reading){
+        if(ODF_arg->subIndex == 0U){
+            ODF_arg->data[0] = (uint8_t) value;
+        }
+        else if(ODF_arg->dataLength == 4U){
+            CO_setUint32(ODF_arg->data, value);
+        }
+    }
+    else{
+        if(ODF_arg->subIndex == 0U){
+            return CO_SDO_AB_READONLY;
+        }
+        CO_resetStatistics(CO_this);
+    }
+
+    return CO_SDO_AB_NONE;
+}
+#endif
+
+
+#ifdef CO_LOCK_STATISTICS
+/******************************************************************************/
+CO_SDO_abortCode_t CO_ODF_lockStatistics(CO_ODF_arg_t *ODF_arg){
+    CO_lockStatistics_t *stat = (CO_lockStatistics_t*) ODF_arg->object;
+    uint32_t value;
+
+    switch(ODF_arg->subIndex){
+        case 0U: value = 6U;                                        break;
+        case 1U: value = stat->lockCount;                           break;
+        case 2U: value = stat->contentionCount;                     break;
+        case 3U: value = stat->overrunCount;                        break;
+        case 4U: value = stat->maxHoldTime;                         break;
+        case 5U: value = (uint32_t)(uintptr_t)stat->maxHolder;      break;
+        case 6U: value = stat->holdLimit;                           break;
+        default: return CO_SDO_AB_SUB_UNKNOWN;
+    }
+
+    if(ODF_arg->reading){
+        if(ODF_arg->subIndex == 0U){
+            ODF_arg->data[0] = (uint8_t) value;
+        }
+        else if(ODF_arg->dataLength == 4U){
+            CO_setUint32(ODF_arg->data, value);
+        }
+    }
+    else if(ODF_arg->subIndex == 0U){
+        return CO_SDO_AB_READONLY;
+    }
+    else if(ODF_arg->subIndex == 6U){
+        stat->holdLimit = CO_getUint32(ODF_arg->data);
+    }
+    else{
+        stat->lockCount = 0U;
+        stat->contentionCount = 0U;
+        stat->overrunCount = 0U;
+        stat->maxHoldTime = 0U;
+        stat->maxHolder = NULL;
+    }
+
+    return CO_SDO_AB_NONE;
+}
+#endif
+
+
+#ifdef CO_DRIVER_ERROR_REPORTING
+/******************************************************************************/
+CO_SDO_abortCode_t CO_ODF_CANerrorStatistics(CO_ODF_arg_t *ODF_arg){
+    CO_CANinterfaceErrorhandler_t *errorhandler = (CO_CANinterfaceErrorhandler_t*) ODF_arg->object;
+    CO_CANerrorStatistics_t *stat = &errorhandler->stats;
+    uint32_t value;
+
+    switch(ODF_arg->subIndex){
+        case 0U: value = 8U;                                        break;
+        case 1U: value = stat->busoffCount;                         break;
+        case 2U: value = stat->noackCount;                          break;
+        case 3U: value = stat->retryCount;                          break;
+        case 4U: value = stat->recoverCount;                        break;
+        case 5U: value = stat->recoverLast;                         break;
+        case 6U: value = stat->recoverMax;                          break;
+        case 7U: value = stat->downtime;                            break;
+        case 8U: value = errorhandler->backoff;                     break;
+        default: return CO_SDO_AB_SUB_UNKNOWN;
+    }
+
+    if(ODF_arg->reading){
+        if(ODF_arg->subIndex == 0U){
+            ODF_arg->data[0] = (uint8_t) value;
+        }
+        else if(ODF_arg->dataLength == 4U){
+            CO_setUint32(ODF_arg->data, value);
+        }
+    }
+    else if(ODF_arg->subIndex == 0U || ODF_arg->subIndex == 8U){
+        return CO_SDO_AB_READONLY;
+    }
+    else{
+        stat->busoffCount = 0U;
+        stat->noackCount = 0U;
+        stat->retryCount = 0U;
+        stat->recoverCount = 0U;
+        stat->recoverLast = 0U;
+        stat->recoverMax = 0U;
+        stat->downtime = 0U;
+    }
+
+    return CO_SDO_AB_NONE;
+}
+#endif
@@ -5,7 +5,8 @@
  * Configuration information are read from CO_OD.h file. This file uses one
  * CAN module. If multiple CAN modules are to be used, then this file may be
  * customized for different CANopen configuration. (One or multiple CANopen
- * device on one or multiple CAN modules.)
+ * device on one or multiple CAN modules.) Without CO_USE_GLOBALS additional
+ * devices with the same configuration may be created with CO_newInstance().
  *
  * @file        CANopen.h
  * @ingroup     CO_CANopen
@@ -83,18 +84,36 @@ extern "C" {
     #include "CO_SYNC.h"
     #include "CO_PDO.h"
     #include "CO_HBconsumer.h"
+    #include "CO_tracepoint.h"
+    #include "CO_statistics.h"
+    #include "CO_DCF.h"
 #if CO_NO_SDO_CLIENT != 0
     #include "CO_SDOmaster.h"
+    #include "CO_SDOqueue.h"
+    #include "CO_SDOscan.h"
+    #include "CO_PDOplan.h"
 #endif
-#if CO_NO_TRACE > 0
+#if CO_NO_TRACE > 0 || CO_NO_SDO_CLIENT != 0
     #include "CO_trace.h"
 #endif
+#if CO_NO_SDO_CLIENT != 0
+    #include "CO_traceCollect.h"
+#endif
+#if CO_NO_TIME == 1
+    #include "CO_TIME.h"
+#endif
 #if CO_NO_LSS_SERVER == 1
     #include "CO_LSSslave.h"
 #endif
 #if CO_NO_LSS_CLIENT == 1
     #include "CO_LSSmaster.h"
 #endif
+#if CO_NO_NMT_MASTER == 1
+    #include "CO_NMTmaster.h"
+#endif
+#if CO_NO_EM_CONS == 1
+    #include "CO_EMconsumer.h"
+#endif
 #if CO_DAISY_PRODUCER == 1 || CO_DAISY_CONSUMER == 1
     #include "CO_Daisychain.h"
 #endif
@@ -141,7 +160,19 @@ typedef struct{
     CO_SYNC_t          *SYNC;           /**< SYNC object */
     CO_RPDO_t          *RPDO[CO_NO_RPDO];/**< RPDO objects */
     CO_TPDO_t          *TPDO[CO_NO_TPDO];/**< TPDO objects */
+#ifdef CO_RPDO_DEADLINE
+    CO_RPDOdeadline_t  *RPDOdeadline;   /**< RPDO deadline monitoring, see CO_RPDO_setDeadline() */
+#endif
     CO_HBconsumer_t    *HBcons;         /**<  Heartbeat consumer object*/
+#if CO_NO_TIME == 1
+    CO_TIME_t          *TIME;           /**< TIME object */
+#endif
+#if CO_NO_NMT_MASTER == 1
+    CO_NMTmaster_t     *NMTmaster;      /**< NMT master object with network state table */
+#endif
+#if CO_NO_EM_CONS == 1
+    CO_EMconsumer_t    *EMcons;         /**< Emergency consumer object */
+#endif
 #if CO_NO_LSS_SERVER == 1
     CO_LSSslave_t      *LSSslave;       /**< LSS server/slave object */
 #endif
@@ -159,6 +190,7 @@ typedef struct{
 #endif
 #if CO_NO_TRACE > 0
     CO_trace_t         *trace[CO_NO_TRACE]; /**< Trace object for monitoring variables */
+    CO_traceGroup_t    *traceGroup;     /**< List of trace groups sampled on SYNC, set by application, or NULL */
 #endif
 }CO_t;
 
@@ -167,6 +199,46 @@ typedef struct{
     extern CO_t *CO;
 
 
+/**
+ * Groups of objects allocated by CO_new(), see CO_getMemoryInfo().
+ *
+ * Order is the layout of the memory block in CO_USE_ARENA mode: objects used
+ * by the realtime thread come first, objects of the same type are contiguous.
+ */
+typedef enum{
+    CO_MEM_CANMODULE,       /**< CAN module */
+    CO_MEM_CANRX,           /**< CAN receive buffers */
+    CO_MEM_CANTX,           /**< CAN transmit buffers */
+    CO_MEM_SYNC,            /**< SYNC object */
+    CO_MEM_RPDO,            /**< RPDO objects */
+    CO_MEM_TPDO,            /**< TPDO objects */
+    CO_MEM_NMT,             /**< NMT object */
+    CO_MEM_HBCONS,          /**< Heartbeat consumer object */
+    CO_MEM_HBCONS_NODES,    /**< Heartbeat consumer monitored nodes */
+    CO_MEM_EM,              /**< Emergency report object */
+    CO_MEM_EMPR,            /**< Emergency process object */
+    CO_MEM_SDO,             /**< SDO server objects */
+    CO_MEM_OD_EXT,          /**< Object dictionary extensions */
+    CO_MEM_SDO_CLIENT,      /**< SDO client objects */
+    CO_MEM_LSS,             /**< LSS slave or master object */
+    CO_MEM_DAISY,           /**< Daisychain object */
+    CO_MEM_TIME,            /**< TIME object */
+    CO_MEM_TRACE,           /**< Trace objects */
+    CO_MEM_TRACE_BUF,       /**< Trace time and value buffers */
+    CO_MEM_NO_GROUPS        /**< Number of groups */
+}CO_memoryGroup_t;
+
+
+/**
+ * Memory footprint of one group of objects, see CO_getMemoryInfo().
+ */
+typedef struct{
+    const char         *name;           /**< Name of the group */
+    uint16_t            count;          /**< Number of objects in the group */
+    uint32_t            size;           /**< Size of all objects in the group in bytes */
+}CO_memoryInfo_t;
+
+
 #if CO_NO_NMT_MASTER == 1
     /**
      * Function CO_sendNMTcommand() is simple function, which sends CANopen message.
@@ -176,6 +248,9 @@ typedef struct{
      *
      * This function also affects the own instance if nodeID is own ID or broadcast
      *
+     * For commands to groups of nodes and NMT state of the network see
+     * CO->NMTmaster, @ref CO_NMTmaster.
+     *
      * @param CO CANopen object.
      * @param command NMT command.
      * @param nodeID Node ID.
@@ -221,6 +296,47 @@ typedef struct{
 CO_ReturnError_t CO_new(void);
 
 
+/**
+ * Get memory footprint of the CANopen objects.
+ *
+ * Table is valid after CO_new(). Sizes are the same without CO_USE_GLOBALS
+ * (heap), with CO_USE_GLOBALS (static) and with CO_USE_ARENA, except for
+ * the alignment padding between groups in arena.
+ *
+ * @param [out] info Table with CO_MEM_NO_GROUPS entries, indexed by
+ * #CO_memoryGroup_t.
+ *
+ * @return Total size of all groups in bytes.
+ */
+uint32_t CO_getMemoryInfo(const CO_memoryInfo_t **info);
+
+
+#ifdef CO_USE_ARENA
+/**
+ * Set memory for CANopen objects (optional).
+ *
+ * With CO_USE_ARENA CO_new() places all CANopen objects into one block of
+ * memory instead of allocating each of them with calloc(). If this function is
+ * not called, the block is allocated with a single calloc().
+ *
+ * Function must be called before CO_new() and the buffer must stay valid
+ * until CO_delete().
+ *
+ * @param buffer Memory aligned to CO_ARENA_ALIGN or NULL for calloc().
+ * @param size Size of the buffer in bytes, at least CO_getArenaSize().
+ */
+void CO_setArena(void *buffer, uint32_t size);
+
+
+/**
+ * Get size of memory block required by CO_new() with CO_USE_ARENA.
+ *
+ * @return Size in bytes, including alignment padding.
+ */
+uint32_t CO_getArenaSize(void);
+#endif
+
+
 /**
  * Initialize CAN driver
  *
@@ -250,6 +366,20 @@ CO_ReturnError_t CO_LSSinit(
         uint16_t                bitRate);
 
 
+/**
+ * Initialize CANopen LSS slave of the CANopen instance, see CO_LSSinit().
+ *
+ * @param CO This object.
+ * @param nodeId Node ID of the CANopen device (1 ... 127) or CO_LSS_NODE_ID_ASSIGNMENT
+ * @param bitRate CAN bit rate.
+ * @return Same as CO_LSSinit().
+ */
+CO_ReturnError_t CO_LSSinitInstance(
+        CO_t                   *CO,
+        uint8_t                 nodeId,
+        uint16_t                bitRate);
+
+
 /**
  * Initialize CANopen stack.
  *
@@ -283,9 +413,144 @@ CO_ReturnError_t CO_init(
 #endif /* CO_NO_LSS_SERVER == 1 */
 
 
+#ifndef CO_USE_GLOBALS
+/**
+ * Allocate additional CANopen instance.
+ *
+ * Instance has its own CANopen objects and its own copy of the Object
+ * dictionary, initialized from CO_OD_RAM, CO_OD_EEPROM and CO_OD_ROM. This
+ * way several CANopen devices with the same Object dictionary layout may run
+ * on different CAN modules in one program. Global #CO is not changed, it
+ * points to the default instance from CO_new().
+ *
+ * Instance is initialized with CO_CANinitInstance(), CO_LSSinitInstance() and
+ * CO_CANopenInitInstance() and processed with the same functions as the
+ * default instance. Use CO_getODvariable() to access its Object dictionary
+ * variables.
+ *
+ * @param [out] pCO Pointer to the new CANopen object.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT,
+ * CO_ERROR_OUT_OF_MEMORY
+ */
+CO_ReturnError_t CO_newInstance(CO_t **pCO);
+
+
+/**
+ * Delete CANopen instance and free memory.
+ *
+ * Works for instances from CO_newInstance() and for the default instance
+ * (same as CO_delete()).
+ *
+ * @param CO This object.
+ * @param CANbaseAddress Address of the CAN module, passed to CO_CANmodule_init().
+ */
+void CO_deleteInstance(CO_t *CO, int32_t CANbaseAddress);
+
+
+/**
+ * Move RAM and EEPROM variables of the Object dictionary of an instance to
+ * memory provided by the application.
+ *
+ * Used for example to place them into a shared memory segment, where other
+ * processes read them directly (see CO_ODshm.h of the socketCAN driver).
+ * Current values are copied and the Object dictionary of the instance is
+ * redirected to the new memory, which is not freed by CO_deleteInstance().
+ * Function must be called before CO_CANopenInitInstance(), because CANopen
+ * objects keep pointers to Object dictionary variables.
+ *
+ * @param CO Instance from CO_newInstance(). The default instance uses global
+ * variables, which can't be moved.
+ * @param ODram Memory of sizeof(struct sCO_OD_RAM) bytes or NULL to keep it.
+ * @param ODeeprom Memory of sizeof(struct sCO_OD_EEPROM) bytes or NULL to keep it.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_setODmemory(CO_t *CO, void *ODram, void *ODeeprom);
+#endif
+
+
+/**
+ * Get Object dictionary variable of the CANopen instance.
+ *
+ * @param CO This object.
+ * @param variable Address of the variable inside CO_OD_RAM, CO_OD_EEPROM or
+ * CO_OD_ROM, for example &OD_producerHeartbeatTime.
+ *
+ * @return Address of the same variable in the Object dictionary of the
+ * instance. For the default instance and for addresses outside the Object
+ * dictionary structures this is the variable itself. NULL if CO is NULL.
+ */
+void *CO_getODvariable(CO_t *CO, const void *variable);
+
+
+/**
+ * Initialize CAN driver of the CANopen instance, see CO_CANinit().
+ *
+ * @param CO This object.
+ * @param CANbaseAddress Address of the CAN module, passed to CO_CANmodule_init().
+ * @param bitRate CAN bit rate.
+ * @return Same as CO_CANinit().
+ */
+CO_ReturnError_t CO_CANinitInstance(
+        CO_t                   *CO,
+        int32_t                 CANbaseAddress,
+        uint16_t                bitRate);
+
+
+/**
+ * Initialize CANopen stack of the CANopen instance, see CO_CANopenInit().
+ *
+ * @param CO This object.
+ * @param nodeId Node ID of the CANopen device (1 ... 127).
+ * @return Same as CO_CANopenInit().
+ */
+CO_ReturnError_t CO_CANopenInitInstance(
+        CO_t                   *CO,
+        uint8_t                 nodeId);
+
+
+/**
+ * Communication reset without new allocation of the CANopen instance.
+ *
+ * Alternative to CO_delete() followed by CO_new(), CO_CANinit() and
+ * CO_CANopenInit() for the NMT command Reset communication. CAN module,
+ * driver resources and Object dictionary stay as they are. All CANopen
+ * objects are initialized again from the communication parameters in the
+ * Object dictionary, so application must update them (from non-volatile
+ * memory for example) before the call. State of the objects from before
+ * is lost, also the configuration of the Object dictionary callbacks from
+ * CO_OD_configure(). CAN module is set to normal mode at the end.
+ *
+ * CANopen objects must not be processed during the call, also not
+ * from the CAN receive thread or interrupt.
+ *
+ * @param CO This object.
+ * @param nodeId Node ID of the CANopen device (1 ... 127).
+ * @return Same as CO_CANopenInit().
+ */
+CO_ReturnError_t CO_CANopenResetCommInstance(
+        CO_t                   *CO,
+        uint8_t                 nodeId);
+
+
+/**
+ * Communication reset of the default instance, see
+ * CO_CANopenResetCommInstance().
+ *
+ * @param nodeId Node ID of the CANopen device (1 ... 127).
+ * @return Same as CO_CANopenInit().
+ */
+CO_ReturnError_t CO_CANopenResetComm(
+        uint8_t                 nodeId);
+
+
 /**
  * Delete CANopen object and free memory. Must be called at program exit.
  *
+ * Deletes the default instance only, instances from CO_newInstance() are
+ * deleted with CO_deleteInstance().
+ *
  * @param CANbaseAddress Address of the CAN module, passed to CO_CANmodule_init().
  */
 void CO_delete(int32_t CANbaseAddress);
@@ -301,10 +566,13 @@ void CO_delete(int32_t CANbaseAddress);
  * @param timeDifference_ms Time difference from previous function call in [milliseconds].
  * @param timerNext_ms Return value - info to OS - maximum delay after function
  *        should be called next time in [milliseconds]. Value can be used for OS
- *        sleep time. Initial value must be set to something, 50ms typically.
- *        Output will be equal or lower to initial value. If there is new object
- *        to process, delay should be suspended and this function should be
- *        called immediately. Parameter is ignored if NULL.
+ *        sleep time. Initial value must be set to the longest sleep time of the
+ *        OS. Output will be equal or lower to initial value: each object with
+ *        a running timer (Heartbeat producer and consumer, EMCY inhibit time,
+ *        TIME, SDO server and NMT master) lowers it to its next deadline, the
+ *        status LEDs to the next 50 ms step (see #CO_NMT_NO_LEDS). If there is
+ *        new object to process, delay should be suspended and this function
+ *        should be called immediately. Parameter is ignored if NULL.
  *
  * @return #CO_NMT_reset_cmd_t from CO_NMT_process().
  */
@@ -373,6 +641,149 @@ CO_TPDO_t *CO_get_TPDO(
         CO_t                   *CO,
         uint16_t                tpdoComParIndex);
 
+
+/**
+ * Set send budget of event driven TPDOs.
+ *
+ * Budget is a token bucket for the whole node: each event driven TPDO
+ * (transmission type 254 or 255) takes one token, one token is added every
+ * _period_, up to _burst_ tokens. TPDO without a token stays pending and is
+ * sent in a later CO_process_TPDO() cycle. Inhibit and event timers of the
+ * TPDO keep running. Tokens are given to the TPDOs with lower CAN identifier
+ * first. Budget is kept over communication reset.
+ *
+ * @param CO This object.
+ * @param burst Size of the bucket, maximum number of TPDOs sent at once.
+ * 0 disables the budget (default).
+ * @param period Time for one token in multiples of 100 microseconds, like
+ * the inhibit time. 0 disables the budget.
+ */
+void CO_setTPDObudget(
+        CO_t                   *CO,
+        uint16_t                burst,
+        uint16_t                period);
+
+
+/**
+ * Function for accessing TPDO send budget from SDO server.
+ *
+ * It may be registered for a manufacturer specific record with two UNSIGNED16
+ * entries with CO_OD_configure(), object argument must be CO. Sub index 1 is
+ * _burst_ and sub index 2 is _period_ of CO_setTPDObudget(). Written value
+ * is applied immediately, application may store it in the Object dictionary
+ * variable and restore it with CO_setTPDObudget() after startup.
+ *
+ * For more information see file CO_SDO.h.
+ */
+CO_SDO_abortCode_t CO_ODF_TPDObudget(CO_ODF_arg_t *ODF_arg);
+
+
+#ifdef CO_USE_STATISTICS
+/**
+ * Get value of CAN message statistics, see CO_statistics.h.
+ *
+ * Sub indexes 1...15 contain message counters per service, summed over
+ * all objects of the service: NMT rx, NMT tx, SYNC rx, SYNC tx, EMCY tx,
+ * Heartbeat rx, Heartbeat tx, SDO server rx, SDO server tx, SDO client rx,
+ * SDO client tx, LSS rx, LSS tx, Daisychain rx and Daisychain tx. They are
+ * followed by three sub indexes for each RPDO (message counter, latency in
+ * microseconds, missed count) and then by the same three for each TPDO.
+ * Last three sub indexes contain the bus load in per mille over 10 ms, 100 ms
+ * and 1 s, see CO_statistics_busLoad(). Sub index 0 contains the number of
+ * the last sub index.
+ *
+ * @param CO This object.
+ * @param subIndex Sub index as described above.
+ * @param [out] value Value of the statistics.
+ *
+ * @return True, if sub index exists.
+ */
+bool_t CO_getStatistics(
+        CO_t                   *CO,
+        uint8_t                 subIndex,
+        uint32_t               *value);
+
+
+/**
+ * Set bus load limit for deferrable TPDOs.
+ *
+ * While the bus load over the last 100 ms is at or above the limit, event
+ * driven TPDOs marked with CO_TPDO_setDeferrable() are postponed. Limit is
+ * kept over communication reset.
+ *
+ * @param CO This object.
+ * @param limit Bus load in per mille, 0 disables the function (default).
+ */
+void CO_setTPDOloadLimit(CO_t *CO, uint16_t limit);
+
+
+/**
+ * Clear CAN message counters and PDO statistics.
+ *
+ * @param CO This object.
+ */
+void CO_resetStatistics(CO_t *CO);
+
+
+/**
+ * Function for accessing statistics from SDO server, see CO_getStatistics().
+ *
+ * It may be registered for a manufacturer specific record of UNSIGNED32
+ * values with CO_OD_configure(), object argument must be CO. Writing any
+ * sub index clears all statistics.
+ *
+ * For more information see file CO_SDO.h.
+ */
+CO_SDO_abortCode_t CO_ODF_statistics(CO_ODF_arg_t *ODF_arg);
+#endif
+
+#ifdef CO_LOCK_STATISTICS
+/**
+ * Function for accessing statistics of a critical section from SDO server.
+ *
+ * Driver must provide CO_lockStatistics_t. Function may be registered for a
+ * manufacturer specific record of UNSIGNED32 values with CO_OD_configure(),
+ * object argument must be the CO_lockStatistics_t, for example
+ * CO_OD_lockStat. Sub indexes:
+ *  - 1: Number of locks.
+ *  - 2: Number of locks, which had to wait for another task.
+ *  - 3: Number of locks held longer than limit in sub index 6.
+ *  - 4: Longest hold time.
+ *  - 5: Task handle, which caused longest hold time.
+ *  - 6: Hold time limit, 0 disables (writable).
+ *
+ * Writing sub index 1 to 5 clears the statistics.
+ *
+ * For more information see file CO_SDO.h.
+ */
+CO_SDO_abortCode_t CO_ODF_lockStatistics(CO_ODF_arg_t *ODF_arg);
+#endif
+
+#ifdef CO_DRIVER_ERROR_REPORTING
+/**
+ * Function for accessing bus off and no-ACK recovery statistics of a
+ * socketCAN interface from SDO server.
+ *
+ * Function may be registered for a manufacturer specific record of UNSIGNED32
+ * values with CO_OD_configure(), object argument must be the error handler of
+ * the interface, for example &CO->CANmodule[0]->CANinterfaces[0].errorhandler.
+ * Sub indexes:
+ *  - 1: Number of bus off events.
+ *  - 2: Number of listen-only periods because of missing ACK.
+ *  - 3: Number of retries after listen-only.
+ *  - 4: Number of recovered faults.
+ *  - 5: Time to recover of the last fault in ms.
+ *  - 6: Longest time to recover in ms.
+ *  - 7: Sum of all times to recover in ms.
+ *  - 8: Current listen-only time in ms (read only).
+ *
+ * Writing sub index 1 to 7 clears the statistics.
+ *
+ * For more information see file CO_SDO.h.
+ */
+CO_SDO_abortCode_t CO_ODF_CANerrorStatistics(CO_ODF_arg_t *ODF_arg);
+#endif
+
 #ifdef __cplusplus
 }
 #endif /*__cplusplus*/
@@ -33,6 +33,7 @@
 
 #include "CANopen.h"
 #include "CO_freertos_threads.h"
+#include "CO_latency.h"
 #include "CO_OD.h"
 
 #include "canopen.h"
@@ -54,7 +55,10 @@ const CLI_Command_Definition_t terminal =
 {
   .pcCommand = "canopen",
   .pcHelpString = "canopen -n x - address"  NEWLINE \
-                  "  -b x baudrate"  NEWLINE,
+                  "  -b x baudrate"  NEWLINE \
+                  "  -h 0 heartbeat consumer"  NEWLINE \
+                  "  -d 0 pdo configuration"  NEWLINE \
+                  "  -o x od range x..x|0xff"  NEWLINE,
   .pxCommandInterpreter = canopen_terminal,
   .cExpectedNumberOfParameters = 2
 };
@@ -153,15 +157,15 @@ CO_SDO_abortCode_t Canopen::store_parameters_callback(CO_ODF_arg_t *p_odf_arg)
 
   switch (p_odf_arg->subIndex) {
     case OD_1010_1_storeParameters_saveAllParameters:
-      result = storage.save(Canopen_storage::PARAMS);
+      result = storage.save(Canopen_storage::PARAMS, true);
       if (result != CO_ERROR_NO)  {
         return CO_SDO_AB_HW;
       }
-      result = storage.save(Canopen_storage::TEST);
+      result = storage.save(Canopen_storage::TEST, true);
       if (result != CO_ERROR_NO)  {
         return CO_SDO_AB_HW;
       }
-      result = storage.save(Canopen_storage::CALIB);
+      result = storage.save(Canopen_storage::CALIB, true);
       if (result != CO_ERROR_NO)  {
         return CO_SDO_AB_HW;
       }
@@ -191,7 +195,7 @@ CO_SDO_abortCode_t Canopen::store_parameters_callback(CO_ODF_arg_t *p_odf_arg)
       return CO_SDO_AB_SUB_UNKNOWN;
   }
 
-  result = storage.save(type);
+  result = storage.save(type, true);
   if (result != CO_ERROR_NO)  {
     return CO_SDO_AB_HW;
   }
@@ -455,7 +459,7 @@ CO_SDO_abortCode_t Canopen::can_runtime_info_callback(CO_ODF_arg_t *p_odf_arg)
   can_info_t rti;
   can_state_t state;
 
-  state = can_ioctl(CO->CANmodule[0]->driver, CAN_GET_INFO, &rti);
+  state = can_ioctl(p_co->CANmodule[0]->driver, CAN_GET_INFO, &rti);
   if (state != CAN_OK) {
     return CO_SDO_AB_GENERAL;
   }
@@ -655,6 +659,102 @@ CO_SDO_abortCode_t Canopen::generic_write_callback(CO_ODF_arg_t* p_odf_arg)
   return CO_SDO_AB_NONE;
 }
 
+/**
+ * Sammelt bei Schreibzugriff auf einen OD Eintrag den Subindex und schreibt
+ * ein Wakeup auf die per <od_event()> vorgegebene Queue, falls noch keines
+ * aussteht
+ *
+ * @param p_odf_arg OD Eintrag
+ * @return CO_SDO_AB_NONE
+ */
+CO_SDO_abortCode_t Canopen::batch_write_callback(CO_ODF_arg_t* p_odf_arg)
+{
+  od_event_batch_t *p_batch;
+  od_event_t event;
+
+  if (p_odf_arg->reading == true) {
+    return CO_SDO_AB_NONE;
+  }
+
+  /* Wird teilweise ohne OD Sperre aufgerufen (<od_commit()>), daher atomar */
+  p_batch = reinterpret_cast<od_event_batch_t*>(p_odf_arg->object);
+  (void)__atomic_fetch_or(&p_batch->changed[p_odf_arg->subIndex / 32],
+                          1UL << (p_odf_arg->subIndex % 32), __ATOMIC_SEQ_CST);
+  if (__atomic_exchange_n(&p_batch->pending, true, __ATOMIC_SEQ_CST) == false) {
+    event.index = p_batch->index;
+    event.subindex = 0;
+    if (xQueueSend(p_batch->event_queue, &event, 0) != pdTRUE) {
+      /* n"achster Schreibzugriff versucht es erneut */
+      p_batch->pending = false;
+    }
+  }
+
+  return CO_SDO_AB_NONE;
+}
+
+/**
+ * SDO Zugriff auf eine per <od_domain_register()> registrierte Domain
+ *
+ * Download schreibt die Segmente direkt in den Speicher der Anwendung, die
+ * L"ange ist bis zum letzten Segment 0. Upload liest direkt aus dem Speicher,
+ * mit CO_SDO_STREAM_UPLOAD ohne Kopie in den SDO Puffer.
+ *
+ * @param p_odf_arg OD Eintrag, object ist der od_domain_t Eintrag
+ * @return CO_SDO_AB_NONE wenn erfolgreich
+ */
+CO_SDO_abortCode_t Canopen::domain_callback(CO_ODF_arg_t* p_odf_arg)
+{
+  od_domain_t *p_domain;
+  u32 count;
+
+  p_domain = reinterpret_cast<od_domain_t*>(p_odf_arg->object);
+  if (p_domain->p_buffer == nullptr) {
+    return CO_SDO_AB_NO_DATA;
+  }
+
+  if (p_odf_arg->reading == false) {
+    if (p_odf_arg->firstSegment == true) {
+      p_domain->length = 0;
+      if (p_odf_arg->dataLengthTotal > p_domain->size) {
+        return CO_SDO_AB_DATA_LONG;
+      }
+    }
+    if ((p_odf_arg->offset + p_odf_arg->dataLength) > p_domain->size) {
+      return CO_SDO_AB_DATA_LONG;
+    }
+    memcpy(&p_domain->p_buffer[p_odf_arg->offset], p_odf_arg->data, p_odf_arg->dataLength);
+    if (p_odf_arg->lastSegment == true) {
+      p_domain->length = p_odf_arg->offset + p_odf_arg->dataLength;
+    }
+    return CO_SDO_AB_NONE;
+  }
+
+  if (p_domain->length == 0) {
+    return CO_SDO_AB_NO_DATA;
+  }
+#ifdef CO_SDO_STREAM_UPLOAD
+  p_domain->scatter.data = p_domain->p_buffer;
+  p_domain->scatter.length = p_domain->length;
+  p_odf_arg->scatter = &p_domain->scatter;
+  p_odf_arg->scatterCount = 1;
+  p_odf_arg->dataLengthTotal = p_domain->length;
+#else
+  if (p_odf_arg->firstSegment == true) {
+    p_odf_arg->dataLengthTotal = p_domain->length;
+  }
+  count = p_domain->length - p_odf_arg->offset;
+  if (count > p_odf_arg->dataLength) {
+    count = p_odf_arg->dataLength;
+  }
+  memcpy(p_odf_arg->data, &p_domain->p_buffer[p_odf_arg->offset], count);
+  p_odf_arg->dataLength = count;
+  p_odf_arg->lastSegment = ((p_odf_arg->offset + count) >= p_domain->length);
+#endif
+  (void)count;
+
+  return CO_SDO_AB_NONE;
+}
+
 /**
  * Tr"agt Callback Funktion in Stack ein
  *
@@ -664,7 +764,7 @@ CO_SDO_abortCode_t Canopen::generic_write_callback(CO_ODF_arg_t* p_odf_arg)
 void Canopen::set_callback(u16 obj_dict_id,
                            CO_SDO_abortCode_t (*pODFunc)(CO_ODF_arg_t *ODF_arg))
 {
-  CO_OD_configure(CO->SDO[0], obj_dict_id, pODFunc, this, NULL, 0);
+  CO_OD_configure(p_co->SDO[0], obj_dict_id, pODFunc, this, NULL, 0);
 }
 
 /**
@@ -680,18 +780,87 @@ void* Canopen::get_od_pointer(u16 index, u8 subindex, size_t size)
   u16 entry;
   u8 length;
 
-  entry = CO_OD_find(CO->SDO[0], index);
+  entry = CO_OD_find(p_co->SDO[0], index);
   if (entry == 0xffff) {
     /* Existiert nicht */
     return NULL;
   }
 
-  length = CO_OD_getLength(CO->SDO[0], entry, subindex);
+  length = CO_OD_getLength(p_co->SDO[0], entry, subindex);
   if (length != size) {
     return NULL;
   }
 
-  return CO_OD_getDataPointer(CO->SDO[0], entry, subindex);
+  CO_OD_PROFILE_COUNT(p_co->SDO[0], entry, CO_OD_PROF_APP);
+  return CO_OD_getDataPointer(p_co->SDO[0], entry, subindex);
+}
+
+/**
+ * OD Eintrag als geschrieben markieren
+ *
+ * Setzt das Flag f"ur die COS Erkennung der TPDOs (TPDO_COS_DIRTY_FLAGS).
+ * Ohne per CO_OD_configure() hinterlegte Flags passiert nichts.
+ *
+ * @param index OD Index (z.B. aus CO_OD.h)
+ * @param subindex OD Subindex (z.B. aus CO_OD.h)
+ */
+void Canopen::mark_od_written(u16 index, u8 subindex)
+{
+  u16 entry;
+  u8 *p_flags;
+
+  entry = CO_OD_find(p_co->SDO[0], index);
+  p_flags = CO_OD_getFlagsPointer(p_co->SDO[0], entry, subindex);
+  if (p_flags != NULL) {
+    *p_flags |= CO_ODFL_TPDO_COS_DIRTY;
+  }
+}
+
+/**
+ * Ansicht auf OD Eintrag mit Speicher im OD bestimmen
+ *
+ * @param index OD Index (z.B. aus CO_OD.h)
+ * @param subindex OD Subindex (z.B. aus CO_OD.h)
+ * @return Ansicht auf den ganzen Eintrag, ung"ultig falls nicht existent
+ * oder Domain
+ */
+od_span<u8> Canopen::get_od_span(u16 index, u8 subindex)
+{
+  u16 entry;
+  u8 *p;
+
+  entry = CO_OD_find(p_co->SDO[0], index);
+  if (entry == 0xffff) {
+    /* Existiert nicht */
+    return od_span<u8>();
+  }
+
+  p = (u8*)CO_OD_getDataPointer(p_co->SDO[0], entry, subindex);
+  if (p == NULL) {
+    /* Domain, Daten nur per <od_domain_register()> */
+    return od_span<u8>();
+  }
+
+  CO_OD_PROFILE_COUNT(p_co->SDO[0], entry, CO_OD_PROF_APP);
+  return od_span<u8>(p, CO_OD_getLength(p_co->SDO[0], entry, subindex));
+}
+
+/**
+ * Registrierte Domain suchen
+ *
+ * @param index OD Index
+ * @return Eintrag oder nullptr
+ */
+Canopen::od_domain_t *Canopen::get_od_domain(u16 index)
+{
+  u8 i;
+
+  for (i = 0; i < od_domain_max; i++) {
+    if ((od_domain[i].index == index) && (od_domain[i].p_buffer != nullptr)) {
+      return &od_domain[i];
+    }
+  }
+  return nullptr;
 }
 
 /**
@@ -709,7 +878,7 @@ void Canopen::daisychain_event_callback(void)
   shift_count = OD_daisyChain.shiftIn;
   CO_UNLOCK_OD();
 
-  (void)CO_DaisyProducer_sendEvent(CO->DaisyProducer, shift_count, nid);
+  (void)CO_DaisyProducer_sendEvent(p_co->DaisyProducer, shift_count, nid);
 }
 
 /**
@@ -755,9 +924,39 @@ bool Canopen::store_lss_config_callback(uint8_t nid, uint16_t bit_rate)
  */
 void Canopen::rpdo_callback(const CO_RPDO_t *rpdo, const CO_CANrxMsg_t *message)
 {
-  if (p_rpdo != nullptr) {
-    p_rpdo(p_rpdo_param, message->data, message->DLC);
+  u8 i;
+
+  /* Tabelle wird unter dem OD Lock ge"andert, siehe #rpdo_register() */
+  CO_LOCK_OD();
+  for (i = 0; i < pdo_manual_max; i++) {
+    rpdo_manual_t *p_entry = &rpdo_manual[i];
+
+    if (p_entry->p_pdo == rpdo) {
+      if (p_entry->p_ring != nullptr) {
+        u16 head = p_entry->head;
+        u16 next = (head + 1) % p_entry->ring_size;
+        rpdo_frame_t *p_frame = &p_entry->p_ring[head];
+
+        if (next == p_entry->tail) {
+          p_entry->overflow ++;
+          break;
+        }
+        p_frame->timestamp = xTaskGetTickCount();
+        /* DLC kommt vom Bus, auf die Puffergr"o"se begrenzen */
+        p_frame->count = (message->DLC < sizeof(p_frame->data)) ? message->DLC : sizeof(p_frame->data);
+        memcpy(p_frame->data, message->data, p_frame->count);
+        /* Daten m"ussen vor dem Index sichtbar sein */
+        __sync_synchronize();
+        p_entry->head = next;
+        (void)xSemaphoreGive(p_entry->sem);
+      }
+      else {
+        p_entry->p(p_entry->param, message->data, message->DLC);
+      }
+      break;
+    }
   }
+  CO_UNLOCK_OD();
 }
 #else
 void Canopen::rpdo_callback(const CO_RPDO_t *rpdo, const CO_CANrxMsg_t *message)
@@ -800,7 +999,7 @@ void Canopen::timer_rx_thread(void)
 void Canopen::nmt_register(QueueHandle_t event_queue)
 {
   Canopen::nmt_event_queue = event_queue;
-  CO_NMT_initCallback(CO->NMT, &nmt_state_callback);
+  CO_NMT_initCallback(p_co->NMT, &nmt_state_callback);
 }
 
 void Canopen::nmt_relay_event(nmt_event_t event)
@@ -955,18 +1154,19 @@ void Canopen::od_get(u16 index, u8 subindex, const char** pp_visible_string)
   u16 entry;
   char *p;
 
-  entry = CO_OD_find(CO->SDO[0], index);
+  entry = CO_OD_find(p_co->SDO[0], index);
   if (entry == 0xffff) {
     /* Existiert nicht */
     *pp_visible_string = NULL;
     return;
   }
 
-  p = (char*)CO_OD_getDataPointer(CO->SDO[0], entry, subindex);
+  p = (char*)CO_OD_getDataPointer(p_co->SDO[0], entry, subindex);
   if (p == NULL) {
     *pp_visible_string = NULL;
     return;
   }
+  CO_OD_PROFILE_COUNT(p_co->SDO[0], entry, CO_OD_PROF_APP);
   *pp_visible_string = p;
 }
 
@@ -979,6 +1179,7 @@ void Canopen::od_set(u16 index, u8 subindex, bool val)
     return;
   }
   *p = (val == true) ? 1 : 0;
+  mark_od_written(index, subindex);
 }
 
 void Canopen::od_set(u16 index, u8 subindex, u8 val)
@@ -990,6 +1191,7 @@ void Canopen::od_set(u16 index, u8 subindex, u8 val)
     return;
   }
   *p = val;
+  mark_od_written(index, subindex);
 }
 
 void Canopen::od_set(u16 index, u8 subindex, u16 val)
@@ -1001,6 +1203,7 @@ void Canopen::od_set(u16 index, u8 subindex, u16 val)
     return;
   }
   *p = val;
+  mark_od_written(index, subindex);
 }
 
 void Canopen::od_set(u16 index, u8 subindex, u32 val)
@@ -1012,6 +1215,7 @@ void Canopen::od_set(u16 index, u8 subindex, u32 val)
     return;
   }
   *p = val;
+  mark_od_written(index, subindex);
 }
 
 void Canopen::od_set(u16 index, u8 subindex, u64 val)
@@ -1023,6 +1227,7 @@ void Canopen::od_set(u16 index, u8 subindex, u64 val)
     return;
   }
   *p = val;
+  mark_od_written(index, subindex);
 }
 
 void Canopen::od_set(u16 index, u8 subindex, s8 val)
@@ -1034,6 +1239,7 @@ void Canopen::od_set(u16 index, u8 subindex, s8 val)
     return;
   }
   *p = val;
+  mark_od_written(index, subindex);
 }
 
 void Canopen::od_set(u16 index, u8 subindex, s16 val)
@@ -1045,6 +1251,7 @@ void Canopen::od_set(u16 index, u8 subindex, s16 val)
     return;
   }
   *p = val;
+  mark_od_written(index, subindex);
 }
 
 void Canopen::od_set(u16 index, u8 subindex, s32 val)
@@ -1056,6 +1263,7 @@ void Canopen::od_set(u16 index, u8 subindex, s32 val)
     return;
   }
   *p = val;
+  mark_od_written(index, subindex);
 }
 
 void Canopen::od_set(u16 index, u8 subindex, s64 val)
@@ -1067,6 +1275,7 @@ void Canopen::od_set(u16 index, u8 subindex, s64 val)
     return;
   }
   *p = val;
+  mark_od_written(index, subindex);
 }
 
 void Canopen::od_set(u16 index, u8 subindex, f32 val)
@@ -1078,6 +1287,7 @@ void Canopen::od_set(u16 index, u8 subindex, f32 val)
     return;
   }
   *p = val;
+  mark_od_written(index, subindex);
 }
 
 void Canopen::od_set(u16 index, u8 subindex, const char* p_visible_string)
@@ -1086,33 +1296,291 @@ void Canopen::od_set(u16 index, u8 subindex, const char* p_visible_string)
   u16 length;
   char *p;
 
-  entry = CO_OD_find(CO->SDO[0], index);
+  entry = CO_OD_find(p_co->SDO[0], index);
   if (entry == 0xffff) {
     /* Existiert nicht */
     return;
   }
 
-  length = CO_OD_getLength(CO->SDO[0], entry, subindex);
+  length = CO_OD_getLength(p_co->SDO[0], entry, subindex);
   if (length == 0) {
     return;
   }
 
-  p = (char*)CO_OD_getDataPointer(CO->SDO[0], entry, subindex);
+  p = (char*)CO_OD_getDataPointer(p_co->SDO[0], entry, subindex);
   if (p == NULL) {
     return;
   }
+  CO_OD_PROFILE_COUNT(p_co->SDO[0], entry, CO_OD_PROF_APP);
 
   /* Der Quellstring muss entweder ein echter, nullterminierter String sein
    * oder die gleiche Länge haben wie der OD Eintrag. */
   (void)snprintf(p, length, p_visible_string);
+  mark_od_written(index, subindex);
+}
+
+CO_ReturnError_t Canopen::od_domain_register(u16 index, u8 *p_buffer, u32 size, u32 length)
+{
+  od_domain_t *p_domain = nullptr;
+  u8 i;
+
+  if ((index == 0) || (length > size)) {
+    return CO_ERROR_ILLEGAL_ARGUMENT;
+  }
+
+  CO_LOCK_OD();
+  for (i = 0; i < od_domain_max; i++) {
+    if (od_domain[i].index == index) {
+      p_domain = &od_domain[i];
+      break;
+    }
+    if ((p_domain == nullptr) && (od_domain[i].index == 0)) {
+      p_domain = &od_domain[i];
+    }
+  }
+  if (p_buffer == nullptr) {
+    /* Freigeben, laufender SDO Transfer bekommt CO_SDO_AB_NO_DATA, der
+     * Eintrag ist danach wieder frei */
+    if ((p_domain == nullptr) || (p_domain->index != index)) {
+      CO_UNLOCK_OD();
+      return CO_ERROR_NO;
+    }
+    p_domain->index = 0;
+    p_domain->p_buffer = nullptr;
+    p_domain->size = 0;
+    p_domain->length = 0;
+    CO_UNLOCK_OD();
+
+    if (p_co != nullptr) {
+      CO_OD_configure(p_co->SDO[0], index, nullptr, nullptr, NULL, 0);
+    }
+    return CO_ERROR_NO;
+  }
+  if (p_domain == nullptr) {
+    CO_UNLOCK_OD();
+    return CO_ERROR_OUT_OF_MEMORY;
+  }
+  p_domain->index = index;
+  p_domain->p_buffer = p_buffer;
+  p_domain->size = size;
+  p_domain->length = length;
+  CO_UNLOCK_OD();
+
+  /* Nach RESET_COMMUNICATION erneut in <co_start()> */
+  if (p_co != nullptr) {
+    CO_OD_configure(p_co->SDO[0], index, domain_callback, p_domain, NULL, 0);
+  }
+  return CO_ERROR_NO;
+}
+
+od_span<const char> Canopen::od_guard::visible_string(u16 index, u8 subindex)
+{
+  od_span<u8> span = co.get_od_span(index, subindex);
+  const char *p = reinterpret_cast<const char*>(span.data());
+
+  if (span.valid() == false) {
+    return od_span<const char>();
+  }
+  /* Visible String muss nicht nullterminiert sein */
+  return od_span<const char>(p, strnlen(p, span.size()));
+}
+
+od_span<const u8> Canopen::od_guard::octet_string(u16 index, u8 subindex)
+{
+  od_span<u8> span = co.get_od_span(index, subindex);
+
+  return od_span<const u8>(span.data(), span.size());
+}
+
+od_span<u8> Canopen::od_guard::octet_string_write(u16 index, u8 subindex)
+{
+  od_span<u8> span = co.get_od_span(index, subindex);
+
+  if (span.valid() == true) {
+    /* COS wird erst nach Freigabe der Sperre ausgewertet */
+    co.mark_od_written(index, subindex);
+  }
+  return span;
+}
+
+od_span<const u8> Canopen::od_guard::domain(u16 index)
+{
+  od_domain_t *p_domain = co.get_od_domain(index);
+
+  if (p_domain == nullptr) {
+    return od_span<const u8>();
+  }
+  return od_span<const u8>(p_domain->p_buffer, p_domain->length);
 }
 
+od_span<u8> Canopen::od_guard::domain_write(u16 index)
+{
+  od_domain_t *p_domain = co.get_od_domain(index);
+
+  if (p_domain == nullptr) {
+    return od_span<u8>();
+  }
+  return od_span<u8>(p_domain->p_buffer, p_domain->size);
+}
+
+bool Canopen::od_guard::domain_commit(u16 index, u32 length)
+{
+  od_domain_t *p_domain = co.get_od_domain(index);
+
+  if ((p_domain == nullptr) || (length > p_domain->size)) {
+    return false;
+  }
+  p_domain->length = length;
+  return true;
+}
+
+/**
+ * Einen Eintrag aus CANOPEN_OD_VARIABLES pr"ufen und Position in CO_OD ablegen
+ */
+#define CANOPEN_OD_VERIFY(name, idx, sub, variable)                          \
+  entry = CO_OD_find(p_co->SDO[0], od::name::index);                           \
+  od::name::entry() = entry;                                                 \
+  if ((entry == 0xffff) ||                                                   \
+      (CO_OD_getLength(p_co->SDO[0], entry, od::name::subindex) !=             \
+       sizeof(od::name::type_t)) ||                                          \
+      (CO_OD_getDataPointer(p_co->SDO[0], entry, od::name::subindex) !=        \
+       od::name::data())) {                                                  \
+    result = false;                                                          \
+  }
+
+bool Canopen::od_verify(void)
+{
+  u16 entry;
+  bool result = true;
+
+  CANOPEN_OD_VARIABLES(CANOPEN_OD_VERIFY)
+  return result;
+}
+
+#undef CANOPEN_OD_VERIFY
+
 void Canopen::od_event(u16 index, QueueHandle_t event_queue)
 {
-  CO_OD_configure(CO->SDO[0], index, generic_write_callback,
+  CO_OD_configure(p_co->SDO[0], index, generic_write_callback,
                   reinterpret_cast<void*>(event_queue), NULL, 0);
 }
 
+void Canopen::od_event(u16 index, od_event_batch_t *p_batch, QueueHandle_t event_queue)
+{
+  memset(p_batch, 0, sizeof(*p_batch));
+  p_batch->index = index;
+  p_batch->event_queue = event_queue;
+  CO_OD_configure(p_co->SDO[0], index, batch_write_callback,
+                  reinterpret_cast<void*>(p_batch), NULL, 0);
+}
+
+u16 Canopen::od_event_fetch(od_event_batch_t *p_batch, u32 *p_changed)
+{
+  u8 i;
+  u16 count = 0;
+
+  /* zuerst pending l"oschen, eine "Anderung w"ahrend des Abholens l"ost
+   * dann ein weiteres Wakeup aus und geht nicht verloren */
+  __atomic_store_n(&p_batch->pending, false, __ATOMIC_SEQ_CST);
+  for (i = 0; i < 256 / 32; i++) {
+    p_changed[i] = __atomic_exchange_n(&p_batch->changed[i], 0, __ATOMIC_SEQ_CST);
+    count += __builtin_popcountl(p_changed[i]);
+  }
+  return count;
+}
+
+u16 Canopen::od_snapshot(const od_bulk_t *p_list, u16 count)
+{
+  u16 i;
+  u16 copied;
+  void *p;
+  u32 seq;
+  bool locked = false;
+
+  seq = CO_OD_readBegin();
+  while (true) {
+    copied = 0;
+    for (i = 0; i < count; i++) {
+      p = get_od_pointer(p_list[i].index, p_list[i].subindex, p_list[i].size);
+      if (p == NULL) {
+        memset(p_list[i].p_data, 0, p_list[i].size);
+        continue;
+      }
+      memcpy(p_list[i].p_data, p, p_list[i].size);
+      copied ++;
+    }
+    if (locked == true) {
+      CO_UNLOCK_OD();
+      break;
+    }
+    if (CO_OD_readValid(seq) == true) {
+      break;
+    }
+    /* OD wurde w"ahrend des Kopierens geschrieben, unter Sperre wiederholen */
+    CO_LOCK_OD();
+    locked = true;
+  }
+
+  return copied;
+}
+
+u16 Canopen::od_commit(const od_bulk_t *p_list, u16 count)
+{
+  u16 i;
+  u16 j;
+  u16 entry;
+  u16 written = 0;
+  void *p;
+  CO_SDO_t *p_sdo = p_co->SDO[0];
+  CO_OD_extension_t *p_ext;
+  CO_ODF_arg_t odf_arg;
+
+  CO_LOCK_OD();
+  for (i = 0; i < count; i++) {
+    p = get_od_pointer(p_list[i].index, p_list[i].subindex, p_list[i].size);
+    if (p == NULL) {
+      continue;
+    }
+    memcpy(p, p_list[i].p_data, p_list[i].size);
+    mark_od_written(p_list[i].index, p_list[i].subindex);
+    written ++;
+  }
+  CO_UNLOCK_OD();
+
+  /* Events erst nach dem Schreiben aller Werte ausl"osen, damit der
+   * Empf"anger einen konsistenten Stand vorfindet. Mehrfach in der Liste
+   * enthaltene Eintr"age werden nur einmal gemeldet. */
+  memset(&odf_arg, 0, sizeof(odf_arg));
+  odf_arg.reading = false;
+  for (i = 0; i < count; i++) {
+    for (j = 0; j < i; j++) {
+      if ((p_list[j].index == p_list[i].index) &&
+          (p_list[j].subindex == p_list[i].subindex)) {
+        break;
+      }
+    }
+    if (j != i) {
+      continue;
+    }
+
+    entry = CO_OD_find(p_sdo, p_list[i].index);
+    if (entry == 0xffff) {
+      continue;
+    }
+    p_ext = CO_OD_getExtension(p_sdo, entry);
+    if (p_ext == NULL || (p_ext->pODFunc != generic_write_callback &&
+                          p_ext->pODFunc != batch_write_callback)) {
+      continue;
+    }
+    odf_arg.index = p_list[i].index;
+    odf_arg.subIndex = p_list[i].subindex;
+    odf_arg.object = p_ext->object;
+    (void)p_ext->pODFunc(&odf_arg);
+  }
+
+  return written;
+}
+
 /** @}*/
 
 /**
@@ -1121,7 +1589,7 @@ void Canopen::od_event(u16 index, QueueHandle_t event_queue)
 
 bool Canopen::error_get(errorcode_t error)
 {
-  return CO_isError(CO->em, error);
+  return CO_isError(p_co->em, error);
 }
 
 void Canopen::error_set(errorcode_t error, u32 detail)
@@ -1167,7 +1635,7 @@ void Canopen::error_set(errorcode_t error, u32 detail)
       break;
   }
 
-  CO_errorReport(CO->em, error, co_emergency,
+  CO_errorReport(p_co->em, error, co_emergency,
                  detail);
 }
 
@@ -1178,7 +1646,7 @@ void Canopen::error_reset(errorcode_t error, u32 detail)
     return;
   }
 
-  CO_errorReset(CO->em, error, detail);
+  CO_errorReset(p_co->em, error, detail);
 }
 
 /** @}*/
@@ -1190,102 +1658,479 @@ void Canopen::error_reset(errorcode_t error, u32 detail)
 
 CO_ReturnError_t Canopen::tpdo_take_control(u16 tpdo_com_param_index)
 {
+  CO_TPDO_t *p_pdo;
   CO_ReturnError_t result;
+  u8 i;
+  u8 free = pdo_manual_max;
 
-  if (p_tpdo != nullptr) {
-    return CO_ERROR_OUT_OF_MEMORY; //nur 1 Eintrag m"oglich
-  }
-  p_tpdo = CO_get_TPDO(CO, tpdo_com_param_index);
-  if (p_tpdo == nullptr) {
+  p_pdo = CO_get_TPDO(p_co, tpdo_com_param_index);
+  if (p_pdo == nullptr) {
     return CO_ERROR_PARAMETERS;
   }
-  result = CO_TPDO_takeManualControl(reinterpret_cast<CO_TPDO_t*>(p_tpdo), true);
+  CO_LOCK_OD();
+  for (i = 0; i < pdo_manual_max; i++) {
+    if (tpdo_manual[i].p_pdo == p_pdo) {
+      CO_UNLOCK_OD();
+      return CO_ERROR_PARAMETERS; //bereits registriert
+    }
+    if ((tpdo_manual[i].p_pdo == nullptr) && (free == pdo_manual_max)) {
+      free = i;
+    }
+  }
+  if (free == pdo_manual_max) {
+    CO_UNLOCK_OD();
+    return CO_ERROR_OUT_OF_MEMORY;
+  }
+
+  result = CO_TPDO_takeManualControl(p_pdo, true);
+  if (result == CO_ERROR_NO) {
+    tpdo_manual[free].called = xTaskGetTickCount();
+    tpdo_manual[free].p_pdo = p_pdo;
+  }
+  CO_UNLOCK_OD();
   return result;
 }
 
 void Canopen::tpdo_release_control(u16 id)
 {
-  (void)CO_TPDO_takeManualControl(reinterpret_cast<CO_TPDO_t*>(p_tpdo), false);
-  p_tpdo = nullptr;
+  u8 i;
+
+  CO_LOCK_OD();
+  for (i = 0; i < pdo_manual_max; i++) {
+    CO_TPDO_t *p_pdo = tpdo_manual[i].p_pdo;
+
+    if ((p_pdo != nullptr) && (p_pdo->idx_TPDOCommPar == id)) {
+      (void)CO_TPDO_takeManualControl(p_pdo, false);
+      tpdo_manual[i].p_pdo = nullptr;
+      break;
+    }
+  }
+  CO_UNLOCK_OD();
 }
 
 CO_ReturnError_t Canopen::tpdo_send(u16 id)
 {
   TickType_t now;
   TickType_t difference_us;
+  u8 i;
+
+  for (i = 0; i < pdo_manual_max; i++) {
+    CO_TPDO_t *p_pdo = tpdo_manual[i].p_pdo;
 
-  if (p_tpdo == nullptr) {
+    if ((p_pdo != nullptr) && (p_pdo->idx_TPDOCommPar == id)) {
+      now = xTaskGetTickCount();
+      difference_us = (now - tpdo_manual[i].called) * 1000;
+      tpdo_manual[i].called = now;
+
+      p_pdo->sendRequest = true;
+      return CO_TPDO_process(p_pdo, nullptr, false, difference_us); //nicht zyklisch -> kein Heartbeat!!
+    }
+  }
+  return CO_ERROR_PARAMETERS;
+}
+
+CO_ReturnError_t Canopen::tpdo_send(u16 id, const u8 *p_data, u8 count)
+{
+  u8 i;
+
+  if (p_data == nullptr) {
     return CO_ERROR_PARAMETERS;
   }
-  now = xTaskGetTickCount();
-  difference_us = (now - tpdo_called) * 1000;
-  tpdo_called = now;
+  for (i = 0; i < pdo_manual_max; i++) {
+    CO_TPDO_t *p_pdo = tpdo_manual[i].p_pdo;
 
-  reinterpret_cast<CO_TPDO_t*>(p_tpdo)->sendRequest = true;
-  return CO_TPDO_process(reinterpret_cast<CO_TPDO_t*>(p_tpdo), nullptr, false, difference_us); //nicht zyklisch -> kein Heartbeat!!
+    if ((p_pdo != nullptr) && (p_pdo->idx_TPDOCommPar == id)) {
+      if (!p_pdo->valid || (*p_pdo->operatingState != CO_NMT_OPERATIONAL)) {
+        return CO_ERROR_WRONG_NMT_STATE;
+      }
+      if (count != p_pdo->dataLength) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+      }
+      /* Sendepuffer geh"ort exklusiv diesem TPDO, CO_TPDO_process() wird
+       * f"ur manuelle TPDOs nicht aufgerufen */
+      memcpy(p_pdo->CANtxBuff->data, p_data, count);
+      return CO_CANsend(p_pdo->CANdevTx, p_pdo->CANtxBuff);
+    }
+  }
+  return CO_ERROR_PARAMETERS;
 }
 
-CO_ReturnError_t Canopen::rpdo_take_control(u16 rpdo_com_param_index, void *param,
-    void (*p)(void *param, const u8* p_data, u8 count))
+CO_ReturnError_t Canopen::rpdo_register(u16 rpdo_com_param_index, void *param,
+    void (*p)(void *param, const u8* p_data, u8 count),
+    rpdo_frame_t *p_ring, u16 ring_size)
 {
   CO_RPDO_t *p_pdo;
   CO_ReturnError_t result;
+  u8 i;
+  u8 free = pdo_manual_max;
 
-  if (p == nullptr) {
+  p_pdo = CO_get_RPDO(p_co, rpdo_com_param_index);
+  if (p_pdo == nullptr) {
     return CO_ERROR_PARAMETERS;
   }
-  if (p_rpdo != nullptr) {
-    return CO_ERROR_OUT_OF_MEMORY; //nur 1 Eintrag m"oglich
+  /* #rpdo_callback() l"auft im RX Thread und liest die Tabelle unter dem
+   * OD Lock */
+  CO_LOCK_OD();
+  for (i = 0; i < pdo_manual_max; i++) {
+    if (rpdo_manual[i].p_pdo == p_pdo) {
+      CO_UNLOCK_OD();
+      return CO_ERROR_PARAMETERS; //bereits registriert
+    }
+    if ((rpdo_manual[i].p_pdo == nullptr) && (free == pdo_manual_max)) {
+      free = i;
+    }
   }
-
-  p_pdo = CO_get_RPDO(CO, rpdo_com_param_index);
-  if (p_pdo == nullptr) {
-    return CO_ERROR_PARAMETERS;
+  if (free == pdo_manual_max) {
+    CO_UNLOCK_OD();
+    return CO_ERROR_OUT_OF_MEMORY;
   }
-  p_rpdo = p;
-  p_rpdo_param = param;
+  if ((p_ring != nullptr) && (rpdo_manual[free].sem == nullptr)) {
+    /* Semaphore bleibt dem Eintrag erhalten */
+    rpdo_manual[free].sem = xSemaphoreCreateBinary();
+    if (rpdo_manual[free].sem == nullptr) {
+      CO_UNLOCK_OD();
+      return CO_ERROR_OUT_OF_MEMORY;
+    }
+  }
+
+  rpdo_manual[free].p = p;
+  rpdo_manual[free].param = param;
+  rpdo_manual[free].p_ring = p_ring;
+  rpdo_manual[free].ring_size = ring_size;
+  rpdo_manual[free].head = 0;
+  rpdo_manual[free].tail = 0;
+  rpdo_manual[free].overflow = 0;
+  rpdo_manual[free].p_pdo = p_pdo;
   result = CO_RPDO_takeManualControl(p_pdo, true, this, rpdo_callback_wrapper);
+  if (result != CO_ERROR_NO) {
+    rpdo_manual[free].p_pdo = nullptr;
+  }
+  CO_UNLOCK_OD();
   return result;
 }
 
-void Canopen::rpdo_release_control(u16 id)
+CO_ReturnError_t Canopen::rpdo_take_control(u16 rpdo_com_param_index, void *param,
+    void (*p)(void *param, const u8* p_data, u8 count))
 {
-  CO_RPDO_t *p_pdo;
-
-  if (p_rpdo == nullptr) {
-    return;
-  }
-  p_pdo = CO_get_RPDO(CO, id);
-  if (p_pdo == nullptr) {
-    return;
+  if (p == nullptr) {
+    return CO_ERROR_PARAMETERS;
   }
-  (void)CO_RPDO_takeManualControl(p_pdo, true, nullptr, nullptr);
-  p_rpdo = nullptr;
+  return rpdo_register(rpdo_com_param_index, param, p, nullptr, 0);
 }
 
-/** @}*/
-#else
-CO_ReturnError_t Canopen::tpdo_take_control(u16 tpdo_com_param_index)
+CO_ReturnError_t Canopen::rpdo_take_control(u16 rpdo_com_param_index,
+    rpdo_frame_t *p_ring, u16 ring_size)
 {
-  return CO_ERROR_PARAMETERS;
+  if ((p_ring == nullptr) || (ring_size < 2)) {
+    return CO_ERROR_PARAMETERS;
+  }
+  return rpdo_register(rpdo_com_param_index, nullptr, nullptr, p_ring, ring_size);
 }
-void Canopen::tpdo_release_control(u16 id)
+
+CO_ReturnError_t Canopen::rpdo_read(u16 id, rpdo_frame_t *p_frame, TickType_t timeout)
+{
+  rpdo_manual_t *p_entry = nullptr;
+  TimeOut_t timeout_state;
+  u8 i;
+
+  if (p_frame == nullptr) {
+    return CO_ERROR_PARAMETERS;
+  }
+  for (i = 0; i < pdo_manual_max; i++) {
+    CO_RPDO_t *p_pdo = rpdo_manual[i].p_pdo;
+
+    if ((p_pdo != nullptr) && (p_pdo->idx_RPDOCommPar == id) &&
+        (rpdo_manual[i].p_ring != nullptr)) {
+      p_entry = &rpdo_manual[i];
+      break;
+    }
+  }
+  if (p_entry == nullptr) {
+    return CO_ERROR_PARAMETERS;
+  }
+
+  vTaskSetTimeOutState(&timeout_state);
+  while (p_entry->tail == p_entry->head) {
+    /* Semaphore kann von bereits gelesenen PDOs noch gesetzt sein */
+    if ((xTaskCheckForTimeOut(&timeout_state, &timeout) != pdFALSE) ||
+        (xSemaphoreTake(p_entry->sem, timeout) != pdTRUE)) {
+      return CO_ERROR_TIMEOUT;
+    }
+  }
+  __sync_synchronize();
+  *p_frame = p_entry->p_ring[p_entry->tail];
+  p_entry->tail = (p_entry->tail + 1) % p_entry->ring_size;
+  return CO_ERROR_NO;
+}
+
+void Canopen::rpdo_release_control(u16 id)
+{
+  CO_RPDO_t *p_pdo;
+  u8 i;
+
+  p_pdo = CO_get_RPDO(p_co, id);
+  if (p_pdo == nullptr) {
+    return;
+  }
+  CO_LOCK_OD();
+  for (i = 0; i < pdo_manual_max; i++) {
+    if (rpdo_manual[i].p_pdo == p_pdo) {
+      (void)CO_RPDO_takeManualControl(p_pdo, false, nullptr, nullptr);
+      rpdo_manual[i].p_pdo = nullptr;
+      break;
+    }
+  }
+  CO_UNLOCK_OD();
+}
+
+/** @}*/
+#else
+CO_ReturnError_t Canopen::tpdo_take_control(u16 tpdo_com_param_index)
+{
+  return CO_ERROR_PARAMETERS;
+}
+void Canopen::tpdo_release_control(u16 id)
 {
 }
 CO_ReturnError_t Canopen::tpdo_send(u16 id)
 {
   return CO_ERROR_PARAMETERS;
 }
+CO_ReturnError_t Canopen::tpdo_send(u16 id, const u8 *p_data, u8 count)
+{
+  return CO_ERROR_PARAMETERS;
+}
 CO_ReturnError_t Canopen::rpdo_take_control(u16 rpdo_com_param_index, void *param,
     void (*p)(void *param, const u8* p_data, u8 count))
 {
   return CO_ERROR_PARAMETERS;
 }
+CO_ReturnError_t Canopen::rpdo_take_control(u16 rpdo_com_param_index,
+    rpdo_frame_t *p_ring, u16 ring_size)
+{
+  return CO_ERROR_PARAMETERS;
+}
+CO_ReturnError_t Canopen::rpdo_read(u16 id, rpdo_frame_t *p_frame, TickType_t timeout)
+{
+  return CO_ERROR_PARAMETERS;
+}
 void Canopen::rpdo_release_control(u16 id)
 {
 }
 #endif
 
+/**
+ * @defgroup Ver"offentlichung empfangener PDO Daten
+ * @{
+ */
+
+/**
+ * Liste der in g"ultige RPDOs gemappten OD Werte neu aufbauen
+ *
+ * L"auft im RX Thread mit gesperrtem OD. Der aktuelle Stand aller Werte
+ * wird als erster Batch ver"offentlicht, damit der Empf"anger ein
+ * vollst"andiges Abbild hat.
+ */
+void Canopen::pdo_publish_build(void)
+{
+  pdo_publish_t *p_pub = p_publish;
+  pdo_batch_t *p_batch = &p_pub->batch[p_pub->fill];
+  u16 shadow = 0;
+  u16 i;
+  u8 j;
+  u8 k;
+
+  p_pub->entries = 0;
+  p_pub->skipped = 0;
+  p_batch->count = 0;
+  p_batch->length = 0;
+  for (i = 0; i < CO_NO_RPDO; i++) {
+    const CO_RPDO_t *p_pdo = p_co->RPDO[i];
+    const uint32_t *p_map = &p_pdo->RPDOMapPar->mappedObject1;
+
+    if (p_pdo->valid == false) {
+      continue;
+    }
+    for (j = 0; (j < p_pdo->RPDOMapPar->numberOfMappedObjects) && (j < 8); j++) {
+      u32 key = p_map[j];
+      u16 index = key >> 16;
+      u8 size = (key & 0xff) / 8;
+      const u8 *p_od;
+
+      if ((index < 0x20) || (size == 0)) {
+        continue; //Dummy Eintrag
+      }
+      for (k = 0; k < p_pub->entries; k++) {
+        if (p_pub->entry[k].key == key) {
+          break; //in mehreren RPDOs gemappt
+        }
+      }
+      if (k < p_pub->entries) {
+        continue;
+      }
+      p_od = reinterpret_cast<const u8*>(get_od_pointer(index, (key >> 8) & 0xff, size));
+      if ((p_od == nullptr) || (p_pub->entries >= pdo_publish_values_max) ||
+          (shadow + size > pdo_publish_data_max)) {
+        p_pub->skipped ++;
+        continue;
+      }
+      p_pub->entry[p_pub->entries].p_od = p_od;
+      p_pub->entry[p_pub->entries].key = key;
+      p_pub->entry[p_pub->entries].shadow = shadow;
+      p_pub->entry[p_pub->entries].slot = 0xffff;
+      memcpy(&p_pub->shadow[shadow], p_od, size);
+      shadow += size;
+      p_pub->entries ++;
+    }
+  }
+  /* Shadow wurde oben bereits gef"ullt, daher alle Werte direkt eintragen */
+  for (i = 0; i < p_pub->entries; i++) {
+    u8 size = (p_pub->entry[i].key & 0xff) / 8;
+
+    p_pub->entry[i].slot = i;
+    p_batch->key[i] = p_pub->entry[i].key;
+    p_batch->changed[i] = xTaskGetTickCount();
+    p_batch->offset[i] = p_batch->length;
+    memcpy(&p_batch->data[p_batch->length], p_pub->entry[i].p_od, size);
+    p_batch->length += size;
+  }
+  p_batch->count = p_pub->entries;
+}
+
+/**
+ * Ge"anderte RPDO Werte sammeln und Batch zur Ver"offentlichung freigeben
+ *
+ * L"auft im RX Thread nach der RPDO Verarbeitung mit gesperrtem OD.
+ *
+ * @param sync_was true wenn in diesem Zyklus ein SYNC empfangen wurde
+ */
+void Canopen::pdo_publish_cycle(bool sync_was)
+{
+  pdo_publish_t *p_pub = p_publish;
+  pdo_batch_t *p_batch;
+  TickType_t now;
+  bool operational;
+  bool due;
+  u16 i;
+
+  if (p_pub == nullptr) {
+    return;
+  }
+  /* Mapping kann sich nur au"serhalb von OPERATIONAL "andern */
+  operational = p_co->NMT->operatingState == CO_NMT_OPERATIONAL;
+  if (operational != p_pub->operational) {
+    p_pub->operational = operational;
+    if (operational == true) {
+      pdo_publish_build();
+    }
+  }
+  if (operational == false) {
+    return;
+  }
+
+  now = xTaskGetTickCount();
+  p_batch = &p_pub->batch[p_pub->fill];
+  for (i = 0; i < p_pub->entries; i++) {
+    auto *p_entry = &p_pub->entry[i];
+    u8 size = (p_entry->key & 0xff) / 8;
+    u16 slot;
+
+    if (memcmp(&p_pub->shadow[p_entry->shadow], p_entry->p_od, size) == 0) {
+      continue;
+    }
+    memcpy(&p_pub->shadow[p_entry->shadow], p_entry->p_od, size);
+    slot = p_entry->slot;
+    if (slot == 0xffff) {
+      /* Jeder Wert h"ochstens einmal pro Batch, der Platz reicht daher immer */
+      slot = p_batch->count ++;
+      p_entry->slot = slot;
+      p_batch->key[slot] = p_entry->key;
+      p_batch->offset[slot] = p_batch->length;
+      p_batch->length += size;
+    }
+    p_batch->changed[slot] = now;
+    memcpy(&p_batch->data[p_batch->offset[slot]], p_entry->p_od, size);
+  }
+
+  if (p_pub->interval == 0) {
+    due = sync_was;
+  } else {
+    due = (now - p_pub->last) >= p_pub->interval;
+  }
+  if (due == false) {
+    return;
+  }
+  if (p_batch->count == 0) {
+    p_pub->last = now;
+    return;
+  }
+  if (p_pub->ready == true) {
+    /* Senke noch besch"aftigt, im selben Batch weitersammeln */
+    return;
+  }
+  p_batch->sequence = p_pub->sequence ++;
+  p_batch->timestamp = now;
+  for (i = 0; i < p_pub->entries; i++) {
+    p_pub->entry[i].slot = 0xffff;
+  }
+  p_pub->fill ^= 1;
+  p_pub->batch[p_pub->fill].count = 0;
+  p_pub->batch[p_pub->fill].length = 0;
+  p_pub->last = now;
+  /* Batch muss vor dem Flag sichtbar sein */
+  __sync_synchronize();
+  p_pub->ready = true;
+  threadMain_signal();
+}
+
+/**
+ * Fertigen Batch an die Senke "ubergeben
+ *
+ * L"auft im Thread von <process()>, ohne OD Sperre.
+ */
+void Canopen::pdo_publish_flush(void)
+{
+  pdo_publish_t *p_pub = p_publish;
+
+  if ((p_pub == nullptr) || (p_pub->ready == false)) {
+    return;
+  }
+  __sync_synchronize();
+  p_pub->p(p_pub->param, &p_pub->batch[p_pub->fill ^ 1]);
+  p_pub->ready = false;
+}
+
+CO_ReturnError_t Canopen::pdo_publish_register(pdo_publish_t *p_pub, u32 interval_ms,
+    void *param, void (*p)(void *param, const pdo_batch_t *p_batch))
+{
+  if ((p_pub == nullptr) || (p == nullptr)) {
+    return CO_ERROR_PARAMETERS;
+  }
+  if (p_publish != nullptr) {
+    return CO_ERROR_OUT_OF_MEMORY;
+  }
+  memset(p_pub, 0, sizeof(*p_pub));
+  p_pub->p = p;
+  p_pub->param = param;
+  p_pub->interval = pdMS_TO_TICKS(interval_ms);
+  p_pub->last = xTaskGetTickCount();
+
+  /* Mapping wird im n"achsten Zyklus im Zustand OPERATIONAL gelesen */
+  CO_LOCK_OD();
+  p_publish = p_pub;
+  CO_UNLOCK_OD();
+  return CO_ERROR_NO;
+}
+
+void Canopen::pdo_publish_release(void)
+{
+  CO_LOCK_OD();
+  p_publish = nullptr;
+  CO_UNLOCK_OD();
+}
+
+/** @}*/
+
 /**
  * Einige Werte im OD werden zur Compile Time / Startup Time generiert. Diese
  * werden hier eingetragen.
@@ -1397,6 +2242,34 @@ void Canopen::od_load_start(void)
   }
 }
 
+/**
+ * CANopen Kommunikationsparameter bei Reset Communication neu laden.
+ *
+ * Das OD Abbild im RAM wurde beim Erststart per od_set_defaults() und
+ * od_load_start() vollst"andig aufgebaut und ist weiterhin g"ultig. Reset
+ * Communication betrifft laut CiA 301 nur den Kommunikationsbereich, daher
+ * wird nur dieser aus dem NVM geladen. Anwendungsparameter bleiben erhalten
+ * und der CRC "uber die gro"sen Bereiche entf"allt.
+ *
+ * Diese Funktion darf nur bei angehaltenem CO Stack aufgerufen werden!
+ */
+void Canopen::od_load_warm(void)
+{
+  CO_ReturnError_t co_result;
+
+  /* 2102 - CANopen Node ID, CAN bit rate wie in od_set_defaults() */
+  OD_CANNodeID = 0;
+  OD_CANBitRate = this->active_bit;
+
+  /* 2112 - Daisy Chain */
+  OD_daisyChain.shiftIn = 0;
+
+  co_result = storage.load(Canopen_storage::COMMUNICATION);
+  if (co_result != CO_ERROR_NO) {
+    log_printf(LOG_NOTICE, NOTE_CANOPEN_NVMEM_LOAD, co_result);
+  }
+}
+
 /**
  * Bestimmt anhand der aus der im OD stehenden (aus dem NVM geladenen)
  * NID und dem "Ubergabeparameter den LSS Startup
@@ -1437,22 +2310,25 @@ CO_ReturnError_t Canopen::co_init(u8 pending_nid)
     log_printf(LOG_ERR, ERR_CANOPEN_INIT_FAILED, co_result);
     return co_result;
   }
-  co_result = CO_CANinit(CAN_MODULE_A, this->active_bit);
+  /* Storage und OD_ Makros beziehen sich auf das globale OD, daher die
+   * Standardinstanz. Weitere Instanzen siehe CO_newInstance(). */
+  p_co = CO;
+  co_result = CO_CANinitInstance(p_co, CAN_MODULE_A, this->active_bit);
   if (co_result != CO_ERROR_NO) {
     CO_delete(CAN_MODULE_A);
     log_printf(LOG_ERR, ERR_CANOPEN_INIT_FAILED, co_result);
     return co_result;
   }
-  co_result = CO_LSSinit(pending_nid, this->active_bit);
+  co_result = CO_LSSinitInstance(p_co, pending_nid, this->active_bit);
   if (co_result != CO_ERROR_NO) {
     CO_delete(CAN_MODULE_A);
     log_printf(LOG_ERR, ERR_CANOPEN_INIT_FAILED, co_result);
     return co_result;
   }
-  CO_LSSslave_initCfgStoreCallback(CO->LSSslave, this, store_lss_config_callback_wrapper);
+  CO_LSSslave_initCfgStoreCallback(p_co->LSSslave, this, store_lss_config_callback_wrapper);
 
   /* start CAN */
-  CO_CANsetNormalMode(CO->CANmodule[0]);
+  CO_CANsetNormalMode(p_co->CANmodule[0]);
 
   return CO_ERROR_NO;
 }
@@ -1471,16 +2347,16 @@ void Canopen::lss_nid_assignment(u8* p_pending_nid)
 
   /* Get Node ID */
   while (true) {
-    CO_LSSslave_process(CO->LSSslave, this->active_bit, *this->p_active_nid,
+    CO_LSSslave_process(p_co->LSSslave, this->active_bit, *this->p_active_nid,
                         &dummy, p_pending_nid);
     if ((*p_pending_nid != CO_LSS_NODE_ID_ASSIGNMENT) &&
-        (CO_LSSslave_getState(CO->LSSslave) == CO_LSS_STATE_WAITING)) {
+        (CO_LSSslave_getState(p_co->LSSslave) == CO_LSS_STATE_WAITING)) {
       log_printf(LOG_NOTICE, NOTE_LSS, *p_pending_nid);
       return;
     }
 
     housekeeping_main();
-    (void)CO_CANrxWait(CO->CANmodule[0], this->main_interval);
+    (void)CO_CANrxWait(p_co->CANmodule[0], this->main_interval);
   }
 
 #else
@@ -1489,7 +2365,16 @@ void Canopen::lss_nid_assignment(u8* p_pending_nid)
 #endif
 }
 
-CO_ReturnError_t Canopen::co_start(u8 pending_nid, u32 interval)
+/**
+ * CANopen Objekte initialisieren, Callbacks eintragen und RX Thread starten
+ *
+ * @param pending_nid CANopen Node ID
+ * @param interval Abarbeitungsintervall f"ur zeitkritische CANopen Komponenten
+ * @param in_place true wenn die Objekte bei Reset Communication im bestehenden
+ * Stack neu initialisiert werden, siehe <reset_comm()>
+ * @return CO_ERROR_NO wenn erfolgreich
+ */
+CO_ReturnError_t Canopen::co_start(u8 pending_nid, u32 interval, bool in_place)
 {
   CO_ReturnError_t co_result;
   BaseType_t os_result;
@@ -1497,7 +2382,11 @@ CO_ReturnError_t Canopen::co_start(u8 pending_nid, u32 interval)
   this->worker_interval = interval;
 
   /* start CANopen */
-  co_result = CO_CANopenInit(pending_nid);
+  if (in_place == true) {
+    co_result = CO_CANopenResetCommInstance(p_co, pending_nid);
+  } else {
+    co_result = CO_CANopenInitInstance(p_co, pending_nid);
+  }
   if (co_result != CO_ERROR_NO) {
     log_printf(LOG_ERR, ERR_CANOPEN_INIT_FAILED, co_result);
     return co_result;
@@ -1510,13 +2399,60 @@ CO_ReturnError_t Canopen::co_start(u8 pending_nid, u32 interval)
   /* OD Callbacks */
   set_callback(OD_1010_storeParameters, store_parameters_callback_wrapper);
   set_callback(OD_1011_restoreDefaultParameters, restore_default_parameters_callback_wrapper);
+#if CO_NO_TIME != 1 /* sonst konfiguriert CO_TIME den Eintrag 1012 */
   set_callback(OD_1012_COB_IDTimestamp, cob_id_timestamp_callback_wrapper);
+#endif
   set_callback(OD_1f51_programControl, program_control_callback_wrapper);
   set_callback(OD_2108_temperature, temperature_callback_wrapper);
   set_callback(OD_2109_voltage, voltage_callback_wrapper);
   set_callback(OD_2110_canRuntimeInfo, can_runtime_info_callback_wrapper);
   set_callback(OD_2112_daisyChain, daisychain_callback_wrapper);
   set_callback(OD_5000_serialNumber, serial_number_callback_wrapper);
+#ifdef CO_USE_STATISTICS
+  CO_OD_configure(p_co->SDO[0], OD_2113_canServiceStatistics, CO_ODF_statistics,
+                  p_co, NULL, 0);
+#endif
+#ifdef CO_LOCK_STATISTICS
+  CO_OD_configure(p_co->SDO[0], OD_2114_odLockStatistics, CO_ODF_lockStatistics,
+                  &CO_OD_lockStat, NULL, 0);
+  CO_OD_configure(p_co->SDO[0], OD_2115_emcyLockStatistics, CO_ODF_lockStatistics,
+                  &CO_EMCY_lockStat, NULL, 0);
+#endif
+#ifdef CO_OD_PROFILING
+  CO_OD_configure(p_co->SDO[0], OD_2116_odProfile, CO_ODF_ODprofile,
+                  p_co->SDO[0], NULL, 0);
+#endif
+#ifdef CO_SDO_TRANSFER_LOG
+  CO_OD_configure(p_co->SDO[0], OD_211b_sdoTransferLog, CO_ODF_SDOtransferLog,
+                  p_co->SDO[0], NULL, 0);
+#endif
+  for (u8 i = 0; i < od_domain_max; i++) {
+    if (od_domain[i].index != 0) {
+      CO_OD_configure(p_co->SDO[0], od_domain[i].index, domain_callback,
+                      &od_domain[i], NULL, 0);
+    }
+  }
+#ifdef CO_LATENCY_BENCH
+  /* Latenzmessung, Werte in CPU Takten */
+  CO_OD_configure(p_co->SDO[0], OD_2117_latencyRxDispatch, CO_ODF_latency,
+                  &CO_latency[CO_LATENCY_RX_DISPATCH], NULL, 0);
+  CO_OD_configure(p_co->SDO[0], OD_2118_latencyRxReturn, CO_ODF_latency,
+                  &CO_latency[CO_LATENCY_RX_RETURN], NULL, 0);
+  CO_OD_configure(p_co->SDO[0], OD_2119_latencySyncRPDO, CO_ODF_latency,
+                  &CO_latency[CO_LATENCY_SYNC_RPDO], NULL, 0);
+  CO_OD_configure(p_co->SDO[0], OD_211a_latencySyncTPDO, CO_ODF_latency,
+                  &CO_latency[CO_LATENCY_SYNC_TPDO], NULL, 0);
+#endif
+
+  /* Alle Knoten starten gleichzeitig. Damit die Heartbeats nicht geb"undelt
+   * gesendet werden, werden sie nach Node ID "uber die Periode verteilt */
+  CO_NMT_setHBphase(p_co->NMT, CO_NMT_HB_PHASE_NODE_ID);
+
+  /* Compile-time Beschreibung aus canopen_od.h muss zu CO_OD.c passen */
+  if (od_verify() != true) {
+    log_printf(LOG_ERR, ERR_CANOPEN_INIT_FAILED, CO_ERROR_ILLEGAL_ARGUMENT);
+    return CO_ERROR_ILLEGAL_ARGUMENT;
+  }
 
   /* Durch Reset Communication werden alle Callbacks im Stack gel"oscht. Falls bereits
    * ein NMT Callback eingetragen war, wird dieser erneut eingetragen und
@@ -1528,6 +2464,7 @@ CO_ReturnError_t Canopen::co_start(u8 pending_nid, u32 interval)
 
   /* Configure Timer function for execution every <interval> millisecond */
   CANrx_threadTmr_init(this->worker_interval);
+  CANrx_threadTmr_initCallback(this, pdo_publish_cycle_wrapper);
   if (timer_rx_handle != NULL) {
     /* Thread wurde bereits gestartet und ist laufbereit */
     vTaskResume(this->timer_rx_handle);
@@ -1555,8 +2492,13 @@ CO_ReturnError_t Canopen::init(u8 nid, u32 interval)
   CO_ReturnError_t co_result;
   u8 pending_nid;
 
-  od_set_defaults();
-  od_load_start();
+  if (once != true) {
+    od_set_defaults();
+    od_load_start();
+  } else {
+    /* Warmstart nach Reset Communication */
+    od_load_warm();
+  }
 
   pending_nid = nid;
   lss_check(&pending_nid);
@@ -1575,7 +2517,7 @@ CO_ReturnError_t Canopen::init(u8 nid, u32 interval)
 
   lss_nid_assignment(&pending_nid);
 
-  co_result = co_start(pending_nid, interval);
+  co_result = co_start(pending_nid, interval, false);
   if (co_result != CO_ERROR_NO) {
     return co_result;
   }
@@ -1583,13 +2525,19 @@ CO_ReturnError_t Canopen::init(u8 nid, u32 interval)
   if (once != true) {
     once = true;
     OD_powerOnCounter ++;
-    (void)storage.save(Canopen_storage::RUNTIME);
+    /* Der Z"ahlerstand darf den Start nicht verz"ogern */
+    storage.save_background(Canopen_storage::RUNTIME);
   }
 
   return CO_ERROR_NO;
 }
 
-void Canopen::deinit(void)
+/**
+ * CANopen Abarbeitung anhalten und Anwendungszugriffe l"osen
+ *
+ * Der Stack selbst bleibt bestehen.
+ */
+void Canopen::co_stop(void)
 {
   /* RX Handlerthread synchronisieren. Der Thread suspended sich dann
    * selbst. */
@@ -1601,11 +2549,62 @@ void Canopen::deinit(void)
   /* NMT Subscribern den Zugriff auf CANopen Funktionen entziehen */
   nmt_relay_event(INITIALIZING);
 
-  CO_delete(CAN_MODULE_A);
   reset = CO_RESET_NOT;
+  CO_LOCK_OD();
+  memset(tpdo_manual, 0, sizeof(tpdo_manual));
+  for (u8 i = 0; i < pdo_manual_max; i++) {
+    rpdo_manual[i].p_pdo = nullptr;   //Semaphore bleibt erhalten
+    rpdo_manual[i].p_ring = nullptr;
+  }
+  CO_UNLOCK_OD();
+  /* Alle od_handle beim n"achsten Zugriff neu aufl"osen */
+  od_generation ++;
+  /* Mapping der Ver"offentlichung nach dem Start neu lesen */
+  if (p_publish != nullptr) {
+    p_publish->operational = false;
+  }
+}
+
+/**
+ * Reset Communication ohne Neuaufbau des Stacks
+ *
+ * CAN Treiber, RX Thread und Speicher des Stacks bleiben erhalten. Es wird
+ * nur der Kommunikationsbereich aus dem NVM geladen und die CANopen Objekte
+ * werden damit neu initialisiert. Der Knoten ist dadurch nur kurz nicht
+ * erreichbar.
+ *
+ * @param nid CANopen Node ID vom LSS Slave. 0 = Node ID aus dem OD.
+ * @return CO_ERROR_NO wenn erfolgreich
+ */
+CO_ReturnError_t Canopen::reset_comm(u8 nid)
+{
+  CO_ReturnError_t co_result;
+  u8 pending_nid;
+
+  co_stop();
+  od_load_warm();
+
+  pending_nid = nid;
+  lss_check(&pending_nid);
+
+  co_result = CO_LSSinitInstance(p_co, pending_nid, this->active_bit);
+  if (co_result != CO_ERROR_NO) {
+    log_printf(LOG_ERR, ERR_CANOPEN_INIT_FAILED, co_result);
+    return co_result;
+  }
+  CO_LSSslave_initCfgStoreCallback(p_co->LSSslave, this, store_lss_config_callback_wrapper);
+
+  lss_nid_assignment(&pending_nid);
+
+  return co_start(pending_nid, this->worker_interval, true);
+}
+
+void Canopen::deinit(void)
+{
+  co_stop();
+
+  CO_delete(CAN_MODULE_A);
   *p_active_nid = 0;
-  p_tpdo = nullptr;
-  p_rpdo = nullptr;
 }
 
 void Canopen::process(void)
@@ -1616,6 +2615,7 @@ void Canopen::process(void)
   CO_NMT_reset_cmd_t reset;
 
   threadMain_process(&reset);
+  pdo_publish_flush();
 
   /* Reset auswerten. Der Reset kann von folgenden Stellen getriggert werden:
    * - Netzwerk
@@ -1623,13 +2623,12 @@ void Canopen::process(void)
   if (reset != CO_RESET_NOT){
     log_printf(LOG_DEBUG, DEBUG_CANOPEN_RESET, reset);
 
-    CO_LSSslave_process(CO->LSSslave, this->active_bit, *this->p_active_nid,
+    CO_LSSslave_process(p_co->LSSslave, this->active_bit, *this->p_active_nid,
                         &dummy, &pending_nid);
 
     switch (reset) {
       case CO_RESET_COMM:
-        deinit();
-        result = init(pending_nid, this->worker_interval);
+        result = reset_comm(pending_nid);
         if (result != CO_ERROR_NO) {
           globals.request_reboot();
         }
@@ -1664,6 +2663,11 @@ BaseType_t Canopen::cmd_terminal( char *pcWriteBuffer,
   const char *p_opttmp;
   const char *p_optarg;
 
+  if (cmd_stream.p_line != nullptr) {
+    /* Fortsetzung einer Ausgabe, die CLI ruft mit demselben Befehl auf */
+    return cmd_stream_output(pcWriteBuffer, xWriteBufferLen);
+  }
+
   /* Pr"ufung auf Parameteranzahl macht CLI da vorgegeben */
   p_opttmp = pcCommandString;
   result = terminal_get_opt(&p_opttmp, &opt);
@@ -1687,7 +2691,7 @@ BaseType_t Canopen::cmd_terminal( char *pcWriteBuffer,
     case 'b':
       /* nach Muster -b <can_baud_t>. 1 MBit = 0
        * Quick & dirty direkt in den Treiber, nicht speichernd */
-      state = can_ioctl(CO->CANmodule[0]->driver, CAN_SET_BAUDRATE,
+      state = can_ioctl(p_co->CANmodule[0]->driver, CAN_SET_BAUDRATE,
                         reinterpret_cast<void*>(&tmp));
       OD_CANBitRate = CO_LSS_bitTimingTableLookup[tmp];
       if (state != CAN_OK) {
@@ -1701,6 +2705,42 @@ BaseType_t Canopen::cmd_terminal( char *pcWriteBuffer,
       }
       (void)storage.restore(static_cast<Canopen_storage::storage_type_t>(tmp));
       break;
+#ifdef CO_USE_STATISTICS
+    case 's':
+      /* nach Muster -s [1]. 1 setzt die Z"ahler zur"uck */
+      return cmd_stream_start(pcWriteBuffer, xWriteBufferLen,
+                              &Canopen::cmd_line_statistics, tmp);
+#endif
+#ifdef CO_OD_PROFILING
+    case 'p':
+      /* nach Muster -p [1]. 1 setzt die Z"ahler zur"uck */
+      return cmd_stream_start(pcWriteBuffer, xWriteBufferLen,
+                              &Canopen::cmd_line_od_profile, tmp);
+#endif
+#ifdef CO_SDO_TRANSFER_LOG
+    case 't':
+      /* nach Muster -t [1]. 1 l"oscht das Protokoll */
+      return cmd_stream_start(pcWriteBuffer, xWriteBufferLen,
+                              &Canopen::cmd_line_sdo_transfers, tmp);
+#endif
+#ifdef CO_LATENCY_BENCH
+    case 'l':
+      /* nach Muster -l [1]. 1 setzt die Messung zur"uck */
+      return cmd_stream_start(pcWriteBuffer, xWriteBufferLen,
+                              &Canopen::cmd_line_latency, tmp);
+#endif
+    case 'h':
+      /* nach Muster -h 0. Zustand der Heartbeat Consumer */
+      return cmd_stream_start(pcWriteBuffer, xWriteBufferLen,
+                              &Canopen::cmd_line_heartbeat, 0);
+    case 'd':
+      /* nach Muster -d 0. PDO Konfiguration */
+      return cmd_stream_start(pcWriteBuffer, xWriteBufferLen,
+                              &Canopen::cmd_line_pdo, 0);
+    case 'o':
+      /* nach Muster -o 0x2100. OD Inhalt 0x2100..0x21ff */
+      return cmd_stream_start(pcWriteBuffer, xWriteBufferLen,
+                              &Canopen::cmd_line_od, tmp);
     default:
       (void)snprintf(pcWriteBuffer, xWriteBufferLen, terminal_text_unknown_option, opt);
       return pdFALSE;
@@ -1708,6 +2748,441 @@ BaseType_t Canopen::cmd_terminal( char *pcWriteBuffer,
   return pdFALSE;
 }
 
+/*
+ * Ausgabe starten, p_line erzeugt die Zeilen
+ */
+BaseType_t Canopen::cmd_stream_start(char *pcWriteBuffer, size_t xWriteBufferLen,
+                                     bool (Canopen::*p_line)(void), u16 arg)
+{
+  cmd_stream.p_line = p_line;
+  cmd_stream.arg = arg;
+  cmd_stream.item = 0;
+  cmd_stream.sub = 0;
+  cmd_stream.offset = 0;
+  if (cmd_stream_next() == false) {
+    pcWriteBuffer[0] = '\0';
+    return pdFALSE;
+  }
+  return cmd_stream_output(pcWriteBuffer, xWriteBufferLen);
+}
+
+/*
+ * N"achste Zeile erzeugen, false wenn Ausgabe beendet
+ */
+bool Canopen::cmd_stream_next(void)
+{
+  cmd_stream.pos = 0;
+  cmd_stream.length = 0;
+  cmd_stream.line[0] = '\0';
+  if ((this->*cmd_stream.p_line)() == false) {
+    cmd_stream.p_line = nullptr;
+    return false;
+  }
+  cmd_stream.length = strnlen(cmd_stream.line, sizeof(cmd_stream.line));
+  return true;
+}
+
+/*
+ * Ein St"uck der aktuellen Zeile ausgeben. Die n"achste Zeile wird bereits
+ * hier erzeugt, damit nach der letzten Zeile pdFALSE geliefert wird.
+ */
+BaseType_t Canopen::cmd_stream_output(char *pcWriteBuffer, size_t xWriteBufferLen)
+{
+  size_t count;
+
+  if (xWriteBufferLen < 2) {
+    cmd_stream.p_line = nullptr;
+    return pdFALSE;
+  }
+
+  count = cmd_stream.length - cmd_stream.pos;
+  if (count > xWriteBufferLen - 1) {
+    count = xWriteBufferLen - 1;
+  }
+  memcpy(pcWriteBuffer, &cmd_stream.line[cmd_stream.pos], count);
+  pcWriteBuffer[count] = '\0';
+  cmd_stream.pos += count;
+
+  if ((cmd_stream.pos >= cmd_stream.length) && (cmd_stream_next() == false)) {
+    return pdFALSE;
+  }
+  return pdTRUE;
+}
+
+#ifdef CO_USE_STATISTICS
+/*
+ * Statistik, siehe CO_getStatistics(). Argument 1 setzt die Z"ahler zur"uck
+ */
+bool Canopen::cmd_line_statistics(void)
+{
+  const u16 line = cmd_stream.item;
+  u32 val[8];
+  u8 sub;
+  u8 i;
+
+  if (line == 0) {
+    if (cmd_stream.arg == 1) {
+      CO_resetStatistics(p_co);
+    }
+    /* Dienste rx/tx */
+    for (i = 0; i < 7; i++) {
+      (void)CO_getStatistics(p_co, i + 1, &val[i]);
+    }
+    (void)snprintf(cmd_stream.line, sizeof(cmd_stream.line),
+                   "NMT %lu/%lu SYNC %lu/%lu EMCY -/%lu HB %lu/%lu" NEWLINE,
+                   (unsigned long)val[0], (unsigned long)val[1],
+                   (unsigned long)val[2], (unsigned long)val[3],
+                   (unsigned long)val[4], (unsigned long)val[5],
+                   (unsigned long)val[6]);
+  } else if (line == 1) {
+    for (i = 0; i < 8; i++) {
+      (void)CO_getStatistics(p_co, i + 8, &val[i]);
+    }
+    (void)snprintf(cmd_stream.line, sizeof(cmd_stream.line),
+                   "SDO %lu/%lu SDOC %lu/%lu LSS %lu/%lu DAISY %lu/%lu" NEWLINE,
+                   (unsigned long)val[0], (unsigned long)val[1],
+                   (unsigned long)val[2], (unsigned long)val[3],
+                   (unsigned long)val[4], (unsigned long)val[5],
+                   (unsigned long)val[6], (unsigned long)val[7]);
+  } else if (line < 2 + CO_NO_RPDO + CO_NO_TPDO) {
+    /* PDOs ab Subindex 16, je Nachrichten, Latenz, Verpasst */
+    i = line - 2;
+    sub = 16 + i * 3;
+    (void)CO_getStatistics(p_co, sub, &val[0]);
+    (void)CO_getStatistics(p_co, sub + 1, &val[1]);
+    (void)CO_getStatistics(p_co, sub + 2, &val[2]);
+    (void)snprintf(cmd_stream.line, sizeof(cmd_stream.line),
+                   "%cPDO%u %lu msg %lu us %lu missed" NEWLINE,
+                   i < CO_NO_RPDO ? 'R' : 'T',
+                   i < CO_NO_RPDO ? i + 1 : i - CO_NO_RPDO + 1,
+                   (unsigned long)val[0], (unsigned long)val[1],
+                   (unsigned long)val[2]);
+  } else if (line == 2 + CO_NO_RPDO + CO_NO_TPDO) {
+    /* Buslast in Promille, letzte drei Subindizes nach den PDOs */
+    sub = 16 + (CO_NO_RPDO + CO_NO_TPDO) * 3;
+    for (i = 0; i < 3; i++) {
+      (void)CO_getStatistics(p_co, sub + i, &val[i]);
+    }
+    (void)snprintf(cmd_stream.line, sizeof(cmd_stream.line),
+                   "Buslast 10ms %lu 100ms %lu 1s %lu promille" NEWLINE,
+                   (unsigned long)val[0], (unsigned long)val[1],
+                   (unsigned long)val[2]);
+  } else {
+    return false;
+  }
+  cmd_stream.item++;
+  return true;
+}
+#endif
+
+#ifdef CO_OD_PROFILING
+/*
+ * N"achster OD Eintrag ab entry mit Zugriffen, ODSize wenn keiner mehr
+ */
+static u16 od_profile_find(const CO_SDO_t *p_sdo, u16 entry)
+{
+  const CO_OD_profile_t *p_prof;
+  u8 i;
+
+  for (; entry < p_sdo->ODSize; entry++) {
+    p_prof = &p_sdo->ODProfile[entry];
+    if (p_prof->ODFcount != 0) {
+      return entry;
+    }
+    for (i = 0; i < CO_OD_PROF_NO_PATHS; i++) {
+      if (p_prof->count[i] != 0) {
+        return entry;
+      }
+    }
+  }
+  return entry;
+}
+
+/*
+ * OD Zugriffe, Eintr"age ohne Zugriff werden "ubersprungen. Argument 1 setzt
+ * die Z"ahler zur"uck
+ */
+bool Canopen::cmd_line_od_profile(void)
+{
+  CO_SDO_t *p_sdo = p_co->SDO[0];
+  const CO_OD_profile_t *p_prof;
+  u16 entry;
+
+  if (p_sdo->ODProfile == NULL) {
+    return false;
+  }
+  if ((cmd_stream.item == 0) && (cmd_stream.arg == 1)) {
+    CO_OD_resetProfile(p_sdo);
+    return false;
+  }
+  entry = od_profile_find(p_sdo, cmd_stream.item);
+  if (entry >= p_sdo->ODSize) {
+    return false;
+  }
+
+  p_prof = &p_sdo->ODProfile[entry];
+  (void)snprintf(cmd_stream.line, sizeof(cmd_stream.line),
+                 "%04X SDO %lu/%lu RPDO %lu TPDO %lu APP %lu ODF %lu max %lu us" NEWLINE,
+                 p_sdo->OD[entry].index,
+                 (unsigned long)p_prof->count[CO_OD_PROF_SDO_READ],
+                 (unsigned long)p_prof->count[CO_OD_PROF_SDO_WRITE],
+                 (unsigned long)p_prof->count[CO_OD_PROF_RPDO],
+                 (unsigned long)p_prof->count[CO_OD_PROF_TPDO],
+                 (unsigned long)p_prof->count[CO_OD_PROF_APP],
+                 (unsigned long)p_prof->ODFcount,
+                 (unsigned long)p_prof->ODFmax_us);
+  cmd_stream.item = entry + 1;
+  return true;
+}
+#endif
+
+#ifdef CO_SDO_TRANSFER_LOG
+/*
+ * SDO Transfers aller Server, "alteste zuerst. Argument 1 l"oscht das
+ * Protokoll
+ */
+bool Canopen::cmd_line_sdo_transfers(void)
+{
+  static const char *const p_protocols[] = { "exp", "seg", "blk" };
+  CO_SDO_transferLog_t *p_log = p_co->SDO[0]->transferLog;
+  const CO_SDO_transferRecord_t *p_rec;
+  u32 records;
+
+  if (p_log == NULL) {
+    return false;
+  }
+  if ((cmd_stream.item == 0) && (cmd_stream.arg == 1)) {
+    CO_SDO_resetTransferLog(p_log);
+    return false;
+  }
+  records = (p_log->count < p_log->size) ? p_log->count : p_log->size;
+  if (cmd_stream.item >= records) {
+    return false;
+  }
+
+  p_rec = &p_log->records[(p_log->head + p_log->size - records +
+                           cmd_stream.item) % p_log->size];
+  (void)snprintf(cmd_stream.line, sizeof(cmd_stream.line),
+                 "%03lX %04X.%02X %s %s %lu byte %lu ms retry %u abort %08lX" NEWLINE,
+                 (unsigned long)p_rec->COB_IDClient, p_rec->index,
+                 p_rec->subIndex, p_rec->upload ? "up" : "down",
+                 p_protocols[p_rec->protocol], (unsigned long)p_rec->bytes,
+                 (unsigned long)p_rec->duration_ms, p_rec->retransmissions,
+                 (unsigned long)p_rec->abortCode);
+  cmd_stream.item++;
+  return true;
+}
+#endif
+
+#ifdef CO_LATENCY_BENCH
+/*
+ * Latenzmessung, siehe CO_latency.h. Je Messpunkt eine Zeile mit den Werten
+ * und Zeilen mit je 8 Histogrammklassen. Argument 1 setzt die Messung zur"uck
+ */
+bool Canopen::cmd_line_latency(void)
+{
+  static const char *const p_names[CO_LATENCY_COUNT] = {
+    "RX_DISPATCH", "RX_RETURN", "SYNC_RPDO", "SYNC_TPDO"
+  };
+  const CO_latency_t *p_lat;
+  u8 bin;
+  u8 i;
+  int pos;
+
+  if ((cmd_stream.item == 0) && (cmd_stream.sub == 0) && (cmd_stream.arg == 1)) {
+    for (i = 0; i < CO_LATENCY_COUNT; i++) {
+      /* Wird vom RT Thread ausgef"uhrt */
+      CO_latency[i].reset = true;
+    }
+    return false;
+  }
+  if (cmd_stream.item >= CO_LATENCY_COUNT) {
+    return false;
+  }
+
+  p_lat = &CO_latency[cmd_stream.item];
+  if (cmd_stream.sub == 0) {
+    (void)snprintf(cmd_stream.line, sizeof(cmd_stream.line),
+                   "%s min %lu avg %lu max %lu cyc %lu n %lu missed" NEWLINE,
+                   p_names[cmd_stream.item],
+                   (unsigned long)(p_lat->count != 0 ? p_lat->min : 0),
+                   (unsigned long)(p_lat->count != 0 ? p_lat->sum / p_lat->count : 0),
+                   (unsigned long)p_lat->max, (unsigned long)p_lat->count,
+                   (unsigned long)p_lat->missed);
+  } else {
+    bin = (cmd_stream.sub - 1) * 8;
+    pos = snprintf(cmd_stream.line, sizeof(cmd_stream.line), "  %lu cyc:",
+                   (unsigned long)bin * CO_LATENCY_BIN_CYCLES);
+    for (i = bin; (i < bin + 8) && (i < CO_LATENCY_BINS); i++) {
+      pos += snprintf(&cmd_stream.line[pos], sizeof(cmd_stream.line) - pos,
+                      " %lu", (unsigned long)p_lat->histogram[i]);
+    }
+    (void)snprintf(&cmd_stream.line[pos], sizeof(cmd_stream.line) - pos, NEWLINE);
+  }
+
+  cmd_stream.sub++;
+  if ((cmd_stream.sub - 1) * 8 >= CO_LATENCY_BINS) {
+    cmd_stream.sub = 0;
+    cmd_stream.item++;
+  }
+  return true;
+}
+#endif
+
+/*
+ * Heartbeat Consumer, eine Zeile pro "uberwachtem Knoten
+ */
+bool Canopen::cmd_line_heartbeat(void)
+{
+  static const char *const p_states[] = {
+    "unconfigured", "unknown", "active", "timeout"
+  };
+  const CO_HBconsumer_t *p_hb = p_co->HBcons;
+  const CO_HBconsNode_t *p_node;
+
+  while ((cmd_stream.item < p_hb->numberOfMonitoredNodes) &&
+         (p_hb->monitoredNodes[cmd_stream.item].HBstate == CO_HBconsumer_UNCONFIGURED)) {
+    cmd_stream.item++;
+  }
+  if (cmd_stream.item >= p_hb->numberOfMonitoredNodes) {
+    return false;
+  }
+  p_node = &p_hb->monitoredNodes[cmd_stream.item];
+
+  (void)snprintf(cmd_stream.line, sizeof(cmd_stream.line),
+                 "HB%u node %u %u ms %s NMT 0x%02X" NEWLINE,
+                 cmd_stream.item + 1, p_node->nodeId, p_node->time,
+                 p_states[p_node->HBstate & 0x03U], (unsigned)p_node->NMTstate);
+  cmd_stream.item++;
+  return true;
+}
+
+/*
+ * PDO Konfiguration, je PDO eine Zeile Kommunikationsparameter und Zeilen mit
+ * je 4 gemappten Objekten
+ */
+bool Canopen::cmd_line_pdo(void)
+{
+  const u32 *p_map;
+  u8 count;
+  u8 first;
+  u8 i;
+  int pos;
+
+  if (cmd_stream.item >= CO_NO_RPDO + CO_NO_TPDO) {
+    return false;
+  }
+
+  if (cmd_stream.item < CO_NO_RPDO) {
+    const CO_RPDO_t *p_pdo = p_co->RPDO[cmd_stream.item];
+
+    p_map = &p_pdo->RPDOMapPar->mappedObject1;
+    count = p_pdo->RPDOMapPar->numberOfMappedObjects;
+    if (cmd_stream.sub == 0) {
+      (void)snprintf(cmd_stream.line, sizeof(cmd_stream.line),
+                     "RPDO%u COB 0x%08lX type %u len %u %s" NEWLINE,
+                     cmd_stream.item + 1,
+                     (unsigned long)p_pdo->RPDOCommPar->COB_IDUsedByRPDO,
+                     p_pdo->RPDOCommPar->transmissionType, p_pdo->dataLength,
+                     p_pdo->valid ? "valid" : "invalid");
+    }
+  } else {
+    const CO_TPDO_t *p_pdo = p_co->TPDO[cmd_stream.item - CO_NO_RPDO];
+
+    p_map = &p_pdo->TPDOMapPar->mappedObject1;
+    count = p_pdo->TPDOMapPar->numberOfMappedObjects;
+    if (cmd_stream.sub == 0) {
+      (void)snprintf(cmd_stream.line, sizeof(cmd_stream.line),
+                     "TPDO%u COB 0x%08lX type %u inhibit %u event %u len %u %s" NEWLINE,
+                     cmd_stream.item - CO_NO_RPDO + 1,
+                     (unsigned long)p_pdo->TPDOCommPar->COB_IDUsedByTPDO,
+                     p_pdo->TPDOCommPar->transmissionType,
+                     p_pdo->TPDOCommPar->inhibitTime,
+                     p_pdo->TPDOCommPar->eventTimer, p_pdo->dataLength,
+                     p_pdo->valid ? "valid" : "invalid");
+    }
+  }
+  if (count > 8) {
+    count = 8;
+  }
+
+  if (cmd_stream.sub != 0) {
+    first = (cmd_stream.sub - 1) * 4;
+    pos = snprintf(cmd_stream.line, sizeof(cmd_stream.line), "  map%u:", first + 1);
+    for (i = first; (i < first + 4) && (i < count); i++) {
+      pos += snprintf(&cmd_stream.line[pos], sizeof(cmd_stream.line) - pos,
+                      " 0x%08lX", (unsigned long)p_map[i]);
+    }
+    (void)snprintf(&cmd_stream.line[pos], sizeof(cmd_stream.line) - pos, NEWLINE);
+  }
+
+  cmd_stream.sub++;
+  if ((cmd_stream.sub - 1) * 4 >= count) {
+    cmd_stream.sub = 0;
+    cmd_stream.item++;
+  }
+  return true;
+}
+
+/*
+ * OD Inhalt von arg bis arg | 0xff, je Subindex Zeilen mit bis zu 16 Bytes
+ */
+bool Canopen::cmd_line_od(void)
+{
+  const CO_SDO_t *p_sdo = p_co->SDO[0];
+  const CO_OD_entry_t *p_entry;
+  const u8 *p_data;
+  u32 length;
+  u32 count;
+  u32 i;
+  int pos;
+
+  /* Erster Eintrag im Bereich, OD ist nach Index sortiert */
+  while ((cmd_stream.item < p_sdo->ODSize) &&
+         (p_sdo->OD[cmd_stream.item].index < cmd_stream.arg)) {
+    cmd_stream.item++;
+  }
+  if ((cmd_stream.item >= p_sdo->ODSize) ||
+      (p_sdo->OD[cmd_stream.item].index > (cmd_stream.arg | 0xffU))) {
+    return false;
+  }
+  p_entry = &p_sdo->OD[cmd_stream.item];
+
+  pos = snprintf(cmd_stream.line, sizeof(cmd_stream.line), "%04X.%02X +%04lX",
+                 p_entry->index, cmd_stream.sub, (unsigned long)cmd_stream.offset);
+  CO_LOCK_OD();
+  length = CO_OD_getLength(p_co->SDO[0], cmd_stream.item, cmd_stream.sub);
+  p_data = (const u8*)CO_OD_getDataPointer(p_co->SDO[0], cmd_stream.item, cmd_stream.sub);
+  if (p_data == NULL) {
+    /* Domain, Inhalt nur per SDO */
+    length = 0;
+    pos += snprintf(&cmd_stream.line[pos], sizeof(cmd_stream.line) - pos, " domain");
+  }
+  count = length - cmd_stream.offset;
+  if (count > 16) {
+    count = 16;
+  }
+  for (i = 0; i < count; i++) {
+    pos += snprintf(&cmd_stream.line[pos], sizeof(cmd_stream.line) - pos,
+                    " %02X", p_data[cmd_stream.offset + i]);
+  }
+  CO_UNLOCK_OD();
+  (void)snprintf(&cmd_stream.line[pos], sizeof(cmd_stream.line) - pos, NEWLINE);
+
+  cmd_stream.offset += count;
+  if (cmd_stream.offset >= length) {
+    cmd_stream.offset = 0;
+    if (cmd_stream.sub >= p_entry->maxSubIndex) {
+      cmd_stream.sub = 0;
+      cmd_stream.item++;
+    } else {
+      cmd_stream.sub++;
+    }
+  }
+  return true;
+}
+#endif
+
 #endif
 
 /*
@@ -1733,6 +3208,11 @@ void Canopen::rpdo_callback_wrapper(void *p_object, const CO_RPDO_t *rpdo, const
   return reinterpret_cast<Canopen*>(p_object)->rpdo_callback(rpdo, message);
 }
 
+void Canopen::pdo_publish_cycle_wrapper(void *p_object, bool_t sync_was, uint32_t time_difference_us)
+{
+  reinterpret_cast<Canopen*>(p_object)->pdo_publish_cycle(sync_was);
+}
+
 CO_SDO_abortCode_t Canopen::store_parameters_callback_wrapper(CO_ODF_arg_t *p_odf_arg)
 {
   return reinterpret_cast<Canopen*>(p_odf_arg->object)->store_parameters_callback(p_odf_arg);
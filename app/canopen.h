@@ -18,6 +18,7 @@
 #include "os/freertos/include/FreeRTOS.h"
 #include "os/freertos/include/queue.h"
 #include "os/freertos/include/task.h"
+#include "os/freertos/include/semphr.h"
 #include "os/freertos_cli/FreeRTOS_CLI.h"
 
 #include "interface/nbtyp.h"
@@ -25,14 +26,98 @@
 
 #include "canopen_storage.h"
 #include "canopen_errors.h"
+#include "canopen_od.h"
 
 
+/**
+ * Empfangener RPDO im Ringpuffer der Anwendung, siehe
+ * Canopen::rpdo_take_control()
+ */
+struct rpdo_frame_t {
+  TickType_t timestamp;               /*!< Empfangszeitpunkt */
+  u8 count;                           /*!< Anzahl Datenbytes */
+  u8 data[CO_PDO_MAX_SIZE];           /*!< PDO Daten */
+};
+
+static const u8 pdo_publish_values_max = 64; /*!< max. Anzahl gemappter RPDO Werte */
+static const u16 pdo_publish_data_max = 256; /*!< max. Summe der Gr"o"sen in Bytes */
+
+/**
+ * Gesammelte "Anderungen der RPDO Daten eines Zyklus als Structure of Arrays,
+ * siehe Canopen::pdo_publish_register()
+ *
+ * Wert i hat den Schl"ussel key[i], liegt ab data[offset[i]] und wurde zum
+ * Zeitpunkt changed[i] als ge"andert erkannt. Jeder Wert ist pro Batch
+ * h"ochstens einmal enthalten, mit dem letzten Stand.
+ */
+struct pdo_batch_t {
+  u32 sequence;                               /*!< fortlaufende Nummer des Batch */
+  TickType_t timestamp;                       /*!< Zeitpunkt der "Ubergabe an die Senke */
+  u16 count;                                  /*!< Anzahl Werte */
+  u16 length;                                 /*!< belegte Bytes in data */
+  u32 key[pdo_publish_values_max];            /*!< Index << 16 | Subindex << 8 | L"ange in Bits, wie RPDO Mapping */
+  TickType_t changed[pdo_publish_values_max]; /*!< Zeitpunkt der Erkennung */
+  u16 offset[pdo_publish_values_max];         /*!< Position in data */
+  u8 data[pdo_publish_data_max];              /*!< Werte, little endian wie im OD */
+};
+
+/**
+ * Ver"offentlichungsobjekt f"ur Canopen::pdo_publish_register(). Speicher
+ * wird von der Anwendung bereitgestellt, die Felder sind intern.
+ */
+struct pdo_publish_t {
+  void (*p)(void *param, const pdo_batch_t *p_batch); /*!< Senke */
+  void *param;                                /*!< Pointer f"ur Senke */
+  TickType_t interval;                        /*!< 0: pro SYNC, sonst Ticks */
+  TickType_t last;                            /*!< letzte "Ubergabe */
+  bool operational;                           /*!< NMT Zustand im letzten Zyklus */
+  u16 entries;                                /*!< Anzahl Eintr"age in entry */
+  struct {
+    const u8 *p_od;                           /*!< Wert im OD */
+    u32 key;                                  /*!< wie pdo_batch_t::key */
+    u16 shadow;                               /*!< Position in shadow */
+    u16 slot;                                 /*!< Position im aktuellen Batch, 0xffff wenn nicht enthalten */
+  } entry[pdo_publish_values_max];
+  u8 shadow[pdo_publish_data_max];            /*!< zuletzt erkannter Stand */
+  u32 sequence;                               /*!< Nummer des n"achsten Batch */
+  u32 skipped;                                /*!< nicht erfasste Werte, Kapazit"at zu klein */
+  volatile u8 fill;                           /*!< Batch, der vom RX Thread gef"ullt wird */
+  volatile bool ready;                        /*!< anderer Batch wartet auf die Senke */
+  pdo_batch_t batch[2];
+};
+
+/**
+ * Ansicht auf Daten im Objektverzeichnis ohne Kopie (Zeiger + L"ange)
+ *
+ * Wird von Canopen::od_guard geliefert und ist nur g"ultig, solange dieser
+ * das OD gesperrt h"alt.
+ */
+template <typename T>
+class od_span {
+  public:
+    od_span() = default;
+    od_span(T *p_data, u32 length) : p_data(p_data), length(length) {}
+
+    T *data(void) const { return p_data; }
+    u32 size(void) const { return length; }
+    bool empty(void) const { return length == 0; }
+    bool valid(void) const { return p_data != nullptr; }
+    T *begin(void) const { return p_data; }
+    T *end(void) const { return p_data + length; }
+    T &operator[](u32 i) const { return p_data[i]; }
+
+  private:
+    T *p_data = nullptr;
+    u32 length = 0;
+};
+
 /**
  * Die CANopen Klasse
  */
 class Canopen: public Canopen_errors {
   private:
     CO_NMT_reset_cmd_t reset;         /*!< Resetanforderung */
+    CO_t *p_co = nullptr;             /*!< CANopen Instanz, gesetzt in <co_init()> */
     u8 *const p_active_nid = &OD_CANNodeID; /*!< Eigene CANopen Node ID. Zeigt auf Eintrag im OD. */
     u16 active_bit = 1000;            /*!< Standard Bitrate */
     class Canopen_storage storage;    /*!< OD Parameter */
@@ -40,13 +125,50 @@ class Canopen: public Canopen_errors {
     u32 worker_interval;              /*!< CO Thread Intervall */
     static QueueHandle_t nmt_event_queue; /*!< per <nmt_register()> eingetragene Queue */
     bool once;                        /*!< Flag Erststart */
-    /* PDO in Anwendung f"ur PSE Stack
-     * Einfachste Implementierung, solange nur eine Instanz notwendig ist.
-     * Falls mehrere notwendig sein sollten, Ablage z.B. in library-asotab */
-    void *p_tpdo = nullptr; //Typ CO_TPDO_t
-    TickType_t tpdo_called = 0;
-    void (*p_rpdo)(void *param, const u8* p_data, u8 count);
-    void *p_rpdo_param = nullptr;     /*!< Pointer f"ur Callback */
+    /* PDOs in Anwendung. Eintr"age werden "uber den Index des
+     * communication parameter gefunden, dieser ist auch die ID. Die Tabellen
+     * werden nur unter dem OD Lock ge"andert. */
+    static const u8 pdo_manual_max = 8; /*!< max. Anzahl manueller TPDOs bzw. RPDOs */
+    struct tpdo_manual_t {
+      CO_TPDO_t *p_pdo;               /*!< nullptr, wenn Eintrag frei */
+      TickType_t called;              /*!< Zeitpunkt letzter #tpdo_send() */
+    } tpdo_manual[pdo_manual_max] = {};
+    struct rpdo_manual_t {
+      CO_RPDO_t *volatile p_pdo;      /*!< nullptr, wenn Eintrag frei */
+      void (*p)(void *param, const u8* p_data, u8 count); /*!< Callback */
+      void *param;                    /*!< Pointer f"ur Callback */
+      rpdo_frame_t *p_ring;           /*!< Ringpuffer der Anwendung oder nullptr */
+      u16 ring_size;                  /*!< Anzahl Eintr"age in p_ring */
+      volatile u16 head;              /*!< wird vom RX Thread geschrieben */
+      volatile u16 tail;              /*!< wird vom Konsumenten geschrieben */
+      volatile u32 overflow;          /*!< Anzahl verworfener PDOs, Ringpuffer voll */
+      SemaphoreHandle_t sem;          /*!< signalisiert neue Eintr"age */
+    } rpdo_manual[pdo_manual_max] = {};
+    u32 od_generation = 0;            /*!< wird bei jedem Reset erh"oht, macht #od_handle ung"ultig */
+    /* Domains mit Speicher der Anwendung, siehe <od_domain_register()> */
+    static const u8 od_domain_max = 4; /*!< max. Anzahl registrierter Domains */
+    struct od_domain_t {
+      u16 index;                      /*!< OD Index, 0 wenn Eintrag frei */
+      u8 *p_buffer;                   /*!< Speicher der Anwendung */
+      u32 size;                       /*!< Gr"o"se von p_buffer */
+      u32 length;                     /*!< Anzahl g"ultiger Bytes, gesch"utzt per OD Sperre */
+#ifdef CO_SDO_STREAM_UPLOAD
+      CO_SDO_scatter_t scatter;       /*!< Upload direkt aus p_buffer */
+#endif
+    } od_domain[od_domain_max] = {};
+    /* Terminalausgabe, siehe <cmd_terminal()> */
+    static const u8 cmd_line_max = 128; /*!< max. L"ange einer Ausgabezeile */
+    struct cmd_stream_t {
+      bool (Canopen::*p_line)(void);  /*!< erzeugt n"achste Zeile, nullptr wenn keine Ausgabe l"auft */
+      u16 arg;                        /*!< Argument des Befehls */
+      u16 item;                       /*!< Position, Bedeutung abh. von p_line */
+      u8 sub;                         /*!< Unterposition, Bedeutung abh. von p_line */
+      u32 offset;                     /*!< Byte innerhalb der Unterposition */
+      u8 length;                      /*!< L"ange der Zeile in line */
+      u8 pos;                         /*!< davon bereits ausgegeben */
+      char line[cmd_line_max];        /*!< aktuelle Zeile */
+    } cmd_stream = {};
+    pdo_publish_t *p_publish = nullptr; /*!< siehe <pdo_publish_register()> */
 
     /*1010*/CO_SDO_abortCode_t store_parameters_callback(CO_ODF_arg_t *p_odf_arg);
     /*1011*/CO_SDO_abortCode_t restore_default_parameters_callback(CO_ODF_arg_t *p_odf_arg);
@@ -61,29 +183,65 @@ class Canopen: public Canopen_errors {
     /* Init Helper */
     void od_load_start(void);
     void od_set_defaults(void);
+    void od_load_warm(void);
     void lss_check(u8 *p_pending_nid);
     CO_ReturnError_t co_init(u8 pending_nid);
     void lss_nid_assignment(u8 *p_pending_nid);
-    CO_ReturnError_t co_start(u8 pending_nid, u32 interval);
+    CO_ReturnError_t co_start(u8 pending_nid, u32 interval, bool in_place);
+    void co_stop(void);
+    CO_ReturnError_t reset_comm(u8 nid);
 
     /* Diese Callbacks m"ussen Klassenmethoden sein, da der Stack Callback
      * keinen Pointer f"ur die Instanz zur Verf"ugung stellt. Diese sind daher
      * so aufgebaut das keine Info "uber die Instanz notwendig ist. */
     static void nmt_state_callback(CO_NMT_internalState_t state);
     static CO_SDO_abortCode_t generic_write_callback(CO_ODF_arg_t *p_odf_arg);
+    static CO_SDO_abortCode_t batch_write_callback(CO_ODF_arg_t *p_odf_arg);
+    static CO_SDO_abortCode_t domain_callback(CO_ODF_arg_t *p_odf_arg);
 
     void set_callback(u16 obj_dict_id, CO_SDO_abortCode_t (*pODFunc)(CO_ODF_arg_t *ODF_arg));
 
     void *get_od_pointer(u16 index, u8 subindex, size_t size);
+    od_span<u8> get_od_span(u16 index, u8 subindex);
+    od_domain_t *get_od_domain(u16 index);
+    void mark_od_written(u16 index, u8 subindex);
 
     void daisychain_event_callback(void);
     bool store_lss_config_callback(uint8_t nid, uint16_t bitRate);
     void rpdo_callback(const CO_RPDO_t *rpdo, const CO_CANrxMsg_t *message);
+    CO_ReturnError_t rpdo_register(u16 rpdo_com_param_index, void *param,
+        void (*p)(void *param, const u8* p_data, u8 count),
+        rpdo_frame_t *p_ring, u16 ring_size);
+
+    void pdo_publish_build(void);
+    void pdo_publish_cycle(bool sync_was);
+    void pdo_publish_flush(void);
 
     volatile bool timer_rx_suspend;
     TaskHandle_t timer_rx_handle;
     void timer_rx_thread();
 
+    /* Terminalausgabe, eine Zeile pro Aufruf von p_line */
+    BaseType_t cmd_stream_start(char *pcWriteBuffer, size_t xWriteBufferLen,
+                                bool (Canopen::*p_line)(void), u16 arg);
+    BaseType_t cmd_stream_output(char *pcWriteBuffer, size_t xWriteBufferLen);
+    bool cmd_stream_next(void);
+#ifdef CO_USE_STATISTICS
+    bool cmd_line_statistics(void);
+#endif
+#ifdef CO_OD_PROFILING
+    bool cmd_line_od_profile(void);
+#endif
+#ifdef CO_SDO_TRANSFER_LOG
+    bool cmd_line_sdo_transfers(void);
+#endif
+#ifdef CO_LATENCY_BENCH
+    bool cmd_line_latency(void);
+#endif
+    bool cmd_line_heartbeat(void);
+    bool cmd_line_pdo(void);
+    bool cmd_line_od(void);
+
   public:
 
     /**
@@ -215,6 +373,53 @@ class Canopen: public Canopen_errors {
     void od_set(u16 index, u8 subindex, const char *p_visible_string);
     // weitere CO Standardtypen
 
+    /**
+     * Zugriff auf Eintr"age mit Compile-time Beschreibung (siehe canopen_od.h)
+     *
+     * Direkter Speicherzugriff, die Gr"o"se von T wird zur Compile-time gegen
+     * die OD Variable gepr"uft. Das OD muss mit <od_lock()> gesperrt sein.
+     *
+     * Beispiel: od_get<od::serial_number>(&serial);
+     *
+     * @param [out] p_retval Im OD hinterlegter Wert
+     */
+    template <typename V, typename T>
+    void od_get(T *p_retval)
+    {
+      static_assert(sizeof(T) == sizeof(typename V::type_t), "Typ passt nicht zum OD Eintrag");
+      *p_retval = *V::data();
+    }
+
+    /**
+     * "Andern von Eintr"agen mit Compile-time Beschreibung (siehe canopen_od.h)
+     *
+     * Wie <od_get<>()>, setzt zus"atzlich das COS Flag wie <od_set()>.
+     *
+     * @param val Zu "ubernehmender Wert
+     */
+    template <typename V, typename T>
+    void od_set(T val)
+    {
+      u8 *p_flags;
+
+      static_assert(sizeof(T) == sizeof(typename V::type_t), "Typ passt nicht zum OD Eintrag");
+      *V::data() = val;
+      p_flags = CO_OD_getFlagsPointer(p_co->SDO[0], V::entry(), V::subindex);
+      if (p_flags != NULL) {
+        *p_flags |= CO_ODFL_TPDO_COS_DIRTY;
+      }
+    }
+
+    /**
+     * Compile-time Beschreibung gegen das Objektverzeichnis pr"ufen
+     *
+     * Pr"uft f"ur alle Eintr"age aus CANOPEN_OD_VARIABLES, dass Adresse und
+     * L"ange mit CO_OD.c "ubereinstimmen. Wird in <co_start()> aufgerufen.
+     *
+     * @return true wenn alle Eintr"age passen
+     */
+    bool od_verify(void);
+
     /**
      * Eintragen einer Event Queue
      *
@@ -240,6 +445,301 @@ class Canopen: public Canopen_errors {
       u8 subindex;
     } od_event_t;
 
+    /**
+     * Gesammelte Schreibzugriffe eines OD Index f"ur <od_event()> im
+     * Sammelmodus. Speicher wird von der Anwendung bereitgestellt.
+     */
+    typedef struct {
+      u16 index;                        //!< OD Index, wird von <od_event()> gesetzt
+      QueueHandle_t event_queue;        //!< Queue f"ur Wakeup, wird von <od_event()> gesetzt
+      volatile u32 changed[256 / 32];   //!< ein Bit pro ge"anderten Subindex
+      volatile bool pending;            //!< Wakeup wurde gesendet und noch nicht abgeholt
+    } od_event_batch_t;
+
+    /**
+     * Eintragen einer Event Queue im Sammelmodus
+     *
+     * Schreibzugriffe auf den per <index> eingetragenen OD Eintrag werden
+     * als Bit pro Subindex in <p_batch> gesammelt. Auf die Queue wird nur
+     * ein od_event_t (subindex 0) geschrieben, wenn seit dem letzten
+     * <od_event_fetch()> noch keines gesendet wurde. Es gehen daher auch
+     * bei voller Queue keine "Anderungen verloren.
+     *
+     * Zum Eintragen muss das OD mit <od_lock()> gesperrt sein
+     *
+     * @param index OD Index (z.B. aus CO_OD.h)
+     * @param p_batch Sammelobjekt, muss bis zum n"achsten
+     * RESET_COMMUNICATION g"ultig sein
+     * @param event_queue Queue f"ur den Wakeup
+     */
+    void od_event(u16 index, od_event_batch_t *p_batch, QueueHandle_t event_queue);
+
+    /**
+     * Gesammelte Schreibzugriffe abholen
+     *
+     * Nach dem Aufruf l"ost der n"achste Schreibzugriff wieder ein Wakeup aus.
+     *
+     * @param p_batch Sammelobjekt aus <od_event()>
+     * @param p_changed hierhin werden die ge"anderten Subindizes kopiert,
+     * Bit n in p_changed[n / 32] entspricht Subindex n. Array mit 8 Eintr"agen.
+     * @return Anzahl ge"anderter Subindizes
+     */
+    u16 od_event_fetch(od_event_batch_t *p_batch, u32 *p_changed);
+
+    /**
+     * Beschreibung eines OD Eintrags f"ur <od_snapshot()>/<od_commit()>
+     */
+    typedef struct {
+      u16 index;      //!< OD Index (z.B. aus CO_OD.h)
+      u8 subindex;    //!< OD Subindex (z.B. aus CO_OD.h)
+      u8 size;        //!< Gr"o"se von p_data in Bytes, muss der L"ange im OD entsprechen
+      void *p_data;   //!< Ziel (snapshot) bzw. Quelle (commit)
+    } od_bulk_t;
+
+    /**
+     * Mehrere OD Eintr"age konsistent lesen
+     *
+     * Alle Eintr"age werden zun"achst ohne OD Sperre kopiert (siehe
+     * CO_OD_readBegin()), so dass der RT Task nicht warten muss. Wurde das OD
+     * w"ahrenddessen geschrieben, wird das Kopieren unter OD Sperre wiederholt.
+     * Das OD darf daher nicht per <od_lock()> gesperrt sein.
+     *
+     * @param p_list Liste der zu lesenden Eintr"age. Bei nicht existierenden
+     * Eintr"agen oder falscher Gr"o"se wird p_data mit 0 gef"ullt.
+     * @param count Anzahl Eintr"age in p_list
+     * @return Anzahl erfolgreich gelesener Eintr"age
+     */
+    u16 od_snapshot(const od_bulk_t *p_list, u16 count);
+
+    /**
+     * Mehrere OD Eintr"age konsistent schreiben
+     *
+     * Alle Eintr"age werden innerhalb einer OD Sperre geschrieben. Das OD darf
+     * daher nicht per <od_lock()> gesperrt sein. Anschlie"send wird f"ur jeden
+     * geschriebenen Eintrag mit per <od_event()> eingetragener Queue genau ein
+     * Event ausgel"ost.
+     *
+     * @param p_list Liste der zu schreibenden Eintr"age
+     * @param count Anzahl Eintr"age in p_list
+     * @return Anzahl erfolgreich geschriebener Eintr"age
+     */
+    u16 od_commit(const od_bulk_t *p_list, u16 count);
+
+    /**
+     * Typisierter Zugriff auf einen OD Eintrag
+     *
+     * Index/Subindex werden einmalig per <bind()> aufgel"ost und die Gr"o"se
+     * des Eintrags gegen T gepr"uft. Danach erfolgt der Zugriff ohne Suche im
+     * Objektverzeichnis. Nach RESET_COMMUNICATION wird der Eintrag beim
+     * n"achsten Zugriff automatisch neu aufgel"ost.
+     *
+     * @remark <get()> und <set()> sperren das OD selbst und d"urfen daher
+     * nicht innerhalb von <od_lock()> aufgerufen werden!
+     */
+    template <typename T>
+    class od_handle {
+      public:
+        od_handle() = default;
+        od_handle(Canopen &co, u16 index, u8 subindex)
+        {
+          (void)bind(co, index, subindex);
+        }
+
+        /**
+         * Handle an OD Eintrag binden
+         *
+         * @param co CANopen Instanz
+         * @param index OD Index (z.B. aus CO_OD.h)
+         * @param subindex OD Subindex (z.B. aus CO_OD.h)
+         * @return true wenn Eintrag existiert und Gr"o"se zu T passt
+         */
+        bool bind(Canopen &co, u16 index, u8 subindex)
+        {
+          this->p_co = &co;
+          this->index = index;
+          this->subindex = subindex;
+          return resolve();
+        }
+
+        /**
+         * Wert aus OD lesen
+         *
+         * @param [out] p_retval Im OD hinterlegter Wert, 0 bei Fehler
+         * @return true wenn erfolgreich
+         */
+        bool get(T *p_retval)
+        {
+          bool result;
+          u32 seq;
+          T val;
+
+          /* Ohne Sperre lesen, der RT Task wird nicht aufgehalten. Nur wenn
+           * das OD w"ahrenddessen gesperrt war, mit Sperre wiederholen. */
+          seq = CO_OD_readBegin();
+          result = check();
+          val = (result == true) ? *p_data : T();
+          if (CO_OD_readValid(seq) == false) {
+            CO_LOCK_OD();
+            result = check();
+            val = (result == true) ? *p_data : T();
+            CO_UNLOCK_OD();
+          }
+          *p_retval = val;
+          return result;
+        }
+
+        /**
+         * Wert in OD schreiben
+         *
+         * @param val Zu "ubernehmender Wert
+         * @return true wenn erfolgreich
+         */
+        bool set(T val)
+        {
+          bool result;
+
+          CO_LOCK_OD();
+          result = check();
+          if (result == true) {
+            *p_data = val;
+            p_co->mark_od_written(index, subindex);
+          }
+          CO_UNLOCK_OD();
+          return result;
+        }
+
+      private:
+        Canopen *p_co = nullptr;
+        T *p_data = nullptr;
+        u32 generation = 0;
+        u16 index = 0;
+        u8 subindex = 0;
+
+        bool resolve(void)
+        {
+          if (p_co == nullptr) {
+            return false;
+          }
+          generation = p_co->od_generation;
+          p_data = static_cast<T*>(p_co->get_od_pointer(index, subindex, sizeof(T)));
+          return (p_data != nullptr);
+        }
+
+        bool check(void)
+        {
+          if ((p_co == nullptr) || (generation != p_co->od_generation)) {
+            return resolve();
+          }
+          return (p_data != nullptr);
+        }
+    };
+
+    /**
+     * Speicher der Anwendung f"ur einen Domain Eintrag (Objekttyp VAR)
+     * registrieren
+     *
+     * SDO Upload und Download arbeiten direkt auf p_buffer, mit
+     * CO_SDO_STREAM_UPLOAD wird beim Upload nicht kopiert. Die Anwendung
+     * greift per <od_guard::domain()> ohne Kopie zu. Der Speicher muss
+     * g"ultig bleiben, bis der Eintrag per p_buffer = nullptr wieder
+     * freigegeben wird.
+     *
+     * @remark Das OD darf nicht per <od_lock()> gesperrt sein.
+     *
+     * @param index OD Index des Domain Eintrags
+     * @param p_buffer Speicher der Anwendung, nullptr gibt Eintrag frei
+     * @param size Gr"o"se von p_buffer
+     * @param length Anzahl bereits g"ultiger Bytes in p_buffer
+     * @return CO_ERROR_NO wenn erfolgreich, CO_ERROR_OUT_OF_MEMORY wenn kein
+     * Eintrag mehr frei ist, CO_ERROR_ILLEGAL_ARGUMENT bei length > size
+     */
+    CO_ReturnError_t od_domain_register(u16 index, u8 *p_buffer, u32 size, u32 length = 0);
+
+    /**
+     * Sperrt das OD f"ur die Lebensdauer des Objekts und liefert
+     * Ansichten auf Strings, Octet Strings und Domains ohne Kopie
+     *
+     * Die gelieferten <od_span> sind nur g"ultig, solange der Guard
+     * existiert. Eine ung"ultige Ansicht (<od_span::valid()> == false)
+     * wird geliefert, wenn der Eintrag nicht existiert oder keinen Speicher
+     * im OD hat.
+     *
+     * Beispiel:
+     * @code
+     * {
+     *   Canopen::od_guard guard(canopen);
+     *   od_span<const char> name = guard.visible_string(0x1008, 0);
+     *   log_printf(LOG_INFO, "%.*s", (int)name.size(), name.data());
+     * }
+     * @endcode
+     *
+     * @remark Nicht innerhalb von <od_lock()> verwenden!
+     */
+    class od_guard {
+      public:
+        explicit od_guard(Canopen &co) : co(co)
+        {
+          CO_LOCK_OD();
+        }
+        ~od_guard()
+        {
+          CO_UNLOCK_OD();
+        }
+        od_guard(const od_guard &) = delete;
+        od_guard &operator=(const od_guard &) = delete;
+
+        /**
+         * Visible String lesen
+         *
+         * @return Ansicht bis zum ersten Nullzeichen bzw. auf den ganzen
+         * Eintrag
+         */
+        od_span<const char> visible_string(u16 index, u8 subindex);
+
+        /**
+         * Octet String (oder anderen Eintrag) als Bytes lesen
+         *
+         * @return Ansicht auf den ganzen Eintrag
+         */
+        od_span<const u8> octet_string(u16 index, u8 subindex);
+
+        /**
+         * Octet String (oder anderen Eintrag) als Bytes "andern
+         *
+         * Setzt das COS Flag wie <od_set()>. Die L"ange ist fest.
+         *
+         * @return Ansicht auf den ganzen Eintrag
+         */
+        od_span<u8> octet_string_write(u16 index, u8 subindex);
+
+        /**
+         * Inhalt einer per <od_domain_register()> registrierten Domain lesen
+         *
+         * @return Ansicht auf die g"ultigen Bytes
+         */
+        od_span<const u8> domain(u16 index);
+
+        /**
+         * Domain "andern
+         *
+         * Liefert den ganzen Speicher der Domain. Die neue L"ange wird mit
+         * <domain_commit()> gesetzt, noch innerhalb dieses Guards.
+         *
+         * @return Ansicht auf p_buffer aus <od_domain_register()>
+         */
+        od_span<u8> domain_write(u16 index);
+
+        /**
+         * Neue L"ange einer Domain setzen
+         *
+         * @return false wenn Domain nicht registriert oder length zu gro"s
+         */
+        bool domain_commit(u16 index, u32 length);
+
+      private:
+        Canopen &co;
+    };
+
     /** @}*/
 
     /**
@@ -250,11 +750,12 @@ class Canopen: public Canopen_errors {
     /**
      * Manuelle TPDO Steuerung aktivieren
      *
-     * @remark Mit der aktuellen Implementierung kann nur ein Sender
-     * registriert werden.
+     * @remark Es k"onnen bis zu #pdo_manual_max Sender registriert werden.
      *
-     * @param tpdo_com_param_index Eintrag des zugeh"origen TPDO communication parameter
-     * @return CO_ERROR_NO wenn erfolgreich
+     * @param tpdo_com_param_index Eintrag des zugeh"origen TPDO communication
+     * parameter, dient gleichzeitig als ID
+     * @return CO_ERROR_NO wenn erfolgreich, CO_ERROR_OUT_OF_MEMORY wenn kein
+     * Eintrag mehr frei ist
      */
     CO_ReturnError_t tpdo_take_control(u16 tpdo_com_param_index);
 
@@ -278,11 +779,27 @@ class Canopen: public Canopen_errors {
      */
     CO_ReturnError_t tpdo_send(u16 id);
 
+    /**
+     * TPDO mit Daten der Anwendung direkt versenden
+     *
+     * Die Daten werden ohne OD Zugriff und ohne #od_lock() in den CAN
+     * Sendepuffer kopiert und versendet. Der Aufruf ist aus mehreren Threads
+     * f"ur verschiedene IDs m"oglich.
+     *
+     * @remark Inhibit Time und Event Timer werden ignoriert!
+     *
+     * @param id ID von #tpdo_take_control()
+     * @param p_data PDO Daten
+     * @param count L"ange der Daten, muss der L"ange des Mappings entsprechen
+     * @return CO_ERROR_NO wenn kein Fehler aufgetreten ist
+     */
+    CO_ReturnError_t tpdo_send(u16 id, const u8 *p_data, u8 count);
+
     /**
      * Manuelle RPDO Steuerung aktivieren
      *
-     * @remark Mit der aktuellen Implementierung kann nur ein RPDO Consumer
-     * registriert werden.
+     * @remark Es k"onnen bis zu #pdo_manual_max RPDO Consumer registriert
+     * werden, jeder mit eigenem Callback.
      *
      * @remark Auf die in diesen PDO gemappten OD Eintr"age kann nicht mehr
      * per SDO zugegriffen werden!
@@ -298,6 +815,40 @@ class Canopen: public Canopen_errors {
     CO_ReturnError_t rpdo_take_control(u16 rpdo_com_param_index, void *param,
         void (*p)(void *param, const u8* p_data, u8 count));
 
+    /**
+     * Manuelle RPDO Steuerung mit Ringpuffer aktivieren
+     *
+     * Empfangene PDOs werden ohne OD Zugriff und ohne Callback mit
+     * Zeitstempel in den Ringpuffer der Anwendung kopiert und per
+     * #rpdo_read() abgeholt. Ist der Ringpuffer voll, wird der neue PDO
+     * verworfen.
+     *
+     * @remark Auf die in diesen PDO gemappten OD Eintr"age kann nicht mehr
+     * per SDO zugegriffen werden!
+     *
+     * @param rpdo_com_param_index Eintrag des zugeh"origen RPDO communication
+     * parameter, dient gleichzeitig als ID
+     * @param p_ring Ringpuffer, muss bis #rpdo_release_control() g"ultig sein
+     * @param ring_size Anzahl Eintr"age in p_ring, es werden max.
+     * ring_size - 1 PDOs gepuffert
+     * @return CO_ERROR_NO wenn kein Fehler aufgetreten ist
+     */
+    CO_ReturnError_t rpdo_take_control(u16 rpdo_com_param_index,
+        rpdo_frame_t *p_ring, u16 ring_size);
+
+    /**
+     * RPDO aus Ringpuffer lesen
+     *
+     * @remark Pro ID darf nur ein Thread lesen.
+     *
+     * @param id ID von #rpdo_take_control() mit Ringpuffer
+     * @param p_frame hierhin wird der "alteste PDO kopiert
+     * @param timeout max. Wartezeit in Ticks, 0 f"ur Polling
+     * @return CO_ERROR_NO wenn PDO gelesen, CO_ERROR_TIMEOUT wenn keiner
+     * vorhanden
+     */
+    CO_ReturnError_t rpdo_read(u16 id, rpdo_frame_t *p_frame, TickType_t timeout);
+
     /**
      * Manuelle RPDO Steuerung deaktivieren
      *
@@ -307,6 +858,49 @@ class Canopen: public Canopen_errors {
 
     /** @}*/
 
+    /**
+     * @defgroup PDO Ver"offentlichung empfangener PDO Daten an externe Systeme
+     * @{
+     */
+
+    /**
+     * Ver"offentlichung der RPDO Daten aktivieren
+     *
+     * Im RX Thread werden nach der RPDO Verarbeitung alle in g"ultige RPDOs
+     * gemappten OD Werte mit dem zuletzt gesehenen Stand verglichen.
+     * Ge"anderte Werte werden in einen Batch kopiert. Pro SYNC bzw. pro
+     * Intervall wird der Batch an die Senke "ubergeben, d.h. eine Kopie pro
+     * Zyklus statt einem <od_get()> pro Wert.
+     *
+     * Die Senke wird im Thread von <process()> aufgerufen und darf daher
+     * blockieren (Shared Memory, UDP, Datei). Ist sie beim n"achsten Zyklus
+     * noch nicht fertig, sammelt der RX Thread im selben Batch weiter, es
+     * gehen keine "Anderungen verloren.
+     *
+     * Das Mapping wird bei jedem Wechsel nach NMT OPERATIONAL neu gelesen.
+     * Die Registrierung bleibt "uber RESET_COMMUNICATION erhalten.
+     *
+     * @remark Es kann nur ein Ver"offentlichungsobjekt registriert werden.
+     *
+     * @param p_pub Ver"offentlichungsobjekt, muss bis
+     * <pdo_publish_release()> g"ultig sein
+     * @param interval_ms 0: Batch pro SYNC, sonst Intervall in ms
+     * @param param Dieser Zeiger wird der Senke "ubergeben
+     * @param p() Senke, der Batch ist nur w"ahrend des Aufrufs g"ultig
+     * @return CO_ERROR_NO wenn erfolgreich
+     */
+    CO_ReturnError_t pdo_publish_register(pdo_publish_t *p_pub, u32 interval_ms,
+        void *param, void (*p)(void *param, const pdo_batch_t *p_batch));
+
+    /**
+     * Ver"offentlichung der RPDO Daten deaktivieren
+     *
+     * Nicht aus der Senke heraus aufrufen.
+     */
+    void pdo_publish_release(void);
+
+    /** @}*/
+
     /**
      * @defgroup EMCY Zugriffsfunktionen auf CANopen Emergency Funktionen.
      * @{
@@ -356,6 +950,9 @@ class Canopen: public Canopen_errors {
      * Dieser Vorgang wartet bis eine g"ultige Adresse (1..127) gesetzt wurde.
      * Hierf"ur wird eine Watchdog ID ben"otigt um den WDT korrekt zu triggern.
      *
+     * @remark Nach dem Erststart (Reset Communication) wird das OD nicht neu
+     * aufgebaut, sondern nur der Kommunikationsbereich neu geladen.
+     *
      * @param nid CANopen Node ID. 0 = Node ID per LSS bestimmen.
      * @param interval Abarbeitungsintervall f"ur zeitkritische CANopen Komponenten
      * @return CO_ERROR_NO wenn erfolgreich
@@ -377,6 +974,11 @@ class Canopen: public Canopen_errors {
 
     /**
      * CANopen Terminalbefehl
+     *
+     * Diagnoseausgaben werden zeilenweise erzeugt und in St"ucken von
+     * xWriteBufferLen - 1 Zeichen ausgegeben. Solange pdTRUE zur"uckgegeben
+     * wird, ruft die CLI mit demselben Befehl erneut auf. Die L"ange der
+     * Ausgabe ist damit unabh"angig von der Puffergr"o"se der CLI.
      */
     BaseType_t cmd_terminal( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
 
@@ -388,6 +990,7 @@ class Canopen: public Canopen_errors {
     static void daisychain_event_callback_wrapper(void *p_object);
     static bool_t store_lss_config_callback_wrapper(void *p_object, uint8_t nid, uint16_t bit_rate);
     static void rpdo_callback_wrapper(void *p_object, const CO_RPDO_t *rpdo, const CO_CANrxMsg_t *message);
+    static void pdo_publish_cycle_wrapper(void *p_object, bool_t sync_was, uint32_t time_difference_us);
     static CO_SDO_abortCode_t store_parameters_callback_wrapper(CO_ODF_arg_t *p_odf_arg);
     static CO_SDO_abortCode_t restore_default_parameters_callback_wrapper(CO_ODF_arg_t *p_odf_arg);
     static CO_SDO_abortCode_t cob_id_timestamp_callback_wrapper(CO_ODF_arg_t *p_odf_arg);
@@ -0,0 +1,307 @@
+/**
+* @addtogroup io8000 template
+* @{
+* @addtogroup application
+* @{
+* @file canopen_node.h
+* @copyright Neuberger Gebäudeautomation GmbH
+* @author mwagner
+* @brief Compile-time Konfiguration der CANopen Dienste f"ur kleine Knoten
+*
+* @details \b Programm-Name template
+**/
+#ifndef SRC_CANOPEN_CANOPEN_NODE_H_
+#define SRC_CANOPEN_CANOPEN_NODE_H_
+
+#include "CANopen.h"
+
+#include "interface/nbtyp.h"
+
+/**
+ * Header-only Ersatz f"ur CO_process(), CO_process_SYNC_RPDO() und
+ * CO_process_TPDO()
+ *
+ * Die Knotenkonfiguration ist ein Template Parameter Pack aus Diensten:
+ *
+ *     typedef co::node<co::sdo_servers<1>, co::sync, co::hb_consumer,
+ *                      co::rpdos<2>, co::tpdos<2> > node_t;
+ *     node_t node;
+ *
+ *     node.bind(CO);                    // nach jedem CO_CANopenInit()
+ *     reset = node.process(diff_ms, &timer_next_ms);
+ *     sync_was = node.process_sync_rpdo(diff_us);
+ *     node.process_tpdo(sync_was, diff_us);
+ *
+ * Nicht aufgef"uhrte Dienste werden nicht aufgerufen, ihre Funktionen werden
+ * vom Linker (--gc-sections) entfernt, solange CO_process() & Co. nicht
+ * verwendet werden. PDO und SDO Anzahlen sind Konstanten, die Schleifen
+ * werden vom Compiler aufgel"ost. OD Variablen f"ur EMCY, NMT und SYNC
+ * werden einmalig in bind() aufgel"ost statt bei jedem Aufruf.
+ *
+ * Gedacht f"ur eine einzelne CANopen Instanz mit wenigen PDOs: die aktiven
+ * PDO Listen, Sendebudget, SYNC Buckets und Prestaging aus CANopen.c werden
+ * nicht verwendet, Trace Gruppen werden nicht verarbeitet. Die Empfangs-
+ * Callbacks der CAN Treiber bleiben Funktionszeiger, da sie im C Stack
+ * gesetzt werden.
+ *
+ * Die Anzahlen d"urfen die Werte aus CO_OD.h (CO_NO_*) nicht "uberschreiten,
+ * optionale Dienste m"ussen dort vorhanden sein. Beides wird zur Compile-time
+ * gepr"uft.
+ */
+namespace co {
+
+  /** SYNC Consumer/Producer, ohne werden synchrone RPDOs nie verarbeitet */
+  struct sync {};
+  /** TIME Producer/Consumer, erfordert CO_NO_TIME */
+  struct time {};
+  /** Heartbeat Consumer */
+  struct hb_consumer {};
+  /** NMT Master, erfordert CO_NO_NMT_MASTER */
+  struct nmt_master {};
+  /** Emergency Consumer, erfordert CO_NO_EM_CONS */
+  struct em_consumer {};
+  /** Anzahl verarbeiteter SDO Server, ohne Angabe 1 */
+  template <u16 N> struct sdo_servers {};
+  /** Anzahl verarbeiteter RPDOs, ohne Angabe 0 */
+  template <u16 N> struct rpdos {};
+  /** Anzahl verarbeiteter TPDOs, ohne Angabe 0 */
+  template <u16 N> struct tpdos {};
+
+  namespace detail {
+
+    /* true, wenn T in S enthalten ist */
+    template <typename T, typename... S>
+    struct contains {
+      static constexpr bool value = false;
+    };
+    template <typename T, typename H, typename... S>
+    struct contains<T, H, S...> : contains<T, S...> {};
+    template <typename T, typename... S>
+    struct contains<T, T, S...> {
+      static constexpr bool value = true;
+    };
+
+    /* N aus T<N> in S, D wenn nicht enthalten */
+    template <template <u16> class T, u16 D, typename... S>
+    struct count {
+      static constexpr u16 value = D;
+    };
+    template <template <u16> class T, u16 D, typename H, typename... S>
+    struct count<T, D, H, S...> : count<T, D, S...> {};
+    template <template <u16> class T, u16 D, u16 N, typename... S>
+    struct count<T, D, T<N>, S...> {
+      static constexpr u16 value = N;
+    };
+
+    /* Optionale Dienste aus CO_OD.h, die Funktionen sind nur dann deklariert */
+#if CO_NO_TIME == 1
+    static constexpr bool od_has_time = true;
+#else
+    static constexpr bool od_has_time = false;
+#endif
+#if CO_NO_NMT_MASTER == 1
+    static constexpr bool od_has_nmt_master = true;
+#else
+    static constexpr bool od_has_nmt_master = false;
+#endif
+#if CO_NO_EM_CONS == 1
+    static constexpr bool od_has_em_consumer = true;
+#else
+    static constexpr bool od_has_em_consumer = false;
+#endif
+
+    template <bool enabled>
+    struct time_service {
+      static void process(CO_t *, u16, u16 *) {}
+    };
+#if CO_NO_TIME == 1
+    template <>
+    struct time_service<true> {
+      static void process(CO_t *p_co, u16 diff_ms, u16 *p_timer_next_ms)
+      {
+        CO_TIME_process(p_co->TIME, diff_ms, p_timer_next_ms);
+      }
+    };
+#endif
+
+    template <bool enabled>
+    struct nmt_master_service {
+      static void process(CO_t *, u16 *) {}
+    };
+#if CO_NO_NMT_MASTER == 1
+    template <>
+    struct nmt_master_service<true> {
+      static void process(CO_t *p_co, u16 *p_timer_next_ms)
+      {
+        CO_NMTmaster_process(p_co->NMTmaster, p_timer_next_ms);
+      }
+    };
+#endif
+
+    template <bool enabled>
+    struct em_consumer_service {
+      static void process(CO_t *, u16) {}
+    };
+#if CO_NO_EM_CONS == 1
+    template <>
+    struct em_consumer_service<true> {
+      static void process(CO_t *p_co, u16 diff_ms)
+      {
+        CO_EMconsumer_process(p_co->EMcons, diff_ms);
+      }
+    };
+#endif
+  }
+
+  /**
+   * CANopen Knoten mit zur Compile-time festgelegten Diensten
+   */
+  template <typename... S>
+  class node {
+    public:
+      static constexpr bool has_sync = detail::contains<sync, S...>::value;
+      static constexpr bool has_time = detail::contains<time, S...>::value;
+      static constexpr bool has_hb_consumer = detail::contains<hb_consumer, S...>::value;
+      static constexpr bool has_nmt_master = detail::contains<nmt_master, S...>::value;
+      static constexpr bool has_em_consumer = detail::contains<em_consumer, S...>::value;
+      static constexpr u16 sdo_count = detail::count<sdo_servers, 1, S...>::value;
+      static constexpr u16 rpdo_count = detail::count<rpdos, 0, S...>::value;
+      static constexpr u16 tpdo_count = detail::count<tpdos, 0, S...>::value;
+
+      static_assert((sdo_count >= 1) && (sdo_count <= CO_NO_SDO_SERVER), "Anzahl SDO Server passt nicht zu CO_NO_SDO_SERVER");
+      static_assert(rpdo_count <= CO_NO_RPDO, "Anzahl RPDOs gr\"o\"ser als CO_NO_RPDO");
+      static_assert(tpdo_count <= CO_NO_TPDO, "Anzahl TPDOs gr\"o\"ser als CO_NO_TPDO");
+      static_assert(!has_time || detail::od_has_time, "TIME ist im OD nicht vorhanden (CO_NO_TIME)");
+      static_assert(!has_nmt_master || detail::od_has_nmt_master, "NMT Master ist im OD nicht vorhanden (CO_NO_NMT_MASTER)");
+      static_assert(!has_em_consumer || detail::od_has_em_consumer, "Emergency Consumer ist im OD nicht vorhanden (CO_NO_EM_CONS)");
+
+      /**
+       * CANopen Instanz eintragen und OD Variablen aufl"osen
+       *
+       * Muss nach jedem CO_CANopenInit() aufgerufen werden.
+       *
+       * @param p CANopen Instanz
+       */
+      void bind(CO_t *p)
+      {
+        p_co = p;
+        p_inhibit_time_emcy = static_cast<u16 *>(CO_getODvariable(p, &OD_inhibitTimeEMCY));
+        p_heartbeat_time = static_cast<u16 *>(CO_getODvariable(p, &OD_producerHeartbeatTime));
+        p_nmt_startup = static_cast<u32 *>(CO_getODvariable(p, &OD_NMTStartup));
+        p_error_register = static_cast<u8 *>(CO_getODvariable(p, &OD_errorRegister));
+        p_error_behavior = static_cast<u8 *>(CO_getODvariable(p, &OD_errorBehavior[0]));
+        p_sync_window = static_cast<u32 *>(CO_getODvariable(p, &OD_synchronousWindowLength));
+        ms50 = 0;
+      }
+
+      /**
+       * Ersatz f"ur CO_process()
+       *
+       * @param diff_ms Zeit seit dem letzten Aufruf
+       * @param p_timer_next_ms siehe CO_process(), darf nullptr sein
+       * @return Resetanforderung des NMT
+       */
+      CO_NMT_reset_cmd_t process(u16 diff_ms, u16 *p_timer_next_ms)
+      {
+        bool pre_or_op = (p_co->NMT->operatingState == CO_NMT_PRE_OPERATIONAL) ||
+                         (p_co->NMT->operatingState == CO_NMT_OPERATIONAL);
+        CO_NMT_reset_cmd_t reset;
+
+#ifndef CO_NMT_NO_LEDS
+        ms50 += diff_ms;
+        while (ms50 >= 50) {
+          ms50 -= 50;
+          CO_NMT_blinkingProcess50ms(p_co->NMT);
+        }
+        if ((p_timer_next_ms != nullptr) && (*p_timer_next_ms > 50 - ms50)) {
+          *p_timer_next_ms = 50 - ms50;
+        }
+#endif
+
+        for (u16 i = 0; i < sdo_count; i++) {
+          CO_SDO_process(p_co->SDO[i], pre_or_op, diff_ms, 1000, p_timer_next_ms);
+        }
+        CO_EM_process(p_co->emPr, pre_or_op, diff_ms * 10, *p_inhibit_time_emcy, p_timer_next_ms);
+        reset = CO_NMT_process(p_co->NMT, diff_ms, *p_heartbeat_time, *p_nmt_startup,
+                               *p_error_register, p_error_behavior, p_timer_next_ms);
+        if (has_hb_consumer) {
+          CO_HBconsumer_process(p_co->HBcons, pre_or_op, diff_ms, p_timer_next_ms);
+        }
+        detail::time_service<has_time>::process(p_co, diff_ms, p_timer_next_ms);
+        detail::nmt_master_service<has_nmt_master>::process(p_co, p_timer_next_ms);
+        detail::em_consumer_service<has_em_consumer>::process(p_co, diff_ms);
+
+        return reset;
+      }
+
+      /**
+       * Ersatz f"ur CO_process_SYNC_RPDO()
+       *
+       * @param diff_us Zeit seit dem letzten Aufruf
+       * @return true direkt nach einer SYNC Nachricht
+       */
+      bool process_sync_rpdo(u32 diff_us)
+      {
+        bool sync_was = false;
+
+#ifdef CO_USE_STATISTICS
+        CO_statistics_addTime(diff_us);
+#endif
+        if (has_sync) {
+          switch (CO_SYNC_process(p_co->SYNC, diff_us, *p_sync_window)) {
+            case 1:   /* direkt nach SYNC */
+              sync_was = true;
+              break;
+            case 2:   /* au"serhalb SYNC Fenster */
+              CO_CANclearPendingSyncPDOs(p_co->CANmodule[0]);
+              break;
+          }
+        }
+        for (u16 i = 0; i < rpdo_count; i++) {
+          CO_RPDO_process(p_co->RPDO[i], sync_was);
+        }
+
+        return sync_was;
+      }
+
+      /**
+       * Ersatz f"ur CO_process_TPDO()
+       *
+       * @param sync_was R"uckgabewert von <process_sync_rpdo()>
+       * @param diff_us Zeit seit dem letzten Aufruf
+       */
+      void process_tpdo(bool sync_was, u32 diff_us)
+      {
+        for (u16 i = 0; i < tpdo_count; i++) {
+          CO_TPDO_t *p_tpdo = p_co->TPDO[i];
+          u8 transmission_type = p_tpdo->TPDOCommPar->transmissionType;
+
+          if (CO_TPDO_isManualControl(p_tpdo)) {
+            /* wird von der Anwendung gesendet */
+            continue;
+          }
+          if (p_tpdo->valid && !p_tpdo->sendRequest &&
+              ((transmission_type == 0) || (transmission_type > 240))) {
+            p_tpdo->sendRequest = CO_TPDOisCOS(p_tpdo);
+          }
+          CO_TPDO_process(p_tpdo, p_co->SYNC, sync_was, diff_us);
+        }
+      }
+
+    private:
+      CO_t *p_co = nullptr;             /*!< gesetzt in <bind()> */
+      u16 *p_inhibit_time_emcy = nullptr; /*!< OD 1015 */
+      u16 *p_heartbeat_time = nullptr;  /*!< OD 1017 */
+      u32 *p_nmt_startup = nullptr;     /*!< OD 1F80 */
+      u8 *p_error_register = nullptr;   /*!< OD 1001 */
+      u8 *p_error_behavior = nullptr;   /*!< OD 1029 */
+      u32 *p_sync_window = nullptr;     /*!< OD 1007 */
+      u16 ms50 = 0;                     /*!< Zeit f"ur CO_NMT_blinkingProcess50ms() */
+  };
+}
+
+#endif /* SRC_CANOPEN_CANOPEN_NODE_H_ */
+
+/**
+* @} @}
+**/
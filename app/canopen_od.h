@@ -0,0 +1,66 @@
+/**
+* @addtogroup io8000 template
+* @{
+* @addtogroup application
+* @{
+* @file canopen_od.h
+* @copyright Neuberger Gebäudeautomation GmbH
+* @author mwagner
+* @brief Compile-time Beschreibung von OD Eintr"agen
+*
+* @details \b Programm-Name template
+**/
+#ifndef SRC_CANOPEN_CANOPEN_OD_H_
+#define SRC_CANOPEN_CANOPEN_OD_H_
+
+#include "CANopen.h"
+
+#include "interface/nbtyp.h"
+
+/**
+ * Liste der OD Eintr"age mit Compile-time Beschreibung
+ *
+ * Format: X(Name, Index, Subindex, Variable)
+ *
+ * Typ und Gr"o"se werden aus der Variable in CO_OD.h abgeleitet, die Adresse
+ * ist eine Konstante. Zugriffe per Canopen::od_get<>() / Canopen::od_set<>()
+ * werden damit zu direkten Speicherzugriffen ohne CO_OD_find(). Die
+ * Korrektheit gegen die generierte Tabelle in CO_OD.c wird einmalig zur
+ * Laufzeit per Canopen::od_verify() gepr"uft.
+ *
+ * Neue Eintr"age werden hier nach Muster eingetragen.
+ */
+#define CANOPEN_OD_VARIABLES(X) \
+  X(daisychain_shift_in,  OD_2112_daisyChain,   OD_2112_1_daisyChain_shiftIn,  OD_daisyChain.shiftIn)  \
+  X(daisychain_shift_out, OD_2112_daisyChain,   OD_2112_2_daisyChain_shiftOut, OD_daisyChain.shiftOut) \
+  X(serial_number,        OD_5000_serialNumber, OD_5000_2_serialNumber_serial, OD_serialNumber.serial)
+
+/**
+ * Beschreibung eines OD Eintrags, wird per CANOPEN_OD_VARIABLES erzeugt
+ *
+ * - type_t: Datentyp der Variable
+ * - index, subindex: Adresse im OD
+ * - data(): Zeiger auf die Variable
+ * - entry(): per Canopen::od_verify() aufgel"oste Position in CO_OD, 0xffff
+ *   solange nicht gepr"uft
+ */
+#define CANOPEN_OD_DESCRIBE(name, idx, sub, variable)                       \
+  struct name {                                                              \
+    typedef decltype(variable) type_t;                                       \
+    static constexpr u16 index = (idx);                                      \
+    static constexpr u8 subindex = (sub);                                    \
+    static type_t *data(void) { return &(variable); }                        \
+    static u16 &entry(void) { static u16 e = 0xffff; return e; }             \
+  };
+
+namespace od {
+  CANOPEN_OD_VARIABLES(CANOPEN_OD_DESCRIBE)
+}
+
+#undef CANOPEN_OD_DESCRIBE
+
+#endif /* SRC_CANOPEN_CANOPEN_OD_H_ */
+
+/**
+* @} @}
+**/
@@ -23,11 +23,126 @@
 #include "interface/log.h"
 #include "interface/errors.h"
 
+/* Polynom CRC-32 ISO 3309 in bitumgekehrter Darstellung */
+static const u32 crc32_polynom = 0xedb88320ul;
+
+#ifdef CANOPEN_STORAGE_CRC32_SLICING
+/* Tabellen f"ur slice-by-8, werden beim ersten Aufruf berechnet */
+static u32 crc32_table[8][256];
+static bool crc32_table_valid = false;
+
+static void crc32_table_init(void)
+{
+  u32 crc;
+  u16 i;
+  u8 j;
+
+  for (i = 0; i < 256; i++) {
+    crc = i;
+    for (j = 0; j < 8; j++) {
+      crc = ((crc & 1) != 0) ? ((crc >> 1) ^ crc32_polynom) : (crc >> 1);
+    }
+    crc32_table[0][i] = crc;
+  }
+  for (i = 0; i < 256; i++) {
+    crc = crc32_table[0][i];
+    for (j = 1; j < 8; j++) {
+      crc = crc32_table[0][crc & 0xff] ^ (crc >> 8);
+      crc32_table[j][i] = crc;
+    }
+  }
+  crc32_table_valid = true;
+}
+#endif
+
+/* a * b mod P, Polynome in bitumgekehrter Darstellung */
+static u32 crc32_multiply(u32 a, u32 b)
+{
+  u32 mask;
+  u32 product;
+
+  product = 0;
+  for (mask = 1ul << 31; mask != 0; mask >>= 1) {
+    if ((a & mask) != 0) {
+      product ^= b;
+    }
+    b = ((b & 1) != 0) ? ((b >> 1) ^ crc32_polynom) : (b >> 1);
+  }
+  return product;
+}
+
+u32 Canopen_storage_type::crc32(const u8 *p_data, u16 length)
+{
+#ifdef CANOPEN_STORAGE_CRC32_SLICING
+  u32 crc;
+  u32 low;
+  u32 high;
+
+  if (crc32_table_valid == false) {
+    crc32_table_init();
+  }
+  crc = 0xfffffffful;
+  while (length >= 8) {
+    low = crc ^ (static_cast<u32>(p_data[0]) | (static_cast<u32>(p_data[1]) << 8) |
+                 (static_cast<u32>(p_data[2]) << 16) | (static_cast<u32>(p_data[3]) << 24));
+    high = static_cast<u32>(p_data[4]) | (static_cast<u32>(p_data[5]) << 8) |
+           (static_cast<u32>(p_data[6]) << 16) | (static_cast<u32>(p_data[7]) << 24);
+    crc = crc32_table[7][low & 0xff] ^ crc32_table[6][(low >> 8) & 0xff] ^
+          crc32_table[5][(low >> 16) & 0xff] ^ crc32_table[4][low >> 24] ^
+          crc32_table[3][high & 0xff] ^ crc32_table[2][(high >> 8) & 0xff] ^
+          crc32_table[1][(high >> 16) & 0xff] ^ crc32_table[0][high >> 24];
+    p_data += 8;
+    length -= 8;
+  }
+  while (length > 0) {
+    crc = crc32_table[0][(crc ^ *p_data) & 0xff] ^ (crc >> 8);
+    p_data++;
+    length--;
+  }
+  return crc ^ 0xfffffffful;
+#else
+  return checksum_calculate_crc32(p_data, length,
+                                  CHECKSUM_CRC32_START_0xFFFFFFFF,
+                                  CHECKSUM_CRC32_POLYNOM_ISO3309);
+#endif
+}
+
+u32 Canopen_storage_type::crc32_combine(u32 crc_first, u32 crc_second, u16 length_second)
+{
+  static u32 page_shift = 0;
+  u32 shift;
+  u32 power;
+  u16 n;
+
+  /* CRC des ersten Blocks um length_second Nullbytes weiterschieben, also
+   * mit x^(8 * length_second) mod P multiplizieren. Der Faktor f"ur ganze
+   * Seiten wird nur einmal berechnet. */
+  if ((length_second == page_size) && (page_shift != 0)) {
+    shift = page_shift;
+  } else {
+    shift = 1ul << 31;        /* x^0 */
+    power = 1ul << 23;        /* x^8 */
+    for (n = length_second; n != 0; n >>= 1) {
+      if ((n & 1) != 0) {
+        shift = crc32_multiply(power, shift);
+      }
+      power = crc32_multiply(power, power);
+    }
+    if (length_second == page_size) {
+      page_shift = shift;
+    }
+  }
+  return crc32_multiply(shift, crc_first) ^ crc_second;
+}
+
 CO_ReturnError_t Canopen_storage_type::load(
-    u16 start, u16 reserved, u16 size, u8 *p_work, u8 *p_to)
+    u16 start, u16 reserved, u16 size, u8 *p_work, u8 *p_to, u32 *p_page_crc)
 {
   u32 crc;
+  u32 crc_page;
   u32 crc_read;
+  u16 offset;
+  u16 length;
 
   if (reserved < (size + sizeof(crc_read))) {
     return CO_ERROR_OUT_OF_MEMORY;
@@ -36,10 +151,22 @@ CO_ReturnError_t Canopen_storage_type::load(
   /* Daten lesen. Der CRC ist an das Ende des Datenbereichs angeh"angt  */
   (void)storage.read(start, size + sizeof(crc_read), p_work);
 
-  crc = checksum_calculate_crc32(p_work, size,
-                                 CHECKSUM_CRC32_START_0xFFFFFFFF,
-                                 CHECKSUM_CRC32_POLYNOM_ISO3309);
-  crc_read = *reinterpret_cast<u32*>(p_work + size);
+  /* CRC des Bereichs aus den Seiten-CRCs, die Seitentabelle wird im selben
+   * Durchlauf gef"ullt und entspricht bei Erfolg dem EEPROM Inhalt */
+  crc = 0;
+  for (offset = 0; offset < size; offset += page_size) {
+    length = size - offset;
+    if (length > page_size) {
+      length = page_size;
+    }
+    crc_page = crc32(p_work + offset, length);
+    crc = (offset == 0) ? crc_page : crc32_combine(crc, crc_page, length);
+    if (p_page_crc != NULL) {
+      p_page_crc[offset / page_size] = crc_page;
+    }
+  }
+  (void)memcpy(reinterpret_cast<void*>(&crc_read),
+               reinterpret_cast<const void*>(p_work + size), sizeof(crc_read));
   if (crc != crc_read) {
     return CO_ERROR_CRC;
   }
@@ -50,37 +177,99 @@ CO_ReturnError_t Canopen_storage_type::load(
 }
 
 CO_ReturnError_t Canopen_storage_type::save(
-    u16 start, u16 reserved, u16 size, u8 *p_work, const u8 *p_from)
+    u16 start, u16 reserved, u16 size, u8 *p_work,
+    u32 *p_page_crc, bool *p_page_crc_valid)
 {
+  u8 page[page_size];
   u32 crc_write;
   u32 crc_read;
+  u32 crc_page;
+  u16 offset;
+  u16 length;
+  u64 changed;
+  bool known;
   nvmem_state_t state;
 
-  if (reserved < (size + sizeof(crc_write))) {
+  /* Ge"anderte Seiten werden in einer 64 Bit Maske gesammelt */
+  if ((reserved < (size + sizeof(crc_write))) || (size > (64 * page_size))) {
     return CO_ERROR_OUT_OF_MEMORY;
   }
 
-  crc_write = checksum_calculate_crc32(p_from, size,
-                                       CHECKSUM_CRC32_START_0xFFFFFFFF,
-                                       CHECKSUM_CRC32_POLYNOM_ISO3309);
+  /* Seiten-CRCs der Kopie. Sie ergeben zusammengesetzt den CRC des
+   * Bereichs. Ein abweichender CRC zeigt eine ge"anderte Seite ohne Lesen
+   * des EEPROM. Bei gleichem CRC kann sich die Seite trotzdem ge"andert
+   * haben (Kollision), diese Seiten werden zur"uckgelesen und verglichen. */
+  known = (p_page_crc != NULL) && (*p_page_crc_valid != false);
+  changed = 0;
+  crc_write = 0;
+  for (offset = 0; offset < size; offset += page_size) {
+    length = size - offset;
+    if (length > page_size) {
+      length = page_size;
+    }
+    crc_page = crc32(p_work + offset, length);
+    crc_write = (offset == 0) ? crc_page : crc32_combine(crc_write, crc_page, length);
+    if ((known != false) && (p_page_crc[offset / page_size] != crc_page)) {
+      changed |= 1ull << (offset / page_size);
+    } else {
+      (void)storage.read(start + offset, length, page);
+      if (memcmp(page, p_work + offset, length) != 0) {
+        changed |= 1ull << (offset / page_size);
+      }
+    }
+    if (p_page_crc != NULL) {
+      p_page_crc[offset / page_size] = crc_page;
+    }
+  }
+  (void)memcpy(reinterpret_cast<void*>(p_work + size),
+               reinterpret_cast<const void*>(&crc_write), sizeof(crc_write));
 
-  /* M"ussen wir einen Schreibvorgang ausl"osen? */
-  (void)storage.read(start + size, sizeof(crc_read),
-                     reinterpret_cast<u8*>(&crc_read));
-  if (crc_read == crc_write) {
+  if ((known == false) && (changed == 0)) {
+    /* Daten sind bereits im EEPROM. Fehlt nur der CRC? */
+    (void)storage.read(start + size, sizeof(crc_read),
+                       reinterpret_cast<u8*>(&crc_read));
+    if (crc_read == crc_write) {
+      /* EEPROM enth"alt die Kopie, Seitentabelle ist jetzt g"ultig */
+      if (p_page_crc != NULL) {
+        *p_page_crc_valid = true;
+      }
+      return CO_ERROR_NO;
+    }
+  } else if (changed == 0) {
     return CO_ERROR_NO;
   }
 
-  /* Wir schreiben immer den gesamten Block. Der CRC ist am Ende des Datenblocks
-   * und schaltet die Daten g"ultig. */
-  (void)memcpy(reinterpret_cast<void*>(p_work),
-               reinterpret_cast<const void*>(p_from), size);
-  (void)memcpy(reinterpret_cast<void*>(p_work + size),
-               reinterpret_cast<const void*>(&crc_write), sizeof(crc_write));
-  state = storage.write(start, size + sizeof(crc_write), p_work);
+  /* Nur ge"anderte Seiten schreiben. Der CRC ist am Ende des Datenblocks und
+   * wird zuletzt geschrieben, er schaltet die Daten g"ultig. Eine
+   * Unterbrechung vorher hinterl"asst einen ung"ultigen Block. */
+  for (offset = 0; offset < size; offset += page_size) {
+    length = size - offset;
+    if (length > page_size) {
+      length = page_size;
+    }
+    if ((changed & (1ull << (offset / page_size))) == 0) {
+      continue;
+    }
+
+    state = storage.write(start + offset, length, p_work + offset);
+    if (state != NVMEM_OK) {
+      if (p_page_crc != NULL) {
+        *p_page_crc_valid = false;
+      }
+      return CO_ERROR_DATA_CORRUPT;
+    }
+  }
+
+  state = storage.write(start + size, sizeof(crc_write), p_work + size);
   if (state != NVMEM_OK) {
+    if (p_page_crc != NULL) {
+      *p_page_crc_valid = false;
+    }
     return CO_ERROR_DATA_CORRUPT;
   }
+  if (p_page_crc != NULL) {
+    *p_page_crc_valid = true;
+  }
   return CO_ERROR_NO;
 }
 
@@ -118,6 +307,41 @@ void Canopen_storage::unlock(void)
   (void)xSemaphoreGive(this->in_use);
 }
 
+u16 Canopen_storage::page_offset(storage_type_t type)
+{
+  u16 offset;
+  u8 i;
+
+  offset = 0;
+  for (i = 0; i < type; i++) {
+    offset += this->reserved_size[i] / page_size;
+  }
+  return offset;
+}
+
+void Canopen_storage::save_task_wrapper(void *p)
+{
+  Canopen_storage *p_this = reinterpret_cast<Canopen_storage*>(p);
+
+  p_this->save_thread();
+}
+
+void Canopen_storage::save_thread(void)
+{
+  u32 pending;
+  u8 type;
+
+  for (;;) {
+    /* Jedes Bit entspricht einem angeforderten Speicherbereich */
+    (void)xTaskNotifyWait(0, 0xffffffff, &pending, portMAX_DELAY);
+    for (type = 0; type < TYPE_COUNT; type++) {
+      if ((pending & (1ul << type)) != 0) {
+        (void)save(static_cast<storage_type_t>(type));
+      }
+    }
+  }
+}
+
 CO_ReturnError_t Canopen_storage::load(storage_type_t type)
 {
   CO_ReturnError_t result;
@@ -132,16 +356,19 @@ CO_ReturnError_t Canopen_storage::load(storage_type_t type)
    * "uberschrieben */
   result = Canopen_storage_type::load(this->start[type], this->reserved_size[type],
                                       this->actual_size[type], this->work,
-                                      this->p_ram[type]);
+                                      this->p_ram[type],
+                                      &this->page_crc[page_offset(type)]);
+  this->page_crc_valid[type] = (result == CO_ERROR_NO);
 
   unlock();
 
   return result;
 }
 
-CO_ReturnError_t Canopen_storage::save(storage_type_t type)
+CO_ReturnError_t Canopen_storage::save(storage_type_t type, bool od_locked)
 {
   CO_ReturnError_t result;
+  u32 seq;
 
   if (this->remaining_size < 0) {
     return CO_ERROR_OUT_OF_MEMORY;
@@ -149,15 +376,59 @@ CO_ReturnError_t Canopen_storage::save(storage_type_t type)
 
   lock();
 
+  /* Der Parametersatz kann w"ahrend des Schreibens per SDO ver"andert werden.
+   * Wir arbeiten deshalb mit einer konsistenten Kopie. Aus einer ODF heraus
+   * ist das OD bereits gesperrt, sonst wird ohne OD Sperre kopiert, damit
+   * der RT Task nicht auf den gesamten Parametersatz warten muss. */
+  if (od_locked != false) {
+    (void)memcpy(reinterpret_cast<void*>(this->work),
+                 reinterpret_cast<const void*>(this->p_ram[type]),
+                 this->actual_size[type]);
+  } else {
+    seq = CO_OD_readBegin();
+    (void)memcpy(reinterpret_cast<void*>(this->work),
+                 reinterpret_cast<const void*>(this->p_ram[type]),
+                 this->actual_size[type]);
+    if (CO_OD_readValid(seq) == false) {
+      /* Sperren immer in der Reihenfolge OD, Speicher. Eine ODF h"alt das OD
+       * und wartet auf den Speicher, wir d"urfen nicht umgekehrt warten. */
+      unlock();
+      CO_LOCK_OD();
+      lock();
+      (void)memcpy(reinterpret_cast<void*>(this->work),
+                   reinterpret_cast<const void*>(this->p_ram[type]),
+                   this->actual_size[type]);
+      CO_UNLOCK_OD();
+    }
+  }
+
   result =  Canopen_storage_type::save(this->start[type], this->reserved_size[type],
                                        this->actual_size[type], this->work,
-                                       this->p_ram[type]);
+                                       &this->page_crc[page_offset(type)],
+                                       &this->page_crc_valid[type]);
 
   unlock();
 
   return result;
 }
 
+void Canopen_storage::save_background(storage_type_t type)
+{
+  BaseType_t result;
+
+  if (this->save_task == NULL) {
+    result = xTaskCreate(save_task_wrapper, "CO_storage",
+                         THREAD_STACKSIZE_CANOPEN_STORAGE, this,
+                         THREAD_PRIORITY_CANOPEN_STORAGE, &this->save_task);
+    if (result != pdPASS) {
+      this->save_task = NULL;
+      (void)save(type);
+      return;
+    }
+  }
+  (void)xTaskNotify(this->save_task, 1ul << type, eSetBits);
+}
+
 void Canopen_storage::restore(storage_type_t type)
 {
   if (this->remaining_size < 0) {
@@ -167,6 +438,7 @@ void Canopen_storage::restore(storage_type_t type)
   lock();
 
   Canopen_storage_type::erase(this->start[type], this->reserved_size[type]);
+  this->page_crc_valid[type] = false;
   /* Der eigentliche Restore wird erst beim n"achsten NMT reset comm/app
    * durchgef"uhrt */
 
@@ -21,12 +21,40 @@
 
 #include "os/freertos/include/FreeRTOS.h"
 #include "os/freertos/include/queue.h"
+#include "os/freertos/include/task.h"
+
+#ifndef THREAD_STACKSIZE_CANOPEN_STORAGE
+/** Stackgr"o"se des Speichertasks */
+#define THREAD_STACKSIZE_CANOPEN_STORAGE (configMINIMAL_STACK_SIZE * 2)
+#endif
+#ifndef THREAD_PRIORITY_CANOPEN_STORAGE
+/** Priorit"at des Speichertasks, unterhalb des CANopen Tasks */
+#define THREAD_PRIORITY_CANOPEN_STORAGE (tskIDLE_PRIORITY + 1)
+#endif
+
+/*
+ * Berechnung des CRC-32 (ISO 3309) der Seiten. Standardm"a"sig "uber
+ * checksum_calculate_crc32() des BSP, das die CRC Einheit des Controllers
+ * nutzt. Mit CANOPEN_STORAGE_CRC32_SLICING wird stattdessen slice-by-8
+ * gerechnet, die Tabellen belegen 8 KiB RAM.
+ */
+//#define CANOPEN_STORAGE_CRC32_SLICING
 
 /**
  * Ablage eines CANopen Speicherbereichs
+ *
+ * Jede Seite hat einen eigenen CRC-32. Der CRC-32 des Bereichs wird aus den
+ * Seiten-CRCs zusammengesetzt, die Daten werden daf"ur nicht erneut gelesen.
  */
 class Canopen_storage_type {
   protected:
+    /*
+     * Granularit"at der "Anderungsverfolgung in Bytes. Entspricht der
+     * Seitengr"o"se des EEPROM, ein Schreibvorgang innerhalb einer Seite
+     * kostet gleich viel Zeit wie der einer ganzen Seite.
+     */
+    static const u16 page_size = 32;
+
     /**
      * Parametersatz laden. Falls das Laden fehlschl"agt, wird der Zieldaten-
      * bereich nicht ver"andert.
@@ -36,22 +64,52 @@ class Canopen_storage_type {
      * @param size L"ange des Nutzdatenbereichs in Bytes
      * @param p_work <reserved> Bytes f"ur tempor"are Daten. Mind. <size> + 4
      * @param p_to <size> Bytes f"ur gelesene Daten
+     * @param p_page_crc <reserved> / page_size Eintr"age, wird mit dem CRC
+     * jeder gelesenen Seite gef"ullt und entspricht bei Erfolg dem EEPROM.
+     * Darf NULL sein.
      * @return CO_ERROR_NO wenn OK
      */
-    CO_ReturnError_t load(u16 start, u16 reserved, u16 size, u8 *p_work, u8 *p_to);
+    CO_ReturnError_t load(u16 start, u16 reserved, u16 size, u8 *p_work, u8 *p_to,
+                          u32 *p_page_crc);
 
     /**
      * Parametersatz speichern. Ein Schreibvorgang wird nur ausgel"ost wenn
-     * sich Daten ge"andert haben.
+     * sich Daten ge"andert haben. Mit g"ultiger Seitentabelle werden nur die
+     * ge"anderten Seiten geschrieben. Zur"uckgelesen werden nur Seiten, deren
+     * CRC unver"andert ist.
      *
      * @param start Startadresse im EEPROM
      * @param reserved F"ur diesen Bereich reservierter Speicher in Bytes
      * @param size L"ange des Nutzdatenbereichs in Bytes
-     * @param p_work <reserved> Bytes f"ur tempor"are Daten. Mind. <size> + 4
-     * @param p_from <size> Bytes f"ur gelesene Daten
+     * @param p_work <reserved> Bytes f"ur tempor"are Daten. Mind. <size> + 4,
+     * enth"alt beim Aufruf die zu speichernden <size> Bytes
+     * @param p_page_crc <reserved> / page_size Eintr"age mit dem CRC jeder
+     * Seite im EEPROM, wird nachgef"uhrt. Darf NULL sein.
+     * @param p_page_crc_valid Inhalt von p_page_crc entspricht dem EEPROM,
+     * wird nachgef"uhrt
      * @return CO_ERROR_NO wenn OK
      */
-    CO_ReturnError_t save(u16 start, u16 reserved, u16 size, u8 *p_work, const u8 *p_from);
+    CO_ReturnError_t save(u16 start, u16 reserved, u16 size, u8 *p_work,
+                          u32 *p_page_crc, bool *p_page_crc_valid);
+
+    /**
+     * CRC-32 (ISO 3309) eines Datenblocks
+     *
+     * @param p_data Daten
+     * @param length L"ange in Bytes
+     * @return CRC-32
+     */
+    static u32 crc32(const u8 *p_data, u16 length);
+
+    /**
+     * CRC-32 zweier aufeinanderfolgender Datenbl"ocke aus deren CRC-32
+     *
+     * @param crc_first CRC-32 des ersten Blocks
+     * @param crc_second CRC-32 des zweiten Blocks
+     * @param length_second L"ange des zweiten Blocks in Bytes
+     * @return CRC-32 beider Bl"ocke
+     */
+    static u32 crc32_combine(u32 crc_first, u32 crc_second, u16 length_second);
 
     /**
      * Speicher l"oschen.
@@ -86,13 +144,19 @@ class Canopen_storage : Canopen_storage_type {
     /*
      * F"ur die einzelnen Bereiche reservierter Speicher
      */
+    static const u16 reserved_com = 32;
+    static const u16 reserved_params = 2048;
+    static const u16 reserved_runtime = 128;
+    static const u16 reserved_serial = 64;
+    static const u16 reserved_test = 256;
+    static const u16 reserved_calib = 1024;
     const u16 reserved_size[TYPE_COUNT] = {
-      /* com */     32,
-      /* params */  2048,
-      /* runtime */ 128,
-      /* serial */  64,
-      /* test */    256,
-      /* calib */   1024
+      /* com */     reserved_com,
+      /* params */  reserved_params,
+      /* runtime */ reserved_runtime,
+      /* serial */  reserved_serial,
+      /* test */    reserved_test,
+      /* calib */   reserved_calib
     };
 
     /*
@@ -163,6 +227,23 @@ class Canopen_storage : Canopen_storage_type {
     void lock(void);
     void unlock(void);
 
+    /*
+     * CRC jeder Seite im EEPROM, je Bereich ab page_offset(type). Nur
+     * g"ultig wenn page_crc_valid gesetzt ist. Die Gr"o"se entspricht der
+     * Summe aus reserved_size
+     */
+    u32 page_crc[(reserved_com + reserved_params + reserved_runtime +
+                  reserved_serial + reserved_test + reserved_calib) / page_size];
+    bool page_crc_valid[TYPE_COUNT] = { false };
+    u16 page_offset(storage_type_t type);
+
+    /*
+     * Speichern im Hintergrund
+     */
+    TaskHandle_t save_task = NULL;
+    static void save_task_wrapper(void *p);
+    void save_thread(void);
+
   public:
 
     /**
@@ -179,9 +260,22 @@ class Canopen_storage : Canopen_storage_type {
      * sich Daten ge"andert haben.
      *
      * @param type Zu bearbeitender Speicherbereich
+     * @param od_locked Aufrufer h"alt bereits die OD Sperre (Aufruf aus einer
+     * ODF), die Daten werden dann ohne weitere Sperre kopiert
      * @return CO_ERROR_NO wenn OK
      */
-    CO_ReturnError_t save(storage_type_t type);
+    CO_ReturnError_t save(storage_type_t type, bool od_locked = false);
+
+    /**
+     * Parametersatz im Hintergrund speichern. Der Schreibvorgang erfolgt
+     * durch einen eigenen Task niedriger Priorit"at, der Aufrufer wird nicht
+     * blockiert. Mehrfache Anforderungen vor dem Schreiben werden
+     * zusammengefasst. Kann der Task nicht angelegt werden, wird direkt
+     * gespeichert.
+     *
+     * @param type Zu bearbeitender Speicherbereich
+     */
+    void save_background(storage_type_t type);
 
     /**
      * Parametersatz zur"ucksetzen. Dieses ver"andert die aktuell geladene
@@ -0,0 +1,418 @@
+/*
+ * Loopback CAN driver for host benchmarks.
+ *
+ * @file        CO_driver.c
+ * @ingroup     CO_loopback
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include <string.h>
+
+#include "CO_driver.h"
+#include "CO_Emergency.h"
+#include "CO_tracepoint.h"
+#include "CO_statistics.h"
+#include "CO_loopback.h"
+
+
+/* Message on the virtual bus */
+typedef struct{
+    CO_CANmodule_t     *sender;
+    CO_CANrxMsg_t       msg;
+}CO_loopback_frame_t;
+
+static CO_CANmodule_t *CO_loopback_modules[CO_LOOPBACK_MAX_MODULES];
+static CO_loopback_frame_t CO_loopback_queue[CO_LOOPBACK_QUEUE_SIZE];
+static uint32_t CO_loopback_writePtr = 0U;
+static uint32_t CO_loopback_readPtr = 0U;
+static uint32_t CO_loopback_frames = 0U;
+
+
+/*
+ * Copy message from transmit buffer into the queue. Returns false, if full.
+ */
+static bool_t CO_loopback_queueMessage(CO_CANmodule_t *CANmodule, const CO_CANtx_t *buffer){
+    CO_loopback_frame_t *frame;
+
+    if((CO_loopback_writePtr - CO_loopback_readPtr) >= CO_LOOPBACK_QUEUE_SIZE){
+        return false;
+    }
+    frame = &CO_loopback_queue[CO_loopback_writePtr & (CO_LOOPBACK_QUEUE_SIZE - 1U)];
+    frame->sender = CANmodule;
+    frame->msg.ident = buffer->ident;
+    frame->msg.DLC = buffer->DLC;
+    memcpy(frame->msg.data, buffer->data, sizeof(frame->msg.data));
+    CO_loopback_writePtr++;
+    CO_loopback_frames++;
+    CANmodule->firstCANtxMessage = false;
+
+    return true;
+}
+
+
+/*
+ * Search receive buffer for the message and call its function.
+ */
+static void CO_loopback_receive(CO_CANmodule_t *CANmodule, const CO_CANrxMsg_t *rcvMsg){
+    CO_CANrx_t *buffer = &CANmodule->rxArray[0];
+    uint16_t index;
+
+    for(index = CANmodule->rxSize; index > 0U; index--){
+        if((((uint16_t)rcvMsg->ident ^ buffer->ident) & buffer->mask) == 0U){
+            if(buffer->pFunct != NULL){
+                CO_TP_BEGIN(CO_TP_RX_CALLBACK, buffer - CANmodule->rxArray);
+                CO_STAT_RX(CANmodule, buffer - CANmodule->rxArray);
+                buffer->pFunct(buffer->object, rcvMsg);
+                CO_TP_END(CO_TP_RX_CALLBACK, buffer - CANmodule->rxArray);
+            }
+            break;
+        }
+        buffer++;
+    }
+}
+
+
+/*
+ * Move messages waiting in transmit buffers into the queue.
+ */
+static void CO_loopback_sendPending(CO_CANmodule_t *CANmodule){
+    CO_CANtx_t *buffer = &CANmodule->txArray[0];
+    uint16_t i;
+
+    for(i = CANmodule->txSize; (i > 0U) && (CANmodule->CANtxCount > 0U); i--){
+        if(buffer->bufferFull){
+            if(!CO_loopback_queueMessage(CANmodule, buffer)){
+                break;
+            }
+            buffer->bufferFull = false;
+            CANmodule->CANtxCount--;
+        }
+        buffer++;
+    }
+}
+
+
+/******************************************************************************/
+void CO_CANsetConfigurationMode(int32_t CANbaseAddress){
+    uint16_t i;
+
+    for(i=0U; i<CO_LOOPBACK_MAX_MODULES; i++){
+        if((CO_loopback_modules[i] != NULL) && (CO_loopback_modules[i]->CANbaseAddress == CANbaseAddress)){
+            CO_loopback_modules[i]->CANnormal = false;
+        }
+    }
+}
+
+
+/******************************************************************************/
+void CO_CANsetNormalMode(CO_CANmodule_t *CANmodule){
+    CANmodule->CANnormal = true;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANmodule_init(
+        CO_CANmodule_t         *CANmodule,
+        int32_t                 CANbaseAddress,
+        CO_CANrx_t              rxArray[],
+        uint16_t                rxSize,
+        CO_CANtx_t              txArray[],
+        uint16_t                txSize,
+        uint16_t                CANbitRate)
+{
+    uint16_t i, free = CO_LOOPBACK_MAX_MODULES;
+
+    (void)CANbitRate;
+
+    /* verify arguments */
+    if(CANmodule==NULL || rxArray==NULL || txArray==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* connect to the bus */
+    for(i=0U; i<CO_LOOPBACK_MAX_MODULES; i++){
+        if(CO_loopback_modules[i] == CANmodule){
+            free = i;
+            break;
+        }
+        if((CO_loopback_modules[i] == NULL) && (free == CO_LOOPBACK_MAX_MODULES)){
+            free = i;
+        }
+    }
+    if(free == CO_LOOPBACK_MAX_MODULES){
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+    CO_loopback_modules[free] = CANmodule;
+
+    /* Configure object variables */
+    CANmodule->CANbaseAddress = CANbaseAddress;
+    CANmodule->rxArray = rxArray;
+    CANmodule->rxSize = rxSize;
+    CANmodule->txArray = txArray;
+    CANmodule->txSize = txSize;
+    CANmodule->CANnormal = false;
+    CANmodule->useCANrxFilters = false;
+    CANmodule->bufferInhibitFlag = false;
+    CANmodule->firstCANtxMessage = true;
+    CANmodule->CANtxCount = 0U;
+    CANmodule->errOld = 0U;
+    CANmodule->em = NULL;
+
+    for(i=0U; i<rxSize; i++){
+        rxArray[i].ident = 0U;
+        rxArray[i].mask = 0xFFFFU;
+        rxArray[i].object = NULL;
+        rxArray[i].pFunct = NULL;
+    }
+    for(i=0U; i<txSize; i++){
+        txArray[i].bufferFull = false;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_CANmodule_disable(CO_CANmodule_t *CANmodule){
+    uint16_t i;
+
+    for(i=0U; i<CO_LOOPBACK_MAX_MODULES; i++){
+        if(CO_loopback_modules[i] == CANmodule){
+            CO_loopback_modules[i] = NULL;
+        }
+    }
+    /* drop messages of this module, which are still in the queue */
+    for(i=0U; i<CO_LOOPBACK_QUEUE_SIZE; i++){
+        if(CO_loopback_queue[i].sender == CANmodule){
+            CO_loopback_queue[i].sender = NULL;
+        }
+    }
+}
+
+
+/******************************************************************************/
+uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg){
+    return (uint16_t) rxMsg->ident;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANrxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        uint16_t                ident,
+        uint16_t                mask,
+        bool_t                  rtr,
+        void                   *object,
+        void                  (*pFunct)(void *object, const CO_CANrxMsg_t *message))
+{
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    if((CANmodule!=NULL) && (object!=NULL) && (pFunct!=NULL) && (index < CANmodule->rxSize)){
+        CO_CANrx_t *buffer = &CANmodule->rxArray[index];
+
+        buffer->object = object;
+        buffer->pFunct = pFunct;
+        buffer->ident = ident & 0x07FFU;
+        if(rtr){
+            buffer->ident |= 0x0800U;
+        }
+        buffer->mask = (mask & 0x07FFU) | 0x0800U;
+    }
+    else{
+        ret = CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    return ret;
+}
+
+
+/******************************************************************************/
+CO_CANtx_t *CO_CANtxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        uint16_t                ident,
+        bool_t                  rtr,
+        uint8_t                 noOfBytes,
+        bool_t                  syncFlag)
+{
+    CO_CANtx_t *buffer = NULL;
+
+    if((CANmodule != NULL) && (index < CANmodule->txSize)){
+        buffer = &CANmodule->txArray[index];
+
+        /* CAN identifier and rtr with the same alignment as receive buffers */
+        buffer->ident = ((uint32_t)ident & 0x07FFU) | ((uint32_t)(rtr ? 0x0800U : 0U));
+        buffer->DLC = noOfBytes;
+
+        buffer->bufferFull = false;
+        buffer->syncFlag = syncFlag;
+    }
+
+    return buffer;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
+    CO_ReturnError_t err = CO_ERROR_NO;
+
+    /* Verify overflow */
+    if(buffer->bufferFull){
+        if(!CANmodule->firstCANtxMessage){
+            CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, buffer->ident);
+        }
+        err = CO_ERROR_TX_OVERFLOW;
+    }
+    CO_STAT_TX(CANmodule, buffer - CANmodule->txArray);
+
+    CO_LOCK_CAN_SEND();
+    if((CANmodule->CANtxCount == 0U) && CO_loopback_queueMessage(CANmodule, buffer)){
+        CANmodule->bufferInhibitFlag = buffer->syncFlag;
+    }
+    /* queue is full, message will be sent by CO_loopback_process() */
+    else if(!buffer->bufferFull){
+        buffer->bufferFull = true;
+        CANmodule->CANtxCount++;
+    }
+    CO_UNLOCK_CAN_SEND();
+
+    return err;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANCheckSend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
+    /* keep some space in the queue for other messages */
+    if((CO_loopback_writePtr - CO_loopback_readPtr) >= (CO_LOOPBACK_QUEUE_SIZE / 2U)){
+        return CO_ERROR_TX_BUSY;
+    }
+    return CO_CANsend(CANmodule, buffer);
+}
+
+
+/******************************************************************************/
+void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule){
+    uint32_t tpdoDeleted = 0U;
+
+    CO_LOCK_CAN_SEND();
+    /* messages in the queue are already on the bus, delete only waiting ones */
+    if(CANmodule->CANtxCount != 0U){
+        uint16_t i;
+        CO_CANtx_t *buffer = &CANmodule->txArray[0];
+        for(i = CANmodule->txSize; i > 0U; i--){
+            if(buffer->bufferFull && buffer->syncFlag){
+                buffer->bufferFull = false;
+                CANmodule->CANtxCount--;
+                tpdoDeleted = 2U;
+            }
+            buffer++;
+        }
+    }
+    CO_UNLOCK_CAN_SEND();
+
+    if(tpdoDeleted != 0U){
+        CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_TPDO_OUTSIDE_WINDOW, CO_EMC_COMMUNICATION, tpdoDeleted);
+    }
+}
+
+
+/******************************************************************************/
+void CO_CANverifyErrors(CO_CANmodule_t *CANmodule){
+    /* virtual bus has no errors */
+    (void)CANmodule;
+}
+
+
+/******************************************************************************/
+void CO_CANinterrupt(CO_CANmodule_t *CANmodule){
+    /* messages are delivered by CO_loopback_process() */
+    (void)CANmodule;
+}
+
+
+/******************************************************************************/
+uint32_t CO_loopback_process(void){
+    uint32_t count = 0U;
+    bool_t pending;
+
+    do{
+        uint16_t i;
+
+        while(CO_loopback_readPtr != CO_loopback_writePtr){
+            CO_loopback_frame_t frame = CO_loopback_queue[CO_loopback_readPtr & (CO_LOOPBACK_QUEUE_SIZE - 1U)];
+
+            CO_loopback_readPtr++;
+            if(frame.sender == NULL){
+                continue;
+            }
+            for(i=0U; i<CO_LOOPBACK_MAX_MODULES; i++){
+                CO_CANmodule_t *CANmodule = CO_loopback_modules[i];
+
+                if((CANmodule != NULL) && (CANmodule != frame.sender) && CANmodule->CANnormal &&
+                   (CANmodule->CANbaseAddress == frame.sender->CANbaseAddress)){
+                    CO_loopback_receive(CANmodule, &frame.msg);
+                }
+            }
+            count++;
+        }
+
+        /* the queue is empty now, like a transmit interrupt */
+        pending = false;
+        for(i=0U; i<CO_LOOPBACK_MAX_MODULES; i++){
+            CO_CANmodule_t *CANmodule = CO_loopback_modules[i];
+
+            if((CANmodule != NULL) && (CANmodule->CANtxCount > 0U)){
+                CO_LOCK_CAN_SEND();
+                CO_loopback_sendPending(CANmodule);
+                CO_UNLOCK_CAN_SEND();
+                pending = true;
+            }
+        }
+    }while(pending && (CO_loopback_readPtr != CO_loopback_writePtr));
+
+    return count;
+}
+
+
+/******************************************************************************/
+uint32_t CO_loopback_frameCount(void){
+    return CO_loopback_frames;
+}
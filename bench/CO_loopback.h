@@ -0,0 +1,103 @@
+/**
+ * Loopback CAN bus for host benchmarks.
+ *
+ * @file        CO_loopback.h
+ * @ingroup     CO_loopback
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_loopback_H
+#define CO_loopback_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_loopback Loopback CAN driver
+ * @ingroup CO_driver
+ * @{
+ *
+ * Virtual CAN bus in process memory, implements the drvTemplate driver API.
+ *
+ * All CAN modules initialized with the same CANbaseAddress are connected to
+ * the same virtual bus. CO_CANsend() puts the message into the bus queue,
+ * CO_loopback_process() delivers queued messages to the receive buffers of
+ * all other modules in normal mode. There is no arbitration, no error
+ * counters and no timing, so the stack cost is measured without the bus.
+ */
+
+
+/** Size of the bus queue for all buses, must be power of 2. */
+#ifndef CO_LOOPBACK_QUEUE_SIZE
+#define CO_LOOPBACK_QUEUE_SIZE      256U
+#endif
+
+/** Maximum number of connected CAN modules. */
+#ifndef CO_LOOPBACK_MAX_MODULES
+#define CO_LOOPBACK_MAX_MODULES     8U
+#endif
+
+
+/**
+ * Deliver all queued messages to the receivers.
+ *
+ * Receive callbacks may send new messages, they are delivered in the same
+ * call. Messages, which did not fit into the queue, are queued afterwards.
+ *
+ * @return Number of delivered messages.
+ */
+uint32_t CO_loopback_process(void);
+
+
+/**
+ * Get number of messages transmitted on all buses since start.
+ *
+ * @return Message count.
+ */
+uint32_t CO_loopback_frameCount(void);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
@@ -0,0 +1,597 @@
+/*
+ * Host benchmarks for the CANopenNode stack core.
+ *
+ * @file        bench.c
+ * @ingroup     CO_loopback
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "CANopen.h"
+#include "CO_SDOmaster.h"
+#include "CO_loopback.h"
+
+
+#define BENCH_NODE_ID           10U     /* Node-ID of the device under test */
+#define BENCH_ITERATIONS        2000U   /* Default iterations per benchmark */
+#define BENCH_MAX_STEPS         100000U /* Limit for one transfer */
+#define BENCH_DOMAIN_INDEX      0x2120U /* Domain at subindex 5 in example OD */
+#define BENCH_DOMAIN_SIZE       889U    /* One full SDO block */
+#define BENCH_BLKSIZE           (CO_SDO_BUFFER_SIZE / 7U) /* Segments per block, server buffer */
+#define BENCH_OD_LOOKUPS        1024U   /* CO_OD_find() calls per sample */
+#define BENCH_HB_MAX_NODES      127U
+
+/* CAN buses of the loopback driver, CANbaseAddress */
+#define BENCH_BUS_DEVICE        0
+#define BENCH_BUS_OD            1
+#define BENCH_BUS_HB            2
+
+/* Buffers of the peer node (SDO client, RPDO producer, NMT master) */
+#define PEER_RX_SDO             0U
+#define PEER_RX_TPDO            1U
+#define PEER_RX_SIZE            2U
+#define PEER_TX_SDO             0U
+#define PEER_TX_RPDO            1U
+#define PEER_TX_NMT             2U
+#define PEER_TX_SIZE            3U
+
+
+/* Collected results of one benchmark */
+typedef struct{
+    uint64_t           *samples;        /* Time of each iteration in ns */
+    uint32_t            count;          /* Number of samples */
+    uint32_t            opsPerSample;   /* Operations measured by one sample */
+    uint32_t            frames;         /* CAN messages on the bus */
+    uint64_t            total;          /* Sum of samples in ns */
+}bench_result_t;
+
+/* Domain at 0x2120,5 of the example Object Dictionary */
+typedef struct{
+    uint8_t             data[BENCH_DOMAIN_SIZE];
+    uint32_t            size;
+    uint32_t            pos;
+}bench_domain_t;
+
+
+static FILE            *benchOut;
+static uint32_t         benchIterations = BENCH_ITERATIONS;
+static int              benchArgc;
+static char           **benchArgv;
+static bool_t           benchFailed = false;
+
+static CO_CANmodule_t   peerCAN;
+static CO_CANrx_t       peerRx[PEER_RX_SIZE];
+static CO_CANtx_t       peerTx[PEER_TX_SIZE];
+static CO_SDO_t         peerSDO;
+static CO_SDOclient_t   peerClient;
+static CO_SDOclientPar_t peerClientPar;
+static volatile bool_t  peerTPDOreceived;
+
+static bench_domain_t   benchDomain;
+static volatile uint16_t benchSink;
+
+
+/* Monotonic time in nanoseconds */
+static uint64_t bench_now(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+static int bench_compare(const void *a, const void *b){
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+
+/* Returns true, if benchmark is selected on command line */
+static bool_t bench_selected(const char *name){
+    int i;
+
+    if(benchArgc == 0){
+        return true;
+    }
+    for(i=0; i<benchArgc; i++){
+        if(strncmp(name, benchArgv[i], strlen(benchArgv[i])) == 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+
+static bool_t bench_start(bench_result_t *res, const char *name, uint32_t opsPerSample){
+    if(!bench_selected(name)){
+        return false;
+    }
+    res->samples = (uint64_t *)malloc(benchIterations * sizeof(uint64_t));
+    res->count = 0U;
+    res->opsPerSample = opsPerSample;
+    res->frames = CO_loopback_frameCount();
+    res->total = 0U;
+    if(res->samples == NULL){
+        fprintf(stderr, "%s: out of memory\n", name);
+        return false;
+    }
+    return true;
+}
+
+
+static void bench_sample(bench_result_t *res, uint64_t time){
+    res->samples[res->count++] = time;
+    res->total += time;
+}
+
+
+/*
+ * Print one JSON object per line. Times are per operation in nanoseconds.
+ */
+static void bench_report(bench_result_t *res, const char *name,
+        const char *paramName, uint32_t param, uint32_t abortCode)
+{
+    double ops = (double)res->count * res->opsPerSample;
+    double seconds = (double)res->total / 1e9;
+    double div = (double)res->opsPerSample;
+
+    fprintf(benchOut, "{\"bench\":\"%s\"", name);
+    if(paramName != NULL){
+        fprintf(benchOut, ",\"%s\":%u", paramName, (unsigned)param);
+    }
+    if(res->count < benchIterations){
+        fprintf(benchOut, ",\"error\":\"iteration %u failed\",\"abort_code\":\"0x%08X\"}\n",
+                (unsigned)res->count, (unsigned)abortCode);
+        free(res->samples);
+        benchFailed = true;
+        return;
+    }
+    res->frames = CO_loopback_frameCount() - res->frames;
+    qsort(res->samples, res->count, sizeof(uint64_t), bench_compare);
+    fprintf(benchOut, ",\"iterations\":%u,\"ops\":%.0f,\"frames\":%u"
+            ",\"ops_per_s\":%.0f,\"frames_per_s\":%.0f"
+            ",\"min_ns\":%.1f,\"mean_ns\":%.1f,\"p50_ns\":%.1f,\"p99_ns\":%.1f,\"max_ns\":%.1f}\n",
+            (unsigned)res->count, ops, (unsigned)res->frames,
+            ops / seconds, (double)res->frames / seconds,
+            (double)res->samples[0] / div,
+            (double)res->total / ops,
+            (double)res->samples[res->count / 2U] / div,
+            (double)res->samples[(res->count * 99U) / 100U] / div,
+            (double)res->samples[res->count - 1U] / div);
+    free(res->samples);
+}
+
+
+/* Object dictionary function for the domain 0x2120,5 */
+static CO_SDO_abortCode_t bench_ODF_2120(CO_ODF_arg_t *ODF_arg){
+    bench_domain_t *domain = (bench_domain_t *)ODF_arg->object;
+
+    if(ODF_arg->subIndex != 5U){
+        return CO_SDO_AB_NONE;
+    }
+    if(ODF_arg->firstSegment){
+        domain->pos = 0U;
+    }
+    if(ODF_arg->reading){
+        uint32_t len = domain->size - domain->pos;
+
+        if(len > ODF_arg->dataLength){
+            len = ODF_arg->dataLength;
+        }
+        memcpy(ODF_arg->data, &domain->data[domain->pos], len);
+        ODF_arg->dataLength = (uint16_t)len;
+        ODF_arg->dataLengthTotal = domain->size;
+        domain->pos += len;
+        ODF_arg->lastSegment = (domain->pos == domain->size) ? true : false;
+    }
+    else{
+        if((domain->pos + ODF_arg->dataLength) > sizeof(domain->data)){
+            return CO_SDO_AB_DATA_LONG;
+        }
+        memcpy(&domain->data[domain->pos], ODF_arg->data, ODF_arg->dataLength);
+        domain->pos += ODF_arg->dataLength;
+        if(ODF_arg->lastSegment){
+            domain->size = domain->pos;
+        }
+    }
+    return CO_SDO_AB_NONE;
+}
+
+
+static void peer_receiveTPDO(void *object, const CO_CANrxMsg_t *msg){
+    (void)object;
+    (void)msg;
+    peerTPDOreceived = true;
+}
+
+
+/* Initialize device under test, peer node and start NMT operational */
+static CO_ReturnError_t bench_init(void){
+    CO_ReturnError_t err;
+    CO_CANtx_t *nmt;
+
+    /* TPDO 1 is sent on change of state without inhibit time */
+    OD_TPDOCommunicationParameter[0].inhibitTime = 0U;
+
+    err = CO_init(BENCH_BUS_DEVICE, BENCH_NODE_ID, 125);
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+    CO_OD_configure(CO->SDO[0], BENCH_DOMAIN_INDEX, bench_ODF_2120, (void*)&benchDomain, 0, 0);
+    CO_CANsetNormalMode(CO->CANmodule[0]);
+
+    err = CO_CANmodule_init(&peerCAN, BENCH_BUS_DEVICE, peerRx, PEER_RX_SIZE, peerTx, PEER_TX_SIZE, 125);
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+    /* SDO client must not use local transfer, peer has no Object Dictionary */
+    memset(&peerSDO, 0, sizeof(peerSDO));
+    peerClientPar.maxSubIndex = 3;
+    peerClientPar.COB_IDClientToServer = CO_CAN_ID_RSDO + BENCH_NODE_ID;
+    peerClientPar.COB_IDServerToClient = CO_CAN_ID_TSDO + BENCH_NODE_ID;
+    peerClientPar.nodeIDOfTheSDOServer = BENCH_NODE_ID;
+    err = CO_SDOclient_init(&peerClient, &peerSDO, &peerClientPar, &peerCAN, PEER_RX_SDO, &peerCAN, PEER_TX_SDO);
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+    /* server accepts block upload only up to its buffer size */
+    peerClient.block_size_max = BENCH_BLKSIZE;
+    CO_CANrxBufferInit(&peerCAN, PEER_RX_TPDO, CO_CAN_ID_TPDO_1 + BENCH_NODE_ID, 0x7FF, 0,
+            (void*)&peerCAN, peer_receiveTPDO);
+    CO_CANtxBufferInit(&peerCAN, PEER_TX_RPDO, CO_CAN_ID_RPDO_1 + BENCH_NODE_ID, 0, 2, 0);
+    nmt = CO_CANtxBufferInit(&peerCAN, PEER_TX_NMT, CO_CAN_ID_NMT_SERVICE, 0, 2, 0);
+    CO_CANsetNormalMode(&peerCAN);
+
+    /* bootup message, then start remote node */
+    CO_process(CO, 0, NULL);
+    nmt->data[0] = CO_NMT_ENTER_OPERATIONAL;
+    nmt->data[1] = BENCH_NODE_ID;
+    CO_CANsend(&peerCAN, nmt);
+    CO_loopback_process();
+    CO_process(CO, 0, NULL);
+    CO_loopback_process();
+
+    return (CO->NMT->operatingState == CO_NMT_OPERATIONAL) ? CO_ERROR_NO : CO_ERROR_PARAMETERS;
+}
+
+
+/*
+ * SDO transfer from peer client to the device, repeated benchIterations
+ * times. Each step runs client, bus, device (CO_process()) and bus again.
+ */
+static void bench_sdo(const char *name, bool_t upload, uint16_t index, uint8_t subIndex,
+        uint8_t *data, uint32_t size, uint8_t blockEnable)
+{
+    bench_result_t res;
+    uint32_t abortCode = 0U;
+    uint32_t i;
+
+    if(!bench_start(&res, name, 1U)){
+        return;
+    }
+    if(upload){
+        benchDomain.size = size;
+    }
+    for(i=0U; i<benchIterations; i++){
+        CO_SDOclient_return_t ret;
+        uint32_t steps = 0U;
+        uint32_t dataSize;
+        uint64_t t0 = bench_now();
+
+        if(upload){
+            ret = CO_SDOclientUploadInitiate(&peerClient, index, subIndex, data, size, blockEnable);
+        }
+        else{
+            ret = CO_SDOclientDownloadInitiate(&peerClient, index, subIndex, data, size, blockEnable);
+        }
+        while((ret == CO_SDOcli_ok_communicationEnd) || (ret > 0)){
+            if(upload){
+                ret = CO_SDOclientUpload(&peerClient, 0, 1000, &dataSize, &abortCode);
+            }
+            else{
+                ret = CO_SDOclientDownload(&peerClient, 0, 1000, &abortCode);
+            }
+            /* device also processes the last message of the client */
+            CO_loopback_process();
+            CO_process(CO, 0, NULL);
+            CO_loopback_process();
+            if((ret <= 0) || (++steps > BENCH_MAX_STEPS)){
+                break;
+            }
+        }
+        CO_SDOclientClose(&peerClient);
+        if(ret != CO_SDOcli_ok_communicationEnd){
+            break;
+        }
+        bench_sample(&res, bench_now() - t0);
+    }
+    bench_report(&res, name, "size", size, abortCode);
+}
+
+
+/*
+ * Peer sends RPDO 1 (0x6200), application copies it to 0x6000, device
+ * sends TPDO 1 on change of state, peer receives it.
+ */
+static void bench_pdo(void){
+    const char *name = "pdo_round_trip";
+    bench_result_t res;
+    CO_CANtx_t *rpdo = &peerTx[PEER_TX_RPDO];
+    uint32_t i;
+
+    if(!bench_start(&res, name, 1U)){
+        return;
+    }
+    for(i=0U; i<benchIterations; i++){
+        bool_t syncWas;
+        uint64_t t0 = bench_now();
+
+        peerTPDOreceived = false;
+        /* sequence number, so the change of state is detected each time */
+        rpdo->data[0] = (uint8_t)i;
+        rpdo->data[1] = (uint8_t)(i >> 8);
+        CO_CANsend(&peerCAN, rpdo);
+        CO_loopback_process();
+
+        syncWas = CO_process_SYNC_RPDO(CO, 1000);
+        OD_readInput8Bit[0] = OD_writeOutput8Bit[0];
+        OD_readInput8Bit[1] = OD_writeOutput8Bit[1];
+        CO_process_TPDO(CO, syncWas, 1000);
+        CO_loopback_process();
+
+        if(!peerTPDOreceived){
+            break;
+        }
+        bench_sample(&res, bench_now() - t0);
+    }
+    bench_report(&res, name, NULL, 0, 0);
+}
+
+
+/*
+ * CO_OD_find() in sorted Object Dictionaries of different size.
+ */
+static void bench_odFind(void){
+    static const uint16_t sizes[] = {16, 64, 256, 1024, 4096, 16384};
+    const char *name = "od_find";
+    CO_CANmodule_t CANmodule;
+    CO_CANrx_t rx[1];
+    CO_CANtx_t tx[1];
+    CO_SDO_t SDO;
+    uint16_t lookups[BENCH_OD_LOOKUPS];
+#ifdef CO_OD_FIND_TABLE
+    uint16_t findTable[CO_OD_FIND_TABLE_SIZE];
+#endif
+    uint32_t variable = 0U;
+    uint16_t s;
+
+    if(!bench_selected(name)){
+        return;
+    }
+    CO_CANmodule_init(&CANmodule, BENCH_BUS_OD, rx, 1, tx, 1, 125);
+    for(s=0U; s<(sizeof(sizes)/sizeof(sizes[0])); s++){
+        uint16_t ODSize = sizes[s];
+        CO_OD_entry_t *OD = (CO_OD_entry_t *)calloc(ODSize, sizeof(CO_OD_entry_t));
+#ifdef CO_OD_EXTENSIONS_SPARSE
+        CO_OD_extension_t *ODext = (CO_OD_extension_t *)calloc(CO_OD_EXTENSIONS_SIZE, sizeof(CO_OD_extension_t));
+#else
+        CO_OD_extension_t *ODext = (CO_OD_extension_t *)calloc(ODSize, sizeof(CO_OD_extension_t));
+#endif
+        uint32_t seed = 12345U;
+        bench_result_t res;
+        uint16_t i;
+
+        if((OD == NULL) || (ODext == NULL) || !bench_start(&res, name, BENCH_OD_LOOKUPS)){
+            free(OD);
+            free(ODext);
+            return;
+        }
+        /* spread the entries over the index range like a large device profile */
+        for(i=0U; i<ODSize; i++){
+            OD[i].index = (uint16_t)(0x1000U + ((uint32_t)i * (0xEFFFU - 0x1000U)) / ODSize);
+            OD[i].maxSubIndex = 0U;
+            OD[i].attribute = CO_ODA_MEM_RAM | CO_ODA_READABLE;
+            OD[i].length = 4U;
+            OD[i].pData = &variable;
+        }
+        for(i=0U; i<BENCH_OD_LOOKUPS; i++){
+            seed = seed * 1103515245U + 12345U;
+            lookups[i] = OD[(seed >> 16) % ODSize].index;
+        }
+        CO_SDO_init(&SDO, 0x600, 0x580, 0, NULL, OD, ODSize, ODext, 1, &CANmodule, 0, &CANmodule, 0);
+#ifdef CO_OD_FIND_TABLE
+        CO_SDO_initFindTable(&SDO, findTable);
+#endif
+#ifdef CO_OD_COLUMNS
+        /* only the packed index column is searched */
+        {
+            static uint16_t colIndex[16384], colAttribute[16384], colLength[16384];
+            static uint8_t colMaxSubIndex[16384];
+            static void *colData[16384];
+            static CO_OD_columnMember_t colMembers[1];
+            static CO_OD_columns_t columns;
+
+            CO_OD_columnsBuild(&columns, OD, ODSize, colIndex, colMaxSubIndex, colAttribute,
+                               colLength, colData, colMembers, 1);
+            CO_SDO_initColumns(&SDO, &columns);
+        }
+#endif
+
+        for(res.count=0U; res.count<benchIterations; ){
+            uint16_t sum = 0U;
+            uint64_t t0 = bench_now();
+
+            for(i=0U; i<BENCH_OD_LOOKUPS; i++){
+                sum += CO_OD_find(&SDO, lookups[i]);
+            }
+            bench_sample(&res, bench_now() - t0);
+            benchSink = sum;
+        }
+        bench_report(&res, name, "od_size", ODSize, 0);
+        free(OD);
+        free(ODext);
+    }
+    CO_CANmodule_disable(&CANmodule);
+}
+
+
+/*
+ * Heartbeat consumer with 1 to 127 monitored nodes. One sample is one
+ * heartbeat period: all producers send, consumer receives and processes.
+ */
+static void bench_HBconsumer(void){
+    static const uint8_t nodes[] = {1, 8, 32, 64, 127};
+    const char *name = "hb_consumer";
+    static CO_CANmodule_t consCAN, prodCAN;
+    static CO_CANrx_t consRx[BENCH_HB_MAX_NODES];
+    static CO_CANtx_t prodTx[BENCH_HB_MAX_NODES];
+    static CO_HBconsNode_t monitoredNodes[BENCH_HB_MAX_NODES];
+    static uint32_t HBconsTime[BENCH_HB_MAX_NODES];
+    CO_HBconsumer_t HBcons;
+    uint16_t n;
+
+    if(!bench_selected(name)){
+        return;
+    }
+    for(n=0U; n<(sizeof(nodes)/sizeof(nodes[0])); n++){
+        uint8_t count = nodes[n];
+        bench_result_t res;
+        uint8_t i;
+
+        if(!bench_start(&res, name, 1U)){
+            return;
+        }
+        CO_CANmodule_init(&consCAN, BENCH_BUS_HB, consRx, count, prodTx, 1, 125);
+        CO_CANmodule_init(&prodCAN, BENCH_BUS_HB, consRx, 0, prodTx, count, 125);
+        for(i=0U; i<count; i++){
+            CO_CANtx_t *tx = CO_CANtxBufferInit(&prodCAN, i, CO_CAN_ID_HEARTBEAT + i + 1U, 0, 1, 0);
+
+            tx->data[0] = CO_NMT_OPERATIONAL;
+            HBconsTime[i] = ((uint32_t)(i + 1U) << 16) | 1000U;
+        }
+        CO_HBconsumer_init(&HBcons, CO->em, CO->SDO[0], HBconsTime, monitoredNodes, count, &consCAN, 0);
+        CO_CANsetNormalMode(&consCAN);
+        CO_CANsetNormalMode(&prodCAN);
+
+        for(res.count=0U; res.count<benchIterations; ){
+            uint64_t t0 = bench_now();
+
+            for(i=0U; i<count; i++){
+                CO_CANsend(&prodCAN, &prodTx[i]);
+            }
+            CO_loopback_process();
+            CO_HBconsumer_process(&HBcons, true, 10, NULL);
+            bench_sample(&res, bench_now() - t0);
+        }
+        if(HBcons.allMonitoredOperational != CO_NMT_OPERATIONAL){
+            res.count = 0U;
+        }
+        bench_report(&res, name, "nodes", count, 0);
+        CO_CANmodule_disable(&prodCAN);
+        CO_CANmodule_disable(&consCAN);
+    }
+}
+
+
+/* main ***********************************************************************/
+int main(int argc, char *argv[]){
+    CO_ReturnError_t err;
+    uint8_t expedited[4] = {0xE8, 0x03, 0, 0};
+    uint32_t i;
+    int arg = 1;
+
+    benchOut = stdout;
+    while((arg < argc) && (argv[arg][0] == '-')){
+        if((strcmp(argv[arg], "-n") == 0) && ((arg + 1) < argc)){
+            benchIterations = (uint32_t)strtoul(argv[++arg], NULL, 0);
+        }
+        else if((strcmp(argv[arg], "-o") == 0) && ((arg + 1) < argc)){
+            benchOut = fopen(argv[++arg], "w");
+            if(benchOut == NULL){
+                perror(argv[arg]);
+                return 1;
+            }
+        }
+        else{
+            fprintf(stderr, "Usage: %s [-n iterations] [-o file] [benchmark prefix ...]\n"
+                    "Results are written as one JSON object per line.\n", argv[0]);
+            return 1;
+        }
+        arg++;
+    }
+    if(benchIterations == 0U){
+        benchIterations = 1U;
+    }
+    benchArgc = argc - arg;
+    benchArgv = &argv[arg];
+
+    err = bench_init();
+    if(err != CO_ERROR_NO){
+        fprintf(stderr, "CANopen initialization failed: %d\n", (int)err);
+        return 1;
+    }
+
+    for(i=0U; i<sizeof(benchDomain.data); i++){
+        benchDomain.data[i] = (uint8_t)i;
+    }
+    benchDomain.size = sizeof(benchDomain.data);
+
+    bench_sdo("sdo_expedited_download", false, OD_H1017_PRODUCER_HB_TIME, 0, expedited, 2, 0);
+    bench_sdo("sdo_expedited_upload", true, OD_H1018_IDENTITY_OBJECT, 1, expedited, 4, 0);
+    bench_sdo("sdo_segmented_download", false, BENCH_DOMAIN_INDEX, 5, benchDomain.data, 256, 0);
+    bench_sdo("sdo_segmented_upload", true, BENCH_DOMAIN_INDEX, 5, benchDomain.data, BENCH_DOMAIN_SIZE, 0);
+    bench_sdo("sdo_block_download", false, BENCH_DOMAIN_INDEX, 5, benchDomain.data, BENCH_DOMAIN_SIZE, 1);
+    bench_sdo("sdo_block_upload", true, BENCH_DOMAIN_INDEX, 5, benchDomain.data, BENCH_DOMAIN_SIZE, 1);
+    bench_pdo();
+    bench_odFind();
+    bench_HBconsumer();
+
+    CO_delete(BENCH_BUS_DEVICE);
+    if(benchOut != stdout){
+        fclose(benchOut);
+    }
+
+    return benchFailed ? 1 : 0;
+}
@@ -0,0 +1,23 @@
+/*
+ * Object dictionary of the simulated nodes.
+ *
+ * Example Object dictionary with LSS server, so node IDs are assigned by the
+ * LSS master of the manager. The LSS master itself is compiled with
+ * SIM_MANAGER, see simlss.c.
+ */
+
+
+#ifndef SIM_CO_OD_H
+#define SIM_CO_OD_H
+
+#include "../../example/CO_OD.h"
+
+#undef  CO_NO_LSS_SERVER
+#define CO_NO_LSS_SERVER               1
+
+#ifdef SIM_MANAGER
+#undef  CO_NO_LSS_CLIENT
+#define CO_NO_LSS_CLIENT               1
+#endif
+
+#endif
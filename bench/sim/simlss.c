@@ -0,0 +1,162 @@
+/*
+ * LSS master of the simulated network manager.
+ *
+ * @file        simlss.c
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+/*
+ * The simulated nodes have an LSS server, so the LSS master is not part of
+ * the CANopen objects (CO_NO_LSS_CLIENT is 0 for CANopen.c). This file and
+ * CO_LSSmaster.c are compiled with SIM_MANAGER and must not use CO_t.
+ */
+
+
+#include <string.h>
+
+#include "CANopen.h"
+#include "CO_LSSmaster.h"
+#include "simlss.h"
+
+
+static CO_LSSmaster_t simLSSmaster;
+static CO_LSSmaster_fastscanAssign_t simAssign;
+static CO_LSSmaster_bitRateSwitch_t simSwitch;
+static CO_LSS_address_t simAddresses[127];
+static uint8_t simNodeIds[127];
+
+
+/******************************************************************************/
+int simlss_init(CO_CANmodule_t *CANmodule, uint16_t rxIdx, uint16_t txIdx,
+        uint16_t timeout_ms, uint16_t window_ms)
+{
+    CO_ReturnError_t err;
+
+    err = CO_LSSmaster_init(&simLSSmaster, timeout_ms,
+            CANmodule, rxIdx, CO_CAN_ID_LSS_CLI,
+            CANmodule, txIdx, CO_CAN_ID_LSS_SRV);
+    if(err == CO_ERROR_NO){
+        CO_LSSmaster_changeTimeoutAdaptive(&simLSSmaster, window_ms);
+    }
+    return (int)err;
+}
+
+
+/******************************************************************************/
+void simlss_assignStart(uint32_t vendorID, uint32_t productCode, uint32_t revisionNumber,
+        uint8_t nodeIdFirst, uint8_t nodeIdLast)
+{
+    memset(&simAssign, 0, sizeof(simAssign));
+    simAssign.fastscan.scan[CO_LSS_FASTSCAN_VENDOR_ID] = CO_LSSmaster_FS_MATCH;
+    simAssign.fastscan.match.identity.vendorID = vendorID;
+    simAssign.fastscan.scan[CO_LSS_FASTSCAN_PRODUCT] = CO_LSSmaster_FS_MATCH;
+    simAssign.fastscan.match.identity.productCode = productCode;
+    simAssign.fastscan.scan[CO_LSS_FASTSCAN_REV] = CO_LSSmaster_FS_MATCH;
+    simAssign.fastscan.match.identity.revisionNumber = revisionNumber;
+    simAssign.fastscan.scan[CO_LSS_FASTSCAN_SERIAL] = CO_LSSmaster_FS_SCAN;
+    simAssign.nodeIdFirst = nodeIdFirst;
+    simAssign.nodeIdLast = nodeIdLast;
+    simAssign.store = false;
+    simAssign.addresses = simAddresses;
+}
+
+
+/******************************************************************************/
+int simlss_assign(uint16_t timeDifference_ms, uint8_t *count){
+    CO_LSSmaster_return_t ret;
+
+    ret = CO_LSSmaster_FastscanAssign(&simLSSmaster, timeDifference_ms, &simAssign);
+    *count = simAssign.count;
+
+    if(ret == CO_LSSmaster_WAIT_SLAVE){
+        return SIMLSS_BUSY;
+    }
+    return ((ret == CO_LSSmaster_SCAN_FINISHED) || (ret == CO_LSSmaster_SCAN_NOACK)) ? SIMLSS_DONE : (int)ret;
+}
+
+
+/******************************************************************************/
+uint32_t simlss_requestCount(void){
+    CO_LSSmaster_fsStatistics_t statistics;
+
+    CO_LSSmaster_getFastscanStatistics(&simLSSmaster, false, &statistics);
+    return statistics.requestCount;
+}
+
+
+/******************************************************************************/
+void simlss_bitRateStart(uint16_t bit, uint16_t switchDelay_ms, uint16_t confirmTimeout_ms,
+        void (*pFunctSwitch)(void *object, uint16_t bit))
+{
+    uint8_t i;
+
+    /* nodes configured by simlss_assign() */
+    for(i=0U; i<simAssign.count; i++){
+        simNodeIds[i] = (uint8_t)(simAssign.nodeIdFirst + i);
+    }
+    memset(&simSwitch, 0, sizeof(simSwitch));
+    simSwitch.bit = bit;
+    simSwitch.switchDelay_ms = switchDelay_ms;
+    simSwitch.confirmTimeout_ms = confirmTimeout_ms;
+    simSwitch.addresses = simAddresses;
+    simSwitch.nodeIds = simNodeIds;
+    simSwitch.count = simAssign.count;
+    simSwitch.store = false;
+    simSwitch.pFunctSwitch = pFunctSwitch;
+}
+
+
+/******************************************************************************/
+int simlss_bitRate(uint16_t timeDifference_ms){
+    CO_LSSmaster_return_t ret;
+
+    ret = CO_LSSmaster_SwitchBitRate(&simLSSmaster, timeDifference_ms, &simSwitch);
+
+    if(ret == CO_LSSmaster_WAIT_SLAVE){
+        return SIMLSS_BUSY;
+    }
+    return (ret == CO_LSSmaster_OK) ? SIMLSS_DONE : (int)ret;
+}
+
+
+/******************************************************************************/
+void simlss_heartbeat(uint8_t nodeId){
+    CO_LSSmaster_SwitchBitRateHeartbeat(&simSwitch, nodeId);
+}
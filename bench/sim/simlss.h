@@ -0,0 +1,77 @@
+/*
+ * LSS master of the simulated network manager.
+ *
+ * @file        simlss.h
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef SIMLSS_H
+#define SIMLSS_H
+
+/* Return values of simlss_assign() and simlss_bitRate(), otherwise CO_LSSmaster_return_t */
+#define SIMLSS_BUSY     1
+#define SIMLSS_DONE     0
+
+
+/* LSS master with rx and tx buffer of the manager module */
+int simlss_init(CO_CANmodule_t *CANmodule, uint16_t rxIdx, uint16_t txIdx,
+        uint16_t timeout_ms, uint16_t window_ms);
+
+/* Start assignment of node IDs to all unconfigured nodes by fastscan */
+void simlss_assignStart(uint32_t vendorID, uint32_t productCode, uint32_t revisionNumber,
+        uint8_t nodeIdFirst, uint8_t nodeIdLast);
+
+/* Process assignment, count is the number of configured nodes */
+int simlss_assign(uint16_t timeDifference_ms, uint8_t *count);
+
+/* Number of fastscan requests sent */
+uint32_t simlss_requestCount(void);
+
+/* Start bit rate switch of all assigned nodes, pFunctSwitch switches the manager */
+void simlss_bitRateStart(uint16_t bit, uint16_t switchDelay_ms, uint16_t confirmTimeout_ms,
+        void (*pFunctSwitch)(void *object, uint16_t bit));
+
+/* Process bit rate switch */
+int simlss_bitRate(uint16_t timeDifference_ms);
+
+/* Heartbeat received by the manager */
+void simlss_heartbeat(uint8_t nodeId);
+
+#endif
@@ -0,0 +1,523 @@
+/*
+ * Simulation of a complete CANopen network on one host.
+ *
+ * @file        simnet.c
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+/*
+ * Up to 127 nodes run the real stack as instances from CO_newInstance() on
+ * the simulation driver, all on one simulated bus. The nodes start without
+ * node ID. A manager without Object dictionary (like the peer of bench.c)
+ * assigns node IDs 1 ... n by LSS fastscan, starts all nodes by NMT, reads
+ * the serial number of each node by SDO and then produces SYNC. The nodes
+ * send heartbeats and synchronous TPDO 1, the manager monitors them. With
+ * option -B the manager switches the bit rate of all nodes and of itself by
+ * LSS before SYNC is started.
+ *
+ * Time is simulated in steps of 1 ms, so the result depends only on the
+ * arguments. Different seeds give different serial numbers and therefore
+ * different fastscan sequences; runs with different seeds may be started in
+ * parallel processes.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "CANopen.h"
+#include "CO_SDOmaster.h"
+#include "CO_SDOqueue.h"
+#include "simlss.h"
+
+
+#define SIM_BUS                 0       /* CANbaseAddress */
+#define SIM_TICK_US             1000U   /* Simulation step */
+#define SIM_MAX_NODES           127U
+#define SIM_SDO_CHANNELS        8U      /* SDO clients of the manager */
+#define SIM_SDO_TIMEOUT_MS      500U
+#define SIM_LSS_TIMEOUT_MS      50U
+#define SIM_LSS_WINDOW_MS       2U      /* Minimum adaptive fastscan window */
+#define SIM_SWITCH_DELAY_MS     20U     /* LSS switch delay of bit rate switch */
+#define SIM_VENDOR_ID           0x000003A5UL
+#define SIM_PRODUCT_CODE        0x00010203UL
+#define SIM_REVISION            0x00020000UL
+
+/* Buffers of the manager */
+#define MGR_RX_SDO              0U
+#define MGR_RX_LSS              (MGR_RX_SDO + SIM_SDO_CHANNELS)
+#define MGR_RX_HB               (MGR_RX_LSS + 1U)
+#define MGR_RX_TPDO             (MGR_RX_HB + 1U)
+#define MGR_RX_SIZE             (MGR_RX_TPDO + 1U)
+#define MGR_TX_SDO              0U
+#define MGR_TX_LSS              (MGR_TX_SDO + SIM_SDO_CHANNELS)
+#define MGR_TX_NMT              (MGR_TX_LSS + 1U)
+#define MGR_TX_SYNC             (MGR_TX_NMT + 1U)
+#define MGR_TX_SIZE             (MGR_TX_SYNC + 1U)
+
+/* Phases of the manager */
+typedef enum{
+    SIM_PHASE_LSS,
+    SIM_PHASE_SDO,
+    SIM_PHASE_BITRATE,
+    SIM_PHASE_RUN
+}sim_phase_t;
+
+/* Simulated node */
+typedef struct{
+    CO_t               *CO;
+    uint32_t            serialNumber;
+    uint8_t             nodeId;         /* 0 until assigned by LSS */
+    uint64_t            switchTime_us;  /* bit rate switch, 0 if none pending */
+    uint16_t            switchDelay_ms;
+}sim_node_t;
+
+/* Node as seen by the manager, index is node ID */
+typedef struct{
+    uint8_t             hbState;
+    uint64_t            hbTime_us;
+    uint32_t            tpdoCount;
+    uint32_t            serialNumber;   /* read by SDO */
+    bool_t              sdoOk;
+}sim_remote_t;
+
+
+static uint16_t         simNodeCount = SIM_MAX_NODES;
+static uint32_t         simTime_ms = 300000U;
+static uint16_t         simBitRate = 1000U;
+static uint16_t         simNewBitRate = 0U;
+static uint16_t         simSyncPeriod_ms = 10U;
+static uint16_t         simHBperiod_ms = 100U;
+static uint32_t         simSeed = 1U;
+
+static sim_node_t       simNodes[SIM_MAX_NODES];
+static sim_remote_t     simRemote[SIM_MAX_NODES + 1U];
+
+static CO_CANmodule_t   mgrCAN;
+static CO_CANrx_t       mgrRx[MGR_RX_SIZE];
+static CO_CANtx_t       mgrTx[MGR_TX_SIZE];
+static CO_SDO_t         mgrSDO;
+static CO_SDOclient_t   mgrClient[SIM_SDO_CHANNELS];
+static CO_SDOclientPar_t mgrClientPar[SIM_SDO_CHANNELS];
+static CO_SDOclient_t  *mgrClients[SIM_SDO_CHANNELS];
+static CO_SDOqueueJob_t *mgrActiveJobs[SIM_SDO_CHANNELS];
+static CO_SDOqueue_t    mgrQueue;
+static CO_SDOqueueJob_t mgrJobs[SIM_MAX_NODES];
+static uint8_t          mgrData[SIM_MAX_NODES][4];
+
+
+/* Monotonic time in nanoseconds */
+static uint64_t sim_now(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+static void mgr_receiveHB(void *object, const CO_CANrxMsg_t *msg){
+    uint8_t nodeId = (uint8_t)(msg->ident & 0x7FU);
+
+    (void)object;
+    if((nodeId != 0U) && (nodeId <= SIM_MAX_NODES) && (msg->DLC == 1U)){
+        simRemote[nodeId].hbState = msg->data[0];
+        simRemote[nodeId].hbTime_us = CO_sim_time_us();
+        simlss_heartbeat(nodeId);
+    }
+}
+
+
+/* Switch of the manager, called by LSS master after the first switch delay */
+static void mgr_switchBitRate(void *object, uint16_t bit){
+    (void)object;
+    mgrCAN.CANbitRate = bit;
+}
+
+
+static void mgr_receiveTPDO(void *object, const CO_CANrxMsg_t *msg){
+    uint8_t nodeId = (uint8_t)(msg->ident & 0x7FU);
+
+    (void)object;
+    if((nodeId != 0U) && (nodeId <= SIM_MAX_NODES)){
+        simRemote[nodeId].tpdoCount++;
+    }
+}
+
+
+static void mgr_sdoFinished(CO_SDOqueueJob_t *job, CO_SDOclient_return_t ret,
+        uint32_t abortCode, uint32_t dataSize)
+{
+    sim_remote_t *remote = &simRemote[job->nodeId];
+
+    (void)abortCode;
+    if((ret == CO_SDOcli_ok_communicationEnd) && (dataSize == 4U)){
+        remote->serialNumber = (uint32_t)job->buffer[0] | ((uint32_t)job->buffer[1] << 8)
+                             | ((uint32_t)job->buffer[2] << 16) | ((uint32_t)job->buffer[3] << 24);
+        remote->sdoOk = true;
+    }
+}
+
+
+static CO_ReturnError_t mgr_init(void){
+    CO_ReturnError_t err;
+    uint8_t i;
+
+    err = CO_CANmodule_init(&mgrCAN, SIM_BUS, mgrRx, MGR_RX_SIZE, mgrTx, MGR_TX_SIZE, simBitRate);
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+    /* SDO clients must not use local transfer, manager has no Object Dictionary */
+    memset(&mgrSDO, 0, sizeof(mgrSDO));
+    for(i=0U; i<SIM_SDO_CHANNELS; i++){
+        mgrClientPar[i].maxSubIndex = 3;
+        err = CO_SDOclient_init(&mgrClient[i], &mgrSDO, &mgrClientPar[i],
+                &mgrCAN, MGR_RX_SDO + i, &mgrCAN, MGR_TX_SDO + i);
+        if(err != CO_ERROR_NO){
+            return err;
+        }
+        mgrClients[i] = &mgrClient[i];
+    }
+    err = CO_SDOqueue_init(&mgrQueue, mgrClients, mgrActiveJobs, SIM_SDO_CHANNELS, SIM_SDO_TIMEOUT_MS);
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+    err = (CO_ReturnError_t)simlss_init(&mgrCAN, MGR_RX_LSS, MGR_TX_LSS, SIM_LSS_TIMEOUT_MS, SIM_LSS_WINDOW_MS);
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+    /* heartbeats and TPDO 1 of all nodes */
+    CO_CANrxBufferInit(&mgrCAN, MGR_RX_HB, CO_CAN_ID_HEARTBEAT, 0x780, 0, (void*)&mgrCAN, mgr_receiveHB);
+    CO_CANrxBufferInit(&mgrCAN, MGR_RX_TPDO, CO_CAN_ID_TPDO_1, 0x780, 0, (void*)&mgrCAN, mgr_receiveTPDO);
+    CO_CANtxBufferInit(&mgrCAN, MGR_TX_NMT, CO_CAN_ID_NMT_SERVICE, 0, 2, 0);
+    CO_CANtxBufferInit(&mgrCAN, MGR_TX_SYNC, CO_CAN_ID_SYNC, 0, 0, 0);
+    CO_CANsetNormalMode(&mgrCAN);
+
+    return CO_ERROR_NO;
+}
+
+
+static bool_t node_checkBitRate(void *object, uint16_t bitRate){
+    (void)object;
+    return (bitRate != 0U) ? true : false;
+}
+
+
+static void node_activateBitRate(void *object, uint16_t delay){
+    sim_node_t *node = (sim_node_t *)object;
+
+    node->switchDelay_ms = delay;
+    node->switchTime_us = CO_sim_time_us() + 1000U * (uint64_t)delay;
+}
+
+
+static CO_ReturnError_t node_init(sim_node_t *node, uint32_t serialNumber){
+    CO_ReturnError_t err;
+    OD_identity_t *identity;
+    OD_TPDOCommunicationParameter_t *TPDOcomm;
+
+    err = CO_newInstance(&node->CO);
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+    identity = (OD_identity_t *)CO_getODvariable(node->CO, &OD_identity);
+    identity->vendorID = SIM_VENDOR_ID;
+    identity->productCode = SIM_PRODUCT_CODE;
+    identity->revisionNumber = SIM_REVISION;
+    identity->serialNumber = serialNumber;
+    node->serialNumber = serialNumber;
+    *(uint16_t *)CO_getODvariable(node->CO, &OD_producerHeartbeatTime) = simHBperiod_ms;
+    /* TPDO 1 is sent on each SYNC */
+    TPDOcomm = (OD_TPDOCommunicationParameter_t *)CO_getODvariable(node->CO, &OD_TPDOCommunicationParameter[0]);
+    TPDOcomm->transmissionType = 1U;
+
+    err = CO_CANinitInstance(node->CO, SIM_BUS, simBitRate);
+    if(err == CO_ERROR_NO){
+        err = CO_LSSinitInstance(node->CO, CO_LSS_NODE_ID_ASSIGNMENT, simBitRate);
+    }
+    if(err == CO_ERROR_NO){
+        CO_LSSslave_initCheckBitRateCallback(node->CO->LSSslave, node, node_checkBitRate);
+        CO_LSSslave_initActivateBitRateCallback(node->CO->LSSslave, node, node_activateBitRate);
+        CO_CANsetNormalMode(node->CO->CANmodule[0]);
+    }
+    node->nodeId = 0U;
+    node->switchTime_us = 0U;
+
+    return err;
+}
+
+
+/* One simulation step of the node */
+static void node_process(sim_node_t *node){
+    bool_t syncWas;
+
+    if(node->nodeId == 0U){
+        uint16_t pendingBitRate;
+        uint8_t pendingNodeId;
+
+        /* wait for node ID from LSS master, then start CANopen */
+        CO_LSSslave_process(node->CO->LSSslave, simBitRate, CO_LSS_NODE_ID_ASSIGNMENT,
+                &pendingBitRate, &pendingNodeId);
+        if((pendingNodeId != CO_LSS_NODE_ID_ASSIGNMENT) &&
+           (CO_LSSslave_getState(node->CO->LSSslave) == CO_LSS_STATE_WAITING) &&
+           (CO_CANopenInitInstance(node->CO, pendingNodeId) == CO_ERROR_NO))
+        {
+            node->nodeId = pendingNodeId;
+        }
+        return;
+    }
+
+    /* silent for switch delay before and after the switch */
+    if(node->switchTime_us != 0U){
+        uint64_t now = CO_sim_time_us();
+
+        if((now >= node->switchTime_us) && (node->CO->CANmodule[0]->CANbitRate != node->CO->LSSslave->pendingBitRate)){
+            node->CO->CANmodule[0]->CANbitRate = node->CO->LSSslave->pendingBitRate;
+        }
+        if(now < (node->switchTime_us + 1000U * (uint64_t)node->switchDelay_ms)){
+            return;
+        }
+        node->switchTime_us = 0U;
+    }
+
+    CO_process(node->CO, SIM_TICK_US / 1000U, NULL);
+    syncWas = CO_process_SYNC_RPDO(node->CO, SIM_TICK_US);
+    CO_process_TPDO(node->CO, syncWas, SIM_TICK_US);
+}
+
+
+static void mgr_sendNMT(uint8_t command, uint8_t nodeId){
+    mgrTx[MGR_TX_NMT].data[0] = command;
+    mgrTx[MGR_TX_NMT].data[1] = nodeId;
+    CO_CANsend(&mgrCAN, &mgrTx[MGR_TX_NMT]);
+}
+
+
+static void sim_usage(const char *name){
+    fprintf(stderr, "Usage: %s [options]\n"
+            "  -n nodes     Number of nodes, 1 ... 127 (127)\n"
+            "  -t ms        Simulated time (300000)\n"
+            "  -b kbps      CAN bit rate (1000)\n"
+            "  -B kbps      Switch bit rate by LSS after start, 0 = no switch (0)\n"
+            "  -s ms        SYNC period (10)\n"
+            "  -h ms        Heartbeat period (100)\n"
+            "  -r seed      Seed for serial numbers (1)\n"
+            "Result is written as one JSON object.\n", name);
+}
+
+
+/* main ***********************************************************************/
+int main(int argc, char *argv[]){
+    CO_simStatistics_t statistics;
+    sim_phase_t phase = SIM_PHASE_LSS;
+    uint32_t lssTime_ms = 0U, sdoTime_ms = 0U, switchTime_ms = 0U, runStart_ms = 0U;
+    uint32_t tpdoTotal = 0U, sdoOk = 0U, operational = 0U, serialOk = 0U;
+    uint32_t seed;
+    uint8_t lssCount = 0U;
+    int lssResult = SIMLSS_BUSY;
+    int switchResult = SIMLSS_DONE;
+    uint16_t lssDt = 0U;
+    uint64_t t0, wall;
+    uint32_t t;
+    uint16_t i;
+    bool_t failed;
+    int arg;
+
+    for(arg=1; arg<argc; arg++){
+        unsigned long value;
+
+        if((argv[arg][0] != '-') || (argv[arg][1] == '\0') || (argv[arg][2] != '\0') || ((arg + 1) >= argc)){
+            sim_usage(argv[0]);
+            return 1;
+        }
+        value = strtoul(argv[arg + 1], NULL, 0);
+        switch(argv[arg][1]){
+            case 'n': simNodeCount = (uint16_t)value; break;
+            case 't': simTime_ms = (uint32_t)value; break;
+            case 'b': simBitRate = (uint16_t)value; break;
+            case 'B': simNewBitRate = (uint16_t)value; break;
+            case 's': simSyncPeriod_ms = (uint16_t)value; break;
+            case 'h': simHBperiod_ms = (uint16_t)value; break;
+            case 'r': simSeed = (uint32_t)value; break;
+            default: sim_usage(argv[0]); return 1;
+        }
+        arg++;
+    }
+    if((simNodeCount == 0U) || (simNodeCount > SIM_MAX_NODES) || (simSyncPeriod_ms == 0U)){
+        sim_usage(argv[0]);
+        return 1;
+    }
+
+    if(mgr_init() != CO_ERROR_NO){
+        fprintf(stderr, "Manager initialization failed\n");
+        return 1;
+    }
+    seed = simSeed;
+    for(i=0U; i<simNodeCount; i++){
+        CO_ReturnError_t err;
+
+        seed = seed * 1103515245U + 12345U;
+        err = node_init(&simNodes[i], seed);
+        if(err != CO_ERROR_NO){
+            fprintf(stderr, "Node initialization failed: %d\n", (int)err);
+            return 1;
+        }
+    }
+    simlss_assignStart(SIM_VENDOR_ID, SIM_PRODUCT_CODE, SIM_REVISION, 1U, (uint8_t)simNodeCount);
+
+    t0 = sim_now();
+    for(t=0U; t<simTime_ms; t++){
+        for(i=0U; i<simNodeCount; i++){
+            node_process(&simNodes[i]);
+        }
+
+        switch(phase){
+            case SIM_PHASE_LSS:
+                lssResult = simlss_assign(lssDt, &lssCount);
+                lssDt = SIM_TICK_US / 1000U;
+                if(lssResult != SIMLSS_BUSY){
+                    lssTime_ms = t;
+                    /* start all nodes and read their serial numbers */
+                    mgr_sendNMT(CO_NMT_ENTER_OPERATIONAL, 0U);
+                    for(i=0U; i<lssCount; i++){
+                        CO_SDOqueueJob_t *job = &mgrJobs[i];
+
+                        memset(job, 0, sizeof(*job));
+                        job->nodeId = (uint8_t)(i + 1U);
+                        job->index = OD_H1018_IDENTITY_OBJECT;
+                        job->subIndex = 4U;
+                        job->buffer = mgrData[i];
+                        job->bufferSize = sizeof(mgrData[i]);
+                        job->pFunctSignal = mgr_sdoFinished;
+                    }
+                    CO_SDOqueue_submit(&mgrQueue, mgrJobs, lssCount);
+                    phase = SIM_PHASE_SDO;
+                }
+                break;
+            case SIM_PHASE_SDO:
+                CO_SDOqueue_process(&mgrQueue, SIM_TICK_US / 1000U, NULL);
+                if(!CO_SDOqueue_isBusy(&mgrQueue)){
+                    sdoTime_ms = t - lssTime_ms;
+                    runStart_ms = t;
+                    if(simNewBitRate != 0U){
+                        /* confirm by heartbeats of all nodes */
+                        simlss_bitRateStart(simNewBitRate, SIM_SWITCH_DELAY_MS,
+                                (uint16_t)(3U * SIM_SWITCH_DELAY_MS + 2U * simHBperiod_ms), mgr_switchBitRate);
+                        switchResult = SIMLSS_BUSY;
+                        lssDt = 0U;
+                        phase = SIM_PHASE_BITRATE;
+                    }
+                    else{
+                        phase = SIM_PHASE_RUN;
+                    }
+                }
+                break;
+            case SIM_PHASE_BITRATE:
+                switchResult = simlss_bitRate(lssDt);
+                lssDt = SIM_TICK_US / 1000U;
+                if(switchResult != SIMLSS_BUSY){
+                    switchTime_ms = t - runStart_ms;
+                    runStart_ms = t;
+                    phase = SIM_PHASE_RUN;
+                }
+                break;
+            case SIM_PHASE_RUN:
+                if(((t - runStart_ms) % simSyncPeriod_ms) == 0U){
+                    CO_CANsend(&mgrCAN, &mgrTx[MGR_TX_SYNC]);
+                }
+                break;
+        }
+
+        CO_sim_run(SIM_TICK_US);
+    }
+    wall = sim_now() - t0;
+
+    /* evaluate */
+    for(i=1U; i<=simNodeCount; i++){
+        sim_remote_t *remote = &simRemote[i];
+        uint16_t n;
+
+        tpdoTotal += remote->tpdoCount;
+        if(remote->sdoOk){
+            sdoOk++;
+        }
+        if((remote->hbState == CO_NMT_OPERATIONAL) &&
+           ((CO_sim_time_us() - remote->hbTime_us) <= (2000U * (uint64_t)simHBperiod_ms)))
+        {
+            operational++;
+        }
+        for(n=0U; n<simNodeCount; n++){
+            if((simNodes[n].nodeId == i) && remote->sdoOk &&
+               (simNodes[n].serialNumber == remote->serialNumber))
+            {
+                serialOk++;
+            }
+        }
+    }
+    CO_sim_getStatistics(SIM_BUS, &statistics);
+    failed = ((lssResult != SIMLSS_DONE) || (lssCount != simNodeCount) || (phase != SIM_PHASE_RUN) ||
+              (switchResult != SIMLSS_DONE) ||
+              (serialOk != simNodeCount) || ((simHBperiod_ms != 0U) && (operational != simNodeCount)))
+           ? true : false;
+
+    printf("{\"sim\":\"network\",\"nodes\":%u,\"bitrate_kbps\":%u,\"seed\":%u"
+           ",\"sim_ms\":%u,\"wall_ms\":%.1f,\"speedup\":%.1f"
+           ",\"frames\":%u,\"bus_load\":%.3f,\"max_latency_us\":%.1f"
+           ",\"lss_assigned\":%u,\"lss_requests\":%u,\"lss_ms\":%u"
+           ",\"sdo_ok\":%u,\"serial_ok\":%u,\"sdo_ms\":%u"
+           ",\"switch_kbps\":%u,\"switch_ms\":%u"
+           ",\"tpdo_received\":%u,\"operational\":%u,\"result\":\"%s\"}\n",
+           (unsigned)simNodeCount, (unsigned)simBitRate, (unsigned)simSeed,
+           (unsigned)simTime_ms, (double)wall / 1e6, (double)simTime_ms * 1e6 / (double)wall,
+           (unsigned)statistics.frames, (double)statistics.busyTime_ns / ((double)simTime_ms * 1e6),
+           (double)statistics.maxLatency_ns / 1e3,
+           (unsigned)lssCount, (unsigned)simlss_requestCount(), (unsigned)lssTime_ms,
+           (unsigned)sdoOk, (unsigned)serialOk, (unsigned)sdoTime_ms,
+           (unsigned)mgrCAN.CANbitRate, (unsigned)switchTime_ms,
+           (unsigned)tpdoTotal, (unsigned)operational, failed ? "fail" : "ok");
+
+    for(i=0U; i<simNodeCount; i++){
+        CO_deleteInstance(simNodes[i].CO, SIM_BUS);
+    }
+    CO_CANmodule_disable(&mgrCAN);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,813 @@
+/*
+ * Load generator for the neuberger-socketCAN driver on vcan interfaces.
+ *
+ * @file        loadgen.c
+ * @ingroup     CO_driver
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+/*
+ * Simulated CANopen nodes run the real stack, each one in its own process
+ * (CANopen.c has one global CO object), so every node has its own socket and
+ * rx thread like a real device. Node n is connected to interface
+ * (n - 1) % interfaces. TPDOs of the nodes are synchronous (transmission type
+ * 1), RPDOs are asynchronous.
+ *
+ * The gateway under test is one CO_CANmodule_t with all interfaces added. It
+ * produces SYNC, sends RPDOs to the nodes, reads objects by SDO and counts
+ * received TPDOs. It uses the driver directly, so it can have receive buffers
+ * for all nodes.
+ */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+
+#include "CANopen.h"
+#include "CO_SDOmaster.h"
+#include "CO_Linux_threads.h"
+
+#ifndef CO_DRIVER_MULTI_INTERFACE
+#error Load generator requires CO_DRIVER_MULTI_INTERFACE
+#endif
+
+#define LOADGEN_MAX_NODES       127U
+#define LOADGEN_MAX_INTERFACES  16U
+#define LOADGEN_MAX_PDO         4U      /* PDOs of the example OD */
+#define LOADGEN_MAX_SDO_CHANNELS 16U
+#define LOADGEN_SDO_TIMEOUT_MS  500U
+#define LOADGEN_STARTUP_MS      5000U   /* Wait for heartbeats of all nodes */
+#define LOADGEN_DRAIN_MS        200U    /* Wait for TPDOs of the last SYNC */
+#define LOADGEN_NODE_MAIN_MS    50U     /* Max. sleep of node mainline thread */
+
+/* Uploaded objects, available in every node of the example OD */
+#define LOADGEN_SDO_EXPEDITED_INDEX 0x1018U /* Vendor-ID, 4 bytes */
+#define LOADGEN_SDO_EXPEDITED_SUB   1U
+#define LOADGEN_SDO_SEGMENTED_INDEX 0x1008U /* Device name, 11 bytes */
+#define LOADGEN_SDO_SEGMENTED_SUB   0U
+
+
+/* Configuration from command line */
+typedef struct{
+    int32_t             ifIndex[LOADGEN_MAX_INTERFACES];
+    const char         *ifName[LOADGEN_MAX_INTERFACES];
+    uint32_t            ifCount;
+    uint32_t            nodes;
+    uint32_t            tpdos;          /* TPDOs per node */
+    uint32_t            rpdos;          /* RPDOs per node */
+    uint32_t            syncPeriod_us;
+    uint32_t            sdoExpedited;   /* Expedited uploads per SYNC */
+    uint32_t            sdoSegmented;   /* Segmented uploads per SYNC */
+    uint32_t            sdoChannels;
+    uint32_t            duration_s;
+    uint32_t            socketBufferMax; /* Gateway socket buffer tuning limit */
+    bool_t              rxThreadPerInterface;
+    bool_t              verbose;
+}loadgen_config_t;
+
+/* Counters of one node process, in shared memory */
+typedef struct{
+    volatile int32_t    error;          /* CO_ReturnError_t of initialization */
+    volatile uint32_t   rxDropCount;
+    volatile uint32_t   txOverflowCount;
+}loadgen_nodeStats_t;
+
+/* Gateway view of one node */
+typedef struct{
+    volatile uint32_t   tpdoCount;      /* Received TPDOs */
+    volatile uint8_t    nmtState;       /* From last heartbeat */
+    volatile uint32_t   hbCount;
+    pid_t               pid;
+    int32_t             ifIndex;
+}loadgen_node_t;
+
+/* SDO client of the gateway. Channel c serves nodes with (nodeId - 1) % channels
+ * == c, so receive COB-IDs of the channels are never duplicated. */
+typedef struct{
+    CO_SDOclient_t      client;
+    CO_SDOclientPar_t   par;
+    bool_t              busy;
+    uint16_t            time_ms;        /* Time since start of transfer */
+    uint8_t             buffer[16];
+}loadgen_sdo_t;
+
+/* Gateway rx thread */
+typedef struct{
+    pthread_t           thread;
+    CO_CANrxThread_t   *rxThread;       /* NULL for the default rx thread */
+    CO_CANrxThread_t    object;
+}loadgen_rxThread_t;
+
+
+static loadgen_config_t lgConfig = {
+    .ifCount = 0U,
+    .nodes = 8U,
+    .tpdos = 2U,
+    .rpdos = 0U,
+    .syncPeriod_us = 1000U,
+    .sdoExpedited = 0U,
+    .sdoSegmented = 0U,
+    .sdoChannels = 4U,
+    .duration_s = 10U,
+    .socketBufferMax = 0U,
+    .rxThreadPerInterface = false,
+    .verbose = false
+};
+
+static volatile sig_atomic_t lgRunning = 1;
+static loadgen_nodeStats_t *lgNodeStats;
+static loadgen_node_t   lgNodes[LOADGEN_MAX_NODES + 1U];
+
+static CO_CANmodule_t   lgCAN;
+static CO_CANrx_t      *lgRx;
+static CO_CANtx_t      *lgTx;
+static CO_CANtx_t      *lgSyncTx;
+static CO_CANtx_t     **lgRpdoTx;
+static CO_SDO_t         lgSDO;          /* Dummy, there is no local SDO server */
+static loadgen_sdo_t    lgSdo[LOADGEN_MAX_SDO_CHANNELS];
+static loadgen_rxThread_t lgRxThreads[LOADGEN_MAX_INTERFACES];
+static uint32_t         lgRxThreadCount;
+
+/* Results */
+static uint32_t         lgSyncSent;
+static uint32_t         lgSyncLate;     /* Timer intervals without SYNC */
+static uint32_t         lgTxErrors;     /* CO_CANsend() returned error */
+static uint32_t         lgSdoOk;
+static uint32_t         lgSdoFailed;
+static uint32_t         lgSdoSkipped;   /* Channel was still busy */
+
+
+static uint64_t loadgen_now_us(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000U;
+}
+
+
+static void loadgen_signal(int sig){
+    (void)sig;
+    lgRunning = 0;
+}
+
+
+/******************************************************************************/
+/* Simulated node                                                             */
+/******************************************************************************/
+static void *loadgen_nodeRT(void *arg){
+    (void)arg;
+    while(lgRunning){
+        CANrx_threadTmr_process();
+    }
+    return NULL;
+}
+
+
+/* Set PDOs of the example OD before CO_init() */
+static void loadgen_nodeConfigure(void){
+    uint32_t i;
+
+    for(i=0U; i<LOADGEN_MAX_PDO; i++){
+        OD_TPDOCommunicationParameter[i].COB_IDUsedByTPDO = CO_CAN_ID_TPDO_1 + i * 0x100U;
+        if(i >= lgConfig.tpdos){
+            OD_TPDOCommunicationParameter[i].COB_IDUsedByTPDO |= 0x80000000UL;
+        }
+        OD_TPDOCommunicationParameter[i].transmissionType = 1U;
+        OD_TPDOCommunicationParameter[i].inhibitTime = 0U;
+        OD_TPDOCommunicationParameter[i].eventTimer = 0U;
+        OD_TPDOMappingParameter[i] = OD_TPDOMappingParameter[0];
+
+        OD_RPDOCommunicationParameter[i].COB_IDUsedByRPDO = CO_CAN_ID_RPDO_1 + i * 0x100U;
+        if(i >= lgConfig.rpdos){
+            OD_RPDOCommunicationParameter[i].COB_IDUsedByRPDO |= 0x80000000UL;
+        }
+        OD_RPDOCommunicationParameter[i].transmissionType = 0xFEU;
+        OD_RPDOMappingParameter[i] = OD_RPDOMappingParameter[0];
+    }
+}
+
+
+/* Process of one node, does not return */
+static void loadgen_node(uint8_t nodeId, int32_t ifIndex, int startFd){
+    loadgen_nodeStats_t *stats = &lgNodeStats[nodeId];
+    CO_NMT_reset_cmd_t reset = CO_RESET_NOT;
+    CO_ReturnError_t err;
+    pthread_t rtThread;
+    uint32_t interval_us;
+    char c;
+
+    signal(SIGTERM, loadgen_signal);
+    signal(SIGINT, SIG_IGN);            /* parent stops the nodes */
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+
+    /* wait until gateway is ready, parent closes the pipe */
+    while((read(startFd, &c, 1) < 0) && (errno == EINTR));
+    close(startFd);
+
+    loadgen_nodeConfigure();
+    err = CO_init(0, nodeId, 0);
+    if(err == CO_ERROR_NO){
+        err = CO_CANmodule_addInterface(CO->CANmodule[0], ifIndex);
+    }
+    if(err != CO_ERROR_NO){
+        stats->error = err;
+        CO_delete(0);
+        _exit(1);
+    }
+
+    /* Process SYNC a few times per SYNC period */
+    interval_us = lgConfig.syncPeriod_us / 4U;
+    if(interval_us < 100U){
+        interval_us = 100U;
+    }
+    else if(interval_us > 1000U){
+        interval_us = 1000U;
+    }
+    threadMain_init(NULL, NULL);
+    CANrx_threadTmr_init_us(interval_us);
+    CO_CANsetNormalMode(CO->CANmodule[0]);
+
+    if(pthread_create(&rtThread, NULL, loadgen_nodeRT, NULL) != 0){
+        stats->error = CO_ERROR_SYSCALL;
+        _exit(1);
+    }
+
+    while(lgRunning && (reset == CO_RESET_NOT)){
+        threadMain_process(&reset);
+        stats->rxDropCount = CO->CANmodule[0]->rxDropCount;
+        stats->txOverflowCount = CO->CANmodule[0]->txOverflowCount;
+        threadMain_wait(LOADGEN_NODE_MAIN_MS);
+    }
+
+    lgRunning = 0;
+    pthread_join(rtThread, NULL);
+    CANrx_threadTmr_close();
+    threadMain_close();
+    CO_delete(0);
+    _exit(0);
+}
+
+
+/******************************************************************************/
+/* Gateway                                                                    */
+/******************************************************************************/
+static void loadgen_receiveTPDO(void *object, const CO_CANrxMsg_t *msg){
+    loadgen_node_t *node = (loadgen_node_t *)object;
+
+    (void)msg;
+    node->tpdoCount++;
+}
+
+
+static void loadgen_receiveHB(void *object, const CO_CANrxMsg_t *msg){
+    loadgen_node_t *node = (loadgen_node_t *)object;
+
+    node->nmtState = msg->data[0];
+    node->hbCount++;
+}
+
+
+static void *loadgen_rxThread(void *arg){
+    loadgen_rxThread_t *t = (loadgen_rxThread_t *)arg;
+
+    while(lgRunning){
+        if(t->rxThread == NULL){
+            (void)CO_CANrxWait(&lgCAN, -1, NULL);
+        }
+        else{
+            (void)CO_CANrxWaitThread(&lgCAN, t->rxThread, -1, NULL);
+        }
+    }
+    return NULL;
+}
+
+
+/* CPU time of rx thread in seconds */
+static double loadgen_rxThreadCPU(loadgen_rxThread_t *t){
+    clockid_t clock;
+    struct timespec ts;
+
+    if((pthread_getcpuclockid(t->thread, &clock) != 0) ||
+       (clock_gettime(clock, &ts) != 0))
+    {
+        return 0.0;
+    }
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+static CO_ReturnError_t loadgen_gatewayInit(void){
+    CO_ReturnError_t err;
+    uint16_t rxSize, txSize, rxIdx, txIdx;
+    uint32_t i, n, j;
+
+    rxSize = (uint16_t)(lgConfig.nodes * (lgConfig.tpdos + 1U) + lgConfig.sdoChannels);
+    txSize = (uint16_t)(1U + lgConfig.nodes * lgConfig.rpdos + lgConfig.sdoChannels);
+    lgRx = (CO_CANrx_t *)calloc(rxSize, sizeof(CO_CANrx_t));
+    lgTx = (CO_CANtx_t *)calloc(txSize, sizeof(CO_CANtx_t));
+    lgRpdoTx = (CO_CANtx_t **)calloc(lgConfig.nodes * lgConfig.rpdos + 1U, sizeof(CO_CANtx_t *));
+    if((lgRx == NULL) || (lgTx == NULL) || (lgRpdoTx == NULL)){
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+
+    CO_CANsetConfigurationMode(0);
+    err = CO_CANmodule_init(&lgCAN, 0, lgRx, rxSize, lgTx, txSize, 0);
+    for(i=0U; (err == CO_ERROR_NO) && (i<lgConfig.ifCount); i++){
+        err = CO_CANmodule_addInterface(&lgCAN, lgConfig.ifIndex[i]);
+    }
+    if(err == CO_ERROR_NO){
+        err = CO_CANmodule_setBufferTuning(&lgCAN, (int)lgConfig.socketBufferMax,
+                                           (int)lgConfig.socketBufferMax, 0);
+    }
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+
+    /* one receive buffer per TPDO and heartbeat of each node */
+    rxIdx = 0U;
+    for(n=1U; (err == CO_ERROR_NO) && (n<=lgConfig.nodes); n++){
+        for(j=0U; (err == CO_ERROR_NO) && (j<lgConfig.tpdos); j++){
+            err = CO_CANrxBufferInit(&lgCAN, rxIdx++, CO_CAN_ID_TPDO_1 + j * 0x100U + n,
+                    0x7FF, 0, (void *)&lgNodes[n], loadgen_receiveTPDO);
+        }
+        if(err == CO_ERROR_NO){
+            err = CO_CANrxBufferInit(&lgCAN, rxIdx++, CO_CAN_ID_HEARTBEAT + n,
+                    0x7FF, 0, (void *)&lgNodes[n], loadgen_receiveHB);
+        }
+    }
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+
+    /* SYNC goes to all interfaces, RPDOs and SDO requests only to the
+     * interface of the node. SDO client buffers change their COB-ID, so
+     * SDO requests are routed by COB-ID. */
+    txIdx = 0U;
+    lgSyncTx = CO_CANtxBufferInit(&lgCAN, txIdx++, CO_CAN_ID_SYNC, 0, 0, 0);
+    for(n=1U; n<=lgConfig.nodes; n++){
+        err = CO_CANtxRoute_add(&lgCAN, CO_CAN_ID_RSDO + n, lgNodes[n].ifIndex);
+        if(err != CO_ERROR_NO){
+            return err;
+        }
+        for(j=0U; j<lgConfig.rpdos; j++){
+            uint32_t ident = CO_CAN_ID_RPDO_1 + j * 0x100U + n;
+            CO_CANtx_t *buffer = CO_CANtxBufferInit(&lgCAN, txIdx++, ident, 0, 2, 0);
+
+            lgRpdoTx[(n - 1U) * lgConfig.rpdos + j] = buffer;
+            err = CO_CANtxBuffer_setInterface(&lgCAN, ident, lgNodes[n].ifIndex);
+            if(err != CO_ERROR_NO){
+                return err;
+            }
+        }
+    }
+
+    /* SDO clients, COB-IDs are set by CO_SDOclient_setup() */
+    memset(&lgSDO, 0, sizeof(lgSDO));
+    for(i=0U; i<lgConfig.sdoChannels; i++){
+        lgSdo[i].par.maxSubIndex = 3U;
+        lgSdo[i].par.COB_IDClientToServer = 0x80000000UL;
+        lgSdo[i].par.COB_IDServerToClient = 0x80000000UL;
+        lgSdo[i].par.nodeIDOfTheSDOServer = 0U;
+        err = CO_SDOclient_init(&lgSdo[i].client, &lgSDO, &lgSdo[i].par,
+                &lgCAN, rxIdx++, &lgCAN, txIdx++);
+        if(err != CO_ERROR_NO){
+            return err;
+        }
+    }
+
+    /* rx threads */
+    if(lgConfig.rxThreadPerInterface){
+        for(i=0U; (err == CO_ERROR_NO) && (i<lgConfig.ifCount); i++){
+            lgRxThreads[i].rxThread = &lgRxThreads[i].object;
+            err = CO_CANrxThread_init(&lgCAN, lgRxThreads[i].rxThread, lgConfig.ifIndex[i]);
+        }
+        lgRxThreadCount = lgConfig.ifCount;
+    }
+    else{
+        lgRxThreads[0].rxThread = NULL;
+        lgRxThreadCount = 1U;
+    }
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+
+    CO_CANsetNormalMode(&lgCAN);
+
+    for(i=0U; i<lgRxThreadCount; i++){
+        if(pthread_create(&lgRxThreads[i].thread, NULL, loadgen_rxThread, &lgRxThreads[i]) != 0){
+            return CO_ERROR_SYSCALL;
+        }
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+static void loadgen_gatewayClose(void){
+    uint32_t i;
+
+    lgRunning = 0;
+    for(i=0U; i<lgRxThreadCount; i++){
+        CO_CANrxThread_t *rxThread = lgRxThreads[i].rxThread;
+
+        CO_NotifyPipeSend((rxThread == NULL) ? lgCAN.rxThread.pipe : rxThread->pipe);
+        pthread_join(lgRxThreads[i].thread, NULL);
+    }
+    CO_CANmodule_disable(&lgCAN);
+    free(lgRx);
+    free(lgTx);
+    free(lgRpdoTx);
+}
+
+
+/* Start SDO upload, if channel of the node is free */
+static void loadgen_sdoStart(uint8_t nodeId, bool_t segmented){
+    loadgen_sdo_t *sdo = &lgSdo[(nodeId - 1U) % lgConfig.sdoChannels];
+    CO_SDOclient_return_t ret;
+
+    if(sdo->busy){
+        lgSdoSkipped++;
+        return;
+    }
+
+    ret = CO_SDOclient_setup(&sdo->client, 0, 0, nodeId);
+    if(ret == CO_SDOcli_ok_communicationEnd){
+        if(segmented){
+            ret = CO_SDOclientUploadInitiate(&sdo->client, LOADGEN_SDO_SEGMENTED_INDEX,
+                    LOADGEN_SDO_SEGMENTED_SUB, sdo->buffer, sizeof(sdo->buffer), 0);
+        }
+        else{
+            ret = CO_SDOclientUploadInitiate(&sdo->client, LOADGEN_SDO_EXPEDITED_INDEX,
+                    LOADGEN_SDO_EXPEDITED_SUB, sdo->buffer, sizeof(sdo->buffer), 0);
+        }
+    }
+    if(ret != CO_SDOcli_ok_communicationEnd){
+        lgSdoFailed++;
+        return;
+    }
+    sdo->busy = true;
+    sdo->time_ms = 0U;
+}
+
+
+static void loadgen_sdoProcess(uint16_t timeDifference_ms){
+    uint32_t i;
+
+    for(i=0U; i<lgConfig.sdoChannels; i++){
+        loadgen_sdo_t *sdo = &lgSdo[i];
+        CO_SDOclient_return_t ret;
+        uint32_t dataSize, abortCode;
+
+        if(!sdo->busy){
+            continue;
+        }
+        ret = CO_SDOclientUpload(&sdo->client, timeDifference_ms,
+                LOADGEN_SDO_TIMEOUT_MS, &dataSize, &abortCode);
+        if(ret == CO_SDOcli_ok_communicationEnd){
+            lgSdoOk++;
+        }
+        else if(ret < 0){
+            lgSdoFailed++;
+        }
+        else{
+            continue;
+        }
+        CO_SDOclientClose(&sdo->client);
+        sdo->busy = false;
+    }
+}
+
+
+/* One SYNC period */
+static void loadgen_cycle(uint16_t timeDifference_ms){
+    static uint32_t sdoNext = 0U;
+    static uint16_t rpdoData = 0U;
+    uint32_t i;
+
+    CO_CANtxBatchStart(&lgCAN);
+
+    if(CO_CANsend(&lgCAN, lgSyncTx) != CO_ERROR_NO){
+        lgTxErrors++;
+    }
+    lgSyncSent++;
+
+    rpdoData++;
+    for(i=0U; i<lgConfig.nodes * lgConfig.rpdos; i++){
+        lgRpdoTx[i]->data[0] = (uint8_t)rpdoData;
+        lgRpdoTx[i]->data[1] = (uint8_t)(rpdoData >> 8);
+        if(CO_CANsend(&lgCAN, lgRpdoTx[i]) != CO_ERROR_NO){
+            lgTxErrors++;
+        }
+    }
+
+    for(i=0U; i<(lgConfig.sdoExpedited + lgConfig.sdoSegmented); i++){
+        loadgen_sdoStart((uint8_t)(sdoNext + 1U), i >= lgConfig.sdoExpedited);
+        sdoNext = (sdoNext + 1U) % lgConfig.nodes;
+    }
+    loadgen_sdoProcess(timeDifference_ms);
+
+    (void)CO_CANtxBatchFlush(&lgCAN);
+}
+
+
+/* Wait until all nodes are operational. Returns number of missing nodes. */
+static uint32_t loadgen_waitNodes(void){
+    uint64_t start = loadgen_now_us();
+    uint32_t n, missing;
+
+    do{
+        missing = 0U;
+        for(n=1U; n<=lgConfig.nodes; n++){
+            if(lgNodeStats[n].error != CO_ERROR_NO){
+                continue;
+            }
+            if(lgNodes[n].nmtState != CO_NMT_OPERATIONAL){
+                missing++;
+            }
+        }
+        if(missing == 0U){
+            break;
+        }
+        usleep(10000);
+    }while(lgRunning && ((loadgen_now_us() - start) < LOADGEN_STARTUP_MS * 1000U));
+
+    return missing;
+}
+
+
+static void loadgen_report(FILE *out, double duration_s, uint32_t tpdoStart[]){
+    uint64_t tpdoReceived = 0U, tpdoExpected;
+    uint32_t nodeRxDrop = 0U, nodeTxOverflow = 0U, nodeErrors = 0U;
+    double cpu, cpuSum = 0.0;
+    uint32_t n, i;
+
+    for(n=1U; n<=lgConfig.nodes; n++){
+        tpdoReceived += lgNodes[n].tpdoCount - tpdoStart[n];
+        nodeRxDrop += lgNodeStats[n].rxDropCount;
+        nodeTxOverflow += lgNodeStats[n].txOverflowCount;
+        if(lgNodeStats[n].error != CO_ERROR_NO){
+            nodeErrors++;
+        }
+    }
+    tpdoExpected = (uint64_t)lgSyncSent * lgConfig.nodes * lgConfig.tpdos;
+
+    fprintf(out, "{\"nodes\":%u,\"interfaces\":%u,\"rx_threads\":%u,"
+            "\"tpdo_per_node\":%u,\"rpdo_per_node\":%u,\"sync_us\":%u,"
+            "\"sdo_expedited\":%u,\"sdo_segmented\":%u,\"duration_s\":%.3f,"
+            "\"sync_sent\":%u,\"sync_late\":%u,"
+            "\"tpdo_expected\":%llu,\"tpdo_received\":%llu,\"tpdo_missing\":%llu,"
+            "\"rx_drop_count\":%u,\"tx_overflow\":%u,\"tx_errors\":%u,"
+            "\"sdo_ok\":%u,\"sdo_failed\":%u,\"sdo_skipped\":%u,"
+            "\"node_errors\":%u,\"node_rx_drop_count\":%u,\"node_tx_overflow\":%u,"
+            "\"rx_thread_cpu_s\":[",
+            lgConfig.nodes, lgConfig.ifCount, lgRxThreadCount,
+            lgConfig.tpdos, lgConfig.rpdos, lgConfig.syncPeriod_us,
+            lgConfig.sdoExpedited, lgConfig.sdoSegmented, duration_s,
+            lgSyncSent, lgSyncLate,
+            (unsigned long long)tpdoExpected, (unsigned long long)tpdoReceived,
+            (unsigned long long)((tpdoExpected > tpdoReceived) ? (tpdoExpected - tpdoReceived) : 0U),
+            lgCAN.rxDropCount, lgCAN.txOverflowCount, lgTxErrors,
+            lgSdoOk, lgSdoFailed, lgSdoSkipped,
+            nodeErrors, nodeRxDrop, nodeTxOverflow);
+    for(i=0U; i<lgRxThreadCount; i++){
+        cpu = loadgen_rxThreadCPU(&lgRxThreads[i]);
+        cpuSum += cpu;
+        fprintf(out, "%s%.6f", (i == 0U) ? "" : ",", cpu);
+    }
+    fprintf(out, "],\"rx_thread_cpu_percent\":%.2f}\n",
+            (duration_s > 0.0) ? (cpuSum * 100.0 / duration_s) : 0.0);
+    fflush(out);
+}
+
+
+static void loadgen_usage(const char *name){
+    fprintf(stderr,
+"Usage: %s [options] [interface ...]\n"
+"  Interfaces default to vcan0, nodes are distributed round robin.\n"
+"  -n nodes      Number of simulated nodes, 1..%u (default %u)\n"
+"  -t tpdos      Synchronous TPDOs per node, 0..%u (default %u)\n"
+"  -r rpdos      RPDOs per node sent by gateway each SYNC, 0..%u (default %u)\n"
+"  -s us         SYNC period in microseconds (default %u)\n"
+"  -x count      Expedited SDO uploads started each SYNC (default %u)\n"
+"  -g count      Segmented SDO uploads started each SYNC (default %u)\n"
+"  -c channels   SDO client channels of the gateway, 1..%u (default %u)\n"
+"  -d seconds    Duration of the measurement (default %u)\n"
+"  -T            One gateway rx thread per interface\n"
+"  -b bytes      Raise gateway socket buffers on drops up to bytes (default off)\n"
+"  -o file       Write result to file instead of stdout\n"
+"  -v            Print intermediate results every second to stderr\n"
+"Result is written as JSON object.\n",
+            name, LOADGEN_MAX_NODES, lgConfig.nodes, LOADGEN_MAX_PDO, lgConfig.tpdos,
+            LOADGEN_MAX_PDO, lgConfig.rpdos, lgConfig.syncPeriod_us,
+            lgConfig.sdoExpedited, lgConfig.sdoSegmented,
+            LOADGEN_MAX_SDO_CHANNELS, lgConfig.sdoChannels, lgConfig.duration_s);
+}
+
+
+int main(int argc, char *argv[]){
+    static uint32_t tpdoStart[LOADGEN_MAX_NODES + 1U];
+    CO_ReturnError_t err;
+    FILE *out = stdout;
+    struct itimerspec itval;
+    uint64_t start, now, lastPrint, expirations;
+    uint32_t elapsed_us = 0U;
+    uint32_t n, missing;
+    int startPipe[2];
+    int fdTimer;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:t:r:s:x:g:c:d:b:To:vh")) != -1){
+        switch(opt){
+            case 'n': lgConfig.nodes = (uint32_t)strtoul(optarg, NULL, 0);          break;
+            case 't': lgConfig.tpdos = (uint32_t)strtoul(optarg, NULL, 0);          break;
+            case 'r': lgConfig.rpdos = (uint32_t)strtoul(optarg, NULL, 0);          break;
+            case 's': lgConfig.syncPeriod_us = (uint32_t)strtoul(optarg, NULL, 0);  break;
+            case 'x': lgConfig.sdoExpedited = (uint32_t)strtoul(optarg, NULL, 0);   break;
+            case 'g': lgConfig.sdoSegmented = (uint32_t)strtoul(optarg, NULL, 0);   break;
+            case 'c': lgConfig.sdoChannels = (uint32_t)strtoul(optarg, NULL, 0);    break;
+            case 'd': lgConfig.duration_s = (uint32_t)strtoul(optarg, NULL, 0);     break;
+            case 'b': lgConfig.socketBufferMax = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'T': lgConfig.rxThreadPerInterface = true;                         break;
+            case 'v': lgConfig.verbose = true;                                      break;
+            case 'o':
+                out = fopen(optarg, "w");
+                if(out == NULL){
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            default:
+                loadgen_usage(argv[0]);
+                return 1;
+        }
+    }
+    if((lgConfig.nodes < 1U) || (lgConfig.nodes > LOADGEN_MAX_NODES) ||
+       (lgConfig.tpdos > LOADGEN_MAX_PDO) || (lgConfig.rpdos > LOADGEN_MAX_PDO) ||
+       (lgConfig.syncPeriod_us == 0U) || (lgConfig.sdoChannels < 1U) ||
+       (lgConfig.sdoChannels > LOADGEN_MAX_SDO_CHANNELS) ||
+       ((argc - optind) > (int)LOADGEN_MAX_INTERFACES))
+    {
+        loadgen_usage(argv[0]);
+        return 1;
+    }
+    if(optind == argc){
+        lgConfig.ifName[lgConfig.ifCount++] = "vcan0";
+    }
+    while(optind < argc){
+        lgConfig.ifName[lgConfig.ifCount++] = argv[optind++];
+    }
+    for(n=0U; n<lgConfig.ifCount; n++){
+        lgConfig.ifIndex[n] = (int32_t)if_nametoindex(lgConfig.ifName[n]);
+        if(lgConfig.ifIndex[n] == 0){
+            fprintf(stderr, "%s: unknown interface\n", lgConfig.ifName[n]);
+            return 1;
+        }
+    }
+
+    signal(SIGINT, loadgen_signal);
+    signal(SIGTERM, loadgen_signal);
+
+    lgNodeStats = (loadgen_nodeStats_t *)mmap(NULL,
+            sizeof(loadgen_nodeStats_t) * (LOADGEN_MAX_NODES + 1U),
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if((lgNodeStats == MAP_FAILED) || (pipe(startPipe) != 0)){
+        perror("loadgen");
+        return 1;
+    }
+    memset(lgNodeStats, 0, sizeof(loadgen_nodeStats_t) * (LOADGEN_MAX_NODES + 1U));
+
+    /* Nodes are forked first, they start when the gateway is ready */
+    for(n=1U; n<=lgConfig.nodes; n++){
+        lgNodes[n].ifIndex = lgConfig.ifIndex[(n - 1U) % lgConfig.ifCount];
+        lgNodes[n].pid = fork();
+        if(lgNodes[n].pid == 0){
+            close(startPipe[1]);
+            loadgen_node((uint8_t)n, lgNodes[n].ifIndex, startPipe[0]);
+        }
+        else if(lgNodes[n].pid < 0){
+            perror("fork");
+            lgRunning = 0;
+            break;
+        }
+    }
+    close(startPipe[0]);
+
+    err = lgRunning ? loadgen_gatewayInit() : CO_ERROR_SYSCALL;
+    close(startPipe[1]);
+    if(err != CO_ERROR_NO){
+        fprintf(stderr, "Gateway initialization failed: %d\n", (int)err);
+        lgRunning = 0;
+    }
+
+    missing = loadgen_waitNodes();
+    if(missing > 0U){
+        fprintf(stderr, "%u nodes are not operational\n", missing);
+    }
+
+    /* SYNC producer on absolute timer */
+    fdTimer = timerfd_create(CLOCK_MONOTONIC, 0);
+    itval.it_interval.tv_sec = lgConfig.syncPeriod_us / 1000000U;
+    itval.it_interval.tv_nsec = (lgConfig.syncPeriod_us % 1000000U) * 1000U;
+    itval.it_value = itval.it_interval;
+    if((fdTimer < 0) || (timerfd_settime(fdTimer, 0, &itval, NULL) != 0)){
+        perror("timerfd");
+        lgRunning = 0;
+    }
+
+    for(n=1U; n<=lgConfig.nodes; n++){
+        tpdoStart[n] = lgNodes[n].tpdoCount;
+    }
+    start = loadgen_now_us();
+    lastPrint = start;
+    now = start;
+    while(lgRunning && ((now - start) < lgConfig.duration_s * 1000000ULL)){
+        if(read(fdTimer, &expirations, sizeof(expirations)) != sizeof(expirations)){
+            continue;
+        }
+        lgSyncLate += (uint32_t)(expirations - 1U);
+        elapsed_us += (uint32_t)expirations * lgConfig.syncPeriod_us;
+        loadgen_cycle((uint16_t)(elapsed_us / 1000U));
+        elapsed_us %= 1000U;
+
+        now = loadgen_now_us();
+        if(lgConfig.verbose && ((now - lastPrint) >= 1000000U)){
+            loadgen_report(stderr, (double)(now - start) / 1e6, tpdoStart);
+            lastPrint = now;
+        }
+    }
+
+    /* let the nodes answer the last SYNC */
+    usleep(LOADGEN_DRAIN_MS * 1000U);
+    if(err == CO_ERROR_NO){
+        loadgen_report(out, (double)(now - start) / 1e6, tpdoStart);
+    }
+
+    for(n=1U; n<=lgConfig.nodes; n++){
+        if(lgNodes[n].pid > 0){
+            kill(lgNodes[n].pid, SIGTERM);
+        }
+    }
+    for(n=1U; n<=lgConfig.nodes; n++){
+        if(lgNodes[n].pid > 0){
+            waitpid(lgNodes[n].pid, NULL, 0);
+        }
+    }
+    if(fdTimer >= 0){
+        close(fdTimer);
+    }
+    loadgen_gatewayClose();
+    if(out != stdout){
+        fclose(out);
+    }
+
+    return (err == CO_ERROR_NO) ? 0 : 1;
+}
@@ -139,8 +139,8 @@ struct sCO_OD_EEPROM CO_OD_EEPROM = {
 /*2101*/ 0x30,
 /*2102*/ 0xFA,
 /*2111*/ {1L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L},
-/*2301*/{{0x8, 0x64L, 0x1, {'T', 'r', 'a', 'c', 'e', '1', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '}, {'r', 'e', 'd', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '}, 0x60000108L, 0x1, 0x0, 0L},
-/*2302*/ {0x8, 0x0L, 0x0, {'T', 'r', 'a', 'c', 'e', '2', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '}, {'g', 'r', 'e', 'e', 'n', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '}, 0x0L, 0x0, 0x0, 0L}},
+/*2301*/{{0x9, 0x64L, 0x1, {'T', 'r', 'a', 'c', 'e', '1', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '}, {'r', 'e', 'd', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '}, 0x60000108L, 0x1, 0x0, 0L, 0x0L},
+/*2302*/ {0x9, 0x0L, 0x0, {'T', 'r', 'a', 'c', 'e', '2', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '}, {'g', 'r', 'e', 'e', 'n', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '}, 0x0L, 0x0, 0x0, 0L, 0x0L}},
 
            CO_OD_FIRST_LAST_WORD
 };
@@ -299,7 +299,7 @@ struct sCO_OD_EEPROM CO_OD_EEPROM = {
            {(void*)&CO_OD_RAM.time.string[0], 0x06, 30},
            {(void*)&CO_OD_RAM.time.epochTimeBaseMs, 0x8E,  8},
            {(void*)&CO_OD_RAM.time.epochTimeOffsetMs, 0xBE,  4}};
-/*0x2301*/ const CO_OD_entryRecord_t OD_record2301[9] = {
+/*0x2301*/ const CO_OD_entryRecord_t OD_record2301[10] = {
            {(void*)&CO_OD_ROM.traceConfig[0].maxSubIndex, 0x05,  1},
            {(void*)&CO_OD_ROM.traceConfig[0].size, 0x8D,  4},
            {(void*)&CO_OD_ROM.traceConfig[0].axisNo, 0x0D,  1},
@@ -308,8 +308,9 @@ struct sCO_OD_EEPROM CO_OD_EEPROM = {
            {(void*)&CO_OD_ROM.traceConfig[0].map, 0x8D,  4},
            {(void*)&CO_OD_ROM.traceConfig[0].format, 0x0D,  1},
            {(void*)&CO_OD_ROM.traceConfig[0].trigger, 0x0D,  1},
-           {(void*)&CO_OD_ROM.traceConfig[0].threshold, 0x8D,  4}};
-/*0x2302*/ const CO_OD_entryRecord_t OD_record2302[9] = {
+           {(void*)&CO_OD_ROM.traceConfig[0].threshold, 0x8D,  4},
+           {(void*)&CO_OD_ROM.traceConfig[0].start, 0x8D,  4}};
+/*0x2302*/ const CO_OD_entryRecord_t OD_record2302[10] = {
            {(void*)&CO_OD_ROM.traceConfig[1].maxSubIndex, 0x05,  1},
            {(void*)&CO_OD_ROM.traceConfig[1].size, 0x8D,  4},
            {(void*)&CO_OD_ROM.traceConfig[1].axisNo, 0x0D,  1},
@@ -318,7 +319,8 @@ struct sCO_OD_EEPROM CO_OD_EEPROM = {
            {(void*)&CO_OD_ROM.traceConfig[1].map, 0x8D,  4},
            {(void*)&CO_OD_ROM.traceConfig[1].format, 0x0D,  1},
            {(void*)&CO_OD_ROM.traceConfig[1].trigger, 0x0D,  1},
-           {(void*)&CO_OD_ROM.traceConfig[1].threshold, 0x8D,  4}};
+           {(void*)&CO_OD_ROM.traceConfig[1].threshold, 0x8D,  4},
+           {(void*)&CO_OD_ROM.traceConfig[1].start, 0x8D,  4}};
 /*0x2401*/ const CO_OD_entryRecord_t OD_record2401[7] = {
            {(void*)&CO_OD_RAM.trace[0].maxSubIndex, 0x06,  1},
            {(void*)&CO_OD_RAM.trace[0].size, 0xBE,  4},
@@ -392,8 +394,8 @@ const CO_OD_entry_t CO_OD[CO_OD_NoOfElements] = {
 {0x2112, 0x10, 0xFF,  4, (void*)&CO_OD_EEPROM.variableNVInt32[0]},
 {0x2120, 0x05, 0x00,  0, (void*)&OD_record2120},
 {0x2130, 0x03, 0x00,  0, (void*)&OD_record2130},
-{0x2301, 0x08, 0x00,  0, (void*)&OD_record2301},
-{0x2302, 0x08, 0x00,  0, (void*)&OD_record2302},
+{0x2301, 0x09, 0x00,  0, (void*)&OD_record2301},
+{0x2302, 0x09, 0x00,  0, (void*)&OD_record2302},
 {0x2400, 0x00, 0x3E,  1, (void*)&CO_OD_RAM.traceEnable},
 {0x2401, 0x06, 0x00,  0, (void*)&OD_record2401},
 {0x2402, 0x06, 0x00,  0, (void*)&OD_record2402},
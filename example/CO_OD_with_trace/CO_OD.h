@@ -193,6 +193,7 @@
                UNSIGNED8      format;
                UNSIGNED8      trigger;
                INTEGER32      threshold;
+               UNSIGNED32     start;
                }              OD_traceConfig_t;
 
 /*2401[2]   */ typedef struct{
@@ -0,0 +1,172 @@
+/*
+ * CAN acceptance filter compiler - merge receive buffers into hardware filters.
+ *
+ * @file        CO_CANfilter.c
+ * @ingroup     CO_CANfilter
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_CANfilter.h"
+
+
+/*
+ * Count set bits.
+ */
+static uint8_t CO_CANfilter_bitCount(uint32_t value){
+    uint8_t count = 0U;
+
+    while(value != 0U){
+        value &= value - 1U;
+        count++;
+    }
+    return count;
+}
+
+
+/*
+ * Verify, if filter a accepts all messages, which are accepted by filter b.
+ */
+static bool_t CO_CANfilter_covers(const CO_CANfilter_t *a, const CO_CANfilter_t *b){
+    return ((a->mask & ~b->mask) == 0U) && (((a->ident ^ b->ident) & a->mask) == 0U);
+}
+
+
+/*
+ * Remove all filters, which are covered by filter at index. Returns new count.
+ */
+static uint16_t CO_CANfilter_removeCovered(
+        CO_CANfilter_t          filters[],
+        uint16_t                count,
+        uint16_t               *index)
+{
+    uint16_t i = 0U;
+
+    while(i < count){
+        if((i != *index) && CO_CANfilter_covers(&filters[*index], &filters[i])){
+            /* move last filter into the gap */
+            count--;
+            filters[i] = filters[count];
+            if(*index == count){
+                *index = i;
+            }
+        }
+        else{
+            i++;
+        }
+    }
+    return count;
+}
+
+
+/******************************************************************************/
+uint16_t CO_CANfilter_merge(
+        CO_CANfilter_t          filters[],
+        uint16_t                count,
+        uint16_t                maxCount)
+{
+    uint16_t i, j;
+
+    if(filters == NULL || maxCount == 0U){
+        return count;
+    }
+
+    /* normalize, bits outside mask are don't care */
+    for(i=0U; i<count; i++){
+        filters[i].ident &= filters[i].mask;
+    }
+
+    /* remove redundant filters */
+    i = 0U;
+    while(i < count){
+        bool_t covered = false;
+
+        for(j=0U; j<count; j++){
+            if((j != i) && CO_CANfilter_covers(&filters[j], &filters[i])){
+                covered = true;
+                break;
+            }
+        }
+        if(covered){
+            /* move last filter into the gap and check it too */
+            count--;
+            filters[i] = filters[count];
+        }
+        else{
+            i++;
+        }
+    }
+
+    /* merge filters pairwise, keep as many mask bits as possible */
+    while(count > maxCount){
+        uint16_t bestI = 0U;
+        uint16_t bestJ = 1U;
+        int16_t bestBits = -1;
+        uint32_t bestMask = 0U;
+
+        for(i=0U; i<count; i++){
+            for(j=i+1U; j<count; j++){
+                uint32_t mask = filters[i].mask & filters[j].mask &
+                                ~(filters[i].ident ^ filters[j].ident);
+                int16_t bits = (int16_t)CO_CANfilter_bitCount(mask);
+
+                if(bits > bestBits){
+                    bestBits = bits;
+                    bestMask = mask;
+                    bestI = i;
+                    bestJ = j;
+                }
+            }
+        }
+
+        filters[bestI].mask = bestMask;
+        filters[bestI].ident &= bestMask;
+        count--;
+        filters[bestJ] = filters[count];
+        if(bestI == count){
+            bestI = bestJ;
+        }
+
+        /* merged filter may cover other filters now */
+        count = CO_CANfilter_removeCovered(filters, count, &bestI);
+    }
+
+    return count;
+}
@@ -0,0 +1,107 @@
+/**
+ * CAN acceptance filter compiler - merge receive buffers into hardware filters.
+ *
+ * @file        CO_CANfilter.h
+ * @ingroup     CO_CANfilter
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_CANfilter_H
+#define CO_CANfilter_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_CANfilter CAN filter compiler
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * Reduce identifier/mask pairs of CAN receive buffers to the number of
+ * acceptance filters supported by the CAN controller or kernel.
+ *
+ * Each filter accepts a message, if ((ident ^ filter.ident) & filter.mask)
+ * is zero. CO_CANfilter_merge() first removes all filters, which are covered
+ * by another filter. This doesn't change the set of accepted messages. If
+ * there are still more filters than supported, the two filters are merged,
+ * that keep the most mask bits. Mask bits, in which the identifiers of both
+ * filters differ, are cleared. So the result accepts all messages of the
+ * original filters, plus some more, which must be rejected by the software
+ * filter of the driver, as before.
+ *
+ * Identifier and mask are given in the bit alignment of the target, e.g.
+ * including RTR and IDE bits. The function is called once after all receive
+ * buffers are configured, it is not intended for use in realtime context.
+ */
+
+
+/**
+ * Acceptance filter, identifier and mask.
+ */
+typedef struct{
+    uint32_t            ident;          /**< Identifier, bit aligned as mask */
+    uint32_t            mask;           /**< Mask, set bits must match ident */
+}CO_CANfilter_t;
+
+
+/**
+ * Merge acceptance filters.
+ *
+ * @param filters Array of filters, will be modified. Unused entries must be
+ * removed by the caller before.
+ * @param count Number of filters in array.
+ * @param maxCount Number of filters supported by target, at least 1. If
+ * maxCount is equal to count, only redundant filters are removed.
+ *
+ * @return Number of filters at the beginning of _filters_ after merge.
+ */
+uint16_t CO_CANfilter_merge(
+        CO_CANfilter_t          filters[],
+        uint16_t                count,
+        uint16_t                maxCount);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
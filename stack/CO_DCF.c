@@ -0,0 +1,374 @@
+/*
+ * Concise DCF download (CiA 302 object 0x1F22 format).
+ *
+ * @file        CO_DCF.c
+ * @ingroup     CO_DCF
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_DCF.h"
+
+#include <string.h> /* for memcpy */
+
+
+/*
+ * Verify entry header, before its data is received.
+ */
+static CO_SDO_abortCode_t CO_DCF_verifyEntry(CO_DCF_t *DCF){
+    CO_SDO_t *SDO = DCF->SDO;
+    uint16_t entryNo;
+
+    /* concise DCF can't contain itself */
+    if(DCF->entryIndex == DCF->index){
+        return CO_SDO_AB_UNSUPPORTED_ACCESS;
+    }
+
+    entryNo = CO_OD_find(SDO, DCF->entryIndex);
+    if(entryNo == 0xFFFFU){
+        return CO_SDO_AB_NOT_EXIST;
+    }
+    if(DCF->entrySubIndex > SDO->OD[entryNo].maxSubIndex &&
+            SDO->OD[entryNo].pData != NULL)
+    {
+        return CO_SDO_AB_SUB_UNKNOWN;
+    }
+    if((CO_OD_getAttribute(SDO, entryNo, DCF->entrySubIndex) & CO_ODA_WRITEABLE) == 0){
+        return CO_SDO_AB_READONLY;
+    }
+
+    /* length of domain data is application specific and not verified */
+    if(CO_OD_getDataPointer(SDO, entryNo, DCF->entrySubIndex) != NULL &&
+            DCF->entrySize != CO_OD_getLength(SDO, entryNo, DCF->entrySubIndex))
+    {
+        return CO_SDO_AB_TYPE_MISMATCH;
+    }
+    if(DCF->entrySize > CO_DCF_DATA_SIZE){
+        return CO_SDO_AB_OUT_OF_MEM;
+    }
+
+    DCF->entryNo = entryNo;
+    return CO_SDO_AB_NONE;
+}
+
+
+/*
+ * Write received entry to the Object dictionary, same as CO_SDO_writeOD().
+ * OD is already locked by the SDO server, which calls CO_ODF_DCF().
+ * SDO->ODF_arg belongs to the running transfer, so own argument is used.
+ */
+static CO_SDO_abortCode_t CO_DCF_writeEntry(CO_DCF_t *DCF){
+    CO_SDO_t *SDO = DCF->SDO;
+    CO_OD_extension_t *ext;
+    CO_ODF_arg_t arg;
+    uint8_t *ODdata;
+    uint16_t len = (uint16_t)DCF->entrySize;
+
+    ext = CO_OD_getExtension(SDO, DCF->entryNo);
+    ODdata = (uint8_t*)CO_OD_getDataPointer(SDO, DCF->entryNo, DCF->entrySubIndex);
+
+    arg.object = (ext != NULL) ? ext->object : NULL;
+    arg.data = DCF->data;
+    arg.ODdataStorage = ODdata;
+    arg.dataLength = len;
+    arg.attribute = CO_OD_getAttribute(SDO, DCF->entryNo, DCF->entrySubIndex);
+    arg.pFlags = CO_OD_getFlagsPointer(SDO, DCF->entryNo, DCF->entrySubIndex);
+    arg.index = DCF->entryIndex;
+    arg.subIndex = DCF->entrySubIndex;
+    arg.reading = false;
+    arg.firstSegment = true;
+    arg.lastSegment = true;
+    arg.dataLengthTotal = len;
+    arg.offset = 0U;
+#ifdef CO_SDO_STREAM_UPLOAD
+    arg.scatter = NULL;
+    arg.scatterCount = 0U;
+#endif
+
+    /* swap data if processor is not little endian (CANopen is) */
+    if((arg.attribute & CO_ODA_MB_VALUE) != 0){
+        CO_swapArray(arg.data, len, len);
+    }
+
+    if(ext != NULL && ext->pODFunc != NULL){
+        CO_SDO_abortCode_t abortCode = ext->pODFunc(&arg);
+        if(abortCode != CO_SDO_AB_NONE){
+            return abortCode;
+        }
+    }
+
+    /* 1003,00 is writable from network, but not in OD */
+    if(ODdata != NULL && !(DCF->entryIndex == 0x1003U && DCF->entrySubIndex == 0U)){
+        memcpy(ODdata, DCF->data, len);
+    }
+
+    if(arg.pFlags != NULL){
+        *arg.pFlags |= CO_ODFL_SDO_DOWNLOADED | CO_ODFL_TPDO_COS_DIRTY;
+    }
+
+    DCF->entriesWritten++;
+    return CO_SDO_AB_NONE;
+}
+
+
+/*
+ * Function for accessing _Concise DCF_ domain from SDO server. Called with
+ * the content of the SDO buffer, each time it is full and at the end of the
+ * download. Entries may be split between calls.
+ */
+static CO_SDO_abortCode_t CO_ODF_DCF(CO_ODF_arg_t *ODF_arg){
+    CO_DCF_t *DCF;
+    const uint8_t *data;
+    uint32_t len;
+    CO_SDO_abortCode_t abortCode = CO_SDO_AB_NONE;
+
+    DCF = (CO_DCF_t*) ODF_arg->object;
+    data = ODF_arg->data;
+    len = ODF_arg->dataLength;
+
+    if(ODF_arg->reading){
+        return CO_SDO_AB_WRITEONLY;
+    }
+
+    if(ODF_arg->firstSegment){
+        DCF->headerFill = 0U;
+        DCF->counted = false;
+        DCF->inData = false;
+        DCF->remaining = 0U;
+        DCF->entriesWritten = 0U;
+        DCF->errorIndex = 0U;
+        DCF->errorSubIndex = 0U;
+    }
+
+    while(len > 0U && abortCode == CO_SDO_AB_NONE){
+        uint32_t n;
+
+        if(DCF->inData){
+            /* data of the current entry */
+            n = DCF->entrySize - DCF->dataFill;
+            if(n > len){
+                n = len;
+            }
+            memcpy(&DCF->data[DCF->dataFill], data, n);
+            DCF->dataFill += n;
+            if(DCF->dataFill == DCF->entrySize){
+                DCF->inData = false;
+                abortCode = CO_DCF_writeEntry(DCF);
+            }
+        }
+        else{
+            /* number of entries or entry header */
+            uint8_t size = DCF->counted ? 7U : 4U;
+
+            if(DCF->counted && DCF->remaining == 0U){
+                return CO_SDO_AB_DATA_LONG;
+            }
+            n = size - DCF->headerFill;
+            if(n > len){
+                n = len;
+            }
+            memcpy(&DCF->header[DCF->headerFill], data, n);
+            DCF->headerFill += (uint8_t)n;
+            if(DCF->headerFill == size){
+                const uint8_t *h = DCF->header;
+
+                DCF->headerFill = 0U;
+                if(!DCF->counted){
+                    DCF->remaining = (uint32_t)h[0] | ((uint32_t)h[1] << 8) |
+                                     ((uint32_t)h[2] << 16) | ((uint32_t)h[3] << 24);
+                    DCF->counted = true;
+                }
+                else{
+                    DCF->entryIndex = (uint16_t)h[0] | (uint16_t)((uint16_t)h[1] << 8);
+                    DCF->entrySubIndex = h[2];
+                    DCF->entrySize = (uint32_t)h[3] | ((uint32_t)h[4] << 8) |
+                                     ((uint32_t)h[5] << 16) | ((uint32_t)h[6] << 24);
+                    DCF->dataFill = 0U;
+                    DCF->remaining--;
+                    abortCode = CO_DCF_verifyEntry(DCF);
+                    if(abortCode == CO_SDO_AB_NONE){
+                        if(DCF->entrySize == 0U){
+                            abortCode = CO_DCF_writeEntry(DCF);
+                        }
+                        else{
+                            DCF->inData = true;
+                        }
+                    }
+                }
+            }
+        }
+        data += n;
+        len -= n;
+    }
+
+    if(abortCode != CO_SDO_AB_NONE){
+        DCF->errorIndex = DCF->entryIndex;
+        DCF->errorSubIndex = DCF->entrySubIndex;
+        return abortCode;
+    }
+
+    if(ODF_arg->lastSegment &&
+            (!DCF->counted || DCF->remaining != 0U || DCF->inData || DCF->headerFill != 0U))
+    {
+        return CO_SDO_AB_DATA_SHORT;
+    }
+
+    return CO_SDO_AB_NONE;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_DCF_init(
+        CO_DCF_t               *DCF,
+        CO_SDO_t               *SDO,
+        uint16_t                index)
+{
+    /* verify arguments */
+    if(DCF==NULL || SDO==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    DCF->SDO = SDO;
+    DCF->index = index;
+    DCF->headerFill = 0U;
+    DCF->counted = false;
+    DCF->inData = false;
+    DCF->remaining = 0U;
+    DCF->entryNo = 0xFFFFU;
+    DCF->entryIndex = 0U;
+    DCF->entrySubIndex = 0U;
+    DCF->entrySize = 0U;
+    DCF->dataFill = 0U;
+    DCF->entriesWritten = 0U;
+    DCF->errorIndex = 0U;
+    DCF->errorSubIndex = 0U;
+
+    CO_OD_configure(SDO, index, CO_ODF_DCF, (void*)DCF, 0, 0U);
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_DCFwriter_init(
+        CO_DCFwriter_t         *writer,
+        uint8_t                *buffer,
+        uint32_t                bufferSize)
+{
+    /* verify arguments */
+    if(writer==NULL || buffer==NULL || bufferSize<4U){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    writer->buffer = buffer;
+    writer->bufferSize = bufferSize;
+    writer->length = 4U;
+    writer->count = 0U;
+    memset(buffer, 0, 4U);
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_DCFwriter_add(
+        CO_DCFwriter_t         *writer,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        const uint8_t          *data,
+        uint32_t                size)
+{
+    uint8_t *p;
+
+    if(writer==NULL || (data==NULL && size!=0U)){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    if(size > (writer->bufferSize - writer->length) ||
+            (writer->bufferSize - writer->length - size) < 7U)
+    {
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+
+    p = &writer->buffer[writer->length];
+    p[0] = (uint8_t)index;
+    p[1] = (uint8_t)(index >> 8);
+    p[2] = subIndex;
+    p[3] = (uint8_t)size;
+    p[4] = (uint8_t)(size >> 8);
+    p[5] = (uint8_t)(size >> 16);
+    p[6] = (uint8_t)(size >> 24);
+    if(size != 0U){
+        memcpy(&p[7], data, size);
+    }
+    writer->length += 7U + size;
+
+    writer->count++;
+    writer->buffer[0] = (uint8_t)writer->count;
+    writer->buffer[1] = (uint8_t)(writer->count >> 8);
+    writer->buffer[2] = (uint8_t)(writer->count >> 16);
+    writer->buffer[3] = (uint8_t)(writer->count >> 24);
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_DCFwriter_addValue(
+        CO_DCFwriter_t         *writer,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint32_t                value,
+        uint8_t                 size)
+{
+    uint8_t data[4];
+    uint8_t i;
+
+    if(size == 0U || size > 4U){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    for(i=0U; i<size; i++){
+        data[i] = (uint8_t)(value >> (i * 8U));
+    }
+
+    return CO_DCFwriter_add(writer, index, subIndex, data, size);
+}
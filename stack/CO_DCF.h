@@ -0,0 +1,208 @@
+/**
+ * Concise DCF download (CiA 302 object 0x1F22 format).
+ *
+ * @file        CO_DCF.h
+ * @ingroup     CO_DCF
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+
+
+
+#ifndef CO_DCF_H
+#define CO_DCF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_DCF Concise DCF
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * Configuration of a node with a concise DCF in one SDO transfer.
+ *
+ * Concise DCF (CiA 302-3, format of object 0x1F22) is a stream of OD entries:
+ * UNSIGNED32 number of entries, followed by each entry as UNSIGNED16 index,
+ * UNSIGNED8 sub-index, UNSIGNED32 data size and data. All values are little
+ * endian, as in SDO.
+ *
+ * Master builds the stream with CO_DCFwriter_init() and CO_DCFwriter_add()
+ * and downloads it to a domain of the node in one block transfer:
+ *
+ *     CO_SDOclientDownloadInitiate(SDO_C, 0x1F22, 0, writer.buffer,
+ *                                  writer.length, 1);
+ *
+ * followed by CO_SDOclientDownload() until it finishes. This replaces one
+ * SDO transfer with its round-trips for each object.
+ *
+ * Node registers the domain with CO_DCF_init(). Stream is parsed as it is
+ * received, each time the SDO buffer is full, and each entry is written to
+ * the Object dictionary as by SDO download: attribute and length are
+ * verified, @ref CO_SDO_OD_function of the entry is called and
+ * #CO_SDO_OD_flags_t are set. If an entry fails, the SDO transfer is aborted
+ * with its abort code and CO_DCF_t::errorIndex and CO_DCF_t::errorSubIndex
+ * indicate the entry. Entries before it stay written.
+ */
+
+
+/**
+ * Maximum data size of one concise DCF entry on the node. Larger entries
+ * are aborted with CO_SDO_AB_OUT_OF_MEM.
+ */
+#ifndef CO_DCF_DATA_SIZE
+    #define CO_DCF_DATA_SIZE            32U
+#endif
+
+
+/**
+ * Concise DCF object on the node.
+ */
+typedef struct{
+    CO_SDO_t           *SDO;            /**< From CO_DCF_init() */
+    uint16_t            index;          /**< From CO_DCF_init() */
+    uint8_t             header[7];      /**< Number of entries or entry header being received */
+    uint8_t             headerFill;     /**< Number of bytes in header */
+    bool_t              counted;        /**< True, after number of entries is received */
+    bool_t              inData;         /**< True, while data of the current entry is received */
+    uint32_t            remaining;      /**< Number of entries not received yet */
+    uint16_t            entryNo;        /**< OD entry of the current entry */
+    uint16_t            entryIndex;     /**< Index of the current entry */
+    uint8_t             entrySubIndex;  /**< Sub-index of the current entry */
+    uint32_t            entrySize;      /**< Data size of the current entry */
+    uint32_t            dataFill;       /**< Number of bytes in data */
+    uint8_t             data[CO_DCF_DATA_SIZE]; /**< Data of the current entry */
+    uint32_t            entriesWritten; /**< Number of entries written by current download */
+    uint16_t            errorIndex;     /**< Index of the entry, which failed, or 0 */
+    uint8_t             errorSubIndex;  /**< Sub-index of the entry, which failed */
+}CO_DCF_t;
+
+
+/**
+ * Concise DCF builder on the master.
+ */
+typedef struct{
+    uint8_t            *buffer;         /**< From CO_DCFwriter_init() */
+    uint32_t            bufferSize;     /**< From CO_DCFwriter_init() */
+    uint32_t            length;         /**< Length of the stream in buffer */
+    uint32_t            count;          /**< Number of entries in the stream */
+}CO_DCFwriter_t;
+
+
+/**
+ * Initialize concise DCF object on the node.
+ *
+ * Function must be called in the communication reset section, after
+ * CO_SDO_init().
+ *
+ * @param DCF This object will be initialized.
+ * @param SDO SDO server object.
+ * @param index Index of the concise DCF domain in Object dictionary, for
+ * example 0x1F22. It must be writeable. Subindex is not verified.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_DCF_init(
+        CO_DCF_t               *DCF,
+        CO_SDO_t               *SDO,
+        uint16_t                index);
+
+
+/**
+ * Start a new concise DCF stream.
+ *
+ * @param writer This object will be initialized.
+ * @param buffer Buffer for the stream. It is downloaded directly from here.
+ * @param bufferSize Size of the buffer, at least 4 bytes.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_DCFwriter_init(
+        CO_DCFwriter_t         *writer,
+        uint8_t                *buffer,
+        uint32_t                bufferSize);
+
+
+/**
+ * Add entry to the concise DCF stream.
+ *
+ * @param writer This object.
+ * @param index Index of the object on the node.
+ * @param subIndex Sub-index of the object on the node.
+ * @param data Data in CANopen (little endian) byte order.
+ * @param size Size of data.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_OUT_OF_MEMORY, if the buffer is full. Stream is unchanged on error.
+ */
+CO_ReturnError_t CO_DCFwriter_add(
+        CO_DCFwriter_t         *writer,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        const uint8_t          *data,
+        uint32_t                size);
+
+
+/**
+ * Add numeric entry to the concise DCF stream.
+ *
+ * @param writer This object.
+ * @param index Index of the object on the node.
+ * @param subIndex Sub-index of the object on the node.
+ * @param value Value, converted to little endian.
+ * @param size Size of the object, 1 to 4 bytes.
+ *
+ * @return Same as CO_DCFwriter_add().
+ */
+CO_ReturnError_t CO_DCFwriter_addValue(
+        CO_DCFwriter_t         *writer,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint32_t                value,
+        uint8_t                 size);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
@@ -108,8 +108,26 @@ static void CO_DaisyConsumer_receive(void *object, const CO_CANrxMsg_t *msg)
 
     DaisyConsumer = (CO_DaisyConsumer_t*)object; /* this is the correct pointer type of the first argument */
 
+    if (msg->DLC==2 && DaisyConsumer->bulkActive) {
+        /* bulk mode, record event into table */
+        uint8_t count = DaisyConsumer->bulkCount;
+
+        if (count < DaisyConsumer->bulkSize) {
+            DaisyConsumer->bulkTable[count].shiftCount = msg->data[0];
+            DaisyConsumer->bulkTable[count].nodeId = msg->data[1];
+            CANrxMemoryBarrier();
+            DaisyConsumer->bulkCount = count + 1;
+        }
+        else if (DaisyConsumer->bulkLost < 0xFF) {
+            DaisyConsumer->bulkLost ++;
+        }
+
+        if(DaisyConsumer->pFunctSignal != NULL) {
+            DaisyConsumer->pFunctSignal(DaisyConsumer->functSignalObject);
+        }
+    }
     /* verify message length and message overflow (previous message was not processed yet) */
-    if(msg->DLC==2 && !IS_CANrxNew(DaisyConsumer->CANrxNew)) {
+    else if(msg->DLC==2 && !IS_CANrxNew(DaisyConsumer->CANrxNew)) {
         /* copy data and set 'new message' flag */
         DaisyConsumer->CANrxData[0] = msg->data[0];
         DaisyConsumer->CANrxData[1] = msg->data[1];
@@ -163,6 +181,12 @@ CO_ReturnError_t CO_DaisyConsumer_init(
     CO_memset(DaisyConsumer->CANrxData, 0, sizeof(DaisyConsumer->CANrxData));
     DaisyConsumer->pFunctSignal = NULL;
     DaisyConsumer->functSignalObject = NULL;
+    DaisyConsumer->bulkActive = false;
+    DaisyConsumer->bulkTable = NULL;
+    DaisyConsumer->bulkSize = 0;
+    DaisyConsumer->bulkCount = 0;
+    DaisyConsumer->bulkLost = 0;
+    DaisyConsumer->bulkSeen = 0;
 
     /* configure daisychain consumer message reception */
     CO_CANrxBufferInit(
@@ -226,4 +250,113 @@ CO_DaisyConsumer_return_t CO_DaisyConsumer_waitEvent(
     return ret;
 }
 
+CO_ReturnError_t CO_DaisyConsumer_bulkStart(
+        CO_DaisyConsumer_t        *DaisyConsumer,
+        CO_DaisyConsumer_event_t  *table,
+        uint8_t                    size)
+{
+    if (DaisyConsumer==NULL || table==NULL || size==0){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    DaisyConsumer->bulkActive = false;
+    DaisyConsumer->bulkTable = table;
+    DaisyConsumer->bulkSize = size;
+    DaisyConsumer->bulkCount = 0;
+    DaisyConsumer->bulkLost = 0;
+    DaisyConsumer->bulkSeen = 0;
+    DaisyConsumer->timeoutTimer = 0;
+    CLEAR_CANrxNew(DaisyConsumer->CANrxNew);
+    /* activate as last, receive function may be called any time */
+    CANrxMemoryBarrier();
+    DaisyConsumer->bulkActive = true;
+
+    return CO_ERROR_NO;
+}
+
+void CO_DaisyConsumer_bulkStop(
+        CO_DaisyConsumer_t  *DaisyConsumer)
+{
+    if (DaisyConsumer != NULL) {
+        DaisyConsumer->bulkActive = false;
+    }
+}
+
+CO_DaisyConsumer_return_t CO_DaisyConsumer_bulkWait(
+        CO_DaisyConsumer_t  *DaisyConsumer,
+        uint16_t             timeDifference_ms,
+        uint8_t              expected,
+        uint8_t             *count)
+{
+    CO_DaisyConsumer_return_t ret;
+    uint8_t received;
+
+    if (DaisyConsumer==NULL){
+        return CO_DaisyConsumer_TIMEOUT;
+    }
+
+    received = DaisyConsumer->bulkCount;
+    if (count != NULL) {
+        *count = received;
+    }
+
+    if (expected != 0 &&
+        (received >= expected || DaisyConsumer->bulkLost != 0)) {
+        ret = CO_DaisyConsumer_OK;
+    }
+    else if (received != DaisyConsumer->bulkSeen) {
+        /* chain is still progressing */
+        DaisyConsumer->bulkSeen = received;
+        DaisyConsumer->timeoutTimer = 0;
+        ret = CO_DaisyConsumer_WAIT;
+    }
+    else {
+        ret = CO_DaisyConsumer_check_timeout(DaisyConsumer, timeDifference_ms);
+        if (ret == CO_DaisyConsumer_TIMEOUT && expected == 0) {
+            ret = CO_DaisyConsumer_OK;
+        }
+    }
+
+    return ret;
+}
+
+CO_DaisyConsumer_return_t CO_DaisyConsumer_bulkVerify(
+        CO_DaisyConsumer_t  *DaisyConsumer,
+        uint8_t              expected)
+{
+    uint8_t seen[16];
+    uint8_t count;
+    uint8_t i;
+
+    if (DaisyConsumer==NULL || DaisyConsumer->bulkTable==NULL){
+        return CO_DaisyConsumer_TIMEOUT;
+    }
+
+    count = DaisyConsumer->bulkCount;
+    if (DaisyConsumer->bulkLost != 0 || (expected != 0 && count > expected)) {
+        return CO_DaisyConsumer_OVERFLOW;
+    }
+    if (count < expected) {
+        return CO_DaisyConsumer_TIMEOUT;
+    }
+
+    /* each node must appear once with a valid node ID */
+    CO_memset(seen, 0, sizeof(seen));
+    for (i = 0; i < count; i++) {
+        const CO_DaisyConsumer_event_t *ev = &DaisyConsumer->bulkTable[i];
+        uint8_t mask;
+
+        if (ev->nodeId < 1 || ev->nodeId > 127 || ev->shiftCount == 0) {
+            return CO_DaisyConsumer_INVALID;
+        }
+        mask = (uint8_t)(1U << (ev->nodeId & 7U));
+        if ((seen[ev->nodeId >> 3] & mask) != 0) {
+            return CO_DaisyConsumer_INVALID;
+        }
+        seen[ev->nodeId >> 3] |= mask;
+    }
+
+    return CO_DaisyConsumer_OK;
+}
+
 #endif
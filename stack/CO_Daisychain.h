@@ -78,6 +78,11 @@ extern "C" {
  * For this, the following CAN message is used:
  * COB ID | Byte0          | Byte1
  * 0x6DF  | Event Counter  | own Node DI
+ *
+ * For long chains, the consumer supports a bulk mode. Shift pulses can then
+ * be issued back-to-back without waiting for each event. All received events
+ * are recorded into a table in order of reception and verified afterwards,
+ * see #CO_DaisyConsumer_bulkStart().
  */
 
 #if CO_DAISY_PRODUCER == 1
@@ -143,8 +148,18 @@ typedef enum {
     CO_DaisyConsumer_WAIT                = 1,    /**< No response arrived from producer yet */
     CO_DaisyConsumer_OK                  = 0,    /**< Success, end of communication */
     CO_DaisyConsumer_TIMEOUT             = -1,   /**< No reply received */
+    CO_DaisyConsumer_OVERFLOW            = -2,   /**< Bulk mode: more events received than table size */
+    CO_DaisyConsumer_INVALID             = -3,   /**< Bulk mode: invalid or duplicate node ID received */
 } CO_DaisyConsumer_return_t;
 
+/**
+ * Daisychain event, recorded in bulk mode.
+ */
+typedef struct{
+    uint8_t          shiftCount;       /**< Event counter of the producer */
+    uint8_t          nodeId;           /**< Node ID of the producer */
+}CO_DaisyConsumer_event_t;
+
 /**
  * Daisychain Consumer object.
  */
@@ -158,6 +173,13 @@ typedef struct{
 
   void           (*pFunctSignal)(void *object); /**< From CO_DaisyConsumer_initCallback() or NULL */
   void            *functSignalObject;/**< Pointer to object */
+
+  volatile bool_t  bulkActive;       /**< True while bulk mode is active */
+  CO_DaisyConsumer_event_t *bulkTable; /**< From CO_DaisyConsumer_bulkStart() */
+  uint8_t          bulkSize;         /**< Number of entries in bulkTable */
+  volatile uint8_t bulkCount;        /**< Number of events recorded into bulkTable */
+  volatile uint8_t bulkLost;         /**< Number of events, which did not fit into bulkTable */
+  uint8_t          bulkSeen;         /**< bulkCount at previous call to CO_DaisyConsumer_bulkWait() */
 }CO_DaisyConsumer_t;
 
 /**
@@ -224,6 +246,74 @@ CO_DaisyConsumer_return_t CO_DaisyConsumer_waitEvent(
         uint8_t             *shiftCount,
         uint8_t             *nodeId);
 
+/**
+ * Start daisychain bulk mode
+ *
+ * All following daisychain events are recorded into table in order of
+ * reception, directly from the CAN receive function.
+ * CO_DaisyConsumer_waitEvent() does not return events while bulk mode is
+ * active.
+ *
+ * @param DaisyConsumer This object.
+ * @param table Table for received events, must stay valid until
+ * CO_DaisyConsumer_bulkStop() is called.
+ * @param size Number of entries in table.
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_DaisyConsumer_bulkStart(
+        CO_DaisyConsumer_t        *DaisyConsumer,
+        CO_DaisyConsumer_event_t  *table,
+        uint8_t                    size);
+
+/**
+ * Stop daisychain bulk mode
+ *
+ * Table is not accessed any more after this call, recorded entries are kept.
+ *
+ * @param DaisyConsumer This object.
+ */
+void CO_DaisyConsumer_bulkStop(
+        CO_DaisyConsumer_t  *DaisyConsumer);
+
+/**
+ * Wait for daisychain events in bulk mode
+ *
+ * Timeout is restarted at every received event, so it is the maximum time
+ * between two consecutive events of the chain.
+ *
+ * @param DaisyConsumer This object.
+ * @param timeDifference_ms Time difference from previous function call in
+ * [milliseconds]. Zero when request is started.
+ * @param expected Number of expected events. If zero, events are collected
+ * until timeout expires.
+ * @param [out] count Number of recorded events. Can be NULL.
+ * @return #CO_DaisyConsumer_return_t: CO_DaisyConsumer_WAIT,
+ * CO_DaisyConsumer_OK when expected number of events is received or timeout
+ * expired with expected zero, CO_DaisyConsumer_TIMEOUT when timeout expired
+ * before all expected events were received.
+ */
+CO_DaisyConsumer_return_t CO_DaisyConsumer_bulkWait(
+        CO_DaisyConsumer_t  *DaisyConsumer,
+        uint16_t             timeDifference_ms,
+        uint8_t              expected,
+        uint8_t             *count);
+
+/**
+ * Verify events recorded in bulk mode
+ *
+ * Should be called after CO_DaisyConsumer_bulkStop().
+ *
+ * @param DaisyConsumer This object.
+ * @param expected Number of expected events or zero if unknown.
+ * @return #CO_DaisyConsumer_return_t: CO_DaisyConsumer_OK,
+ * CO_DaisyConsumer_OVERFLOW if events were lost or more than expected were
+ * received, CO_DaisyConsumer_TIMEOUT if less than expected were received,
+ * CO_DaisyConsumer_INVALID if a node ID is invalid or received twice.
+ */
+CO_DaisyConsumer_return_t CO_DaisyConsumer_bulkVerify(
+        CO_DaisyConsumer_t  *DaisyConsumer,
+        uint8_t              expected);
+
 /** @} */
 
 #endif //CO_DAISY_CONSUMER
@@ -0,0 +1,233 @@
+/*
+ * CANopen Emergency consumer with history of each node.
+ *
+ * @file        CO_EMconsumer.c
+ * @ingroup     CO_EMconsumer
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include <string.h>
+
+#include "CANopen.h"
+#include "CO_EMconsumer.h"
+
+#if CO_NO_EM_CONS == 1
+
+/*
+ * Read received message from CAN module.
+ *
+ * Function will be called (by CAN receive interrupt) every time, when CAN
+ * message with correct identifier will be received. For more information and
+ * description of parameters see file CO_driver.h.
+ */
+static void CO_EMconsumer_receive(void *object, const CO_CANrxMsg_t *msg){
+    CO_EMconsumer_t *EMcons;
+    CO_EMconsumerNode_t *node;
+    CO_EMconsumerEntry_t *entry;
+    uint8_t nodeId;
+
+    EMcons = (CO_EMconsumer_t*)object;   /* this is the correct pointer type of the first argument */
+    nodeId = (uint8_t)(CO_CANrxMsg_readIdent(msg) & 0x7FU);
+
+    /* identifier 0x080 is SYNC, own messages are not monitored */
+    if(nodeId == 0U || nodeId == EMcons->nodeId || msg->DLC != 8U){
+        return;
+    }
+
+    node = &EMcons->node[nodeId - 1U];
+    CO_LOCK_OD();
+    entry = &node->history[node->count % CO_EM_CONS_HISTORY];
+    entry->errorCode = CO_getUint16(&msg->data[0]);
+    entry->errorRegister = msg->data[2];
+    entry->errorBit = msg->data[3];
+    entry->infoCode = CO_getUint32(&msg->data[4]);
+#ifdef CO_USE_STATISTICS
+    entry->timestamp_us = CO_STAT_RX_TIMESTAMP_US(msg);
+#else
+    entry->timestamp_us = EMcons->time_us;
+#endif
+    node->errorRegister = entry->errorRegister;
+    node->count++;
+    CO_UNLOCK_OD();
+
+    SET_CANrxNew(EMcons->CANrxGroupNew[(nodeId - 1U) / CO_EM_CONS_GROUP_SIZE]);
+}
+
+
+/*
+ * Count entries, which were overwritten before delivery, and skip them.
+ * Must be called inside CO_LOCK_OD().
+ */
+static void CO_EMconsumer_skipLost(CO_EMconsumerNode_t *node){
+    if((node->count - node->delivered) > CO_EM_CONS_HISTORY){
+        node->lost += node->count - node->delivered - CO_EM_CONS_HISTORY;
+        node->delivered = node->count - CO_EM_CONS_HISTORY;
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_EMconsumer_init(
+        CO_EMconsumer_t        *EMcons,
+        uint8_t                 nodeId,
+        CO_CANmodule_t         *CANdevRx,
+        uint16_t                CANdevRxIdx)
+{
+    uint8_t i;
+
+    /* verify arguments */
+    if(EMcons==NULL || CANdevRx==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    memset(EMcons->node, 0, sizeof(EMcons->node));
+    for(i=0; i<(sizeof(EMcons->CANrxGroupNew)/sizeof(EMcons->CANrxGroupNew[0])); i++){
+        CLEAR_CANrxNew(EMcons->CANrxGroupNew[i]);
+    }
+    EMcons->time_us = 0U;
+    EMcons->nodeId = nodeId;
+    EMcons->pFunctSignal = NULL;
+    EMcons->functSignalObject = NULL;
+
+    /* configure Emergency CAN reception for all node IDs */
+    return CO_CANrxBufferInit(
+            CANdevRx,               /* CAN device */
+            CANdevRxIdx,            /* rx buffer index */
+            CO_CAN_ID_EMERGENCY,    /* CAN identifier */
+            0x780,                  /* mask */
+            0,                      /* rtr */
+            (void*)EMcons,          /* object passed to receive function */
+            CO_EMconsumer_receive); /* this function will process received message */
+}
+
+
+/******************************************************************************/
+void CO_EMconsumer_initCallback(
+        CO_EMconsumer_t        *EMcons,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, const CO_EMconsumerEvent_t events[], uint16_t count))
+{
+    if(EMcons != NULL){
+        EMcons->pFunctSignal = pFunctSignal;
+        EMcons->functSignalObject = object;
+    }
+}
+
+
+/******************************************************************************/
+uint8_t CO_EMconsumer_getHistory(
+        CO_EMconsumer_t        *EMcons,
+        uint8_t                 nodeId,
+        CO_EMconsumerEntry_t    entries[],
+        uint8_t                 maxCount)
+{
+    CO_EMconsumerNode_t *node;
+    uint8_t n = 0U;
+
+    if(EMcons == NULL || entries == NULL || nodeId < 1U || nodeId > 127U){
+        return 0U;
+    }
+
+    node = &EMcons->node[nodeId - 1U];
+    CO_LOCK_OD();
+    while(n < maxCount && n < CO_EM_CONS_HISTORY && n < node->count){
+        entries[n] = node->history[(node->count - 1U - n) % CO_EM_CONS_HISTORY];
+        n++;
+    }
+    CO_UNLOCK_OD();
+
+    return n;
+}
+
+
+/******************************************************************************/
+void CO_EMconsumer_process(
+        CO_EMconsumer_t        *EMcons,
+        uint16_t                timeDifference_ms)
+{
+    uint8_t group;
+    uint16_t batchCount = 0U;
+
+    EMcons->time_us += (uint32_t)timeDifference_ms * 1000U;
+
+    for(group=0; group<(sizeof(EMcons->CANrxGroupNew)/sizeof(EMcons->CANrxGroupNew[0])); group++){
+        uint8_t i, last;
+
+        if(!IS_CANrxNew(EMcons->CANrxGroupNew[group])){
+            continue;
+        }
+        CLEAR_CANrxNew(EMcons->CANrxGroupNew[group]);
+
+        i = group * CO_EM_CONS_GROUP_SIZE;
+        last = (127U - i > CO_EM_CONS_GROUP_SIZE) ? (i + CO_EM_CONS_GROUP_SIZE) : 127U;
+        for(; i<last; i++){
+            CO_EMconsumerNode_t *node = &EMcons->node[i];
+
+            CO_LOCK_OD();
+            CO_EMconsumer_skipLost(node);
+            while(node->delivered != node->count){
+                if(EMcons->pFunctSignal != NULL){
+                    CO_EMconsumerEvent_t *event = &EMcons->batch[batchCount++];
+
+                    event->nodeId = i + 1U;
+                    event->entry = node->history[node->delivered % CO_EM_CONS_HISTORY];
+                }
+                node->delivered++;
+
+                /* deliver full batch outside of the lock */
+                if(batchCount == CO_EM_CONS_BATCH_SIZE){
+                    CO_UNLOCK_OD();
+                    EMcons->pFunctSignal(EMcons->functSignalObject, EMcons->batch, batchCount);
+                    batchCount = 0U;
+                    CO_LOCK_OD();
+                    CO_EMconsumer_skipLost(node);
+                }
+            }
+            CO_UNLOCK_OD();
+        }
+    }
+
+    if(batchCount > 0U){
+        EMcons->pFunctSignal(EMcons->functSignalObject, EMcons->batch, batchCount);
+    }
+}
+
+#endif /* CO_NO_EM_CONS == 1 */
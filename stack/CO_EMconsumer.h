@@ -0,0 +1,240 @@
+/**
+ * CANopen Emergency consumer with history of each node.
+ *
+ * @file        CO_EMconsumer.h
+ * @ingroup     CO_EMconsumer
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+
+#ifndef CO_EMconsumer_H
+#define CO_EMconsumer_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CO_NO_EM_CONS == 1
+
+/**
+ * @defgroup CO_EMconsumer Emergency consumer
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * Emergency consumer receives emergency messages of all node IDs with a single
+ * receive buffer (COB ID 0x081 to 0x0FF, CAN identifier 0x080 is SYNC).
+ *
+ * Receive callback stores each message with its reception time in the
+ * history of the sending node, a ring of #CO_EM_CONS_HISTORY entries, and
+ * counts it. In a fault storm the oldest entries are overwritten, counters
+ * still count all messages. Nodes with new entries are signalled per group of
+ * #CO_EM_CONS_GROUP_SIZE node IDs, like in the Heartbeat consumer.
+ *
+ * CO_EMconsumer_process() collects the new entries of all nodes and delivers
+ * them to the application in batches of up to #CO_EM_CONS_BATCH_SIZE events
+ * with one callback call, see CO_EMconsumer_initCallback(). Entries, which
+ * were overwritten before they were delivered, are counted in
+ * CO_EMconsumerNode_t::lost. History of a node can also be read at any time
+ * with CO_EMconsumer_getHistory().
+ *
+ * History is written inside CO_LOCK_OD() from the receive callback, so the
+ * lock must be usable from the CAN receive context.
+ */
+
+
+/**
+ * Number of history entries per node, power of two.
+ */
+#ifndef CO_EM_CONS_HISTORY
+#define CO_EM_CONS_HISTORY          4U
+#endif
+
+/**
+ * Maximum number of events per call of the batch callback.
+ */
+#ifndef CO_EM_CONS_BATCH_SIZE
+#define CO_EM_CONS_BATCH_SIZE       16U
+#endif
+
+/**
+ * Number of node IDs, which share one receive indication flag.
+ */
+#define CO_EM_CONS_GROUP_SIZE       8U
+
+
+/**
+ * Received emergency message.
+ */
+typedef struct{
+    uint16_t            errorCode;      /**< Emergency error code, 0 for error reset */
+    uint8_t             errorRegister;  /**< Error register of the node */
+    uint8_t             errorBit;       /**< Byte 3, error status bit in CANopenNode devices */
+    uint32_t            infoCode;       /**< Bytes 4 to 7, manufacturer specific */
+    /** Reception time in microseconds, from CO_STAT_RX_TIMESTAMP_US(), if
+     * CO_USE_STATISTICS is defined, else from CO_EMconsumer_process() calls */
+    uint32_t            timestamp_us;
+}CO_EMconsumerEntry_t;
+
+
+/**
+ * Emergency message of a node, delivered to the batch callback.
+ */
+typedef struct{
+    uint8_t             nodeId;         /**< Node ID of the producer */
+    CO_EMconsumerEntry_t entry;         /**< Message */
+}CO_EMconsumerEvent_t;
+
+
+/**
+ * History and counters of one node.
+ */
+typedef struct{
+    /** Ring of the last messages, written by the receive callback */
+    CO_EMconsumerEntry_t history[CO_EM_CONS_HISTORY];
+    /** Number of received messages, next entry is history[count % #CO_EM_CONS_HISTORY] */
+    uint32_t            count;
+    /** Value of count, up to which messages were delivered */
+    uint32_t            delivered;
+    /** Number of messages overwritten before delivery */
+    uint32_t            lost;
+    /** Error register from the last message */
+    uint8_t             errorRegister;
+}CO_EMconsumerNode_t;
+
+
+/**
+ * Emergency consumer object.
+ */
+typedef struct{
+    /** History of each node ID, index is node ID - 1 */
+    CO_EMconsumerNode_t node[127];
+    /** Indication if new message received for one of the nodes in group of
+        #CO_EM_CONS_GROUP_SIZE node IDs */
+    volatile void      *CANrxGroupNew[(127U + CO_EM_CONS_GROUP_SIZE - 1U) / CO_EM_CONS_GROUP_SIZE];
+    /** Time in microseconds, accumulated from CO_EMconsumer_process() calls */
+    uint32_t            time_us;
+    /** Own node ID, from CO_EMconsumer_init() */
+    uint8_t             nodeId;
+    /** Events collected by CO_EMconsumer_process() */
+    CO_EMconsumerEvent_t batch[CO_EM_CONS_BATCH_SIZE];
+    /** Callback for received messages */
+    void              (*pFunctSignal)(void *object, const CO_EMconsumerEvent_t events[], uint16_t count); /**< From CO_EMconsumer_initCallback() or NULL */
+    void               *functSignalObject;/**< Pointer to object */
+}CO_EMconsumer_t;
+
+
+/**
+ * Initialize Emergency consumer object.
+ *
+ * Function must be called in the communication reset section. History is
+ * cleared.
+ *
+ * @param EMcons This object will be initialized.
+ * @param nodeId Node ID of this node, its messages are ignored.
+ * @param CANdevRx CAN device for Emergency reception.
+ * @param CANdevRxIdx Index of receive buffer in the above CAN device.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_EMconsumer_init(
+        CO_EMconsumer_t        *EMcons,
+        uint8_t                 nodeId,
+        CO_CANmodule_t         *CANdevRx,
+        uint16_t                CANdevRxIdx);
+
+
+/**
+ * Initialize Emergency consumer batch callback function.
+ *
+ * Callback is called from CO_EMconsumer_process() with all new messages, in
+ * order of node ID and then in order of reception, up to
+ * #CO_EM_CONS_BATCH_SIZE messages per call. It is cleared by
+ * CO_EMconsumer_init().
+ *
+ * @param EMcons This object.
+ * @param object Pointer to object, which will be passed to pFunctSignal(). Can be NULL
+ * @param pFunctSignal Pointer to the callback function. Not called if NULL.
+ */
+void CO_EMconsumer_initCallback(
+        CO_EMconsumer_t        *EMcons,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, const CO_EMconsumerEvent_t events[], uint16_t count));
+
+
+/**
+ * Get history of a node.
+ *
+ * @param EMcons This object.
+ * @param nodeId Node ID 1..127.
+ * @param [out] entries Messages, newest first.
+ * @param maxCount Size of entries.
+ *
+ * @return Number of messages copied into entries.
+ */
+uint8_t CO_EMconsumer_getHistory(
+        CO_EMconsumer_t        *EMcons,
+        uint8_t                 nodeId,
+        CO_EMconsumerEntry_t    entries[],
+        uint8_t                 maxCount);
+
+
+/**
+ * Process Emergency consumer object.
+ *
+ * Function must be called cyclically. It delivers new messages to the batch
+ * callback. If no callback is set, messages are only kept in the history.
+ *
+ * @param EMcons This object.
+ * @param timeDifference_ms Time difference from previous function call in [milliseconds].
+ */
+void CO_EMconsumer_process(
+        CO_EMconsumer_t        *EMcons,
+        uint16_t                timeDifference_ms);
+
+
+/** @} */
+
+#endif /* CO_NO_EM_CONS == 1 */
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+#endif
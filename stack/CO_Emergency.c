@@ -119,6 +119,237 @@ static CO_SDO_abortCode_t CO_ODF_1014(CO_ODF_arg_t *ODF_arg){
 }
 
 
+/* Read error status bits, which may be concurrently modified by CO_errorReport() */
+#ifdef CO_EM_LOCKFREE_FIFO
+    #define CO_EM_STATUS_BITS(em, i)    __atomic_load_n(&(em)->errorStatusBits[i], __ATOMIC_RELAXED)
+#else
+    #define CO_EM_STATUS_BITS(em, i)    ((em)->errorStatusBits[i])
+#endif
+
+
+#ifdef CO_EM_LOCKFREE_FIFO
+/*
+ * Lock-free FIFO for emergency messages.
+ *
+ * Bounded queue with a sequence number in each entry. Producers reserve an
+ * entry by advancing fifoWrite with compare and swap and then publish it by
+ * writing its sequence number. Entry at position pos is free, if its sequence
+ * number is pos, and written, if it is pos+1. Single consumer releases the
+ * entry for the next round by writing pos+CO_EM_INTERNAL_BUFFER_SIZE.
+ */
+static void CO_EM_fifoInit(CO_EM_t *em){
+    uint32_t i;
+
+    for(i=0U; i<CO_EM_INTERNAL_BUFFER_SIZE; i++){
+        em->fifo[i].seq = i;
+    }
+    em->fifoRead = 0U;
+    em->fifoOverflow = 0U;
+    __atomic_store_n(&em->fifoWrite, 0U, __ATOMIC_RELEASE);
+}
+
+/* Write message into the FIFO, return false if FIFO is full. */
+static bool_t CO_EM_fifoPush(CO_EM_t *em, const uint8_t data[]){
+    CO_EM_fifoEntry_t *entry;
+    uint32_t pos = __atomic_load_n(&em->fifoWrite, __ATOMIC_RELAXED);
+
+    for(;;){
+        uint32_t seq;
+        int32_t diff;
+
+        entry = &em->fifo[pos & (CO_EM_INTERNAL_BUFFER_SIZE - 1U)];
+        seq = __atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE);
+        diff = (int32_t)(seq - pos);
+
+        if(diff == 0){
+            /* entry is free, try to reserve it, pos is updated on failure */
+            if(__atomic_compare_exchange_n(&em->fifoWrite, &pos, pos + 1U,
+                    true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+                break;
+            }
+        }
+        else if(diff < 0){
+            /* entry was not yet read by CO_EM_process() */
+            return false;
+        }
+        else{
+            /* other producer was faster */
+            pos = __atomic_load_n(&em->fifoWrite, __ATOMIC_RELAXED);
+        }
+    }
+
+    CO_memcpy(entry->data, data, 8U);
+    __atomic_store_n(&entry->seq, pos + 1U, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+/* Return oldest written message or NULL, if FIFO is empty. */
+static uint8_t *CO_EM_fifoPeek(CO_EM_t *em){
+    CO_EM_fifoEntry_t *entry = &em->fifo[em->fifoRead & (CO_EM_INTERNAL_BUFFER_SIZE - 1U)];
+
+    if(__atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE) != (em->fifoRead + 1U)){
+        return NULL;
+    }
+    return entry->data;
+}
+
+/* Release message returned by CO_EM_fifoPeek(). */
+static void CO_EM_fifoPop(CO_EM_t *em){
+    CO_EM_fifoEntry_t *entry = &em->fifo[em->fifoRead & (CO_EM_INTERNAL_BUFFER_SIZE - 1U)];
+
+    __atomic_store_n(&entry->seq, em->fifoRead + CO_EM_INTERNAL_BUFFER_SIZE, __ATOMIC_RELEASE);
+    em->fifoRead++;
+}
+#endif
+
+
+/* Return oldest message written by CO_errorReport() or NULL, if buffer is empty. */
+static uint8_t *CO_EM_bufPeek(CO_EM_t *em){
+#ifdef CO_EM_LOCKFREE_FIFO
+    return CO_EM_fifoPeek(em);
+#else
+    return (em->bufReadPtr != em->bufWritePtr || em->bufFull) ? em->bufReadPtr : NULL;
+#endif
+}
+
+/* Remove message returned by CO_EM_bufPeek(), return true if messages were
+ * lost since the previous call, because buffer was full. */
+static bool_t CO_EM_bufPop(CO_EM_t *em){
+#ifdef CO_EM_LOCKFREE_FIFO
+    CO_EM_fifoPop(em);
+    return __atomic_exchange_n(&em->fifoOverflow, 0U, __ATOMIC_RELAXED) != 0U;
+#else
+    bool_t overflow = (em->bufFull == 2U);
+
+    em->bufReadPtr += 8;
+    if(em->bufReadPtr == em->bufEnd){
+        em->bufReadPtr = em->buf;
+    }
+    em->bufFull = 0U;
+    return overflow;
+#endif
+}
+
+/* Write messages to 'pre-defined error field' (object dictionary, index 0x1003).
+ * preDEF contains count messages, the last one is the newest. */
+static void CO_EM_preDefErrAdd(CO_EMpr_t *emPr, const uint32_t preDEF[], uint8_t count){
+    uint8_t i;
+
+    if(emPr->preDefErr == NULL || emPr->preDefErrSize == 0U || count == 0U){
+        return;
+    }
+    if(count > emPr->preDefErrSize){
+        preDEF += count - emPr->preDefErrSize;
+        count = emPr->preDefErrSize;
+    }
+
+    /* shift older errors only once for all new ones */
+    if(emPr->preDefErrNoOfErrors < (emPr->preDefErrSize - count))
+        emPr->preDefErrNoOfErrors += count;
+    else
+        emPr->preDefErrNoOfErrors = emPr->preDefErrSize;
+    for(i=emPr->preDefErrNoOfErrors; i>count; i--)
+        emPr->preDefErr[i-1] = emPr->preDefErr[i-1-count];
+    for(i=0; i<count; i++)
+        emPr->preDefErr[i] = preDEF[count-1-i];
+}
+
+#ifdef CO_EM_COALESCE
+/* Return newest or oldest pending message or NULL. */
+static CO_EM_pending_t *CO_EM_pendingFind(CO_EMpr_t *emPr, bool_t newest){
+    CO_EM_pending_t *found = NULL;
+    uint8_t i;
+
+    for(i=0U; i<CO_EM_COALESCE_SIZE; i++){
+        CO_EM_pending_t *p = &emPr->pending[i];
+
+        if(p->count != 0U && (found == NULL ||
+           (newest ? (int32_t)(p->stamp - found->stamp) > 0 : (int32_t)(p->stamp - found->stamp) < 0)))
+        {
+            found = p;
+        }
+    }
+    return found;
+}
+
+/*
+ * Move all messages from the buffer into the list of pending messages.
+ *
+ * Pending list contains at most one message per error bit: its latest state
+ * (error or reset) with the number of coalesced reports. If list is full, the
+ * oldest message is dropped. All moved messages are written to 0x1003 at once.
+ * Outside NMT pre-operational and operational messages stay in the buffer,
+ * as without coalescing, so 0x1003 gets only messages, which can be sent.
+ */
+static void CO_EM_coalesce(CO_EMpr_t *emPr, bool_t NMTisPreOrOperational){
+    CO_EM_t *em = emPr->em;
+    uint32_t preDEF[CO_EM_INTERNAL_BUFFER_SIZE];
+    uint8_t count = 0U;
+    bool_t lost = false;
+    uint8_t *msg;
+
+    if(!NMTisPreOrOperational){
+        return;
+    }
+
+    while((msg = CO_EM_bufPeek(em)) != NULL){
+        CO_EM_pending_t *entry = NULL;
+        CO_EM_pending_t *oldest = NULL;
+        uint8_t i;
+
+        msg[2] = *emPr->errorRegister;
+        if(count == CO_EM_INTERNAL_BUFFER_SIZE){
+            CO_EM_preDefErrAdd(emPr, preDEF, count);
+            count = 0U;
+        }
+        CO_memcpy((uint8_t*)&preDEF[count++], msg, 4U);
+
+        /* find entry with the same error bit, else free or oldest entry */
+        for(i=0U; i<CO_EM_COALESCE_SIZE; i++){
+            CO_EM_pending_t *p = &emPr->pending[i];
+
+            if(p->count == 0U){
+                if(entry == NULL) entry = p;
+            }
+            else if(p->data[3] == msg[3]){
+                entry = p;
+                break;
+            }
+            else if(oldest == NULL || (int32_t)(p->stamp - oldest->stamp) < 0){
+                oldest = p;
+            }
+        }
+
+        if(entry != NULL && entry->count != 0U){
+            /* coalesce with the previous report of the same error bit */
+            if(entry->count < 0xFFU) entry->count++;
+        }
+        else{
+            if(entry == NULL){
+                entry = oldest;
+                lost = true;
+            }
+            entry->count = 1U;
+        }
+        CO_memcpy(entry->data, msg, 8U);
+        entry->stamp = ++emPr->pendingStamp;
+
+        if(CO_EM_bufPop(em)){
+            lost = true;
+        }
+    }
+
+    CO_EM_preDefErrAdd(emPr, preDEF, count);
+
+    /* reported error is moved to the pending list with the next call */
+    if(lost){
+        CO_errorReport(em, CO_EM_EMERGENCY_BUFFER_FULL, CO_EMC_GENERIC, 0U);
+    }
+}
+#endif
+
+
 /******************************************************************************/
 CO_ReturnError_t CO_EM_init(
         CO_EM_t                *em,
@@ -144,10 +375,14 @@ CO_ReturnError_t CO_EM_init(
     /* Configure object variables */
     em->errorStatusBits         = errorStatusBits;
     em->errorStatusBitsSize     = errorStatusBitsSize;
+#ifdef CO_EM_LOCKFREE_FIFO
+    CO_EM_fifoInit(em);
+#else
     em->bufEnd                  = em->buf + (CO_EM_INTERNAL_BUFFER_SIZE * 8);
     em->bufWritePtr             = em->buf;
     em->bufReadPtr              = em->buf;
     em->bufFull                 = 0U;
+#endif
     em->wrongErrorReport        = 0U;
     em->pFunctSignal            = NULL;
     emPr->em                    = em;
@@ -156,6 +391,14 @@ CO_ReturnError_t CO_EM_init(
     emPr->preDefErrSize         = preDefErrSize;
     emPr->preDefErrNoOfErrors   = 0U;
     emPr->inhibitEmTimer        = 0U;
+#ifdef CO_EM_COALESCE
+    for(i=0U; i<CO_EM_COALESCE_SIZE; i++){
+        emPr->pending[i].count = 0U;
+    }
+    emPr->pendingStamp          = 0U;
+    emPr->coalescedCount        = 0U;
+    emPr->newestSent            = 0U;
+#endif
 
     /* clear error status bits */
     for(i=0U; i<errorStatusBitsSize; i++){
@@ -204,6 +447,12 @@ void CO_EM_process(
     CO_EM_t *em = emPr->em;
     uint8_t errorRegister;
     uint8_t errorMask;
+    uint8_t *msg;
+#ifdef CO_EM_COALESCE
+    CO_EM_pending_t *pending;
+#else
+    bool_t overflow;
+#endif
     uint8_t i;
 
     /* verify errors from driver and other */
@@ -218,16 +467,16 @@ void CO_EM_process(
     errorRegister = 0U;
     errorMask = (uint8_t)~(CO_ERR_REG_GENERIC_ERR | CO_ERR_REG_COMM_ERR | CO_ERR_REG_MANUFACTURER);
     /* generic error */
-    if(em->errorStatusBits[5]){
+    if(CO_EM_STATUS_BITS(em, 5)){
         errorRegister |= CO_ERR_REG_GENERIC_ERR;
     }
     /* communication error (overrun, error state) */
-    if(em->errorStatusBits[2] || em->errorStatusBits[3]){
+    if(CO_EM_STATUS_BITS(em, 2) || CO_EM_STATUS_BITS(em, 3)){
         errorRegister |= CO_ERR_REG_COMM_ERR;
     }
     /* Manufacturer */
     for(i=6; i<em->errorStatusBitsSize; i++) {
-        if (em->errorStatusBits[i]) {
+        if (CO_EM_STATUS_BITS(em, i)) {
             errorRegister |= CO_ERR_REG_MANUFACTURER;
         }
     }
@@ -238,51 +487,70 @@ void CO_EM_process(
         emPr->inhibitEmTimer += timeDifference_100us;
     }
 
+#ifdef CO_EM_COALESCE
+    /* move new messages into the list of pending messages. Newest message
+     * is sent first, but each CO_EM_COALESCE_OLDEST-th the oldest one, so
+     * old errors are not starved by a storm of new ones. */
+    CO_EM_coalesce(emPr, NMTisPreOrOperational);
+    pending = CO_EM_pendingFind(emPr, emPr->newestSent < (CO_EM_COALESCE_OLDEST - 1U));
+    msg = (pending != NULL) ? pending->data : NULL;
+#else
+    /* oldest unsent emergency message */
+    msg = CO_EM_bufPeek(em);
+#endif
+
     /* send Emergency message. */
     if(     NMTisPreOrOperational &&
             !emPr->CANtxBuff->bufferFull &&
-            (em->bufReadPtr != em->bufWritePtr || em->bufFull))
+            msg != NULL)
     {
-        uint32_t preDEF;    /* preDefinedErrorField */
         uint16_t diff;
         
         if (emPr->inhibitEmTimer >= emInhTime) {
             /* inhibit time elapsed, send message */
+#ifdef CO_EM_COALESCE
+            /* error register is updated, messages were already written to 0x1003 */
+            msg[2] = *emPr->errorRegister;
+            CO_memcpy(emPr->CANtxBuff->data, msg, 8U);
+            emPr->coalescedCount += pending->count - 1U;
+            pending->count = 0U;
+            emPr->inhibitEmTimer = 0U;
+            if(emPr->newestSent < (CO_EM_COALESCE_OLDEST - 1U)){
+                emPr->newestSent++;
+            }
+            else{
+                emPr->newestSent = 0U;
+            }
+
+            /* mark buffer overflow solved, when all pending messages are sent */
+            if(CO_EM_pendingFind(emPr, true) == NULL){
+                CO_errorReset(em, CO_EM_EMERGENCY_BUFFER_FULL, 0);
+            }
+#else
+            uint32_t preDEF;    /* preDefinedErrorField */
 
             /* add error register */
-            em->bufReadPtr[2] = *emPr->errorRegister;
+            msg[2] = *emPr->errorRegister;
 
             /* copy data to CAN emergency message */
-            CO_memcpy(emPr->CANtxBuff->data, em->bufReadPtr, 8U);
-            CO_memcpy((uint8_t*)&preDEF, em->bufReadPtr, 4U);
-            em->bufReadPtr += 8;
+            CO_memcpy(emPr->CANtxBuff->data, msg, 8U);
+            CO_memcpy((uint8_t*)&preDEF, msg, 4U);
 
-            /* Update read buffer pointer and reset inhibit timer */
-            if(em->bufReadPtr == em->bufEnd){
-                em->bufReadPtr = em->buf;
-            }
+            /* Update read position and reset inhibit timer */
+            overflow = CO_EM_bufPop(em);
             emPr->inhibitEmTimer = 0U;
 
-            /* verify message buffer overflow, then clear full flag */
-            if(em->bufFull == 2U){
-                em->bufFull = 0U;    /* will be updated below */
+            /* verify message buffer overflow */
+            if(overflow){
                 CO_errorReport(em, CO_EM_EMERGENCY_BUFFER_FULL, CO_EMC_GENERIC, 0U);
             }
             else{
-                em->bufFull = 0;
                 CO_errorReset(em, CO_EM_EMERGENCY_BUFFER_FULL, 0);
             }
 
             /* write to 'pre-defined error field' (object dictionary, index 0x1003) */
-            if(emPr->preDefErr){
-                uint8_t i;
-
-                if(emPr->preDefErrNoOfErrors < emPr->preDefErrSize)
-                    emPr->preDefErrNoOfErrors++;
-                for(i=emPr->preDefErrNoOfErrors-1; i>0; i--)
-                    emPr->preDefErr[i] = emPr->preDefErr[i-1];
-                emPr->preDefErr[0] = preDEF;
-            }
+            CO_EM_preDefErrAdd(emPr, &preDEF, 1U);
+#endif
 
             /* send CAN message */
             CO_CANsend(emPr->CANdev, emPr->CANtxBuff);
@@ -316,12 +584,39 @@ void CO_errorReport(CO_EM_t *em, const uint8_t errorBit, const uint16_t errorCod
     }
     else{
         errorStatusBits = &em->errorStatusBits[index];
+#ifdef CO_EM_LOCKFREE_FIFO
+        /* test and set error bit (any error except NO_ERROR) in one step, so
+         * concurrent reports of the same error send only one emergency */
+        if(errorBit && (__atomic_fetch_or(errorStatusBits, bitmask, __ATOMIC_RELAXED) & bitmask) != 0){
+            sendEmergency = false;
+        }
+#else
         /* if error was already reported, do nothing */
         if((*errorStatusBits & bitmask) != 0){
             sendEmergency = false;
         }
+#endif
     }
 
+#ifdef CO_EM_LOCKFREE_FIFO
+    if(sendEmergency){
+        uint8_t bufCopy[8];
+
+        /* prepare data for emergency message */
+        CO_memcpySwap2(&bufCopy[0], &errorCode);
+        bufCopy[2] = 0; /* error register will be set later */
+        bufCopy[3] = errorBit;
+        CO_memcpySwap4(&bufCopy[4], &infoCode);
+
+        if(!CO_EM_fifoPush(em, bufCopy)){
+            __atomic_store_n(&em->fifoOverflow, 1U, __ATOMIC_RELAXED);
+        }
+        /* Optional signal to RTOS, which can resume task, which handles CO_EM_process */
+        else if(em->pFunctSignal != NULL) {
+            em->pFunctSignal();
+        }
+    }
+#else
     if(sendEmergency){
         /* set error bit */
         if(errorBit){
@@ -357,6 +652,7 @@ void CO_errorReport(CO_EM_t *em, const uint8_t errorBit, const uint16_t errorCod
             }
         }
     }
+#endif
 }
 
 
@@ -377,12 +673,39 @@ void CO_errorReset(CO_EM_t *em, const uint8_t errorBit, const uint32_t infoCode)
     }
     else{
         errorStatusBits = &em->errorStatusBits[index];
+#ifdef CO_EM_LOCKFREE_FIFO
+        /* test and erase error bit in one step */
+        if((__atomic_fetch_and(errorStatusBits, (uint8_t)~bitmask, __ATOMIC_RELAXED) & bitmask) == 0){
+            sendEmergency = false;
+        }
+#else
         /* if error was allready cleared, do nothing */
         if((*errorStatusBits & bitmask) == 0){
             sendEmergency = false;
         }
+#endif
     }
 
+#ifdef CO_EM_LOCKFREE_FIFO
+    if(sendEmergency){
+        uint8_t bufCopy[8];
+
+        /* prepare data for emergency message */
+        bufCopy[0] = 0;
+        bufCopy[1] = 0;
+        bufCopy[2] = 0; /* error register will be set later */
+        bufCopy[3] = errorBit;
+        CO_memcpySwap4(&bufCopy[4], &infoCode);
+
+        if(!CO_EM_fifoPush(em, bufCopy)){
+            __atomic_store_n(&em->fifoOverflow, 1U, __ATOMIC_RELAXED);
+        }
+        /* Optional signal to RTOS, which can resume task, which handles CO_EM_process */
+        else if(em->pFunctSignal != NULL) {
+            em->pFunctSignal();
+        }
+    }
+#else
     if(sendEmergency){
         /* erase error bit */
         *errorStatusBits &= ~bitmask;
@@ -416,6 +739,7 @@ void CO_errorReset(CO_EM_t *em, const uint8_t errorBit, const uint32_t infoCode)
             }
         }
     }
+#endif
 }
 
 
@@ -426,7 +750,7 @@ bool_t CO_isError(CO_EM_t *em, const uint8_t errorBit){
     bool_t ret = false;
 
     if(em != NULL && index < em->errorStatusBitsSize){
-        if((em->errorStatusBits[index] & bitmask) != 0){
+        if((CO_EM_STATUS_BITS(em, index) & bitmask) != 0){
             ret = true;
         }
     }
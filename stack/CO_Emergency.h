@@ -88,6 +88,27 @@ extern "C" {
  * ####Contents of _Pre Defined Error Field_ (object dictionary, index 0x1003):
  * bytes 0..3 are equal to bytes 0..3 in the Emergency message.
  *
+ * ###Lock-free error reporting
+ * By default CO_errorReport() and CO_errorReset() write to the internal buffer
+ * inside CO_LOCK_EMCY(). If CO_EM_LOCKFREE_FIFO is defined, they use a
+ * lock-free multi-producer FIFO instead and never block, so they may be called
+ * from interrupts or realtime threads with higher priority than the thread,
+ * which runs CO_EM_process(). Error status bits are then updated with atomic
+ * operations too. This requires GCC compatible __atomic builtins and a target
+ * with atomic compare and swap. CO_EM_process() is the only consumer.
+ *
+ * ###Coalescing
+ * If CO_EM_COALESCE is defined, CO_EM_process() moves all buffered messages
+ * into a list of pending messages on each call, so the buffer does not
+ * overflow during error storms. Repeated reports (error and reset) of the same
+ * error bit are merged into one entry with the latest state and a count. All
+ * moved messages are written to _Pre Defined Error Field_ at once. After the
+ * inhibit time the newest pending message is sent first, but each
+ * CO_EM_COALESCE_OLDEST-th transmission takes the oldest one, so it can't be
+ * starved by new errors. If the list is full, the oldest one is dropped and
+ * CO_EM_EMERGENCY_BUFFER_FULL is reported. Outside NMT pre-operational and
+ * operational messages are kept in the buffer as without coalescing.
+ *
  * @see #CO_Default_CAN_ID_t
  */
 
@@ -226,7 +247,7 @@ typedef enum{
 #define CO_EM_CAN_TX_OVERFLOW           0x14U /**< 0x14, communication, critical, CAN transmit buffer has overflowed */
 #define CO_EM_TPDO_OUTSIDE_WINDOW       0x15U /**< 0x15, communication, critical, TPDO is outside SYNC window */
 #define CO_EM_16_unused                 0x16U /**< 0x16, (unused) */
-#define CO_EM_17_unused                 0x17U /**< 0x17, (unused) */
+#define CO_EM_RPDO_TIME_OUT             0x17U /**< 0x17, communication, critical, RPDO deadline monitoring timeout */
 #define CO_EM_SYNC_TIME_OUT             0x18U /**< 0x18, communication, critical, SYNC message timeout */
 #define CO_EM_SYNC_LENGTH               0x19U /**< 0x19, communication, critical, Unexpected SYNC data length */
 #define CO_EM_PDO_WRONG_MAPPING         0x1AU /**< 0x1A, communication, critical, Error with PDO mapping */
@@ -261,9 +282,30 @@ typedef enum{
 
 /**
  * Size of internal buffer, whwre emergencies are stored after CO_errorReport().
- * Buffer is cleared by CO_EM_process().
+ * Buffer is cleared by CO_EM_process(). With CO_EM_LOCKFREE_FIFO it must be
+ * a power of two.
  */
-#define CO_EM_INTERNAL_BUFFER_SIZE      10
+#ifndef CO_EM_INTERNAL_BUFFER_SIZE
+#ifdef CO_EM_LOCKFREE_FIFO
+    #define CO_EM_INTERNAL_BUFFER_SIZE  16
+#else
+    #define CO_EM_INTERNAL_BUFFER_SIZE  10
+#endif
+#endif
+
+#ifdef CO_EM_LOCKFREE_FIFO
+#if (CO_EM_INTERNAL_BUFFER_SIZE & (CO_EM_INTERNAL_BUFFER_SIZE - 1)) != 0
+    #error CO_EM_INTERNAL_BUFFER_SIZE must be a power of two with CO_EM_LOCKFREE_FIFO.
+#endif
+
+/**
+ * Entry of lock-free emergency FIFO.
+ */
+typedef struct{
+    uint32_t            seq;            /**< Sequence number, tells if entry is free or written */
+    uint8_t             data[8];        /**< Emergency message */
+}CO_EM_fifoEntry_t;
+#endif
 
 
 /**
@@ -274,12 +316,20 @@ typedef enum{
 typedef struct{
     uint8_t            *errorStatusBits;/**< From CO_EM_init() */
     uint8_t             errorStatusBitsSize;/**< From CO_EM_init() */
+#ifdef CO_EM_LOCKFREE_FIFO
+    /** Lock-free FIFO for storing unsent emergency messages.*/
+    CO_EM_fifoEntry_t   fifo[CO_EM_INTERNAL_BUFFER_SIZE];
+    uint32_t            fifoWrite;      /**< Write position, shared by all producers */
+    uint32_t            fifoRead;       /**< Read position, used by CO_EM_process() only */
+    uint8_t             fifoOverflow;   /**< True if message was lost, because above FIFO was full */
+#else
     /** Internal buffer for storing unsent emergency messages.*/
     uint8_t             buf[CO_EM_INTERNAL_BUFFER_SIZE * 8];
     uint8_t            *bufEnd;         /**< End+1 address of the above buffer */
     uint8_t            *bufWritePtr;    /**< Write pointer in the above buffer */
     uint8_t            *bufReadPtr;     /**< Read pointer in the above buffer */
     uint8_t             bufFull;        /**< True if above buffer is full */
+#endif
     uint8_t             wrongErrorReport;/**< Error in arguments to CO_errorReport() */
     void              (*pFunctSignal)(void);/**< From CO_EM_initCallback() or NULL */
 }CO_EM_t;
@@ -340,6 +390,30 @@ bool_t CO_isError(CO_EM_t *em, const uint8_t errorBit);
 #ifdef CO_SDO_H
 
 
+#ifdef CO_EM_COALESCE
+#ifndef CO_EM_COALESCE_SIZE
+/** Number of distinct error bits, which can be pending for transmission. */
+    #define CO_EM_COALESCE_SIZE         8
+#endif
+#ifndef CO_EM_COALESCE_OLDEST
+/** Each n-th emergency message is the oldest pending one instead of the newest. */
+    #define CO_EM_COALESCE_OLDEST       4
+#endif
+#if CO_EM_COALESCE_OLDEST < 1
+    #error CO_EM_COALESCE_OLDEST must be at least 1
+#endif
+
+/**
+ * Pending emergency message, see CO_EM_COALESCE.
+ */
+typedef struct{
+    uint8_t             data[8];        /**< Latest message for the error bit in data[3] */
+    uint8_t             count;          /**< Number of coalesced reports, 0 if entry is free */
+    uint32_t            stamp;          /**< Age of the entry, higher is newer */
+}CO_EM_pending_t;
+#endif
+
+
 /**
  * Error control and Emergency object. It controls internal error state and
  * sends emergency message, if error condition was reported. Object is initialized
@@ -354,6 +428,13 @@ typedef struct{
     CO_EM_t            *em;             /**< CO_EM_t sub object is included here */
     CO_CANmodule_t     *CANdev;         /**< From CO_EM_init() */
     CO_CANtx_t         *CANtxBuff;      /**< CAN transmit buffer */
+#ifdef CO_EM_COALESCE
+    /** Messages moved from CO_EM_t buffer, not yet sent */
+    CO_EM_pending_t     pending[CO_EM_COALESCE_SIZE];
+    uint32_t            pendingStamp;   /**< Stamp of the newest pending message */
+    uint32_t            coalescedCount; /**< Number of reports merged into other messages */
+    uint8_t             newestSent;     /**< Newest messages sent since the oldest one */
+#endif
 }CO_EMpr_t;
 
 
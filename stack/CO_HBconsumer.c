@@ -43,6 +43,8 @@
  * to do so, delete this exception statement from your version.
  */
 
+#include <string.h>
+
 #include "CANopen.h"
 #include "CO_HBconsumer.h"
 
@@ -63,10 +65,175 @@ static void CO_HBcons_receive(void *object, const CO_CANrxMsg_t *msg){
         /* copy data and set 'new message' flag. */
         HBconsNode->NMTstate = (CO_NMT_internalState_t)msg->data[0];
         SET_CANrxNew(HBconsNode->CANrxNew);
+        SET_CANrxNew(*HBconsNode->CANrxGroupNew);
+    }
+}
+
+
+/*
+ * Deadline heap.
+ *
+ * Heap contains indexes of all nodes in state CO_HBconsumer_ACTIVE, node with
+ * the earliest deadline is on top. Heap array is distributed over heapNode
+ * members of the monitored nodes, heapPos of the node is its position inside.
+ */
+static bool_t CO_HBcons_heapBefore(
+        CO_HBconsumer_t        *HBcons,
+        uint8_t                 pos1,
+        uint8_t                 pos2)
+{
+    uint32_t d1 = HBcons->monitoredNodes[HBcons->monitoredNodes[pos1].heapNode].deadline;
+    uint32_t d2 = HBcons->monitoredNodes[HBcons->monitoredNodes[pos2].heapNode].deadline;
+
+    return ((int32_t)(d1 - d2) < 0) ? true : false;
+}
+
+static void CO_HBcons_heapSet(
+        CO_HBconsumer_t        *HBcons,
+        uint8_t                 pos,
+        uint8_t                 idx)
+{
+    HBcons->monitoredNodes[pos].heapNode = idx;
+    HBcons->monitoredNodes[idx].heapPos = pos;
+}
+
+static void CO_HBcons_heapSwap(
+        CO_HBconsumer_t        *HBcons,
+        uint8_t                 pos1,
+        uint8_t                 pos2)
+{
+    uint8_t idx1 = HBcons->monitoredNodes[pos1].heapNode;
+    uint8_t idx2 = HBcons->monitoredNodes[pos2].heapNode;
+
+    CO_HBcons_heapSet(HBcons, pos1, idx2);
+    CO_HBcons_heapSet(HBcons, pos2, idx1);
+}
+
+static void CO_HBcons_heapFix(CO_HBconsumer_t *HBcons, uint8_t pos){
+    /* sift up */
+    while(pos > 0U){
+        uint8_t parent = (pos - 1U) / 2U;
+        if(!CO_HBcons_heapBefore(HBcons, pos, parent)){
+            break;
+        }
+        CO_HBcons_heapSwap(HBcons, pos, parent);
+        pos = parent;
+    }
+
+    /* sift down */
+    for(;;){
+        uint16_t child = (uint16_t)pos * 2U + 1U;
+        uint8_t smallest = pos;
+
+        if(child < HBcons->heapSize && CO_HBcons_heapBefore(HBcons, (uint8_t)child, smallest)){
+            smallest = (uint8_t)child;
+        }
+        child++;
+        if(child < HBcons->heapSize && CO_HBcons_heapBefore(HBcons, (uint8_t)child, smallest)){
+            smallest = (uint8_t)child;
+        }
+        if(smallest == pos){
+            break;
+        }
+        CO_HBcons_heapSwap(HBcons, pos, smallest);
+        pos = smallest;
+    }
+}
+
+/* Insert node or move it to the new position, if deadline has changed. */
+static void CO_HBcons_heapUpdate(CO_HBconsumer_t *HBcons, uint8_t idx){
+    CO_HBconsNode_t *monitoredNode = &HBcons->monitoredNodes[idx];
+
+    if(monitoredNode->heapPos == 0xFFU){
+        CO_HBcons_heapSet(HBcons, HBcons->heapSize, idx);
+        HBcons->heapSize++;
+    }
+    CO_HBcons_heapFix(HBcons, monitoredNode->heapPos);
+}
+
+static void CO_HBcons_heapRemove(CO_HBconsumer_t *HBcons, uint8_t idx){
+    CO_HBconsNode_t *monitoredNode = &HBcons->monitoredNodes[idx];
+    uint8_t pos = monitoredNode->heapPos;
+
+    if(pos == 0xFFU){
+        return;
+    }
+
+    HBcons->heapSize--;
+    monitoredNode->heapPos = 0xFFU;
+    if(pos != HBcons->heapSize){
+        CO_HBcons_heapSet(HBcons, pos, HBcons->monitoredNodes[HBcons->heapSize].heapNode);
+        CO_HBcons_heapFix(HBcons, pos);
+    }
+}
+
+
+/*
+ * Signal heartbeat and NMT state of one monitored node to the application.
+ */
+static void CO_HBcons_signalNmtState(
+        CO_HBconsumer_t        *HBcons,
+        uint8_t                 idx,
+        uint8_t                 nodeId,
+        CO_HBconsumer_state_t   HBstate)
+{
+    if(HBcons->pFunctSignalNmtState != NULL){
+        HBcons->pFunctSignalNmtState(nodeId, idx, HBstate,
+            HBcons->monitoredNodes[idx].NMTstate, HBcons->functSignalObjectNmtState);
     }
 }
 
 
+/*
+ * Set bits of the node in the bitmaps of active, operational and timed out nodes.
+ */
+static void CO_HBcons_updateMaps(
+        CO_HBconsumer_t        *HBcons,
+        const CO_HBconsNode_t  *monitoredNode)
+{
+    uint8_t w = monitoredNode->nodeId / 32U;
+    uint32_t mask = 1UL << (monitoredNode->nodeId % 32U);
+
+    if(monitoredNode->nodeId >= CO_HBCONS_MAP_SIZE * 32U) return;
+
+    HBcons->activeNodes[w] &= ~mask;
+    HBcons->operationalNodes[w] &= ~mask;
+    HBcons->timeoutNodes[w] &= ~mask;
+    if(monitoredNode->HBstate == CO_HBconsumer_ACTIVE){
+        HBcons->activeNodes[w] |= mask;
+    }
+    else if(monitoredNode->HBstate == CO_HBconsumer_TIMEOUT){
+        HBcons->timeoutNodes[w] |= mask;
+    }
+    if(monitoredNode->operational){
+        HBcons->operationalNodes[w] |= mask;
+    }
+}
+
+
+/*
+ * Update operational state of the node in the counter of not operational nodes
+ * and state of the node in the bitmaps.
+ */
+static void CO_HBcons_updateOperational(
+        CO_HBconsumer_t        *HBcons,
+        CO_HBconsNode_t        *monitoredNode)
+{
+    bool_t operational = (monitoredNode->NMTstate == CO_NMT_OPERATIONAL) ? true : false;
+
+    if(operational != monitoredNode->operational){
+        monitoredNode->operational = operational;
+        if(operational){
+            HBcons->notOperationalCount--;
+        }
+        else{
+            HBcons->notOperationalCount++;
+        }
+    }
+    CO_HBcons_updateMaps(HBcons, monitoredNode);
+}
+
+
 /*
  * Configure one monitored node.
  */
@@ -82,15 +249,36 @@ static void CO_HBcons_monitoredNodeConfig(
     if(idx >= HBcons->numberOfMonitoredNodes) return;
 
     monitoredNode = &HBcons->monitoredNodes[idx];
+    if(monitoredNode->HBstate != CO_HBconsumer_UNCONFIGURED){
+        CO_HBcons_signalNmtState(HBcons, idx, monitoredNode->nodeId, CO_HBconsumer_UNCONFIGURED);
+    }
+
+    /* remove old node ID from the bitmaps and from the index table */
+    monitoredNode->HBstate = CO_HBconsumer_UNCONFIGURED;
+    monitoredNode->operational = false;
+    CO_HBcons_updateMaps(HBcons, monitoredNode);
+    if(monitoredNode->nodeId < CO_HBCONS_MAP_SIZE * 32U &&
+       HBcons->idxByNodeId[monitoredNode->nodeId] == idx + 1U){
+        HBcons->idxByNodeId[monitoredNode->nodeId] = 0U;
+    }
+
     monitoredNode->nodeId = nodeId;
     monitoredNode->time = time;
     monitoredNode->NMTstate = CO_NMT_INITIALIZING;
     monitoredNode->HBstate = CO_HBconsumer_UNCONFIGURED;
+    monitoredNode->CANrxGroupNew = &HBcons->CANrxGroupNew[idx / CO_HBCONS_GROUP_SIZE];
+
+    /* counters and deadline heap are recalculated in next process call */
+    HBcons->rebuild = true;
 
     /* is channel used */
     if(monitoredNode->nodeId && monitoredNode->time){
         COB_ID = monitoredNode->nodeId + CO_CAN_ID_HEARTBEAT;
         monitoredNode->HBstate = CO_HBconsumer_UNKNOWN;
+        if(nodeId < CO_HBCONS_MAP_SIZE * 32U){
+            HBcons->idxByNodeId[nodeId] = idx + 1U;
+        }
+        CO_HBcons_signalNmtState(HBcons, idx, nodeId, CO_HBconsumer_UNKNOWN);
 
     }
     else{
@@ -173,6 +361,28 @@ CO_ReturnError_t CO_HBconsumer_init(
     HBcons->allMonitoredOperational = 0;
     HBcons->CANdevRx = CANdevRx;
     HBcons->CANdevRxIdxStart = CANdevRxIdxStart;
+    HBcons->time_ms = 0;
+    HBcons->heapSize = 0;
+    HBcons->timeoutCount = 0;
+    HBcons->notOperationalCount = 0;
+    HBcons->rebuild = true;
+    HBcons->pFunctSignalNmtState = NULL;
+    HBcons->functSignalObjectNmtState = NULL;
+    for(i=0; i<(sizeof(HBcons->CANrxGroupNew)/sizeof(HBcons->CANrxGroupNew[0])); i++) {
+        CLEAR_CANrxNew(HBcons->CANrxGroupNew[i]);
+    }
+
+    memset(HBcons->activeNodes, 0, sizeof(HBcons->activeNodes));
+    memset(HBcons->operationalNodes, 0, sizeof(HBcons->operationalNodes));
+    memset(HBcons->timeoutNodes, 0, sizeof(HBcons->timeoutNodes));
+    memset(HBcons->idxByNodeId, 0, sizeof(HBcons->idxByNodeId));
+
+    for(i=0; i<HBcons->numberOfMonitoredNodes; i++) {
+        HBcons->monitoredNodes[i].nodeId = 0;
+        HBcons->monitoredNodes[i].HBstate = CO_HBconsumer_UNCONFIGURED;
+        HBcons->monitoredNodes[i].heapPos = 0xFFU;
+        CLEAR_CANrxNew(HBcons->monitoredNodes[i].CANrxNew);
+    }
 
     for(i=0; i<HBcons->numberOfMonitoredNodes; i++) {
         uint8_t nodeId = (HBcons->HBconsTime[i] >> 16U) & 0xFFU;
@@ -278,95 +488,211 @@ void CO_HBconsumer_initCallbackRemoteReset(
     monitoredNode->functSignalObjectRemoteReset = object;
 }
 
+
+/******************************************************************************/
+void CO_HBconsumer_initCallbackNmtState(
+    CO_HBconsumer_t        *HBcons,
+    void                   *object,
+    void                  (*pFunctSignal)(uint8_t nodeId, uint8_t idx, CO_HBconsumer_state_t HBstate,
+                                          CO_NMT_internalState_t NMTstate, void *object))
+{
+    if (HBcons==NULL) {
+        return;
+    }
+
+    HBcons->pFunctSignalNmtState = pFunctSignal;
+    HBcons->functSignalObjectNmtState = object;
+}
+
+/*
+ * Recalculate counters and deadline heap of all monitored nodes.
+ *
+ * Called after configuration changes or after NMT state of this node was not
+ * (pre)operational. Timeout of active nodes is restarted.
+ */
+static void CO_HBcons_rebuild(CO_HBconsumer_t *HBcons){
+    uint8_t i;
+    CO_HBconsNode_t *monitoredNode;
+
+    HBcons->heapSize = 0;
+    HBcons->timeoutCount = 0;
+    HBcons->notOperationalCount = 0;
+    memset(HBcons->activeNodes, 0, sizeof(HBcons->activeNodes));
+    memset(HBcons->operationalNodes, 0, sizeof(HBcons->operationalNodes));
+    memset(HBcons->timeoutNodes, 0, sizeof(HBcons->timeoutNodes));
+
+    monitoredNode = &HBcons->monitoredNodes[0];
+    for(i=0; i<HBcons->numberOfMonitoredNodes; i++){
+        monitoredNode->heapPos = 0xFFU;
+        monitoredNode->operational = false;
+        if(monitoredNode->time > 0){/* is node monitored */
+            if(monitoredNode->HBstate == CO_HBconsumer_ACTIVE){
+                monitoredNode->deadline = HBcons->time_ms + monitoredNode->time;
+                CO_HBcons_heapUpdate(HBcons, i);
+            }
+            else if(monitoredNode->HBstate == CO_HBconsumer_TIMEOUT){
+                HBcons->timeoutCount++;
+            }
+            HBcons->notOperationalCount++;
+            CO_HBcons_updateOperational(HBcons, monitoredNode);
+        }
+        monitoredNode++;
+    }
+
+    HBcons->rebuild = false;
+}
+
+
+/*
+ * Process received heartbeat or bootup message of one monitored node.
+ *
+ * @return True, if remote reset was detected on active node.
+ */
+static bool_t CO_HBcons_processRx(CO_HBconsumer_t *HBcons, uint8_t idx){
+    bool_t remoteReset = false;
+    CO_HBconsNode_t *monitoredNode = &HBcons->monitoredNodes[idx];
+
+    if(monitoredNode->NMTstate == CO_NMT_INITIALIZING){
+        /* bootup message, call callback */
+        if (monitoredNode->pFunctSignalRemoteReset != NULL) {
+            monitoredNode->pFunctSignalRemoteReset(monitoredNode->nodeId, idx,
+                monitoredNode->functSignalObjectRemoteReset);
+        }
+        if(monitoredNode->HBstate == CO_HBconsumer_ACTIVE){
+            /* there was a bootup message */
+            CO_errorReport(HBcons->em, CO_EM_HB_CONSUMER_REMOTE_RESET, CO_EMC_HEARTBEAT, idx);
+            remoteReset = true;
+
+            CO_HBcons_heapRemove(HBcons, idx);
+            monitoredNode->HBstate = CO_HBconsumer_UNKNOWN;
+        }
+    }
+    else {
+        /* heartbeat message */
+        if (monitoredNode->HBstate!=CO_HBconsumer_ACTIVE &&
+            monitoredNode->pFunctSignalHbStarted!=NULL) {
+            monitoredNode->pFunctSignalHbStarted(monitoredNode->nodeId, idx,
+                monitoredNode->functSignalObjectHbStarted);
+        }
+        if(monitoredNode->HBstate == CO_HBconsumer_TIMEOUT){
+            HBcons->timeoutCount--;
+        }
+        monitoredNode->HBstate = CO_HBconsumer_ACTIVE;
+        monitoredNode->deadline = HBcons->time_ms + monitoredNode->time;  /* reset timer */
+        CO_HBcons_heapUpdate(HBcons, idx);
+    }
+    CO_HBcons_updateOperational(HBcons, monitoredNode);
+    CLEAR_CANrxNew(monitoredNode->CANrxNew);
+    CO_HBcons_signalNmtState(HBcons, idx, monitoredNode->nodeId, monitoredNode->HBstate);
+
+    return remoteReset;
+}
+
+
 /******************************************************************************/
 void CO_HBconsumer_process(
         CO_HBconsumer_t        *HBcons,
         bool_t                  NMTisPreOrOperational,
-        uint16_t                timeDifference_ms)
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
 {
     uint8_t i;
-    uint8_t emcyHeartbeatTimeoutActive = 0;
     uint8_t emcyRemoteResetActive = 0;
     uint8_t AllMonitoredOperationalCopy;
     CO_HBconsNode_t *monitoredNode;
 
     AllMonitoredOperationalCopy = 5;
     monitoredNode = &HBcons->monitoredNodes[0];
+    HBcons->time_ms += timeDifference_ms;
 
     if(NMTisPreOrOperational){
-        for(i=0; i<HBcons->numberOfMonitoredNodes; i++){
-            if(monitoredNode->time > 0){/* is node monitored */
-                /* Verify if received message is heartbeat or bootup */
-                if(IS_CANrxNew(monitoredNode->CANrxNew)){
-                    if(monitoredNode->NMTstate == CO_NMT_INITIALIZING){
-                        /* bootup message, call callback */
-                        if (monitoredNode->pFunctSignalRemoteReset != NULL) {
-                            monitoredNode->pFunctSignalRemoteReset(monitoredNode->nodeId, i,
-                                monitoredNode->functSignalObjectRemoteReset);
-                        }
-                    }
-                    else {
-                        /* heartbeat message */
-                        if (monitoredNode->HBstate!=CO_HBconsumer_ACTIVE &&
-                            monitoredNode->pFunctSignalHbStarted!=NULL) {
-                            monitoredNode->pFunctSignalHbStarted(monitoredNode->nodeId, i,
-                                monitoredNode->functSignalObjectHbStarted);
-                        }
-                        monitoredNode->HBstate = CO_HBconsumer_ACTIVE;
-                        monitoredNode->timeoutTimer = 0;  /* reset timer */
-                        timeDifference_ms = 0;
-                    }
-                    CLEAR_CANrxNew(monitoredNode->CANrxNew);
-                }
+        uint8_t group;
+        uint8_t groupCount;
+        bool_t all = HBcons->rebuild;
 
-                /* Verify timeout */
-                if(monitoredNode->timeoutTimer < monitoredNode->time) {
-                    monitoredNode->timeoutTimer += timeDifference_ms;
-                }
-                if(monitoredNode->HBstate!=CO_HBconsumer_UNCONFIGURED &&
-                   monitoredNode->HBstate!=CO_HBconsumer_UNKNOWN) {
-                    if(monitoredNode->timeoutTimer >= monitoredNode->time){
-                        /* timeout expired */
-                        CO_errorReport(HBcons->em, CO_EM_HEARTBEAT_CONSUMER, CO_EMC_HEARTBEAT, i);
-                        emcyHeartbeatTimeoutActive = 1;
-
-                        monitoredNode->NMTstate = CO_NMT_INITIALIZING;
-                        if (monitoredNode->HBstate!=CO_HBconsumer_TIMEOUT &&
-                            monitoredNode->pFunctSignalTimeout!=NULL) {
-                            monitoredNode->pFunctSignalTimeout(monitoredNode->nodeId, i,
-                                monitoredNode->functSignalObjectTimeout);
-                        }
-                        monitoredNode->HBstate = CO_HBconsumer_TIMEOUT;
-                    }
-                    else if(monitoredNode->NMTstate == CO_NMT_INITIALIZING){
-                        /* there was a bootup message */
-                        CO_errorReport(HBcons->em, CO_EM_HB_CONSUMER_REMOTE_RESET, CO_EMC_HEARTBEAT, i);
-                        emcyRemoteResetActive = 1;
+        if(all){
+            CO_HBcons_rebuild(HBcons);
+        }
 
-                        monitoredNode->HBstate = CO_HBconsumer_UNKNOWN;
+        /* Verify received messages, only for groups with new messages */
+        groupCount = (HBcons->numberOfMonitoredNodes + CO_HBCONS_GROUP_SIZE - 1U) / CO_HBCONS_GROUP_SIZE;
+        for(group=0; group<groupCount; group++){
+            uint8_t last;
+
+            if(!all && !IS_CANrxNew(HBcons->CANrxGroupNew[group])){
+                continue;
+            }
+            CLEAR_CANrxNew(HBcons->CANrxGroupNew[group]);
+
+            i = group * CO_HBCONS_GROUP_SIZE;
+            last = (HBcons->numberOfMonitoredNodes - i > CO_HBCONS_GROUP_SIZE) ?
+                    (i + CO_HBCONS_GROUP_SIZE) : HBcons->numberOfMonitoredNodes;
+            for(; i<last; i++){
+                monitoredNode = &HBcons->monitoredNodes[i];
+                if(monitoredNode->time > 0 && IS_CANrxNew(monitoredNode->CANrxNew)){
+                    if(CO_HBcons_processRx(HBcons, i)){
+                        emcyRemoteResetActive = 1;
                     }
                 }
-                if(monitoredNode->NMTstate != CO_NMT_OPERATIONAL) {
-                    AllMonitoredOperationalCopy = 0;
+            }
+        }
+
+        /* Verify timeout, only for nodes with expired deadline */
+        while(HBcons->heapSize > 0U){
+            uint8_t idx = HBcons->monitoredNodes[0].heapNode;
+            int32_t diff;
+
+            monitoredNode = &HBcons->monitoredNodes[idx];
+            diff = (int32_t)(monitoredNode->deadline - HBcons->time_ms);
+            if(diff > 0){
+                /* lower timerNext_ms if necessary */
+                if(timerNext_ms != NULL && *timerNext_ms > diff){
+                    *timerNext_ms = (uint16_t)diff;
                 }
+                break;
             }
-            monitoredNode++;
+
+            /* timeout expired */
+            CO_errorReport(HBcons->em, CO_EM_HEARTBEAT_CONSUMER, CO_EMC_HEARTBEAT, idx);
+
+            CO_HBcons_heapRemove(HBcons, idx);
+            monitoredNode->NMTstate = CO_NMT_INITIALIZING;
+            if (monitoredNode->pFunctSignalTimeout!=NULL) {
+                monitoredNode->pFunctSignalTimeout(monitoredNode->nodeId, idx,
+                    monitoredNode->functSignalObjectTimeout);
+            }
+            monitoredNode->HBstate = CO_HBconsumer_TIMEOUT;
+            HBcons->timeoutCount++;
+            CO_HBcons_updateOperational(HBcons, monitoredNode);
+            CO_HBcons_signalNmtState(HBcons, idx, monitoredNode->nodeId, CO_HBconsumer_TIMEOUT);
+        }
+
+        if(HBcons->notOperationalCount > 0U) {
+            AllMonitoredOperationalCopy = 0;
         }
     }
     else{ /* not in (pre)operational state */
         for(i=0; i<HBcons->numberOfMonitoredNodes; i++){
             monitoredNode->NMTstate = CO_NMT_INITIALIZING;
             CLEAR_CANrxNew(monitoredNode->CANrxNew);
-            if(monitoredNode->HBstate != CO_HBconsumer_UNCONFIGURED){
+            if(monitoredNode->HBstate != CO_HBconsumer_UNCONFIGURED &&
+               monitoredNode->HBstate != CO_HBconsumer_UNKNOWN){
                 monitoredNode->HBstate = CO_HBconsumer_UNKNOWN;
+                CO_HBcons_signalNmtState(HBcons, i, monitoredNode->nodeId, CO_HBconsumer_UNKNOWN);
             }
             monitoredNode++;
         }
         AllMonitoredOperationalCopy = 0;
+        HBcons->heapSize = 0;
+        HBcons->timeoutCount = 0;
+        memset(HBcons->activeNodes, 0, sizeof(HBcons->activeNodes));
+        memset(HBcons->operationalNodes, 0, sizeof(HBcons->operationalNodes));
+        memset(HBcons->timeoutNodes, 0, sizeof(HBcons->timeoutNodes));
+        HBcons->rebuild = true;
     }
     /* clear emergencies. We only have one emergency index for all
      * monitored nodes! */
-    if ( ! emcyHeartbeatTimeoutActive) {
+    if (HBcons->timeoutCount == 0U) {
         CO_errorReset(HBcons->em, CO_EM_HEARTBEAT_CONSUMER, 0);
     }
     if ( ! emcyRemoteResetActive) {
@@ -382,23 +708,12 @@ int8_t CO_HBconsumer_getIdxByNodeId(
         CO_HBconsumer_t        *HBcons,
         uint8_t                 nodeId)
 {
-    uint8_t i;
-    CO_HBconsNode_t *monitoredNode;
-
-    if (HBcons == NULL) {
+    if (HBcons == NULL || nodeId >= CO_HBCONS_MAP_SIZE * 32U) {
         return -1;
     }
 
-    /* linear search for the node */
-    monitoredNode = &HBcons->monitoredNodes[0];
-    for(i=0; i<HBcons->numberOfMonitoredNodes; i++){
-        if (monitoredNode->nodeId == nodeId) {
-            return i;
-        }
-        monitoredNode ++;
-    }
-    /* not found */
-    return -1;
+    /* direct table, 0 if not found */
+    return (int8_t)((int16_t)HBcons->idxByNodeId[nodeId] - 1);
 }
 
 
@@ -67,9 +67,31 @@ extern "C" {
  * Heartbeat set up is done by writing to the OD registers 0x1016 or by using
  * the function _CO_HBconsumer_initEntry()_
  *
+ * CO_HBconsumer_process() does not iterate all monitored nodes on every call.
+ * Received messages are signalled per group of #CO_HBCONS_GROUP_SIZE nodes and
+ * active nodes are kept in a min-heap, ordered by their timeout deadline. So
+ * only nodes with a received message or an expired timeout are visited.
+ *
+ * State of the network is aggregated incrementally on each state change of a
+ * node: counters of timed out and not operational nodes and bitmaps of active,
+ * operational and timed out node IDs (CO_HBconsumer_t::activeNodes,
+ * operationalNodes and timeoutNodes), see CO_HBconsumer_nodeInMap(). Index
+ * of a monitored node is found by its node ID with a direct table.
+ *
  * @see  @ref CO_NMT_Heartbeat
  */
 
+/**
+ * Number of monitored nodes, which share one receive indication flag.
+ */
+#define CO_HBCONS_GROUP_SIZE        8U
+
+/**
+ * Number of 32 bit words in a bitmap of node IDs 0 to 127.
+ */
+#define CO_HBCONS_MAP_SIZE          4U
+
+
 /**
  * Heartbeat state of a node
  */
@@ -88,9 +110,13 @@ typedef struct{
     uint8_t                 nodeId;       /**< Node Id of the monitored node */
     CO_NMT_internalState_t  NMTstate;     /**< Of the remote node (Heartbeat payload) */
     CO_HBconsumer_state_t   HBstate;      /**< Current heartbeat state */
-    uint16_t                timeoutTimer; /**< Time since last heartbeat received */
+    uint32_t                deadline;     /**< Value of CO_HBconsumer_t::time_ms, when heartbeat times out */
     uint16_t                time;         /**< Consumer heartbeat time from OD */
+    uint8_t                 heapPos;      /**< Position of this node in deadline heap, 0xFF if not inside */
+    uint8_t                 heapNode;     /**< Index of node at heap position equal to index of this node */
+    bool_t                  operational;  /**< NMTstate was CO_NMT_OPERATIONAL, when node was processed */
     volatile void          *CANrxNew;     /**< Indication if new Heartbeat message received from the CAN bus */
+    volatile void         **CANrxGroupNew;/**< Indication for group of nodes inside CO_HBconsumer_t */
     /** Callback for heartbeat state change to active event */
     void                  (*pFunctSignalHbStarted)(uint8_t nodeId, uint8_t idx, void *object); /**< From CO_HBconsumer_initTimeoutCallback() or NULL */
     void                   *functSignalObjectHbStarted;/**< Pointer to object */
@@ -119,6 +145,31 @@ typedef struct{
     uint8_t             allMonitoredOperational;
     CO_CANmodule_t     *CANdevRx;         /**< From CO_HBconsumer_init() */
     uint16_t            CANdevRxIdxStart; /**< From CO_HBconsumer_init() */
+    /** Time in milliseconds, accumulated from CO_HBconsumer_process() calls */
+    uint32_t            time_ms;
+    /** Number of nodes in deadline heap (nodes in state CO_HBconsumer_ACTIVE) */
+    uint8_t             heapSize;
+    /** Number of nodes in state CO_HBconsumer_TIMEOUT */
+    uint8_t             timeoutCount;
+    /** Number of monitored nodes, which are not NMT operational */
+    uint8_t             notOperationalCount;
+    /** Bitmap of node IDs in state CO_HBconsumer_ACTIVE */
+    uint32_t            activeNodes[CO_HBCONS_MAP_SIZE];
+    /** Bitmap of node IDs, which are NMT operational */
+    uint32_t            operationalNodes[CO_HBCONS_MAP_SIZE];
+    /** Bitmap of node IDs in state CO_HBconsumer_TIMEOUT */
+    uint32_t            timeoutNodes[CO_HBCONS_MAP_SIZE];
+    /** Index of monitored node plus one for each node ID, 0 if not monitored */
+    uint8_t             idxByNodeId[CO_HBCONS_MAP_SIZE * 32U];
+    /** True, if all nodes must be processed in next CO_HBconsumer_process() call */
+    bool_t              rebuild;
+    /** Indication if new Heartbeat message received for one of the nodes in
+        group of #CO_HBCONS_GROUP_SIZE nodes */
+    volatile void      *CANrxGroupNew[(255U + CO_HBCONS_GROUP_SIZE - 1U) / CO_HBCONS_GROUP_SIZE];
+    /** Callback for NMT state of all monitored nodes */
+    void              (*pFunctSignalNmtState)(uint8_t nodeId, uint8_t idx, CO_HBconsumer_state_t HBstate,
+                                              CO_NMT_internalState_t NMTstate, void *object); /**< From CO_HBconsumer_initCallbackNmtState() or NULL */
+    void               *functSignalObjectNmtState;/**< Pointer to object */
 }CO_HBconsumer_t;
 
 
@@ -226,6 +277,27 @@ void CO_HBconsumer_initCallbackRemoteReset(
         void                   *object,
         void                  (*pFunctSignal)(uint8_t nodeId, uint8_t idx, void *object));
 
+/**
+ * Initialize Heartbeat consumer NMT state callback function.
+ *
+ * Function initializes optional callback function, which is called for every
+ * received heartbeat or bootup message of any monitored node, on heartbeat
+ * timeout and when entry of the node is configured from OD index 0x1016 or by
+ * CO_HBconsumer_initEntry(). Entry, which is not used any more, is signalled
+ * with CO_HBconsumer_UNCONFIGURED and with the node ID it had before.
+ * Callback is called from CO_HBconsumer_process() or from the SDO server and
+ * must be fast. It is cleared by CO_HBconsumer_init().
+ *
+ * @param HBcons This object.
+ * @param object Pointer to object, which will be passed to pFunctSignal(). Can be NULL
+ * @param pFunctSignal Pointer to the callback function. Not called if NULL.
+ */
+void CO_HBconsumer_initCallbackNmtState(
+        CO_HBconsumer_t        *HBcons,
+        void                   *object,
+        void                  (*pFunctSignal)(uint8_t nodeId, uint8_t idx, CO_HBconsumer_state_t HBstate,
+                                              CO_NMT_internalState_t NMTstate, void *object));
+
 /**
  * Process Heartbeat consumer object.
  *
@@ -234,15 +306,19 @@ void CO_HBconsumer_initCallbackRemoteReset(
  * @param HBcons This object.
  * @param NMTisPreOrOperational True if this node is NMT_PRE_OPERATIONAL or NMT_OPERATIONAL.
  * @param timeDifference_ms Time difference from previous function call in [milliseconds].
+ * @param timerNext_ms Return value - info to OS - see CO_process().
  */
 void CO_HBconsumer_process(
         CO_HBconsumer_t        *HBcons,
         bool_t                  NMTisPreOrOperational,
-        uint16_t                timeDifference_ms);
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms);
 
 /**
  * Get the heartbeat producer object index by node ID
  *
+ * Only entries with consumer time other than zero are found.
+ *
  * @param HBcons This object.
  * @param nodeId producer node ID
  * @return index. -1 if not found
@@ -278,6 +354,21 @@ int8_t CO_HBconsumer_getNmtState(
         uint8_t                 idx,
         CO_NMT_internalState_t *nmtState);
 
+/**
+ * Test, if node ID is set in a bitmap of CO_HBconsumer_t.
+ *
+ * Example: CO_HBconsumer_nodeInMap(HBcons->operationalNodes, 5).
+ *
+ * @param map One of activeNodes, operationalNodes or timeoutNodes.
+ * @param nodeId Node ID of the monitored node.
+ *
+ * @return True, if node ID is set.
+ */
+static inline bool_t CO_HBconsumer_nodeInMap(const uint32_t map[], uint8_t nodeId){
+    return (nodeId < CO_HBCONS_MAP_SIZE * 32U &&
+            (map[nodeId / 32U] & (1UL << (nodeId % 32U))) != 0U) ? true : false;
+}
+
 
 #ifdef __cplusplus
 }
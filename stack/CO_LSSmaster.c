@@ -82,9 +82,36 @@ typedef enum {
 typedef enum {
   CO_LSSmaster_FS_STATE_CHECK,
   CO_LSSmaster_FS_STATE_SCAN,
-  CO_LSSmaster_FS_STATE_VERIFY
+  CO_LSSmaster_FS_STATE_VERIFY,
+  CO_LSSmaster_FS_STATE_PROBE,
+  CO_LSSmaster_FS_STATE_SEARCH
 } CO_LSSmaster_fs_t;
 
+/*
+ * LSS master fastscan node ID assignment state machine
+ */
+typedef enum {
+  CO_LSSmaster_FA_STATE_IDENTIFY = 0,
+  CO_LSSmaster_FA_STATE_INQUIRE,
+  CO_LSSmaster_FA_STATE_CFG_NODE_ID,
+  CO_LSSmaster_FA_STATE_CFG_STORE
+} CO_LSSmaster_fa_t;
+
+/*
+ * LSS master bit rate switch state machine
+ */
+typedef enum {
+  CO_LSSmaster_BR_STATE_SELECT = 0,
+  CO_LSSmaster_BR_STATE_CFG_BIT_TIMING,
+  CO_LSSmaster_BR_STATE_ACTIVATE,
+  CO_LSSmaster_BR_STATE_ACTIVATE_BIT,
+  CO_LSSmaster_BR_STATE_DELAY_BEFORE,
+  CO_LSSmaster_BR_STATE_DELAY_AFTER,
+  CO_LSSmaster_BR_STATE_CONFIRM,
+  CO_LSSmaster_BR_STATE_STORE_SELECT,
+  CO_LSSmaster_BR_STATE_CFG_STORE
+} CO_LSSmaster_br_t;
+
 /*
  * Read received message from CAN module.
  *
@@ -144,6 +171,69 @@ static CO_LSSmaster_return_t CO_LSSmaster_check_timeout(
 }
 
 
+/*
+ * Get fastscan response window
+ */
+static uint16_t CO_LSSmaster_FsWindow(
+        CO_LSSmaster_t         *LSSmaster)
+{
+    const CO_LSSmaster_fsStatistics_t *stat = &LSSmaster->fsStatistics;
+    uint32_t window;
+
+    if (LSSmaster->timeoutMin == 0 || stat->rttSamples < CO_LSSmaster_ADAPTIVE_SAMPLES) {
+        return LSSmaster->timeout;
+    }
+    window = (uint32_t)stat->rttMax_ms * CO_LSSmaster_ADAPTIVE_FACTOR + CO_LSSmaster_ADAPTIVE_MARGIN_ms;
+    if (window < LSSmaster->timeoutMin) {
+        window = LSSmaster->timeoutMin;
+    }
+    if (window > LSSmaster->timeout) {
+        window = LSSmaster->timeout;
+    }
+    return (uint16_t)window;
+}
+
+/*
+ * Check fastscan timeout
+ *
+ * Same as CO_LSSmaster_check_timeout(), but with the adaptive window. Response
+ * time of the first response to each request is measured.
+ */
+static CO_LSSmaster_return_t CO_LSSmaster_FsCheckTimeout(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms)
+{
+    CO_LSSmaster_fsStatistics_t *stat = &LSSmaster->fsStatistics;
+    CO_LSSmaster_return_t ret = CO_LSSmaster_WAIT_SLAVE;
+
+    LSSmaster->timeoutTimer += timeDifference_ms;
+    if (LSSmaster->fsRttPending && IS_CANrxNew(LSSmaster->CANrxNew)) {
+        /* response arrived within the last time difference */
+        uint16_t rtt = LSSmaster->timeoutTimer;
+
+        LSSmaster->fsRttPending = false;
+        if (rtt >= stat->rttMax_ms) {
+            stat->rttMax_ms = rtt;
+        }
+        else {
+            /* let the maximum slowly follow shorter response times */
+            stat->rttMax_ms -= (uint16_t)((stat->rttMax_ms - rtt + 7U) / 8U);
+        }
+        if (stat->rttSamples < 0xFFFFU) {
+            stat->rttSamples ++;
+        }
+        stat->window_ms = CO_LSSmaster_FsWindow(LSSmaster);
+    }
+
+    if (LSSmaster->timeoutTimer >= CO_LSSmaster_FsWindow(LSSmaster)) {
+        LSSmaster->timeoutTimer = 0;
+        ret = CO_LSSmaster_TIMEOUT;
+    }
+
+    return ret;
+}
+
+
 /******************************************************************************/
 CO_ReturnError_t CO_LSSmaster_init(
         CO_LSSmaster_t         *LSSmaster,
@@ -161,6 +251,10 @@ CO_ReturnError_t CO_LSSmaster_init(
     }
 
     LSSmaster->timeout = timeout_ms;
+    LSSmaster->timeoutMin = 0;
+    LSSmaster->fsRttPending = false;
+    CO_memset((uint8_t*)&LSSmaster->fsStatistics, 0, sizeof(LSSmaster->fsStatistics));
+    LSSmaster->fsStatistics.window_ms = timeout_ms;
     LSSmaster->state = CO_LSSmaster_STATE_WAITING;
     LSSmaster->command = CO_LSSmaster_COMMAND_WAITING;
     LSSmaster->timeoutTimer = 0;
@@ -200,6 +294,43 @@ void CO_LSSmaster_changeTimeout(
 {
     if (LSSmaster != NULL) {
         LSSmaster->timeout = timeout_ms;
+        LSSmaster->fsStatistics.window_ms = CO_LSSmaster_FsWindow(LSSmaster);
+    }
+}
+
+
+/******************************************************************************/
+void CO_LSSmaster_changeTimeoutAdaptive(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeoutMin_ms)
+{
+    if (LSSmaster != NULL) {
+        LSSmaster->timeoutMin = timeoutMin_ms;
+        LSSmaster->fsStatistics.window_ms = CO_LSSmaster_FsWindow(LSSmaster);
+    }
+}
+
+
+/******************************************************************************/
+void CO_LSSmaster_getFastscanStatistics(
+        CO_LSSmaster_t                  *LSSmaster,
+        bool_t                           reset,
+        CO_LSSmaster_fsStatistics_t     *statistics)
+{
+    CO_LSSmaster_fsStatistics_t *stat;
+
+    if (LSSmaster == NULL || statistics == NULL) {
+        return;
+    }
+    stat = &LSSmaster->fsStatistics;
+    *statistics = *stat;
+    if (reset) {
+        stat->scanCount = 0;
+        stat->requestCount = 0;
+        stat->timeTotal_ms = 0;
+        stat->timeLast_ms = 0;
+        stat->timeMax_ms = 0;
+        stat->fallbackCount = 0;
     }
 }
 
@@ -216,6 +347,26 @@ void CO_LSSmaster_initCallback(
     }
 }
 
+/*
+ * Helper function - send remaining requests of switch state selective
+ *
+ * Vendor ID, product code, revision number and serial number are sent with
+ * the same CAN transmit buffer. Next request is only sent, if the buffer is
+ * free, so drivers with a single buffer per message do not overwrite it.
+ */
+static void CO_LSSmaster_switchStateSelectSend(
+        CO_LSSmaster_t         *LSSmaster)
+{
+    while (LSSmaster->selSent < 4U && !LSSmaster->TXbuff->bufferFull) {
+        LSSmaster->TXbuff->data[0] = CO_LSS_SWITCH_STATE_SEL_VENDOR + LSSmaster->selSent;
+        CO_setUint32(&LSSmaster->TXbuff->data[1],
+                     LSSmaster->selAddress.addr[LSSmaster->selSent]);
+        CO_memset(&LSSmaster->TXbuff->data[5], 0, 3);
+        CO_CANsend(LSSmaster->CANdevTx, LSSmaster->TXbuff);
+        LSSmaster->selSent ++;
+    }
+}
+
 /*
  * Helper function - initiate switch state
  */
@@ -232,19 +383,9 @@ static CO_LSSmaster_return_t CO_LSSmaster_switchStateSelectInitiate(
       LSSmaster->timeoutTimer = 0;
 
       CLEAR_CANrxNew(LSSmaster->CANrxNew);
-      CO_memset(&LSSmaster->TXbuff->data[6], 0, 3);
-      LSSmaster->TXbuff->data[0] = CO_LSS_SWITCH_STATE_SEL_VENDOR;
-      CO_setUint32(&LSSmaster->TXbuff->data[1], lssAddress->identity.vendorID);
-      CO_CANsend(LSSmaster->CANdevTx, LSSmaster->TXbuff);
-      LSSmaster->TXbuff->data[0] = CO_LSS_SWITCH_STATE_SEL_PRODUCT;
-      CO_setUint32(&LSSmaster->TXbuff->data[1], lssAddress->identity.productCode);
-      CO_CANsend(LSSmaster->CANdevTx, LSSmaster->TXbuff);
-      LSSmaster->TXbuff->data[0] = CO_LSS_SWITCH_STATE_SEL_REV;
-      CO_setUint32(&LSSmaster->TXbuff->data[1], lssAddress->identity.revisionNumber);
-      CO_CANsend(LSSmaster->CANdevTx, LSSmaster->TXbuff);
-      LSSmaster->TXbuff->data[0] = CO_LSS_SWITCH_STATE_SEL_SERIAL;
-      CO_setUint32(&LSSmaster->TXbuff->data[1], lssAddress->identity.serialNumber);
-      CO_CANsend(LSSmaster->CANdevTx, LSSmaster->TXbuff);
+      LSSmaster->selAddress = *lssAddress;
+      LSSmaster->selSent = 0;
+      CO_LSSmaster_switchStateSelectSend(LSSmaster);
 
       ret = CO_LSSmaster_WAIT_SLAVE;
   }
@@ -273,6 +414,8 @@ static CO_LSSmaster_return_t CO_LSSmaster_switchStateSelectWait(
 {
     CO_LSSmaster_return_t ret;
 
+    CO_LSSmaster_switchStateSelectSend(LSSmaster);
+
     if (IS_CANrxNew(LSSmaster->CANrxNew)) {
         uint8_t cs = LSSmaster->CANrxData[0];
         CLEAR_CANrxNew(LSSmaster->CANrxNew);
@@ -767,6 +910,8 @@ static void CO_LSSmaster_FsSendMsg(
         uint8_t                 lssNext)
 {
     LSSmaster->timeoutTimer = 0;
+    LSSmaster->fsRttPending = true;
+    LSSmaster->fsStatistics.requestCount ++;
 
     CLEAR_CANrxNew(LSSmaster->CANrxNew);
     LSSmaster->TXbuff->data[0] = CO_LSS_IDENT_FASTSCAN;
@@ -787,7 +932,7 @@ static CO_LSSmaster_return_t CO_LSSmaster_FsCheckWait(
 {
     CO_LSSmaster_return_t ret;
 
-    ret = CO_LSSmaster_check_timeout(LSSmaster, timeDifference_ms);
+    ret = CO_LSSmaster_FsCheckTimeout(LSSmaster, timeDifference_ms);
     if (ret == CO_LSSmaster_TIMEOUT) {
         ret = CO_LSSmaster_SCAN_NOACK;
 
@@ -856,7 +1001,7 @@ static CO_LSSmaster_return_t CO_LSSmaster_FsScanWait(
             return CO_LSSmaster_SCAN_FAILED;
     }
 
-    ret = CO_LSSmaster_check_timeout(LSSmaster, timeDifference_ms);
+    ret = CO_LSSmaster_FsCheckTimeout(LSSmaster, timeDifference_ms);
     if (ret == CO_LSSmaster_TIMEOUT) {
 
         ret = CO_LSSmaster_WAIT_SLAVE;
@@ -938,7 +1083,7 @@ static CO_LSSmaster_return_t CO_LSSmaster_FsVerifyWait(
         return CO_LSSmaster_SCAN_FAILED;
     }
 
-    ret = CO_LSSmaster_check_timeout(LSSmaster, timeDifference_ms);
+    ret = CO_LSSmaster_FsCheckTimeout(LSSmaster, timeDifference_ms);
     if (ret == CO_LSSmaster_TIMEOUT) {
 
         *idNumberRet = 0;
@@ -982,11 +1127,262 @@ static CO_LSS_fastscan_lss_sub_next CO_LSSmaster_FsSearchNext(
     return CO_LSS_FASTSCAN_VENDOR_ID;
 }
 
-/******************************************************************************/
-CO_LSSmaster_return_t CO_LSSmaster_IdentifyFastscan(
+/*
+ * Helper function - check which 32 bit part is the last one to scan for. This
+ * is the first candidate for the difference to the previously found node.
+ */
+static int CO_LSSmaster_FsLastScan(
+        const CO_LSSmaster_fastscan_t   *fastscan,
+        int                              lssSub)
+{
+    int i;
+
+    for (i = lssSub; i >= (int)CO_LSS_FASTSCAN_VENDOR_ID; i--) {
+        if (fastscan->scan[i] == CO_LSSmaster_FS_SCAN) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Helper function - send probe for difference to previously found node
+ *
+ * The previously found node was the smallest LSS address. The next one shares
+ * the upper bits with it and then has a one, where the previous address has a
+ * zero. First guess is the least significant zero bit, which is the next
+ * address in case of consecutive numbers.
+ *
+ * @return CO_LSSmaster_WAIT_SLAVE if probe is sent, CO_LSSmaster_SCAN_NOACK
+ * if there is no zero bit.
+ */
+static CO_LSSmaster_return_t CO_LSSmaster_FsProbeInitiate(
+        CO_LSSmaster_t                  *LSSmaster,
+        uint8_t                          bit)
+{
+    uint32_t prev = LSSmaster->fsPrevious.addr[LSSmaster->fsLssSub];
+
+    while (bit <= CO_LSS_FASTSCAN_BIT31 && (prev & (1UL << bit)) != 0) {
+        bit ++;
+    }
+    if (bit > CO_LSS_FASTSCAN_BIT31) {
+        return CO_LSSmaster_SCAN_NOACK;
+    }
+
+    /* upper bits from previous address, probed bit set */
+    LSSmaster->fsBitChecked = bit;
+    LSSmaster->fsIdNumber = (bit == CO_LSS_FASTSCAN_BIT31) ? 0 : (prev & (0xFFFFFFFFUL << (bit + 1U)));
+    LSSmaster->fsIdNumber |= 1UL << bit;
+    LSSmaster->fsState = CO_LSSmaster_FS_STATE_PROBE;
+
+    CO_LSSmaster_FsSendMsg(LSSmaster, LSSmaster->fsIdNumber,
+        LSSmaster->fsBitChecked, LSSmaster->fsLssSub, LSSmaster->fsLssSub);
+
+    return CO_LSSmaster_WAIT_SLAVE;
+}
+
+/*
+ * Helper function - continue search for the length of the prefix, which
+ * remaining nodes share with the previous address
+ *
+ * A node with upper bits 31..n of the previous address exists for all n
+ * above some limit, which is found by binary search between fsSearchLow (no
+ * node) and fsSearchHigh (node exists or not checked yet, 32).
+ *
+ * @return CO_LSSmaster_WAIT_SLAVE if request is sent or scan is continued,
+ * CO_LSSmaster_SCAN_FINISHED if the value is complete,
+ * CO_LSSmaster_SCAN_NOACK if there is no bigger node in this part.
+ */
+static CO_LSSmaster_return_t CO_LSSmaster_FsSearchPrefix(
+        CO_LSSmaster_t                  *LSSmaster)
+{
+    uint32_t prev = LSSmaster->fsPrevious.addr[LSSmaster->fsLssSub];
+    uint8_t bit;
+
+    if ((uint8_t)(LSSmaster->fsSearchHigh - LSSmaster->fsSearchLow) > 1U) {
+        LSSmaster->fsBitChecked = (uint8_t)
+            ((LSSmaster->fsSearchLow + LSSmaster->fsSearchHigh) / 2U);
+        LSSmaster->fsState = CO_LSSmaster_FS_STATE_SEARCH;
+        CO_LSSmaster_FsSendMsg(LSSmaster, prev, LSSmaster->fsBitChecked,
+            LSSmaster->fsLssSub, LSSmaster->fsLssSub);
+        return CO_LSSmaster_WAIT_SLAVE;
+    }
+
+    if (LSSmaster->fsSearchHigh > CO_LSS_FASTSCAN_BIT31) {
+        /* no node shares bit 31, only a one in bit 31 is possible */
+        return CO_LSSmaster_FsProbeInitiate(LSSmaster, CO_LSS_FASTSCAN_BIT31);
+    }
+
+    /* nodes share bits 31..fsSearchHigh and differ in the bit below */
+    bit = (uint8_t)(LSSmaster->fsSearchHigh - 1U);
+    if ((prev & (1UL << bit)) != 0) {
+        /* inconsistent, previous node was not the smallest one */
+        return CO_LSSmaster_SCAN_FAILED;
+    }
+    LSSmaster->fsIdNumber = (prev & (0xFFFFFFFFUL << LSSmaster->fsSearchHigh)) | (1UL << bit);
+    LSSmaster->fsNext = false;
+    if (bit == CO_LSS_FASTSCAN_BIT0) {
+        return CO_LSSmaster_SCAN_FINISHED;
+    }
+
+    /* continue with ordinary scan of the remaining bits */
+    LSSmaster->fsBitChecked = (uint8_t)(bit - 1U);
+    LSSmaster->fsState = CO_LSSmaster_FS_STATE_SCAN;
+    CO_LSSmaster_FsSendMsg(LSSmaster, LSSmaster->fsIdNumber,
+        LSSmaster->fsBitChecked, LSSmaster->fsLssSub, LSSmaster->fsLssSub);
+
+    return CO_LSSmaster_WAIT_SLAVE;
+}
+
+/*
+ * Helper function - restart fastscan with the difference to the previous node
+ * searched in part lssSub or above. Resets node state machines.
+ */
+static CO_LSSmaster_return_t CO_LSSmaster_FsRestart(
+        CO_LSSmaster_t                  *LSSmaster,
+        const CO_LSSmaster_fastscan_t   *fastscan,
+        int                              lssSub)
+{
+    int last = CO_LSSmaster_FsLastScan(fastscan, lssSub);
+
+    if (last < 0) {
+        /* no remaining node is bigger than the previous one */
+        return CO_LSSmaster_SCAN_NOACK;
+    }
+    LSSmaster->fsDivergence = (uint8_t)last;
+    LSSmaster->fsState = CO_LSSmaster_FS_STATE_CHECK;
+    CO_LSSmaster_FsSendMsg(LSSmaster, 0, CO_LSS_FASTSCAN_CONFIRM, 0, 0);
+
+    return CO_LSSmaster_WAIT_SLAVE;
+}
+
+/*
+ * Helper function - start processing of 32 bit part of LSS address
+ *
+ * For fastscan with previous node, parts above fsDivergence are only verified
+ * with the previous value and part fsDivergence is probed. Other parts are
+ * scanned.
+ */
+static CO_LSSmaster_return_t CO_LSSmaster_FsStartPart(
+        CO_LSSmaster_t                  *LSSmaster,
+        uint16_t                         timeDifference_ms,
+        const CO_LSSmaster_fastscan_t   *fastscan,
+        CO_LSS_fastscan_lss_sub_next     lssSub)
+{
+    CO_LSSmaster_return_t ret;
+
+    if (LSSmaster->fsNext && lssSub < LSSmaster->fsDivergence) {
+        /* same value as previous node */
+        LSSmaster->fsLssSub = lssSub;
+        LSSmaster->fsState = CO_LSSmaster_FS_STATE_VERIFY;
+        return CO_LSSmaster_FsVerifyInitiate(LSSmaster, timeDifference_ms,
+                  CO_LSSmaster_FS_MATCH,
+                  (fastscan->scan[lssSub] == CO_LSSmaster_FS_MATCH) ?
+                      fastscan->match.addr[lssSub] :
+                      LSSmaster->fsPrevious.addr[lssSub],
+                  CO_LSSmaster_FsSearchNext(LSSmaster, fastscan));
+    }
+    if (LSSmaster->fsNext && lssSub == LSSmaster->fsDivergence) {
+        LSSmaster->fsLssSub = lssSub;
+        ret = CO_LSSmaster_FsProbeInitiate(LSSmaster, CO_LSS_FASTSCAN_BIT0);
+        if (ret != CO_LSSmaster_WAIT_SLAVE) {
+            /* all bits are set, difference must be in upper part */
+            ret = CO_LSSmaster_FsRestart(LSSmaster, fastscan, (int)lssSub - 1);
+        }
+        return ret;
+    }
+
+    ret = CO_LSSmaster_FsScanInitiate(LSSmaster, timeDifference_ms,
+              fastscan->scan[lssSub], lssSub);
+    if (ret == CO_LSSmaster_SCAN_FINISHED) {
+        /* Scanning is not requested. Initiate verification
+         * step in next function call */
+        ret = CO_LSSmaster_WAIT_SLAVE;
+    }
+    LSSmaster->fsState = CO_LSSmaster_FS_STATE_SCAN;
+
+    return ret;
+}
+
+/*
+ * Helper function - wait for response to probe or prefix search
+ */
+static CO_LSSmaster_return_t CO_LSSmaster_FsProbeWait(
+        CO_LSSmaster_t                  *LSSmaster,
+        uint16_t                         timeDifference_ms,
+        const CO_LSSmaster_fastscan_t   *fastscan)
+{
+    CO_LSSmaster_return_t ret;
+    bool_t ack = false;
+
+    ret = CO_LSSmaster_FsCheckTimeout(LSSmaster, timeDifference_ms);
+    if (ret != CO_LSSmaster_TIMEOUT) {
+        return ret;
+    }
+
+    if (IS_CANrxNew(LSSmaster->CANrxNew)) {
+        uint8_t cs = LSSmaster->CANrxData[0];
+        CLEAR_CANrxNew(LSSmaster->CANrxNew);
+
+        if (cs != CO_LSS_IDENT_SLAVE) {
+            /* wrong response received. Can not continue */
+            return CO_LSSmaster_SCAN_FAILED;
+        }
+        ack = true;
+    }
+
+    if (LSSmaster->fsState == CO_LSSmaster_FS_STATE_PROBE) {
+        if (ack) {
+            /* at least one node has this prefix, continue with ordinary
+             * scan of the remaining bits */
+            LSSmaster->fsNext = false;
+            if (LSSmaster->fsBitChecked == CO_LSS_FASTSCAN_BIT0) {
+                return CO_LSSmaster_SCAN_FINISHED;
+            }
+            LSSmaster->fsBitChecked --;
+            LSSmaster->fsState = CO_LSSmaster_FS_STATE_SCAN;
+            CO_LSSmaster_FsSendMsg(LSSmaster,
+                LSSmaster->fsIdNumber, LSSmaster->fsBitChecked,
+                LSSmaster->fsLssSub, LSSmaster->fsLssSub);
+            return CO_LSSmaster_WAIT_SLAVE;
+        }
+        if (LSSmaster->fsBitChecked == CO_LSS_FASTSCAN_BIT31) {
+            ret = CO_LSSmaster_SCAN_NOACK;
+        }
+        else {
+            /* no node has the bits above the probed one */
+            LSSmaster->fsSearchLow = (uint8_t)(LSSmaster->fsBitChecked + 1U);
+            LSSmaster->fsSearchHigh = CO_LSS_FASTSCAN_BIT31 + 1U;
+            ret = CO_LSSmaster_FsSearchPrefix(LSSmaster);
+        }
+    }
+    else {
+        if (ack) {
+            LSSmaster->fsSearchHigh = LSSmaster->fsBitChecked;
+        }
+        else {
+            LSSmaster->fsSearchLow = LSSmaster->fsBitChecked;
+        }
+        ret = CO_LSSmaster_FsSearchPrefix(LSSmaster);
+    }
+
+    if (ret == CO_LSSmaster_SCAN_NOACK) {
+        /* no bigger node in this part, difference must be in upper part */
+        ret = CO_LSSmaster_FsRestart(LSSmaster, fastscan,
+                  (int)LSSmaster->fsLssSub - 1);
+    }
+    return ret;
+}
+
+/*
+ * Fastscan state machine, see CO_LSSmaster_IdentifyFastscan() and
+ * CO_LSSmaster_IdentifyFastscanNext().
+ */
+static CO_LSSmaster_return_t CO_LSSmaster_Fastscan(
         CO_LSSmaster_t          *LSSmaster,
         uint16_t                 timeDifference_ms,
-        CO_LSSmaster_fastscan_t *fastscan)
+        CO_LSSmaster_fastscan_t *fastscan,
+        bool_t                   usePrevious)
 {
     uint8_t i;
     uint8_t count;
@@ -1025,6 +1421,19 @@ CO_LSSmaster_return_t CO_LSSmaster_IdentifyFastscan(
         case CO_LSSmaster_COMMAND_WAITING:
             /* start fastscan */
             LSSmaster->command = CO_LSSmaster_COMMAND_IDENTIFY_FASTSCAN;
+            LSSmaster->fsStatistics.scanCount ++;
+            LSSmaster->fsStatistics.timeLast_ms = 0;
+
+            /* previous result is the scan prefix. Without parts to scan,
+             * there is no prefix. */
+            LSSmaster->fsNext = false;
+            if (usePrevious &&
+                CO_LSSmaster_FsLastScan(fastscan, CO_LSS_FASTSCAN_SERIAL) >= 0) {
+                LSSmaster->fsNext = true;
+                LSSmaster->fsPrevious = fastscan->found;
+                LSSmaster->fsDivergence = (uint8_t)
+                    CO_LSSmaster_FsLastScan(fastscan, CO_LSS_FASTSCAN_SERIAL);
+            }
 
             /* check if any nodes are waiting, if yes fastscan is reset */
             LSSmaster->fsState = CO_LSSmaster_FS_STATE_CHECK;
@@ -1033,6 +1442,8 @@ CO_LSSmaster_return_t CO_LSSmaster_IdentifyFastscan(
             return CO_LSSmaster_WAIT_SLAVE;
         default:
             /* continue with evaluating fastscan state machine */
+            LSSmaster->fsStatistics.timeLast_ms += timeDifference_ms;
+            LSSmaster->fsStatistics.timeTotal_ms += timeDifference_ms;
             break;
     }
 
@@ -1048,7 +1459,11 @@ CO_LSSmaster_return_t CO_LSSmaster_IdentifyFastscan(
      * - verify serial number, switch node to LSS configuration mode
      * Certain steps can be skipped as mentioned in the function description.
      * If one step is not ack'ed by a node, the scanning process is terminated
-     * and the correspondign error is returned. */
+     * and the correspondign error is returned.
+     * If previous node is used, parts above the difference are verified with
+     * the previous values and the part with the difference is probed instead
+     * of scanned. If there is no node, scan is restarted with the difference
+     * in the upper part. */
     switch (LSSmaster->fsState) {
         case CO_LSSmaster_FS_STATE_CHECK:
             ret = CO_LSSmaster_FsCheckWait(LSSmaster, timeDifference_ms);
@@ -1056,12 +1471,8 @@ CO_LSSmaster_return_t CO_LSSmaster_IdentifyFastscan(
                 CO_memset((uint8_t*)&fastscan->found, 0, sizeof(fastscan->found));
 
                 /* start scanning procedure by triggering vendor ID scan */
-                CO_LSSmaster_FsScanInitiate(LSSmaster, timeDifference_ms,
-                      fastscan->scan[CO_LSS_FASTSCAN_VENDOR_ID],
-                      CO_LSS_FASTSCAN_VENDOR_ID);
-                ret = CO_LSSmaster_WAIT_SLAVE;
-
-                LSSmaster->fsState = CO_LSSmaster_FS_STATE_SCAN;
+                ret = CO_LSSmaster_FsStartPart(LSSmaster, timeDifference_ms,
+                          fastscan, CO_LSS_FASTSCAN_VENDOR_ID);
             }
             break;
         case CO_LSSmaster_FS_STATE_SCAN:
@@ -1079,11 +1490,30 @@ CO_LSSmaster_return_t CO_LSSmaster_IdentifyFastscan(
                 LSSmaster->fsState = CO_LSSmaster_FS_STATE_VERIFY;
             }
             break;
+        case CO_LSSmaster_FS_STATE_PROBE:
+        case CO_LSSmaster_FS_STATE_SEARCH:
+            ret = CO_LSSmaster_FsProbeWait(LSSmaster, timeDifference_ms,
+                      fastscan);
+            if (ret == CO_LSSmaster_SCAN_FINISHED) {
+                /* difference was in bit 0, value is complete */
+                next = CO_LSSmaster_FsSearchNext(LSSmaster, fastscan);
+                ret = CO_LSSmaster_FsVerifyInitiate(LSSmaster, timeDifference_ms,
+                          CO_LSSmaster_FS_SCAN, 0, next);
+
+                LSSmaster->fsState = CO_LSSmaster_FS_STATE_VERIFY;
+            }
+            break;
         case CO_LSSmaster_FS_STATE_VERIFY:
             ret = CO_LSSmaster_FsVerifyWait(LSSmaster, timeDifference_ms,
                       fastscan->scan[LSSmaster->fsLssSub],
                       &fastscan->found.addr[LSSmaster->fsLssSub]);
-            if (ret == CO_LSSmaster_SCAN_FINISHED) {
+            if (ret == CO_LSSmaster_SCAN_NOACK && LSSmaster->fsNext) {
+                /* no remaining node with the previous value, difference
+                 * must be in this or in an upper part */
+                ret = CO_LSSmaster_FsRestart(LSSmaster, fastscan,
+                          (int)LSSmaster->fsLssSub);
+            }
+            else if (ret == CO_LSSmaster_SCAN_FINISHED) {
                 /* verification successful:
                  * - assumed node id is correct
                  * - node state machine has switched to the requested state,
@@ -1096,15 +1526,8 @@ CO_LSSmaster_return_t CO_LSSmaster_IdentifyFastscan(
                 }
                 else {
                     /* initiate scan for next part of LSS address */
-                    ret = CO_LSSmaster_FsScanInitiate(LSSmaster,
-                              timeDifference_ms, fastscan->scan[next], next);
-                    if (ret == CO_LSSmaster_SCAN_FINISHED) {
-                        /* Scanning is not requested. Initiate verification
-                         * step in next function call */
-                        ret = CO_LSSmaster_WAIT_SLAVE;
-                    }
-
-                    LSSmaster->fsState = CO_LSSmaster_FS_STATE_SCAN;
+                    ret = CO_LSSmaster_FsStartPart(LSSmaster,
+                              timeDifference_ms, fastscan, next);
                 }
             }
             break;
@@ -1112,10 +1535,456 @@ CO_LSSmaster_return_t CO_LSSmaster_IdentifyFastscan(
 
     if (ret != CO_LSSmaster_WAIT_SLAVE) {
         /* finished */
+        CO_LSSmaster_fsStatistics_t *stat = &LSSmaster->fsStatistics;
+
         LSSmaster->command = CO_LSSmaster_COMMAND_WAITING;
+        LSSmaster->fsRttPending = false;
+        if (stat->timeLast_ms > stat->timeMax_ms) {
+            stat->timeMax_ms = (stat->timeLast_ms > 0xFFFFU) ? 0xFFFFU : (uint16_t)stat->timeLast_ms;
+        }
+        if (ret == CO_LSSmaster_SCAN_FAILED ||
+            (ret == CO_LSSmaster_SCAN_NOACK &&
+             LSSmaster->fsState == CO_LSSmaster_FS_STATE_VERIFY &&
+             fastscan->scan[LSSmaster->fsLssSub] == CO_LSSmaster_FS_SCAN &&
+             !LSSmaster->fsNext)) {
+            /* response may have been too late for the window, start again
+             * with the full timeout */
+            if (stat->window_ms < LSSmaster->timeout) {
+                stat->fallbackCount ++;
+            }
+            stat->rttMax_ms = 0;
+            stat->rttSamples = 0;
+            stat->window_ms = LSSmaster->timeout;
+        }
+    }
+    return ret;
+}
+
+
+/******************************************************************************/
+CO_LSSmaster_return_t CO_LSSmaster_IdentifyFastscan(
+        CO_LSSmaster_t          *LSSmaster,
+        uint16_t                 timeDifference_ms,
+        CO_LSSmaster_fastscan_t *fastscan)
+{
+    return CO_LSSmaster_Fastscan(LSSmaster, timeDifference_ms, fastscan, false);
+}
+
+
+/******************************************************************************/
+CO_LSSmaster_return_t CO_LSSmaster_IdentifyFastscanNext(
+        CO_LSSmaster_t          *LSSmaster,
+        uint16_t                 timeDifference_ms,
+        CO_LSSmaster_fastscan_t *fastscan)
+{
+    return CO_LSSmaster_Fastscan(LSSmaster, timeDifference_ms, fastscan, true);
+}
+
+
+/*
+ * Helper function - repeat identification of the current node by full scan
+ * and full timeout, only once per node
+ */
+static bool_t CO_LSSmaster_FaRetry(
+        CO_LSSmaster_t                  *LSSmaster,
+        CO_LSSmaster_fastscanAssign_t   *assign)
+{
+    if (assign->faRetry) {
+        return false;
+    }
+    /* A node may have entered configuration state by a wrong acknowledge */
+    (void)CO_LSSmaster_switchStateDeselect(LSSmaster);
+    assign->faRetry = true;
+    if (LSSmaster->timeoutMin != 0) {
+        assign->faTimeoutMin = LSSmaster->timeoutMin;
+        LSSmaster->timeoutMin = 0;
+    }
+    assign->faState = CO_LSSmaster_FA_STATE_IDENTIFY;
+    return true;
+}
+
+
+/******************************************************************************/
+CO_LSSmaster_return_t CO_LSSmaster_FastscanAssign(
+        CO_LSSmaster_t                  *LSSmaster,
+        uint16_t                         timeDifference_ms,
+        CO_LSSmaster_fastscanAssign_t   *assign)
+{
+    CO_LSSmaster_return_t ret;
+    uint16_t fallbacks;
+
+    if (LSSmaster==NULL || assign==NULL ||
+        !CO_LSS_NODE_ID_VALID(assign->nodeIdFirst) ||
+        !CO_LSS_NODE_ID_VALID(assign->nodeIdLast) ||
+        assign->nodeIdFirst == CO_LSS_NODE_ID_ASSIGNMENT ||
+        assign->nodeIdLast == CO_LSS_NODE_ID_ASSIGNMENT ||
+        assign->nodeIdLast < assign->nodeIdFirst){
+        return CO_LSSmaster_ILLEGAL_ARGUMENT;
+    }
+
+    /* start */
+    if (!assign->faBusy) {
+        if (LSSmaster->state != CO_LSSmaster_STATE_WAITING ||
+            LSSmaster->command != CO_LSSmaster_COMMAND_WAITING) {
+            return CO_LSSmaster_INVALID_STATE;
+        }
+        assign->faBusy = true;
+        assign->faState = CO_LSSmaster_FA_STATE_IDENTIFY;
+        assign->faRetry = false;
+        assign->faTimeoutMin = 0;
+        assign->count = 0;
+        timeDifference_ms = 0;
+    }
+
+    ret = CO_LSSmaster_WAIT_SLAVE;
+    while (ret == CO_LSSmaster_WAIT_SLAVE) {
+        uint8_t nodeId = (uint8_t)(assign->nodeIdFirst + assign->count);
+
+        switch (assign->faState) {
+            case CO_LSSmaster_FA_STATE_IDENTIFY:
+                fallbacks = LSSmaster->fsStatistics.fallbackCount;
+                /* all nodes after the first one are searched from the
+                 * previous address */
+                ret = CO_LSSmaster_Fastscan(LSSmaster, timeDifference_ms,
+                          &assign->fastscan, assign->count > 0 && !assign->faRetry);
+                if (ret == CO_LSSmaster_WAIT_SLAVE) {
+                    return ret;
+                }
+                if ((fallbacks != LSSmaster->fsStatistics.fallbackCount ||
+                     (ret == CO_LSSmaster_SCAN_NOACK && assign->count > 0 &&
+                      LSSmaster->timeoutMin != 0)) &&
+                    CO_LSSmaster_FaRetry(LSSmaster, assign)) {
+                    /* adaptive window may have been too short. Full scan
+                     * also confirms, that there are no more nodes. */
+                    ret = CO_LSSmaster_WAIT_SLAVE;
+                    timeDifference_ms = 0;
+                    break;
+                }
+                if (assign->faTimeoutMin != 0) {
+                    LSSmaster->timeoutMin = assign->faTimeoutMin;
+                    assign->faTimeoutMin = 0;
+                }
+                if (ret == CO_LSSmaster_SCAN_NOACK) {
+                    /* no more unconfigured nodes */
+                    assign->faBusy = false;
+                    return (assign->count > 0) ?
+                        CO_LSSmaster_SCAN_FINISHED : CO_LSSmaster_SCAN_NOACK;
+                }
+                if (ret != CO_LSSmaster_SCAN_FINISHED) {
+                    assign->faBusy = false;
+                    return ret;
+                }
+                if (assign->addresses != NULL) {
+                    assign->addresses[assign->count] = assign->fastscan.found;
+                }
+                /* with adaptive window, a late acknowledge may fake a
+                 * result. Read back the address of the selected node. */
+                assign->faState = (LSSmaster->timeoutMin != 0) ?
+                    CO_LSSmaster_FA_STATE_INQUIRE : CO_LSSmaster_FA_STATE_CFG_NODE_ID;
+                ret = CO_LSSmaster_WAIT_SLAVE;
+                timeDifference_ms = 0;
+                break;
+            case CO_LSSmaster_FA_STATE_INQUIRE:
+                ret = CO_LSSmaster_InquireLssAddress(LSSmaster, timeDifference_ms,
+                          &assign->faInquired);
+                if (ret == CO_LSSmaster_WAIT_SLAVE) {
+                    return ret;
+                }
+                if (ret == CO_LSSmaster_OK) {
+                    uint8_t i;
+
+                    for (i = 0; i <= CO_LSS_FASTSCAN_SERIAL; i++) {
+                        if (assign->fastscan.scan[i] != CO_LSSmaster_FS_SKIP &&
+                            assign->fastscan.found.addr[i] != assign->faInquired.addr[i]) {
+                            ret = CO_LSSmaster_SCAN_FAILED;
+                        }
+                    }
+                }
+                if (ret != CO_LSSmaster_OK) {
+                    /* wrong node or no node selected */
+                    LSSmaster->fsStatistics.fallbackCount ++;
+                    if (CO_LSSmaster_FaRetry(LSSmaster, assign)) {
+                        ret = CO_LSSmaster_WAIT_SLAVE;
+                        timeDifference_ms = 0;
+                        break;
+                    }
+                    ret = CO_LSSmaster_SCAN_FAILED;
+                    break;
+                }
+                if (assign->addresses != NULL) {
+                    assign->addresses[assign->count] = assign->faInquired;
+                }
+                assign->faState = CO_LSSmaster_FA_STATE_CFG_NODE_ID;
+                ret = CO_LSSmaster_WAIT_SLAVE;
+                timeDifference_ms = 0;
+                break;
+            case CO_LSSmaster_FA_STATE_CFG_NODE_ID:
+                ret = CO_LSSmaster_configureNodeId(LSSmaster, timeDifference_ms,
+                          nodeId);
+                if (ret == CO_LSSmaster_WAIT_SLAVE) {
+                    return ret;
+                }
+                if (ret != CO_LSSmaster_OK) {
+                    break;
+                }
+                if (!assign->store) {
+                    assign->count ++;
+                    assign->faRetry = false;
+                    (void)CO_LSSmaster_switchStateDeselect(LSSmaster);
+                    assign->faState = CO_LSSmaster_FA_STATE_IDENTIFY;
+                }
+                else {
+                    assign->faState = CO_LSSmaster_FA_STATE_CFG_STORE;
+                }
+                ret = CO_LSSmaster_WAIT_SLAVE;
+                timeDifference_ms = 0;
+                break;
+            case CO_LSSmaster_FA_STATE_CFG_STORE:
+                ret = CO_LSSmaster_configureStore(LSSmaster, timeDifference_ms);
+                if (ret == CO_LSSmaster_WAIT_SLAVE) {
+                    return ret;
+                }
+                if (ret != CO_LSSmaster_OK) {
+                    break;
+                }
+                assign->count ++;
+                assign->faRetry = false;
+                (void)CO_LSSmaster_switchStateDeselect(LSSmaster);
+                assign->faState = CO_LSSmaster_FA_STATE_IDENTIFY;
+                ret = CO_LSSmaster_WAIT_SLAVE;
+                timeDifference_ms = 0;
+                break;
+            default:
+                ret = CO_LSSmaster_INVALID_STATE;
+                break;
+        }
+
+        if (ret == CO_LSSmaster_WAIT_SLAVE &&
+            assign->faState == CO_LSSmaster_FA_STATE_IDENTIFY &&
+            assign->nodeIdFirst + assign->count > assign->nodeIdLast) {
+            /* all node IDs are assigned */
+            assign->faBusy = false;
+            return CO_LSSmaster_SCAN_FINISHED;
+        }
+    }
+
+    /* configuration failed, release node */
+    if (assign->faTimeoutMin != 0) {
+        LSSmaster->timeoutMin = assign->faTimeoutMin;
+        assign->faTimeoutMin = 0;
+    }
+    (void)CO_LSSmaster_switchStateDeselect(LSSmaster);
+    assign->faState = CO_LSSmaster_FA_STATE_IDENTIFY;
+    assign->faBusy = false;
+    return ret;
+}
+
+
+/*
+ * Helper function - number of nodes, which sent a heartbeat after switching
+ */
+static uint8_t CO_LSSmaster_BrConfirmed(
+        CO_LSSmaster_bitRateSwitch_t    *sw)
+{
+    uint8_t i;
+    uint8_t confirmed = 0;
+
+    for (i = 0; i < sw->count; i++) {
+        uint8_t nodeId = sw->nodeIds[i];
+
+        if ((sw->confirmed[nodeId / 32U] & (1UL << (nodeId % 32U))) != 0U) {
+            confirmed ++;
+        }
+    }
+    return confirmed;
+}
+
+
+/******************************************************************************/
+CO_LSSmaster_return_t CO_LSSmaster_SwitchBitRate(
+        CO_LSSmaster_t                  *LSSmaster,
+        uint16_t                         timeDifference_ms,
+        CO_LSSmaster_bitRateSwitch_t    *sw)
+{
+    CO_LSSmaster_return_t ret;
+    uint8_t i;
+
+    if (LSSmaster==NULL || sw==NULL || sw->bit==0 || sw->count==0 ||
+        sw->addresses==NULL || sw->nodeIds==NULL || sw->pFunctSwitch==NULL ||
+        sw->confirmTimeout_ms==0){
+        return CO_LSSmaster_ILLEGAL_ARGUMENT;
     }
+
+    /* start */
+    if (!sw->brBusy) {
+        if (LSSmaster->state != CO_LSSmaster_STATE_WAITING ||
+            LSSmaster->command != CO_LSSmaster_COMMAND_WAITING) {
+            return CO_LSSmaster_INVALID_STATE;
+        }
+        for (i = 0; i < sw->count; i++) {
+            if (!CO_LSS_NODE_ID_VALID(sw->nodeIds[i]) ||
+                sw->nodeIds[i] == CO_LSS_NODE_ID_ASSIGNMENT) {
+                return CO_LSSmaster_ILLEGAL_ARGUMENT;
+            }
+        }
+        sw->brBusy = true;
+        sw->brState = CO_LSSmaster_BR_STATE_SELECT;
+        sw->brTimer = 0;
+        sw->done = 0;
+        timeDifference_ms = 0;
+    }
+
+    ret = CO_LSSmaster_WAIT_SLAVE;
+    while (ret == CO_LSSmaster_WAIT_SLAVE) {
+        switch (sw->brState) {
+            case CO_LSSmaster_BR_STATE_SELECT:
+            case CO_LSSmaster_BR_STATE_STORE_SELECT:
+                ret = CO_LSSmaster_switchStateSelect(LSSmaster, timeDifference_ms,
+                          &sw->addresses[sw->done]);
+                if (ret == CO_LSSmaster_WAIT_SLAVE) {
+                    return ret;
+                }
+                if (ret != CO_LSSmaster_OK) {
+                    break;
+                }
+                sw->brState = (sw->brState == CO_LSSmaster_BR_STATE_SELECT) ?
+                    CO_LSSmaster_BR_STATE_CFG_BIT_TIMING : CO_LSSmaster_BR_STATE_CFG_STORE;
+                ret = CO_LSSmaster_WAIT_SLAVE;
+                timeDifference_ms = 0;
+                break;
+            case CO_LSSmaster_BR_STATE_CFG_BIT_TIMING:
+                /* node, which does not support the bit rate, answers with an
+                 * error code (CiA 305), so this returns
+                 * CO_LSSmaster_OK_ILLEGAL_ARGUMENT or _OK_MANUFACTURER */
+                ret = CO_LSSmaster_configureBitTiming(LSSmaster, timeDifference_ms,
+                          sw->bit);
+                if (ret == CO_LSSmaster_WAIT_SLAVE) {
+                    return ret;
+                }
+                if (ret != CO_LSSmaster_OK) {
+                    break;
+                }
+                (void)CO_LSSmaster_switchStateDeselect(LSSmaster);
+                sw->done ++;
+                sw->brState = (sw->done < sw->count) ?
+                    CO_LSSmaster_BR_STATE_SELECT : CO_LSSmaster_BR_STATE_ACTIVATE;
+                ret = CO_LSSmaster_WAIT_SLAVE;
+                timeDifference_ms = 0;
+                break;
+            case CO_LSSmaster_BR_STATE_ACTIVATE:
+            case CO_LSSmaster_BR_STATE_ACTIVATE_BIT:
+                /* all nodes accepted the new bit rate. Unconfirmed requests
+                 * are sent, when the transmit buffer is free. */
+                if (LSSmaster->TXbuff->bufferFull) {
+                    return CO_LSSmaster_WAIT_SLAVE;
+                }
+                if (sw->brState == CO_LSSmaster_BR_STATE_ACTIVATE) {
+                    ret = CO_LSSmaster_switchStateSelect(LSSmaster, 0, NULL);
+                    if (ret != CO_LSSmaster_OK) {
+                        break;
+                    }
+                    sw->brState = CO_LSSmaster_BR_STATE_ACTIVATE_BIT;
+                    ret = CO_LSSmaster_WAIT_SLAVE;
+                    break;
+                }
+                ret = CO_LSSmaster_ActivateBit(LSSmaster, sw->switchDelay_ms);
+                if (ret != CO_LSSmaster_OK) {
+                    break;
+                }
+                sw->brState = CO_LSSmaster_BR_STATE_DELAY_BEFORE;
+                sw->brTimer = 0;
+                ret = CO_LSSmaster_WAIT_SLAVE;
+                timeDifference_ms = 0;
+                break;
+            case CO_LSSmaster_BR_STATE_DELAY_BEFORE:
+            case CO_LSSmaster_BR_STATE_DELAY_AFTER:
+                /* nodes are silent for switchDelay_ms before and after
+                 * switching, master switches in between */
+                sw->brTimer += timeDifference_ms;
+                if (sw->brTimer < sw->switchDelay_ms) {
+                    return CO_LSSmaster_WAIT_SLAVE;
+                }
+                sw->brTimer = 0;
+                if (sw->brState == CO_LSSmaster_BR_STATE_DELAY_BEFORE) {
+                    sw->pFunctSwitch(sw->functSwitchObject, sw->bit);
+                    sw->brState = CO_LSSmaster_BR_STATE_DELAY_AFTER;
+                }
+                else {
+                    (void)CO_LSSmaster_switchStateDeselect(LSSmaster);
+                    for (i = 0; i < 4U; i++) {
+                        sw->confirmed[i] = 0;
+                    }
+                    sw->done = 0;
+                    sw->brState = CO_LSSmaster_BR_STATE_CONFIRM;
+                }
+                timeDifference_ms = 0;
+                break;
+            case CO_LSSmaster_BR_STATE_CONFIRM:
+                sw->brTimer += timeDifference_ms;
+                sw->done = CO_LSSmaster_BrConfirmed(sw);
+                if (sw->done < sw->count) {
+                    if (sw->brTimer < sw->confirmTimeout_ms) {
+                        return CO_LSSmaster_WAIT_SLAVE;
+                    }
+                    /* new bit rate is not stored, so nodes return to the
+                     * old one with their next reset */
+                    sw->brState = CO_LSSmaster_BR_STATE_SELECT;
+                    sw->brBusy = false;
+                    return CO_LSSmaster_TIMEOUT;
+                }
+                if (!sw->store) {
+                    sw->brState = CO_LSSmaster_BR_STATE_SELECT;
+                    sw->brBusy = false;
+                    return CO_LSSmaster_OK;
+                }
+                sw->done = 0;
+                sw->brState = CO_LSSmaster_BR_STATE_STORE_SELECT;
+                timeDifference_ms = 0;
+                break;
+            case CO_LSSmaster_BR_STATE_CFG_STORE:
+                ret = CO_LSSmaster_configureStore(LSSmaster, timeDifference_ms);
+                if (ret == CO_LSSmaster_WAIT_SLAVE) {
+                    return ret;
+                }
+                if (ret != CO_LSSmaster_OK) {
+                    break;
+                }
+                (void)CO_LSSmaster_switchStateDeselect(LSSmaster);
+                sw->done ++;
+                if (sw->done >= sw->count) {
+                    sw->brState = CO_LSSmaster_BR_STATE_SELECT;
+                    sw->brBusy = false;
+                    return CO_LSSmaster_OK;
+                }
+                sw->brState = CO_LSSmaster_BR_STATE_STORE_SELECT;
+                ret = CO_LSSmaster_WAIT_SLAVE;
+                timeDifference_ms = 0;
+                break;
+            default:
+                ret = CO_LSSmaster_INVALID_STATE;
+                break;
+        }
+    }
+
+    /* node failed, release it. Nodes with pending bit rate keep it until
+     * their next reset. */
+    (void)CO_LSSmaster_switchStateDeselect(LSSmaster);
+    sw->brState = CO_LSSmaster_BR_STATE_SELECT;
+    sw->brBusy = false;
     return ret;
 }
 
 
+/******************************************************************************/
+void CO_LSSmaster_SwitchBitRateHeartbeat(
+        CO_LSSmaster_bitRateSwitch_t    *sw,
+        uint8_t                          nodeId)
+{
+    if (sw != NULL && sw->brBusy && sw->brState == CO_LSSmaster_BR_STATE_CONFIRM &&
+        nodeId < 128U) {
+        sw->confirmed[nodeId / 32U] |= 1UL << (nodeId % 32U);
+    }
+}
+
+
 #endif
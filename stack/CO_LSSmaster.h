@@ -72,6 +72,7 @@ extern "C" {
  * - Configure node ID
  * - Activate bit timing parameters
  * - Store configuration
+ * - Switch bit rate of all nodes together with the master
  *
  * The LSS master is initalized during the CANopenNode initialization process.
  * Except for enabling the LSS master in the configurator, no further
@@ -123,20 +124,46 @@ typedef enum {
 } CO_LSSmaster_return_t;
 
 
+/**
+ * Fastscan duration statistics, see #CO_LSSmaster_changeTimeoutAdaptive
+ */
+typedef struct{
+    uint32_t         scanCount;        /**< Number of started fastscans */
+    uint32_t         requestCount;     /**< Number of fastscan requests sent */
+    uint32_t         timeTotal_ms;     /**< Sum of all fastscan durations */
+    uint32_t         timeLast_ms;      /**< Duration of the last fastscan */
+    uint16_t         timeMax_ms;       /**< Longest fastscan duration, saturated */
+    uint16_t         rttMax_ms;        /**< Longest response time measured, decays slowly */
+    uint16_t         rttSamples;       /**< Number of measured response times, saturated */
+    uint16_t         window_ms;        /**< Currently used fastscan response window */
+    uint16_t         fallbackCount;    /**< Number of fallbacks to the full timeout after failed scan */
+} CO_LSSmaster_fsStatistics_t;
+
+
 /**
  * LSS master object.
  */
 typedef struct{
     uint16_t         timeout;          /**< LSS response timeout in ms */
+    uint16_t         timeoutMin;       /**< Minimum fastscan response window in ms, 0 if adaptive window is disabled */
 
     uint8_t          state;            /**< Node is currently selected */
     uint8_t          command;          /**< Active command */
     uint16_t         timeoutTimer;     /**< Timeout timer for LSS communication */
+    CO_LSS_address_t selAddress;       /**< LSS address of switch state selective */
+    uint8_t          selSent;          /**< Number of switch state selective requests sent */
 
     uint8_t          fsState;          /**< Current state of fastscan master state machine */
     uint8_t          fsLssSub;         /**< Current state of node state machine */
     uint8_t          fsBitChecked;     /**< Current scan bit position */
     uint32_t         fsIdNumber;       /**< Current scan result */
+    bool_t           fsNext;           /**< Scan starts from fsPrevious, see #CO_LSSmaster_IdentifyFastscanNext */
+    uint8_t          fsDivergence;     /**< Part of LSS address, which is probed for difference to fsPrevious */
+    uint8_t          fsSearchLow;      /**< Search for common prefix with fsPrevious, no node shares bits 31..fsSearchLow */
+    uint8_t          fsSearchHigh;     /**< Search for common prefix with fsPrevious, node shares bits 31..fsSearchHigh */
+    CO_LSS_address_t fsPrevious;       /**< Previously found LSS address */
+    bool_t           fsRttPending;     /**< Response time for the last request is not measured yet */
+    CO_LSSmaster_fsStatistics_t fsStatistics; /**< Fastscan statistics */
 
     volatile void   *CANrxNew;         /**< Indication if new LSS message is received from CAN bus. It needs to be cleared when received message is completely processed. */
     uint8_t          CANrxData[8];     /**< 8 data bytes of the received message */
@@ -206,6 +233,67 @@ void CO_LSSmaster_changeTimeout(
         uint16_t                timeout_ms);
 
 
+/**
+ * Enable adaptive response window for fastscan
+ *
+ * Fastscan waits for the full timeout on each request, where no node answers,
+ * and most requests are answered by no node. With the adaptive window, the
+ * master measures the response time of the nodes and waits only
+ * #CO_LSSmaster_ADAPTIVE_FACTOR times the longest response time plus
+ * #CO_LSSmaster_ADAPTIVE_MARGIN_ms, but at least timeoutMin_ms and at most
+ * the timeout from #CO_LSSmaster_changeTimeout. The window is used after
+ * #CO_LSSmaster_ADAPTIVE_SAMPLES responses have been measured.
+ *
+ * If a fastscan fails, the measurements are dropped and the next scan starts
+ * with the full timeout again. A response later than the window can be
+ * taken as answer to the next request, which makes a scan fail. The
+ * accuracy of the measurement is the time difference of the calls to the
+ * fastscan function, so the function should be called often, e.g. from the
+ * callback set by #CO_LSSmaster_initCallback.
+ *
+ * Other LSS services always use the full timeout.
+ *
+ * @param LSSmaster This object.
+ * @param timeoutMin_ms Minimum response window in ms, 0 disables the
+ * adaptive window.
+ */
+void CO_LSSmaster_changeTimeoutAdaptive(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeoutMin_ms);
+
+/** Adaptive fastscan window: factor for the longest response time */
+#ifndef CO_LSSmaster_ADAPTIVE_FACTOR
+#define CO_LSSmaster_ADAPTIVE_FACTOR    2U
+#endif
+/** Adaptive fastscan window: fixed margin in ms */
+#ifndef CO_LSSmaster_ADAPTIVE_MARGIN_ms
+#define CO_LSSmaster_ADAPTIVE_MARGIN_ms 2U
+#endif
+/** Adaptive fastscan window: number of measurements before the window is used */
+#ifndef CO_LSSmaster_ADAPTIVE_SAMPLES
+#define CO_LSSmaster_ADAPTIVE_SAMPLES   4U
+#endif
+
+
+/**
+ * Get fastscan statistics
+ *
+ * Statistics are collected for #CO_LSSmaster_IdentifyFastscan and
+ * #CO_LSSmaster_IdentifyFastscanNext, also when called by
+ * #CO_LSSmaster_FastscanAssign. Duration is the sum of the time differences
+ * given to these functions.
+ *
+ * @param LSSmaster This object.
+ * @param reset If true, statistics are cleared after reading. Response time
+ * measurements are kept.
+ * @param statistics [out] copy of the statistics.
+ */
+void CO_LSSmaster_getFastscanStatistics(
+        CO_LSSmaster_t                  *LSSmaster,
+        bool_t                           reset,
+        CO_LSSmaster_fsStatistics_t     *statistics);
+
+
 /**
  * Initialize LSSserverRx callback function.
  *
@@ -229,7 +317,8 @@ void CO_LSSmaster_initCallback(
  * This function can select one specific or all nodes.
  *
  * Function must be called cyclically until it returns != #CO_LSSmaster_WAIT_SLAVE
- * Function is non-blocking.
+ * Function is non-blocking. The four requests of a specific selection are sent
+ * one after another, each when the CAN transmit buffer is free.
  *
  * @remark Only one selection can be active at any time.
  *
@@ -483,6 +572,184 @@ CO_LSSmaster_return_t CO_LSSmaster_IdentifyFastscan(
         CO_LSSmaster_fastscan_t         *fastscan);
 
 
+/**
+ * Select next node by LSS identify fastscan
+ *
+ * Same as #CO_LSSmaster_IdentifyFastscan, but the scan continues from the
+ * LSS address in fastscan->found, which is the result of the previous scan
+ * with the same parameters. Fastscan always finds the smallest LSS address,
+ * so the next node shares the upper bits with the previous one and then has a
+ * one, where the previous address has a zero. Parts of the LSS address above
+ * this difference are only verified. In the part with the difference, the
+ * least significant zero bit is probed first, then the length of the common
+ * prefix is found by binary search. Only the remaining bits are scanned as
+ * usual. For nodes with consecutive serial numbers, this needs a few scan
+ * cycles instead of 33 per scanned part.
+ *
+ * @remark All nodes found before (with smaller LSS address) must be
+ * configured, so they do not take part in fastscan anymore. Otherwise nodes
+ * with address smaller than fastscan->found are not found.
+ *
+ * @param LSSmaster This object.
+ * @param timeDifference_ms Time difference from previous function call in
+ * [milliseconds]. Zero when request is started.
+ * @param fastscan struct according to #CO_LSSmaster_fastscan_t, found
+ * contains the previous result.
+ * @return Same as #CO_LSSmaster_IdentifyFastscan.
+ */
+CO_LSSmaster_return_t CO_LSSmaster_IdentifyFastscanNext(
+        CO_LSSmaster_t                  *LSSmaster,
+        uint16_t                         timeDifference_ms,
+        CO_LSSmaster_fastscan_t         *fastscan);
+
+
+/**
+ * Parameters for LSS fastscan node ID assignment #CO_LSSmaster_FastscanAssign
+ *
+ * Object must be zero initialized before the first use.
+ */
+typedef struct{
+    CO_LSSmaster_fastscan_t fastscan; /**< Scan parameters, found is the last identified node */
+    uint8_t           nodeIdFirst;    /**< Node ID assigned to the first node found */
+    uint8_t           nodeIdLast;     /**< Last node ID to assign */
+    bool_t            store;          /**< If true, node ID is stored in each node */
+    CO_LSS_address_t *addresses;      /**< Array of nodeIdLast - nodeIdFirst + 1 elements for LSS addresses of the configured nodes or NULL */
+    uint8_t           count;          /**< Number of configured nodes. Node IDs are nodeIdFirst ... nodeIdFirst + count - 1 */
+    uint8_t           faState;        /**< Internal state */
+    bool_t            faBusy;         /**< True while assignment is in progress */
+    bool_t            faRetry;        /**< Identification of the current node is repeated with full scan and full timeout */
+    uint16_t          faTimeoutMin;   /**< Adaptive window setting during repeated identification */
+    CO_LSS_address_t  faInquired;     /**< LSS address read back from the selected node */
+} CO_LSSmaster_fastscanAssign_t;
+
+/**
+ * Assign node IDs to all unconfigured nodes by LSS fastscan
+ *
+ * This repeats the following steps, until no more unconfigured nodes are
+ * found or all node IDs from nodeIdFirst to nodeIdLast are assigned:
+ * - identify node by #CO_LSSmaster_IdentifyFastscan, all nodes after the first
+ *   one by #CO_LSSmaster_IdentifyFastscanNext
+ * - configure node ID by #CO_LSSmaster_configureNodeId
+ * - store configuration by #CO_LSSmaster_configureStore, if requested
+ * - deselect node by #CO_LSSmaster_switchStateDeselect
+ *
+ * With the adaptive window (see #CO_LSSmaster_changeTimeoutAdaptive), the
+ * LSS address of each identified node is read back by
+ * #CO_LSSmaster_InquireLssAddress and addresses contains the complete LSS
+ * address. If identification fails, the read back address does not match or
+ * no more nodes are found, identification is repeated once by full scan with
+ * the full timeout.
+ *
+ * Known parts of the LSS address (e.g. vendor ID and product code) should be
+ * given as #CO_LSSmaster_FS_MATCH to shorten the scan.
+ * Configured nodes get their new node ID after the next
+ * #CO_LSSmaster_ActivateBit or reset communication.
+ *
+ * This function needs that no node is selected when starting.
+ *
+ * Function must be called cyclically until it returns != #CO_LSSmaster_WAIT_SLAVE.
+ * Function is non-blocking.
+ *
+ * @param LSSmaster This object.
+ * @param timeDifference_ms Time difference from previous function call in
+ * [milliseconds]. Zero when request is started.
+ * @param assign struct according to #CO_LSSmaster_fastscanAssign_t.
+ * @return #CO_LSSmaster_ILLEGAL_ARGUMENT, #CO_LSSmaster_INVALID_STATE,
+ * #CO_LSSmaster_WAIT_SLAVE, #CO_LSSmaster_SCAN_FINISHED (at least one node
+ * configured, see count), #CO_LSSmaster_SCAN_NOACK (no unconfigured node),
+ * #CO_LSSmaster_SCAN_FAILED or error from configuration of a node. In case of
+ * error, count contains the number of nodes configured successfully.
+ */
+CO_LSSmaster_return_t CO_LSSmaster_FastscanAssign(
+        CO_LSSmaster_t                  *LSSmaster,
+        uint16_t                         timeDifference_ms,
+        CO_LSSmaster_fastscanAssign_t   *assign);
+
+
+/**
+ * Parameters for network wide bit rate switch #CO_LSSmaster_SwitchBitRate
+ *
+ * Object must be zero initialized before the first use.
+ */
+typedef struct{
+    uint16_t          bit;            /**< New bit rate, see #CO_LSSmaster_configureBitTiming, zero (automatic) is not allowed */
+    uint16_t          switchDelay_ms; /**< Delay before and after switching, see #CO_LSSmaster_ActivateBit */
+    uint16_t          confirmTimeout_ms; /**< Time for the heartbeats of all nodes after switching */
+    CO_LSS_address_t *addresses;      /**< Array of count elements with the LSS addresses of the nodes */
+    const uint8_t    *nodeIds;        /**< Array of count elements with the node IDs of the nodes */
+    uint8_t           count;          /**< Number of nodes */
+    bool_t            store;          /**< If true, new bit rate is stored in each node after confirmation */
+    void            (*pFunctSwitch)(void *object, uint16_t bit); /**< Switches CAN interface of the master to the new bit rate */
+    void             *functSwitchObject; /**< Pointer to object, which is passed to pFunctSwitch() */
+    uint8_t           done;           /**< Number of nodes processed in the current step, see #CO_LSSmaster_SwitchBitRate */
+    uint32_t          confirmed[4];   /**< Bitmap of node IDs, which sent a heartbeat after switching */
+    uint8_t           brState;        /**< Internal state */
+    bool_t            brBusy;         /**< True while bit rate switch is in progress */
+    uint16_t          brTimer;        /**< Timer of the current step in ms */
+} CO_LSSmaster_bitRateSwitch_t;
+
+/**
+ * Switch bit rate of all nodes and of the master together
+ *
+ * This executes the following steps:
+ * - verify: for each node select it by its LSS address, configure the new
+ *   bit rate by #CO_LSSmaster_configureBitTiming and deselect it. Node,
+ *   which does not support the bit rate, answers with an error code, then
+ *   the switch ends with #CO_LSSmaster_OK_ILLEGAL_ARGUMENT or
+ *   #CO_LSSmaster_OK_MANUFACTURER. Node without LSS does not answer at all
+ *   (#CO_LSSmaster_TIMEOUT).
+ * - activate: select all nodes and send #CO_LSSmaster_ActivateBit. After
+ *   switchDelay_ms pFunctSwitch() is called, after another switchDelay_ms
+ *   all nodes are deselected with the new bit rate.
+ * - confirm: wait up to confirmTimeout_ms, until each node sent a heartbeat,
+ *   see #CO_LSSmaster_SwitchBitRateHeartbeat.
+ * - store: if requested, for each node select it, store the configuration by
+ *   #CO_LSSmaster_configureStore and deselect it.
+ *
+ * New bit rate is activated only, if all nodes accepted it, and it is stored
+ * only after all nodes are confirmed. If a later step fails, nodes return to
+ * the old bit rate with their next reset.
+ *
+ * Other messages of the master should be suppressed during the activate
+ * step. confirmTimeout_ms must be longer than the heartbeat period of the
+ * nodes. The LSS addresses may be taken from #CO_LSSmaster_FastscanAssign.
+ *
+ * This function needs that no node is selected when starting.
+ *
+ * Function must be called cyclically until it returns != #CO_LSSmaster_WAIT_SLAVE.
+ * Function is non-blocking.
+ *
+ * @param LSSmaster This object.
+ * @param timeDifference_ms Time difference from previous function call in
+ * [milliseconds]. Zero when request is started.
+ * @param sw struct according to #CO_LSSmaster_bitRateSwitch_t.
+ * @return #CO_LSSmaster_ILLEGAL_ARGUMENT, #CO_LSSmaster_INVALID_STATE,
+ * #CO_LSSmaster_WAIT_SLAVE, #CO_LSSmaster_OK (all nodes switched), error
+ * from verify or store step, where done is the index of the failed node, or
+ * #CO_LSSmaster_TIMEOUT from confirm step, where done is the number of
+ * confirmed nodes.
+ */
+CO_LSSmaster_return_t CO_LSSmaster_SwitchBitRate(
+        CO_LSSmaster_t                  *LSSmaster,
+        uint16_t                         timeDifference_ms,
+        CO_LSSmaster_bitRateSwitch_t    *sw);
+
+/**
+ * Indicate heartbeat for #CO_LSSmaster_SwitchBitRate
+ *
+ * Must be called for each received heartbeat, for example from the NMT state
+ * callback of the heartbeat consumer (#CO_HBconsumer_initCallbackNmtState),
+ * from the same thread as #CO_LSSmaster_SwitchBitRate. Heartbeats are only
+ * counted in the confirm step.
+ *
+ * @param sw struct according to #CO_LSSmaster_bitRateSwitch_t.
+ * @param nodeId Node ID of the heartbeat producer.
+ */
+void CO_LSSmaster_SwitchBitRateHeartbeat(
+        CO_LSSmaster_bitRateSwitch_t    *sw,
+        uint8_t                          nodeId);
+
+
 #else /* CO_NO_LSS_CLIENT == 1 */
 
 /**
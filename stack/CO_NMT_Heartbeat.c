@@ -127,6 +127,9 @@ CO_ReturnError_t CO_NMT_init(
     NMT->firstHBTime            = firstHBTime;
     NMT->resetCommand           = 0;
     NMT->HBproducerTimer        = 0xFFFF;
+    NMT->HBphase                = CO_NMT_HB_PHASE_NONE;
+    NMT->HBtimePhased           = 0;
+    NMT->HBsendNow              = false;
     NMT->emPr                   = emPr;
     NMT->pFunctNMT              = NULL;
 
@@ -203,6 +206,30 @@ void CO_NMT_blinkingProcess50ms(CO_NMT_t *NMT){
 }
 
 
+/******************************************************************************/
+void CO_NMT_setHBphase(CO_NMT_t *NMT, uint16_t HBphase){
+    if(NMT != NULL){
+        NMT->HBphase = HBphase;
+        /* phase is applied in the next CO_NMT_process() */
+        NMT->HBtimePhased = 0;
+    }
+}
+
+
+/*
+ * Phase of the heartbeat producer inside _Producer Heartbeat time_.
+ */
+static uint16_t CO_NMT_HBphase(const CO_NMT_t *NMT, uint16_t HBtime){
+    if(HBtime == 0){
+        return 0;
+    }
+    if(NMT->HBphase == CO_NMT_HB_PHASE_NODE_ID){
+        return (uint16_t)(((uint32_t)HBtime * ((NMT->nodeId - 1U) % 127U)) / 127U);
+    }
+    return NMT->HBphase % HBtime;
+}
+
+
 /******************************************************************************/
 CO_NMT_reset_cmd_t CO_NMT_process(
         CO_NMT_t               *NMT,
@@ -219,19 +246,38 @@ CO_NMT_reset_cmd_t CO_NMT_process(
 
     NMT->HBproducerTimer += timeDifference_ms;
 
+    /* Producer Heartbeat time was changed, apply the phase again */
+    if(NMT->HBphase != CO_NMT_HB_PHASE_NONE && HBtime != NMT->HBtimePhased
+        && NMT->operatingState != CO_NMT_INITIALIZING)
+    {
+        NMT->HBtimePhased = HBtime;
+        NMT->HBproducerTimer = HBtime - CO_NMT_HBphase(NMT, HBtime);
+    }
+
     /* Heartbeat producer message & Bootup message */
-    if((HBtime != 0 && NMT->HBproducerTimer >= HBtime) || NMT->operatingState == CO_NMT_INITIALIZING){
+    if((HBtime != 0 && NMT->HBproducerTimer >= HBtime) || NMT->HBsendNow || NMT->operatingState == CO_NMT_INITIALIZING){
 
-        /* Start from the beginning. If OS is slow, time sliding may occur. However, heartbeat is
-         * not for synchronization, it is for health report. */
-        NMT->HBproducerTimer = 0;
+        if(NMT->HBphase == CO_NMT_HB_PHASE_NONE){
+            /* Start from the beginning. If OS is slow, time sliding may occur. However, heartbeat is
+             * not for synchronization, it is for health report. */
+            NMT->HBproducerTimer = 0;
+        }
+        else if(HBtime != 0 && NMT->HBproducerTimer >= HBtime){
+            /* Keep the phase, skip heartbeats missed by a slow OS. */
+            NMT->HBproducerTimer = (uint16_t)((NMT->HBproducerTimer - HBtime) % HBtime);
+        }
+        NMT->HBsendNow = false;
 
         NMT->HB_TXbuff->data[0] = NMT->operatingState;
         CO_CANsend(NMT->HB_CANdev, NMT->HB_TXbuff);
 
         if(NMT->operatingState == CO_NMT_INITIALIZING){
-            if(HBtime > NMT->firstHBTime) NMT->HBproducerTimer = HBtime - NMT->firstHBTime;
-            else                          NMT->HBproducerTimer = 0;
+            if(NMT->HBphase != CO_NMT_HB_PHASE_NONE){
+                NMT->HBtimePhased = HBtime;
+                NMT->HBproducerTimer = HBtime - CO_NMT_HBphase(NMT, HBtime);
+            }
+            else if(HBtime > NMT->firstHBTime) NMT->HBproducerTimer = HBtime - NMT->firstHBTime;
+            else                               NMT->HBproducerTimer = 0;
 
             if((NMTstartup & 0x04) == 0) NMT->operatingState = CO_NMT_OPERATIONAL;
             else                         NMT->operatingState = CO_NMT_PRE_OPERATIONAL;
@@ -331,8 +377,10 @@ CO_NMT_reset_cmd_t CO_NMT_process(
             }
 
             /* if operational state is lost, send HB immediately. */
-            if(NMT->operatingState != CO_NMT_OPERATIONAL)
-                NMT->HBproducerTimer = HBtime;
+            if(NMT->operatingState != CO_NMT_OPERATIONAL){
+                if(NMT->HBphase == CO_NMT_HB_PHASE_NONE) NMT->HBproducerTimer = HBtime;
+                else if(HBtime != 0)                     NMT->HBsendNow = true;
+            }
         }
     }
 
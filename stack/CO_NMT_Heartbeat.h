@@ -97,7 +97,12 @@ extern "C" {
  * also be used by the application. If macro returns 1 LED should be ON,
  * otherwise OFF. Function CO_NMT_blinkingProcess50ms() must be called cyclically
  * to update the variables.
+ *
+ * Devices without status LEDs may define CO_NMT_NO_LEDS. CO_process() then
+ * doesn't call CO_NMT_blinkingProcess50ms() and doesn't wake up the mainline
+ * every 50 ms.
  */
+//#define CO_NMT_NO_LEDS
     #define LED_FLICKERING(NMT)     (((NMT)->LEDflickering>=0)     ? 1 : 0) /**< 10HZ (100MS INTERVAL) */
     #define LED_BLINKING(NMT)       (((NMT)->LEDblinking>=0)       ? 1 : 0) /**< 2.5HZ (400MS INTERVAL) */
     #define LED_SINGLE_FLASH(NMT)   (((NMT)->LEDsingleFlash>=0)    ? 1 : 0) /**< 200MS ON, 1000MS OFF */
@@ -163,6 +168,9 @@ typedef struct{
     uint8_t             nodeId;         /**< CANopen Node ID of this device */
     uint16_t            HBproducerTimer;/**< Internal timer for HB producer */
     uint16_t            firstHBTime;    /**< From CO_NMT_init() */
+    uint16_t            HBphase;        /**< From CO_NMT_setHBphase() */
+    uint16_t            HBtimePhased;   /**< _Producer Heartbeat time_, for which the phase is set */
+    bool_t              HBsendNow;      /**< Send heartbeat without changing the phase */
     CO_EMpr_t          *emPr;           /**< From CO_NMT_init() */
     CO_CANmodule_t     *HB_CANdev;      /**< From CO_NMT_init() */
     void              (*pFunctNMT)(CO_NMT_internalState_t state); /**< From CO_NMT_initCallback() or NULL */
@@ -170,6 +178,12 @@ typedef struct{
 }CO_NMT_t;
 
 
+/** Heartbeat producer without phase, see CO_NMT_setHBphase() */
+#define CO_NMT_HB_PHASE_NONE    0xFFFFU
+/** Heartbeat producer phase derived from node ID, see CO_NMT_setHBphase() */
+#define CO_NMT_HB_PHASE_NODE_ID 0xFFFEU
+
+
 /**
  * Initialize NMT and Heartbeat producer object.
  *
@@ -221,6 +235,29 @@ void CO_NMT_initCallback(
         void                  (*pFunctNMT)(CO_NMT_internalState_t state));
 
 
+/**
+ * Set phase of the Heartbeat producer.
+ *
+ * Without phase (default after CO_NMT_init()), heartbeat timer restarts with
+ * each heartbeat, so heartbeats of nodes, which boot together, are sent in
+ * bursts. With phase, first heartbeat after the bootup message is sent after
+ * _phase_ milliseconds instead of firstHBTime. Further heartbeats are sent
+ * every _Producer Heartbeat time_ without time sliding, heartbeats missed
+ * by a slow OS are skipped. Phase is applied again, if _Producer Heartbeat
+ * time_ is changed. Heartbeat, which is sent immediately after loss of NMT
+ * operational state, does not change the phase.
+ *
+ * With #CO_NMT_HB_PHASE_NODE_ID phase is (nodeId - 1) / 127 of the
+ * _Producer Heartbeat time_, so heartbeats of all nodes are spread evenly
+ * over the period.
+ *
+ * @param NMT This object.
+ * @param HBphase Phase in milliseconds (modulo _Producer Heartbeat time_),
+ * #CO_NMT_HB_PHASE_NODE_ID or #CO_NMT_HB_PHASE_NONE.
+ */
+void CO_NMT_setHBphase(CO_NMT_t *NMT, uint16_t HBphase);
+
+
 /**
  * Calculate blinking bytes.
  *
@@ -0,0 +1,343 @@
+/*
+ * CANopen NMT master with network state table.
+ *
+ * @file        CO_NMTmaster.c
+ * @ingroup     CO_NMTmaster
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include "CANopen.h"
+#include "CO_NMTmaster.h"
+
+#if CO_NO_NMT_MASTER == 1
+
+/*
+ * Update state table from Heartbeat consumer, see
+ * CO_HBconsumer_initCallbackNmtState().
+ */
+static void CO_NMTmaster_HBstate(
+        uint8_t                 nodeId,
+        uint8_t                 idx,
+        CO_HBconsumer_state_t   HBstate,
+        CO_NMT_internalState_t  NMTstate,
+        void                   *object)
+{
+    CO_NMTmaster_t *NMTmaster = (CO_NMTmaster_t*) object;
+
+    (void)idx;
+    if(nodeId == 0U || nodeId > 127U || nodeId == NMTmaster->nodeId){
+        return;
+    }
+
+    switch(HBstate){
+        case CO_HBconsumer_UNCONFIGURED:
+            NMTmaster->state[nodeId] = CO_NMTMASTER_UNMONITORED;
+            CO_NMTmaster_setRemove(&NMTmaster->network, nodeId);
+            break;
+        case CO_HBconsumer_ACTIVE:
+            NMTmaster->state[nodeId] = (uint8_t)NMTstate;
+            CO_NMTmaster_setAdd(&NMTmaster->network, nodeId);
+            break;
+        default:
+            NMTmaster->state[nodeId] = CO_NMTMASTER_UNKNOWN;
+            CO_NMTmaster_setAdd(&NMTmaster->network, nodeId);
+            break;
+    }
+}
+
+
+/*
+ * Get NMT state, in which command puts the node, or CO_NMTMASTER_UNKNOWN for
+ * reset commands.
+ */
+static uint8_t CO_NMTmaster_commandState(uint8_t command){
+    switch(command){
+        case CO_NMT_ENTER_OPERATIONAL:      return CO_NMT_OPERATIONAL;
+        case CO_NMT_ENTER_STOPPED:          return CO_NMT_STOPPED;
+        case CO_NMT_ENTER_PRE_OPERATIONAL:  return CO_NMT_PRE_OPERATIONAL;
+        default:                            return CO_NMTMASTER_UNKNOWN;
+    }
+}
+
+
+/*
+ * Reduce nodes of the request to the required messages. Nodes already in the
+ * target state are removed. If broadcast does not change any other node of
+ * the network, nodes are replaced by node ID 0.
+ */
+static void CO_NMTmaster_plan(
+        CO_NMTmaster_t         *NMTmaster,
+        CO_NMTmaster_request_t *request)
+{
+    uint8_t target = CO_NMTmaster_commandState(request->command);
+    bool_t broadcast = true;
+    uint8_t count = 0;
+    uint8_t nodeId;
+
+    for(nodeId=1; nodeId<128U; nodeId++){
+        uint8_t state = NMTmaster->state[nodeId];
+
+        if(CO_NMTmaster_setHas(&request->nodes, nodeId)){
+            if(target != CO_NMTMASTER_UNKNOWN && state == target){
+                CO_NMTmaster_setRemove(&request->nodes, nodeId);
+            }
+            else{
+                count++;
+            }
+        }
+        else if(state != CO_NMTMASTER_UNMONITORED &&
+                (target == CO_NMTMASTER_UNKNOWN || state != target)){
+            /* broadcast would change node outside the set */
+            broadcast = false;
+        }
+    }
+
+    /* single node is addressed directly, the same number of messages */
+    if(broadcast && count > 1U){
+        CO_NMTmaster_setClear(&request->nodes);
+        CO_NMTmaster_setAdd(&request->nodes, 0U);
+    }
+    request->planned = true;
+}
+
+
+/*
+ * Get lowest node ID in the set or 0xFF, if set is empty.
+ */
+static uint8_t CO_NMTmaster_setFirst(const CO_NMTmaster_set_t *nodes){
+    uint8_t i;
+
+    for(i=0; i<4U; i++){
+        uint32_t bits = nodes->bits[i];
+
+        if(bits != 0UL){
+            uint8_t nodeId = i * 32U;
+            while((bits & 1UL) == 0UL){
+                bits >>= 1U;
+                nodeId++;
+            }
+            return nodeId;
+        }
+    }
+    return 0xFFU;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_NMTmaster_init(
+        CO_NMTmaster_t         *NMTmaster,
+        CO_HBconsumer_t        *HBcons,
+        uint8_t                 nodeId,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx)
+{
+    uint8_t i;
+
+    /* verify arguments */
+    if(NMTmaster==NULL || HBcons==NULL || CANdevTx==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    for(i=0; i<128U; i++){
+        NMTmaster->state[i] = CO_NMTMASTER_UNMONITORED;
+    }
+    CO_NMTmaster_setClear(&NMTmaster->network);
+    NMTmaster->nodeId = nodeId;
+    NMTmaster->queueFirst = 0;
+    NMTmaster->queueCount = 0;
+    NMTmaster->txCount = 0;
+
+    /* fill the table with nodes already configured in Heartbeat consumer */
+    for(i=0; i<HBcons->numberOfMonitoredNodes; i++){
+        CO_HBconsNode_t *monitoredNode = &HBcons->monitoredNodes[i];
+
+        if(monitoredNode->HBstate != CO_HBconsumer_UNCONFIGURED){
+            CO_NMTmaster_HBstate(monitoredNode->nodeId, i, monitoredNode->HBstate,
+                                 monitoredNode->NMTstate, (void*)NMTmaster);
+        }
+    }
+    CO_HBconsumer_initCallbackNmtState(HBcons, (void*)NMTmaster, CO_NMTmaster_HBstate);
+
+    /* configure NMT CAN transmission */
+    NMTmaster->CANdevTx = CANdevTx;
+    NMTmaster->CANtxBuff = CO_CANtxBufferInit(
+            CANdevTx,                   /* CAN device */
+            CANdevTxIdx,                /* index of specific buffer inside CAN module */
+            CO_CAN_ID_NMT_SERVICE,      /* CAN identifier */
+            0,                          /* rtr */
+            2,                          /* number of data bytes */
+            0);                         /* synchronous message flag bit */
+
+    if(NMTmaster->CANtxBuff == NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+uint8_t CO_NMTmaster_getState(
+        const CO_NMTmaster_t   *NMTmaster,
+        uint8_t                 nodeId)
+{
+    if(NMTmaster==NULL || nodeId > 127U){
+        return CO_NMTMASTER_UNMONITORED;
+    }
+    return NMTmaster->state[nodeId];
+}
+
+
+/******************************************************************************/
+uint8_t CO_NMTmaster_getNodes(
+        const CO_NMTmaster_t   *NMTmaster,
+        uint8_t                 state,
+        CO_NMTmaster_set_t     *nodes)
+{
+    uint8_t nodeId;
+    uint8_t count = 0;
+
+    if(NMTmaster==NULL || nodes==NULL){
+        return 0;
+    }
+
+    CO_NMTmaster_setClear(nodes);
+    for(nodeId=1; nodeId<128U; nodeId++){
+        if(NMTmaster->state[nodeId] == state && state != CO_NMTMASTER_UNMONITORED){
+            CO_NMTmaster_setAdd(nodes, nodeId);
+            count++;
+        }
+    }
+    return count;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_NMTmaster_command(
+        CO_NMTmaster_t         *NMTmaster,
+        uint8_t                 command,
+        const CO_NMTmaster_set_t *nodes)
+{
+    CO_NMTmaster_request_t *request;
+
+    /* verify arguments */
+    if(NMTmaster==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    switch(command){
+        case CO_NMT_ENTER_OPERATIONAL:
+        case CO_NMT_ENTER_STOPPED:
+        case CO_NMT_ENTER_PRE_OPERATIONAL:
+        case CO_NMT_RESET_NODE:
+        case CO_NMT_RESET_COMMUNICATION:
+            break;
+        default:
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    if(NMTmaster->queueCount >= CO_NMTMASTER_QUEUE_SIZE){
+        return CO_ERROR_TX_BUSY;
+    }
+
+    request = &NMTmaster->queue[(NMTmaster->queueFirst + NMTmaster->queueCount) % CO_NMTMASTER_QUEUE_SIZE];
+    request->nodes = (nodes != NULL) ? *nodes : NMTmaster->network;
+    CO_NMTmaster_setRemove(&request->nodes, 0U);
+    CO_NMTmaster_setRemove(&request->nodes, NMTmaster->nodeId);
+    request->command = command;
+    request->planned = false;
+    NMTmaster->queueCount++;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_NMTmaster_process(
+        CO_NMTmaster_t         *NMTmaster,
+        uint16_t               *timerNext_ms)
+{
+    while(NMTmaster->queueCount > 0U && !NMTmaster->CANtxBuff->bufferFull){
+        CO_NMTmaster_request_t *request = &NMTmaster->queue[NMTmaster->queueFirst];
+        uint8_t nodeId;
+        uint8_t target;
+
+        /* plan only, when previous commands are sent and table is updated */
+        if(!request->planned){
+            CO_NMTmaster_plan(NMTmaster, request);
+        }
+
+        nodeId = CO_NMTmaster_setFirst(&request->nodes);
+        if(nodeId == 0xFFU){
+            /* request finished */
+            NMTmaster->queueFirst = (NMTmaster->queueFirst + 1U) % CO_NMTMASTER_QUEUE_SIZE;
+            NMTmaster->queueCount--;
+            continue;
+        }
+
+        NMTmaster->CANtxBuff->data[0] = request->command;
+        NMTmaster->CANtxBuff->data[1] = nodeId;
+        if(CO_CANCheckSend(NMTmaster->CANdevTx, NMTmaster->CANtxBuff) == CO_ERROR_TX_BUSY){
+            break;
+        }
+        NMTmaster->txCount++;
+        CO_NMTmaster_setRemove(&request->nodes, nodeId);
+
+        /* expected state until next heartbeat */
+        target = CO_NMTmaster_commandState(request->command);
+        if(nodeId == 0U){
+            uint8_t i;
+            for(i=1; i<128U; i++){
+                if(NMTmaster->state[i] != CO_NMTMASTER_UNMONITORED){
+                    NMTmaster->state[i] = target;
+                }
+            }
+        }
+        else if(NMTmaster->state[nodeId] != CO_NMTMASTER_UNMONITORED){
+            NMTmaster->state[nodeId] = target;
+        }
+    }
+
+    /* Inform OS to call this function again, if commands are waiting */
+    if(NMTmaster->queueCount > 0U && timerNext_ms != NULL && *timerNext_ms > 1U){
+        *timerNext_ms = 1U;
+    }
+}
+
+#endif /* CO_NO_NMT_MASTER == 1 */
@@ -0,0 +1,251 @@
+/**
+ * CANopen NMT master with network state table.
+ *
+ * @file        CO_NMTmaster.h
+ * @ingroup     CO_NMTmaster
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+
+#ifndef CO_NMTmaster_H
+#define CO_NMTmaster_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CO_NO_NMT_MASTER == 1
+
+/**
+ * @defgroup CO_NMTmaster NMT master
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * NMT master with network state table and commands to groups of nodes.
+ *
+ * Object keeps the NMT state of all node IDs in a table, which is updated from
+ * the Heartbeat consumer, see CO_HBconsumer_initCallbackNmtState(). Nodes
+ * monitored by the Heartbeat consumer form the network. State of a node is
+ * read with CO_NMTmaster_getState() in constant time.
+ *
+ * NMT commands are given for a set of nodes with CO_NMTmaster_command() and
+ * sent from CO_NMTmaster_process() with as few CAN messages as possible:
+ * - Nodes, which are already in the state requested by the command, are
+ *   skipped.
+ * - A single broadcast message is sent, if it does not change any node outside
+ *   the set: for start, stop and enter pre-operational all other nodes of the
+ *   network must already be in the requested state, for reset commands the
+ *   set must contain all nodes of the network.
+ * - Otherwise one message per node is sent.
+ *
+ * After a command is sent, table contains the expected state of its nodes
+ * (#CO_NMTMASTER_UNKNOWN after reset) until the next heartbeat of the node.
+ * So commands given one after another are planned correctly. Nodes, which are
+ * on the bus but not monitored by the Heartbeat consumer, are not known to the
+ * object. They may receive broadcast commands for the network.
+ *
+ * Own node ID is never part of a set, own node is controlled by CO->NMT.
+ */
+
+
+/**
+ * Number of commands, which may wait for CO_NMTmaster_process().
+ */
+#ifndef CO_NMTMASTER_QUEUE_SIZE
+#define CO_NMTMASTER_QUEUE_SIZE     4U
+#endif
+
+/**
+ * Value in state table for node, which is not monitored.
+ */
+#define CO_NMTMASTER_UNMONITORED    0xFFU
+
+/**
+ * Value in state table for monitored node without valid heartbeat.
+ */
+#define CO_NMTMASTER_UNKNOWN        0xFEU
+
+
+/**
+ * Set of node IDs, one bit per node ID 0..127.
+ */
+typedef struct{
+    uint32_t            bits[4];        /**< Bit (nodeId % 32) of word (nodeId / 32) */
+}CO_NMTmaster_set_t;
+
+/** Remove all node IDs from the set */
+#define CO_NMTmaster_setClear(set) \
+    ((set)->bits[0] = (set)->bits[1] = (set)->bits[2] = (set)->bits[3] = 0UL)
+/** Add node ID to the set */
+#define CO_NMTmaster_setAdd(set, nodeId) \
+    ((set)->bits[((nodeId) >> 5U) & 3U] |= 1UL << ((nodeId) & 0x1FU))
+/** Remove node ID from the set */
+#define CO_NMTmaster_setRemove(set, nodeId) \
+    ((set)->bits[((nodeId) >> 5U) & 3U] &= ~(1UL << ((nodeId) & 0x1FU)))
+/** True, if node ID is in the set */
+#define CO_NMTmaster_setHas(set, nodeId) \
+    ((((set)->bits[((nodeId) >> 5U) & 3U] >> ((nodeId) & 0x1FU)) & 1UL) != 0UL)
+
+
+/**
+ * NMT command to a set of nodes, waiting in CO_NMTmaster_t.
+ */
+typedef struct{
+    CO_NMTmaster_set_t  nodes;          /**< Nodes, to which command was not sent yet */
+    uint8_t             command;        /**< #CO_NMT_command_t */
+    bool_t              planned;        /**< True, if nodes were reduced to the required messages */
+}CO_NMTmaster_request_t;
+
+
+/**
+ * NMT master object.
+ */
+typedef struct{
+    /** NMT state of each node ID (#CO_NMT_internalState_t),
+    #CO_NMTMASTER_UNMONITORED or #CO_NMTMASTER_UNKNOWN */
+    uint8_t             state[128];
+    /** Nodes monitored by the Heartbeat consumer */
+    CO_NMTmaster_set_t  network;
+    /** Own node ID, from CO_NMTmaster_init() */
+    uint8_t             nodeId;
+    /** Commands in order of CO_NMTmaster_command() calls */
+    CO_NMTmaster_request_t queue[CO_NMTMASTER_QUEUE_SIZE];
+    uint8_t             queueFirst;     /**< Index of the oldest command in queue */
+    uint8_t             queueCount;     /**< Number of commands in queue */
+    /** Number of NMT messages sent, can be read by the application */
+    uint32_t            txCount;
+    CO_CANmodule_t     *CANdevTx;       /**< From CO_NMTmaster_init() */
+    CO_CANtx_t         *CANtxBuff;      /**< CAN transmit buffer */
+}CO_NMTmaster_t;
+
+
+/**
+ * Initialize NMT master object.
+ *
+ * Function must be called in the communication reset section, after
+ * CO_HBconsumer_init(). Table is filled from the Heartbeat consumer.
+ *
+ * @param NMTmaster This object will be initialized.
+ * @param HBcons Heartbeat consumer object. Its NMT state callback is used.
+ * @param nodeId Node ID of this node.
+ * @param CANdevTx CAN device for NMT master transmission.
+ * @param CANdevTxIdx Index of transmit buffer in the above CAN device. May be
+ * the same buffer, which is used by CO_sendNMTcommand().
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_NMTmaster_init(
+        CO_NMTmaster_t         *NMTmaster,
+        CO_HBconsumer_t        *HBcons,
+        uint8_t                 nodeId,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx);
+
+
+/**
+ * Get NMT state of a node from the table.
+ *
+ * @param NMTmaster This object.
+ * @param nodeId Node ID 1..127.
+ *
+ * @return #CO_NMT_internalState_t of the node, #CO_NMTMASTER_UNKNOWN or
+ * #CO_NMTMASTER_UNMONITORED (also for invalid node ID).
+ */
+uint8_t CO_NMTmaster_getState(
+        const CO_NMTmaster_t   *NMTmaster,
+        uint8_t                 nodeId);
+
+
+/**
+ * Get set of nodes in the network with given state.
+ *
+ * @param NMTmaster This object.
+ * @param state #CO_NMT_internalState_t or #CO_NMTMASTER_UNKNOWN.
+ * @param [out] nodes Set of nodes with this state in the table.
+ *
+ * @return Number of nodes in the set.
+ */
+uint8_t CO_NMTmaster_getNodes(
+        const CO_NMTmaster_t   *NMTmaster,
+        uint8_t                 state,
+        CO_NMTmaster_set_t     *nodes);
+
+
+/**
+ * Give NMT command to a set of nodes.
+ *
+ * Command is sent by CO_NMTmaster_process(), after all previous commands.
+ *
+ * @param NMTmaster This object.
+ * @param command #CO_NMT_command_t.
+ * @param nodes Set of nodes. If NULL, all nodes of the network.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_TX_BUSY (queue is full, try again).
+ */
+CO_ReturnError_t CO_NMTmaster_command(
+        CO_NMTmaster_t         *NMTmaster,
+        uint8_t                 command,
+        const CO_NMTmaster_set_t *nodes);
+
+
+/**
+ * Process NMT master object.
+ *
+ * Function must be called cyclically. It sends waiting commands, as many
+ * messages as the CAN driver accepts.
+ *
+ * @param NMTmaster This object.
+ * @param timerNext_ms Return value - info to OS - see CO_process().
+ */
+void CO_NMTmaster_process(
+        CO_NMTmaster_t         *NMTmaster,
+        uint16_t               *timerNext_ms);
+
+
+/** @} */
+
+#endif /* CO_NO_NMT_MASTER == 1 */
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+#endif
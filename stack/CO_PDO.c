@@ -50,7 +50,34 @@
 #include "CO_NMT_Heartbeat.h"
 #include "CO_SYNC.h"
 #include "CO_PDO.h"
+#include "CO_statistics.h"
 #include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#ifdef CO_RPDO_IMMEDIATE
+#ifndef CO_LOCK_OD_RX
+#error CO_RPDO_IMMEDIATE requires CO_LOCK_OD_RX() from CO_driver.h, see drvTemplate
+#endif
+static void CO_RPDOcopyImmediate(CO_RPDO_t *RPDO, const CO_CANrxMsg_t *msg);
+#endif
+#ifdef CO_PDO_MPDO
+#ifndef CO_LOCK_OD_RX
+#error CO_PDO_MPDO requires CO_LOCK_OD_RX() from CO_driver.h, see drvTemplate
+#endif
+static void CO_RPDOreceiveMPDO(CO_RPDO_t *RPDO, const CO_CANrxMsg_t *msg);
+#endif
+
+#ifdef CO_RPDO_DEADLINE
+/* Values of CO_RPDO_t dlState */
+#define CO_RPDO_DL_IDLE     0U  /* not monitored */
+#define CO_RPDO_DL_ARMED    1U  /* in slot of the timer wheel */
+#define CO_RPDO_DL_EXPIRED  2U  /* in list of expired RPDOs */
+#endif
+
 
 /*
  * Read received message from CAN module.
@@ -70,6 +97,13 @@ static void CO_PDO_receive(void *object, const CO_CANrxMsg_t *msg){
         (*RPDO->operatingState == CO_NMT_OPERATIONAL) &&
         (msg->DLC >= RPDO->dataLength))
     {
+#ifdef CO_RPDO_DEADLINE
+        /* time first, CO_RPDOdeadline_process() reads it after the flag */
+        if(RPDO->deadline != NULL){
+            RPDO->dlRxTime = RPDO->deadline->now_ms;
+            RPDO->dlReceived = true;
+        }
+#endif
 #ifdef RPDO_MANUAL_CONTROL_EXTENSION
         if (CO_RPDO_isManualControl(RPDO)) {
             /* RPDO is handled by user application */
@@ -78,9 +112,24 @@ static void CO_PDO_receive(void *object, const CO_CANrxMsg_t *msg){
             }
         }
         else
+#endif
+#ifdef CO_PDO_MPDO
+        if(RPDO->MPDO != 0) {
+            CO_RPDOreceiveMPDO(RPDO, msg);
+        }
+        else
+#endif
+#ifdef CO_RPDO_IMMEDIATE
+        if(RPDO->immediate && !RPDO->synchronous) {
+            CO_RPDOcopyImmediate(RPDO, msg);
+        }
+        else
 #endif
         if(RPDO->synchronous && RPDO->SYNC->CANrxToggle) {
             /* copy data into second buffer and set 'new message' flag */
+#if CO_PDO_MAX_SIZE > 8
+            memcpy(RPDO->CANrxData[1], msg->data, RPDO->dataLength);
+#else
             RPDO->CANrxData[1][0] = msg->data[0];
             RPDO->CANrxData[1][1] = msg->data[1];
             RPDO->CANrxData[1][2] = msg->data[2];
@@ -89,11 +138,20 @@ static void CO_PDO_receive(void *object, const CO_CANrxMsg_t *msg){
             RPDO->CANrxData[1][5] = msg->data[5];
             RPDO->CANrxData[1][6] = msg->data[6];
             RPDO->CANrxData[1][7] = msg->data[7];
+#endif
 
+#ifdef CO_USE_STATISTICS
+            /* previous message was overwritten before it was processed */
+            if(IS_CANrxNew(RPDO->CANrxNew[1])) RPDO->missedCount++;
+            RPDO->rxTimestamp_us[1] = CO_STAT_RX_TIMESTAMP_US(msg);
+#endif
             SET_CANrxNew(RPDO->CANrxNew[1]);
         }
         else {
             /* copy data into default buffer and set 'new message' flag */
+#if CO_PDO_MAX_SIZE > 8
+            memcpy(RPDO->CANrxData[0], msg->data, RPDO->dataLength);
+#else
             RPDO->CANrxData[0][0] = msg->data[0];
             RPDO->CANrxData[0][1] = msg->data[1];
             RPDO->CANrxData[0][2] = msg->data[2];
@@ -102,7 +160,13 @@ static void CO_PDO_receive(void *object, const CO_CANrxMsg_t *msg){
             RPDO->CANrxData[0][5] = msg->data[5];
             RPDO->CANrxData[0][6] = msg->data[6];
             RPDO->CANrxData[0][7] = msg->data[7];
+#endif
 
+#ifdef CO_USE_STATISTICS
+            /* previous message was overwritten before it was processed */
+            if(IS_CANrxNew(RPDO->CANrxNew[0])) RPDO->missedCount++;
+            RPDO->rxTimestamp_us[0] = CO_STAT_RX_TIMESTAMP_US(msg);
+#endif
             SET_CANrxNew(RPDO->CANrxNew[0]);
         }
     }
@@ -154,6 +218,10 @@ static void CO_RPDOconfigCom(CO_RPDO_t* RPDO, uint32_t COB_IDUsedByRPDO){
         CLEAR_CANrxNew(RPDO->CANrxNew[0]);
         CLEAR_CANrxNew(RPDO->CANrxNew[1]);
     }
+
+    if(RPDO->configChanged != NULL){
+        SET_CANrxNew(*RPDO->configChanged);
+    }
 }
 
 
@@ -173,6 +241,8 @@ static void CO_RPDOconfigCom(CO_RPDO_t* RPDO, uint32_t COB_IDUsedByRPDO){
  */
 static void CO_TPDOconfigCom(CO_TPDO_t* TPDO, uint32_t COB_IDUsedByTPDO, uint8_t syncFlag){
     uint16_t ID;
+    uint8_t CANlength = TPDO->dataLength;
+    bool_t validPrev = TPDO->valid;
 
     ID = (uint16_t)COB_IDUsedByTPDO;
 
@@ -186,21 +256,47 @@ static void CO_TPDOconfigCom(CO_TPDO_t* TPDO, uint32_t COB_IDUsedByTPDO, uint8_t
         ID = 0;
         TPDO->valid = false;
     }
+    TPDO->CAN_ID = ID;
+
+#if CO_PDO_MAX_SIZE > 8
+    /* CAN FD frame has 0..8, 12, 16, 20, 24, 32, 48 or 64 data bytes */
+    if(CANlength > 8){
+        CANlength = (CANlength <= 24) ? (uint8_t)((CANlength + 3) & ~3) :
+                    (CANlength <= 32) ? 32 : (CANlength <= 48) ? 48 : 64;
+    }
+#endif
 
     TPDO->CANtxBuff = CO_CANtxBufferInit(
             TPDO->CANdevTx,            /* CAN device */
             TPDO->CANdevTxIdx,         /* index of specific buffer inside CAN module */
             ID,                        /* CAN identifier */
             0,                         /* rtr */
-            TPDO->dataLength,          /* number of data bytes */
+            CANlength,                 /* number of data bytes */
             syncFlag);                 /* synchronous message flag bit */
 
     if(TPDO->CANtxBuff == 0){
         TPDO->valid = false;
     }
+#if CO_PDO_MAX_SIZE > 8
+    else if(CANlength > TPDO->dataLength){
+        /* padding, mapped data never reaches it */
+        memset(&TPDO->CANtxBuff->data[TPDO->dataLength], 0, CANlength - TPDO->dataLength);
+    }
+#endif
+
+    if(TPDO->valid && !validPrev){
+        /* Force TPDO first send after valid. Disabled TPDO may not be
+         * processed by CO_TPDO_process(), see CO_TPDO_initConfigFlag(). */
+        TPDO->sendRequest = (TPDO->TPDOCommPar->transmissionType>=254) ? 1 : 0;
+        TPDO->inhibitTimer = 0;
+    }
+    if(TPDO->configChanged != NULL){
+        SET_CANrxNew(*TPDO->configChanged);
+    }
 }
 
 
+#ifndef CO_PDO_STATIC_MAPPING
 /*
  * Find mapped variable in Object Dictionary.
  *
@@ -213,6 +309,8 @@ static void CO_TPDOconfigCom(CO_TPDO_t* TPDO, uint32_t COB_IDUsedByTPDO, uint8_t
  * @param pLength Pointer to returning parameter: *add* length of mapped variable.
  * @param pSendIfCOSFlags Pointer to returning parameter: sendIfCOSFlags variable.
  * @param pIsMultibyteVar Pointer to returning parameter: true for multibyte variable.
+ * @param pEntryNo Pointer to returning parameter: sequence number of mapped OD
+ * entry, 0xFFFF for dummy entries.
  *
  * @return 0 on success, otherwise SDO abort code.
  */
@@ -222,8 +320,9 @@ static uint32_t CO_PDOfindMap(
         uint8_t                 R_T,
         uint8_t               **ppData,
         uint8_t                *pLength,
-        uint8_t                *pSendIfCOSFlags,
-        uint8_t                *pIsMultibyteVar)
+        CO_PDOcosFlags_t       *pSendIfCOSFlags,
+        uint8_t                *pIsMultibyteVar,
+        uint16_t               *pEntryNo)
 {
     uint16_t entryNo;
     uint16_t index;
@@ -235,6 +334,7 @@ static uint32_t CO_PDOfindMap(
     index = (uint16_t)(map>>16);
     subIndex = (uint8_t)(map>>8);
     dataLen = (uint8_t) map;   /* data length in bits */
+    *pEntryNo = 0xFFFF;
 
     /* data length must be byte aligned */
     if(dataLen&0x07) return CO_SDO_AB_NO_MAP;   /* Object cannot be mapped to the PDO. */
@@ -242,8 +342,8 @@ static uint32_t CO_PDOfindMap(
     dataLen >>= 3;    /* new data length is in bytes */
     *pLength += dataLen;
 
-    /* total PDO length can not be more than 8 bytes */
-    if(*pLength > 8) return CO_SDO_AB_MAP_LEN;  /* The number and length of the objects to be mapped would exceed PDO length. */
+    /* total PDO length can not be more than 8 bytes (64 bytes with CAN FD) */
+    if(*pLength > CO_PDO_MAX_SIZE) return CO_SDO_AB_MAP_LEN;  /* The number and length of the objects to be mapped would exceed PDO length. */
 
     /* is there a reference to dummy entries */
     if(index <=7 && subIndex == 0){
@@ -269,7 +369,7 @@ static uint32_t CO_PDOfindMap(
     entryNo = CO_OD_find(SDO, index);
 
     /* Does object exist in OD? */
-    if(entryNo == 0xFFFF || subIndex > SDO->OD[entryNo].maxSubIndex)
+    if(entryNo == 0xFFFF || subIndex > CO_OD_getMaxSubIndex(SDO, entryNo))
         return CO_SDO_AB_NOT_EXIST;   /* Object does not exist in the object dictionary. */
 
     attr = CO_OD_getAttribute(SDO, entryNo, subIndex);
@@ -285,6 +385,8 @@ static uint32_t CO_PDOfindMap(
     /* mark multibyte variable */
     *pIsMultibyteVar = (attr&CO_ODA_MB_VALUE) ? 1 : 0;
 
+    *pEntryNo = entryNo;
+
     /* pointer to data */
     *ppData = (uint8_t*) CO_OD_getDataPointer(SDO, entryNo, subIndex);
 #ifdef CO_BIG_ENDIAN
@@ -298,21 +400,409 @@ static uint32_t CO_PDOfindMap(
     if(attr&CO_ODA_TPDO_DETECT_COS){
         int16_t i;
         for(i=*pLength-dataLen; i<*pLength; i++){
-            *pSendIfCOSFlags |= 1<<i;
+            *pSendIfCOSFlags |= (CO_PDOcosFlags_t)1<<i;
         }
     }
 
     return 0;
 }
+#endif
+
+
+/*
+ * Expand COS flags of TPDO to byte mask over PDO data.
+ */
+static void CO_TPDOconfigCOSmask(CO_TPDO_t* TPDO){
+    uint8_t mask[sizeof(TPDO->COSmask)];
+    uint8_t i;
+
+    for(i=0; i<sizeof(mask); i++){
+        mask[i] = ((i < TPDO->dataLength) && (TPDO->sendIfCOSFlags & ((CO_PDOcosFlags_t)1<<i))) ? 0xFF : 0;
+    }
+    memcpy(TPDO->COSmask, mask, sizeof(TPDO->COSmask));
+}
+
+
+#ifndef CO_PDO_STATIC_MAPPING
+/*
+ * Build copy plan from PDO data pointers.
+ *
+ * Consecutive mapPointer entries, which point to consecutive bytes in Object
+ * Dictionary, are merged into one run.
+ *
+ * @param mapPointer Array of data pointers, one for each PDO data byte.
+ * @param start First valid entry in mapPointer.
+ * @param length Number of entries in mapPointer, including the first _start_.
+ * @param mapRun Pointer to returning parameter: array of CO_PDO_MAX_SIZE runs.
+ *
+ * @return Number of runs written to mapRun.
+ */
+static uint8_t CO_PDOconfigRuns(
+        uint8_t               **mapPointer,
+        uint8_t                 start,
+        uint8_t                 length,
+        CO_PDOmapRun_t         *mapRun)
+{
+    uint8_t i;
+    uint8_t count = 0;
+    CO_PDOmapRun_t *run = NULL;
+
+    for(i=start; i<length; i++){
+        if(run != NULL && (run->pOD + run->length) == mapPointer[i]){
+            run->length++;
+        }
+        else{
+            run = &mapRun[count++];
+            run->pOD = mapPointer[i];
+            run->PDOpos = i;
+            run->length = 1;
+        }
+    }
+
+    return count;
+}
+#endif
+
+
+#ifdef CO_PDO_STATIC_MAPPING
+/*
+ * Verify, that all runs of constant mapping are inside PDO data.
+ */
+static bool_t CO_PDOstaticMapIsValid(const CO_PDOstaticMap_t *map){
+    uint8_t i;
+
+    if(map == NULL || map->dataLength > CO_PDO_MAX_SIZE || map->runCount > CO_PDO_MAX_SIZE){
+        return false;
+    }
+    for(i=0; i<map->runCount; i++){
+        const CO_PDOmapRun_t *run = &map->runs[i];
+
+        if(run->pOD == NULL || ((uint16_t)run->PDOpos + run->length) > map->dataLength){
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
+
+
+/*
+ * Copy one run of PDO data.
+ *
+ * Runs of 2, 4 or 8 bytes are copied with constant size, so compiler can use
+ * single word moves.
+ */
+static void CO_PDOcopyRun(uint8_t *dst, const uint8_t *src, uint8_t length){
+    switch(length){
+        case 1: *dst = *src;         break;
+        case 2: memcpy(dst, src, 2); break;
+        case 4: memcpy(dst, src, 4); break;
+        case 8: memcpy(dst, src, 8); break;
+        default: memcpy(dst, src, length); break;
+    }
+}
+
+
+#ifdef CO_OD_PROFILING
+/*
+ * Count access to the mapped variables of a PDO, see CO_OD_PROFILING.
+ */
+static void CO_PDOprofile(CO_SDO_t *SDO, const uint16_t entryNo[], uint8_t count, CO_OD_profilePath_t path){
+    uint8_t i;
+
+    for(i=0; i<count; i++){
+        CO_OD_profileCount(SDO, entryNo[i], path);
+    }
+}
+#endif
+
+
+#ifdef CO_OD_EXTENSIONS_SPARSE
+/*
+ * Look up OD extensions of mapped variables again, if extensions were added
+ * to the sparse table after the mapping was resolved.
+ */
+static void CO_PDOrefreshExt(
+        CO_SDO_t               *SDO,
+        CO_OD_extension_t      *ext[],
+        const uint16_t          entryNo[],
+        uint8_t                 count,
+        uint16_t               *extUsed)
+{
+    uint16_t used = SDO->ODExtensionsUsed;
+    uint8_t i;
+
+    if(*extUsed != used){
+        for(i=0; i<count; i++){
+            ext[i] = CO_OD_getExtension(SDO, entryNo[i]);
+        }
+        *extUsed = used;
+    }
+}
+#endif
+
+
+/*
+ * Mark mapped variables of RPDO as written after data was copied to OD.
+ */
+static void CO_RPDOmarkWritten(CO_RPDO_t *RPDO){
+    uint8_t i;
+
+#ifdef CO_OD_EXTENSIONS_SPARSE
+    CO_PDOrefreshExt(RPDO->SDO, RPDO->mapExt, RPDO->mapEntryNo, RPDO->mapObjCount, &RPDO->mapExtUsed);
+#endif
+    for(i=0; i<RPDO->mapObjCount; i++){
+        const CO_OD_extension_t *ext = RPDO->mapExt[i];
+
+        if(ext != NULL && ext->flags != NULL){
+            ext->flags[RPDO->mapSubIndex[i]] |= CO_ODFL_RPDO_WRITTEN | CO_ODFL_TPDO_COS_DIRTY;
+        }
+    }
+#ifdef CO_OD_PROFILING
+    CO_PDOprofile(RPDO->SDO, RPDO->profEntryNo, RPDO->profEntryCount, CO_OD_PROF_RPDO);
+#endif
+}
+
+
+#ifdef CO_RPDO_IMMEDIATE
+/*
+ * Copy received message directly to OD, see CO_RPDO_IMMEDIATE.
+ */
+static void CO_RPDOcopyImmediate(CO_RPDO_t *RPDO, const CO_CANrxMsg_t *msg){
+    uint8_t i;
+
+    CO_LOCK_OD_RX();
+    for(i=0; i<RPDO->mapRunCount; i++){
+        const CO_PDOmapRun_t *run = &RPDO->mapRun[i];
+        CO_PDOcopyRun(run->pOD, &msg->data[run->PDOpos], run->length);
+    }
+    CO_RPDOmarkWritten(RPDO);
+    CO_UNLOCK_OD_RX();
+
+#ifdef CO_USE_STATISTICS
+    RPDO->latency_us = CO_STAT_TIMESTAMP_US() - CO_STAT_RX_TIMESTAMP_US(msg);
+#endif
+
+    if(RPDO->pFunctImmediate != NULL){
+        RPDO->pFunctImmediate(RPDO->objectImmediate, RPDO);
+    }
+}
+#endif
+
+
+#ifdef CO_PDO_MPDO
+/*
+ * Verify, if object can be transferred by MPDO.
+ *
+ * @param SDO SDO object.
+ * @param entryNo Entry in Object Dictionary, may be 0xFFFF.
+ * @param subIndex Sub-index, may be out of range.
+ * @param R_T 0 for RPDO, 1 for TPDO.
+ *
+ * @return True, if object is mappable and has 1 to 4 bytes.
+ */
+static bool_t CO_MPDOisMappable(CO_SDO_t *SDO, uint16_t entryNo, uint16_t subIndex, uint8_t R_T){
+    uint8_t attr;
+    uint16_t length;
+
+    if(entryNo == 0xFFFF || subIndex > CO_OD_getMaxSubIndex(SDO, entryNo)){
+        return false;
+    }
+    attr = CO_OD_getAttribute(SDO, entryNo, (uint8_t)subIndex);
+    if(R_T==0 && !((attr&CO_ODA_RPDO_MAPABLE) && (attr&CO_ODA_WRITEABLE))) return false;
+    if(R_T!=0 && !((attr&CO_ODA_TPDO_MAPABLE) && (attr&CO_ODA_READABLE))) return false;
+    length = CO_OD_getLength(SDO, entryNo, (uint8_t)subIndex);
+
+    return (length > 0 && length <= 4) ? true : false;
+}
+
+
+/*
+ * Hash of producer node-ID and index for object dispatcher list.
+ */
+static uint16_t CO_MPDOhash(uint8_t nodeId, uint16_t index){
+    uint16_t h = (uint16_t)(index * 40503U) ^ (uint16_t)(nodeId * 157U);
+
+    return h ^ (h >> 7);
+}
+
+
+/*
+ * Find object of SAM-MPDO in object dispatcher list.
+ *
+ * @param dispatcher Object dispatcher list.
+ * @param nodeId, index, subIndex Address of the object in the producer.
+ * @param pEntryNo Pointer to returning parameter: local OD entry.
+ * @param pSubIndex Pointer to returning parameter: local sub-index.
+ *
+ * @return True, if object is in the list.
+ */
+static bool_t CO_MPDOdispatcherFind(
+        const CO_MPDOdispatcher_t *dispatcher,
+        uint8_t                 nodeId,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint16_t               *pEntryNo,
+        uint8_t                *pSubIndex)
+{
+    uint16_t mask = dispatcher->hashSize - 1U;
+    uint16_t slot = CO_MPDOhash(nodeId, index) & mask;
+    uint16_t pos;
+
+    /* list is shorter than hash table, so there is always an empty slot */
+    while((pos = dispatcher->hash[slot]) != 0){
+        uint64_t entry = dispatcher->list[pos - 1U];
+
+        if((uint8_t)entry == nodeId && (uint16_t)(entry >> 16) == index){
+            uint8_t first = (uint8_t)(entry >> 8);
+            uint8_t blockSize = (uint8_t)(entry >> 56);
+
+            if(blockSize == 0) blockSize = 1;
+            if(subIndex >= first && (uint8_t)(subIndex - first) < blockSize){
+                *pEntryNo = dispatcher->entryNo[pos - 1U];
+                *pSubIndex = (uint8_t)(entry >> 32) + (subIndex - first);
+                return true;
+            }
+        }
+        slot = (slot + 1U) & mask;
+    }
+
+    return false;
+}
+
+
+/*
+ * Write data of received MPDO into Object Dictionary, see CO_PDO_MPDO.
+ */
+static void CO_RPDOreceiveMPDO(CO_RPDO_t *RPDO, const CO_CANrxMsg_t *msg){
+    CO_SDO_t *SDO = RPDO->SDO;
+    uint8_t address = msg->data[0];
+    uint16_t index = (uint16_t)msg->data[1] | ((uint16_t)msg->data[2] << 8);
+    uint16_t entryNo;
+    uint8_t subIndex = msg->data[3];
+    uint8_t *pOD;
+    uint8_t *flags;
+    uint8_t length;
+    uint8_t i;
+
+    if(RPDO->MPDO == CO_PDO_MPDO_DAM){
+        /* object of own Object Dictionary, addressed to this or to all nodes */
+        if((address & 0x80U) == 0 || ((address & 0x7FU) != 0 && (address & 0x7FU) != RPDO->nodeId)){
+            return;
+        }
+        entryNo = CO_OD_find(SDO, index);
+        if(!CO_MPDOisMappable(SDO, entryNo, subIndex, 0)){
+            return;
+        }
+    }
+    else{
+        /* object of producer, from dispatcher list */
+        if((address & 0x80U) != 0 || RPDO->dispatcher == NULL ||
+           !CO_MPDOdispatcherFind(RPDO->dispatcher, address, index, subIndex, &entryNo, &subIndex))
+        {
+            return;
+        }
+    }
+
+    pOD = (uint8_t*) CO_OD_getDataPointer(SDO, entryNo, subIndex);
+    length = CO_OD_getLength(SDO, entryNo, subIndex);
+    flags = CO_OD_getFlagsPointer(SDO, entryNo, subIndex);
+
+    CO_LOCK_OD_RX();
+#ifdef CO_BIG_ENDIAN
+    if(CO_OD_getAttribute(SDO, entryNo, subIndex) & CO_ODA_MB_VALUE){
+        for(i=0; i<length; i++){
+            pOD[i] = msg->data[3 + length - i];
+        }
+    }
+    else
+#endif
+    {
+        for(i=0; i<length; i++){
+            pOD[i] = msg->data[4 + i];
+        }
+    }
+    if(flags != NULL){
+        *flags |= CO_ODFL_RPDO_WRITTEN | CO_ODFL_TPDO_COS_DIRTY;
+    }
+    CO_UNLOCK_OD_RX();
+#ifdef CO_OD_PROFILING
+    CO_OD_profileCount(SDO, entryNo, CO_OD_PROF_RPDO);
+#endif
+}
+
+
+/*
+ * Copy next object of MPDO into the CAN transmit buffer, see CO_PDO_MPDO.
+ */
+static void CO_TPDOcopyMPDO(CO_TPDO_t *TPDO){
+    uint8_t *data = TPDO->CANtxBuff->data;
+    uint8_t i;
+
+    memset(&data[4], 0, 4);
+
+    if(TPDO->MPDO == CO_PDO_MPDO_DAM){
+        data[0] = 0x80U | TPDO->MPDOdestination;
+        data[1] = (uint8_t)(TPDO->MPDOmux >> 16);
+        data[2] = (uint8_t)(TPDO->MPDOmux >> 24);
+        data[3] = (uint8_t)(TPDO->MPDOmux >> 8);
+        for(i=0; i<TPDO->mapRunCount; i++){
+            const CO_PDOmapRun_t *run = &TPDO->mapRun[i];
+            CO_PDOcopyRun(&data[run->PDOpos], run->pOD, run->length);
+        }
+    }
+    else{
+        CO_MPDOscanner_t *scanner = TPDO->scanner;
+        uint32_t entry = scanner->list[scanner->pos];
+        uint16_t entryNo = scanner->entryNo[scanner->pos];
+        uint8_t blockSize = (uint8_t)(entry >> 24);
+        uint8_t subIndex = (uint8_t)entry + scanner->blockPos;
+        const uint8_t *pOD = (const uint8_t*) CO_OD_getDataPointer(TPDO->SDO, entryNo, subIndex);
+        uint8_t length = CO_OD_getLength(TPDO->SDO, entryNo, subIndex);
+
+        data[0] = TPDO->nodeId & 0x7FU;
+        data[1] = (uint8_t)(entry >> 8);
+        data[2] = (uint8_t)(entry >> 16);
+        data[3] = subIndex;
+#ifdef CO_BIG_ENDIAN
+        if(CO_OD_getAttribute(TPDO->SDO, entryNo, subIndex) & CO_ODA_MB_VALUE){
+            for(i=0; i<length; i++){
+                data[4 + i] = pOD[length - 1 - i];
+            }
+        }
+        else
+#endif
+        {
+            for(i=0; i<length; i++){
+                data[4 + i] = pOD[i];
+            }
+        }
+#ifdef CO_OD_PROFILING
+        CO_OD_profileCount(TPDO->SDO, entryNo, CO_OD_PROF_TPDO);
+#endif
+
+        /* next object */
+        if(blockSize == 0) blockSize = 1;
+        if(++scanner->blockPos >= blockSize){
+            scanner->blockPos = 0;
+            if(++scanner->pos >= scanner->listSize){
+                scanner->pos = 0;
+            }
+        }
+    }
+}
+#endif
 
 
+#ifndef CO_PDO_STATIC_MAPPING
 /*
  * Configure RPDO Mapping parameter.
  *
  * Function is called from communication reset or when parameter changes.
  *
  * Function configures following variables from CO_RPDO_t: _dataLength_ and
- * _mapPointer_.
+ * _mapRun_.
  *
  * @param RPDO RPDO object.
  * @param noOfMappedObjects Number of mapped object (from OD).
@@ -321,16 +811,39 @@ static uint32_t CO_PDOfindMap(
  */
 static uint32_t CO_RPDOconfigMap(CO_RPDO_t* RPDO, uint8_t noOfMappedObjects){
     int16_t i;
+    uint8_t *mapPointer[CO_PDO_MAX_SIZE];
     uint8_t length = 0;
     uint32_t ret = 0;
     const uint32_t* pMap = &RPDO->RPDOMapPar->mappedObject1;
 
+    RPDO->mapObjCount = 0;
+#ifdef CO_OD_EXTENSIONS_SPARSE
+    RPDO->mapExtUsed = RPDO->SDO->ODExtensionsUsed;
+#endif
+#ifdef CO_OD_PROFILING
+    RPDO->profEntryCount = 0;
+#endif
+#ifdef CO_PDO_LAZY_MAPPING
+    RPDO->mapPending = false;
+#endif
+#ifdef CO_PDO_MPDO
+    RPDO->MPDO = 0;
+    if(noOfMappedObjects == CO_PDO_MPDO_SAM || noOfMappedObjects == CO_PDO_MPDO_DAM){
+        /* objects are addressed by each message, SAM needs dispatcher list */
+        RPDO->MPDO = noOfMappedObjects;
+        RPDO->dataLength = (noOfMappedObjects == CO_PDO_MPDO_DAM || RPDO->dispatcher != NULL) ? 8 : 0;
+        RPDO->mapRunCount = 0;
+        return 0;
+    }
+#endif
+
     for(i=noOfMappedObjects; i>0; i--){
         int16_t j;
         uint8_t* pData;
-        uint8_t dummy = 0;
+        CO_PDOcosFlags_t dummy = 0;
         uint8_t prevLength = length;
         uint8_t MBvar;
+        uint16_t entryNo;
         uint32_t map = *(pMap++);
 
         /* function do much checking of errors in map */
@@ -341,32 +854,50 @@ static uint32_t CO_RPDOconfigMap(CO_RPDO_t* RPDO, uint8_t noOfMappedObjects){
                 &pData,
                 &length,
                 &dummy,
-                &MBvar);
+                &MBvar,
+                &entryNo);
         if(ret){
             length = 0;
+            RPDO->mapObjCount = 0;
+#ifdef CO_OD_PROFILING
+            RPDO->profEntryCount = 0;
+#endif
             CO_errorReport(RPDO->em, CO_EM_PDO_WRONG_MAPPING, CO_EMC_PROTOCOL_ERROR, map);
             break;
         }
 
+        RPDO->mapExt[RPDO->mapObjCount] = CO_OD_getExtension(RPDO->SDO, entryNo);
+        RPDO->mapSubIndex[RPDO->mapObjCount] = (uint8_t)(map>>8);
+#ifdef CO_OD_EXTENSIONS_SPARSE
+        RPDO->mapEntryNo[RPDO->mapObjCount] = entryNo;
+#endif
+        RPDO->mapObjCount++;
+#ifdef CO_OD_PROFILING
+        if(entryNo != 0xFFFF){
+            RPDO->profEntryNo[RPDO->profEntryCount++] = entryNo;
+        }
+#endif
+
         /* write PDO data pointers */
 #ifdef CO_BIG_ENDIAN
         if(MBvar){
             for(j=length-1; j>=prevLength; j--)
-                RPDO->mapPointer[j] = pData++;
+                mapPointer[j] = pData++;
         }
         else{
             for(j=prevLength; j<length; j++)
-                RPDO->mapPointer[j] = pData++;
+                mapPointer[j] = pData++;
         }
 #else
         for(j=prevLength; j<length; j++){
-            RPDO->mapPointer[j] = pData++;
+            mapPointer[j] = pData++;
         }
 #endif
 
     }
 
     RPDO->dataLength = length;
+    RPDO->mapRunCount = CO_PDOconfigRuns(mapPointer, 0, length, RPDO->mapRun);
 
     return ret;
 }
@@ -378,7 +909,7 @@ static uint32_t CO_RPDOconfigMap(CO_RPDO_t* RPDO, uint8_t noOfMappedObjects){
  * Function is called from communication reset or when parameter changes.
  *
  * Function configures following variables from CO_TPDO_t: _dataLength_,
- * _mapPointer_ and _sendIfCOSFlags_.
+ * _mapRun_, _sendIfCOSFlags_ and _COSmask_.
  *
  * @param TPDO TPDO object.
  * @param noOfMappedObjects Number of mapped object (from OD).
@@ -387,17 +918,52 @@ static uint32_t CO_RPDOconfigMap(CO_RPDO_t* RPDO, uint8_t noOfMappedObjects){
  */
 static uint32_t CO_TPDOconfigMap(CO_TPDO_t* TPDO, uint8_t noOfMappedObjects){
     int16_t i;
+    uint8_t *mapPointer[CO_PDO_MAX_SIZE];
+    uint8_t start = 0;
     uint8_t length = 0;
     uint32_t ret = 0;
     const uint32_t* pMap = &TPDO->TPDOMapPar->mappedObject1;
 
     TPDO->sendIfCOSFlags = 0;
+#ifdef TPDO_COS_DIRTY_FLAGS
+    TPDO->COSobjCount = 0;
+#ifdef CO_OD_EXTENSIONS_SPARSE
+    TPDO->COSextUsed = TPDO->SDO->ODExtensionsUsed;
+#endif
+#endif
+#ifdef CO_OD_PROFILING
+    TPDO->profEntryCount = 0;
+#endif
+#ifdef CO_PDO_LAZY_MAPPING
+    TPDO->mapPending = false;
+#endif
+#ifdef CO_PDO_MPDO
+    TPDO->MPDO = 0;
+    if(noOfMappedObjects == CO_PDO_MPDO_SAM){
+        /* objects are taken from scanner list */
+        TPDO->MPDO = CO_PDO_MPDO_SAM;
+        TPDO->dataLength = (TPDO->scanner != NULL) ? 8 : 0;
+        TPDO->mapRunCount = 0;
+        CO_TPDOconfigCOSmask(TPDO);
+        return 0;
+    }
+    if(noOfMappedObjects == CO_PDO_MPDO_DAM){
+        /* single object behind the multiplexer */
+        TPDO->MPDO = CO_PDO_MPDO_DAM;
+        TPDO->MPDOmux = TPDO->TPDOMapPar->mappedObject1 & 0xFFFFFF00UL;
+        noOfMappedObjects = 1;
+        start = 4;
+        length = 4;
+    }
+#endif
 
     for(i=noOfMappedObjects; i>0; i--){
         int16_t j;
         uint8_t* pData;
         uint8_t prevLength = length;
+        CO_PDOcosFlags_t prevCOSFlags = TPDO->sendIfCOSFlags;
         uint8_t MBvar;
+        uint16_t entryNo;
         uint32_t map = *(pMap++);
 
         /* function do much checking of errors in map */
@@ -408,35 +974,102 @@ static uint32_t CO_TPDOconfigMap(CO_TPDO_t* TPDO, uint8_t noOfMappedObjects){
                 &pData,
                 &length,
                 &TPDO->sendIfCOSFlags,
-                &MBvar);
+                &MBvar,
+                &entryNo);
+#ifdef CO_PDO_MPDO
+        /* data of MPDO is at most 4 bytes, also with CAN FD */
+        if(ret == 0 && start != 0 && length > 8){
+            ret = CO_SDO_AB_MAP_LEN;  /* The number and length of the objects to be mapped would exceed PDO length. */
+        }
+#endif
         if(ret){
             length = 0;
+#ifdef TPDO_COS_DIRTY_FLAGS
+            TPDO->COSobjCount = 0;
+#endif
+#ifdef CO_OD_PROFILING
+            TPDO->profEntryCount = 0;
+#endif
             CO_errorReport(TPDO->em, CO_EM_PDO_WRONG_MAPPING, CO_EMC_PROTOCOL_ERROR, map);
             break;
         }
 
+#ifdef TPDO_COS_DIRTY_FLAGS
+        /* remember variables with change of state detection */
+        if(TPDO->sendIfCOSFlags != prevCOSFlags){
+            TPDO->COSext[TPDO->COSobjCount] = CO_OD_getExtension(TPDO->SDO, entryNo);
+            TPDO->COSsubIndex[TPDO->COSobjCount] = (uint8_t)(map>>8);
+#ifdef CO_OD_EXTENSIONS_SPARSE
+            TPDO->COSentryNo[TPDO->COSobjCount] = entryNo;
+#endif
+            TPDO->COSobjCount++;
+        }
+#else
+        (void)prevCOSFlags;
+#endif
+#ifdef CO_OD_PROFILING
+        if(entryNo != 0xFFFF){
+            TPDO->profEntryNo[TPDO->profEntryCount++] = entryNo;
+        }
+#endif
+        (void)entryNo;
+
         /* write PDO data pointers */
 #ifdef CO_BIG_ENDIAN
         if(MBvar){
             for(j=length-1; j>=prevLength; j--)
-                TPDO->mapPointer[j] = pData++;
+                mapPointer[j] = pData++;
         }
         else{
             for(j=prevLength; j<length; j++)
-                TPDO->mapPointer[j] = pData++;
+                mapPointer[j] = pData++;
         }
 #else
         for(j=prevLength; j<length; j++){
-            TPDO->mapPointer[j] = pData++;
+            mapPointer[j] = pData++;
         }
 #endif
 
     }
 
+    TPDO->mapRunCount = CO_PDOconfigRuns(mapPointer, start, length, TPDO->mapRun);
+#ifdef CO_PDO_MPDO
+    /* MPDO message has always 8 bytes */
+    if(start != 0 && length != 0){
+        length = 8;
+    }
+#endif
     TPDO->dataLength = length;
+    CO_TPDOconfigCOSmask(TPDO);
 
     return ret;
 }
+#endif
+
+
+#ifdef CO_PDO_LAZY_MAPPING
+/*
+ * Verify, if PDO is enabled by COB-ID, see CO_R(T)PDOconfigCom.
+ */
+static bool_t CO_PDOisEnabled(uint32_t COB_IDUsedByPDO){
+    return ((COB_IDUsedByPDO & 0xBFFFF800L) == 0 && (uint16_t)COB_IDUsedByPDO) ? true : false;
+}
+#endif
+
+
+#ifndef CO_PDO_STATIC_MAPPING
+/*
+ * Verify _numberOfMappedObjects_ written to PDO mapping parameter.
+ */
+static bool_t CO_PDOisMapCount(uint8_t noOfMappedObjects){
+#ifdef CO_PDO_MPDO
+    if(noOfMappedObjects == CO_PDO_MPDO_SAM || noOfMappedObjects == CO_PDO_MPDO_DAM){
+        return true;
+    }
+#endif
+    return (noOfMappedObjects <= 8) ? true : false;
+}
+#endif
 
 
 /*
@@ -487,6 +1120,13 @@ static CO_SDO_abortCode_t CO_ODF_RPDOcom(CO_ODF_arg_t *ODF_arg){
         if(RPDO->valid && ((*value ^ RPDO->RPDOCommPar->COB_IDUsedByRPDO) & 0x3FFFFFFFL))
             return CO_SDO_AB_INVALID_VALUE;  /* Invalid value for parameter (download only). */
 
+#ifdef CO_PDO_LAZY_MAPPING
+        /* resolve mapping, when PDO is enabled first time */
+        if(RPDO->mapPending && CO_PDOisEnabled(*value)){
+            CO_RPDOconfigMap(RPDO, RPDO->RPDOMapPar->numberOfMappedObjects);
+        }
+#endif
+
         /* configure RPDO */
         CO_RPDOconfigCom(RPDO, *value);
     }
@@ -503,6 +1143,9 @@ static CO_SDO_abortCode_t CO_ODF_RPDOcom(CO_ODF_arg_t *ODF_arg){
         /* Remove old message from second buffer. */
         if(RPDO->synchronous != synchronousPrev) {
             CLEAR_CANrxNew(RPDO->CANrxNew[1]);
+            if(RPDO->configChanged != NULL){
+                SET_CANrxNew(*RPDO->configChanged);
+            }
         }
     }
 
@@ -560,6 +1203,13 @@ static CO_SDO_abortCode_t CO_ODF_TPDOcom(CO_ODF_arg_t *ODF_arg){
         if(TPDO->valid && ((*value ^ TPDO->TPDOCommPar->COB_IDUsedByTPDO) & 0x3FFFFFFFL))
             return CO_SDO_AB_INVALID_VALUE;  /* Invalid value for parameter (download only). */
 
+#ifdef CO_PDO_LAZY_MAPPING
+        /* resolve mapping, when PDO is enabled first time */
+        if(TPDO->mapPending && CO_PDOisEnabled(*value)){
+            CO_TPDOconfigMap(TPDO, TPDO->TPDOMapPar->numberOfMappedObjects);
+        }
+#endif
+
         /* configure TPDO */
         CO_TPDOconfigCom(TPDO, *value, TPDO->CANtxBuff->syncFlag);
         TPDO->syncCounter = 255;
@@ -575,6 +1225,9 @@ static CO_SDO_abortCode_t CO_ODF_TPDOcom(CO_ODF_arg_t *ODF_arg){
             return CO_SDO_AB_INVALID_VALUE;  /* Invalid value for parameter (download only). */
         TPDO->CANtxBuff->syncFlag = (*value <= 240) ? 1 : 0;
         TPDO->syncCounter = 255;
+        if(TPDO->configChanged != NULL){
+            SET_CANrxNew(*TPDO->configChanged);
+        }
     }
     else if(ODF_arg->subIndex == 3){   /* Inhibit_Time */
         /* if PDO is valid, value can not be changed */
@@ -620,12 +1273,20 @@ static CO_SDO_abortCode_t CO_ODF_RPDOmap(CO_ODF_arg_t *ODF_arg){
 
         if(ODF_arg->subIndex == 0){
             /* If there is error in mapping, dataLength is 0, so numberOfMappedObjects is 0. */
+#ifdef CO_PDO_LAZY_MAPPING
+            if(!RPDO->dataLength && !RPDO->mapPending) *value = 0;
+#else
             if(!RPDO->dataLength) *value = 0;
+#endif
         }
         return CO_SDO_AB_NONE;
     }
 
     /* Writing Object Dictionary variable */
+#ifdef CO_PDO_STATIC_MAPPING
+    /* mapping is constant */
+    return CO_SDO_AB_READONLY;  /* Attempt to write a read only object. */
+#else
     if(RPDO->restrictionFlags & 0x08)
         return CO_SDO_AB_READONLY;  /* Attempt to write a read only object. */
     if(*RPDO->operatingState == CO_NMT_OPERATIONAL && (RPDO->restrictionFlags & 0x02))
@@ -637,7 +1298,7 @@ static CO_SDO_abortCode_t CO_ODF_RPDOmap(CO_ODF_arg_t *ODF_arg){
     if(ODF_arg->subIndex == 0){
         uint8_t *value = (uint8_t*) ODF_arg->data;
 
-        if(*value > 8)
+        if(!CO_PDOisMapCount(*value))
             return CO_SDO_AB_MAP_LEN;  /* Number and length of object to be mapped exceeds PDO length. */
 
         /* configure mapping */
@@ -649,11 +1310,16 @@ static CO_SDO_abortCode_t CO_ODF_RPDOmap(CO_ODF_arg_t *ODF_arg){
         uint32_t *value = (uint32_t*) ODF_arg->data;
         uint8_t* pData;
         uint8_t length = 0;
-        uint8_t dummy = 0;
+        CO_PDOcosFlags_t dummy = 0;
         uint8_t MBvar;
+        uint16_t entryNo;
 
         if(RPDO->dataLength)
             return CO_SDO_AB_UNSUPPORTED_ACCESS;  /* Unsupported access to an object. */
+#ifdef CO_PDO_LAZY_MAPPING
+        if(RPDO->mapPending)
+            return CO_SDO_AB_UNSUPPORTED_ACCESS;  /* Unsupported access to an object. */
+#endif
 
         /* verify if mapping is correct */
         return CO_PDOfindMap(
@@ -663,10 +1329,12 @@ static CO_SDO_abortCode_t CO_ODF_RPDOmap(CO_ODF_arg_t *ODF_arg){
                &pData,
                &length,
                &dummy,
-               &MBvar);
+               &MBvar,
+               &entryNo);
     }
 
     return CO_SDO_AB_NONE;
+#endif
 }
 
 
@@ -686,12 +1354,20 @@ static CO_SDO_abortCode_t CO_ODF_TPDOmap(CO_ODF_arg_t *ODF_arg){
 
         if(ODF_arg->subIndex == 0){
             /* If there is error in mapping, dataLength is 0, so numberOfMappedObjects is 0. */
+#ifdef CO_PDO_LAZY_MAPPING
+            if(!TPDO->dataLength && !TPDO->mapPending) *value = 0;
+#else
             if(!TPDO->dataLength) *value = 0;
+#endif
         }
         return CO_SDO_AB_NONE;
     }
 
     /* Writing Object Dictionary variable */
+#ifdef CO_PDO_STATIC_MAPPING
+    /* mapping is constant */
+    return CO_SDO_AB_READONLY;  /* Attempt to write a read only object. */
+#else
     if(TPDO->restrictionFlags & 0x08)
         return CO_SDO_AB_READONLY;  /* Attempt to write a read only object. */
     if(*TPDO->operatingState == CO_NMT_OPERATIONAL && (TPDO->restrictionFlags & 0x02))
@@ -703,7 +1379,7 @@ static CO_SDO_abortCode_t CO_ODF_TPDOmap(CO_ODF_arg_t *ODF_arg){
     if(ODF_arg->subIndex == 0){
         uint8_t *value = (uint8_t*) ODF_arg->data;
 
-        if(*value > 8)
+        if(!CO_PDOisMapCount(*value))
             return CO_SDO_AB_MAP_LEN;  /* Number and length of object to be mapped exceeds PDO length. */
 
         /* configure mapping */
@@ -715,11 +1391,16 @@ static CO_SDO_abortCode_t CO_ODF_TPDOmap(CO_ODF_arg_t *ODF_arg){
         uint32_t *value = (uint32_t*) ODF_arg->data;
         uint8_t* pData;
         uint8_t length = 0;
-        uint8_t dummy = 0;
+        CO_PDOcosFlags_t dummy = 0;
         uint8_t MBvar;
+        uint16_t entryNo;
 
         if(TPDO->dataLength)
             return CO_SDO_AB_UNSUPPORTED_ACCESS;  /* Unsupported access to an object. */
+#ifdef CO_PDO_LAZY_MAPPING
+        if(TPDO->mapPending)
+            return CO_SDO_AB_UNSUPPORTED_ACCESS;  /* Unsupported access to an object. */
+#endif
 
         /* verify if mapping is correct */
         return CO_PDOfindMap(
@@ -729,10 +1410,12 @@ static CO_SDO_abortCode_t CO_ODF_TPDOmap(CO_ODF_arg_t *ODF_arg){
                &pData,
                &length,
                &dummy,
-               &MBvar);
+               &MBvar,
+               &entryNo);
     }
 
     return CO_SDO_AB_NONE;
+#endif
 }
 
 
@@ -771,6 +1454,17 @@ CO_ReturnError_t CO_RPDO_init(
     RPDO->nodeId = nodeId;
     RPDO->defaultCOB_ID = defaultCOB_ID;
     RPDO->restrictionFlags = restrictionFlags;
+    RPDO->configChanged = NULL;
+#ifdef CO_PDO_MPDO
+    RPDO->MPDO = 0;
+    RPDO->dispatcher = NULL;
+#endif
+#ifdef CO_RPDO_DEADLINE
+    /* dlTimeout_ms is kept, monitoring is attached by CO_RPDOdeadline_init() */
+    RPDO->deadline = NULL;
+    RPDO->dlNext = NULL;
+    RPDO->dlState = CO_RPDO_DL_IDLE;
+#endif
 
     /* Configure Object dictionary entry at index 0x1400+ and 0x1600+ */
     CO_OD_configure(SDO, idx_RPDOCommPar, CO_ODF_RPDOcom, (void*)RPDO, 0, 0);
@@ -779,15 +1473,399 @@ CO_ReturnError_t CO_RPDO_init(
     /* configure communication and mapping */
     CLEAR_CANrxNew(RPDO->CANrxNew[0]);
     CLEAR_CANrxNew(RPDO->CANrxNew[1]);
+#ifdef CO_USE_STATISTICS
+    RPDO->rxTimestamp_us[0] = 0;
+    RPDO->rxTimestamp_us[1] = 0;
+    RPDO->latency_us = 0;
+    RPDO->missedCount = 0;
+#endif
     RPDO->CANdevRx = CANdevRx;
     RPDO->CANdevRxIdx = CANdevRxIdx;
 
-    CO_RPDOconfigMap(RPDO, RPDOMapPar->numberOfMappedObjects);
+#ifdef CO_PDO_STATIC_MAPPING
+    /* PDO stays invalid until CO_RPDO_initStaticMap() */
+    RPDO->mapRun = NULL;
+    RPDO->mapRunCount = 0;
+    RPDO->dataLength = 0;
+    RPDO->mapObjCount = 0;
+#ifdef CO_OD_PROFILING
+    RPDO->profEntryCount = 0;
+#endif
+#else
+#ifdef CO_PDO_LAZY_MAPPING
+    if(!CO_PDOisEnabled(RPDOCommPar->COB_IDUsedByRPDO) && RPDOMapPar->numberOfMappedObjects != 0){
+        CO_RPDOconfigMap(RPDO, 0);
+        RPDO->mapPending = true;
+    }
+    else
+#endif
+    {
+        CO_RPDOconfigMap(RPDO, RPDOMapPar->numberOfMappedObjects);
+    }
+#endif
     CO_RPDOconfigCom(RPDO, RPDOCommPar->COB_IDUsedByRPDO);
 
     return CO_ERROR_NO;
 }
 
+
+/******************************************************************************/
+void CO_RPDO_initConfigFlag(
+        CO_RPDO_t              *RPDO,
+        volatile void         **configChanged)
+{
+    if(RPDO != NULL){
+        RPDO->configChanged = configChanged;
+    }
+}
+
+#ifdef CO_PDO_STATIC_MAPPING
+/******************************************************************************/
+CO_ReturnError_t CO_RPDO_initStaticMap(
+        CO_RPDO_t              *RPDO,
+        const CO_PDOstaticMap_t *map)
+{
+    /* verify arguments */
+    if(RPDO==NULL || !CO_PDOstaticMapIsValid(map)){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    RPDO->mapRun = map->runs;
+    RPDO->mapRunCount = map->runCount;
+    RPDO->dataLength = map->dataLength;
+    CO_RPDOconfigCom(RPDO, RPDO->RPDOCommPar->COB_IDUsedByRPDO);
+
+    return CO_ERROR_NO;
+}
+#endif
+
+#ifdef CO_PDO_MPDO
+/******************************************************************************/
+CO_ReturnError_t CO_RPDO_initMPDOdispatcher(
+        CO_RPDO_t              *RPDO,
+        CO_MPDOdispatcher_t    *dispatcher)
+{
+    uint16_t mask;
+    uint16_t i;
+
+    /* verify arguments */
+    if(RPDO==NULL || dispatcher==NULL || dispatcher->list==NULL ||
+       dispatcher->entryNo==NULL || dispatcher->hash==NULL ||
+       dispatcher->hashSize <= dispatcher->listSize ||
+       (dispatcher->hashSize & (dispatcher->hashSize - 1U)) != 0){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    RPDO->dispatcher = NULL;
+    mask = dispatcher->hashSize - 1U;
+    memset(dispatcher->hash, 0, dispatcher->hashSize * sizeof(dispatcher->hash[0]));
+
+    for(i=0; i<dispatcher->listSize; i++){
+        uint64_t entry = dispatcher->list[i];
+        uint16_t entryNo = CO_OD_find(RPDO->SDO, (uint16_t)(entry >> 40));
+        uint16_t subIndex = (uint8_t)(entry >> 32);
+        uint16_t blockSize = (uint8_t)(entry >> 56);
+        uint16_t slot;
+        uint16_t j;
+
+        if(blockSize == 0) blockSize = 1;
+        if(((uint16_t)(uint8_t)(entry >> 8) + blockSize) > 256U){
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+        for(j=0; j<blockSize; j++){
+            if(!CO_MPDOisMappable(RPDO->SDO, entryNo, subIndex + j, 0)){
+                return CO_ERROR_ILLEGAL_ARGUMENT;
+            }
+        }
+        dispatcher->entryNo[i] = entryNo;
+
+        slot = CO_MPDOhash((uint8_t)entry, (uint16_t)(entry >> 16)) & mask;
+        while(dispatcher->hash[slot] != 0){
+            slot = (slot + 1U) & mask;
+        }
+        dispatcher->hash[slot] = i + 1U;
+    }
+
+    RPDO->dispatcher = dispatcher;
+    if(RPDO->MPDO == CO_PDO_MPDO_SAM){
+        CO_RPDOconfigMap(RPDO, CO_PDO_MPDO_SAM);
+        CO_RPDOconfigCom(RPDO, RPDO->RPDOCommPar->COB_IDUsedByRPDO);
+    }
+
+    return CO_ERROR_NO;
+}
+#endif
+
+#ifdef CO_RPDO_IMMEDIATE
+/******************************************************************************/
+CO_ReturnError_t CO_RPDO_setImmediate(
+        CO_RPDO_t              *RPDO,
+        bool_t                  immediate,
+        void                   *object,
+        void                  (*pFunct)(void *object, const CO_RPDO_t *RPDO))
+{
+    if(RPDO==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* callback is set first, receive may run concurrently */
+    RPDO->immediate = false;
+    RPDO->pFunctImmediate = pFunct;
+    RPDO->objectImmediate = object;
+    RPDO->immediate = immediate;
+
+    return CO_ERROR_NO;
+}
+#endif
+
+#ifdef CO_RPDO_DEADLINE
+/*
+ * Insert RPDO into the slot of the timer wheel, where it is checked next.
+ */
+static void CO_RPDOdeadlineInsert(CO_RPDOdeadline_t *DL, CO_RPDO_t *RPDO, uint16_t due){
+    CO_RPDO_t **slot = &DL->slot[due & (CO_RPDO_DEADLINE_SLOTS - 1U)];
+
+    RPDO->dlDue = due;
+    RPDO->dlState = CO_RPDO_DL_ARMED;
+    RPDO->dlNext = *slot;
+    *slot = RPDO;
+}
+
+
+/*
+ * Insert received RPDO with deadline one timeout after its reception. If
+ * that has already passed, it is checked with the next tick, because the
+ * slot of the current tick was already visited.
+ */
+static void CO_RPDOdeadlineInsertRx(CO_RPDOdeadline_t *DL, CO_RPDO_t *RPDO){
+    uint16_t due = (uint16_t)(RPDO->dlRxTime + RPDO->dlTimeout_ms);
+
+    if((int16_t)(due - DL->now_ms) <= 0){
+        due = (uint16_t)(DL->now_ms + 1U);
+    }
+    CO_RPDOdeadlineInsert(DL, RPDO, due);
+}
+
+
+/*
+ * Remove all RPDOs from monitoring and reset the emergency.
+ */
+static void CO_RPDOdeadlineClear(CO_RPDOdeadline_t *DL){
+    uint16_t i;
+
+    for(i=0; i<CO_RPDO_DEADLINE_SLOTS; i++){
+        DL->slot[i] = NULL;
+    }
+    DL->expired = NULL;
+    for(i=0; i<DL->RPDOcount; i++){
+        DL->RPDOs[i]->dlNext = NULL;
+        DL->RPDOs[i]->dlState = CO_RPDO_DL_IDLE;
+    }
+    if(DL->expiredCount != 0U){
+        DL->expiredCount = 0;
+        CO_errorReset(DL->em, CO_EM_RPDO_TIME_OUT, 0);
+    }
+}
+
+
+/*
+ * Check RPDO, whose slot is reached: move it to the slot of the new deadline,
+ * if it was received in time, otherwise it expires.
+ */
+static void CO_RPDOdeadlineCheck(CO_RPDOdeadline_t *DL, CO_RPDO_t *RPDO){
+    if(!RPDO->valid || RPDO->dlTimeout_ms == 0U){
+        /* disabled in the meantime, remains so until next arming */
+        RPDO->dlState = CO_RPDO_DL_IDLE;
+    }
+    else if(RPDO->dlReceived){
+        RPDO->dlReceived = false;
+        RPDO->dlStarted = true;
+        CO_RPDOdeadlineInsertRx(DL, RPDO);
+    }
+    else if(!RPDO->dlStarted){
+        /* monitoring starts with the first message */
+        CO_RPDOdeadlineInsert(DL, RPDO, (uint16_t)(DL->now_ms + RPDO->dlTimeout_ms));
+    }
+    else{
+        RPDO->dlState = CO_RPDO_DL_EXPIRED;
+        RPDO->dlNext = DL->expired;
+        DL->expired = RPDO;
+        DL->expiredCount++;
+        DL->expiryCount++;
+        CO_errorReport(DL->em, CO_EM_RPDO_TIME_OUT, CO_EMC_RPDO_TIMEOUT, RPDO->idx_RPDOCommPar);
+        if(DL->pFunctSignal != NULL){
+            DL->pFunctSignal(DL->functSignalObject, RPDO, true);
+        }
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_RPDOdeadline_init(
+        CO_RPDOdeadline_t      *DL,
+        CO_EM_t                *em,
+        CO_RPDO_t             **RPDOs,
+        uint16_t                RPDOcount)
+{
+    uint16_t i;
+
+    /* verify arguments */
+    if(DL==NULL || em==NULL || (RPDOs==NULL && RPDOcount!=0U)){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    DL->em = em;
+    DL->RPDOs = RPDOs;
+    DL->RPDOcount = RPDOcount;
+    DL->expiredCount = 0;
+    DL->expiryCount = 0;
+    DL->now_ms = 0;
+    DL->time_us = 0;
+    DL->operational = false;
+    DL->rearm = false;
+    DL->pFunctSignal = NULL;
+    DL->functSignalObject = NULL;
+    for(i=0; i<RPDOcount; i++){
+        RPDOs[i]->deadline = DL;
+    }
+    CO_RPDOdeadlineClear(DL);
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_RPDOdeadline_initCallback(
+        CO_RPDOdeadline_t      *DL,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, CO_RPDO_t *RPDO, bool_t expired))
+{
+    if(DL != NULL){
+        DL->functSignalObject = object;
+        DL->pFunctSignal = pFunctSignal;
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_RPDO_setDeadline(
+        CO_RPDO_t              *RPDO,
+        uint16_t                timeout_ms)
+{
+    if(RPDO==NULL || timeout_ms > 0x7FFFU){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    RPDO->dlTimeout_ms = timeout_ms;
+    if(RPDO->deadline != NULL){
+        CO_RPDOdeadline_rearm(RPDO->deadline);
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_RPDOdeadline_rearm(CO_RPDOdeadline_t *DL){
+    if(DL != NULL){
+        DL->rearm = true;
+    }
+}
+
+
+/******************************************************************************/
+void CO_RPDOdeadline_process(
+        CO_RPDOdeadline_t      *DL,
+        bool_t                  operational,
+        uint32_t                timeDifference_us)
+{
+    uint32_t time_us;
+    uint32_t ticks;
+    uint16_t i;
+
+    /* time base runs always, receive reads it */
+    time_us = DL->time_us + timeDifference_us;
+    ticks = time_us / 1000U;
+    DL->time_us = (uint16_t)(time_us % 1000U);
+
+    if(!operational){
+        if(DL->operational){
+            CO_RPDOdeadlineClear(DL);
+            DL->operational = false;
+        }
+        DL->now_ms = (uint16_t)(DL->now_ms + ticks);
+        return;
+    }
+
+    /* arm all monitored RPDOs, first deadline is one timeout from now */
+    if(!DL->operational || DL->rearm){
+        DL->operational = true;
+        DL->rearm = false;
+        CO_RPDOdeadlineClear(DL);
+        for(i=0; i<DL->RPDOcount; i++){
+            CO_RPDO_t *RPDO = DL->RPDOs[i];
+
+            if(RPDO->valid && RPDO->dlTimeout_ms != 0U){
+                RPDO->dlReceived = false;
+                RPDO->dlStarted = false;
+                CO_RPDOdeadlineInsert(DL, RPDO, (uint16_t)(DL->now_ms + RPDO->dlTimeout_ms));
+            }
+        }
+    }
+
+    /* expired RPDOs, which are received again */
+    if(DL->expired != NULL){
+        CO_RPDO_t **prev = &DL->expired;
+
+        while(*prev != NULL){
+            CO_RPDO_t *RPDO = *prev;
+
+            if(RPDO->dlReceived){
+                *prev = RPDO->dlNext;
+                DL->expiredCount--;
+                RPDO->dlReceived = false;
+                CO_RPDOdeadlineInsertRx(DL, RPDO);
+                if(DL->pFunctSignal != NULL){
+                    DL->pFunctSignal(DL->functSignalObject, RPDO, false);
+                }
+            }
+            else{
+                prev = &RPDO->dlNext;
+            }
+        }
+        if(DL->expiredCount == 0U){
+            CO_errorReset(DL->em, CO_EM_RPDO_TIME_OUT, 0);
+        }
+    }
+
+    /* advance the wheel, each slot is visited at most once per call */
+    if(ticks > CO_RPDO_DEADLINE_SLOTS){
+        DL->now_ms = (uint16_t)(DL->now_ms + ticks - CO_RPDO_DEADLINE_SLOTS);
+        ticks = CO_RPDO_DEADLINE_SLOTS;
+    }
+    while(ticks > 0U){
+        CO_RPDO_t *RPDO;
+
+        DL->now_ms++;
+        ticks--;
+        RPDO = DL->slot[DL->now_ms & (CO_RPDO_DEADLINE_SLOTS - 1U)];
+        DL->slot[DL->now_ms & (CO_RPDO_DEADLINE_SLOTS - 1U)] = NULL;
+        while(RPDO != NULL){
+            CO_RPDO_t *next = RPDO->dlNext;
+
+            /* later deadline: stays in the slot for the next round */
+            if((int16_t)(RPDO->dlDue - DL->now_ms) > 0){
+                CO_RPDOdeadlineInsert(DL, RPDO, RPDO->dlDue);
+            }
+            else{
+                CO_RPDOdeadlineCheck(DL, RPDO);
+            }
+            RPDO = next;
+        }
+    }
+}
+#endif
+
 #ifdef RPDO_MANUAL_CONTROL_EXTENSION
 /******************************************************************************/
 CO_ReturnError_t CO_RPDO_takeManualControl(
@@ -848,6 +1926,14 @@ CO_ReturnError_t CO_TPDO_init(
     TPDO->nodeId = nodeId;
     TPDO->defaultCOB_ID = defaultCOB_ID;
     TPDO->restrictionFlags = restrictionFlags;
+    TPDO->configChanged = NULL;
+#ifdef CO_PDO_MPDO
+    TPDO->MPDO = 0;
+    TPDO->scanner = NULL;
+#endif
+    TPDO->valid = false;
+    TPDO->CAN_ID = 0;
+    TPDO->budgetBlocked = false;
 #ifdef TPDO_MANUAL_CONTROL_EXTENSION
     TPDO->manualControl = false;
 #endif
@@ -860,11 +1946,99 @@ CO_ReturnError_t CO_TPDO_init(
     TPDO->CANdevTx = CANdevTx;
     TPDO->CANdevTxIdx = CANdevTxIdx;
     TPDO->syncCounter = 255;
+#ifdef CO_TPDO_PRESTAGE
+    TPDO->staged = CO_TPDO_STAGED_NONE;
+#endif
     TPDO->inhibitTimer = 0;
     TPDO->eventTimer = ((uint32_t) TPDOCommPar->eventTimer) * 1000;
     if(TPDOCommPar->transmissionType>=254) TPDO->sendRequest = 1;
+#ifdef CO_USE_STATISTICS
+    TPDO->latency_us = 0;
+    TPDO->missedCount = 0;
+    TPDO->deferrable = false;
+    TPDO->deferSend = false;
+    TPDO->deferTimer = 0;
+#endif
+
+#ifdef CO_PDO_STATIC_MAPPING
+    /* PDO stays invalid until CO_TPDO_initStaticMap() */
+    TPDO->mapRun = NULL;
+    TPDO->mapRunCount = 0;
+    TPDO->dataLength = 0;
+    TPDO->sendIfCOSFlags = 0;
+    CO_TPDOconfigCOSmask(TPDO);
+#ifdef TPDO_COS_DIRTY_FLAGS
+    TPDO->COSobjCount = 0;
+#endif
+#ifdef CO_OD_PROFILING
+    TPDO->profEntryCount = 0;
+#endif
+#else
+#ifdef CO_PDO_LAZY_MAPPING
+    if(!CO_PDOisEnabled(TPDOCommPar->COB_IDUsedByTPDO) && TPDOMapPar->numberOfMappedObjects != 0){
+        CO_TPDOconfigMap(TPDO, 0);
+        TPDO->mapPending = true;
+    }
+    else
+#endif
+    {
+        CO_TPDOconfigMap(TPDO, TPDOMapPar->numberOfMappedObjects);
+    }
+#endif
+    CO_TPDOconfigCom(TPDO, TPDOCommPar->COB_IDUsedByTPDO, ((TPDOCommPar->transmissionType<=240) ? 1 : 0));
+
+    if((TPDOCommPar->transmissionType>240 &&
+         TPDOCommPar->transmissionType<254) ||
+         TPDOCommPar->SYNCStartValue>240){
+            TPDO->valid = false;
+    }
+
+    return CO_ERROR_NO;
+}
+
 
-    CO_TPDOconfigMap(TPDO, TPDOMapPar->numberOfMappedObjects);
+/******************************************************************************/
+void CO_TPDO_initConfigFlag(
+        CO_TPDO_t              *TPDO,
+        volatile void         **configChanged)
+{
+    if(TPDO != NULL){
+        TPDO->configChanged = configChanged;
+    }
+}
+
+#ifdef CO_PDO_STATIC_MAPPING
+/******************************************************************************/
+CO_ReturnError_t CO_TPDO_initStaticMap(
+        CO_TPDO_t              *TPDO,
+        const CO_PDOstaticMap_t *map)
+{
+    const CO_TPDOCommPar_t *TPDOCommPar;
+
+    /* verify arguments */
+    if(TPDO==NULL || !CO_PDOstaticMapIsValid(map)){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    TPDO->mapRun = map->runs;
+    TPDO->mapRunCount = map->runCount;
+    TPDO->dataLength = map->dataLength;
+    TPDO->sendIfCOSFlags = map->sendIfCOSFlags;
+    CO_TPDOconfigCOSmask(TPDO);
+#ifdef TPDO_COS_DIRTY_FLAGS
+    /* no OD extensions, COS is always verified */
+    TPDO->COSobjCount = 0;
+    if(TPDO->sendIfCOSFlags){
+        TPDO->COSext[0] = NULL;
+        TPDO->COSsubIndex[0] = 0;
+#ifdef CO_OD_EXTENSIONS_SPARSE
+        TPDO->COSentryNo[0] = 0xFFFF;
+#endif
+        TPDO->COSobjCount = 1;
+    }
+#endif
+
+    TPDOCommPar = TPDO->TPDOCommPar;
     CO_TPDOconfigCom(TPDO, TPDOCommPar->COB_IDUsedByTPDO, ((TPDOCommPar->transmissionType<=240) ? 1 : 0));
 
     if((TPDOCommPar->transmissionType>240 &&
@@ -875,6 +2049,83 @@ CO_ReturnError_t CO_TPDO_init(
 
     return CO_ERROR_NO;
 }
+#endif
+
+#ifdef CO_PDO_MPDO
+/******************************************************************************/
+CO_ReturnError_t CO_TPDO_initMPDOscanner(
+        CO_TPDO_t              *TPDO,
+        CO_MPDOscanner_t       *scanner)
+{
+    const CO_TPDOCommPar_t *TPDOCommPar;
+    uint16_t i;
+
+    /* verify arguments */
+    if(TPDO==NULL || scanner==NULL || scanner->list==NULL ||
+       scanner->entryNo==NULL || scanner->listSize==0){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    TPDO->scanner = NULL;
+
+    for(i=0; i<scanner->listSize; i++){
+        uint32_t entry = scanner->list[i];
+        uint16_t entryNo = CO_OD_find(TPDO->SDO, (uint16_t)(entry >> 8));
+        uint16_t subIndex = (uint8_t)entry;
+        uint16_t blockSize = (uint8_t)(entry >> 24);
+        uint16_t j;
+
+        if(blockSize == 0) blockSize = 1;
+        for(j=0; j<blockSize; j++){
+            if(!CO_MPDOisMappable(TPDO->SDO, entryNo, subIndex + j, 1)){
+                return CO_ERROR_ILLEGAL_ARGUMENT;
+            }
+        }
+        scanner->entryNo[i] = entryNo;
+    }
+    scanner->pos = 0;
+    scanner->blockPos = 0;
+
+    TPDO->scanner = scanner;
+    if(TPDO->MPDO == CO_PDO_MPDO_SAM){
+        CO_TPDOconfigMap(TPDO, CO_PDO_MPDO_SAM);
+
+        TPDOCommPar = TPDO->TPDOCommPar;
+        CO_TPDOconfigCom(TPDO, TPDOCommPar->COB_IDUsedByTPDO, ((TPDOCommPar->transmissionType<=240) ? 1 : 0));
+
+        if((TPDOCommPar->transmissionType>240 &&
+             TPDOCommPar->transmissionType<254) ||
+             TPDOCommPar->SYNCStartValue>240){
+                TPDO->valid = false;
+        }
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_TPDO_setMPDOdestination(
+        CO_TPDO_t              *TPDO,
+        uint8_t                 nodeId)
+{
+    if(TPDO != NULL){
+        TPDO->MPDOdestination = nodeId & 0x7FU;
+    }
+}
+#endif
+
+#ifdef CO_USE_STATISTICS
+/******************************************************************************/
+void CO_TPDO_setDeferrable(
+        CO_TPDO_t              *TPDO,
+        bool_t                  deferrable)
+{
+    if(TPDO != NULL){
+        TPDO->deferrable = deferrable;
+    }
+}
+#endif
 
 #ifdef TPDO_MANUAL_CONTROL_EXTENSION
 /******************************************************************************/
@@ -915,33 +2166,217 @@ bool_t CO_TPDO_isManualControl(CO_TPDO_t *TPDO)
 uint8_t CO_TPDOisCOS(CO_TPDO_t *TPDO){
 
     /* Prepare TPDO data automatically from Object Dictionary variables */
-    uint8_t* pPDOdataByte;
-    uint8_t** ppODdataByte;
+    uint8_t data[sizeof(TPDO->COSmask)] = {0};
+    uint64_t current;
+    uint64_t sent;
+    uint8_t i;
 
-    pPDOdataByte = &TPDO->CANtxBuff->data[TPDO->dataLength];
-    ppODdataByte = &TPDO->mapPointer[TPDO->dataLength];
+    if(TPDO->sendIfCOSFlags == 0){
+        return 0;
+    }
 
-    switch(TPDO->dataLength){
-        case 8: if(*(--pPDOdataByte) != **(--ppODdataByte) && (TPDO->sendIfCOSFlags&0x80)) return 1;
-        case 7: if(*(--pPDOdataByte) != **(--ppODdataByte) && (TPDO->sendIfCOSFlags&0x40)) return 1;
-        case 6: if(*(--pPDOdataByte) != **(--ppODdataByte) && (TPDO->sendIfCOSFlags&0x20)) return 1;
-        case 5: if(*(--pPDOdataByte) != **(--ppODdataByte) && (TPDO->sendIfCOSFlags&0x10)) return 1;
-        case 4: if(*(--pPDOdataByte) != **(--ppODdataByte) && (TPDO->sendIfCOSFlags&0x08)) return 1;
-        case 3: if(*(--pPDOdataByte) != **(--ppODdataByte) && (TPDO->sendIfCOSFlags&0x04)) return 1;
-        case 2: if(*(--pPDOdataByte) != **(--ppODdataByte) && (TPDO->sendIfCOSFlags&0x02)) return 1;
-        case 1: if(*(--pPDOdataByte) != **(--ppODdataByte) && (TPDO->sendIfCOSFlags&0x01)) return 1;
+    for(i=0; i<TPDO->mapRunCount; i++){
+        const CO_PDOmapRun_t *run = &TPDO->mapRun[i];
+        CO_PDOcopyRun(&data[run->PDOpos], run->pOD, run->length);
     }
 
+    for(i=0; i<sizeof(TPDO->COSmask)/sizeof(TPDO->COSmask[0]); i++){
+        memcpy(&current, &data[i*8], sizeof(current));
+        memcpy(&sent, &TPDO->CANtxBuff->data[i*8], sizeof(sent));
+        if((current ^ sent) & TPDO->COSmask[i]){
+            return 1;
+        }
+    }
     return 0;
 }
 
-//#define TPDO_CALLS_EXTENSION
+
+/* Native word for change of state comparison */
+#if defined(__SIZEOF_POINTER__) && (__SIZEOF_POINTER__ >= 8)
+typedef uint64_t CO_PDOcosWord_t;
+#else
+typedef uint32_t CO_PDOcosWord_t;
+#endif
+
+/* Words of one TPDO in CO_TPDOisCOSbulk() */
+#define CO_PDO_COS_ROW_WORDS    (((CO_PDO_MAX_SIZE + 7) / 8) * 8 / sizeof(CO_PDOcosWord_t))
+
+#if (CO_TPDO_COS_BULK % 2) != 0
+#error CO_TPDO_COS_BULK must be even
+#endif
+
+
+/*
+ * Compare block of TPDOs collected by CO_TPDOisCOSbulk(). cur is overwritten
+ * with the masked difference. Positions of rows with difference are appended
+ * to cosList.
+ *
+ * @return New number of entries in cosList.
+ */
+static uint16_t CO_TPDOcosSweep(
+        CO_PDOcosWord_t        *cur,
+        const CO_PDOcosWord_t  *sent,
+        const CO_PDOcosWord_t  *mask,
+        const uint16_t          rowPos[],
+        uint16_t                rows,
+        uint16_t                cosList[],
+        uint16_t                cosCount)
+{
+    uint16_t words = (uint16_t)(rows * CO_PDO_COS_ROW_WORDS);
+    uint16_t k = 0;
+    uint16_t r;
+
+    /* all rows in one pass, 16 bytes at once if available */
+#if defined(__SSE2__)
+    for(; (k + 16U / sizeof(CO_PDOcosWord_t)) <= words; k += 16U / sizeof(CO_PDOcosWord_t)){
+        __m128i c = _mm_loadu_si128((const __m128i*)&cur[k]);
+        __m128i t = _mm_loadu_si128((const __m128i*)&sent[k]);
+        __m128i m = _mm_loadu_si128((const __m128i*)&mask[k]);
+        _mm_storeu_si128((__m128i*)&cur[k], _mm_and_si128(_mm_xor_si128(c, t), m));
+    }
+#elif defined(__ARM_NEON)
+    for(; (k + 16U / sizeof(CO_PDOcosWord_t)) <= words; k += 16U / sizeof(CO_PDOcosWord_t)){
+        uint8x16_t c = vld1q_u8((const uint8_t*)&cur[k]);
+        uint8x16_t t = vld1q_u8((const uint8_t*)&sent[k]);
+        uint8x16_t m = vld1q_u8((const uint8_t*)&mask[k]);
+        vst1q_u8((uint8_t*)&cur[k], vandq_u8(veorq_u8(c, t), m));
+    }
+#endif
+    for(; k<words; k++){
+        cur[k] = (cur[k] ^ sent[k]) & mask[k];
+    }
+
+    /* reduce rows */
+    for(r=0; r<rows; r++){
+        CO_PDOcosWord_t diff = 0;
+
+        for(k=0; k<CO_PDO_COS_ROW_WORDS; k++){
+            diff |= cur[r * CO_PDO_COS_ROW_WORDS + k];
+        }
+        if(diff != 0){
+            cosList[cosCount++] = rowPos[r];
+        }
+    }
+
+    return cosCount;
+}
+
+
 /******************************************************************************/
-CO_ReturnError_t CO_TPDOsend(CO_TPDO_t *TPDO){
+uint16_t CO_TPDOisCOSbulk(CO_TPDO_t *const TPDO[], uint16_t count, uint16_t cosList[]){
+    /* current data, sent data and COS mask, one row per TPDO */
+    CO_PDOcosWord_t cur[CO_TPDO_COS_BULK * CO_PDO_COS_ROW_WORDS];
+    CO_PDOcosWord_t sent[CO_TPDO_COS_BULK * CO_PDO_COS_ROW_WORDS];
+    CO_PDOcosWord_t mask[CO_TPDO_COS_BULK * CO_PDO_COS_ROW_WORDS];
+    uint16_t rowPos[CO_TPDO_COS_BULK];
+    uint16_t rows = 0;
+    uint16_t cosCount = 0;
+    uint16_t i;
+
+    for(i=0; i<count; i++){
+        CO_TPDO_t *T = TPDO[i];
+        uint8_t *data = (uint8_t*)&cur[rows * CO_PDO_COS_ROW_WORDS];
+        uint8_t j;
+
+        if(T->sendIfCOSFlags == 0){
+            continue;
+        }
+
+        /* Prepare TPDO data automatically from Object Dictionary variables */
+        memset(data, 0, sizeof(T->COSmask));
+        for(j=0; j<T->mapRunCount; j++){
+            const CO_PDOmapRun_t *run = &T->mapRun[j];
+            CO_PDOcopyRun(&data[run->PDOpos], run->pOD, run->length);
+        }
+        memcpy(&sent[rows * CO_PDO_COS_ROW_WORDS], T->CANtxBuff->data, sizeof(T->COSmask));
+        memcpy(&mask[rows * CO_PDO_COS_ROW_WORDS], T->COSmask, sizeof(T->COSmask));
+        rowPos[rows++] = i;
+
+        if(rows == CO_TPDO_COS_BULK){
+            cosCount = CO_TPDOcosSweep(cur, sent, mask, rowPos, rows, cosList, cosCount);
+            rows = 0;
+        }
+    }
+    if(rows > 0){
+        cosCount = CO_TPDOcosSweep(cur, sent, mask, rowPos, rows, cosList, cosCount);
+    }
+
+    return cosCount;
+}
+
+
+#ifdef TPDO_COS_DIRTY_FLAGS
+/******************************************************************************/
+void CO_TPDOlatchCOSdirty(CO_TPDO_t *TPDO){
+    uint8_t i;
+
+#ifdef CO_OD_EXTENSIONS_SPARSE
+    CO_PDOrefreshExt(TPDO->SDO, TPDO->COSext, TPDO->COSentryNo, TPDO->COSobjCount, &TPDO->COSextUsed);
+#endif
+    for(i=0; i<TPDO->COSobjCount; i++){
+        const CO_OD_extension_t *ext = TPDO->COSext[i];
+
+        if(ext != NULL && ext->flags != NULL){
+            uint8_t *flags = &ext->flags[TPDO->COSsubIndex[i]];
+
+            /* test and clear in one step, writer may set it again any time */
+            if((__atomic_fetch_and(flags, (uint8_t)~CO_ODFL_TPDO_COS_DIRTY, __ATOMIC_ACQ_REL)
+                & CO_ODFL_TPDO_COS_DIRTY) != 0){
+                (void)__atomic_fetch_or(flags, (uint8_t)CO_ODFL_TPDO_COS_LATCHED, __ATOMIC_RELAXED);
+            }
+        }
+    }
+}
+
+
+/******************************************************************************/
+bool_t CO_TPDOisCOSdirty(CO_TPDO_t *TPDO){
+    uint8_t i;
+
+    for(i=0; i<TPDO->COSobjCount; i++){
+        const CO_OD_extension_t *ext = TPDO->COSext[i];
+
+        /* without flags there is no information, variable may be changed */
+        if(ext == NULL || ext->flags == NULL){
+            return true;
+        }
+        if(__atomic_load_n(&ext->flags[TPDO->COSsubIndex[i]], __ATOMIC_RELAXED) & CO_ODFL_TPDO_COS_LATCHED){
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/******************************************************************************/
+void CO_TPDOclearCOSdirty(CO_TPDO_t *TPDO){
+    uint8_t i;
+
+    for(i=0; i<TPDO->COSobjCount; i++){
+        const CO_OD_extension_t *ext = TPDO->COSext[i];
+
+        if(ext != NULL && ext->flags != NULL){
+            (void)__atomic_fetch_and(&ext->flags[TPDO->COSsubIndex[i]],
+                                     (uint8_t)~CO_ODFL_TPDO_COS_LATCHED, __ATOMIC_RELAXED);
+        }
+    }
+}
+#endif
+
+//#define TPDO_CALLS_EXTENSION
+/*
+ * Copy data of the TPDO from the Object dictionary into the CAN transmit buffer.
+ */
+static void CO_TPDOcopy(CO_TPDO_t *TPDO){
     int16_t i;
-    uint8_t* pPDOdataByte;
-    uint8_t** ppODdataByte;
 
+#ifdef CO_PDO_MPDO
+    if(TPDO->MPDO != 0){
+        CO_TPDOcopyMPDO(TPDO);
+        return;
+    }
+#endif
 #ifdef TPDO_CALLS_EXTENSION
     if( !CO_TPDO_isManualControl(TPDO) && TPDO->SDO->ODExtensions){
         /* for each mapped OD, check mapping to see if an OD extension is available, and call it if it is */
@@ -954,8 +2389,8 @@ CO_ReturnError_t CO_TPDOsend(CO_TPDO_t *TPDO){
             uint8_t subIndex = (uint8_t)(map>>8);
             uint16_t entryNo = CO_OD_find(pSDO, index);
             if ( entryNo == 0xFFFF ) continue;
-            CO_OD_extension_t *ext = &pSDO->ODExtensions[entryNo];
-            if( ext->pODFunc == NULL) continue;
+            CO_OD_extension_t *ext = CO_OD_getExtension(pSDO, entryNo);
+            if( ext == NULL || ext->pODFunc == NULL) continue;
             CO_ODF_arg_t ODF_arg;
             memset((void*)&ODF_arg, 0, sizeof(CO_ODF_arg_t));
             ODF_arg.reading = true;
@@ -966,24 +2401,125 @@ CO_ReturnError_t CO_TPDOsend(CO_TPDO_t *TPDO){
             ODF_arg.pFlags = CO_OD_getFlagsPointer(pSDO, entryNo, subIndex);
             ODF_arg.data = CO_OD_getDataPointer(pSDO, entryNo, subIndex); //https://github.com/CANopenNode/CANopenNode/issues/100
             ODF_arg.dataLength = CO_OD_getLength(pSDO, entryNo, subIndex);
+#ifdef CO_OD_PROFILING
+            {
+                uint32_t start = CO_STAT_TIMESTAMP_US();
+                ext->pODFunc(&ODF_arg);
+                CO_OD_profileODF(pSDO, entryNo, CO_STAT_TIMESTAMP_US() - start);
+            }
+#else
             ext->pODFunc(&ODF_arg);
+#endif
         }
     }
 #endif
-    i = TPDO->dataLength;
-    pPDOdataByte = &TPDO->CANtxBuff->data[0];
-    ppODdataByte = &TPDO->mapPointer[0];
-
     /* Copy data from Object dictionary. */
-    for(; i>0; i--) {
-        *(pPDOdataByte++) = **(ppODdataByte++);
+    for(i=0; i<TPDO->mapRunCount; i++){
+        const CO_PDOmapRun_t *run = &TPDO->mapRun[i];
+        CO_PDOcopyRun(&TPDO->CANtxBuff->data[run->PDOpos], run->pOD, run->length);
     }
+}
+
+/******************************************************************************/
+CO_ReturnError_t CO_TPDOsend(CO_TPDO_t *TPDO){
+    CO_TPDOcopy(TPDO);
 
     TPDO->sendRequest = 0;
+#ifdef CO_OD_PROFILING
+    CO_PDOprofile(TPDO->SDO, TPDO->profEntryNo, TPDO->profEntryCount, CO_OD_PROF_TPDO);
+#endif
 
     return CO_CANCheckSend(TPDO->CANdevTx, TPDO->CANtxBuff);
 }
 
+/******************************************************************************/
+CO_ReturnError_t CO_TPDOsendSync(CO_TPDO_t *TPDO, CO_SYNC_t *SYNC){
+    CO_ReturnError_t retval;
+#ifdef CO_TPDO_PRESTAGE
+    uint8_t staged;
+
+    /* CO_TPDO_release() can't send the TPDO any more after this */
+    CO_LOCK_OD();
+    staged = TPDO->staged;
+    TPDO->staged = CO_TPDO_STAGED_NONE;
+    CO_UNLOCK_OD();
+
+    if(staged == CO_TPDO_STAGED_SENT){
+        /* sent with the SYNC, latency is set by CO_TPDO_release() */
+        TPDO->sendRequest = 0;
+#ifdef CO_OD_PROFILING
+        CO_PDOprofile(TPDO->SDO, TPDO->profEntryNo, TPDO->profEntryCount, CO_OD_PROF_TPDO);
+#endif
+        return CO_ERROR_NO;
+    }
+#endif
+
+    retval = CO_TPDOsend(TPDO);
+
+#ifdef CO_USE_STATISTICS
+    if(retval == CO_ERROR_NO){
+        TPDO->latency_us = CO_STAT_TIMESTAMP_US() - SYNC->timestamp_us;
+    }
+    else{
+        TPDO->missedCount++;
+    }
+#else
+    (void)SYNC;
+#endif
+
+    return retval;
+}
+
+#ifdef CO_TPDO_PRESTAGE
+/******************************************************************************/
+bool_t CO_TPDO_stage(CO_TPDO_t *TPDO, bool_t due){
+    if(!TPDO->valid || *TPDO->operatingState != CO_NMT_OPERATIONAL || CO_TPDO_isManualControl(TPDO)){
+        due = false;
+    }
+
+    /* TPDO sent with a SYNC stays sent, until the SYNC is processed */
+    if(TPDO->staged == CO_TPDO_STAGED_SENT){
+        return false;
+    }
+
+    if(!due){
+        if(TPDO->staged == CO_TPDO_STAGED_READY){
+            CO_LOCK_OD();
+            if(TPDO->staged == CO_TPDO_STAGED_READY){
+                TPDO->staged = CO_TPDO_STAGED_NONE;
+            }
+            CO_UNLOCK_OD();
+        }
+        return false;
+    }
+
+    CO_LOCK_OD();
+    if(TPDO->staged != CO_TPDO_STAGED_SENT){
+        CO_TPDOcopy(TPDO);
+        TPDO->staged = CO_TPDO_STAGED_READY;
+    }
+    CO_UNLOCK_OD();
+
+    return TPDO->staged == CO_TPDO_STAGED_READY;
+}
+
+/******************************************************************************/
+void CO_TPDO_release(CO_TPDO_t *TPDO, CO_SYNC_t *SYNC){
+    if(TPDO->staged == CO_TPDO_STAGED_READY && *TPDO->operatingState == CO_NMT_OPERATIONAL){
+        /* if buffer is busy, TPDO is sent after the SYNC by CO_TPDOsendSync() */
+        if(CO_CANCheckSend(TPDO->CANdevTx, TPDO->CANtxBuff) == CO_ERROR_NO){
+            TPDO->staged = CO_TPDO_STAGED_SENT;
+#ifdef CO_USE_STATISTICS
+            TPDO->latency_us = CO_STAT_TIMESTAMP_US() - SYNC->timestamp_us;
+#endif
+        }
+    }
+#ifndef CO_USE_STATISTICS
+    (void)SYNC;
+#endif
+}
+#endif
+
 //#define RPDO_CALLS_EXTENSION
 /******************************************************************************/
 void CO_RPDO_process(CO_RPDO_t *RPDO, bool_t syncWas){
@@ -1004,21 +2540,24 @@ void CO_RPDO_process(CO_RPDO_t *RPDO, bool_t syncWas){
         }
 
         while(IS_CANrxNew(RPDO->CANrxNew[bufNo])){
-            int16_t i;
-            uint8_t* pPDOdataByte;
-            uint8_t** ppODdataByte;
-
-            i = RPDO->dataLength;
-            pPDOdataByte = &RPDO->CANrxData[bufNo][0];
-            ppODdataByte = &RPDO->mapPointer[0];
+            uint8_t i;
 
             /* Copy data to Object dictionary. If between the copy operation CANrxNew
              * is set to true by receive thread, then copy the latest data again. */
             CLEAR_CANrxNew(RPDO->CANrxNew[bufNo]);
-            for(; i>0; i--) {
-                **(ppODdataByte++) = *(pPDOdataByte++);
+            for(i=0; i<RPDO->mapRunCount; i++){
+                const CO_PDOmapRun_t *run = &RPDO->mapRun[i];
+                CO_PDOcopyRun(run->pOD, &RPDO->CANrxData[bufNo][run->PDOpos], run->length);
             }
             update = true;
+#ifdef CO_USE_STATISTICS
+            RPDO->latency_us = CO_STAT_TIMESTAMP_US() - RPDO->rxTimestamp_us[bufNo];
+#endif
+        }
+
+        /* mark mapped variables as written */
+        if(update){
+            CO_RPDOmarkWritten(RPDO);
         }
 #ifdef RPDO_CALLS_EXTENSION
         if(update==true && RPDO->SDO->ODExtensions){
@@ -1033,8 +2572,8 @@ void CO_RPDO_process(CO_RPDO_t *RPDO, bool_t syncWas){
                 uint8_t subIndex = (uint8_t)(map>>8);
                 uint16_t entryNo = CO_OD_find(pSDO, index);
                 if ( entryNo == 0xFFFF ) continue;
-                CO_OD_extension_t *ext = &pSDO->ODExtensions[entryNo];
-                if( ext->pODFunc == NULL) continue;
+                CO_OD_extension_t *ext = CO_OD_getExtension(pSDO, entryNo);
+                if( ext == NULL || ext->pODFunc == NULL) continue;
                 CO_ODF_arg_t ODF_arg;
                 memset((void*)&ODF_arg, 0, sizeof(CO_ODF_arg_t));
                 ODF_arg.reading = false;
@@ -1045,7 +2584,15 @@ void CO_RPDO_process(CO_RPDO_t *RPDO, bool_t syncWas){
                 ODF_arg.pFlags = CO_OD_getFlagsPointer(pSDO, entryNo, subIndex);
                 ODF_arg.data = CO_OD_getDataPointer(pSDO, entryNo, subIndex); //https://github.com/CANopenNode/CANopenNode/issues/100
                 ODF_arg.dataLength = CO_OD_getLength(pSDO, entryNo, subIndex);
+#ifdef CO_OD_PROFILING
+                {
+                    uint32_t start = CO_STAT_TIMESTAMP_US();
+                    ext->pODFunc(&ODF_arg);
+                    CO_OD_profileODF(pSDO, entryNo, CO_STAT_TIMESTAMP_US() - start);
+                }
+#else
                 ext->pODFunc(&ODF_arg);
+#endif
             }
         }
 #endif
@@ -1068,12 +2615,28 @@ CO_ReturnError_t CO_TPDO_process(
 
         /* Send PDO by application request or by Event timer */
         if(TPDO->TPDOCommPar->transmissionType >= 253){
-            if(TPDO->inhibitTimer == 0 && (TPDO->sendRequest || (TPDO->TPDOCommPar->eventTimer && TPDO->eventTimer == 0))){
+            bool_t due = TPDO->inhibitTimer == 0 && (TPDO->sendRequest || (TPDO->TPDOCommPar->eventTimer && TPDO->eventTimer == 0));
+
+            if(due && TPDO->budgetBlocked){
+                /* send budget is used up, send in a later cycle */
+                due = false;
+            }
+#ifdef CO_USE_STATISTICS
+            if(due && TPDO->deferSend && TPDO->deferTimer < CO_TPDO_DEFER_MAX_US){
+                /* bus load is high, send later with the data from then */
+                TPDO->deferTimer += timeDifference_us;
+                due = false;
+            }
+#endif
+            if(due){
                 retval = CO_TPDOsend(TPDO);
                 if(retval == CO_ERROR_NO){
                     /* successfully sent */
                     TPDO->inhibitTimer = ((uint32_t) TPDO->TPDOCommPar->inhibitTime) * 100;
                     TPDO->eventTimer = ((uint32_t) TPDO->TPDOCommPar->eventTimer) * 1000;
+#ifdef CO_USE_STATISTICS
+                    TPDO->deferTimer = 0;
+#endif
                 }
             }
         }
@@ -1082,7 +2645,7 @@ CO_ReturnError_t CO_TPDO_process(
         else if(SYNC && syncWas){
             /* send synchronous acyclic PDO */
             if(TPDO->TPDOCommPar->transmissionType == 0){
-                if(TPDO->sendRequest) retval = CO_TPDOsend(TPDO);
+                if(TPDO->sendRequest) retval = CO_TPDOsendSync(TPDO, SYNC);
             }
             /* send synchronous cyclic PDO */
             else{
@@ -1097,13 +2660,13 @@ CO_ReturnError_t CO_TPDO_process(
                 if(TPDO->syncCounter == 254){
                     if(SYNC->counter == TPDO->TPDOCommPar->SYNCStartValue){
                         TPDO->syncCounter = TPDO->TPDOCommPar->transmissionType;
-                        retval = CO_TPDOsend(TPDO);
+                        retval = CO_TPDOsendSync(TPDO, SYNC);
                     }
                 }
                 /* Send PDO after every N-th Sync */
                 else if(--TPDO->syncCounter == 0){
                     TPDO->syncCounter = TPDO->TPDOCommPar->transmissionType;
-                    retval = CO_TPDOsend(TPDO);
+                    retval = CO_TPDOsendSync(TPDO, SYNC);
                 }
             }
         }
@@ -1113,6 +2676,13 @@ CO_ReturnError_t CO_TPDO_process(
         /* Not operational or valid. Force TPDO first send after operational or valid. */
         if(TPDO->TPDOCommPar->transmissionType>=254) TPDO->sendRequest = 1;
         else                                         TPDO->sendRequest = 0;
+#ifdef CO_TPDO_PRESTAGE
+        if(TPDO->staged != CO_TPDO_STAGED_NONE){
+            CO_LOCK_OD();
+            TPDO->staged = CO_TPDO_STAGED_NONE;
+            CO_UNLOCK_OD();
+        }
+#endif
     }
 
     /* update timers */
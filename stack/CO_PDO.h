@@ -109,6 +109,218 @@ extern "C" {
 //#define RPDO_MANUAL_CONTROL_EXTENSION
 //#define TPDO_MANUAL_CONTROL_EXTENSION
 
+/**
+ * TPDO change of state detection by dirty flags.
+ *
+ * If defined, CO_process_TPDO() calls CO_TPDOisCOS() only for TPDOs, where at
+ * least one mapped variable with _CO_ODA_TPDO_DETECT_COS_ attribute has the
+ * #CO_ODFL_TPDO_COS_DIRTY flag set. The flag is set by SDO download, RPDO
+ * reception and the application, after it writes to the variable.
+ *
+ * Flags must be configured with CO_OD_configure() for the mapped variables.
+ * If a mapped variable has no flags, change of state of the TPDO is verified
+ * on every call, as without this option. Flags are taken over with GCC
+ * compatible __atomic builtins, so writes during CO_process_TPDO() are not lost.
+ */
+//#define TPDO_COS_DIRTY_FLAGS
+
+/**
+ * Lazy PDO mapping.
+ *
+ * If defined, CO_RPDO_init() and CO_TPDO_init() do not resolve the mapping of
+ * PDOs, which are disabled by COB-ID (bit 31 set or COB-ID zero). Mapping is
+ * resolved once, when the PDO is enabled by SDO write to its COB-ID, and
+ * kept until next communication reset. Errors in mapping of disabled PDOs
+ * are then reported only, when the PDO is enabled.
+ */
+//#define CO_PDO_LAZY_MAPPING
+
+/**
+ * Immediate processing of asynchronous RPDOs.
+ *
+ * If defined, single RPDOs may be switched with CO_RPDO_setImmediate() to
+ * copy received data into the Object dictionary directly in CO_PDO_receive(),
+ * instead of in the next CO_RPDO_process(). This removes up to one period of
+ * the realtime thread from the latency, for example for setpoints.
+ *
+ * Data is copied with the copy plan of the mapping inside CO_LOCK_OD_RX(), so
+ * readers, which access the mapped variables inside CO_LOCK_OD(), always see
+ * all variables of one message together. Driver defines the lock, if it is
+ * usable from its receive context (thread, or interrupt with saved interrupt
+ * state), see drvTemplate/CO_driver.h. Synchronous RPDOs are still copied
+ * after SYNC by CO_RPDO_process(). RPDO_CALLS_EXTENSION is not used for
+ * immediate RPDOs.
+ */
+//#define CO_RPDO_IMMEDIATE
+
+/**
+ * Bucketed scheduling of synchronous cyclic TPDOs.
+ *
+ * If defined, CO_process_TPDO() keeps TPDOs with transmission type 1..240 in
+ * buckets by the SYNC cycle, in which they are due next. On each SYNC only
+ * the due TPDOs are touched, _syncCounter_ is not decremented for each TPDO.
+ * TPDOs without _SYNC start value_ get the first transmission in the least
+ * loaded SYNC cycle within their period, so TPDOs with the same transmission
+ * type are spread over the SYNC cycles. Uses 512 bytes of RAM for buckets
+ * and three bytes per TPDO.
+ */
+//#define CO_TPDO_SYNC_BUCKETS
+
+/**
+ * Pre-staged synchronous TPDOs.
+ *
+ * If defined, CO_process_TPDO() prepares synchronous TPDOs, which will be due
+ * with the next SYNC, already in each cycle before the SYNC: data is copied
+ * from the Object dictionary into the CAN transmit buffer with
+ * CO_TPDO_stage(). The SYNC object then sends the staged TPDOs with
+ * CO_TPDO_release() directly from its receive function (or right after own
+ * SYNC transmission), see CO_SYNC_initCallbackSync(). SYNC to TPDO latency is
+ * then only the turnaround of the CAN driver and does not depend on the
+ * period of the realtime thread.
+ *
+ * Data of a pre-staged TPDO is sampled in the last CO_process_TPDO() before
+ * the SYNC, not after it. TPDOs, which are not staged in time (for example
+ * sendRequest set after the last cycle or TPDO waiting for _SYNC start
+ * value_), are sent after the SYNC as without this option. Staging is
+ * protected with CO_LOCK_OD(), release from the SYNC receive function with
+ * CO_LOCK_OD_RX(). Driver defines the lock, if it is usable from its receive
+ * context (thread, or interrupt with saved interrupt state), see
+ * drvTemplate/CO_driver.h.
+ */
+//#define CO_TPDO_PRESTAGE
+
+/**
+ * Constant PDO mapping in ROM.
+ *
+ * If defined, mapping of PDOs is not resolved from the Object Dictionary at
+ * all. Copy plans are built at compile time as constant CO_PDOstaticMap_t,
+ * for example by the OD generator, and attached to the PDOs with
+ * CO_RPDO_initStaticMap() and CO_TPDO_initStaticMap() after each
+ * communication reset. PDO objects only keep a pointer to the copy plan, so
+ * the configuration pass and the RAM for the copy plans are saved. PDO stays
+ * disabled until its map is attached. Mapping parameters are read-only,
+ * their content must match the constant maps.
+ *
+ * OD extensions of mapped variables are not used: RPDOs don't set
+ * #CO_ODFL_RPDO_WRITTEN, TPDOs are verified for change of state on every
+ * call also with #TPDO_COS_DIRTY_FLAGS and mapped variables are not counted
+ * by #CO_OD_PROFILING. Can't be used with #CO_PDO_LAZY_MAPPING.
+ */
+//#define CO_PDO_STATIC_MAPPING
+
+#if defined(CO_PDO_STATIC_MAPPING) && defined(CO_PDO_LAZY_MAPPING)
+#error CO_PDO_STATIC_MAPPING can not be used with CO_PDO_LAZY_MAPPING
+#endif
+
+/**
+ * Multiplexed PDOs (MPDO) according to CiA 301.
+ *
+ * If defined, a PDO with _numberOfMappedObjects_ #CO_PDO_MPDO_SAM (0xFE) or
+ * #CO_PDO_MPDO_DAM (0xFF) is a multiplexed PDO. Each message carries one
+ * object of up to 4 bytes together with its address, so many objects are
+ * exchanged through one COB-ID:
+ *  - byte 0: bit 7 is set for destination address mode, bits 0..6 are the
+ *    node-ID of the producer (SAM) or of the consumer (DAM, 0 for all nodes),
+ *  - bytes 1..3: index and sub-index,
+ *  - bytes 4..7: data.
+ *
+ * Source address mode (SAM) producer sends the next object from its _object
+ * scanner list_ with each transmission of the TPDO, see
+ * CO_TPDO_initMPDOscanner(). SAM consumer writes objects of the producers
+ * listed in its _object dispatcher list_, see CO_RPDO_initMPDOdispatcher().
+ * Dispatcher list is indexed by a hash table, so received MPDO is found in
+ * constant time. Destination address mode (DAM) producer sends its single
+ * mapped object, DAM consumer writes the addressed object of its own Object
+ * Dictionary, if it is RPDO mappable.
+ *
+ * MPDOs are written into the Object Dictionary directly in CO_PDO_receive()
+ * inside CO_LOCK_OD_RX(), regardless of the transmission type, because
+ * consecutive messages carry different objects. Driver defines the lock, if
+ * it is usable from its receive context (thread, or interrupt with saved
+ * interrupt state), see drvTemplate/CO_driver.h. Can't be used with
+ * #CO_PDO_STATIC_MAPPING.
+ */
+//#define CO_PDO_MPDO
+
+#if defined(CO_PDO_STATIC_MAPPING) && defined(CO_PDO_MPDO)
+#error CO_PDO_STATIC_MAPPING can not be used with CO_PDO_MPDO
+#endif
+
+/**
+ * Reception deadline monitoring of RPDOs.
+ *
+ * If defined, RPDOs with a timeout from CO_RPDO_setDeadline() are supervised
+ * in NMT operational state. All RPDOs of a node share one timer wheel
+ * (CO_RPDOdeadline_t) with #CO_RPDO_DEADLINE_SLOTS slots of 1 ms. Each
+ * monitored RPDO is in the slot of its next deadline. CO_PDO_receive() only
+ * records the time of reception, the RPDO is moved to its new slot, when the
+ * old slot is reached. So CO_RPDOdeadline_process() touches each RPDO about
+ * once per timeout and not on every call, regardless of the number of RPDOs.
+ *
+ * Monitoring of an RPDO starts with its first reception after entering NMT
+ * operational or after change of the PDO configuration. If no message is
+ * received within the timeout, emergency #CO_EM_RPDO_TIME_OUT is reported
+ * with the index of the RPDO communication parameter as info code and the
+ * application callback is called. Error is reset, when all expired RPDOs are
+ * received again.
+ */
+//#define CO_RPDO_DEADLINE
+
+/**
+ * Number of slots of the RPDO deadline timer wheel, power of two.
+ *
+ * Timeouts longer than the number of slots in ms pass the wheel several times.
+ */
+#ifndef CO_RPDO_DEADLINE_SLOTS
+#define CO_RPDO_DEADLINE_SLOTS 64
+#endif
+
+#ifdef CO_RPDO_DEADLINE
+#if (CO_RPDO_DEADLINE_SLOTS & (CO_RPDO_DEADLINE_SLOTS - 1)) != 0
+#error CO_RPDO_DEADLINE_SLOTS must be a power of two
+#endif
+#endif
+
+/**
+ * Maximum length of PDO data in bytes.
+ *
+ * Default is 8 bytes for classic CAN. CAN driver with CAN FD support may set
+ * it up to 64 bytes and defines CO_CAN_DATA_MAX, the size of data in
+ * CO_CANrxMsg_t and CO_CANtx_t. Number of mapped objects is still limited
+ * to 8. TPDO longer than 8 bytes is sent with the next valid CAN FD length
+ * (12, 16, 20, 24, 32, 48 or 64 bytes), padded with zeros.
+ */
+#ifndef CO_PDO_MAX_SIZE
+#define CO_PDO_MAX_SIZE 8
+#endif
+
+#if CO_PDO_MAX_SIZE > 64
+#error CO_PDO_MAX_SIZE must not be larger than 64
+#endif
+#if CO_PDO_MAX_SIZE > 8 && !defined(CO_CAN_DATA_MAX)
+#error CO_PDO_MAX_SIZE larger than 8 requires CAN FD driver with CO_CAN_DATA_MAX
+#endif
+#if defined(CO_CAN_DATA_MAX) && CO_PDO_MAX_SIZE > CO_CAN_DATA_MAX
+#error CO_PDO_MAX_SIZE must not be larger than CO_CAN_DATA_MAX
+#endif
+
+/**
+ * Maximum time in microseconds, for which a deferrable TPDO is postponed
+ * because of high bus load, see CO_TPDO_setDeferrable().
+ */
+#ifndef CO_TPDO_DEFER_MAX_US
+#define CO_TPDO_DEFER_MAX_US 100000UL
+#endif
+
+/**
+ * Change of state flags of TPDO, one bit for each byte of PDO data.
+ */
+#if CO_PDO_MAX_SIZE > 8
+typedef uint64_t CO_PDOcosFlags_t;
+#else
+typedef uint8_t CO_PDOcosFlags_t;
+#endif
+
 
 /**
  * RPDO communication parameter. The same as record from Object dictionary (index 0x1400+).
@@ -209,10 +421,98 @@ typedef struct{
 }CO_TPDOMapPar_t;
 
 
+/**
+ * Contiguous run of mapped data.
+ *
+ * Calculated from PDO mapping in CO_RPDOconfigMap() and CO_TPDOconfigMap()
+ * or constant with #CO_PDO_STATIC_MAPPING. Bytes, which are consecutive in both, Object Dictionary and PDO, are merged
+ * into one run, so they can be copied with a single access.
+ */
+typedef struct{
+    uint8_t            *pOD;            /**< Pointer to first byte in Object Dictionary */
+    uint8_t             PDOpos;         /**< Position of first byte inside PDO data */
+    uint8_t             length;         /**< Number of bytes in run */
+}CO_PDOmapRun_t;
+
+
+#ifdef CO_PDO_STATIC_MAPPING
+/**
+ * Constant PDO mapping, see #CO_PDO_STATIC_MAPPING.
+ *
+ * Runs are in the byte order of the target. With CO_BIG_ENDIAN multibyte
+ * variables must be mapped as single byte runs in reversed order.
+ *
+ * Example for a TPDO with 16-bit and 8-bit variable, COS on all bytes:
+ *
+ *     static const CO_PDOmapRun_t TPDO1runs[] = {
+ *         {(uint8_t *)&OD_position, 0, 2},
+ *         {(uint8_t *)&OD_status,   2, 1}
+ *     };
+ *     static const CO_PDOstaticMap_t TPDO1map = {TPDO1runs, 2, 3, 0x07};
+ */
+typedef struct{
+    const CO_PDOmapRun_t *runs;         /**< Copy plan, merged runs */
+    uint8_t             runCount;       /**< Number of entries in runs */
+    uint8_t             dataLength;     /**< Length of PDO data */
+    CO_PDOcosFlags_t    sendIfCOSFlags; /**< TPDO only, same as in CO_TPDO_t */
+}CO_PDOstaticMap_t;
+#endif
+
+
+#ifdef CO_PDO_MPDO
+/** _numberOfMappedObjects_ of source address mode MPDO, see #CO_PDO_MPDO */
+#define CO_PDO_MPDO_SAM     0xFEU
+/** _numberOfMappedObjects_ of destination address mode MPDO */
+#define CO_PDO_MPDO_DAM     0xFFU
+
+
+/**
+ * Object scanner list of SAM-MPDO producer, see CO_TPDO_initMPDOscanner().
+ */
+typedef struct{
+    /** Entries as in Object Dictionary (index 0x1FA0+). Bit meanings
+    `0xBBIIIISS`: block size (number of consecutive sub-indexes, 0 is the same
+    as 1), index and sub-index of the object. */
+    const uint32_t     *list;
+    /** Resolved OD entries, one for each entry in list, filled by
+    CO_TPDO_initMPDOscanner() */
+    uint16_t           *entryNo;
+    uint16_t            listSize;       /**< Number of entries in list */
+    uint16_t            pos;            /**< Entry, which is sent next */
+    uint8_t             blockPos;       /**< Sub-index offset inside block, which is sent next */
+}CO_MPDOscanner_t;
+
+
+/**
+ * Object dispatcher list of SAM-MPDO consumer, see CO_RPDO_initMPDOdispatcher().
+ */
+typedef struct{
+    /** Entries as in Object Dictionary (index 0x1FD0+). Bit meanings
+    `0xBBIIIISSiiiissNN`: block size (0 is the same as 1), local index and
+    sub-index, index and sub-index in the producer and node-ID of the
+    producer. */
+    const uint64_t     *list;
+    /** Resolved local OD entries, one for each entry in list, filled by
+    CO_RPDO_initMPDOdispatcher() */
+    uint16_t           *entryNo;
+    /** Hash table over node-ID and index of the producer. Each slot holds the
+    position in list plus one, 0 for empty slot. Filled by
+    CO_RPDO_initMPDOdispatcher(). */
+    uint16_t           *hash;
+    uint16_t            hashSize;       /**< Number of slots, power of two, larger than listSize */
+    uint16_t            listSize;       /**< Number of entries in list */
+}CO_MPDOdispatcher_t;
+#endif
+
+
 /**
  * RPDO object.
  */
 typedef struct CO_RPDO CO_RPDO_t;
+#ifdef CO_RPDO_DEADLINE
+/** Timer wheel for RPDO deadline monitoring, see #CO_RPDO_DEADLINE */
+typedef struct CO_RPDOdeadline CO_RPDOdeadline_t;
+#endif
 struct CO_RPDO{
     CO_EM_t            *em;             /**< From CO_RPDO_init() */
     CO_SDO_t           *SDO;            /**< From CO_RPDO_init() */
@@ -231,22 +531,123 @@ struct CO_RPDO{
     bool_t              synchronous;
     /** Data length of the received PDO message. Calculated from mapping */
     uint8_t             dataLength;
-    /** Pointers to 8 data objects, where PDO will be copied */
-    uint8_t            *mapPointer[8];
+#ifdef CO_PDO_STATIC_MAPPING
+    /** Copy plan of PDO data, from CO_RPDO_initStaticMap() */
+    const CO_PDOmapRun_t *mapRun;
+#else
+    /** Copy plan of PDO data, calculated from mapping */
+    CO_PDOmapRun_t      mapRun[CO_PDO_MAX_SIZE];
+#endif
+    /** Number of valid entries in mapRun */
+    uint8_t             mapRunCount;
+    /** OD extensions of the mapped variables, NULL for dummy entries
+     * and, with CO_OD_EXTENSIONS_SPARSE, for entries without extension */
+    CO_OD_extension_t  *mapExt[8];
+    /** Sub-indexes of the mapped variables */
+    uint8_t             mapSubIndex[8];
+    /** Number of valid entries in mapExt */
+    uint8_t             mapObjCount;
+#ifdef CO_OD_EXTENSIONS_SPARSE
+    /** OD entries of the mapped variables, 0xFFFF for dummy entries */
+    uint16_t            mapEntryNo[8];
+    /** CO_SDO_t::ODExtensionsUsed, when mapExt was looked up */
+    uint16_t            mapExtUsed;
+#endif
+#ifdef CO_OD_PROFILING
+    /** OD entries of the mapped variables without dummy entries, see CO_OD_PROFILING */
+    uint16_t            profEntryNo[8];
+    /** Number of valid entries in profEntryNo */
+    uint8_t             profEntryCount;
+#endif
+#ifdef CO_PDO_LAZY_MAPPING
+    /** True, if mapping is not yet resolved, see #CO_PDO_LAZY_MAPPING */
+    bool_t              mapPending;
+#endif
 #ifdef RPDO_MANUAL_CONTROL_EXTENSION
     /** Callback from #CO_RPDO_takeManualControl() */
     void              (*pFuncManualControl)(void *object, const CO_RPDO_t *rpdo, const CO_CANrxMsg_t *message);
     void               *object;         /**< Pointer to object */
 #endif
+#ifdef CO_RPDO_IMMEDIATE
+    /** True, if RPDO is copied in CO_PDO_receive(), see #CO_RPDO_IMMEDIATE */
+    bool_t              immediate;
+    /** Callback from CO_RPDO_setImmediate() or NULL */
+    void              (*pFunctImmediate)(void *object, const CO_RPDO_t *RPDO);
+    /** Pointer to object, which will be passed to pFunctImmediate */
+    void               *objectImmediate;
+#endif
+#ifdef CO_PDO_MPDO
+    /** 0, #CO_PDO_MPDO_SAM or #CO_PDO_MPDO_DAM, from mapping */
+    uint8_t             MPDO;
+    /** From CO_RPDO_initMPDOdispatcher() or NULL */
+    CO_MPDOdispatcher_t *dispatcher;
+#endif
+#ifdef CO_RPDO_DEADLINE
+    /** From CO_RPDOdeadline_init() or NULL */
+    CO_RPDOdeadline_t  *deadline;
+    /** Next RPDO in the same slot of the timer wheel or in the list of expired RPDOs */
+    CO_RPDO_t          *dlNext;
+    /** From CO_RPDO_setDeadline(), 0 if RPDO is not monitored */
+    uint16_t            dlTimeout_ms;
+    /** Time of the slot, in which RPDO is checked next */
+    uint16_t            dlDue;
+    /** Time of the last reception, set by CO_PDO_receive() */
+    volatile uint16_t   dlRxTime;
+    /** Set by CO_PDO_receive(), cleared by CO_RPDOdeadline_process() */
+    volatile bool_t     dlReceived;
+    /** True after the first reception, since monitoring is armed */
+    bool_t              dlStarted;
+    /** RPDO is not monitored (0), in the timer wheel (1) or expired (2) */
+    uint8_t             dlState;
+#endif
+    /** From CO_RPDO_initConfigFlag() or NULL. Set, when _valid_ or
+    _synchronous_ changes. */
+    volatile void     **configChanged;
     /** Variable indicates, if new PDO message received from CAN bus. */
     volatile void      *CANrxNew[2];
-    /** 8 data bytes of the received message. */
-    uint8_t             CANrxData[2][8];
+    /** Data bytes of the received message. */
+    uint8_t             CANrxData[2][CO_PDO_MAX_SIZE];
     CO_CANmodule_t     *CANdevRx;       /**< From CO_RPDO_init() */
     uint16_t            CANdevRxIdx;    /**< From CO_RPDO_init() */
+#ifdef CO_USE_STATISTICS
+    /** Reception time of the message in CANrxData, see CO_statistics.h */
+    uint32_t            rxTimestamp_us[2];
+    /** Time from reception to copy into Object Dictionary of the last message */
+    uint32_t            latency_us;
+    /** Number of messages overwritten by the next one before they were processed */
+    uint32_t            missedCount;
+#endif
 };
 
 
+#ifdef CO_RPDO_DEADLINE
+/**
+ * Timer wheel for RPDO deadline monitoring, see #CO_RPDO_DEADLINE.
+ */
+struct CO_RPDOdeadline{
+    CO_EM_t            *em;             /**< From CO_RPDOdeadline_init() */
+    CO_RPDO_t         **RPDOs;          /**< From CO_RPDOdeadline_init() */
+    uint16_t            RPDOcount;      /**< From CO_RPDOdeadline_init() */
+    /** Monitored RPDOs, linked by _dlNext_, by their next deadline */
+    CO_RPDO_t          *slot[CO_RPDO_DEADLINE_SLOTS];
+    /** Expired RPDOs, linked by _dlNext_. Checked on each call for reception */
+    CO_RPDO_t          *expired;
+    uint16_t            expiredCount;   /**< Number of RPDOs in _expired_ */
+    /** Number of expired deadlines since CO_RPDOdeadline_init() */
+    uint32_t            expiryCount;
+    /** Time in ms, read by CO_PDO_receive() */
+    volatile uint16_t   now_ms;
+    uint16_t            time_us;        /**< Time below 1 ms */
+    bool_t              operational;    /**< NMT state at the previous call */
+    /** Set, when timeouts or PDO configuration change */
+    volatile bool_t     rearm;
+    /** From CO_RPDOdeadline_initCallback() or NULL */
+    void              (*pFunctSignal)(void *object, CO_RPDO_t *RPDO, bool_t expired);
+    void               *functSignalObject; /**< Pointer to object */
+};
+#endif
+
+
 /**
  * TPDO object.
  */
@@ -262,8 +663,13 @@ typedef struct{
     uint16_t            defaultCOB_ID;  /**< From CO_TPDO_init() */
     uint8_t             restrictionFlags;/**< From CO_TPDO_init() */
     bool_t              valid;          /**< True, if PDO is enabled and valid */
+    /** CAN identifier of the PDO, including node ID. 0 if not valid */
+    uint16_t            CAN_ID;
     /** Data length of the transmitting PDO message. Calculated from mapping */
     uint8_t             dataLength;
+    /** Set by CO_process_TPDO(), if the node wide send budget for event driven
+    TPDOs is used up. PDO is then sent in a later cycle. */
+    bool_t              budgetBlocked;
 #ifdef TPDO_MANUAL_CONTROL_EXTENSION
     /** Info for #CO_TPDO_isManualControl() */
     bool_t              manualControl;
@@ -271,21 +677,86 @@ typedef struct{
     /** If application set this flag, PDO will be later sent by
     function CO_TPDO_process(). Depends on transmission type. */
     uint8_t             sendRequest;
-    /** Pointers to 8 data objects, where PDO will be copied */
-    uint8_t            *mapPointer[8];
-    /** Each flag bit is connected with one mapPointer. If flag bit
+    /** Each flag bit is connected with one byte of PDO data. If flag bit
     is true, CO_TPDO_process() functiuon will send PDO if
-    Change of State is detected on value pointed by that mapPointer */
-    uint8_t             sendIfCOSFlags;
+    Change of State is detected on that byte */
+    CO_PDOcosFlags_t    sendIfCOSFlags;
+    /** sendIfCOSFlags expanded to a byte mask over the PDO data, 8 bytes per word */
+    uint64_t            COSmask[(CO_PDO_MAX_SIZE + 7) / 8];
+#ifdef CO_PDO_STATIC_MAPPING
+    /** Copy plan of PDO data, from CO_TPDO_initStaticMap() */
+    const CO_PDOmapRun_t *mapRun;
+#else
+    /** Copy plan of PDO data, calculated from mapping */
+    CO_PDOmapRun_t      mapRun[CO_PDO_MAX_SIZE];
+#endif
+    /** Number of valid entries in mapRun */
+    uint8_t             mapRunCount;
+#ifdef CO_PDO_LAZY_MAPPING
+    /** True, if mapping is not yet resolved, see #CO_PDO_LAZY_MAPPING */
+    bool_t              mapPending;
+#endif
+#ifdef CO_OD_PROFILING
+    /** OD entries of the mapped variables without dummy entries, see CO_OD_PROFILING */
+    uint16_t            profEntryNo[8];
+    /** Number of valid entries in profEntryNo */
+    uint8_t             profEntryCount;
+#endif
+#ifdef TPDO_COS_DIRTY_FLAGS
+    /** OD extensions of the mapped variables with change of state detection */
+    CO_OD_extension_t  *COSext[8];
+    /** Sub-indexes of the mapped variables with change of state detection */
+    uint8_t             COSsubIndex[8];
+    /** Number of valid entries in COSext */
+    uint8_t             COSobjCount;
+#ifdef CO_OD_EXTENSIONS_SPARSE
+    /** OD entries of the mapped variables with change of state detection */
+    uint16_t            COSentryNo[8];
+    /** CO_SDO_t::ODExtensionsUsed, when COSext was looked up */
+    uint16_t            COSextUsed;
+#endif
+    /** Latched result of CO_TPDOisCOSdirty(), used by CO_process_TPDO() */
+    bool_t              COSdirty;
+#endif
+#ifdef CO_PDO_MPDO
+    /** 0, #CO_PDO_MPDO_SAM or #CO_PDO_MPDO_DAM, from mapping */
+    uint8_t             MPDO;
+    /** From CO_TPDO_initMPDOscanner() or NULL */
+    CO_MPDOscanner_t   *scanner;
+    /** Index and sub-index of the mapped object of DAM-MPDO */
+    uint32_t            MPDOmux;
+    /** From CO_TPDO_setMPDOdestination(), 0 for all nodes */
+    uint8_t             MPDOdestination;
+#endif
     /** SYNC counter used for PDO sending */
     uint8_t             syncCounter;
+#ifdef CO_TPDO_PRESTAGE
+    /** CO_TPDO_STAGED_NONE, _READY or _SENT, see #CO_TPDO_PRESTAGE */
+    volatile uint8_t    staged;
+#endif
     /** Inhibit timer used for inhibit PDO sending translated to microseconds */
     uint32_t            inhibitTimer;
     /** Event timer used for PDO sending translated to microseconds */
     uint32_t            eventTimer;
+    /** From CO_TPDO_initConfigFlag() or NULL. Set, when _valid_ or
+    transmission type changes. */
+    volatile void     **configChanged;
     CO_CANmodule_t     *CANdevTx;       /**< From CO_TPDO_init() */
     CO_CANtx_t         *CANtxBuff;      /**< CAN transmit buffer inside CANdev */
     uint16_t            CANdevTxIdx;    /**< From CO_TPDO_init() */
+#ifdef CO_USE_STATISTICS
+    /** Time from SYNC to transmission of the last synchronous PDO */
+    uint32_t            latency_us;
+    /** Number of PDOs, which were due, but could not be sent */
+    uint32_t            missedCount;
+    /** From CO_TPDO_setDeferrable() */
+    bool_t              deferrable;
+    /** Set by CO_process_TPDO(), if bus load is above the limit and PDO is
+    deferrable. Event driven PDO is then sent later, see CO_TPDO_DEFER_MAX_US */
+    bool_t              deferSend;
+    /** Time, for which the pending PDO was deferred */
+    uint32_t            deferTimer;
+#endif
 }CO_TPDO_t;
 
 
@@ -334,6 +805,169 @@ CO_ReturnError_t CO_RPDO_init(
         CO_CANmodule_t         *CANdevRx,
         uint16_t                CANdevRxIdx);
 
+
+/**
+ * Initialize common flag for changed RPDO configuration.
+ *
+ * Optional flag is set, when RPDO gets enabled or disabled or when its
+ * transmission type changes between synchronous and asynchronous. The same
+ * flag may be used by all RPDOs and TPDOs, so the mainline function needs to
+ * classify the PDOs only if flag is set. See CO_process_SYNC_RPDO() for usage.
+ *
+ * @param RPDO This object.
+ * @param configChanged Pointer to the flag. Not used if NULL.
+ */
+void CO_RPDO_initConfigFlag(
+        CO_RPDO_t              *RPDO,
+        volatile void         **configChanged);
+
+
+#ifdef CO_PDO_STATIC_MAPPING
+/**
+ * Attach constant mapping to RPDO, see #CO_PDO_STATIC_MAPPING.
+ *
+ * Function must be called after CO_RPDO_init(), in the communication reset
+ * section. RPDO is then configured from its communication parameter.
+ *
+ * @param RPDO This object.
+ * @param map Constant mapping, must stay valid.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_RPDO_initStaticMap(
+        CO_RPDO_t              *RPDO,
+        const CO_PDOstaticMap_t *map);
+#endif
+
+#ifdef CO_PDO_MPDO
+/**
+ * Attach object dispatcher list to SAM-MPDO consumer, see #CO_PDO_MPDO.
+ *
+ * Function must be called after CO_RPDO_init(), in the communication reset
+ * section. It resolves the local objects and builds the hash table. RPDO with
+ * #CO_PDO_MPDO_SAM mapping stays disabled until its dispatcher is attached.
+ * List must not change while it is attached, call the function again after
+ * changing it.
+ *
+ * @param RPDO This object.
+ * @param dispatcher Dispatcher with _list_, _entryNo_, _hash_, _hashSize_ and
+ * _listSize_ set, must stay valid.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT, if
+ * arguments are wrong or if a local object is not RPDO mappable or longer than
+ * 4 bytes.
+ */
+CO_ReturnError_t CO_RPDO_initMPDOdispatcher(
+        CO_RPDO_t              *RPDO,
+        CO_MPDOdispatcher_t    *dispatcher);
+#endif
+
+#ifdef CO_RPDO_IMMEDIATE
+/**
+ * Switch RPDO to immediate processing, see #CO_RPDO_IMMEDIATE.
+ *
+ * Setting is kept over communication reset and applies, while the RPDO is
+ * asynchronous (transmission type 254 or 255).
+ *
+ * @remark Callback is called from CO_PDO_receive(), depending on the CAN
+ * driver inside an ISR. It is called after the data is written and the OD is
+ * unlocked again, so it may notify the application, but must be short.
+ *
+ * @param RPDO This object.
+ * @param immediate True = copy on reception, false = copy in CO_RPDO_process().
+ * @param object Pointer to object, which will be passed to callback. Can be NULL
+ * @param pFunct Callback function after the data is written or NULL.
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_RPDO_setImmediate(
+        CO_RPDO_t              *RPDO,
+        bool_t                  immediate,
+        void                   *object,
+        void                  (*pFunct)(void *object, const CO_RPDO_t *RPDO));
+#endif
+
+#ifdef CO_RPDO_DEADLINE
+/**
+ * Initialize RPDO deadline monitoring, see #CO_RPDO_DEADLINE.
+ *
+ * Function must be called in the communication reset section, after
+ * CO_RPDO_init() of all RPDOs.
+ *
+ * @param DL This object will be initialized.
+ * @param em Emergency object.
+ * @param RPDOs Array of all RPDOs of the node, must stay valid.
+ * @param RPDOcount Number of RPDOs.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_RPDOdeadline_init(
+        CO_RPDOdeadline_t      *DL,
+        CO_EM_t                *em,
+        CO_RPDO_t             **RPDOs,
+        uint16_t                RPDOcount);
+
+
+/**
+ * Initialize RPDO deadline callback function.
+ *
+ * Function is called with expired = true, when an RPDO is not received
+ * within its timeout, and with expired = false, when it is received again.
+ * It is called from CO_RPDOdeadline_process(), so it must be short.
+ *
+ * @param DL This object.
+ * @param object Pointer to object, which will be passed to pFunctSignal(). Can be NULL
+ * @param pFunctSignal Pointer to the callback function. Not called if NULL.
+ */
+void CO_RPDOdeadline_initCallback(
+        CO_RPDOdeadline_t      *DL,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, CO_RPDO_t *RPDO, bool_t expired));
+
+
+/**
+ * Set reception timeout of RPDO, see #CO_RPDO_DEADLINE.
+ *
+ * Setting is kept over communication reset. Monitoring starts with the next
+ * reception of the RPDO.
+ *
+ * @param RPDO This object.
+ * @param timeout_ms Maximum time between two receptions, 1 to 32767 ms, or
+ * 0 to disable monitoring.
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_RPDO_setDeadline(
+        CO_RPDO_t              *RPDO,
+        uint16_t                timeout_ms);
+
+
+/**
+ * Process RPDO deadline monitoring.
+ *
+ * Function must be called cyclically, for example from
+ * CO_process_SYNC_RPDO() after the RPDOs are processed. Monitoring is armed
+ * again, when NMT operational state is entered or the configuration of RPDOs
+ * changes. In other NMT states nothing is monitored and the emergency is
+ * reset.
+ *
+ * @param DL This object.
+ * @param operational True, if NMT state is operational.
+ * @param timeDifference_us Time difference from previous function call in [microseconds].
+ */
+void CO_RPDOdeadline_process(
+        CO_RPDOdeadline_t      *DL,
+        bool_t                  operational,
+        uint32_t                timeDifference_us);
+
+
+/**
+ * Request new arming of RPDO deadline monitoring, for example after change
+ * of PDO configuration. All expired RPDOs are cleared.
+ *
+ * @param DL This object.
+ */
+void CO_RPDOdeadline_rearm(CO_RPDOdeadline_t *DL);
+#endif
+
 #ifdef RPDO_MANUAL_CONTROL_EXTENSION
 /**
  * Request manual control of RPDO from application
@@ -413,6 +1047,91 @@ CO_ReturnError_t CO_TPDO_init(
         CO_CANmodule_t         *CANdevTx,
         uint16_t                CANdevTxIdx);
 
+
+/**
+ * Initialize common flag for changed TPDO configuration.
+ *
+ * Optional flag is set, when TPDO gets enabled or disabled or when its
+ * transmission type changes. See CO_RPDO_initConfigFlag().
+ *
+ * @param TPDO This object.
+ * @param configChanged Pointer to the flag. Not used if NULL.
+ */
+void CO_TPDO_initConfigFlag(
+        CO_TPDO_t              *TPDO,
+        volatile void         **configChanged);
+
+
+#ifdef CO_PDO_STATIC_MAPPING
+/**
+ * Attach constant mapping to TPDO, see #CO_PDO_STATIC_MAPPING.
+ *
+ * Function must be called after CO_TPDO_init(), in the communication reset
+ * section. TPDO is then configured from its communication parameter.
+ *
+ * @param TPDO This object.
+ * @param map Constant mapping, must stay valid.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_TPDO_initStaticMap(
+        CO_TPDO_t              *TPDO,
+        const CO_PDOstaticMap_t *map);
+#endif
+
+#ifdef CO_PDO_MPDO
+/**
+ * Attach object scanner list to SAM-MPDO producer, see #CO_PDO_MPDO.
+ *
+ * Function must be called after CO_TPDO_init(), in the communication reset
+ * section. Each transmission of the TPDO, triggered by its transmission type,
+ * event timer or _sendRequest_, sends the next object from the list. TPDO with
+ * #CO_PDO_MPDO_SAM mapping stays disabled until its scanner is attached. List
+ * must not change while it is attached, call the function again after
+ * changing it.
+ *
+ * @param TPDO This object.
+ * @param scanner Scanner with _list_, _entryNo_ and _listSize_ set, must stay
+ * valid.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT, if
+ * arguments are wrong or if an object is not TPDO mappable or longer than 4
+ * bytes.
+ */
+CO_ReturnError_t CO_TPDO_initMPDOscanner(
+        CO_TPDO_t              *TPDO,
+        CO_MPDOscanner_t       *scanner);
+
+
+/**
+ * Set destination of DAM-MPDO producer, see #CO_PDO_MPDO.
+ *
+ * @param TPDO This object.
+ * @param nodeId Node-ID of the consumer, 0 for all nodes. Kept over
+ * communication reset.
+ */
+void CO_TPDO_setMPDOdestination(
+        CO_TPDO_t              *TPDO,
+        uint8_t                 nodeId);
+#endif
+
+#ifdef CO_USE_STATISTICS
+/**
+ * Mark event driven TPDO as not time critical.
+ *
+ * While the bus load is above the limit from CO_setTPDOloadLimit(), sending of
+ * deferrable TPDOs with transmission type 254 or 255 is postponed, by at most
+ * CO_TPDO_DEFER_MAX_US. Data is taken at the time, when the PDO is sent. Flag
+ * is cleared by CO_TPDO_init().
+ *
+ * @param TPDO This object.
+ * @param deferrable True, if PDO may be deferred.
+ */
+void CO_TPDO_setDeferrable(
+        CO_TPDO_t              *TPDO,
+        bool_t                  deferrable);
+#endif
+
 #ifdef TPDO_MANUAL_CONTROL_EXTENSION
 /**
  * Request manual control of #CO_TPDO_process() function from application
@@ -458,6 +1177,77 @@ bool_t CO_TPDO_isManualControl(CO_TPDO_t *TPDO);
 uint8_t CO_TPDOisCOS(CO_TPDO_t *TPDO);
 
 
+/**
+ * Number of TPDOs compared in one pass by CO_TPDOisCOSbulk(). Must be even.
+ * Stack usage of CO_TPDOisCOSbulk() is about 3 * CO_PDO_MAX_SIZE bytes per
+ * TPDO of the block.
+ */
+#ifndef CO_TPDO_COS_BULK
+#define CO_TPDO_COS_BULK    16U
+#endif
+
+
+/**
+ * Verify Change of State of multiple PDOs.
+ *
+ * Result is the same as from CO_TPDOisCOS() for each TPDO. Current data, sent
+ * data and COS mask of a block of #CO_TPDO_COS_BULK TPDOs are collected into
+ * contiguous arrays, which are then compared in one pass: with SSE2 or NEON
+ * 16 bytes at once, otherwise with native words (64 bit on 64-bit targets,
+ * 32 bit on microcontrollers). TPDOs without _sendIfCOSFlags_ are skipped.
+ *
+ * CO_process_TPDO() uses this function for event driven and synchronous
+ * acyclic TPDOs.
+ *
+ * @param TPDO Array of TPDO objects.
+ * @param count Number of TPDOs in array.
+ * @param cosList Output: positions in TPDO array of TPDOs with COS detected,
+ * in ascending order. Array must have count entries.
+ *
+ * @return Number of entries written to cosList.
+ */
+uint16_t CO_TPDOisCOSbulk(CO_TPDO_t *const TPDO[], uint16_t count, uint16_t cosList[]);
+
+
+#ifdef TPDO_COS_DIRTY_FLAGS
+/**
+ * Take over #CO_ODFL_TPDO_COS_DIRTY flag of all variables mapped to TPDO.
+ *
+ * Flag is atomically cleared and #CO_ODFL_TPDO_COS_LATCHED is set instead, so
+ * a write after this call sets the dirty flag again for the next cycle.
+ *
+ * @param TPDO TPDO object.
+ */
+void CO_TPDOlatchCOSdirty(CO_TPDO_t *TPDO);
+
+
+/**
+ * Verify, if any variable with change of state detection, mapped to TPDO, was
+ * written before last CO_TPDOlatchCOSdirty().
+ *
+ * If variable is mapped to multiple TPDOs, function must be called after
+ * CO_TPDOlatchCOSdirty() was called for all of them.
+ *
+ * @param TPDO TPDO object.
+ *
+ * @return True if CO_TPDOisCOS() needs to be called. Also true, if a mapped
+ * variable has no #CO_SDO_OD_flags_t configured.
+ */
+bool_t CO_TPDOisCOSdirty(CO_TPDO_t *TPDO);
+
+
+/**
+ * Clear #CO_ODFL_TPDO_COS_LATCHED flag of all variables mapped to TPDO.
+ *
+ * If variable is mapped to multiple TPDOs, function must be called after
+ * CO_TPDOisCOSdirty() was called for all of them.
+ *
+ * @param TPDO TPDO object.
+ */
+void CO_TPDOclearCOSdirty(CO_TPDO_t *TPDO);
+#endif
+
+
 /**
  * Send TPDO message.
  *
@@ -472,6 +1262,61 @@ uint8_t CO_TPDOisCOS(CO_TPDO_t *TPDO);
 CO_ReturnError_t CO_TPDOsend(CO_TPDO_t *TPDO);
 
 
+/**
+ * Send synchronous TPDO message.
+ *
+ * Same as CO_TPDOsend(), additionally updates statistics. Latency is measured
+ * from the reception (or transmission) of the SYNC message, TPDO which could
+ * not be sent in its SYNC cycle is counted as missed. It is called from
+ * CO_TPDO_process() and from the scheduler, see #CO_TPDO_SYNC_BUCKETS.
+ *
+ * @param TPDO TPDO object.
+ * @param SYNC SYNC object.
+ *
+ * @return Same as CO_CANsend().
+ */
+CO_ReturnError_t CO_TPDOsendSync(CO_TPDO_t *TPDO, CO_SYNC_t *SYNC);
+
+
+#ifdef CO_TPDO_PRESTAGE
+/** TPDO is not staged, see CO_TPDO_t::staged */
+#define CO_TPDO_STAGED_NONE     0U
+/** TPDO data is prepared for the next SYNC */
+#define CO_TPDO_STAGED_READY    1U
+/** TPDO was sent by CO_TPDO_release(), not yet processed after the SYNC */
+#define CO_TPDO_STAGED_SENT     2U
+
+
+/**
+ * Stage or unstage synchronous TPDO for the next SYNC.
+ *
+ * If TPDO is due, its data is copied from the Object dictionary into the CAN
+ * transmit buffer and TPDO is marked ready for CO_TPDO_release(). Otherwise
+ * TPDO, which is ready, is unstaged. It is called from CO_process_TPDO() in
+ * each cycle, see #CO_TPDO_PRESTAGE.
+ *
+ * @param TPDO TPDO object.
+ * @param due True, if TPDO will be sent with the next SYNC.
+ *
+ * @return True, if TPDO is ready.
+ */
+bool_t CO_TPDO_stage(CO_TPDO_t *TPDO, bool_t due);
+
+
+/**
+ * Send staged TPDO.
+ *
+ * Called after SYNC reception or transmission, see CO_SYNC_initCallbackSync().
+ * TPDO which is ready is sent, CO_TPDOsendSync() after the SYNC then only
+ * updates its state. Function must be called inside CO_LOCK_OD().
+ *
+ * @param TPDO TPDO object.
+ * @param SYNC SYNC object, for latency statistics.
+ */
+void CO_TPDO_release(CO_TPDO_t *TPDO, CO_SYNC_t *SYNC);
+#endif
+
+
 /**
  * Process received PDO messages.
  *
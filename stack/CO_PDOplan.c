@@ -0,0 +1,389 @@
+/*
+ * CANopen Process Data Object - network PDO packing planner.
+ *
+ * @file        CO_PDOplan.c
+ * @ingroup     CO_PDOplan
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_SDOmaster.h"
+#include "CO_SDOqueue.h"
+#include "CO_PDOplan.h"
+
+
+/* Signal, which is not yet processed by CO_PDOplan_compute() */
+#define CO_PDOPLAN_PENDING      0xFEU
+
+/* Bits of a data frame with len data bytes, see CO_STAT_BUS_FRAME_BITS() */
+#ifdef CO_STAT_BUS_FRAME_BITS
+#define CO_PDOPLAN_FRAME_BITS(len)  CO_STAT_BUS_FRAME_BITS(len)
+#else
+#define CO_PDOPLAN_FRAME_BITS(len)  (47U + 8U * (len) + (33U + 8U * (len)) / 4U)
+#endif
+
+
+/*
+ * Find next pending signal of the node and direction: shortest period first,
+ * then longest signal.
+ *
+ * @return Index of the signal or signalCount, if there is none.
+ */
+static uint16_t CO_PDOplan_next(CO_PDOplan_t *plan, uint8_t nodeId, bool_t toNode){
+    uint16_t best = plan->signalCount;
+    uint16_t i;
+
+    for(i=0; i<plan->signalCount; i++){
+        const CO_PDOplanSignal_t *sig = &plan->signals[i];
+
+        if(sig->pdo != CO_PDOPLAN_PENDING || sig->nodeId != nodeId || sig->toNode != toNode){
+            continue;
+        }
+        if(best == plan->signalCount ||
+           sig->period < plan->signals[best].period ||
+           (sig->period == plan->signals[best].period && sig->bitLength > plan->signals[best].bitLength))
+        {
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+
+/*
+ * Pack all signals of one node and direction.
+ *
+ * @return CO_ERROR_NO or CO_ERROR_OUT_OF_MEMORY, if a signal was not placed.
+ */
+static CO_ReturnError_t CO_PDOplan_packGroup(CO_PDOplan_t *plan, uint8_t nodeId, bool_t toNode){
+    CO_ReturnError_t ret = CO_ERROR_NO;
+    uint16_t first = plan->pdoCount;
+    uint16_t s;
+
+    while((s = CO_PDOplan_next(plan, nodeId, toNode)) < plan->signalCount){
+        CO_PDOplanSignal_t *sig = &plan->signals[s];
+        CO_PDOplanPdo_t *pdo = NULL;
+        uint16_t i;
+
+        /* best fit into existing PDO, all of them are at least as fast */
+        for(i=first; i<plan->pdoCount; i++){
+            CO_PDOplanPdo_t *p = &plan->pdos[i];
+
+            if(p->mapCount < 8U && (p->bitLength + sig->bitLength) <= 64U &&
+               (pdo == NULL || p->bitLength > pdo->bitLength))
+            {
+                pdo = p;
+            }
+        }
+
+        /* otherwise new PDO with the period of the signal */
+        if(pdo == NULL){
+            uint8_t number = (uint8_t)(plan->pdoCount - first);
+
+            if(number >= plan->maxPdo || plan->pdoCount >= plan->pdosSize){
+                sig->pdo = CO_PDOPLAN_NOT_PLACED;
+                ret = CO_ERROR_OUT_OF_MEMORY;
+                continue;
+            }
+            pdo = &plan->pdos[plan->pdoCount++];
+            pdo->nodeId = nodeId;
+            pdo->toNode = toNode;
+            pdo->pdo = number;
+            pdo->period = sig->period;
+            pdo->COB_ID = (uint16_t)((toNode ? 0x200U : 0x180U) + 0x100U * number + nodeId);
+            pdo->bitLength = 0;
+            pdo->mapCount = 0;
+        }
+
+        sig->pdo = pdo->pdo;
+        sig->bitOffset = pdo->bitLength;
+        pdo->map[pdo->mapCount++] = ((uint32_t)sig->index << 16) | ((uint32_t)sig->subIndex << 8) | sig->bitLength;
+        pdo->bitLength += sig->bitLength;
+    }
+
+    return ret;
+}
+
+
+/*
+ * Add SDO download job.
+ */
+static void CO_PDOplan_addJob(
+        CO_PDOplan_t           *plan,
+        uint8_t                 nodeId,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint32_t                value,
+        uint8_t                 size)
+{
+    if(plan->jobs != NULL){
+        CO_PDOplanJob_t *pj = &plan->jobs[plan->jobCount];
+
+        pj->data[0] = (uint8_t)value;
+        pj->data[1] = (uint8_t)(value >> 8);
+        pj->data[2] = (uint8_t)(value >> 16);
+        pj->data[3] = (uint8_t)(value >> 24);
+        pj->job.nodeId = nodeId;
+        pj->job.index = index;
+        pj->job.subIndex = subIndex;
+        pj->job.download = true;
+        pj->job.buffer = pj->data;
+        pj->job.bufferSize = size;
+        pj->job.object = plan;
+    }
+    plan->jobCount++;
+}
+
+
+/*
+ * Add jobs for all PDOs of the plan. If plan->jobs is NULL, jobs are only
+ * counted.
+ */
+static void CO_PDOplan_addJobs(CO_PDOplan_t *plan){
+    uint16_t i;
+
+    plan->jobCount = 0;
+    for(i=0; i<plan->pdoCount; i++){
+        const CO_PDOplanPdo_t *pdo = &plan->pdos[i];
+        uint16_t comm = (uint16_t)((pdo->toNode ? 0x1400U : 0x1800U) + pdo->pdo);
+        uint16_t map = (uint16_t)(comm + 0x200U);
+        uint8_t j;
+
+        CO_PDOplan_addJob(plan, pdo->nodeId, comm, 1, 0x80000000UL | pdo->COB_ID, 4);
+        CO_PDOplan_addJob(plan, pdo->nodeId, comm, 2, pdo->period, 1);
+        CO_PDOplan_addJob(plan, pdo->nodeId, map, 0, 0, 1);
+        for(j=0; j<pdo->mapCount; j++){
+            CO_PDOplan_addJob(plan, pdo->nodeId, map, j + 1U, pdo->map[j], 4);
+        }
+        CO_PDOplan_addJob(plan, pdo->nodeId, map, 0, pdo->mapCount, 1);
+        CO_PDOplan_addJob(plan, pdo->nodeId, comm, 1, pdo->COB_ID, 4);
+
+        /* disable unused PDOs after the last PDO of the node and direction */
+        if((i + 1U) == plan->pdoCount || plan->pdos[i + 1U].nodeId != pdo->nodeId ||
+           plan->pdos[i + 1U].toNode != pdo->toNode)
+        {
+            uint8_t k;
+
+            for(k=pdo->pdo + 1U; k<plan->maxPdo; k++){
+                uint16_t COB_ID = (uint16_t)((pdo->toNode ? 0x200U : 0x180U) + 0x100U * k + pdo->nodeId);
+
+                CO_PDOplan_addJob(plan, pdo->nodeId, (uint16_t)(comm - pdo->pdo + k), 1, 0x80000000UL | COB_ID, 4);
+            }
+        }
+    }
+}
+
+
+/*
+ * Callback of finished SDO job.
+ */
+static void CO_PDOplan_jobDone(
+        CO_SDOqueueJob_t       *job,
+        CO_SDOclient_return_t   ret,
+        uint32_t                abortCode,
+        uint32_t                dataSize)
+{
+    CO_PDOplan_t *plan = (CO_PDOplan_t*)job->object;
+
+    (void)dataSize;
+    if(ret != CO_SDOcli_ok_communicationEnd && plan->failedNodeId == 0){
+        plan->failedNodeId = job->nodeId;
+        plan->failedRet = ret;
+        plan->failedAbortCode = abortCode;
+    }
+    plan->jobsDone++;
+    if(plan->jobsDone == plan->jobCount && plan->pFunctSignal != NULL){
+        plan->pFunctSignal(plan->object, plan);
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_PDOplan_init(
+        CO_PDOplan_t           *plan,
+        CO_PDOplanSignal_t      signals[],
+        uint16_t                signalCount,
+        CO_PDOplanPdo_t         pdos[],
+        uint16_t                pdosSize)
+{
+    /* verify arguments */
+    if(plan==NULL || (signals==NULL && signalCount!=0) || pdos==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    plan->signals = signals;
+    plan->signalCount = signalCount;
+    plan->pdos = pdos;
+    plan->pdosSize = pdosSize;
+    plan->pdoCount = 0;
+    plan->maxPdo = CO_PDOPLAN_MAX_PDO;
+    plan->framesPer1000Sync = 0;
+    plan->bitsPer1000Sync = 0;
+    plan->jobs = NULL;
+    plan->jobCount = 0;
+    plan->jobsDone = 0;
+    plan->failedNodeId = 0;
+    plan->failedRet = CO_SDOcli_ok_communicationEnd;
+    plan->failedAbortCode = 0;
+    plan->pFunctSignal = NULL;
+    plan->object = NULL;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_PDOplan_compute(CO_PDOplan_t *plan){
+    CO_ReturnError_t ret = CO_ERROR_NO;
+    uint16_t i;
+
+    if(plan == NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* verify signals */
+    for(i=0; i<plan->signalCount; i++){
+        CO_PDOplanSignal_t *sig = &plan->signals[i];
+
+        if(sig->nodeId < 1U || sig->nodeId > 127U || sig->bitLength < 1U ||
+           sig->bitLength > 64U || sig->period < 1U || sig->period > 240U)
+        {
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+        sig->pdo = CO_PDOPLAN_PENDING;
+        sig->bitOffset = 0;
+    }
+
+    /* pack each node and direction, in order of first appearance */
+    plan->pdoCount = 0;
+    for(i=0; i<plan->signalCount; i++){
+        const CO_PDOplanSignal_t *sig = &plan->signals[i];
+
+        if(sig->pdo == CO_PDOPLAN_PENDING){
+            if(CO_PDOplan_packGroup(plan, sig->nodeId, sig->toNode) != CO_ERROR_NO){
+                ret = CO_ERROR_OUT_OF_MEMORY;
+            }
+        }
+    }
+
+    /* bus load */
+    plan->framesPer1000Sync = 0;
+    plan->bitsPer1000Sync = 0;
+    for(i=0; i<plan->pdoCount; i++){
+        const CO_PDOplanPdo_t *pdo = &plan->pdos[i];
+        uint32_t frames = 1000U / pdo->period;
+
+        plan->framesPer1000Sync += frames;
+        plan->bitsPer1000Sync += frames * CO_PDOPLAN_FRAME_BITS((pdo->bitLength + 7U) / 8U);
+    }
+
+    return ret;
+}
+
+
+/******************************************************************************/
+uint32_t CO_PDOplan_busLoad(
+        const CO_PDOplan_t     *plan,
+        uint32_t                syncPeriod_us,
+        uint16_t                bitRate)
+{
+    uint64_t capacity;
+
+    if(plan == NULL || syncPeriod_us == 0 || bitRate == 0){
+        return 0;
+    }
+
+    /* bits per 1000 SYNC cycles against bits available in 1000 SYNC cycles,
+     * in per mille */
+    capacity = (uint64_t)syncPeriod_us * bitRate;
+
+    return (uint32_t)(((uint64_t)plan->bitsPer1000Sync * 1000U) / capacity);
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_PDOplan_apply(
+        CO_PDOplan_t           *plan,
+        CO_SDOqueue_t          *SDOqueue,
+        CO_PDOplanJob_t         jobs[],
+        uint16_t                jobsSize,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, CO_PDOplan_t *plan))
+{
+    uint16_t i;
+
+    /* verify arguments */
+    if(plan==NULL || SDOqueue==NULL || jobs==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* count jobs first */
+    plan->jobs = NULL;
+    CO_PDOplan_addJobs(plan);
+    if(plan->jobCount > jobsSize){
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+
+    plan->jobs = jobs;
+    plan->jobsDone = 0;
+    plan->failedNodeId = 0;
+    plan->failedRet = CO_SDOcli_ok_communicationEnd;
+    plan->failedAbortCode = 0;
+    plan->pFunctSignal = pFunctSignal;
+    plan->object = object;
+    CO_PDOplan_addJobs(plan);
+
+    if(plan->jobCount == 0){
+        if(pFunctSignal != NULL){
+            pFunctSignal(object, plan);
+        }
+        return CO_ERROR_NO;
+    }
+
+    /* jobs are not contiguous CO_SDOqueueJob_t, submit one by one */
+    for(i=0; i<plan->jobCount; i++){
+        jobs[i].job.pFunctSignal = CO_PDOplan_jobDone;
+        (void)CO_SDOqueue_submit(SDOqueue, &jobs[i].job, 1);
+    }
+
+    return CO_ERROR_NO;
+}
@@ -0,0 +1,289 @@
+/**
+ * CANopen Process Data Object - network PDO packing planner.
+ *
+ * @file        CO_PDOplan.h
+ * @ingroup     CO_PDOplan
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_PDOplan_H
+#define CO_PDOplan_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_PDOplan Network PDO packing planner
+ * @ingroup CO_SDOmaster
+ * @{
+ *
+ * Packing of process data of remote nodes into synchronous PDOs.
+ *
+ * Application describes each signal with node, direction, object address,
+ * length in bits and desired update period in SYNC cycles, for example from
+ * the EDS files of the nodes. CO_PDOplan_compute() packs the signals of each
+ * node and direction into PDOs, so the number of frames per SYNC cycle is
+ * small:
+ *  - signals are placed in order of increasing period, longer signals first,
+ *  - a signal goes into the PDO with the least free space, where it fits.
+ *    All existing PDOs are at least as fast as the signal, so this adds no
+ *    frame,
+ *  - otherwise a new PDO with the period of the signal is opened, if the node
+ *    has one left.
+ *
+ * Each PDO is synchronous cyclic with its period as transmission type and
+ * uses the predefined COB-ID of the node. CO_PDOplan_busLoad() estimates the
+ * resulting bus load. CO_PDOplan_apply() writes communication and mapping
+ * parameters (index 0x1400+, 0x1600+, 0x1800+ and 0x1A00+) of the nodes
+ * through CO_SDOqueue. PDOs of this device, which produce or consume the
+ * planned PDOs, must be configured by the application from
+ * CO_PDOplan_t::pdos.
+ */
+
+
+/**
+ * Maximum number of PDOs per node and direction. Default is 4, the PDOs with
+ * predefined COB-ID.
+ */
+#ifndef CO_PDOPLAN_MAX_PDO
+#define CO_PDOPLAN_MAX_PDO      4U
+#endif
+
+/** CO_PDOplanSignal_t::pdo of a signal, which could not be placed */
+#define CO_PDOPLAN_NOT_PLACED   0xFFU
+
+
+/**
+ * Signal to be transferred by PDO.
+ *
+ * Array is defined by the application, see CO_PDOplan_init().
+ */
+typedef struct{
+    /** Node-ID of the remote node */
+    uint8_t             nodeId;
+    /** True, if signal is written to the node (RPDO of the node), false, if
+    signal is produced by the node (TPDO of the node) */
+    bool_t              toNode;
+    /** Index of object in object dictionary of the node */
+    uint16_t            index;
+    /** Subindex of object in object dictionary of the node */
+    uint8_t             subIndex;
+    /** Length of the object in bits, 1 to 64. Nodes with map granularity of
+    one byte, like CANopenNode, need multiples of 8 */
+    uint8_t             bitLength;
+    /** Desired update period in SYNC cycles, 1 to 240 */
+    uint8_t             period;
+    /** Result: number of the PDO of the node, 0 for first PDO, or
+    #CO_PDOPLAN_NOT_PLACED */
+    uint8_t             pdo;
+    /** Result: position of the signal in the PDO in bits */
+    uint8_t             bitOffset;
+}CO_PDOplanSignal_t;
+
+
+/**
+ * PDO calculated by CO_PDOplan_compute().
+ */
+typedef struct{
+    /** Node-ID of the remote node */
+    uint8_t             nodeId;
+    /** True for RPDO of the node, false for TPDO of the node */
+    bool_t              toNode;
+    /** Number of the PDO of the node, 0 for first PDO */
+    uint8_t             pdo;
+    /** Period in SYNC cycles, used as transmission type */
+    uint8_t             period;
+    /** COB-ID of the PDO */
+    uint16_t            COB_ID;
+    /** Length of mapped data in bits */
+    uint8_t             bitLength;
+    /** Number of entries in map */
+    uint8_t             mapCount;
+    /** Mapping parameter entries, `0xIIIISSLL` as in index 0x1600+ */
+    uint32_t            map[8];
+}CO_PDOplanPdo_t;
+
+
+/**
+ * SDO job of CO_PDOplan_apply().
+ *
+ * Array is defined by the application, see CO_PDOplan_apply().
+ */
+typedef struct{
+    /** SDO client job, must be first */
+    CO_SDOqueueJob_t    job;
+    /** Data of the job, little endian */
+    uint8_t             data[4];
+}CO_PDOplanJob_t;
+
+
+/**
+ * Network PDO packing planner object.
+ */
+typedef struct CO_PDOplan{
+    /** From CO_PDOplan_init() */
+    CO_PDOplanSignal_t *signals;
+    /** From CO_PDOplan_init() */
+    uint16_t            signalCount;
+    /** From CO_PDOplan_init() */
+    CO_PDOplanPdo_t    *pdos;
+    /** From CO_PDOplan_init() */
+    uint16_t            pdosSize;
+    /** Number of PDOs calculated by CO_PDOplan_compute() */
+    uint16_t            pdoCount;
+    /** PDOs available per node and direction, set to #CO_PDOPLAN_MAX_PDO in
+    CO_PDOplan_init(). Can be lowered by application. */
+    uint8_t             maxPdo;
+    /** Frames of the calculated PDOs in 1000 SYNC cycles */
+    uint32_t            framesPer1000Sync;
+    /** Bits on the bus of the calculated PDOs in 1000 SYNC cycles */
+    uint32_t            bitsPer1000Sync;
+    /** From CO_PDOplan_apply() */
+    CO_PDOplanJob_t    *jobs;
+    /** Number of jobs submitted by CO_PDOplan_apply(), or number of jobs
+    needed, if CO_PDOplan_apply() returned CO_ERROR_OUT_OF_MEMORY */
+    uint16_t            jobCount;
+    /** Number of finished jobs */
+    uint16_t            jobsDone;
+    /** Node-ID of the first failed job, 0 if all succeeded */
+    uint8_t             failedNodeId;
+    /** Result of the first failed job */
+    CO_SDOclient_return_t failedRet;
+    /** SDO abort code of the first failed job */
+    uint32_t            failedAbortCode;
+    /** From CO_PDOplan_apply() */
+    void              (*pFunctSignal)(void *object, struct CO_PDOplan *plan);
+    /** From CO_PDOplan_apply() */
+    void               *object;
+}CO_PDOplan_t;
+
+
+/**
+ * Initialize PDO packing planner.
+ *
+ * @param plan This object will be initialized.
+ * @param signals Array of signals with fields nodeId, toNode, index, subIndex,
+ * bitLength and period set. Results are written into it.
+ * @param signalCount Number of signals.
+ * @param pdos Externally defined array for the calculated PDOs.
+ * @param pdosSize Size of the pdos array.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_PDOplan_init(
+        CO_PDOplan_t           *plan,
+        CO_PDOplanSignal_t      signals[],
+        uint16_t                signalCount,
+        CO_PDOplanPdo_t         pdos[],
+        uint16_t                pdosSize);
+
+
+/**
+ * Calculate packing of signals into PDOs.
+ *
+ * Results are written into CO_PDOplanSignal_t::pdo and bitOffset and into
+ * CO_PDOplan_t::pdos.
+ *
+ * @param plan This object.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT for invalid
+ * signal or CO_ERROR_OUT_OF_MEMORY, if a signal could not be placed, because
+ * node has no PDO left or pdos array is full. Signals, which were placed, are
+ * valid also then.
+ */
+CO_ReturnError_t CO_PDOplan_compute(CO_PDOplan_t *plan);
+
+
+/**
+ * Estimate bus load of the calculated PDOs.
+ *
+ * Frame length is estimated with worst case bit stuffing, see
+ * CO_STAT_BUS_FRAME_BITS().
+ *
+ * @param plan This object.
+ * @param syncPeriod_us Period of the SYNC message in microseconds.
+ * @param bitRate CAN bit rate in kbit/s.
+ *
+ * @return Bus load in per mille, may be above 1000.
+ */
+uint32_t CO_PDOplan_busLoad(
+        const CO_PDOplan_t     *plan,
+        uint32_t                syncPeriod_us,
+        uint16_t                bitRate);
+
+
+/**
+ * Write calculated PDOs to the remote nodes.
+ *
+ * Jobs for each PDO disable it by COB-ID, write transmission type, clear the
+ * mapping, write mapped objects and number of mapped objects and enable the
+ * PDO. Remaining PDOs up to CO_PDOplan_t::maxPdo of each node and direction,
+ * which has signals, are disabled. Jobs of one node run in this order, see
+ * CO_SDOqueue. Nodes must be in NMT pre-operational state.
+ *
+ * @param plan This object.
+ * @param SDOqueue SDO client request queue.
+ * @param jobs Externally defined array for the jobs, must stay valid until
+ * callback.
+ * @param jobsSize Size of jobs array.
+ * @param object Pointer to object, which will be passed to pFunctSignal.
+ * @param pFunctSignal Callback after all jobs are finished, see
+ * CO_PDOplan_t::failedNodeId for the result. Not called if NULL.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_OUT_OF_MEMORY, if jobs array is too small, CO_PDOplan_t::jobCount
+ * is then the required size.
+ */
+CO_ReturnError_t CO_PDOplan_apply(
+        CO_PDOplan_t           *plan,
+        CO_SDOqueue_t          *SDOqueue,
+        CO_PDOplanJob_t         jobs[],
+        uint16_t                jobsSize,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, CO_PDOplan_t *plan));
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
@@ -48,6 +48,15 @@
 #include "CO_SDO.h"
 #include "crc16-ccitt.h"
 
+#include <stddef.h> /* for offsetof */
+
+#ifdef CO_OD_PROFILING
+  #ifndef CO_USE_STATISTICS
+    #error CO_OD_PROFILING requires CO_USE_STATISTICS.
+  #endif
+  #include "CO_statistics.h"
+#endif
+
 
 /* Client command specifier, see DS301 */
 #define CCS_DOWNLOAD_INITIATE          1U
@@ -79,104 +88,177 @@ void CO_memset(uint8_t dest[], uint8_t c, const uint16_t size){
     }
 }
 
-uint16_t CO_getUint16(const uint8_t data[]){
-    CO_bytes_t b;
-    b.u8[0] = data[0];
-    b.u8[1] = data[1];
-    return b.u16[0];
-}
+#ifdef CO_BIG_ENDIAN
+void CO_swapArray(uint8_t data[], uint16_t length, uint16_t elementSize){
+    uint16_t i;
 
-uint32_t CO_getUint32(const uint8_t data[]){
-    CO_bytes_t b;
-    b.u8[0] = data[0];
-    b.u8[1] = data[1];
-    b.u8[2] = data[2];
-    b.u8[3] = data[3];
-    return b.u32[0];
+    switch(elementSize){
+        case 1U:
+            break;
+        case 2U:
+            for(i = 0U; (i + 2U) <= length; i += 2U){
+                CO_memcpySwap2(&data[i], &data[i]);
+            }
+            break;
+        case 4U:
+            for(i = 0U; (i + 4U) <= length; i += 4U){
+                CO_memcpySwap4(&data[i], &data[i]);
+            }
+            break;
+        case 8U:
+            for(i = 0U; (i + 8U) <= length; i += 8U){
+                CO_memcpySwap8(&data[i], &data[i]);
+            }
+            break;
+        default:
+            for(i = 0U; (elementSize > 1U) && ((i + elementSize) <= length); i += elementSize){
+                uint8_t *buf1 = &data[i];
+                uint8_t *buf2 = &data[i + elementSize - 1U];
+
+                while(buf1 < buf2){
+                    uint8_t b = *buf1;
+                    *(buf1++) = *buf2;
+                    *(buf2--) = b;
+                }
+            }
+            break;
+    }
 }
+#endif
 
-void CO_setUint16(uint8_t data[], const uint16_t value){
-    CO_bytes_t b;
-    b.u16[0] = value;
-    data[0] = b.u8[0];
-    data[1] = b.u8[1];
-}
 
-void CO_setUint32(uint8_t data[], const uint32_t value){
-    CO_bytes_t b;
-    b.u32[0] = value;
-    data[0] = b.u8[0];
-    data[1] = b.u8[1];
-    data[2] = b.u8[2];
-    data[3] = b.u8[3];
+/*
+ * False for a domain variable, which accepts any sub-index. True for other
+ * variables, arrays and records.
+ */
+static bool_t CO_OD_hasData(CO_SDO_t *SDO, uint16_t entryNo){
+#ifdef CO_OD_COLUMNS
+    if(SDO->ODColumns != NULL){
+        return SDO->ODColumns->pData[entryNo] != NULL;
+    }
+#endif
+    return SDO->OD[entryNo].pData != NULL;
 }
 
-#ifdef CO_LITTLE_ENDIAN
-void CO_memcpySwap2(void* dest, const void* src){
-    char *cdest;
-    char *csrc;
-    cdest = (char *) dest;
-    csrc = (char *) src;
-    cdest[0] = csrc[0];
-    cdest[1] = csrc[1];
-}
-void CO_memcpySwap4(void* dest, const void* src){
-    char *cdest;
-    char *csrc;
-    cdest = (char *) dest;
-    csrc = (char *) src;
-    cdest[0] = csrc[0];
-    cdest[1] = csrc[1];
-    cdest[2] = csrc[2];
-    cdest[3] = csrc[3];
-}
-void CO_memcpySwap8(void* dest, const void* src){
-    char *cdest;
-    char *csrc;
-    cdest = (char *) dest;
-    csrc = (char *) src;
-    cdest[0] = csrc[0];
-    cdest[1] = csrc[1];
-    cdest[2] = csrc[2];
-    cdest[3] = csrc[3];
-    cdest[4] = csrc[4];
-    cdest[5] = csrc[5];
-    cdest[6] = csrc[6];
-    cdest[7] = csrc[7];
-}
+
+#ifdef CO_SDO_FAST_EXPEDITED
+#ifndef CO_LOCK_OD_RX
+#error CO_SDO_FAST_EXPEDITED requires CO_LOCK_OD_RX() from CO_driver.h, see drvTemplate
 #endif
-#ifdef CO_BIG_ENDIAN
-void CO_memcpySwap2(void* dest, const void* src){
-    char *cdest;
-    char *csrc;
-    cdest = (char *) dest;
-    csrc = (char *) src;
-    cdest[0] = csrc[1];
-    cdest[1] = csrc[0];
-}
-void CO_memcpySwap4(void* dest, const void* src){
-    char *cdest;
-    char *csrc;
-    cdest = (char *) dest;
-    csrc = (char *) src;
-    cdest[0] = csrc[3];
-    cdest[1] = csrc[2];
-    cdest[2] = csrc[1];
-    cdest[3] = csrc[0];
-}
-void CO_memcpySwap8(void* dest, const void* src){
-    char *cdest;
-    char *csrc;
-    cdest = (char *) dest;
-    csrc = (char *) src;
-    cdest[0] = csrc[7];
-    cdest[1] = csrc[6];
-    cdest[2] = csrc[5];
-    cdest[3] = csrc[4];
-    cdest[4] = csrc[3];
-    cdest[5] = csrc[2];
-    cdest[6] = csrc[1];
-    cdest[7] = csrc[0];
+
+/*
+ * Answer expedited upload or download of a plain OD variable directly.
+ *
+ * Called from CO_SDO_receive() if SDO server is idle. Returns true, if the
+ * response was sent. Otherwise request must be processed by CO_SDO_process(),
+ * which also sends the abort message, if request is invalid.
+ */
+static bool_t CO_SDO_fastExpedited(CO_SDO_t *SDO, const uint8_t data[]){
+    CO_OD_extension_t *ext;
+    CO_CANtx_t *txBuff = SDO->CANtxBuffFast;
+    uint16_t index, entryNo, attribute, length, i;
+    uint8_t subIndex;
+    uint8_t *ODdata;
+    uint8_t *pFlags;
+    bool_t upload;
+
+    if((txBuff == NULL) || (!SDO->fastPathEnabled) || (txBuff->bufferFull)){
+        return false;
+    }
+
+    /* expedited download or upload initiate */
+    if((data[0] & 0xE2U) == 0x22U){
+        upload = false;
+    }
+    else if((data[0] & 0xE0U) == 0x40U){
+        upload = true;
+    }
+    else{
+        return false;
+    }
+
+    index = data[2];
+    index = index << 8 | data[1];
+    subIndex = data[3];
+
+    entryNo = CO_OD_find(SDO, index);
+    if((entryNo == 0xFFFFU) || (index == 0x1003U)){
+        return false;
+    }
+    if(!CO_OD_hasData(SDO, entryNo) || (subIndex > CO_OD_getMaxSubIndex(SDO, entryNo))){
+        return false;
+    }
+
+    /* entries with Object dictionary function are processed by mainline */
+    ext = CO_OD_getExtension(SDO, entryNo);
+    if((ext != NULL) && (ext->pODFunc != NULL)){
+        return false;
+    }
+
+    ODdata = (uint8_t*)CO_OD_getDataPointer(SDO, entryNo, subIndex);
+    length = CO_OD_getLength(SDO, entryNo, subIndex);
+    attribute = CO_OD_getAttribute(SDO, entryNo, subIndex);
+    if((ODdata == NULL) || (length == 0U) || (length > 4U)){
+        return false;
+    }
+
+    txBuff->data[1] = data[1];
+    txBuff->data[2] = data[2];
+    txBuff->data[3] = data[3];
+    txBuff->data[4] = txBuff->data[5] = txBuff->data[6] = txBuff->data[7] = 0U;
+
+    if(upload){
+        if((attribute & CO_ODA_READABLE) == 0U){
+            return false;
+        }
+
+        CO_LOCK_OD_RX();
+        for(i=0U; i<length; i++){
+            txBuff->data[4U+i] = ODdata[i];
+        }
+        CO_UNLOCK_OD_RX();
+
+        if((attribute & CO_ODA_MB_VALUE) != 0U){
+            CO_swapArray(&txBuff->data[4], length, length);
+        }
+        txBuff->data[0] = 0x43U | ((4U-length) << 2U);
+    }
+    else{
+        uint8_t buf[4];
+
+        if((attribute & CO_ODA_WRITEABLE) == 0U){
+            return false;
+        }
+        /* verify length, if size is indicated */
+        if(((data[0] & 0x01U) != 0U) && ((4U - ((data[0] >> 2U) & 0x03U)) != length)){
+            return false;
+        }
+
+        for(i=0U; i<length; i++){
+            buf[i] = data[4U+i];
+        }
+        if((attribute & CO_ODA_MB_VALUE) != 0U){
+            CO_swapArray(buf, length, length);
+        }
+
+        pFlags = CO_OD_getFlagsPointer(SDO, entryNo, subIndex);
+
+        CO_LOCK_OD_RX();
+        for(i=0U; i<length; i++){
+            ODdata[i] = buf[i];
+        }
+        if(pFlags != NULL){
+            *pFlags |= CO_ODFL_SDO_DOWNLOADED | CO_ODFL_TPDO_COS_DIRTY;
+        }
+        CO_UNLOCK_OD_RX();
+
+        txBuff->data[0] = 0x60U;
+    }
+
+    CO_CANsend(SDO->CANdevTx, txBuff);
+    CO_OD_PROFILE_COUNT(SDO, entryNo, upload ? CO_OD_PROF_SDO_READ : CO_OD_PROF_SDO_WRITE);
+
+    return true;
 }
 #endif
 
@@ -199,6 +281,33 @@ static void CO_SDO_receive(void *object, const CO_CANrxMsg_t *msg){
      * processing function has slow response.
      * See: https://github.com/CANopenNode/CANopenNode/issues/39 */
 
+#ifdef CO_SDO_FAST_EXPEDITED
+    /* answer simple expedited requests immediately, if server is idle */
+    if((msg->DLC == 8U) && (SDO->state == CO_SDO_ST_IDLE) &&
+       ((SDO->rxRing == NULL) || CO_rxRing_isEmpty(SDO->rxRing)) && (!IS_CANrxNew(SDO->CANrxNew)) &&
+       CO_SDO_fastExpedited(SDO, msg->data))
+    {
+        return;
+    }
+#endif
+
+    /* queue message, if previous message was not processed yet. Ring is
+     * tested before the flag: mainline sets the flag before it pops the
+     * last message, so one of both is always seen. */
+    if((msg->DLC == 8U) && (SDO->rxRing != NULL) && (SDO->state != CO_SDO_ST_DOWNLOAD_BL_SUBBLOCK) &&
+       (!CO_rxRing_isEmpty(SDO->rxRing) || IS_CANrxNew(SDO->CANrxNew)))
+    {
+        if(CO_rxRing_put(SDO->rxRing, msg)){
+            if(SDO->CANrxActiveNew != NULL) {
+                SET_CANrxNew(*SDO->CANrxActiveNew);
+            }
+            if(SDO->pFunctSignal != NULL) {
+                SDO->pFunctSignal();
+            }
+        }
+        return;
+    }
+
     /* verify message length and message overflow (previous message was not processed yet) */
     if((msg->DLC == 8U) && (!IS_CANrxNew(SDO->CANrxNew))){
         if(SDO->state != CO_SDO_ST_DOWNLOAD_BL_SUBBLOCK) {
@@ -256,6 +365,11 @@ static void CO_SDO_receive(void *object, const CO_CANrxMsg_t *msg){
             }
         }
 
+        /* Optional common flag for all SDO servers, set after own flag. */
+        if(IS_CANrxNew(SDO->CANrxNew) && SDO->CANrxActiveNew != NULL) {
+            SET_CANrxNew(*SDO->CANrxActiveNew);
+        }
+
         /* Optional signal to RTOS, which can resume task, which handles SDO server. */
         if(IS_CANrxNew(SDO->CANrxNew) && SDO->pFunctSignal != NULL) {
             SDO->pFunctSignal();
@@ -288,6 +402,49 @@ static CO_SDO_abortCode_t CO_ODF_1200(CO_ODF_arg_t *ODF_arg){
 }
 
 
+#ifdef CO_OD_FIND_TABLE
+/*
+ * Build lookup table for CO_OD_find().
+ *
+ * For each high byte of the index store the first entry in OD, which has the
+ * same or higher index. Entries for high byte H are from table[H] to
+ * table[H+1]-1. Table is only used, if OD is sorted.
+ */
+void CO_SDO_initFindTable(CO_SDO_t *SDO, uint16_t ODFindTable[]){
+    uint16_t i;
+    uint16_t bucket = 0U;
+
+    if(SDO == NULL || !SDO->ownOD){
+        return;
+    }
+    SDO->ODFindTable = NULL;
+    if(ODFindTable == NULL){
+        return;
+    }
+
+    for(i=1U; i<SDO->ODSize; i++){
+        if(SDO->OD[i].index <= SDO->OD[i-1U].index){
+            /* OD not sorted */
+            return;
+        }
+    }
+
+    for(i=0U; i<SDO->ODSize; i++){
+        uint16_t highByte = SDO->OD[i].index >> 8;
+
+        while(bucket <= highByte){
+            ODFindTable[bucket++] = i;
+        }
+    }
+    while(bucket < CO_OD_FIND_TABLE_SIZE){
+        ODFindTable[bucket++] = SDO->ODSize;
+    }
+
+    SDO->ODFindTable = ODFindTable;
+}
+#endif
+
+
 /******************************************************************************/
 CO_ReturnError_t CO_SDO_init(
         CO_SDO_t               *SDO,
@@ -317,13 +474,31 @@ CO_ReturnError_t CO_SDO_init(
         SDO->OD = OD;
         SDO->ODSize = ODSize;
         SDO->ODExtensions = ODExtensions;
+#ifdef CO_OD_PROFILING
+        SDO->ODProfile = NULL;
+#endif
+#ifdef CO_OD_COLUMNS
+        SDO->ODColumns = NULL;
+#endif
+#ifdef CO_SDO_TRANSFER_LOG
+        SDO->transferLog = NULL;
+#endif
 
         /* clear pointers in ODExtensions */
+#ifdef CO_OD_EXTENSIONS_SPARSE
+        SDO->ODExtensionsUsed = 0U;
+        for(i=0U; i<CO_OD_EXTENSIONS_SIZE; i++){
+            SDO->ODExtensions[i].entryNo = 0xFFFFU;
+#else
         for(i=0U; i<ODSize; i++){
+#endif
             SDO->ODExtensions[i].pODFunc = NULL;
             SDO->ODExtensions[i].object = NULL;
             SDO->ODExtensions[i].flags = NULL;
         }
+#ifdef CO_OD_FIND_TABLE
+        SDO->ODFindTable = NULL;
+#endif
     }
     /* copy object dictionary from parent */
     else{
@@ -331,13 +506,41 @@ CO_ReturnError_t CO_SDO_init(
         SDO->OD = parentSDO->OD;
         SDO->ODSize = parentSDO->ODSize;
         SDO->ODExtensions = parentSDO->ODExtensions;
+#ifdef CO_OD_EXTENSIONS_SPARSE
+        SDO->ODExtensionsUsed = 0U;
+#endif
+#ifdef CO_OD_PROFILING
+        SDO->ODProfile = parentSDO->ODProfile;
+#endif
+#ifdef CO_OD_COLUMNS
+        SDO->ODColumns = parentSDO->ODColumns;
+#endif
+#ifdef CO_SDO_TRANSFER_LOG
+        SDO->transferLog = parentSDO->transferLog;
+#endif
+#ifdef CO_OD_FIND_TABLE
+        SDO->ODFindTable = parentSDO->ODFindTable;
+#endif
     }
 
     /* Configure object variables */
     SDO->nodeId = nodeId;
     SDO->state = CO_SDO_ST_IDLE;
     CLEAR_CANrxNew(SDO->CANrxNew);
+    SDO->CANrxActiveNew = NULL;
+    SDO->rxRing = NULL;
     SDO->pFunctSignal = NULL;
+#ifdef CO_SDO_FAST_EXPEDITED
+    SDO->CANtxBuffFast = NULL;
+    SDO->fastPathEnabled = false;
+#endif
+#ifdef CO_SDO_ODF_ASYNC
+    SDO->ODFpending = false;
+    SDO->ODFaborted = false;
+#endif
+#ifdef CO_SDO_TRANSFER_LOG
+    SDO->transferOpen = false;
+#endif
 
 
     /* Configure Object dictionary entry at index 0x1200 */
@@ -350,6 +553,12 @@ CO_ReturnError_t CO_SDO_init(
         COB_IDClientToServer = 0;
         COB_IDServerToClient = 0;
     }
+#ifdef CO_SDO_FAST_EXPEDITED
+    SDO->COB_IDServerToClient = COB_IDServerToClient;
+#endif
+#ifdef CO_SDO_TRANSFER_LOG
+    SDO->COB_IDClientToServer = COB_IDClientToServer;
+#endif
     /* configure SDO server CAN reception */
     CO_CANrxBufferInit(
             CANdevRx,               /* CAN device */
@@ -386,7 +595,53 @@ void CO_SDO_initCallback(
 
 
 /******************************************************************************/
-void CO_OD_configure(
+void CO_SDO_initActiveFlag(
+        CO_SDO_t               *SDO,
+        volatile void         **CANrxActiveNew)
+{
+    if(SDO != NULL){
+        SDO->CANrxActiveNew = CANrxActiveNew;
+    }
+}
+
+
+/******************************************************************************/
+void CO_SDO_initRxRing(
+        CO_SDO_t               *SDO,
+        CO_rxRing_t            *rxRing)
+{
+    if(SDO != NULL){
+        SDO->rxRing = rxRing;
+    }
+}
+
+
+#ifdef CO_SDO_FAST_EXPEDITED
+/******************************************************************************/
+CO_ReturnError_t CO_SDO_initFastPath(
+        CO_SDO_t               *SDO,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx)
+{
+    if(SDO==NULL || CANdevTx==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    SDO->CANtxBuffFast = CO_CANtxBufferInit(
+            CANdevTx,               /* CAN device */
+            CANdevTxIdx,            /* index of specific buffer inside CAN module */
+            SDO->COB_IDServerToClient, /* CAN identifier */
+            0,                      /* rtr */
+            8,                      /* number of data bytes */
+            0);                     /* synchronous message flag bit */
+
+    return (SDO->CANtxBuffFast != NULL) ? CO_ERROR_NO : CO_ERROR_ILLEGAL_ARGUMENT;
+}
+#endif
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_OD_configure(
         CO_SDO_t               *SDO,
         uint16_t                index,
         CO_SDO_abortCode_t    (*pODFunc)(CO_ODF_arg_t *ODF_arg),
@@ -398,12 +653,16 @@ void CO_OD_configure(
 
     entryNo = CO_OD_find(SDO, index);
     if(entryNo < 0xFFFFU){
-        CO_OD_extension_t *ext = &SDO->ODExtensions[entryNo];
-        uint8_t maxSubIndex = SDO->OD[entryNo].maxSubIndex;
+        CO_OD_extension_t *ext = CO_OD_addExtension(SDO, entryNo);
+        uint8_t maxSubIndex = CO_OD_getMaxSubIndex(SDO, entryNo);
+
+        if(ext == NULL){
+            return CO_ERROR_OUT_OF_MEMORY;
+        }
 
         ext->pODFunc = pODFunc;
         ext->object = object;
-        if((flags != NULL) && (flagsSize != 0U) && (flagsSize == maxSubIndex)){
+        if((flags != NULL) && (flagsSize != 0U) && (flagsSize > maxSubIndex)){
             uint16_t i;
             ext->flags = flags;
             for(i=0U; i<=maxSubIndex; i++){
@@ -413,7 +672,75 @@ void CO_OD_configure(
         else{
             ext->flags = NULL;
         }
+        return CO_ERROR_NO;
+    }
+
+    return CO_ERROR_ILLEGAL_ARGUMENT;
+}
+
+
+#ifdef CO_OD_COLUMNS
+/*
+ * CO_OD_find() with columns. Only the packed array of indexes is searched, so
+ * more of the search fits into one cache line.
+ */
+static uint16_t CO_OD_columnsFind(CO_SDO_t *SDO, uint16_t index){
+    const uint16_t *ODindex = SDO->ODColumns->index;
+    uint16_t min = 0U;
+    uint16_t max = SDO->ODSize;
+
+#ifdef CO_OD_FIND_TABLE
+    if(SDO->ODFindTable != NULL){
+        uint16_t highByte = index >> 8;
+
+        min = SDO->ODFindTable[highByte];
+        max = SDO->ODFindTable[highByte + 1U];
+    }
+#endif
+    /* search in entries from min to max - 1 */
+    while(min < max){
+        uint16_t cur = (min + max) / 2U;
+        uint16_t curIndex = ODindex[cur];
+
+        if(index == curIndex){
+            return cur;
+        }
+        if(index < curIndex){
+            max = cur;
+        }
+        else{
+            min = cur + 1U;
+        }
+    }
+
+    return 0xFFFFU;  /* object does not exist in OD */
+}
+
+
+/*
+ * Member of a record in columns.
+ */
+static const CO_OD_columnMember_t *CO_OD_columnsMember(const CO_OD_columns_t *columns, uint16_t entryNo, uint8_t subIndex){
+    return &columns->members[columns->length[entryNo] + subIndex];
+}
+#endif
+
+
+/*
+ * Attribute of a member of an array, sub-index 0 is read-only.
+ */
+static uint16_t CO_OD_arrayAttribute(uint16_t index, uint16_t attribute, uint8_t subIndex){
+    /* Special exception: Object 1003,00 should be writable */
+    if(index == 0x1003 && subIndex == 0) {
+        return attribute | CO_ODA_WRITEABLE;
+    }
+
+    if(subIndex == 0U){
+        /* First subIndex is readonly */
+        attribute &= ~(CO_ODA_WRITEABLE | CO_ODA_RPDO_MAPABLE);
+        attribute |= CO_ODA_READABLE;
     }
+    return attribute;
 }
 
 
@@ -424,8 +751,26 @@ uint16_t CO_OD_find(CO_SDO_t *SDO, uint16_t index){
     uint16_t cur, min, max;
     const CO_OD_entry_t* object;
 
+#ifdef CO_OD_COLUMNS
+    if(SDO->ODColumns != NULL){
+        return CO_OD_columnsFind(SDO, index);
+    }
+#endif
     min = 0U;
     max = SDO->ODSize - 1U;
+#ifdef CO_OD_FIND_TABLE
+    /* limit search to entries with the same high byte of the index */
+    if(SDO->ODFindTable != NULL){
+        uint16_t highByte = index >> 8;
+
+        min = SDO->ODFindTable[highByte];
+        max = SDO->ODFindTable[highByte + 1U];
+        if(min == max){
+            return 0xFFFFU;  /* no object in this index range */
+        }
+        max--;
+    }
+#endif
     while(min < max){
         cur = (min + max) / 2;
         object = &SDO->OD[cur];
@@ -461,6 +806,22 @@ uint16_t CO_OD_getLength(CO_SDO_t *SDO, uint16_t entryNo, uint8_t subIndex){
         return 0U;
     }
 
+#ifdef CO_OD_COLUMNS
+    if(SDO->ODColumns != NULL){
+        const CO_OD_columns_t *columns = SDO->ODColumns;
+
+        if(columns->maxSubIndex[entryNo] != 0U && columns->attribute[entryNo] == 0U){
+            /* Object type is Record */
+            const CO_OD_columnMember_t *member = CO_OD_columnsMember(columns, entryNo, subIndex);
+
+            return (member->offset == CO_OD_COLUMN_DOMAIN) ? CO_SDO_BUFFER_SIZE : member->length;
+        }
+        if(columns->maxSubIndex[entryNo] != 0U && subIndex == 0U){
+            return 1U;
+        }
+        return (columns->pData[entryNo] == NULL) ? CO_SDO_BUFFER_SIZE : columns->length[entryNo];
+    }
+#endif
     if(object->maxSubIndex == 0U){    /* Object type is Var */
         if(object->pData == 0){ /* data type is domain */
             return CO_SDO_BUFFER_SIZE;
@@ -501,25 +862,24 @@ uint16_t CO_OD_getAttribute(CO_SDO_t *SDO, uint16_t entryNo, uint8_t subIndex){
         return 0U;
     }
 
+#ifdef CO_OD_COLUMNS
+    if(SDO->ODColumns != NULL){
+        const CO_OD_columns_t *columns = SDO->ODColumns;
+
+        if(columns->maxSubIndex[entryNo] == 0U){
+            return columns->attribute[entryNo];
+        }
+        else if(columns->attribute[entryNo] != 0U){
+            return CO_OD_arrayAttribute(columns->index[entryNo], columns->attribute[entryNo], subIndex);
+        }
+        return CO_OD_columnsMember(columns, entryNo, subIndex)->attribute;
+    }
+#endif
     if(object->maxSubIndex == 0U){   /* Object type is Var */
         return object->attribute;
     }
     else if(object->attribute != 0U){/* Object type is Array */
-        bool_t exception_1003 = false;
-        uint16_t attr = object->attribute;
-
-        /* Special exception: Object 1003,00 should be writable */
-        if(object->index == 0x1003 && subIndex == 0) {
-            exception_1003 = true;
-            attr |= CO_ODA_WRITEABLE;
-        }
-
-        if(subIndex == 0U  && exception_1003 == false){
-            /* First subIndex is readonly */
-            attr &= ~(CO_ODA_WRITEABLE | CO_ODA_RPDO_MAPABLE);
-            attr |= CO_ODA_READABLE;
-        }
-        return attr;
+        return CO_OD_arrayAttribute(object->index, object->attribute, subIndex);
     }
     else{                            /* Object type is Record */
         return ((const CO_OD_entryRecord_t*)(object->pData))[subIndex].attribute;
@@ -535,6 +895,33 @@ void* CO_OD_getDataPointer(CO_SDO_t *SDO, uint16_t entryNo, uint8_t subIndex){
         return 0;
     }
 
+#ifdef CO_OD_COLUMNS
+    if(SDO->ODColumns != NULL){
+        const CO_OD_columns_t *columns = SDO->ODColumns;
+        uint8_t *pData = (uint8_t*)columns->pData[entryNo];
+
+        if(columns->maxSubIndex[entryNo] == 0U){
+            return pData;
+        }
+        else if(columns->maxSubIndex[entryNo] < subIndex){
+            return 0;
+        }
+        else if(columns->attribute[entryNo] != 0U){
+            if(subIndex == 0){
+                return (void*) &columns->maxSubIndex[entryNo];
+            }
+            else if(pData == 0){
+                return 0;
+            }
+            return (void*)(pData + ((subIndex-1) * columns->length[entryNo]));
+        }
+        else{
+            const CO_OD_columnMember_t *member = CO_OD_columnsMember(columns, entryNo, subIndex);
+
+            return (member->offset == CO_OD_COLUMN_DOMAIN) ? 0 : (void*)(pData + member->offset);
+        }
+    }
+#endif
     if(object->maxSubIndex == 0U){   /* Object type is Var */
         return object->pData;
     }
@@ -561,6 +948,28 @@ void* CO_OD_getDataPointer(CO_SDO_t *SDO, uint16_t entryNo, uint8_t subIndex){
 }
 
 
+/******************************************************************************/
+uint16_t CO_OD_getIndex(CO_SDO_t *SDO, uint16_t entryNo){
+#ifdef CO_OD_COLUMNS
+    if(SDO->ODColumns != NULL){
+        return SDO->ODColumns->index[entryNo];
+    }
+#endif
+    return SDO->OD[entryNo].index;
+}
+
+
+/******************************************************************************/
+uint8_t CO_OD_getMaxSubIndex(CO_SDO_t *SDO, uint16_t entryNo){
+#ifdef CO_OD_COLUMNS
+    if(SDO->ODColumns != NULL){
+        return SDO->ODColumns->maxSubIndex[entryNo];
+    }
+#endif
+    return SDO->OD[entryNo].maxSubIndex;
+}
+
+
 /******************************************************************************/
 uint8_t* CO_OD_getFlagsPointer(CO_SDO_t *SDO, uint16_t entryNo, uint8_t subIndex){
     CO_OD_extension_t* ext;
@@ -569,29 +978,489 @@ uint8_t* CO_OD_getFlagsPointer(CO_SDO_t *SDO, uint16_t entryNo, uint8_t subIndex
         return 0;
     }
 
-    ext = &SDO->ODExtensions[entryNo];
+    ext = CO_OD_getExtension(SDO, entryNo);
+    if(ext == NULL || ext->flags == NULL){
+        return 0;
+    }
 
     return &ext->flags[subIndex];
 }
 
 
-/******************************************************************************/
-uint32_t CO_SDO_initTransfer(CO_SDO_t *SDO, uint16_t index, uint8_t subIndex){
-
-    SDO->ODF_arg.index = index;
-    SDO->ODF_arg.subIndex = subIndex;
+#ifdef CO_OD_EXTENSIONS_SPARSE
+/*
+ * Find extension in hash table with linear probing, optionally add it into
+ * the first free element. Elements are never removed.
+ */
+static CO_OD_extension_t *CO_OD_findExtension(CO_SDO_t *SDO, uint16_t entryNo, bool_t add){
+    uint16_t slot = (uint16_t)(((uint32_t)entryNo * 40503U) >> 8) & (CO_OD_EXTENSIONS_SIZE - 1U);
+    uint16_t n;
 
-    /* find object in Object Dictionary */
-    SDO->entryNo = CO_OD_find(SDO, index);
-    if(SDO->entryNo == 0xFFFFU){
-        return CO_SDO_AB_NOT_EXIST ;     /* object does not exist in OD */
+    if(SDO->ODExtensions == NULL || entryNo == 0xFFFFU){
+        return NULL;
     }
 
-    /* verify existance of subIndex */
-    if(subIndex > SDO->OD[SDO->entryNo].maxSubIndex &&
-            SDO->OD[SDO->entryNo].pData != NULL)
-    {
-        return CO_SDO_AB_SUB_UNKNOWN;     /* Sub-index does not exist. */
+    for(n=0U; n<CO_OD_EXTENSIONS_SIZE; n++){
+        CO_OD_extension_t *ext = &SDO->ODExtensions[slot];
+
+        if(ext->entryNo == entryNo){
+            return ext;
+        }
+        if(ext->entryNo == 0xFFFFU){
+            if(add){
+                ext->entryNo = entryNo;
+                SDO->ODExtensionsUsed++;
+                return ext;
+            }
+            return NULL;
+        }
+        slot = (slot + 1U) & (CO_OD_EXTENSIONS_SIZE - 1U);
+    }
+
+    return NULL;
+}
+#endif
+
+
+/******************************************************************************/
+CO_OD_extension_t *CO_OD_getExtension(CO_SDO_t *SDO, uint16_t entryNo){
+#ifdef CO_OD_EXTENSIONS_SPARSE
+    return CO_OD_findExtension(SDO, entryNo, false);
+#else
+    if(SDO->ODExtensions == NULL || entryNo >= SDO->ODSize){
+        return NULL;
+    }
+    return &SDO->ODExtensions[entryNo];
+#endif
+}
+
+
+/******************************************************************************/
+CO_OD_extension_t *CO_OD_addExtension(CO_SDO_t *SDO, uint16_t entryNo){
+#ifdef CO_OD_EXTENSIONS_SPARSE
+    return CO_OD_findExtension(SDO, entryNo, true);
+#else
+    return CO_OD_getExtension(SDO, entryNo);
+#endif
+}
+
+
+#ifdef CO_OD_COLUMNS
+/******************************************************************************/
+CO_ReturnError_t CO_OD_columnsBuild(
+        CO_OD_columns_t        *columns,
+        const CO_OD_entry_t     OD[],
+        uint16_t                ODSize,
+        uint16_t                index[],
+        uint8_t                 maxSubIndex[],
+        uint16_t                attribute[],
+        uint16_t                length[],
+        void                   *pData[],
+        CO_OD_columnMember_t    members[],
+        uint16_t                membersSize)
+{
+    uint16_t membersUsed = 0U;
+    uint16_t i;
+
+    /* verify arguments */
+    if(columns==NULL || OD==NULL || index==NULL || maxSubIndex==NULL || attribute==NULL ||
+       length==NULL || pData==NULL || members==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    for(i=0U; i<ODSize; i++){
+        const CO_OD_entry_t *object = &OD[i];
+
+        if(i > 0U && object->index <= OD[i-1U].index){
+            return CO_ERROR_ILLEGAL_ARGUMENT;   /* OD not sorted */
+        }
+        index[i] = object->index;
+        maxSubIndex[i] = object->maxSubIndex;
+        attribute[i] = object->attribute;
+        length[i] = object->length;
+        pData[i] = object->pData;
+
+        if(object->maxSubIndex > 0U && object->attribute == 0U){
+            /* Object type is Record, data relative to lowest member address */
+            const CO_OD_entryRecord_t *record = (const CO_OD_entryRecord_t*)object->pData;
+            uint16_t noMembers = object->maxSubIndex + 1U;
+            uintptr_t base = 0U;
+            uint16_t j, k;
+
+            for(j=0U; j<noMembers; j++){
+                uintptr_t a = (uintptr_t)record[j].pData;
+
+                if(a != 0U && (base == 0U || a < base)){
+                    base = a;
+                }
+            }
+            if(membersUsed + noMembers > membersSize){
+                return CO_ERROR_OUT_OF_MEMORY;
+            }
+            for(j=0U; j<noMembers; j++){
+                CO_OD_columnMember_t *member = &members[membersUsed + j];
+                uintptr_t a = (uintptr_t)record[j].pData;
+
+                if(a == 0U){
+                    member->offset = CO_OD_COLUMN_DOMAIN;
+                }
+                else if(a - base >= CO_OD_COLUMN_DOMAIN){
+                    return CO_ERROR_ILLEGAL_ARGUMENT;
+                }
+                else{
+                    member->offset = (uint16_t)(a - base);
+                }
+                member->attribute = record[j].attribute;
+                member->length = record[j].length;
+            }
+            /* Records with the same layout share the members */
+            for(k=0U; k+noMembers<=membersUsed; k++){
+                for(j=0U; j<noMembers; j++){
+                    const CO_OD_columnMember_t *m1 = &members[k + j];
+                    const CO_OD_columnMember_t *m2 = &members[membersUsed + j];
+
+                    if(m1->offset != m2->offset || m1->attribute != m2->attribute ||
+                       m1->length != m2->length){
+                        break;
+                    }
+                }
+                if(j == noMembers){
+                    break;
+                }
+            }
+            if(k+noMembers > membersUsed){
+                k = membersUsed;
+                membersUsed += noMembers;
+            }
+            length[i] = k;
+            /* Record with domains only has no data, keep non NULL pointer */
+            pData[i] = (base != 0U) ? (void*)base : object->pData;
+        }
+    }
+
+    columns->ODSize = ODSize;
+    columns->index = index;
+    columns->maxSubIndex = maxSubIndex;
+    columns->attribute = attribute;
+    columns->length = length;
+    columns->pData = pData;
+    columns->members = members;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_SDO_initColumns(CO_SDO_t *SDO, const CO_OD_columns_t *columns){
+    if(SDO != NULL){
+        SDO->ODColumns = (columns != NULL && columns->ODSize == SDO->ODSize) ? columns : NULL;
+    }
+}
+#endif
+
+
+#ifdef CO_OD_PROFILING
+/******************************************************************************/
+void CO_SDO_initProfile(CO_SDO_t *SDO, CO_OD_profile_t ODProfile[]){
+    if(SDO != NULL){
+        SDO->ODProfile = ODProfile;
+    }
+}
+
+
+/******************************************************************************/
+void CO_OD_profileCount(CO_SDO_t *SDO, uint16_t entryNo, CO_OD_profilePath_t path){
+    if(SDO->ODProfile != NULL && entryNo < SDO->ODSize){
+        SDO->ODProfile[entryNo].count[path]++;
+    }
+}
+
+
+/******************************************************************************/
+void CO_OD_profileODF(CO_SDO_t *SDO, uint16_t entryNo, uint32_t duration_us){
+    if(SDO->ODProfile != NULL && entryNo < SDO->ODSize){
+        CO_OD_profile_t *prof = &SDO->ODProfile[entryNo];
+
+        prof->ODFcount++;
+        if(duration_us > prof->ODFmax_us){
+            prof->ODFmax_us = duration_us;
+        }
+    }
+}
+
+
+/******************************************************************************/
+void CO_OD_resetProfile(CO_SDO_t *SDO){
+    if(SDO->ODProfile != NULL){
+        memset(SDO->ODProfile, 0, SDO->ODSize * sizeof(CO_OD_profile_t));
+    }
+}
+
+
+/******************************************************************************/
+CO_SDO_abortCode_t CO_ODF_ODprofile(CO_ODF_arg_t *ODF_arg){
+    CO_SDO_t *SDO = (CO_SDO_t*) ODF_arg->object;
+    uint32_t entryNo;
+    uint8_t *data = ODF_arg->data;
+    uint16_t freeLen = ODF_arg->dataLength;
+
+    if(SDO->ODProfile == NULL){
+        return CO_SDO_AB_NO_DATA;
+    }
+
+    if(!ODF_arg->reading){
+        CO_OD_resetProfile(SDO);
+        return CO_SDO_AB_NONE;
+    }
+
+    /* records have fixed size, so offset gives the next entry */
+    if(freeLen < 32U){
+        return CO_SDO_AB_OUT_OF_MEM;
+    }
+    entryNo = ODF_arg->offset / 32U;
+    ODF_arg->lastSegment = false;
+    while(freeLen >= 32U){
+        const CO_OD_profile_t *prof;
+        uint8_t i;
+
+        if(entryNo >= SDO->ODSize){
+            ODF_arg->lastSegment = true;
+            break;
+        }
+        prof = &SDO->ODProfile[entryNo];
+        CO_setUint16(&data[0], CO_OD_getIndex(SDO, entryNo));
+        CO_setUint16(&data[2], 0U);
+        for(i=0U; i<CO_OD_PROF_NO_PATHS; i++){
+            CO_setUint32(&data[4U + 4U*i], prof->count[i]);
+        }
+        CO_setUint32(&data[24], prof->ODFcount);
+        CO_setUint32(&data[28], prof->ODFmax_us);
+        data += 32U;
+        freeLen -= 32U;
+        entryNo++;
+    }
+    if(entryNo >= SDO->ODSize){
+        ODF_arg->lastSegment = true;
+    }
+    ODF_arg->dataLength -= freeLen;
+
+    return CO_SDO_AB_NONE;
+}
+#endif
+
+
+#ifdef CO_SDO_TRANSFER_LOG
+/******************************************************************************/
+void CO_SDO_initTransferLog(CO_SDO_t *SDO, CO_SDO_transferLog_t *transferLog){
+    if(SDO != NULL){
+        SDO->transferLog = transferLog;
+    }
+}
+
+
+/******************************************************************************/
+void CO_SDO_resetTransferLog(CO_SDO_transferLog_t *transferLog){
+    if(transferLog != NULL){
+        transferLog->head = 0U;
+        transferLog->count = 0U;
+    }
+}
+
+
+/*
+ * Start record of a new transfer. Request is in CANrxData.
+ */
+static void CO_SDO_transferStart(CO_SDO_t *SDO, uint8_t CCS){
+    CO_SDO_transferRecord_t *rec = &SDO->transfer;
+
+    SDO->transferOpen = (SDO->transferLog != NULL) ? true : false;
+    rec->COB_IDClient = SDO->COB_IDClientToServer;
+    rec->index = ((uint16_t)SDO->CANrxData[2] << 8) | SDO->CANrxData[1];
+    rec->subIndex = SDO->CANrxData[3];
+    rec->protocol = ((CCS == CCS_DOWNLOAD_BLOCK) || (CCS == CCS_UPLOAD_BLOCK)) ?
+                    CO_SDO_PROT_BLOCK : CO_SDO_PROT_EXPEDITED;
+    rec->upload = ((CCS == CCS_UPLOAD_INITIATE) || (CCS == CCS_UPLOAD_BLOCK)) ? true : false;
+    rec->retransmissions = 0U;
+    rec->bytes = 0U;
+    rec->duration_ms = 0U;
+    rec->abortCode = CO_SDO_AB_NONE;
+
+    /* not yet set by CO_SDO_initTransfer(), if object does not exist */
+    SDO->ODF_arg.offset = 0U;
+}
+
+
+/*
+ * Update record after CO_SDO_process() and add it to the log, if transfer
+ * has finished.
+ */
+static void CO_SDO_transferUpdate(CO_SDO_t *SDO){
+    CO_SDO_transferRecord_t *rec = &SDO->transfer;
+    CO_SDO_transferLog_t *log = SDO->transferLog;
+
+    if((SDO->state == CO_SDO_ST_DOWNLOAD_SEGMENTED) || (SDO->state == CO_SDO_ST_UPLOAD_SEGMENTED)){
+        rec->protocol = CO_SDO_PROT_SEGMENTED;
+    }
+    if(SDO->state != CO_SDO_ST_IDLE){
+        return;
+    }
+
+    rec->bytes = SDO->ODF_arg.offset;
+    log->records[log->head] = *rec;
+    log->head = (log->head + 1U < log->size) ? (log->head + 1U) : 0U;
+    log->count++;
+    SDO->transferOpen = false;
+}
+
+
+/******************************************************************************/
+CO_SDO_abortCode_t CO_ODF_SDOtransferLog(CO_ODF_arg_t *ODF_arg){
+    CO_SDO_t *SDO = (CO_SDO_t*) ODF_arg->object;
+    const CO_SDO_transferLog_t *log = SDO->transferLog;
+    uint32_t recNo, noRecords;
+    uint8_t *data = ODF_arg->data;
+    uint16_t freeLen = ODF_arg->dataLength;
+
+    if(log == NULL){
+        return CO_SDO_AB_NO_DATA;
+    }
+
+    if(!ODF_arg->reading){
+        CO_SDO_resetTransferLog(SDO->transferLog);
+        return CO_SDO_AB_NONE;
+    }
+
+    /* records have fixed size, so offset gives the next record */
+    if(freeLen < 24U){
+        return CO_SDO_AB_OUT_OF_MEM;
+    }
+    noRecords = (log->count < log->size) ? log->count : log->size;
+    if(noRecords == 0U){
+        return CO_SDO_AB_NO_DATA;
+    }
+    recNo = ODF_arg->offset / 24U;
+    while((freeLen >= 24U) && (recNo < noRecords)){
+        const CO_SDO_transferRecord_t *rec;
+
+        /* oldest record first */
+        rec = &log->records[(log->head + log->size - noRecords + recNo) % log->size];
+        CO_setUint32(&data[0], rec->COB_IDClient);
+        CO_setUint16(&data[4], rec->index);
+        data[6] = rec->subIndex;
+        data[7] = rec->protocol;
+        data[8] = rec->upload ? 1U : 0U;
+        data[9] = 0U;
+        CO_setUint16(&data[10], rec->retransmissions);
+        CO_setUint32(&data[12], rec->bytes);
+        CO_setUint32(&data[16], rec->duration_ms);
+        CO_setUint32(&data[20], rec->abortCode);
+        data += 24U;
+        freeLen -= 24U;
+        recNo++;
+    }
+    ODF_arg->lastSegment = (recNo >= noRecords) ? true : false;
+    ODF_arg->dataLength -= freeLen;
+
+    return CO_SDO_AB_NONE;
+}
+#endif
+
+
+#ifdef CO_SDO_STREAM_UPLOAD
+/*
+ * Start streaming upload from scatter list, set by Object dictionary function.
+ *
+ * @param SDO This object.
+ *
+ * @return 0 on success, otherwise SDO abort code.
+ */
+static uint32_t CO_SDO_streamStart(CO_SDO_t *SDO){
+    uint32_t total = 0U;
+    uint8_t i;
+
+    /* only domain may be streamed */
+    if(SDO->ODF_arg.ODdataStorage != NULL){
+        return CO_SDO_AB_DEVICE_INCOMPAT;     /* general internal incompatibility in the device */
+    }
+
+    for(i=0U; i<SDO->ODF_arg.scatterCount; i++){
+        if((SDO->ODF_arg.scatter[i].data == NULL) && (SDO->ODF_arg.scatter[i].length != 0U)){
+            return CO_SDO_AB_DEVICE_INCOMPAT;     /* general internal incompatibility in the device */
+        }
+        total += SDO->ODF_arg.scatter[i].length;
+    }
+
+    SDO->streamIdx = 0U;
+    SDO->streamOffset = 0U;
+    SDO->streamRemaining = total;
+
+    SDO->ODF_arg.dataLengthTotal = total;
+    SDO->ODF_arg.offset = total;
+    SDO->ODF_arg.firstSegment = false;
+    SDO->ODF_arg.lastSegment = true;
+
+    return 0U;
+}
+
+
+/*
+ * Copy next bytes of streaming upload.
+ *
+ * @param SDO This object.
+ * @param dest Destination or NULL, if data are only skipped.
+ * @param count Maximum number of bytes to copy.
+ *
+ * @return Number of bytes copied, less than count at the end of data.
+ */
+static uint16_t CO_SDO_streamCopy(CO_SDO_t *SDO, uint8_t *dest, uint16_t count){
+    uint16_t copied = 0U;
+
+    if(count > SDO->streamRemaining){
+        count = (uint16_t)SDO->streamRemaining;
+    }
+
+    while(copied < count){
+        const CO_SDO_scatter_t *area = &SDO->ODF_arg.scatter[SDO->streamIdx];
+        uint32_t len = area->length - SDO->streamOffset;
+
+        if(len > (uint32_t)(count - copied)){
+            len = count - copied;
+        }
+        if(dest != NULL){
+            CO_memcpy(&dest[copied], &area->data[SDO->streamOffset], (uint16_t)len);
+        }
+        copied += (uint16_t)len;
+
+        SDO->streamOffset += len;
+        if(SDO->streamOffset >= area->length){
+            SDO->streamIdx++;
+            SDO->streamOffset = 0U;
+        }
+    }
+
+    SDO->streamRemaining -= copied;
+    return copied;
+}
+#endif
+
+
+/******************************************************************************/
+uint32_t CO_SDO_initTransfer(CO_SDO_t *SDO, uint16_t index, uint8_t subIndex){
+
+    SDO->ODF_arg.index = index;
+    SDO->ODF_arg.subIndex = subIndex;
+
+    /* find object in Object Dictionary */
+    SDO->entryNo = CO_OD_find(SDO, index);
+    if(SDO->entryNo == 0xFFFFU){
+        return CO_SDO_AB_NOT_EXIST ;     /* object does not exist in OD */
+    }
+
+    /* verify existance of subIndex */
+    if(subIndex > CO_OD_getMaxSubIndex(SDO, SDO->entryNo) &&
+            CO_OD_hasData(SDO, SDO->entryNo))
+    {
+        return CO_SDO_AB_SUB_UNKNOWN;     /* Sub-index does not exist. */
     }
 
     /* pointer to data in Object dictionary */
@@ -599,9 +1468,11 @@ uint32_t CO_SDO_initTransfer(CO_SDO_t *SDO, uint16_t index, uint8_t subIndex){
 
     /* fill ODF_arg */
     SDO->ODF_arg.object = NULL;
-    if(SDO->ODExtensions){
-        CO_OD_extension_t *ext = &SDO->ODExtensions[SDO->entryNo];
-        SDO->ODF_arg.object = ext->object;
+    {
+        CO_OD_extension_t *ext = CO_OD_getExtension(SDO, SDO->entryNo);
+        if(ext != NULL){
+            SDO->ODF_arg.object = ext->object;
+        }
     }
     SDO->ODF_arg.data = SDO->databuffer;
     SDO->ODF_arg.dataLength = CO_OD_getLength(SDO, SDO->entryNo, subIndex);
@@ -615,6 +1486,10 @@ uint32_t CO_SDO_initTransfer(CO_SDO_t *SDO, uint16_t index, uint8_t subIndex){
     SDO->ODF_arg.dataLengthTotal = (SDO->ODF_arg.ODdataStorage) ? SDO->ODF_arg.dataLength : 0U;
 
     SDO->ODF_arg.offset = 0U;
+#ifdef CO_SDO_STREAM_UPLOAD
+    SDO->ODF_arg.scatter = NULL;
+    SDO->ODF_arg.scatterCount = 0U;
+#endif
 
     /* verify length */
     if(SDO->ODF_arg.dataLength > CO_SDO_BUFFER_SIZE){
@@ -625,8 +1500,74 @@ uint32_t CO_SDO_initTransfer(CO_SDO_t *SDO, uint16_t index, uint8_t subIndex){
 }
 
 
-/******************************************************************************/
-uint32_t CO_SDO_readOD(CO_SDO_t *SDO, uint16_t SDOBufferSize){
+#ifdef CO_SDO_ODF_ASYNC
+/*
+ * Object dictionary function returned CO_SDO_AB_PENDING. If async is false,
+ * caller can't wait for CO_SDO_ODF_complete().
+ */
+static uint32_t CO_SDO_ODFwait(CO_SDO_t *SDO, bool_t async){
+    if(!async){
+        return CO_SDO_AB_DEVICE_INCOMPAT;     /* general internal incompatibility in the device */
+    }
+    SDO->ODFaborted = false;
+    SDO->ODFpending = true;
+    return CO_SDO_AB_PENDING;
+}
+#endif
+
+
+/*
+ * Part of CO_SDO_readOD() after Object dictionary function.
+ */
+static uint32_t CO_SDO_readODfinish(CO_SDO_t *SDO, uint16_t SDOBufferSize, bool_t ODFcalled){
+    if(ODFcalled){
+#ifdef CO_SDO_STREAM_UPLOAD
+        /* data will be transferred directly from memory areas in scatter list */
+        if(SDO->ODF_arg.scatter != NULL){
+            return CO_SDO_streamStart(SDO);
+        }
+#endif
+
+        /* dataLength (upadted by pODFunc) must be inside limits */
+        if((SDO->ODF_arg.dataLength == 0U) || (SDO->ODF_arg.dataLength > SDOBufferSize)){
+            return CO_SDO_AB_DEVICE_INCOMPAT;     /* general internal incompatibility in the device */
+        }
+    }
+
+    SDO->ODF_arg.offset += SDO->ODF_arg.dataLength;
+    SDO->ODF_arg.firstSegment = false;
+
+    /* swap data if processor is not little endian (CANopen is) */
+    if((SDO->ODF_arg.attribute & CO_ODA_MB_VALUE) != 0){
+        CO_swapArray(SDO->ODF_arg.data, SDO->ODF_arg.dataLength, SDO->ODF_arg.dataLength);
+    }
+
+    return 0U;
+}
+
+
+/*
+ * Call Object dictionary function of the current transfer, its duration is
+ * profiled with CO_OD_PROFILING.
+ */
+static uint32_t CO_SDO_callODF(CO_SDO_t *SDO, const CO_OD_extension_t *ext){
+#ifdef CO_OD_PROFILING
+    uint32_t start = CO_STAT_TIMESTAMP_US();
+    uint32_t abortCode = ext->pODFunc(&SDO->ODF_arg);
+
+    CO_OD_profileODF(SDO, SDO->entryNo, CO_STAT_TIMESTAMP_US() - start);
+    return abortCode;
+#else
+    return ext->pODFunc(&SDO->ODF_arg);
+#endif
+}
+
+
+/*
+ * CO_SDO_readOD(), Object dictionary function may complete later, if async
+ * is true.
+ */
+static uint32_t CO_SDO_readODasync(CO_SDO_t *SDO, uint16_t SDOBufferSize, bool_t async){
     uint8_t *SDObuffer = SDO->ODF_arg.data;
     uint8_t *ODdata = (uint8_t*)SDO->ODF_arg.ODdataStorage;
     uint16_t length = SDO->ODF_arg.dataLength;
@@ -637,8 +1578,10 @@ uint32_t CO_SDO_readOD(CO_SDO_t *SDO, uint16_t SDOBufferSize){
         return CO_SDO_AB_WRITEONLY;     /* attempt to read a write-only object */
 
     /* find extension */
-    if(SDO->ODExtensions != NULL){
-        ext = &SDO->ODExtensions[SDO->entryNo];
+    ext = CO_OD_getExtension(SDO, SDO->entryNo);
+
+    if(SDO->ODF_arg.firstSegment){
+        CO_OD_PROFILE_COUNT(SDO, SDO->entryNo, CO_OD_PROF_SDO_READ);
     }
 
     CO_LOCK_OD();
@@ -649,7 +1592,7 @@ uint32_t CO_SDO_readOD(CO_SDO_t *SDO, uint16_t SDOBufferSize){
     }
     /* if domain, Object dictionary function MUST exist */
     else{
-        if(ext->pODFunc == NULL){
+        if(ext == NULL || ext->pODFunc == NULL){
             CO_UNLOCK_OD();
             return CO_SDO_AB_DEVICE_INCOMPAT;     /* general internal incompatibility in the device */
         }
@@ -657,50 +1600,68 @@ uint32_t CO_SDO_readOD(CO_SDO_t *SDO, uint16_t SDOBufferSize){
 
     /* call Object dictionary function if registered */
     SDO->ODF_arg.reading = true;
-    if(ext->pODFunc != NULL){
-        uint32_t abortCode = ext->pODFunc(&SDO->ODF_arg);
+    if(ext != NULL && ext->pODFunc != NULL){
+        uint32_t abortCode = CO_SDO_callODF(SDO, ext);
+
+        CO_UNLOCK_OD();
+#ifdef CO_SDO_ODF_ASYNC
+        if(abortCode == CO_SDO_AB_PENDING){
+            return CO_SDO_ODFwait(SDO, async);
+        }
+#endif
         if(abortCode != 0U){
-            CO_UNLOCK_OD();
             return abortCode;
         }
-
-        /* dataLength (upadted by pODFunc) must be inside limits */
-        if((SDO->ODF_arg.dataLength == 0U) || (SDO->ODF_arg.dataLength > SDOBufferSize)){
-            CO_UNLOCK_OD();
-            return CO_SDO_AB_DEVICE_INCOMPAT;     /* general internal incompatibility in the device */
-        }
+        return CO_SDO_readODfinish(SDO, SDOBufferSize, true);
     }
 
     CO_UNLOCK_OD();
 
+    return CO_SDO_readODfinish(SDO, SDOBufferSize, false);
+}
+
+
+/******************************************************************************/
+uint32_t CO_SDO_readOD(CO_SDO_t *SDO, uint16_t SDOBufferSize){
+    return CO_SDO_readODasync(SDO, SDOBufferSize, false);
+}
+
+
+/*
+ * Part of CO_SDO_writeOD() after Object dictionary function, OD is locked.
+ */
+static void CO_SDO_writeODfinish(CO_SDO_t *SDO, uint16_t length){
+    uint8_t *SDObuffer = SDO->ODF_arg.data;
+    uint8_t *ODdata = (uint8_t*)SDO->ODF_arg.ODdataStorage;
+    bool_t exception_1003 = false;
+
     SDO->ODF_arg.offset += SDO->ODF_arg.dataLength;
     SDO->ODF_arg.firstSegment = false;
 
-    /* swap data if processor is not little endian (CANopen is) */
-#ifdef CO_BIG_ENDIAN
-    if((SDO->ODF_arg.attribute & CO_ODA_MB_VALUE) != 0){
-        uint16_t len = SDO->ODF_arg.dataLength;
-        uint8_t *buf1 = SDO->ODF_arg.data;
-        uint8_t *buf2 = buf1 + len - 1;
+    /* Special exception: 1003,00 is writable from network, but not in OD  */
+    if(SDO->ODF_arg.index == 0x1003 && SDO->ODF_arg.subIndex == 0) {
+        exception_1003 = true;
+    }
 
-        len /= 2;
-        while(len--){
-            uint8_t b = *buf1;
-            *(buf1++) = *buf2;
-            *(buf2--) = b;
+    /* copy data from SDO buffer to OD if not domain */
+    if(ODdata != NULL && exception_1003 == false){
+        while(length--){
+            *(ODdata++) = *(SDObuffer++);
         }
     }
-#endif
 
-    return 0U;
+    if(SDO->ODF_arg.pFlags != NULL){
+        *SDO->ODF_arg.pFlags |= CO_ODFL_SDO_DOWNLOADED | CO_ODFL_TPDO_COS_DIRTY;
+    }
 }
 
 
-/******************************************************************************/
-uint32_t CO_SDO_writeOD(CO_SDO_t *SDO, uint16_t length){
-    uint8_t *SDObuffer = SDO->ODF_arg.data;
+/*
+ * CO_SDO_writeOD(), Object dictionary function may complete later, if async
+ * is true.
+ */
+static uint32_t CO_SDO_writeODasync(CO_SDO_t *SDO, uint16_t length, bool_t async){
     uint8_t *ODdata = (uint8_t*)SDO->ODF_arg.ODdataStorage;
-    bool_t exception_1003 = false;
 
     /* is object writeable? */
     if((SDO->ODF_arg.attribute & CO_ODA_WRITEABLE) == 0){
@@ -718,50 +1679,37 @@ uint32_t CO_SDO_writeOD(CO_SDO_t *SDO, uint16_t length){
     }
 
     /* swap data if processor is not little endian (CANopen is) */
-#ifdef CO_BIG_ENDIAN
     if((SDO->ODF_arg.attribute & CO_ODA_MB_VALUE) != 0){
-        uint16_t len = SDO->ODF_arg.dataLength;
-        uint8_t *buf1 = SDO->ODF_arg.data;
-        uint8_t *buf2 = buf1 + len - 1;
+        CO_swapArray(SDO->ODF_arg.data, SDO->ODF_arg.dataLength, SDO->ODF_arg.dataLength);
+    }
 
-        len /= 2;
-        while(len--){
-            uint8_t b = *buf1;
-            *(buf1++) = *buf2;
-            *(buf2--) = b;
-        }
+    if(SDO->ODF_arg.firstSegment){
+        CO_OD_PROFILE_COUNT(SDO, SDO->entryNo, CO_OD_PROF_SDO_WRITE);
     }
-#endif
 
     CO_LOCK_OD();
 
     /* call Object dictionary function if registered */
     SDO->ODF_arg.reading = false;
-    if(SDO->ODExtensions != NULL){
-        CO_OD_extension_t *ext = &SDO->ODExtensions[SDO->entryNo];
+    {
+        CO_OD_extension_t *ext = CO_OD_getExtension(SDO, SDO->entryNo);
 
-        if(ext->pODFunc != NULL){
-            uint32_t abortCode = ext->pODFunc(&SDO->ODF_arg);
+        if(ext != NULL && ext->pODFunc != NULL){
+            uint32_t abortCode = CO_SDO_callODF(SDO, ext);
+#ifdef CO_SDO_ODF_ASYNC
+            if(abortCode == CO_SDO_AB_PENDING){
+                CO_UNLOCK_OD();
+                return CO_SDO_ODFwait(SDO, async);
+            }
+#endif
             if(abortCode != 0U){
                 CO_UNLOCK_OD();
                 return abortCode;
             }
         }
     }
-    SDO->ODF_arg.offset += SDO->ODF_arg.dataLength;
-    SDO->ODF_arg.firstSegment = false;
-
-    /* Special exception: 1003,00 is writable from network, but not in OD  */
-    if(SDO->ODF_arg.index == 0x1003 && SDO->ODF_arg.subIndex == 0) {
-        exception_1003 = true;
-    }
 
-    /* copy data from SDO buffer to OD if not domain */
-    if(ODdata != NULL && exception_1003 == false){
-        while(length--){
-            *(ODdata++) = *(SDObuffer++);
-        }
-    }
+    CO_SDO_writeODfinish(SDO, length);
 
     CO_UNLOCK_OD();
 
@@ -769,6 +1717,12 @@ uint32_t CO_SDO_writeOD(CO_SDO_t *SDO, uint16_t length){
 }
 
 
+/******************************************************************************/
+uint32_t CO_SDO_writeOD(CO_SDO_t *SDO, uint16_t length){
+    return CO_SDO_writeODasync(SDO, length, false);
+}
+
+
 /******************************************************************************/
 static void CO_SDO_abort(CO_SDO_t *SDO, uint32_t code){
     SDO->CANtxBuff->data[0] = 0x80;
@@ -779,11 +1733,222 @@ static void CO_SDO_abort(CO_SDO_t *SDO, uint32_t code){
     SDO->state = CO_SDO_ST_IDLE;
     CLEAR_CANrxNew(SDO->CANrxNew);
     CO_CANsend(SDO->CANdevTx, SDO->CANtxBuff);
+#ifdef CO_SDO_TRANSFER_LOG
+    SDO->transfer.abortCode = code;
+#endif
+}
+
+
+#ifdef CO_SDO_BLOCK_TUNING
+/*
+ * Calculate data rate of the finished block transfer.
+ *
+ * @param SDO This object.
+ */
+static void CO_SDO_transferRate(CO_SDO_t *SDO){
+    uint32_t time_ms = (SDO->transferTime_ms != 0U) ? SDO->transferTime_ms : 1U;
+
+    SDO->transferRate = (uint32_t)(((uint64_t)SDO->ODF_arg.offset * 1000U) / time_ms);
+}
+#endif
+
+
+/*
+ * Fill CAN transmit buffer with next segment of block upload.
+ *
+ * @param SDO This object.
+ */
+static void CO_SDO_prepareBlockSegment(CO_SDO_t *SDO){
+    uint16_t len, i;
+    bool_t lastSegment;
+
+#ifdef CO_SDO_STREAM_UPLOAD
+    /* fill data bytes directly from memory areas */
+    if(SDO->ODF_arg.scatter != NULL){
+        len = CO_SDO_streamCopy(SDO, &SDO->CANtxBuff->data[1], 7U);
+        lastSegment = (SDO->streamRemaining == 0U) ? true : false;
+    }
+    else{
+#endif
+    /* calculate length to be sent */
+    len = SDO->ODF_arg.dataLength - SDO->bufferOffset;
+    if(len > 7U){
+        len = 7U;
+    }
+
+    /* fill data bytes */
+    for(i=0U; i<len; i++){
+        SDO->CANtxBuff->data[i+1] = SDO->ODF_arg.data[SDO->bufferOffset++];
+    }
+    lastSegment = ((SDO->bufferOffset == SDO->ODF_arg.dataLength) && (SDO->ODF_arg.lastSegment)) ? true : false;
+#ifdef CO_SDO_STREAM_UPLOAD
+    }
+#endif
+    for(i=len; i<7U; i++){
+        SDO->CANtxBuff->data[i+1] = 0U;
+    }
+
+    /* first byte */
+    SDO->CANtxBuff->data[0] = ++SDO->sequence;
+
+    /* verify end of transfer */
+    if(lastSegment){
+        SDO->CANtxBuff->data[0] |= 0x80;
+        SDO->lastLen = (uint8_t)len;
+        SDO->blksize = SDO->sequence;
+        SDO->endOfTransfer = true;
+    }
+}
+
+
+/*
+ * Select normal or block upload after the first Object dictionary function
+ * call. Upload request is in CANrxData.
+ */
+static CO_SDO_state_t CO_SDO_uploadState(CO_SDO_t *SDO){
+    uint8_t CCS = SDO->CANrxData[0] >> 5;   /* Client command specifier */
+
+    /* if data size is large enough set state machine to block upload, otherwise set to normal transfer */
+#ifdef CO_SDO_STREAM_UPLOAD
+    if(SDO->ODF_arg.scatter != NULL){
+        if((CCS == CCS_UPLOAD_BLOCK) && (SDO->streamRemaining > SDO->CANrxData[5])){
+            return CO_SDO_ST_UPLOAD_BL_INITIATE;
+        }
+        return CO_SDO_ST_UPLOAD_INITIATE;
+    }
+#endif
+    if((CCS == CCS_UPLOAD_BLOCK) && (SDO->ODF_arg.dataLength > SDO->CANrxData[5])){
+        return CO_SDO_ST_UPLOAD_BL_INITIATE;
+    }
+    return CO_SDO_ST_UPLOAD_INITIATE;
+}
+
+
+#ifdef CO_SDO_ODF_ASYNC
+/*
+ * Process SDO server in CO_SDO_ST_ODF_PENDING state. Returns true, if
+ * CO_SDO_process() shall continue with the upload.
+ */
+static bool_t CO_SDO_ODFprocess(
+        CO_SDO_t               *SDO,
+        bool_t                  NMTisPreOrOperational,
+        uint16_t                timeDifference_ms,
+        uint16_t                SDOtimeoutTime,
+        int8_t                 *ret)
+{
+    bool_t pending;
+    uint32_t abortCode;
+
+    CO_LOCK_OD();
+    pending = SDO->ODFpending;
+    abortCode = SDO->ODFabortCode;
+    CO_UNLOCK_OD();
+
+    if(pending){
+        *ret = 1;
+        if(SDO->ODFaborted){
+            return false;
+        }
+
+        /* abort the transfer, but keep the buffer for the Object dictionary function */
+        if(SDO->timeoutTimer < SDOtimeoutTime){
+            SDO->timeoutTimer += timeDifference_ms;
+        }
+        if(!NMTisPreOrOperational){
+            SDO->ODFaborted = true;
+#ifdef CO_SDO_TRANSFER_LOG
+            SDO->transfer.abortCode = CO_SDO_AB_DATA_DEV_STATE;
+#endif
+        }
+        else if(SDO->timeoutTimer >= SDOtimeoutTime){
+            uint32_t code = CO_SDO_AB_TIMEOUT;
+
+            SDO->CANtxBuff->data[0] = 0x80;
+            SDO->CANtxBuff->data[1] = SDO->ODF_arg.index & 0xFF;
+            SDO->CANtxBuff->data[2] = (SDO->ODF_arg.index>>8) & 0xFF;
+            SDO->CANtxBuff->data[3] = SDO->ODF_arg.subIndex;
+            CO_memcpySwap4(&SDO->CANtxBuff->data[4], &code);
+            CO_CANsend(SDO->CANdevTx, SDO->CANtxBuff);
+            SDO->ODFaborted = true;
+#ifdef CO_SDO_TRANSFER_LOG
+            SDO->transfer.abortCode = code;
+#endif
+            *ret = -1;
+        }
+        return false;
+    }
+
+    /* transfer was aborted, release the request */
+    if(SDO->ODFaborted || !NMTisPreOrOperational){
+        SDO->state = CO_SDO_ST_IDLE;
+        CLEAR_CANrxNew(SDO->CANrxNew);
+        *ret = 0;
+        return false;
+    }
+
+    if(SDO->ODF_arg.reading){
+        if(abortCode == 0U){
+            abortCode = CO_SDO_readODfinish(SDO, CO_SDO_BUFFER_SIZE, true);
+        }
+        if(abortCode != 0U){
+            CO_SDO_abort(SDO, abortCode);
+            *ret = -1;
+            return false;
+        }
+        SDO->state = CO_SDO_uploadState(SDO);
+        return true;
+    }
+
+    /* download response was prepared before waiting */
+    if(abortCode == 0U){
+        CO_LOCK_OD();
+        CO_SDO_writeODfinish(SDO, SDO->ODF_arg.dataLength);
+        CO_UNLOCK_OD();
+    }
+    if(abortCode != 0U){
+        CO_SDO_abort(SDO, abortCode);
+        *ret = -1;
+        return false;
+    }
+    SDO->state = CO_SDO_ST_IDLE;
+    CLEAR_CANrxNew(SDO->CANrxNew);
+    CO_CANsend(SDO->CANdevTx, SDO->CANtxBuff);
+    *ret = 0;
+    return false;
 }
 
 
 /******************************************************************************/
-int8_t CO_SDO_process(
+void CO_SDO_ODF_complete(CO_ODF_arg_t *ODF_arg, uint32_t abortCode){
+    CO_SDO_t *SDO;
+
+    if(ODF_arg == NULL){
+        return;
+    }
+    SDO = (CO_SDO_t*)((uint8_t*)ODF_arg - offsetof(CO_SDO_t, ODF_arg));
+
+    CO_LOCK_OD();
+    if(SDO->ODFpending){
+        SDO->ODFabortCode = abortCode;
+        SDO->ODFpending = false;
+    }
+    CO_UNLOCK_OD();
+
+    /* resume task, which processes SDO server */
+    if(SDO->CANrxActiveNew != NULL){
+        SET_CANrxNew(*SDO->CANrxActiveNew);
+    }
+    if(SDO->pFunctSignal != NULL){
+        SDO->pFunctSignal();
+    }
+}
+#endif
+
+
+/*
+ * State machine of CO_SDO_process().
+ */
+static int8_t CO_SDO_processState(
         CO_SDO_t               *SDO,
         bool_t                  NMTisPreOrOperational,
         uint16_t                timeDifference_ms,
@@ -794,6 +1959,37 @@ int8_t CO_SDO_process(
     bool_t timeoutSubblockDownolad = false;
     bool_t sendResponse = false;
 
+#ifdef CO_SDO_FAST_EXPEDITED
+    SDO->fastPathEnabled = NMTisPreOrOperational;
+#endif
+
+#ifdef CO_SDO_ODF_ASYNC
+    /* Object dictionary function completes later, request stays in CANrxData */
+    if(SDO->state == CO_SDO_ST_ODF_PENDING){
+        int8_t ret;
+
+        if(!CO_SDO_ODFprocess(SDO, NMTisPreOrOperational, timeDifference_ms, SDOtimeoutTime, &ret)){
+            return ret;
+        }
+    }
+#endif
+
+    /* take next queued message, if previous one was processed */
+    if((SDO->rxRing != NULL) && (!IS_CANrxNew(SDO->CANrxNew)) && (SDO->state != CO_SDO_ST_DOWNLOAD_BL_SUBBLOCK)){
+        const CO_rxRingMsg_t *rxMsg = CO_rxRing_peek(SDO->rxRing);
+
+        if(rxMsg != NULL){
+            uint8_t i;
+
+            for(i=0U; i<8U; i++){
+                SDO->CANrxData[i] = rxMsg->data[i];
+            }
+            /* set flag before releasing the message, so receive thread keeps queuing */
+            SET_CANrxNew(SDO->CANrxNew);
+            CO_rxRing_pop(SDO->rxRing);
+        }
+    }
+
     /* return if idle */
     if((SDO->state == CO_SDO_ST_IDLE) && (!IS_CANrxNew(SDO->CANrxNew))){
         return 0;
@@ -801,11 +1997,21 @@ int8_t CO_SDO_process(
 
     /* SDO is allowed to work only in operational or pre-operational NMT state */
     if(!NMTisPreOrOperational){
+#ifdef CO_SDO_TRANSFER_LOG
+        SDO->transfer.abortCode = CO_SDO_AB_DATA_DEV_STATE;
+#endif
         SDO->state = CO_SDO_ST_IDLE;
         CLEAR_CANrxNew(SDO->CANrxNew);
         return 0;
     }
 
+#ifdef CO_SDO_BLOCK_TUNING
+    /* duration of the current transfer */
+    if(SDO->state != CO_SDO_ST_IDLE){
+        SDO->transferTime_ms += timeDifference_ms;
+    }
+#endif
+
     /* Is something new to process? */
     if((!SDO->CANtxBuff->bufferFull) && ((IS_CANrxNew(SDO->CANrxNew)) || (SDO->state == CO_SDO_ST_UPLOAD_BL_SUBBLOCK))){
         uint8_t CCS = SDO->CANrxData[0] >> 5;   /* Client command specifier */
@@ -815,11 +2021,22 @@ int8_t CO_SDO_process(
             SDO->timeoutTimer = 0;
 
         /* clear response buffer */
+#ifdef CO_SDO_BLOCK_TUNING
+        /* keep block segment, which was not accepted by the driver */
+        if(!SDO->blockTxPending || IS_CANrxNew(SDO->CANrxNew)){
+            SDO->blockTxPending = false;
+#endif
         SDO->CANtxBuff->data[0] = SDO->CANtxBuff->data[1] = SDO->CANtxBuff->data[2] = SDO->CANtxBuff->data[3] = 0;
         SDO->CANtxBuff->data[4] = SDO->CANtxBuff->data[5] = SDO->CANtxBuff->data[6] = SDO->CANtxBuff->data[7] = 0;
+#ifdef CO_SDO_BLOCK_TUNING
+        }
+#endif
 
         /* Is abort from client? */
         if((IS_CANrxNew(SDO->CANrxNew)) && (SDO->CANrxData[0] == CCS_ABORT)){
+#ifdef CO_SDO_TRANSFER_LOG
+            CO_memcpySwap4(&SDO->transfer.abortCode, &SDO->CANrxData[4]);
+#endif
             SDO->state = CO_SDO_ST_IDLE;
             CLEAR_CANrxNew(SDO->CANrxNew);
             return -1;
@@ -833,6 +2050,10 @@ int8_t CO_SDO_process(
             uint32_t abortCode;
             uint16_t index;
 
+#ifdef CO_SDO_TRANSFER_LOG
+            CO_SDO_transferStart(SDO, CCS);
+#endif
+
             /* Is client command specifier valid */
             if((CCS != CCS_DOWNLOAD_INITIATE) && (CCS != CCS_UPLOAD_INITIATE) &&
                 (CCS != CCS_DOWNLOAD_BLOCK) && (CCS != CCS_UPLOAD_BLOCK)){
@@ -848,6 +2069,9 @@ int8_t CO_SDO_process(
                 CO_SDO_abort(SDO, abortCode);
                 return -1;
             }
+#ifdef CO_SDO_BLOCK_TUNING
+            SDO->transferTime_ms = 0U;
+#endif
 
             /* download */
             if((CCS == CCS_DOWNLOAD_INITIATE) || (CCS == CCS_DOWNLOAD_BLOCK)){
@@ -867,19 +2091,19 @@ int8_t CO_SDO_process(
 
             /* upload */
             else{
-                abortCode = CO_SDO_readOD(SDO, CO_SDO_BUFFER_SIZE);
+                abortCode = CO_SDO_readODasync(SDO, CO_SDO_BUFFER_SIZE, true);
+#ifdef CO_SDO_ODF_ASYNC
+                if(abortCode == CO_SDO_AB_PENDING){
+                    SDO->state = CO_SDO_ST_ODF_PENDING;
+                    return 1;
+                }
+#endif
                 if(abortCode != 0U){
                     CO_SDO_abort(SDO, abortCode);
                     return -1;
                 }
 
-                /* if data size is large enough set state machine to block upload, otherwise set to normal transfer */
-                if((CCS == CCS_UPLOAD_BLOCK) && (SDO->ODF_arg.dataLength > SDO->CANrxData[5])){
-                    state = CO_SDO_ST_UPLOAD_BL_INITIATE;
-                }
-                else{
-                    state = CO_SDO_ST_UPLOAD_INITIATE;
-                }
+                state = CO_SDO_uploadState(SDO);
             }
         }
     }
@@ -898,6 +2122,14 @@ int8_t CO_SDO_process(
             return -1;
         }
     }
+    else if((state != CO_SDO_ST_IDLE) && (timerNext_ms != NULL)){
+        /* transfer in progress, call again at its timeout */
+        uint16_t diff = SDOtimeoutTime - SDO->timeoutTimer;
+
+        if(*timerNext_ms > diff){
+            *timerNext_ms = diff;
+        }
+    }
 
     /* return immediately if still idle */
     if(state == CO_SDO_ST_IDLE){
@@ -934,7 +2166,13 @@ int8_t CO_SDO_process(
                 SDO->ODF_arg.data[3] = SDO->CANrxData[7];
 
                 /* write data to the Object dictionary */
-                abortCode = CO_SDO_writeOD(SDO, len);
+                abortCode = CO_SDO_writeODasync(SDO, len, true);
+#ifdef CO_SDO_ODF_ASYNC
+                if(abortCode == CO_SDO_AB_PENDING){
+                    SDO->state = CO_SDO_ST_ODF_PENDING;
+                    return 1;
+                }
+#endif
                 if(abortCode != 0U){
                     CO_SDO_abort(SDO, abortCode);
                     return -1;
@@ -1011,7 +2249,14 @@ int8_t CO_SDO_process(
             /* If no more segments to be downloaded, write data to the Object dictionary */
             if((SDO->CANrxData[0] & 0x01U) != 0U){
                 SDO->ODF_arg.lastSegment = true;
-                abortCode = CO_SDO_writeOD(SDO, SDO->bufferOffset);
+                abortCode = CO_SDO_writeODasync(SDO, SDO->bufferOffset, true);
+#ifdef CO_SDO_ODF_ASYNC
+                if(abortCode == CO_SDO_AB_PENDING){
+                    SDO->CANtxBuff->data[0] = 0x20 | (SDO->sequence ? 0x10 : 0x00);
+                    SDO->state = CO_SDO_ST_ODF_PENDING;
+                    return 1;
+                }
+#endif
                 if(abortCode != 0U){
                     CO_SDO_abort(SDO, abortCode);
                     return -1;
@@ -1044,6 +2289,9 @@ int8_t CO_SDO_process(
             /* blksize */
             SDO->blksize = (CO_SDO_BUFFER_SIZE > (7*127)) ? 127 : (CO_SDO_BUFFER_SIZE / 7);
             SDO->CANtxBuff->data[4] = SDO->blksize;
+#ifdef CO_SDO_BLOCK_TUNING
+            SDO->blksizeAdapt = 127U;
+#endif
 
             /* is CRC enabled */
             SDO->crcEnabled = (SDO->CANrxData[0] & 0x04) ? true : false;
@@ -1084,6 +2332,12 @@ int8_t CO_SDO_process(
             /* prepare response */
             SDO->CANtxBuff->data[0] = 0xA2;
             SDO->CANtxBuff->data[1] = SDO->sequence;
+#ifdef CO_SDO_TRANSFER_LOG
+            /* client repeats the segments after the last correct one */
+            if(!lastSegmentInSubblock && (SDO->sequence < SDO->blksize)){
+                SDO->transfer.retransmissions += SDO->blksize - SDO->sequence;
+            }
+#endif
             SDO->sequence = 0;
 
             /* empty buffer in domain data type if not last segment */
@@ -1105,9 +2359,24 @@ int8_t CO_SDO_process(
                 SDO->bufferOffset = 0;
             }
 
+#ifdef CO_SDO_BLOCK_TUNING
+            /* halve block size after lost segments, double it after complete block */
+            if(SDO->CANtxBuff->data[1] < SDO->blksize){
+                SDO->blksizeAdapt = (SDO->blksizeAdapt > 1U) ? (SDO->blksizeAdapt / 2U) : 1U;
+            }
+            else{
+                SDO->blksizeAdapt = (SDO->blksizeAdapt < 64U) ? (SDO->blksizeAdapt * 2U) : 127U;
+            }
+#endif
+
             /* blksize */
             len = CO_SDO_BUFFER_SIZE - SDO->bufferOffset;
             SDO->blksize = (len > (7*127)) ? 127 : (len / 7);
+#ifdef CO_SDO_BLOCK_TUNING
+            if(SDO->blksize > SDO->blksizeAdapt){
+                SDO->blksize = SDO->blksizeAdapt;
+            }
+#endif
             SDO->CANtxBuff->data[2] = SDO->blksize;
 
             /* set next state */
@@ -1154,12 +2423,23 @@ int8_t CO_SDO_process(
 
             /* write data to the Object dictionary */
             SDO->ODF_arg.lastSegment = true;
-            abortCode = CO_SDO_writeOD(SDO, SDO->bufferOffset);
+            abortCode = CO_SDO_writeODasync(SDO, SDO->bufferOffset, true);
+#ifdef CO_SDO_ODF_ASYNC
+            if(abortCode == CO_SDO_AB_PENDING){
+                SDO->CANtxBuff->data[0] = 0xA1;
+                SDO->state = CO_SDO_ST_ODF_PENDING;
+                return 1;
+            }
+#endif
             if(abortCode != 0U){
                 CO_SDO_abort(SDO, abortCode);
                 return -1;
             }
 
+#ifdef CO_SDO_BLOCK_TUNING
+            CO_SDO_transferRate(SDO);
+#endif
+
             /* send response */
             SDO->CANtxBuff->data[0] = 0xA1;
             SDO->state = CO_SDO_ST_IDLE;
@@ -1173,6 +2453,33 @@ int8_t CO_SDO_process(
             SDO->CANtxBuff->data[2] = SDO->CANrxData[2];
             SDO->CANtxBuff->data[3] = SDO->CANrxData[3];
 
+#ifdef CO_SDO_STREAM_UPLOAD
+            /* Expedited transfer from memory areas */
+            if((SDO->ODF_arg.scatter != NULL) && (SDO->streamRemaining != 0U) && (SDO->streamRemaining <= 4U)){
+                len = CO_SDO_streamCopy(SDO, &SDO->CANtxBuff->data[4], 4U);
+
+                SDO->CANtxBuff->data[0] = 0x43U | ((4U-len) << 2U);
+                SDO->state = CO_SDO_ST_IDLE;
+
+                sendResponse = true;
+            }
+            else if(SDO->ODF_arg.scatter != NULL){
+                SDO->bufferOffset = 0U;
+                SDO->sequence = 0U;
+                SDO->state = CO_SDO_ST_UPLOAD_SEGMENTED;
+
+                /* indicate data size */
+                {
+                    uint32_t lenTotal = SDO->ODF_arg.dataLengthTotal;
+                    CO_memcpySwap4(&SDO->CANtxBuff->data[4], &lenTotal);
+                }
+                SDO->CANtxBuff->data[0] = 0x41U;
+
+                /* send response */
+                sendResponse = true;
+            }
+            else
+#endif
             /* Expedited transfer */
             if(SDO->ODF_arg.dataLength <= 4U){
                 for(i=0U; i<SDO->ODF_arg.dataLength; i++)
@@ -1220,6 +2527,25 @@ int8_t CO_SDO_process(
                 return -1;
             }
 
+#ifdef CO_SDO_STREAM_UPLOAD
+            /* copy next data bytes directly from memory areas */
+            if(SDO->ODF_arg.scatter != NULL){
+                len = CO_SDO_streamCopy(SDO, &SDO->CANtxBuff->data[1], 7U);
+
+                SDO->CANtxBuff->data[0] = 0x00 | (SDO->sequence ? 0x10 : 0x00) | ((7-len)<<1);
+                SDO->sequence = (SDO->sequence) ? 0 : 1;
+
+                /* verify end of transfer */
+                if(SDO->streamRemaining == 0U){
+                    SDO->CANtxBuff->data[0] |= 0x01;
+                    SDO->state = CO_SDO_ST_IDLE;
+                }
+
+                sendResponse = true;
+                break;
+            }
+#endif
+
             /* calculate length to be sent */
             len = SDO->ODF_arg.dataLength - SDO->bufferOffset;
             if(len > 7U) len = 7U;
@@ -1280,6 +2606,15 @@ int8_t CO_SDO_process(
             /* calculate CRC, if enabled */
             if((SDO->CANrxData[0] & 0x04U) != 0U){
                 SDO->crcEnabled = true;
+#ifdef CO_SDO_STREAM_UPLOAD
+                if(SDO->ODF_arg.scatter != NULL){
+                    SDO->crc = 0;
+                    for(i=0U; i<SDO->ODF_arg.scatterCount; i++){
+                        SDO->crc = crc16_ccitt(SDO->ODF_arg.scatter[i].data, SDO->ODF_arg.scatter[i].length, SDO->crc);
+                    }
+                }
+                else
+#endif
                 SDO->crc = crc16_ccitt(SDO->ODF_arg.data, SDO->ODF_arg.dataLength, 0);
             }
             else{
@@ -1297,6 +2632,16 @@ int8_t CO_SDO_process(
             }
 
             /* verify blksize and if SDO data buffer is large enough */
+#ifdef CO_SDO_STREAM_UPLOAD
+            if(SDO->ODF_arg.scatter != NULL){
+                /* memory areas are not limited by SDO data buffer */
+                if((SDO->blksize < 1U) || (SDO->blksize > 127U)){
+                    CO_SDO_abort(SDO, CO_SDO_AB_BLOCK_SIZE); /* Invalid block size (block mode only). */
+                    return -1;
+                }
+            }
+            else
+#endif
             if((SDO->blksize < 1U) || (SDO->blksize > 127U) ||
                (((SDO->blksize*7U) > SDO->ODF_arg.dataLength) && (!SDO->ODF_arg.lastSegment))){
                 CO_SDO_abort(SDO, CO_SDO_AB_BLOCK_SIZE); /* Invalid block size (block mode only). */
@@ -1329,6 +2674,14 @@ int8_t CO_SDO_process(
             SDO->bufferOffset = 0;
             SDO->sequence = 0;
             SDO->endOfTransfer = false;
+#ifdef CO_SDO_BLOCK_TUNING
+            SDO->blockTxPending = false;
+#endif
+#ifdef CO_SDO_STREAM_UPLOAD
+            SDO->streamBlockIdx = SDO->streamIdx;
+            SDO->streamBlockOffset = SDO->streamOffset;
+            SDO->streamBlockRemaining = SDO->streamRemaining;
+#endif
             CLEAR_CANrxNew(SDO->CANrxNew);
             SDO->state = CO_SDO_ST_UPLOAD_BL_SUBBLOCK;
             /* continue in next case */
@@ -1370,6 +2723,38 @@ int8_t CO_SDO_process(
                     break;
                 }
 
+#ifdef CO_SDO_TRANSFER_LOG
+                /* segments after ackseq are sent again */
+                SDO->transfer.retransmissions += SDO->sequence - ackseq;
+#endif
+
+#ifdef CO_SDO_STREAM_UPLOAD
+                /* continue after the last segment confirmed by the client */
+                if(SDO->ODF_arg.scatter != NULL){
+                    SDO->streamIdx = SDO->streamBlockIdx;
+                    SDO->streamOffset = SDO->streamBlockOffset;
+                    SDO->streamRemaining = SDO->streamBlockRemaining;
+                    CO_SDO_streamCopy(SDO, NULL, ackseq * 7U);
+                    SDO->streamBlockIdx = SDO->streamIdx;
+                    SDO->streamBlockOffset = SDO->streamOffset;
+                    SDO->streamBlockRemaining = SDO->streamRemaining;
+
+                    /* new block size */
+                    SDO->blksize = SDO->CANrxData[2];
+                    if((SDO->blksize < 1U) || (SDO->blksize > 127U)){
+                        CO_SDO_abort(SDO, CO_SDO_AB_BLOCK_SIZE); /* Invalid block size (block mode only). */
+                        return -1;
+                    }
+
+                    SDO->bufferOffset = 0U;
+                    SDO->sequence = 0U;
+                    SDO->endOfTransfer = false;
+
+                    /* clear flag here */
+                    CLEAR_CANrxNew(SDO->CANrxNew);
+                }
+                else{
+#endif
                 /* move remaining data to the beginning */
                 for(i=ackseq*7, j=0; i<SDO->ODF_arg.dataLength; i++, j++)
                     SDO->ODF_arg.data[j] = SDO->ODF_arg.data[i];
@@ -1416,8 +2801,45 @@ int8_t CO_SDO_process(
 
                 /* clear flag here */
                 CLEAR_CANrxNew(SDO->CANrxNew);
+#ifdef CO_SDO_STREAM_UPLOAD
+                }
+#endif
+            }
+
+#ifdef CO_SDO_BLOCK_TUNING
+            /* send segment, which was not accepted by the driver in previous call */
+            if(SDO->blockTxPending){
+                if(CO_CANCheckSend(SDO->CANdevTx, SDO->CANtxBuff) == CO_ERROR_TX_BUSY){
+                    if((timerNext_ms != NULL) && (*timerNext_ms > 1U)){
+                        *timerNext_ms = 1U;
+                    }
+                    return 1;
+                }
+                SDO->blockTxPending = false;
+            }
+
+            /* send as many segments of the block, as the driver accepts */
+            while((SDO->sequence < SDO->blksize) && (!SDO->endOfTransfer) && (!SDO->CANtxBuff->bufferFull)){
+                SDO->timeoutTimer = 0;
+                CO_SDO_prepareBlockSegment(SDO);
+                if(CO_CANCheckSend(SDO->CANdevTx, SDO->CANtxBuff) == CO_ERROR_TX_BUSY){
+                    SDO->blockTxPending = true;
+                    break;
+                }
             }
 
+            /* Inform OS to call this function again, if block is not finished */
+            if(timerNext_ms != NULL){
+                if(SDO->blockTxPending){
+                    if(*timerNext_ms > 1U){
+                        *timerNext_ms = 1U;
+                    }
+                }
+                else if((SDO->sequence < SDO->blksize) && (!SDO->endOfTransfer)){
+                    *timerNext_ms = 0;
+                }
+            }
+#else
             /* return, if all segments was already transfered or on end of transfer */
             if((SDO->sequence == SDO->blksize) || (SDO->endOfTransfer)){
                 return 1;/* don't call CLEAR_CANrxNew, so return directly */
@@ -1426,27 +2848,8 @@ int8_t CO_SDO_process(
             /* reset timeout */
             SDO->timeoutTimer = 0;
 
-            /* calculate length to be sent */
-            len = SDO->ODF_arg.dataLength - SDO->bufferOffset;
-            if(len > 7U){
-                len = 7U;
-            }
-
             /* fill response data bytes */
-            for(i=0U; i<len; i++){
-                SDO->CANtxBuff->data[i+1] = SDO->ODF_arg.data[SDO->bufferOffset++];
-            }
-
-            /* first response byte */
-            SDO->CANtxBuff->data[0] = ++SDO->sequence;
-
-            /* verify end of transfer */
-            if((SDO->bufferOffset == SDO->ODF_arg.dataLength) && (SDO->ODF_arg.lastSegment)){
-                SDO->CANtxBuff->data[0] |= 0x80;
-                SDO->lastLen = len;
-                SDO->blksize = SDO->sequence;
-                SDO->endOfTransfer = true;
-            }
+            CO_SDO_prepareBlockSegment(SDO);
 
             /* send response */
             CO_CANsend(SDO->CANdevTx, SDO->CANtxBuff);
@@ -1455,6 +2858,7 @@ int8_t CO_SDO_process(
             if(timerNext_ms != NULL){
                 *timerNext_ms = 0;
             }
+#endif
 
             /* don't call CLEAR_CANrxNew, so return directly */
             return 1;
@@ -1467,6 +2871,9 @@ int8_t CO_SDO_process(
                 return -1;
             }
 
+#ifdef CO_SDO_BLOCK_TUNING
+            CO_SDO_transferRate(SDO);
+#endif
             SDO->state = CO_SDO_ST_IDLE;
             break;
         }
@@ -1489,3 +2896,28 @@ int8_t CO_SDO_process(
 
     return 0;
 }
+
+
+/******************************************************************************/
+int8_t CO_SDO_process(
+        CO_SDO_t               *SDO,
+        bool_t                  NMTisPreOrOperational,
+        uint16_t                timeDifference_ms,
+        uint16_t                SDOtimeoutTime,
+        uint16_t               *timerNext_ms)
+{
+#ifdef CO_SDO_TRANSFER_LOG
+    int8_t ret;
+
+    if(SDO->transferOpen){
+        SDO->transfer.duration_ms += timeDifference_ms;
+    }
+    ret = CO_SDO_processState(SDO, NMTisPreOrOperational, timeDifference_ms, SDOtimeoutTime, timerNext_ms);
+    if(SDO->transferOpen){
+        CO_SDO_transferUpdate(SDO);
+    }
+    return ret;
+#else
+    return CO_SDO_processState(SDO, NMTisPreOrOperational, timeDifference_ms, SDOtimeoutTime, timerNext_ms);
+#endif
+}
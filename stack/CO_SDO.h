@@ -47,6 +47,10 @@
 #ifndef CO_SDO_H
 #define CO_SDO_H
 
+#include <string.h>
+
+#include "CO_rxRing.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -197,7 +201,8 @@ typedef enum{
     CO_SDO_AB_DATA_LOC_CTRL         = 0x08000021UL, /**< 0x08000021, Data cannot be transferred or stored to application because of local control */
     CO_SDO_AB_DATA_DEV_STATE        = 0x08000022UL, /**< 0x08000022, Data cannot be transferred or stored to application because of present device state */
     CO_SDO_AB_DATA_OD               = 0x08000023UL, /**< 0x08000023, Object dictionary not present or dynamic generation fails */
-    CO_SDO_AB_NO_DATA               = 0x08000024UL  /**< 0x08000024, No data available */
+    CO_SDO_AB_NO_DATA               = 0x08000024UL, /**< 0x08000024, No data available */
+    CO_SDO_AB_PENDING               = 0x7FFFFFFFUL  /**< Not an abort code: @ref CO_SDO_OD_function completes later, see #CO_SDO_ODF_ASYNC */
 }CO_SDO_abortCode_t;
 
 
@@ -333,12 +338,15 @@ typedef enum{
  *     specify actual length. With domain data type it is possible to transfer
  *     data, which are longer than #CO_SDO_BUFFER_SIZE. In that case
  *     Object dictionary function is called multiple times between SDO transfer.
+ *     With #CO_SDO_STREAM_UPLOAD function may instead point the SDO server to
+ *     the data in application memory by upload.
  *
  * ####Parameter to function:
  *     ODF_arg     - Pointer to CO_ODF_arg_t object filled before function call.
  *
  * ####Return from function:
  *  - 0: Data transfer is successful
+ *  - CO_SDO_AB_PENDING: Function completes later, see #CO_SDO_ODF_ASYNC.
  *  - Different than 0: Failure. See #CO_SDO_abortCode_t.
  */
 
@@ -359,6 +367,201 @@ typedef enum{
     #endif
 
 
+/**
+ * Object Dictionary lookup table.
+ *
+ * If defined, CO_SDO_initFindTable() builds a table with the first Object
+ * Dictionary entry for each high byte of the index (index range buckets).
+ * CO_OD_find() then searches only the entries inside one bucket, which is
+ * usually a handful of entries, independent of the size of the Object
+ * Dictionary. Table needs 514 bytes of RAM per Object Dictionary, it is shared
+ * by all SDO servers using that Object Dictionary.
+ *
+ * If the Object Dictionary is not sorted by index, the table is not used and
+ * CO_OD_find() falls back to binary search over the whole array.
+ */
+/* #define CO_OD_FIND_TABLE */
+
+
+/**
+ * Number of elements in the lookup table, see #CO_OD_FIND_TABLE.
+ */
+#define CO_OD_FIND_TABLE_SIZE   257U
+
+
+/**
+ * Streaming SDO upload of domains.
+ *
+ * If defined, @ref CO_SDO_OD_function of a domain may, when called for the
+ * first segment of an upload, set CO_ODF_arg_t::scatter to a list of memory
+ * areas (see CO_SDO_scatter_t) instead of copying data into the SDO buffer.
+ * SDO server then transfers all areas in sequence directly from application
+ * memory by expedited, segmented or block upload. Object dictionary function
+ * is not called again for that transfer, the block size is not limited by
+ * #CO_SDO_BUFFER_SIZE and CRC is calculated over the areas.
+ *
+ * Scatter list and memory areas must stay valid and unchanged until SDO
+ * server finishes or aborts the transfer.
+ */
+/* #define CO_SDO_STREAM_UPLOAD */
+
+
+/**
+ * SDO block transfer tuning.
+ *
+ * If defined, SDO server sends as many segments of a block upload in one
+ * CO_SDO_process() call, as the CAN driver accepts with CO_CANCheckSend().
+ * (Segment, which was rejected with #CO_ERROR_TX_BUSY, is sent first in the
+ * next call.) By block download server halves the block size after a sub-block
+ * with lost segments and doubles it again after complete sub-blocks, SDO client
+ * does the same by block upload. Achieved data rate of the last block transfer
+ * is available in CO_SDO_t::transferRate and CO_SDOclient_t::transferRate.
+ *
+ * Burst sending requires a CAN driver, which copies messages into a transmit
+ * queue in CO_CANsend().
+ */
+/* #define CO_SDO_BLOCK_TUNING */
+
+
+/**
+ * Fast path for expedited SDO transfers.
+ *
+ * If defined, SDO server answers expedited upload and expedited download of
+ * Object Dictionary variables with one to four bytes directly in the receive
+ * function (CAN receive thread or interrupt), without waiting for
+ * CO_SDO_process(). Response is sent with a separate CAN transmit buffer, see
+ * CO_SDO_initFastPath().
+ *
+ * Only plain variables in RAM are served: entry has no @ref CO_SDO_OD_function
+ * registered, is not a domain and is not 0x1003. Request is passed to
+ * CO_SDO_process() as before, if SDO server is busy with another transfer, if
+ * NMT state was not pre-operational or operational by the last
+ * CO_SDO_process() call, if the fast transmit buffer is still full or if the
+ * request results in an SDO abort. Data is copied inside CO_LOCK_OD_RX(),
+ * which must be defined by the driver, if the lock is usable from its receive
+ * context (thread, or interrupt with saved interrupt state).
+ */
+/* #define CO_SDO_FAST_EXPEDITED */
+
+
+/**
+ * Asynchronous Object Dictionary functions.
+ *
+ * If defined, @ref CO_SDO_OD_function may return CO_SDO_AB_PENDING instead of
+ * blocking CO_SDO_process() for a slow operation, for example a hardware
+ * read. SDO server then waits without calling the function again and without
+ * sending a response. Another task finishes the operation, writes the data
+ * into ODF_arg->data (and dataLength for domain) by upload and calls
+ * CO_SDO_ODF_complete() with the result. Next CO_SDO_process() continues the
+ * transfer as if the function had returned that result.
+ *
+ * CO_SDO_AB_PENDING is accepted for the first call by upload and for the last
+ * call by download, which covers all transfers of variables. For other calls
+ * of domain functions and for local transfers of the SDO client it is
+ * replaced by CO_SDO_AB_DEVICE_INCOMPAT.
+ *
+ * If client does not get the response within the SDO timeout or NMT state
+ * leaves pre-operational and operational, the transfer is aborted. ODF_arg
+ * still belongs to the application and SDO server does not start a new
+ * transfer until CO_SDO_ODF_complete() is called. Requests received in the
+ * meantime are queued, if receive ring is used (CO_SDO_initRxRing()).
+ */
+/* #define CO_SDO_ODF_ASYNC */
+
+
+/**
+ * Profiling of Object Dictionary accesses.
+ *
+ * If defined, SDO server keeps a table CO_SDO_t::ODProfile, parallel to the
+ * Object dictionary, see CO_SDO_initProfile(). For each OD entry it counts
+ * the accesses by path (#CO_OD_profilePath_t) and the calls of its
+ * @ref CO_SDO_OD_function together with their longest duration. SDO server
+ * counts its transfers (also from #CO_SDO_FAST_EXPEDITED), RPDO and TPDO count
+ * their mapped variables per processed message, the application counts its
+ * own accesses with CO_OD_PROFILE_COUNT(). Table is read with
+ * CO_ODF_ODprofile().
+ *
+ * Durations are taken from CO_STAT_TIMESTAMP_US(), so CO_USE_STATISTICS must
+ * be defined too. Counters are incremented without lock from different
+ * threads, so a concurrent increment may rarely be lost.
+ */
+/* #define CO_OD_PROFILING */
+
+
+/**
+ * Column layout of the Object Dictionary.
+ *
+ * If defined, SDO server may use the Object dictionary in a second form with
+ * one array per field (CO_OD_columns_t), see CO_SDO_initColumns(). CO_OD_find()
+ * then searches a packed array of indexes, two bytes per entry instead of a
+ * whole CO_OD_entry_t, and the other accessors read only the fields they
+ * need. Records with the same layout, for example all RPDO communication
+ * parameters, share one table of members with offsets relative to the
+ * record, so each record needs a single data pointer.
+ *
+ * Columns are created from the @ref CO_SDO_objectDictionary with
+ * CO_OD_columnsBuild() or may be generated as constant data. The
+ * @ref CO_SDO_objectDictionary stays valid and is still used by CANopen.c for
+ * the Object dictionaries of instances.
+ *
+ * Default values are not deduplicated. They are the initializers of
+ * CO_OD_ROM, CO_OD_RAM and CO_OD_EEPROM in the generated CO_OD.c, whose
+ * generator is not part of this tree, and columns only point into them.
+ */
+/* #define CO_OD_COLUMNS */
+
+
+/**
+ * Number of record members in the columns of the Object Dictionary, which
+ * CANopen.c creates with CO_OD_columnsBuild(), see #CO_OD_COLUMNS. Records
+ * with the same layout share their members.
+ */
+#ifdef CO_OD_COLUMNS
+    #ifndef CO_OD_COLUMNS_MEMBERS
+        #define CO_OD_COLUMNS_MEMBERS   256
+    #endif
+#endif
+
+
+/**
+ * Log of SDO server transfers.
+ *
+ * If defined, CO_SDO_process() records each transfer of the SDO server into
+ * a ring of CO_SDO_transferRecord_t, see CO_SDO_initTransferLog(): COB-ID of
+ * the client, index and sub-index, protocol, number of bytes, duration,
+ * retransmitted block segments and abort code. Records are added, when the
+ * transfer finishes or is aborted, the oldest record is overwritten. The ring
+ * is read with CO_ODF_SDOtransferLog().
+ *
+ * Duration is the sum of timeDifference_ms from the CO_SDO_process() calls
+ * of the transfer, expedited transfers finished in one call have zero.
+ * Transfers answered by #CO_SDO_FAST_EXPEDITED are not recorded.
+ */
+/* #define CO_SDO_TRANSFER_LOG */
+
+
+/**
+ * Number of records in the log of SDO transfers, which CANopen.c shares
+ * between its SDO servers, see #CO_SDO_TRANSFER_LOG.
+ */
+#ifdef CO_SDO_TRANSFER_LOG
+    #ifndef CO_SDO_TRANSFER_LOG_SIZE
+        #define CO_SDO_TRANSFER_LOG_SIZE    16
+    #endif
+#endif
+
+
+/**
+ * Number of elements in the receive ring, which CANopen.c gives each SDO
+ * server, see CO_SDO_initRxRing(). Ring holds one message less than its size.
+ * If not defined, SDO servers are initialized without receive ring.
+ */
+/* #define CO_SDO_RX_RING_SIZE 8 */
+#if defined CO_SDO_RX_RING_SIZE && CO_SDO_RX_RING_SIZE < 2
+    #error CO_SDO_RX_RING_SIZE must be at least 2
+#endif
+
+
 /**
  * Object Dictionary attributes. Bit masks for attribute in CO_OD_entry_t.
  */
@@ -461,10 +664,12 @@ typedef enum{
     CO_ODFL_SDO_DOWNLOADED      = 0x10U,
     /** Variable was accessed by SDO upload */
     CO_ODFL_SDO_UPLOADED        = 0x20U,
-    /** Reserved */
-    CO_ODFL_BIT_6               = 0x40U,
-    /** Reserved */
-    CO_ODFL_BIT_7               = 0x80U
+    /** Variable was written by SDO download, RPDO or application. Used by
+    TPDOs with #TPDO_COS_DIRTY_FLAGS to skip change of state detection. */
+    CO_ODFL_TPDO_COS_DIRTY      = 0x40U,
+    /** #CO_ODFL_TPDO_COS_DIRTY taken over by CO_TPDOlatchCOSdirty(), valid
+    until CO_TPDOclearCOSdirty() */
+    CO_ODFL_TPDO_COS_LATCHED    = 0x80U
 }CO_SDO_OD_flags_t;
 
 
@@ -484,7 +689,8 @@ typedef enum {
     CO_SDO_ST_UPLOAD_BL_INITIATE    = 0x24U,
     CO_SDO_ST_UPLOAD_BL_INITIATE_2  = 0x25U,
     CO_SDO_ST_UPLOAD_BL_SUBBLOCK    = 0x26U,
-    CO_SDO_ST_UPLOAD_BL_END         = 0x27U
+    CO_SDO_ST_UPLOAD_BL_END         = 0x27U,
+    CO_SDO_ST_ODF_PENDING           = 0x30U  /**< Waiting for CO_SDO_ODF_complete() */
 } CO_SDO_state_t;
 
 
@@ -534,6 +740,19 @@ typedef struct{
 }CO_OD_entryRecord_t;
 
 
+#ifdef CO_SDO_STREAM_UPLOAD
+/**
+ * Memory area of a streaming SDO upload, see #CO_SDO_STREAM_UPLOAD.
+ */
+typedef struct{
+    /** Pointer to data in application memory. */
+    const uint8_t      *data;
+    /** Length of data in bytes. */
+    uint32_t            length;
+}CO_SDO_scatter_t;
+#endif
+
+
 /**
  * Object contains all information about the object being transferred by SDO server.
  *
@@ -583,9 +802,41 @@ typedef struct{
     /** Used by domain data type. In case of multiple segments, this indicates the offset
     into the buffer this segment starts at. */
     uint32_t            offset;
+#ifdef CO_SDO_STREAM_UPLOAD
+    /** Used by domain data type by upload. @ref CO_SDO_OD_function may set it to
+    an array of scatterCount memory areas, which are then transferred instead
+    of the SDO buffer. See #CO_SDO_STREAM_UPLOAD. NULL by default. */
+    const CO_SDO_scatter_t *scatter;
+    /** Number of elements in scatter array. */
+    uint8_t             scatterCount;
+#endif
 }CO_ODF_arg_t;
 
 
+/**
+ * Sparse table of OD extensions.
+ *
+ * By default CO_SDO_t::ODExtensions is parallel to the Object dictionary and
+ * contains one CO_OD_extension_t for each OD entry. If CO_OD_EXTENSIONS_SPARSE
+ * is defined, it is a hash table with CO_OD_EXTENSIONS_SIZE elements (power
+ * of two), keyed by OD entry number, so RAM use depends on the number of
+ * extensions instead of the size of the Object dictionary. Lookup is O(1) on
+ * average. Extension is added by CO_OD_configure() only, PDO mapping does not
+ * use elements of the table. PDOs look up the extensions of their mapped
+ * variables again, when an extension was added through their SDO object
+ * after the mapping was resolved. If the table is full, CO_OD_configure()
+ * returns CO_ERROR_OUT_OF_MEMORY.
+ */
+#ifdef CO_OD_EXTENSIONS_SPARSE
+  #ifndef CO_OD_EXTENSIONS_SIZE
+    #define CO_OD_EXTENSIONS_SIZE       32
+  #endif
+  #if (CO_OD_EXTENSIONS_SIZE & (CO_OD_EXTENSIONS_SIZE - 1)) != 0
+    #error CO_OD_EXTENSIONS_SIZE must be a power of two.
+  #endif
+#endif
+
+
 /**
  * Object is used as array inside CO_SDO_t, parallel to @ref CO_SDO_objectDictionary.
  *
@@ -600,9 +851,143 @@ typedef struct{
     /** Pointer to #CO_SDO_OD_flags_t. If object type is array or record, this
     variable points to array with length equal to number of subindexes. */
     uint8_t            *flags;
+#ifdef CO_OD_EXTENSIONS_SPARSE
+    /** Sequence number of OD entry, 0xFFFF if element is unused */
+    uint16_t            entryNo;
+#endif
 }CO_OD_extension_t;
 
 
+#ifdef CO_OD_PROFILING
+/**
+ * Access paths counted in CO_OD_profile_t, see #CO_OD_PROFILING.
+ */
+typedef enum{
+    CO_OD_PROF_SDO_READ     = 0,    /**< SDO upload */
+    CO_OD_PROF_SDO_WRITE    = 1,    /**< SDO download */
+    CO_OD_PROF_RPDO         = 2,    /**< Received RPDO copied to OD */
+    CO_OD_PROF_TPDO         = 3,    /**< TPDO copied from OD */
+    CO_OD_PROF_APP          = 4,    /**< Access by the application */
+    CO_OD_PROF_NO_PATHS     = 5     /**< Number of paths */
+}CO_OD_profilePath_t;
+
+
+/**
+ * Profile of one OD entry, element of CO_SDO_t::ODProfile.
+ */
+typedef struct{
+    /** Number of accesses by each #CO_OD_profilePath_t */
+    uint32_t            count[CO_OD_PROF_NO_PATHS];
+    /** Number of calls of @ref CO_SDO_OD_function */
+    uint32_t            ODFcount;
+    /** Longest duration of @ref CO_SDO_OD_function in microseconds */
+    uint32_t            ODFmax_us;
+}CO_OD_profile_t;
+#endif
+
+
+#ifdef CO_OD_COLUMNS
+/**
+ * Offset of a domain in CO_OD_columnMember_t.
+ */
+#define CO_OD_COLUMN_DOMAIN     0xFFFFU
+
+
+/**
+ * Member of a record in CO_OD_columns_t, shared by records with the same
+ * layout.
+ */
+typedef struct{
+    /** Offset of the variable from CO_OD_columns_t::pData of the record or
+    #CO_OD_COLUMN_DOMAIN */
+    uint16_t            offset;
+    /** See #CO_SDO_OD_attributes_t */
+    uint16_t            attribute;
+    /** Length of variable in bytes */
+    uint16_t            length;
+}CO_OD_columnMember_t;
+
+
+/**
+ * Object dictionary in column layout, see #CO_OD_COLUMNS.
+ *
+ * Element i of each array belongs to entry i of the
+ * @ref CO_SDO_objectDictionary, arrays have ODSize elements.
+ */
+typedef struct{
+    /** Number of entries */
+    uint16_t            ODSize;
+    /** Index of the entry, sorted */
+    const uint16_t     *index;
+    /** See CO_OD_entry_t */
+    const uint8_t      *maxSubIndex;
+    /** Attribute of variable or array, zero for record */
+    const uint16_t     *attribute;
+    /** Length of variable or array member. For record position of its
+    sub-index 0 in members. */
+    const uint16_t     *length;
+    /** Data of variable or array, NULL for domain. For record address, to
+    which offsets of its members are added. */
+    void * const       *pData;
+    /** Members of all records */
+    const CO_OD_columnMember_t *members;
+}CO_OD_columns_t;
+#endif
+
+
+#ifdef CO_SDO_TRANSFER_LOG
+/**
+ * SDO protocol of a transfer in CO_SDO_transferRecord_t.
+ */
+typedef enum{
+    CO_SDO_PROT_EXPEDITED   = 0,    /**< Expedited transfer */
+    CO_SDO_PROT_SEGMENTED   = 1,    /**< Segmented transfer */
+    CO_SDO_PROT_BLOCK       = 2     /**< Block transfer */
+}CO_SDO_protocol_t;
+
+
+/**
+ * Record of one SDO server transfer, see #CO_SDO_TRANSFER_LOG.
+ */
+typedef struct{
+    /** CAN identifier of the client requests */
+    uint32_t            COB_IDClient;
+    /** Index of the object */
+    uint16_t            index;
+    /** Sub-index of the object */
+    uint8_t             subIndex;
+    /** See #CO_SDO_protocol_t */
+    uint8_t             protocol;
+    /** True for upload, false for download */
+    bool_t              upload;
+    /** Number of retransmitted segments in block transfer */
+    uint16_t            retransmissions;
+    /** Number of bytes read from or written to the Object dictionary */
+    uint32_t            bytes;
+    /** Duration of the transfer in milliseconds */
+    uint32_t            duration_ms;
+    /** #CO_SDO_abortCode_t sent or received, CO_SDO_AB_NONE on success */
+    uint32_t            abortCode;
+}CO_SDO_transferRecord_t;
+
+
+/**
+ * Ring of transfer records, may be shared by SDO servers, see
+ * CO_SDO_initTransferLog().
+ */
+typedef struct{
+    /** Array of size elements, set by the application */
+    CO_SDO_transferRecord_t *records;
+    /** Number of records, set by the application */
+    uint16_t            size;
+    /** Element of records, which is written next */
+    uint16_t            head;
+    /** Number of recorded transfers since the last clear */
+    uint32_t            count;
+}CO_SDO_transferLog_t;
+#endif
+
+
 /**
  * SDO server object.
  */
@@ -618,8 +1003,26 @@ typedef struct{
     /** Size of the @ref CO_SDO_objectDictionary */
     uint16_t            ODSize;
     /** Pointer to array of CO_OD_extension_t objects. Size of the array is
-    equal to ODSize. */
+    equal to ODSize or CO_OD_EXTENSIONS_SIZE, see CO_OD_EXTENSIONS_SPARSE. */
     CO_OD_extension_t  *ODExtensions;
+#ifdef CO_OD_EXTENSIONS_SPARSE
+    /** Number of extensions added through this object, see
+    CO_OD_EXTENSIONS_SPARSE. */
+    uint16_t            ODExtensionsUsed;
+#endif
+#ifdef CO_OD_PROFILING
+    /** From CO_SDO_initProfile() or NULL, array of ODSize elements. */
+    CO_OD_profile_t    *ODProfile;
+#endif
+#ifdef CO_OD_COLUMNS
+    /** From CO_SDO_initColumns() or NULL, if OD is used directly. */
+    const CO_OD_columns_t *ODColumns;
+#endif
+#ifdef CO_OD_FIND_TABLE
+    /** Lookup table used by CO_OD_find(), from CO_SDO_initFindTable() or
+    from the parent. NULL, if not initialized or OD is not sorted. */
+    const uint16_t     *ODFindTable;
+#endif
     /** Offset in buffer of next data segment being read/written */
     uint16_t            bufferOffset;
     /** Sequence number of OD entry as returned from CO_OD_find() */
@@ -645,14 +1048,69 @@ typedef struct{
     uint8_t             lastLen;
     /** Indication end of block transfer */
     bool_t              endOfTransfer;
+#ifdef CO_SDO_BLOCK_TUNING
+    /** True, if block segment in CANtxBuff was not accepted by the driver yet */
+    bool_t              blockTxPending;
+    /** Upper limit for blksize by block download, adapted to lost segments */
+    uint8_t             blksizeAdapt;
+    /** Duration of the current transfer in milliseconds */
+    uint32_t            transferTime_ms;
+    /** Data rate of the last successful block transfer in bytes per second */
+    uint32_t            transferRate;
+#endif
+#ifdef CO_SDO_STREAM_UPLOAD
+    /** Element of ODF_arg.scatter with the next data to upload */
+    uint8_t             streamIdx;
+    /** Offset of the next data inside that element */
+    uint32_t            streamOffset;
+    /** Number of bytes not yet uploaded */
+    uint32_t            streamRemaining;
+    /** streamIdx at the start of the current block in block upload */
+    uint8_t             streamBlockIdx;
+    /** streamOffset at the start of the current block in block upload */
+    uint32_t            streamBlockOffset;
+    /** streamRemaining at the start of the current block in block upload */
+    uint32_t            streamBlockRemaining;
+#endif
     /** Variable indicates, if new SDO message received from CAN bus */
     volatile void      *CANrxNew;
+    /** From CO_SDO_initActiveFlag() or NULL. Set together with CANrxNew. */
+    volatile void     **CANrxActiveNew;
+    /** From CO_SDO_initRxRing() or NULL */
+    CO_rxRing_t        *rxRing;
     /** From CO_SDO_initCallback() or NULL */
     void              (*pFunctSignal)(void);
     /** From CO_SDO_init() */
     CO_CANmodule_t     *CANdevTx;
     /** CAN transmit buffer inside CANdev for CAN tx message */
     CO_CANtx_t         *CANtxBuff;
+#ifdef CO_SDO_FAST_EXPEDITED
+    /** From CO_SDO_init(), CAN identifier of the response */
+    uint32_t            COB_IDServerToClient;
+    /** CAN transmit buffer for the fast path, from CO_SDO_initFastPath() or NULL */
+    CO_CANtx_t         *CANtxBuffFast;
+    /** True, if NMT state was pre-operational or operational by the last
+    CO_SDO_process() call */
+    volatile bool_t     fastPathEnabled;
+#endif
+#ifdef CO_SDO_ODF_ASYNC
+    /** True from CO_SDO_AB_PENDING to CO_SDO_ODF_complete() */
+    volatile bool_t     ODFpending;
+    /** True, if waiting transfer was already aborted */
+    bool_t              ODFaborted;
+    /** Result from CO_SDO_ODF_complete() */
+    uint32_t            ODFabortCode;
+#endif
+#ifdef CO_SDO_TRANSFER_LOG
+    /** From CO_SDO_initTransferLog() or NULL */
+    CO_SDO_transferLog_t *transferLog;
+    /** From CO_SDO_init(), CAN identifier of the requests */
+    uint32_t            COB_IDClientToServer;
+    /** Record of the current transfer, valid if transferOpen is true */
+    CO_SDO_transferRecord_t transfer;
+    /** True, if current transfer is recorded */
+    bool_t              transferOpen;
+#endif
 }CO_SDO_t;
 
 
@@ -689,13 +1147,45 @@ void CO_memcpy(uint8_t dest[], const uint8_t src[], const uint16_t size);
 void CO_memset(uint8_t dest[], uint8_t c, const uint16_t size);
 
 
+/**
+ * @name Byte order helpers
+ *
+ * CANopen is little endian. Helpers below copy values between CAN data or
+ * Object Dictionary buffers and variables. They are inline and use word
+ * accesses; compiler turns the memcpy() of fixed size into a single load or
+ * store, also for unaligned data. With CO_LITTLE_ENDIAN they are plain copies
+ * and CO_swapArray() is empty, so little endian builds don't contain any
+ * swap code. With CO_BIG_ENDIAN bytes are swapped with CO_SWAP_16(),
+ * CO_SWAP_32() and CO_SWAP_64(), which use compiler builtins with GCC and
+ * may be defined by the target.
+ * @{
+ */
+#ifdef CO_BIG_ENDIAN
+#if defined(__GNUC__) && !defined(CO_SWAP_16)
+    #define CO_SWAP_16(x)   __builtin_bswap16(x)    /**< Swap bytes of uint16_t */
+    #define CO_SWAP_32(x)   __builtin_bswap32(x)    /**< Swap bytes of uint32_t */
+    #define CO_SWAP_64(x)   __builtin_bswap64(x)    /**< Swap bytes of uint64_t */
+#elif !defined(CO_SWAP_16)
+    #define CO_SWAP_16(x)   ((uint16_t)(((uint16_t)(x) << 8) | ((uint16_t)(x) >> 8)))
+    #define CO_SWAP_32(x)   ((((uint32_t)CO_SWAP_16((uint16_t)(x))) << 16) | \
+                             (uint32_t)CO_SWAP_16((uint16_t)((uint32_t)(x) >> 16)))
+    #define CO_SWAP_64(x)   ((((uint64_t)CO_SWAP_32((uint32_t)(x))) << 32) | \
+                             (uint64_t)CO_SWAP_32((uint32_t)((uint64_t)(x) >> 32)))
+#endif
+#endif
+
+
 /**
  * Helper function returns uint16 from byte array.
  *
  * @param data Location of source data.
  * @return Variable of type uint16_t.
  */
-uint16_t CO_getUint16(const uint8_t data[]);
+static inline uint16_t CO_getUint16(const uint8_t data[]){
+    uint16_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
 
 
 /**
@@ -704,7 +1194,11 @@ uint16_t CO_getUint16(const uint8_t data[]);
  * @param data Location of source data.
  * @return Variable of type uint32_t.
  */
-uint32_t CO_getUint32(const uint8_t data[]);
+static inline uint32_t CO_getUint32(const uint8_t data[]){
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
 
 
 /**
@@ -713,7 +1207,9 @@ uint32_t CO_getUint32(const uint8_t data[]);
  * @param data Location of destination data.
  * @param value Variable of type uint16_t to be written into data.
  */
-void CO_setUint16(uint8_t data[], const uint16_t value);
+static inline void CO_setUint16(uint8_t data[], const uint16_t value){
+    memcpy(data, &value, sizeof(value));
+}
 
 
 /**
@@ -722,7 +1218,9 @@ void CO_setUint16(uint8_t data[], const uint16_t value);
  * @param data Location of destination data.
  * @param value Variable of type uint32_t to be written into data.
  */
-void CO_setUint32(uint8_t data[], const uint32_t value);
+static inline void CO_setUint32(uint8_t data[], const uint32_t value){
+    memcpy(data, &value, sizeof(value));
+}
 
 
 /**
@@ -732,7 +1230,16 @@ void CO_setUint32(uint8_t data[], const uint32_t value);
  * @param dest Destination location.
  * @param src Source location.
  */
-void CO_memcpySwap2(void* dest, const void* src);
+static inline void CO_memcpySwap2(void* dest, const void* src){
+#ifdef CO_BIG_ENDIAN
+    uint16_t value;
+    memcpy(&value, src, sizeof(value));
+    value = CO_SWAP_16(value);
+    memcpy(dest, &value, sizeof(value));
+#else
+    memcpy(dest, src, 2U);
+#endif
+}
 
 
 /**
@@ -742,7 +1249,16 @@ void CO_memcpySwap2(void* dest, const void* src);
  * @param dest Destination location.
  * @param src Source location.
  */
-void CO_memcpySwap4(void* dest, const void* src);
+static inline void CO_memcpySwap4(void* dest, const void* src){
+#ifdef CO_BIG_ENDIAN
+    uint32_t value;
+    memcpy(&value, src, sizeof(value));
+    value = CO_SWAP_32(value);
+    memcpy(dest, &value, sizeof(value));
+#else
+    memcpy(dest, src, 4U);
+#endif
+}
 
 
 /**
@@ -752,7 +1268,38 @@ void CO_memcpySwap4(void* dest, const void* src);
  * @param dest Destination location.
  * @param src Source location.
  */
-void CO_memcpySwap8(void* dest, const void* src);
+static inline void CO_memcpySwap8(void* dest, const void* src){
+#ifdef CO_BIG_ENDIAN
+    uint64_t value;
+    memcpy(&value, src, sizeof(value));
+    value = CO_SWAP_64(value);
+    memcpy(dest, &value, sizeof(value));
+#else
+    memcpy(dest, src, 8U);
+#endif
+}
+
+
+/**
+ * Swap bytes of each element of an array in place, if microcontroller is
+ * big-endian.
+ *
+ * Used for multi-byte values (#CO_ODA_MB_VALUE) between the Object
+ * Dictionary and the little endian SDO buffer. Single value is an array with
+ * one element of size length. Elements of 2, 4 and 8 bytes are swapped with
+ * word accesses in one pass, other sizes byte by byte. Empty function on
+ * little endian microcontroller.
+ *
+ * @param data Location of the array.
+ * @param length Length of the array in bytes, multiple of elementSize.
+ * @param elementSize Size of one element in bytes.
+ */
+#ifdef CO_BIG_ENDIAN
+void CO_swapArray(uint8_t data[], uint16_t length, uint16_t elementSize);
+#else
+#define CO_swapArray(data, length, elementSize) ((void)0)
+#endif
+/** @} */
 
 
 /**
@@ -771,7 +1318,7 @@ void CO_memcpySwap8(void* dest, const void* src);
  * @param OD Pointer to @ref CO_SDO_objectDictionary array defined externally.
  * @param ODSize Size of the above array.
  * @param ODExtensions Pointer to the externally defined array of the same size
- * as ODSize.
+ * as ODSize (CO_OD_EXTENSIONS_SIZE with CO_OD_EXTENSIONS_SPARSE).
  * @param nodeId CANopen Node ID of this device.
  * @param CANdevRx CAN device for SDO server reception.
  * @param CANdevRxIdx Index of receive buffer in the above CAN device.
@@ -811,6 +1358,74 @@ void CO_SDO_initCallback(
         void                  (*pFunctSignal)(void));
 
 
+/**
+ * Initialize common flag for new SDO requests.
+ *
+ * Optional flag is set by reception of new message additionally to the own
+ * flag of the SDO server. With multiple SDO servers the same flag may be used
+ * by all of them, so the mainline function needs to look for new requests only
+ * if flag is set. See CO_process() for usage.
+ *
+ * @param SDO This object.
+ * @param CANrxActiveNew Pointer to the flag. Not used if NULL.
+ */
+void CO_SDO_initActiveFlag(
+        CO_SDO_t               *SDO,
+        volatile void         **CANrxActiveNew);
+
+
+/**
+ * Initialize optional receive ring for SDO requests.
+ *
+ * Without receive ring SDO server drops a request, which arrives before the
+ * previous one was processed by CO_SDO_process(). With receive ring such
+ * requests are queued and processed in order of reception. Segments of block
+ * download are not queued. Function must be called after CO_SDO_init().
+ *
+ * @param SDO This object.
+ * @param rxRing Receive ring, initialized with CO_rxRing_init(). Not used if NULL.
+ */
+void CO_SDO_initRxRing(
+        CO_SDO_t               *SDO,
+        CO_rxRing_t            *rxRing);
+
+
+#ifdef CO_SDO_FAST_EXPEDITED
+/**
+ * Initialize fast path for expedited transfers, see #CO_SDO_FAST_EXPEDITED.
+ *
+ * Fast path uses its own CAN transmit buffer with the same CAN identifier as
+ * the SDO response, so it never changes the buffer of CO_SDO_process().
+ * Function must be called after CO_SDO_init().
+ *
+ * @param SDO This object.
+ * @param CANdevTx CAN device for SDO server transmission.
+ * @param CANdevTxIdx Index of transmit buffer in the above CAN device.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_SDO_initFastPath(
+        CO_SDO_t               *SDO,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx);
+#endif
+
+
+#ifdef CO_SDO_ODF_ASYNC
+/**
+ * Complete @ref CO_SDO_OD_function, which returned CO_SDO_AB_PENDING.
+ *
+ * Function may be called from any task. By upload data must be written into
+ * ODF_arg->data before the call. Mainline task is resumed by the callback
+ * from CO_SDO_initCallback(). See #CO_SDO_ODF_ASYNC.
+ *
+ * @param ODF_arg Argument, which was passed to the Object dictionary function.
+ * @param abortCode Result of the function, CO_SDO_AB_NONE on success.
+ */
+void CO_SDO_ODF_complete(CO_ODF_arg_t *ODF_arg, uint32_t abortCode);
+#endif
+
+
 /**
  * Process SDO communication.
  *
@@ -840,7 +1455,7 @@ int8_t CO_SDO_process(
  *
  * Additional functionality include: @ref CO_SDO_OD_function and
  * #CO_SDO_OD_flags_t. It is optional feature and can be used on any object in
- * Object dictionary. If OD entry does not exist, function returns silently.
+ * Object dictionary.
  *
  * @param SDO This object.
  * @param index Index of object in the Object dictionary.
@@ -850,10 +1465,14 @@ int8_t CO_SDO_process(
  * @param flags Pointer to array of #CO_SDO_OD_flags_t defined externally. If
  * zero, #CO_SDO_OD_flags_t will not be used on this OD entry.
  * @param flagsSize Size of the above array. It must be equal to number
- * of sub-objects in object dictionary entry. Otherwise #CO_SDO_OD_flags_t will
- * not be used on this OD entry.
+ * of sub-objects in object dictionary entry, including sub-object 0 (one for
+ * variables). Otherwise #CO_SDO_OD_flags_t will not be used on this OD entry.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT if OD entry
+ * does not exist or CO_ERROR_OUT_OF_MEMORY if there are no ODExtensions or the
+ * sparse table is full (#CO_OD_EXTENSIONS_SPARSE).
  */
-void CO_OD_configure(
+CO_ReturnError_t CO_OD_configure(
         CO_SDO_t               *SDO,
         uint16_t                index,
         CO_SDO_abortCode_t    (*pODFunc)(CO_ODF_arg_t *ODF_arg),
@@ -865,6 +1484,9 @@ void CO_OD_configure(
 /**
  * Find object with specific index in Object dictionary.
  *
+ * Object dictionary must be sorted by index. If #CO_OD_FIND_TABLE is defined,
+ * only the entries with the same high byte of the index are searched.
+ *
  * @param SDO This object.
  * @param index Index of the object in Object dictionary.
  *
@@ -916,6 +1538,28 @@ uint16_t CO_OD_getAttribute(CO_SDO_t *SDO, uint16_t entryNo, uint8_t subIndex);
 void* CO_OD_getDataPointer(CO_SDO_t *SDO, uint16_t entryNo, uint8_t subIndex);
 
 
+/**
+ * Get index of the given object.
+ *
+ * @param SDO This object.
+ * @param entryNo Sequence number of OD entry as returned from CO_OD_find().
+ *
+ * @return Index of the object in Object dictionary.
+ */
+uint16_t CO_OD_getIndex(CO_SDO_t *SDO, uint16_t entryNo);
+
+
+/**
+ * Get highest sub-index of the given object, see CO_OD_entry_t.
+ *
+ * @param SDO This object.
+ * @param entryNo Sequence number of OD entry as returned from CO_OD_find().
+ *
+ * @return Zero for variable, number of sub-objects - 1 for array or record.
+ */
+uint8_t CO_OD_getMaxSubIndex(CO_SDO_t *SDO, uint16_t entryNo);
+
+
 /**
  * Get pointer to the #CO_SDO_OD_flags_t byte of the given object with
  * specific subIndex.
@@ -924,11 +1568,209 @@ void* CO_OD_getDataPointer(CO_SDO_t *SDO, uint16_t entryNo, uint8_t subIndex);
  * @param entryNo Sequence number of OD entry as returned from CO_OD_find().
  * @param subIndex Sub-index of the object in Object dictionary.
  *
- * @return Pointer to the #CO_SDO_OD_flags_t of the variable.
+ * @return Pointer to the #CO_SDO_OD_flags_t of the variable or NULL, if
+ * flags are not configured for this OD entry.
  */
 uint8_t* CO_OD_getFlagsPointer(CO_SDO_t *SDO, uint16_t entryNo, uint8_t subIndex);
 
 
+/**
+ * Get extension of OD entry, see CO_OD_configure().
+ *
+ * @param SDO This object.
+ * @param entryNo Sequence number of OD entry as returned from CO_OD_find().
+ *
+ * @return Pointer to the extension or NULL, if there are no ODExtensions or,
+ * with CO_OD_EXTENSIONS_SPARSE, if extension was not added for this entry.
+ */
+CO_OD_extension_t *CO_OD_getExtension(CO_SDO_t *SDO, uint16_t entryNo);
+
+
+/**
+ * Get extension of OD entry and add an empty one, if it does not exist yet.
+ *
+ * Used by CO_OD_configure() and by PDO mapping, which keeps pointer to the
+ * extension. Pointer stays valid until CO_SDO_init().
+ *
+ * @param SDO This object.
+ * @param entryNo Sequence number of OD entry as returned from CO_OD_find().
+ *
+ * @return Pointer to the extension or NULL, if there are no ODExtensions or
+ * sparse table is full.
+ */
+CO_OD_extension_t *CO_OD_addExtension(CO_SDO_t *SDO, uint16_t entryNo);
+
+
+#ifdef CO_OD_COLUMNS
+/**
+ * Create column layout of Object dictionary, see #CO_OD_COLUMNS.
+ *
+ * Columns are written into the arrays of ODSize elements given as arguments,
+ * record members into members. Columns contain the data pointers of OD, so
+ * they must be created again, if data pointers in OD are changed.
+ *
+ * @param columns This object will be initialized.
+ * @param OD Pointer to @ref CO_SDO_objectDictionary, sorted by index.
+ * @param ODSize Size of the above array.
+ * @param index Array for CO_OD_columns_t::index.
+ * @param maxSubIndex Array for CO_OD_columns_t::maxSubIndex.
+ * @param attribute Array for CO_OD_columns_t::attribute.
+ * @param length Array for CO_OD_columns_t::length.
+ * @param pData Array for CO_OD_columns_t::pData.
+ * @param members Array for record members.
+ * @param membersSize Size of the above array.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT (OD not
+ * sorted or record members more than 64 kB apart) or CO_ERROR_OUT_OF_MEMORY
+ * (membersSize too small).
+ */
+CO_ReturnError_t CO_OD_columnsBuild(
+        CO_OD_columns_t        *columns,
+        const CO_OD_entry_t     OD[],
+        uint16_t                ODSize,
+        uint16_t                index[],
+        uint8_t                 maxSubIndex[],
+        uint16_t                attribute[],
+        uint16_t                length[],
+        void                   *pData[],
+        CO_OD_columnMember_t    members[],
+        uint16_t                membersSize);
+
+
+/**
+ * Use column layout of Object dictionary, see #CO_OD_COLUMNS.
+ *
+ * Function must be called after CO_SDO_init() for each SDO server, which
+ * shares the Object dictionary.
+ *
+ * @param SDO This object.
+ * @param columns Columns of the same Object dictionary or NULL to use the
+ * Object dictionary directly.
+ */
+void CO_SDO_initColumns(CO_SDO_t *SDO, const CO_OD_columns_t *columns);
+#endif
+
+
+#ifdef CO_OD_FIND_TABLE
+/**
+ * Build lookup table of the Object dictionary, see #CO_OD_FIND_TABLE.
+ *
+ * Function must be called after CO_SDO_init() for the SDO server with own
+ * Object dictionary, before the SDO servers sharing it are initialized. They
+ * take the table from their parent, for them function has no effect.
+ *
+ * @param SDO This object.
+ * @param ODFindTable Array of CO_OD_FIND_TABLE_SIZE elements. First entry in
+ * OD for each high byte of the index, last element is ODSize.
+ */
+void CO_SDO_initFindTable(CO_SDO_t *SDO, uint16_t ODFindTable[]);
+#endif
+
+
+#ifdef CO_OD_PROFILING
+/**
+ * Initialize profiling table, see #CO_OD_PROFILING.
+ *
+ * Function must be called after CO_SDO_init() for each SDO server, which
+ * shares the Object dictionary. Table is not cleared, so counting continues
+ * over communication reset, see CO_OD_resetProfile().
+ *
+ * @param SDO This object.
+ * @param ODProfile Array of ODSize elements.
+ */
+void CO_SDO_initProfile(CO_SDO_t *SDO, CO_OD_profile_t ODProfile[]);
+
+
+/**
+ * Count access to an OD entry.
+ *
+ * @param SDO This object.
+ * @param entryNo Sequence number of OD entry as returned from CO_OD_find().
+ * @param path Access path.
+ */
+void CO_OD_profileCount(CO_SDO_t *SDO, uint16_t entryNo, CO_OD_profilePath_t path);
+
+
+/**
+ * Count call of @ref CO_SDO_OD_function of an OD entry.
+ *
+ * @param SDO This object.
+ * @param entryNo Sequence number of OD entry as returned from CO_OD_find().
+ * @param duration_us Duration of the call from CO_STAT_TIMESTAMP_US().
+ */
+void CO_OD_profileODF(CO_SDO_t *SDO, uint16_t entryNo, uint32_t duration_us);
+
+
+/**
+ * Clear profiling table.
+ *
+ * @param SDO This object.
+ */
+void CO_OD_resetProfile(CO_SDO_t *SDO);
+
+
+/**
+ * Function for accessing profiling table from SDO server.
+ *
+ * It may be registered for a manufacturer specific domain with
+ * CO_OD_configure(), object argument must be the SDO server with the table.
+ * Upload contains one record of 32 bytes for each OD entry in order of the
+ * Object dictionary: index (UNSIGNED16), reserved (UNSIGNED16), counters of
+ * #CO_OD_profilePath_t, ODFcount and ODFmax_us (UNSIGNED32 each). Download of
+ * any data clears the table.
+ *
+ * For more information see file CO_SDO.h.
+ */
+CO_SDO_abortCode_t CO_ODF_ODprofile(CO_ODF_arg_t *ODF_arg);
+
+/** Count access to OD entry, see CO_OD_profileCount(). */
+#define CO_OD_PROFILE_COUNT(SDO, entryNo, path) CO_OD_profileCount(SDO, entryNo, path)
+#else
+#define CO_OD_PROFILE_COUNT(SDO, entryNo, path)
+#endif
+
+
+#ifdef CO_SDO_TRANSFER_LOG
+/**
+ * Initialize log of transfers, see #CO_SDO_TRANSFER_LOG.
+ *
+ * Function must be called after CO_SDO_init() for each SDO server, which
+ * records its transfers. Members records and size of transferLog must be set
+ * before, head and count are zero for an empty log. Log is not cleared, so
+ * recording continues over communication reset, see CO_SDO_resetTransferLog().
+ *
+ * @param SDO This object.
+ * @param transferLog Ring of records, may be shared by several SDO servers,
+ * which are processed from the same thread.
+ */
+void CO_SDO_initTransferLog(CO_SDO_t *SDO, CO_SDO_transferLog_t *transferLog);
+
+
+/**
+ * Clear log of transfers.
+ *
+ * @param transferLog Ring of records.
+ */
+void CO_SDO_resetTransferLog(CO_SDO_transferLog_t *transferLog);
+
+
+/**
+ * Function for accessing log of transfers from SDO server.
+ *
+ * It may be registered for a manufacturer specific domain with
+ * CO_OD_configure(), object argument must be the SDO server with the log.
+ * Upload contains one record of 24 bytes for each logged transfer from the
+ * oldest to the newest: COB_IDClient (UNSIGNED32), index (UNSIGNED16),
+ * subIndex, protocol, upload, reserved (UNSIGNED8 each), retransmissions
+ * (UNSIGNED16), bytes, duration_ms and abortCode (UNSIGNED32 each). Transfers, which finish during the upload, may shift
+ * the records. Download of any data clears the log.
+ *
+ * For more information see file CO_SDO.h.
+ */
+CO_SDO_abortCode_t CO_ODF_SDOtransferLog(CO_ODF_arg_t *ODF_arg);
+#endif
+
+
 /**
  * Initialize SDO transfer.
  *
@@ -0,0 +1,398 @@
+/*
+ * CANopen Service Data Object - broadcast program download.
+ *
+ * @file        CO_SDObroadcast.c
+ * @ingroup     CO_SDObroadcast
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_SDOmaster.h"
+#include "CO_SDObroadcast.h"
+#include "crc16-ccitt.h"
+
+
+/* Internal states */
+#define CO_SDOBC_IDLE           0U  /* no transfer */
+#define CO_SDOBC_BROADCAST      1U  /* image to all nodes */
+#define CO_SDOBC_LIST           2U  /* upload of CRC list from node */
+#define CO_SDOBC_OFFSET         3U  /* download of repair offset to node */
+#define CO_SDOBC_REPAIR         4U  /* download of blocks to node */
+
+
+/*
+ * Start one SDO transfer.
+ *
+ * @return CO_SDOcli_ok_communicationEnd, if transfer was started.
+ */
+static CO_SDOclient_return_t CO_SDObroadcast_transfer(
+        CO_SDObroadcast_t      *SDObc,
+        uint32_t                COB_IDClientToServer,
+        uint32_t                COB_IDServerToClient,
+        uint8_t                 nodeId,
+        bool_t                  download,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint8_t                *buffer,
+        uint32_t                bufferSize)
+{
+    CO_SDOclient_return_t ret;
+
+    ret = CO_SDOclient_setup(SDObc->SDO_C, COB_IDClientToServer, COB_IDServerToClient, nodeId);
+    if(ret != CO_SDOcli_ok_communicationEnd){
+        return ret;
+    }
+
+    if(download){
+        ret = CO_SDOclientDownloadInitiate(SDObc->SDO_C, index, subIndex,
+                buffer, bufferSize, (bufferSize > 4U) ? 1 : 0);
+    }
+    else{
+        ret = CO_SDOclientUploadInitiate(SDObc->SDO_C, index, subIndex,
+                buffer, bufferSize, 1);
+    }
+    if(ret != CO_SDOcli_ok_communicationEnd){
+        CO_SDOclientClose(SDObc->SDO_C);
+    }
+    return ret;
+}
+
+
+/*
+ * Mark current node as failed.
+ */
+static void CO_SDObroadcast_fail(
+        CO_SDObroadcast_t      *SDObc,
+        CO_SDOclient_return_t   ret,
+        uint32_t                abortCode)
+{
+    CO_SDObroadcastNode_t *node = &SDObc->nodes[SDObc->node];
+
+    node->verified = false;
+    node->ret = ret;
+    node->abortCode = abortCode;
+}
+
+
+/*
+ * Start verification of the next node, beginning with the current one. Nodes,
+ * for which the transfer can't be started, are marked as failed.
+ */
+static void CO_SDObroadcast_verify(CO_SDObroadcast_t *SDObc){
+    while(SDObc->node < SDObc->nodeCount){
+        CO_SDOclient_return_t ret;
+
+        ret = CO_SDObroadcast_transfer(SDObc, 0, 0, SDObc->nodes[SDObc->node].nodeId,
+                false, SDObc->repairIndex, 1, SDObc->list, sizeof(SDObc->list));
+        if(ret == CO_SDOcli_ok_communicationEnd){
+            SDObc->state = CO_SDOBC_LIST;
+            SDObc->repaired = false;
+            return;
+        }
+        CO_SDObroadcast_fail(SDObc, ret, 0);
+        SDObc->node++;
+        SDObc->round = 0;
+    }
+    SDObc->state = CO_SDOBC_IDLE;
+}
+
+
+/*
+ * Verify, if block of the current node differs from the image.
+ */
+static bool_t CO_SDObroadcast_blockBad(CO_SDObroadcast_t *SDObc, uint16_t block){
+    uint32_t offset = (uint32_t)block * SDObc->blockSize;
+    uint32_t len = SDObc->imageSize - offset;
+    uint16_t crc;
+
+    if(block >= SDObc->blockCount){
+        return true;
+    }
+    if(len > SDObc->blockSize){
+        len = SDObc->blockSize;
+    }
+    crc = CO_getUint16(&SDObc->list[6U + (uint32_t)block * 2U]);
+    return (crc16_ccitt(&SDObc->image[offset], len, 0U) != crc) ? true : false;
+}
+
+
+/*
+ * Start repair of the next run of bad blocks of the current node, starting
+ * from repairBlock. If there are none, verify the node again after a repair
+ * or continue with the next node.
+ */
+static void CO_SDObroadcast_repair(CO_SDObroadcast_t *SDObc){
+    uint16_t blocks = (uint16_t)((SDObc->imageSize + SDObc->blockSize - 1U) / SDObc->blockSize);
+    uint16_t b = SDObc->repairBlock;
+
+    while(b < blocks && !CO_SDObroadcast_blockBad(SDObc, b)){
+        b++;
+    }
+
+    if(b < blocks){
+        CO_SDOclient_return_t ret;
+
+        SDObc->repairBlock = b;
+        while(b < blocks && CO_SDObroadcast_blockBad(SDObc, b)){
+            b++;
+        }
+        SDObc->repairEnd = b;
+
+        CO_setUint32(SDObc->offset, (uint32_t)SDObc->repairBlock * SDObc->blockSize);
+        ret = CO_SDObroadcast_transfer(SDObc, 0, 0, SDObc->nodes[SDObc->node].nodeId,
+                true, SDObc->repairIndex, 2, SDObc->offset, sizeof(SDObc->offset));
+        if(ret == CO_SDOcli_ok_communicationEnd){
+            SDObc->state = CO_SDOBC_OFFSET;
+            return;
+        }
+        CO_SDObroadcast_fail(SDObc, ret, 0);
+    }
+    else if(!SDObc->repaired){
+        /* all blocks equal */
+        SDObc->nodes[SDObc->node].verified = true;
+    }
+    else if(++SDObc->round < CO_SDO_BROADCAST_MAX_ROUNDS){
+        /* verify the repaired node again */
+        CO_SDObroadcast_verify(SDObc);
+        return;
+    }
+    else{
+        CO_SDObroadcast_fail(SDObc, CO_SDOcli_endedWithClientAbort, CO_SDO_AB_GENERAL);
+    }
+
+    SDObc->node++;
+    SDObc->round = 0;
+    CO_SDObroadcast_verify(SDObc);
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_SDObroadcast_init(
+        CO_SDObroadcast_t      *SDObc,
+        CO_SDOclient_t         *SDO_C,
+        uint16_t                SDOtimeoutTime)
+{
+    /* verify arguments */
+    if(SDObc==NULL || SDO_C==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    SDObc->SDO_C = SDO_C;
+    SDObc->SDOtimeoutTime = SDOtimeoutTime;
+    SDObc->image = NULL;
+    SDObc->imageSize = 0;
+    SDObc->nodes = NULL;
+    SDObc->nodeCount = 0;
+    SDObc->state = CO_SDOBC_IDLE;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_SDObroadcast_start(
+        CO_SDObroadcast_t      *SDObc,
+        uint8_t                *image,
+        uint32_t                imageSize,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint16_t                repairIndex,
+        uint32_t                COB_IDClientToServer,
+        CO_SDObroadcastNode_t   nodes[],
+        uint8_t                 nodeCount)
+{
+    uint8_t i;
+    CO_SDOclient_return_t ret;
+
+    /* verify arguments */
+    if(SDObc==NULL || image==NULL || imageSize==0 || nodes==NULL || nodeCount==0 ||
+       SDObc->state != CO_SDOBC_IDLE){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    for(i=0; i<nodeCount; i++){
+        if(nodes[i].nodeId == 0 || nodes[i].nodeId > 127){
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+        nodes[i].verified = false;
+        nodes[i].ret = CO_SDOcli_ok_communicationEnd;
+        nodes[i].abortCode = 0;
+        nodes[i].repairedBlocks = 0;
+    }
+
+    SDObc->image = image;
+    SDObc->imageSize = imageSize;
+    SDObc->index = index;
+    SDObc->subIndex = subIndex;
+    SDObc->repairIndex = repairIndex;
+    SDObc->nodes = nodes;
+    SDObc->nodeCount = nodeCount;
+    SDObc->node = 0;
+    SDObc->round = 0;
+
+    /* responses come from the first node on its default COB-ID */
+    ret = CO_SDObroadcast_transfer(SDObc, COB_IDClientToServer, 0x580UL + nodes[0].nodeId,
+            nodes[0].nodeId, true, index, subIndex, image, imageSize);
+    if(ret == CO_SDOcli_ok_communicationEnd){
+        SDObc->state = CO_SDOBC_BROADCAST;
+    }
+    else{
+        /* nodes are still verified and programmed one by one */
+        CO_SDObroadcast_verify(SDObc);
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+bool_t CO_SDObroadcast_isBusy(CO_SDObroadcast_t *SDObc){
+    return (SDObc != NULL && SDObc->state != CO_SDOBC_IDLE) ? true : false;
+}
+
+
+/******************************************************************************/
+void CO_SDObroadcast_process(
+        CO_SDObroadcast_t      *SDObc,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
+{
+    CO_SDOclient_return_t ret;
+    uint32_t abortCode = 0;
+    uint32_t dataSize = sizeof(SDObc->list);
+
+    if(SDObc == NULL || SDObc->state == CO_SDOBC_IDLE){
+        return;
+    }
+
+    if(SDObc->state == CO_SDOBC_LIST){
+        ret = CO_SDOclientUpload(SDObc->SDO_C, timeDifference_ms,
+                SDObc->SDOtimeoutTime, &dataSize, &abortCode);
+    }
+    else{
+        ret = CO_SDOclientDownload(SDObc->SDO_C, timeDifference_ms,
+                SDObc->SDOtimeoutTime, &abortCode);
+    }
+
+    if(ret > CO_SDOcli_ok_communicationEnd){
+        /* transfer in progress */
+        if(ret == CO_SDOcli_waitingServerResponse){
+            CO_SDOclient_timerNext(SDObc->SDO_C, SDObc->SDOtimeoutTime, timerNext_ms);
+        }
+        else if(timerNext_ms != NULL){
+            *timerNext_ms = 0;
+        }
+        return;
+    }
+    CO_SDOclientClose(SDObc->SDO_C);
+    if(timerNext_ms != NULL){
+        /* next transfer is started, continue with next process call */
+        *timerNext_ms = 0;
+    }
+
+    switch(SDObc->state){
+        case CO_SDOBC_BROADCAST:
+            /* nodes with lost data are repaired by verification */
+            CO_SDObroadcast_verify(SDObc);
+            break;
+
+        case CO_SDOBC_LIST:
+            if(ret != CO_SDOcli_ok_communicationEnd){
+                CO_SDObroadcast_fail(SDObc, ret, abortCode);
+            }
+            else if(dataSize < 6U || CO_getUint32(&SDObc->list[0]) == 0U ||
+                    dataSize < (6U + 2U * (uint32_t)CO_getUint16(&SDObc->list[4]))){
+                /* invalid list */
+                CO_SDObroadcast_fail(SDObc, CO_SDOcli_endedWithClientAbort, CO_SDO_AB_DATA_SHORT);
+            }
+            else{
+                SDObc->blockSize = CO_getUint32(&SDObc->list[0]);
+                SDObc->blockCount = CO_getUint16(&SDObc->list[4]);
+                SDObc->repairBlock = 0;
+                CO_SDObroadcast_repair(SDObc);
+                break;
+            }
+            SDObc->node++;
+            SDObc->round = 0;
+            CO_SDObroadcast_verify(SDObc);
+            break;
+
+        case CO_SDOBC_OFFSET:
+            if(ret == CO_SDOcli_ok_communicationEnd){
+                uint32_t offset = (uint32_t)SDObc->repairBlock * SDObc->blockSize;
+                uint32_t end = (uint32_t)SDObc->repairEnd * SDObc->blockSize;
+
+                if(end > SDObc->imageSize){
+                    end = SDObc->imageSize;
+                }
+                ret = CO_SDObroadcast_transfer(SDObc, 0, 0, SDObc->nodes[SDObc->node].nodeId,
+                        true, SDObc->index, SDObc->subIndex, &SDObc->image[offset], end - offset);
+                if(ret == CO_SDOcli_ok_communicationEnd){
+                    SDObc->state = CO_SDOBC_REPAIR;
+                    break;
+                }
+                abortCode = 0;
+            }
+            CO_SDObroadcast_fail(SDObc, ret, abortCode);
+            SDObc->node++;
+            SDObc->round = 0;
+            CO_SDObroadcast_verify(SDObc);
+            break;
+
+        case CO_SDOBC_REPAIR:
+            if(ret == CO_SDOcli_ok_communicationEnd){
+                SDObc->nodes[SDObc->node].repairedBlocks += SDObc->repairEnd - SDObc->repairBlock;
+                SDObc->repaired = true;
+                SDObc->repairBlock = SDObc->repairEnd;
+                CO_SDObroadcast_repair(SDObc);
+                break;
+            }
+            CO_SDObroadcast_fail(SDObc, ret, abortCode);
+            SDObc->node++;
+            SDObc->round = 0;
+            CO_SDObroadcast_verify(SDObc);
+            break;
+
+        default:
+            SDObc->state = CO_SDOBC_IDLE;
+            break;
+    }
+}
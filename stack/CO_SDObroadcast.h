@@ -0,0 +1,236 @@
+/**
+ * CANopen Service Data Object - broadcast program download.
+ *
+ * @file        CO_SDObroadcast.h
+ * @ingroup     CO_SDObroadcast
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_SDObroadcast_H
+#define CO_SDObroadcast_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_SDObroadcast SDO broadcast program download
+ * @ingroup CO_SDOmaster
+ * @{
+ *
+ * Download of the same image into many identical nodes with one transfer.
+ *
+ * The image is downloaded once by SDO block download on a COB-ID, on which all
+ * target nodes listen (their bootloader is in multicast mode, see CO_program
+ * and the neuberger-bootloader driver). Only the first node of the list
+ * responds, the other nodes receive silently. Then each node is verified one
+ * by one with normal SDO transfers: the list of block CRCs is read from its
+ * repair object and compared with the CRCs of the image. Blocks, which differ
+ * or are missing, are downloaded again with offset, and the node is verified
+ * again, up to #CO_SDO_BROADCAST_MAX_ROUNDS times.
+ *
+ * Without losses the image is transferred once plus a short CRC list per
+ * node, instead of once per node. Bringing the nodes into multicast mode is
+ * left to the application, it must be done before CO_SDObroadcast_start().
+ *
+ * SDO client object used by this object must not be used by the application
+ * during the transfer.
+ */
+
+
+/**
+ * Maximum number of blocks in the CRC list of a node.
+ */
+#ifndef CO_SDO_BROADCAST_MAX_BLOCKS
+#define CO_SDO_BROADCAST_MAX_BLOCKS     512U
+#endif
+
+
+/**
+ * Maximum number of verifications of one node.
+ */
+#ifndef CO_SDO_BROADCAST_MAX_ROUNDS
+#define CO_SDO_BROADCAST_MAX_ROUNDS     3U
+#endif
+
+
+/**
+ * Target node of a broadcast download.
+ *
+ * Array is defined by the application and must be valid until the end of the
+ * transfer.
+ */
+typedef struct{
+    /** Node-ID, set by the application */
+    uint8_t             nodeId;
+    /** True, if all blocks of the node were verified */
+    bool_t              verified;
+    /** Result of the last failed transfer with the node */
+    CO_SDOclient_return_t ret;
+    /** SDO abort code of the last failed transfer with the node */
+    uint32_t            abortCode;
+    /** Number of blocks downloaded again to the node */
+    uint16_t            repairedBlocks;
+}CO_SDObroadcastNode_t;
+
+
+/**
+ * SDO broadcast program download object.
+ */
+typedef struct{
+    /** From CO_SDObroadcast_init() */
+    CO_SDOclient_t     *SDO_C;
+    /** From CO_SDObroadcast_init(), can be changed by application */
+    uint16_t            SDOtimeoutTime;
+    /** From CO_SDObroadcast_start() */
+    uint8_t            *image;
+    /** From CO_SDObroadcast_start() */
+    uint32_t            imageSize;
+    /** From CO_SDObroadcast_start() */
+    uint16_t            index;
+    /** From CO_SDObroadcast_start() */
+    uint8_t             subIndex;
+    /** From CO_SDObroadcast_start() */
+    uint16_t            repairIndex;
+    /** From CO_SDObroadcast_start() */
+    CO_SDObroadcastNode_t *nodes;
+    /** From CO_SDObroadcast_start() */
+    uint8_t             nodeCount;
+    /** Internal state */
+    uint8_t             state;
+    /** Index of the node, which is verified */
+    uint8_t             node;
+    /** Number of verifications of the node */
+    uint8_t             round;
+    /** True, if blocks were repaired since the last verification */
+    bool_t              repaired;
+    /** Block size from the CRC list of the node */
+    uint32_t            blockSize;
+    /** Number of blocks in the CRC list of the node */
+    uint16_t            blockCount;
+    /** First block of the current repair */
+    uint16_t            repairBlock;
+    /** Block after the current repair */
+    uint16_t            repairEnd;
+    /** Offset for the repair object */
+    uint8_t             offset[4];
+    /** CRC list, read from the node */
+    uint8_t             list[6U + 2U * CO_SDO_BROADCAST_MAX_BLOCKS];
+}CO_SDObroadcast_t;
+
+
+/**
+ * Initialize SDO broadcast program download object.
+ *
+ * @param SDObc This object will be initialized.
+ * @param SDO_C SDO client object used for all transfers.
+ * @param SDOtimeoutTime Timeout time for SDO communication in milliseconds.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_SDObroadcast_init(
+        CO_SDObroadcast_t      *SDObc,
+        CO_SDOclient_t         *SDO_C,
+        uint16_t                SDOtimeoutTime);
+
+
+/**
+ * Start broadcast download.
+ *
+ * @param SDObc This object.
+ * @param image Image to be downloaded. Must be valid until the end of the
+ * transfer.
+ * @param imageSize Size of the image in bytes.
+ * @param index Index of program data in the nodes, usually 0x1F50.
+ * @param subIndex Subindex of program data in the nodes, usually 1.
+ * @param repairIndex Index of the repair object in the nodes, see
+ * CO_program_initRepair().
+ * @param COB_IDClientToServer COB-ID, on which all nodes receive the
+ * broadcast download.
+ * @param nodes Array of target nodes. First node responds to the broadcast
+ * download, its SDO server transmits on the default COB-ID. Results are
+ * written into the array.
+ * @param nodeCount Number of target nodes.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_SDObroadcast_start(
+        CO_SDObroadcast_t      *SDObc,
+        uint8_t                *image,
+        uint32_t                imageSize,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint16_t                repairIndex,
+        uint32_t                COB_IDClientToServer,
+        CO_SDObroadcastNode_t   nodes[],
+        uint8_t                 nodeCount);
+
+
+/**
+ * Verify, if broadcast download is in progress.
+ *
+ * @param SDObc This object.
+ *
+ * @return True, until all nodes are verified or failed.
+ */
+bool_t CO_SDObroadcast_isBusy(CO_SDObroadcast_t *SDObc);
+
+
+/**
+ * Process broadcast download.
+ *
+ * Function must be called cyclically.
+ *
+ * @param SDObc This object.
+ * @param timeDifference_ms Time difference from previous function call in [milliseconds].
+ * @param timerNext_ms Return value - info to OS - see CO_process().
+ */
+void CO_SDObroadcast_process(
+        CO_SDObroadcast_t      *SDObc,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
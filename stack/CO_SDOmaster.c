@@ -76,6 +76,10 @@
 #define SCS_UPLOAD_BLOCK                6
 
 
+/* Maximum number of doublings of the adaptive timeout */
+#define CO_SDOCLI_RTT_MAX_BACKOFF       8U
+
+
 /* client states */
 #define SDO_STATE_NOTDEFINED            0
 #define SDO_STATE_ABORT                 1
@@ -89,6 +93,7 @@
 #define SDO_STATE_UPLOAD_INITIATED      20
 #define SDO_STATE_UPLOAD_REQUEST        21
 #define SDO_STATE_UPLOAD_RESPONSE       22
+#define SDO_STATE_UPLOAD_RETRY          23
 
 /* DOWNLOAD BLOCK */
 #define SDO_STATE_BLOCKDOWNLOAD_INITIATE        100
@@ -213,6 +218,10 @@ CO_ReturnError_t CO_SDOclient_init(
     SDO_C->SDOClientPar = SDOClientPar;
 
     SDO_C->pFunctSignal = NULL;
+    SDO_C->cache = NULL;
+    SDO_C->cacheHitSize = 0;
+    SDO_C->rtt = NULL;
+    SDO_C->retriesLeft = 0;
 
     SDO_C->CANdevRx = CANdevRx;
     SDO_C->CANdevRxIdx = CANdevRxIdx;
@@ -240,6 +249,258 @@ void CO_SDOclient_initCallback(
 }
 
 
+/*
+ * Default decision, if object is cacheable, see CO_SDOclientCache_t.
+ */
+static bool_t CO_SDOclientCache_cacheable(uint16_t index, uint8_t subIndex){
+    (void)subIndex;
+    return (index == 0x1000U || (index >= 0x1008U && index <= 0x100AU) ||
+            index == 0x1018U || (index >= 0x1400U && index <= 0x1BFFU)) ? true : false;
+}
+
+
+/*
+ * Find object in the cache.
+ */
+static CO_SDOclientCacheEntry_t *CO_SDOclientCache_find(
+        CO_SDOclientCache_t    *cache,
+        uint8_t                 nodeId,
+        uint16_t                index,
+        uint8_t                 subIndex)
+{
+    uint16_t i;
+
+    for(i=0; i<cache->numberOfEntries; i++){
+        CO_SDOclientCacheEntry_t *entry = &cache->entries[i];
+
+        if(entry->nodeId == nodeId && entry->index == index && entry->subIndex == subIndex){
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+
+/*
+ * Store uploaded object in the cache.
+ */
+static void CO_SDOclientCache_store(
+        CO_SDOclientCache_t    *cache,
+        uint8_t                 nodeId,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        const uint8_t          *data,
+        uint32_t                size)
+{
+    CO_SDOclientCacheEntry_t *entry;
+    uint16_t i;
+
+    if(size == 0U || size > CO_SDOCLI_CACHE_DATA_SIZE){
+        return;
+    }
+
+    /* same object, free entry or the oldest one */
+    entry = CO_SDOclientCache_find(cache, nodeId, index, subIndex);
+    if(entry == NULL){
+        entry = CO_SDOclientCache_find(cache, 0, 0, 0);
+    }
+    if(entry == NULL){
+        entry = &cache->entries[cache->replaceNext];
+        cache->replaceNext++;
+        if(cache->replaceNext >= cache->numberOfEntries){
+            cache->replaceNext = 0;
+        }
+    }
+
+    entry->nodeId = nodeId;
+    entry->index = index;
+    entry->subIndex = subIndex;
+    entry->size = (uint8_t)size;
+    for(i=0; i<size; i++){
+        entry->data[i] = data[i];
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_SDOclientCache_init(
+        CO_SDOclientCache_t    *cache,
+        CO_SDOclientCacheEntry_t entries[],
+        uint16_t                numberOfEntries)
+{
+    /* verify arguments */
+    if(cache==NULL || entries==NULL || numberOfEntries==0){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    cache->entries = entries;
+    cache->numberOfEntries = numberOfEntries;
+    cache->replaceNext = 0;
+    cache->pFunctCacheable = CO_SDOclientCache_cacheable;
+    cache->hitCount = 0;
+    cache->missCount = 0;
+    CO_SDOclientCache_invalidate(cache, 0);
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_SDOclientCache_invalidate(
+        CO_SDOclientCache_t    *cache,
+        uint8_t                 nodeId)
+{
+    uint16_t i;
+
+    if(cache == NULL){
+        return;
+    }
+
+    for(i=0; i<cache->numberOfEntries; i++){
+        CO_SDOclientCacheEntry_t *entry = &cache->entries[i];
+
+        if(nodeId == 0U || entry->nodeId == nodeId){
+            entry->nodeId = 0;
+            entry->index = 0;
+            entry->subIndex = 0;
+        }
+    }
+}
+
+
+/******************************************************************************/
+void CO_SDOclientCache_remoteReset(
+        uint8_t                 nodeId,
+        uint8_t                 idx,
+        void                   *object)
+{
+    (void)idx;
+    if(nodeId != 0U){
+        CO_SDOclientCache_invalidate((CO_SDOclientCache_t*)object, nodeId);
+    }
+}
+
+
+/******************************************************************************/
+void CO_SDOclient_initCache(
+        CO_SDOclient_t         *SDO_C,
+        CO_SDOclientCache_t    *cache)
+{
+    if(SDO_C != NULL){
+        SDO_C->cache = cache;
+        SDO_C->cacheHitSize = 0;
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_SDOclientRtt_init(
+        CO_SDOclientRtt_t      *rtt,
+        uint16_t                minTimeout_ms,
+        uint8_t                 retries)
+{
+    if(rtt == NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    CO_SDOclientRtt_reset(rtt, 0);
+    rtt->minTimeout_ms = minTimeout_ms;
+    rtt->retries = retries;
+    rtt->timeoutCount = 0;
+    rtt->retryCount = 0;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_SDOclientRtt_reset(
+        CO_SDOclientRtt_t      *rtt,
+        uint8_t                 nodeId)
+{
+    uint16_t i;
+
+    if(rtt == NULL || nodeId > 127U){
+        return;
+    }
+
+    for(i=0; i<128U; i++){
+        if(nodeId == 0U || i == nodeId){
+            rtt->nodes[i].srtt = 0;
+            rtt->nodes[i].rttvar = 0;
+            rtt->nodes[i].samples = 0;
+            rtt->nodes[i].backoff = 0;
+        }
+    }
+}
+
+
+/******************************************************************************/
+uint16_t CO_SDOclientRtt_getTimeout(
+        const CO_SDOclientRtt_t *rtt,
+        uint8_t                 nodeId,
+        uint16_t                SDOtimeoutTime)
+{
+    const CO_SDOclientRttEntry_t *entry;
+    const CO_SDOclientRttEntry_t *estimate;
+    uint32_t timeout;
+
+    if(rtt == NULL || nodeId == 0U || nodeId > 127U){
+        return SDOtimeoutTime;
+    }
+
+    /* node without own samples uses the estimate of all nodes */
+    entry = &rtt->nodes[nodeId];
+    estimate = (entry->samples != 0U) ? entry : &rtt->nodes[0];
+    if(estimate->samples == 0U){
+        return SDOtimeoutTime;
+    }
+
+    timeout = estimate->srtt / 8U + estimate->rttvar;
+    if(timeout < rtt->minTimeout_ms){
+        timeout = rtt->minTimeout_ms;
+    }
+    timeout <<= entry->backoff;
+
+    return (timeout < SDOtimeoutTime) ? (uint16_t)timeout : SDOtimeoutTime;
+}
+
+
+/*
+ * Add round-trip time sample to the estimate, see RFC 6298.
+ * srtt is scaled by 8, rttvar by 4.
+ */
+static void CO_SDOclientRtt_update(CO_SDOclientRttEntry_t *entry, uint32_t rtt_ms){
+    if(entry->samples == 0U){
+        entry->srtt = rtt_ms * 8U;
+        entry->rttvar = rtt_ms * 2U;
+    }
+    else{
+        uint32_t srtt = entry->srtt / 8U;
+        uint32_t delta = (rtt_ms > srtt) ? (rtt_ms - srtt) : (srtt - rtt_ms);
+
+        entry->srtt = entry->srtt - entry->srtt / 8U + rtt_ms;
+        entry->rttvar = entry->rttvar - entry->rttvar / 4U + delta;
+    }
+    if(entry->samples < 0xFFFFU){
+        entry->samples++;
+    }
+    entry->backoff = 0;
+}
+
+
+/******************************************************************************/
+void CO_SDOclient_initRtt(
+        CO_SDOclient_t         *SDO_C,
+        CO_SDOclientRtt_t      *rtt)
+{
+    if(SDO_C != NULL){
+        SDO_C->rtt = rtt;
+        SDO_C->retriesLeft = 0;
+    }
+}
+
+
 /******************************************************************************/
 CO_SDOclient_return_t CO_SDOclient_setup(
         CO_SDOclient_t         *SDO_C,
@@ -325,6 +586,79 @@ static void CO_SDOclient_abort(CO_SDOclient_t *SDO_C, uint32_t code){
 }
 
 
+#ifdef CO_SDO_BLOCK_TUNING
+/******************************************************************************/
+static void CO_SDOclient_transferRate(CO_SDOclient_t *SDO_C, uint32_t dataSize){
+    uint32_t time_ms = (SDO_C->transferTime_ms != 0U) ? SDO_C->transferTime_ms : 1U;
+
+    SDO_C->transferRate = (uint32_t)(((uint64_t)dataSize * 1000U) / time_ms);
+}
+#endif
+
+
+/*
+ * True, if the client waits for a single response, which is measured and
+ * waited for with the adaptive timeout. Responses after a write into the object
+ * dictionary of the server and sub-blocks are not.
+ */
+static bool_t CO_SDOclient_rttMeasured(const CO_SDOclient_t *SDO_C){
+    switch(SDO_C->state){
+        case SDO_STATE_DOWNLOAD_INITIATE:
+            return SDO_C->bufferSize > 4U;
+        case SDO_STATE_DOWNLOAD_RESPONSE:
+            return SDO_C->bufferOffset < SDO_C->bufferSize;
+        case SDO_STATE_BLOCKDOWNLOAD_INITIATE:
+        case SDO_STATE_UPLOAD_INITIATED:
+        case SDO_STATE_UPLOAD_RESPONSE:
+        case SDO_STATE_BLOCKUPLOAD_INITIATE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+/* Timeout for the response, the client currently waits for */
+static uint16_t CO_SDOclient_timeout(const CO_SDOclient_t *SDO_C, uint16_t SDOtimeoutTime){
+    if(SDO_C->rtt == NULL || !CO_SDOclient_rttMeasured(SDO_C)){
+        return SDOtimeoutTime;
+    }
+    return CO_SDOclientRtt_getTimeout(SDO_C->rtt,
+            SDO_C->SDOClientPar->nodeIDOfTheSDOServer, SDOtimeoutTime);
+}
+
+
+/* Measure round-trip time of the received response */
+static void CO_SDOclient_rttSample(CO_SDOclient_t *SDO_C, uint16_t timeDifference_ms){
+    uint8_t nodeId = SDO_C->SDOClientPar->nodeIDOfTheSDOServer;
+    uint32_t rtt_ms;
+
+    if(SDO_C->rtt == NULL || nodeId == 0U || nodeId > 127U || !CO_SDOclient_rttMeasured(SDO_C)){
+        return;
+    }
+
+    /* timeoutTimer is not yet incremented by this call */
+    rtt_ms = (uint32_t)SDO_C->timeoutTimer + timeDifference_ms;
+    CO_SDOclientRtt_update(&SDO_C->rtt->nodes[nodeId], rtt_ms);
+    CO_SDOclientRtt_update(&SDO_C->rtt->nodes[0], rtt_ms);
+}
+
+
+/* Adaptive timeout expired, double it for the next request */
+static void CO_SDOclient_rttTimeout(CO_SDOclient_t *SDO_C, uint16_t timeout, uint16_t SDOtimeoutTime){
+    uint8_t nodeId = SDO_C->SDOClientPar->nodeIDOfTheSDOServer;
+
+    if(SDO_C->rtt == NULL || nodeId == 0U || nodeId > 127U || timeout >= SDOtimeoutTime){
+        return;
+    }
+
+    if(SDO_C->rtt->nodes[nodeId].backoff < CO_SDOCLI_RTT_MAX_BACKOFF){
+        SDO_C->rtt->nodes[nodeId].backoff++;
+    }
+    SDO_C->rtt->timeoutCount++;
+}
+
+
 /******************************************************************************/
 static void CO_SDOTxBufferClear(CO_SDOclient_t *SDO_C) {
     uint16_t i;
@@ -360,6 +694,18 @@ CO_SDOclient_return_t CO_SDOclientDownloadInitiate(
     SDO_C->bufferSize = dataSize;
 
     SDO_C->state = SDO_STATE_DOWNLOAD_INITIATE;
+    SDO_C->cacheHitSize = 0;
+
+    /* object may change, remove it from the cache */
+    if(SDO_C->cache != NULL){
+        CO_SDOclientCacheEntry_t *entry = CO_SDOclientCache_find(SDO_C->cache,
+                SDO_C->SDOClientPar->nodeIDOfTheSDOServer, index, subIndex);
+        if(entry != NULL){
+            entry->nodeId = 0;
+            entry->index = 0;
+            entry->subIndex = 0;
+        }
+    }
 
     /* prepare CAN tx message */
     CO_SDOTxBufferClear(SDO_C);
@@ -418,6 +764,9 @@ CO_SDOclient_return_t CO_SDOclientDownloadInitiate(
     /* empty receive buffer, reset timeout timer and send message */
     CLEAR_CANrxNew(SDO_C->CANrxNew);
     SDO_C->timeoutTimer = 0;
+#ifdef CO_SDO_BLOCK_TUNING
+    SDO_C->transferTime_ms = 0U;
+#endif
     CO_CANsend(SDO_C->CANdevTx, SDO_C->CANtxBuff);
 
     return CO_SDOcli_ok_communicationEnd;
@@ -432,6 +781,7 @@ CO_SDOclient_return_t CO_SDOclientDownload(
         uint32_t               *pSDOabortCode)
 {
     CO_SDOclient_return_t ret = CO_SDOcli_waitingServerResponse;
+    uint16_t timeout;
 
     /* verify parameters */
     if(SDO_C == NULL) {
@@ -482,6 +832,8 @@ CO_SDOclient_return_t CO_SDOclientDownload(
             return CO_SDOcli_endedWithServerAbort;
         }
 
+        CO_SDOclient_rttSample(SDO_C, timeDifference_ms);
+
         switch (SDO_C->state){
 
             case SDO_STATE_DOWNLOAD_INITIATE:{
@@ -609,6 +961,9 @@ CO_SDOclient_return_t CO_SDOclientDownload(
                         break;
                     }
                     /*  SDO block download successfully transferred */
+#ifdef CO_SDO_BLOCK_TUNING
+                    CO_SDOclient_transferRate(SDO_C, SDO_C->bufferSize);
+#endif
                     SDO_C->state = SDO_STATE_NOTDEFINED;
                     SDO_C->timeoutTimer = 0;
                     CLEAR_CANrxNew(SDO_C->CANrxNew);
@@ -632,10 +987,15 @@ CO_SDOclient_return_t CO_SDOclientDownload(
     }
 
 /*  TMO *********************************************************************************************** */
-    if(SDO_C->timeoutTimer < SDOtimeoutTime){
+#ifdef CO_SDO_BLOCK_TUNING
+    SDO_C->transferTime_ms += timeDifference_ms;
+#endif
+    timeout = CO_SDOclient_timeout(SDO_C, SDOtimeoutTime);
+    if(SDO_C->timeoutTimer < timeout){
         SDO_C->timeoutTimer += timeDifference_ms;
     }
-    if(SDO_C->timeoutTimer >= SDOtimeoutTime){ /*  communication TMO */
+    if(SDO_C->timeoutTimer >= timeout){ /*  communication TMO */
+        CO_SDOclient_rttTimeout(SDO_C, timeout, SDOtimeoutTime);
         *pSDOabortCode = CO_SDO_AB_TIMEOUT;
         CO_SDOclient_abort(SDO_C, *pSDOabortCode);
         return CO_SDOcli_endedWithTimeout;
@@ -771,6 +1131,8 @@ CO_SDOclient_return_t CO_SDOclientUploadInitiate(
     /* save parameters */
     SDO_C->buffer = dataRx;
     SDO_C->bufferSize = dataRxSize;
+    SDO_C->blockEnable = blockEnable;
+    SDO_C->retriesLeft = (SDO_C->rtt != NULL) ? SDO_C->rtt->retries : 0U;
 
     /* prepare CAN tx message */
     CO_SDOTxBufferClear(SDO_C);
@@ -782,6 +1144,32 @@ CO_SDOclient_return_t CO_SDOclientUploadInitiate(
     SDO_C->CANtxBuff->data[2] = index >> 8;
     SDO_C->CANtxBuff->data[3] = subIndex;
 
+    /* answer from the cache, if object is there */
+    SDO_C->cacheHitSize = 0;
+    if(SDO_C->cache != NULL && SDO_C->SDOClientPar->nodeIDOfTheSDOServer != SDO_C->SDO->nodeId &&
+       SDO_C->cache->pFunctCacheable(index, subIndex))
+    {
+        CO_SDOclientCacheEntry_t *entry = CO_SDOclientCache_find(SDO_C->cache,
+                SDO_C->SDOClientPar->nodeIDOfTheSDOServer, index, subIndex);
+
+        if(entry != NULL && entry->size <= dataRxSize){
+            uint8_t i;
+            for(i=0; i<entry->size; i++){
+                dataRx[i] = entry->data[i];
+            }
+            SDO_C->cacheHitSize = entry->size;
+            SDO_C->state = SDO_STATE_NOTDEFINED;
+            SDO_C->cache->hitCount++;
+
+            /* Optional signal to RTOS. We can immediately continue SDO Client */
+            if(SDO_C->pFunctSignal != NULL) {
+                SDO_C->pFunctSignal();
+            }
+            return CO_SDOcli_ok_communicationEnd;
+        }
+        SDO_C->cache->missCount++;
+    }
+
 
     if(blockEnable == 0){
         SDO_C->state = SDO_STATE_UPLOAD_INITIATED;
@@ -804,6 +1192,9 @@ CO_SDOclient_return_t CO_SDOclientUploadInitiate(
 
         SDO_C->CANtxBuff->data[4] = SDO_C->block_blksize;
         SDO_C->CANtxBuff->data[5] = SDO_C->pst;
+#ifdef CO_SDO_BLOCK_TUNING
+        SDO_C->block_size_adapt = SDO_C->block_size_max;
+#endif
 
 
         SDO_C->block_seqno = 0;
@@ -824,14 +1215,19 @@ CO_SDOclient_return_t CO_SDOclientUploadInitiate(
     CLEAR_CANrxNew(SDO_C->CANrxNew);
     SDO_C->timeoutTimer = 0;
     SDO_C->timeoutTimerBLOCK =0;
+#ifdef CO_SDO_BLOCK_TUNING
+    SDO_C->transferTime_ms = 0U;
+#endif
     CO_CANsend(SDO_C->CANdevTx, SDO_C->CANtxBuff);
 
     return CO_SDOcli_ok_communicationEnd;
 }
 
 
-/******************************************************************************/
-CO_SDOclient_return_t CO_SDOclientUpload(
+/*
+ * Process SDO upload communication without the cache, see CO_SDOclientUpload().
+ */
+static CO_SDOclient_return_t CO_SDOclientUploadTransfer(
         CO_SDOclient_t         *SDO_C,
         uint16_t                timeDifference_ms,
         uint16_t                SDOtimeoutTime,
@@ -840,6 +1236,7 @@ CO_SDOclient_return_t CO_SDOclientUpload(
 {
     uint16_t indexTmp;
     uint32_t tmp32;
+    uint16_t timeout;
     CO_SDOclient_return_t ret = CO_SDOcli_waitingServerResponse;
 
     /* verify parameters */
@@ -902,6 +1299,9 @@ CO_SDOclient_return_t CO_SDOclientUpload(
             CO_memcpySwap4(pSDOabortCode , &SDO_C->CANrxData[4]);
             return CO_SDOcli_endedWithServerAbort;
         }
+
+        CO_SDOclient_rttSample(SDO_C, timeDifference_ms);
+
         switch (SDO_C->state){
             case SDO_STATE_UPLOAD_INITIATED:{
 
@@ -1125,12 +1525,17 @@ CO_SDOclient_return_t CO_SDOclientUpload(
     }
 
 /*  TMO *************************************************************************************************** */
-    if(SDO_C->timeoutTimer < SDOtimeoutTime){
+#ifdef CO_SDO_BLOCK_TUNING
+    SDO_C->transferTime_ms += timeDifference_ms;
+#endif
+    timeout = CO_SDOclient_timeout(SDO_C, SDOtimeoutTime);
+    if(SDO_C->timeoutTimer < timeout){
         SDO_C->timeoutTimer += timeDifference_ms;
         if (SDO_C->state == SDO_STATE_BLOCKUPLOAD_INPROGRES)
             SDO_C->timeoutTimerBLOCK += timeDifference_ms;
     }
-    if(SDO_C->timeoutTimer >= SDOtimeoutTime){ /*  communication TMO */
+    if(SDO_C->timeoutTimer >= timeout){ /*  communication TMO */
+        CO_SDOclient_rttTimeout(SDO_C, timeout, SDOtimeoutTime);
         *pSDOabortCode = CO_SDO_AB_TIMEOUT;
         CO_SDOclient_abort(SDO_C, *pSDOabortCode);
         return CO_SDOcli_endedWithTimeout;
@@ -1198,6 +1603,17 @@ CO_SDOclient_return_t CO_SDOclientUpload(
             SDO_C->CANtxBuff->data[0] = (CCS_UPLOAD_BLOCK<<5) | 0x02;
             SDO_C->CANtxBuff->data[1] = SDO_C->block_seqno;
 
+#ifdef CO_SDO_BLOCK_TUNING
+            /* halve block size after lost segments, double it after complete block */
+            if(SDO_C->block_seqno < SDO_C->block_blksize){
+                SDO_C->block_size_adapt = (SDO_C->block_size_adapt > 1U) ? (SDO_C->block_size_adapt / 2U) : 1U;
+            }
+            else if(SDO_C->block_size_adapt < SDO_C->block_size_max){
+                SDO_C->block_size_adapt = (SDO_C->block_size_adapt < (SDO_C->block_size_max / 2U)) ?
+                        (SDO_C->block_size_adapt * 2U) : SDO_C->block_size_max;
+            }
+#endif
+
             /*  set next block size */
             if (SDO_C->dataSize != 0){
                 if(SDO_C->dataSizeTransfered >= SDO_C->dataSize){
@@ -1206,9 +1622,15 @@ CO_SDOclient_return_t CO_SDOclientUpload(
                 }
                 else{
                     tmp32 = ((SDO_C->dataSize - SDO_C->dataSizeTransfered) / 7);
+#ifdef CO_SDO_BLOCK_TUNING
+                    if(tmp32 >= SDO_C->block_size_adapt){
+                        SDO_C->block_blksize = SDO_C->block_size_adapt;
+                    }
+#else
                     if(tmp32 >= SDO_C->block_size_max){
                         SDO_C->block_blksize = SDO_C->block_size_max;
                     }
+#endif
                     else{
                         if((SDO_C->dataSize - SDO_C->dataSizeTransfered) % 7 == 0)
                             SDO_C->block_blksize = tmp32;
@@ -1221,6 +1643,9 @@ CO_SDOclient_return_t CO_SDOclientUpload(
                 }
             }
             else{
+#ifdef CO_SDO_BLOCK_TUNING
+                SDO_C->block_blksize = SDO_C->block_size_adapt;
+#endif
                 SDO_C->block_seqno = 0;
                 SDO_C->timeoutTimerBLOCK = 0;
 
@@ -1238,6 +1663,9 @@ CO_SDOclient_return_t CO_SDOclientUpload(
             CO_CANsend(SDO_C->CANdevTx, SDO_C->CANtxBuff);
 
             *pDataSize = SDO_C->dataSizeTransfered;
+#ifdef CO_SDO_BLOCK_TUNING
+            CO_SDOclient_transferRate(SDO_C, SDO_C->dataSizeTransfered);
+#endif
 
             SDO_C->state = SDO_STATE_NOTDEFINED;
 
@@ -1257,6 +1685,99 @@ CO_SDOclient_return_t CO_SDOclientUpload(
 }
 
 
+/******************************************************************************/
+CO_SDOclient_return_t CO_SDOclientUpload(
+        CO_SDOclient_t         *SDO_C,
+        uint16_t                timeDifference_ms,
+        uint16_t                SDOtimeoutTime,
+        uint32_t               *pDataSize,
+        uint32_t               *pSDOabortCode)
+{
+    CO_SDOclient_return_t ret;
+
+    /* verify parameters */
+    if(SDO_C == NULL) {
+        return CO_SDOcli_wrongArguments;
+    }
+
+    /* object was copied from the cache */
+    if(SDO_C->cacheHitSize != 0U){
+        *pSDOabortCode = CO_SDO_AB_NONE;
+        *pDataSize = SDO_C->cacheHitSize;
+        SDO_C->cacheHitSize = 0;
+        return CO_SDOcli_ok_communicationEnd;
+    }
+
+    /* repeat upload after timeout, abort message must be sent first */
+    if(SDO_C->state == SDO_STATE_UPLOAD_RETRY){
+        uint8_t retriesLeft = SDO_C->retriesLeft;
+
+        *pSDOabortCode = CO_SDO_AB_NONE;
+        if(SDO_C->CANtxBuff->bufferFull){
+            return CO_SDOcli_transmittBufferFull;
+        }
+        SDO_C->rtt->retryCount++;
+        (void)CO_SDOclientUploadInitiate(SDO_C, SDO_C->index, SDO_C->subIndex,
+                SDO_C->buffer, SDO_C->bufferSize, SDO_C->blockEnable);
+        SDO_C->retriesLeft = retriesLeft;
+        return CO_SDOcli_waitingServerResponse;
+    }
+
+    ret = CO_SDOclientUploadTransfer(SDO_C, timeDifference_ms, SDOtimeoutTime,
+            pDataSize, pSDOabortCode);
+
+    if(ret == CO_SDOcli_endedWithTimeout && SDO_C->retriesLeft > 0U && SDO_C->rtt != NULL){
+        SDO_C->retriesLeft--;
+        SDO_C->state = SDO_STATE_UPLOAD_RETRY;
+        *pSDOabortCode = CO_SDO_AB_NONE;
+        return CO_SDOcli_transmittBufferFull;
+    }
+
+    if(ret == CO_SDOcli_ok_communicationEnd && SDO_C->cache != NULL &&
+       SDO_C->SDOClientPar->nodeIDOfTheSDOServer != SDO_C->SDO->nodeId &&
+       SDO_C->cache->pFunctCacheable(SDO_C->index, SDO_C->subIndex))
+    {
+        CO_SDOclientCache_store(SDO_C->cache, SDO_C->SDOClientPar->nodeIDOfTheSDOServer,
+                SDO_C->index, SDO_C->subIndex, SDO_C->buffer, *pDataSize);
+    }
+
+    return ret;
+}
+
+
+/******************************************************************************/
+void CO_SDOclient_timerNext(
+        CO_SDOclient_t         *SDO_C,
+        uint16_t                SDOtimeoutTime,
+        uint16_t               *timerNext_ms)
+{
+    uint16_t diff;
+    uint16_t timeout;
+
+    if(SDO_C == NULL || timerNext_ms == NULL || SDO_C->state == SDO_STATE_NOTDEFINED){
+        return;
+    }
+
+    timeout = CO_SDOclient_timeout(SDO_C, SDOtimeoutTime);
+    if(SDO_C->timeoutTimer >= timeout){
+        return;
+    }
+
+    diff = timeout - SDO_C->timeoutTimer;
+    if(SDO_C->state == SDO_STATE_BLOCKUPLOAD_INPROGRES){
+        uint16_t diffBlock = (SDO_C->timeoutTimerBLOCK < (SDOtimeoutTime/2)) ?
+                             ((SDOtimeoutTime/2) - SDO_C->timeoutTimerBLOCK) : 0U;
+
+        if(diff > diffBlock){
+            diff = diffBlock;
+        }
+    }
+    if(*timerNext_ms > diff){
+        *timerNext_ms = diff;
+    }
+}
+
+
 /******************************************************************************/
 void CO_SDOclientClose(CO_SDOclient_t *SDO_C){
     if(SDO_C != NULL) {
@@ -109,6 +109,111 @@ typedef struct{
 }CO_SDOclientPar_t;
 
 
+/**
+ * Size of data in one entry of CO_SDOclientCache_t. Larger objects are not
+ * cached.
+ */
+#ifndef CO_SDOCLI_CACHE_DATA_SIZE
+#define CO_SDOCLI_CACHE_DATA_SIZE       16U
+#endif
+
+
+/**
+ * One object in CO_SDOclientCache_t.
+ */
+typedef struct{
+    /** Node-ID of the SDO server, 0 if entry is free */
+    uint8_t             nodeId;
+    /** Subindex of the object */
+    uint8_t             subIndex;
+    /** Index of the object */
+    uint16_t            index;
+    /** Size of data */
+    uint8_t             size;
+    /** Data of the object */
+    uint8_t             data[CO_SDOCLI_CACHE_DATA_SIZE];
+}CO_SDOclientCacheEntry_t;
+
+
+/**
+ * Read-through cache of constant objects of remote nodes.
+ *
+ * Cache may be shared by all SDO client objects, see CO_SDOclient_initCache().
+ * Successful uploads of cacheable objects are stored in the cache, next
+ * upload of the same object from the same node is answered from the cache
+ * without CAN communication. Object is removed from the cache, when it is
+ * downloaded by any SDO client object, which uses the cache. All objects of a
+ * node are removed on its bootup, see CO_SDOclientCache_remoteReset(). Objects
+ * of this node are never cached.
+ */
+typedef struct{
+    /** From CO_SDOclientCache_init() */
+    CO_SDOclientCacheEntry_t *entries;
+    /** From CO_SDOclientCache_init() */
+    uint16_t            numberOfEntries;
+    /** Entry, which is replaced next, if cache is full */
+    uint16_t            replaceNext;
+    /** Function, which decides if object is cacheable. Set to default in
+    CO_SDOclientCache_init(): 0x1000, 0x1008..0x100A, 0x1018 and PDO
+    parameters 0x1400..0x1BFF. Can be changed by application. */
+    bool_t            (*pFunctCacheable)(uint16_t index, uint8_t subIndex);
+    /** Number of uploads answered from the cache */
+    uint32_t            hitCount;
+    /** Number of uploads of cacheable objects, which were not in the cache */
+    uint32_t            missCount;
+}CO_SDOclientCache_t;
+
+
+/**
+ * Round-trip time estimate of one SDO server, see CO_SDOclientRtt_t.
+ */
+typedef struct{
+    /** Smoothed round-trip time in 1/8 milliseconds */
+    uint32_t            srtt;
+    /** Round-trip time variation in 1/4 milliseconds */
+    uint32_t            rttvar;
+    /** Number of samples, saturated at 0xFFFF. 0 if no estimate yet */
+    uint16_t            samples;
+    /** Timeout is doubled this many times after timeouts, reset by next sample */
+    uint8_t             backoff;
+}CO_SDOclientRttEntry_t;
+
+
+/**
+ * Round-trip time estimator for adaptive SDO client timeouts.
+ *
+ * Estimator may be shared by all SDO client objects, see
+ * CO_SDOclient_initRtt(). The time from a request until the response of the
+ * server is measured for each node, and the timeout of the SDO client is
+ * calculated like the TCP retransmission timeout: srtt + 4 * rttvar, but not
+ * below minTimeout_ms. The timeout is doubled after each timeout of a node. The
+ * SDOtimeoutTime argument of CO_SDOclientDownload() and CO_SDOclientUpload() is
+ * the upper limit and it is used for nodes without estimate. Nodes without own
+ * samples use the estimate of all nodes, if available.
+ *
+ * Responses, which follow a write into the object dictionary of the server
+ * (expedited download, last segment and end of block download), may take much
+ * longer. They are not measured and are always waited for with SDOtimeoutTime.
+ * The same applies to the sub-blocks of a block upload.
+ *
+ * Uploads do not change the server, so they are repeated up to _retries_ times
+ * after a timeout. Timeout and retry are reported by timeoutCount and
+ * retryCount; the application sees only the final result.
+ */
+typedef struct{
+    /** Estimates by node-ID 1..127, index 0 holds the estimate of all nodes */
+    CO_SDOclientRttEntry_t nodes[128];
+    /** From CO_SDOclientRtt_init(), can be changed by application */
+    uint16_t            minTimeout_ms;
+    /** From CO_SDOclientRtt_init(), can be changed by application */
+    uint8_t             retries;
+    /** Number of timeouts with adaptive timeout */
+    uint32_t            timeoutCount;
+    /** Number of repeated uploads */
+    uint32_t            retryCount;
+}CO_SDOclientRtt_t;
+
+
 /**
  * SDO client object
  */
@@ -169,6 +274,15 @@ typedef struct{
     uint8_t             block_seqno;
     /** Block size in current transfer */
     uint8_t             block_blksize;
+#ifdef CO_SDO_BLOCK_TUNING
+    /** Upper limit for block_blksize by block upload, adapted to lost
+    segments between 1 and block_size_max. See #CO_SDO_BLOCK_TUNING. */
+    uint8_t             block_size_adapt;
+    /** Duration of the current transfer in milliseconds */
+    uint32_t            transferTime_ms;
+    /** Data rate of the last successful block transfer in bytes per second */
+    uint32_t            transferRate;
+#endif
     /** Number of bytes in last segment that do not contain data */
     uint8_t             block_noData;
     /** Server CRC support in block transfer */
@@ -177,6 +291,17 @@ typedef struct{
     uint32_t            COB_IDClientToServerPrev;
     /** Previous value of the COB_IDServerToClient */
     uint32_t            COB_IDServerToClientPrev;
+    /** From CO_SDOclient_initCache() or NULL */
+    CO_SDOclientCache_t *cache;
+    /** Size of data, copied from the cache by CO_SDOclientUploadInitiate(),
+    0 if upload is not answered from the cache */
+    uint8_t             cacheHitSize;
+    /** From CO_SDOclient_initRtt() or NULL */
+    CO_SDOclientRtt_t  *rtt;
+    /** Remaining repetitions of the current upload */
+    uint8_t             retriesLeft;
+    /** blockEnable of the current upload, for repetition */
+    uint8_t             blockEnable;
 
 }CO_SDOclient_t;
 
@@ -223,6 +348,112 @@ void CO_SDOclient_initCallback(
         void                  (*pFunctSignal)(void));
 
 
+/**
+ * Initialize read-through cache of constant objects.
+ *
+ * @param cache This object will be initialized.
+ * @param entries Externally defined array of cache entries.
+ * @param numberOfEntries Size of the above array.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_SDOclientCache_init(
+        CO_SDOclientCache_t    *cache,
+        CO_SDOclientCacheEntry_t entries[],
+        uint16_t                numberOfEntries);
+
+
+/**
+ * Remove objects of a node from the cache.
+ *
+ * @param cache This object.
+ * @param nodeId Node-ID of the SDO server or 0 for all nodes.
+ */
+void CO_SDOclientCache_invalidate(
+        CO_SDOclientCache_t    *cache,
+        uint8_t                 nodeId);
+
+
+/**
+ * Remove objects of a node from the cache on its bootup.
+ *
+ * Function has the signature of Heartbeat consumer callbacks, it may be set
+ * with CO_HBconsumer_initCallbackRemoteReset() for each monitored node,
+ * object is the cache.
+ *
+ * @param nodeId Node-ID of the node, which has sent bootup message.
+ * @param idx Index of the node in Heartbeat consumer, not used.
+ * @param object Pointer to CO_SDOclientCache_t.
+ */
+void CO_SDOclientCache_remoteReset(
+        uint8_t                 nodeId,
+        uint8_t                 idx,
+        void                   *object);
+
+
+/**
+ * Use read-through cache for SDO client object.
+ *
+ * @param SDO_C This object.
+ * @param cache Cache object or NULL, if cache is not used.
+ */
+void CO_SDOclient_initCache(
+        CO_SDOclient_t         *SDO_C,
+        CO_SDOclientCache_t    *cache);
+
+
+/**
+ * Initialize round-trip time estimator.
+ *
+ * @param rtt This object will be initialized.
+ * @param minTimeout_ms Lower limit for the adaptive timeout.
+ * @param retries Number of repetitions of an upload after timeout.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_SDOclientRtt_init(
+        CO_SDOclientRtt_t      *rtt,
+        uint16_t                minTimeout_ms,
+        uint8_t                 retries);
+
+
+/**
+ * Forget the estimate of a node, for example if it was replaced.
+ *
+ * @param rtt This object.
+ * @param nodeId Node-ID of the SDO server or 0 for all nodes.
+ */
+void CO_SDOclientRtt_reset(
+        CO_SDOclientRtt_t      *rtt,
+        uint8_t                 nodeId);
+
+
+/**
+ * Get the adaptive timeout for a node.
+ *
+ * @param rtt This object.
+ * @param nodeId Node-ID of the SDO server.
+ * @param SDOtimeoutTime Upper limit in milliseconds.
+ *
+ * @return Timeout in milliseconds, SDOtimeoutTime if there is no estimate.
+ */
+uint16_t CO_SDOclientRtt_getTimeout(
+        const CO_SDOclientRtt_t *rtt,
+        uint8_t                 nodeId,
+        uint16_t                SDOtimeoutTime);
+
+
+/**
+ * Use round-trip time estimator for SDO client object.
+ *
+ * @param SDO_C This object.
+ * @param rtt Estimator or NULL, if fixed timeout is used.
+ */
+void CO_SDOclient_initRtt(
+        CO_SDOclient_t         *SDO_C,
+        CO_SDOclientRtt_t      *rtt);
+
+
 /**
  * Setup SDO client object.
  *
@@ -289,6 +520,7 @@ CO_SDOclient_return_t CO_SDOclientDownloadInitiate(
  * @param SDO_C This object.
  * @param timeDifference_ms Time difference from previous function call in [milliseconds].
  * @param SDOtimeoutTime Timeout time for SDO communication in milliseconds.
+ * Upper limit, if round-trip time estimator is used, see CO_SDOclientRtt_t.
  * @param pSDOabortCode Pointer to external variable written by this function
  * in case of error in communication.
  *
@@ -306,7 +538,9 @@ CO_SDOclient_return_t CO_SDOclientDownload(
  *
  * Function initiates SDO upload communication with server specified in
  * CO_SDOclient_init() function. Data will be read from remote node.
- * Function is non-blocking.
+ * Function is non-blocking. If object is in the cache of this SDO client
+ * object, no message is sent and next CO_SDOclientUpload() call ends the
+ * communication.
  *
  * @param SDO_C This object.
  * @param index Index of object in object dictionary in remote node.
@@ -339,6 +573,8 @@ CO_SDOclient_return_t CO_SDOclientUploadInitiate(
  * @param SDO_C This object.
  * @param timeDifference_ms Time difference from previous function call in [milliseconds].
  * @param SDOtimeoutTime Timeout time for SDO communication in milliseconds.
+ * Upper limit, if round-trip time estimator is used, see CO_SDOclientRtt_t.
+ * After a timeout the upload may be repeated, see CO_SDOclientRtt_t::retries.
  * @param pDataSize pointer to external variable, where size of received
  * data will be written.
  * @param pSDOabortCode Pointer to external variable written by this function
@@ -354,6 +590,23 @@ CO_SDOclient_return_t CO_SDOclientUpload(
         uint32_t               *pSDOabortCode);
 
 
+/**
+ * Lower OS sleep time to the timeout of a running transfer.
+ *
+ * To be called after CO_SDOclientDownload() or CO_SDOclientUpload() returned
+ * #CO_SDOcli_waitingServerResponse. The response of the server wakes up the
+ * OS anyway, so only the timeout must be scheduled.
+ *
+ * @param SDO_C This object.
+ * @param SDOtimeoutTime Same as for CO_SDOclientDownload() or CO_SDOclientUpload().
+ * @param timerNext_ms Info to OS, see CO_process(). Ignored if NULL.
+ */
+void CO_SDOclient_timerNext(
+        CO_SDOclient_t         *SDO_C,
+        uint16_t                SDOtimeoutTime,
+        uint16_t               *timerNext_ms);
+
+
 /**
  * Close SDO communication temporary.
  *
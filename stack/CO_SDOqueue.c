@@ -0,0 +1,339 @@
+/*
+ * CANopen Service Data Object - client request queue.
+ *
+ * @file        CO_SDOqueue.c
+ * @ingroup     CO_SDOqueue
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_SDOmaster.h"
+#include "CO_SDOqueue.h"
+
+
+/*
+ * Verify, if a job for the node is active on any channel.
+ */
+static bool_t CO_SDOqueue_nodeBusy(CO_SDOqueue_t *SDOqueue, uint8_t nodeId){
+    uint8_t i;
+
+    for(i=0; i<SDOqueue->numberOfChannels; i++){
+        if(SDOqueue->activeJobs[i] != NULL && SDOqueue->activeJobs[i]->nodeId == nodeId){
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/*
+ * Take first pending job, whose node is not busy, out of the queue.
+ */
+static CO_SDOqueueJob_t *CO_SDOqueue_take(CO_SDOqueue_t *SDOqueue){
+    CO_SDOqueueJob_t *prev = NULL;
+    CO_SDOqueueJob_t *job = SDOqueue->head;
+
+    while(job != NULL){
+        if(!CO_SDOqueue_nodeBusy(SDOqueue, job->nodeId)){
+            if(prev == NULL){
+                SDOqueue->head = job->next;
+            }
+            else{
+                prev->next = job->next;
+            }
+            if(SDOqueue->tail == job){
+                SDOqueue->tail = prev;
+            }
+            job->next = NULL;
+            return job;
+        }
+        prev = job;
+        job = job->next;
+    }
+    return NULL;
+}
+
+
+/*
+ * Start job on the channel.
+ *
+ * @return CO_SDOcli_ok_communicationEnd (job started), otherwise result for
+ * the callback.
+ */
+static CO_SDOclient_return_t CO_SDOqueue_start(
+        CO_SDOqueue_t          *SDOqueue,
+        uint8_t                 channel,
+        CO_SDOqueueJob_t       *job)
+{
+    CO_SDOclient_t *SDO_C = SDOqueue->SDOclients[channel];
+    CO_SDOclient_return_t ret;
+
+    ret = CO_SDOclient_setup(SDO_C, 0, 0, job->nodeId);
+    if(ret != CO_SDOcli_ok_communicationEnd){
+        return ret;
+    }
+
+    if(job->download){
+        ret = CO_SDOclientDownloadInitiate(SDO_C, job->index, job->subIndex,
+                job->buffer, job->bufferSize, job->blockEnable);
+    }
+    else{
+        ret = CO_SDOclientUploadInitiate(SDO_C, job->index, job->subIndex,
+                job->buffer, job->bufferSize, job->blockEnable);
+    }
+    if(ret != CO_SDOcli_ok_communicationEnd){
+        CO_SDOclientClose(SDO_C);
+        return ret;
+    }
+
+    SDOqueue->activeJobs[channel] = job;
+    return CO_SDOcli_ok_communicationEnd;
+}
+
+
+/*
+ * Finish job and call its callback.
+ */
+static void CO_SDOqueue_finish(
+        CO_SDOqueueJob_t       *job,
+        CO_SDOclient_return_t   ret,
+        uint32_t                abortCode,
+        uint32_t                dataSize)
+{
+    if(job->pFunctSignal != NULL){
+        job->pFunctSignal(job, ret, abortCode, dataSize);
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_SDOqueue_init(
+        CO_SDOqueue_t          *SDOqueue,
+        CO_SDOclient_t         *SDOclients[],
+        CO_SDOqueueJob_t       *activeJobs[],
+        uint8_t                 numberOfChannels,
+        uint16_t                SDOtimeoutTime)
+{
+    uint8_t i;
+
+    /* verify arguments */
+    if(SDOqueue==NULL || SDOclients==NULL || activeJobs==NULL || numberOfChannels==0){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    for(i=0; i<numberOfChannels; i++){
+        if(SDOclients[i] == NULL){
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+        activeJobs[i] = NULL;
+    }
+
+    /* Configure object variables */
+    SDOqueue->SDOclients = SDOclients;
+    SDOqueue->activeJobs = activeJobs;
+    SDOqueue->numberOfChannels = numberOfChannels;
+    SDOqueue->SDOtimeoutTime = SDOtimeoutTime;
+    SDOqueue->blockThreshold = CO_SDOQUEUE_BLOCK_THRESHOLD;
+    SDOqueue->head = NULL;
+    SDOqueue->tail = NULL;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_SDOqueue_submit(
+        CO_SDOqueue_t          *SDOqueue,
+        CO_SDOqueueJob_t        jobs[],
+        uint16_t                count)
+{
+    uint16_t i;
+
+    /* verify arguments */
+    if(SDOqueue==NULL || (jobs==NULL && count!=0)){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    for(i=0; i<count; i++){
+        if(jobs[i].nodeId == 0 || jobs[i].nodeId > 127 || jobs[i].buffer == NULL){
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+    }
+
+    for(i=0; i<count; i++){
+        CO_SDOqueueJob_t *job = &jobs[i];
+
+        job->next = NULL;
+        job->blockEnable = (SDOqueue->blockThreshold != 0 &&
+                            job->bufferSize >= SDOqueue->blockThreshold) ? 1 : 0;
+        if(SDOqueue->tail == NULL){
+            SDOqueue->head = job;
+        }
+        else{
+            SDOqueue->tail->next = job;
+        }
+        SDOqueue->tail = job;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_SDOqueue_cancel(CO_SDOqueue_t *SDOqueue){
+    uint8_t i;
+
+    if(SDOqueue == NULL){
+        return;
+    }
+
+    for(i=0; i<SDOqueue->numberOfChannels; i++){
+        CO_SDOqueueJob_t *job = SDOqueue->activeJobs[i];
+
+        if(job != NULL){
+            CO_SDOclientClose(SDOqueue->SDOclients[i]);
+            SDOqueue->activeJobs[i] = NULL;
+            CO_SDOqueue_finish(job, CO_SDOcli_endedWithClientAbort, 0, 0);
+        }
+    }
+
+    while(SDOqueue->head != NULL){
+        CO_SDOqueueJob_t *job = SDOqueue->head;
+
+        SDOqueue->head = job->next;
+        job->next = NULL;
+        CO_SDOqueue_finish(job, CO_SDOcli_endedWithClientAbort, 0, 0);
+    }
+    SDOqueue->tail = NULL;
+}
+
+
+/******************************************************************************/
+bool_t CO_SDOqueue_isBusy(CO_SDOqueue_t *SDOqueue){
+    uint8_t i;
+
+    if(SDOqueue == NULL){
+        return false;
+    }
+    if(SDOqueue->head != NULL){
+        return true;
+    }
+    for(i=0; i<SDOqueue->numberOfChannels; i++){
+        if(SDOqueue->activeJobs[i] != NULL){
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/******************************************************************************/
+void CO_SDOqueue_process(
+        CO_SDOqueue_t          *SDOqueue,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
+{
+    uint8_t i;
+
+    for(i=0; i<SDOqueue->numberOfChannels; i++){
+        CO_SDOclient_t *SDO_C = SDOqueue->SDOclients[i];
+        CO_SDOqueueJob_t *job = SDOqueue->activeJobs[i];
+
+        /* Process active transfer */
+        if(job != NULL){
+            CO_SDOclient_return_t ret;
+            uint32_t abortCode = 0;
+            uint32_t dataSize = job->bufferSize;
+
+            if(job->download){
+                ret = CO_SDOclientDownload(SDO_C, timeDifference_ms,
+                        SDOqueue->SDOtimeoutTime, &abortCode);
+            }
+            else{
+                ret = CO_SDOclientUpload(SDO_C, timeDifference_ms,
+                        SDOqueue->SDOtimeoutTime, &dataSize, &abortCode);
+            }
+
+            if(ret > CO_SDOcli_ok_communicationEnd){
+                /* transfer in progress */
+                if(ret == CO_SDOcli_waitingServerResponse){
+                    CO_SDOclient_timerNext(SDO_C, SDOqueue->SDOtimeoutTime, timerNext_ms);
+                }
+                else if(timerNext_ms != NULL){
+                    *timerNext_ms = 0;
+                }
+                continue;
+            }
+
+            CO_SDOclientClose(SDO_C);
+            SDOqueue->activeJobs[i] = NULL;
+
+            /* Server does not support block transfer, repeat segmented */
+            if(ret == CO_SDOcli_endedWithServerAbort && abortCode == CO_SDO_AB_CMD &&
+               job->blockEnable)
+            {
+                job->blockEnable = 0;
+                if(CO_SDOqueue_start(SDOqueue, i, job) == CO_SDOcli_ok_communicationEnd){
+                    continue;
+                }
+            }
+
+            CO_SDOqueue_finish(job, ret, abortCode,
+                    (ret == CO_SDOcli_ok_communicationEnd) ? dataSize : 0);
+        }
+
+        /* Start next pending job on free channel */
+        while(SDOqueue->activeJobs[i] == NULL){
+            CO_SDOclient_return_t ret;
+
+            job = CO_SDOqueue_take(SDOqueue);
+            if(job == NULL){
+                break;
+            }
+            ret = CO_SDOqueue_start(SDOqueue, i, job);
+            if(ret != CO_SDOcli_ok_communicationEnd){
+                CO_SDOqueue_finish(job, ret, 0, 0);
+            }
+            else if(timerNext_ms != NULL){
+                /* transfer is continued by next process call */
+                *timerNext_ms = 0;
+            }
+        }
+    }
+}
@@ -0,0 +1,220 @@
+/**
+ * CANopen Service Data Object - client request queue.
+ *
+ * @file        CO_SDOqueue.h
+ * @ingroup     CO_SDOqueue
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_SDOqueue_H
+#define CO_SDOqueue_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_SDOqueue SDO client request queue
+ * @ingroup CO_SDOmaster
+ * @{
+ *
+ * Request queue for SDO client transfers to multiple nodes.
+ *
+ * The queue takes over a number of SDO client objects (channels). Application
+ * submits jobs (node, index, subindex, buffer) with a completion callback.
+ * CO_SDOqueue_process() assigns pending jobs to free channels, so transfers to
+ * different nodes run in parallel. Jobs to the same node are executed one
+ * after another in order of submission, because a SDO server handles only one
+ * transfer at a time.
+ *
+ * Expedited or segmented transfer is selected by CO_SDOclient by the data
+ * size. Block transfer is used, if the buffer is larger than
+ * CO_SDOqueue_t::blockThreshold. If the server aborts the block transfer with
+ * CO_SDO_AB_CMD, the job is repeated with segmented transfer.
+ *
+ * SDO client objects used by the queue must not be used by the application.
+ */
+
+
+/**
+ * Default value for CO_SDOqueue_t::blockThreshold in bytes.
+ */
+#ifndef CO_SDOQUEUE_BLOCK_THRESHOLD
+#define CO_SDOQUEUE_BLOCK_THRESHOLD     64U
+#endif
+
+
+/**
+ * SDO client job.
+ *
+ * Object is defined by the application and must be valid until its callback
+ * was called.
+ */
+typedef struct CO_SDOqueueJob{
+    /** Node-ID of the SDO server */
+    uint8_t             nodeId;
+    /** Index of object in object dictionary in remote node */
+    uint16_t            index;
+    /** Subindex of object in object dictionary in remote node */
+    uint8_t             subIndex;
+    /** True for download (write to remote node), false for upload */
+    bool_t              download;
+    /** Data to be written or buffer for data to be read, see
+    CO_SDOclientDownloadInitiate() and CO_SDOclientUploadInitiate() */
+    uint8_t            *buffer;
+    /** By download size of data in buffer, by upload size of buffer */
+    uint32_t            bufferSize;
+    /** Callback at the end of the job. Not called if NULL.
+    ret is result of the transfer, abortCode the SDO abort code and dataSize
+    the number of bytes transferred. */
+    void              (*pFunctSignal)(struct CO_SDOqueueJob *job, CO_SDOclient_return_t ret,
+                                      uint32_t abortCode, uint32_t dataSize);
+    /** Pointer to object for use by the application */
+    void               *object;
+    /** Internal: next job in queue */
+    struct CO_SDOqueueJob *next;
+    /** Internal: block transfer is used for this job */
+    bool_t              blockEnable;
+}CO_SDOqueueJob_t;
+
+
+/**
+ * SDO client request queue object.
+ */
+typedef struct{
+    /** From CO_SDOqueue_init() */
+    CO_SDOclient_t    **SDOclients;
+    /** From CO_SDOqueue_init() */
+    CO_SDOqueueJob_t  **activeJobs;
+    /** From CO_SDOqueue_init() */
+    uint8_t             numberOfChannels;
+    /** From CO_SDOqueue_init(), can be changed by application */
+    uint16_t            SDOtimeoutTime;
+    /** Minimum size of buffer for block transfer, set to
+    #CO_SDOQUEUE_BLOCK_THRESHOLD in CO_SDOqueue_init(). Can be changed by
+    application. 0 disables block transfer. */
+    uint32_t            blockThreshold;
+    /** First pending job */
+    CO_SDOqueueJob_t   *head;
+    /** Last pending job */
+    CO_SDOqueueJob_t   *tail;
+}CO_SDOqueue_t;
+
+
+/**
+ * Initialize SDO client request queue.
+ *
+ * @param SDOqueue This object will be initialized.
+ * @param SDOclients Array of SDO client objects, used as channels.
+ * @param activeJobs Externally defined array of the same size as
+ * numberOfChannels.
+ * @param numberOfChannels Size of the above arrays.
+ * @param SDOtimeoutTime Timeout time for SDO communication in milliseconds.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_SDOqueue_init(
+        CO_SDOqueue_t          *SDOqueue,
+        CO_SDOclient_t         *SDOclients[],
+        CO_SDOqueueJob_t       *activeJobs[],
+        uint8_t                 numberOfChannels,
+        uint16_t                SDOtimeoutTime);
+
+
+/**
+ * Submit jobs.
+ *
+ * Jobs are appended to the end of the queue. Fields nodeId, index, subIndex,
+ * download, buffer, bufferSize, pFunctSignal and object must be set.
+ *
+ * @param SDOqueue This object.
+ * @param jobs Array of jobs.
+ * @param count Number of jobs in the array.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_SDOqueue_submit(
+        CO_SDOqueue_t          *SDOqueue,
+        CO_SDOqueueJob_t        jobs[],
+        uint16_t                count);
+
+
+/**
+ * Cancel all pending and active jobs.
+ *
+ * Callback of each job is called with CO_SDOcli_endedWithClientAbort.
+ *
+ * @param SDOqueue This object.
+ */
+void CO_SDOqueue_cancel(CO_SDOqueue_t *SDOqueue);
+
+
+/**
+ * Verify, if queue has pending or active jobs.
+ *
+ * @param SDOqueue This object.
+ *
+ * @return True, if any job is not finished.
+ */
+bool_t CO_SDOqueue_isBusy(CO_SDOqueue_t *SDOqueue);
+
+
+/**
+ * Process SDO client request queue.
+ *
+ * Function must be called cyclically. It processes all active transfers and
+ * starts pending jobs on free channels.
+ *
+ * @param SDOqueue This object.
+ * @param timeDifference_ms Time difference from previous function call in [milliseconds].
+ * @param timerNext_ms Return value - info to OS - see CO_process().
+ */
+void CO_SDOqueue_process(
+        CO_SDOqueue_t          *SDOqueue,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
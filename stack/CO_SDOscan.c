@@ -0,0 +1,289 @@
+/*
+ * CANopen Service Data Object - network discovery scan.
+ *
+ * @file        CO_SDOscan.c
+ * @ingroup     CO_SDOscan
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_SDOmaster.h"
+#include "CO_SDOscan.h"
+
+
+/*
+ * Start upload of one subindex of the identity object on the channel.
+ */
+static CO_SDOclient_return_t CO_SDOscan_upload(
+        CO_SDOscan_t           *SDOscan,
+        uint8_t                 channel)
+{
+    CO_SDOclient_t *SDO_C = SDOscan->SDOclients[channel];
+    CO_SDOscanChannel_t *ch = &SDOscan->channels[channel];
+    CO_SDOclient_return_t ret;
+
+    ret = CO_SDOclient_setup(SDO_C, 0, 0, ch->node.nodeId);
+    if(ret == CO_SDOcli_ok_communicationEnd){
+        ret = CO_SDOclientUploadInitiate(SDO_C, 0x1018, ch->subIndex,
+                ch->buffer, sizeof(ch->buffer), 0);
+        if(ret != CO_SDOcli_ok_communicationEnd){
+            CO_SDOclientClose(SDO_C);
+        }
+    }
+    return ret;
+}
+
+
+/*
+ * Write found node into results, sorted by node ID.
+ */
+static void CO_SDOscan_record(
+        CO_SDOscan_t           *SDOscan,
+        const CO_SDOscanNode_t *node)
+{
+    uint8_t i;
+
+    if(SDOscan->nodeCount >= SDOscan->maxNodes){
+        return;
+    }
+
+    i = SDOscan->nodeCount;
+    while(i > 0U && SDOscan->nodes[i - 1U].nodeId > node->nodeId){
+        SDOscan->nodes[i] = SDOscan->nodes[i - 1U];
+        i--;
+    }
+    SDOscan->nodes[i] = *node;
+    SDOscan->nodeCount++;
+}
+
+
+/*
+ * Start probe of the next node ID on the free channel.
+ */
+static void CO_SDOscan_probeNext(
+        CO_SDOscan_t           *SDOscan,
+        uint8_t                 channel)
+{
+    CO_SDOscanChannel_t *ch = &SDOscan->channels[channel];
+
+    while(ch->node.nodeId == 0U && SDOscan->nextNodeId <= SDOscan->lastNodeId){
+        uint8_t i;
+
+        ch->node.nodeId = SDOscan->nextNodeId++;
+        ch->node.identityCount = 0;
+        for(i=0; i<4U; i++){
+            ch->node.identity[i] = 0;
+        }
+        ch->subIndex = 1;
+        if(CO_SDOscan_upload(SDOscan, channel) != CO_SDOcli_ok_communicationEnd){
+            ch->node.nodeId = 0;
+        }
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_SDOscan_init(
+        CO_SDOscan_t           *SDOscan,
+        CO_SDOclient_t         *SDOclients[],
+        CO_SDOscanChannel_t     channels[],
+        uint8_t                 numberOfChannels,
+        uint16_t                SDOtimeoutTime)
+{
+    uint8_t i;
+
+    /* verify arguments */
+    if(SDOscan==NULL || SDOclients==NULL || channels==NULL || numberOfChannels==0){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    for(i=0; i<numberOfChannels; i++){
+        if(SDOclients[i] == NULL){
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+        channels[i].node.nodeId = 0;
+    }
+
+    /* Configure object variables */
+    SDOscan->SDOclients = SDOclients;
+    SDOscan->channels = channels;
+    SDOscan->numberOfChannels = numberOfChannels;
+    SDOscan->SDOtimeoutTime = SDOtimeoutTime;
+    SDOscan->probeTimeoutTime = CO_SDOSCAN_PROBE_TIMEOUT;
+    SDOscan->nodes = NULL;
+    SDOscan->maxNodes = 0;
+    SDOscan->nodeCount = 0;
+    SDOscan->nextNodeId = 1;
+    SDOscan->lastNodeId = 0;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_SDOscan_start(
+        CO_SDOscan_t           *SDOscan,
+        uint8_t                 firstNodeId,
+        uint8_t                 lastNodeId,
+        CO_SDOscanNode_t        nodes[],
+        uint8_t                 maxNodes)
+{
+    /* verify arguments */
+    if(SDOscan==NULL || (nodes==NULL && maxNodes!=0) || firstNodeId==0 ||
+       lastNodeId > 127 || firstNodeId > lastNodeId){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    CO_SDOscan_cancel(SDOscan);
+
+    SDOscan->nodes = nodes;
+    SDOscan->maxNodes = maxNodes;
+    SDOscan->nodeCount = 0;
+    SDOscan->nextNodeId = firstNodeId;
+    SDOscan->lastNodeId = lastNodeId;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_SDOscan_cancel(CO_SDOscan_t *SDOscan){
+    uint8_t i;
+
+    if(SDOscan == NULL){
+        return;
+    }
+
+    for(i=0; i<SDOscan->numberOfChannels; i++){
+        if(SDOscan->channels[i].node.nodeId != 0U){
+            CO_SDOclientClose(SDOscan->SDOclients[i]);
+            SDOscan->channels[i].node.nodeId = 0;
+        }
+    }
+    SDOscan->nextNodeId = 1;
+    SDOscan->lastNodeId = 0;
+}
+
+
+/******************************************************************************/
+bool_t CO_SDOscan_isBusy(CO_SDOscan_t *SDOscan){
+    uint8_t i;
+
+    if(SDOscan == NULL){
+        return false;
+    }
+    if(SDOscan->nextNodeId <= SDOscan->lastNodeId){
+        return true;
+    }
+    for(i=0; i<SDOscan->numberOfChannels; i++){
+        if(SDOscan->channels[i].node.nodeId != 0U){
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/******************************************************************************/
+void CO_SDOscan_process(
+        CO_SDOscan_t           *SDOscan,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
+{
+    uint8_t i;
+
+    for(i=0; i<SDOscan->numberOfChannels; i++){
+        CO_SDOclient_t *SDO_C = SDOscan->SDOclients[i];
+        CO_SDOscanChannel_t *ch = &SDOscan->channels[i];
+
+        /* Process active upload */
+        if(ch->node.nodeId != 0U){
+            CO_SDOclient_return_t ret;
+            uint32_t abortCode = 0;
+            uint32_t dataSize = 0;
+
+            ret = CO_SDOclientUpload(SDO_C, timeDifference_ms,
+                    (ch->subIndex == 1U) ? SDOscan->probeTimeoutTime : SDOscan->SDOtimeoutTime,
+                    &dataSize, &abortCode);
+
+            if(ret > CO_SDOcli_ok_communicationEnd){
+                /* transfer in progress */
+                if(ret == CO_SDOcli_waitingServerResponse){
+                    CO_SDOclient_timerNext(SDO_C, (ch->subIndex == 1U) ?
+                            SDOscan->probeTimeoutTime : SDOscan->SDOtimeoutTime, timerNext_ms);
+                }
+                else if(timerNext_ms != NULL){
+                    *timerNext_ms = 0;
+                }
+                continue;
+            }
+
+            CO_SDOclientClose(SDO_C);
+
+            if(ret == CO_SDOcli_ok_communicationEnd && dataSize == sizeof(ch->buffer)){
+                ch->node.identity[ch->subIndex - 1U] = CO_getUint32(ch->buffer);
+                ch->node.identityCount++;
+            }
+
+            /* Node is present, if it responded to the probe. Read the rest
+             * of the identity, if it has one. */
+            if(ch->subIndex > 1U || ret == CO_SDOcli_ok_communicationEnd){
+                if(ch->subIndex < 4U && ch->node.identityCount > 0U){
+                    ch->subIndex++;
+                    if(CO_SDOscan_upload(SDOscan, i) == CO_SDOcli_ok_communicationEnd){
+                        continue;
+                    }
+                }
+                CO_SDOscan_record(SDOscan, &ch->node);
+            }
+            else if(ret == CO_SDOcli_endedWithServerAbort){
+                CO_SDOscan_record(SDOscan, &ch->node);
+            }
+            ch->node.nodeId = 0;
+        }
+
+        /* Start probe of next node ID on free channel */
+        CO_SDOscan_probeNext(SDOscan, i);
+        if(ch->node.nodeId != 0U && timerNext_ms != NULL){
+            /* transfer is continued by next process call */
+            *timerNext_ms = 0;
+        }
+    }
+}
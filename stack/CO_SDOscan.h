@@ -0,0 +1,224 @@
+/**
+ * CANopen Service Data Object - network discovery scan.
+ *
+ * @file        CO_SDOscan.h
+ * @ingroup     CO_SDOscan
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+
+#ifndef CO_SDOscan_H
+#define CO_SDOscan_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_SDOscan SDO network discovery scan
+ * @ingroup CO_SDOmaster
+ * @{
+ *
+ * Discovery of nodes present on the network in one pass.
+ *
+ * The scan takes over a number of SDO client objects (channels), like
+ * CO_SDOqueue. Each channel probes one node ID after another with an
+ * expedited upload of the Vendor-ID (index 0x1018, subindex 1), so as many
+ * node IDs are probed in parallel as there are channels. Absent node IDs cost
+ * only the short CO_SDOscan_t::probeTimeoutTime. Each node, which responds,
+ * also with an SDO abort, is present. Its remaining identity object
+ * (Product code, Revision number and Serial number) is then read with the
+ * normal CO_SDOscan_t::SDOtimeoutTime.
+ *
+ * Results are sorted by node ID. SDO client objects used by the scan must not
+ * be used by the application during the scan.
+ */
+
+
+/**
+ * Default value for CO_SDOscan_t::probeTimeoutTime in milliseconds.
+ */
+#ifndef CO_SDOSCAN_PROBE_TIMEOUT
+#define CO_SDOSCAN_PROBE_TIMEOUT        20U
+#endif
+
+
+/**
+ * Node found by the scan.
+ */
+typedef struct{
+    /** Node-ID of the node */
+    uint8_t             nodeId;
+    /** Number of identity subindexes read, 0 if node responded with SDO abort
+    to Vendor-ID */
+    uint8_t             identityCount;
+    /** Vendor-ID, Product code, Revision number and Serial number from
+    index 0x1018, 0 if not read */
+    uint32_t            identity[4];
+}CO_SDOscanNode_t;
+
+
+/**
+ * State of one channel of the scan.
+ *
+ * Array is defined by the application, see CO_SDOscan_init().
+ */
+typedef struct{
+    /** Node found or probed by the channel, nodeId is 0 if channel is free */
+    CO_SDOscanNode_t    node;
+    /** Subindex of index 0x1018, which is read */
+    uint8_t             subIndex;
+    /** Buffer for the uploaded value */
+    uint8_t             buffer[4];
+}CO_SDOscanChannel_t;
+
+
+/**
+ * SDO network discovery scan object.
+ */
+typedef struct{
+    /** From CO_SDOscan_init() */
+    CO_SDOclient_t    **SDOclients;
+    /** From CO_SDOscan_init() */
+    CO_SDOscanChannel_t *channels;
+    /** From CO_SDOscan_init() */
+    uint8_t             numberOfChannels;
+    /** From CO_SDOscan_init(), can be changed by application */
+    uint16_t            SDOtimeoutTime;
+    /** Timeout of the probe of each node ID in milliseconds, set to
+    #CO_SDOSCAN_PROBE_TIMEOUT in CO_SDOscan_init(). Can be changed by
+    application. */
+    uint16_t            probeTimeoutTime;
+    /** From CO_SDOscan_start() */
+    CO_SDOscanNode_t   *nodes;
+    /** From CO_SDOscan_start() */
+    uint8_t             maxNodes;
+    /** Number of nodes found, written into nodes */
+    uint8_t             nodeCount;
+    /** Next node ID to be probed */
+    uint8_t             nextNodeId;
+    /** From CO_SDOscan_start() */
+    uint8_t             lastNodeId;
+}CO_SDOscan_t;
+
+
+/**
+ * Initialize SDO network discovery scan.
+ *
+ * @param SDOscan This object will be initialized.
+ * @param SDOclients Array of SDO client objects, used as channels.
+ * @param channels Externally defined array of the same size as
+ * numberOfChannels.
+ * @param numberOfChannels Size of the above arrays.
+ * @param SDOtimeoutTime Timeout time for SDO communication with present nodes
+ * in milliseconds.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_SDOscan_init(
+        CO_SDOscan_t           *SDOscan,
+        CO_SDOclient_t         *SDOclients[],
+        CO_SDOscanChannel_t     channels[],
+        uint8_t                 numberOfChannels,
+        uint16_t                SDOtimeoutTime);
+
+
+/**
+ * Start scan of a range of node IDs.
+ *
+ * Scan, which is in progress, is cancelled.
+ *
+ * @param SDOscan This object.
+ * @param firstNodeId First node ID to be probed, 1..127.
+ * @param lastNodeId Last node ID to be probed, firstNodeId..127.
+ * @param nodes Array for the results, must be valid until the end of the scan.
+ * If array is full, further nodes are not recorded.
+ * @param maxNodes Size of the above array.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_SDOscan_start(
+        CO_SDOscan_t           *SDOscan,
+        uint8_t                 firstNodeId,
+        uint8_t                 lastNodeId,
+        CO_SDOscanNode_t        nodes[],
+        uint8_t                 maxNodes);
+
+
+/**
+ * Cancel the scan. Nodes found so far stay in the results.
+ *
+ * @param SDOscan This object.
+ */
+void CO_SDOscan_cancel(CO_SDOscan_t *SDOscan);
+
+
+/**
+ * Verify, if scan is in progress.
+ *
+ * @param SDOscan This object.
+ *
+ * @return True, if scan is not finished.
+ */
+bool_t CO_SDOscan_isBusy(CO_SDOscan_t *SDOscan);
+
+
+/**
+ * Process SDO network discovery scan.
+ *
+ * Function must be called cyclically. It processes all channels and starts
+ * the probe of the next node ID on free channels.
+ *
+ * @param SDOscan This object.
+ * @param timeDifference_ms Time difference from previous function call in [milliseconds].
+ * @param timerNext_ms Return value - info to OS - see CO_process().
+ */
+void CO_SDOscan_process(
+        CO_SDOscan_t           *SDOscan,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
@@ -49,6 +49,7 @@
 #include "CO_Emergency.h"
 #include "CO_NMT_Heartbeat.h"
 #include "CO_SYNC.h"
+#include "CO_statistics.h"
 
 /*
  * Read received message from CAN module.
@@ -84,6 +85,14 @@ static void CO_SYNC_receive(void *object, const CO_CANrxMsg_t *msg){
         }
         if(IS_CANrxNew(SYNC->CANrxNew)) {
             SYNC->CANrxToggle = SYNC->CANrxToggle ? false : true;
+#ifdef CO_USE_STATISTICS
+            SYNC->timestamp_us = CO_STAT_RX_TIMESTAMP_US(msg);
+#endif
+#ifdef CO_TPDO_PRESTAGE
+            if(SYNC->pFunctSync != NULL){
+                SYNC->pFunctSync(SYNC->functSyncObject);
+            }
+#endif
         }
     }
 }
@@ -274,6 +283,16 @@ CO_ReturnError_t CO_SYNC_init(
 
     CLEAR_CANrxNew(SYNC->CANrxNew);
     SYNC->CANrxToggle = false;
+#ifdef CO_USE_STATISTICS
+    SYNC->timestamp_us = 0;
+#endif
+#ifdef CO_TPDO_PRESTAGE
+    SYNC->pFunctSync = NULL;
+    SYNC->functSyncObject = NULL;
+#endif
+#ifdef CO_SYNC_HW_TIMER
+    SYNC->timerDriven = false;
+#endif
     SYNC->timer = 0;
     SYNC->counter = 0;
     SYNC->receiveError = 0U;
@@ -314,6 +333,61 @@ CO_ReturnError_t CO_SYNC_init(
 }
 
 
+#ifdef CO_TPDO_PRESTAGE
+/******************************************************************************/
+void CO_SYNC_initCallbackSync(
+        CO_SYNC_t              *SYNC,
+        void                   *object,
+        void                  (*pFunctSync)(void *object))
+{
+    if(SYNC != NULL){
+        SYNC->functSyncObject = object;
+        SYNC->pFunctSync = pFunctSync;
+    }
+}
+#endif
+
+
+#ifdef CO_SYNC_HW_TIMER
+/******************************************************************************/
+void CO_SYNC_setTimerDriven(CO_SYNC_t *SYNC, bool_t timerDriven){
+    if(SYNC != NULL){
+        SYNC->timerDriven = timerDriven;
+    }
+}
+
+
+/******************************************************************************/
+bool_t CO_SYNC_timerIsr(CO_SYNC_t *SYNC){
+    uint8_t operState = *SYNC->operatingState;
+
+    if(!SYNC->timerDriven || !SYNC->isProducer || SYNC->periodTime == 0U ||
+        ((operState != CO_NMT_OPERATIONAL) && (operState != CO_NMT_PRE_OPERATIONAL))){
+        return false;
+    }
+
+    /* only the counter changes, identifier and DLC are prepared */
+    if(++SYNC->counter > SYNC->counterOverflowValue) SYNC->counter = 1;
+    SYNC->CANtxBuff->data[0] = SYNC->counter;
+    CO_CANsendFromISR(SYNC->CANdevTx, SYNC->CANtxBuff);
+
+    /* notify CO_SYNC_process() as with received SYNC */
+    SYNC->CANrxToggle = SYNC->CANrxToggle ? false : true;
+#ifdef CO_USE_STATISTICS
+    SYNC->timestamp_us = CO_STAT_TIMESTAMP_US();
+#endif
+    SET_CANrxNew(SYNC->CANrxNew);
+#ifdef CO_TPDO_PRESTAGE
+    if(SYNC->pFunctSync != NULL){
+        SYNC->pFunctSync(SYNC->functSyncObject);
+    }
+#endif
+
+    return true;
+}
+#endif
+
+
 /******************************************************************************/
 uint8_t CO_SYNC_process(
         CO_SYNC_t              *SYNC,
@@ -336,7 +410,11 @@ uint8_t CO_SYNC_process(
         }
 
         /* SYNC producer */
+#ifdef CO_SYNC_HW_TIMER
+        if(SYNC->isProducer && SYNC->periodTime && !SYNC->timerDriven){
+#else
         if(SYNC->isProducer && SYNC->periodTime){
+#endif
             if(SYNC->timer >= SYNC->periodTime){
                 if(++SYNC->counter > SYNC->counterOverflowValue) SYNC->counter = 1;
                 SYNC->timer = 0;
@@ -344,6 +422,14 @@ uint8_t CO_SYNC_process(
                 SYNC->CANrxToggle = SYNC->CANrxToggle ? false : true;
                 SYNC->CANtxBuff->data[0] = SYNC->counter;
                 CO_CANsend(SYNC->CANdevTx, SYNC->CANtxBuff);
+#ifdef CO_USE_STATISTICS
+                SYNC->timestamp_us = CO_STAT_TIMESTAMP_US();
+#endif
+#ifdef CO_TPDO_PRESTAGE
+                if(SYNC->pFunctSync != NULL){
+                    SYNC->pFunctSync(SYNC->functSyncObject);
+                }
+#endif
             }
         }
 
@@ -78,6 +78,22 @@ extern "C" {
  * transmitted, internal variable CANrxToggle toggles. That variable is then
  * used by synchronous RPDO to determine, which of the two buffers is used for
  * RPDO reception and which for RPDO processing.
+ *
+ * ####SYNC production from hardware timer
+ * By default SYNC producer transmits SYNC message from CO_SYNC_process(), so
+ * the jitter of SYNC period is the jitter of the realtime thread or timer
+ * task. If CO_SYNC_HW_TIMER is defined and CO_SYNC_setTimerDriven() is
+ * enabled, CO_SYNC_process() does not transmit SYNC. Instead, a hardware timer
+ * interrupt with period _Communication cycle period_ (index 0x1006) calls
+ * CO_SYNC_timerIsr(), which updates the counter in the prepared SYNC message
+ * and transmits it with CO_CANsendFromISR() directly into a free (or
+ * dedicated) transmit buffer of the CAN module. The stack is notified the
+ * same way as by received SYNC: next CO_SYNC_process() returns 1.
+ *
+ * Timer setup and CO_CANsendFromISR() are target specific, see the CAN
+ * driver. The timer must follow changes of isProducer and periodTime.
+ * CO_SYNC_HW_TIMER must be defined for the whole project (compiler option),
+ * because it is used also by the CAN driver.
  */
 
 
@@ -121,6 +137,20 @@ typedef struct{
     CO_CANmodule_t     *CANdevTx;       /**< From CO_SYNC_init() */
     CO_CANtx_t         *CANtxBuff;      /**< CAN transmit buffer inside CANdevTx */
     uint16_t            CANdevTxIdx;    /**< From CO_SYNC_init() */
+#ifdef CO_TPDO_PRESTAGE
+    /** From CO_SYNC_initCallbackSync() or NULL */
+    void              (*pFunctSync)(void *object);
+    /** From CO_SYNC_initCallbackSync() or NULL */
+    void               *functSyncObject;
+#endif
+#ifdef CO_SYNC_HW_TIMER
+    /** From CO_SYNC_setTimerDriven() */
+    volatile bool_t     timerDriven;
+#endif
+#ifdef CO_USE_STATISTICS
+    /** Time of the last received or transmitted SYNC message, see CO_statistics.h */
+    uint32_t            timestamp_us;
+#endif
 }CO_SYNC_t;
 
 
@@ -157,6 +187,59 @@ CO_ReturnError_t CO_SYNC_init(
         uint16_t                CANdevTxIdx);
 
 
+#ifdef CO_TPDO_PRESTAGE
+/**
+ * Initialize SYNC callback function.
+ *
+ * Function initializes optional callback function, which is called right
+ * after SYNC message is received (from the CAN receive context) or
+ * transmitted (from CO_SYNC_process() or CO_SYNC_timerIsr()). It is used for
+ * sending of pre-staged TPDOs, see #CO_TPDO_PRESTAGE. Callback must be short
+ * and must not block.
+ *
+ * @param SYNC This object.
+ * @param object Pointer to object, which will be passed to pFunctSync(). Can be NULL.
+ * @param pFunctSync Pointer to the callback function. Not called if NULL.
+ */
+void CO_SYNC_initCallbackSync(
+        CO_SYNC_t              *SYNC,
+        void                   *object,
+        void                  (*pFunctSync)(void *object));
+#endif
+
+
+#ifdef CO_SYNC_HW_TIMER
+/**
+ * Enable SYNC production from hardware timer.
+ *
+ * Function must be called after CO_SYNC_init(), before the timer interrupt
+ * is started. See #CO_SYNC_HW_TIMER.
+ *
+ * @param SYNC This object.
+ * @param timerDriven If true, SYNC is transmitted only by CO_SYNC_timerIsr().
+ */
+void CO_SYNC_setTimerDriven(CO_SYNC_t *SYNC, bool_t timerDriven);
+
+
+/**
+ * Transmit SYNC message from hardware timer interrupt.
+ *
+ * Function must be called from the timer interrupt each SYNC period. It does
+ * nothing, if timer driven SYNC is not enabled, device is not SYNC producer,
+ * period is zero or NMT state is not operational or pre-operational.
+ * Otherwise it increments the counter, transmits SYNC with
+ * CO_CANsendFromISR(), toggles CANrxToggle and calls pFunctSync, if
+ * configured.
+ *
+ * @param SYNC This object.
+ *
+ * @return True, if SYNC was transmitted. Application may then trigger the
+ * realtime thread.
+ */
+bool_t CO_SYNC_timerIsr(CO_SYNC_t *SYNC);
+#endif
+
+
 /**
  * Process SYNC communication.
  *
@@ -0,0 +1,365 @@
+/*
+ * CANopen TIME protocol, producer and consumer with drift estimation.
+ *
+ * @file        CO_TIME.c
+ * @ingroup     CO_TIME
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include <string.h>
+
+#include "CANopen.h"
+#include "CO_TIME.h"
+
+#if CO_NO_TIME == 1
+
+#ifndef CO_USE_STATISTICS
+#error CO_TIME needs CO_USE_STATISTICS for the local clock and reception times.
+#endif
+
+/* Milliseconds in one day. */
+#define CO_TIME_DAY_MS      86400000ULL
+
+/* Reference point is moved forward after this local time, so elapsed time
+ * always fits into int32_t. */
+#define CO_TIME_REBASE_US   0x40000000UL
+
+
+/*
+ * Read received message from CAN module.
+ *
+ * Function will be called (by CAN receive interrupt) every time, when CAN
+ * message with correct identifier will be received. For more information and
+ * description of parameters see file CO_driver.h.
+ */
+static void CO_TIME_receive(void *object, const CO_CANrxMsg_t *msg){
+    CO_TIME_t *TIME;
+    uint8_t operState;
+
+    TIME = (CO_TIME_t*)object;   /* this is the correct pointer type of the first argument */
+    operState = *TIME->operatingState;
+
+    if(((operState == CO_NMT_OPERATIONAL) || (operState == CO_NMT_PRE_OPERATIONAL)) &&
+        TIME->isConsumer && (msg->DLC == 6U))
+    {
+        memcpy(TIME->rxData, msg->data, sizeof(TIME->rxData));
+        TIME->rxLocal_us = CO_STAT_RX_TIMESTAMP_US(msg);
+        SET_CANrxNew(TIME->CANrxNew);
+    }
+}
+
+
+/*
+ * Configure producer, consumer and CAN buffers from _COB ID TIME_.
+ */
+static void CO_TIME_configure(CO_TIME_t *TIME, uint32_t COB_ID_TIME){
+    TIME->isConsumer = (COB_ID_TIME & 0x80000000UL) ? true : false;
+    TIME->isProducer = (COB_ID_TIME & 0x40000000UL) ? true : false;
+    TIME->COB_ID = (uint16_t)(COB_ID_TIME & 0x7FFU);
+    TIME->producerTimer_ms = 0U;
+    CLEAR_CANrxNew(TIME->CANrxNew);
+
+    CO_CANrxBufferInit(
+            TIME->CANdevRx,         /* CAN device */
+            TIME->CANdevRxIdx,      /* rx buffer index */
+            TIME->COB_ID,           /* CAN identifier */
+            0x7FF,                  /* mask */
+            0,                      /* rtr */
+            (void*)TIME,            /* object passed to receive function */
+            CO_TIME_receive);       /* this function will process received message */
+
+    TIME->CANtxBuff = CO_CANtxBufferInit(
+            TIME->CANdevTx,         /* CAN device */
+            TIME->CANdevTxIdx,      /* index of specific buffer inside CAN module */
+            TIME->COB_ID,           /* CAN identifier */
+            0,                      /* rtr */
+            6,                      /* number of data bytes */
+            0);                     /* synchronous message flag bit */
+}
+
+
+/*
+ * Function for accessing _COB ID TIME_ (index 0x1012) from SDO server.
+ *
+ * For more information see file CO_SDO.h.
+ */
+static CO_SDO_abortCode_t CO_ODF_1012(CO_ODF_arg_t *ODF_arg){
+    CO_TIME_t *TIME;
+    uint32_t value;
+    CO_SDO_abortCode_t ret = CO_SDO_AB_NONE;
+
+    TIME = (CO_TIME_t*) ODF_arg->object;
+    value = CO_getUint32(ODF_arg->data);
+
+    if(!ODF_arg->reading){
+        /* only 11-bit CAN identifier is supported */
+        if(value & 0x20000000UL){
+            ret = CO_SDO_AB_INVALID_VALUE;
+        }
+        else{
+            CO_TIME_configure(TIME, value);
+        }
+    }
+
+    return ret;
+}
+
+
+/*
+ * Network time at the given local time. Must be called inside CO_LOCK_OD().
+ */
+static uint64_t CO_TIME_at(const CO_TIME_t *TIME, uint32_t local_us){
+    int64_t elapsed = (int32_t)(local_us - TIME->ref.local_us);
+
+    elapsed += elapsed * TIME->drift_ppb / 1000000000LL;
+
+    return (uint64_t)((int64_t)TIME->ref.net_us + elapsed);
+}
+
+
+/*
+ * Evaluate received TIME message.
+ */
+static void CO_TIME_receiveProcess(CO_TIME_t *TIME){
+    CO_TIME_point_t rx;
+    int64_t offset = 0;
+    uint32_t ms = CO_getUint32(&TIME->rxData[0]) & 0x0FFFFFFFUL;
+    uint16_t days = CO_getUint16(&TIME->rxData[4]);
+
+    rx.net_us = ((uint64_t)days * CO_TIME_DAY_MS + ms) * 1000U;
+    rx.local_us = TIME->rxLocal_us;
+
+    CO_LOCK_OD();
+    if(TIME->valid){
+        offset = (int64_t)(rx.net_us - CO_TIME_at(TIME, rx.local_us));
+    }
+
+    if(!TIME->valid || offset > CO_TIME_STEP_US || offset < -CO_TIME_STEP_US){
+        /* first message or time was set on the producer */
+        TIME->ref = rx;
+        TIME->anchor = rx;
+        TIME->anchorNextValid = false;
+        TIME->valid = true;
+        offset = 0;
+    }
+    else{
+        uint32_t baseline = rx.local_us - TIME->anchor.local_us;
+
+        /* correct a part of the offset, message has millisecond resolution */
+        TIME->ref.net_us = CO_TIME_at(TIME, rx.local_us) + offset / CO_TIME_OFFSET_GAIN;
+        TIME->ref.local_us = rx.local_us;
+
+        if(baseline >= CO_TIME_DRIFT_MIN_US){
+            int64_t drift = ((int64_t)(rx.net_us - TIME->anchor.net_us) - (int64_t)baseline)
+                            * 1000000000LL / (int64_t)baseline;
+
+            if(drift <= CO_TIME_DRIFT_MAX_PPB && drift >= -CO_TIME_DRIFT_MAX_PPB){
+                TIME->drift_ppb = (int32_t)drift;
+            }
+        }
+
+        /* slide the window of the drift estimation */
+        if(baseline >= CO_TIME_DRIFT_WINDOW_US){
+            TIME->anchor = TIME->anchorNextValid ? TIME->anchorNext : rx;
+            TIME->anchorNextValid = false;
+            baseline = rx.local_us - TIME->anchor.local_us;
+        }
+        if(baseline >= CO_TIME_DRIFT_WINDOW_US / 2U && !TIME->anchorNextValid){
+            TIME->anchorNext = rx;
+            TIME->anchorNextValid = true;
+        }
+    }
+    TIME->offset_us = (int32_t)offset;
+    TIME->rxCount++;
+    CO_UNLOCK_OD();
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_TIME_init(
+        CO_TIME_t              *TIME,
+        CO_EM_t                *em,
+        CO_SDO_t               *SDO,
+        uint8_t                *operatingState,
+        uint32_t                COB_ID_TIME,
+        uint16_t                producerInterval_ms,
+        CO_CANmodule_t         *CANdevRx,
+        uint16_t                CANdevRxIdx,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx)
+{
+    /* verify arguments */
+    if(TIME==NULL || em==NULL || SDO==NULL || operatingState==NULL ||
+        CANdevRx==NULL || CANdevTx==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    TIME->em = em;
+    TIME->operatingState = operatingState;
+    TIME->producerInterval_ms = producerInterval_ms;
+    TIME->valid = false;
+    TIME->anchorNextValid = false;
+    TIME->drift_ppb = 0;
+    TIME->offset_us = 0;
+    TIME->rxCount = 0U;
+    TIME->last_us = 0U;
+
+    TIME->CANdevRx = CANdevRx;
+    TIME->CANdevRxIdx = CANdevRxIdx;
+    TIME->CANdevTx = CANdevTx;
+    TIME->CANdevTxIdx = CANdevTxIdx;
+
+    /* Configure Object dictionary entry at index 0x1012 */
+    CO_OD_configure(SDO, OD_H1012_COBID_TIME, CO_ODF_1012, (void*)TIME, 0, 0);
+
+    /* configure TIME CAN reception and transmission */
+    CO_TIME_configure(TIME, COB_ID_TIME);
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_TIME_set(CO_TIME_t *TIME, uint64_t time_us){
+    uint32_t now = CO_STAT_TIMESTAMP_US();
+
+    CO_LOCK_OD();
+    TIME->ref.net_us = time_us;
+    TIME->ref.local_us = now;
+    TIME->valid = true;
+    CO_UNLOCK_OD();
+}
+
+
+/******************************************************************************/
+uint64_t CO_TIME_get_us(CO_TIME_t *TIME){
+    uint64_t time_us = 0U;
+
+    if(TIME != NULL && TIME->valid){
+        uint32_t now = CO_STAT_TIMESTAMP_US();
+
+        CO_LOCK_OD();
+        time_us = CO_TIME_at(TIME, now);
+        /* hold the time on small corrections backwards, follow steps */
+        if(time_us < TIME->last_us && (TIME->last_us - time_us) <= (uint64_t)CO_TIME_STEP_US){
+            time_us = TIME->last_us;
+        }
+        else{
+            TIME->last_us = time_us;
+        }
+        CO_UNLOCK_OD();
+    }
+
+    return time_us;
+}
+
+
+/******************************************************************************/
+uint32_t CO_TIME_getMs(CO_TIME_t *TIME){
+    return (uint32_t)(CO_TIME_get_us(TIME) / 1000U);
+}
+
+
+/******************************************************************************/
+void CO_TIME_process(
+        CO_TIME_t              *TIME,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
+{
+    uint8_t operState = *TIME->operatingState;
+    bool_t NMTisPreOrOperational = (operState == CO_NMT_OPERATIONAL) ||
+                                   (operState == CO_NMT_PRE_OPERATIONAL);
+
+    if(TIME->valid){
+        uint32_t now = CO_STAT_TIMESTAMP_US();
+
+        /* move the reference point forward, if no message was received for
+         * a long time. Drift estimation continues from there. */
+        if((uint32_t)(now - TIME->ref.local_us) > CO_TIME_REBASE_US){
+            CO_LOCK_OD();
+            TIME->ref.net_us = CO_TIME_at(TIME, now);
+            TIME->ref.local_us = now;
+            TIME->anchor = TIME->ref;
+            TIME->anchorNextValid = false;
+            CO_UNLOCK_OD();
+        }
+    }
+
+    if(!NMTisPreOrOperational){
+        CLEAR_CANrxNew(TIME->CANrxNew);
+        TIME->producerTimer_ms = 0U;
+        return;
+    }
+
+    /* consumer */
+    if(IS_CANrxNew(TIME->CANrxNew)){
+        CO_TIME_receiveProcess(TIME);
+        CLEAR_CANrxNew(TIME->CANrxNew);
+    }
+
+    /* producer */
+    if(TIME->isProducer && TIME->producerInterval_ms != 0U){
+        if(TIME->producerTimer_ms < TIME->producerInterval_ms){
+            TIME->producerTimer_ms += timeDifference_ms;
+        }
+        if(TIME->producerTimer_ms >= TIME->producerInterval_ms){
+            TIME->producerTimer_ms = 0U;
+
+            if(TIME->valid){
+                uint64_t ms = (CO_TIME_get_us(TIME) + 500U) / 1000U;
+
+                CO_setUint32(&TIME->CANtxBuff->data[0], (uint32_t)(ms % CO_TIME_DAY_MS));
+                CO_setUint16(&TIME->CANtxBuff->data[4], (uint16_t)(ms / CO_TIME_DAY_MS));
+                CO_CANsend(TIME->CANdevTx, TIME->CANtxBuff);
+            }
+        }
+
+        /* Calculate when next TIME needs to be sent */
+        if(timerNext_ms != NULL){
+            uint16_t diff = TIME->producerInterval_ms - TIME->producerTimer_ms;
+            if(*timerNext_ms > diff){
+                *timerNext_ms = diff;
+            }
+        }
+    }
+}
+
+#endif
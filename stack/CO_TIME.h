@@ -0,0 +1,288 @@
+/**
+ * CANopen TIME protocol, producer and consumer with drift estimation.
+ *
+ * @file        CO_TIME.h
+ * @ingroup     CO_TIME
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+
+#ifndef CO_TIME_H
+#define CO_TIME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_TIME TIME
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * CANopen TIME protocol (TIME_OF_DAY) with drift estimation.
+ *
+ * TIME message has six data bytes: milliseconds after midnight (28 bit) and
+ * days since January 1, 1984 (16 bit). Consumer and producer are enabled by
+ * bits 31 and 30 of _COB ID TIME_ (index 0x1012).
+ *
+ * Network time is kept in microseconds since January 1, 1984. It is the
+ * network time of a reference point plus the time elapsed since then on the
+ * local clock CO_STAT_TIMESTAMP_US(), corrected by the estimated drift of the
+ * local clock. CO_USE_STATISTICS must be defined.
+ *
+ * Object is used by CANopen.c, if CO_OD.h defines CO_NO_TIME as 1 and
+ * contains variable OD_COB_ID_TIME (index 0x1012). It is then available as
+ * CO->TIME.
+ *
+ * ####Consumer
+ * Reception time of each TIME message is taken from CO_STAT_RX_TIMESTAMP_US()
+ * inside the receive callback. With a driver, which timestamps received
+ * messages (neuberger-socketCAN), accuracy does not depend on the interval of
+ * CO_TIME_process(). The difference between the received time and the time
+ * predicted for the reception is stored as CO_TIME_t::offset_us, a part of it
+ * (1/#CO_TIME_OFFSET_GAIN) corrects the reference point, so the millisecond
+ * resolution of the message is averaged. Drift is calculated from network and
+ * local time elapsed since an older message (anchor), which is between
+ * #CO_TIME_DRIFT_WINDOW_US / 2 and #CO_TIME_DRIFT_WINDOW_US before. Offset
+ * above #CO_TIME_STEP_US (time set on the producer, first message) sets the
+ * time directly and restarts drift estimation, drift estimated so far is kept.
+ *
+ * ####Producer
+ * Producer sends the network time every _producerInterval_ms_, rounded to
+ * milliseconds. Application sets the network time with CO_TIME_set(), in
+ * between the producer continues on the local clock. On Linux it may be set
+ * from CLOCK_REALTIME, which may in turn be disciplined by PTP (phc2sys), or
+ * directly from a PTP hardware clock:
+ *
+ *     struct timespec ts;
+ *     clock_gettime(CLOCK_REALTIME, &ts);
+ *     CO_TIME_set(CO->TIME, CO_TIME_FROM_UNIX_US(
+ *             (uint64_t)ts.tv_sec * 1000000U + (uint64_t)ts.tv_nsec / 1000U));
+ *
+ * ####Corrected time
+ * CO_TIME_get_us() returns the network time, it never goes backwards.
+ * CO_TIME_getMs() returns a 32 bit millisecond timestamp, which is used as
+ * _timestamp_ of CO_trace_process() and by the application for timestamps of
+ * emergency messages, so traces and logs of different nodes can be
+ * correlated.
+ */
+
+
+/** Interval of TIME messages in [milliseconds], if device is producer */
+#ifndef CO_TIME_PRODUCER_INTERVAL_MS
+#define CO_TIME_PRODUCER_INTERVAL_MS 1000U
+#endif
+
+/** Offset in microseconds, above which time is set without filtering */
+#ifndef CO_TIME_STEP_US
+#define CO_TIME_STEP_US             100000L
+#endif
+
+/** Divider of the offset, which corrects the reference point on reception */
+#ifndef CO_TIME_OFFSET_GAIN
+#define CO_TIME_OFFSET_GAIN         4
+#endif
+
+/** Maximum time between anchor and reception for drift estimation, < 2^32 */
+#ifndef CO_TIME_DRIFT_WINDOW_US
+#define CO_TIME_DRIFT_WINDOW_US     600000000UL
+#endif
+
+/** Minimum time between anchor and reception for drift estimation */
+#ifndef CO_TIME_DRIFT_MIN_US
+#define CO_TIME_DRIFT_MIN_US        10000000UL
+#endif
+
+/** Maximum accepted drift of the local clock in ppb (1000 ppm) */
+#ifndef CO_TIME_DRIFT_MAX_PPB
+#define CO_TIME_DRIFT_MAX_PPB       1000000L
+#endif
+
+/** Microseconds between January 1, 1970 (Unix epoch) and January 1, 1984 */
+#define CO_TIME_UNIX_OFFSET_US      441763200000000ULL
+
+/** Convert Unix time in microseconds to network time */
+#define CO_TIME_FROM_UNIX_US(t)     ((uint64_t)(t) - CO_TIME_UNIX_OFFSET_US)
+
+
+/**
+ * Pair of network and local time.
+ */
+typedef struct{
+    uint64_t            net_us;         /**< Network time in microseconds since 1984 */
+    uint32_t            local_us;       /**< Local time from CO_STAT_TIMESTAMP_US() */
+}CO_TIME_point_t;
+
+
+/**
+ * TIME producer and consumer object.
+ */
+typedef struct{
+    CO_EM_t            *em;             /**< From CO_TIME_init() */
+    uint8_t            *operatingState; /**< From CO_TIME_init() */
+    /** True, if device is TIME consumer, bit 31 of _COB ID TIME_ */
+    bool_t              isConsumer;
+    /** True, if device is TIME producer, bit 30 of _COB ID TIME_ */
+    bool_t              isProducer;
+    /** CAN identifier of TIME message, from _COB ID TIME_ */
+    uint16_t            COB_ID;
+    /** From CO_TIME_init(), 0 disables the producer */
+    uint16_t            producerInterval_ms;
+    /** Time since the last transmission in [milliseconds] */
+    uint16_t            producerTimer_ms;
+    /** Indicates, if new TIME message received from CAN bus */
+    volatile void      *CANrxNew;
+    /** Data of the last received message */
+    uint8_t             rxData[6];
+    /** Local time of the reception of the last message */
+    uint32_t            rxLocal_us;
+    /** True, after the first received message or CO_TIME_set() */
+    bool_t              valid;
+    /** Network time is this point plus corrected local time elapsed since */
+    CO_TIME_point_t     ref;
+    /** Start of the drift estimation */
+    CO_TIME_point_t     anchor;
+    /** Next anchor, set in the middle of the window */
+    CO_TIME_point_t     anchorNext;
+    /** True, if anchorNext is set */
+    bool_t              anchorNextValid;
+    /** Estimated drift of the network time to the local clock in [ppb] */
+    int32_t             drift_ppb;
+    /** Received minus predicted time of the last message in [microseconds] */
+    int32_t             offset_us;
+    /** Number of received messages */
+    uint32_t            rxCount;
+    /** Last value returned by CO_TIME_get_us() */
+    uint64_t            last_us;
+    CO_CANmodule_t     *CANdevRx;       /**< From CO_TIME_init() */
+    uint16_t            CANdevRxIdx;    /**< From CO_TIME_init() */
+    CO_CANmodule_t     *CANdevTx;       /**< From CO_TIME_init() */
+    uint16_t            CANdevTxIdx;    /**< From CO_TIME_init() */
+    CO_CANtx_t         *CANtxBuff;      /**< CAN transmit buffer inside CANdevTx */
+}CO_TIME_t;
+
+
+/**
+ * Initialize TIME object.
+ *
+ * Function must be called in the communication reset section.
+ *
+ * @param TIME This object will be initialized.
+ * @param em Emergency object.
+ * @param SDO SDO server object.
+ * @param operatingState Pointer to variable indicating CANopen device NMT internal state.
+ * @param COB_ID_TIME From Object dictionary (index 0x1012).
+ * @param producerInterval_ms Interval of TIME messages, if device is producer.
+ * @param CANdevRx CAN device for TIME reception.
+ * @param CANdevRxIdx Index of receive buffer in the above CAN device.
+ * @param CANdevTx CAN device for TIME transmission.
+ * @param CANdevTxIdx Index of transmit buffer in the above CAN device.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_TIME_init(
+        CO_TIME_t              *TIME,
+        CO_EM_t                *em,
+        CO_SDO_t               *SDO,
+        uint8_t                *operatingState,
+        uint32_t                COB_ID_TIME,
+        uint16_t                producerInterval_ms,
+        CO_CANmodule_t         *CANdevRx,
+        uint16_t                CANdevRxIdx,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx);
+
+
+/**
+ * Set network time.
+ *
+ * Used by the producer. Time is valid from now on, drift is not changed.
+ *
+ * @param TIME This object.
+ * @param time_us Network time in microseconds since January 1, 1984.
+ */
+void CO_TIME_set(CO_TIME_t *TIME, uint64_t time_us);
+
+
+/**
+ * Get network time.
+ *
+ * Returned time never goes backwards. Function may be called from any thread.
+ *
+ * @param TIME This object.
+ *
+ * @return Network time in microseconds since January 1, 1984 or 0, if time
+ * was not yet received or set.
+ */
+uint64_t CO_TIME_get_us(CO_TIME_t *TIME);
+
+
+/**
+ * Get network time as 32 bit millisecond timestamp.
+ *
+ * @param TIME This object.
+ *
+ * @return Milliseconds since January 1, 1984, wraps around, or 0.
+ */
+uint32_t CO_TIME_getMs(CO_TIME_t *TIME);
+
+
+/**
+ * Process TIME communication.
+ *
+ * Function must be called cyclically. It evaluates received TIME message
+ * and sends TIME message, if device is producer.
+ *
+ * @param TIME This object.
+ * @param timeDifference_ms Time difference from previous function call in [milliseconds].
+ * @param timerNext_ms Return value - info to OS - see CO_process().
+ */
+void CO_TIME_process(
+        CO_TIME_t              *TIME,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
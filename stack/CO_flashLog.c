@@ -0,0 +1,402 @@
+/*
+ * Log structured storage of a data block in flash memory.
+ *
+ * @file        CO_flashLog.c
+ * @ingroup     CO_flashLog
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+
+#include "CO_driver.h"
+#include "crc16-ccitt.h"
+#include "CO_flashLog.h"
+
+#include <string.h> /* for memcpy */
+
+
+#if (CO_FLASH_LOG_ALIGN == 0U) || ((8U % CO_FLASH_LOG_ALIGN) != 0U)
+    #error CO_FLASH_LOG_ALIGN must be 1, 2, 4 or 8.
+#endif
+
+/* Marks a written page header, "CLOG". */
+#define CO_FLASH_LOG_MAGIC          0x474F4C43UL
+
+/* Size rounded up to CO_FLASH_LOG_ALIGN. */
+#define CO_FLASH_LOG_ALIGNED(size)  \
+    (((uint32_t)(size) + CO_FLASH_LOG_ALIGN - 1U) & ~((uint32_t)CO_FLASH_LOG_ALIGN - 1U))
+
+
+/*
+ * Page header, at the beginning of each page. Programmed after the snapshot.
+ */
+typedef struct{
+    uint32_t            magic;
+    uint32_t            sequence;
+}CO_flashLog_page_t;
+
+/*
+ * Record header, followed by _length_ bytes of data and padding.
+ */
+typedef struct{
+    uint16_t            offset;         /* Inside data block */
+    uint16_t            length;         /* Number of data bytes */
+    uint16_t            lengthInv;      /* ~length, detects incomplete header */
+    uint16_t            crc;            /* CRC of offset, length and data */
+}CO_flashLog_record_t;
+
+/* Changed bytes closer than this are stored in one record. */
+#define CO_FLASH_LOG_GAP            sizeof(CO_flashLog_record_t)
+
+
+/*
+ * Address of a page.
+ */
+static uint32_t CO_flashLog_pageAddress(CO_flashLog_t *log, uint16_t page){
+    return log->address + (uint32_t)page * log->pageSize;
+}
+
+
+/*
+ * Calculate CRC of a record header (without crc) and data in RAM.
+ */
+static uint16_t CO_flashLog_crc(CO_flashLog_record_t *rec, const uint8_t *data){
+    uint16_t crc;
+
+    crc = crc16_ccitt((const unsigned char *)rec, 4U, 0U);
+    return crc16_ccitt(data, rec->length, crc);
+}
+
+
+/*
+ * Program a record with data to address.
+ */
+static CO_ReturnError_t CO_flashLog_writeRecord(
+        CO_flashLog_t          *log,
+        uint32_t                address,
+        uint16_t                offset,
+        uint16_t                length,
+        const uint8_t          *data)
+{
+    CO_flashLog_record_t rec;
+    uint8_t pad[CO_FLASH_LOG_ALIGN];
+    uint16_t full;
+    CO_ReturnError_t ret;
+
+    rec.offset = offset;
+    rec.length = length;
+    rec.lengthInv = (uint16_t)~length;
+    rec.crc = CO_flashLog_crc(&rec, data);
+
+    /* Header first, so an interrupted record is never taken as free space. */
+    ret = log->pFunctProgram(log->object, address, &rec, sizeof(rec));
+    address += sizeof(rec);
+
+    full = length & (uint16_t)~(CO_FLASH_LOG_ALIGN - 1U);
+    if(ret == CO_ERROR_NO && full > 0U){
+        ret = log->pFunctProgram(log->object, address, data, full);
+        address += full;
+    }
+    if(ret == CO_ERROR_NO && full < length){
+        memset(pad, 0xFF, sizeof(pad));
+        memcpy(pad, &data[full], length - full);
+        ret = log->pFunctProgram(log->object, address, pad, sizeof(pad));
+    }
+
+    return ret;
+}
+
+
+/*
+ * Store complete data block to the next page and make it the active page.
+ */
+static CO_ReturnError_t CO_flashLog_snapshot(CO_flashLog_t *log, const uint8_t *data){
+    CO_flashLog_page_t hdr;
+    uint16_t next;
+    uint32_t address;
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    next = log->page + 1U;
+    if(next >= log->pageCount){
+        next = 0U;
+    }
+    address = CO_flashLog_pageAddress(log, next);
+
+    if(!log->nextErased){
+        ret = log->pFunctErase(log->object, address, log->pageSize);
+    }
+    log->nextErased = false;
+
+    if(ret == CO_ERROR_NO){
+        ret = CO_flashLog_writeRecord(log, address + sizeof(hdr), 0U, log->imageSize, data);
+    }
+    if(ret == CO_ERROR_NO){
+        hdr.magic = CO_FLASH_LOG_MAGIC;
+        hdr.sequence = log->sequence + 1U;
+        ret = log->pFunctProgram(log->object, address, &hdr, sizeof(hdr));
+    }
+    if(ret != CO_ERROR_NO){
+        /* Previous page is still valid */
+        return ret;
+    }
+
+    log->page = next;
+    log->sequence++;
+    log->offset = sizeof(hdr) + sizeof(CO_flashLog_record_t) + CO_FLASH_LOG_ALIGNED(log->imageSize);
+    memcpy(log->image, data, log->imageSize);
+    log->imageValid = true;
+
+    return CO_ERROR_NO;
+}
+
+
+/*
+ * Replay records of the active page into image. Sets offset behind the last
+ * valid record.
+ */
+static void CO_flashLog_replay(CO_flashLog_t *log){
+    CO_flashLog_record_t rec;
+    uint8_t buf[16];
+    uint32_t address;
+    uint32_t size;
+    uint16_t crc;
+    uint16_t i;
+    uint16_t chunk;
+
+    address = CO_flashLog_pageAddress(log, log->page);
+    log->offset = sizeof(CO_flashLog_page_t);
+
+    while((log->offset + sizeof(rec)) <= log->pageSize){
+        if(log->pFunctRead(log->object, address + log->offset, &rec, sizeof(rec)) != CO_ERROR_NO){
+            break;
+        }
+        if(rec.offset == 0xFFFFU && rec.length == 0xFFFFU &&
+           rec.lengthInv == 0xFFFFU && rec.crc == 0xFFFFU)
+        {
+            /* Free space */
+            return;
+        }
+
+        size = sizeof(rec) + CO_FLASH_LOG_ALIGNED(rec.length);
+        if((uint16_t)(rec.lengthInv ^ rec.length) != 0xFFFFU || rec.length == 0U ||
+           ((uint32_t)rec.offset + rec.length) > log->imageSize ||
+           (log->offset + size) > log->pageSize)
+        {
+            break;
+        }
+        if(!log->imageValid && (rec.offset != 0U || rec.length != log->imageSize)){
+            /* First record must be the snapshot */
+            break;
+        }
+
+        /* verify data before it is applied */
+        crc = crc16_ccitt((const unsigned char *)&rec, 4U, 0U);
+        for(i = 0U; i < rec.length; i += chunk){
+            chunk = rec.length - i;
+            if(chunk > sizeof(buf)){
+                chunk = sizeof(buf);
+            }
+            if(log->pFunctRead(log->object, address + log->offset + sizeof(rec) + i,
+                               buf, chunk) != CO_ERROR_NO)
+            {
+                break;
+            }
+            crc = crc16_ccitt(buf, chunk, crc);
+        }
+        if(i < rec.length || crc != rec.crc){
+            break;
+        }
+
+        if(log->pFunctRead(log->object, address + log->offset + sizeof(rec),
+                           &log->image[rec.offset], rec.length) != CO_ERROR_NO)
+        {
+            break;
+        }
+        log->imageValid = true;
+        log->offset += size;
+    }
+
+    /* Interrupted or invalid record, don't append behind it. Next store
+     * continues on the next page. */
+    log->offset = log->pageSize;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_flashLog_init(
+        CO_flashLog_t          *log,
+        uint32_t                address,
+        uint32_t                pageSize,
+        uint16_t                pageCount,
+        uint8_t                *image,
+        uint16_t                imageSize,
+        void                   *object,
+        CO_ReturnError_t      (*pFunctErase)(void *object, uint32_t address, uint32_t size),
+        CO_ReturnError_t      (*pFunctProgram)(void *object, uint32_t address, const void *data, uint32_t size),
+        CO_ReturnError_t      (*pFunctRead)(void *object, uint32_t address, void *data, uint32_t size))
+{
+    CO_flashLog_page_t hdr;
+    uint16_t page;
+    bool_t found = false;
+
+    /* verify arguments */
+    if(log==NULL || image==NULL || pFunctErase==NULL || pFunctProgram==NULL ||
+       pFunctRead==NULL || pageCount < 2U || imageSize == 0U || imageSize == 0xFFFFU ||
+       (address % CO_FLASH_LOG_ALIGN) != 0U || (pageSize % CO_FLASH_LOG_ALIGN) != 0U ||
+       pageSize < (sizeof(hdr) + sizeof(CO_flashLog_record_t) + CO_FLASH_LOG_ALIGNED(imageSize)))
+    {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    log->address = address;
+    log->pageSize = pageSize;
+    log->pageCount = pageCount;
+    log->image = image;
+    log->imageSize = imageSize;
+    log->imageValid = false;
+    log->nextErased = false;
+    log->object = object;
+    log->pFunctErase = pFunctErase;
+    log->pFunctProgram = pFunctProgram;
+    log->pFunctRead = pFunctRead;
+
+    /* No valid page: first store goes to page 0 */
+    log->page = pageCount - 1U;
+    log->offset = pageSize;
+    log->sequence = 0U;
+
+    /* search page with highest sequence number */
+    for(page = 0U; page < pageCount; page++){
+        if(pFunctRead(object, CO_flashLog_pageAddress(log, page), &hdr, sizeof(hdr)) != CO_ERROR_NO){
+            continue;
+        }
+        if(hdr.magic == CO_FLASH_LOG_MAGIC &&
+           (!found || (int32_t)(hdr.sequence - log->sequence) > 0))
+        {
+            found = true;
+            log->page = page;
+            log->sequence = hdr.sequence;
+        }
+    }
+
+    if(found){
+        CO_flashLog_replay(log);
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_flashLog_load(CO_flashLog_t *log, void *data){
+    if(!log->imageValid){
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    memcpy(data, log->image, log->imageSize);
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_flashLog_store(CO_flashLog_t *log, const void *data){
+    const uint8_t *d = (const uint8_t *)data;
+    uint32_t size;
+    uint16_t i;
+    uint16_t j;
+    uint16_t end;
+    CO_ReturnError_t ret;
+
+    if(!log->imageValid){
+        return CO_flashLog_snapshot(log, d);
+    }
+
+    i = 0U;
+    while(i < log->imageSize){
+        if(d[i] == log->image[i]){
+            i++;
+            continue;
+        }
+
+        /* changed region, include following changes closer than the gap */
+        end = i + 1U;
+        for(j = end; j < log->imageSize && j < (end + CO_FLASH_LOG_GAP); j++){
+            if(d[j] != log->image[j]){
+                end = j + 1U;
+            }
+        }
+
+        size = sizeof(CO_flashLog_record_t) + CO_FLASH_LOG_ALIGNED(end - i);
+        if((log->offset + size) > log->pageSize){
+            /* Page full, continue with the complete data block */
+            return CO_flashLog_snapshot(log, d);
+        }
+
+        ret = CO_flashLog_writeRecord(log, CO_flashLog_pageAddress(log, log->page) + log->offset,
+                                      i, end - i, &d[i]);
+        log->offset += size;
+        if(ret != CO_ERROR_NO){
+            /* Records behind a defective one are lost on replay */
+            log->offset = log->pageSize;
+            return ret;
+        }
+        memcpy(&log->image[i], &d[i], end - i);
+
+        i = end;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_flashLog_process(CO_flashLog_t *log){
+    uint16_t next;
+
+    if(log->nextErased || log->offset < (log->pageSize / 2U)){
+        return;
+    }
+
+    next = log->page + 1U;
+    if(next >= log->pageCount){
+        next = 0U;
+    }
+    if(log->pFunctErase(log->object, CO_flashLog_pageAddress(log, next), log->pageSize) == CO_ERROR_NO){
+        log->nextErased = true;
+    }
+}
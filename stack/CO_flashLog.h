@@ -0,0 +1,204 @@
+/**
+ * Log structured storage of a data block in flash memory.
+ *
+ * @file        CO_flashLog.h
+ * @ingroup     CO_flashLog
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+
+#ifndef CO_flashLog_H
+#define CO_flashLog_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_flashLog Flash log
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * Log structured storage of a data block (e.g. CO_OD_ROM) in flash memory.
+ *
+ * Storing a data block by erasing and rewriting a flash page on each store
+ * wears the flash and blocks the caller for the duration of the erase. The
+ * flash log instead appends only the changed bytes of the data block as
+ * a record to the active page. A store then costs some words to program.
+ *
+ * The log area consists of _pageCount_ (at least two) equally sized pages.
+ * Each page starts with a header with a sequence number, followed by
+ * records. A record consists of offset and length of the changed bytes
+ * inside the data block, CRC and the data, padded to CO_FLASH_LOG_ALIGN.
+ * The first record on each page is a snapshot of the complete data block.
+ *
+ * If the active page is full, the next page is used: the snapshot of the
+ * data block is programmed first, then the page header. An interrupted
+ * store therefore leaves either the previous page valid or an incomplete
+ * record (detected by CRC) on the active page. CO_flashLog_init() uses the
+ * page with the highest sequence number and replays its records up to the
+ * first invalid one.
+ *
+ * The next page is erased by CO_flashLog_process() in advance, when the
+ * active page is half full. If this hasn't been done, it is erased inside
+ * CO_flashLog_store().
+ *
+ * Flash access is done by callbacks, which are provided by the target
+ * driver (see CO_Flash.c).
+ */
+
+
+/**
+ * Alignment and granularity of flash programming in bytes. All records
+ * start and end at a multiple of this value.
+ */
+#ifndef CO_FLASH_LOG_ALIGN
+    #define CO_FLASH_LOG_ALIGN          4U
+#endif
+
+
+/**
+ * Flash log object.
+ */
+typedef struct{
+    uint32_t            address;        /**< From CO_flashLog_init() */
+    uint32_t            pageSize;       /**< From CO_flashLog_init() */
+    uint16_t            pageCount;      /**< From CO_flashLog_init() */
+    uint8_t            *image;          /**< From CO_flashLog_init(), data as stored in flash */
+    uint16_t            imageSize;      /**< From CO_flashLog_init() */
+    bool_t              imageValid;     /**< True, if image contains stored data */
+    uint16_t            page;           /**< Index of active page */
+    uint32_t            offset;         /**< Offset of next record in active page */
+    uint32_t            sequence;       /**< Sequence number of active page */
+    bool_t              nextErased;     /**< True, if next page is erased */
+    void               *object;         /**< From CO_flashLog_init() */
+    /** From CO_flashLog_init() */
+    CO_ReturnError_t  (*pFunctErase)(void *object, uint32_t address, uint32_t size);
+    /** From CO_flashLog_init() */
+    CO_ReturnError_t  (*pFunctProgram)(void *object, uint32_t address, const void *data, uint32_t size);
+    /** From CO_flashLog_init() */
+    CO_ReturnError_t  (*pFunctRead)(void *object, uint32_t address, void *data, uint32_t size);
+}CO_flashLog_t;
+
+
+/**
+ * Initialize flash log object and scan the log area.
+ *
+ * Function must be called before any other function. It searches the active
+ * page and restores the stored data into _image_. Use CO_flashLog_load() to
+ * get them.
+ *
+ * @param log This object will be initialized.
+ * @param address Start address of log area. Must be aligned to a page.
+ * @param pageSize Size of a page (erase unit) in bytes.
+ * @param pageCount Number of pages in log area, at least 2.
+ * @param image RAM buffer of _imageSize_ bytes, used as a copy of the data
+ * stored in flash.
+ * @param imageSize Size of data block in bytes. Snapshot must fit into a
+ * page.
+ * @param object Pointer to object, which will be passed to callbacks.
+ * @param pFunctErase Pointer to function, which erases _size_ bytes of flash
+ * starting at page aligned _address_. After erase all bytes read as 0xFF.
+ * @param pFunctProgram Pointer to function, which programs _size_ bytes of
+ * previously erased flash. _address_ and _size_ are multiples of
+ * CO_FLASH_LOG_ALIGN.
+ * @param pFunctRead Pointer to function, which reads _size_ bytes of flash.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_flashLog_init(
+        CO_flashLog_t          *log,
+        uint32_t                address,
+        uint32_t                pageSize,
+        uint16_t                pageCount,
+        uint8_t                *image,
+        uint16_t                imageSize,
+        void                   *object,
+        CO_ReturnError_t      (*pFunctErase)(void *object, uint32_t address, uint32_t size),
+        CO_ReturnError_t      (*pFunctProgram)(void *object, uint32_t address, const void *data, uint32_t size),
+        CO_ReturnError_t      (*pFunctRead)(void *object, uint32_t address, void *data, uint32_t size));
+
+
+/**
+ * Copy stored data block.
+ *
+ * @param log This object.
+ * @param data Destination of _imageSize_ bytes. Not changed, if no valid
+ * data are stored.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_DATA_CORRUPT (no valid
+ * data in log area).
+ */
+CO_ReturnError_t CO_flashLog_load(CO_flashLog_t *log, void *data);
+
+
+/**
+ * Store data block.
+ *
+ * Appends the bytes, which differ from the stored data, to the log. Nothing
+ * is programmed, if data are unchanged. If the active page is full, the
+ * complete data block is stored to the next page.
+ *
+ * @param log This object.
+ * @param data Data block of _imageSize_ bytes.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or error from callback.
+ */
+CO_ReturnError_t CO_flashLog_store(CO_flashLog_t *log, const void *data);
+
+
+/**
+ * Process flash log in background.
+ *
+ * Erases the next page in advance, so CO_flashLog_store() doesn't have to.
+ * Function blocks for the duration of a page erase, if one is done. Call it
+ * where this doesn't matter, e.g. from the mainline of the program.
+ *
+ * @param log This object.
+ */
+void CO_flashLog_process(CO_flashLog_t *log);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
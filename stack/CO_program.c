@@ -0,0 +1,462 @@
+/*
+ * Program download into flash memory (object 0x1F50).
+ *
+ * @file        CO_program.c
+ * @ingroup     CO_program
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "crc16-ccitt.h"
+#include "CO_program.h"
+
+#include <string.h> /* for memcpy */
+
+
+/*
+ * Wait, until programming of the other buffer has finished.
+ */
+static void CO_program_wait(CO_program_t *prog){
+    if(prog->pending){
+        while(prog->pFunctBusy(prog->object)){
+            ;
+        }
+        prog->pending = false;
+    }
+}
+
+
+/*
+ * Start programming of the active buffer and switch to the other one.
+ */
+static void CO_program_flush(CO_program_t *prog){
+    CO_ReturnError_t ret;
+
+    if(prog->fill == 0U){
+        return;
+    }
+    CO_program_wait(prog);
+
+    ret = prog->pFunctProgram(prog->object, prog->address, prog->buffer[prog->active], prog->fill);
+    if(ret != CO_ERROR_NO){
+        prog->error = ret;
+    }
+    else{
+        uint32_t end = prog->address - prog->startAddress + prog->fill;
+#ifdef CO_PROGRAM_MAX_BLOCKS
+        uint32_t block = (prog->address - prog->startAddress) / CO_PROGRAM_BUFFER_SIZE;
+
+        if(block < CO_PROGRAM_MAX_BLOCKS){
+            prog->blockCrc[block] = crc16_ccitt(prog->buffer[prog->active], prog->fill, 0U);
+        }
+#endif
+        if(end > prog->imageEnd){
+            prog->imageEnd = end;
+        }
+        prog->pending = true;
+    }
+    prog->address += prog->fill;
+    prog->active ^= 1U;
+    prog->fill = 0U;
+}
+
+
+/*
+ * Add bytes of the image to the programming buffers.
+ */
+static void CO_program_put(CO_program_t *prog, const uint8_t *data, uint32_t len){
+    if(prog->error == CO_ERROR_NO && (prog->offset + prog->size + len) > prog->maxSize){
+        prog->error = CO_ERROR_OUT_OF_MEMORY;
+    }
+
+    if(prog->error == CO_ERROR_NO){
+        prog->crc = crc16_ccitt(data, len, prog->crc);
+        prog->size += len;
+
+        while(len > 0U){
+            uint32_t n = CO_PROGRAM_BUFFER_SIZE - prog->fill;
+
+            if(n > len){
+                n = len;
+            }
+            memcpy(&prog->buffer[prog->active][prog->fill], data, n);
+            prog->fill += n;
+            data += n;
+            len -= n;
+            if(prog->fill == CO_PROGRAM_BUFFER_SIZE){
+                CO_program_flush(prog);
+            }
+        }
+    }
+}
+
+
+#ifdef CO_PROGRAM_COMPRESSED
+/* Elements of the compressed stream */
+#define CO_PROGRAM_DEC_TAG          0U
+#define CO_PROGRAM_DEC_LITERAL      1U
+#define CO_PROGRAM_DEC_INDEX        2U
+#define CO_PROGRAM_DEC_COUNT        3U
+
+#define CO_PROGRAM_WINDOW_MASK      ((1U << CO_PROGRAM_WINDOW_BITS) - 1U)
+
+/*
+ * Add decompressed byte to the window and to the programming buffers.
+ */
+static void CO_program_output(CO_program_t *prog, uint8_t value){
+    prog->window[prog->windowPos] = value;
+    prog->windowPos = (prog->windowPos + 1U) & CO_PROGRAM_WINDOW_MASK;
+    CO_program_put(prog, &value, 1U);
+}
+
+
+/*
+ * Decompress received part of the stream. State of the decoder is kept
+ * between calls, elements may be split over segments.
+ */
+static void CO_program_decompress(CO_program_t *prog, const uint8_t *data, uint32_t len){
+    static const uint8_t need[4] = {1U, 8U, CO_PROGRAM_WINDOW_BITS, CO_PROGRAM_LOOKAHEAD_BITS};
+
+    while(prog->error == CO_ERROR_NO){
+        uint8_t n = need[prog->decodeState];
+        uint16_t value;
+
+        if(prog->bitCount < n){
+            if(len == 0U){
+                break;
+            }
+            prog->bits = (prog->bits << 8U) | *data++;
+            prog->bitCount += 8U;
+            len--;
+            continue;
+        }
+        prog->bitCount -= n;
+        value = (uint16_t)((prog->bits >> prog->bitCount) & ((1UL << n) - 1U));
+
+        switch(prog->decodeState){
+        case CO_PROGRAM_DEC_TAG:
+            prog->decodeState = (value != 0U) ? CO_PROGRAM_DEC_LITERAL : CO_PROGRAM_DEC_INDEX;
+            break;
+        case CO_PROGRAM_DEC_LITERAL:
+            CO_program_output(prog, (uint8_t)value);
+            prog->decodeState = CO_PROGRAM_DEC_TAG;
+            break;
+        case CO_PROGRAM_DEC_INDEX:
+            prog->backrefIndex = value;
+            prog->decodeState = CO_PROGRAM_DEC_COUNT;
+            break;
+        default:{
+            /* copy value + 1 bytes from backrefIndex + 1 bytes before */
+            uint16_t pos = (prog->windowPos - prog->backrefIndex - 1U) & CO_PROGRAM_WINDOW_MASK;
+            uint16_t i;
+
+            for(i=0U; i<=value; i++){
+                CO_program_output(prog, prog->window[pos]);
+                pos = (pos + 1U) & CO_PROGRAM_WINDOW_MASK;
+            }
+            prog->decodeState = CO_PROGRAM_DEC_TAG;
+            break;
+        }
+        }
+    }
+}
+#endif
+
+
+/*
+ * Download of the image into the programming buffers. Called with the content
+ * of the SDO buffer, each time it is full and at the end of the download.
+ */
+static CO_SDO_abortCode_t CO_program_download(CO_ODF_arg_t *ODF_arg, bool_t compressed){
+    CO_program_t *prog;
+    const uint8_t *data;
+    uint32_t len;
+
+    prog = (CO_program_t*) ODF_arg->object;
+    data = ODF_arg->data;
+    len = ODF_arg->dataLength;
+
+    if(ODF_arg->reading){
+        return CO_SDO_AB_WRITEONLY;
+    }
+
+    if(ODF_arg->firstSegment){
+        /* previous download may have been aborted while programming */
+        CO_program_wait(prog);
+        prog->active = 0U;
+        prog->fill = 0U;
+        prog->offset = prog->repairOffset;
+        prog->repairOffset = 0U;
+        prog->address = prog->startAddress + prog->offset;
+        prog->size = 0U;
+        prog->crc = 0U;
+        prog->error = CO_ERROR_NO;
+        prog->valid = false;
+        prog->downloading = true;
+        if(prog->offset == 0U){
+            /* new image */
+            prog->imageEnd = 0U;
+#ifdef CO_PROGRAM_MAX_BLOCKS
+            memset(prog->blockCrc, 0, sizeof(prog->blockCrc));
+#endif
+        }
+#ifdef CO_PROGRAM_COMPRESSED
+        prog->compressed = compressed;
+        memset(prog->window, 0, sizeof(prog->window));
+        prog->windowPos = 0U;
+        prog->bits = 0U;
+        prog->bitCount = 0U;
+        prog->decodeState = CO_PROGRAM_DEC_TAG;
+#endif
+    }
+#ifndef CO_PROGRAM_COMPRESSED
+    (void)compressed;
+#endif
+
+#ifdef CO_PROGRAM_COMPRESSED
+    if(prog->compressed){
+        CO_program_decompress(prog, data, len);
+    }
+    else
+#endif
+    {
+        CO_program_put(prog, data, len);
+    }
+
+    if(ODF_arg->lastSegment){
+        /* program the rest and report the result of the whole download */
+        if(prog->error == CO_ERROR_NO){
+            CO_program_flush(prog);
+        }
+        CO_program_wait(prog);
+        if(prog->error == CO_ERROR_NO && prog->offset == 0U && prog->pFunctFinish != NULL){
+            prog->error = prog->pFunctFinish(prog->object, prog->size, prog->crc);
+        }
+        prog->valid = (prog->error == CO_ERROR_NO) ? true : false;
+    }
+
+    if(prog->error == CO_ERROR_OUT_OF_MEMORY){
+        return CO_SDO_AB_OUT_OF_MEM;
+    }
+    if(prog->error != CO_ERROR_NO){
+        return CO_SDO_AB_HW;
+    }
+    return CO_SDO_AB_NONE;
+}
+
+
+/*
+ * Function for accessing _Program data_ (index 0x1F50) from SDO server.
+ */
+static CO_SDO_abortCode_t CO_ODF_program(CO_ODF_arg_t *ODF_arg){
+    return CO_program_download(ODF_arg, false);
+}
+
+
+#ifdef CO_PROGRAM_COMPRESSED
+/*
+ * Function for accessing the domain for compressed images from SDO server.
+ */
+static CO_SDO_abortCode_t CO_ODF_programCompressed(CO_ODF_arg_t *ODF_arg){
+    return CO_program_download(ODF_arg, true);
+}
+#endif
+
+
+#ifdef CO_PROGRAM_MAX_BLOCKS
+/*
+ * Function for accessing the repair object from SDO server. Sub-index 1 is
+ * the CRC list, which is generated in segments of CO_SDO_BUFFER_SIZE, sub-index
+ * 2 the offset for the next download.
+ */
+static CO_SDO_abortCode_t CO_ODF_programRepair(CO_ODF_arg_t *ODF_arg){
+    CO_program_t *prog;
+
+    prog = (CO_program_t*) ODF_arg->object;
+
+    if(ODF_arg->subIndex == 2U){
+        uint32_t value;
+
+        if(ODF_arg->reading){
+            CO_setUint32(ODF_arg->data, prog->repairOffset);
+            return CO_SDO_AB_NONE;
+        }
+        value = CO_getUint32(ODF_arg->data);
+        if((value % CO_PROGRAM_BUFFER_SIZE) != 0U || value >= prog->maxSize){
+            return CO_SDO_AB_INVALID_VALUE;
+        }
+        prog->repairOffset = value;
+    }
+    else if(ODF_arg->subIndex == 1U){
+        uint32_t count;
+        uint32_t total;
+        uint32_t len;
+        uint32_t i;
+
+        if(!ODF_arg->reading){
+            return CO_SDO_AB_READONLY;
+        }
+
+        count = (prog->imageEnd + CO_PROGRAM_BUFFER_SIZE - 1U) / CO_PROGRAM_BUFFER_SIZE;
+        if(count > CO_PROGRAM_MAX_BLOCKS){
+            count = CO_PROGRAM_MAX_BLOCKS;
+        }
+        total = 6U + count * 2U;
+        if(ODF_arg->firstSegment){
+            prog->listOffset = 0U;
+            ODF_arg->dataLengthTotal = total;
+        }
+
+        len = total - prog->listOffset;
+        if(len > CO_SDO_BUFFER_SIZE){
+            len = CO_SDO_BUFFER_SIZE;
+        }
+        for(i=0U; i<len; i++){
+            uint32_t pos = prog->listOffset + i;
+            uint32_t value;
+
+            if(pos < 4U){
+                value = CO_PROGRAM_BUFFER_SIZE >> (pos * 8U);
+            }
+            else if(pos < 6U){
+                value = count >> ((pos - 4U) * 8U);
+            }
+            else{
+                value = (uint32_t)prog->blockCrc[(pos - 6U) / 2U] >> (((pos - 6U) % 2U) * 8U);
+            }
+            ODF_arg->data[i] = (uint8_t)value;
+        }
+        prog->listOffset += len;
+        ODF_arg->dataLength = (uint16_t)len;
+        ODF_arg->lastSegment = (prog->listOffset == total) ? true : false;
+    }
+    else{
+        return CO_SDO_AB_SUB_UNKNOWN;
+    }
+
+    return CO_SDO_AB_NONE;
+}
+#endif
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_program_init(
+        CO_program_t           *prog,
+        CO_SDO_t               *SDO,
+        uint16_t                index,
+        uint32_t                startAddress,
+        uint32_t                maxSize,
+        void                   *object,
+        CO_ReturnError_t      (*pFunctProgram)(void *object, uint32_t address, const void *data, uint32_t size),
+        bool_t                (*pFunctBusy)(void *object),
+        CO_ReturnError_t      (*pFunctFinish)(void *object, uint32_t size, uint16_t crc))
+{
+    /* verify arguments */
+    if(prog==NULL || SDO==NULL || pFunctProgram==NULL || pFunctBusy==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    prog->active = 0U;
+    prog->fill = 0U;
+    prog->pending = false;
+    prog->address = startAddress;
+    prog->startAddress = startAddress;
+    prog->maxSize = maxSize;
+    prog->size = 0U;
+    prog->crc = 0U;
+    prog->error = CO_ERROR_NO;
+    prog->valid = false;
+    prog->downloading = false;
+    prog->offset = 0U;
+    prog->repairOffset = 0U;
+    prog->imageEnd = 0U;
+    prog->SDO = SDO;
+#ifdef CO_PROGRAM_MAX_BLOCKS
+    memset(prog->blockCrc, 0, sizeof(prog->blockCrc));
+    prog->listOffset = 0U;
+#endif
+#ifdef CO_PROGRAM_COMPRESSED
+    prog->compressed = false;
+#endif
+    prog->object = object;
+    prog->pFunctProgram = pFunctProgram;
+    prog->pFunctBusy = pFunctBusy;
+    prog->pFunctFinish = pFunctFinish;
+
+    CO_OD_configure(SDO, index, CO_ODF_program, (void*)prog, 0, 0U);
+
+    return CO_ERROR_NO;
+}
+
+
+#ifdef CO_PROGRAM_MAX_BLOCKS
+/******************************************************************************/
+void CO_program_initRepair(CO_program_t *prog, uint16_t index){
+    if(prog != NULL && prog->SDO != NULL){
+        CO_OD_configure(prog->SDO, index, CO_ODF_programRepair, (void*)prog, 0, 0U);
+    }
+}
+#endif
+
+
+#ifdef CO_PROGRAM_COMPRESSED
+/******************************************************************************/
+void CO_program_initCompressed(CO_program_t *prog, uint16_t index){
+    if(prog != NULL && prog->SDO != NULL){
+        CO_OD_configure(prog->SDO, index, CO_ODF_programCompressed, (void*)prog, 0, 0U);
+    }
+}
+#endif
+
+
+/******************************************************************************/
+bool_t CO_program_process(CO_program_t *prog){
+    if(prog == NULL || !prog->downloading || prog->SDO->state != CO_SDO_ST_IDLE){
+        return false;
+    }
+
+    /* download has finished or was aborted, let the last buffer complete */
+    CO_program_wait(prog);
+    prog->downloading = false;
+    return true;
+}
@@ -0,0 +1,282 @@
+/**
+ * Program download into flash memory (object 0x1F50).
+ *
+ * @file        CO_program.h
+ * @ingroup     CO_program
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+
+
+#ifndef CO_program_H
+#define CO_program_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_program Program download
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * Download of a firmware image into flash memory by SDO (CiA 302-3 object
+ * 0x1F50, program data), typically used by a bootloader.
+ *
+ * Image is written to the domain 0x1F50 by SDO download. SDO block download
+ * should be used with #CO_SDO_BUFFER_SIZE of 889 bytes, so each block of 127
+ * segments is passed to the object with one call of the @ref CO_SDO_OD_function.
+ *
+ * Received data are collected in two buffers of #CO_PROGRAM_BUFFER_SIZE
+ * bytes. If a buffer is full, its programming is started by the
+ * _pFunctProgram_ callback, which must not wait for completion, and the
+ * other buffer is filled. SDO server acknowledges the block immediately, so
+ * the next block is received while flash is programmed. The function waits
+ * only when both buffers are full, because flash is slower than CAN, and at
+ * the end of the download, so the SDO response reports the result of the
+ * whole download.
+ *
+ * CRC of the image (CRC-16 CCITT, same as SDO block transfer) and its size
+ * are passed to the _pFunctFinish_ callback, where the bootloader can verify
+ * the image before it is marked valid.
+ *
+ * Identical nodes can be programmed at the same time, if the CAN driver
+ * supports it (see CO_CANrxBufferRemap() and CO_CANtxBufferSetSilent() in the
+ * neuberger-bootloader driver). All nodes receive the download on a common
+ * SDO COB-ID, only one node responds. A node, which misses a segment, can't
+ * request it again and its download fails. Each node must therefore be
+ * verified after the download, see CO_program_initRepair(). Nodes leave the
+ * multicast mode, when CO_program_process() indicates the end of the download.
+ *
+ * Repair object (configured with CO_program_initRepair()) has two sub-indexes:
+ *  - 1, domain, read only: list of CRCs of all programmed blocks. It contains
+ *    UNSIGNED32 block size (#CO_PROGRAM_BUFFER_SIZE), UNSIGNED16 number of
+ *    blocks and an UNSIGNED16 CRC-16 CCITT for each block. Last block may be
+ *    shorter, CRC is calculated over its programmed size.
+ *  - 2, UNSIGNED32, read/write: offset for the next download into 0x1F50, a
+ *    multiple of the block size. Download then only programs and updates the
+ *    blocks it covers, offset is reset to 0 when the download starts.
+ *
+ * A master (see CO_SDObroadcast) compares the list with the CRCs of its image
+ * and downloads only the blocks, which differ or are missing.
+ *
+ * If #CO_PROGRAM_COMPRESSED is defined, a compressed image may be written to
+ * a second domain, see CO_program_initCompressed(). Stream is decompressed
+ * while it is received, directly into the programming buffers, so only a
+ * window of the last 2^#CO_PROGRAM_WINDOW_BITS decompressed bytes is needed
+ * in addition. Format is the one of heatshrink (LZSS bitstream, created with
+ * "heatshrink -e -w 8 -l 4" for the default parameters): tag bit 1 is
+ * followed by a literal byte, tag bit 0 by a back-reference with
+ * #CO_PROGRAM_WINDOW_BITS bits index and #CO_PROGRAM_LOOKAHEAD_BITS bits
+ * count, most significant bit first. Incomplete bits at the end are padding.
+ * Size, CRC, maximum size and repair offset always refer to the decompressed
+ * image, a repaired range is compressed on its own.
+ */
+
+
+/**
+ * Size of one programming buffer in bytes. It should be a multiple of the
+ * flash programming unit. Two buffers are used.
+ */
+#ifndef CO_PROGRAM_BUFFER_SIZE
+    #define CO_PROGRAM_BUFFER_SIZE      1024U
+#endif
+
+
+/**
+ * Maximum number of blocks of #CO_PROGRAM_BUFFER_SIZE in the image, for which
+ * a CRC is kept for the repair object. If not defined, CO_program_initRepair()
+ * is not available. Needs two bytes of RAM per block.
+ */
+/* #define CO_PROGRAM_MAX_BLOCKS       512U */
+
+
+/**
+ * If defined, compressed images can be downloaded, see
+ * CO_program_initCompressed().
+ */
+/* #define CO_PROGRAM_COMPRESSED */
+
+#ifdef CO_PROGRAM_COMPRESSED
+/** Window size of compressed images, 2^bits bytes of RAM, 4 to 15 */
+#ifndef CO_PROGRAM_WINDOW_BITS
+    #define CO_PROGRAM_WINDOW_BITS      8U
+#endif
+/** Bits of the back-reference count of compressed images, 3 to window bits - 1 */
+#ifndef CO_PROGRAM_LOOKAHEAD_BITS
+    #define CO_PROGRAM_LOOKAHEAD_BITS   4U
+#endif
+#endif
+
+
+/**
+ * Program download object.
+ */
+typedef struct{
+    /** Programming buffers, one is filled, other may be programmed */
+    uint8_t             buffer[2][CO_PROGRAM_BUFFER_SIZE];
+    uint8_t             active;         /**< Index of buffer being filled */
+    uint32_t            fill;           /**< Number of bytes in active buffer */
+    bool_t              pending;        /**< True, if other buffer is being programmed */
+    uint32_t            address;        /**< Flash address of active buffer */
+    uint32_t            startAddress;   /**< From CO_program_init() */
+    uint32_t            maxSize;        /**< From CO_program_init() */
+    uint32_t            size;           /**< Number of bytes received in current download */
+    uint16_t            crc;            /**< CRC of bytes received in current download */
+    CO_ReturnError_t    error;          /**< First error of current download */
+    bool_t              valid;          /**< True, after successful download */
+    bool_t              downloading;    /**< True from first segment until CO_program_process() sees SDO idle */
+    uint32_t            offset;         /**< Offset of current download in the image */
+    uint32_t            repairOffset;   /**< Offset for next download, from repair object */
+    uint32_t            imageEnd;       /**< Highest programmed offset + 1 */
+    CO_SDO_t           *SDO;            /**< From CO_program_init() */
+#ifdef CO_PROGRAM_MAX_BLOCKS
+    uint16_t            blockCrc[CO_PROGRAM_MAX_BLOCKS]; /**< CRC of each programmed block */
+    uint32_t            listOffset;     /**< Next byte of CRC list by upload */
+#endif
+#ifdef CO_PROGRAM_COMPRESSED
+    bool_t              compressed;     /**< True, if current download is compressed */
+    uint8_t             window[1U << CO_PROGRAM_WINDOW_BITS]; /**< Last decompressed bytes */
+    uint16_t            windowPos;      /**< Position of next byte in window */
+    uint32_t            bits;           /**< Received bits, not yet decoded */
+    uint8_t             bitCount;       /**< Number of valid bits in bits */
+    uint8_t             decodeState;    /**< Next element expected in the stream */
+    uint16_t            backrefIndex;   /**< Index of the back-reference being decoded */
+#endif
+    void               *object;         /**< From CO_program_init() */
+    /** From CO_program_init() */
+    CO_ReturnError_t  (*pFunctProgram)(void *object, uint32_t address, const void *data, uint32_t size);
+    /** From CO_program_init() */
+    bool_t            (*pFunctBusy)(void *object);
+    /** From CO_program_init() */
+    CO_ReturnError_t  (*pFunctFinish)(void *object, uint32_t size, uint16_t crc);
+}CO_program_t;
+
+
+/**
+ * Initialize program download object.
+ *
+ * Function must be called in the communication reset section, after
+ * CO_SDO_init().
+ *
+ * @param prog This object will be initialized.
+ * @param SDO SDO server object.
+ * @param index Index of program data domain in Object dictionary, usually
+ * 0x1F50. Subindex is not verified.
+ * @param startAddress Flash address of the image.
+ * @param maxSize Size of flash area for the image. Larger downloads are
+ * aborted.
+ * @param object Pointer to object, which will be passed to callbacks.
+ * @param pFunctProgram Pointer to function, which starts programming of
+ * _size_ bytes to _address_ and returns without waiting. _data_ stays
+ * unchanged, until _pFunctBusy_ returns false. Area must be erased by the
+ * function or before the download.
+ * @param pFunctBusy Pointer to function, which returns true, while
+ * programming is in progress.
+ * @param pFunctFinish Pointer to function, which is called after the last
+ * byte is programmed, with size and CRC of the image, or NULL. If it returns
+ * error, download is aborted. It is not called for downloads with offset from
+ * the repair object, those are verified by the CRC list.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_program_init(
+        CO_program_t           *prog,
+        CO_SDO_t               *SDO,
+        uint16_t                index,
+        uint32_t                startAddress,
+        uint32_t                maxSize,
+        void                   *object,
+        CO_ReturnError_t      (*pFunctProgram)(void *object, uint32_t address, const void *data, uint32_t size),
+        bool_t                (*pFunctBusy)(void *object),
+        CO_ReturnError_t      (*pFunctFinish)(void *object, uint32_t size, uint16_t crc));
+
+
+#ifdef CO_PROGRAM_MAX_BLOCKS
+/**
+ * Configure repair object for verification by a master after multicast
+ * download.
+ *
+ * Function must be called after CO_program_init().
+ *
+ * @param prog This object.
+ * @param index Index of the repair object in Object dictionary. It must have
+ * sub-index 1 (domain) and 2 (UNSIGNED32).
+ */
+void CO_program_initRepair(CO_program_t *prog, uint16_t index);
+#endif
+
+
+#ifdef CO_PROGRAM_COMPRESSED
+/**
+ * Configure domain for download of compressed images.
+ *
+ * Function must be called after CO_program_init(). Download to this domain
+ * programs the same flash area as the program data domain.
+ *
+ * @param prog This object.
+ * @param index Index of the domain in Object dictionary, manufacturer
+ * specific. Subindex is not verified.
+ */
+void CO_program_initCompressed(CO_program_t *prog, uint16_t index);
+#endif
+
+
+/**
+ * Process program download object.
+ *
+ * Function must be called cyclically. It detects the end of a download,
+ * also of a download, which was aborted or timed out in the SDO server. In
+ * this case programming of the last buffer is finished first.
+ *
+ * @param prog This object.
+ *
+ * @return True once after the end of each download. CO_program_t::valid
+ * indicates the result.
+ */
+bool_t CO_program_process(CO_program_t *prog);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
@@ -0,0 +1,137 @@
+/*
+ * CANopen receive ring - lock-free message queue for CAN receive callbacks.
+ *
+ * @file        CO_rxRing.c
+ * @ingroup     CO_rxRing
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_rxRing.h"
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_rxRing_init(
+        CO_rxRing_t            *ring,
+        CO_rxRingMsg_t          msgs[],
+        uint16_t                size)
+{
+    /* verify arguments */
+    if(ring==NULL || msgs==NULL || size<2U){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    ring->msgs = msgs;
+    ring->size = size;
+    ring->head = 0U;
+    ring->tail = 0U;
+    ring->overflowCount = 0U;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+bool_t CO_rxRing_put(CO_rxRing_t *ring, const CO_CANrxMsg_t *msg){
+    uint16_t head = ring->head;
+    uint16_t next = head + 1U;
+    CO_rxRingMsg_t *rxMsg;
+    uint8_t i;
+
+    if(next >= ring->size){
+        next = 0U;
+    }
+
+    /* ring is full */
+    if(next == ring->tail){
+        ring->overflowCount++;
+        return false;
+    }
+
+    /* copy message into free element, then publish it by moving head */
+    rxMsg = &ring->msgs[head];
+    rxMsg->DLC = msg->DLC;
+    for(i=0U; i<8U; i++){
+        rxMsg->data[i] = msg->data[i];
+    }
+
+    CANrxMemoryBarrier();
+    ring->head = next;
+
+    return true;
+}
+
+
+/******************************************************************************/
+const CO_rxRingMsg_t *CO_rxRing_peek(CO_rxRing_t *ring){
+    uint16_t tail = ring->tail;
+
+    if(tail == ring->head){
+        return NULL;
+    }
+
+    /* don't read the message before head */
+    CANrxMemoryBarrier();
+    return &ring->msgs[tail];
+}
+
+
+/******************************************************************************/
+void CO_rxRing_pop(CO_rxRing_t *ring){
+    uint16_t tail = ring->tail;
+
+    if(tail != ring->head){
+        tail++;
+        if(tail >= ring->size){
+            tail = 0U;
+        }
+
+        /* message must be read completely, before element is released */
+        CANrxMemoryBarrier();
+        ring->tail = tail;
+    }
+}
+
+
+/******************************************************************************/
+bool_t CO_rxRing_isEmpty(const CO_rxRing_t *ring){
+    return (ring->tail == ring->head) ? true : false;
+}
@@ -0,0 +1,171 @@
+/**
+ * CANopen receive ring - lock-free message queue for CAN receive callbacks.
+ *
+ * @file        CO_rxRing.h
+ * @ingroup     CO_rxRing
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_rxRing_H
+#define CO_rxRing_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_rxRing Receive ring
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * Single producer, single consumer ring buffer for received CAN messages.
+ *
+ * CAN receive callbacks usually copy the message into a single buffer and set
+ * a CANrxNew flag. If the next message arrives before the mainline function
+ * processed the previous one, it is lost. A receive ring queues such bursts
+ * between receive thread (producer, calls CO_rxRing_put()) and mainline
+ * thread (consumer, calls CO_rxRing_peek() and CO_rxRing_pop()).
+ *
+ * Each side writes only its own index, so no locking is necessary, only
+ * CANrxMemoryBarrier() from CO_driver.h. There must be exactly one producer
+ * and one consumer per ring. Depth of the ring is configured by the size of
+ * the array given to CO_rxRing_init(), one element is always kept free, so
+ * the ring holds up to size - 1 messages.
+ */
+
+
+/**
+ * Message inside receive ring.
+ */
+typedef struct{
+    /** Length of CAN message */
+    uint8_t             DLC;
+    /** 8 data bytes */
+    uint8_t             data[8];
+}CO_rxRingMsg_t;
+
+
+/**
+ * Receive ring object.
+ */
+typedef struct{
+    /** From CO_rxRing_init() */
+    CO_rxRingMsg_t     *msgs;
+    /** From CO_rxRing_init() */
+    uint16_t            size;
+    /** Index of next free element, written only by producer */
+    volatile uint16_t   head;
+    /** Index of oldest message, written only by consumer */
+    volatile uint16_t   tail;
+    /** Number of messages dropped because ring was full, written only by producer */
+    volatile uint16_t   overflowCount;
+}CO_rxRing_t;
+
+
+/**
+ * Initialize receive ring object.
+ *
+ * Function must be called before the ring is used by receive callback.
+ *
+ * @param ring This object will be initialized.
+ * @param msgs Array of messages, defined by application.
+ * @param size Number of elements in msgs, at least 2.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_rxRing_init(
+        CO_rxRing_t            *ring,
+        CO_rxRingMsg_t          msgs[],
+        uint16_t                size);
+
+
+/**
+ * Add received message to the ring.
+ *
+ * Function is called by producer, usually from CAN receive callback.
+ *
+ * @param ring This object.
+ * @param msg Received CAN message.
+ *
+ * @return True on success, false if ring is full and message was dropped.
+ */
+bool_t CO_rxRing_put(CO_rxRing_t *ring, const CO_CANrxMsg_t *msg);
+
+
+/**
+ * Get oldest message from the ring.
+ *
+ * Function is called by consumer. Message stays in the ring until
+ * CO_rxRing_pop() is called.
+ *
+ * @param ring This object.
+ *
+ * @return Pointer to the message or NULL, if ring is empty.
+ */
+const CO_rxRingMsg_t *CO_rxRing_peek(CO_rxRing_t *ring);
+
+
+/**
+ * Remove oldest message from the ring.
+ *
+ * Function is called by consumer after message from CO_rxRing_peek() was
+ * processed.
+ *
+ * @param ring This object.
+ */
+void CO_rxRing_pop(CO_rxRing_t *ring);
+
+
+/**
+ * Verify if ring is empty.
+ *
+ * @param ring This object.
+ *
+ * @return True, if there is no message in the ring.
+ */
+bool_t CO_rxRing_isEmpty(const CO_rxRing_t *ring);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
@@ -0,0 +1,164 @@
+/*
+ * Per-service CAN message counters.
+ *
+ * @file        CO_statistics.c
+ * @ingroup     CO_statistics
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_statistics.h"
+
+#ifdef CO_USE_STATISTICS
+
+#include <string.h>
+
+
+CO_statistics_t *CO_statistics = NULL;
+volatile uint32_t CO_statistics_time_us = 0U;
+
+
+/******************************************************************************/
+void CO_statistics_init(
+        CO_statistics_t        *stats,
+        CO_CANmodule_t         *CANmodule,
+        uint32_t                rxCount[],
+        uint16_t                rxSize,
+        uint32_t                txCount[],
+        uint16_t                txSize,
+        uint16_t                bitRate)
+{
+    CO_statistics_t **last;
+
+    if((stats == NULL) || (rxCount == NULL) || (txCount == NULL)){
+        return;
+    }
+
+    stats->CANmodule = CANmodule;
+    stats->rxCount = rxCount;
+    stats->rxSize = rxSize;
+    stats->txCount = txCount;
+    stats->txSize = txSize;
+    stats->bitRate = bitRate;
+    CO_statistics_reset(stats);
+
+    /* append to the list, if not there yet (communication reset) */
+    for(last = &CO_statistics; *last != NULL; last = &(*last)->next){
+        if(*last == stats){
+            return;
+        }
+    }
+    stats->next = NULL;
+    *last = stats;
+}
+
+
+/******************************************************************************/
+void CO_statistics_remove(CO_statistics_t *stats){
+    CO_statistics_t **prev;
+
+    for(prev = &CO_statistics; *prev != NULL; prev = &(*prev)->next){
+        if(*prev == stats){
+            *prev = stats->next;
+            return;
+        }
+    }
+}
+
+
+/******************************************************************************/
+void CO_statistics_reset(CO_statistics_t *stats){
+    if(stats != NULL){
+        uint16_t i;
+
+        memset(stats->rxCount, 0, stats->rxSize * sizeof(uint32_t));
+        memset(stats->txCount, 0, stats->txSize * sizeof(uint32_t));
+        for(i = 0; i < (CO_STAT_BUS_SLOTS + 1U); i++){
+            __atomic_store_n(&stats->busSlots[i], 0U, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+
+/******************************************************************************/
+uint16_t CO_statistics_busLoad(CO_statistics_t *stats, CO_statistics_busWindow_t window){
+    uint32_t slot;
+    uint32_t bits;
+    uint32_t capacity;
+    uint16_t count;
+    uint16_t i;
+
+    if(stats == NULL || stats->bitRate == 0U){
+        return 0;
+    }
+
+    switch(window){
+        case CO_STAT_BUS_10MS:
+            count = 1U;
+            break;
+        case CO_STAT_BUS_100MS:
+            count = 10U;
+            break;
+        default:
+            count = CO_STAT_BUS_SLOTS;
+            break;
+    }
+    /* bit rate in kbit/s is the number of bits per millisecond */
+    capacity = (uint32_t)stats->bitRate * (CO_STAT_BUS_SLOT_US / 1000U) * count;
+
+    /* complete slots before the current one, slots from a previous round or
+     * without any frame are idle */
+    slot = CO_STAT_TIMESTAMP_US() / CO_STAT_BUS_SLOT_US;
+    bits = 0;
+    for(i = 1U; i <= count; i++){
+        uint32_t s = slot - i;
+        uint32_t entry = __atomic_load_n(&stats->busSlots[s % (CO_STAT_BUS_SLOTS + 1U)],
+                                         __ATOMIC_RELAXED);
+
+        if((entry & 0xFFFF0000U) == (s << 16)){
+            bits += entry & 0xFFFFU;
+        }
+    }
+
+    bits = (uint32_t)(((uint64_t)bits * 1000U) / capacity);
+    return (bits > 1000U) ? 1000U : (uint16_t)bits;
+}
+
+#endif /* CO_USE_STATISTICS */
@@ -0,0 +1,311 @@
+/**
+ * Per-service CAN message counters.
+ *
+ * @file        CO_statistics.h
+ * @ingroup     CO_statistics
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_statistics_H
+#define CO_statistics_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_statistics Statistics
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * Counters of received and transmitted CAN messages per CANopen service.
+ *
+ * Statistics are enabled by defining CO_USE_STATISTICS. Otherwise
+ * CO_STAT_RX() and CO_STAT_TX() expand to nothing.
+ *
+ * The driver counts each message with the index of its buffer: CO_STAT_RX()
+ * before the receive callback is called, CO_STAT_TX() when a message is
+ * written to the CAN controller. Messages queued in a full buffer are counted
+ * later, when the driver hands them over from the transmit interrupt. Only CAN modules given to CO_statistics_init()
+ * are counted, each into its own object. Buffer indexes are translated to services
+ * (NMT, SYNC, PDO channel, ...) by the owner of the buffer layout, see
+ * CO_ODF_statistics() in CANopen.c.
+ *
+ * Additionally CO_PDO.c stores the last latency and the number of missed
+ * deadlines of each PDO, see CO_RPDO_t and CO_TPDO_t. Times are taken from
+ * CO_STAT_TIMESTAMP_US(), which may be defined by the target. Default is a
+ * time base in microseconds, which is advanced by CO_statistics_addTime() from
+ * CO_process_SYNC_RPDO(). Its resolution is the interval of the realtime
+ * thread. Reception times are taken from CO_STAT_RX_TIMESTAMP_US() inside the
+ * receive callback. A driver may define it to return the time when the message
+ * actually arrived, together with a matching CO_STAT_TIMESTAMP_US().
+ *
+ * ###Bus load
+ *
+ * The driver also calls CO_STAT_BUS() for each received frame, before the
+ * receive buffer is searched, and for each frame accepted for transmission.
+ * Length of the frame on the bus is estimated by CO_STAT_BUS_FRAME_BITS() and
+ * added to slots of CO_STAT_BUS_SLOT_US, taken from CO_STAT_TIMESTAMP_US().
+ * The last CO_STAT_BUS_SLOTS complete slots give sliding windows of 10 ms,
+ * 100 ms and 1 s, see CO_statistics_busLoad(). Frames dropped by hardware
+ * filters are not seen by the driver and are not counted.
+ *
+ * Each slot is tagged with its number. The first frame of a slot replaces the
+ * content from the previous round with an atomic compare and swap, so receive
+ * and transmit context may count concurrently. CO_statistics_busLoad() only
+ * reads the slots and may be called from any thread. This requires GCC
+ * compatible __atomic builtins. For up to 1 s after CO_STAT_TIMESTAMP_US()
+ * wraps around, slots before the wrap are not counted.
+ */
+
+
+#ifdef CO_USE_STATISTICS
+
+#ifndef CO_STAT_TIMESTAMP_US
+/** Current time in microseconds, 32 bit, wraps around. */
+#define CO_STAT_TIMESTAMP_US()  (CO_statistics_time_us)
+#endif
+
+#ifndef CO_STAT_RX_TIMESTAMP_US
+/** Reception time of the received CAN message _msg_ in microseconds. */
+#define CO_STAT_RX_TIMESTAMP_US(msg)  CO_STAT_TIMESTAMP_US()
+#endif
+
+#ifndef CO_STAT_BUS_FRAME_BITS
+/**
+ * Bits of a data frame with 11 bit identifier and _len_ (0...8) data bytes.
+ *
+ * 44 + 8 * len bits of the frame, 3 bits interframe space and the worst case
+ * number of stuff bits. Worst case keeps the estimate on the safe side for
+ * scheduling, a target may define a different estimate.
+ */
+#define CO_STAT_BUS_FRAME_BITS(len)  (47U + 8U * (len) + (33U + 8U * (len)) / 4U)
+#endif
+
+/** Length of one bus load slot in microseconds. */
+#define CO_STAT_BUS_SLOT_US     10000U
+
+/** Number of slots in the longest window (1 s). */
+#define CO_STAT_BUS_SLOTS       100U
+
+
+/**
+ * Window for CO_statistics_busLoad().
+ */
+typedef enum{
+    CO_STAT_BUS_10MS    = 0,    /**< Last complete slot */
+    CO_STAT_BUS_100MS   = 1,    /**< Last 10 complete slots */
+    CO_STAT_BUS_1S      = 2     /**< Last 100 complete slots */
+}CO_statistics_busWindow_t;
+
+
+/**
+ * Statistics object.
+ */
+typedef struct CO_statistics{
+    CO_CANmodule_t     *CANmodule;      /**< From CO_statistics_init() */
+    uint32_t           *rxCount;        /**< From CO_statistics_init(), one per rx buffer */
+    uint16_t            rxSize;         /**< From CO_statistics_init() */
+    uint32_t           *txCount;        /**< From CO_statistics_init(), one per tx buffer */
+    uint16_t            txSize;         /**< From CO_statistics_init() */
+    uint16_t            bitRate;        /**< From CO_statistics_init(), in kbit/s */
+    /** Bits on the bus per slot in the lower 16 bits, slot number in the upper
+     * 16 bits. Ring with one more entry than the 1 s window */
+    uint32_t            busSlots[CO_STAT_BUS_SLOTS + 1U];
+    struct CO_statistics *next;         /**< Next active object or NULL */
+}CO_statistics_t;
+
+
+/** List of active objects in order of CO_statistics_init(), NULL before. */
+extern CO_statistics_t *CO_statistics;
+
+/** Default time base for CO_STAT_TIMESTAMP_US(). */
+extern volatile uint32_t CO_statistics_time_us;
+
+
+/**
+ * Initialize statistics and add the object to the list of active objects.
+ *
+ * @param stats This object will be initialized.
+ * @param CANmodule CAN module, which is counted.
+ * @param rxCount Externally defined array of rxSize counters.
+ * @param rxSize Number of receive buffers of the CAN module.
+ * @param txCount Externally defined array of txSize counters.
+ * @param txSize Number of transmit buffers of the CAN module.
+ * @param bitRate CAN bit rate in kbit/s, used for bus load.
+ */
+void CO_statistics_init(
+        CO_statistics_t        *stats,
+        CO_CANmodule_t         *CANmodule,
+        uint32_t                rxCount[],
+        uint16_t                rxSize,
+        uint32_t                txCount[],
+        uint16_t                txSize,
+        uint16_t                bitRate);
+
+
+/**
+ * Remove the object from the list of active objects.
+ *
+ * Must be called before memory of the object is freed.
+ *
+ * @param stats This object.
+ */
+void CO_statistics_remove(CO_statistics_t *stats);
+
+
+/**
+ * Clear all message counters and the bus load.
+ *
+ * @param stats This object.
+ */
+void CO_statistics_reset(CO_statistics_t *stats);
+
+
+/**
+ * Get bus load.
+ *
+ * @param stats This object.
+ * @param window Sliding window.
+ *
+ * @return Bus load in per mille of the bit rate, 0...1000. 0 if stats is NULL.
+ */
+uint16_t CO_statistics_busLoad(CO_statistics_t *stats, CO_statistics_busWindow_t window);
+
+
+/**
+ * Advance default time base.
+ *
+ * @param timeDifference_us Time difference from previous function call in [microseconds].
+ */
+static inline void CO_statistics_addTime(uint32_t timeDifference_us){
+    CO_statistics_time_us += timeDifference_us;
+}
+
+
+/**
+ * Count received message. Called by the driver through CO_STAT_RX().
+ *
+ * @param CANmodule CAN module, which received the message.
+ * @param index Index of the receive buffer.
+ */
+static inline void CO_statistics_rx(CO_CANmodule_t *CANmodule, uint16_t index){
+    CO_statistics_t *stats;
+
+    for(stats = CO_statistics; stats != NULL; stats = stats->next){
+        if(stats->CANmodule == CANmodule){
+            if(index < stats->rxSize){
+                stats->rxCount[index]++;
+            }
+            break;
+        }
+    }
+}
+
+
+/**
+ * Count transmitted message. Called by the driver through CO_STAT_TX().
+ *
+ * @param CANmodule CAN module, which transmits the message.
+ * @param index Index of the transmit buffer.
+ */
+static inline void CO_statistics_tx(CO_CANmodule_t *CANmodule, uint16_t index){
+    CO_statistics_t *stats;
+
+    for(stats = CO_statistics; stats != NULL; stats = stats->next){
+        if(stats->CANmodule == CANmodule){
+            if(index < stats->txSize){
+                stats->txCount[index]++;
+            }
+            break;
+        }
+    }
+}
+
+
+/**
+ * Count frame on the bus. Called by the driver through CO_STAT_BUS().
+ *
+ * @param CANmodule CAN module, which received or transmits the frame.
+ * @param len Number of data bytes.
+ */
+static inline void CO_statistics_bus(CO_CANmodule_t *CANmodule, uint8_t len){
+    CO_statistics_t *stats;
+
+    for(stats = CO_statistics; stats != NULL; stats = stats->next){
+        if(stats->CANmodule == CANmodule){
+            uint32_t bits = CO_STAT_BUS_FRAME_BITS((len > 8U) ? 8U : len);
+            uint32_t slot = CO_STAT_TIMESTAMP_US() / CO_STAT_BUS_SLOT_US;
+            uint32_t tag = slot << 16;
+            uint32_t *entry = &stats->busSlots[slot % (CO_STAT_BUS_SLOTS + 1U)];
+            uint32_t old = __atomic_load_n(entry, __ATOMIC_RELAXED);
+            uint32_t val;
+
+            do{
+                /* first frame of the slot drops the previous round */
+                val = ((old & 0xFFFF0000U) == tag) ? (old & 0xFFFFU) : 0U;
+                val = (val + bits > 0xFFFFU) ? 0xFFFFU : (val + bits);
+            }while(!__atomic_compare_exchange_n(entry, &old, tag | val, false,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+            break;
+        }
+    }
+}
+
+
+#define CO_STAT_RX(CANmodule, index)    CO_statistics_rx((CANmodule), (uint16_t)(index))
+#define CO_STAT_TX(CANmodule, index)    CO_statistics_tx((CANmodule), (uint16_t)(index))
+#define CO_STAT_BUS(CANmodule, len)     CO_statistics_bus((CANmodule), (uint8_t)(len))
+
+#else
+
+#define CO_STAT_RX(CANmodule, index)
+#define CO_STAT_TX(CANmodule, index)
+#define CO_STAT_BUS(CANmodule, len)
+
+#endif /* CO_USE_STATISTICS */
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
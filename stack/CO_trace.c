@@ -69,6 +69,23 @@ static uint32_t printPointBinary(char *s, uint32_t size, uint32_t timeStamp, int
     CO_memcpySwap4(s+4, &value);
     return 8;
 }
+static uint32_t printPointDelta(char *s, uint32_t size, uint32_t timeStamp, int32_t value) {
+    /* timeStamp and value are differences to the previous point, see CO_trace.h */
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value < 0 ? -1 : 0);
+    uint32_t len = 0;
+    if(size < 10) return 0;
+    while(timeStamp >= 0x80) {
+        s[len++] = (char)(timeStamp | 0x80);
+        timeStamp >>= 7;
+    }
+    s[len++] = (char)timeStamp;
+    while(zigzag >= 0x80) {
+        s[len++] = (char)(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+    s[len++] = (char)zigzag;
+    return len;
+}
 static uint32_t printPointSvgStart(char *s, uint32_t size, uint32_t timeStamp, int32_t value) {
     return snprintf(s, size, "M%lu,%ld", timeStamp,             value);
 }
@@ -104,44 +121,76 @@ static const CO_trace_dataType_t dataTypes[] = {
     {getValueI32, printPointSvgStart,         printPointSvg,         printPointSvg},
     {getValueU8,  printPointSvgStartUnsigned, printPointSvgUnsigned, printPointSvgUnsigned},
     {getValueU16, printPointSvgStartUnsigned, printPointSvgUnsigned, printPointSvgUnsigned},
-    {getValueU32, printPointSvgStartUnsigned, printPointSvgUnsigned, printPointSvgUnsigned}
+    {getValueU32, printPointSvgStartUnsigned, printPointSvgUnsigned, printPointSvgUnsigned},
+    {getValueI8,  printPointBinary,           printPointDelta,       printPointDelta,       true},
+    {getValueI16, printPointBinary,           printPointDelta,       printPointDelta,       true},
+    {getValueI32, printPointBinary,           printPointDelta,       printPointDelta,       true},
+    {getValueU8,  printPointBinary,           printPointDelta,       printPointDelta,       true},
+    {getValueU16, printPointBinary,           printPointDelta,       printPointDelta,       true},
+    {getValueU32, printPointBinary,           printPointDelta,       printPointDelta,       true}
 };
 
 
-/* Find variable in Object Dictionary *****************************************/
-static void findVariable(CO_trace_t *trace) {
+/* Print point with printPoint or printPointEnd. For delta encoded format
+ * difference to the previously printed point is passed. */
+static uint32_t printPointNext(
+        CO_trace_t             *trace,
+        uint32_t              (*pPrint)(char *s, uint32_t size, uint32_t timeStamp, int32_t value),
+        char                   *s,
+        uint32_t                size,
+        uint32_t                timeStamp,
+        int32_t                 value)
+{
+    uint32_t len;
+
+    if(trace->dt->delta) {
+        len = pPrint(s, size, timeStamp - trace->timePrinted,
+                     (int32_t)((uint32_t)value - (uint32_t)trace->valuePrinted));
+    }
+    else {
+        len = pPrint(s, size, timeStamp, value);
+    }
+    trace->timePrinted = timeStamp;
+    trace->valuePrinted = value;
+
+    return len;
+}
+
+
+/* Find variable in Object Dictionary, mapped by _map_ (same structure as in
+ * PDO). If map is zero, OdDataPtr is set to NULL without error. dataLen is set
+ * to the length of the variable in bytes. Returns true on error. */
+static bool_t findMap(CO_SDO_t *SDO, uint32_t map, void **OdDataPtr, uint8_t *dataLen) {
     bool_t err = false;
     uint16_t index;
     uint8_t subIndex;
-    uint8_t dataLen;
-    void *OdDataPtr = NULL;
-    unsigned dtIndex = 0;
 
     /* parse mapping */
-    index = (uint16_t) ((*trace->map) >> 16);
-    subIndex = (uint8_t) ((*trace->map) >> 8);
-    dataLen = (uint8_t) (*trace->map);
-    if((dataLen & 0x07) != 0) { /* data length must be byte aligned */
+    index = (uint16_t) (map >> 16);
+    subIndex = (uint8_t) (map >> 8);
+    *dataLen = (uint8_t) map;
+    *OdDataPtr = NULL;
+    if(((*dataLen) & 0x07) != 0) { /* data length must be byte aligned */
         err = true;
     }
-    dataLen >>= 3;   /* in bytes now */
-    if(dataLen == 0) {
-        dataLen = 4;
+    *dataLen >>= 3;   /* in bytes now */
+    if(*dataLen == 0) {
+        *dataLen = 4;
     }
 
     /* find mapped variable, if map available */
     if(!err && (index != 0 || subIndex != 0)) {
-        uint16_t entryNo = CO_OD_find(trace->SDO, index);
+        uint16_t entryNo = CO_OD_find(SDO, index);
 
-        if(index >= 0x1000 && entryNo != 0xFFFF && subIndex <= trace->SDO->OD[entryNo].maxSubIndex) {
-            OdDataPtr = CO_OD_getDataPointer(trace->SDO, entryNo, subIndex);
+        if(index >= 0x1000 && entryNo != 0xFFFF && subIndex <= CO_OD_getMaxSubIndex(SDO, entryNo)) {
+            *OdDataPtr = CO_OD_getDataPointer(SDO, entryNo, subIndex);
         }
 
-        if(OdDataPtr != NULL) {
-            uint16_t len = CO_OD_getLength(trace->SDO, entryNo, subIndex);
+        if(*OdDataPtr != NULL) {
+            uint16_t len = CO_OD_getLength(SDO, entryNo, subIndex);
 
-            if(len < dataLen) {
-                dataLen = len;
+            if(len < *dataLen) {
+                *dataLen = len;
             }
         }
         else {
@@ -149,23 +198,48 @@ static void findVariable(CO_trace_t *trace) {
         }
     }
 
+    return err;
+}
+
+
+/* Get function pointers for data length in bytes and format. Returns NULL on error. */
+static const CO_trace_dataType_t *findDataType(uint8_t dataLen, uint8_t format) {
+    unsigned dtIndex = 0;
+
+    /* first sequence: data length */
+    switch(dataLen) {
+        case 1: dtIndex = 0; break;
+        case 2: dtIndex = 1; break;
+        case 4: dtIndex = 2; break;
+        default: return NULL;
+    }
+    /* second sequence: signed or unsigned */
+    if((format & 1) == 1) {
+        dtIndex += 3;
+    }
+    /* third sequence: Output type */
+    dtIndex += (format >> 1) * 6;
+
+    if(dtIndex >= (sizeof(dataTypes) / sizeof(CO_trace_dataType_t))) {
+        return NULL;
+    }
+    return &dataTypes[dtIndex];
+}
+
+
+/* Find variable in Object Dictionary *****************************************/
+static void findVariable(CO_trace_t *trace) {
+    bool_t err;
+    uint8_t dataLen;
+    void *OdDataPtr;
+    const CO_trace_dataType_t *dt = NULL;
+
+    err = findMap(trace->SDO, *trace->map, &OdDataPtr, &dataLen);
+
     /* Get function pointers for correct data type */
     if(!err) {
-        /* first sequence: data length */
-        switch(dataLen) {
-            case 1: dtIndex = 0; break;
-            case 2: dtIndex = 1; break;
-            case 4: dtIndex = 2; break;
-            default: err = true; break;
-        }
-        /* second sequence: signed or unsigned */
-        if(((*trace->format) & 1) == 1) {
-            dtIndex += 3;
-        }
-        /* third sequence: Output type */
-        dtIndex += ((*trace->format) >> 1) * 6;
-
-        if(dtIndex > (sizeof(dataTypes) / sizeof(CO_trace_dataType_t))) {
+        dt = findDataType(dataLen, *trace->format);
+        if(dt == NULL) {
             err = true;
         }
     }
@@ -178,7 +252,7 @@ static void findVariable(CO_trace_t *trace) {
         else {
             trace->OD_variable = trace->value;
         }
-        trace->dt = &dataTypes[dtIndex];
+        trace->dt = dt;
     }
     else  {
         trace->OD_variable = NULL;
@@ -187,6 +261,125 @@ static void findVariable(CO_trace_t *trace) {
 }
 
 
+/* Verify, if value passed threshold, according to trigger setting. */
+static bool_t triggered(uint8_t trigger, int32_t threshold, int32_t valuePrev, int32_t val) {
+    if((trigger & 1) != 0 && valuePrev < threshold && val >= threshold) {
+        return true;
+    }
+    if((trigger & 2) != 0 && valuePrev < threshold && val >= threshold) {
+        return true;
+    }
+    return false;
+}
+
+
+/* Compare values, unsigned if bit 0 of format is set. */
+static bool_t lessThan(uint8_t format, int32_t a, int32_t b) {
+    if((format & 1) != 0) {
+        return ((uint32_t)a < (uint32_t)b) ? true : false;
+    }
+    return (a < b) ? true : false;
+}
+
+
+/* Aggregate the sample into the window. If window is elapsed, store its record
+ * first and start the next window with this sample. */
+static void processWindow(CO_trace_t *trace, uint32_t timestamp, int32_t val) {
+    uint8_t format = *trace->format;
+    bool_t start = (trace->windowCount == 0) ? true : false;
+
+    if(!start && (timestamp - trace->windowStart) >= trace->window) {
+        uint32_t wp = trace->writePtr;
+
+        trace->timeBuffer[wp] = trace->windowStart;
+        trace->valueBuffer[wp] = (int32_t)(trace->windowSum / (int64_t)trace->windowCount);
+        trace->minBuffer[wp] = trace->windowMin;
+        trace->maxBuffer[wp] = trace->windowMax;
+        trace->countBuffer[wp] = trace->windowCount;
+        *trace->minValue = trace->windowMin;
+        *trace->maxValue = trace->windowMax;
+        if(++trace->writePtr == trace->bufferSize) {
+            trace->writePtr = 0;
+        }
+        if(trace->writePtr == trace->readPtr) {
+            if(++trace->readPtr == trace->bufferSize) {
+                trace->readPtr = 0;
+            }
+        }
+
+        /* keep windows aligned, unless samples were missing for a window */
+        trace->windowStart += trace->window;
+        if((timestamp - trace->windowStart) >= trace->window) {
+            trace->windowStart = timestamp;
+        }
+        start = true;
+    }
+    else if(start) {
+        trace->windowStart = timestamp;
+    }
+
+    if(start) {
+        trace->windowCount = 0;
+        trace->windowSum = 0;
+        trace->windowMin = val;
+        trace->windowMax = val;
+    }
+    else {
+        if(lessThan(format, val, trace->windowMin)) {
+            trace->windowMin = val;
+        }
+        if(lessThan(format, trace->windowMax, val)) {
+            trace->windowMax = val;
+        }
+    }
+    trace->windowSum += ((format & 1) != 0) ? (int64_t)(uint32_t)val : (int64_t)val;
+    trace->windowCount++;
+}
+
+
+/* Clear buffer, handle race conditions, and arm the capture, if configured. */
+static void clearBuffer(CO_trace_t *trace) {
+    while(trace->readPtr != 0 || trace->writePtr != 0) {
+        trace->readPtr = 0;
+        trace->writePtr = 0;
+    }
+    if(trace->captureState != CO_TRACE_CAPTURE_OFF) {
+        trace->captureState = CO_TRACE_CAPTURE_ARMED;
+    }
+}
+
+
+/* Handle capture after the sample is processed. trig is true, if sample went
+ * through the threshold, wpBefore is writePtr before the sample. */
+static void processCapture(CO_trace_t *trace, bool_t trig, uint32_t wpBefore) {
+    uint32_t written = (trace->writePtr != wpBefore) ? 1 : 0;
+
+    if(trace->captureState == CO_TRACE_CAPTURE_ARMED && trig) {
+        /* trigger record is just written or, in aggregation mode, next one */
+        uint32_t trigPtr = (written != 0) ? wpBefore : trace->writePtr;
+        uint32_t rp = trace->readPtr;
+        uint32_t before = (trigPtr >= rp) ? (trigPtr - rp) : (trace->bufferSize - rp + trigPtr);
+
+        if(before > trace->preTrigger) {
+            rp = trigPtr + trace->bufferSize - trace->preTrigger;
+            if(rp >= trace->bufferSize) {
+                rp -= trace->bufferSize;
+            }
+            trace->readPtr = rp;
+        }
+        trace->captureRemaining = trace->postTrigger + 1 - written;
+        trace->captureState = CO_TRACE_CAPTURE_POST;
+    }
+    else if(trace->captureState == CO_TRACE_CAPTURE_POST) {
+        trace->captureRemaining -= written;
+    }
+
+    if(trace->captureState == CO_TRACE_CAPTURE_POST && trace->captureRemaining == 0) {
+        trace->captureState = CO_TRACE_CAPTURE_READY;
+    }
+}
+
+
 /* OD function for accessing _OD_traceConfig_ (index 0x2300+) from SDO server.
  * For more information see file CO_SDO.h. */
 static CO_SDO_abortCode_t CO_ODF_traceConfig(CO_ODF_arg_t *ODF_arg) {
@@ -230,8 +423,13 @@ static CO_SDO_abortCode_t CO_ODF_traceConfig(CO_ODF_arg_t *ODF_arg) {
                         *trace->maxValue = 0;
                         *trace->triggerTime = 0;
                         trace->valuePrev = 0;
+                        trace->windowCount = 0;
                         trace->readPtr = 0;
                         trace->writePtr = 0;
+                        if(trace->captureState != CO_TRACE_CAPTURE_OFF) {
+                            trace->captureState = CO_TRACE_CAPTURE_ARMED;
+                        }
+                        trace->startPending = (trace->start != NULL && *trace->start != 0) ? true : false;
                         trace->enabled = true;
                     }
                     else {
@@ -242,8 +440,21 @@ static CO_SDO_abortCode_t CO_ODF_traceConfig(CO_ODF_arg_t *ODF_arg) {
         }
         break;
 
-    case 5:     /* map */
     case 6:     /* format */
+        if(ODF_arg->reading) {
+            /* plot of windowed trace has its own records, see CO_trace.h */
+            if(trace->window != 0) {
+                uint8_t *value = (uint8_t*) ODF_arg->data;
+                *value = (uint8_t)((*value & 1U) | (CO_TRACE_FORMAT_WINDOW << 1));
+            }
+        }
+        else if(trace->enabled) {
+            ret = CO_SDO_AB_INVALID_VALUE;
+        }
+        break;
+
+    case 5:     /* map */
+    case 9:     /* start */
         if(!ODF_arg->reading) {
             if(trace->enabled) {
                 ret = CO_SDO_AB_INVALID_VALUE;
@@ -283,12 +494,8 @@ static CO_SDO_abortCode_t CO_ODF_trace(CO_ODF_arg_t *ODF_arg) {
             uint32_t *value = (uint32_t*) ODF_arg->data;
 
             if(*value == 0) {
-                /* clear buffer, handle race conditions */
-                while(trace->readPtr != 0 || trace->writePtr != 0) {
-                    trace->readPtr = 0;
-                    trace->writePtr = 0;
-                    *trace->triggerTime = 0;
-                }
+                *trace->triggerTime = 0;
+                clearBuffer(trace);
             }
             else {
                 ret = CO_SDO_AB_INVALID_VALUE;
@@ -297,7 +504,56 @@ static CO_SDO_abortCode_t CO_ODF_trace(CO_ODF_arg_t *ODF_arg) {
         break;
 
     case 5:     /* plot */
-        if(ODF_arg->reading) {
+        if(ODF_arg->reading && ODF_arg->firstSegment &&
+           trace->captureState != CO_TRACE_CAPTURE_OFF && trace->captureState != CO_TRACE_CAPTURE_READY)
+        {
+            /* capture in progress, records must not be consumed */
+            ret = CO_SDO_AB_NO_DATA;
+        }
+        else if(ODF_arg->reading && trace->window != 0) {
+            /* Records of the windows are copied to SDO buffer as domain, in
+             * the same way as rows of the trace group. */
+            if(trace->bufferSize == 0 || ODF_arg->dataLength < 20) {
+                ret = CO_SDO_AB_OUT_OF_MEM;
+            }
+            else if(ODF_arg->firstSegment && trace->readPtr == trace->writePtr) {
+                ret = CO_SDO_AB_NO_DATA;
+            }
+            else {
+                uint8_t *s = ODF_arg->data;
+                uint32_t freeLen = ODF_arg->dataLength;
+                uint32_t rp;
+
+                ODF_arg->lastSegment = false;
+                while(freeLen >= 20) {
+                    rp = trace->readPtr;
+                    if(rp == trace->writePtr) {
+                        break;
+                    }
+                    CO_memcpySwap4(s, &trace->timeBuffer[rp]);
+                    CO_memcpySwap4(s + 4, &trace->valueBuffer[rp]);
+                    CO_memcpySwap4(s + 8, &trace->minBuffer[rp]);
+                    CO_memcpySwap4(s + 12, &trace->maxBuffer[rp]);
+                    CO_memcpySwap4(s + 16, &trace->countBuffer[rp]);
+                    if(rp != trace->readPtr) {
+                        /* overwritten, repeat */
+                        continue;
+                    }
+                    if(++rp == trace->bufferSize) {
+                        rp = 0;
+                    }
+                    trace->readPtr = rp;
+                    s += 20;
+                    freeLen -= 20;
+                }
+                if(trace->readPtr == trace->writePtr) {
+                    ODF_arg->lastSegment = true;
+                }
+
+                ODF_arg->dataLength -= freeLen;
+            }
+        }
+        else if(ODF_arg->reading) {
             /* This plot will be transmitted as domain data type. String data
              * will be printed directly to SDO buffer. If there is more data
              * to print, than is the size of SDO buffer, then this function
@@ -344,6 +600,8 @@ static CO_SDO_abortCode_t CO_ODF_trace(CO_ODF_arg_t *ODF_arg) {
                             continue;
                         }
                         len = trace->dt->printPointStart(s, freeLen, t, v);
+                        trace->timePrinted = t;
+                        trace->valuePrinted = v;
                         s += len;
                         freeLen -= len;
                     }
@@ -371,14 +629,14 @@ static CO_SDO_abortCode_t CO_ODF_trace(CO_ODF_arg_t *ODF_arg) {
                         if(rp == trace->writePtr) {
                             /* If there is last time stamp, point will be printed at the end */
                             if(t != trace->lastTimeStamp) {
-                                len = trace->dt->printPoint(s, freeLen, t, v);
+                                len = printPointNext(trace, trace->dt->printPoint, s, freeLen, t, v);
                                 s += len;
                                 freeLen -= len;
                             }
                             ODF_arg->lastSegment = true;
                             break;
                         }
-                        len = trace->dt->printPoint(s, freeLen, t, v);
+                        len = printPointNext(trace, trace->dt->printPoint, s, freeLen, t, v);
                         s += len;
                         freeLen -= len;
 
@@ -394,7 +652,7 @@ static CO_SDO_abortCode_t CO_ODF_trace(CO_ODF_arg_t *ODF_arg) {
                     if(!readPtrOverflowed && ODF_arg->lastSegment) {
                         v = trace->valuePrev;
                         t = trace->lastTimeStamp;
-                        len = trace->dt->printPointEnd(s, freeLen, t, v);
+                        len = printPointNext(trace, trace->dt->printPointEnd, s, freeLen, t, v);
                         s += len;
                         freeLen -= len;
                     }
@@ -437,6 +695,8 @@ void CO_trace_init(
     trace->writePtr = 0;
     trace->readPtr = 0;
     trace->lastTimeStamp = 0;
+    trace->timePrinted = 0;
+    trace->valuePrinted = 0;
     trace->map = map;
     trace->format = format;
     trace->trigger = trigger;
@@ -450,6 +710,15 @@ void CO_trace_init(
     *trace->maxValue = 0;
     *trace->triggerTime = 0;
     trace->valuePrev = 0;
+    trace->window = 0;
+    trace->minBuffer = NULL;
+    trace->maxBuffer = NULL;
+    trace->countBuffer = NULL;
+    trace->windowCount = 0;
+    trace->captureState = CO_TRACE_CAPTURE_OFF;
+    trace->preTrigger = 0;
+    trace->postTrigger = 0;
+    trace->captureRemaining = 0;
 
     /* set trace->OD_variable and trace->dt, based on 'map' and 'format' */
     findVariable(trace);
@@ -462,24 +731,116 @@ void CO_trace_init(
         trace->enabled = false;
     }
 
+    /* optional start condition in traceConfig */
+    trace->start = NULL;
+    {
+        uint16_t entryNo = CO_OD_find(SDO, idx_OD_traceConfig);
+
+        if(entryNo != 0xFFFF && CO_OD_getMaxSubIndex(SDO, entryNo) >= 9 &&
+           CO_OD_getLength(SDO, entryNo, 9) == 4)
+        {
+            trace->start = (uint32_t*) CO_OD_getDataPointer(SDO, entryNo, 9);
+        }
+    }
+    trace->startPending = (trace->enabled && trace->start != NULL && *trace->start != 0) ? true : false;
+
     CO_OD_configure(SDO, idx_OD_traceConfig, CO_ODF_traceConfig, (void*)trace, 0, 0);
     CO_OD_configure(SDO, idx_OD_trace, CO_ODF_trace, (void*)trace, 0, 0);
 }
 
 
+/******************************************************************************/
+CO_ReturnError_t CO_trace_initWindow(
+        CO_trace_t             *trace,
+        uint32_t                window,
+        int32_t                *minBuffer,
+        int32_t                *maxBuffer,
+        uint32_t               *countBuffer)
+{
+    /* verify arguments */
+    if(trace==NULL || (window!=0 && (minBuffer==NULL || maxBuffer==NULL || countBuffer==NULL))) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    trace->window = window;
+    trace->minBuffer = minBuffer;
+    trace->maxBuffer = maxBuffer;
+    trace->countBuffer = countBuffer;
+    trace->windowCount = 0;
+
+    /* records of both modes must not be mixed */
+    clearBuffer(trace);
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_trace_initCapture(
+        CO_trace_t             *trace,
+        bool_t                  enable,
+        uint32_t                preTrigger,
+        uint32_t                postTrigger)
+{
+    /* verify arguments, pre-trigger, trigger and post-trigger records must fit */
+    if(trace==NULL || (enable && (preTrigger >= trace->bufferSize ||
+       postTrigger >= trace->bufferSize - preTrigger - 1U)))
+    {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    trace->preTrigger = preTrigger;
+    trace->postTrigger = postTrigger;
+    trace->captureState = enable ? CO_TRACE_CAPTURE_ARMED : CO_TRACE_CAPTURE_OFF;
+    clearBuffer(trace);
+
+    return CO_ERROR_NO;
+}
+
+
 /******************************************************************************/
 void CO_trace_process(CO_trace_t *trace, uint32_t timestamp) {
-    if(trace->enabled) {
+    uint32_t wpBefore = trace->writePtr;
+    bool_t trig = false;
+
+    if(trace->captureState == CO_TRACE_CAPTURE_READY) {
+        /* buffer is frozen until read and cleared */
+        return;
+    }
+
+    if(trace->enabled && trace->startPending) {
+        uint32_t start = *trace->start;
+
+        /* wait for SYNC or for the start time */
+        if((start & CO_TRACE_START_SYNC) == CO_TRACE_START_SYNC || (int32_t)(timestamp - start) < 0) {
+            return;
+        }
+        trace->startPending = false;
+    }
+
+    if(trace->enabled && trace->window != 0) {
+        int32_t val = trace->dt->pGetValue(trace->OD_variable);
+
+        if(triggered(*trace->trigger, *trace->threshold, trace->valuePrev, val)) {
+            *trace->triggerTime = timestamp;
+            trig = true;
+        }
+        if(trace->value != trace->OD_variable) {
+            *trace->value = val;
+        }
+        trace->valuePrev = val;
+        processWindow(trace, timestamp, val);
+        trace->lastTimeStamp = timestamp;
+    }
+    else if(trace->enabled) {
 
         int32_t val = trace->dt->pGetValue(trace->OD_variable);
 
         if(val != trace->valuePrev) {
             /* Verify, if value passed threshold */
-            if((*trace->trigger & 1) != 0 && trace->valuePrev < *trace->threshold && val >= *trace->threshold) {
-                *trace->triggerTime = timestamp;
-            }
-            if((*trace->trigger & 2) != 0 && trace->valuePrev < *trace->threshold && val >= *trace->threshold) {
+            if(triggered(*trace->trigger, *trace->threshold, trace->valuePrev, val)) {
                 *trace->triggerTime = timestamp;
+                trig = true;
             }
 
             /* Write value and verify min/max */
@@ -519,4 +880,214 @@ void CO_trace_process(CO_trace_t *trace, uint32_t timestamp) {
         }
         trace->lastTimeStamp = timestamp;
     }
+
+    if(trace->enabled && trace->captureState != CO_TRACE_CAPTURE_OFF) {
+        processCapture(trace, trig, wpBefore);
+    }
+}
+
+
+/******************************************************************************/
+void CO_trace_sync(CO_trace_t *trace, uint8_t counter) {
+    if(trace->startPending) {
+        uint32_t start = *trace->start;
+
+        if((start & CO_TRACE_START_SYNC) == CO_TRACE_START_SYNC &&
+           ((uint8_t)start == 0 || counter == 0 || (uint8_t)start == counter))
+        {
+            trace->startPending = false;
+        }
+    }
+}
+
+
+/* OD function for accessing trace group from SDO server.
+ * For more information see file CO_SDO.h. */
+static CO_SDO_abortCode_t CO_ODF_traceGroup(CO_ODF_arg_t *ODF_arg) {
+    CO_traceGroup_t *group;
+    CO_SDO_abortCode_t ret = CO_SDO_AB_NONE;
+    uint32_t rowSize;
+
+    group = (CO_traceGroup_t*) ODF_arg->object;
+    rowSize = 4 + 4 * (uint32_t)group->columnCount;
+
+    switch(ODF_arg->subIndex) {
+    case 1:     /* size */
+        if(ODF_arg->reading) {
+            uint32_t *value = (uint32_t*) ODF_arg->data;
+            uint32_t wp = group->writePtr;
+            uint32_t rp = group->readPtr;
+
+            if(wp >= rp) {
+                *value = wp - rp;
+            }
+            else {
+                *value = group->bufferSize - rp + wp;
+            }
+        }
+        else {
+            uint32_t *value = (uint32_t*) ODF_arg->data;
+
+            if(*value == 0) {
+                /* clear buffer, handle race conditions */
+                while(group->readPtr != 0 || group->writePtr != 0) {
+                    group->readPtr = 0;
+                    group->writePtr = 0;
+                }
+            }
+            else {
+                ret = CO_SDO_AB_INVALID_VALUE;
+            }
+        }
+        break;
+
+    case 5:     /* rows */
+        if(ODF_arg->reading) {
+            /* Rows are copied to SDO buffer as domain, function is called
+             * multiple times, until circular buffer is empty. Buffer is
+             * filled by higher priority thread. If it overflows, the row
+             * being copied may be overwritten. This is detected by moved
+             * readPtr and the row is copied again from new position. */
+            if(group->bufferSize == 0 || ODF_arg->dataLength < rowSize) {
+                ret = CO_SDO_AB_OUT_OF_MEM;
+            }
+            else if(ODF_arg->firstSegment && group->readPtr == group->writePtr) {
+                ret = CO_SDO_AB_NO_DATA;
+            }
+            else {
+                uint8_t *s = ODF_arg->data;
+                uint32_t freeLen = ODF_arg->dataLength;
+                uint32_t rp;
+                uint8_t i;
+
+                ODF_arg->lastSegment = false;
+                while(freeLen >= rowSize) {
+                    int32_t *values;
+
+                    rp = group->readPtr;
+                    if(rp == group->writePtr) {
+                        ODF_arg->lastSegment = true;
+                        break;
+                    }
+                    values = &group->valueBuffer[rp * group->columnCount];
+                    CO_memcpySwap4(s, &group->timeBuffer[rp]);
+                    for(i = 0; i < group->columnCount; i++) {
+                        CO_memcpySwap4(s + 4 + 4 * i, &values[i]);
+                    }
+                    if(rp != group->readPtr) {
+                        /* overwritten, repeat */
+                        continue;
+                    }
+                    if(++rp == group->bufferSize) {
+                        rp = 0;
+                    }
+                    group->readPtr = rp;
+                    s += rowSize;
+                    freeLen -= rowSize;
+                }
+                if(group->readPtr == group->writePtr) {
+                    ODF_arg->lastSegment = true;
+                }
+
+                ODF_arg->dataLength -= freeLen;
+            }
+        }
+        break;
+    }
+
+    return ret;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_traceGroup_init(
+        CO_traceGroup_t        *group,
+        CO_SDO_t               *SDO,
+        CO_traceColumn_t       *columns,
+        uint8_t                 columnCount,
+        uint32_t               *timeBuffer,
+        int32_t                *valueBuffer,
+        uint32_t                bufferSize,
+        uint16_t                idx_OD_traceGroup)
+{
+    uint8_t i;
+
+    /* verify arguments */
+    if(group==NULL || SDO==NULL || columns==NULL || columnCount==0 ||
+       timeBuffer==NULL || valueBuffer==NULL || bufferSize==0)
+    {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    group->enabled = false;
+    group->SDO = SDO;
+    group->columns = columns;
+    group->columnCount = columnCount;
+    group->timeBuffer = timeBuffer;
+    group->valueBuffer = valueBuffer;
+    group->bufferSize = bufferSize;
+    group->writePtr = 0;
+    group->readPtr = 0;
+    group->timestamp = 0;
+    group->next = NULL;
+
+    /* set OD_variable and dt of each column, based on 'map' and 'format' */
+    for(i = 0; i < columnCount; i++) {
+        CO_traceColumn_t *col = &columns[i];
+        uint8_t dataLen;
+
+        if(findMap(SDO, col->map, &col->OD_variable, &dataLen) || col->OD_variable == NULL) {
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+        col->dt = findDataType(dataLen, col->format & 1);
+        if(col->dt == NULL) {
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+        col->triggerTime = 0;
+        col->valuePrev = col->dt->pGetValue(col->OD_variable);
+    }
+
+    group->enabled = true;
+
+    CO_OD_configure(SDO, idx_OD_traceGroup, CO_ODF_traceGroup, (void*)group, 0, 0);
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_traceGroup_process(
+        CO_traceGroup_t        *group,
+        bool_t                  syncWas,
+        uint32_t                timeDifference_us)
+{
+    group->timestamp += timeDifference_us;
+
+    if(group->enabled && syncWas) {
+        int32_t *values = &group->valueBuffer[group->writePtr * group->columnCount];
+        uint8_t i;
+
+        /* sample all columns in one pass */
+        for(i = 0; i < group->columnCount; i++) {
+            CO_traceColumn_t *col = &group->columns[i];
+            int32_t val = col->dt->pGetValue(col->OD_variable);
+
+            if(triggered(col->trigger, col->threshold, col->valuePrev, val)) {
+                col->triggerTime = group->timestamp;
+            }
+            col->valuePrev = val;
+            values[i] = val;
+        }
+
+        /* write time stamp and update pointers */
+        group->timeBuffer[group->writePtr] = group->timestamp;
+        if(++group->writePtr == group->bufferSize) {
+            group->writePtr = 0;
+        }
+        if(group->writePtr == group->readPtr) {
+            if(++group->readPtr == group->bufferSize) {
+                group->readPtr = 0;
+            }
+        }
+    }
 }
@@ -75,6 +75,53 @@ extern "C" {
  * buffer, prints a SVG curve into string and sends it as a SDO response. If a
  * SDO request was received from the same device, then no traffic occupies CAN
  * network.
+ *
+ * Output format of the plot is selected by bits 1..7 of _format_:
+ *  - 0: CSV text, "timestamp;value\n" per point.
+ *  - 1: Binary, 4 bytes timestamp and 4 bytes value per point, little endian.
+ *  - 2: SVG path text.
+ *  - 3: Delta encoded binary, for continuous streaming of fast traces. Each
+ *    SDO upload starts with an absolute point as in binary format, followed
+ *    by points encoded as difference to the previous point: time difference
+ *    as unsigned LEB128 varint, then value difference (calculated modulo
+ *    2^32) zigzag encoded ((d << 1) ^ (d >> 31)) as unsigned LEB128 varint.
+ *    Slowly changing variables need 2 or 3 bytes per point. Reading the plot
+ *    consumes the points, so the trace can be read repeatedly, e.g. with
+ *    block transfer, without losing points, as long as the circular buffer
+ *    doesn't overflow between two reads.
+ *
+ * For noisy variables, which change in each cycle, trace may aggregate the
+ * samples over a time window instead, see CO_trace_initWindow(). Then one
+ * record with mean, minimum, maximum and number of samples is stored per
+ * window and _format_ is ignored for the plot: it is a domain of records,
+ * each with 4 bytes window start time stamp, 4 bytes mean, 4 bytes minimum,
+ * 4 bytes maximum and 4 bytes number of samples, little endian. Reading the
+ * plot consumes the records. _min_ and _max_ show minimum and maximum of the
+ * last completed window. Reading _format_ then returns output format
+ * #CO_TRACE_FORMAT_WINDOW, so a client can recognize the records.
+ *
+ * Like an oscilloscope, trace may also capture the records around a trigger,
+ * see CO_trace_initCapture(). While armed, the circular buffer is overwritten
+ * continuously and the plot can't be read. When the variable goes through the
+ * threshold, older records are dropped except the configured pre-trigger
+ * depth, then the configured number of post-trigger records is recorded and
+ * the buffer is frozen. Now the plot can be read. Writing 0 to the size of
+ * the trace (clearing the buffer) arms the capture again.
+ *
+ * If traceConfig has optional subindex 9 (_start_, UNSIGNED32), recording
+ * of an enabled trace may be delayed, so traces on different devices start
+ * at the same moment. Start condition is evaluated, when the trace is enabled
+ * by writing nonzero _axisNo_:
+ *  - 0: Recording starts immediately.
+ *  - #CO_TRACE_START_SYNC + counter: Recording starts after the SYNC message
+ *    with the counter value (1..240), see CO_trace_sync(). If counter is 0
+ *    or _Synchronous counter overflow value_ is 0, after the next SYNC.
+ *  - Other value: Recording starts, when the timestamp of CO_trace_process()
+ *    reaches the value. Timestamp must then be on a common time base for
+ *    all devices, for example CO_TIME_getMs().
+ *
+ * First record is made by the first CO_trace_process() after the start, so
+ * all traces begin with the same timestamp. See also CO_traceCollect.
  */
 
 
@@ -87,6 +134,21 @@ extern "C" {
 #endif
 
 
+/**
+ * Output format (bits 1..7 of traceConfig _format_) read from a trace with
+ * aggregation window, see CO_trace_initWindow(). It can't be written.
+ */
+#define CO_TRACE_FORMAT_WINDOW  4U
+
+
+/**
+ * Value of traceConfig _start_, recording starts on SYNC. Lower 8 bits may
+ * contain the SYNC counter value. Timestamps in this range can't be used as
+ * start time.
+ */
+#define CO_TRACE_START_SYNC     0xFFFFFF00UL
+
+
 /**
  *  structure for reading variables and printing points for specific data type.
  */
@@ -99,9 +161,22 @@ typedef struct {
     uint32_t (*printPoint)(char *s, uint32_t size, uint32_t timeStamp, int32_t value);
     /** Function pointer for printing the end point to trace.plot */
     uint32_t (*printPointEnd)(char *s, uint32_t size, uint32_t timeStamp, int32_t value);
+    /** If true, printPoint and printPointEnd get differences to the previous point. */
+    bool_t delta;
 } CO_trace_dataType_t;
 
 
+/**
+ * State of the capture, see CO_trace_initCapture().
+ */
+typedef enum {
+    CO_TRACE_CAPTURE_OFF    = 0,    /**< Capture disabled, continuous recording */
+    CO_TRACE_CAPTURE_ARMED  = 1,    /**< Waiting for trigger */
+    CO_TRACE_CAPTURE_POST   = 2,    /**< Triggered, recording post-trigger records */
+    CO_TRACE_CAPTURE_READY  = 3     /**< Buffer frozen, ready for reading */
+} CO_trace_capture_t;
+
+
 /**
  * Trace object.
  */
@@ -117,6 +192,8 @@ typedef struct {
     void               *OD_variable;    /**< Pointer to variable, which is monitored */
     const CO_trace_dataType_t *dt;      /**< Data type specific function pointers. **/
     int32_t             valuePrev;      /**< Previous value of value. */
+    uint32_t            timePrinted;    /**< Time stamp of the last point printed to trace.plot. */
+    int32_t             valuePrinted;   /**< Value of the last point printed to trace.plot. */
     uint32_t           *map;            /**< From CO_trace_init(). */
     uint8_t            *format;         /**< From CO_trace_init(). */
     int32_t            *value;          /**< From CO_trace_init(). */
@@ -125,6 +202,21 @@ typedef struct {
     uint32_t           *triggerTime;    /**< From CO_trace_init(). */
     uint8_t            *trigger;        /**< From CO_trace_init(). */
     int32_t            *threshold;      /**< From CO_trace_init(). */
+    uint32_t            window;         /**< Aggregation window, 0 if disabled. From CO_trace_initWindow(). */
+    int32_t            *minBuffer;      /**< From CO_trace_initWindow(). */
+    int32_t            *maxBuffer;      /**< From CO_trace_initWindow(). */
+    uint32_t           *countBuffer;    /**< From CO_trace_initWindow(). */
+    uint32_t            windowStart;    /**< Time stamp of the start of the current window. */
+    int64_t             windowSum;      /**< Sum of the samples in the current window. */
+    uint32_t            windowCount;    /**< Number of samples in the current window, 0 if not started. */
+    int32_t             windowMin;      /**< Minimum in the current window. */
+    int32_t             windowMax;      /**< Maximum in the current window. */
+    volatile CO_trace_capture_t captureState; /**< State of the capture. */
+    uint32_t            preTrigger;     /**< From CO_trace_initCapture(). */
+    uint32_t            postTrigger;    /**< From CO_trace_initCapture(). */
+    uint32_t            captureRemaining; /**< Number of records until the buffer is frozen. */
+    uint32_t           *start;          /**< traceConfig subindex 9 or NULL, found by CO_trace_init(). */
+    volatile bool_t     startPending;   /**< Trace is enabled and waits for the start condition. */
 } CO_trace_t;
 
 
@@ -147,7 +239,8 @@ typedef struct {
  * @param minValue Pointer to variable, which will show minimum value of the variable.
  * @param maxValue Pointer to variable, which will show maximum value of the variable.
  * @param triggerTime Pointer to variable, which will show last trigger time of the variable.
- * @param idx_OD_traceConfig Index in Object Dictionary.
+ * @param idx_OD_traceConfig Index in Object Dictionary. If the object has
+ * subindex 9, it is used as _start_.
  * @param idx_OD_trace Index in Object Dictionary.
  *
  * @return 0 on success, -1 on error.
@@ -171,6 +264,65 @@ void CO_trace_init(
         uint16_t                idx_OD_trace);
 
 
+/**
+ * Configure aggregation of the trace over a time window.
+ *
+ * Function may be called after CO_trace_init(), also in the communication
+ * reset section, after CO_init(). Instead of a record for each change of the
+ * variable, CO_trace_process() accumulates all samples of the window and
+ * stores one record per window. Buffer is cleared.
+ *
+ * @param trace This object.
+ * @param window Length of the window in units of the time stamp (usually
+ * milliseconds). If zero, aggregation is disabled.
+ * @param minBuffer Memory block for storing minimums, same size as valueBuffer.
+ * @param maxBuffer Memory block for storing maximums, same size as valueBuffer.
+ * @param countBuffer Memory block for storing number of samples, same size as valueBuffer.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_trace_initWindow(
+        CO_trace_t             *trace,
+        uint32_t                window,
+        int32_t                *minBuffer,
+        int32_t                *maxBuffer,
+        uint32_t               *countBuffer);
+
+
+/**
+ * Configure capture of the records around a trigger.
+ *
+ * Function may be called after CO_trace_init() and CO_trace_initWindow().
+ * Buffer is cleared and capture is armed. Trigger must be configured in
+ * traceConfig.
+ *
+ * @param trace This object.
+ * @param enable If false, trace records continuously.
+ * @param preTrigger Number of records before the trigger record, which are retained.
+ * @param postTrigger Number of records after the trigger record, then buffer is frozen.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT (also
+ * if records don't fit into the buffer, which holds bufferSize - 1 records).
+ */
+CO_ReturnError_t CO_trace_initCapture(
+        CO_trace_t             *trace,
+        bool_t                  enable,
+        uint32_t                preTrigger,
+        uint32_t                postTrigger);
+
+
+/**
+ * Get ready flag of the capture.
+ *
+ * @param trace This object.
+ *
+ * @return True, if records around the trigger are captured and buffer is frozen.
+ */
+static inline bool_t CO_trace_captureReady(CO_trace_t *trace) {
+    return (trace->captureState == CO_TRACE_CAPTURE_READY) ? true : false;
+}
+
+
 /**
  * Process trace object.
  *
@@ -183,6 +335,114 @@ void CO_trace_init(
  */
 void CO_trace_process(CO_trace_t *trace, uint32_t timestamp);
 
+
+/**
+ * Release traces, which wait for SYNC.
+ *
+ * Function is called by CO_process_SYNC_RPDO() after SYNC message was
+ * received or transmitted. See traceConfig _start_ in CO_trace.
+ *
+ * @param trace This object.
+ * @param counter SYNC counter, 0 if SYNC has no counter.
+ */
+void CO_trace_sync(CO_trace_t *trace, uint8_t counter);
+
+
+/**
+ * Column of a trace group, one mapped variable.
+ *
+ * Members map, format, trigger and threshold are set by the application before
+ * CO_traceGroup_init(). They have the same meaning as in traceConfig.
+ */
+typedef struct {
+    uint32_t            map;            /**< Map to variable in Object Dictionary. Same structure as in PDO. */
+    uint8_t             format;         /**< If bit 0 is 1, variable is unsigned. */
+    uint8_t             trigger;        /**< If different than zero, triggerTime is recorded, when variable goes through threshold. */
+    int32_t             threshold;      /**< Used with trigger. */
+    uint32_t            triggerTime;    /**< Last trigger time of the variable. */
+    int32_t             valuePrev;      /**< Previous value of the variable. */
+    void               *OD_variable;    /**< Set by CO_traceGroup_init(). */
+    const CO_trace_dataType_t *dt;      /**< Set by CO_traceGroup_init(). */
+} CO_traceColumn_t;
+
+
+/**
+ * Trace group object.
+ *
+ * Trace group records a set of variables at the same moment, immediately
+ * after each SYNC message, into one row with a shared time stamp. All
+ * variables are sampled in one pass in CO_process_SYNC_RPDO() context, after
+ * the synchronous RPDOs are processed. Rows are stored in circular buffer,
+ * oldest rows are overwritten, if buffer is full.
+ *
+ * Time stamps are in microseconds, accumulated from timeDifference_us, and
+ * wrap around after 2^32 us.
+ *
+ * Group is accessible via SDO at own Object Dictionary index, if it exists:
+ *  - Subindex 1: Number of rows in buffer (read). Writing 0 clears buffer.
+ *  - Subindex 5: Rows as domain (read). Each row contains 4 bytes time stamp
+ *    and 4 bytes for each column, little endian. Reading consumes the rows.
+ */
+typedef struct CO_traceGroup_t {
+    bool_t              enabled;        /**< True, if group is recording. */
+    CO_SDO_t           *SDO;            /**< From CO_traceGroup_init(). */
+    CO_traceColumn_t   *columns;        /**< From CO_traceGroup_init(). */
+    uint8_t             columnCount;    /**< From CO_traceGroup_init(). */
+    uint32_t           *timeBuffer;     /**< From CO_traceGroup_init(). */
+    int32_t            *valueBuffer;    /**< From CO_traceGroup_init(). */
+    uint32_t            bufferSize;     /**< From CO_traceGroup_init(), number of rows. */
+    volatile uint32_t   writePtr;       /**< Row in buffer, which will be next written. */
+    volatile uint32_t   readPtr;        /**< Row in buffer, which will be next read. */
+    uint32_t            timestamp;      /**< Current time stamp in microseconds. */
+    struct CO_traceGroup_t *next;       /**< Next group processed by CO_process_SYNC_RPDO() or NULL. */
+} CO_traceGroup_t;
+
+
+/**
+ * Initialize trace group object.
+ *
+ * Function must be called in the communication reset section. To be processed
+ * on SYNC, the group must be linked to CO->traceGroup (see CANopen.h) after
+ * CO_init().
+ *
+ * @param group This object will be initialized.
+ * @param SDO SDO server object.
+ * @param columns Array of columns with map, format, trigger and threshold set.
+ * @param columnCount Number of columns.
+ * @param timeBuffer Memory block for storing time stamps, bufferSize entries.
+ * @param valueBuffer Memory block for storing values, bufferSize * columnCount entries.
+ * @param bufferSize Number of rows in above buffers.
+ * @param idx_OD_traceGroup Index in Object Dictionary.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT (also
+ * if a column can not be mapped).
+ */
+CO_ReturnError_t CO_traceGroup_init(
+        CO_traceGroup_t        *group,
+        CO_SDO_t               *SDO,
+        CO_traceColumn_t       *columns,
+        uint8_t                 columnCount,
+        uint32_t               *timeBuffer,
+        int32_t                *valueBuffer,
+        uint32_t                bufferSize,
+        uint16_t                idx_OD_traceGroup);
+
+
+/**
+ * Process trace group object.
+ *
+ * Function is called by CO_process_SYNC_RPDO(). If syncWas is true, it
+ * records a row.
+ *
+ * @param group This object.
+ * @param syncWas True, if SYNC message was just received.
+ * @param timeDifference_us Time difference from previous function call in [microseconds].
+ */
+void CO_traceGroup_process(
+        CO_traceGroup_t        *group,
+        bool_t                  syncWas,
+        uint32_t                timeDifference_us);
+
 #ifdef __cplusplus
 }
 #endif /*__cplusplus*/
@@ -0,0 +1,474 @@
+/*
+ * CANopen trace - network trace collector.
+ *
+ * @file        CO_traceCollect.c
+ * @ingroup     CO_traceCollect
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_Emergency.h"
+#include "CO_SYNC.h"
+#include "CO_SDOmaster.h"
+#include "CO_SDOqueue.h"
+#include "CO_trace.h"
+#include "CO_traceCollect.h"
+
+
+/* traceConfig subindexes and format, see CO_trace */
+#define CO_TRACECOLLECT_SUB_AXIS    2U
+#define CO_TRACECOLLECT_SUB_MAP     5U
+#define CO_TRACECOLLECT_SUB_FORMAT  6U
+#define CO_TRACECOLLECT_SUB_START   9U
+#define CO_TRACECOLLECT_SUB_SIZE    1U
+#define CO_TRACECOLLECT_SUB_PLOT    5U
+#define CO_TRACECOLLECT_FORMAT_BIN  (1U << 1)
+
+/* CO_traceCollectSource_t::records, if plot is not read */
+#define CO_TRACECOLLECT_REJECTED    0xFFFFFFFFUL
+
+
+/*
+ * Read UNSIGNED32 from the plot or job data, little endian.
+ */
+static uint32_t CO_traceCollect_get(const uint8_t *p){
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+/*
+ * Add SDO job, value is written or read data is stored in the job.
+ */
+static void CO_traceCollect_addJob(
+        CO_traceCollect_t      *collect,
+        bool_t                  download,
+        uint8_t                 nodeId,
+        uint16_t                index,
+        uint8_t                 subIndex,
+        uint32_t                value,
+        uint8_t                 size)
+{
+    CO_traceCollectJob_t *tj = &collect->jobs[collect->jobCount++];
+
+    tj->data[0] = (uint8_t)value;
+    tj->data[1] = (uint8_t)(value >> 8);
+    tj->data[2] = (uint8_t)(value >> 16);
+    tj->data[3] = (uint8_t)(value >> 24);
+    tj->job.nodeId = nodeId;
+    tj->job.index = index;
+    tj->job.subIndex = subIndex;
+    tj->job.download = download;
+    tj->job.buffer = tj->data;
+    tj->job.bufferSize = size;
+    tj->job.object = collect;
+}
+
+
+/*
+ * Count finished job, record the first failure and signal the end of step.
+ */
+static void CO_traceCollect_done(
+        CO_traceCollect_t      *collect,
+        uint8_t                 nodeId,
+        CO_SDOclient_return_t   ret,
+        uint32_t                abortCode)
+{
+    if(ret != CO_SDOcli_ok_communicationEnd && collect->failedNodeId == 0){
+        collect->failedNodeId = nodeId;
+        collect->failedRet = ret;
+        collect->failedAbortCode = abortCode;
+    }
+    collect->jobsDone++;
+    if(collect->jobsDone == collect->jobCount && collect->pFunctSignal != NULL){
+        collect->pFunctSignal(collect->object, collect);
+    }
+}
+
+
+/*
+ * Callback of finished SDO job.
+ */
+static void CO_traceCollect_jobDone(
+        CO_SDOqueueJob_t       *job,
+        CO_SDOclient_return_t   ret,
+        uint32_t                abortCode,
+        uint32_t                dataSize)
+{
+    CO_traceCollect_t *collect = (CO_traceCollect_t*)job->object;
+    CO_traceCollectJob_t *tj = (CO_traceCollectJob_t*)job;
+    uint16_t n = collect->sourceCount;
+    uint16_t idx = (uint16_t)(tj - collect->jobs);
+
+    if(job->download){
+        CO_traceCollect_done(collect, job->nodeId, ret, abortCode);
+    }
+    else if(idx >= 2U * n){
+        /* plot, submitted only after the size was read */
+        CO_traceCollectSource_t *src = &collect->sources[idx - 2U * n];
+
+        /* Empty trace is not an error. With records on the node the plot
+         * is refused only while capture is in progress. */
+        if(ret == CO_SDOcli_endedWithServerAbort && abortCode == CO_SDO_AB_NO_DATA &&
+           src->records == 0)
+        {
+            ret = CO_SDOcli_ok_communicationEnd;
+            dataSize = 0;
+        }
+        src->dataSize = (ret == CO_SDOcli_ok_communicationEnd) ? dataSize : 0;
+        CO_traceCollect_done(collect, job->nodeId, ret, abortCode);
+    }
+    else if((idx & 1U) == 0U){
+        /* format, plot of windowed trace has 20 byte records */
+        if(ret == CO_SDOcli_ok_communicationEnd &&
+           (tj->data[0] >> 1) != (CO_TRACECOLLECT_FORMAT_BIN >> 1))
+        {
+            ret = CO_SDOcli_endedWithClientAbort;
+            abortCode = CO_SDO_AB_TYPE_MISMATCH;
+        }
+        collect->sources[idx / 2U].records = (ret == CO_SDOcli_ok_communicationEnd) ? 0U : CO_TRACECOLLECT_REJECTED;
+        CO_traceCollect_done(collect, job->nodeId, ret, abortCode);
+    }
+    else{
+        /* size, then read the plot of accepted source */
+        CO_traceCollectSource_t *src = &collect->sources[idx / 2U];
+        CO_SDOqueueJob_t *plot = &collect->jobs[2U * n + idx / 2U].job;
+
+        if(src->records != CO_TRACECOLLECT_REJECTED){
+            src->records = (ret == CO_SDOcli_ok_communicationEnd) ? CO_traceCollect_get(tj->data) : CO_TRACECOLLECT_REJECTED;
+        }
+        if(src->records == CO_TRACECOLLECT_REJECTED ||
+           CO_SDOqueue_submit(collect->SDOqueue, plot, 1) != CO_ERROR_NO)
+        {
+            /* plot job is finished without transfer */
+            collect->jobsDone++;
+        }
+        CO_traceCollect_done(collect, job->nodeId, ret, abortCode);
+    }
+}
+
+
+/*
+ * Prepare next step.
+ *
+ * @return CO_ERROR_NO or CO_ERROR_TX_BUSY.
+ */
+static CO_ReturnError_t CO_traceCollect_begin(
+        CO_traceCollect_t      *collect,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, CO_traceCollect_t *collect))
+{
+    if(collect->jobsDone != collect->jobCount){
+        return CO_ERROR_TX_BUSY;
+    }
+
+    collect->jobCount = 0;
+    collect->jobsDone = 0;
+    collect->failedNodeId = 0;
+    collect->failedRet = CO_SDOcli_ok_communicationEnd;
+    collect->failedAbortCode = 0;
+    collect->pFunctSignal = pFunctSignal;
+    collect->object = object;
+
+    return CO_ERROR_NO;
+}
+
+
+/*
+ * Submit prepared jobs.
+ */
+static void CO_traceCollect_submit(CO_traceCollect_t *collect){
+    uint16_t i;
+
+    if(collect->jobCount == 0){
+        if(collect->pFunctSignal != NULL){
+            collect->pFunctSignal(collect->object, collect);
+        }
+        return;
+    }
+
+    /* jobs are not contiguous CO_SDOqueueJob_t, submit one by one */
+    for(i=0; i<collect->jobCount; i++){
+        collect->jobs[i].job.pFunctSignal = CO_traceCollect_jobDone;
+        (void)CO_SDOqueue_submit(collect->SDOqueue, &collect->jobs[i].job, 1);
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_traceCollect_init(
+        CO_traceCollect_t      *collect,
+        CO_SDOqueue_t          *SDOqueue,
+        CO_traceCollectSource_t sources[],
+        uint16_t                sourceCount,
+        CO_traceCollectJob_t    jobs[],
+        uint16_t                jobsSize)
+{
+    uint16_t i;
+
+    /* verify arguments */
+    if(collect==NULL || SDOqueue==NULL || (sources==NULL && sourceCount!=0) || jobs==NULL ||
+       (uint32_t)jobsSize < CO_TRACECOLLECT_JOBS_PER_SOURCE * sourceCount)
+    {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    for(i=0; i<sourceCount; i++){
+        if(sources[i].nodeId < 1U || sources[i].nodeId > 127U ||
+           (sources[i].buffer == NULL && sources[i].bufferSize != 0))
+        {
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+        sources[i].dataSize = 0;
+        sources[i].pos = 0;
+    }
+
+    collect->SDOqueue = SDOqueue;
+    collect->sources = sources;
+    collect->sourceCount = sourceCount;
+    collect->jobs = jobs;
+    collect->jobCount = 0;
+    collect->jobsDone = 0;
+    collect->failedNodeId = 0;
+    collect->failedRet = CO_SDOcli_ok_communicationEnd;
+    collect->failedAbortCode = 0;
+    collect->pFunctSignal = NULL;
+    collect->object = NULL;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+uint32_t CO_traceCollect_startSync(const CO_SYNC_t *SYNC, uint8_t cycles){
+    uint8_t overflow;
+
+    if(SYNC == NULL || SYNC->counterOverflowValue < 2U){
+        return CO_TRACE_START_SYNC;
+    }
+
+    /* counter runs from 1 to overflow, 0 before the first SYNC */
+    overflow = SYNC->counterOverflowValue;
+    if(cycles == 0U){
+        cycles = 1;
+    }
+    else if(cycles >= overflow){
+        cycles = overflow - 1U;
+    }
+
+    return CO_TRACE_START_SYNC | (((uint32_t)SYNC->counter + cycles - 1U) % overflow + 1U);
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_traceCollect_arm(
+        CO_traceCollect_t      *collect,
+        uint32_t                start,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, CO_traceCollect_t *collect))
+{
+    CO_ReturnError_t err;
+    uint16_t i;
+
+    if(collect == NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    err = CO_traceCollect_begin(collect, object, pFunctSignal);
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+
+    /* map, format and start can only be written to disabled trace. Enabling
+     * clears the buffer on the node. */
+    for(i=0; i<collect->sourceCount; i++){
+        CO_traceCollectSource_t *src = &collect->sources[i];
+        uint16_t index = (uint16_t)(OD_INDEX_TRACE_CONFIG + src->traceNo);
+        uint8_t format = CO_TRACECOLLECT_FORMAT_BIN | (src->isUnsigned ? 1U : 0U);
+
+        src->dataSize = 0;
+        src->pos = 0;
+        CO_traceCollect_addJob(collect, true, src->nodeId, index, CO_TRACECOLLECT_SUB_AXIS, 0, 1);
+        CO_traceCollect_addJob(collect, true, src->nodeId, index, CO_TRACECOLLECT_SUB_MAP, src->map, 4);
+        CO_traceCollect_addJob(collect, true, src->nodeId, index, CO_TRACECOLLECT_SUB_FORMAT, format, 1);
+        CO_traceCollect_addJob(collect, true, src->nodeId, index, CO_TRACECOLLECT_SUB_START, start, 4);
+        CO_traceCollect_addJob(collect, true, src->nodeId, index, CO_TRACECOLLECT_SUB_AXIS, 1, 1);
+    }
+    CO_traceCollect_submit(collect);
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_traceCollect_upload(
+        CO_traceCollect_t      *collect,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, CO_traceCollect_t *collect))
+{
+    CO_ReturnError_t err;
+    uint16_t i;
+
+    if(collect == NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    err = CO_traceCollect_begin(collect, object, pFunctSignal);
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+
+    /* Jobs 2i and 2i+1 read format and size of source i, job 2n+i reads
+     * its plot. Plot is submitted from CO_traceCollect_jobDone(), after
+     * format and size are known. */
+    for(i=0; i<collect->sourceCount; i++){
+        CO_traceCollectSource_t *src = &collect->sources[i];
+        CO_SDOqueueJob_t *job = &collect->jobs[2U * collect->sourceCount + i].job;
+
+        src->dataSize = 0;
+        src->pos = 0;
+        src->records = CO_TRACECOLLECT_REJECTED;
+        CO_traceCollect_addJob(collect, false, src->nodeId, (uint16_t)(OD_INDEX_TRACE_CONFIG + src->traceNo),
+                               CO_TRACECOLLECT_SUB_FORMAT, 0, 1);
+        CO_traceCollect_addJob(collect, false, src->nodeId, (uint16_t)(OD_INDEX_TRACE + src->traceNo),
+                               CO_TRACECOLLECT_SUB_SIZE, 0, 4);
+
+        job->nodeId = src->nodeId;
+        job->index = (uint16_t)(OD_INDEX_TRACE + src->traceNo);
+        job->subIndex = CO_TRACECOLLECT_SUB_PLOT;
+        job->download = false;
+        job->buffer = src->buffer;
+        job->bufferSize = src->bufferSize;
+        job->object = collect;
+        job->pFunctSignal = CO_traceCollect_jobDone;
+    }
+    CO_traceCollect_submit(collect);
+    collect->jobCount = (uint16_t)(3U * collect->sourceCount);
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+uint32_t CO_traceCollect_merge(
+        CO_traceCollect_t      *collect,
+        uint32_t                rowTime[],
+        int32_t                 rowValues[],
+        uint32_t                rowsSize)
+{
+    uint16_t n, i;
+    uint32_t rows = 0;
+    uint32_t start = 0;
+    bool_t startValid = false;
+    int32_t *row;
+
+    if(collect==NULL || rowTime==NULL || rowValues==NULL || rowsSize==0){
+        return 0;
+    }
+    n = collect->sourceCount;
+
+    /* common start is the latest first point */
+    for(i=0; i<n; i++){
+        CO_traceCollectSource_t *src = &collect->sources[i];
+
+        src->pos = 0;
+        if(src->dataSize >= 8U){
+            uint32_t t = CO_traceCollect_get(src->buffer);
+
+            if(!startValid || (int32_t)(t - start) > 0){
+                start = t;
+            }
+            startValid = true;
+        }
+    }
+    if(!startValid){
+        return 0;
+    }
+
+    /* k-way merge, values of the next row are collected in place */
+    row = &rowValues[0];
+    for(i=0; i<n; i++){
+        row[i] = 0;
+    }
+    for(;;){
+        uint32_t t = 0;
+        bool_t found = false;
+
+        for(i=0; i<n; i++){
+            CO_traceCollectSource_t *src = &collect->sources[i];
+
+            if((src->pos + 8U) <= src->dataSize){
+                uint32_t ts = CO_traceCollect_get(&src->buffer[src->pos]);
+
+                if(!found || (int32_t)(ts - t) < 0){
+                    t = ts;
+                }
+                found = true;
+            }
+        }
+        if(!found){
+            break;
+        }
+
+        for(i=0; i<n; i++){
+            CO_traceCollectSource_t *src = &collect->sources[i];
+
+            while((src->pos + 8U) <= src->dataSize &&
+                  CO_traceCollect_get(&src->buffer[src->pos]) == t)
+            {
+                row[i] = (int32_t)CO_traceCollect_get(&src->buffer[src->pos + 4U]);
+                src->pos += 8U;
+            }
+        }
+
+        /* points before the common start only set the values */
+        if((int32_t)(t - start) < 0){
+            continue;
+        }
+        rowTime[rows++] = t;
+        if(rows == rowsSize){
+            break;
+        }
+        for(i=0; i<n; i++){
+            rowValues[rows * n + i] = row[i];
+        }
+        row = &rowValues[rows * n];
+    }
+
+    return rows;
+}
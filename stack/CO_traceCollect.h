@@ -0,0 +1,280 @@
+/**
+ * CANopen trace - network trace collector.
+ *
+ * @file        CO_traceCollect.h
+ * @ingroup     CO_traceCollect
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+
+#ifndef CO_traceCollect_H
+#define CO_traceCollect_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_traceCollect Network trace collector
+ * @ingroup CO_SDOmaster
+ * @{
+ *
+ * Collection of traces from multiple nodes into one time aligned dataset.
+ *
+ * Each source is one trace (see CO_trace) on a remote node. Collection has
+ * three steps:
+ *  - CO_traceCollect_arm() writes through CO_SDOqueue for each source
+ *    traceConfig (index #OD_INDEX_TRACE_CONFIG + traceNo): disables the trace,
+ *    writes _map_, binary _format_ and _start_ and enables the trace again.
+ *    Jobs of different nodes run in parallel. All sources get the same
+ *    _start_, so recording begins on all nodes at the same moment, either at
+ *    network time (CO_TIME_getMs() + margin, nodes must then use TIME
+ *    as timestamp for CO_trace_process()) or on a SYNC, see
+ *    CO_traceCollect_startSync(). Margin must cover the time needed for
+ *    arming. Nodes must support traceConfig subindex 9, otherwise they start
+ *    immediately.
+ *  - After recording, CO_traceCollect_upload() reads the binary plots
+ *    (index #OD_INDEX_TRACE + traceNo, subindex 5) of all sources in
+ *    parallel into their buffers. Large plots use block transfer. Before
+ *    the plot, _format_ and size of the trace are read: trace with
+ *    aggregation window (see CO_trace_initWindow()) has records of different
+ *    structure and its plot is not read.
+ *  - CO_traceCollect_merge() merges the plots by timestamp into rows. Each
+ *    row has a timestamp and the value of each source at that time (the last
+ *    recorded value, because traces record only changes).
+ */
+
+
+/** Number of SDO jobs per source, see CO_traceCollect_init() */
+#define CO_TRACECOLLECT_JOBS_PER_SOURCE 5U
+
+
+/**
+ * Trace on a remote node.
+ *
+ * Array is defined by the application, see CO_traceCollect_init().
+ */
+typedef struct{
+    /** Node-ID of the remote node */
+    uint8_t             nodeId;
+    /** Number of the trace on the node, 0 for the first trace */
+    uint8_t             traceNo;
+    /** Map to variable in object dictionary of the node, written to
+    traceConfig _map_. Same structure as in PDO. */
+    uint32_t            map;
+    /** True, if variable is unsigned */
+    bool_t              isUnsigned;
+    /** Buffer for the binary plot, 8 bytes per record, plus 8 bytes for the
+    last point */
+    uint8_t            *buffer;
+    /** Size of the buffer */
+    uint32_t            bufferSize;
+    /** Result: size of the uploaded plot in bytes */
+    uint32_t            dataSize;
+    /** Internal: read position in buffer */
+    uint32_t            pos;
+    /** Internal: number of records on the node before the plot is read */
+    uint32_t            records;
+}CO_traceCollectSource_t;
+
+
+/**
+ * SDO job of the trace collector.
+ *
+ * Array is defined by the application, see CO_traceCollect_init().
+ */
+typedef struct{
+    /** SDO client job, must be first */
+    CO_SDOqueueJob_t    job;
+    /** Data of the job, little endian */
+    uint8_t             data[4];
+}CO_traceCollectJob_t;
+
+
+/**
+ * Network trace collector object.
+ */
+typedef struct CO_traceCollect{
+    /** From CO_traceCollect_init() */
+    CO_SDOqueue_t      *SDOqueue;
+    /** From CO_traceCollect_init() */
+    CO_traceCollectSource_t *sources;
+    /** From CO_traceCollect_init() */
+    uint16_t            sourceCount;
+    /** From CO_traceCollect_init() */
+    CO_traceCollectJob_t *jobs;
+    /** Number of jobs of the last step */
+    uint16_t            jobCount;
+    /** Number of finished jobs of the last step */
+    uint16_t            jobsDone;
+    /** Node-ID of the first failed job, 0 if all succeeded */
+    uint8_t             failedNodeId;
+    /** Result of the first failed job */
+    CO_SDOclient_return_t failedRet;
+    /** SDO abort code of the first failed job */
+    uint32_t            failedAbortCode;
+    /** From CO_traceCollect_arm() or CO_traceCollect_upload() */
+    void              (*pFunctSignal)(void *object, struct CO_traceCollect *collect);
+    /** From CO_traceCollect_arm() or CO_traceCollect_upload() */
+    void               *object;
+}CO_traceCollect_t;
+
+
+/**
+ * Initialize network trace collector.
+ *
+ * @param collect This object will be initialized.
+ * @param SDOqueue SDO client request queue.
+ * @param sources Array of sources with fields nodeId, traceNo, map,
+ * isUnsigned, buffer and bufferSize set.
+ * @param sourceCount Number of sources.
+ * @param jobs Externally defined array for the jobs, must stay valid while
+ * collector is used.
+ * @param jobsSize Size of jobs array, at least
+ * #CO_TRACECOLLECT_JOBS_PER_SOURCE * sourceCount.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_traceCollect_init(
+        CO_traceCollect_t      *collect,
+        CO_SDOqueue_t          *SDOqueue,
+        CO_traceCollectSource_t sources[],
+        uint16_t                sourceCount,
+        CO_traceCollectJob_t    jobs[],
+        uint16_t                jobsSize);
+
+
+/**
+ * Calculate _start_ for recording on SYNC.
+ *
+ * If SYNC has a counter, recording starts on SYNC with the counter value
+ * cycles after the current one. Otherwise it starts on the next SYNC after
+ * arming, which is common for all nodes only, if arming finishes within one
+ * SYNC period.
+ *
+ * @param SYNC SYNC object of this device, producer or consumer.
+ * @param cycles Number of SYNC cycles for arming, 1 or more. Limited to the
+ * _Synchronous counter overflow value_.
+ *
+ * @return Value for CO_traceCollect_arm().
+ */
+uint32_t CO_traceCollect_startSync(const CO_SYNC_t *SYNC, uint8_t cycles);
+
+
+/**
+ * Configure and enable traces on all nodes.
+ *
+ * Buffers of the traces on the nodes are cleared. Trace config _trigger_ and
+ * _threshold_ of the nodes are not changed.
+ *
+ * @param collect This object.
+ * @param start Start condition written to traceConfig _start_ of each source,
+ * see CO_trace.
+ * @param object Pointer to object, which will be passed to pFunctSignal.
+ * @param pFunctSignal Callback after all jobs are finished, see
+ * CO_traceCollect_t::failedNodeId for the result. Not called if NULL.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_TX_BUSY, if jobs of the previous step are not finished.
+ */
+CO_ReturnError_t CO_traceCollect_arm(
+        CO_traceCollect_t      *collect,
+        uint32_t                start,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, CO_traceCollect_t *collect));
+
+
+/**
+ * Read binary plots of all sources.
+ *
+ * Reading consumes the records on the nodes. Trace, which has no records,
+ * gets dataSize 0 and is not a failure. Failures, source gets dataSize 0:
+ *  - Trace with aggregation window, _format_ doesn't read as binary:
+ *    failedRet is CO_SDOcli_endedWithClientAbort and failedAbortCode
+ *    CO_SDO_AB_TYPE_MISMATCH.
+ *  - Trace has records, but the plot can't be read, because capture is in
+ *    progress: failedRet is CO_SDOcli_endedWithServerAbort and
+ *    failedAbortCode CO_SDO_AB_NO_DATA.
+ *
+ * @param collect This object.
+ * @param object Pointer to object, which will be passed to pFunctSignal.
+ * @param pFunctSignal Callback after all plots are read, see
+ * CO_traceCollect_t::failedNodeId for the result. Not called if NULL.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_TX_BUSY, if jobs of the previous step are not finished.
+ */
+CO_ReturnError_t CO_traceCollect_upload(
+        CO_traceCollect_t      *collect,
+        void                   *object,
+        void                  (*pFunctSignal)(void *object, CO_traceCollect_t *collect));
+
+
+/**
+ * Merge uploaded plots into time aligned rows.
+ *
+ * Rows begin at the latest first timestamp of the sources, so each source
+ * has a valid value in each row. Points of different sources with the same
+ * timestamp give one row. Sources without data are ignored for the start and
+ * have value 0.
+ *
+ * @param collect This object.
+ * @param rowTime Externally defined array for the timestamps of the rows.
+ * @param rowValues Externally defined array for the values, rowsSize *
+ * sourceCount entries. Row n contains values of all sources, in order of
+ * sources array, beginning at rowValues[n * sourceCount]. Unsigned values are
+ * stored as they are.
+ * @param rowsSize Size of rowTime array.
+ *
+ * @return Number of rows. Rows, which don't fit, are dropped.
+ */
+uint32_t CO_traceCollect_merge(
+        CO_traceCollect_t      *collect,
+        uint32_t                rowTime[],
+        int32_t                 rowValues[],
+        uint32_t                rowsSize);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
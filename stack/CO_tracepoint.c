@@ -0,0 +1,196 @@
+/*
+ * Compile-time trace points for the CANopen processing functions.
+ *
+ * @file        CO_tracepoint.c
+ * @ingroup     CO_tracepoint
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_tracepoint.h"
+
+#ifdef CO_USE_TRACEPOINTS
+
+#include <string.h>
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+
+CO_TP_THREAD_LOCAL CO_tracepoint_ring_t *CO_tracepoint_ring = NULL;
+
+static CO_tracepoint_ring_t CO_tracepoint_rings[CO_TP_MAX_THREADS];
+/* Rings are taken in order by incrementing ringsReserved. Ring becomes
+ * visible to readers after its threadId is set, by raising ringsUsed. */
+static uint32_t CO_tracepoint_ringsReserved = 0U;
+static uint32_t CO_tracepoint_ringsUsed = 0U;
+
+
+/******************************************************************************/
+void CO_tracepoint_init(void){
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+    /* CoreDebug->DEMCR |= TRCENA; DWT->CYCCNT = 0; DWT->CTRL |= CYCCNTENA */
+    *(volatile uint32_t *)0xE000EDFCUL |= 1UL << 24;
+    *(volatile uint32_t *)0xE0001004UL = 0U;
+    *(volatile uint32_t *)0xE0001000UL |= 1UL;
+#endif
+    uint32_t used = __atomic_load_n(&CO_tracepoint_ringsUsed, __ATOMIC_ACQUIRE);
+    uint32_t i;
+
+    /* Threads keep their rings, pointers in their thread local storage can't
+     * be reset from here. Only the recorded events are cleared. */
+    for(i=0U; i<used; i++){
+        CO_tracepoint_ring_t *ring = &CO_tracepoint_rings[i];
+
+        __atomic_store_n(&ring->writePtr, 0U, __ATOMIC_RELAXED);
+        memset(ring->events, 0, sizeof(ring->events));
+    }
+}
+
+
+/******************************************************************************/
+CO_tracepoint_ring_t *CO_tracepoint_attach(void){
+    uint32_t index = __atomic_fetch_add(&CO_tracepoint_ringsReserved, 1U, __ATOMIC_RELAXED);
+    uint32_t used;
+    CO_tracepoint_ring_t *ring;
+
+    if(index >= CO_TP_MAX_THREADS){
+        __atomic_store_n(&CO_tracepoint_ringsReserved, CO_TP_MAX_THREADS, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    ring = &CO_tracepoint_rings[index];
+    ring->writePtr = 0U;
+#if defined(__linux__)
+    __atomic_store_n(&ring->threadId, (uint32_t)syscall(SYS_gettid), __ATOMIC_RELEASE);
+#else
+    __atomic_store_n(&ring->threadId, index + 1U, __ATOMIC_RELEASE);
+#endif
+
+    /* Publish last. Ring of a concurrent thread with lower index may still
+     * be without threadId, it is skipped by CO_tracepoint_getRing(). No
+     * waiting here, attach may also run in an interrupt. */
+    used = __atomic_load_n(&CO_tracepoint_ringsUsed, __ATOMIC_RELAXED);
+    while(used < index + 1U &&
+          !__atomic_compare_exchange_n(&CO_tracepoint_ringsUsed, &used, index + 1U,
+                                       false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    {
+    }
+    CO_tracepoint_ring = ring;
+    return ring;
+}
+
+
+/******************************************************************************/
+CO_tracepoint_ring_t *CO_tracepoint_getRing(uint16_t index){
+    uint32_t used = __atomic_load_n(&CO_tracepoint_ringsUsed, __ATOMIC_ACQUIRE);
+
+    if(index >= used || index >= CO_TP_MAX_THREADS ||
+       __atomic_load_n(&CO_tracepoint_rings[index].threadId, __ATOMIC_ACQUIRE) == 0U)
+    {
+        return NULL;
+    }
+    return &CO_tracepoint_rings[index];
+}
+
+
+#if defined(__linux__)
+/*
+ * Name of the trace point in the exported file.
+ */
+static const char *CO_tracepoint_name(uint16_t id){
+    switch(id){
+        case CO_TP_PROCESS:             return "CO_process";
+        case CO_TP_PROCESS_SYNC_RPDO:   return "CO_process_SYNC_RPDO";
+        case CO_TP_PROCESS_TPDO:        return "CO_process_TPDO";
+        case CO_TP_RX_CALLBACK:         return "CAN rx callback";
+        default:                        return NULL;
+    }
+}
+
+
+/******************************************************************************/
+int32_t CO_tracepoint_exportChrome(FILE *fp){
+    int32_t count = 0;
+    uint16_t r;
+    const char *sep = "";
+
+    if(fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[") < 0){
+        return -1;
+    }
+    for(r=0U; r<CO_TP_MAX_THREADS; r++){
+        const CO_tracepoint_ring_t *ring = CO_tracepoint_getRing(r);
+        uint32_t first, i;
+
+        if(ring == NULL){
+            continue;
+        }
+        first = (ring->writePtr > CO_TP_RING_SIZE) ? (ring->writePtr - CO_TP_RING_SIZE) : 0U;
+        for(i=first; i!=ring->writePtr; i++){
+            const CO_tracepoint_event_t *event = &ring->events[i & (CO_TP_RING_SIZE - 1U)];
+            const char *name = CO_tracepoint_name(event->id);
+            char userName[16];
+            int ret;
+
+            if(name == NULL){
+                snprintf(userName, sizeof(userName), "user %u", (unsigned)event->id);
+                name = userName;
+            }
+            ret = fprintf(fp, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,"
+                    "\"pid\":1,\"tid\":%lu,\"args\":{\"arg\":%u}}",
+                    sep, name, event->phase,
+                    (unsigned long long)(event->timestamp / 1000U),
+                    (unsigned)(event->timestamp % 1000U),
+                    (unsigned long)ring->threadId, (unsigned)event->arg);
+            if(ret < 0){
+                return -1;
+            }
+            sep = ",";
+            count++;
+        }
+    }
+    if(fprintf(fp, "\n]}\n") < 0){
+        return -1;
+    }
+    return count;
+}
+#endif /* __linux__ */
+
+#endif /* CO_USE_TRACEPOINTS */
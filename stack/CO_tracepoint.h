@@ -0,0 +1,248 @@
+/**
+ * Compile-time trace points for the CANopen processing functions.
+ *
+ * @file        CO_tracepoint.h
+ * @ingroup     CO_tracepoint
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_tracepoint_H
+#define CO_tracepoint_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_tracepoint Trace points
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * Timestamps at entry and exit of the CANopen hot paths.
+ *
+ * Trace points are enabled by defining CO_USE_TRACEPOINTS. Otherwise
+ * CO_TP_BEGIN() and CO_TP_END() expand to nothing and there is no code or
+ * data left in the binary.
+ *
+ * Instrumented are CO_process(), CO_process_SYNC_RPDO(), CO_process_TPDO()
+ * and the receive callback of each matching CAN message in the driver
+ * (argument is the index of the receive buffer). Application may use own
+ * identifiers starting with CO_TP_USER.
+ *
+ * Each thread records into its own ring of CO_TP_RING_SIZE events, so no
+ * locking is required in the fast path. The oldest events are overwritten.
+ * Without thread local storage (microcontrollers) only one ring is used;
+ * events recorded from interrupts may then overwrite events of the mainline.
+ *
+ * Timestamp source is CO_TP_TIMESTAMP(), which may be defined by the target.
+ * Default is CLOCK_MONOTONIC in nanoseconds on Linux and the DWT cycle
+ * counter on Cortex-M3/M4/M7, enabled by CO_tracepoint_init().
+ *
+ * On Linux CO_tracepoint_exportChrome() writes the collected events in the
+ * Chrome trace event format, which can be opened by chrome://tracing or
+ * https://ui.perfetto.dev.
+ */
+
+
+/**
+ * Trace point identifiers.
+ */
+typedef enum{
+    CO_TP_PROCESS           = 0,    /**< CO_process() */
+    CO_TP_PROCESS_SYNC_RPDO = 1,    /**< CO_process_SYNC_RPDO() */
+    CO_TP_PROCESS_TPDO      = 2,    /**< CO_process_TPDO() */
+    CO_TP_RX_CALLBACK       = 3,    /**< Receive callback, arg is buffer index */
+    CO_TP_USER              = 16    /**< First identifier for application */
+}CO_tracepoint_id_t;
+
+
+#ifdef CO_USE_TRACEPOINTS
+
+/** Number of events per ring, must be power of 2. */
+#ifndef CO_TP_RING_SIZE
+#define CO_TP_RING_SIZE         1024U
+#endif
+
+/** Maximum number of threads with own ring. */
+#ifndef CO_TP_MAX_THREADS
+#define CO_TP_MAX_THREADS       8U
+#endif
+
+#ifndef CO_TP_TIMESTAMP
+#if defined(__linux__)
+#include <time.h>
+static inline uint64_t CO_tracepoint_timestamp(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+#define CO_TP_TIMESTAMP()       CO_tracepoint_timestamp()
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+/** DWT->CYCCNT, 32 bit, wraps around. */
+#define CO_TP_TIMESTAMP()       (*(volatile uint32_t *)0xE0001004UL)
+#else
+#error Define CO_TP_TIMESTAMP() for this target.
+#endif
+#endif
+
+#ifndef CO_TP_THREAD_LOCAL
+#if defined(__linux__)
+#define CO_TP_THREAD_LOCAL      __thread
+#else
+#define CO_TP_THREAD_LOCAL
+#endif
+#endif
+
+
+/**
+ * Trace event.
+ */
+typedef struct{
+    uint64_t            timestamp;      /**< From CO_TP_TIMESTAMP() */
+    uint16_t            id;             /**< From CO_tracepoint_id_t */
+    uint16_t            arg;            /**< Argument, e.g. buffer index */
+    char                phase;          /**< 'B' for entry, 'E' for exit */
+}CO_tracepoint_event_t;
+
+
+/**
+ * Ring of trace events of one thread.
+ */
+typedef struct{
+    CO_tracepoint_event_t events[CO_TP_RING_SIZE]; /**< Events */
+    uint32_t            writePtr;       /**< Number of recorded events */
+    uint32_t            threadId;       /**< Thread identifier for export */
+}CO_tracepoint_ring_t;
+
+
+/** Ring of the calling thread, NULL before the first event. */
+extern CO_TP_THREAD_LOCAL CO_tracepoint_ring_t *CO_tracepoint_ring;
+
+
+/**
+ * Enable the timestamp source, if necessary, and clear events of all rings.
+ *
+ * Threads keep their rings, so it may be called again to restart recording.
+ * Call before the first trace point and while no events are recorded, not
+ * from realtime context.
+ */
+void CO_tracepoint_init(void);
+
+
+/**
+ * Assign a free ring to the calling thread.
+ *
+ * Called by CO_tracepoint_record() on first use.
+ *
+ * @return Ring or NULL, if CO_TP_MAX_THREADS rings are in use.
+ */
+CO_tracepoint_ring_t *CO_tracepoint_attach(void);
+
+
+/**
+ * Get ring by index, e.g. for reading out with debugger or own exporter.
+ *
+ * @param index from 0 to CO_TP_MAX_THREADS-1.
+ *
+ * @return Ring or NULL, if not in use or not yet completely assigned.
+ */
+CO_tracepoint_ring_t *CO_tracepoint_getRing(uint16_t index);
+
+
+/**
+ * Record an event into the ring of the calling thread.
+ *
+ * @param id Trace point identifier.
+ * @param arg Argument.
+ * @param phase 'B' or 'E'.
+ */
+static inline void CO_tracepoint_record(uint16_t id, uint16_t arg, char phase){
+    CO_tracepoint_ring_t *ring = CO_tracepoint_ring;
+    CO_tracepoint_event_t *event;
+
+    if(ring == NULL){
+        ring = CO_tracepoint_attach();
+        if(ring == NULL){
+            return;
+        }
+    }
+    event = &ring->events[ring->writePtr & (CO_TP_RING_SIZE - 1U)];
+    event->timestamp = CO_TP_TIMESTAMP();
+    event->id = id;
+    event->arg = arg;
+    event->phase = phase;
+    ring->writePtr++;
+}
+
+
+#if defined(__linux__)
+#include <stdio.h>
+/**
+ * Write events of all rings in Chrome trace event format (JSON).
+ *
+ * Rings are read without locking, so recording should be stopped before.
+ *
+ * @param fp Open output file.
+ *
+ * @return Number of exported events or -1 on write error.
+ */
+int32_t CO_tracepoint_exportChrome(FILE *fp);
+#endif
+
+/** Trace point at function entry. */
+#define CO_TP_BEGIN(id, arg)    CO_tracepoint_record((uint16_t)(id), (uint16_t)(arg), 'B')
+/** Trace point at function exit. */
+#define CO_TP_END(id, arg)      CO_tracepoint_record((uint16_t)(id), (uint16_t)(arg), 'E')
+
+#else /* CO_USE_TRACEPOINTS */
+
+#define CO_TP_BEGIN(id, arg)
+#define CO_TP_END(id, arg)
+
+#endif /* CO_USE_TRACEPOINTS */
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
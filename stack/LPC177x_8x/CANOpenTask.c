@@ -42,7 +42,7 @@
 /* Global variables and objects */
 volatile uint16_t CO_timer1ms = 0U; /* variable increments each millisecond */
 static bool canStackEnabled = true;
-void CO_TimerProcess(void);
+void CO_TimerProcess(uint16_t timer1msDiff);
 
 #ifdef TASK_WATCHDOG_ENABLED
 static hWatchdog			CanOpenWdHandler;
@@ -120,25 +120,40 @@ void CANOpenTask ( void *pvParameters )
     /* loop for normal program execution ******************************************/
                 uint16_t timer1msDiff;
 
-                CO_DISABLE_INTERRUPTS();
-				/*execution every 1 millisecond */
+#ifdef CO_PDO_DOUBLE_BUFFER
+				/*execution every 1 millisecond, PDO data is double buffered, so CAN
+				 interrupt stays enabled. */
                 timer1msDiff = CO_timer1ms - timer1msPrevious;
+                timer1msPrevious += timer1msDiff;
                 if(0 < timer1msDiff)
                 {
-                    CO_TimerProcess();
+                    CO_TimerProcess(timer1msDiff);
                 }
                 else
                 {
                     vTaskDelay(1);
                 }
-                timer1msPrevious = CO_timer1ms;
-                CO_ENABLE_INTERRUPTS();
+#else
+                CO_LOCK_OD();
+				/*execution every 1 millisecond */
+                timer1msDiff = CO_timer1ms - timer1msPrevious;
+                timer1msPrevious += timer1msDiff;
+                if(0 < timer1msDiff)
+                {
+                    CO_TimerProcess(timer1msDiff);
+                }
+                CO_UNLOCK_OD();
+                if(0 == timer1msDiff)
+                {
+                    vTaskDelay(1);
+                }
+#endif
 
                 /* Application interface */
                 programAsync(timer1msDiff);
 
                 /* CANopen process */
-                reset = CO_process(CO, timer1msDiff);
+                reset = CO_process(CO, timer1msDiff, NULL);
                 /* Process EEPROM */
 				
 #ifdef TASK_WATCHDOG_ENABLED
@@ -173,14 +188,18 @@ void /* interrupt */ CO_TimerInterruptHandler(void){
 }
 
 /* function executes every millisecond ************************/
-void CO_TimerProcess(void){
+void CO_TimerProcess(uint16_t timer1msDiff){
+    uint32_t timeDifference_us = (uint32_t)timer1msDiff * 1000U;
+    bool_t syncWas;
 
-    CO_process_RPDO(CO);
+    /* After SYNC, synchronous RPDOs are copied from the buffer received before
+     * the SYNC, while CAN interrupt already writes into the other one. */
+    syncWas = CO_process_SYNC_RPDO(CO, timeDifference_us);
 
     /* Application interface */
     program1ms();
 
-    CO_process_TPDO(CO);
+    CO_process_TPDO(CO, syncWas, timeDifference_us);
 
     /* verify timer overflow (is flag set again?) */
     if(0){
@@ -50,6 +50,7 @@
 #include "task.h"
 
 #include "board.h"
+#include <string.h>
 
 #include "CO_driver.h"
 #include "CO_Emergency.h"
@@ -393,13 +394,22 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
     }
   
     CO_LOCK_CAN_SEND();
-    
+
+#ifdef CO_PDO_DOUBLE_BUFFER
+    /* swap images, pending message is replaced by the latest data */
+    memcpy(&buffer->msg, buffer, sizeof(CAN_MSG_T));
+#endif
+
     /* if CAN TX buffer is free, copy message to it */
     TxBuf = Chip_CAN_GetFreeTxBuf(LPC_CAN);
     if( TxBuf < CAN_BUFFER_LAST && CANmodule->CANtxCount == 0){
         CANmodule->bufferInhibitFlag = buffer->syncFlag;
         /* copy message and txRequest */
+#ifdef CO_PDO_DOUBLE_BUFFER
+        Chip_CAN_Send(LPC_CAN, TxBuf, &buffer->msg);
+#else
         Chip_CAN_Send(LPC_CAN, TxBuf,(CAN_MSG_T*)buffer);
+#endif
        
         /*DEBUGOUT("CO_CANsend!!!\r\n");*/
         /*PrintCANMsg((CAN_MSG_T*)buffer);*/
@@ -618,7 +628,11 @@ void CO_CANinterrupt(CO_CANmodule_t *CANmodule){
                     if( TxBuf < CAN_BUFFER_LAST){
                         CANmodule->bufferInhibitFlag = buffer->syncFlag;
                         /* copy message and txRequest */
+#ifdef CO_PDO_DOUBLE_BUFFER
+                        Chip_CAN_Send(LPC_CAN, TxBuf, &buffer->msg);
+#else
                         Chip_CAN_Send(LPC_CAN, TxBuf,(CAN_MSG_T*)buffer);
+#endif
                     }
                     break;                      /* exit for loop */
                 }
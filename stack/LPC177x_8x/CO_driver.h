@@ -90,6 +90,18 @@
     #define CO_LOCK_OD()            taskENTER_CRITICAL()
     #define CO_UNLOCK_OD()          taskEXIT_CRITICAL()
 
+    /* receive runs in interrupt */
+    #define CO_LOCK_OD_RX()         { UBaseType_t CO_isrMaskRx = taskENTER_CRITICAL_FROM_ISR();
+    #define CO_UNLOCK_OD_RX()       taskEXIT_CRITICAL_FROM_ISR(CO_isrMaskRx); }
+
+
+/* Double buffered PDOs. If defined, CO_CANsend() copies the transmit buffer
+ * into a second image under CO_LOCK_CAN_SEND() and the interrupt sends only
+ * from that image. CANOpenTask then processes PDOs with interrupts enabled:
+ * synchronous RPDOs are already swapped on SYNC by CO_RPDO_t (two CANrxData
+ * buffers) and TPDO data may be written while previous message is pending. */
+/* #define CO_PDO_DOUBLE_BUFFER */
+
 
 /* Data types */
     /* int8_t to uint64_t are defined in stdint.h */
@@ -148,6 +160,9 @@ typedef struct{
 	uint8_t  data[CAN_MSG_MAX_DATA_LEN];/*!< Message Data */
     volatile bool_t     bufferFull;
     volatile bool_t     syncFlag;
+#ifdef CO_PDO_DOUBLE_BUFFER
+    CAN_MSG_T           msg;        /* image, sent by CAN module or interrupt */
+#endif
 }CO_CANtx_t;
 
 
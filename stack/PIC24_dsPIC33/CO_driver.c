@@ -52,11 +52,15 @@
 /* Globals */
     extern const CO_CANbitRateData_t  CO_CANbitRateData[8];
 
+/* Peripheral indirect addressing needs the DMA buffer area aligned to its
+ * size, rounded up to power of two. */
+    #define CO_CANmsgBuffAlign(size) ((size) > 16 ? 512 : ((size) > 8 ? 256 : 128))
+
 #if CO_CAN1msgBuffSize > 0
-    __eds__ CO_CANrxMsg_t CO_CAN1msg[CO_CAN1msgBuffSize] __eds __dma __attribute__((aligned(128)));
+    __eds__ CO_CANrxMsg_t CO_CAN1msg[CO_CAN1msgBuffSize] __eds __dma __attribute__((aligned(CO_CANmsgBuffAlign(CO_CAN1msgBuffSize))));
 #endif
 #if CO_CAN2msgBuffSize > 0
-    __eds__ CO_CANrxMsg_t CO_CAN2msg[CO_CAN1msgBuffSize] __eds __dma __attribute__((aligned(128)));
+    __eds__ CO_CANrxMsg_t CO_CAN2msg[CO_CAN2msgBuffSize] __eds __dma __attribute__((aligned(CO_CANmsgBuffAlign(CO_CAN2msgBuffSize))));
 #endif
 
 
@@ -216,9 +220,14 @@ CO_ReturnError_t CO_CANmodule_init(
     CANmodule->CANtxCount = 0U;
     CANmodule->errOld = 0U;
     CANmodule->em = NULL;
+    CANmodule->rxFifoNext = 1U;     /* FIFO starts with buffer 1 (FSA) */
+#if CO_CAN_RX_INDEX_SIZE > 0
+    CANmodule->rxIndexValid = false;
+#endif
 
     for(i=0U; i<rxSize; i++){
         rxArray[i].ident = 0U;
+        rxArray[i].mask = 0xFFFFU;
         rxArray[i].pFunct = NULL;
     }
     for(i=0U; i<txSize; i++){
@@ -292,6 +301,23 @@ CO_ReturnError_t CO_CANmodule_init(
         CAN_REG(CANbaseAddress, C_RXM1SID) = 0xFFE8;
         CAN_REG(CANbaseAddress, C_RXM2SID) = 0xFFE8;
     }
+#if CO_CAN_RX_INDEX_SIZE > 0
+    else{
+        /* CAN module filters are not used for each receive buffer. Filter i */
+        /* accepts all messages with function code i (CAN-ID bits 10..7), */
+        /* FILHIT then selects receive buffers from rxIndex. Filters are */
+        /* enabled by CO_CANrxIndexBuild() for function codes in use. */
+        CAN_REG(CANbaseAddress, C_FEN1) = 0x0000;
+        CAN_REG(CANbaseAddress, C_RXM0SID) = 0xF008;
+        CAN_REG(CANbaseAddress, C_RXM1SID) = 0xF008;
+        CAN_REG(CANbaseAddress, C_RXM2SID) = 0xF008;
+        pRXF = &CAN_REG(CANbaseAddress, C_RXF0SID);
+        for(i=0; i<16; i++){
+            *pRXF = i << 12;
+            pRXF += 2;
+        }
+    }
+#else
     else{
         /* CAN module filters are not used, all messages with standard 11-bit */
         /* identifier will be received */
@@ -300,6 +326,7 @@ CO_ReturnError_t CO_CANmodule_init(
         CAN_REG(CANbaseAddress, C_RXM1SID) = 0x0008;
         CAN_REG(CANbaseAddress, C_RXM2SID) = 0x0008;
     }
+#endif
 
     /* WIN = 0 - use buffer registers for default */
     CAN_REG(CANbaseAddress, C_CTRL1) &= 0xFFFE;
@@ -307,8 +334,16 @@ CO_ReturnError_t CO_CANmodule_init(
 
     /* Configure DMA controller */
     /* Set size of buffer in DMA RAM (FIFO Area Starts with Tx/Rx buffer TRB1 (FSA = 1)) */
-    /* Use maximum 16 buffers, because we have 16-bit system. */
-    if (CANmsgBuffSize >= 16) {
+    /* Buffers 16 to 31 are indicated in C_RXFUL2. */
+    if (CANmsgBuffSize >= 32) {
+        CAN_REG(CANbaseAddress, C_FCTRL) = 0xC001;
+        CANmodule->CANmsgBuffSize = 32;
+    }
+    else if(CANmsgBuffSize >= 24) {
+        CAN_REG(CANbaseAddress, C_FCTRL) = 0xA001;
+        CANmodule->CANmsgBuffSize = 24;
+    }
+    else if(CANmsgBuffSize >= 16) {
         CAN_REG(CANbaseAddress, C_FCTRL) = 0x8001;
         CANmodule->CANmsgBuffSize = 16;
     }
@@ -386,6 +421,47 @@ uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg){
 }
 
 
+#if CO_CAN_RX_INDEX_SIZE > 0
+/* Build receive index and enable hardware filters - internal usage only.
+ *
+ * rxIndex lists for each function code the receive buffers, which may accept
+ * it. Interrupt has higher priority and can not be interrupted by this
+ * function, so it searches linearly while rxIndexValid is false.
+ *
+ * @param CANmodule This object.
+ */
+static void CO_CANrxIndexBuild(CO_CANmodule_t *CANmodule){
+    uint16_t fc, i;
+    uint16_t count = 0U;
+    uint16_t FEN = 0U;
+
+    CANmodule->rxIndexValid = false;
+
+    for(fc=0U; fc<16U; fc++){
+        CANmodule->rxIndexStart[fc] = count;
+        for(i=0U; i<CANmodule->rxSize; i++){
+            CO_CANrx_t *buffer = &CANmodule->rxArray[i];
+
+            /* function code is in bits 12..9 of aligned identifier */
+            if(buffer->pFunct != NULL && (((fc << 9) ^ buffer->ident) & buffer->mask & 0x1E00) == 0U){
+                if(count >= CO_CAN_RX_INDEX_SIZE || i > 0xFFU){
+                    /* index too small, accept all and search linearly */
+                    CAN_REG(CANmodule->CANbaseAddress, C_FEN1) = 0xFFFF;
+                    return;
+                }
+                CANmodule->rxIndex[count++] = i;
+                FEN |= 1U << fc;
+            }
+        }
+    }
+    CANmodule->rxIndexStart[16] = count;
+
+    CAN_REG(CANmodule->CANbaseAddress, C_FEN1) = FEN;
+    CANmodule->rxIndexValid = true;
+}
+#endif
+
+
 /******************************************************************************/
 CO_ReturnError_t CO_CANrxBufferInit(
         CO_CANmodule_t         *CANmodule,
@@ -403,6 +479,9 @@ CO_ReturnError_t CO_CANrxBufferInit(
         CO_CANrx_t *buffer = &CANmodule->rxArray[index];
         uint16_t RXF, RXM;
         uint16_t addr = CANmodule->CANbaseAddress;
+#if CO_CAN_RX_INDEX_SIZE > 0
+        bool_t newBuffer = (buffer->pFunct == NULL) ? true : false;
+#endif
 
         /* Configure object variables */
         buffer->object = object;
@@ -479,7 +558,15 @@ CO_ReturnError_t CO_CANrxBufferInit(
                 }
             }
             CAN_REG(addr, C_CTRL1) = C_CTRL1old;
+#if CO_CAN_RX_INDEX_SIZE > 0
+            newBuffer = true;
+#endif
+        }
+#if CO_CAN_RX_INDEX_SIZE > 0
+        if(newBuffer && !CANmodule->useCANrxFilters){
+            CO_CANrxIndexBuild(CANmodule);
         }
+#endif
     }
     else{
         ret = CO_ERROR_ILLEGAL_ARGUMENT;
@@ -690,104 +777,143 @@ void CO_CANverifyErrors(CO_CANmodule_t *CANmodule){
 }
 
 
+/* Find receive buffer for message and process it - internal usage only.
+ *
+ * @param CANmodule This object.
+ * @param rcvMsg Received message in DMA buffer.
+ */
+static void CO_CANrxDispatch(CO_CANmodule_t *CANmodule, __eds__ CO_CANrxMsg_t *rcvMsg) {
+    uint16_t index;             /* index of received message */
+    uint16_t rcvMsgIdent;       /* identifier of the received message */
+    CO_CANrx_t *buffer = NULL;  /* receive message buffer from CO_CANmodule_t object. */
+    bool_t msgMatched = false;
+
+    rcvMsgIdent = rcvMsg->ident;
+    if(CANmodule->useCANrxFilters) {
+        /* CAN module filters are used. Message with known 11-bit identifier has */
+        /* been received */
+        index = rcvMsg->FILHIT;
+        if(index < CANmodule->rxSize) {
+            buffer = &CANmodule->rxArray[index];
+            /* verify also RTR */
+            if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U) {
+                msgMatched = true;
+            }
+        }
+    }
+#if CO_CAN_RX_INDEX_SIZE > 0
+    else if(CANmodule->rxIndexValid) {
+        /* Filter hit is the function code of the message. Search only the */
+        /* receive buffers, which accept this function code. */
+        uint8_t fc = rcvMsg->FILHIT & 0x0F;
+        uint8_t i;
+        for(i = CANmodule->rxIndexStart[fc]; i < CANmodule->rxIndexStart[fc + 1]; i++) {
+            buffer = &CANmodule->rxArray[CANmodule->rxIndex[i]];
+            if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U) {
+                msgMatched = true;
+                break;
+            }
+        }
+    }
+#endif
+    else {
+        /* CAN module filters are not used, message with any standard 11-bit identifier */
+        /* has been received. Search rxArray form CANmodule for the same CAN-ID. */
+        buffer = &CANmodule->rxArray[0];
+        for(index = CANmodule->rxSize; index > 0U; index--) {
+            if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U) {
+                msgMatched = true;
+                break;
+            }
+            buffer++;
+        }
+    }
+
+    /* Call specific function, which will process the message */
+    if(msgMatched && (buffer != NULL) && (buffer->pFunct != NULL)) {
+#ifdef __HAS_EDS__
+        CO_CANrxMsg_t _rcvMsg = *rcvMsg;
+        buffer->pFunct(buffer->object, &_rcvMsg);
+#else
+        buffer->pFunct(buffer->object, rcvMsg);
+#endif
+    }
+}
+
+
 /******************************************************************************/
 void CO_CANinterrupt(CO_CANmodule_t *CANmodule) {
 
-    /* receive interrupt (New CAN message is available in RX FIFO buffer) */
+    /* receive interrupt (New CAN messages are available in RX FIFO buffer) */
     if(CAN_REG(CANmodule->CANbaseAddress, C_INTF) & 0x02) {
         uint16_t C_CTRL1old;
-        uint16_t C_RXFUL1copy;
-        uint16_t C_FIFOcopy;
-        uint8_t FNRB, FBP;
-
-        CO_DISABLE_INTERRUPTS();
-        C_CTRL1old = CAN_REG(CANmodule->CANbaseAddress, C_CTRL1);
-        CAN_REG(CANmodule->CANbaseAddress, C_CTRL1) = C_CTRL1old & 0xFFFE;     /* WIN = 0 - use buffer registers */
-        C_RXFUL1copy = CAN_REG(CANmodule->CANbaseAddress, C_RXFUL1);
-        CAN_REG(CANmodule->CANbaseAddress, C_CTRL1) = C_CTRL1old;
+        uint16_t RXFULcopy[2];  /* C_RXFUL1 and C_RXFUL2 */
+        uint16_t RXFULdone[2];  /* serviced buffers */
+        uint16_t mask;
+        uint8_t FNRB = CANmodule->rxFifoNext;
 
-        /* We will service the buffers indicated by RXFUL copy, clear interrupt
-         * flag now and let interrupt hit again if more messages are received */
+        /* Clear interrupt flag now and let interrupt hit again if more
+         * messages are received. These are also drained below. */
         CAN_REG(CANmodule->CANbaseAddress, C_INTF) &= 0xFFFD;
-        C_FIFOcopy = CAN_REG(CANmodule->CANbaseAddress, C_FIFO);
-        CO_ENABLE_INTERRUPTS();
 
-        /* FNRB tells us which buffer to read in FIFO */
-        FNRB = C_FIFOcopy & 0x3F;
-        /* FBP tells us the next FIFO entry that will be written */
-        FBP = C_FIFOcopy >> 8;
-
-        while(C_RXFUL1copy != 0) {
-            __eds__ CO_CANrxMsg_t *rcvMsg;/* pointer to received message in CAN module */
-            uint16_t index;             /* index of received message */
-            uint16_t rcvMsgIdent;       /* identifier of the received message */
-            CO_CANrx_t *buffer = NULL;  /* receive message buffer from CO_CANmodule_t object. */
-            bool_t msgMatched = false;
-            uint16_t mask;
+        for(;;) {
+            CO_DISABLE_INTERRUPTS();
+            C_CTRL1old = CAN_REG(CANmodule->CANbaseAddress, C_CTRL1);
+            CAN_REG(CANmodule->CANbaseAddress, C_CTRL1) = C_CTRL1old & 0xFFFE;     /* WIN = 0 - use buffer registers */
+            RXFULcopy[0] = CAN_REG(CANmodule->CANbaseAddress, C_RXFUL1) & 0xFFFE; /* buffer 0 is for transmission */
+            RXFULcopy[1] = CAN_REG(CANmodule->CANbaseAddress, C_RXFUL2);
+            CAN_REG(CANmodule->CANbaseAddress, C_CTRL1) = C_CTRL1old;
+            CO_ENABLE_INTERRUPTS();
 
-            mask = 1 << FNRB;
+            if((RXFULcopy[0] | RXFULcopy[1]) == 0U) {
+                break;
+            }
 
-            if((C_RXFUL1copy & mask) == 0) {
+            if((RXFULcopy[FNRB >> 4] & (1 << (FNRB & 0x0F))) == 0) {
                 /* This should not happen. However, if it does happen
-                 * (in case of debugging), get FNRB from loop. */
+                 * (in case of debugging), continue with first full buffer. */
                 for(FNRB=1; FNRB<CANmodule->CANmsgBuffSize; FNRB++) {
-                    mask = 1 << FNRB;
-                    if((C_RXFUL1copy & mask)) {
+                    if(RXFULcopy[FNRB >> 4] & (1 << (FNRB & 0x0F))) {
                         break;
                     }
                 }
-            }
-
-            /* RXFUL is set for this buffer, service it */
-            rcvMsg = &CANmodule->CANmsgBuff[FNRB];
-            rcvMsgIdent = rcvMsg->ident;
-            if(CANmodule->useCANrxFilters) {
-                /* CAN module filters are used. Message with known 11-bit identifier has */
-                /* been received */
-                index = rcvMsg->FILHIT;
-                if(index < CANmodule->rxSize) {
-                    buffer = &CANmodule->rxArray[index];
-                    /* verify also RTR */
-                    if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U) {
-                        msgMatched = true;
-                    }
-                }
-            }
-            else {
-                /* CAN module filters are not used, message with any standard 11-bit identifier */
-                /* has been received. Search rxArray form CANmodule for the same CAN-ID. */
-                buffer = &CANmodule->rxArray[0];
-                for(index = CANmodule->rxSize; index > 0U; index--) {
-                    if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U) {
-                        msgMatched = true;
-                        break;
-                    }
-                    buffer++;
+                if(FNRB >= CANmodule->CANmsgBuffSize) {
+                    FNRB = 1;
+                    break;
                 }
             }
 
-            /* Call specific function, which will process the message */
-            if(msgMatched && (buffer != NULL) && (buffer->pFunct != NULL)) {
-        #ifdef __HAS_EDS__
-                CO_CANrxMsg_t _rcvMsg = *rcvMsg;
-                buffer->pFunct(buffer->object, &_rcvMsg);
-        #else
-                buffer->pFunct(buffer->object, rcvMsg);
-        #endif
+            /* Service all full buffers in FIFO order, FNRB is followed in
+             * software, so C_FIFO is not read for each message. */
+            RXFULdone[0] = 0U;
+            RXFULdone[1] = 0U;
+            mask = 1 << (FNRB & 0x0F);
+            while(RXFULcopy[FNRB >> 4] & mask) {
+                CO_CANrxDispatch(CANmodule, &CANmodule->CANmsgBuff[FNRB]);
+                RXFULcopy[FNRB >> 4] &= ~mask;
+                RXFULdone[FNRB >> 4] |= mask;
+
+                if(++FNRB >= CANmodule->CANmsgBuffSize) {
+                    FNRB = 1;
+                }
+                mask = 1 << (FNRB & 0x0F);
             }
 
-            /* Clear RXFUL flag */
+            /* Clear RXFUL flags of all serviced buffers at once */
             CO_DISABLE_INTERRUPTS();
             C_CTRL1old = CAN_REG(CANmodule->CANbaseAddress, C_CTRL1);
             CAN_REG(CANmodule->CANbaseAddress, C_CTRL1) = C_CTRL1old & 0xFFFE;     /* WIN = 0 - use buffer registers */
-            CAN_REG(CANmodule->CANbaseAddress, C_RXFUL1) &= ~(mask);
+            if(RXFULdone[0] != 0U) {
+                CAN_REG(CANmodule->CANbaseAddress, C_RXFUL1) &= ~RXFULdone[0];
+            }
+            if(RXFULdone[1] != 0U) {
+                CAN_REG(CANmodule->CANbaseAddress, C_RXFUL2) &= ~RXFULdone[1];
+            }
             CAN_REG(CANmodule->CANbaseAddress, C_CTRL1) = C_CTRL1old;
             CO_ENABLE_INTERRUPTS();
-            C_RXFUL1copy &= ~(mask);
-
-            /* Now update FNRB, it will point to a new buffer after RXFUL was cleared */
-            FNRB = (CAN_REG(CANmodule->CANbaseAddress, C_FIFO) & 0x3F);
         }
+
+        CANmodule->rxFifoNext = FNRB;
     }
 
     /* transmit interrupt (TX buffer is free) */
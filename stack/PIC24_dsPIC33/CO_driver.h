@@ -63,7 +63,9 @@
 
 
 /* CAN message buffer sizes for CAN module 1 and 2. Valid values
- * are 0, 4, 6, 8, 12, 16. Default is one TX and seven RX messages (FIFO). */
+ * are 0, 4, 6, 8, 12, 16, 24, 32. Default is one TX and seven RX messages (FIFO).
+ * Larger FIFO absorbs bursts at high bitrates, all received messages are
+ * drained in one interrupt. */
     #ifndef CO_CAN1msgBuffSize
         #define CO_CAN1msgBuffSize   8
     #endif
@@ -72,6 +74,20 @@
     #endif
 
 
+/* Size of receive index, if hardware filters can not be used for each
+ * receive buffer (more than 16 receive buffers). Then the 16 hardware
+ * filters accept one CANopen function code each (CAN-ID bits 10..7) and the
+ * filter hit selects the receive buffers with that function code. Index
+ * holds one byte for each receive buffer and function code it accepts.
+ * If too small or 0, receive buffers are searched linearly. */
+    #ifndef CO_CAN_RX_INDEX_SIZE
+        #define CO_CAN_RX_INDEX_SIZE 64
+    #endif
+    #if CO_CAN_RX_INDEX_SIZE > 255
+        #error CO_CAN_RX_INDEX_SIZE must fit into uint8_t
+    #endif
+
+
 /* Default DMA addresses for CAN modules. */
     #ifndef CO_CAN1_DMA0
         #define CO_CAN1_DMA0 ADDR_DMA0
@@ -458,6 +474,12 @@ typedef struct{
     volatile uint16_t   CANtxCount;
     uint16_t            errOld;
     void               *em;
+    uint8_t             rxFifoNext;     /* dsPIC33F specific: next FIFO buffer to read */
+#if CO_CAN_RX_INDEX_SIZE > 0
+    volatile bool_t     rxIndexValid;   /* dsPIC33F specific: rxIndex is used by interrupt */
+    volatile uint8_t    rxIndexStart[17]; /* first rxIndex entry for each function code */
+    volatile uint8_t    rxIndex[CO_CAN_RX_INDEX_SIZE]; /* rxArray indexes by function code */
+#endif
 }CO_CANmodule_t;
 
 
@@ -140,7 +140,11 @@ CO_ReturnError_t CO_CANmodule_init(
 
     /* Configure object variables */
     CANmodule->CANbaseAddress = CANbaseAddress;
+#ifdef CO_SYNC_HW_TIMER
+    CANmodule->CANmsgBuffSize = 34; /* Must be the same as size of CANmodule->CANmsgBuff array. */
+#else
     CANmodule->CANmsgBuffSize = 33; /* Must be the same as size of CANmodule->CANmsgBuff array. */
+#endif
     CANmodule->rxArray = rxArray;
     CANmodule->rxSize = rxSize;
     CANmodule->txArray = txArray;
@@ -177,6 +181,9 @@ CO_ReturnError_t CO_CANmodule_init(
     CAN_REG(CANbaseAddress, C_FIFOBA) = CO_KVA_TO_PA(CANmodule->CANmsgBuff);/* FIFO base address */
     CAN_REG(CANbaseAddress, C_FIFOCON) = (NO_CAN_RXF==32) ? 0x001F0000 : 0x000F0000;     /* FIFO0: receive FIFO, 32(16) buffers */
     CAN_REG(CANbaseAddress, C_FIFOCON+0x40) = 0x00000080;/* FIFO1: transmit FIFO, 1 buffer */
+#ifdef CO_SYNC_HW_TIMER
+    CAN_REG(CANbaseAddress, C_FIFOCON+0x80) = 0x00000083;/* FIFO2: transmit FIFO for SYNC, 1 buffer, highest priority (TXPRI = 3) */
+#endif
 
 
     /* Configure CAN timing */
@@ -417,6 +424,34 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
 }
 
 
+#ifdef CO_SYNC_HW_TIMER
+/******************************************************************************/
+CO_ReturnError_t CO_CANsendFromISR(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
+    uint16_t addr = CANmodule->CANbaseAddress;
+    volatile uint32_t* TX_FIFOcon = &CAN_REG(addr, C_FIFOCON+0x80);
+    volatile uint32_t* TX_FIFOconSet = &CAN_REG(addr, C_FIFOCON+0x88);
+    uint32_t* TXmsgBuffer = CO_PA_TO_KVA1(CAN_REG(addr, C_FIFOUA+0x80));
+    uint32_t* message = (uint32_t*) buffer;
+
+    /* previous SYNC is still waiting for the bus */
+    if((*TX_FIFOcon & 0x8) != 0){
+        CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, buffer->CMSGSID);
+        return CO_ERROR_TX_OVERFLOW;
+    }
+
+    /* FIFO 2 is used only from here, no lock is necessary */
+    *(TXmsgBuffer++) = *(message++);
+    *(TXmsgBuffer++) = *(message++);
+    *(TXmsgBuffer++) = *(message++);
+    *(TXmsgBuffer++) = *(message++);
+    *TX_FIFOconSet = 0x2000;   /* set UINC */
+    *TX_FIFOconSet = 0x0008;   /* set TXREQ */
+
+    return CO_ERROR_NO;
+}
+#endif
+
+
 /******************************************************************************/
 void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule){
     uint32_t tpdoDeleted = 0U;
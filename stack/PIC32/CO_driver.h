@@ -366,8 +366,13 @@ typedef struct{
 /* CAN module object. */
 typedef struct{
     uint16_t            CANbaseAddress;
+#ifdef CO_SYNC_HW_TIMER
+    CO_CANrxMsg_t       CANmsgBuff[34]; /* PIC32 specific: CAN message buffer for CAN module. 32 buffers for receive, 1 buffer for transmit, 1 buffer for SYNC transmit */
+    uint8_t             CANmsgBuffSize; /* PIC32 specific: Size of the above buffer == 34. Take care initial value! */
+#else
     CO_CANrxMsg_t       CANmsgBuff[33]; /* PIC32 specific: CAN message buffer for CAN module. 32 buffers for receive, 1 buffer for transmit */
     uint8_t             CANmsgBuffSize; /* PIC32 specific: Size of the above buffer == 33. Take care initial value! */
+#endif
     CO_CANrx_t         *rxArray;
     uint16_t            rxSize;
     CO_CANtx_t         *txArray;
@@ -442,6 +447,18 @@ CO_CANtx_t *CO_CANtxBufferInit(
 CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer);
 
 
+#ifdef CO_SYNC_HW_TIMER
+/* Send SYNC message from timer interrupt.
+ *
+ * Message is copied into FIFO 2, which is reserved for SYNC and has higher
+ * transmit priority than FIFO 1, so it does not wait for other messages.
+ * Used with CO_SYNC_HW_TIMER (see CO_SYNC.h). Interrupt must have the same
+ * priority as CAN interrupt.
+ */
+CO_ReturnError_t CO_CANsendFromISR(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer);
+#endif
+
+
 /* Clear all synchronous TPDOs from CAN module transmit buffers. */
 void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule);
 
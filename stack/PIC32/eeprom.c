@@ -48,6 +48,7 @@
 #include "CO_Emergency.h"
 #include "eeprom.h"
 #include "crc16-ccitt.h"
+#include <string.h>
 
 
 /* Eeprom *********************************************************************/
@@ -59,6 +60,12 @@
 #define SPISTAT         SPI2ASTAT
 #define SPISTATbits     SPI2ASTATbits
 #define SPIBRG          SPI2ABRG
+#define EE_CMD_READ     (unsigned)0b00000011
+#define EE_CMD_WRITE    (unsigned)0b00000010
+#define EE_CMD_WRDI     (unsigned)0b00000100
+#define EE_CMD_WREN     (unsigned)0b00000110
+#define EE_CMD_RDSR     (unsigned)0b00000101
+#define EE_CMD_WRSR     (unsigned)0b00000001
 static void EE_SPIwrite(uint8_t *tx, uint8_t *rx, uint8_t len);
 static void EE_writeEnable();
 static void EE_writeByteNoWait(uint8_t data, uint32_t addr);
@@ -69,6 +76,14 @@ static uint8_t EE_verifyBlock(uint8_t *data, uint32_t addr, uint32_t len);
 static void EE_writeStatus(uint8_t data);
 static uint8_t EE_readStatus();
 #define EE_isWriteInProcess()   (EE_readStatus() & 0x01) /* True if write is in process. */
+#ifdef EE_DMA
+#define EE_DMA_IDLE     0
+#define EE_DMA_READ     1
+#define EE_DMA_WRITE    2
+static void EE_DMAstart(CO_EE_t *ee, uint32_t len);
+static bool_t EE_DMAisFinished(void);
+static void EE_DMAwait(CO_EE_t *ee);
+#endif
 
 static uint32_t tmpU32;
 
@@ -90,6 +105,9 @@ static CO_SDO_abortCode_t CO_ODF_1010(CO_ODF_arg_t *ODF_arg){
             if(value == 0x65766173UL){
                 EE_MBR_t MBR;
 
+#ifdef EE_DMA
+                EE_DMAwait(ee);
+#endif
                 /* read the master boot record from the last page in eeprom */
                 EE_readBlock((uint8_t*)&MBR, EE_SIZE - EE_PAGE_SIZE, sizeof(MBR));
                 /* if EEPROM is not yet initilalized, enable it now */
@@ -142,6 +160,9 @@ static CO_SDO_abortCode_t CO_ODF_1011(CO_ODF_arg_t *ODF_arg){
             if(value == 0x64616F6CUL){
                 EE_MBR_t MBR;
 
+#ifdef EE_DMA
+                EE_DMAwait(ee);
+#endif
                 /* read the master boot record from the last page in eeprom */
                 EE_readBlock((uint8_t*)&MBR, EE_SIZE - EE_PAGE_SIZE, sizeof(MBR));
                 /* verify MBR for safety */
@@ -204,6 +225,11 @@ CO_ReturnError_t CO_EE_init_1(
                                   /* Enable SPI, 8-bit mode */
                                   /* SMP = 0, CKE = 1, CKP = 0 */
                                   /* MSTEN = 1 - master mode enable bit */
+#ifdef EE_DMA
+    SPICON |= 0x0000000D; /* STXISEL = 11 - tx request while tx buffer is not full */
+                                  /* SRXISEL = 01 - rx request while rx buffer is not empty */
+    DMACONSET = 0x00008000; /* enable DMA controller */
+#endif
 
     /* Set IOs directions for EEPROM SPI */
     EE_SSHigh();
@@ -220,6 +246,10 @@ CO_ReturnError_t CO_EE_init_1(
     ee->OD_ROMSize = OD_ROMSize;
     ee->OD_EEPROMCurrentIndex = 0;
     ee->OD_EEPROMWriteEnable = false;
+#ifdef EE_DMA
+    ee->DMAstate = EE_DMA_IDLE;
+    ee->DMAlength = 0;
+#endif
 
     /* read the master boot record from the last page in eeprom */
     EE_MBR_t MBR;
@@ -271,6 +301,64 @@ void CO_EE_init_2(
 
 
 /******************************************************************************/
+#ifdef EE_DMA
+void CO_EE_process(CO_EE_t *ee){
+    uint32_t addr;
+
+    if(ee == NULL || !ee->OD_EEPROMWriteEnable) return;
+
+    addr = ee->OD_EEPROMCurrentIndex;
+
+    switch(ee->DMAstate){
+        case EE_DMA_IDLE:
+            /* wait for the previous page write cycle, then read next page */
+            if(EE_isWriteInProcess()) break;
+
+            ee->DMAlength = ee->OD_EEPROMSize - addr;
+            if(ee->DMAlength > EE_PAGE_SIZE) ee->DMAlength = EE_PAGE_SIZE;
+
+            ee->DMAtx[0] = EE_CMD_READ;
+            ee->DMAtx[1] = (uint8_t) (addr >> 8);
+            ee->DMAtx[2] = (uint8_t) addr;
+            memset(&ee->DMAtx[3], 0, ee->DMAlength);
+            EE_DMAstart(ee, 3 + ee->DMAlength);
+            ee->DMAstate = EE_DMA_READ;
+            break;
+
+        case EE_DMA_READ:
+            if(!EE_DMAisFinished()) break;
+            EE_SSHigh();
+
+            /* if page in EEPROM and in RAM are different, then write whole page */
+            if(memcmp(&ee->DMArx[3], &ee->OD_EEPROMAddress[addr], ee->DMAlength) != 0){
+                EE_writeEnable();
+                ee->DMAtx[0] = EE_CMD_WRITE;
+                memcpy(&ee->DMAtx[3], &ee->OD_EEPROMAddress[addr], ee->DMAlength);
+                EE_DMAstart(ee, 3 + ee->DMAlength);
+                ee->DMAstate = EE_DMA_WRITE;
+                break;
+            }
+            /* page is equal, verify next page on next call */
+            addr += EE_PAGE_SIZE;
+            ee->OD_EEPROMCurrentIndex = (addr < ee->OD_EEPROMSize) ? addr : 0;
+            ee->DMAstate = EE_DMA_IDLE;
+            break;
+
+        case EE_DMA_WRITE:
+            if(!EE_DMAisFinished()) break;
+            EE_SSHigh();    /* starts the internal write cycle */
+
+            addr += EE_PAGE_SIZE;
+            ee->OD_EEPROMCurrentIndex = (addr < ee->OD_EEPROMSize) ? addr : 0;
+            ee->DMAstate = EE_DMA_IDLE;
+            break;
+
+        default:
+            ee->DMAstate = EE_DMA_IDLE;
+            break;
+    }
+}
+#else
 void CO_EE_process(CO_EE_t *ee){
     if(ee && ee->OD_EEPROMWriteEnable && !EE_isWriteInProcess()){
         /* verify next word */
@@ -286,19 +374,12 @@ void CO_EE_process(CO_EE_t *ee){
             EE_writeByteNoWait(RAMdata, i);
     }
 }
+#endif
 
 
 /******************************************************************************/
 /* EEPROM 25LC128 on SPI ******************************************************/
 /******************************************************************************/
-#define EE_CMD_READ     (unsigned)0b00000011
-#define EE_CMD_WRITE    (unsigned)0b00000010
-#define EE_CMD_WRDI     (unsigned)0b00000100
-#define EE_CMD_WREN     (unsigned)0b00000110
-#define EE_CMD_RDSR     (unsigned)0b00000101
-#define EE_CMD_WRSR     (unsigned)0b00000001
-
-
 /**
  * Function - EE_SPIwrite
  *
@@ -552,3 +633,73 @@ static uint8_t EE_readStatus(){
 
     return bufRx[1];
 }
+
+
+#ifdef EE_DMA
+/* DMA channel registers, DCHxCON, DCHxECON, ... */
+#define EE_DCH_(ch, reg)    DCH##ch##reg
+#define EE_DCH(ch, reg)     EE_DCH_(ch, reg)
+#define EE_TX(reg)          EE_DCH(EE_DMA_CH_TX, reg)
+#define EE_RX(reg)          EE_DCH(EE_DMA_CH_RX, reg)
+
+
+/*
+ * Start full duplex SPI transfer of ee->DMAtx into ee->DMArx with DMA. Eeprom
+ * is selected and stays selected, until EE_DMAisFinished() returns true.
+ *
+ * @param ee Eeprom object.
+ * @param len Number of bytes to transfer, max 3 + EE_PAGE_SIZE.
+ */
+static void EE_DMAstart(CO_EE_t *ee, uint32_t len){
+    /* rx channel: one byte from SPIBUF on each rx request, block of len bytes */
+    EE_RX(CON) = 0x03;      /* disabled, highest priority */
+    EE_RX(ECON) = ((uint32_t)EE_DMA_IRQ_RX << 8) | 0x10; /* start on IRQ */
+    EE_RX(SSA) = CO_KVA_TO_PA(&SPIBUF);
+    EE_RX(DSA) = CO_KVA_TO_PA(ee->DMArx);
+    EE_RX(SSIZ) = 1;
+    EE_RX(DSIZ) = len;
+    EE_RX(CSIZ) = 1;
+    EE_RX(INTCLR) = 0x00FF00FF;
+
+    /* tx channel: one byte into SPIBUF on each tx request */
+    EE_TX(CON) = 0x02;
+    EE_TX(ECON) = ((uint32_t)EE_DMA_IRQ_TX << 8) | 0x10;
+    EE_TX(SSA) = CO_KVA_TO_PA(ee->DMAtx);
+    EE_TX(DSA) = CO_KVA_TO_PA(&SPIBUF);
+    EE_TX(SSIZ) = len;
+    EE_TX(DSIZ) = 1;
+    EE_TX(CSIZ) = 1;
+    EE_TX(INTCLR) = 0x00FF00FF;
+
+    EE_SSLow();
+    EE_RX(CONSET) = 0x80;   /* CHEN */
+    EE_TX(CONSET) = 0x80;
+    EE_TX(ECONSET) = 0x80;  /* CFORCE, first byte */
+}
+
+
+/*
+ * Verify, if DMA SPI transfer has finished.
+ *
+ * @return true, if all bytes were received.
+ */
+static bool_t EE_DMAisFinished(void){
+    return (EE_RX(INT) & 0x08) ? true : false; /* CHBCIF - block transfer complete */
+}
+
+
+/*
+ * Finish background transfer, so blocking functions may use SPI. Interrupted
+ * page is verified again by next CO_EE_process().
+ *
+ * @param ee Eeprom object.
+ */
+static void EE_DMAwait(CO_EE_t *ee){
+    if(ee->DMAstate != EE_DMA_IDLE){
+        while(!EE_DMAisFinished());
+        EE_SSHigh();
+        ee->DMAstate = EE_DMA_IDLE;
+    }
+    while(EE_isWriteInProcess());
+}
+#endif
@@ -72,6 +72,35 @@
 #define EE_PAGE_SIZE    64
 
 
+/* Background page verification of OD_EEPROM with DMA.
+ *
+ * If defined, CO_EE_process() verifies OD_EEPROM one eeprom page at a time.
+ * Page is read with one SPI transfer, compared with RAM and if different, the
+ * whole page is written back with one write cycle. SPI transfers are made by
+ * two DMA channels, so CO_EE_process() only starts a transfer or checks, if it
+ * has finished, and never waits in the SPI polling loop. Without EE_DMA one
+ * byte is verified per call, with separate SPI transfers for read and write.
+ *
+ * EE_DMA_CH_TX and EE_DMA_CH_RX are free DMA channels (0...7), EE_DMA_IRQ_TX
+ * and EE_DMA_IRQ_RX are SPI interrupt request numbers, which start DMA cells.
+ */
+//#define EE_DMA
+#ifdef EE_DMA
+    #ifndef EE_DMA_CH_TX
+        #define EE_DMA_CH_TX    2
+    #endif
+    #ifndef EE_DMA_CH_RX
+        #define EE_DMA_CH_RX    3
+    #endif
+    #ifndef EE_DMA_IRQ_TX
+        #define EE_DMA_IRQ_TX   _SPI2A_TX_IRQ
+    #endif
+    #ifndef EE_DMA_IRQ_RX
+        #define EE_DMA_IRQ_RX   _SPI2A_RX_IRQ
+    #endif
+#endif
+
+
 /* Master boot record is stored on the last page in eeprom */
 typedef struct{
     uint32_t            CRC;            /* CRC code of the OD_ROM block */
@@ -88,6 +117,12 @@ typedef struct{
     uint32_t            OD_ROMSize;
     uint32_t            OD_EEPROMCurrentIndex;
     bool_t              OD_EEPROMWriteEnable;
+#ifdef EE_DMA
+    uint8_t             DMAstate;       /* idle, reading or writing a page */
+    uint32_t            DMAlength;      /* Length of the current page data */
+    uint8_t             DMAtx[3 + EE_PAGE_SIZE]; /* command, address and page */
+    uint8_t             DMArx[3 + EE_PAGE_SIZE];
+#endif
 
 }CO_EE_t;
 
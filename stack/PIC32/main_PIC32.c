@@ -96,6 +96,16 @@
     #define CO_TMR_ISR_PRIORITY IPC2bits.T2IP    /* Interrupt Priority */
     #define CO_TMR_ISR_ENABLE   IEC0bits.T2IE    /* Interrupt Enable bit */
 
+#ifdef CO_SYNC_HW_TIMER
+    /* Timer 4 and 5 as one 32 bit timer for SYNC producer, see CO_SYNC.h */
+    #define CO_SYNC_TMR_TMR          TMR4             /* TMR register */
+    #define CO_SYNC_TMR_PR           PR4              /* Period register */
+    #define CO_SYNC_TMR_CON          T4CON            /* Control register */
+    #define CO_SYNC_TMR_ISR_FLAG     IFS0bits.T5IF    /* Interrupt Flag bit */
+    #define CO_SYNC_TMR_ISR_PRIORITY IPC5bits.T5IP    /* Interrupt Priority */
+    #define CO_SYNC_TMR_ISR_ENABLE   IEC0bits.T5IE    /* Interrupt Enable bit */
+#endif
+
     #define CO_CAN_ISR() void __ISR(_CAN_1_VECTOR, IPL5SOFT) CO_CAN1InterruptHandler(void)
     #define CO_CAN_ISR_FLAG     IFS1bits.CAN1IF  /* Interrupt Flag bit */
     #define CO_CAN_ISR_PRIORITY IPC11bits.CAN1IP /* Interrupt Priority */
@@ -112,11 +122,35 @@
     volatile uint16_t CO_timer1ms = 0U; /* variable increments each millisecond */
     const CO_CANbitRateData_t   CO_CANbitRateData[8] = {CO_CANbitRateDataInitializers};
     static uint32_t tmpU32;
+#ifdef CO_SYNC_HW_TIMER
+    static uint32_t CO_SYNCtimerPeriod_us;  /* period of running SYNC timer or 0 */
+#endif
 #ifdef USE_EEPROM
     CO_EE_t                     CO_EEO;         /* Eeprom object */
 #endif
 
 
+#ifdef CO_SYNC_HW_TIMER
+/* Start, stop or reload SYNC timer, if SYNC producer or period changed *******/
+static void CO_SYNCtimer_process(void){
+    uint32_t period_us = CO->SYNC->isProducer ? CO->SYNC->periodTime : 0;
+
+    if(period_us != CO_SYNCtimerPeriod_us){
+        CO_SYNC_TMR_CON = 0;
+        CO_SYNC_TMR_ISR_ENABLE = 0;
+        if(period_us != 0){
+            CO_SYNC_TMR_TMR = 0;
+            CO_SYNC_TMR_PR = (uint32_t)((uint64_t)period_us * CO_PBCLK / 1000) - 1;
+            CO_SYNC_TMR_ISR_FLAG = 0;
+            CO_SYNC_TMR_ISR_ENABLE = 1;
+            CO_SYNC_TMR_CON = 0x8008;  /* start timer (TON=1), 32 bit mode (T32=1) */
+        }
+        CO_SYNCtimerPeriod_us = period_us;
+    }
+}
+#endif
+
+
 /* main ***********************************************************************/
 int main (void){
     CO_NMT_reset_cmd_t reset = CO_RESET_NOT;
@@ -164,6 +198,11 @@ int main (void){
         /* disable CAN and CAN interrupts */
         CO_CAN_ISR_ENABLE = 0;
         CO_CAN_ISR2_ENABLE = 0;
+#ifdef CO_SYNC_HW_TIMER
+        CO_SYNC_TMR_CON = 0;
+        CO_SYNC_TMR_ISR_ENABLE = 0;
+        CO_SYNCtimerPeriod_us = 0;
+#endif
 
         /* Read CANopen Node-ID and CAN bit-rate from object dictionary */
         nodeId = OD_CANNodeID;
@@ -208,6 +247,9 @@ int main (void){
         CO_CAN_ISR_PRIORITY = 5;   /* CAN1 Interrupt - Set higher priority than timer (set the same value in '#define CO_CAN_ISR_PRIORITY') */
         CO_CAN_ISR2_FLAG = 0;      /* CAN2 Interrupt - Clear flag */
         CO_CAN_ISR2_PRIORITY = 5;  /* CAN Interrupt - Set higher priority than timer (set the same value in '#define CO_CAN_ISR_PRIORITY') */
+#ifdef CO_SYNC_HW_TIMER
+        CO_SYNC_TMR_ISR_PRIORITY = 5; /* SYNC timer interrupt - Same priority as CAN, they don't preempt each other */
+#endif
 
 
         communicationReset();
@@ -223,6 +265,11 @@ int main (void){
         CO_CAN_ISR2_ENABLE = 1;
 #endif
 
+#ifdef CO_SYNC_HW_TIMER
+        CO_SYNC_setTimerDriven(CO->SYNC, true);
+        CO_SYNCtimer_process();
+#endif
+
 
         while(reset == CO_RESET_NOT){
 /* loop for normal program execution ******************************************/
@@ -261,6 +308,10 @@ int main (void){
             /* CANopen process */
             reset = CO_process(CO, timer1msDiff, NULL);
 
+#ifdef CO_SYNC_HW_TIMER
+            CO_SYNCtimer_process();
+#endif
+
             CO_clearWDT();
 
 
@@ -331,6 +382,15 @@ void __ISR(_TIMER_2_VECTOR, IPL3SOFT) CO_TimerInterruptHandler(void){
 #endif
 
 
+#ifdef CO_SYNC_HW_TIMER
+/* SYNC timer interrupt function transmits SYNC every SYNC period *************/
+void __ISR(_TIMER_5_VECTOR, IPL5SOFT) CO_SYNCtimerInterruptHandler(void){
+    CO_SYNC_TMR_ISR_FLAG = 0;
+    CO_SYNC_timerIsr(CO->SYNC);
+}
+#endif
+
+
 /* CAN interrupt function *****************************************************/
 CO_CAN_ISR(){
     CO_CANinterrupt(CO->CANmodule[0]);
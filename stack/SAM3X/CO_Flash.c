@@ -47,8 +47,12 @@
 //                                INCLUDES
 //============================================================================
 #include "CANopen.h"
+#include "CO_flashLog.h"
+#include "CO_Flash.h"
 #include "asf.h"
 
+#include <string.h>
+
 //============================================================================
 //                                DEFINES
 //============================================================================
@@ -60,8 +64,13 @@
 
 #define LAST_PAGE_ADDRESS           (IFLASH1_ADDR + IFLASH1_SIZE - (2*IFLASH1_PAGE_SIZE))
 #define PAGES_PER_FLASH_AREA        6
+#define FLASH_AREAS_PER_LOG         2
 #define CO_OD_FLASH_PARAM_DEFAULT   LAST_PAGE_ADDRESS - (1*PAGES_PER_FLASH_AREA*IFLASH1_PAGE_SIZE)
-#define CO_OD_FLASH_PARAM_RUNTIME   LAST_PAGE_ADDRESS - (2*PAGES_PER_FLASH_AREA*IFLASH1_PAGE_SIZE)
+// Runtime parameters are stored in a flash log, see CO_flashLog.h
+#define CO_OD_FLASH_PARAM_RUNTIME   LAST_PAGE_ADDRESS - ((1+FLASH_AREAS_PER_LOG)*PAGES_PER_FLASH_AREA*IFLASH1_PAGE_SIZE)
+// Runtime parameters of firmware before the flash log, taken over once by
+// CO_FlashInit(). Same area as the second page of the log.
+#define CO_OD_FLASH_PARAM_LEGACY    LAST_PAGE_ADDRESS - (2*PAGES_PER_FLASH_AREA*IFLASH1_PAGE_SIZE)
 #define IFLASH_PAGE_SIZE            IFLASH1_PAGE_SIZE
 
 #define CO_UNUSED(v)  (void)(v)
@@ -71,6 +80,9 @@
 //============================================================================
 extern struct sCO_OD_ROM CO_OD_ROM;
 
+static CO_flashLog_t CO_OD_flashLog;
+static uint8_t CO_OD_flashLogImage[sizeof(struct sCO_OD_ROM)];
+
 enum CO_OD_H1010_StoreParam_Sub
 {
   OD_H1010_STORE_PARAM_COUNT,
@@ -182,6 +194,123 @@ static CO_SDO_abortCode_t restoreParameters(uint32_t FlashAddress, uint8_t Param
   return CO_SDO_AB_NONE;
 }
 
+//============================================================================
+/**
+* Flash log callbacks, see CO_flashLog_init().
+*/
+static CO_ReturnError_t flashLogPrepare(uint32_t address, uint32_t size)
+{
+  uint32_t ret;
+
+  // Initialize flash, 6 wait states for flash writing.
+  if ((ret = flash_init(FLASH_ACCESS_MODE_128, 6)) != FLASH_RC_OK)
+  {
+    CO_DBG_PRINT("Flash initialization error %u\n\r", ret);
+    return CO_ERROR_DATA_CORRUPT;
+  }
+
+  // Unlock flash
+  if ((ret = flash_unlock(address, address + size, 0, 0)) != FLASH_RC_OK)
+  {
+    CO_DBG_PRINT("Flash unlock error %u\n\r", ret);
+    return CO_ERROR_DATA_CORRUPT;
+  }
+
+  return CO_ERROR_NO;
+}
+
+static CO_ReturnError_t flashLogErase(void *object, uint32_t address, uint32_t size)
+{
+  static uint8_t erased[IFLASH_PAGE_SIZE];
+  uint32_t addressPtr;
+
+  CO_UNUSED(object);
+
+  if (flashLogPrepare(address, size) != CO_ERROR_NO)
+  {
+    return CO_ERROR_DATA_CORRUPT;
+  }
+
+  // There is no plain erase command, erase and write pages with 0xFF
+  memset(erased, 0xFF, sizeof(erased));
+  for (addressPtr = address; addressPtr < (address + size); addressPtr += IFLASH_PAGE_SIZE)
+  {
+    if (flash_write(addressPtr, erased, IFLASH_PAGE_SIZE, 1) != FLASH_RC_OK)
+    {
+      CO_DBG_PRINT("Flash erase error at 0x%08x\n\r", addressPtr);
+      return CO_ERROR_DATA_CORRUPT;
+    }
+  }
+
+  return CO_ERROR_NO;
+}
+
+static CO_ReturnError_t flashLogProgram(void *object, uint32_t address, const void *data, uint32_t size)
+{
+  CO_UNUSED(object);
+
+  if (flashLogPrepare(address, size) != CO_ERROR_NO)
+  {
+    return CO_ERROR_DATA_CORRUPT;
+  }
+
+  // Program without erase, bytes outside of data are kept
+  if (flash_write(address, data, size, 0) != FLASH_RC_OK)
+  {
+    CO_DBG_PRINT("Flash programming error at 0x%08x\n\r", address);
+    return CO_ERROR_DATA_CORRUPT;
+  }
+
+  return CO_ERROR_NO;
+}
+
+static CO_ReturnError_t flashLogRead(void *object, uint32_t address, void *data, uint32_t size)
+{
+  CO_UNUSED(object);
+
+  memcpy(data, (const void *) address, size);
+
+  return CO_ERROR_NO;
+}
+
+//============================================================================
+/**
+* Copy runtime parameters stored by firmware before the flash log into the
+* object dictionary. Returns false, if there are no valid parameters.
+*/
+static bool_t loadLegacyParameters(void)
+{
+  struct sCO_OD_ROM LegacyObjDicParam;
+
+  flash_read(CO_OD_FLASH_PARAM_LEGACY, &LegacyObjDicParam, sizeof(LegacyObjDicParam));
+  if ((LegacyObjDicParam.FirstWord != CO_OD_FIRST_LAST_WORD) ||
+      (LegacyObjDicParam.LastWord  != CO_OD_FIRST_LAST_WORD))
+  {
+    return false;
+  }
+  CO_DBG_PRINT("Take over runtime parameters of previous firmware\n");
+  memcpy(&CO_OD_ROM, &LegacyObjDicParam, sizeof(CO_OD_ROM));
+
+  return true;
+}
+
+//============================================================================
+/**
+* Store parameters of object dictionary into the runtime flash log. Only
+* changed data are appended, the page is not erased.
+*/
+static CO_SDO_abortCode_t storeRuntimeParameters(void)
+{
+  CO_DBG_PRINT("Store runtime parameters\n");
+
+  if (CO_flashLog_store(&CO_OD_flashLog, &CO_OD_ROM) != CO_ERROR_NO)
+  {
+    return CO_SDO_AB_HW;
+  }
+
+  return CO_SDO_AB_NONE;
+}
+
 //============================================================================
 /**
 * Access to object dictionary OD_H1010_STORE_PARAM_FUNC
@@ -211,7 +340,7 @@ static CO_SDO_abortCode_t CO_ODF_1010_StoreParam(CO_ODF_arg_t *ODF_arg)
     return CO_SDO_AB_DATA_TRANSF;
   }
 
-  return storeParameters(CO_OD_FLASH_PARAM_RUNTIME, ODF_arg->subIndex);
+  return storeRuntimeParameters();
 }
 
 //============================================================================
@@ -251,7 +380,7 @@ static CO_SDO_abortCode_t CO_ODF_1011_RestoreParam(CO_ODF_arg_t *ODF_arg)
     return Result;
   }
 
-  return storeParameters(CO_OD_FLASH_PARAM_RUNTIME, OD_H1011_RESTORE_PARAM_ALL);
+  return storeRuntimeParameters();
 }
 
 //===========================================================================
@@ -266,7 +395,7 @@ void CO_FlashInit(void)
 {
   // Info on addresses for flash data and default flash data
 
-  CO_DBG_PRINT("Runtime OD flash, address 0x%08x, %u bytes\n\r", CO_OD_FLASH_PARAM_DEFAULT, PAGES_PER_FLASH_AREA*IFLASH1_PAGE_SIZE);
+  CO_DBG_PRINT("Runtime OD flash log, address 0x%08x, %u bytes\n\r", CO_OD_FLASH_PARAM_RUNTIME, FLASH_AREAS_PER_LOG*PAGES_PER_FLASH_AREA*IFLASH1_PAGE_SIZE);
   CO_DBG_PRINT("Default OD flash, address 0x%08x, %u bytes\n\r", CO_OD_FLASH_PARAM_DEFAULT, PAGES_PER_FLASH_AREA*IFLASH1_PAGE_SIZE);
 
   /* Before we can access the data, we need to make sure, that the flash
@@ -277,21 +406,40 @@ void CO_FlashInit(void)
   struct sCO_OD_ROM DefaultObjDicParam;
   flash_read(CO_OD_FLASH_PARAM_DEFAULT, &DefaultObjDicParam, sizeof(DefaultObjDicParam));
 
+  CO_flashLog_init(&CO_OD_flashLog, CO_OD_FLASH_PARAM_RUNTIME,
+                   PAGES_PER_FLASH_AREA*IFLASH1_PAGE_SIZE, FLASH_AREAS_PER_LOG,
+                   CO_OD_flashLogImage, sizeof(CO_OD_flashLogImage), (void*)0,
+                   flashLogErase, flashLogProgram, flashLogRead);
+
   /* If the default parameters are not present in flash, then we know that
      we need to create them for later restore. */
 
   if ((DefaultObjDicParam.FirstWord != CO_OD_FIRST_LAST_WORD) ||
       (DefaultObjDicParam.LastWord  != CO_OD_FIRST_LAST_WORD))
   {
-    storeParameters(CO_OD_FLASH_PARAM_RUNTIME, OD_H1010_STORE_PARAM_ALL);
+    storeRuntimeParameters();
     storeParameters(CO_OD_FLASH_PARAM_DEFAULT, OD_H1010_STORE_PARAM_ALL);
   }
-  else
+  else if (CO_flashLog_load(&CO_OD_flashLog, &CO_OD_ROM) != CO_ERROR_NO)
   {
-    restoreParameters(CO_OD_FLASH_PARAM_RUNTIME, OD_H1010_STORE_PARAM_ALL);
+    // No runtime parameters in the log yet. Take them over from the previous
+    // firmware or start the log with the defaults. The first snapshot goes to
+    // the first page of the log, so the legacy area is erased only after that
+    // succeeded.
+    if (!loadLegacyParameters())
+    {
+      restoreParameters(CO_OD_FLASH_PARAM_DEFAULT, OD_H1010_STORE_PARAM_ALL);
+    }
+    storeRuntimeParameters();
   }
 }
 
+//===========================================================================
+void CO_FlashProcess(void)
+{
+  CO_flashLog_process(&CO_OD_flashLog);
+}
+
 //===========================================================================
 void CO_FlashRegisterODFunctions(CO_t* CO)
 {
@@ -45,6 +45,8 @@
 
 #include "CO_driver.h"
 #include "CO_Emergency.h"
+#include "CO_tracepoint.h"
+#include "CO_statistics.h"
 
 #include "asf.h"
 #include "htc.h"
@@ -52,7 +54,9 @@
 #include "sn65hvd234.h"
 
 #define CO_UNUSED(v)  (void)(v)
-#define CANMB_TX      (CANMB_NUMBER - 1)
+#define CANMB_TX      (CANMB_NUMBER - CO_CAN_TX_MB_COUNT) /* first transmit mailbox */
+#define CANMB_TX_MASK (((0x1u << CO_CAN_TX_MB_COUNT) - 1U) << CANMB_TX)
+#define CANMB_NONE    0xFFFFU
 
 void reset_mailbox_conf(can_mb_conf_t *p_mailbox)
 {
@@ -70,6 +74,157 @@ void reset_mailbox_conf(can_mb_conf_t *p_mailbox)
 }
 
 
+/* Configure receive mailbox i. Dedicated mailboxes compare all bits of ident,
+ * mailboxes with mask 0 accept every standard identifier. */
+static void CO_CANrxMailboxInit(CO_CANmodule_t *CANmodule, uint8_t i, uint32_t ident, uint32_t mask)
+{
+  reset_mailbox_conf(&CANmodule->rxMbConf[i]);
+  CANmodule->rxMbConf[i].ul_mb_idx = i;
+  CANmodule->rxMbConf[i].uc_obj_type = CAN_MB_RX_MODE;
+
+  /* Last catch-all mailbox keeps the newest message, if software is late */
+  if (i == (CO_CAN_RX_MB_COUNT-1))
+    CANmodule->rxMbConf[i].uc_obj_type = CAN_MB_RX_OVER_WR_MODE;
+
+  /* Standard mode only, not extended mode */
+  CANmodule->rxMbConf[i].ul_id_msk = CAN_MAM_MIDvA(mask);
+  CANmodule->rxMbConf[i].ul_id = CAN_MID_MIDvA(ident);
+  can_mailbox_init(CANmodule->CANbaseAddress, &CANmodule->rxMbConf[i]);
+}
+
+
+/* Configure all mailboxes after can_init() */
+static void CO_CANmailboxInit(CO_CANmodule_t *CANmodule)
+{
+  uint8_t i;
+
+  can_reset_all_mailbox(CANmodule->CANbaseAddress);
+
+  /* Dedicated mailboxes are disabled until CO_CANrxBufferInit() assigns them */
+  for (i = 0; i < CO_CAN_RX_MB_DEDICATED; i++)
+  {
+    reset_mailbox_conf(&CANmodule->rxMbConf[i]);
+    CANmodule->rxMbConf[i].ul_mb_idx = i;
+    CANmodule->rxMbIndex[i] = CANMB_NONE;
+  }
+
+  /* Catch-all mailboxes receive all messages with standard 11-bit identifier */
+  for (; i < CO_CAN_RX_MB_COUNT; i++)
+  {
+    CANmodule->rxMbIndex[i] = CANMB_NONE;
+    CO_CANrxMailboxInit(CANmodule, i, 0, 0);
+
+    /* Enable mailbox number i interrupt. */
+    can_enable_interrupt(CANmodule->CANbaseAddress, (0x1u << i));
+  }
+
+  /* Init upper mailboxes as transmit queue, priority is set per message */
+  for (i = 0; i < CO_CAN_TX_MB_COUNT; i++)
+  {
+    reset_mailbox_conf(&CANmodule->txMbConf[i]);
+    CANmodule->txMbConf[i].ul_mb_idx = CANMB_TX + i;
+    CANmodule->txMbConf[i].uc_obj_type = CAN_MB_TX_MODE;
+    CANmodule->txMbConf[i].uc_tx_prio = 15;
+    CANmodule->txMbConf[i].uc_id_ver = 0;
+    CANmodule->txMbConf[i].ul_id_msk = 0;
+    can_mailbox_init(CANmodule->CANbaseAddress, &CANmodule->txMbConf[i]);
+    CANmodule->txMbBuffer[i] = NULL;
+  }
+}
+
+
+/* Write message into free transmit mailbox i and request transmission. Lower
+ * function code gets higher hardware priority (0 is the highest). Equal
+ * priority is sent from the lowest mailbox first, so the same buffer is never
+ * in two mailboxes at once, see CO_CANtxMailboxFree(). */
+static void CO_CANtxMailboxWrite(CO_CANmodule_t *CANmodule, uint8_t i, CO_CANtx_t *buffer)
+{
+  Can *p_can = CANmodule->CANbaseAddress;
+  can_mb_conf_t *mb = &CANmodule->txMbConf[i];
+  uint32_t mbIdx = mb->ul_mb_idx;
+
+  CANmodule->txMbBuffer[i] = buffer;
+  if (buffer->syncFlag)
+    CANmodule->bufferInhibitFlag = true;
+
+  mb->uc_tx_prio = (uint8_t)((buffer->ident >> 7) & 0x0FU);
+  p_can->CAN_MB[mbIdx].CAN_MMR = (p_can->CAN_MB[mbIdx].CAN_MMR & ~CAN_MMR_PRIOR_Msk)
+                               | CAN_MMR_PRIOR(mb->uc_tx_prio);
+
+  /* Copy message and txRequest */
+  mb->ul_id = CAN_MID_MIDvA(buffer->ident);
+  mb->ul_datal = *((uint32_t *) &(buffer->data[0]));
+  mb->ul_datah = *((uint32_t *) &(buffer->data[4]));
+  mb->uc_length = buffer->DLC;
+
+  if (buffer->rtr)
+    can_mailbox_tx_remote_frame(p_can, mb);
+  else
+    can_mailbox_write(p_can, mb);
+
+  can_global_send_transfer_cmd(p_can, 0x1u << mbIdx);
+  CO_STAT_TX(CANmodule, buffer - CANmodule->txArray);
+  CO_STAT_BUS(CANmodule, buffer->DLC);
+  can_enable_interrupt(p_can, 0x1u << mbIdx);
+}
+
+
+/* Return index of free transmit mailbox or CO_CAN_TX_MB_COUNT. If the buffer
+ * itself still waits in a mailbox, there is no free one, so messages with the
+ * same CAN-ID keep their order. */
+static uint8_t CO_CANtxMailboxFree(CO_CANmodule_t *CANmodule, const CO_CANtx_t *buffer)
+{
+  uint8_t i, free = CO_CAN_TX_MB_COUNT;
+
+  for (i = 0; i < CO_CAN_TX_MB_COUNT; i++)
+  {
+    if (CANmodule->txMbBuffer[i] == buffer)
+      return CO_CAN_TX_MB_COUNT;
+    if ((CANmodule->txMbBuffer[i] == NULL) && (free == CO_CAN_TX_MB_COUNT))
+      free = i;
+  }
+  return free;
+}
+
+
+/* Move messages from txArray into free transmit mailboxes. Called from
+ * interrupt after a transmission completed. */
+static void CO_CANtxQueueDrain(CO_CANmodule_t *CANmodule)
+{
+  uint16_t j;    /* Index of transmitting message */
+  uint16_t waiting = 0U;
+
+  /* First buffer */
+  CO_CANtx_t *buffer = &CANmodule->txArray[0];
+
+  /* Search through whole array of pointers to transmit message buffers. */
+  for (j = CANmodule->txSize; (j > 0U) && (CANmodule->CANtxCount > 0U); j--)
+  {
+    /* If message buffer is full, send it. */
+    if (buffer->bufferFull)
+    {
+      uint8_t i = CO_CANtxMailboxFree(CANmodule, buffer);
+
+      if (i < CO_CAN_TX_MB_COUNT)
+      {
+        buffer->bufferFull = false;
+        CANmodule->CANtxCount--;
+        CO_CANtxMailboxWrite(CANmodule, i, buffer);
+      }
+      else
+      {
+        waiting++;
+      }
+    }
+    buffer++;
+  }
+
+  /* Clear counter if no more messages */
+  if ((j == 0U) && (waiting == 0U))
+    CANmodule->CANtxCount = 0U;
+}
+
+
 /******************************************************************************/
 void CO_CANsetConfigurationMode(Can *CANbaseAddress)
 {
@@ -163,39 +318,7 @@ CO_ReturnError_t CO_CANmodule_init(
       NVIC_EnableIRQ(CAN0_IRQn);
     }
 
-    can_reset_all_mailbox(CANmodule->CANbaseAddress);
-
-    /* CAN module filters are not used, all messages with standard 11-bit */
-    /* identifier will be received */
-    /* Configure mask 0 so that all messages with standard identifier are accepted */
-
-    /* Init CAN0 mailbox 0-6 as reception mailboxes */
-    for (i = 0; i <= (CANMB_NUMBER-2); i++)
-    {
-      reset_mailbox_conf(&CANmodule->rxMbConf[i]);
-      CANmodule->rxMbConf[i].ul_mb_idx = i;
-      CANmodule->rxMbConf[i].uc_obj_type = CAN_MB_RX_MODE;
-
-      if (i == (CANMB_NUMBER-2))
-        CANmodule->rxMbConf[i].uc_obj_type = CAN_MB_RX_OVER_WR_MODE;
-
-      /* Standard mode only, not extended mode */
-      CANmodule->rxMbConf[i].ul_id_msk = CAN_MAM_MIDvA_Msk;
-      CANmodule->rxMbConf[i].ul_id = CAN_MID_MIDvA(0);
-      can_mailbox_init(CANmodule->CANbaseAddress, &CANmodule->rxMbConf[i]);
-
-      /* Enable CAN0 mailbox number i interrupt. */
-      can_enable_interrupt(CANmodule->CANbaseAddress, (0x1u << i));
-    }
-
-    /* Init last CAN0 mailbox, number 7, as transmit mailbox */
-    reset_mailbox_conf(&CANmodule->txMbConf);
-    CANmodule->txMbConf.ul_mb_idx = (CANMB_TX);
-    CANmodule->txMbConf.uc_obj_type = CAN_MB_TX_MODE;
-    CANmodule->txMbConf.uc_tx_prio = 14;
-    CANmodule->txMbConf.uc_id_ver = 0;
-    CANmodule->txMbConf.ul_id_msk = 0;
-    can_mailbox_init(CANmodule->CANbaseAddress, &CANmodule->txMbConf);
+    CO_CANmailboxInit(CANmodule);
   }
 
   if (CANmodule->CANbaseAddress == CAN1)
@@ -229,40 +352,7 @@ CO_ReturnError_t CO_CANmodule_init(
       NVIC_EnableIRQ(CAN1_IRQn);
     }
 
-    can_reset_all_mailbox(CANmodule->CANbaseAddress);
-
-    /* CAN module filters are not used, all messages with standard 11-bit */
-    /* identifier will be received */
-    /* Configure mask 0 so that all messages with standard identifier are accepted */
-
-    /* Init CAN1 mailbox 0-6 as reception mailboxes */
-
-    for (i = 0; i <= (CANMB_NUMBER-2); i++)
-    {
-      reset_mailbox_conf(&CANmodule->rxMbConf[i]);
-      CANmodule->rxMbConf[i].ul_mb_idx = i;
-      CANmodule->rxMbConf[i].uc_obj_type = CAN_MB_RX_MODE;
-
-      if (i == (CANMB_NUMBER-2))
-        CANmodule->rxMbConf[i].uc_obj_type = CAN_MB_RX_OVER_WR_MODE;
-
-      /* Standard mode only, not extended mode */
-      CANmodule->rxMbConf[i].ul_id_msk = CAN_MAM_MIDvA_Msk;
-      CANmodule->rxMbConf[i].ul_id = CAN_MID_MIDvA(0);
-      can_mailbox_init(CANmodule->CANbaseAddress, &CANmodule->rxMbConf[i]);
-
-      /* Enable CAN1 mailbox number i interrupt. */
-      can_enable_interrupt(CANmodule->CANbaseAddress, (0x1u << i));
-    }
-
-    /* Init last CAN1 mailbox, number 7, as transmit mailbox */
-    reset_mailbox_conf(&CANmodule->txMbConf);
-    CANmodule->txMbConf.ul_mb_idx = (CANMB_TX);
-    CANmodule->txMbConf.uc_obj_type = CAN_MB_TX_MODE;
-    CANmodule->txMbConf.uc_tx_prio = 14;
-    CANmodule->txMbConf.uc_id_ver = 0;
-    CANmodule->txMbConf.ul_id_msk = 0;
-    can_mailbox_init(CANmodule->CANbaseAddress, &CANmodule->txMbConf);
+    CO_CANmailboxInit(CANmodule);
   }
 
   return CO_ERROR_NO;
@@ -312,9 +402,41 @@ CO_ReturnError_t CO_CANrxBufferInit(
     }
     buffer->mask = (mask & 0x07FFU) | 0x0800U;
 
-    /* Set CAN hardware module filter and mask. */
-    if(CANmodule->useCANrxFilters)
+    /* Set CAN hardware module filter and mask. SYNC and RPDOs with exact
+     * CAN-ID get a dedicated mailbox, if one is free. Other messages are
+     * received by the catch-all mailboxes. */
     {
+      uint8_t i, mbOld = CO_CAN_RX_MB_DEDICATED, mbNew = CO_CAN_RX_MB_DEDICATED;
+      uint16_t fc = ident & 0x0780U;
+      bool_t hot = !rtr && ((mask & 0x07FFU) == 0x07FFU)
+                && ((ident == 0x0080U) || ((fc >= 0x0200U) && (fc <= 0x0500U) && ((fc & 0x0080U) == 0U)));
+
+      for (i = 0; i < CO_CAN_RX_MB_DEDICATED; i++)
+      {
+        if (CANmodule->rxMbIndex[i] == index)
+          mbOld = i;
+        else if ((CANmodule->rxMbIndex[i] == CANMB_NONE) && (mbNew == CO_CAN_RX_MB_DEDICATED))
+          mbNew = i;
+      }
+      if (mbOld < CO_CAN_RX_MB_DEDICATED)
+        mbNew = mbOld;
+
+      if (hot && (mbNew < CO_CAN_RX_MB_DEDICATED))
+      {
+        can_disable_interrupt(CANmodule->CANbaseAddress, (0x1u << mbNew));
+        CANmodule->rxMbIndex[mbNew] = index;
+        CO_CANrxMailboxInit(CANmodule, mbNew, buffer->ident, 0x07FFU);
+        can_enable_interrupt(CANmodule->CANbaseAddress, (0x1u << mbNew));
+      }
+      else if (mbOld < CO_CAN_RX_MB_DEDICATED)
+      {
+        /* Release mailbox, message goes to catch-all mailboxes now */
+        can_disable_interrupt(CANmodule->CANbaseAddress, (0x1u << mbOld));
+        CANmodule->rxMbIndex[mbOld] = CANMB_NONE;
+        reset_mailbox_conf(&CANmodule->rxMbConf[mbOld]);
+        CANmodule->rxMbConf[mbOld].ul_mb_idx = mbOld;
+        can_mailbox_init(CANmodule->CANbaseAddress, &CANmodule->rxMbConf[mbOld]);
+      }
     }
   }
   else
@@ -368,33 +490,22 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
     }
     err = CO_ERROR_TX_OVERFLOW;
   }
-
   CO_LOCK_CAN_SEND();
 
-  /* If CAN TX buffer is free, copy message to it */
-  if (((can_mailbox_get_status(CANmodule->CANbaseAddress, CANMB_TX) & CAN_MSR_MRDY) == CAN_MSR_MRDY) && (CANmodule->CANtxCount == 0))
+  /* If CAN TX mailbox is free and nothing is queued before, copy message to it */
   {
-    CANmodule->bufferInhibitFlag = buffer->syncFlag;
-
-    /* Copy message and txRequest */
-    CANmodule->txMbConf.ul_id = CAN_MID_MIDvA(buffer->ident);
-    CANmodule->txMbConf.ul_datal = *((uint32_t *) &(buffer->data[0]));
-    CANmodule->txMbConf.ul_datah = *((uint32_t *) &(buffer->data[4]));
-    CANmodule->txMbConf.uc_length = buffer->DLC;
+    uint8_t i = CO_CANtxMailboxFree(CANmodule, buffer);
 
-    if (buffer->rtr)
-      can_mailbox_tx_remote_frame(CANmodule->CANbaseAddress, &CANmodule->txMbConf);
-    else
-      can_mailbox_write(CANmodule->CANbaseAddress, &CANmodule->txMbConf);
-
-    can_global_send_transfer_cmd(CANmodule->CANbaseAddress, 1 << CANMB_TX);
-  }
-  else /* If no buffer is free, message will be sent by interrupt */
-  {
-    buffer->bufferFull = true;
-    CANmodule->CANtxCount++;
+    if ((i < CO_CAN_TX_MB_COUNT) && (CANmodule->CANtxCount == 0))
+    {
+      CO_CANtxMailboxWrite(CANmodule, i, buffer);
+    }
+    else /* If no mailbox is free, message will be sent by interrupt */
+    {
+      buffer->bufferFull = true;
+      CANmodule->CANtxCount++;
+    }
   }
-  can_enable_interrupt(CANmodule->CANbaseAddress, 0x1u << CANMB_TX);
   CO_UNLOCK_CAN_SEND();
 
   return err;
@@ -409,10 +520,22 @@ void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule)
   CO_LOCK_CAN_SEND();
   /* Abort message from CAN module, if there is synchronous TPDO.
   * Take special care with this functionality. */
-  if(/*messageIsOnCanBuffer && */CANmodule->bufferInhibitFlag){
-    /* clear TXREQ */
+  if(CANmodule->bufferInhibitFlag){
+    uint8_t i;
+    uint8_t abortMask = 0U;
+
+    /* abort mailboxes with synchronous messages, interrupt frees them */
+    for(i = 0; i < CO_CAN_TX_MB_COUNT; i++){
+      CO_CANtx_t *inMb = CANmodule->txMbBuffer[i];
+      if((inMb != NULL) && inMb->syncFlag){
+        abortMask |= (uint8_t)(0x1u << (CANMB_TX + i));
+      }
+    }
+    if(abortMask != 0U){
+      can_global_send_abort_cmd(CANmodule->CANbaseAddress, abortMask);
+      tpdoDeleted = 1U;
+    }
     CANmodule->bufferInhibitFlag = false;
-    tpdoDeleted = 1U;
   }
   /* delete also pending synchronous TPDOs in TX buffers */
   if(CANmodule->CANtxCount != 0U){
@@ -515,131 +638,102 @@ void CO_CANverifyErrors(CO_CANmodule_t *CANmodule){
 void CO_CANinterrupt(CO_CANmodule_t *CANmodule)
 {
   uint32_t ul_status;
+  uint32_t mbReady;
 
   ul_status = can_get_status(CANmodule->CANbaseAddress);
-  if (ul_status & GLOBAL_MAILBOX_MASK)
+
+  /* Idle transmit mailboxes are always ready, handle enabled ones only */
+  mbReady = ul_status & can_get_interrupt_mask(CANmodule->CANbaseAddress) & GLOBAL_MAILBOX_MASK;
+  if (mbReady)
   {
-    for (uint8_t i = 0; i < CANMB_NUMBER; i++)
+    uint8_t i;
+
+    /* Receive mailboxes, handle all ready ones in one interrupt */
+    for (i = 0; i < CO_CAN_RX_MB_COUNT; i++)
     {
-      ul_status = can_mailbox_get_status(CANmodule->CANbaseAddress, i);
-      if ((ul_status & CAN_MSR_MRDY) == CAN_MSR_MRDY) //Mailbox Ready Bit
+      if (mbReady & (0x1u << i))
       {
-        //Handle interrupt
-        if (i != CANMB_TX)
+        //Receive interrupt
+        CO_CANrxMsg_t *rcvMsg;      /* pointer to received message in CAN module */
+        CO_CANrxMsg_t rcvMsgBuf;
+        uint16_t index;             /* index of received message */
+        uint32_t rcvMsgIdent;       /* identifier of the received message */
+        CO_CANrx_t *buffer = NULL;  /* receive message buffer from CO_CANmodule_t object. */
+        bool_t msgMatched = false;
+
+        CANmodule->rxMbConf[i].ul_mb_idx = i;
+        CANmodule->rxMbConf[i].ul_status = can_mailbox_get_status(CANmodule->CANbaseAddress, i);
+        can_mailbox_read(CANmodule->CANbaseAddress, &CANmodule->rxMbConf[i]);
+
+
+        /* Get message from module here */
+        memset(rcvMsgBuf.data, 0, 8);
+        memcpy(rcvMsgBuf.data, &CANmodule->rxMbConf[i].ul_datal, CANmodule->rxMbConf[i].uc_length);
+        rcvMsgBuf.ident = CANmodule->rxMbConf[i].ul_id;
+        rcvMsgBuf.DLC = CANmodule->rxMbConf[i].uc_length;
+
+        rcvMsg = &rcvMsgBuf;
+
+        rcvMsgIdent = rcvMsg->ident;
+        CO_STAT_BUS(CANmodule, rcvMsg->DLC);
+        index = CANmodule->rxMbIndex[i];
+        if(index < CANmodule->rxSize)
         {
-          //Receive interrupt
-          CO_CANrxMsg_t *rcvMsg;      /* pointer to received message in CAN module */
-          CO_CANrxMsg_t rcvMsgBuf;
-          uint16_t index;             /* index of received message */
-          uint32_t rcvMsgIdent;       /* identifier of the received message */
-          CO_CANrx_t *buffer = NULL;  /* receive message buffer from CO_CANmodule_t object. */
-          bool_t msgMatched = false;
-
-          CANmodule->rxMbConf[i].ul_mb_idx = i;
-          CANmodule->rxMbConf[i].ul_status = ul_status;
-          can_mailbox_read(CANmodule->CANbaseAddress, &CANmodule->rxMbConf[i]);
-
-
-          /* Get message from module here */
-          memset(rcvMsgBuf.data, 0, 8);
-          memcpy(rcvMsgBuf.data, &CANmodule->rxMbConf[i].ul_datal, CANmodule->rxMbConf[i].uc_length);
-          rcvMsgBuf.ident = CANmodule->rxMbConf[i].ul_id;
-          rcvMsgBuf.DLC = CANmodule->rxMbConf[i].uc_length;
-
-          rcvMsg = &rcvMsgBuf;
-
-          rcvMsgIdent = rcvMsg->ident;
-          if(CANmodule->useCANrxFilters)
+          /* Dedicated mailbox, message with known 11-bit identifier */
+          /* has been received */
+          buffer = &CANmodule->rxArray[index];
+          /* verify also RTR */
+          if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U)
           {
-            /* CAN module filters are used. Message with known 11-bit identifier has */
-            /* been received */
-            index = 0;  /* get index of the received message here. Or something similar */
-            if(index < CANmodule->rxSize)
-            {
-              buffer = &CANmodule->rxArray[index];
-              /* verify also RTR */
-              if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U)
-              {
-                msgMatched = true;
-              }
-            }
-          }
-          else
-          {
-            /* CAN module filters are not used, message with any standard 11-bit identifier */
-            /* has been received. Search rxArray from CANmodule for the same CAN-ID. */
-            buffer = &CANmodule->rxArray[0];
-            for(index = CANmodule->rxSize; index > 0U; index--)
-            {
-              if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U)
-              {
-                msgMatched = true;
-                break;
-              }
-              buffer++;
-            }
-          }
-
-          /* Call specific function, which will process the message */
-          if(msgMatched && (buffer != NULL) && (buffer->pFunct != NULL))
-          {
-            buffer->pFunct(buffer->object, rcvMsg);
+            msgMatched = true;
           }
         }
         else
         {
-          /* First CAN message (bootup) was sent successfully */
-          CANmodule->firstCANtxMessage = false;
-          /* Clear flag from previous message */
-          CANmodule->bufferInhibitFlag = false;
-          /* Are there any new messages waiting to be send */
-          if(CANmodule->CANtxCount > 0U)
+          /* Catch-all mailbox, message with any standard 11-bit identifier */
+          /* has been received. Search rxArray from CANmodule for the same CAN-ID. */
+          buffer = &CANmodule->rxArray[0];
+          for(index = CANmodule->rxSize; index > 0U; index--)
           {
-            uint16_t j;    /* Index of transmitting message */
-
-            /* First buffer */
-            CO_CANtx_t *buffer = &CANmodule->txArray[0];
-            /* Search through whole array of pointers to transmit message buffers. */
-            for(j = CANmodule->txSize; j > 0U; j--)
+            if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U)
             {
-              /* If message buffer is full, send it. */
-              if(buffer->bufferFull)
-              {
-                buffer->bufferFull = false;
-                CANmodule->CANtxCount--;
-
-                /* Copy message to CAN buffer */
-                CANmodule->txMbConf.ul_datal = *((uint32_t *) &(buffer->data[0]));
-                CANmodule->txMbConf.ul_datah = *((uint32_t *) &(buffer->data[4]));
-
-                /* Write transmit information into mailbox. */
-                CANmodule->txMbConf.ul_id = CAN_MID_MIDvA(buffer->ident);
-                CANmodule->txMbConf.uc_length = buffer->DLC;
-
-                if (buffer->rtr)
-                  can_mailbox_tx_remote_frame(CANmodule->CANbaseAddress, &CANmodule->txMbConf);
-                else
-                  can_mailbox_write(CANmodule->CANbaseAddress, &CANmodule->txMbConf);
-
-                can_global_send_transfer_cmd(CANmodule->CANbaseAddress, 1 << CANMB_TX);
-
-                break; /* Exit for loop */
-              }
-              buffer++;
-            } /* End of for loop */
-
-            /* Clear counter if no more messages */
-            if(j == 0U){
-              CANmodule->CANtxCount = 0U;
+              msgMatched = true;
+              break;
             }
+            buffer++;
           }
-          else
-          {
-            /* Nothing more to send */
-            can_disable_interrupt(CANmodule->CANbaseAddress, 0x1u << CANMB_TX);
-          }
         }
-        break;
+
+        /* Call specific function, which will process the message */
+        if(msgMatched && (buffer != NULL) && (buffer->pFunct != NULL))
+        {
+          CO_TP_BEGIN(CO_TP_RX_CALLBACK, buffer - CANmodule->rxArray);
+          CO_STAT_RX(CANmodule, buffer - CANmodule->rxArray);
+          buffer->pFunct(buffer->object, rcvMsg);
+          CO_TP_END(CO_TP_RX_CALLBACK, buffer - CANmodule->rxArray);
+        }
+      }
+    }
+
+    /* Transmit mailboxes */
+    if (mbReady & CANMB_TX_MASK)
+    {
+      for (i = 0; i < CO_CAN_TX_MB_COUNT; i++)
+      {
+        if (mbReady & (0x1u << (CANMB_TX + i)))
+        {
+          /* Message was sent successfully or aborted */
+          CANmodule->txMbBuffer[i] = NULL;
+          can_disable_interrupt(CANmodule->CANbaseAddress, 0x1u << (CANMB_TX + i));
+        }
+      }
+      /* First CAN message (bootup) was sent successfully */
+      CANmodule->firstCANtxMessage = false;
+
+      /* Are there any new messages waiting to be send */
+      if(CANmodule->CANtxCount > 0U)
+      {
+        CO_CANtxQueueDrain(CANmodule);
       }
     }
   }
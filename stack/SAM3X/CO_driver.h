@@ -71,9 +71,33 @@
     */
 
 
+/* Mailbox usage. The controller has CANMB_NUMBER (8) mailboxes. The upper
+ * CO_CAN_TX_MB_COUNT mailboxes form a transmit queue. Each queued message gets
+ * hardware priority from its function code (CAN-ID >> 7), so NMT, SYNC and
+ * EMCY overtake PDOs and SDOs waiting in other mailboxes. The lower mailboxes
+ * receive. Up to (CANMB_NUMBER - CO_CAN_TX_MB_COUNT - CO_CAN_RX_MB_CATCHALL)
+ * of them are dedicated to single SYNC or RPDO COB-IDs with an exact
+ * acceptance mask and dispatch without software search. The last
+ * CO_CAN_RX_MB_CATCHALL receive mailboxes accept all standard identifiers. */
+#ifndef CO_CAN_TX_MB_COUNT
+    #define CO_CAN_TX_MB_COUNT      3
+#endif
+#ifndef CO_CAN_RX_MB_CATCHALL
+    #define CO_CAN_RX_MB_CATCHALL   2
+#endif
+    #define CO_CAN_RX_MB_COUNT      (CANMB_NUMBER - CO_CAN_TX_MB_COUNT)
+    #define CO_CAN_RX_MB_DEDICATED  (CO_CAN_RX_MB_COUNT - CO_CAN_RX_MB_CATCHALL)
+#if CO_CAN_TX_MB_COUNT < 1 || CO_CAN_RX_MB_CATCHALL < 1 || CO_CAN_RX_MB_DEDICATED < 0
+    #error Invalid mailbox configuration
+#endif
+
+
 /* Critical sections */
-    #define CO_LOCK_CAN_SEND()      //taskENTER_CRITICAL()
-    #define CO_UNLOCK_CAN_SEND()    //taskEXIT_CRITICAL()
+    /* CO_CANinterrupt() drains the tx queue, so CO_CANsend() masks interrupts.
+     * PRIMASK is restored, not cleared, so the lock may also be taken from an
+     * interrupt. The pair opens and closes a block, CMSIS comes from asf.h. */
+    #define CO_LOCK_CAN_SEND()      { uint32_t CO_primaskTx = __get_PRIMASK(); __disable_irq();
+    #define CO_UNLOCK_CAN_SEND()    __set_PRIMASK(CO_primaskTx); }
 
     #define CO_LOCK_EMCY()          //taskENTER_CRITICAL()
     #define CO_UNLOCK_EMCY()        //taskEXIT_CRITICAL()
@@ -156,8 +180,10 @@ typedef struct{
     volatile uint16_t   CANtxCount;
     uint32_t            errOld;
     void               *em;
-    can_mb_conf_t       rxMbConf[CANMB_NUMBER-1]; /* Reference to controller's mailboxes */
-    can_mb_conf_t       txMbConf;
+    can_mb_conf_t       rxMbConf[CO_CAN_RX_MB_COUNT]; /* Reference to controller's mailboxes */
+    can_mb_conf_t       txMbConf[CO_CAN_TX_MB_COUNT];
+    uint16_t            rxMbIndex[CO_CAN_RX_MB_COUNT]; /* rxArray index of dedicated mailbox or 0xFFFF */
+    CO_CANtx_t * volatile txMbBuffer[CO_CAN_TX_MB_COUNT]; /* Message in transmit mailbox or NULL */
 }CO_CANmodule_t;
 
 
@@ -48,7 +48,10 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f10x_conf.h"
 #include "CO_driver.h"
+#include "CO_SDO.h"
 #include "CO_Emergency.h"
+#include "CO_SYNC.h"
+#include "CO_CANfilter.h"
 #include "led.h"
 #include <string.h>
 
@@ -90,8 +93,107 @@ void CO_CANsetConfigurationMode(int32_t CANbaseAddress){
 }
 
 
+/******************************************************************************/
+/* Convert identifier or mask from rxArray alignment (ID << 2 | RTR << 1) into
+ * 16-bit bxCAN filter alignment (ID << 5 | RTR << 4 | IDE << 3) */
+static uint16_t CO_CANfilterTo16bit(uint32_t value){
+    return (uint16_t)((((value >> 2) & 0x07FF) << 5) | ((value & 0x02) ? 0x10 : 0));
+}
+
+#ifdef CO_CAN_RX_RING
+/* Get rx buffer for messages passing a hardware filter. This is the first rx
+ * buffer, which accepts all messages of the filter, if no buffer before it
+ * accepts any of them. Otherwise the buffer must be searched for each message. */
+static uint16_t CO_CANfilterIndex(CO_CANmodule_t *CANmodule, const CO_CANfilter_t *filter){
+    uint16_t i;
+
+    for (i = 0; i < CANmodule->rxSize; i++) {
+        CO_CANrx_t *rxBuffer = &CANmodule->rxArray[i];
+        uint32_t ident;
+        uint32_t mask;
+
+        if (rxBuffer->pFunct == 0) {
+            continue;
+        }
+        ident = CO_CANfilterTo16bit(rxBuffer->ident);
+        mask = CO_CANfilterTo16bit(rxBuffer->mask) | 0x08;
+        if (((ident ^ filter->ident) & mask & filter->mask) != 0) {
+            /* no message of the filter is accepted by this buffer */
+            continue;
+        }
+        if (((mask & ~filter->mask) == 0) && (((ident ^ filter->ident) & mask) == 0)) {
+            /* buffer accepts all messages of the filter */
+            return i;
+        }
+        break;
+    }
+    return CO_CAN_RX_INDEX_UNKNOWN;
+}
+#endif
+
+/* Program hardware acceptance filters from rxArray. Messages are still checked
+ * by software inside CO_CANinterrupt_Rx(), so merged filters may let some more
+ * messages pass. */
+static void CO_CANsetFilters(CO_CANmodule_t *CANmodule){
+    CAN_FilterInitTypeDef CAN_FilterInitStruct;
+    CO_CANfilter_t filters[CO_CAN_NO_FILTER_BANKS * 2 + 1];
+    uint16_t count = 0;
+    uint16_t i;
+
+#ifdef CO_CAN_RX_RING
+    for (i = 0; i < CO_CAN_NO_FILTER_BANKS * 2; i++) {
+        CANmodule->rxFilterIndex[i] = CO_CAN_RX_INDEX_UNKNOWN;
+    }
+#endif
+
+    /* add filters one by one, merge as soon as there are too many */
+    for (i = 0; i < CANmodule->rxSize; i++) {
+        CO_CANrx_t *rxBuffer = &CANmodule->rxArray[i];
+
+        if (rxBuffer->pFunct != 0) {
+            filters[count].ident = CO_CANfilterTo16bit(rxBuffer->ident);
+            /* IDE bit must match, only standard frames are used */
+            filters[count].mask = CO_CANfilterTo16bit(rxBuffer->mask) | 0x08;
+            count = CO_CANfilter_merge(filters, count + 1, CO_CAN_NO_FILTER_BANKS * 2);
+        }
+    }
+    if (count == 0) {
+        /* nothing configured, keep accept all filter */
+        return;
+    }
+
+    memset(&CAN_FilterInitStruct, 0, sizeof (CAN_FilterInitStruct));
+    CAN_FilterInitStruct.CAN_FilterFIFOAssignment = 0; // pouzivame jen FIFO0
+    CAN_FilterInitStruct.CAN_FilterMode = CAN_FilterMode_IdMask;
+    CAN_FilterInitStruct.CAN_FilterScale = CAN_FilterScale_16bit;
+    for (i = 0; i < CO_CAN_NO_FILTER_BANKS; i++) {
+        uint16_t first = i * 2;
+        uint16_t second = (first + 1 < count) ? (first + 1) : first;
+
+        CAN_FilterInitStruct.CAN_FilterNumber = i;
+        if (first < count) {
+            /* two filters per bank, an odd one is used twice */
+            CAN_FilterInitStruct.CAN_FilterIdLow = filters[first].ident;
+            CAN_FilterInitStruct.CAN_FilterMaskIdLow = filters[first].mask;
+            CAN_FilterInitStruct.CAN_FilterIdHigh = filters[second].ident;
+            CAN_FilterInitStruct.CAN_FilterMaskIdHigh = filters[second].mask;
+            CAN_FilterInitStruct.CAN_FilterActivation = ENABLE;
+#ifdef CO_CAN_RX_RING
+            /* filter match index: two per bank, low register first */
+            CANmodule->rxFilterIndex[first] = CO_CANfilterIndex(CANmodule, &filters[first]);
+            CANmodule->rxFilterIndex[first + 1] = CO_CANfilterIndex(CANmodule, &filters[second]);
+#endif
+        } else {
+            CAN_FilterInitStruct.CAN_FilterActivation = DISABLE;
+        }
+        CAN_FilterInit(&CAN_FilterInitStruct);
+    }
+}
+
+
 /******************************************************************************/
 void CO_CANsetNormalMode(CO_CANmodule_t *CANmodule){
+    CO_CANsetFilters(CANmodule);
     CANmodule->CANnormal = true;
 }
 
@@ -116,6 +218,11 @@ CO_ReturnError_t CO_CANmodule_init(
     if(CANmodule==NULL || rxArray==NULL || txArray==NULL){
         return CO_ERROR_ILLEGAL_ARGUMENT;
     }
+#ifdef CO_CAN_TX_PRIORITY
+    if(txSize > CO_CAN_TX_PENDING_WORDS * 32){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+#endif
 
     CANmodule->CANbaseAddress = CANbaseAddress;
     CANmodule->rxArray = rxArray;
@@ -129,6 +236,21 @@ CO_ReturnError_t CO_CANmodule_init(
     CANmodule->CANtxCount = 0;
     CANmodule->errOld = 0;
     CANmodule->em = 0;
+#ifdef CO_CAN_RX_RING
+    CANmodule->rxRingHead = 0;
+    CANmodule->rxRingTail = 0;
+    CANmodule->rxRingOverflow = 0;
+    CANmodule->rxRingOverflowOld = 0;
+    for (i = 0; i < CO_CAN_NO_FILTER_BANKS * 2; i++) {
+        CANmodule->rxFilterIndex[i] = CO_CAN_RX_INDEX_UNKNOWN;
+    }
+#endif
+#ifdef CO_CAN_TX_PRIORITY
+    for (i = 0; i < CO_CAN_TX_PENDING_WORDS; i++) {
+        CANmodule->txPending[i] = 0;
+    }
+    CANmodule->txMailboxSync = 0;
+#endif
 
 		// Replaced magic number 0x03 by (CAN_IT_TME | CAN_IT_FMP0) JvL
     CAN_ITConfig(CANmodule->CANbaseAddress, (CAN_IT_TME | CAN_IT_FMP0), DISABLE);
@@ -177,6 +299,9 @@ CO_ReturnError_t CO_CANmodule_init(
     CAN_InitStruct.CAN_BS1 = CAN_BS1_12tq;    // changed by VJ, old value = CAN_BS1_3tq;
     CAN_InitStruct.CAN_BS2 = CAN_BS2_5tq;     // changed by VJ, old value = CAN_BS2_2tq;
     CAN_InitStruct.CAN_NART = ENABLE;   // No Automatic retransmision
+#ifdef CO_CAN_TX_PRIORITY
+    CAN_InitStruct.CAN_TXFP = DISABLE;  // Mailboxes are sent by identifier priority
+#endif
 
    /* CO - Changed VJ Start */
     result = CAN_Init(CANmodule->CANbaseAddress, &CAN_InitStruct);
@@ -264,6 +389,13 @@ CO_ReturnError_t CO_CANrxBufferInit(
         rxBuffer->mask = RXM;
     }
 
+    //filters are programmed in CO_CANsetNormalMode(), later changes (PDO
+    //COB-ID, heartbeat consumer, SDO client) must reprogram them
+    if (CANmodule->CANnormal)
+    {
+        CO_CANsetFilters(CANmodule);
+    }
+
     return CO_ERROR_NO;
 }
 
@@ -331,11 +463,75 @@ int8_t getFreeTxBuff(CO_CANmodule_t *CANmodule)
     return -1;
 }
 
+#ifdef CO_CAN_TX_PRIORITY
+/******************************************************************************/
+/* Return index of pending transmit buffer with the lowest CAN identifier or -1. */
+static int32_t CO_CANtxPendingFirst(CO_CANmodule_t *CANmodule)
+{
+    int32_t first = -1;
+    uint32_t firstIdent = 0xFFFFFFFF;
+    uint16_t w;
+
+    for (w = 0; w < CO_CAN_TX_PENDING_WORDS; w++)
+    {
+        uint32_t bits = CANmodule->txPending[w];
+
+        while (bits != 0)
+        {
+            uint16_t index = w * 32 + __CLZ(__RBIT(bits));
+
+            if (CANmodule->txArray[index].ident < firstIdent)
+            {
+                firstIdent = CANmodule->txArray[index].ident;
+                first = index;
+            }
+            bits &= bits - 1;
+        }
+    }
+    return first;
+}
+
+/******************************************************************************/
+/* Copy pending messages into all free mailboxes, lowest CAN identifier first.
+ * Called from CO_CANinterrupt_Tx() or inside CO_LOCK_CAN_SEND(). */
+static void CO_CANtxFill(CO_CANmodule_t *CANmodule)
+{
+    int8_t txBuff;
+
+    while (CANmodule->CANtxCount > 0 && (txBuff = getFreeTxBuff(CANmodule)) != -1)
+    {
+        int32_t index = CO_CANtxPendingFirst(CANmodule);
+        CO_CANtx_t *buffer;
+
+        if (index < 0)
+        {
+            CANmodule->CANtxCount = 0;
+            break;
+        }
+        buffer = &CANmodule->txArray[index];
+        CANmodule->txPending[index >> 5] &= ~(1UL << (index & 31));
+        buffer->bufferFull = 0;
+        CANmodule->CANtxCount--;
+
+        /* CAN_Transmit() takes the same (first free) mailbox as getFreeTxBuff() */
+        if (buffer->syncFlag) CANmodule->txMailboxSync |= 1 << txBuff;
+        else                  CANmodule->txMailboxSync &= ~(1 << txBuff);
+        CO_CANsendToModule(CANmodule, buffer, txBuff);
+    }
+    CANmodule->bufferInhibitFlag = CANmodule->txMailboxSync ? 1 : 0;
+
+    /* tx interrupt is needed only while messages are waiting for mailbox */
+    CAN_ITConfig(CANmodule->CANbaseAddress, CAN_IT_TME, CANmodule->CANtxCount > 0 ? ENABLE : DISABLE);
+}
+#endif
+
 /******************************************************************************/
 CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
 {
     CO_ReturnError_t err = CO_ERROR_NO;
+#ifndef CO_CAN_TX_PRIORITY
     int8_t txBuff;
+#endif
 
     /* Verify overflow */
     if(buffer->bufferFull)
@@ -345,6 +541,20 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
         err = CO_ERROR_TX_OVERFLOW;
     }
 
+#ifdef CO_CAN_TX_PRIORITY
+    CO_LOCK_CAN_SEND();
+    //mark message as pending, then send pending messages in priority order
+    if(!buffer->bufferFull)
+    {
+        uint16_t index = buffer - CANmodule->txArray;
+
+        buffer->bufferFull = 1;
+        CANmodule->txPending[index >> 5] |= 1UL << (index & 31);
+        CANmodule->CANtxCount++;
+    }
+    CO_CANtxFill(CANmodule);
+    CO_UNLOCK_CAN_SEND();
+#else
     CO_LOCK_CAN_SEND();
     //if CAN TB buffer0 is free, copy message to it
      txBuff = getFreeTxBuff(CANmodule);
@@ -363,15 +573,87 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
         CAN_ITConfig(CANmodule->CANbaseAddress, CAN_IT_TME, ENABLE);
     }
     CO_UNLOCK_CAN_SEND();
+#endif
 
     return err;
 }
 
+#ifdef CO_SYNC_HW_TIMER
+/******************************************************************************/
+CO_ReturnError_t CO_CANsendFromISR(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
+{
+    uint32_t primask = __get_PRIMASK();
+    int8_t txBuff;
+
+    __set_PRIMASK(1);
+    txBuff = getFreeTxBuff(CANmodule);
+    //copy directly into free mailbox, messages waiting for a mailbox are overtaken
+    if(txBuff != -1 && !buffer->bufferFull)
+    {
+#ifdef CO_CAN_TX_PRIORITY
+        CANmodule->txMailboxSync &= ~(1 << txBuff);
+        CANmodule->bufferInhibitFlag = CANmodule->txMailboxSync ? 1 : 0;
+#endif
+        CO_CANsendToModule(CANmodule, buffer, txBuff);
+        __set_PRIMASK(primask);
+        return CO_ERROR_NO;
+    }
+    __set_PRIMASK(primask);
+
+    //all mailboxes are busy, SYNC waits like other messages
+    return CO_CANsend(CANmodule, buffer);
+}
+#endif
+
 /******************************************************************************/
 void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule)
 {
+#ifdef CO_CAN_TX_PRIORITY
+    uint32_t tpdoDeleted = 0;
+    uint16_t w;
+
+    CO_LOCK_CAN_SEND();
+    /* Abort synchronous TPDOs, which are still in mailboxes. */
+    if(CANmodule->txMailboxSync)
+    {
+        uint8_t txBuff;
 
+        for (txBuff = CAN_TXMAILBOX_0; txBuff <= CAN_TXMAILBOX_2; txBuff++)
+        {
+            if (CANmodule->txMailboxSync & (1 << txBuff))
+                CAN_CancelTransmit(CANmodule->CANbaseAddress, txBuff);
+        }
+        CANmodule->txMailboxSync = 0;
+        CANmodule->bufferInhibitFlag = 0;
+        tpdoDeleted = 1;
+    }
+    /* delete also pending synchronous TPDOs */
+    for (w = 0; w < CO_CAN_TX_PENDING_WORDS; w++)
+    {
+        uint32_t bits = CANmodule->txPending[w];
+
+        while (bits != 0)
+        {
+            uint32_t bit = __CLZ(__RBIT(bits));
+            CO_CANtx_t *buffer = &CANmodule->txArray[w * 32 + bit];
+
+            if (buffer->syncFlag)
+            {
+                buffer->bufferFull = 0;
+                CANmodule->txPending[w] &= ~(1UL << bit);
+                CANmodule->CANtxCount--;
+                tpdoDeleted = 2;
+            }
+            bits &= bits - 1;
+        }
+    }
+    CO_UNLOCK_CAN_SEND();
+
+    if(tpdoDeleted)
+        CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_TPDO_OUTSIDE_WINDOW, CO_EMC_COMMUNICATION, tpdoDeleted);
+#else
     /* See generic driver for implemetation. */
+#endif
 }
 
 /******************************************************************************/
@@ -383,6 +665,15 @@ void CO_CANverifyErrors(CO_CANmodule_t *CANmodule)
    err = CANmodule->CANbaseAddress->ESR;
    // if(CAN_REG(CANmodule->CANbaseAddress, C_INTF) & 4) err |= 0x80;
 
+#ifdef CO_CAN_RX_RING
+   //rx ring overflow
+   if(CANmodule->rxRingOverflow != CANmodule->rxRingOverflowOld)
+   {
+      CANmodule->rxRingOverflowOld = CANmodule->rxRingOverflow;
+      CO_errorReport(em, CO_EM_CAN_RXB_OVERFLOW, CO_EMC_CAN_OVERRUN, CANmodule->rxRingOverflowOld);
+   }
+#endif
+
    if(CANmodule->errOld != err)
    {
       CANmodule->errOld = err;
@@ -423,6 +714,91 @@ void CO_CANverifyErrors(CO_CANmodule_t *CANmodule)
    }
 }
 
+#ifdef CO_CAN_RX_RING
+/******************************************************************************/
+// Interrupt from Receiver, drain both FIFOs into rx ring
+void CO_CANinterrupt_Rx(CO_CANmodule_t *CANmodule)
+{
+    uint8_t fifo;
+    uint8_t received = 0;
+
+    for (fifo = CAN_FIFO0; fifo <= CAN_FIFO1; fifo++)
+    {
+        while (CAN_MessagePending(CANmodule->CANbaseAddress, fifo) != 0)
+        {
+            uint16_t head = CANmodule->rxRingHead;
+            CO_CANrxRingEntry_t *entry;
+
+            if ((uint16_t)(head - CANmodule->rxRingTail) >= CO_CAN_RX_RING_SIZE)
+            {
+                /* ring full, drop message */
+                CAN_FIFORelease(CANmodule->CANbaseAddress, fifo);
+                CANmodule->rxRingOverflow++;
+                continue;
+            }
+            entry = &CANmodule->rxRing[head & (CO_CAN_RX_RING_SIZE - 1)];
+            CAN_Receive(CANmodule->CANbaseAddress, fifo, &entry->msg);
+            /* filters are only configured for FIFO0 */
+            entry->index = (fifo == CAN_FIFO0 && entry->msg.FMI < CO_CAN_NO_FILTER_BANKS * 2) ?
+                           CANmodule->rxFilterIndex[entry->msg.FMI] : CO_CAN_RX_INDEX_UNKNOWN;
+            /* entry must be complete before consumer sees it */
+            __DMB();
+            CANmodule->rxRingHead = head + 1;
+            received = 1;
+        }
+    }
+    if (received)
+    {
+        CO_CAN_RX_SIGNAL(CANmodule);
+    }
+}
+
+/******************************************************************************/
+void CO_CANrxRing_process(CO_CANmodule_t *CANmodule)
+{
+    uint16_t tail = CANmodule->rxRingTail;
+
+    while (tail != CANmodule->rxRingHead)
+    {
+        CO_CANrxRingEntry_t *entry;
+        CO_CANrx_t *msgBuff = 0;
+        uint16_t msg;
+
+        __DMB();
+        entry = &CANmodule->rxRing[tail & (CO_CAN_RX_RING_SIZE - 1)];
+        msg = (entry->msg.StdId << 2) | (entry->msg.RTR ? 2 : 0);
+        /* filter map may be rebuilt after the message was queued, verify it */
+        if (entry->index < CANmodule->rxSize &&
+            ((msg ^ CANmodule->rxArray[entry->index].ident) & CANmodule->rxArray[entry->index].mask) == 0)
+        {
+            msgBuff = &CANmodule->rxArray[entry->index];
+        }
+        else
+        {
+            /* filter covers more rx buffers, search */
+            uint16_t index;
+
+            for (index = 0; index < CANmodule->rxSize; index++)
+            {
+                if (((msg ^ CANmodule->rxArray[index].ident) & CANmodule->rxArray[index].mask) == 0)
+                {
+                    msgBuff = &CANmodule->rxArray[index];
+                    break;
+                }
+            }
+        }
+        //Call specific function, which will process the message
+        if (msgBuff && msgBuff->pFunct)
+            msgBuff->pFunct(msgBuff->object, &entry->msg);
+
+        /* entry is free after callback returned */
+        __DMB();
+        tail++;
+        CANmodule->rxRingTail = tail;
+    }
+}
+
+#else
 /******************************************************************************/
 // Interrupt from Receiver
 void CO_CANinterrupt_Rx(CO_CANmodule_t *CANmodule)
@@ -449,9 +825,27 @@ void CO_CANinterrupt_Rx(CO_CANmodule_t *CANmodule)
             msgBuff->pFunct(msgBuff->object, &CAN1_RxMsg);
 		}
 }
+#endif
 
 /******************************************************************************/
 // Interrupt from Transeiver
+#ifdef CO_CAN_TX_PRIORITY
+void CO_CANinterrupt_Tx(CO_CANmodule_t *CANmodule)
+{
+    uint32_t TSR = CANmodule->CANbaseAddress->TSR;
+
+    /* Clear interrupt flags (request completed) */
+    CANmodule->CANbaseAddress->TSR = CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2;
+    /* First CAN message (bootup) was sent successfully */
+    CANmodule->firstCANtxMessage = 0;
+    /* empty mailboxes don't hold synchronous TPDOs any more */
+    if (TSR & CAN_TSR_TME0) CANmodule->txMailboxSync &= ~(1 << CAN_TXMAILBOX_0);
+    if (TSR & CAN_TSR_TME1) CANmodule->txMailboxSync &= ~(1 << CAN_TXMAILBOX_1);
+    if (TSR & CAN_TSR_TME2) CANmodule->txMailboxSync &= ~(1 << CAN_TXMAILBOX_2);
+    /* refill all free mailboxes */
+    CO_CANtxFill(CANmodule);
+}
+#else
 void CO_CANinterrupt_Tx(CO_CANmodule_t *CANmodule)
 {
 
@@ -490,6 +884,80 @@ void CO_CANinterrupt_Tx(CO_CANmodule_t *CANmodule)
         if(i == 0) CANmodule->CANtxCount = 0;
     }
 }
+#endif
+
+#ifdef CO_SYNC_HW_TIMER
+/******************************************************************************/
+void CO_SYNCtimer_init(
+        CO_SYNCtimer_t         *SYNCtimer,
+        TIM_TypeDef            *TIMx,
+        uint8_t                 IRQChannel,
+        uint32_t                clock_Hz,
+        void                   *SYNC)
+{
+    NVIC_InitTypeDef NVIC_InitStructure;
+
+    SYNCtimer->TIMx = TIMx;
+    SYNCtimer->clock_Hz = clock_Hz;
+    SYNCtimer->SYNC = SYNC;
+    SYNCtimer->period_us = 0;
+
+    TIM_Cmd(TIMx, DISABLE);
+    TIM_ITConfig(TIMx, TIM_IT_Update, DISABLE);
+
+    /* same priority as CAN interrupts, they don't preempt each other */
+    NVIC_InitStructure.NVIC_IRQChannel = IRQChannel;
+    NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+    NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStructure);
+
+    CO_SYNC_setTimerDriven((CO_SYNC_t*)SYNC, 1);
+    CO_SYNCtimer_process(SYNCtimer);
+}
+
+/******************************************************************************/
+void CO_SYNCtimer_process(CO_SYNCtimer_t *SYNCtimer)
+{
+    CO_SYNC_t *SYNC = (CO_SYNC_t*)SYNCtimer->SYNC;
+    uint32_t period_us = SYNC->isProducer ? SYNC->periodTime : 0;
+
+    if (period_us != SYNCtimer->period_us)
+    {
+        TIM_Cmd(SYNCtimer->TIMx, DISABLE);
+        TIM_ITConfig(SYNCtimer->TIMx, TIM_IT_Update, DISABLE);
+
+        if (period_us != 0)
+        {
+            TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+            /* timer ticks of 'div' microseconds, so period fits into 16 bits */
+            uint32_t div = (period_us >> 16) + 1;
+
+            TIM_TimeBaseStructInit(&TIM_TimeBaseStructure);
+            TIM_TimeBaseStructure.TIM_Prescaler = (uint16_t)(SYNCtimer->clock_Hz / 1000000 * div - 1);
+            TIM_TimeBaseStructure.TIM_Period = (uint16_t)(period_us / div - 1);
+            TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+            TIM_TimeBaseInit(SYNCtimer->TIMx, &TIM_TimeBaseStructure);
+
+            /* TIM_TimeBaseInit() sets update flag when loading prescaler */
+            TIM_ClearITPendingBit(SYNCtimer->TIMx, TIM_IT_Update);
+            TIM_ITConfig(SYNCtimer->TIMx, TIM_IT_Update, ENABLE);
+            TIM_Cmd(SYNCtimer->TIMx, ENABLE);
+        }
+        SYNCtimer->period_us = period_us;
+    }
+}
+
+/******************************************************************************/
+bool_t CO_SYNCtimer_interrupt(CO_SYNCtimer_t *SYNCtimer)
+{
+    if (TIM_GetITStatus(SYNCtimer->TIMx, TIM_IT_Update) == RESET)
+        return 0;
+    TIM_ClearITPendingBit(SYNCtimer->TIMx, TIM_IT_Update);
+
+    return CO_SYNC_timerIsr((CO_SYNC_t*)SYNCtimer->SYNC);
+}
+#endif
 
 /******************************************************************************/
 void CO_CANinterrupt_Status(CO_CANmodule_t *CANmodule)
@@ -75,6 +75,10 @@
     #define CO_LOCK_OD()            __set_PRIMASK(1);
     #define CO_UNLOCK_OD()          __set_PRIMASK(0);
 
+    /* receive runs in interrupt, keep PRIMASK of the interrupted code */
+    #define CO_LOCK_OD_RX()         { uint32_t CO_primaskRx = __get_PRIMASK(); __set_PRIMASK(1);
+    #define CO_UNLOCK_OD_RX()       __set_PRIMASK(CO_primaskRx); }
+
     
 #define CLOCK_CAN                   RCC_APB1Periph_CAN1
 
@@ -116,6 +120,52 @@
 #define CAN_TXMAILBOX_1   ((uint8_t)0x01)
 #define CAN_TXMAILBOX_2   ((uint8_t)0x02)
 
+/* Number of bxCAN filter banks used for hardware acceptance filters */
+#ifndef CO_CAN_NO_FILTER_BANKS
+#define CO_CAN_NO_FILTER_BANKS      14
+#endif
+
+/* Deferred reception. If defined, CO_CANinterrupt_Rx() only drains both rx
+ * FIFOs into a ring inside CO_CANmodule_t and signals the application with
+ * CO_CAN_RX_SIGNAL(). The rx buffer of a message is taken from the filter
+ * match index (FMI), if the hardware filter belongs to one rx buffer only.
+ * The map is rebuilt with the filters and verified in software on dispatch.
+ * Receive callbacks are called later by CO_CANrxRing_process(), which must be
+ * called from a high priority task. Ring size must be a power of two. */
+//#define CO_CAN_RX_RING
+#ifdef CO_CAN_RX_RING
+#ifndef CO_CAN_RX_RING_SIZE
+#define CO_CAN_RX_RING_SIZE         32
+#endif
+#ifndef CO_CAN_RX_SIGNAL
+#define CO_CAN_RX_SIGNAL(CANmodule)
+#endif
+#define CO_CAN_RX_INDEX_UNKNOWN     0xFFFF
+#endif
+
+/* Prioritized transmission. If defined, all three transmit mailboxes are kept
+ * filled. Messages waiting for a free mailbox are marked in a bitmap and the
+ * one with the lowest CAN identifier is sent first, so SDO or heartbeat
+ * messages can't delay SYNC or PDOs by more than the messages already in the
+ * mailboxes. Mailboxes are arbitrated by identifier (TXFP = 0). Number of
+ * transmit buffers is limited to CO_CAN_TX_PENDING_WORDS * 32. */
+//#define CO_CAN_TX_PRIORITY
+#ifdef CO_CAN_TX_PRIORITY
+#ifndef CO_CAN_TX_PENDING_WORDS
+#define CO_CAN_TX_PENDING_WORDS     2
+#endif
+#endif
+
+/* SYNC production from hardware timer, if CO_SYNC_HW_TIMER is defined for the
+ * whole project (see CO_SYNC.h). CO_SYNCtimer_init() configures a basic or
+ * general purpose timer for update interrupt every SYNC period, application
+ * must enable its clock and call CO_SYNCtimer_interrupt() from its interrupt
+ * handler (for example TIM6_IRQHandler). SYNC is copied by the interrupt into
+ * a free transmit mailbox, messages waiting for a mailbox are overtaken.
+ * CO_SYNCtimer_process() must be called cyclically, it restarts the timer,
+ * if SYNC producer (0x1005) or period (0x1006) is changed. Timer is 16 bit,
+ * period is rounded to the prescaled timer clock. */
+
 /* Timeout for initialization */
 
 #define INAK_TIMEOUT        ((uint32_t)0x0000FFFF)
@@ -179,6 +229,15 @@ typedef struct{
 }CO_CANtx_t;/* ALIGN_STRUCT_DWORD; */
 
 
+#ifdef CO_CAN_RX_RING
+/* Message inside rx ring, with index of rx buffer or CO_CAN_RX_INDEX_UNKNOWN */
+typedef struct{
+    CanRxMsg            msg;
+    uint16_t            index;
+}CO_CANrxRingEntry_t;
+#endif
+
+
 /* CAN module object. */
 typedef struct{
     CAN_TypeDef        *CANbaseAddress;         /* STM32F4xx specific */
@@ -194,8 +253,31 @@ typedef struct{
     volatile uint16_t   CANtxCount;
     uint32_t            errOld;
     void               *em;
+#ifdef CO_CAN_RX_RING
+    CO_CANrxRingEntry_t rxRing[CO_CAN_RX_RING_SIZE];
+    volatile uint16_t   rxRingHead;             /* written only by CO_CANinterrupt_Rx() */
+    volatile uint16_t   rxRingTail;             /* written only by CO_CANrxRing_process() */
+    volatile uint16_t   rxRingOverflow;         /* messages dropped, ring full */
+    uint16_t            rxRingOverflowOld;
+    uint16_t            rxFilterIndex[CO_CAN_NO_FILTER_BANKS * 2]; /* FMI to rx buffer index */
+#endif
+#ifdef CO_CAN_TX_PRIORITY
+    volatile uint32_t   txPending[CO_CAN_TX_PENDING_WORDS]; /* bit per txArray buffer waiting for mailbox */
+    volatile uint8_t    txMailboxSync;          /* bit per mailbox holding synchronous TPDO */
+#endif
 }CO_CANmodule_t;
 
+#ifdef CO_SYNC_HW_TIMER
+/* Hardware timer for SYNC production */
+typedef struct
+{
+    TIM_TypeDef        *TIMx;       /* from CO_SYNCtimer_init() */
+    uint32_t            clock_Hz;   /* timer input clock, from CO_SYNCtimer_init() */
+    void               *SYNC;       /* CO_SYNC_t object, from CO_SYNCtimer_init() */
+    uint32_t            period_us;  /* period of running timer or 0 if stopped */
+}CO_SYNCtimer_t;
+#endif
+
 /* Init CAN Led Interface */
 typedef enum {
     eCoLed_None = 0,
@@ -272,5 +354,30 @@ void CO_CANinterrupt_Rx(CO_CANmodule_t *CANmodule);
 void CO_CANinterrupt_Tx(CO_CANmodule_t *CANmodule);
 void CO_CANinterrupt_Status(CO_CANmodule_t *CANmodule);
 
+#ifdef CO_CAN_RX_RING
+/* Call receive callbacks for all messages in rx ring. */
+void CO_CANrxRing_process(CO_CANmodule_t *CANmodule);
+#endif
+
+#ifdef CO_SYNC_HW_TIMER
+/* Send CAN message from interrupt into a free mailbox, see drvTemplate. */
+CO_ReturnError_t CO_CANsendFromISR(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer);
+
+/* Configure timer and its interrupt, enable timer driven SYNC production.
+ * Must be called after each CO_init(). */
+void CO_SYNCtimer_init(
+        CO_SYNCtimer_t         *SYNCtimer,
+        TIM_TypeDef            *TIMx,
+        uint8_t                 IRQChannel,
+        uint32_t                clock_Hz,
+        void                   *SYNC);
+
+/* Start, stop or reload timer, if SYNC producer or period changed. */
+void CO_SYNCtimer_process(CO_SYNCtimer_t *SYNCtimer);
+
+/* Timer interrupt transmits SYNC. Returns true, if SYNC was transmitted. */
+bool_t CO_SYNCtimer_interrupt(CO_SYNCtimer_t *SYNCtimer);
+#endif
+
 
 #endif
@@ -48,8 +48,12 @@
 //                                INCLUDES
 //============================================================================
 #include "CANopen.h"
+#include "CO_flashLog.h"
+#include "CO_Flash.h"
 #include "stm32f30x.h"
 
+#include <string.h>
+
 //============================================================================
 //                                DEFINES
 //============================================================================
@@ -61,8 +65,13 @@
 #define LAST_PAGE_ADDRESS           0x0800F800
 #define PAGES_PER_FLASH_AREA        1
 #define FLASH_PAGE_SIZE             0x800
+#define FLASH_AREAS_PER_LOG         2
 #define CO_OD_FLASH_PARAM_DEFAULT   LAST_PAGE_ADDRESS - (1*PAGES_PER_FLASH_AREA*FLASH_PAGE_SIZE)
-#define CO_OD_FLASH_PARAM_RUNTIME   LAST_PAGE_ADDRESS - (2*PAGES_PER_FLASH_AREA*FLASH_PAGE_SIZE)
+/* Runtime parameters are stored in a flash log, see CO_flashLog.h */
+#define CO_OD_FLASH_PARAM_RUNTIME   LAST_PAGE_ADDRESS - ((1+FLASH_AREAS_PER_LOG)*PAGES_PER_FLASH_AREA*FLASH_PAGE_SIZE)
+/* Runtime parameters of firmware before the flash log, taken over once by
+   CO_FlashInit(). Same area as the second page of the log. */
+#define CO_OD_FLASH_PARAM_LEGACY    LAST_PAGE_ADDRESS - (2*PAGES_PER_FLASH_AREA*FLASH_PAGE_SIZE)
 
 #define CO_UNUSED(v)  (void)(v)
 
@@ -71,6 +80,23 @@
 //============================================================================
 extern struct sCO_OD_ROM CO_OD_ROM;
 
+static CO_flashLog_t CO_OD_flashLog;
+static uint8_t CO_OD_flashLogImage[sizeof(struct sCO_OD_ROM)];
+static bool_t CO_OD_flashLogReady = false;
+
+/* Snapshot of the flash log (page header, record header and data) must fit
+   into one page, see CO_flashLog_init() */
+typedef char CO_OD_flashLogFitsPage[
+    ((sizeof(struct sCO_OD_ROM) + 16U) <= (PAGES_PER_FLASH_AREA*FLASH_PAGE_SIZE)) ? 1 : -1];
+
+/* End of the application image in flash, from the linker script: load
+   address and size of the initialized data follow the code. The flash log
+   takes one page more than the runtime parameters before, so the image must
+   end below CO_OD_FLASH_PARAM_RUNTIME. */
+extern uint32_t _sidata;
+extern uint32_t _sdata;
+extern uint32_t _edata;
+
 enum CO_OD_H1010_StoreParam_Sub
 {
     OD_H1010_STORE_PARAM_COUNT,
@@ -175,6 +201,100 @@ static CO_SDO_abortCode_t restoreParameters(uint32_t FlashAddress, uint8_t Param
     return CO_SDO_AB_NONE;
 }
 
+//============================================================================
+/**
+* Flash log callbacks, see CO_flashLog_init().
+*/
+static CO_ReturnError_t flashLogErase(void *object, uint32_t address, uint32_t size)
+{
+    uint32_t addressPtr;
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    CO_UNUSED(object);
+
+    FLASH_Unlock();
+    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPERR);
+    for (addressPtr = address; addressPtr < (address + size); addressPtr += FLASH_PAGE_SIZE) {
+        if (FLASH_ErasePage(addressPtr) != FLASH_COMPLETE) {
+            ret = CO_ERROR_DATA_CORRUPT;
+            break;
+        }
+    }
+    FLASH_Lock();
+
+    return ret;
+}
+
+static CO_ReturnError_t flashLogProgram(void *object, uint32_t address, const void *data, uint32_t size)
+{
+    const uint8_t* p_data = (const uint8_t *) data;
+    uint32_t addressPtr;
+    uint32_t word;
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    CO_UNUSED(object);
+
+    FLASH_Unlock();
+    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPERR);
+    for (addressPtr = address; addressPtr < (address + size); addressPtr += 4) {
+        /* Record data are not word aligned in RAM */
+        memcpy(&word, p_data, sizeof(word));
+        if (FLASH_ProgramWord(addressPtr, word) != FLASH_COMPLETE) {
+            ret = CO_ERROR_DATA_CORRUPT;
+            break;
+        }
+        p_data += 4;
+    }
+    FLASH_Lock();
+
+    return ret;
+}
+
+static CO_ReturnError_t flashLogRead(void *object, uint32_t address, void *data, uint32_t size)
+{
+    CO_UNUSED(object);
+
+    flash_read(address, data, size);
+
+    return CO_ERROR_NO;
+}
+
+//============================================================================
+/**
+* Copy runtime parameters stored by firmware before the flash log into the
+* object dictionary. Returns false, if there are no valid parameters.
+*/
+static bool_t loadLegacyParameters(void)
+{
+    struct sCO_OD_ROM LegacyObjDicParam;
+
+    flash_read(CO_OD_FLASH_PARAM_LEGACY, &LegacyObjDicParam, sizeof(LegacyObjDicParam));
+    if ((LegacyObjDicParam.FirstWord != CO_OD_FIRST_LAST_WORD) ||
+    (LegacyObjDicParam.LastWord  != CO_OD_FIRST_LAST_WORD)) {
+        return false;
+    }
+    memcpy(&CO_OD_ROM, &LegacyObjDicParam, sizeof(CO_OD_ROM));
+
+    return true;
+}
+
+//============================================================================
+/**
+* Store parameters of object dictionary into the runtime flash log. Only
+* changed data are appended, the page is not erased.
+*/
+static CO_SDO_abortCode_t storeRuntimeParameters(void)
+{
+    if (!CO_OD_flashLogReady) {
+        return CO_SDO_AB_HW;
+    }
+    if (CO_flashLog_store(&CO_OD_flashLog, &CO_OD_ROM) != CO_ERROR_NO) {
+        return CO_SDO_AB_HW;
+    }
+
+    return CO_SDO_AB_NONE;
+}
+
 //============================================================================
 /**
 * Access to object dictionary OD_H1010_STORE_PARAM_FUNC
@@ -199,7 +319,7 @@ static CO_SDO_abortCode_t CO_ODF_1010_StoreParam(CO_ODF_arg_t *ODF_arg)
         return CO_SDO_AB_DATA_TRANSF;
     }
 
-    return storeParameters(CO_OD_FLASH_PARAM_RUNTIME, ODF_arg->subIndex);
+    return storeRuntimeParameters();
 }
 
 //============================================================================
@@ -231,7 +351,7 @@ static CO_SDO_abortCode_t CO_ODF_1011_RestoreParam(CO_ODF_arg_t *ODF_arg)
         return Result;
     }
 
-    return storeParameters(CO_OD_FLASH_PARAM_RUNTIME, OD_H1011_RESTORE_PARAM_ALL);
+    return storeRuntimeParameters();
 }
 
 //===========================================================================
@@ -250,18 +370,46 @@ void CO_FlashInit(void)
     members. */
 
     struct sCO_OD_ROM DefaultObjDicParam;
+    uint32_t imageEnd;
+
+    /* Never erase pages of the application. Parameters stay as compiled. */
+    imageEnd = (uint32_t)&_sidata + ((uint32_t)&_edata - (uint32_t)&_sdata);
+    if (imageEnd > CO_OD_FLASH_PARAM_RUNTIME) {
+        return;
+    }
+
     flash_read(CO_OD_FLASH_PARAM_DEFAULT, &DefaultObjDicParam, sizeof(DefaultObjDicParam));
 
+    CO_OD_flashLogReady = (CO_flashLog_init(&CO_OD_flashLog, CO_OD_FLASH_PARAM_RUNTIME,
+                     PAGES_PER_FLASH_AREA*FLASH_PAGE_SIZE, FLASH_AREAS_PER_LOG,
+                     CO_OD_flashLogImage, sizeof(CO_OD_flashLogImage), (void*)0,
+                     flashLogErase, flashLogProgram, flashLogRead) == CO_ERROR_NO);
+
     /* If the default parameters are not present in flash, then we know that
     we need to create them for later restore. */
 
     if ((DefaultObjDicParam.FirstWord != CO_OD_FIRST_LAST_WORD) ||
     (DefaultObjDicParam.LastWord  != CO_OD_FIRST_LAST_WORD)) {
-        storeParameters(CO_OD_FLASH_PARAM_RUNTIME, OD_H1010_STORE_PARAM_ALL);
+        storeRuntimeParameters();
         storeParameters(CO_OD_FLASH_PARAM_DEFAULT, OD_H1010_STORE_PARAM_ALL);
     }
-    else {
-        restoreParameters(CO_OD_FLASH_PARAM_RUNTIME, OD_H1010_STORE_PARAM_ALL);
+    else if (CO_flashLog_load(&CO_OD_flashLog, &CO_OD_ROM) != CO_ERROR_NO) {
+        /* No runtime parameters in the log yet. Take them over from the
+        previous firmware or start the log with the defaults. The first
+        snapshot goes to the first page of the log, so the legacy area is
+        erased only after that succeeded. */
+        if (!loadLegacyParameters()) {
+            restoreParameters(CO_OD_FLASH_PARAM_DEFAULT, OD_H1010_STORE_PARAM_ALL);
+        }
+        storeRuntimeParameters();
+    }
+}
+
+//===========================================================================
+void CO_FlashProcess(void)
+{
+    if (CO_OD_flashLogReady) {
+        CO_flashLog_process(&CO_OD_flashLog);
     }
 }
 
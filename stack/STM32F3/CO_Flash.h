@@ -58,9 +58,25 @@
  * default data that will be restored. The default parameters are stored
  * at address CO_OD_Flash_Default_Param. The data that will be loaded at
  * startup or saved if user modifies data.
+ *
+ * Runtime parameters are kept in a flash log of two pages below the default
+ * parameters, 0x0800E000 to 0x0800EFFF. This is one page more than before,
+ * the application image must end below it. Otherwise flash is not used and
+ * parameters keep the compiled values. Linker script should check this, for
+ * example: ASSERT(_sidata + SIZEOF(.data) <= 0x0800E000, "CO_Flash")
+ * Runtime parameters of the previous firmware are taken over on the first
+ * start.
  */
 void CO_FlashInit(void);
 
+/**
+ * Process flash storage in background. Runtime parameters are appended to
+ * a flash log, this function erases the next log page in advance. It may
+ * block for the duration of a page erase, so call it cyclically from the
+ * mainline of the program.
+ */
+void CO_FlashProcess(void);
+
 /**
  * Register object dictionary functions for parameter storage and restoring
  * parameters (Object dictionary index 0x1010 Store Param and 0x1011 Restore
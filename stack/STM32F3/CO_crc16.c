@@ -0,0 +1,87 @@
+/*
+ * CRC16 CCITT calculation with the STM32F3 hardware CRC unit.
+ *
+ * @file        CO_crc16.c
+ * @ingroup     CO_crc16_ccitt
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+#include "stm32f30x.h"
+#include "crc16-ccitt.h"
+
+/* File replaces stack/crc16-ccitt.c, if CO_USE_OWN_CRC16 is defined in the
+ * project. CRC unit is configured for 16 bit polynomial 0x1021 without bit
+ * reversal, which equals the table driven implementation. CRC unit must not be
+ * used by other modules concurrently. */
+#ifdef CO_USE_OWN_CRC16
+
+/******************************************************************************/
+unsigned short crc16_ccitt(
+        const unsigned char     block[],
+        unsigned int            blockLength,
+        unsigned short          crc)
+{
+    static uint8_t initialized = 0;
+    unsigned int i = 0U;
+
+    if(!initialized){
+        RCC_AHBPeriphClockCmd(RCC_AHBPeriph_CRC, ENABLE);
+        CRC_PolynomialSizeSelect(CRC_PolSize_16);
+        CRC_SetPolynomial(0x1021U);
+        CRC_ReverseInputDataSelect(CRC_ReverseInputData_No);
+        CRC_ReverseOutputDataCmd(DISABLE);
+        initialized = 1;
+    }
+
+    CRC_SetInitRegister(crc);
+    CRC_ResetDR();
+
+    /* Word is processed MSB first, so four bytes can be fed at once */
+    for(; (blockLength - i) >= 4U; i+=4U){
+        (void)CRC_CalcCRC(((uint32_t)block[i] << 24) | ((uint32_t)block[i+1U] << 16) |
+                          ((uint32_t)block[i+2U] << 8) | (uint32_t)block[i+3U]);
+    }
+    for(; i<blockLength; i++){
+        (void)CRC_CalcCRC8bits(block[i]);
+    }
+
+    return (unsigned short)CRC_GetCRC();
+}
+
+#endif /* CO_USE_OWN_CRC16 */
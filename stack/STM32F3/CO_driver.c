@@ -50,6 +50,9 @@
 #include "stm32f30x.h"
 #include "CO_driver.h"
 #include "CO_Emergency.h"
+#include "CO_CANfilter.h"
+#include "CO_tracepoint.h"
+#include "CO_statistics.h"
 #include <string.h>
 
 /* Private macro -------------------------------------------------------------*/
@@ -70,8 +73,65 @@ void CO_CANsetConfigurationMode(CAN_TypeDef* CANbaseAddress){
 }
 
 
+/******************************************************************************/
+/* Convert identifier or mask from rxArray alignment (ID << 2 | RTR << 1) into
+ * 16-bit bxCAN filter alignment (ID << 5 | RTR << 4 | IDE << 3) */
+static uint16_t CO_CANfilterTo16bit(uint32_t value){
+    return (uint16_t)((((value >> 2) & 0x07FF) << 5) | ((value & 0x02) ? 0x10 : 0));
+}
+
+/* Program hardware acceptance filters from rxArray. Messages are still checked
+ * by software inside CO_CANinterrupt_Rx(), so merged filters may let some more
+ * messages pass. */
+static void CO_CANsetFilters(CO_CANmodule_t *CANmodule){
+    CAN_FilterInitTypeDef CAN_FilterInitStruct;
+    CO_CANfilter_t filters[CO_CAN_NO_FILTER_BANKS * 2 + 1];
+    uint16_t count = 0;
+    uint16_t i;
+
+    /* add filters one by one, merge as soon as there are too many */
+    for (i = 0; i < CANmodule->rxSize; i++) {
+        CO_CANrx_t *rxBuffer = &CANmodule->rxArray[i];
+
+        if (rxBuffer->pFunct != 0) {
+            filters[count].ident = CO_CANfilterTo16bit(rxBuffer->ident);
+            /* IDE bit must match, only standard frames are used */
+            filters[count].mask = CO_CANfilterTo16bit(rxBuffer->mask) | 0x08;
+            count = CO_CANfilter_merge(filters, count + 1, CO_CAN_NO_FILTER_BANKS * 2);
+        }
+    }
+    if (count == 0) {
+        /* nothing configured, keep accept all filter */
+        return;
+    }
+
+    memset(&CAN_FilterInitStruct, 0, sizeof (CAN_FilterInitStruct));
+    CAN_FilterInitStruct.CAN_FilterFIFOAssignment = 0; // pouzivame jen FIFO0
+    CAN_FilterInitStruct.CAN_FilterMode = CAN_FilterMode_IdMask;
+    CAN_FilterInitStruct.CAN_FilterScale = CAN_FilterScale_16bit;
+    for (i = 0; i < CO_CAN_NO_FILTER_BANKS; i++) {
+        uint16_t first = i * 2;
+        uint16_t second = (first + 1 < count) ? (first + 1) : first;
+
+        CAN_FilterInitStruct.CAN_FilterNumber = i;
+        if (first < count) {
+            /* two filters per bank, an odd one is used twice */
+            CAN_FilterInitStruct.CAN_FilterIdLow = filters[first].ident;
+            CAN_FilterInitStruct.CAN_FilterMaskIdLow = filters[first].mask;
+            CAN_FilterInitStruct.CAN_FilterIdHigh = filters[second].ident;
+            CAN_FilterInitStruct.CAN_FilterMaskIdHigh = filters[second].mask;
+            CAN_FilterInitStruct.CAN_FilterActivation = ENABLE;
+        } else {
+            CAN_FilterInitStruct.CAN_FilterActivation = DISABLE;
+        }
+        CAN_FilterInit(&CAN_FilterInitStruct);
+    }
+}
+
+
 /******************************************************************************/
 void CO_CANsetNormalMode(CO_CANmodule_t *CANmodule){
+    CO_CANsetFilters(CANmodule);
     CANmodule->CANnormal = true;
 }
 
@@ -233,6 +293,12 @@ CO_ReturnError_t CO_CANrxBufferInit(
         rxBuffer->mask = RXM;
     }
 
+    /* filters are programmed in CO_CANsetNormalMode(), later changes (PDO
+     * COB-ID, heartbeat consumer, SDO client) must reprogram them */
+    if (CANmodule->CANnormal) {
+        CO_CANsetFilters(CANmodule);
+    }
+
     return CO_ERROR_NO;
 }
 
@@ -280,7 +346,6 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
             CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, 0);
         err = CO_ERROR_TX_OVERFLOW;
     }
-
     CO_LOCK_CAN_SEND();
     
     /* First try to transmit the message immediately if mailbox is free.
@@ -392,6 +457,7 @@ void CO_CANinterrupt_Rx(CO_CANmodule_t *CANmodule)
     CO_CANrx_t *msgBuff = CANmodule->rxArray;
 
 	CAN_Receive(CANmodule->CANbaseAddress, CAN_FilterFIFO0, &CAN1_RxMsg);
+    CO_STAT_BUS(CANmodule, CAN1_RxMsg.DLC);
     
     for (index = 0; index < CANmodule->rxSize; index++) {
         uint16_t msg = (CAN1_RxMsg.StdId << 2) | (CAN1_RxMsg.RTR ? 2 : 0);
@@ -405,7 +471,10 @@ void CO_CANinterrupt_Rx(CO_CANmodule_t *CANmodule)
     
     /* Call specific function, which will process the message */
     if (msgMatched && msgBuff->pFunct) {
+        CO_TP_BEGIN(CO_TP_RX_CALLBACK, msgBuff - CANmodule->rxArray);
+        CO_STAT_RX(CANmodule, msgBuff - CANmodule->rxArray);
         msgBuff->pFunct(msgBuff->object, (CO_CANrxMsg_t*) &CAN1_RxMsg);
+        CO_TP_END(CO_TP_RX_CALLBACK, msgBuff - CANmodule->rxArray);
     }
 }
 
@@ -480,6 +549,8 @@ static uint8_t CO_CANsendToModule(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
                     
     /* Request transmission */
     txMbox->TIR |= 1;
+    CO_STAT_TX(CANmodule, buffer - CANmodule->txArray);
+    CO_STAT_BUS(CANmodule, buffer->DLC);
     
     return 0;
 }
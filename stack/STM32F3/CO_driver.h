@@ -80,6 +80,10 @@
 #define CO_LOCK_OD()                __set_PRIMASK(1);
 #define CO_UNLOCK_OD()              __set_PRIMASK(0);
 
+/* receive runs in interrupt, keep PRIMASK of the interrupted code */
+#define CO_LOCK_OD_RX()             { uint32_t CO_primaskRx = __get_PRIMASK(); __set_PRIMASK(1);
+#define CO_UNLOCK_OD_RX()           __set_PRIMASK(CO_primaskRx); }
+
 #define CLOCK_CAN                   RCC_APB1Periph_CAN1
 
 #define CAN_REMAP_1                 /* Select CAN1 remap 1 */
@@ -109,6 +113,11 @@
 
 #define CO_CAN_TXMAILBOX   ((uint8_t)0x00)
 
+/* Number of bxCAN filter banks used for hardware acceptance filters */
+#ifndef CO_CAN_NO_FILTER_BANKS
+#define CO_CAN_NO_FILTER_BANKS      14
+#endif
+
 /* Timeout for initialization */
 
 #define INAK_TIMEOUT        ((uint32_t)0x0000FFFF)
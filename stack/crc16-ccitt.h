@@ -62,9 +62,26 @@ extern "C" {
  * Equation:
  *
  * `x^16 + x^12 + x^5 + 1`
+ *
+ * Function is used by SDO server and SDO client for block transfer. If
+ * CO_USE_OWN_CRC16 is defined, function is not compiled here, but provided by
+ * the target, for example with a hardware CRC unit (see STM32F3/CO_crc16.c) or
+ * a BSP function (see neuberger-FreeRTOS/crc.c).
  */
 
 
+/**
+ * Number of bytes processed per step in the table driven calculation.
+ *
+ * 1 uses one table with 256 entries (512 bytes). 4 (slice-by-4) and 8
+ * (slice-by-8) use 4 or 8 tables (2 or 4 KiB of flash) and are faster on
+ * processors with data cache, for example on Linux.
+ */
+#ifndef CO_CRC16_SLICING
+#define CO_CRC16_SLICING        1
+#endif
+
+
 /**
  * Calculate CRC sum on block of data.
  *
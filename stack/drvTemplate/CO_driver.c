@@ -48,6 +48,8 @@
 
 #include "CO_driver.h"
 #include "CO_Emergency.h"
+#include "CO_tracepoint.h"
+#include "CO_statistics.h"
 
 
 /******************************************************************************/
@@ -226,6 +228,8 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
         }
         err = CO_ERROR_TX_OVERFLOW;
     }
+    CO_STAT_TX(CANmodule, buffer - CANmodule->txArray);
+    CO_STAT_BUS(CANmodule, buffer->DLC);
 
     CO_LOCK_CAN_SEND();
     /* if CAN TX buffer is free, copy message to it */
@@ -262,6 +266,16 @@ CO_ReturnError_t CO_CANCheckSend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
 }
 
 
+/******************************************************************************/
+CO_ReturnError_t CO_CANsendFromISR(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
+    /* Copy message directly into a free (or dedicated) transmit buffer of the
+     * CAN module and request transmission, messages waiting in CANmodule are
+     * overtaken. If there is no free transmit buffer, queue the message as
+     * CO_CANsend() does. Microcontroller specific. */
+    return CO_CANsend(CANmodule, buffer);
+}
+
+
 /******************************************************************************/
 void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule){
     uint32_t tpdoDeleted = 0U;
@@ -370,6 +384,7 @@ void CO_CANinterrupt(CO_CANmodule_t *CANmodule){
 
         rcvMsg = 0; /* get message from module here */
         rcvMsgIdent = rcvMsg->ident;
+        CO_STAT_BUS(CANmodule, rcvMsg->DLC);
         if(CANmodule->useCANrxFilters){
             /* CAN module filters are used. Message with known 11-bit identifier has */
             /* been received */
@@ -397,7 +412,10 @@ void CO_CANinterrupt(CO_CANmodule_t *CANmodule){
 
         /* Call specific function, which will process the message */
         if(msgMatched && (buffer != NULL) && (buffer->pFunct != NULL)){
+            CO_TP_BEGIN(CO_TP_RX_CALLBACK, buffer - CANmodule->rxArray);
+            CO_STAT_RX(CANmodule, buffer - CANmodule->rxArray);
             buffer->pFunct(buffer->object, rcvMsg);
+            CO_TP_END(CO_TP_RX_CALLBACK, buffer - CANmodule->rxArray);
         }
 
         /* Clear interrupt flag */
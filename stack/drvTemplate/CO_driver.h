@@ -168,6 +168,13 @@ extern "C" {
  * After presence of SYNC message on CANopen bus, CANrx should be temporary
  * disabled until all receive PDOs are processed. See also CO_SYNC.h file and
  * CO_SYNC_initCallback() function.
+ *
+ * Options, which access Object Dictionary directly in the receive function
+ * (#CO_SDO_FAST_EXPEDITED, #CO_PDO_MPDO, #CO_RPDO_IMMEDIATE,
+ * #CO_TPDO_PRESTAGE), use CO_LOCK_OD_RX(). Driver defines it only, if the
+ * lock is usable there: CO_LOCK_OD(), if receive runs in a thread, or a
+ * variant, which saves and restores the interrupt state, if receive runs in
+ * an interrupt. Otherwise these options can't be used with the driver.
  * @{
  */
     #define CO_LOCK_CAN_SEND()  /**< Lock critical section in CO_CANsend() */
@@ -178,6 +185,9 @@ extern "C" {
 
     #define CO_LOCK_OD()        /**< Lock critical section when accessing Object Dictionary */
     #define CO_UNLOCK_OD()      /**< Unock critical section when accessing Object Dictionary */
+
+    #define CO_LOCK_OD_RX()     /**< Lock Object Dictionary from the CAN receive function */
+    #define CO_UNLOCK_OD_RX()   /**< Unlock Object Dictionary from the CAN receive function */
 /** @} */
 
 /**
@@ -470,6 +480,23 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer);
 CO_ReturnError_t CO_CANCheckSend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer);
 
 
+/**
+ * Send CAN message from interrupt, bypassing messages waiting for transmission.
+ *
+ * Function is needed only with #CO_SYNC_HW_TIMER. It is called by
+ * CO_SYNC_timerIsr() from the hardware timer interrupt. Message should be
+ * copied into a free or dedicated transmit buffer of the CAN module
+ * immediately, also if other messages are waiting in CANmodule. Function must
+ * be safe against CO_CANsend() and the CAN interrupt.
+ *
+ * @param CANmodule This object.
+ * @param buffer Pointer to transmit buffer, returned by CO_CANtxBufferInit().
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_TX_OVERFLOW.
+ */
+CO_ReturnError_t CO_CANsendFromISR(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer);
+
+
 /**
  * Clear all synchronous TPDOs from CAN module transmit buffers.
  *
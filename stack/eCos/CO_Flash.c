@@ -50,6 +50,10 @@
 #include <cyg/infra/diag.h>
 
 #include "CANopen.h"
+#include "CO_flashLog.h"
+#include "CO_Flash.h"
+
+#include <string.h>
 
 
 //============================================================================
@@ -67,9 +71,16 @@
 //============================================================================
 static cyg_flash_info_t flash_info;
 static const int CYGNUM_CANOPEN_FLASH_DATA_BLOCK = -3;
+static const int CYGNUM_CANOPEN_FLASH_LOG_BLOCKS = 2;
 static cyg_flashaddr_t CO_OD_Flash_Adress;
 static cyg_flashaddr_t CO_OD_Flash_Default_Param;
+// runtime parameters of firmware before the flash log, taken over once by
+// CO_FlashInit(); same block as the second block of the log
+static cyg_flashaddr_t CO_OD_Flash_Legacy_Param;
 extern struct sCO_OD_ROM CO_OD_ROM;
+// runtime parameters are stored in a flash log at CO_OD_Flash_Adress
+static CO_flashLog_t CO_OD_flashLog;
+static uint8_t CO_OD_flashLogImage[sizeof(struct sCO_OD_ROM)];
 
 
 enum CO_OD_H1010_StoreParam_Sub
@@ -175,6 +186,93 @@ static CO_SDO_abortCode_t restoreParameters(cyg_flashaddr_t FlashAddress,
 }
 
 
+//============================================================================
+/**
+ * Flash log callbacks, see CO_flashLog_init().
+ */
+static CO_ReturnError_t flashLogErase(void *object, uint32_t address,
+	uint32_t size)
+{
+	(void)object;
+	cyg_flashaddr_t ErrorAddress;
+	int Result = cyg_flash_erase((cyg_flashaddr_t)address, size, &ErrorAddress);
+	CHECK_FLASH_RESULT(Result);
+	if (CYG_FLASH_ERR_OK != Result)
+	{
+		return CO_ERROR_DATA_CORRUPT;
+	}
+	return CO_ERROR_NO;
+}
+
+static CO_ReturnError_t flashLogProgram(void *object, uint32_t address,
+	const void *data, uint32_t size)
+{
+	(void)object;
+	cyg_flashaddr_t ErrorAddress;
+	int Result = cyg_flash_program((cyg_flashaddr_t)address, data, size, &ErrorAddress);
+	CHECK_FLASH_RESULT(Result);
+	if (CYG_FLASH_ERR_OK != Result)
+	{
+		return CO_ERROR_DATA_CORRUPT;
+	}
+	return CO_ERROR_NO;
+}
+
+static CO_ReturnError_t flashLogRead(void *object, uint32_t address,
+	void *data, uint32_t size)
+{
+	(void)object;
+	cyg_flashaddr_t ErrorAddress;
+	int Result = cyg_flash_read((cyg_flashaddr_t)address, data, size, &ErrorAddress);
+	CHECK_FLASH_RESULT(Result);
+	if (CYG_FLASH_ERR_OK != Result)
+	{
+		return CO_ERROR_DATA_CORRUPT;
+	}
+	return CO_ERROR_NO;
+}
+
+
+//============================================================================
+/**
+ * Copy runtime parameters stored by firmware before the flash log into the
+ * object dictionary. Returns false, if there are no valid parameters.
+ */
+static bool_t loadLegacyParameters(void)
+{
+	struct sCO_OD_ROM LegacyObjDicParam;
+	cyg_flashaddr_t ErrorAddress;
+
+	int Result = cyg_flash_read(CO_OD_Flash_Legacy_Param, &LegacyObjDicParam,
+		sizeof(LegacyObjDicParam), &ErrorAddress);
+	if ((Result != CYG_FLASH_ERR_OK)
+	  ||(LegacyObjDicParam.FirstWord != CO_OD_FIRST_LAST_WORD)
+	  ||(LegacyObjDicParam.LastWord != CO_OD_FIRST_LAST_WORD))
+	{
+		return false;
+	}
+	CO_DBG_PRINT("Take over runtime parameters of previous firmware\n");
+	memcpy(&CO_OD_ROM, &LegacyObjDicParam, sizeof(CO_OD_ROM));
+	return true;
+}
+
+
+//============================================================================
+/**
+ * Store parameters of object dictionary into the runtime flash log. Only
+ * changed data are appended, the block is not erased.
+ */
+static CO_SDO_abortCode_t storeRuntimeParameters(void)
+{
+	CO_DBG_PRINT("Store runtime parameters\n");
+	if (CO_flashLog_store(&CO_OD_flashLog, &CO_OD_ROM) != CO_ERROR_NO)
+	{
+		return CO_SDO_AB_HW;
+	}
+	return CO_SDO_AB_NONE;
+}
+
+
 //============================================================================
 /**
  * Access to object dictionary OD_H1010_STORE_PARAM_FUNC
@@ -203,7 +301,7 @@ static CO_SDO_abortCode_t CO_ODF_1010_StoreParam(CO_ODF_arg_t *ODF_arg)
 		return CO_SDO_AB_DATA_TRANSF;
 	}
 
-    return storeParameters(CO_OD_Flash_Adress, ODF_arg->subIndex);
+	return storeRuntimeParameters();
 }
 
 //============================================================================
@@ -242,7 +340,7 @@ static CO_SDO_abortCode_t CO_ODF_1011_RestoreParam(CO_ODF_arg_t *ODF_arg)
 		return Result;
 	}
 
-	return storeParameters(CO_OD_Flash_Adress, OD_H1011_RESTORE_PARAM_ALL);
+	return storeRuntimeParameters();
 }
 
 
@@ -288,9 +386,12 @@ void CO_FlashInit(void)
 	CO_DBG_PRINT("Last block - block size: %d blocks: %d\n",
 		block_info->block_size, block_info->blocks);
 	CO_OD_Flash_Adress = flash_info.end + 1 +
-		(CYGNUM_CANOPEN_FLASH_DATA_BLOCK * block_info->block_size);
+		((CYGNUM_CANOPEN_FLASH_DATA_BLOCK - CYGNUM_CANOPEN_FLASH_LOG_BLOCKS + 1)
+		* block_info->block_size);
 	CO_DBG_PRINT("CO_OD_Flash_Adress 0x%8x\n", CO_OD_Flash_Adress);
 	CO_OD_Flash_Default_Param = CO_OD_Flash_Adress - block_info->block_size;
+	CO_OD_Flash_Legacy_Param = flash_info.end + 1 +
+		(CYGNUM_CANOPEN_FLASH_DATA_BLOCK * block_info->block_size);
 	CO_DBG_PRINT("CO_OD_Flash_Default_Param 0x%8x\n", CO_OD_Flash_Default_Param);
 
 	//
@@ -300,6 +401,16 @@ void CO_FlashInit(void)
 	// members
 	//
 	cyg_flashaddr_t ErrorAddress;
+#ifdef CYGHWR_IO_FLASH_BLOCK_LOCKING
+	Result = cyg_flash_unlock(CO_OD_Flash_Adress,
+		CYGNUM_CANOPEN_FLASH_LOG_BLOCKS * block_info->block_size, &ErrorAddress);
+	CHECK_FLASH_RESULT(Result);
+#endif
+	CO_flashLog_init(&CO_OD_flashLog, CO_OD_Flash_Adress,
+		block_info->block_size, CYGNUM_CANOPEN_FLASH_LOG_BLOCKS,
+		CO_OD_flashLogImage, sizeof(CO_OD_flashLogImage), (void*)0,
+		flashLogErase, flashLogProgram, flashLogRead);
+
 	struct sCO_OD_ROM DefaultObjDicParam;
 	Result = cyg_flash_read(CO_OD_Flash_Default_Param, &DefaultObjDicParam,
 		sizeof(DefaultObjDicParam), &ErrorAddress);
@@ -312,16 +423,34 @@ void CO_FlashInit(void)
 	if ((DefaultObjDicParam.FirstWord != CO_OD_FIRST_LAST_WORD)
 	  ||(DefaultObjDicParam.LastWord != CO_OD_FIRST_LAST_WORD))
 	{
-		storeParameters(CO_OD_Flash_Adress, OD_H1010_STORE_PARAM_ALL);
+		// Default parameters also moved one block down with the flash log,
+		// so they are missing after an update, too. Store the compiled
+		// defaults first, then take over the runtime parameters of the
+		// previous firmware, if any.
 		storeParameters(CO_OD_Flash_Default_Param, OD_H1010_STORE_PARAM_ALL);
+		loadLegacyParameters();
+		storeRuntimeParameters();
 	}
-	else
+	else if (CO_flashLog_load(&CO_OD_flashLog, &CO_OD_ROM) != CO_ERROR_NO)
 	{
-		restoreParameters(CO_OD_Flash_Adress, OD_H1010_STORE_PARAM_ALL);
+		// no runtime parameters in the log yet, take them over from the
+		// previous firmware or start the log with the defaults
+		if (!loadLegacyParameters())
+		{
+			restoreParameters(CO_OD_Flash_Default_Param, OD_H1010_STORE_PARAM_ALL);
+		}
+		storeRuntimeParameters();
 	}
 }
 
 
+//===========================================================================
+void CO_FlashProcess(void)
+{
+	CO_flashLog_process(&CO_OD_flashLog);
+}
+
+
 //===========================================================================
 void CO_FlashRegisterODFunctions(CO_t* CO)
 {
@@ -59,6 +59,14 @@
  */
 void CO_FlashInit(void);
 
+/**
+ * Process flash storage in background. Runtime parameters are appended to
+ * a flash log, this function erases the next log page in advance. It may
+ * block for the duration of a page erase, so call it cyclically from the
+ * mainline of the program.
+ */
+void CO_FlashProcess(void);
+
 /**
  * Register object dictionary functions for parameter storage and restoring
  * parameters (Object dictionary index 0x1010 Store Param and 0x1011 Restore
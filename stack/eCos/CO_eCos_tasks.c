@@ -0,0 +1,265 @@
+//===========================================================================
+/// \file    CO_eCos_tasks.c
+/// \brief   Implementation of event driven CANopen tasks for eCos.
+//===========================================================================
+
+
+//===========================================================================
+//                                  INCLUDES
+//===========================================================================
+#include <cyg/kernel/kapi.h>
+#include "CO_eCos_tasks.h"
+#include "CO_PollingTimer.h"
+#include "ecos_helper.h"
+
+
+//===========================================================================
+//                                DEFINES
+//===========================================================================
+#define CO_EVENT_MAIN       0x01 ///< flag bit, mainline task has work
+#define CO_EVENT_RT         0x02 ///< flag bit, realtime interval expired
+#define CO_MAIN_INTERVAL    50   ///< longest mainline sleep in milliseconds
+#define CO_RT_PRIORITY      3    ///< realtime thread, above can_rx_thread (4)
+
+
+//===========================================================================
+//                               DATA TYPES
+//===========================================================================
+/**
+ * Stores thread data of a single thread object
+ */
+typedef struct st_thread_data
+{
+    cyg_thread   obj;
+    long         stack[CYGNUM_HAL_STACK_SIZE_TYPICAL];
+    cyg_handle_t hdl;
+} thread_data_t;
+
+
+//===========================================================================
+//                             LOCAL DATA
+//===========================================================================
+/// Mainline task
+static struct
+{
+	cyg_flag_t   flag;       ///< CO_EVENT_MAIN, kept over communication reset
+	bool_t       flagInit;   ///< flag is initialized
+	cyg_uint64   tmr1msPrev; ///< time of previous CO_process() call
+	uint16_t     timerNext;  ///< sleep time from CO_process()
+} taskMain;
+
+/// Realtime task
+static struct
+{
+	cyg_flag_t        flag;           ///< CO_EVENT_RT
+	thread_data_t     thread;         ///< realtime thread, created once
+	cyg_handle_t      counter;        ///< real time clock counter
+	cyg_handle_t      alarmHdl;       ///< periodic alarm
+	cyg_alarm         alarmObj;       ///< periodic alarm object
+	cyg_uint32        intervalus;     ///< exact interval after rounding to ticks
+	volatile cyg_uint32 alarmCount;   ///< incremented by alarm
+	cyg_uint32        processedCount; ///< alarmCount at last processing
+	cyg_uint32        overruns;       ///< see CANrx_taskTmr_getOverruns()
+	void            (*pFunctApp)(void); ///< application code or 0
+	volatile bool_t   running;        ///< between init and close
+} taskRT;
+
+
+//===========================================================================
+void taskMain_init(void)
+{
+	uint16_t i;
+
+	if (!taskMain.flagInit)
+	{
+		cyg_flag_init(&taskMain.flag);
+		taskMain.flagInit = true;
+	}
+	taskMain.tmr1msPrev = CO_TmrGetMilliSec();
+	taskMain.timerNext = 0; // do not block the first time
+
+	// SDO requests and emergencies are processed immediately
+	for (i = 0; i < CO_NO_SDO_SERVER; i++)
+	{
+		CO_SDO_initCallback(CO->SDO[i], taskMain_cbSignal);
+	}
+	CO_EM_initCallback(CO->em, taskMain_cbSignal);
+}
+
+
+//===========================================================================
+void taskMain_close(void)
+{
+	uint16_t i;
+
+	for (i = 0; i < CO_NO_SDO_SERVER; i++)
+	{
+		CO_SDO_initCallback(CO->SDO[i], 0);
+	}
+	CO_EM_initCallback(CO->em, 0);
+}
+
+
+//===========================================================================
+uint16_t taskMain_process(CO_NMT_reset_cmd_t *reset)
+{
+	cyg_uint64 timer1ms;
+	uint16_t timer1msDiff;
+
+	if (taskMain.timerNext > 0)
+	{
+		// Wait for signal or deadline. One tick more, because the current
+		// tick is already partly over.
+		cyg_flag_timed_wait(&taskMain.flag, CO_EVENT_MAIN,
+			CYG_FLAG_WAITMODE_OR | CYG_FLAG_WAITMODE_CLR,
+			cyg_current_time() + convertMsToTicks(taskMain.timerNext) + 1);
+	}
+	else
+	{
+		// consume pending signal, it is handled by this call
+		cyg_flag_poll(&taskMain.flag, CO_EVENT_MAIN,
+			CYG_FLAG_WAITMODE_OR | CYG_FLAG_WAITMODE_CLR);
+	}
+
+	// absolute time base, rounding of ticks does not accumulate
+	timer1ms = CO_TmrGetMilliSec();
+	timer1msDiff = (uint16_t)(timer1ms - taskMain.tmr1msPrev);
+	taskMain.tmr1msPrev = timer1ms;
+
+	taskMain.timerNext = CO_MAIN_INTERVAL;
+	*reset = CO_process(CO, timer1msDiff, &taskMain.timerNext);
+
+	return timer1msDiff;
+}
+
+
+//===========================================================================
+void taskMain_cbSignal(void)
+{
+	cyg_flag_setbits(&taskMain.flag, CO_EVENT_MAIN);
+}
+
+
+//===========================================================================
+/**
+ * Periodic alarm, runs in DSR context
+ */
+static void taskRT_alarm(cyg_handle_t alarm, cyg_addrword_t data)
+{
+	taskRT.alarmCount++;
+	cyg_flag_setbits(&taskRT.flag, CO_EVENT_RT);
+}
+
+
+//===========================================================================
+/**
+ * Realtime thread, processes SYNC, RPDOs, application and TPDOs once per
+ * alarm interval
+ */
+static void taskRT_thread(cyg_addrword_t data)
+{
+	while (1)
+	{
+		cyg_uint32 intervals;
+
+		cyg_flag_wait(&taskRT.flag, CO_EVENT_RT,
+			CYG_FLAG_WAITMODE_OR | CYG_FLAG_WAITMODE_CLR);
+
+		// alarm DSR does not run while scheduler is locked
+		cyg_scheduler_lock();
+		intervals = taskRT.alarmCount - taskRT.processedCount;
+		taskRT.processedCount = taskRT.alarmCount;
+		cyg_scheduler_unlock();
+
+		if (!taskRT.running || (intervals == 0))
+		{
+			continue;
+		}
+		taskRT.overruns += intervals - 1;
+
+		CO_LOCK_OD();
+		if (CO->CANmodule[0]->CANnormal)
+		{
+			bool_t syncWas;
+			cyg_uint32 timeDifference_us = intervals * taskRT.intervalus;
+
+			// Process Sync and read inputs
+			syncWas = CO_process_SYNC_RPDO(CO, timeDifference_us);
+
+			// Further I/O or nonblocking application code
+			if (taskRT.pFunctApp)
+			{
+				taskRT.pFunctApp();
+			}
+
+			// Write outputs
+			CO_process_TPDO(CO, syncWas, timeDifference_us);
+		}
+		CO_UNLOCK_OD();
+	}
+}
+
+
+//===========================================================================
+void CANrx_taskTmr_init(cyg_uint32 interval_us, void (*pFunctApp)(void))
+{
+	cyg_resolution_t res;
+	cyg_tick_count ticks;
+
+	if (!taskRT.thread.hdl)
+	{
+		cyg_flag_init(&taskRT.flag);
+		cyg_clock_to_counter(cyg_real_time_clock(), &taskRT.counter);
+		cyg_alarm_create(taskRT.counter, taskRT_alarm, 0,
+			&taskRT.alarmHdl, &taskRT.alarmObj);
+		cyg_thread_create(CO_RT_PRIORITY, taskRT_thread, 0,
+			"CANrx_taskTmr",
+			(void *) taskRT.thread.stack,
+			sizeof(taskRT.thread.stack),
+			&taskRT.thread.hdl,
+			&taskRT.thread.obj);
+		cyg_thread_resume(taskRT.thread.hdl);
+	}
+
+	// Round interval to ticks of real time clock. Resolution is
+	// dividend / divisor nanoseconds per tick.
+	res = cyg_clock_get_resolution(cyg_real_time_clock());
+	ticks = ((cyg_uint64)interval_us * 1000 * res.divisor + res.dividend / 2)
+		/ res.dividend;
+	if (ticks == 0)
+	{
+		ticks = 1;
+	}
+
+	cyg_scheduler_lock();
+	taskRT.intervalus = (cyg_uint32)((ticks * res.dividend / res.divisor) / 1000);
+	taskRT.pFunctApp = pFunctApp;
+	taskRT.processedCount = taskRT.alarmCount;
+	taskRT.overruns = 0;
+	taskRT.running = true;
+	cyg_scheduler_unlock();
+
+	// periodic alarm, next expiration is derived from the previous one
+	cyg_alarm_initialize(taskRT.alarmHdl, cyg_current_time() + ticks, ticks);
+}
+
+
+//===========================================================================
+void CANrx_taskTmr_close(void)
+{
+	// Realtime thread has higher priority than the caller, so it is not
+	// inside processing here.
+	cyg_alarm_disable(taskRT.alarmHdl);
+	taskRT.running = false;
+}
+
+
+//===========================================================================
+cyg_uint32 CANrx_taskTmr_getOverruns(void)
+{
+	return taskRT.overruns;
+}
+
+
+//----------------------------------------------------------------------------
+// end of CO_eCos_tasks.c
@@ -0,0 +1,84 @@
+//---------------------------------------------------------------------------
+#ifndef CO_eCos_tasksH
+#define CO_eCos_tasksH
+//===========================================================================
+/// \file    CO_eCos_tasks.h
+/// \brief   Event driven CANopen tasks for eCos.
+///
+/// Mirrors the two task model of the Linux port (CO_Linux_tasks.h):
+/// - The mainline task sleeps on an eCos flag until either a CANopen object
+///   signals new work (SDO request, emergency) or the next deadline reported
+///   by CO_process() is reached. No CPU time is spent in polling loops.
+/// - The realtime task is woken by a periodic eCos alarm and processes SYNC,
+///   RPDOs, optional application code and TPDOs. The alarm is driven by the
+///   kernel real time clock and does not drift.
+///
+/// Both tasks must be initialized after CO_init() and closed before the next
+/// CO_init().
+//===========================================================================
+
+
+//===========================================================================
+//                                  INCLUDES
+//===========================================================================
+#include <cyg/infra/cyg_type.h>
+#include "CANopen.h"
+
+
+///
+/// Initialize mainline task.
+/// Registers the wake up callback in the SDO server and emergency objects.
+/// The mainline task runs in the context of the thread, that calls
+/// taskMain_process().
+///
+void taskMain_init(void);
+
+///
+/// Cleanup mainline task.
+///
+void taskMain_close(void);
+
+///
+/// Wait for next event or deadline, then process CO_process().
+/// Blocks at most 50 ms.
+/// \param[out] reset Return value from CO_process()
+/// \return Time since previous call in milliseconds, for application code
+///
+uint16_t taskMain_process(CO_NMT_reset_cmd_t *reset);
+
+///
+/// Signal function, which triggers mainline task.
+/// It is used from some CANopenNode objects as callback and may be called
+/// from any thread.
+///
+void taskMain_cbSignal(void);
+
+
+///
+/// Initialize realtime task.
+/// Creates the realtime thread on first call and starts the periodic alarm.
+/// The interval is rounded to whole ticks of the real time clock, at least
+/// one tick.
+/// \param[in] interval_us Interval of the realtime task in microseconds
+/// \param[in] pFunctApp   Nonblocking application code, executed between
+///                        RPDO and TPDO processing with locked OD, or 0
+///
+void CANrx_taskTmr_init(cyg_uint32 interval_us, void (*pFunctApp)(void));
+
+///
+/// Stop realtime task. The thread is kept and waits for the next
+/// CANrx_taskTmr_init().
+///
+void CANrx_taskTmr_close(void);
+
+///
+/// Returns number of realtime intervals, that were missed because the
+/// realtime thread was not ready when the alarm fired. Missed intervals are
+/// passed as time difference to the PDO objects, so their timers stay
+/// accurate.
+///
+cyg_uint32 CANrx_taskTmr_getOverruns(void);
+
+
+//----------------------------------------------------------------------------
+#endif // CO_eCos_tasksH
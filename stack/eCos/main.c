@@ -16,14 +16,14 @@
 
 #include "CANopen.h"
 #include "application.h"
-#include "CO_PollingTimer.h"
+#include "CO_eCos_tasks.h"
 #include "CO_Flash.h"
 
 
 //============================================================================
 // Global variables and objects
 //============================================================================
-static cyg_uint64 CANopenPollingTimer = 1;
+#define CO_RT_INTERVAL_US 1000 // interval of realtime task
 extern struct sCO_OD_ROM CO_OD_ROM;
 static uint8_t reset = CO_RESET_NOT;
 extern void CO_eCos_errorReport(CO_EM_t *em, const uint8_t errorBit,
@@ -48,7 +48,6 @@ void CO_main(void)
 		{
 			// CANopen communication reset - initialize CANopen objects
 			int16_t err;
-			cyg_uint64 timer1msPrevious = CO_TmrGetMilliSec();
 
 			// initialize CANopen
 			err = CO_init();
@@ -71,27 +70,25 @@ void CO_main(void)
 			// start CAN and enable interrupts
 			CO_CANsetNormalMode(ADDR_CAN1);
 
+			// mainline task waits for events, realtime task runs on alarm
+			taskMain_init();
+			CANrx_taskTmr_init(CO_RT_INTERVAL_US, program1ms);
+
 			while (CO_RESET_NOT == reset)
 			{
-				//diag_print_reg("CAN GSR", CAN_CTRL_1_REG_BASE + CANREG_GSR);
-				// loop for normal program execution
-				cyg_uint64 timer1ms = CO_TmrGetMilliSec();
-				uint16_t timer1msDiff = timer1ms - timer1msPrevious;
-				timer1msPrevious = timer1ms;
+				// loop for normal program execution, blocks until next
+				// CANopen event or deadline
+				uint16_t timer1msDiff = taskMain_process(&reset);
 
 				// Application interface
 				programAsync(timer1msDiff);
 
-				// CANopen process
-				reset = CO_process(CO, timer1msDiff);
-				if (CO_TmrIsExpired(CANopenPollingTimer))
-				{
-					CANopenPollingTimer = CO_TmrStartFrom(CANopenPollingTimer, 1);
-					CO_process_RPDO(CO);
-					program1ms();
-					CO_process_TPDO(CO);
-				}
+				// erase next flash log block in advance
+				CO_FlashProcess();
 			}
+
+			CANrx_taskTmr_close();
+			taskMain_close();
 		}
 	}
 }
@@ -47,6 +47,9 @@
 
 #include "CO_driver.h"
 #include "CO_Emergency.h"
+#include "CO_tracepoint.h"
+#include "CO_statistics.h"
+#include "CO_latency.h"
 
 #include "drivers/can.h"
 #include "drivers/led.h"
@@ -59,8 +62,47 @@ static const char CAN_ERR_MSG[] = "CAN err %d 0x%x";
 
 SemaphoreHandle_t CO_EMCY_mtx = NULL; /* mutex type semaphore */
 SemaphoreHandle_t CO_OD_mtx = NULL;   /* mutex type semaphore */
-QueueHandle_t CO_ERR_queue = NULL;
-static const u8 CO_ERR_queue_size = 5;
+volatile uint32_t CO_OD_sequence = 0; /* see CO_OD_readBegin() */
+
+#ifdef CO_LOCK_STATISTICS
+CO_lockStatistics_t CO_EMCY_lockStat;
+CO_lockStatistics_t CO_OD_lockStat;
+
+
+/******************************************************************************/
+void CO_lockTake(SemaphoreHandle_t mtx, CO_lockStatistics_t *stat)
+{
+  bool contention = false;
+
+  if (xSemaphoreTake(mtx, 0) != pdTRUE) {
+    contention = true;
+    (void)xSemaphoreTake(mtx, portMAX_DELAY);
+  }
+  stat->lockCount++;
+  if (contention) {
+    stat->contentionCount++;
+  }
+  stat->holder = xTaskGetCurrentTaskHandle();
+  stat->lockTime = CO_LOCK_TIME();
+}
+
+
+/******************************************************************************/
+void CO_lockGive(SemaphoreHandle_t mtx, CO_lockStatistics_t *stat)
+{
+  uint32_t holdTime = CO_LOCK_TIME() - stat->lockTime;
+
+  if (holdTime > stat->maxHoldTime) {
+    stat->maxHoldTime = holdTime;
+    stat->maxHolder = stat->holder;
+  }
+  if ((stat->holdLimit != 0U) && (holdTime > stat->holdLimit)) {
+    stat->overrunCount++;
+  }
+  stat->holder = NULL;
+  (void)xSemaphoreGive(mtx);
+}
+#endif
 
 /******************************************************************************/
 static inline void CO_CANSignalBusPermanentError(void)
@@ -163,6 +205,9 @@ CO_ReturnError_t CO_CANmodule_init(CO_CANmodule_t *CANmodule,
   CANmodule->CANtxCount = 0U;
   CANmodule->errOld = 0U;
   CANmodule->em = NULL;
+  CANmodule->notifyTask = NULL;
+  CANmodule->errState = CO_CAN_ERRSTATE_ACTIVE;
+  CANmodule->errEvents = 0U;
 
   for(i=0U; i<rxSize; i++){
       rxArray[i].ident = 0U;
@@ -187,12 +232,6 @@ CO_ReturnError_t CO_CANmodule_init(CO_CANmodule_t *CANmodule,
       return CO_ERROR_OUT_OF_MEMORY;
     }
   }
-  if (CO_ERR_queue == NULL) {
-    CO_ERR_queue = xQueueCreate(CO_ERR_queue_size, sizeof(struct can_frame));
-    if (CO_ERR_queue == NULL) {
-      return CO_ERROR_OUT_OF_MEMORY;
-    }
-  }
 
   (void)led_setup_blink(LED_NAME_BUS_RED, CO_BUS_LED_BLINK, CO_BUS_LED_BLINK);
   (void)led_setup_blink(LED_NAME_BUS_GREEN, CO_BUS_LED_FLASH, 0);
@@ -243,7 +282,8 @@ void CO_CANmodule_disable(CO_CANmodule_t *CANmodule)
   can_deinit(CANmodule->driver);
   can_free(CANmodule->driver);
   CANmodule->driver = NULL;
-  xQueueReset(CO_ERR_queue);
+  CANmodule->notifyTask = NULL;
+  CANmodule->errEvents = 0U;
   (void)led_set(LED_NAME_BUS_RED, LED_STATE_OFF);
   (void)led_set(LED_NAME_BUS_GREEN, LED_STATE_OFF);
 }
@@ -334,6 +374,9 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
 
   /* Tx successfull -> reset OF */
   CO_errorReset(em, CO_EM_CAN_TX_OVERFLOW, 0);
+  CO_STAT_TX(CANmodule, buffer - CANmodule->txArray);
+  CO_STAT_BUS(CANmodule, buffer->DLC);
+  CO_LATENCY_TX(buffer);
 
   CO_CANSignalRxTx();
   return CO_ERROR_NO;
@@ -362,49 +405,113 @@ void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule)
    * for transmission inside the driver or dropped */
 }
 
+/******************************************************************************/
+void CO_CANsetNotifyTask(CO_CANmodule_t *CANmodule, TaskHandle_t task)
+{
+  CANmodule->notifyTask = task;
+}
+
+/******************************************************************************/
+void CO_CANnotified(CO_CANmodule_t *CANmodule, uint32_t notification)
+{
+  taskENTER_CRITICAL();
+  CANmodule->errEvents |= notification & CO_NOTIFY_ERR_MASK;
+  taskEXIT_CRITICAL();
+}
+
 /******************************************************************************/
 void CO_CANverifyErrors(CO_CANmodule_t *CANmodule)
 {
-  BaseType_t result;
-  struct can_frame frame;
+  uint32_t events;
+  uint8_t errState;
   CO_EM_t* em = (CO_EM_t*)CANmodule->em;
 
-  result = xQueueReceive(CO_ERR_queue, &frame, 0);
-  if (result == pdTRUE) {
-    switch (frame.can_id & CAN_ERR_MASK) {
-      case CAN_ERR_CRTL:
-        if ((frame.data[1] & CAN_ERR_CRTL_RX_OVERFLOW) != 0) {
-          CO_errorReport(em, CO_EM_CAN_RXB_OVERFLOW, CO_EMC_CAN_OVERRUN, 0);
-          CO_CANSignalBusSingleError();
-
-        } else if ((frame.data[1] & CAN_ERR_CRTL_TX_OVERFLOW) != 0) {
-          CO_errorReport(em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, 0);
-          CO_CANSignalBusSingleError();
-
-        } else if ((frame.data[1] & CAN_ERR_CRTL_RX_PASSIVE) != 0) {
-          CO_errorReport(em, CO_EM_CAN_RX_BUS_PASSIVE, CO_EMC_CAN_PASSIVE, 0);
-          CO_CANSignalBusPermanentError();
-
-        } else if ((frame.data[1] & CAN_ERR_CRTL_TX_PASSIVE) != 0) {
-          CO_errorReport(em, CO_EM_CAN_TX_BUS_PASSIVE, CO_EMC_CAN_PASSIVE, 0);
-          CO_CANSignalBusPermanentError();
-
-        } else if ((frame.data[1] & CAN_ERR_CRTL_ACTIVE) != 0) {
-          /* active -> Busfehler quittieren */
-          CO_errorReset(em, CO_EM_CAN_RX_BUS_PASSIVE, 0);
-          CO_errorReset(em, CO_EM_CAN_TX_BUS_PASSIVE, 0);
-          CO_errorReset(em, CO_EM_CAN_TX_BUS_OFF, 0);
-          CO_CANSignalBusNoError();
-        } else {
-          /* Everyting else, eg. Warning level */
-          CO_CANSignalBusSingleError();
-        }
-        break;
-      case CAN_ERR_BUSOFF:
-        /* wird verschickt wenn wir nicht mehr "Bus Off" sind */
-        CO_errorReport(em, CO_EM_CAN_TX_BUS_OFF, CO_EMC_BUS_OFF_RECOVERED, 0);
-        CO_CANSignalBusPermanentError();
-        break;
+  taskENTER_CRITICAL();
+  events = CANmodule->errEvents;
+  CANmodule->errEvents = 0U;
+  taskEXIT_CRITICAL();
+  if (events == 0U) {
+    return;
+  }
+
+  if ((events & CO_NOTIFY_ERR_RX_OVF) != 0U) {
+    CO_errorReport(em, CO_EM_CAN_RXB_OVERFLOW, CO_EMC_CAN_OVERRUN, 0);
+    CO_CANSignalBusSingleError();
+  }
+  if ((events & CO_NOTIFY_ERR_TX_OVF) != 0U) {
+    CO_errorReport(em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, 0);
+    CO_CANSignalBusSingleError();
+  }
+  if ((events & CO_NOTIFY_ERR) != 0U) {
+    errState = CANmodule->errState;
+    if ((errState & CO_CAN_ERRSTATE_RX_PASSIVE) != 0U) {
+      CO_errorReport(em, CO_EM_CAN_RX_BUS_PASSIVE, CO_EMC_CAN_PASSIVE, 0);
+      CO_CANSignalBusPermanentError();
+    }
+    if ((errState & CO_CAN_ERRSTATE_TX_PASSIVE) != 0U) {
+      CO_errorReport(em, CO_EM_CAN_TX_BUS_PASSIVE, CO_EMC_CAN_PASSIVE, 0);
+      CO_CANSignalBusPermanentError();
+    }
+    if (errState == CO_CAN_ERRSTATE_ACTIVE) {
+      /* active -> Busfehler quittieren */
+      CO_errorReset(em, CO_EM_CAN_RX_BUS_PASSIVE, 0);
+      CO_errorReset(em, CO_EM_CAN_TX_BUS_PASSIVE, 0);
+      CO_errorReset(em, CO_EM_CAN_TX_BUS_OFF, 0);
+      CO_CANSignalBusNoError();
+    }
+  }
+  if ((events & CO_NOTIFY_ERR_WARNING) != 0U) {
+    /* Everyting else, eg. Warning level */
+    CO_CANSignalBusSingleError();
+  }
+  if ((events & CO_NOTIFY_ERR_BUSOFF) != 0U) {
+    /* wird verschickt wenn wir nicht mehr "Bus Off" sind */
+    CO_errorReport(em, CO_EM_CAN_TX_BUS_OFF, CO_EMC_BUS_OFF_RECOVERED, 0);
+    CO_CANSignalBusPermanentError();
+  }
+}
+
+/******************************************************************************/
+static void CO_CANrxError(CO_CANmodule_t *CANmodule, const struct can_frame *frame)
+{
+  uint32_t events = 0U;
+
+  /* Error frames are classified here and passed to the mainline thread by task
+   * notification. Controller state is kept inside CANmodule, so no error is
+   * lost if more frames arrive before CO_CANverifyErrors() is called. */
+  switch (frame->can_id & CAN_ERR_MASK) {
+    case CAN_ERR_CRTL:
+      if ((frame->data[1] & CAN_ERR_CRTL_RX_OVERFLOW) != 0) {
+        events = CO_NOTIFY_ERR_RX_OVF;
+      } else if ((frame->data[1] & CAN_ERR_CRTL_TX_OVERFLOW) != 0) {
+        events = CO_NOTIFY_ERR_TX_OVF;
+      } else if ((frame->data[1] & CAN_ERR_CRTL_RX_PASSIVE) != 0) {
+        CANmodule->errState |= CO_CAN_ERRSTATE_RX_PASSIVE;
+        events = CO_NOTIFY_ERR;
+      } else if ((frame->data[1] & CAN_ERR_CRTL_TX_PASSIVE) != 0) {
+        CANmodule->errState |= CO_CAN_ERRSTATE_TX_PASSIVE;
+        events = CO_NOTIFY_ERR;
+      } else if ((frame->data[1] & CAN_ERR_CRTL_ACTIVE) != 0) {
+        CANmodule->errState = CO_CAN_ERRSTATE_ACTIVE;
+        events = CO_NOTIFY_ERR;
+      } else {
+        events = CO_NOTIFY_ERR_WARNING;
+      }
+      break;
+    case CAN_ERR_BUSOFF:
+      events = CO_NOTIFY_ERR_BUSOFF;
+      break;
+    default:
+      break;
+  }
+
+  if (events != 0U) {
+    if (CANmodule->notifyTask != NULL) {
+      (void)xTaskNotify(CANmodule->notifyTask, events, eSetBits);
+    } else {
+      taskENTER_CRITICAL();
+      CANmodule->errEvents |= events;
+      taskEXIT_CRITICAL();
     }
   }
 }
@@ -441,15 +548,17 @@ CO_ReturnError_t CO_CANrxWait(CO_CANmodule_t *CANmodule, uint16_t timeout)
     CO_CANSignalBusSingleError();
     return CO_ERROR_RX_OVERFLOW;
   }
+  CO_LATENCY_RX_READ();
 
   if ((frame.can_id & CAN_ERR_FLAG) != 0) {
-    (void)xQueueSend(CO_ERR_queue, &frame, 0);
+    CO_CANrxError(CANmodule, &frame);
     log_printf(LOG_DEBUG, CAN_ERR_MSG, __LINE__, frame.can_id);
     return CO_ERROR_NO;
   }
 
   /* Rx successfull -> reset OF */
   CO_errorReset(em, CO_EM_CAN_RXB_OVERFLOW, 0);
+  CO_STAT_BUS(CANmodule, frame.can_dlc);
 
   /* The template supports hardware and software filtering modes. However,
    * hardware filtering mode requires to get filter match index from hardware,
@@ -465,10 +574,15 @@ CO_ReturnError_t CO_CANrxWait(CO_CANmodule_t *CANmodule, uint16_t timeout)
 
   /* Call specific function, which will process the message */
   if (matched && (buffer->pFunct != NULL)) {
+    CO_TP_BEGIN(CO_TP_RX_CALLBACK, buffer - CANmodule->rxArray);
+    CO_STAT_RX(CANmodule, buffer - CANmodule->rxArray);
+    CO_LATENCY_RX_DISPATCH(buffer->object);
     buffer->pFunct(buffer->object, (CO_CANrxMsg_t*) &frame);
+    CO_TP_END(CO_TP_RX_CALLBACK, buffer - CANmodule->rxArray);
     CO_CANSignalRxTx();
   }
 
+  CO_LATENCY_RX_RETURN();
   return CO_ERROR_NO;
 }
 
@@ -58,6 +58,7 @@ extern "C" {
 
 #include "os/freertos/include/FreeRTOS.h"
 #include "os/freertos/include/semphr.h"
+#include "os/freertos/include/task.h"
 
 #include "interface/utils.h"
 #include "drivers/can.h"
@@ -174,20 +175,104 @@ extern "C" {
  * CO_SYNC_initCallback() function.
  * @{
  */
+/* CO_CANsend() only puts the message into the queue of the CAN driver, which
+ * is protected by the driver itself. No lock and so no statistics needed. */
 #define CO_LOCK_CAN_SEND()      /* not needed */
 #define CO_UNLOCK_CAN_SEND()
 
+#ifdef CO_LOCK_STATISTICS
+/**
+ * Time source for the lock statistics. Default is the tick counter, which
+ * only shows hold times longer than one tick. Define CO_LOCK_TIME() as a
+ * free running microsecond timer for better resolution.
+ */
+#ifndef CO_LOCK_TIME
+#define CO_LOCK_TIME() ((uint32_t)xTaskGetTickCount())
+#endif
+
+/**
+ * Statistics of one critical section, see CO_ODF_lockStatistics().
+ *
+ * All members are updated while the mutex is held.
+ */
+typedef struct{
+    uint32_t            lockCount;      /**< Number of locks */
+    uint32_t            contentionCount;/**< Locks, which had to wait for another task */
+    uint32_t            overrunCount;   /**< Locks held longer than holdLimit */
+    uint32_t            maxHoldTime;    /**< Longest hold time in CO_LOCK_TIME() units */
+    uint32_t            holdLimit;      /**< Limit for overrunCount, 0 disables */
+    uint32_t            lockTime;       /**< CO_LOCK_TIME() of the current lock */
+    TaskHandle_t        holder;         /**< Task, which holds the lock, or NULL */
+    TaskHandle_t        maxHolder;      /**< Task, which caused maxHoldTime */
+}CO_lockStatistics_t;
+
+extern CO_lockStatistics_t CO_EMCY_lockStat;
+extern CO_lockStatistics_t CO_OD_lockStat;
+
+/**
+ * Take mutex and update statistics.
+ *
+ * The mutex is first tried without blocking, so a contention is counted only
+ * if another task really holds it. Mutexes of FreeRTOS use priority
+ * inheritance, so the holder runs with priority of the waiting RT task.
+ *
+ * @param mtx Mutex type semaphore.
+ * @param stat Statistics of the critical section.
+ */
+void CO_lockTake(SemaphoreHandle_t mtx, CO_lockStatistics_t *stat);
+
+/**
+ * Update statistics and give mutex taken with CO_lockTake().
+ *
+ * @param mtx Mutex type semaphore.
+ * @param stat Statistics of the critical section.
+ */
+void CO_lockGive(SemaphoreHandle_t mtx, CO_lockStatistics_t *stat);
+
+#define CO_LOCK_TAKE(mtx, stat) CO_lockTake(mtx, stat)
+#define CO_LOCK_GIVE(mtx, stat) CO_lockGive(mtx, stat)
+#else
+#define CO_LOCK_TAKE(mtx, stat) ((void)xSemaphoreTake(mtx, portMAX_DELAY))
+#define CO_LOCK_GIVE(mtx, stat) ((void)xSemaphoreGive(mtx))
+#endif
+
 extern SemaphoreHandle_t CO_EMCY_mtx;
 /** Lock critical section in CO_errorReport() or CO_errorReset() */
-static inline void CO_LOCK_EMCY(void) { (void)xSemaphoreTake(CO_EMCY_mtx, portMAX_DELAY); }
+static inline void CO_LOCK_EMCY(void) { CO_LOCK_TAKE(CO_EMCY_mtx, &CO_EMCY_lockStat); }
 /** Unlock critical section in CO_errorReport() or CO_errorReset() */
-static inline void CO_UNLOCK_EMCY(void) { (void)xSemaphoreGive(CO_EMCY_mtx); }
+static inline void CO_UNLOCK_EMCY(void) { CO_LOCK_GIVE(CO_EMCY_mtx, &CO_EMCY_lockStat); }
 
 extern SemaphoreHandle_t CO_OD_mtx;
+/** Sequence counter of the Object Dictionary, odd while CO_OD_mtx is taken */
+extern volatile uint32_t CO_OD_sequence;
 /** Lock critical section when accessing Object Dictionary */
-static inline void CO_LOCK_OD(void) { (void)xSemaphoreTake(CO_OD_mtx, portMAX_DELAY); }
+static inline void CO_LOCK_OD(void) { CO_LOCK_TAKE(CO_OD_mtx, &CO_OD_lockStat); CO_OD_sequence++; __sync_synchronize(); }
 /** Unock critical section when accessing Object Dictionary */
-static inline void CO_UNLOCK_OD(void) { (void)xSemaphoreGive(CO_OD_mtx); }
+static inline void CO_UNLOCK_OD(void) { __sync_synchronize(); CO_OD_sequence++; CO_LOCK_GIVE(CO_OD_mtx, &CO_OD_lockStat); }
+/** Lock Object Dictionary from the CAN receive function, which runs in a task */
+#define CO_LOCK_OD_RX() CO_LOCK_OD()
+/** Unlock Object Dictionary from the CAN receive function */
+#define CO_UNLOCK_OD_RX() CO_UNLOCK_OD()
+
+/**
+ * Start reading Object Dictionary without lock (seqlock).
+ *
+ * Writers (RT thread with RPDOs, SDO server, application) hold CO_LOCK_OD().
+ * A reader copies the data without taking the mutex, so it never delays the
+ * RT thread, and verifies the copy with CO_OD_readValid(). If the copy is
+ * invalid, it is repeated with CO_LOCK_OD(). Spinning instead would not
+ * terminate, if the writer has lower priority than the reader.
+ *
+ * @return Sequence counter for CO_OD_readValid().
+ */
+static inline uint32_t CO_OD_readBegin(void) { uint32_t seq = CO_OD_sequence; __sync_synchronize(); return seq; }
+/**
+ * Verify data read after CO_OD_readBegin().
+ *
+ * @param seq Return value of CO_OD_readBegin().
+ * @return True, if Object Dictionary was not locked in the meantime.
+ */
+static inline bool CO_OD_readValid(uint32_t seq) { __sync_synchronize(); return ((seq & 1U) == 0U) && (CO_OD_sequence == seq); }
 /** @} */
 
 /**
@@ -298,6 +383,36 @@ typedef struct{
 }CO_CANtx_t;
 
 
+/**
+ * @name Task notification bits
+ *
+ * The mainline thread blocks on its task notification value instead of a fixed
+ * delay. Receive callbacks, the receive thread and driver interrupts set one
+ * of these bits to wake it up, see threadMain_process().
+ * @{
+ */
+#define CO_NOTIFY_RX            0x00000001UL /**< Message for mainline processing received (SDO, EMCY, ...) */
+#define CO_NOTIFY_TX            0x00000002UL /**< Message transmitted, from low level driver tx complete interrupt */
+#define CO_NOTIFY_ERR           0x00000004UL /**< CAN controller error state changed, see CO_CANmodule_t::errState */
+#define CO_NOTIFY_ERR_RX_OVF    0x00000008UL /**< CAN receive overflow */
+#define CO_NOTIFY_ERR_TX_OVF    0x00000010UL /**< CAN transmit overflow */
+#define CO_NOTIFY_ERR_WARNING   0x00000020UL /**< CAN warning level or other single error */
+#define CO_NOTIFY_ERR_BUSOFF    0x00000040UL /**< Recovered from CAN bus off */
+#define CO_NOTIFY_ERR_MASK      0x0000007CUL /**< All error bits, evaluated by CO_CANverifyErrors() */
+/** @} */
+
+
+/**
+ * CAN controller error state, bits accumulated from the error frames. Receive
+ * and transmit passive may be set together, error active clears both.
+ */
+typedef enum{
+    CO_CAN_ERRSTATE_ACTIVE      = 0,    /**< Error active, no bit set */
+    CO_CAN_ERRSTATE_RX_PASSIVE  = 1,    /**< Receive error passive */
+    CO_CAN_ERRSTATE_TX_PASSIVE  = 2     /**< Transmit error passive */
+}CO_CANerrState_t;
+
+
 /**
  * CAN module object. It may be different in different microcontrollers.
  */
@@ -319,6 +434,15 @@ typedef struct{
     volatile uint32_t   CANtxCount;
     uint32_t            errOld;         /**< Previous state of CAN errors */
     void               *em;             /**< Emergency object */
+    /** Task notified on CAN errors, from CO_CANsetNotifyTask(). If NULL, error
+      * events are stored directly, which is only valid if receive and mainline
+      * processing run inside the same task. */
+    TaskHandle_t        notifyTask;
+    /** Controller error state, written by receive thread (bits of #CO_CANerrState_t) */
+    volatile uint8_t    errState;
+    /** Error events (CO_NOTIFY_ERR_xxx) not yet evaluated by CO_CANverifyErrors(),
+      * accessed inside taskENTER_CRITICAL() */
+    uint32_t            errEvents;
 
     can_t              *driver;         /**< neuberger can driver object */
 }CO_CANmodule_t;
@@ -515,6 +639,30 @@ void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule);
 void CO_CANverifyErrors(CO_CANmodule_t *CANmodule);
 
 
+/**
+ * Set task to be notified on CAN errors.
+ *
+ * Error frames are classified inside the receive thread and passed to this task
+ * by setting CO_NOTIFY_ERR_xxx bits in its notification value.
+ *
+ * @param CANmodule This object.
+ * @param task Task which calls CO_process(), may be NULL.
+ */
+void CO_CANsetNotifyTask(CO_CANmodule_t *CANmodule, TaskHandle_t task);
+
+
+/**
+ * Pass task notification value to CAN module.
+ *
+ * Function must be called by the notified task after it received it's
+ * notification value and before calling CO_process().
+ *
+ * @param CANmodule This object.
+ * @param notification Notification value received by xTaskNotifyWait().
+ */
+void CO_CANnotified(CO_CANmodule_t *CANmodule, uint32_t notification);
+
+
 /**
  * Receives CAN messages.
  *
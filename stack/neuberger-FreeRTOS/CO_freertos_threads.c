@@ -48,6 +48,7 @@
 
 #include "CO_driver.h"
 #include "CANopen.h"
+#include "CO_latency.h"
 
 /* Mainline thread (threadMain) ***************************************************/
 static struct
@@ -59,50 +60,75 @@ static struct
 } threadMain;
 
 /**
- * This function resumes the main thread after an SDO event happened
+ * This function resumes the main thread after an SDO or EMCY event happened
  */
 static void threadMain_resumeCallback(void)
 {
   if (threadMain.id != 0) {
-    xTaskAbortDelay(threadMain.id);
+    (void)xTaskNotify(threadMain.id, CO_NOTIFY_RX, eSetBits);
+  }
+}
+
+void threadMain_signal(void)
+{
+  threadMain_resumeCallback();
+}
+
+void threadMain_notifyFromISR(uint32_t bits, BaseType_t *pxHigherPriorityTaskWoken)
+{
+  if (threadMain.id != 0) {
+    (void)xTaskNotifyFromISR(threadMain.id, bits, eSetBits,
+                             pxHigherPriorityTaskWoken);
   }
 }
 
 void threadMain_init(uint16_t interval, TaskHandle_t threadMainID)
 {
+  uint16_t i;
+
   threadMain.interval = interval;
   threadMain.interval_next = 1; /* do not block the first time. 0 is not allowed by the OS */
   threadMain.interval_start = xTaskGetTickCount();
   threadMain.id = threadMainID;
-  CO_SDO_initCallback(CO->SDO[0], threadMain_resumeCallback);
+  for (i = 0; i < CO_NO_SDO_SERVER; i++) {
+    CO_SDO_initCallback(CO->SDO[i], threadMain_resumeCallback);
+  }
   CO_EM_initCallback(CO->em, threadMain_resumeCallback);
+  CO_CANsetNotifyTask(CO->CANmodule[0], threadMainID);
 }
 
 void threadMain_close(void)
 {
-
+  threadMain.id = 0;
 }
 
 void threadMain_process(CO_NMT_reset_cmd_t *reset)
 {
   uint16_t diff;
   uint16_t next;
+  uint32_t notification = 0;
   TickType_t now;
-  TickType_t start;
+  TickType_t elapsed;
+  TickType_t timeout;
 
-  start = threadMain.interval_start;
-  vTaskDelayUntil(&start, pdMS_TO_TICKS(threadMain.interval_next));
+  /* Block until either the timer interval runs out or an event is signalled by
+   * task notification. Other than an aborted vTaskDelayUntil(), this gives us
+   * the exact time we were woken up. Pending notifications are always fetched,
+   * even if we are already late. */
   now = xTaskGetTickCount();
-  if (start > now) {
-    /* vTaskDelayUntil returns the delay end time in value "start". If this time
-     * is in the future, delay has been aborted by callback.
-     * Unfortunately, vTaskDelayUntil() doesn't give us a exact time stamp it
-     * was abortet, so we have to take a timestamp afterwards. This introduces
-     * some inaccuracy. */
-    start = now;
+  elapsed = now - threadMain.interval_start;
+  timeout = pdMS_TO_TICKS(threadMain.interval_next);
+  if (elapsed < timeout) {
+    timeout -= elapsed;
+  } else {
+    timeout = 0;
   }
+  if (xTaskNotifyWait(0, 0xFFFFFFFFUL, &notification, timeout) == pdTRUE) {
+    CO_CANnotified(CO->CANmodule[0], notification);
+  }
+  now = xTaskGetTickCount();
 
-  diff = (uint16_t)(start - threadMain.interval_start);
+  diff = (uint16_t)(now - threadMain.interval_start);
 
   do {
     next = threadMain.interval;
@@ -112,19 +138,24 @@ void threadMain_process(CO_NMT_reset_cmd_t *reset)
 
   /* prepare next call */
   threadMain.interval_next = next;
-  threadMain.interval_start = start;
+  threadMain.interval_start = now;
 }
 
 /* Realtime thread (threadRT) *****************************************************/
 static struct {
   int16_t interval;          /* max timer interval */
   TickType_t interval_time;  /* time value CO_process() was called last time */
+  void *object;              /* from CANrx_threadTmr_initCallback() */
+  void (*pFunct)(void *object, bool_t syncWas, uint32_t timeDifference_us);
 } threadRT;
 
 void CANrx_threadTmr_init(uint16_t interval)
 {
   threadRT.interval = interval;
   threadRT.interval_time = xTaskGetTickCount(); /* Processing is due now */
+#ifdef CO_LATENCY_BENCH
+  CO_latency_init(CO->SYNC);
+#endif
 }
 
 void CANrx_threadTmr_close(void)
@@ -132,6 +163,15 @@ void CANrx_threadTmr_close(void)
 
 }
 
+void CANrx_threadTmr_initCallback(void *object,
+    void (*pFunct)(void *object, bool_t syncWas, uint32_t timeDifference_us))
+{
+  CO_LOCK_OD();
+  threadRT.object = object;
+  threadRT.pFunct = pFunct;
+  CO_UNLOCK_OD();
+}
+
 void CANrx_threadTmr_process(void)
 {
   int16_t timeout;
@@ -162,6 +202,12 @@ void CANrx_threadTmr_process(void)
 
         /* Process Sync and read inputs */
         syncWas = CO_process_SYNC_RPDO(CO, us_interval);
+        CO_LATENCY_SYNC_RPDO(syncWas);
+
+        /* Further I/O or nonblocking application code */
+        if (threadRT.pFunct != NULL) {
+          threadRT.pFunct(threadRT.object, syncWas, us_interval);
+        }
 
         /* Write outputs */
         CO_process_TPDO(CO, syncWas, us_interval);
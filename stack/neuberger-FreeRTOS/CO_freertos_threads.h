@@ -60,10 +60,14 @@ extern "C" {
  * Initialize mainline thread.
  *
  * threadMain is non-realtime thread for CANopenNode processing. It is blocking.
- * It blocks for a maximum of <interval> ms or less if necessary.
+ * It blocks for a maximum of <interval> ms or less if necessary. It is woken
+ * up early by direct task notification (CO_NOTIFY_xxx) on SDO and EMCY
+ * reception and on CAN errors.
  * This thread processes CO_process() function from CANopen.c file.
  *
- * @param interval maximum interval in ms, recommended value: 50 ms
+ * @param interval maximum interval in ms. Deadlines of the stack are reported
+ * exactly by CO_process(), so this only needs to cover events which are not
+ * signalled by task notification.
  * @param threadMainID ID of the thread that will run #threadMain_process()
  */
 extern void threadMain_init(uint16_t interval, TaskHandle_t threadMainID);
@@ -73,6 +77,22 @@ extern void threadMain_init(uint16_t interval, TaskHandle_t threadMainID);
  */
 extern void threadMain_close(void);
 
+/**
+ * Wake up mainline thread from another thread.
+ */
+extern void threadMain_signal(void);
+
+/**
+ * Wake up mainline thread from interrupt.
+ *
+ * To be called by low level driver interrupts, e.g. CAN tx complete or error,
+ * with CO_NOTIFY_xxx bits from CO_driver.h.
+ *
+ * @param bits CO_NOTIFY_xxx bits to set in notification value
+ * @param [out] pxHigherPriorityTaskWoken see xTaskNotifyFromISR()
+ */
+extern void threadMain_notifyFromISR(uint32_t bits, BaseType_t *pxHigherPriorityTaskWoken);
+
 /**
  * Process mainline thread.
  *
@@ -102,6 +122,20 @@ extern void CANrx_threadTmr_init(uint16_t interval);
  */
 extern void CANrx_threadTmr_close(void);
 
+/**
+ * Register application code for the realtime thread.
+ *
+ * pFunct is called once per interval between RPDO and TPDO processing with
+ * CO_LOCK_OD() held, only if the CAN module is in normal mode. It must not
+ * block. The callback is kept over CANrx_threadTmr_init().
+ *
+ * @param object Pointer passed to pFunct.
+ * @param pFunct Callback or NULL. syncWas is the return value of
+ *               CO_process_SYNC_RPDO().
+ */
+extern void CANrx_threadTmr_initCallback(void *object,
+    void (*pFunct)(void *object, bool_t syncWas, uint32_t timeDifference_us));
+
 /**
  * Process realtime thread.
  *
@@ -0,0 +1,252 @@
+/**
+ * CAN latency benchmark for neuberger. + FreeRTOS.
+ *
+ * @file        CO_latency.c
+ * @ingroup     CO_driver
+ * @author      Martin Wagner
+ * @copyright   2016 Neuberger Gebaeudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+#include <string.h>
+
+#include "CO_latency.h"
+
+#ifdef CO_LATENCY_BENCH
+
+CO_latency_t CO_latency[CO_LATENCY_COUNT];
+volatile uint32_t CO_latency_isrStamps[CO_LATENCY_ISR_QUEUE];
+volatile uint32_t CO_latency_isrHead = 0;
+
+/* State of the realtime thread, only used from there */
+static struct {
+  const void *syncObject;   /* object of SYNC receive buffer */
+  uint32_t isrTail;         /* next stamp to take from CO_latency_isrStamps */
+  uint32_t rxStamp;         /* interrupt stamp of the frame being processed */
+  bool_t rxStampValid;
+  uint32_t syncStamp;       /* interrupt stamp of the last SYNC */
+  bool_t syncRPDOpending;   /* SYNC received, CO_process_SYNC_RPDO() not yet done */
+  bool_t syncTPDOpending;   /* SYNC processed, no synchronous TPDO sent yet */
+} latencyRT;
+
+/* Helper function - add latency in cycles to statistics */
+static void CO_latency_add(CO_latency_t *latency, uint32_t cycles)
+{
+  uint32_t bin;
+
+  if (latency->reset) {
+    memset(latency, 0, sizeof(*latency));
+  }
+
+  if ((latency->count == 0) || (cycles < latency->min)) {
+    latency->min = cycles;
+  }
+  if (cycles > latency->max) {
+    latency->max = cycles;
+  }
+  latency->sum += cycles;
+  latency->count++;
+
+  bin = cycles / CO_LATENCY_BIN_CYCLES;
+  if (bin >= CO_LATENCY_BINS) {
+    bin = CO_LATENCY_BINS - 1;
+  }
+  latency->histogram[bin]++;
+}
+
+/* Helper function - count event without start stamp */
+static void CO_latency_miss(CO_latency_t *latency)
+{
+  if (latency->reset) {
+    memset(latency, 0, sizeof(*latency));
+  }
+  latency->missed++;
+}
+
+/******************************************************************************/
+void CO_latency_init(const void *syncObject)
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+  /* CoreDebug->DEMCR |= TRCENA; DWT->CTRL |= CYCCNTENA. CYCCNT is not reset,
+   * trace points may use it at the same time. */
+  *(volatile uint32_t *)0xE000EDFCUL |= 1UL << 24;
+  *(volatile uint32_t *)0xE0001000UL |= 1UL;
+#endif
+  memset(CO_latency, 0, sizeof(CO_latency));
+  memset(&latencyRT, 0, sizeof(latencyRT));
+  latencyRT.syncObject = syncObject;
+  latencyRT.isrTail = CO_latency_isrHead;
+}
+
+/******************************************************************************/
+void CO_latency_rxRead(void)
+{
+  uint32_t head = CO_latency_isrHead;
+
+  if (head == latencyRT.isrTail) {
+    /* driver did not stamp this frame */
+    latencyRT.rxStampValid = false;
+    return;
+  }
+  if ((head - latencyRT.isrTail) > CO_LATENCY_ISR_QUEUE) {
+    /* stamps were overwritten, frames got out of order with stamps. Start
+     * over with the most recent one */
+    CO_latency_miss(&CO_latency[CO_LATENCY_RX_DISPATCH]);
+    latencyRT.isrTail = head - 1U;
+  }
+  latencyRT.rxStamp = CO_latency_isrStamps[latencyRT.isrTail & (CO_LATENCY_ISR_QUEUE - 1U)];
+  latencyRT.isrTail++;
+  latencyRT.rxStampValid = true;
+}
+
+/******************************************************************************/
+void CO_latency_rxDispatch(const void *object)
+{
+  uint32_t now = CO_LATENCY_TIMESTAMP();
+
+  if (!latencyRT.rxStampValid) {
+    CO_latency_miss(&CO_latency[CO_LATENCY_RX_DISPATCH]);
+    return;
+  }
+  CO_latency_add(&CO_latency[CO_LATENCY_RX_DISPATCH], now - latencyRT.rxStamp);
+
+  if ((object != NULL) && (object == latencyRT.syncObject)) {
+    latencyRT.syncStamp = latencyRT.rxStamp;
+    latencyRT.syncRPDOpending = true;
+    latencyRT.syncTPDOpending = false;
+  }
+}
+
+/******************************************************************************/
+void CO_latency_rxReturn(void)
+{
+  uint32_t now = CO_LATENCY_TIMESTAMP();
+
+  if (!latencyRT.rxStampValid) {
+    CO_latency_miss(&CO_latency[CO_LATENCY_RX_RETURN]);
+    return;
+  }
+  CO_latency_add(&CO_latency[CO_LATENCY_RX_RETURN], now - latencyRT.rxStamp);
+  latencyRT.rxStampValid = false;
+}
+
+/******************************************************************************/
+void CO_latency_syncRPDO(bool_t syncWas)
+{
+  uint32_t now = CO_LATENCY_TIMESTAMP();
+
+  if (!syncWas) {
+    return;
+  }
+  if (!latencyRT.syncRPDOpending) {
+    /* SYNC was received without interrupt stamp */
+    CO_latency_miss(&CO_latency[CO_LATENCY_SYNC_RPDO]);
+    return;
+  }
+  CO_latency_add(&CO_latency[CO_LATENCY_SYNC_RPDO], now - latencyRT.syncStamp);
+  latencyRT.syncRPDOpending = false;
+  latencyRT.syncTPDOpending = true;
+}
+
+/******************************************************************************/
+void CO_latency_tx(const CO_CANtx_t *buffer)
+{
+  uint32_t now = CO_LATENCY_TIMESTAMP();
+
+  /* Synchronous TPDOs are sent from the realtime thread only */
+  if (!buffer->syncFlag || !latencyRT.syncTPDOpending) {
+    return;
+  }
+  CO_latency_add(&CO_latency[CO_LATENCY_SYNC_TPDO], now - latencyRT.syncStamp);
+  latencyRT.syncTPDOpending = false;
+}
+
+/******************************************************************************/
+CO_SDO_abortCode_t CO_ODF_latency(CO_ODF_arg_t *ODF_arg)
+{
+  uint32_t value;
+  CO_latency_t *latency = (CO_latency_t *)ODF_arg->object;
+
+  if (ODF_arg->subIndex == 0) {
+    return CO_SDO_AB_NONE;
+  }
+
+  if (!ODF_arg->reading) {
+    /* any write resets statistics. Done by the realtime thread with the next
+     * sample, which owns the statistics */
+    latency->reset = true;
+    return CO_SDO_AB_NONE;
+  }
+
+  if (latency->reset) {
+    /* reset is pending */
+    value = 0;
+  } else {
+    switch (ODF_arg->subIndex) {
+      case 1:
+        value = latency->min;
+        break;
+      case 2:
+        value = (latency->count > 0) ? (uint32_t)(latency->sum / latency->count) : 0;
+        break;
+      case 3:
+        value = latency->max;
+        break;
+      case 4:
+        value = latency->count;
+        break;
+      case 5:
+        value = latency->missed;
+        break;
+      case 6:
+        value = CO_LATENCY_BIN_CYCLES;
+        break;
+      default:
+        if (ODF_arg->subIndex >= 7 + CO_LATENCY_BINS) {
+          return CO_SDO_AB_SUB_UNKNOWN;
+        }
+        value = latency->histogram[ODF_arg->subIndex - 7];
+        break;
+    }
+  }
+  CO_setUint32(ODF_arg->data, value);
+
+  return CO_SDO_AB_NONE;
+}
+
+#endif /* CO_LATENCY_BENCH */
@@ -0,0 +1,229 @@
+/**
+ * CAN latency benchmark for neuberger. + FreeRTOS.
+ *
+ * @file        CO_latency.h
+ * @ingroup     CO_driver
+ * @author      Martin Wagner
+ * @copyright   2016 Neuberger Gebaeudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_LATENCY_H
+#define CO_LATENCY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The latency benchmark measures the reaction of the realtime thread on the
+ * target. Times are taken from the DWT cycle counter of Cortex-M3/M4/M7:
+ *
+ * - the low level CAN driver calls CO_latency_stampISR() on entry of the
+ *   receive interrupt, once for each frame, which it queues for can_read(),
+ * - CO_CANrxWait() takes the stamp of the frame after can_read(), before the
+ *   receive callback (pFunct) is called and on return,
+ * - CANrx_threadTmr_process() after CO_process_SYNC_RPDO() has seen a SYNC,
+ * - CO_CANsend() when the first synchronous TPDO after the SYNC is sent.
+ *
+ * Each measurement is collected into a CO_latency_t, which can be read by SDO
+ * with CO_ODF_latency(). All values are in CPU cycles, so results of different
+ * builds and configurations on the same hardware can be compared directly.
+ *
+ * The benchmark is enabled by defining CO_LATENCY_BENCH. Otherwise the hooks
+ * in the driver expand to nothing. */
+
+#ifdef CO_LATENCY_BENCH
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+
+/**
+ * Cycle counter, 32 bit, wraps around. Default is DWT->CYCCNT, which is
+ * enabled by CO_latency_init().
+ */
+#ifndef CO_LATENCY_TIMESTAMP
+#define CO_LATENCY_TIMESTAMP()      (*(volatile uint32_t *)0xE0001004UL)
+#endif
+
+/**
+ * Number of histogram bins. The last bin collects all values above.
+ */
+#ifndef CO_LATENCY_BINS
+#define CO_LATENCY_BINS             16U
+#endif
+
+/**
+ * Width of one histogram bin in CPU cycles. Default is 10us.
+ */
+#ifndef CO_LATENCY_BIN_CYCLES
+#define CO_LATENCY_BIN_CYCLES       (configCPU_CLOCK_HZ / 100000UL)
+#endif
+
+/**
+ * Number of interrupt stamps, which may be queued for CO_CANrxWait(). Should
+ * be at least the length of the receive queue of the low level driver, must be
+ * power of 2.
+ */
+#ifndef CO_LATENCY_ISR_QUEUE
+#define CO_LATENCY_ISR_QUEUE        32U
+#endif
+
+/**
+ * Measured latencies.
+ */
+typedef enum {
+  CO_LATENCY_RX_DISPATCH = 0, /**< Receive interrupt until receive callback is called */
+  CO_LATENCY_RX_RETURN   = 1, /**< Receive interrupt until CO_CANrxWait() returns */
+  CO_LATENCY_SYNC_RPDO   = 2, /**< SYNC receive interrupt until CO_process_SYNC_RPDO() is done */
+  CO_LATENCY_SYNC_TPDO   = 3, /**< SYNC receive interrupt until first synchronous TPDO is sent */
+  CO_LATENCY_COUNT       = 4  /**< Number of measurements */
+} CO_latency_id_t;
+
+/**
+ * Statistics of one measurement, see CO_ODF_latency().
+ *
+ * Updated by the realtime thread only. Reading from other tasks may see one
+ * sample inconsistent between members.
+ */
+typedef struct {
+  uint32_t          min;        /**< Minimum latency in cycles */
+  uint32_t          max;        /**< Maximum latency in cycles */
+  uint64_t          sum;        /**< Sum of all latencies, for average */
+  uint32_t          count;      /**< Number of samples */
+  uint32_t          missed;     /**< Events without start stamp, e.g. lost interrupt stamps */
+  /** Histogram, bin n counts values from n * CO_LATENCY_BIN_CYCLES */
+  uint32_t          histogram[CO_LATENCY_BINS];
+  volatile bool_t   reset;      /**< Reset requested by other task */
+} CO_latency_t;
+
+/** Statistics, indexed by CO_latency_id_t */
+extern CO_latency_t CO_latency[CO_LATENCY_COUNT];
+
+/** Queue of receive interrupt stamps, written by CO_latency_stampISR() */
+extern volatile uint32_t CO_latency_isrStamps[CO_LATENCY_ISR_QUEUE];
+extern volatile uint32_t CO_latency_isrHead;
+
+/**
+ * Enable cycle counter and clear all statistics.
+ *
+ * Called by CANrx_threadTmr_init().
+ *
+ * @param syncObject Object of the SYNC receive buffer (CO->SYNC), so SYNC can
+ * be recognized in CO_CANrxWait(). May be NULL.
+ */
+void CO_latency_init(const void *syncObject);
+
+/**
+ * Take stamp of a received frame.
+ *
+ * To be called by the low level CAN driver from the receive interrupt, as
+ * early as possible, once for each frame, which is later returned by
+ * can_read(). This includes error frames. There must be only one receive
+ * interrupt calling this function.
+ */
+static inline void CO_latency_stampISR(void)
+{
+  uint32_t head = CO_latency_isrHead;
+
+  CO_latency_isrStamps[head & (CO_LATENCY_ISR_QUEUE - 1U)] = CO_LATENCY_TIMESTAMP();
+  CO_latency_isrHead = head + 1U;
+}
+
+/**
+ * Take stamp of the interrupt queue for the frame just read. Called by
+ * CO_CANrxWait() after can_read().
+ */
+void CO_latency_rxRead(void);
+
+/**
+ * Record receive interrupt until receive callback of _object_.
+ */
+void CO_latency_rxDispatch(const void *object);
+
+/**
+ * Record receive interrupt until return of CO_CANrxWait().
+ */
+void CO_latency_rxReturn(void);
+
+/**
+ * Record SYNC receive interrupt until CO_process_SYNC_RPDO() is done.
+ *
+ * @param syncWas Return value from CO_process_SYNC_RPDO().
+ */
+void CO_latency_syncRPDO(bool_t syncWas);
+
+/**
+ * Record SYNC receive interrupt until first synchronous TPDO is sent.
+ *
+ * @param buffer Buffer, which was just sent by CO_CANsend().
+ */
+void CO_latency_tx(const CO_CANtx_t *buffer);
+
+/**
+ * Function for accessing latency statistics by SDO.
+ *
+ * Register with CO_OD_configure() for an UNSIGNED32 array entry, object
+ * argument is one of CO_latency[]. Subindex 1: min, 2: average, 3: max latency
+ * in cycles, 4: number of samples, 5: missed samples, 6: width of histogram bin
+ * in cycles, 7 and following: histogram bins. Writing any subindex resets the
+ * statistics.
+ *
+ * For more information see file CO_SDO.h.
+ */
+CO_SDO_abortCode_t CO_ODF_latency(CO_ODF_arg_t *ODF_arg);
+
+#define CO_LATENCY_RX_READ()            CO_latency_rxRead()
+#define CO_LATENCY_RX_DISPATCH(object)  CO_latency_rxDispatch(object)
+#define CO_LATENCY_RX_RETURN()          CO_latency_rxReturn()
+#define CO_LATENCY_SYNC_RPDO(syncWas)   CO_latency_syncRPDO(syncWas)
+#define CO_LATENCY_TX(buffer)           CO_latency_tx(buffer)
+#else
+#define CO_LATENCY_RX_READ()
+#define CO_LATENCY_RX_DISPATCH(object)
+#define CO_LATENCY_RX_RETURN()
+#define CO_LATENCY_SYNC_RPDO(syncWas)
+#define CO_LATENCY_TX(buffer)
+#endif /* CO_LATENCY_BENCH */
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
@@ -44,6 +44,7 @@
  */
 
 #include "drivers/checksum.h"
+#include "crc.h"
 
 /*
  * This function wraps the BSP CRC function to the CANopenNode signature.
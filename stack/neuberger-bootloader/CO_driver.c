@@ -102,6 +102,7 @@ CO_ReturnError_t CO_CANmodule_init(CO_CANmodule_t *CANmodule,
   }
   for(i=0U; i<txSize; i++){
       txArray[i].bufferFull = false;
+      txArray[i].silent = false;
   }
 
   /* First time only configuration */
@@ -207,6 +208,9 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
   can_state_t state;
 
   if ((CANmodule != NULL) && (buffer != NULL)) {
+    if (buffer->silent) {
+      return CO_ERROR_NO;
+    }
     state = can_write(&CANmodule->driver.can, (struct can_frame*) buffer);
     if (state != CAN_OK) {;
       return CO_ERROR_TX_OVERFLOW;
@@ -218,6 +222,50 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
   return CO_ERROR_NO;
 }
 
+/******************************************************************************/
+void CO_CANtxBufferSetSilent(CO_CANtx_t *buffer, bool_t silent)
+{
+  if (buffer != NULL) {
+    buffer->silent = silent;
+  }
+}
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANrxBufferRemap(CO_CANmodule_t *CANmodule, uint16_t ident,
+    uint16_t newIdent)
+{
+  struct can_filter filter;
+  can_state_t state;
+  uint32_t i;
+
+  if (CANmodule == NULL) {
+    return CO_ERROR_ILLEGAL_ARGUMENT;
+  }
+
+  for (i = 0U; i < CANmodule->rxSize; i++) {
+    CO_CANrx_t *buffer = &CANmodule->rxArray[i];
+
+    if ((buffer->pFunct != NULL)
+        && ((buffer->ident & CAN_SFF_MASK) == (ident & CAN_SFF_MASK))) {
+      buffer->ident = (buffer->ident & ~CAN_SFF_MASK) | (newIdent & CAN_SFF_MASK);
+
+      if (CANmodule->useCANrxFilters) {
+        filter.can_id = buffer->ident;
+        filter.can_mask = buffer->mask;
+        state = can_ioctl(&CANmodule->driver.can, CAN_SET_FILTER, &filter);
+        if (state != CAN_OK) {
+          /* fall back to software filtering, see CO_CANrxBufferInit() */
+          (void)can_ioctl(&CANmodule->driver.can, CAN_SET_FILTER, NULL);
+          CANmodule->useCANrxFilters = false;
+        }
+      }
+      return CO_ERROR_NO;
+    }
+  }
+
+  return CO_ERROR_ILLEGAL_ARGUMENT;
+}
+
 /******************************************************************************/
 CO_ReturnError_t CO_CANCheckSend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
 {
@@ -179,6 +179,15 @@
     #define CO_UNLOCK_OD()      /**< Unock critical section when accessing Object Dictionary */
 /** @} */
 
+/**
+ * SDO buffer size for program download. Largest block of SDO block download
+ * (127 segments) fits into the buffer, so the image in 0x1F50 is passed to
+ * CO_program with one call per block, see CO_program.h.
+ */
+#ifndef CO_SDO_BUFFER_SIZE
+    #define CO_SDO_BUFFER_SIZE    889
+#endif
+
 /**
  * @name Syncronisation functions
  * syncronisation for message buffer for communication between CAN receive and
@@ -269,6 +278,8 @@ typedef struct{
     bool_t              bufferFull;     /**< True if previous message is still in buffer */
     /** Synchronous PDO messages has this flag set. It prevents them to be sent outside the synchronous window */
     bool_t              syncFlag;
+    /** Messages are not sent, see CO_CANtxBufferSetSilent() */
+    bool_t              silent;
 }CO_CANtx_t;
 
 
@@ -448,6 +459,36 @@ CO_CANtx_t *CO_CANtxBufferInit(
  */
 CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer);
 
+/**
+ * Enable or disable sending of a transmit buffer.
+ *
+ * CO_CANsend() drops messages of a silent buffer and returns CO_ERROR_NO. This
+ * is used for multicast program download: all nodes receive the same SDO
+ * download (see CO_CANrxBufferRemap()), only one of them responds, SDO server
+ * of the other nodes is set silent.
+ *
+ * @param buffer Pointer to transmit buffer, returned by CO_CANtxBufferInit().
+ * @param silent True, if messages must not be sent.
+ */
+void CO_CANtxBufferSetSilent(CO_CANtx_t *buffer, bool_t silent);
+
+/**
+ * Change CAN identifier of a configured receive buffer.
+ *
+ * Object and function of the buffer are kept, so for example the SDO server
+ * may be moved to a COB-ID, which is common to a group of nodes. Hardware
+ * filter for the new identifier is added. Original identifier is restored by
+ * the next communication reset.
+ *
+ * @param CANmodule This object.
+ * @param ident Current 11-bit CAN identifier of the buffer.
+ * @param newIdent New 11-bit CAN identifier.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT (no
+ * buffer with _ident_).
+ */
+CO_ReturnError_t CO_CANrxBufferRemap(CO_CANmodule_t *CANmodule, uint16_t ident, uint16_t newIdent);
+
 /**
  * maps directly to CO_CANsend()
  */
@@ -47,20 +47,9 @@
 #ifndef CO_CRC_H
 #define CO_CRC_H
 
-/**
- * Our own implementation of the CANopenNode CRC function
- *
- * @param block Pointer to block of data.
- * @param blockLength Length of data in bytes;
- * @param crc Initial value (zero for xmodem). If block is split into
- * multiple segments, previous CRC is used as initial.
- *
- * @return Calculated CRC.
- */
-unsigned short crc16_ccitt(
-        const unsigned char     block[],
-        unsigned int            blockLength,
-        unsigned short          crc);
+/* Our own implementation of the CANopenNode CRC function, see crc.c. The
+ * prototype is shared with the stack, project must define CO_USE_OWN_CRC16. */
+#include "crc16-ccitt.h"
 
 
 /** @} */
@@ -43,12 +43,20 @@
  * to do so, delete this exception statement from your version.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     /* for pthread_setaffinity_np() */
+#endif
 #include <sys/timerfd.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
 
 #include "CO_driver.h"
 #include "CANopen.h"
+#include "CO_Linux_threads.h"
+#include "CO_log.h"
 
 /* Helper function - get monotonic clock time in ms */
 static uint64_t CO_LinuxThreads_clock_gettime_ms(void)
@@ -59,40 +67,78 @@ static uint64_t CO_LinuxThreads_clock_gettime_ms(void)
   return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 }
 
+/* Helper function - get monotonic clock time in ns */
+static uint64_t CO_LinuxThreads_clock_gettime_ns(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
 /* Mainline thread (threadMain) ***************************************************/
 static struct
 {
   uint64_t  start;                  /* time value CO_process() was called last time in ms */
+  uint64_t  deadline;               /* time value CO_process() must be called next time in ms */
   void    (*pFunct)(void* object);  /* Callback function */
   void     *object;
-} threadMain;
+  pthread_mutex_t mutex;            /* protects pending */
+  pthread_cond_t  cond;             /* signals pending to threadMain_wait() */
+  bool_t    pending;                /* event happened since last threadMain_process() */
+} threadMain = {
+  .mutex = PTHREAD_MUTEX_INITIALIZER
+};
 
 /**
  * This function notifies the user application after an event happened
  *
  * This is necessary because not all stack callbacks support object pointers.
- * It is not used for those callbacks that have this pointer!
+ * It also wakes up threadMain_wait().
  */
 static void threadMain_resumeCallback(void)
 {
+  pthread_mutex_lock(&threadMain.mutex);
+  threadMain.pending = true;
+  pthread_cond_signal(&threadMain.cond);
+  pthread_mutex_unlock(&threadMain.mutex);
+
   if (threadMain.pFunct != NULL) {
     threadMain.pFunct(threadMain.object);
   }
 }
 
+#if (CO_NO_LSS_CLIENT == 1) || (CO_DAISY_CONSUMER == 1)
+/* Same for callbacks with object pointer */
+static void threadMain_resumeCallbackObject(void *object)
+{
+  (void)object;
+  threadMain_resumeCallback();
+}
+#endif
+
 void threadMain_init(void (*callback)(void*), void *object)
 {
+  pthread_condattr_t attr;
+
   threadMain.start = CO_LinuxThreads_clock_gettime_ms();
+  threadMain.deadline = threadMain.start;
   threadMain.pFunct = callback;
   threadMain.object = object;
+  threadMain.pending = false;
+
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&threadMain.cond, &attr);
+  pthread_condattr_destroy(&attr);
 
   CO_SDO_initCallback(CO->SDO[0], threadMain_resumeCallback);
   CO_EM_initCallback(CO->em, threadMain_resumeCallback);
 #if CO_NO_LSS_CLIENT == 1
-  CO_LSSmaster_initCallback(CO->LSSmaster, threadMain.object, threadMain.pFunct);
+  CO_LSSmaster_initCallback(CO->LSSmaster, NULL, threadMain_resumeCallbackObject);
 #endif
 #if CO_DAISY_CONSUMER == 1
-  CO_DaisyConsumer_initCallback(CO->DaisyConsumer, threadMain.object, threadMain.pFunct);
+  CO_DaisyConsumer_initCallback(CO->DaisyConsumer, NULL, threadMain_resumeCallbackObject);
 #endif
 #if CO_NO_SDO_CLIENT != 0
   for (int i = 0; i < CO_NO_SDO_CLIENT; i++) {
@@ -105,47 +151,112 @@ void threadMain_close(void)
 {
   threadMain.pFunct = NULL;
   threadMain.object = NULL;
+  pthread_cond_destroy(&threadMain.cond);
 }
 
 void threadMain_process(CO_NMT_reset_cmd_t *reset)
 {
-  uint16_t finished;
+  uint16_t timerNext;
   uint16_t diff;
   uint64_t now;
 
+  pthread_mutex_lock(&threadMain.mutex);
+  threadMain.pending = false;
+  pthread_mutex_unlock(&threadMain.mutex);
+
   now = CO_LinuxThreads_clock_gettime_ms();
   diff = (uint16_t)(now - threadMain.start);
 
-  /* we use timerNext_ms in CO_process() as indication if processing is
-   * finished. We ignore any calculated values for maximum delay times. */
+  /* CO_process() lowers timerNext to the next deadline of the stack. Zero
+   * means there is more work to do immediately. */
   do {
-    finished = 1;
-    *reset = CO_process(CO, diff, &finished);
+    timerNext = CO_LINUX_THREADS_MAIN_MAX_MS;
+    *reset = CO_process(CO, diff, &timerNext);
     diff = 0;
-  } while ((*reset == CO_RESET_NOT) && (finished == 0));
+  } while ((*reset == CO_RESET_NOT) && (timerNext == 0));
+
+  /* driver errors from the realtime threads */
+  (void)CO_log_process();
 
   /* prepare next call */
   threadMain.start = now;
+  threadMain.deadline = now + timerNext;
+}
+
+void threadMain_wait(uint32_t max_ms)
+{
+  struct timespec ts;
+  uint64_t deadline;
+
+  deadline = CO_LinuxThreads_clock_gettime_ms() + max_ms;
+  if (deadline > threadMain.deadline) {
+    deadline = threadMain.deadline;
+  }
+  ts.tv_sec = deadline / 1000;
+  ts.tv_nsec = (deadline % 1000) * 1000000;
+
+  pthread_mutex_lock(&threadMain.mutex);
+  while (!threadMain.pending) {
+    if (pthread_cond_timedwait(&threadMain.cond, &threadMain.mutex, &ts) != 0) {
+      break;
+    }
+  }
+  pthread_mutex_unlock(&threadMain.mutex);
 }
 
 /* Realtime thread (threadRT) *****************************************************/
 static struct {
   uint32_t us_interval;         /* configured interval in us */
   int interval_fd;              /* timer fd */
+  uint64_t deadline;            /* absolute time of next timer expiration in ns */
+  CO_LinuxThreads_jitter_t jitter;  /* jitter statistics, protected by CO_LOCK_OD() */
 } threadRT;
 
+/* Helper function - add jitter value in us to statistics */
+static void CANrx_threadTmr_addJitter(uint32_t us_jitter, uint32_t overruns)
+{
+  uint32_t bin;
+  CO_LinuxThreads_jitter_t *jitter = &threadRT.jitter;
+
+  if ((jitter->count == 0) || (us_jitter < jitter->min)) {
+    jitter->min = us_jitter;
+  }
+  if (us_jitter > jitter->max) {
+    jitter->max = us_jitter;
+  }
+  jitter->sum += us_jitter;
+  jitter->count++;
+  jitter->overruns += overruns;
+
+  bin = us_jitter / CO_LINUX_THREADS_JITTER_BIN_US;
+  if (bin >= CO_LINUX_THREADS_JITTER_BINS) {
+    bin = CO_LINUX_THREADS_JITTER_BINS - 1;
+  }
+  jitter->histogram[bin]++;
+}
+
 void CANrx_threadTmr_init(uint16_t interval)
+{
+  CANrx_threadTmr_init_us((uint32_t)interval * 1000);
+}
+
+void CANrx_threadTmr_init_us(uint32_t us_interval)
 {
   struct itimerspec itval;
 
-  threadRT.us_interval = interval * 1000;
-  /* set up non-blocking interval timer */
+  threadRT.us_interval = us_interval;
+  CANrx_threadTmr_resetJitter();
+  /* set up non-blocking interval timer. The first expiration is set as
+   * absolute time, so we know each following deadline exactly */
   threadRT.interval_fd = timerfd_create(CLOCK_MONOTONIC, 0);
   (void)fcntl(threadRT.interval_fd, F_SETFL, O_NONBLOCK);
-  itval.it_interval.tv_sec = 0;
-  itval.it_interval.tv_nsec = interval * 1000000;
-  itval.it_value = itval.it_interval;
-  (void)timerfd_settime(threadRT.interval_fd, 0, &itval, NULL);
+  threadRT.deadline = CO_LinuxThreads_clock_gettime_ns() +
+                      (uint64_t)us_interval * 1000;
+  itval.it_interval.tv_sec = us_interval / 1000000;
+  itval.it_interval.tv_nsec = (us_interval % 1000000) * 1000;
+  itval.it_value.tv_sec = threadRT.deadline / 1000000000;
+  itval.it_value.tv_nsec = threadRT.deadline % 1000000000;
+  (void)timerfd_settime(threadRT.interval_fd, TFD_TIMER_ABSTIME, &itval, NULL);
 }
 
 void CANrx_threadTmr_close(void)
@@ -154,28 +265,174 @@ void CANrx_threadTmr_close(void)
   threadRT.interval_fd = -1;
 }
 
+CO_ReturnError_t CANrx_threadTmr_setRealtime(int priority, int cpu)
+{
+  struct sched_param param;
+  cpu_set_t cpuset;
+
+  if (priority > 0) {
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+      return CO_ERROR_SYSCALL;
+    }
+  }
+  if (cpu >= 0) {
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) != 0) {
+      return CO_ERROR_SYSCALL;
+    }
+  }
+  return CO_ERROR_NO;
+}
+
+void CANrx_threadTmr_getJitter(CO_LinuxThreads_jitter_t *jitter)
+{
+  CO_LOCK_OD();
+  *jitter = threadRT.jitter;
+  CO_UNLOCK_OD();
+}
+
+void CANrx_threadTmr_resetJitter(void)
+{
+  CO_LOCK_OD();
+  memset(&threadRT.jitter, 0, sizeof(threadRT.jitter));
+  CO_UNLOCK_OD();
+}
+
+CO_SDO_abortCode_t CANrx_threadTmr_ODF_jitter(CO_ODF_arg_t *ODF_arg)
+{
+  uint32_t value;
+  CO_LinuxThreads_jitter_t *jitter = &threadRT.jitter;
+
+  if (ODF_arg->subIndex == 0) {
+    return CO_SDO_AB_NONE;
+  }
+
+  if (!ODF_arg->reading) {
+    /* any write resets statistics. OD_lock is already held by SDO server */
+    memset(jitter, 0, sizeof(*jitter));
+    return CO_SDO_AB_NONE;
+  }
+
+  switch (ODF_arg->subIndex) {
+    case 1:
+      value = jitter->min;
+      break;
+    case 2:
+      value = (jitter->count > 0) ? (uint32_t)(jitter->sum / jitter->count) : 0;
+      break;
+    case 3:
+      value = jitter->max;
+      break;
+    case 4:
+      value = jitter->count;
+      break;
+    case 5:
+      value = jitter->overruns;
+      break;
+    default:
+      if (ODF_arg->subIndex >= 6 + CO_LINUX_THREADS_JITTER_BINS) {
+        return CO_SDO_AB_SUB_UNKNOWN;
+      }
+      value = jitter->histogram[ODF_arg->subIndex - 6];
+      break;
+  }
+  CO_setUint32(ODF_arg->data, value);
+
+  return CO_SDO_AB_NONE;
+}
+
+CO_SDO_abortCode_t CANrx_ODF_rxDrops(CO_ODF_arg_t *ODF_arg)
+{
+  CO_CANmodule_t *CANmodule = (CO_CANmodule_t *)ODF_arg->object;
+  const CO_CANinterface_t *interface;
+  uint32_t index;
+  uint32_t value;
+  uint32_t i;
+
+  if (ODF_arg->subIndex == 0) {
+    return CO_SDO_AB_NONE;
+  }
+
+  if (!ODF_arg->reading) {
+    /* any write resets statistics, counters are only incremented by rx */
+    for (i = 0; i < CANmodule->CANinterfaceCount; i++) {
+      CANmodule->CANinterfaces[i].rxDropCount = 0;
+      CANmodule->CANinterfaces[i].rxFrameCount = 0;
+    }
+    return CO_SDO_AB_NONE;
+  }
+
+  index = (ODF_arg->subIndex - 1U) / 4U;
+  if (index >= CANmodule->CANinterfaceCount) {
+    return CO_SDO_AB_SUB_UNKNOWN;
+  }
+  interface = &CANmodule->CANinterfaces[index];
+
+  switch ((ODF_arg->subIndex - 1U) % 4U) {
+    case 0:
+      value = interface->rxDropCount;
+      break;
+    case 1: {
+      uint64_t total = (uint64_t)interface->rxDropCount + interface->rxFrameCount;
+
+      value = (total > 0) ? (uint32_t)((uint64_t)interface->rxDropCount * 1000U / total) : 0;
+      break;
+    }
+    case 2:
+      value = (uint32_t)interface->rcvbuf;
+      break;
+    default:
+      value = (uint32_t)interface->sndbuf;
+      break;
+  }
+  CO_setUint32(ODF_arg->data, value);
+
+  return CO_SDO_AB_NONE;
+}
+
+
 void CANrx_threadTmr_process(void)
 {
   int32_t result;
   int32_t i;
   bool_t syncWas;
   unsigned long long missed;
+  uint64_t now;
+  uint64_t late;
 
   result = CO_CANrxWait(CO->CANmodule[0], threadRT.interval_fd, NULL);
   if (result < 0) {
     result = read(threadRT.interval_fd, &missed, sizeof(missed));
     if (result > 0) {
-      /* at least one timer interval occured */
+      /* at least one timer interval occured. Jitter is measured against the
+       * last deadline that expired */
+      now = CO_LinuxThreads_clock_gettime_ns();
+      threadRT.deadline += (missed - 1) * threadRT.us_interval * 1000ULL;
+      late = (now > threadRT.deadline) ? (now - threadRT.deadline) / 1000 : 0;
+      threadRT.deadline += threadRT.us_interval * 1000ULL;
+
       CO_LOCK_OD();
 
+      CANrx_threadTmr_addJitter((late > UINT32_MAX) ? UINT32_MAX : (uint32_t)late,
+                                (uint32_t)(missed - 1));
+
       if(CO->CANmodule[0]->CANnormal == true) {
 
-        for (i = 0; i <= missed; i++) {
+        /* catch up all missed intervals */
+        for (i = 0; i < missed; i++) {
+          /* collect all messages from this cycle, send them at once */
+          CO_CANtxBatchStart(CO->CANmodule[0]);
+
           /* Process Sync and read inputs */
           syncWas = CO_process_SYNC_RPDO(CO, threadRT.us_interval);
 
           /* Write outputs */
           CO_process_TPDO(CO, syncWas, threadRT.us_interval);
+
+          (void)CO_CANtxBatchFlush(CO->CANmodule[0]);
         }
       }
 
@@ -183,3 +440,18 @@ void CANrx_threadTmr_process(void)
     }
   }
 }
+
+#ifdef CO_DRIVER_MULTI_INTERFACE
+/* Interface rx threads ***********************************************************/
+CO_ReturnError_t CANrx_threadInterface_init(CO_CANrxThread_t *rxThread,
+                                            int32_t CANbaseAddress)
+{
+  return CO_CANrxThread_init(CO->CANmodule[0], rxThread, CANbaseAddress);
+}
+
+void CANrx_threadInterface_process(CO_CANrxThread_t *rxThread)
+{
+  /* messages are evaluated inside rxWait() */
+  (void)CO_CANrxWaitThread(CO->CANmodule[0], rxThread, -1, NULL);
+}
+#endif
@@ -57,12 +57,21 @@ extern "C" {
  * Like the CO socketCAN driver implementation, this driver uses the global CO
  * object and has one thread-local struct for variables. */
 
+/**
+ * Longest time threadMain_process() lets the mainline thread sleep in ms, if
+ * no stack service has an earlier deadline.
+ */
+#ifndef CO_LINUX_THREADS_MAIN_MAX_MS
+#define CO_LINUX_THREADS_MAIN_MAX_MS    1000
+#endif
+
 /**
  * Initialize mainline thread.
  *
  * threadMain is non-realtime thread for CANopenNode processing. It is nonblocking
- * and should be called cyclically in 50 ms intervals or less if necessary. This
- * is indicated by the callback function.
+ * and must be called again when the deadline reported by CO_process() expires
+ * or after an event is indicated by the callback function. threadMain_wait()
+ * sleeps exactly until then, so no fixed polling interval is required.
  * This thread processes CO_process() function from CANopen.c file.
  *
  * @param callback this function is called to indicate #threadMain_process() has
@@ -85,6 +94,49 @@ extern void threadMain_close(void);
  */
 extern void threadMain_process(CO_NMT_reset_cmd_t *reset);
 
+/**
+ * Wait for mainline thread.
+ *
+ * Blocks until the next deadline reported by CO_process(), until an event is
+ * signalled from the stack callbacks or until max_ms expired, whichever comes
+ * first. Application events which are not signalled by the stack must be
+ * covered by max_ms.
+ *
+ * @param max_ms maximum time to wait in ms.
+ */
+extern void threadMain_wait(uint32_t max_ms);
+
+/**
+ * Number of histogram bins for SYNC jitter statistics. The last bin collects
+ * all values above.
+ */
+#ifndef CO_LINUX_THREADS_JITTER_BINS
+#define CO_LINUX_THREADS_JITTER_BINS    8
+#endif
+
+/**
+ * Width of one histogram bin for SYNC jitter statistics in us.
+ */
+#ifndef CO_LINUX_THREADS_JITTER_BIN_US
+#define CO_LINUX_THREADS_JITTER_BIN_US  50
+#endif
+
+/**
+ * Jitter statistics of realtime thread.
+ *
+ * Jitter is the time from the absolute timer deadline until the realtime thread
+ * starts processing that interval. Values are in us.
+ */
+typedef struct {
+    uint32_t    min;            /**< Minimum jitter */
+    uint32_t    max;            /**< Maximum jitter */
+    uint64_t    sum;            /**< Sum of all jitter values, for average */
+    uint32_t    count;          /**< Number of processed intervals */
+    uint32_t    overruns;       /**< Number of intervals caught up late */
+    /** Histogram, bin n counts values from n * CO_LINUX_THREADS_JITTER_BIN_US */
+    uint32_t    histogram[CO_LINUX_THREADS_JITTER_BINS];
+} CO_LinuxThreads_jitter_t;
+
 /**
  * Initialize realtime thread.
  *
@@ -102,6 +154,67 @@ extern void threadMain_process(CO_NMT_reset_cmd_t *reset);
  */
 extern void CANrx_threadTmr_init(uint16_t interval);
 
+/**
+ * Initialize realtime thread with interval in us.
+ *
+ * Same as CANrx_threadTmr_init(). The timer runs on absolute CLOCK_MONOTONIC
+ * deadlines, so the interval does not drift. Intervals that were missed are
+ * caught up inside the next CANrx_threadTmr_process() call.
+ *
+ * @param us_interval Interval of periodic timer in us.
+ */
+extern void CANrx_threadTmr_init_us(uint32_t us_interval);
+
+/**
+ * Configure realtime scheduling for realtime thread.
+ *
+ * Function must be called from the thread which calls
+ * CANrx_threadTmr_process().
+ *
+ * @param priority SCHED_FIFO priority, 0 keeps current scheduling policy.
+ * @param cpu CPU the thread is pinned to, -1 keeps current affinity.
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_SYSCALL.
+ */
+extern CO_ReturnError_t CANrx_threadTmr_setRealtime(int priority, int cpu);
+
+/**
+ * Get jitter statistics of realtime thread.
+ *
+ * @param [out] jitter copy of statistics.
+ */
+extern void CANrx_threadTmr_getJitter(CO_LinuxThreads_jitter_t *jitter);
+
+/**
+ * Reset jitter statistics of realtime thread.
+ */
+extern void CANrx_threadTmr_resetJitter(void);
+
+/**
+ * Function for accessing jitter statistics by SDO.
+ *
+ * Register with CO_OD_configure() for an UNSIGNED32 array entry, e.g. right
+ * after the CAN runtime info. Subindex 1: min, 2: average, 3: max jitter in us,
+ * 4: number of intervals, 5: overruns, 6 and following: histogram bins. Writing
+ * any subindex resets the statistics.
+ *
+ * For more information see file CO_SDO.h.
+ */
+extern CO_SDO_abortCode_t CANrx_threadTmr_ODF_jitter(CO_ODF_arg_t *ODF_arg);
+
+/**
+ * Function for accessing rx drop statistics of the CAN interfaces by SDO.
+ *
+ * Register with CO_OD_configure() for an UNSIGNED32 array entry, object
+ * argument must be the CAN module. Four subindexes per interface, in the order
+ * the interfaces were added: messages dropped on the rx socket queue, drop
+ * rate in per mille of the messages on the socket, SO_RCVBUF and SO_SNDBUF in
+ * bytes, see CO_CANmodule_setBufferTuning(). Writing any subindex resets the
+ * drop statistics.
+ *
+ * For more information see file CO_SDO.h.
+ */
+extern CO_SDO_abortCode_t CANrx_ODF_rxDrops(CO_ODF_arg_t *ODF_arg);
+
 /**
  * Terminate realtime thread.
  */
@@ -115,6 +228,37 @@ extern void CANrx_threadTmr_close(void);
  */
 extern void CANrx_threadTmr_process();
 
+#ifdef CO_DRIVER_MULTI_INTERFACE
+/**
+ * Initialize interface rx thread.
+ *
+ * Moves one CAN interface to its own rx thread, so each interface can be
+ * received by a separate thread (e.g. pinned to its own CPU by
+ * CANrx_threadTmr_setRealtime()). Received messages are evaluated by the
+ * callbacks set with CO_CANrxBufferInit(), SYNC/PDO processing is still done
+ * by the realtime thread and the mainline thread is shared.
+ *
+ * Must be called after CO_CANmodule_addInterface() and before
+ * CO_CANsetNormalMode().
+ *
+ * @param rxThread rx thread object, see CO_CANrxThread_init().
+ * @param CANbaseAddress CAN interface to be moved.
+ * @return #CO_ReturnError_t: see CO_CANrxThread_init().
+ */
+extern CO_ReturnError_t CANrx_threadInterface_init(CO_CANrxThread_t *rxThread,
+                                                   int32_t CANbaseAddress);
+
+/**
+ * Process interface rx thread.
+ *
+ * This function must be called inside an infinite loop. It blocks until
+ * messages are received on the interface or CO_CANmodule_disable() is called.
+ *
+ * @param rxThread rx thread object from CANrx_threadInterface_init().
+ */
+extern void CANrx_threadInterface_process(CO_CANrxThread_t *rxThread);
+#endif
+
 #ifdef __cplusplus
 }
 #endif /*__cplusplus*/
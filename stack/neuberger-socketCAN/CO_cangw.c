@@ -0,0 +1,519 @@
+/*
+ * Kernel CAN gateway (can-gw) rules for Linux socketCAN.
+ *
+ * @file        CO_cangw.c
+ * @ingroup     CO_driver
+ * @copyright   2019 Neuberger Gebaeudeautomation GmbH
+ *
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/can/gw.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#include "CO_cangw.h"
+
+
+/* can-gw request, attributes are 4 byte aligned */
+struct CO_CANgwRequest {
+    struct nlmsghdr     nh;
+    struct rtcanmsg     rtcan;
+    char                attr[128];
+};
+
+/* One kernel job: identifier and mask of a block of the range */
+struct CO_CANgwJob {
+    struct can_filter   filter;
+    uint32_t            uid;
+};
+
+
+/*
+ * Split COB ID range into naturally aligned blocks, one can_filter each.
+ *
+ * @return Number of jobs.
+ */
+static uint8_t CO_CANgw_jobs(
+        const CO_CANgw_t       *gw,
+        int32_t                 rule,
+        uint16_t                first,
+        uint16_t                last,
+        struct CO_CANgwJob      jobs[CO_CANGW_JOBS_MAX])
+{
+    uint32_t ident = first;
+    uint8_t count = 0;
+
+    while (ident <= last && count < CO_CANGW_JOBS_MAX) {
+        uint32_t size = 1;
+
+        /* largest block, which starts at ident and ends not after last */
+        while ((ident & size) == 0 && size < (CAN_SFF_MASK + 1) &&
+               (ident + size * 2 - 1) <= last) {
+            size *= 2;
+        }
+        jobs[count].filter.can_id = ident;
+        jobs[count].filter.can_mask = CAN_EFF_FLAG | (CAN_SFF_MASK & ~(size - 1));
+        jobs[count].uid = gw->uidBase + (uint32_t)rule * CO_CANGW_JOBS_MAX + count;
+        ident += size;
+        count ++;
+    }
+
+    return count;
+}
+
+
+static void CO_CANgw_addAttr(
+        struct CO_CANgwRequest *req,
+        uint16_t                type,
+        const void             *data,
+        uint16_t                length)
+{
+    struct rtattr *rta = (struct rtattr *)(((char *)req) + NLMSG_ALIGN(req->nh.nlmsg_len));
+
+    rta->rta_type = type;
+    rta->rta_len = RTA_LENGTH(length);
+    memcpy(RTA_DATA(rta), data, length);
+    req->nh.nlmsg_len = NLMSG_ALIGN(req->nh.nlmsg_len) + RTA_ALIGN(rta->rta_len);
+}
+
+
+/*
+ * Send request and wait for the acknowledge of the kernel.
+ *
+ * @return 0 or negative errno.
+ */
+static int CO_CANgw_request(CO_CANgw_t *gw, struct CO_CANgwRequest *req)
+{
+    char buf[256] __attribute__((aligned(NLMSG_ALIGNTO)));
+    ssize_t n;
+
+    req->nh.nlmsg_flags |= NLM_F_REQUEST | NLM_F_ACK;
+    req->nh.nlmsg_seq = ++gw->seq;
+    if (send(gw->fd, req, req->nh.nlmsg_len, 0) < 0) {
+        return -errno;
+    }
+
+    for (;;) {
+        struct nlmsghdr *nh;
+
+        n = recv(gw->fd, buf, sizeof(buf), 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        for (nh = (struct nlmsghdr *)buf; NLMSG_OK(nh, (size_t)n); nh = NLMSG_NEXT(nh, n)) {
+            if (nh->nlmsg_seq == gw->seq && nh->nlmsg_type == NLMSG_ERROR) {
+                return ((struct nlmsgerr *)NLMSG_DATA(nh))->error;
+            }
+        }
+    }
+}
+
+
+/*
+ * Install or remove one kernel job. Remove must repeat all attributes of the
+ * job, can-gw compares them.
+ */
+static int CO_CANgw_job(
+        CO_CANgw_t             *gw,
+        const CO_CANgwRule_t   *rule,
+        const struct CO_CANgwJob *job,
+        uint16_t                type)
+{
+    struct CO_CANgwRequest req;
+    uint32_t srcIf = (uint32_t)rule->srcBaseAddress;
+    uint32_t dstIf = (uint32_t)rule->dstBaseAddress;
+
+    memset(&req, 0, sizeof(req));
+    req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtcanmsg));
+    req.nh.nlmsg_type = type;
+    if (type == RTM_NEWROUTE) {
+        req.nh.nlmsg_flags = NLM_F_CREATE | NLM_F_EXCL;
+    }
+    req.rtcan.can_family = AF_CAN;
+    req.rtcan.gwtype = CGW_TYPE_CAN_CAN;
+    req.rtcan.flags = rule->flags;
+
+    CO_CANgw_addAttr(&req, CGW_SRC_IF, &srcIf, sizeof(srcIf));
+    CO_CANgw_addAttr(&req, CGW_DST_IF, &dstIf, sizeof(dstIf));
+    CO_CANgw_addAttr(&req, CGW_FILTER, &job->filter, sizeof(job->filter));
+    CO_CANgw_addAttr(&req, CGW_MOD_UID, &job->uid, sizeof(job->uid));
+    if (rule->hops != 0) {
+        CO_CANgw_addAttr(&req, CGW_LIM_HOPS, &rule->hops, sizeof(rule->hops));
+    }
+
+    return CO_CANgw_request(gw, &req);
+}
+
+
+/*
+ * Install jobs of a rule. Already installed jobs are removed, if one fails.
+ */
+static CO_ReturnError_t CO_CANgw_install(CO_CANgw_t *gw, int32_t rule)
+{
+    CO_CANgwRule_t *r = &gw->rules[rule];
+    struct CO_CANgwJob jobs[CO_CANGW_JOBS_MAX];
+    uint8_t count;
+    uint8_t i;
+    int err = 0;
+
+    count = CO_CANgw_jobs(gw, rule, r->first, r->last, jobs);
+    for (i = 0; i < count; i++) {
+        err = CO_CANgw_job(gw, r, &jobs[i], RTM_NEWROUTE);
+        if (err != 0) {
+            break;
+        }
+    }
+    if (err != 0) {
+        while (i > 0) {
+            i--;
+            (void)CO_CANgw_job(gw, r, &jobs[i], RTM_DELROUTE);
+        }
+        r->jobCount = 0;
+        errno = -err;
+        return CO_ERROR_SYSCALL;
+    }
+    r->jobCount = count;
+
+    return CO_ERROR_NO;
+}
+
+
+/*
+ * Remove all jobs of a rule from the kernel.
+ */
+static CO_ReturnError_t CO_CANgw_uninstall(CO_CANgw_t *gw, int32_t rule)
+{
+    CO_CANgwRule_t *r = &gw->rules[rule];
+    struct CO_CANgwJob jobs[CO_CANGW_JOBS_MAX];
+    uint8_t i;
+    int err = 0;
+
+    (void)CO_CANgw_jobs(gw, rule, r->first, r->last, jobs);
+    for (i = 0; i < r->jobCount; i++) {
+        int ret = CO_CANgw_job(gw, r, &jobs[i], RTM_DELROUTE);
+
+        if (ret != 0 && err == 0) {
+            err = ret;
+        }
+    }
+    r->jobCount = 0;
+    if (err != 0) {
+        errno = -err;
+        return CO_ERROR_SYSCALL;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+static bool_t CO_CANgw_ruleIsValid(const CO_CANgw_t *gw, int32_t rule)
+{
+    return gw != NULL && gw->fd >= 0 && rule >= 0 && rule < gw->rulesSize &&
+           gw->rules[rule].srcBaseAddress != 0;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANgw_init(CO_CANgw_t *gw, CO_CANmodule_t *CANmodule,
+                               CO_CANgwRule_t rules[], uint16_t rulesSize)
+{
+    struct sockaddr_nl addr;
+
+    if (gw == NULL || CANmodule == NULL || rules == NULL || rulesSize == 0 ||
+        (uint32_t)rulesSize * CO_CANGW_JOBS_MAX > 0xFFFFU) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    gw->CANmodule = CANmodule;
+    gw->rules = rules;
+    gw->rulesSize = rulesSize;
+    gw->seq = 0;
+    /* unique per process, upper half of the uid is the pid */
+    gw->uidBase = ((uint32_t)getpid() << 16) | 1U;
+    memset(rules, 0, sizeof(CO_CANgwRule_t) * rulesSize);
+
+    gw->fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (gw->fd < 0) {
+        return CO_ERROR_SYSCALL;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    if (bind(gw->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(gw->fd);
+        gw->fd = -1;
+        return CO_ERROR_SYSCALL;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+int32_t CO_CANgw_add(CO_CANgw_t *gw, int32_t srcBaseAddress, int32_t dstBaseAddress,
+                     uint16_t first, uint16_t last, uint16_t flags, uint8_t hops)
+{
+    CO_CANgwRule_t *r;
+    bool_t srcFound = false;
+    bool_t dstFound = false;
+    int32_t rule;
+    uint32_t i;
+    CO_ReturnError_t ret;
+
+    if (gw == NULL || gw->fd < 0 || srcBaseAddress <= 0 ||
+        srcBaseAddress == dstBaseAddress || first > last || last > CAN_SFF_MASK) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    for (i = 0; i < gw->CANmodule->CANinterfaceCount; i++) {
+        int32_t base = gw->CANmodule->CANinterfaces[i].CANbaseAddress;
+
+        srcFound = srcFound || base == srcBaseAddress;
+        dstFound = dstFound || base == dstBaseAddress;
+    }
+    if (!srcFound || !dstFound) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    for (rule = 0; rule < gw->rulesSize; rule++) {
+        if (gw->rules[rule].srcBaseAddress == 0) {
+            break;
+        }
+    }
+    if (rule == gw->rulesSize) {
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+
+    r = &gw->rules[rule];
+    memset(r, 0, sizeof(*r));
+    r->srcBaseAddress = srcBaseAddress;
+    r->dstBaseAddress = dstBaseAddress;
+    r->first = first;
+    r->last = last;
+    r->flags = flags;
+#ifdef CO_DRIVER_CAN_FD
+    r->flags |= CGW_FLAGS_CAN_FD;
+#endif
+    r->hops = hops;
+
+    ret = CO_CANgw_install(gw, rule);
+    if (ret != CO_ERROR_NO) {
+        r->srcBaseAddress = 0;
+        return ret;
+    }
+
+    return rule;
+}
+
+
+/*
+ * Read counters of the installed jobs of a rule from the kernel list.
+ */
+static CO_ReturnError_t CO_CANgw_readJobs(
+        CO_CANgw_t             *gw,
+        int32_t                 rule,
+        CO_CANgwCounters_t     *counters)
+{
+    struct CO_CANgwRequest req;
+    uint32_t uidFirst = gw->uidBase + (uint32_t)rule * CO_CANGW_JOBS_MAX;
+    uint32_t uidEnd = uidFirst + gw->rules[rule].jobCount;
+    char buf[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+
+    memset(counters, 0, sizeof(*counters));
+
+    memset(&req, 0, sizeof(req));
+    req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtcanmsg));
+    req.nh.nlmsg_type = RTM_GETROUTE;
+    req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nh.nlmsg_seq = ++gw->seq;
+    req.rtcan.can_family = AF_CAN;
+    if (send(gw->fd, &req, req.nh.nlmsg_len, 0) < 0) {
+        return CO_ERROR_SYSCALL;
+    }
+
+    /* dump is terminated by NLMSG_DONE or by an error */
+    for (;;) {
+        struct nlmsghdr *nh;
+        ssize_t n = recv(gw->fd, buf, sizeof(buf), 0);
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return CO_ERROR_SYSCALL;
+        }
+        for (nh = (struct nlmsghdr *)buf; NLMSG_OK(nh, (size_t)n); nh = NLMSG_NEXT(nh, n)) {
+            CO_CANgwCounters_t job = {0, 0, 0};
+            uint32_t uid = 0;
+            struct rtattr *rta;
+            int len;
+
+            if (nh->nlmsg_seq != gw->seq) {
+                continue;
+            }
+            if (nh->nlmsg_type == NLMSG_DONE) {
+                return CO_ERROR_NO;
+            }
+            if (nh->nlmsg_type == NLMSG_ERROR) {
+                errno = -((struct nlmsgerr *)NLMSG_DATA(nh))->error;
+                return CO_ERROR_SYSCALL;
+            }
+            if (nh->nlmsg_type != RTM_NEWROUTE) {
+                continue;
+            }
+
+            rta = (struct rtattr *)(((char *)NLMSG_DATA(nh)) + NLMSG_ALIGN(sizeof(struct rtcanmsg)));
+            len = (int)NLMSG_PAYLOAD(nh, sizeof(struct rtcanmsg));
+            for (; RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+                uint32_t value;
+
+                if (RTA_PAYLOAD(rta) < sizeof(value)) {
+                    continue;
+                }
+                memcpy(&value, RTA_DATA(rta), sizeof(value));
+                switch (rta->rta_type) {
+                    case CGW_MOD_UID: uid = value; break;
+                    case CGW_HANDLED: job.handled = value; break;
+                    case CGW_DROPPED: job.dropped = value; break;
+                    case CGW_DELETED: job.deleted = value; break;
+                    default: break;
+                }
+            }
+            if (uid >= uidFirst && uid < uidEnd) {
+                counters->handled += job.handled;
+                counters->dropped += job.dropped;
+                counters->deleted += job.deleted;
+            }
+        }
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANgw_update(CO_CANgw_t *gw, int32_t rule,
+                                 uint16_t first, uint16_t last)
+{
+    CO_CANgwRule_t *r;
+    CO_CANgwCounters_t counters;
+    CO_ReturnError_t ret;
+
+    if (!CO_CANgw_ruleIsValid(gw, rule) || first > last || last > CAN_SFF_MASK) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    r = &gw->rules[rule];
+    if (r->first == first && r->last == last && r->jobCount != 0) {
+        return CO_ERROR_NO;
+    }
+
+    /* counters of the kernel jobs are lost with them */
+    if (CO_CANgw_readJobs(gw, rule, &counters) == CO_ERROR_NO) {
+        r->removed.handled += counters.handled;
+        r->removed.dropped += counters.dropped;
+        r->removed.deleted += counters.deleted;
+    }
+    ret = CO_CANgw_uninstall(gw, rule);
+    if (ret != CO_ERROR_NO) {
+        return ret;
+    }
+    r->first = first;
+    r->last = last;
+
+    return CO_CANgw_install(gw, rule);
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANgw_remove(CO_CANgw_t *gw, int32_t rule)
+{
+    CO_ReturnError_t ret;
+
+    if (!CO_CANgw_ruleIsValid(gw, rule)) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    ret = CO_CANgw_uninstall(gw, rule);
+    gw->rules[rule].srcBaseAddress = 0;
+
+    return ret;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANgw_getCounters(CO_CANgw_t *gw, int32_t rule,
+                                      CO_CANgwCounters_t *counters)
+{
+    CO_ReturnError_t ret;
+    const CO_CANgwRule_t *r;
+
+    if (!CO_CANgw_ruleIsValid(gw, rule) || counters == NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    ret = CO_CANgw_readJobs(gw, rule, counters);
+    if (ret != CO_ERROR_NO) {
+        return ret;
+    }
+    r = &gw->rules[rule];
+    counters->handled += r->removed.handled;
+    counters->dropped += r->removed.dropped;
+    counters->deleted += r->removed.deleted;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_CANgw_close(CO_CANgw_t *gw)
+{
+    int32_t rule;
+
+    if (gw == NULL || gw->fd < 0) {
+        return;
+    }
+    for (rule = 0; rule < gw->rulesSize; rule++) {
+        if (gw->rules[rule].srcBaseAddress != 0) {
+            (void)CO_CANgw_remove(gw, rule);
+        }
+    }
+    close(gw->fd);
+    gw->fd = -1;
+}
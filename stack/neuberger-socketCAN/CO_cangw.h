@@ -0,0 +1,213 @@
+/**
+ * Kernel CAN gateway (can-gw) rules for Linux socketCAN.
+ *
+ * @file        CO_cangw.h
+ * @ingroup     CO_driver
+ * @copyright   2019 Neuberger Gebaeudeautomation GmbH
+ *
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+#ifndef CO_CANGW_H_
+#define CO_CANGW_H_
+
+#include "CO_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_cangw Kernel gateway
+ * @ingroup CO_driver
+ * @{
+ *
+ * Forwarding of CAN frames between the interfaces of a CAN module inside the
+ * kernel.
+ *
+ * A gateway, which receives frames through the stack and sends them again on
+ * another interface, copies each frame twice between kernel and userspace and
+ * depends on the scheduling of the rx thread. The Linux can-gw module
+ * (modprobe can-gw) forwards frames in the softirq of the source interface
+ * instead. Its rules are installed over rtnetlink, this needs CAP_NET_ADMIN.
+ *
+ * A rule forwards a range of standard COB IDs from one interface of the CAN
+ * module to another. As can-gw filters by identifier and mask, the range is
+ * split into up to #CO_CANGW_JOBS_MAX kernel jobs. Each job carries a unique
+ * CGW_MOD_UID, so the jobs of a rule are found again in the kernel list to
+ * read the counters.
+ *
+ * The stack still receives forwarded frames on the source interface by its
+ * own socket. Frames are sent on the destination interface without local echo
+ * (unless CGW_FLAGS_CAN_ECHO is given), so the sockets of the stack on that
+ * interface don't see them.
+ *
+ * Kernel rules are not bound to the process. CO_CANgw_close() removes all
+ * rules of the object, rules of a crashed process stay active until removed,
+ * e.g. with "cangw -F".
+ *
+ * Functions are not thread safe, call them from one non realtime thread.
+ */
+
+/** Max number of kernel jobs of one rule, an 11 bit range needs up to 20 */
+#define CO_CANGW_JOBS_MAX       20U
+
+/**
+ * Counters of a rule, summed over its kernel jobs
+ */
+typedef struct {
+    uint32_t            handled;        /**< Frames forwarded */
+    uint32_t            dropped;        /**< Frames dropped, e.g. destination tx queue full */
+    uint32_t            deleted;        /**< Frames deleted by the hop limit */
+} CO_CANgwCounters_t;
+
+/**
+ * One rule
+ */
+typedef struct {
+    int32_t             srcBaseAddress; /**< Source interface, 0 if the rule is free */
+    int32_t             dstBaseAddress; /**< Destination interface */
+    uint16_t            first;          /**< First COB ID of the range */
+    uint16_t            last;           /**< Last COB ID of the range */
+    uint16_t            flags;          /**< CGW_FLAGS_CAN_xxx from linux/can/gw.h */
+    uint8_t             hops;           /**< Hop limit, 0 for the kernel default */
+    uint8_t             jobCount;       /**< Number of installed kernel jobs */
+    CO_CANgwCounters_t  removed;        /**< Counters of jobs replaced by CO_CANgw_update() */
+} CO_CANgwRule_t;
+
+/**
+ * Gateway object
+ */
+typedef struct {
+    CO_CANmodule_t     *CANmodule;      /**< From CO_CANgw_init() */
+    CO_CANgwRule_t     *rules;          /**< From CO_CANgw_init() */
+    uint16_t            rulesSize;      /**< From CO_CANgw_init() */
+    int                 fd;             /**< rtnetlink socket, -1 if closed */
+    uint32_t            seq;            /**< Sequence number of the last request */
+    uint32_t            uidBase;        /**< CGW_MOD_UID of job 0 of rule 0 */
+} CO_CANgw_t;
+
+/**
+ * Initialize gateway object and open the rtnetlink socket.
+ *
+ * @param gw This object will be initialized.
+ * @param CANmodule CAN module, which owns the interfaces.
+ * @param rules Array for the rules, must be valid until CO_CANgw_close().
+ * @param rulesSize Number of rules in the array.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_SYSCALL.
+ */
+CO_ReturnError_t CO_CANgw_init(CO_CANgw_t *gw, CO_CANmodule_t *CANmodule,
+                               CO_CANgwRule_t rules[], uint16_t rulesSize);
+
+/**
+ * Install rule in the kernel.
+ *
+ * @param gw This object.
+ * @param srcBaseAddress Interface of the CAN module, frames are received on.
+ * @param dstBaseAddress Interface of the CAN module, frames are sent on.
+ * @param first First COB ID to forward.
+ * @param last Last COB ID to forward, not below _first_.
+ * @param flags CGW_FLAGS_CAN_xxx, CGW_FLAGS_CAN_FD is added with
+ * #CO_DRIVER_CAN_FD.
+ * @param hops Hop limit of the rule, 0 for the kernel default.
+ *
+ * @return Index of the rule, or #CO_ReturnError_t: CO_ERROR_ILLEGAL_ARGUMENT,
+ * CO_ERROR_OUT_OF_MEMORY (no free rule) or CO_ERROR_SYSCALL (errno is set
+ * from the kernel, e.g. EPERM or EAFNOSUPPORT if can-gw is not loaded).
+ */
+int32_t CO_CANgw_add(CO_CANgw_t *gw, int32_t srcBaseAddress, int32_t dstBaseAddress,
+                     uint16_t first, uint16_t last, uint16_t flags, uint8_t hops);
+
+/**
+ * Change COB ID range of a rule.
+ *
+ * can-gw can't change the filter of a job, so the jobs are replaced. Frames
+ * of the old range, which arrive in between, are not forwarded. Counters of
+ * the replaced jobs are kept.
+ *
+ * @param gw This object.
+ * @param rule Index from CO_CANgw_add().
+ * @param first New first COB ID.
+ * @param last New last COB ID.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_SYSCALL. On error the rule may be left with part of its jobs.
+ */
+CO_ReturnError_t CO_CANgw_update(CO_CANgw_t *gw, int32_t rule,
+                                 uint16_t first, uint16_t last);
+
+/**
+ * Remove rule from the kernel.
+ *
+ * @param gw This object.
+ * @param rule Index from CO_CANgw_add().
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_SYSCALL. The rule is freed also on error.
+ */
+CO_ReturnError_t CO_CANgw_remove(CO_CANgw_t *gw, int32_t rule);
+
+/**
+ * Read counters of a rule from the kernel.
+ *
+ * @param gw This object.
+ * @param rule Index from CO_CANgw_add().
+ * @param [out] counters Counters summed over the jobs of the rule.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_SYSCALL.
+ */
+CO_ReturnError_t CO_CANgw_getCounters(CO_CANgw_t *gw, int32_t rule,
+                                      CO_CANgwCounters_t *counters);
+
+/**
+ * Remove all rules and close the rtnetlink socket.
+ *
+ * @param gw This object.
+ */
+void CO_CANgw_close(CO_CANgw_t *gw);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+#endif /* CO_CANGW_H_ */
@@ -0,0 +1,262 @@
+/*
+ * CAN frame capture and replay for Linux socketCAN.
+ *
+ * @file        CO_capture.c
+ * @ingroup     CO_driver
+ * @copyright   2019 Neuberger Gebaeudeautomation GmbH
+ *
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "CO_capture.h"
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_capture_init(CO_capture_t *capture, CO_captureRecord_t records[],
+                                 uint32_t size, const char *path)
+{
+    CO_captureHeader_t header;
+
+    if (capture == NULL || records == NULL || size == 0 || path == NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    capture->records = records;
+    capture->size = size;
+    capture->head = 0;
+    capture->tail = 0;
+    capture->dropped = 0;
+
+    capture->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (capture->fd < 0) {
+        return CO_ERROR_SYSCALL;
+    }
+    header.magic = CO_CAPTURE_MAGIC;
+    header.version = CO_CAPTURE_VERSION;
+    header.recordSize = sizeof(CO_captureRecord_t);
+    if (write(capture->fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+        close(capture->fd);
+        capture->fd = -1;
+        return CO_ERROR_SYSCALL;
+    }
+    pthread_spin_init(&capture->lock, PTHREAD_PROCESS_PRIVATE);
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_capture_add(CO_capture_t *capture, const CO_CANrxMsg_t *msg,
+                    uint64_t timestamp_us, uint32_t interface, uint8_t direction)
+{
+    CO_captureRecord_t *record;
+    uint8_t DLC = (msg->DLC <= CO_CAN_DATA_MAX) ? msg->DLC : CO_CAN_DATA_MAX;
+
+    pthread_spin_lock(&capture->lock);
+    if ((capture->head - capture->tail) >= capture->size) {
+        /* ring full, spill is too slow */
+        capture->dropped ++;
+    }
+    else {
+        record = &capture->records[capture->head % capture->size];
+        record->timestamp_us = timestamp_us;
+        record->ident = msg->ident;
+        record->DLC = DLC;
+        record->flags = msg->padding[0];
+        record->interface = (uint8_t)interface;
+        record->direction = direction;
+        memcpy(record->data, msg->data, DLC);
+        memset(&record->data[DLC], 0, CO_CAN_DATA_MAX - DLC);
+        capture->head ++;
+    }
+    pthread_spin_unlock(&capture->lock);
+}
+
+
+/******************************************************************************/
+int32_t CO_capture_spill(CO_capture_t *capture)
+{
+    uint32_t head;
+    uint32_t tail;
+    uint32_t start;
+
+    if (capture == NULL || capture->fd < 0) {
+        return -1;
+    }
+
+    /* records up to head are complete, the lock orders them before head */
+    pthread_spin_lock(&capture->lock);
+    head = capture->head;
+    pthread_spin_unlock(&capture->lock);
+
+    start = capture->tail;
+    tail = start;
+    while (tail != head) {
+        uint32_t index = tail % capture->size;
+        uint32_t count = head - tail;
+        const char *data = (const char *)&capture->records[index];
+        size_t length;
+
+        /* up to the end of the ring, the rest with the next loop */
+        if (count > capture->size - index) {
+            count = capture->size - index;
+        }
+        length = count * sizeof(CO_captureRecord_t);
+        while (length > 0) {
+            ssize_t n = write(capture->fd, data, length);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -1;
+            }
+            data += n;
+            length -= (size_t)n;
+        }
+        tail += count;
+
+        /* release the records to the writers */
+        __sync_synchronize();
+        capture->tail = tail;
+    }
+
+    return (int32_t)(head - start);
+}
+
+
+/******************************************************************************/
+void CO_capture_close(CO_capture_t *capture)
+{
+    if (capture == NULL || capture->fd < 0) {
+        return;
+    }
+    (void)CO_capture_spill(capture);
+    close(capture->fd);
+    capture->fd = -1;
+    pthread_spin_destroy(&capture->lock);
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_replay_open(CO_replay_t *replay, const char *path, uint32_t speed)
+{
+    CO_captureHeader_t header;
+
+    if (replay == NULL || path == NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    replay->speed = speed;
+    replay->started = false;
+    replay->first_us = 0;
+    replay->start_us = 0;
+    replay->count = 0;
+
+    replay->file = fopen(path, "rb");
+    if (replay->file == NULL) {
+        return CO_ERROR_SYSCALL;
+    }
+    if (fread(&header, sizeof(header), 1, replay->file) != 1 ||
+        header.magic != CO_CAPTURE_MAGIC || header.version != CO_CAPTURE_VERSION ||
+        header.recordSize != sizeof(CO_captureRecord_t)) {
+        fclose(replay->file);
+        replay->file = NULL;
+        return CO_ERROR_DATA_CORRUPT;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+bool_t CO_replay_next(CO_replay_t *replay, CO_captureRecord_t *record)
+{
+    struct timespec now;
+    uint64_t now_us;
+
+    if (replay == NULL || replay->file == NULL) {
+        return false;
+    }
+
+    do {
+        if (fread(record, sizeof(*record), 1, replay->file) != 1) {
+            return false;
+        }
+    } while (record->direction != CO_CAPTURE_RX);
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    now_us = (uint64_t)now.tv_sec * 1000000U + (uint64_t)now.tv_nsec / 1000U;
+    if (!replay->started) {
+        replay->started = true;
+        replay->first_us = record->timestamp_us;
+        replay->start_us = now_us;
+    }
+    else if (replay->speed != 0 && record->timestamp_us > replay->first_us) {
+        uint64_t due_us = replay->start_us +
+            (record->timestamp_us - replay->first_us) * 100U / replay->speed;
+
+        if (due_us > now_us) {
+            struct timespec due;
+
+            due.tv_sec = (time_t)(due_us / 1000000U);
+            due.tv_nsec = (long)(due_us % 1000000U) * 1000L;
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR) {
+            }
+        }
+    }
+    replay->count ++;
+
+    return true;
+}
+
+
+/******************************************************************************/
+void CO_replay_close(CO_replay_t *replay)
+{
+    if (replay == NULL || replay->file == NULL) {
+        return;
+    }
+    fclose(replay->file);
+    replay->file = NULL;
+}
@@ -0,0 +1,227 @@
+/**
+ * CAN frame capture and replay for Linux socketCAN.
+ *
+ * @file        CO_capture.h
+ * @ingroup     CO_driver
+ * @copyright   2019 Neuberger Gebaeudeautomation GmbH
+ *
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+#ifndef CO_CAPTURE_H_
+#define CO_CAPTURE_H_
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include "CO_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_capture Capture
+ * @ingroup CO_driver
+ * @{
+ *
+ * Recording of all CAN frames of the driver and replay of a recording.
+ *
+ * With #CO_DRIVER_CAPTURE and CO_CANmodule_setCapture(), the driver copies
+ * each frame it reads with recvmmsg() and each frame it sends into the
+ * capture ring. No additional socket is read, so a candump running beside
+ * the stack is not needed. Only frames passing the rx filters of the driver
+ * are received, these are all frames the stack reacts on.
+ *
+ * The ring is written under a spinlock by the rx threads and by the threads
+ * sending messages. CO_capture_spill() writes the records from the ring
+ * directly into the file, it is called cyclically by the application from a
+ * non realtime thread. If the ring is full, new frames are dropped and
+ * counted, the realtime threads never wait for the file.
+ *
+ * The file starts with CO_captureHeader_t, followed by CO_captureRecord_t
+ * records in host byte order.
+ *
+ * CO_replay_next() reads the received frames of a recording at the original
+ * or at accelerated timing, CO_CANrxReplay() of the driver evaluates them
+ * like frames received from the socket.
+ */
+
+/** Value of CO_captureHeader_t::magic */
+#define CO_CAPTURE_MAGIC        0x50434F43UL
+/** Value of CO_captureHeader_t::version */
+#define CO_CAPTURE_VERSION      1U
+
+/** CO_captureRecord_t::direction of a received frame */
+#define CO_CAPTURE_RX           0U
+/** CO_captureRecord_t::direction of a sent frame */
+#define CO_CAPTURE_TX           1U
+
+/**
+ * Header of a capture file
+ */
+typedef struct {
+    uint32_t            magic;          /**< CO_CAPTURE_MAGIC */
+    uint16_t            version;        /**< CO_CAPTURE_VERSION */
+    uint16_t            recordSize;     /**< sizeof(CO_captureRecord_t) */
+} CO_captureHeader_t;
+
+/**
+ * One captured frame
+ */
+typedef struct {
+    uint64_t            timestamp_us;   /**< CLOCK_REALTIME, from the socket for rx */
+    uint32_t            ident;          /**< socketCAN can_id with EFF/RTR/ERR flags */
+    uint8_t             DLC;            /**< Length of data in bytes */
+    uint8_t             flags;          /**< CAN FD flags */
+    uint8_t             interface;      /**< Index of the interface in the CAN module */
+    uint8_t             direction;      /**< CO_CAPTURE_RX or CO_CAPTURE_TX */
+    uint8_t             data[CO_CAN_DATA_MAX]; /**< data bytes */
+} CO_captureRecord_t;
+
+/**
+ * Capture object
+ */
+typedef struct CO_capture {
+    CO_captureRecord_t *records;        /**< From CO_capture_init() */
+    uint32_t            size;           /**< From CO_capture_init() */
+    volatile uint32_t   head;           /**< Number of records written to the ring */
+    volatile uint32_t   tail;           /**< Number of records spilled to the file */
+    uint32_t            dropped;        /**< Frames dropped because the ring was full */
+    int                 fd;             /**< File, -1 if closed */
+    pthread_spinlock_t  lock;           /**< Protects head and dropped */
+} CO_capture_t;
+
+/**
+ * Replay object
+ */
+typedef struct CO_replay {
+    FILE               *file;           /**< Recording */
+    uint32_t            speed;          /**< From CO_replay_open() */
+    bool_t              started;        /**< First frame was read */
+    uint64_t            first_us;       /**< Time of the first frame in the recording */
+    uint64_t            start_us;       /**< CLOCK_MONOTONIC at the first frame */
+    uint32_t            count;          /**< Number of frames replayed */
+} CO_replay_t;
+
+/**
+ * Initialize capture and create the file.
+ *
+ * @param capture This object will be initialized.
+ * @param records Array for the ring, must be valid until CO_capture_close().
+ * @param size Number of records in the array.
+ * @param path Name of the file, existing file is replaced.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_SYSCALL.
+ */
+CO_ReturnError_t CO_capture_init(CO_capture_t *capture, CO_captureRecord_t records[],
+                                 uint32_t size, const char *path);
+
+/**
+ * Add frame to the ring. Called by the driver.
+ *
+ * @param capture This object.
+ * @param msg Frame, CO_CANtx_t and socketCAN frames are binary compatible.
+ * @param timestamp_us CLOCK_REALTIME of the frame.
+ * @param interface Index of the interface in the CAN module.
+ * @param direction CO_CAPTURE_RX or CO_CAPTURE_TX.
+ */
+void CO_capture_add(CO_capture_t *capture, const CO_CANrxMsg_t *msg,
+                    uint64_t timestamp_us, uint32_t interface, uint8_t direction);
+
+/**
+ * Write records from the ring to the file.
+ *
+ * Must be called cyclically from one thread, it blocks while writing.
+ *
+ * @param capture This object.
+ *
+ * @return Number of records written or -1 if writing failed.
+ */
+int32_t CO_capture_spill(CO_capture_t *capture);
+
+/**
+ * Spill remaining records and close the file. Capture must be detached from
+ * the driver before, see CO_CANmodule_setCapture().
+ *
+ * @param capture This object.
+ */
+void CO_capture_close(CO_capture_t *capture);
+
+/**
+ * Open recording for replay.
+ *
+ * @param replay This object will be initialized.
+ * @param path Name of the file written by CO_capture_init().
+ * @param speed Replay speed in percent of the original timing, 200 is twice
+ *              as fast. 0 replays without waiting.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT,
+ * CO_ERROR_SYSCALL or CO_ERROR_DATA_CORRUPT (not a capture file of this
+ * driver configuration).
+ */
+CO_ReturnError_t CO_replay_open(CO_replay_t *replay, const char *path, uint32_t speed);
+
+/**
+ * Get next received frame of the recording at its time. Sent frames are
+ * skipped, they are generated by the stack under test again.
+ *
+ * Function blocks until the time of the frame, relative to the first frame.
+ * If the caller is late, the frame is returned immediately.
+ *
+ * @param replay This object.
+ * @param [out] record The frame.
+ *
+ * @return True, false at the end of the recording.
+ */
+bool_t CO_replay_next(CO_replay_t *replay, CO_captureRecord_t *record);
+
+/**
+ * Close recording.
+ *
+ * @param replay This object.
+ */
+void CO_replay_close(CO_replay_t *replay);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+#endif /* CO_CAPTURE_H_ */
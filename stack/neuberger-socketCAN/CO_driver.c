@@ -45,6 +45,10 @@
  * to do so, delete this exception statement from your version.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE         /* for recvmmsg(), sendmmsg() */
+#endif
+
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -56,6 +60,10 @@
 #include <sys/epoll.h>
 
 #include "CO_driver.h"
+#include "CO_CANfilter.h"
+#include "CO_tracepoint.h"
+#include "CO_statistics.h"
+#include "CO_log.h"
 
 #if defined CO_DRIVER_ERROR_REPORTING && __has_include("syslog/log.h")
   #include "syslog/log.h"
@@ -69,6 +77,60 @@
   #define USE_EMERGENCY_OBJECT
 #endif
 
+#ifdef CO_DRIVER_CAPTURE
+  #include "CO_capture.h"
+#endif
+
+/**
+ * One received message inside rx batch, filled by recvmmsg()
+ */
+#ifdef CO_DRIVER_CAN_FD
+typedef struct canfd_frame CO_CANframe_t;
+/** socketCAN frame size. Messages up to 8 bytes are classic CAN frames */
+#define CO_CAN_FRAME_MTU(len) (((len) > CAN_MAX_DLEN) ? CANFD_MTU : CAN_MTU)
+#else
+typedef struct can_frame CO_CANframe_t;
+#define CO_CAN_FRAME_MTU(len) CAN_MTU
+#endif
+
+struct CO_CANrxBatch {
+    CO_CANframe_t       msg;            /**< received message */
+    struct timespec     timestamp;      /**< time of reception */
+#ifdef CO_DRIVER_RX_TIMESTAMP
+    uint32_t            timestamp_us;   /**< time of reception, monotonic */
+#endif
+    struct iovec        iov;            /**< points to msg */
+    /** SO_TIMESTAMPING delivers three timestamps, SO_RXQ_OVFL the drop counter */
+    char                ctrlmsg[CMSG_SPACE(3 * sizeof(struct timespec)) +
+                                CMSG_SPACE(sizeof(uint32_t))];
+};
+
+/**
+ * Software tx queue of one interface, sent by sendmmsg()
+ */
+struct CO_CANtxQueue {
+    CO_CANframe_t       msg[CO_DRIVER_TX_QUEUE_SIZE];      /**< queued messages */
+    bool_t              syncFlag[CO_DRIVER_TX_QUEUE_SIZE]; /**< message is synchronous TPDO */
+    struct iovec        iov[CO_DRIVER_TX_QUEUE_SIZE];      /**< points to msg */
+    struct mmsghdr      hdr[CO_DRIVER_TX_QUEUE_SIZE];      /**< points to iov */
+};
+
+#ifdef CO_DRIVER_MULTI_INTERFACE
+#if (CO_DRIVER_RX_DUP_TABLE_SIZE & (CO_DRIVER_RX_DUP_TABLE_SIZE - 1)) != 0
+  #error CO_DRIVER_RX_DUP_TABLE_SIZE must be a power of two
+#endif
+
+/**
+ * Entry of the duplicate suppression table, see CO_CANrxDuplicate_init()
+ */
+struct CO_CANrxDup {
+    uint64_t            time_us;        /**< reception of first copy */
+    uint32_t            hash;           /**< hash over COB ID, DLC and data, 0 = free */
+    uint32_t            ident;          /**< COB ID with flags */
+    uint32_t            interfaceMask;  /**< interfaces which received this message */
+};
+#endif
+
 pthread_mutex_t CO_EMCY_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t CO_OD_mutex = PTHREAD_MUTEX_INITIALIZER;
 
@@ -76,9 +138,13 @@ pthread_mutex_t CO_OD_mutex = PTHREAD_MUTEX_INITIALIZER;
 static CO_ReturnError_t CO_CANmodule_addInterface(CO_CANmodule_t *CANmodule, int32_t CANbaseAddress);
 #endif
 
-#ifdef CO_DRIVER_MULTI_INTERFACE
+#ifdef CO_DRIVER_RX_DISPATCH_TABLE
 
 static const uint32_t CO_INVALID_COB_ID = 0xffffffff;
+#ifdef CO_DRIVER_MULTI_INTERFACE
+/* entry of rxRouteLearn without learning rule */
+static const uint16_t CO_TX_ROUTE_NO_LEARN = 0xffff;
+#endif
 
 /******************************************************************************/
 void CO_CANsetIdentToIndex(
@@ -87,13 +153,15 @@ void CO_CANsetIdentToIndex(
         uint32_t                identNew,
         uint32_t                identCurrent)
 {
-    /* entry changed, remove old one */
-    if (identCurrent<CO_CAN_MSG_SFF_MAX_COB_ID && identNew!=identCurrent) {
+    /* entry changed, remove old one. Only remove it if it still belongs to
+     * this index, unconfigured entries all share COB ID "0" */
+    if (identCurrent<CO_CAN_MSG_SFF_MAX_COB_ID && identNew!=identCurrent &&
+        lookup[identCurrent]==index) {
         lookup[identCurrent] = CO_INVALID_COB_ID;
     }
 
     /* check if this COB ID is part of the table */
-    if (identNew > CO_CAN_MSG_SFF_MAX_COB_ID) {
+    if (identNew >= CO_CAN_MSG_SFF_MAX_COB_ID) {
         return;
     }
 
@@ -116,13 +184,78 @@ static uint32_t CO_CANgetIndexFromIdent(
         uint32_t                ident)
 {
     /* check if this COB ID is part of the table */
-    if (ident > CO_CAN_MSG_SFF_MAX_COB_ID) {
+    if (ident >= CO_CAN_MSG_SFF_MAX_COB_ID) {
         return CO_INVALID_COB_ID;
     }
 
     return lookup[ident];
 }
 
+
+/******************************************************************************/
+/* Enter the first rx buffer with this CAN-ID into the lookup table, which a
+ * linear search over rxArray would find. Unconfigured buffers all share COB ID
+ * "0", it is only entered for buffer 0 (CO_RXCAN_NMT). */
+static void CO_CANrxSetIdentToIndex(
+        CO_CANmodule_t         *CANmodule,
+        uint32_t                ident)
+{
+    uint16_t i;
+
+    if (ident >= CO_CAN_MSG_SFF_MAX_COB_ID) {
+        return;
+    }
+
+    CANmodule->rxIdentToIndex[ident] = CO_INVALID_COB_ID;
+    for (i = 0; i < CANmodule->rxSize; i ++) {
+        if ((CANmodule->rxArray[i].ident & CAN_SFF_MASK) == ident) {
+            if ((ident != 0) || (i == 0)) {
+                CANmodule->rxIdentToIndex[ident] = i;
+            }
+            break;
+        }
+    }
+}
+
+
+/******************************************************************************/
+static void CO_CANsetRxMasked(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        bool_t                  masked)
+{
+    uint16_t i;
+    uint16_t j;
+
+    /* remove entry, if already listed */
+    for (i = 0; i < CANmodule->rxMaskedCount; i ++) {
+        if (CANmodule->rxMaskedIndex[i] == index) {
+            for (j = i; j < (CANmodule->rxMaskedCount - 1); j ++) {
+                CANmodule->rxMaskedIndex[j] = CANmodule->rxMaskedIndex[j + 1];
+            }
+            CANmodule->rxMaskedCount --;
+            break;
+        }
+    }
+
+    if (!masked) {
+        return;
+    }
+
+    /* insert entry. List is kept in rxArray order, so the first matching
+     * buffer is found the same way as with a linear search */
+    for (i = 0; i < CANmodule->rxMaskedCount; i ++) {
+        if (CANmodule->rxMaskedIndex[i] > index) {
+            break;
+        }
+    }
+    for (j = CANmodule->rxMaskedCount; j > i; j --) {
+        CANmodule->rxMaskedIndex[j] = CANmodule->rxMaskedIndex[j - 1];
+    }
+    CANmodule->rxMaskedIndex[i] = index;
+    CANmodule->rxMaskedCount ++;
+}
+
 #endif
 
 
@@ -157,7 +290,8 @@ static CO_ReturnError_t setRxFilters(CO_CANmodule_t *CANmodule)
     int count;
     CO_ReturnError_t retval;
 
-    struct can_filter rxFiltersCpy[CANmodule->rxSize];
+    /* binary compatible to struct can_filter */
+    CO_CANfilter_t rxFiltersCpy[CANmodule->rxSize];
 
     count = 0;
     /* remove unused entries ( id == 0 and mask == 0 ) as they would act as
@@ -166,7 +300,8 @@ static CO_ReturnError_t setRxFilters(CO_CANmodule_t *CANmodule)
         if ((CANmodule->rxFilter[i].can_id != 0) ||
             (CANmodule->rxFilter[i].can_mask != 0)) {
 
-            rxFiltersCpy[count] = CANmodule->rxFilter[i];
+            rxFiltersCpy[count].ident = CANmodule->rxFilter[i].can_id;
+            rxFiltersCpy[count].mask = CANmodule->rxFilter[i].can_mask;
 
             count ++;
         }
@@ -177,10 +312,15 @@ static CO_ReturnError_t setRxFilters(CO_CANmodule_t *CANmodule)
         return disableRx(CANmodule);
     }
 
+    /* remove duplicate and covered entries. Filters are not merged any further,
+     * as the kernel looks up exact matching filters by hash, but checks
+     * masked filters one by one */
+    count = CO_CANfilter_merge(rxFiltersCpy, count, count);
+
     retval = CO_ERROR_NO;
     for (i = 0; i < CANmodule->CANinterfaceCount; i ++) {
       ret = setsockopt(CANmodule->CANinterfaces[i].fd, SOL_CAN_RAW, CAN_RAW_FILTER,
-                       rxFiltersCpy, sizeof(struct can_filter) * count);
+                       rxFiltersCpy, sizeof(rxFiltersCpy[0]) * count);
       if(ret < 0){
           log_printf(LOG_ERR, CAN_FILTER_FAILED,
                      CANmodule->CANinterfaces[i].ifName);
@@ -217,75 +357,185 @@ void CO_CANsetNormalMode(CO_CANmodule_t *CANmodule)
 }
 
 
-/******************************************************************************/
-CO_ReturnError_t CO_CANmodule_init(
-        CO_CANmodule_t         *CANmodule,
-        int32_t                 CANbaseAddress,
-        CO_CANrx_t              rxArray[],
-        uint16_t                rxSize,
-        CO_CANtx_t              txArray[],
-        uint16_t                txSize,
-        uint16_t                CANbitRate)
+/** Create epoll set, notification pipe and rx batch of one rx thread ********/
+static CO_ReturnError_t CO_CANrxThread_open(CO_CANrxThread_t *rxThread)
 {
     int32_t ret;
     uint16_t i;
     struct epoll_event ev;
 
-    /* verify arguments */
-    if(CANmodule==NULL || rxArray==NULL || txArray==NULL){
-        return CO_ERROR_ILLEGAL_ARGUMENT;
-    }
+    rxThread->pipe = NULL;
+    rxThread->fdTimerRead = -1;
+    rxThread->rxBatch = NULL;
+    rxThread->rxBatchHdr = NULL;
 
     /* Create epoll FD */
-    CANmodule->fdEpoll = epoll_create(1);
-    if(CANmodule->fdEpoll < 0){
+    rxThread->fdEpoll = epoll_create(1);
+    if(rxThread->fdEpoll < 0){
         log_printf(LOG_DEBUG, DBG_ERRNO, "epoll_create()");
-        CO_CANmodule_disable(CANmodule);
         return CO_ERROR_SYSCALL;
     }
 
-    /* Create notification pipe */
-    CANmodule->pipe = CO_NotifyPipeCreate();
-    if (CANmodule->pipe==NULL) {
+    /* Create notification pipe (eventfd, if available) */
+    rxThread->pipe = CO_NotifyPipeCreate();
+    if (rxThread->pipe==NULL) {
         log_printf(LOG_DEBUG, DBG_ERRNO, "pipe");
-        CO_CANmodule_disable(CANmodule);
         return CO_ERROR_OUT_OF_MEMORY;
     }
     /* ...and add it to epoll */
     ev.events = EPOLLIN;
-    ev.data.fd = CO_NotifyPipeGetFd(CANmodule->pipe);
-    ret = epoll_ctl(CANmodule->fdEpoll, EPOLL_CTL_ADD, ev.data.fd, &ev);
+    ev.data.ptr = rxThread->pipe;
+    ret = epoll_ctl(rxThread->fdEpoll, EPOLL_CTL_ADD, CO_NotifyPipeGetFd(rxThread->pipe), &ev);
     if(ret < 0){
         log_printf(LOG_DEBUG, DBG_ERRNO, "epoll_ctl(pipe)");
-        CO_CANmodule_disable(CANmodule);
         return CO_ERROR_SYSCALL;
     }
 
-    /* Configure object variables */
+    /* initialize rx batch. Message buffers are assigned once, control
+     * buffers are reset before every read */
+    rxThread->rxBatchSize = (CO_DRIVER_RX_BATCH_SIZE > 0) ? CO_DRIVER_RX_BATCH_SIZE : 1;
+    rxThread->rxBatchCount = 0;
+    rxThread->rxBatchNext = 0;
+    rxThread->rxBatchInterface = 0;
+    rxThread->rxBatch = calloc(rxThread->rxBatchSize, sizeof(*rxThread->rxBatch));
+    rxThread->rxBatchHdr = calloc(rxThread->rxBatchSize, sizeof(*rxThread->rxBatchHdr));
+    if((rxThread->rxBatch == NULL) || (rxThread->rxBatchHdr == NULL)){
+        log_printf(LOG_DEBUG, DBG_ERRNO, "malloc()");
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+    for(i=0U; i<rxThread->rxBatchSize; i++){
+        struct CO_CANrxBatch *rx = &rxThread->rxBatch[i];
+        struct msghdr *msghdr = &rxThread->rxBatchHdr[i].msg_hdr;
+
+        rx->iov.iov_base = &rx->msg;
+        rx->iov.iov_len = sizeof(rx->msg);
+        msghdr->msg_name = NULL;
+        msghdr->msg_namelen = 0;
+        msghdr->msg_iov = &rx->iov;
+        msghdr->msg_iovlen = 1;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/** Cancel a blocking CO_CANrxWait() and free rx thread **********************/
+static void CO_CANrxThread_free(CO_CANrxThread_t *rxThread)
+{
+    struct timespec wait;
+
+    /* cancel rx */
+    if (rxThread->pipe != NULL) {
+        CO_NotifyPipeSend(rxThread->pipe);
+        /* give some time for delivery */
+        wait.tv_sec = 0;
+        wait.tv_nsec = 50 /* ms */ * 1000000;
+        nanosleep(&wait, NULL);
+        CO_NotifyPipeFree(rxThread->pipe);
+    }
+    rxThread->pipe = NULL;
+
+    if (rxThread->fdEpoll >= 0) {
+        close(rxThread->fdEpoll);
+    }
+    rxThread->fdEpoll = -1;
+
+    if (rxThread->rxBatch != NULL) {
+        free(rxThread->rxBatch);
+    }
+    rxThread->rxBatch = NULL;
+    if (rxThread->rxBatchHdr != NULL) {
+        free(rxThread->rxBatchHdr);
+    }
+    rxThread->rxBatchHdr = NULL;
+    rxThread->rxBatchCount = 0;
+    rxThread->rxBatchNext = 0;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANmodule_init(
+        CO_CANmodule_t         *CANmodule,
+        int32_t                 CANbaseAddress,
+        CO_CANrx_t              rxArray[],
+        uint16_t                rxSize,
+        CO_CANtx_t              txArray[],
+        uint16_t                txSize,
+        uint16_t                CANbitRate)
+{
+    int32_t ret;
+    uint16_t i;
+    struct can_filter *rxFilter;
+#ifdef CO_DRIVER_RX_DISPATCH_TABLE
+    uint16_t *rxMaskedIndex;
+#endif
+
+    /* verify arguments */
+    if(CANmodule==NULL || rxArray==NULL || txArray==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    pthread_mutex_init(&CANmodule->txMutex, NULL);
+    CANmodule->txBatch = false;
+#ifdef CO_DRIVER_MULTI_INTERFACE
+    pthread_mutex_init(&CANmodule->rxDupMutex, NULL);
+    CANmodule->rxDup = NULL;
+    CANmodule->rxDupWindow_us = 0;
+#endif
     CANmodule->CANinterfaces = NULL;
     CANmodule->CANinterfaceCount = 0;
+
+    /* Create epoll FD, notification pipe and rx batch */
+    ret = CO_CANrxThread_open(&CANmodule->rxThread);
+    if(ret != CO_ERROR_NO){
+        CO_CANmodule_disable(CANmodule);
+        return ret;
+    }
+
+    /* Configure object variables */
     CANmodule->rxArray = rxArray;
     CANmodule->rxSize = rxSize;
     CANmodule->txArray = txArray;
     CANmodule->txSize = txSize;
     CANmodule->CANnormal = false;
+    CANmodule->rxDropCount = 0;
+    CANmodule->txOverflowCount = 0;
+    CANmodule->rcvbufMax = 0;
+    CANmodule->sndbufMax = 0;
+    CANmodule->rxPriority = 0;
     CANmodule->em = NULL; //this is set inside CO_Emergency.c init function!
-    CANmodule->fdTimerRead = -1;
-#ifdef CO_DRIVER_MULTI_INTERFACE
+#ifdef CO_DRIVER_CAPTURE
+    CANmodule->capture = NULL;
+#endif
+#ifdef CO_DRIVER_RX_DISPATCH_TABLE
     for (i = 0; i < CO_CAN_MSG_SFF_MAX_COB_ID; i++) {
         CANmodule->rxIdentToIndex[i] = CO_INVALID_COB_ID;
+#ifdef CO_DRIVER_MULTI_INTERFACE
         CANmodule->txIdentToIndex[i] = CO_INVALID_COB_ID;
+        CANmodule->txRoute[i] = 0;
+        CANmodule->rxRouteLearn[i] = CO_TX_ROUTE_NO_LEARN;
+#endif
+    }
+    /* reused on communication reset, freed by CO_CANmodule_disable() */
+    CANmodule->rxMaskedCount = 0;
+    rxMaskedIndex = realloc(CANmodule->rxMaskedIndex, rxSize * sizeof(uint16_t));
+    if(rxMaskedIndex == NULL){
+        log_printf(LOG_DEBUG, DBG_ERRNO, "realloc()");
+        return CO_ERROR_OUT_OF_MEMORY;
     }
+    CANmodule->rxMaskedIndex = rxMaskedIndex;
 #endif
 
     /* initialize socketCAN filters
      * CAN module filters will be configured with CO_CANrxBufferInit()
      * functions, called by separate CANopen init functions */
-    CANmodule->rxFilter = calloc(CANmodule->rxSize, sizeof(struct can_filter));
-    if(CANmodule->rxFilter == NULL){
-        log_printf(LOG_DEBUG, DBG_ERRNO, "malloc()");
+    rxFilter = realloc(CANmodule->rxFilter, rxSize * sizeof(struct can_filter));
+    if(rxFilter == NULL){
+        log_printf(LOG_DEBUG, DBG_ERRNO, "realloc()");
         return CO_ERROR_OUT_OF_MEMORY;
     }
+    memset(rxFilter, 0, rxSize * sizeof(struct can_filter));
+    CANmodule->rxFilter = rxFilter;
 
     for(i=0U; i<rxSize; i++){
         rxArray[i].ident = 0U;
@@ -345,9 +595,45 @@ CO_ReturnError_t CO_CANmodule_addInterface(
         log_printf(LOG_DEBUG, DBG_ERRNO, "malloc()");
         return CO_ERROR_OUT_OF_MEMORY;
     }
+    /* epoll sets refer to the interface objects, which may have moved */
+    for (tmp = 0; tmp < (int32_t)CANmodule->CANinterfaceCount - 1; tmp ++) {
+        interface = &CANmodule->CANinterfaces[tmp];
+        ev.events = interface->txPollOut ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        ev.data.ptr = interface;
+        (void)epoll_ctl(interface->rxThread->fdEpoll, EPOLL_CTL_MOD, interface->fd, &ev);
+    }
     interface = &CANmodule->CANinterfaces[CANmodule->CANinterfaceCount - 1];
 
     interface->CANbaseAddress = CANbaseAddress;
+    interface->fd = -1;
+    interface->txQueueCount = 0;
+    interface->txPollOut = false;
+    interface->txRetry = false;
+    interface->rxThread = &CANmodule->rxThread;
+    interface->rxDropSocket = 0;
+    interface->rxDropCount = 0;
+    interface->rxFrameCount = 0;
+    interface->rcvbuf = 0;
+    interface->sndbuf = 0;
+    interface->rcvbufLimit = false;
+    interface->sndbufLimit = false;
+#ifdef CO_DRIVER_MULTI_INTERFACE
+    memset(&interface->linkStats, 0, sizeof(interface->linkStats));
+#endif
+    interface->txQueue = calloc(1, sizeof(*interface->txQueue));
+    if (interface->txQueue == NULL) {
+        log_printf(LOG_DEBUG, DBG_ERRNO, "malloc()");
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+    for (tmp = 0; tmp < CO_DRIVER_TX_QUEUE_SIZE; tmp ++) {
+        struct CO_CANtxQueue *txQueue = interface->txQueue;
+
+        txQueue->iov[tmp].iov_base = &txQueue->msg[tmp];
+        txQueue->iov[tmp].iov_len = sizeof(txQueue->msg[tmp]);
+        txQueue->hdr[tmp].msg_hdr.msg_iov = &txQueue->iov[tmp];
+        txQueue->hdr[tmp].msg_hdr.msg_iovlen = 1;
+    }
+
     ifName = if_indextoname(CANbaseAddress, interface->ifName);
     if (ifName == NULL) {
         log_printf(LOG_DEBUG, DBG_ERRNO, "if_indextoname()");
@@ -361,6 +647,16 @@ CO_ReturnError_t CO_CANmodule_addInterface(
         return CO_ERROR_SYSCALL;
     }
 
+#ifdef CO_DRIVER_CAN_FD
+    /* enable CAN FD frames */
+    tmp = 1;
+    ret = setsockopt(interface->fd, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &tmp, sizeof(tmp));
+    if(ret < 0){
+        log_printf(LOG_DEBUG, DBG_ERRNO, "setsockopt(fd frames)");
+        return CO_ERROR_SYSCALL;
+    }
+#endif
+
     /* enable socket rx queue overflow detection */
     tmp = 1;
     ret = setsockopt(interface->fd, SOL_SOCKET, SO_RXQ_OVFL, &tmp, sizeof(tmp));
@@ -368,7 +664,7 @@ CO_ReturnError_t CO_CANmodule_addInterface(
         log_printf(LOG_DEBUG, DBG_ERRNO, "setsockopt(ovfl)");
         return CO_ERROR_SYSCALL;
     }
-#ifdef CO_DRIVER_MULTI_INTERFACE
+#if defined CO_DRIVER_MULTI_INTERFACE || defined CO_DRIVER_RX_TIMESTAMP || defined CO_DRIVER_CAPTURE
     /* enable software time stamp mode (hardware timestamps do not work properly
      * on all devices)*/
     tmp = (SOF_TIMESTAMPING_SOFTWARE |
@@ -380,18 +676,21 @@ CO_ReturnError_t CO_CANmodule_addInterface(
     }
 #endif
 
-    //todo - modify rx buffer size? first one needs root
-    //ret = setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, (void *)&bytes, sLen);
-    //ret = setsockopt(fd, SOL_SOCKET, SO_RCVBUF, (void *)&bytes, sLen);
-
     /* print socket rx buffer size in bytes (In my experience, the kernel reserves
-     * around 450 bytes for each CAN message) */
+     * around 450 bytes for each CAN message). Buffers are raised on demand,
+     * see CO_CANmodule_setBufferTuning() */
     sLen = sizeof(bytes);
     getsockopt(interface->fd, SOL_SOCKET, SO_RCVBUF, (void *)&bytes, &sLen);
     if (sLen == sizeof(bytes)) {
+        interface->rcvbuf = bytes;
         log_printf(LOG_INFO, CAN_SOCKET_BUF_SIZE, interface->ifName,
                    bytes / 446, bytes);
     }
+    sLen = sizeof(bytes);
+    getsockopt(interface->fd, SOL_SOCKET, SO_SNDBUF, (void *)&bytes, &sLen);
+    if (sLen == sizeof(bytes)) {
+        interface->sndbuf = bytes;
+    }
 
     /* bind socket */
     memset(&sockAddr, 0, sizeof(sockAddr));
@@ -424,8 +723,8 @@ CO_ReturnError_t CO_CANmodule_addInterface(
 
     /* Add socket to epoll */
     ev.events = EPOLLIN;
-    ev.data.fd = interface->fd;
-    ret = epoll_ctl(CANmodule->fdEpoll, EPOLL_CTL_ADD, ev.data.fd, &ev);
+    ev.data.ptr = interface;
+    ret = epoll_ctl(interface->rxThread->fdEpoll, EPOLL_CTL_ADD, interface->fd, &ev);
     if(ret < 0){
         log_printf(LOG_DEBUG, DBG_ERRNO, "epoll_ctl(can)");
         return CO_ERROR_SYSCALL;
@@ -439,104 +738,490 @@ CO_ReturnError_t CO_CANmodule_addInterface(
 
 
 /******************************************************************************/
-void CO_CANmodule_disable(CO_CANmodule_t *CANmodule)
+CO_ReturnError_t CO_CANmodule_setBufferTuning(
+        CO_CANmodule_t         *CANmodule,
+        int                     rcvbufMax,
+        int                     sndbufMax,
+        int                     rxPriority)
 {
     uint32_t i;
-    struct timespec wait;
 
-    if (CANmodule == NULL) {
-        return;
+    if (CANmodule == NULL || rcvbufMax < 0 || sndbufMax < 0 || rxPriority < 0 ||
+        rxPriority > sched_get_priority_max(SCHED_FIFO)) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
     }
 
-    /* clear interfaces */
+    pthread_mutex_lock(&CANmodule->txMutex);
+    CANmodule->rcvbufMax = rcvbufMax;
+    CANmodule->sndbufMax = sndbufMax;
+    CANmodule->rxPriority = rxPriority;
+    /* new limits, try again */
     for (i = 0; i < CANmodule->CANinterfaceCount; i++) {
-        CO_CANinterface_t *interface = &CANmodule->CANinterfaces[i];
+        CANmodule->CANinterfaces[i].rcvbufLimit = false;
+        CANmodule->CANinterfaces[i].sndbufLimit = false;
+    }
+    pthread_mutex_unlock(&CANmodule->txMutex);
 
-#ifdef CO_DRIVER_ERROR_REPORTING
-        CO_CANerror_disable(&interface->errorhandler);
-#endif
+    return CO_ERROR_NO;
+}
 
-        epoll_ctl(CANmodule->fdEpoll, EPOLL_CTL_DEL, interface->fd, NULL);
-        close(interface->fd);
-        interface->fd = -1;
-    }
-    if (CANmodule->CANinterfaces != NULL) {
-        free(CANmodule->CANinterfaces);
-    }
-    CANmodule->CANinterfaceCount = 0;
 
-    /* cancel rx */
-    if (CANmodule->pipe != NULL) {
-        CO_NotifyPipeSend(CANmodule->pipe);
-        /* give some time for delivery */
-        wait.tv_sec = 0;
-        wait.tv_nsec = 50 /* ms */ * 1000000;
-        nanosleep(&wait, NULL);
-        CO_NotifyPipeFree(CANmodule->pipe);
-    }
+/*
+ * Double socket buffer, up to max.
+ *
+ * @param size Size as reported by getsockopt(), updated.
+ * @param limit Set, if size can't be raised any more.
+ */
+static void CO_CANsocketBufferRaise(
+        int                     fd,
+        int                     option,
+        int                     optionForce,
+        int                     max,
+        int                    *size,
+        bool_t                 *limit)
+{
+    int bytes;
+    socklen_t sLen = sizeof(bytes);
 
-    if (CANmodule->fdEpoll >= 0) {
-        close(CANmodule->fdEpoll);
+    if (*limit || max <= *size) {
+        *limit = true;
+        return;
     }
-    CANmodule->fdEpoll = -1;
 
-    if (CANmodule->rxFilter != NULL) {
-        free(CANmodule->rxFilter);
+    /* kernel doubles the value for its bookkeeping, getsockopt() returns the
+     * doubled value */
+    bytes = (*size <= max / 2) ? *size : max / 2;
+    if (setsockopt(fd, SOL_SOCKET, optionForce, &bytes, sizeof(bytes)) < 0) {
+        /* no CAP_NET_ADMIN, limited by net.core.rmem_max/wmem_max */
+        (void)setsockopt(fd, SOL_SOCKET, option, &bytes, sizeof(bytes));
     }
-    CANmodule->rxFilter = NULL;
+    if (getsockopt(fd, SOL_SOCKET, option, &bytes, &sLen) < 0 || bytes <= *size) {
+        *limit = true;
+        return;
+    }
+    *size = bytes;
+    *limit = (bytes >= max);
 }
 
 
-/******************************************************************************/
-uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg)
+/*
+ * Switch calling rx thread to SCHED_FIFO with priority, if it runs below.
+ */
+static void CO_CANrxRaisePriority(int priority)
 {
-    /* remove socketCAN flags */
-    return (uint16_t) (rxMsg->ident & CAN_SFF_MASK);
+    struct sched_param param;
+    int policy;
+
+    if (pthread_getschedparam(pthread_self(), &policy, &param) != 0) {
+        return;
+    }
+    if ((policy == SCHED_FIFO || policy == SCHED_RR) && param.sched_priority >= priority) {
+        return;
+    }
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    (void)pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
 }
 
 
+#ifdef CO_DRIVER_MULTI_INTERFACE
 /******************************************************************************/
-CO_ReturnError_t CO_CANrxBufferInit(
+CO_ReturnError_t CO_CANrxThread_init(
         CO_CANmodule_t         *CANmodule,
-        uint32_t                index,
-        uint32_t                ident,
-        uint32_t                mask,
-        bool_t                  rtr,
-        void                   *object,
-        void                  (*pFunct)(void *object, const CO_CANrxMsg_t *message))
+        CO_CANrxThread_t       *rxThread,
+        int32_t                 CANbaseAddress)
 {
-    CO_ReturnError_t ret = CO_ERROR_NO;
-
-    if((CANmodule!=NULL) && (index < CANmodule->rxSize)){
-        uint32_t i;
-        CO_CANrx_t *buffer;
+    int32_t ret;
+    uint32_t i;
+    CO_CANinterface_t *interface = NULL;
+    struct epoll_event ev;
 
-        /* check if COB ID is already used */
-        for (i = 0; i < CANmodule->rxSize; i ++) {
-            buffer = &CANmodule->rxArray[i];
+    if ((CANmodule == NULL) || (rxThread == NULL)) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    if (CANmodule->CANnormal != false) {
+        /* can't change config now! */
+        return CO_ERROR_INVALID_STATE;
+    }
 
-            if (i!=index && ident>0 && ident==buffer->ident) {
-                log_printf(LOG_DEBUG, DBG_CAN_RX_PARAM_FAILED, "duplicate entry");
-                ret = CO_ERROR_ILLEGAL_ARGUMENT;
-            }
+    for (i = 0; i < CANmodule->CANinterfaceCount; i++) {
+        if (CANmodule->CANinterfaces[i].CANbaseAddress == CANbaseAddress) {
+            interface = &CANmodule->CANinterfaces[i];
+            break;
         }
+    }
+    if ((interface == NULL) || (interface->rxThread != &CANmodule->rxThread)) {
+        /* unknown interface or already moved */
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
 
-        if (ret == CO_ERROR_NO) {
-            /* buffer, which will be configured */
-            buffer = &CANmodule->rxArray[index];
+    ret = CO_CANrxThread_open(rxThread);
+    if (ret != CO_ERROR_NO) {
+        CO_CANrxThread_free(rxThread);
+        return ret;
+    }
 
-#ifdef CO_DRIVER_MULTI_INTERFACE
-            CO_CANsetIdentToIndex(CANmodule->rxIdentToIndex, index, ident,
-                                  buffer->ident);
-#endif
+    /* Move socket from default epoll set to the one of this thread */
+    epoll_ctl(CANmodule->rxThread.fdEpoll, EPOLL_CTL_DEL, interface->fd, NULL);
+    ev.events = interface->txPollOut ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    ev.data.ptr = interface;
+    ret = epoll_ctl(rxThread->fdEpoll, EPOLL_CTL_ADD, interface->fd, &ev);
+    if (ret < 0) {
+        log_printf(LOG_DEBUG, DBG_ERRNO, "epoll_ctl(can)");
+        CO_CANrxThread_free(rxThread);
+        /* keep interface working with the default rx thread */
+        ev.events = interface->txPollOut ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+        (void)epoll_ctl(CANmodule->rxThread.fdEpoll, EPOLL_CTL_ADD, interface->fd, &ev);
+        return CO_ERROR_SYSCALL;
+    }
+    interface->rxThread = rxThread;
 
-            /* Configure object variables */
-            buffer->object = object;
-            buffer->pFunct = pFunct;
-#ifdef CO_DRIVER_MULTI_INTERFACE
-            buffer->CANbaseAddress = -1;
-            buffer->timestamp.tv_nsec = 0;
-            buffer->timestamp.tv_sec = 0;
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANrxDuplicate_init(
+        CO_CANmodule_t         *CANmodule,
+        uint32_t                window_us)
+{
+    if (CANmodule == NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    if (CANmodule->CANnormal != false) {
+        /* can't change config now! */
+        return CO_ERROR_INVALID_STATE;
+    }
+
+    if (window_us == 0) {
+        free(CANmodule->rxDup);
+        CANmodule->rxDup = NULL;
+    }
+    else if (CANmodule->rxDup == NULL) {
+        CANmodule->rxDup = calloc(CO_DRIVER_RX_DUP_TABLE_SIZE, sizeof(*CANmodule->rxDup));
+        if (CANmodule->rxDup == NULL) {
+            log_printf(LOG_DEBUG, DBG_ERRNO, "malloc()");
+            return CO_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    CANmodule->rxDupWindow_us = window_us;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANinterface_getLinkStats(
+        CO_CANmodule_t         *CANmodule,
+        int32_t                 CANbaseAddress,
+        CO_CANlinkStats_t      *stats)
+{
+    uint32_t i;
+
+    if ((CANmodule == NULL) || (stats == NULL)) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    for (i = 0; i < CANmodule->CANinterfaceCount; i++) {
+        CO_CANinterface_t *interface = &CANmodule->CANinterfaces[i];
+
+        if (interface->CANbaseAddress == CANbaseAddress) {
+            pthread_mutex_lock(&CANmodule->rxDupMutex);
+            *stats = interface->linkStats;
+            pthread_mutex_unlock(&CANmodule->rxDupMutex);
+            return CO_ERROR_NO;
+        }
+    }
+    return CO_ERROR_ILLEGAL_ARGUMENT;
+}
+
+
+/*
+ * Check if received message is a copy of a message from another interface
+ *
+ * Table entry is selected by a hash over the message, so the lookup takes
+ * constant time. When an entry is reused, interfaces which did not deliver
+ * a copy of the previous message count it as missed.
+ *
+ * @return true, if message is a duplicate and must be dropped.
+ */
+static bool_t CO_CANrxDuplicate(
+        CO_CANmodule_t         *CANmodule,
+        CO_CANinterface_t      *interface,
+        const struct CO_CANrxBatch *rx)
+{
+    const CO_CANrxMsg_t *msg = (const CO_CANrxMsg_t *)&rx->msg;
+    struct CO_CANrxDup *entry;
+    uint32_t interfaceIndex;
+    uint32_t interfaceBit;
+    uint32_t allMask;
+    uint32_t hash;
+    uint64_t now_us;
+    uint8_t len;
+    uint8_t i;
+    bool_t duplicate = false;
+
+    interfaceIndex = (uint32_t)(interface - CANmodule->CANinterfaces);
+    if (interfaceIndex >= 32) {
+        return false;
+    }
+    interfaceBit = 1UL << interfaceIndex;
+    allMask = (CANmodule->CANinterfaceCount >= 32) ?
+              0xFFFFFFFFUL : ((1UL << CANmodule->CANinterfaceCount) - 1);
+
+    /* FNV-1a over COB ID, DLC and data */
+    len = msg->DLC;
+    if (len > CO_CAN_DATA_MAX) {
+        len = CO_CAN_DATA_MAX;
+    }
+    hash = 2166136261UL;
+    hash = (hash ^ (msg->ident & 0xFFFFU)) * 16777619UL;
+    hash = (hash ^ (msg->ident >> 16)) * 16777619UL;
+    hash = (hash ^ len) * 16777619UL;
+    for (i = 0; i < len; i++) {
+        hash = (hash ^ msg->data[i]) * 16777619UL;
+    }
+    if (hash == 0) {
+        hash = 1;
+    }
+
+    if ((rx->timestamp.tv_sec != 0) || (rx->timestamp.tv_nsec != 0)) {
+        now_us = (uint64_t)rx->timestamp.tv_sec * 1000000U +
+                 (uint64_t)rx->timestamp.tv_nsec / 1000U;
+    }
+    else {
+        struct timespec now;
+
+        clock_gettime(CLOCK_REALTIME, &now);
+        now_us = (uint64_t)now.tv_sec * 1000000U + (uint64_t)now.tv_nsec / 1000U;
+    }
+
+    entry = &CANmodule->rxDup[hash & (CO_DRIVER_RX_DUP_TABLE_SIZE - 1)];
+
+    pthread_mutex_lock(&CANmodule->rxDupMutex);
+    if ((entry->hash == hash) && (entry->ident == msg->ident) &&
+        ((entry->interfaceMask & interfaceBit) == 0) &&
+        ((now_us - entry->time_us) < CANmodule->rxDupWindow_us ||
+         entry->time_us > now_us)) {
+        /* copy of a message from another interface */
+        entry->interfaceMask |= interfaceBit;
+        interface->linkStats.rxDuplicateCount ++;
+        duplicate = true;
+    }
+    else {
+        if (entry->hash != 0) {
+            /* previous message of this entry was missed by these interfaces */
+            uint32_t missed = allMask & ~entry->interfaceMask;
+
+            for (i = 0; missed != 0; i++, missed >>= 1) {
+                if ((missed & 1U) != 0) {
+                    CANmodule->CANinterfaces[i].linkStats.rxMissedCount ++;
+                }
+            }
+        }
+        entry->time_us = now_us;
+        entry->hash = hash;
+        entry->ident = msg->ident;
+        entry->interfaceMask = interfaceBit;
+    }
+    pthread_mutex_unlock(&CANmodule->rxDupMutex);
+
+    return duplicate;
+}
+#endif
+
+
+/******************************************************************************/
+void CO_CANmodule_disable(CO_CANmodule_t *CANmodule)
+{
+    uint32_t i;
+
+    if (CANmodule == NULL) {
+        return;
+    }
+
+    /* clear interfaces */
+    for (i = 0; i < CANmodule->CANinterfaceCount; i++) {
+        CO_CANinterface_t *interface = &CANmodule->CANinterfaces[i];
+
+#ifdef CO_DRIVER_ERROR_REPORTING
+        CO_CANerror_disable(&interface->errorhandler);
+#endif
+
+        epoll_ctl(interface->rxThread->fdEpoll, EPOLL_CTL_DEL, interface->fd, NULL);
+        close(interface->fd);
+        interface->fd = -1;
+
+        if (interface->rxThread != &CANmodule->rxThread) {
+            /* interface has its own rx thread */
+            CO_CANrxThread_free(interface->rxThread);
+        }
+        interface->rxThread = NULL;
+
+        if (interface->txQueue != NULL) {
+            free(interface->txQueue);
+        }
+        interface->txQueue = NULL;
+        interface->txQueueCount = 0;
+    }
+    if (CANmodule->CANinterfaces != NULL) {
+        free(CANmodule->CANinterfaces);
+    }
+    CANmodule->CANinterfaceCount = 0;
+
+    /* cancel rx */
+    CO_CANrxThread_free(&CANmodule->rxThread);
+
+    if (CANmodule->rxFilter != NULL) {
+        free(CANmodule->rxFilter);
+    }
+    CANmodule->rxFilter = NULL;
+
+#ifdef CO_DRIVER_RX_DISPATCH_TABLE
+    if (CANmodule->rxMaskedIndex != NULL) {
+        free(CANmodule->rxMaskedIndex);
+    }
+    CANmodule->rxMaskedIndex = NULL;
+    CANmodule->rxMaskedCount = 0;
+#endif
+
+#ifdef CO_DRIVER_MULTI_INTERFACE
+    if (CANmodule->rxDup != NULL) {
+        free(CANmodule->rxDup);
+    }
+    CANmodule->rxDup = NULL;
+    CANmodule->rxDupWindow_us = 0;
+    pthread_mutex_destroy(&CANmodule->rxDupMutex);
+#endif
+
+    pthread_mutex_destroy(&CANmodule->txMutex);
+}
+
+
+#ifdef CO_DRIVER_CAPTURE
+/******************************************************************************/
+void CO_CANmodule_setCapture(CO_CANmodule_t *CANmodule, struct CO_capture *capture)
+{
+    if (CANmodule == NULL) {
+        return;
+    }
+    /* tx side is synchronized by txMutex */
+    pthread_mutex_lock(&CANmodule->txMutex);
+    CANmodule->capture = capture;
+    pthread_mutex_unlock(&CANmodule->txMutex);
+}
+
+
+/** Current CLOCK_REALTIME for capture, same base as socket timestamps ********/
+static uint64_t CO_CANcaptureTime_us(void)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000000U + (uint64_t)now.tv_nsec / 1000U;
+}
+
+
+/** Add sent messages to capture, txMutex must be locked **********************/
+static void CO_CANcaptureTx(
+        CO_CANmodule_t         *CANmodule,
+        CO_CANinterface_t      *interface,
+        const void             *msg,
+        size_t                  msgSize,
+        uint16_t                count)
+{
+    struct CO_capture *capture = CANmodule->capture;
+    uint64_t now_us;
+    uint16_t i;
+
+    if ((capture == NULL) || (count == 0)) {
+        return;
+    }
+    now_us = CO_CANcaptureTime_us();
+    for (i = 0; i < count; i ++) {
+        /* CANopenNode can message is binary compatible to the socketCAN one */
+        CO_capture_add(capture, (const CO_CANrxMsg_t *)((const char *)msg + i * msgSize),
+                       now_us, (uint32_t)(interface - CANmodule->CANinterfaces),
+                       CO_CAPTURE_TX);
+    }
+}
+#endif
+
+
+/******************************************************************************/
+uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg)
+{
+    /* remove socketCAN flags */
+    return (uint16_t) (rxMsg->ident & CAN_SFF_MASK);
+}
+
+
+#ifdef CO_DRIVER_RX_TIMESTAMP
+/******************************************************************************/
+uint32_t CO_CANrxMsg_readTimestamp_us(const CO_CANrxMsg_t *rxMsg)
+{
+    /* rx callbacks get a pointer to the message inside the rx batch */
+    return ((const struct CO_CANrxBatch *)(const void *)rxMsg)->timestamp_us;
+}
+
+
+/******************************************************************************/
+uint32_t CO_CANtimestamp_us(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000U + (uint64_t)ts.tv_nsec / 1000U);
+}
+#endif
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANrxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint32_t                index,
+        uint32_t                ident,
+        uint32_t                mask,
+        bool_t                  rtr,
+        void                   *object,
+        void                  (*pFunct)(void *object, const CO_CANrxMsg_t *message))
+{
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    if((CANmodule!=NULL) && (index < CANmodule->rxSize)){
+        uint32_t i;
+        CO_CANrx_t *buffer;
+#ifdef CO_DRIVER_RX_DISPATCH_TABLE
+        uint32_t identCurrent;
+#endif
+
+        /* check if COB ID is already used */
+        for (i = 0; i < CANmodule->rxSize; i ++) {
+            buffer = &CANmodule->rxArray[i];
+
+            if (i!=index && ident>0 && ident==buffer->ident) {
+                log_printf(LOG_DEBUG, DBG_CAN_RX_PARAM_FAILED, "duplicate entry");
+                ret = CO_ERROR_ILLEGAL_ARGUMENT;
+            }
+        }
+
+        if (ret == CO_ERROR_NO) {
+            /* buffer, which will be configured */
+            buffer = &CANmodule->rxArray[index];
+
+#ifdef CO_DRIVER_RX_DISPATCH_TABLE
+            identCurrent = buffer->ident & CAN_SFF_MASK;
+            CO_CANsetRxMasked(CANmodule, index,
+                              (mask & CAN_SFF_MASK) != CAN_SFF_MASK);
+#endif
+
+            /* Configure object variables */
+            buffer->object = object;
+            buffer->pFunct = pFunct;
+#ifdef CO_DRIVER_MULTI_INTERFACE
+            buffer->CANbaseAddress = -1;
+            buffer->timestamp.tv_nsec = 0;
+            buffer->timestamp.tv_sec = 0;
 #endif
 
             /* CAN identifier and CAN mask, bit aligned with CAN module */
@@ -545,6 +1230,10 @@ CO_ReturnError_t CO_CANrxBufferInit(
                 buffer->ident |= CAN_RTR_FLAG;
             }
             buffer->mask = (mask & CAN_SFF_MASK) | CAN_EFF_FLAG | CAN_RTR_FLAG;
+#ifdef CO_DRIVER_RX_DISPATCH_TABLE
+            CO_CANrxSetIdentToIndex(CANmodule, identCurrent);
+            CO_CANrxSetIdentToIndex(CANmodule, buffer->ident & CAN_SFF_MASK);
+#endif
 
             /* Set CAN hardware module filter and mask. */
             CANmodule->rxFilter[index].can_id = buffer->ident;
@@ -650,15 +1339,233 @@ CO_ReturnError_t CO_CANtxBuffer_setInterface(
         if ((index == CO_INVALID_COB_ID) || (index > CANmodule->txSize)) {
             return CO_ERROR_PARAMETERS;
         }
-        CANmodule->txArray[index].CANbaseAddress = CANbaseAddressTx;
+        CANmodule->txArray[index].CANbaseAddress = CANbaseAddressTx;
+
+        return CO_ERROR_NO;
+    }
+    return CO_ERROR_PARAMETERS;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANtxRoute_add(
+        CO_CANmodule_t         *CANmodule,
+        uint32_t                ident,
+        int32_t                 CANbaseAddressTx)
+{
+    uint32_t i;
+
+    if ((CANmodule == NULL) || (ident >= CO_CAN_MSG_SFF_MAX_COB_ID)) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    for (i = 0; (i < CANmodule->CANinterfaceCount) &&
+                (i < CO_DRIVER_TX_ROUTE_INTERFACES); i++) {
+        if (CANmodule->CANinterfaces[i].CANbaseAddress == CANbaseAddressTx) {
+            pthread_mutex_lock(&CANmodule->txMutex);
+            CANmodule->txRoute[ident] |= 1UL << i;
+            pthread_mutex_unlock(&CANmodule->txMutex);
+            return CO_ERROR_NO;
+        }
+    }
+    return CO_ERROR_ILLEGAL_ARGUMENT;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANtxRoute_clear(
+        CO_CANmodule_t         *CANmodule,
+        uint32_t                ident)
+{
+    if ((CANmodule == NULL) || (ident >= CO_CAN_MSG_SFF_MAX_COB_ID)) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    pthread_mutex_lock(&CANmodule->txMutex);
+    CANmodule->txRoute[ident] = 0;
+    pthread_mutex_unlock(&CANmodule->txMutex);
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANtxRoute_learn(
+        CO_CANmodule_t         *CANmodule,
+        uint32_t                rxIdent,
+        uint32_t                txIdent)
+{
+    if ((CANmodule == NULL) || (rxIdent >= CO_CAN_MSG_SFF_MAX_COB_ID) ||
+        (txIdent >= CO_CAN_MSG_SFF_MAX_COB_ID)) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    CANmodule->rxRouteLearn[rxIdent] = (uint16_t)txIdent;
+    return CO_ERROR_NO;
+}
+
+
+/*
+ * Add interface of a received message to the learned tx route
+ */
+static void CO_CANtxRouteLearnRx(
+        CO_CANmodule_t         *CANmodule,
+        CO_CANinterface_t      *interface,
+        uint32_t                rxIdent)
+{
+    uint32_t txIdent;
+    uint32_t interfaceIndex;
+    uint32_t bit;
+
+    txIdent = CANmodule->rxRouteLearn[rxIdent & CAN_SFF_MASK];
+    interfaceIndex = (uint32_t)(interface - CANmodule->CANinterfaces);
+    if ((txIdent == CO_TX_ROUTE_NO_LEARN) ||
+        (interfaceIndex >= CO_DRIVER_TX_ROUTE_INTERFACES)) {
+        return;
+    }
+
+    /* Learned route mostly exists already, no lock needed to see this */
+    bit = 1UL << interfaceIndex;
+    if ((CANmodule->txRoute[txIdent] & bit) == 0) {
+        pthread_mutex_lock(&CANmodule->txMutex);
+        CANmodule->txRoute[txIdent] |= bit;
+        pthread_mutex_unlock(&CANmodule->txMutex);
+    }
+}
+
+#endif
+
+/** Enable/disable wakeup when socket gets writeable *************************/
+static void CO_CANtxQueuePollOut(
+        CO_CANmodule_t         *CANmodule,
+        CO_CANinterface_t      *interface,
+        bool_t                  enable)
+{
+    int ret;
+    struct epoll_event ev;
+
+    if (interface->txPollOut == enable) {
+        return;
+    }
+
+    ev.events = enable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    ev.data.ptr = interface;
+    ret = epoll_ctl(interface->rxThread->fdEpoll, EPOLL_CTL_MOD, interface->fd, &ev);
+    if (ret < 0) {
+        log_printf(LOG_DEBUG, DBG_ERRNO, "epoll_ctl(can)");
+        return;
+    }
+    interface->txPollOut = enable;
+}
+
+
+/** Add message to tx queue, txMutex must be locked ***************************/
+static CO_ReturnError_t CO_CANtxQueueAdd(
+        CO_CANinterface_t      *interface,
+        CO_CANtx_t             *buffer)
+{
+    struct CO_CANtxQueue *txQueue = interface->txQueue;
+
+    if (interface->txQueueCount >= CO_DRIVER_TX_QUEUE_SIZE) {
+        return CO_ERROR_TX_BUSY;
+    }
+
+    /* CANopenNode can message is binary compatible to the socketCAN one */
+    memcpy(&txQueue->msg[interface->txQueueCount], buffer, CO_CAN_FRAME_MTU(buffer->DLC));
+    txQueue->iov[interface->txQueueCount].iov_len = CO_CAN_FRAME_MTU(buffer->DLC);
+    txQueue->syncFlag[interface->txQueueCount] = buffer->syncFlag;
+    interface->txQueueCount ++;
+
+    return CO_ERROR_NO;
+}
+
+
+/** Raise SO_SNDBUF after socket tx queue was full, txMutex must be locked ****/
+static void CO_CANtxBufferRaise(
+        CO_CANmodule_t         *CANmodule,
+        CO_CANinterface_t      *interface)
+{
+    if (CANmodule->sndbufMax > 0 && !interface->sndbufLimit) {
+        CO_CANsocketBufferRaise(interface->fd, SO_SNDBUF, SO_SNDBUFFORCE,
+                                CANmodule->sndbufMax, &interface->sndbuf,
+                                &interface->sndbufLimit);
+    }
+}
+
+
+/** Send messages from tx queue, txMutex must be locked ***********************/
+static CO_ReturnError_t CO_CANtxQueueFlush(
+        CO_CANmodule_t         *CANmodule,
+        CO_CANinterface_t      *interface)
+{
+    int n;
+    uint16_t remaining;
+    struct CO_CANtxQueue *txQueue = interface->txQueue;
+
+    interface->txRetry = false;
+    if (interface->txQueueCount == 0) {
+        CO_CANtxQueuePollOut(CANmodule, interface, false);
+        return CO_ERROR_NO;
+    }
+
+    do {
+        errno = 0;
+        n = sendmmsg(interface->fd, txQueue->hdr, interface->txQueueCount,
+                     MSG_DONTWAIT);
+    } while ((n < 0) && (errno == EINTR));
+
+    if (n < 0) {
+        if (errno == EAGAIN) {
+            /* socket queue full, wait until it gets writeable */
+            CO_CANtxQueuePollOut(CANmodule, interface, true);
+            CO_CANtxBufferRaise(CANmodule, interface);
+            return CO_ERROR_TX_BUSY;
+        }
+        else if (errno == ENOBUFS) {
+            /* device queue full. socketCAN reports the socket as writeable in
+             * this case, so waiting for EPOLLOUT won't help. Queue is retried
+             * by CO_CANrxWait() after CO_DRIVER_TX_RETRY_MS. */
+            CO_CANtxQueuePollOut(CANmodule, interface, false);
+            interface->txRetry = true;
+            return CO_ERROR_TX_BUSY;
+        }
 
-        return CO_ERROR_NO;
+        /* unrecoverable, drop queue */
+#ifdef USE_EMERGENCY_OBJECT
+        CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW,
+                       CO_EMC_CAN_OVERRUN, interface->txQueueCount);
+#endif
+        CO_log_event(CO_LOG_CAN_TX_FAILED, interface->ifName,
+                     txQueue->msg[0].can_id, errno);
+        CANmodule->txOverflowCount += interface->txQueueCount;
+        interface->txQueueCount = 0;
+        CO_CANtxQueuePollOut(CANmodule, interface, false);
+        return CO_ERROR_TX_OVERFLOW;
     }
-    return CO_ERROR_PARAMETERS;
-}
 
+#ifdef CO_DRIVER_CAPTURE
+    CO_CANcaptureTx(CANmodule, interface, &txQueue->msg[0], sizeof(txQueue->msg[0]), n);
 #endif
 
+    /* move unsent messages to the beginning */
+    remaining = interface->txQueueCount - n;
+    if ((remaining > 0) && (n > 0)) {
+        uint16_t i;
+
+        memmove(&txQueue->msg[0], &txQueue->msg[n],
+                remaining * sizeof(txQueue->msg[0]));
+        memmove(&txQueue->syncFlag[0], &txQueue->syncFlag[n],
+                remaining * sizeof(txQueue->syncFlag[0]));
+        for (i = 0; i < remaining; i ++) {
+            txQueue->iov[i].iov_len = txQueue->iov[i + n].iov_len;
+        }
+    }
+    interface->txQueueCount = remaining;
+
+    CO_CANtxQueuePollOut(CANmodule, interface, remaining > 0);
+    return (remaining > 0) ? CO_ERROR_TX_BUSY : CO_ERROR_NO;
+}
+
+
 /******************************************************************************/
 static CO_ReturnError_t CO_CANCheckSendInterface(
         CO_CANmodule_t         *CANmodule,
@@ -670,10 +1577,16 @@ static CO_ReturnError_t CO_CANCheckSendInterface(
     CO_CANinterfaceState_t ifState;
 #endif
     ssize_t n;
+    size_t mtu;
 
     if (CANmodule==NULL || interface==NULL || interface->fd < 0) {
         return CO_ERROR_PARAMETERS;
     }
+    mtu = CO_CAN_FRAME_MTU(buffer->DLC);
+#ifdef CO_DRIVER_CAN_FD
+    /* CAN FD flags */
+    buffer->padding[0] = (mtu == CANFD_MTU) ? CANFD_BRS : 0;
+#endif
 
 #ifdef CO_DRIVER_ERROR_REPORTING
     ifState = CO_CANerror_txMsg(&interface->errorhandler);
@@ -689,35 +1602,69 @@ static CO_ReturnError_t CO_CANCheckSendInterface(
     }
 #endif
 
-    do {
-        errno = 0;
-        n = send(interface->fd, buffer, CAN_MTU, MSG_DONTWAIT);
-        if (errno == EINTR) {
-            /* try again */
-            continue;
+    pthread_mutex_lock(&CANmodule->txMutex);
+
+    if (CANmodule->txBatch || (interface->txQueueCount > 0)) {
+        /* keep message order, messages from queue are sent first */
+        err = CO_CANtxQueueAdd(interface, buffer);
+        if (err != CO_ERROR_NO) {
+            /* software queue full, message is lost */
+#ifdef USE_EMERGENCY_OBJECT
+            CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW,
+                           CO_EMC_CAN_OVERRUN, interface->txQueueCount);
+#endif
+            CO_log_event(CO_LOG_CAN_TX_BUSY, interface->ifName, buffer->ident, 0);
+            CANmodule->txOverflowCount ++;
+            err = CO_ERROR_TX_OVERFLOW;
         }
-        else if (errno == EAGAIN) {
-            /* socket queue full */
-            break;
+        if (!CANmodule->txBatch) {
+            (void)CO_CANtxQueueFlush(CANmodule, interface);
         }
-        else if (errno == ENOBUFS) {
-            /* socketCAN doesn't support blocking write. You can wait here for
-             * a few hundred us and then try again */
-            return CO_ERROR_TX_BUSY;
+        pthread_mutex_unlock(&CANmodule->txMutex);
+        return err;
+    }
+
+    do {
+        errno = 0;
+        n = send(interface->fd, buffer, mtu, MSG_DONTWAIT);
+    } while ((n < 0) && (errno == EINTR));
+
+    if ((n < 0) && ((errno == EAGAIN) || (errno == ENOBUFS))) {
+        /* socket queue full, message is sent later. See CO_CANtxQueueFlush()
+         * for ENOBUFS */
+        bool_t pollOut = (errno == EAGAIN);
+
+        err = CO_CANtxQueueAdd(interface, buffer);
+        if (err != CO_ERROR_NO) {
+#ifdef USE_EMERGENCY_OBJECT
+            CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW,
+                           CO_EMC_CAN_OVERRUN, interface->txQueueCount);
+#endif
+            CO_log_event(CO_LOG_CAN_TX_BUSY, interface->ifName, buffer->ident, errno);
+            CANmodule->txOverflowCount ++;
+            err = CO_ERROR_TX_OVERFLOW;
         }
-        else if (n != CAN_MTU) {
-            break;
+        CO_CANtxQueuePollOut(CANmodule, interface, pollOut);
+        interface->txRetry = !pollOut;
+        if (pollOut) {
+            CO_CANtxBufferRaise(CANmodule, interface);
         }
-    } while (errno != 0);
-
-    if(n != CAN_MTU){
+    }
+    else if(n != (ssize_t)mtu){
 #ifdef USE_EMERGENCY_OBJECT
         CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, 0);
 #endif
-        log_printf(LOG_ERR, DBG_CAN_TX_FAILED, buffer->ident, interface->ifName);
-        log_printf(LOG_DEBUG, DBG_ERRNO, "send()");
+        CO_log_event(CO_LOG_CAN_TX_SEND_FAILED, interface->ifName, buffer->ident, errno);
+        CANmodule->txOverflowCount ++;
         err = CO_ERROR_TX_OVERFLOW;
     }
+#ifdef CO_DRIVER_CAPTURE
+    else {
+        CO_CANcaptureTx(CANmodule, interface, buffer, sizeof(*buffer), 1);
+    }
+#endif
+
+    pthread_mutex_unlock(&CANmodule->txMutex);
 
     return err;
 }
@@ -733,8 +1680,10 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
 #ifdef USE_EMERGENCY_OBJECT
         CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, 0);
 #endif
-        log_printf(LOG_ERR, DBG_CAN_TX_FAILED, buffer->ident, "CANx");
-        log_printf(LOG_DEBUG, DBG_ERRNO, "send()");
+        CO_log_event(CO_LOG_CAN_TX_BUSY, NULL, buffer->ident, errno);
+        pthread_mutex_lock(&CANmodule->txMutex);
+        CANmodule->txOverflowCount ++;
+        pthread_mutex_unlock(&CANmodule->txMutex);
         err = CO_ERROR_TX_OVERFLOW;
     }
     return err;
@@ -746,13 +1695,26 @@ CO_ReturnError_t CO_CANCheckSend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
 {
     uint32_t i;
     CO_ReturnError_t err = CO_ERROR_NO;
+#ifdef CO_DRIVER_MULTI_INTERFACE
+    uint32_t route = CANmodule->txRoute[buffer->ident & CAN_SFF_MASK];
+#endif
 
     /* check on which interfaces to send this messages */
     for (i = 0; i < CANmodule->CANinterfaceCount; i++) {
         CO_CANinterface_t *interface = &CANmodule->CANinterfaces[i];
+        bool_t match;
 
-        if (buffer->CANbaseAddress < 0 ||
-            buffer->CANbaseAddress == interface->CANbaseAddress) {
+#ifdef CO_DRIVER_MULTI_INTERFACE
+        if (route != 0) {
+            match = (i < CO_DRIVER_TX_ROUTE_INTERFACES) && ((route & (1UL << i)) != 0);
+        }
+        else
+#endif
+        {
+            match = buffer->CANbaseAddress < 0 ||
+                    buffer->CANbaseAddress == interface->CANbaseAddress;
+        }
+        if (match) {
 
             CO_ReturnError_t tmp;
 
@@ -764,6 +1726,55 @@ CO_ReturnError_t CO_CANCheckSend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
             }
         }
     }
+    if (err == CO_ERROR_NO) {
+        CO_STAT_TX(CANmodule, buffer - CANmodule->txArray);
+        CO_STAT_BUS(CANmodule, buffer->DLC);
+    }
+
+    return err;
+}
+
+
+/******************************************************************************/
+void CO_CANtxBatchStart(CO_CANmodule_t *CANmodule)
+{
+    uint32_t i;
+
+    if (CANmodule != NULL) {
+        pthread_mutex_lock(&CANmodule->txMutex);
+        CANmodule->txBatch = true;
+        /* queue is not sent while the batch is open, EPOLLOUT would wake up
+         * the rx thread again and again. CO_CANtxBatchFlush() arms it again */
+        for (i = 0; i < CANmodule->CANinterfaceCount; i++) {
+            CO_CANtxQueuePollOut(CANmodule, &CANmodule->CANinterfaces[i], false);
+        }
+        pthread_mutex_unlock(&CANmodule->txMutex);
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANtxBatchFlush(CO_CANmodule_t *CANmodule)
+{
+    uint32_t i;
+    CO_ReturnError_t err = CO_ERROR_NO;
+
+    if (CANmodule == NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    pthread_mutex_lock(&CANmodule->txMutex);
+    CANmodule->txBatch = false;
+    for (i = 0; i < CANmodule->CANinterfaceCount; i++) {
+        CO_ReturnError_t tmp;
+
+        tmp = CO_CANtxQueueFlush(CANmodule, &CANmodule->CANinterfaces[i]);
+        if (tmp) {
+            /* only last error is returned to callee */
+            err = tmp;
+        }
+    }
+    pthread_mutex_unlock(&CANmodule->txMutex);
 
     return err;
 }
@@ -772,7 +1783,40 @@ CO_ReturnError_t CO_CANCheckSend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
 /******************************************************************************/
 void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule)
 {
-    /* Messages are either written to the socket queue or dropped */
+    uint32_t i;
+    uint16_t j;
+    uint16_t count;
+    uint32_t tpdoDeleted = 0U;
+
+    /* Messages already written to the socket queue can't be removed, only
+     * the ones still waiting in the tx queues */
+    pthread_mutex_lock(&CANmodule->txMutex);
+    for (i = 0; i < CANmodule->CANinterfaceCount; i++) {
+        CO_CANinterface_t *interface = &CANmodule->CANinterfaces[i];
+        struct CO_CANtxQueue *txQueue = interface->txQueue;
+
+        count = 0;
+        for (j = 0; j < interface->txQueueCount; j++) {
+            if (txQueue->syncFlag[j]) {
+                tpdoDeleted ++;
+                continue;
+            }
+            if (count != j) {
+                txQueue->msg[count] = txQueue->msg[j];
+                txQueue->iov[count].iov_len = txQueue->iov[j].iov_len;
+                txQueue->syncFlag[count] = txQueue->syncFlag[j];
+            }
+            count ++;
+        }
+        interface->txQueueCount = count;
+    }
+    pthread_mutex_unlock(&CANmodule->txMutex);
+
+#ifdef USE_EMERGENCY_OBJECT
+    if(tpdoDeleted != 0U){
+        CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_TPDO_OUTSIDE_WINDOW, CO_EMC_COMMUNICATION, tpdoDeleted);
+    }
+#endif
 }
 
 
@@ -788,83 +1832,223 @@ void CO_CANverifyErrors(CO_CANmodule_t *CANmodule)
 /******************************************************************************/
 static CO_ReturnError_t CO_CANread(
         CO_CANmodule_t         *CANmodule,
-        CO_CANinterface_t      *interface,
-        struct can_frame       *msg,
-        struct timespec        *timestamp)
+        CO_CANrxThread_t       *rxThread,
+        uint32_t                interfaceIndex)
 {
     int32_t n;
+    int32_t i;
+    uint16_t count;
     uint32_t dropped;
-    /* recvmsg - like read, but generates statistics about the socket
-     * example in berlios candump.c */
-    struct iovec iov;
-    struct msghdr msghdr;
-    char ctrlmsg[CMSG_SPACE(sizeof(struct timeval)) + CMSG_SPACE(sizeof(dropped))];
+    bool_t rxDrops = false;
+    CO_CANinterface_t *interface = &CANmodule->CANinterfaces[interfaceIndex];
     struct cmsghdr *cmsg;
+#ifdef CO_DRIVER_RX_TIMESTAMP
+    struct timespec now;
+    uint64_t nowMono_us;
+    uint64_t nowReal_us;
+#endif
+#ifdef CO_DRIVER_CAPTURE
+    struct CO_capture *capture = CANmodule->capture;
+    uint64_t captureNow_us = 0;
+#endif
 
-    iov.iov_base = msg;
-    iov.iov_len = sizeof(*msg);
+    for (i = 0; i < rxThread->rxBatchSize; i ++) {
+        struct msghdr *msghdr = &rxThread->rxBatchHdr[i].msg_hdr;
 
-    msghdr.msg_name = NULL;
-    msghdr.msg_namelen = 0;
-    msghdr.msg_iov = &iov;
-    msghdr.msg_iovlen = 1;
-    msghdr.msg_control = &ctrlmsg;
-    msghdr.msg_controllen = sizeof(ctrlmsg);
-    msghdr.msg_flags = 0;
+        msghdr->msg_control = rxThread->rxBatch[i].ctrlmsg;
+        msghdr->msg_controllen = sizeof(rxThread->rxBatch[i].ctrlmsg);
+        msghdr->msg_flags = 0;
+    }
 
-    n = recvmsg(interface->fd, &msghdr, 0);
-    if (n != CAN_MTU) {
+    /* recvmmsg - like recvmsg, but gets all messages that are already waiting
+     * in the socket queue (up to batch size) with one call. Socket is known to
+     * be readable, so don't block here. */
+    n = recvmmsg(interface->fd, rxThread->rxBatchHdr, rxThread->rxBatchSize,
+                 MSG_DONTWAIT, NULL);
+    if (n < 1) {
 #ifdef USE_EMERGENCY_OBJECT
         CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_RXB_OVERFLOW,
                        CO_EMC_CAN_OVERRUN, n);
 #endif
-        log_printf(LOG_DEBUG, DBG_CAN_RX_FAILED, interface->ifName);
-        log_printf(LOG_DEBUG, DBG_ERRNO, "recvmsg()");
+        CO_log_event(CO_LOG_CAN_RX_FAILED, interface->ifName, (uint32_t)n, errno);
         return CO_ERROR_SYSCALL;
     }
 
-    /* check for rx queue overflow, get rx time */
-    for (cmsg = CMSG_FIRSTHDR(&msghdr);
-         cmsg && (cmsg->cmsg_level == SOL_SOCKET);
-         cmsg = CMSG_NXTHDR(&msghdr, cmsg)) {
-        if (cmsg->cmsg_type == SO_TIMESTAMPING) {
-            /* this is system time, not monotonic time! */
-            *timestamp = ((struct timespec*)CMSG_DATA(cmsg))[0];
+#ifdef CO_DRIVER_RX_TIMESTAMP
+    /* system time to monotonic time offset, once for the whole batch */
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    nowMono_us = (uint64_t)now.tv_sec * 1000000U + (uint64_t)now.tv_nsec / 1000U;
+    (void)clock_gettime(CLOCK_REALTIME, &now);
+    nowReal_us = (uint64_t)now.tv_sec * 1000000U + (uint64_t)now.tv_nsec / 1000U;
+#endif
+#ifdef CO_DRIVER_CAPTURE
+    if (capture != NULL) {
+        captureNow_us = CO_CANcaptureTime_us();
+    }
+#endif
+
+    interface->rxFrameCount += (uint32_t)n;
+    count = 0;
+    for (i = 0; i < n; i ++) {
+        struct msghdr *msghdr = &rxThread->rxBatchHdr[i].msg_hdr;
+        struct CO_CANrxBatch *rx = &rxThread->rxBatch[i];
+        struct CO_CANrxBatch *rxStore = &rxThread->rxBatch[count];
+
+#ifdef CO_DRIVER_CAN_FD
+        if ((rxThread->rxBatchHdr[i].msg_len != CAN_MTU) &&
+            (rxThread->rxBatchHdr[i].msg_len != CANFD_MTU)) {
+#else
+        if (rxThread->rxBatchHdr[i].msg_len != CAN_MTU) {
+#endif
+            /* skip this one */
+#ifdef USE_EMERGENCY_OBJECT
+            CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_RXB_OVERFLOW,
+                           CO_EMC_CAN_OVERRUN, rxThread->rxBatchHdr[i].msg_len);
+#endif
+            CO_log_event(CO_LOG_CAN_RX_LENGTH, interface->ifName,
+                         rxThread->rxBatchHdr[i].msg_len, 0);
+            continue;
         }
-        else if (cmsg->cmsg_type == SO_RXQ_OVFL) {
-            dropped = *(uint32_t*)CMSG_DATA(cmsg);
-            if (dropped > CANmodule->rxDropCount) {
+
+        /* check for rx queue overflow, get rx time */
+        rx->timestamp.tv_sec = 0;
+        rx->timestamp.tv_nsec = 0;
+        for (cmsg = CMSG_FIRSTHDR(msghdr);
+             cmsg && (cmsg->cmsg_level == SOL_SOCKET);
+             cmsg = CMSG_NXTHDR(msghdr, cmsg)) {
+            if (cmsg->cmsg_type == SO_TIMESTAMPING) {
+                /* this is system time, not monotonic time! */
+                rx->timestamp = ((struct timespec*)CMSG_DATA(cmsg))[0];
+            }
+            else if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+                /* counter of the socket since its creation */
+                dropped = *(uint32_t*)CMSG_DATA(cmsg);
+                if (dropped != interface->rxDropSocket) {
+                    uint32_t newDrops = dropped - interface->rxDropSocket;
+
+                    interface->rxDropSocket = dropped;
+                    interface->rxDropCount += newDrops;
+                    CANmodule->rxDropCount += newDrops;
 #ifdef USE_EMERGENCY_OBJECT
-                CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_RXB_OVERFLOW,
-                               CO_EMC_COMMUNICATION, 0);
+                    CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_RXB_OVERFLOW,
+                                   CO_EMC_COMMUNICATION, 0);
+#endif
+                    CO_log_event(CO_LOG_CAN_RX_QUEUE_OVERFLOW, interface->ifName,
+                                 dropped, 0);
+                    rxDrops = true;
+                }
+            }
+        }
+
+#ifdef CO_DRIVER_RX_TIMESTAMP
+        if ((rx->timestamp.tv_sec == 0) && (rx->timestamp.tv_nsec == 0)) {
+            /* no time from socket, use time of read */
+            rx->timestamp_us = (uint32_t)nowMono_us;
+        }
+        else {
+            uint64_t rx_us = (uint64_t)rx->timestamp.tv_sec * 1000000U +
+                             (uint64_t)rx->timestamp.tv_nsec / 1000U;
+
+            /* messages are older than "now" */
+            rx->timestamp_us = (rx_us < nowReal_us) ?
+                (uint32_t)(nowMono_us - (nowReal_us - rx_us)) : (uint32_t)nowMono_us;
+        }
 #endif
-                log_printf(LOG_ERR, CAN_RX_SOCKET_QUEUE_OVERFLOW,
-                           interface->ifName, dropped);
+
+#ifdef CO_DRIVER_CAPTURE
+        if (capture != NULL) {
+            uint64_t rx_us = captureNow_us;
+
+            if ((rx->timestamp.tv_sec != 0) || (rx->timestamp.tv_nsec != 0)) {
+                rx_us = (uint64_t)rx->timestamp.tv_sec * 1000000U +
+                        (uint64_t)rx->timestamp.tv_nsec / 1000U;
             }
-            CANmodule->rxDropCount = dropped;
-            //todo use this info!
+            CO_capture_add(capture, (const CO_CANrxMsg_t *)&rx->msg, rx_us,
+                           interfaceIndex, CO_CAPTURE_RX);
+        }
+#endif
+
+        /* keep valid messages at the beginning of the batch */
+        if (rxStore != rx) {
+            rxStore->msg = rx->msg;
+            rxStore->timestamp = rx->timestamp;
+#ifdef CO_DRIVER_RX_TIMESTAMP
+            rxStore->timestamp_us = rx->timestamp_us;
+#endif
         }
+        count ++;
     }
 
-    return CO_ERROR_NO;
+    if (rxDrops) {
+        /* socket queue was too short for this burst, see
+         * CO_CANmodule_setBufferTuning() */
+        if (CANmodule->rcvbufMax > 0 && !interface->rcvbufLimit) {
+            CO_CANsocketBufferRaise(interface->fd, SO_RCVBUF, SO_RCVBUFFORCE,
+                                    CANmodule->rcvbufMax, &interface->rcvbuf,
+                                    &interface->rcvbufLimit);
+        }
+        if (CANmodule->rxPriority > 0) {
+            CO_CANrxRaisePriority(CANmodule->rxPriority);
+        }
+    }
+
+    rxThread->rxBatchCount = count;
+    rxThread->rxBatchNext = 0;
+    rxThread->rxBatchInterface = interfaceIndex;
+
+    return (count > 0) ? CO_ERROR_NO : CO_ERROR_SYSCALL;
 }
 
 static int32_t CO_CANrxMsg(
         CO_CANmodule_t        *CANmodule,
-        struct can_frame      *msg,
+        CO_CANframe_t         *msg,
         CO_CANrxMsg_t         *buffer)
 {
     int32_t retval;
     const CO_CANrxMsg_t *rcvMsg;  /* pointer to received message in CAN module */
-    uint16_t index;               /* index of received message */
+    uint16_t index = 0;           /* index of received message */
     CO_CANrx_t *rcvMsgObj = NULL; /* receive message object from CO_CANmodule_t object. */
     bool_t msgMatched = false;
+#ifdef CO_DRIVER_RX_DISPATCH_TABLE
+    uint32_t lookup;
+    uint16_t i;
+#endif
 
     /* CANopenNode can message is binary compatible to the socketCAN one, except
      * for extension flags */
     msg->can_id &= CAN_EFF_MASK;
     rcvMsg = (CO_CANrxMsg_t *)msg;
+    CO_STAT_BUS(CANmodule, rcvMsg->DLC);
+
+#ifdef CO_DRIVER_RX_DISPATCH_TABLE
+    /* Message has been received. Get rx buffer with the same CAN-ID from
+     * lookup table, search only masked rx buffers if this fails. */
+    lookup = CO_CANgetIndexFromIdent(CANmodule->rxIdentToIndex,
+                                     rcvMsg->ident & CAN_SFF_MASK);
+    if (lookup < CANmodule->rxSize) {
+        index = (uint16_t) lookup;
+        rcvMsgObj = &CANmodule->rxArray[index];
+        if(((rcvMsg->ident ^ rcvMsgObj->ident) & rcvMsgObj->mask) == 0U){
+            msgMatched = true;
+        }
+    }
+    /* A masked buffer before the found one takes precedence, the same as with
+     * linear search. List is sorted by index. */
+    for (i = 0; i < CANmodule->rxMaskedCount; i ++) {
+        uint16_t masked = CANmodule->rxMaskedIndex[i];
 
+        if (msgMatched && (masked >= index)) {
+            break;
+        }
+        if(((rcvMsg->ident ^ CANmodule->rxArray[masked].ident) &
+            CANmodule->rxArray[masked].mask) == 0U){
+            index = masked;
+            rcvMsgObj = &CANmodule->rxArray[index];
+            msgMatched = true;
+            break;
+        }
+    }
+#else
     /* Message has been received. Search rxArray from CANmodule for the
      * same CAN-ID. */
     rcvMsgObj = &CANmodule->rxArray[0];
@@ -875,10 +2059,14 @@ static int32_t CO_CANrxMsg(
         }
         rcvMsgObj++;
     }
+#endif
     if(msgMatched) {
         /* Call specific function, which will process the message */
         if ((rcvMsgObj != NULL) && (rcvMsgObj->pFunct != NULL)){
+            CO_TP_BEGIN(CO_TP_RX_CALLBACK, rcvMsgObj - CANmodule->rxArray);
+            CO_STAT_RX(CANmodule, rcvMsgObj - CANmodule->rxArray);
             rcvMsgObj->pFunct(rcvMsgObj->object, rcvMsg);
+            CO_TP_END(CO_TP_RX_CALLBACK, rcvMsgObj - CANmodule->rxArray);
         }
         /* return message */
         if (buffer != NULL) {
@@ -894,39 +2082,201 @@ static int32_t CO_CANrxMsg(
 }
 
 /******************************************************************************/
+static int32_t CO_CANrxEvaluate(
+        CO_CANmodule_t        *CANmodule,
+        CO_CANinterface_t     *interface,
+        struct CO_CANrxBatch  *rx,
+        CO_CANrxMsg_t         *buffer)
+{
+    int32_t retval;
+
+    retval = -1;
+    if(CANmodule->CANnormal){
+
+        if (rx->msg.can_id & CAN_ERR_FLAG) {
+            /* error msg */
+#ifdef CO_DRIVER_ERROR_REPORTING
+            /* error messages are classic CAN frames */
+            CO_CANerror_rxMsgError(&interface->errorhandler, (struct can_frame *)&rx->msg);
+#endif
+        }
+        else {
+            /* data msg */
+            int32_t msgIndex;
+
+#ifdef CO_DRIVER_ERROR_REPORTING
+            CO_CANerror_rxMsg(&interface->errorhandler);
+#endif
+
+#ifdef CO_DRIVER_MULTI_INTERFACE
+            /* rx threads of other interfaces may run in parallel, reader
+             * copies the whole struct */
+            pthread_mutex_lock(&CANmodule->rxDupMutex);
+            interface->linkStats.rxCount ++;
+            interface->linkStats.rxLast = rx->timestamp;
+            pthread_mutex_unlock(&CANmodule->rxDupMutex);
+
+            /* before callback, which may already answer */
+            if ((rx->msg.can_id & CAN_EFF_FLAG) == 0) {
+                CO_CANtxRouteLearnRx(CANmodule, interface, rx->msg.can_id);
+            }
+
+            /* only first copy from redundant interfaces */
+            if ((CANmodule->rxDup != NULL) &&
+                CO_CANrxDuplicate(CANmodule, interface, rx)) {
+                return -1;
+            }
+#endif
+            msgIndex = CO_CANrxMsg(CANmodule, &rx->msg, buffer);
+            if (msgIndex > -1) {
+#ifdef CO_DRIVER_MULTI_INTERFACE
+                /* Store message info */
+                CANmodule->rxArray[msgIndex].timestamp = rx->timestamp;
+                CANmodule->rxArray[msgIndex].CANbaseAddress = interface->CANbaseAddress;
+#endif
+            }
+            retval = msgIndex;
+        }
+    }
+    return retval;
+}
+
+#ifdef CO_DRIVER_CAPTURE
+/******************************************************************************/
+int32_t CO_CANrxReplay(CO_CANmodule_t *CANmodule, struct CO_replay *replay,
+                       CO_CANrxMsg_t *buffer)
+{
+    CO_captureRecord_t record;
+    struct CO_CANrxBatch rx;
+    CO_CANrxMsg_t *msg = (CO_CANrxMsg_t *)&rx.msg;
+    uint32_t interfaceIndex;
+
+    if (CANmodule==NULL || replay==NULL || CANmodule->CANinterfaceCount==0) {
+        return -2;
+    }
+    if (!CO_replay_next(replay, &record)) {
+        return -2;
+    }
+
+    /* rebuild rx batch entry, as read by CO_CANread() */
+    if (record.DLC > CO_CAN_DATA_MAX) {
+        record.DLC = CO_CAN_DATA_MAX;
+    }
+    memset(&rx, 0, sizeof(rx));
+    msg->ident = record.ident;
+    msg->DLC = record.DLC;
+    msg->padding[0] = record.flags;
+    memcpy(msg->data, record.data, record.DLC);
+    rx.timestamp.tv_sec = (time_t)(record.timestamp_us / 1000000U);
+    rx.timestamp.tv_nsec = (long)(record.timestamp_us % 1000000U) * 1000L;
+#ifdef CO_DRIVER_RX_TIMESTAMP
+    rx.timestamp_us = CO_CANtimestamp_us();
+#endif
+
+    interfaceIndex = record.interface;
+    if (interfaceIndex >= CANmodule->CANinterfaceCount) {
+        interfaceIndex = 0;
+    }
+    return CO_CANrxEvaluate(CANmodule, &CANmodule->CANinterfaces[interfaceIndex],
+                            &rx, buffer);
+}
+#endif
+
+/******************************************************************************/
+#ifndef CO_DRIVER_MULTI_INTERFACE
+static int32_t CO_CANrxWaitThread(CO_CANmodule_t *CANmodule, CO_CANrxThread_t *rxThread,
+                                  int fdTimer, CO_CANrxMsg_t *buffer);
+#endif
+
 int32_t CO_CANrxWait(CO_CANmodule_t *CANmodule, int fdTimer, CO_CANrxMsg_t *buffer)
+{
+    if (CANmodule==NULL) {
+        return -1;
+    }
+    return CO_CANrxWaitThread(CANmodule, &CANmodule->rxThread, fdTimer, buffer);
+}
+
+/******************************************************************************/
+#ifndef CO_DRIVER_MULTI_INTERFACE
+static
+#endif
+int32_t CO_CANrxWaitThread(CO_CANmodule_t *CANmodule, CO_CANrxThread_t *rxThread,
+                           int fdTimer, CO_CANrxMsg_t *buffer)
 {
     int32_t retval;
     int32_t ret;
-    int32_t CANbaseAddress __attribute__((unused));
+    int32_t i;
+    bool_t done;
+    bool_t wakeup;
     CO_ReturnError_t err;
-    CO_CANinterface_t *interface = NULL;
-    struct epoll_event ev[1];
-    struct can_frame msg;
-    struct timespec timestamp;
+    CO_CANinterface_t *interface;
+    struct epoll_event ev[CO_DRIVER_EPOLL_EVENTS];
+    CO_CANframe_t msg;
 
-    if (CANmodule==NULL || CANmodule->CANinterfaceCount==0) {
+    if (CANmodule==NULL || rxThread==NULL || CANmodule->CANinterfaceCount==0) {
         return -1;
     }
 
-    if (fdTimer>=0 && fdTimer!=CANmodule->fdTimerRead) {
+    if (fdTimer>=0 && fdTimer!=rxThread->fdTimerRead) {
         /* new timer, timer changed */
-        epoll_ctl(CANmodule->fdEpoll, EPOLL_CTL_DEL, CANmodule->fdTimerRead, NULL);
+        epoll_ctl(rxThread->fdEpoll, EPOLL_CTL_DEL, rxThread->fdTimerRead, NULL);
         ev[0].events = EPOLLIN;
-        ev[0].data.fd = fdTimer;
-        ret = epoll_ctl(CANmodule->fdEpoll, EPOLL_CTL_ADD, ev[0].data.fd, &ev[0]);
+        ev[0].data.ptr = &rxThread->fdTimerRead;
+        ret = epoll_ctl(rxThread->fdEpoll, EPOLL_CTL_ADD, fdTimer, &ev[0]);
         if(ret < 0){
             return -1;
         }
-        CANmodule->fdTimerRead = fdTimer;
+        rxThread->fdTimerRead = fdTimer;
+    }
+
+    /*
+     * evaluate messages left from last batch (manual mode). In automatic mode
+     * all of them are evaluated at once.
+     */
+    if (rxThread->rxBatchNext < rxThread->rxBatchCount) {
+        interface = &CANmodule->CANinterfaces[rxThread->rxBatchInterface];
+        retval = -1;
+        do {
+            ret = CO_CANrxEvaluate(CANmodule, interface,
+                &rxThread->rxBatch[rxThread->rxBatchNext], buffer);
+            rxThread->rxBatchNext ++;
+            if ((buffer != NULL) || (ret > -1)) {
+                retval = ret;
+            }
+        } while ((buffer == NULL) &&
+                 (rxThread->rxBatchNext < rxThread->rxBatchCount));
+        return retval;
     }
+    rxThread->rxBatchCount = 0;
+    rxThread->rxBatchNext = 0;
 
     /*
-     * blocking read using epoll
+     * blocking read using epoll. All ready sources are handled, wait again
+     * if there was nothing to return (only tx or error events)
      */
+    retval = -1;
+    done = false;
+    wakeup = false;
     do {
+        int timeout = -1;
+
+        /* tx queue waits for a free device queue */
+        for (i = 0; i < (int32_t)CANmodule->CANinterfaceCount; i ++) {
+            interface = &CANmodule->CANinterfaces[i];
+            if ((interface->rxThread == rxThread) && interface->txRetry) {
+                pthread_mutex_lock(&CANmodule->txMutex);
+                if (!CANmodule->txBatch && interface->txRetry) {
+                    (void)CO_CANtxQueueFlush(CANmodule, interface);
+                }
+                pthread_mutex_unlock(&CANmodule->txMutex);
+                if (interface->txRetry) {
+                    timeout = CO_DRIVER_TX_RETRY_MS;
+                }
+            }
+        }
+
         errno = 0;
-        ret = epoll_wait(CANmodule->fdEpoll, ev, sizeof(ev) / sizeof(ev[0]), -1);
+        ret = epoll_wait(rxThread->fdEpoll, ev, CO_DRIVER_EPOLL_EVENTS, timeout);
         if (errno == EINTR) {
             /* try again */
             continue;
@@ -935,73 +2285,84 @@ int32_t CO_CANrxWait(CO_CANmodule_t *CANmodule, int fdTimer, CO_CANrxMsg_t *buff
             /* epoll failed */
             return -1;
         }
-        else if ((ev[0].events & (EPOLLERR | EPOLLHUP)) != 0) {
-            /* epoll detected close/error on socket. Try to pull event */
-            errno = 0;
-            recv(ev[0].data.fd, &msg, sizeof(msg), MSG_DONTWAIT);
-            log_printf(LOG_DEBUG, DBG_CAN_RX_EPOLL, ev[0].events, strerror(errno));
-            continue;
-        }
-        else if ((ev[0].events & EPOLLIN) != 0) {
-            /* one of the sockets is ready */
-            if ((ev[0].data.fd == CO_NotifyPipeGetFd(CANmodule->pipe)) ||
-                (ev[0].data.fd == fdTimer)) {
-                /* timer/pipe socket */
-                return -1;
+
+        for (i = 0; i < ret; i ++) {
+            if (ev[i].data.ptr == rxThread->pipe) {
+                /* notification, all pending events are consumed at once */
+                CO_NotifyPipeDrain(rxThread->pipe);
+                wakeup = true;
+                done = true;
+                continue;
+            }
+            if (ev[i].data.ptr == &rxThread->fdTimerRead) {
+                /* timer socket, fd is read by the caller */
+                wakeup = true;
+                done = true;
+                continue;
+            }
+
+            /* CAN socket */
+            interface = (CO_CANinterface_t *)ev[i].data.ptr;
+            if ((ev[i].events & (EPOLLERR | EPOLLHUP)) != 0) {
+                /* epoll detected close/error on socket. Try to pull event */
+                errno = 0;
+                recv(interface->fd, &msg, sizeof(msg), MSG_DONTWAIT);
+                CO_log_event(CO_LOG_CAN_RX_EPOLL, interface->ifName, ev[i].events, errno);
+                continue;
+            }
+            if ((ev[i].events & EPOLLOUT) != 0) {
+                /* CAN socket is writeable again, send tx queue. Batch is
+                 * sent by CO_CANtxBatchFlush() */
+                pthread_mutex_lock(&CANmodule->txMutex);
+                if (!CANmodule->txBatch) {
+                    (void)CO_CANtxQueueFlush(CANmodule, interface);
+                }
+                else {
+                    CO_CANtxQueuePollOut(CANmodule, interface, false);
+                }
+                pthread_mutex_unlock(&CANmodule->txMutex);
             }
-            else {
-                /* CAN socket */
-                uint32_t i;
-
-                for (i = 0; i < CANmodule->CANinterfaceCount; i ++) {
-                    interface = &CANmodule->CANinterfaces[i];
-
-                    if (ev[0].data.fd == interface->fd) {
-                        /* get interface handle */
-                        CANbaseAddress = interface->CANbaseAddress;
-                        /* get message */
-                        err = CO_CANread(CANmodule, interface, &msg, &timestamp);
-                        if (err != CO_ERROR_NO) {
-                            return -1;
+            if (((ev[i].events & EPOLLIN) != 0) &&
+                ((buffer == NULL) || (rxThread->rxBatchCount == 0))) {
+                /* get messages. In manual mode, other interfaces stay
+                 * readable for the next call */
+                err = CO_CANread(CANmodule, rxThread,
+                                 (uint32_t)(interface - CANmodule->CANinterfaces));
+                if (err != CO_ERROR_NO) {
+                    return -1;
+                }
+                done = true;
+                if (buffer == NULL) {
+                    /* automatic mode, evaluate the whole batch right now.
+                     * Only the last matched index is returned, see
+                     * CO_CANrxWait() */
+                    while (rxThread->rxBatchNext < rxThread->rxBatchCount) {
+                        int32_t msgIndex = CO_CANrxEvaluate(CANmodule, interface,
+                            &rxThread->rxBatch[rxThread->rxBatchNext], NULL);
+                        rxThread->rxBatchNext ++;
+                        if (msgIndex > -1) {
+                            retval = msgIndex;
                         }
-                        /* no need to continue search */
-                        break;
                     }
+                    rxThread->rxBatchCount = 0;
+                    rxThread->rxBatchNext = 0;
                 }
             }
         }
-    } while (errno != 0);
-
-    /*
-     * evaluate Rx
-     */
-    retval = -1;
-    if(CANmodule->CANnormal){
-
-        if (msg.can_id & CAN_ERR_FLAG) {
-            /* error msg */
-#ifdef CO_DRIVER_ERROR_REPORTING
-            CO_CANerror_rxMsgError(&interface->errorhandler, &msg);
-#endif
-        }
-        else {
-            /* data msg */
-            int32_t msgIndex;
-
-#ifdef CO_DRIVER_ERROR_REPORTING
-            CO_CANerror_rxMsg(&interface->errorhandler);
-#endif
+    } while (!done);
 
-            msgIndex = CO_CANrxMsg(CANmodule, &msg, buffer);
-            if (msgIndex > -1) {
-#ifdef CO_DRIVER_MULTI_INTERFACE
-                /* Store message info */
-                CANmodule->rxArray[msgIndex].timestamp = timestamp;
-                CANmodule->rxArray[msgIndex].CANbaseAddress = CANbaseAddress;
-#endif
-            }
-            retval = msgIndex;
-        }
+    if (wakeup) {
+        /* timer/notification takes precedence. In manual mode, the new batch
+         * is returned with the next call */
+        return -1;
     }
+    if ((buffer != NULL) && (rxThread->rxBatchCount > 0)) {
+        /* manual mode, return first message of the new batch */
+        interface = &CANmodule->CANinterfaces[rxThread->rxBatchInterface];
+        retval = CO_CANrxEvaluate(CANmodule, interface,
+            &rxThread->rxBatch[rxThread->rxBatchNext], buffer);
+        rxThread->rxBatchNext ++;
+    }
+
     return retval;
 }
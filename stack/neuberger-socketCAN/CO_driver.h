@@ -76,9 +76,130 @@ extern "C" {
  * you need to enable error reporting in your kernel driver using
  * "ip link set canX type can berr-reporting on". Of course, the kernel
  * driver for your hardware needs this functionallity to be implemented...
+ *
+ * Errors on the rx and tx path are logged deferred and rate limited from
+ * threadMain_process(), see CO_log.h.
  */
 //#define CO_DRIVER_ERROR_REPORTING
 
+/**
+ * @name rx dispatch table
+ *
+ * Enable this to resolve received messages through a COB ID to rx buffer
+ * lookup table instead of searching the whole _rxArray_. Only rx buffers
+ * which are configured with a mask other than 0x7FF are still searched
+ * linearly. This needs 8kB of additional RAM per CAN module. It is always
+ * enabled together with multi interface support, as the lookup tables are
+ * needed there anyway.
+ */
+//#define CO_DRIVER_RX_DISPATCH_TABLE
+
+#if defined CO_DRIVER_MULTI_INTERFACE && !defined CO_DRIVER_RX_DISPATCH_TABLE
+  #define CO_DRIVER_RX_DISPATCH_TABLE
+#endif
+
+/**
+ * @name tx routing
+ *
+ * With #CO_DRIVER_MULTI_INTERFACE, transmitted messages can be routed per
+ * COB ID to a set of interfaces, see CO_CANtxRoute_add(). Routes are bit
+ * masks over the interface list, so only the first interfaces added with
+ * CO_CANmodule_addInterface() can be used as route targets.
+ */
+#define CO_DRIVER_TX_ROUTE_INTERFACES 32
+
+/**
+ * @name rx duplicate table size
+ *
+ * Number of entries of the duplicate suppression table for redundant
+ * interfaces, see CO_CANrxDuplicate_init(). Must be a power of two. One entry
+ * is needed for each message received within the time window, collisions
+ * let duplicates through.
+ */
+#ifndef CO_DRIVER_RX_DUP_TABLE_SIZE
+  #define CO_DRIVER_RX_DUP_TABLE_SIZE 256
+#endif
+
+/**
+ * @name rx timestamps
+ *
+ * Enable this to take the reception time of every message from the socket
+ * (SO_TIMESTAMPING). The time is converted to CLOCK_MONOTONIC once per rx
+ * batch and can be read inside the receive callback with
+ * CO_CANrxMsg_readTimestamp_us(). With #CO_USE_STATISTICS, the SYNC and RPDO
+ * reception times and the PDO latencies (see CO_statistics.h) are then based
+ * on the kernel rx time instead of the time of the callback.
+ */
+//#define CO_DRIVER_RX_TIMESTAMP
+
+/**
+ * @name CAN FD
+ *
+ * Enable this to use CAN FD frames with up to 64 data bytes. The sockets are
+ * switched to CAN_RAW_FD_FRAMES, CO_CANrxMsg_t and CO_CANtx_t get 64 data
+ * bytes and PDOs can be mapped up to #CO_PDO_MAX_SIZE = 64 bytes. Messages
+ * with up to 8 bytes are still sent as classic CAN frames, so SDO, NMT, EMCY
+ * and other fixed size services stay compatible. Longer messages are sent as
+ * CAN FD frames with bit rate switch. The interface must be configured for
+ * CAN FD by the OS, e.g. "ip link set canX type can bitrate 500000 dbitrate
+ * 2000000 fd on".
+ */
+//#define CO_DRIVER_CAN_FD
+
+/**
+ * @name frame capture
+ *
+ * Enable this to record all received and sent frames of the driver into a
+ * capture ring, which is written to a file, and to replay recordings with
+ * CO_CANrxReplay(). See CO_capture.h.
+ */
+//#define CO_DRIVER_CAPTURE
+
+/**
+ * @name rx batch size
+ *
+ * Maximum number of CAN messages read from one socket with a single
+ * recvmmsg() call inside CO_CANrxWait(). The value is taken over by
+ * CO_CANmodule_init(). If set to "1", every received message needs its own
+ * syscall.
+ */
+#ifndef CO_DRIVER_RX_BATCH_SIZE
+  #define CO_DRIVER_RX_BATCH_SIZE 32
+#endif
+
+/**
+ * @name tx queue size
+ *
+ * Number of CAN messages which are buffered in software per interface. Messages
+ * are queued while a tx batch is collected (see CO_CANtxBatchStart()) or if the
+ * socket queue is full. Queued messages are sent with sendmmsg().
+ */
+#ifndef CO_DRIVER_TX_QUEUE_SIZE
+  #define CO_DRIVER_TX_QUEUE_SIZE 64
+#endif
+
+/**
+ * @name tx queue retry time
+ *
+ * If the device queue is full (ENOBUFS), the socket is still reported as
+ * writeable. CO_CANrxWait() then retries the tx queue after this time in
+ * milliseconds instead of waiting for EPOLLOUT.
+ */
+#ifndef CO_DRIVER_TX_RETRY_MS
+  #define CO_DRIVER_TX_RETRY_MS 1
+#endif
+
+/**
+ * @name epoll event count
+ *
+ * Maximum number of ready sources (CAN sockets, timer, notification pipe)
+ * returned by one epoll_wait() call inside CO_CANrxWait(). All of them are
+ * processed before the function returns.
+ */
+#ifndef CO_DRIVER_EPOLL_EVENTS
+  #define CO_DRIVER_EPOLL_EVENTS 8
+#endif
+
 
 #include "CO_driver_base.h"
 #include "CO_notify_pipe.h"
@@ -87,6 +208,38 @@ extern "C" {
   #include "CO_error.h"
 #endif
 
+/**
+ * Receive thread object
+ *
+ * Contains the epoll set and the rx batch of one thread calling
+ * CO_CANrxWait(). CO_CANmodule_t contains the default object for all
+ * interfaces. With #CO_DRIVER_MULTI_INTERFACE, interfaces can get their own
+ * object, see CO_CANrxThread_init().
+ */
+typedef struct {
+    CO_NotifyPipe_t    *pipe;           /**< Notification Pipe */
+    int                 fdEpoll;        /**< epoll FD */
+    int                 fdTimerRead;    /**< timer handle from CANrxWait() */
+    struct mmsghdr     *rxBatchHdr;     /**< recvmmsg() message headers, one per batch entry */
+    struct CO_CANrxBatch *rxBatch;      /**< received messages, one per batch entry */
+    uint16_t            rxBatchSize;    /**< max. number of messages read at once */
+    uint16_t            rxBatchCount;   /**< number of messages in current batch */
+    uint16_t            rxBatchNext;    /**< next message to be evaluated from current batch */
+    uint32_t            rxBatchInterface; /**< index in CANinterfaces current batch was read from */
+} CO_CANrxThread_t;
+
+/**
+ * Link statistics of one socketCAN interface
+ *
+ * Kept with #CO_DRIVER_MULTI_INTERFACE, see CO_CANinterface_getLinkStats().
+ */
+typedef struct {
+    uint32_t            rxCount;        /**< data messages received */
+    uint32_t            rxDuplicateCount; /**< messages dropped, copy was received on other interface before */
+    uint32_t            rxMissedCount;  /**< messages received only on other interfaces */
+    struct timespec     rxLast;         /**< time of last received data message */
+} CO_CANlinkStats_t;
+
 /**
  * socketCAN interface object
  */
@@ -94,9 +247,24 @@ typedef struct {
     int32_t             CANbaseAddress;   /**< CAN Interface identifier */
     char                ifName[IFNAMSIZ]; /**< CAN Interface name */
     int                 fd;               /**< socketCAN file descriptor */
+    struct CO_CANtxQueue *txQueue;        /**< software tx queue */
+    uint16_t            txQueueCount;     /**< number of messages in tx queue */
+    bool_t              txPollOut;        /**< EPOLLOUT is registered for fd */
+    bool_t              txRetry;          /**< tx queue is retried after ENOBUFS */
+    CO_CANrxThread_t   *rxThread;         /**< rx thread, fd is part of its epoll set */
+    uint32_t            rxDropSocket;     /**< last SO_RXQ_OVFL counter of the socket */
+    uint32_t            rxDropCount;      /**< messages dropped on rx socket queue */
+    uint32_t            rxFrameCount;     /**< messages read from socket */
+    int                 rcvbuf;           /**< SO_RCVBUF in bytes, as reported by the kernel */
+    int                 sndbuf;           /**< SO_SNDBUF in bytes, as reported by the kernel */
+    bool_t              rcvbufLimit;      /**< SO_RCVBUF can't be raised any more */
+    bool_t              sndbufLimit;      /**< SO_SNDBUF can't be raised any more */
 #ifdef CO_DRIVER_ERROR_REPORTING
     CO_CANinterfaceErrorhandler_t errorhandler;
 #endif
+#ifdef CO_DRIVER_MULTI_INTERFACE
+    CO_CANlinkStats_t   linkStats;        /**< link statistics, protected by rxDupMutex */
+#endif
 } CO_CANinterface_t;
 
 /**
@@ -108,21 +276,40 @@ typedef struct{
     uint32_t            CANinterfaceCount; /** interface count */
     CO_CANrx_t         *rxArray;        /**< From CO_CANmodule_init() */
     uint16_t            rxSize;         /**< From CO_CANmodule_init() */
-    struct can_filter  *rxFilter;       /**< socketCAN filter list, one per rx buffer */
+    /** socketCAN filter list, one per rx buffer. Reused by CO_CANmodule_init()
+     * on communication reset, so CO_CANmodule_t must be zeroed before the first
+     * call. Freed by CO_CANmodule_disable(). */
+    struct can_filter  *rxFilter;
     uint32_t            rxDropCount;    /**< messages dropped on rx socket queue */
+    uint32_t            txOverflowCount; /**< messages dropped on transmission (CO_ERROR_TX_OVERFLOW) */
+    int                 rcvbufMax;      /**< From CO_CANmodule_setBufferTuning() */
+    int                 sndbufMax;      /**< From CO_CANmodule_setBufferTuning() */
+    int                 rxPriority;     /**< From CO_CANmodule_setBufferTuning() */
     CO_CANtx_t         *txArray;        /**< From CO_CANmodule_init() */
     uint16_t            txSize;         /**< From CO_CANmodule_init() */
     volatile bool_t     CANnormal;      /**< CAN module is in normal mode */
+    bool_t              txBatch;        /**< tx messages are only queued, see CO_CANtxBatchStart() */
+    pthread_mutex_t     txMutex;        /**< protects tx queues */
     void               *em;             /**< Emergency object */
-    CO_NotifyPipe_t    *pipe;           /**< Notification Pipe */
-    int                 fdEpoll;        /**< epoll FD */
-    int                 fdTimerRead;    /**< timer handle from CANrxWait() */
-#ifdef CO_DRIVER_MULTI_INTERFACE
+    CO_CANrxThread_t    rxThread;       /**< default rx thread, used by CO_CANrxWait() */
+#ifdef CO_DRIVER_RX_DISPATCH_TABLE
     /**
      * Lookup tables Cob ID to rx/tx array index. Only feasible for SFF Messages.
      */
     uint32_t            rxIdentToIndex[CO_CAN_MSG_SFF_MAX_COB_ID]; /**< COB ID to index assignment */
+    uint16_t           *rxMaskedIndex;  /**< rx buffers with mask, sorted, searched linearly on reception. Reused like rxFilter */
+    uint16_t            rxMaskedCount;  /**< number of entries in rxMaskedIndex */
+#endif
+#ifdef CO_DRIVER_MULTI_INTERFACE
     uint32_t            txIdentToIndex[CO_CAN_MSG_SFF_MAX_COB_ID]; /**< COB ID to index assignment */
+    uint32_t            txRoute[CO_CAN_MSG_SFF_MAX_COB_ID]; /**< COB ID to interface bit mask, 0 = no route, see CO_CANtxRoute_add() */
+    uint16_t            rxRouteLearn[CO_CAN_MSG_SFF_MAX_COB_ID]; /**< rx COB ID to tx COB ID learning its route, see CO_CANtxRoute_learn() */
+    struct CO_CANrxDup *rxDup;          /**< duplicate suppression table or NULL, see CO_CANrxDuplicate_init() */
+    uint32_t            rxDupWindow_us; /**< time window for duplicates */
+    pthread_mutex_t     rxDupMutex;     /**< protects rxDup, rx threads may run in parallel */
+#endif
+#ifdef CO_DRIVER_CAPTURE
+    struct CO_capture  *volatile capture; /**< From CO_CANmodule_setCapture() or NULL */
 #endif
 }CO_CANmodule_t;
 
@@ -187,6 +374,35 @@ CO_ReturnError_t CO_CANmodule_init(
         uint16_t                txSize,
         uint16_t                CANbitRate);
 
+/**
+ * Enable automatic socket buffer sizing
+ *
+ * When messages are dropped on the rx socket queue of an interface
+ * (SO_RXQ_OVFL), SO_RCVBUF of its socket is doubled, up to _rcvbufMax_. When
+ * the socket tx queue is full (EAGAIN), SO_SNDBUF is doubled, up to
+ * _sndbufMax_. Sizes start at the kernel default and are never reduced.
+ * SO_RCVBUFFORCE and SO_SNDBUFFORCE are used, if the process has
+ * CAP_NET_ADMIN. Otherwise sizes are limited by net.core.rmem_max and
+ * net.core.wmem_max.
+ *
+ * If _rxPriority_ is given, the thread which read the dropping interface is
+ * switched to SCHED_FIFO with this priority, if it runs below it.
+ *
+ * Sizes are in bytes as reported by getsockopt(), the kernel reserves around
+ * 450 bytes for each CAN message. Function may be called at any time.
+ *
+ * @param CANmodule This object.
+ * @param rcvbufMax Max. SO_RCVBUF, 0 disables tuning of rx buffers (default).
+ * @param sndbufMax Max. SO_SNDBUF, 0 disables tuning of tx buffers (default).
+ * @param rxPriority SCHED_FIFO priority of rx threads on drops, 0 to disable.
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_CANmodule_setBufferTuning(
+        CO_CANmodule_t         *CANmodule,
+        int                     rcvbufMax,
+        int                     sndbufMax,
+        int                     rxPriority);
+
 #ifdef CO_DRIVER_MULTI_INTERFACE
 
 /**
@@ -203,6 +419,73 @@ CO_ReturnError_t CO_CANmodule_addInterface(
         CO_CANmodule_t         *CANmodule,
         int32_t                 CANbaseAddress);
 
+/**
+ * Move socketCAN interface to its own rx thread
+ *
+ * By default, all interfaces are received by CO_CANrxWait(). After this call,
+ * messages of this interface are only received by CO_CANrxWaitThread() with
+ * the given object, so each interface can be processed by its own (pinned)
+ * thread. Received messages are still evaluated against the common _rxArray_,
+ * so one CANopen object should only be received on one of these interfaces.
+ *
+ * Function must be called after CO_CANmodule_addInterface() and before
+ * CO_CANsetNormalMode(). The object is released by CO_CANmodule_disable().
+ *
+ * @param CANmodule This object.
+ * @param rxThread rx thread object, will be initialized.
+ * @param CANbaseAddress CAN module base address of an added interface.
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT,
+ * CO_ERROR_OUT_OF_MEMORY, CO_ERROR_SYSCALL or CO_ERROR_INVALID_STATE.
+ */
+CO_ReturnError_t CO_CANrxThread_init(
+        CO_CANmodule_t         *CANmodule,
+        CO_CANrxThread_t       *rxThread,
+        int32_t                 CANbaseAddress);
+
+/**
+ * Enable duplicate suppression for redundant interfaces
+ *
+ * For interfaces connected to the same (redundant) bus. A message, which was
+ * received on one interface, is dropped if the same message (COB ID, DLC and
+ * data) is received on another interface within _window_us_. So only the
+ * first copy is passed to the receive callback. The same message received
+ * again on the same interface is a new message. Messages are looked up in a
+ * hash table of #CO_DRIVER_RX_DUP_TABLE_SIZE entries, which is independent of
+ * the number of received COB IDs. Time window must be shorter than the
+ * shortest period of equal messages, e.g. a PDO with unchanged data.
+ *
+ * Link statistics are updated, see CO_CANinterface_getLinkStats().
+ *
+ * Function must be called before CO_CANsetNormalMode(). The table is released
+ * by CO_CANmodule_disable().
+ *
+ * @param CANmodule This object.
+ * @param window_us time window for duplicates in microseconds, 0 disables
+ * suppression.
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT,
+ * CO_ERROR_OUT_OF_MEMORY or CO_ERROR_INVALID_STATE.
+ */
+CO_ReturnError_t CO_CANrxDuplicate_init(
+        CO_CANmodule_t         *CANmodule,
+        uint32_t                window_us);
+
+/**
+ * Get link statistics of an interface
+ *
+ * _rxMissedCount_ is only counted with duplicate suppression, when the table
+ * entry of a message is reused. Statistics may be read while the rx threads
+ * are running, values are not consistent to each other then.
+ *
+ * @param CANmodule This object.
+ * @param CANbaseAddress CAN module base address of an added interface.
+ * @param [out] stats link statistics.
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_CANinterface_getLinkStats(
+        CO_CANmodule_t         *CANmodule,
+        int32_t                 CANbaseAddress,
+        CO_CANlinkStats_t      *stats);
+
 #endif
 
 /**
@@ -221,6 +504,31 @@ void CO_CANmodule_disable(CO_CANmodule_t *CANmodule);
  */
 uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg);
 
+#ifdef CO_DRIVER_RX_TIMESTAMP
+/**
+ * Read reception time from received message
+ *
+ * Only valid for the message pointer passed to the receive callback, not for
+ * copies of the message.
+ *
+ * @param rxMsg Pointer to received message
+ * @return monotonic time in microseconds, 32 bit, wraps around.
+ */
+uint32_t CO_CANrxMsg_readTimestamp_us(const CO_CANrxMsg_t *rxMsg);
+
+/**
+ * Get current time in the time base of CO_CANrxMsg_readTimestamp_us()
+ *
+ * @return monotonic time in microseconds, 32 bit, wraps around.
+ */
+uint32_t CO_CANtimestamp_us(void);
+
+/** Statistics use the same time base as the rx timestamps */
+#define CO_STAT_TIMESTAMP_US()          CO_CANtimestamp_us()
+/** Reception time of a message, see CO_statistics.h */
+#define CO_STAT_RX_TIMESTAMP_US(msg)    CO_CANrxMsg_readTimestamp_us(msg)
+#endif
+
 
 /**
  * Configure CAN message receive buffer.
@@ -326,6 +634,66 @@ CO_ReturnError_t CO_CANtxBuffer_setInterface(
         uint32_t                ident,
         int32_t                 CANbaseAddressTx);
 
+/**
+ * Add interface to the tx route of a COB ID
+ *
+ * Messages with a route are sent only on the interfaces of the route, the
+ * interface set by CO_CANtxBuffer_setInterface() is then ignored. Messages
+ * without route are sent as before. Routes belong to the COB ID, not to the
+ * tx buffer, so they are kept if a buffer is initialized again, e.g. by a
+ * changed PDO or SDO client configuration. Routes are kept until
+ * CO_CANtxRoute_clear() or CO_CANmodule_init().
+ *
+ * @param CANmodule This object.
+ * @param ident 11-bit standard CAN Identifier.
+ * @param CANbaseAddressTx interface to add, must be one of the first
+ * #CO_DRIVER_TX_ROUTE_INTERFACES interfaces.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_CANtxRoute_add(
+        CO_CANmodule_t         *CANmodule,
+        uint32_t                ident,
+        int32_t                 CANbaseAddressTx);
+
+/**
+ * Remove the tx route of a COB ID
+ *
+ * Messages are sent as without route again. A learning rule from
+ * CO_CANtxRoute_learn() for this COB ID stays active and builds up the
+ * route again.
+ *
+ * @param CANmodule This object.
+ * @param ident 11-bit standard CAN Identifier.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_CANtxRoute_clear(
+        CO_CANmodule_t         *CANmodule,
+        uint32_t                ident);
+
+/**
+ * Learn the tx route of a COB ID from received messages
+ *
+ * Each interface, on which a message with _rxIdent_ is received, is added
+ * to the route of _txIdent_, before the message is passed to its receive
+ * callback. So for example an SDO server response (0x580 + node ID) is
+ * sent only on the interfaces, where the requests (0x600 + node ID) came
+ * from, or a TPDO only where its consumer sends its heartbeat. One rx COB
+ * ID teaches one tx COB ID, a second call for the same _rxIdent_ replaces
+ * the rule.
+ *
+ * @param CANmodule This object.
+ * @param rxIdent 11-bit standard CAN Identifier of received messages.
+ * @param txIdent 11-bit standard CAN Identifier of transmitted messages.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_CANtxRoute_learn(
+        CO_CANmodule_t         *CANmodule,
+        uint32_t                rxIdent,
+        uint32_t                txIdent);
+
 #endif
 
 /**
@@ -344,9 +712,9 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer);
  * The same as #CO_CANsend(), but ensures that there is enough space remaining
  * in the driver for more important messages.
  *
- * The default threshold is 50%, or at least 1 message buffer. If sending
- * would violate those limits, #CO_ERROR_TX_OVERFLOW is returned and the
- * message will not be sent.
+ * If the socket queue is full, the message is put into the tx queue of the
+ * interface. If the tx queue is full too, #CO_ERROR_TX_BUSY is returned and
+ * the message will not be sent.
  *
  * @param CANmodule This object.
  * @param buffer Pointer to transmit buffer, returned by CO_CANtxBufferInit().
@@ -358,8 +726,36 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer);
 CO_ReturnError_t CO_CANCheckSend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer);
 
 /**
- * Clear all synchronous TPDOs from CAN module transmit buffers.
- * This function is not supported in this driver.
+ * Start collecting tx messages.
+ *
+ * After this call, all messages given to CO_CANsend() and CO_CANCheckSend()
+ * are only put into the tx queue of the interface. They are sent with one
+ * sendmmsg() call per interface by CO_CANtxBatchFlush(). This is intended to
+ * be used around CO_process_TPDO().
+ *
+ * @param CANmodule This object.
+ */
+void CO_CANtxBatchStart(CO_CANmodule_t *CANmodule);
+
+/**
+ * Send all queued tx messages and stop collecting.
+ *
+ * Messages which can't be sent because the socket queue is full stay inside
+ * the tx queue. They are sent when the socket gets writeable again (inside
+ * CO_CANrxWait()), with the next call to this function or with the next
+ * message sent.
+ *
+ * @param CANmodule This object.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_TX_BUSY (messages left
+ * in queue) or CO_ERROR_TX_OVERFLOW.
+ */
+CO_ReturnError_t CO_CANtxBatchFlush(CO_CANmodule_t *CANmodule);
+
+/**
+ * Clear all synchronous TPDOs from the tx queues.
+ *
+ * Messages already written to the socket queue can't be removed.
  */
 void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule);
 
@@ -381,16 +777,92 @@ void CO_CANverifyErrors(CO_CANmodule_t *CANmodule);
  *
  * Both modes can be combined.
  *
+ * Messages are read from the socket in batches of up to
+ * #CO_DRIVER_RX_BATCH_SIZE messages. In automatic mode (_buffer_ is _NULL_),
+ * all messages of one batch are evaluated within one call. In manual mode,
+ * one message is returned per call and further calls return the remaining
+ * messages of the batch without waiting.
+ *
+ * All sources which are ready at the same time are handled within one call.
+ * In automatic mode this includes the rx batches of all ready interfaces. In
+ * manual mode only one interface is read per call, the others stay ready for
+ * the next call.
+ *
+ * In automatic mode one call may evaluate many messages, but only one index
+ * is returned: the one of the last message, which matched a receive buffer.
+ * Indexes of the other messages are not available to the caller. The
+ * callbacks are called for all of them, so application, which needs to know
+ * each received message, must use the callbacks (or manual mode).
+ *
  * @param CANmodule This object.
  * @param fdTimer file descriptor with activated timeout. fd is not read after
  *                expiring! -1 if not used.
  * @param buffer [out] storage for received message or _NULL_
  * @retval >= 0 index of received message in array set by #CO_CANmodule_init()
- *         _rxArray_, copy available in _buffer_
- * @retval -1 no message received
+ *         _rxArray_, copy available in _buffer_. In automatic mode, index of
+ *         the last matched message of the call.
+ * @retval -1 no message received, or _fdTimer_ expired or wait was cancelled.
+ *         In automatic mode also, if none of the messages matched.
  */
 int32_t CO_CANrxWait(CO_CANmodule_t *CANmodule, int fdTimer, CO_CANrxMsg_t *buffer);
 
+#ifdef CO_DRIVER_MULTI_INTERFACE
+/**
+ * Functions receives CAN messages of one rx thread. It is blocking.
+ *
+ * Same as CO_CANrxWait(), but only waits for the interfaces which were moved
+ * to _rxThread_ by CO_CANrxThread_init(). Different rx threads may call this
+ * function in parallel. Call returns with -1 when CO_CANmodule_disable() is
+ * called.
+ *
+ * @param CANmodule This object.
+ * @param rxThread rx thread object from CO_CANrxThread_init().
+ * @param fdTimer file descriptor with activated timeout. fd is not read after
+ *                expiring! -1 if not used.
+ * @param buffer [out] storage for received message or _NULL_
+ * @return see CO_CANrxWait()
+ */
+int32_t CO_CANrxWaitThread(CO_CANmodule_t *CANmodule, CO_CANrxThread_t *rxThread,
+                           int fdTimer, CO_CANrxMsg_t *buffer);
+#endif
+
+#ifdef CO_DRIVER_CAPTURE
+struct CO_capture;
+struct CO_replay;
+
+/**
+ * Attach capture object to the CAN module or detach it.
+ *
+ * Frames read by the rx threads and all sent frames are added to the capture
+ * from now on. Capture must only be attached or detached while no rx thread
+ * is inside CO_CANrxWait().
+ *
+ * @param CANmodule This object.
+ * @param capture Initialized capture object, see CO_capture_init(), or NULL.
+ */
+void CO_CANmodule_setCapture(CO_CANmodule_t *CANmodule, struct CO_capture *capture);
+
+/**
+ * Replay next received frame of a recording. It is blocking.
+ *
+ * Used instead of CO_CANrxWait() for reproducible tests. Function waits for
+ * the time of the next frame (see CO_replay_next()) and evaluates it like a
+ * frame received from the socket. The CAN module needs at least one
+ * interface, frames of other interfaces of the recording are received on
+ * the first one.
+ *
+ * @param CANmodule This object.
+ * @param replay Recording, see CO_replay_open().
+ * @param buffer [out] storage for received message or _NULL_
+ * @retval >= 0 index of received message in array set by #CO_CANmodule_init()
+ *         _rxArray_, copy available in _buffer_.
+ * @retval -1 message did not match any rx buffer.
+ * @retval -2 end of recording.
+ */
+int32_t CO_CANrxReplay(CO_CANmodule_t *CANmodule, struct CO_replay *replay,
+                       CO_CANrxMsg_t *buffer);
+#endif
+
 #ifdef __cplusplus
 }
 #endif /*__cplusplus*/
@@ -184,6 +184,9 @@ static inline void CO_UNLOCK_EMCY() { (void)pthread_mutex_unlock(&CO_EMCY_mutex)
 extern pthread_mutex_t CO_OD_mutex;
 static inline int CO_LOCK_OD()      { return pthread_mutex_lock(&CO_OD_mutex); }    /**< Lock critical section when accessing Object Dictionary */
 static inline void CO_UNLOCK_OD()   { (void)pthread_mutex_unlock(&CO_OD_mutex); }   /**< Unock critical section when accessing Object Dictionary */
+/* receive runs in a thread */
+#define CO_LOCK_OD_RX()     CO_LOCK_OD()    /**< Lock Object Dictionary from the CAN receive function */
+#define CO_UNLOCK_OD_RX()   CO_UNLOCK_OD()  /**< Unlock Object Dictionary from the CAN receive function */
 
 /** @} */
 
@@ -260,14 +263,27 @@ typedef enum{
 #define CO_CAN_MSG_SFF_MAX_COB_ID (1 << CAN_SFF_ID_BITS)
 
 /**
- * CAN receive message structure as aligned in socketCAN.
+ * Maximum number of data bytes in one CAN message, see #CO_DRIVER_CAN_FD
+ */
+#ifdef CO_DRIVER_CAN_FD
+  #define CO_CAN_DATA_MAX   CANFD_MAX_DLEN
+  #ifndef CO_PDO_MAX_SIZE
+    #define CO_PDO_MAX_SIZE CANFD_MAX_DLEN
+  #endif
+#else
+  #define CO_CAN_DATA_MAX   CAN_MAX_DLEN
+#endif
+
+/**
+ * CAN receive message structure as aligned in socketCAN (struct can_frame or
+ * struct canfd_frame).
  */
 typedef struct{
     /** CAN identifier. It must be read through CO_CANrxMsg_readIdent() function. */
     uint32_t            ident;
-    uint8_t             DLC ;           /**< Length of CAN message */
-    uint8_t             padding[3];     /**< ensure alignment */
-    uint8_t             data[8];        /**< 8 data bytes */
+    uint8_t             DLC ;           /**< Length of CAN message in bytes */
+    uint8_t             padding[3];     /**< ensure alignment, CAN FD flags */
+    uint8_t             data[CO_CAN_DATA_MAX]; /**< data bytes */
 }CO_CANrxMsg_t;
 
 /**
@@ -293,9 +309,9 @@ typedef struct{
 typedef struct{
     /** CAN identifier. It must be read through CO_CANrxMsg_readIdent() function. */
     uint32_t            ident;
-    uint8_t             DLC ;           /**< Length of CAN message */
-    uint8_t             padding[3];     /**< ensure alignment */
-    uint8_t             data[8];        /**< 8 data bytes */
+    uint8_t             DLC ;           /**< Length of CAN message in bytes */
+    uint8_t             padding[3];     /**< ensure alignment, CAN FD flags */
+    uint8_t             data[CO_CAN_DATA_MAX]; /**< data bytes */
     volatile bool_t     bufferFull;     /**< True if previous message is still in buffer (not used in this driver) */
     /** Synchronous PDO messages has this flag set. It prevents them to be sent outside the synchronous window */
     volatile bool_t     syncFlag;
@@ -59,18 +59,89 @@
 #endif
 
 
+/**
+ * Milliseconds from "from" to "to"
+ */
+static uint32_t CO_CANerrorDiffMs(
+        const struct timespec             *from,
+        const struct timespec             *to)
+{
+    int64_t ms;
+
+    ms = (int64_t)(to->tv_sec - from->tv_sec) * 1000 +
+         (to->tv_nsec - from->tv_nsec) / 1000000;
+    return (ms > 0) ? (uint32_t)ms : 0;
+}
+
+
+/**
+ * Fault is over, transmission works since "end"
+ */
+static void CO_CANerrorRecovered(
+        CO_CANinterfaceErrorhandler_t     *CANerrorhandler,
+        const struct timespec             *end)
+{
+    uint32_t ms;
+
+    ms = CO_CANerrorDiffMs(&CANerrorhandler->faultStart, end);
+    CANerrorhandler->stats.recoverCount ++;
+    CANerrorhandler->stats.recoverLast = ms;
+    if (ms > CANerrorhandler->stats.recoverMax) {
+        CANerrorhandler->stats.recoverMax = ms;
+    }
+    CANerrorhandler->stats.downtime += ms;
+
+    CANerrorhandler->fault = false;
+    CANerrorhandler->backoff = CO_CANerror_BACKOFF_MIN;
+}
+
+
+/**
+ * Recover fault, if transmission works for CO_CANerror_STABLE after listen
+ * only mode ended
+ */
+static void CO_CANerrorCheckStable(
+        CO_CANinterfaceErrorhandler_t     *CANerrorhandler,
+        const struct timespec             *now)
+{
+    if (CANerrorhandler->fault && !CANerrorhandler->listenOnly &&
+        CO_CANerrorDiffMs(&CANerrorhandler->retry, now) >= CO_CANerror_STABLE) {
+        CO_CANerrorRecovered(CANerrorhandler, &CANerrorhandler->retry);
+    }
+}
+
+
 /**
  * Reset CAN interface and set to listen only mode
+ *
+ * First fault blocks transmission for CO_CANerror_BACKOFF_MIN, each fault
+ * after an unsuccessful retry doubles the time.
  */
 static CO_CANinterfaceState_t CO_CANerrorSetListenOnly(
         CO_CANinterfaceErrorhandler_t     *CANerrorhandler,
         bool_t                             resetIf)
 {
     char command[100];
+    struct timespec now;
 
     log_printf(LOG_DEBUG, DBG_CAN_SET_LISTEN_ONLY, CANerrorhandler->ifName);
 
-    clock_gettime(CLOCK_MONOTONIC, &CANerrorhandler->timestamp);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    CO_CANerrorCheckStable(CANerrorhandler, &now);
+    if (!CANerrorhandler->fault) {
+        CANerrorhandler->fault = true;
+        CANerrorhandler->faultStart = now;
+        CANerrorhandler->backoff = CO_CANerror_BACKOFF_MIN;
+    }
+    else if (!CANerrorhandler->listenOnly) {
+        /* retry failed */
+        CANerrorhandler->backoff *= 2;
+        if (CANerrorhandler->backoff > CO_CANerror_LISTEN_ONLY * 1000) {
+            CANerrorhandler->backoff = CO_CANerror_LISTEN_ONLY * 1000;
+        }
+    }
+
+    CANerrorhandler->timestamp = now;
     CANerrorhandler->listenOnly = true;
 
     if (resetIf) {
@@ -111,6 +182,7 @@ static CO_CANinterfaceState_t CO_CANerrorBusoff(
 
     if ((msg->can_id & CAN_ERR_BUSOFF) != 0) {
         log_printf(LOG_NOTICE, CAN_BUSOFF, CANerrorhandler->ifName);
+        CANerrorhandler->stats.busoffCount ++;
 
         /* The can interface changed it's state to "bus off" (e.g. because of
          * a short on the can wires). We re-start the interface and mark it
@@ -183,6 +255,8 @@ static CO_CANinterfaceState_t CO_CANerrorNoack(
         CANerrorhandler->noackCounter ++;
         if (CANerrorhandler->noackCounter > CO_CANerror_NOACK_MAX) {
             log_printf(LOG_INFO, CAN_NOACK, CANerrorhandler->ifName);
+            CANerrorhandler->stats.noackCount ++;
+            CANerrorhandler->noackCounter = 0;
 
             /* We get the NO-ACK error continuously when no other CAN node
              * is active on the bus (Error Counting exception 1 in CAN spec).
@@ -215,6 +289,9 @@ void CO_CANerror_init(
     CANerrorhandler->listenOnly = false;
     CANerrorhandler->timestamp.tv_sec = 0;
     CANerrorhandler->timestamp.tv_nsec = 0;
+    CANerrorhandler->backoff = CO_CANerror_BACKOFF_MIN;
+    CANerrorhandler->fault = false;
+    memset(&CANerrorhandler->stats, 0, sizeof(CANerrorhandler->stats));
 }
 
 
@@ -243,6 +320,12 @@ void CO_CANerror_rxMsg(
     if (CANerrorhandler->listenOnly == true) {
         CO_CANerrorClearListenOnly(CANerrorhandler);
     }
+    if (CANerrorhandler->fault) {
+        struct timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        CO_CANerrorRecovered(CANerrorhandler, &now);
+    }
     CANerrorhandler->noackCounter = 0;
 }
 
@@ -259,14 +342,20 @@ CO_CANinterfaceState_t CO_CANerror_txMsg(
 
     if (CANerrorhandler->listenOnly == true) {
         clock_gettime(CLOCK_MONOTONIC, &now);
-        if (CANerrorhandler->timestamp.tv_sec + CO_CANerror_LISTEN_ONLY < now.tv_sec) {
+        if (CO_CANerrorDiffMs(&CANerrorhandler->timestamp, &now) >= CANerrorhandler->backoff) {
             /* let's try that again. Maybe someone is waiting for LSS now. It
              * doesn't matter which message is sent, as all messages are ACKed. */
             CO_CANerrorClearListenOnly(CANerrorhandler);
+            CANerrorhandler->retry = now;
+            CANerrorhandler->stats.retryCount ++;
             return CO_INTERFACE_ACTIVE;
         }
         return CO_INTERFACE_LISTEN_ONLY;
     }
+    if (CANerrorhandler->fault) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        CO_CANerrorCheckStable(CANerrorhandler, &now);
+    }
     return CO_INTERFACE_ACTIVE;
 }
 
@@ -78,7 +78,7 @@ typedef enum {
 
 
 /**
- * This is how long we are going to block transmission if listen-only
+ * This is the longest time we are going to block transmission if listen-only
  * mode is active
  *
  * Time is in seconds.
@@ -86,6 +86,42 @@ typedef enum {
 #define CO_CANerror_LISTEN_ONLY 10
 
 
+/**
+ * This is how long we block transmission after the first bus off or no-ACK.
+ * Each further bus off or no-ACK before the fault is recovered doubles the
+ * time up to #CO_CANerror_LISTEN_ONLY.
+ *
+ * Time is in milliseconds.
+ */
+#ifndef CO_CANerror_BACKOFF_MIN
+#define CO_CANerror_BACKOFF_MIN 100
+#endif
+
+
+/**
+ * Transmission must work for this time after listen-only mode ended, before
+ * the fault is recovered and the next one starts again with
+ * #CO_CANerror_BACKOFF_MIN. A received message recovers immediately.
+ *
+ * Time is in milliseconds.
+ */
+#define CO_CANerror_STABLE 1000
+
+
+/**
+ * Recovery statistics of one interface, see CO_ODF_CANerrorStatistics()
+ */
+typedef struct {
+  uint32_t            busoffCount;    /**< bus off events */
+  uint32_t            noackCount;     /**< listen-only because of missing ACK */
+  uint32_t            retryCount;     /**< transmission resumed after listen-only */
+  uint32_t            recoverCount;   /**< recovered faults */
+  uint32_t            recoverLast;    /**< time to recover of the last fault in ms */
+  uint32_t            recoverMax;     /**< longest time to recover in ms */
+  uint32_t            downtime;       /**< sum of all times to recover in ms */
+} CO_CANerrorStatistics_t;
+
+
 /**
  * socketCAN interface error handling
  */
@@ -97,6 +133,12 @@ typedef struct {
 
   volatile bool_t     listenOnly;     /**< set to listen only mode */
   struct timespec     timestamp;      /**< listen only mode started at this time */
+  uint32_t            backoff;        /**< current listen only time in ms */
+
+  bool_t              fault;          /**< bus off or no-ACK, not recovered yet */
+  struct timespec     faultStart;     /**< first bus off or no-ACK of the fault */
+  struct timespec     retry;          /**< listen only mode ended at this time */
+  CO_CANerrorStatistics_t stats;      /**< recovery statistics */
 } CO_CANinterfaceErrorhandler_t;
 
 /**
@@ -124,7 +166,8 @@ void CO_CANerror_disable(
 /**
  * Message received event
  *
- * when a message is received at least one other CAN module is connected
+ * when a message is received at least one other CAN module is connected, so
+ * a fault is recovered
  *
  * @param CANerrorhandler CAN error object.
  */
@@ -135,7 +178,8 @@ void CO_CANerror_rxMsg(
 /**
  * Check if interface is ready for message transmission
  *
- * message musn't be transmitted if not ready
+ * message musn't be transmitted if not ready. Listen-only mode ends after
+ * the backoff time, see #CO_CANerror_BACKOFF_MIN.
  *
  * @param CANerrorhandler CAN error object.
  * @return CO_INTERFACE_ACTIVE message transmission ready
@@ -0,0 +1,263 @@
+/*
+ * Deferred, rate limited logging of the Linux socketCAN driver.
+ *
+ * @file        CO_log.c
+ * @ingroup     CO_driver
+ * @copyright   2019 Neuberger Gebaeudeautomation GmbH
+ *
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#include "CO_log.h"
+
+#if defined CO_DRIVER_ERROR_REPORTING && __has_include("syslog/log.h")
+  #include "syslog/log.h"
+  #include "msgs.h"
+#else
+  #define log_printf(macropar_prio, macropar_message, ...)
+#endif
+
+#ifndef DBG_LOG_SUPPRESSED
+  #define DBG_LOG_SUPPRESSED "%s: %u messages suppressed"
+#endif
+
+
+/* Rate limit of one event id */
+typedef struct {
+    uint64_t            start_us;       /* start of the period */
+    uint32_t            count;          /* events queued in the period */
+    uint32_t            suppressed;     /* events suppressed, not reported yet */
+    uint64_t            report_us;      /* time of the last report */
+} CO_logRate_t;
+
+/* Names of the event ids for the report of suppressed events */
+static const char *const CO_logEventName[CO_LOG_EVENT_COUNT] = {
+    "CAN rx failed",
+    "CAN rx length",
+    "CAN rx socket queue overflow",
+    "CAN rx epoll",
+    "CAN tx failed",
+    "CAN tx send failed",
+    "CAN tx busy"
+};
+
+static CO_logEvent_t CO_logQueue[CO_LOG_QUEUE_SIZE];
+static volatile uint32_t CO_logHead;    /* number of events written to the ring */
+static volatile uint32_t CO_logTail;    /* number of events logged */
+static CO_logRate_t CO_logRate[CO_LOG_EVENT_COUNT];
+static CO_logStatistics_t CO_logStatistics;
+static volatile int CO_logLock;         /* protects all above, except tail */
+
+
+/* Helper function - get monotonic clock time in us */
+static uint64_t CO_log_time_us(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000U + (uint64_t)ts.tv_nsec / 1000U;
+}
+
+/* spinlock, held only for a few instructions */
+static void CO_log_lock(void)
+{
+    while (__sync_lock_test_and_set(&CO_logLock, 1) != 0) {
+    }
+}
+
+static void CO_log_unlock(void)
+{
+    __sync_lock_release(&CO_logLock);
+}
+
+
+/******************************************************************************/
+void CO_log_event(CO_logEventId_t id, const char *ifName, uint32_t arg, int err)
+{
+    uint64_t now_us;
+    CO_logRate_t *rate;
+
+    if ((uint32_t)id >= CO_LOG_EVENT_COUNT) {
+        return;
+    }
+    now_us = CO_log_time_us();
+    rate = &CO_logRate[id];
+
+    CO_log_lock();
+    CO_logStatistics.events ++;
+    if ((now_us - rate->start_us) >= (uint64_t)CO_LOG_RATE_PERIOD_MS * 1000U) {
+        /* suppressed events stay for CO_log_process() */
+        rate->start_us = now_us;
+        rate->count = 0;
+    }
+    if (rate->count >= CO_LOG_RATE_MAX) {
+        rate->suppressed ++;
+        CO_logStatistics.suppressed ++;
+    }
+    else if ((CO_logHead - CO_logTail) >= CO_LOG_QUEUE_SIZE) {
+        /* ring full, CO_log_process() is too slow */
+        rate->suppressed ++;
+        CO_logStatistics.dropped ++;
+    }
+    else {
+        CO_logEvent_t *event = &CO_logQueue[CO_logHead % CO_LOG_QUEUE_SIZE];
+
+        event->id = (uint8_t)id;
+        event->err = err;
+        event->arg = arg;
+        if (ifName != NULL) {
+            strncpy(event->ifName, ifName, sizeof(event->ifName) - 1);
+            event->ifName[sizeof(event->ifName) - 1] = '\0';
+        }
+        else {
+            event->ifName[0] = '\0';
+        }
+        rate->count ++;
+        CO_logHead ++;
+    }
+    CO_log_unlock();
+}
+
+
+/*
+ * Write one event with log_printf(). Same messages as written directly by
+ * the driver before.
+ */
+static void CO_log_write(const CO_logEvent_t *event)
+{
+    /* DBG_ERRNO takes errno of the failed call */
+    errno = event->err;
+
+    switch (event->id) {
+        case CO_LOG_CAN_RX_FAILED:
+            log_printf(LOG_DEBUG, DBG_CAN_RX_FAILED, event->ifName);
+            log_printf(LOG_DEBUG, DBG_ERRNO, "recvmmsg()");
+            break;
+        case CO_LOG_CAN_RX_LENGTH:
+            log_printf(LOG_DEBUG, DBG_CAN_RX_FAILED, event->ifName);
+            break;
+        case CO_LOG_CAN_RX_QUEUE_OVERFLOW:
+            log_printf(LOG_ERR, CAN_RX_SOCKET_QUEUE_OVERFLOW,
+                       event->ifName, event->arg);
+            break;
+        case CO_LOG_CAN_RX_EPOLL:
+            log_printf(LOG_DEBUG, DBG_CAN_RX_EPOLL, event->arg, strerror(event->err));
+            break;
+        case CO_LOG_CAN_TX_FAILED:
+            log_printf(LOG_ERR, DBG_CAN_TX_FAILED, event->arg, event->ifName);
+            log_printf(LOG_DEBUG, DBG_ERRNO, "sendmmsg()");
+            break;
+        case CO_LOG_CAN_TX_SEND_FAILED:
+            log_printf(LOG_ERR, DBG_CAN_TX_FAILED, event->arg, event->ifName);
+            log_printf(LOG_DEBUG, DBG_ERRNO, "send()");
+            break;
+        case CO_LOG_CAN_TX_BUSY:
+            log_printf(LOG_ERR, DBG_CAN_TX_FAILED, event->arg, "CANx");
+            log_printf(LOG_DEBUG, DBG_ERRNO, "send()");
+            break;
+        default:
+            break;
+    }
+}
+
+
+/******************************************************************************/
+uint32_t CO_log_process(void)
+{
+    uint32_t suppressed[CO_LOG_EVENT_COUNT];
+    uint32_t count = 0;
+    uint64_t now_us;
+    uint32_t i;
+    int errnoSaved = errno;
+
+    for (;;) {
+        CO_logEvent_t event;
+
+        /* copy the event, writers may continue meanwhile */
+        CO_log_lock();
+        if (CO_logTail == CO_logHead) {
+            CO_log_unlock();
+            break;
+        }
+        event = CO_logQueue[CO_logTail % CO_LOG_QUEUE_SIZE];
+        CO_logTail ++;
+        CO_logStatistics.logged ++;
+        CO_log_unlock();
+
+        CO_log_write(&event);
+        count ++;
+    }
+
+    /* report suppressed events once per period */
+    now_us = CO_log_time_us();
+    CO_log_lock();
+    for (i = 0; i < CO_LOG_EVENT_COUNT; i++) {
+        CO_logRate_t *rate = &CO_logRate[i];
+
+        suppressed[i] = 0;
+        if ((rate->suppressed > 0) &&
+            ((now_us - rate->report_us) >= (uint64_t)CO_LOG_RATE_PERIOD_MS * 1000U)) {
+            suppressed[i] = rate->suppressed;
+            rate->suppressed = 0;
+            rate->report_us = now_us;
+        }
+    }
+    CO_log_unlock();
+
+    for (i = 0; i < CO_LOG_EVENT_COUNT; i++) {
+        if (suppressed[i] > 0) {
+            log_printf(LOG_NOTICE, DBG_LOG_SUPPRESSED, CO_logEventName[i], suppressed[i]);
+        }
+    }
+    (void)CO_logEventName;
+
+    errno = errnoSaved;
+    return count;
+}
+
+
+/******************************************************************************/
+void CO_log_getStatistics(CO_logStatistics_t *statistics)
+{
+    if (statistics == NULL) {
+        return;
+    }
+    CO_log_lock();
+    *statistics = CO_logStatistics;
+    CO_log_unlock();
+}
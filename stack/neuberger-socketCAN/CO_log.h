@@ -0,0 +1,156 @@
+/**
+ * Deferred, rate limited logging of the Linux socketCAN driver.
+ *
+ * @file        CO_log.h
+ * @ingroup     CO_driver
+ * @copyright   2019 Neuberger Gebaeudeautomation GmbH
+ *
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+#ifndef CO_LOG_H_
+#define CO_LOG_H_
+
+#include "CO_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_log Deferred logging
+ * @ingroup CO_driver
+ * @{
+ *
+ * Logging of errors which happen on the CAN hot path.
+ *
+ * CO_CANread(), CO_CANrxWait() and the transmit functions of the driver
+ * don't call log_printf() themselves. A formatted syslog message inside the
+ * rx thread or inside the tx lock would slow down the driver most, when the
+ * bus is disturbed and errors come in bursts. They call CO_log_event()
+ * instead, which stores a binary event into a ring in constant time.
+ *
+ * Each event id may be queued #CO_LOG_RATE_MAX times per
+ * #CO_LOG_RATE_PERIOD_MS. Further events of the id and events which don't
+ * fit into the full ring are only counted. CO_log_process() is called from a
+ * non realtime thread, threadMain_process() of CO_Linux_threads.c does so.
+ * It formats the queued events with log_printf() and reports the number of
+ * suppressed events of an id at most once per #CO_LOG_RATE_PERIOD_MS.
+ *
+ * Without #CO_DRIVER_ERROR_REPORTING or syslog/log.h, log_printf() is empty
+ * and events are only counted, see CO_log_getStatistics().
+ */
+
+/** Number of events in the ring */
+#ifndef CO_LOG_QUEUE_SIZE
+  #define CO_LOG_QUEUE_SIZE       64U
+#endif
+
+/** Number of events per id, which are queued in #CO_LOG_RATE_PERIOD_MS */
+#ifndef CO_LOG_RATE_MAX
+  #define CO_LOG_RATE_MAX         5U
+#endif
+
+/** Period of the rate limit in ms */
+#ifndef CO_LOG_RATE_PERIOD_MS
+  #define CO_LOG_RATE_PERIOD_MS   10000U
+#endif
+
+/**
+ * Id of an event, selects message and priority of log_printf()
+ */
+typedef enum {
+    CO_LOG_CAN_RX_FAILED,         /**< recvmmsg() failed, arg: return value */
+    CO_LOG_CAN_RX_LENGTH,         /**< message with wrong length, arg: length */
+    CO_LOG_CAN_RX_QUEUE_OVERFLOW, /**< socket rx queue overflow, arg: dropped messages */
+    CO_LOG_CAN_RX_EPOLL,          /**< error or hangup on socket, arg: epoll events */
+    CO_LOG_CAN_TX_FAILED,         /**< sendmmsg() failed, arg: CAN ID */
+    CO_LOG_CAN_TX_SEND_FAILED,    /**< send() failed, arg: CAN ID */
+    CO_LOG_CAN_TX_BUSY,           /**< CO_CANsend() while busy, arg: CAN ID */
+    CO_LOG_EVENT_COUNT            /**< Number of event ids */
+} CO_logEventId_t;
+
+/**
+ * Event in the ring
+ */
+typedef struct {
+    uint8_t             id;             /**< #CO_logEventId_t */
+    int                 err;            /**< errno at the event */
+    uint32_t            arg;            /**< Argument, see #CO_logEventId_t */
+    char                ifName[IFNAMSIZ]; /**< CAN interface name */
+} CO_logEvent_t;
+
+/**
+ * Event statistics
+ */
+typedef struct {
+    uint32_t            events;         /**< All events from CO_log_event() */
+    uint32_t            logged;         /**< Events written by CO_log_process() */
+    uint32_t            suppressed;     /**< Events suppressed by the rate limit */
+    uint32_t            dropped;        /**< Events dropped, ring was full */
+} CO_logStatistics_t;
+
+/**
+ * Queue an event. Called by the driver, in constant time.
+ *
+ * @param id Event id.
+ * @param ifName CAN interface name, copied. May be NULL.
+ * @param arg Argument of the event.
+ * @param err errno of the failed call or 0.
+ */
+void CO_log_event(CO_logEventId_t id, const char *ifName, uint32_t arg, int err);
+
+/**
+ * Log queued events and report suppressed events.
+ *
+ * Must be called cyclically from one non realtime thread, it may block in
+ * log_printf().
+ *
+ * @return Number of events logged.
+ */
+uint32_t CO_log_process(void);
+
+/**
+ * Get event statistics since start of the program.
+ *
+ * @param [out] statistics Statistics.
+ */
+void CO_log_getStatistics(CO_logStatistics_t *statistics);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+#endif /* CO_LOG_H_ */
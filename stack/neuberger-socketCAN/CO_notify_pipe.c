@@ -3,31 +3,51 @@
 #include <unistd.h>
 #include <assert.h>
 #include <fcntl.h>
+#include <stdint.h>
 #include <stdlib.h>
+#if defined(__linux__) && !defined(CO_NOTIFY_PIPE_NO_EVENTFD)
+#include <sys/eventfd.h>
+#endif
 
 #include "CO_notify_pipe.h"
 
 struct CO_NotifyPipe {
     int m_receiveFd;
-    int m_sendFd;
+    int m_sendFd;           /* same as m_receiveFd for eventfd */
 };
 
 CO_NotifyPipe_t *CO_NotifyPipeCreate(void)
 {
     int pipefd[2];
     CO_NotifyPipe_t *p;
-    int ret = pipe(pipefd);
+    int ret = -1;
 
+#if defined(__linux__) && !defined(CO_NOTIFY_PIPE_NO_EVENTFD)
+    pipefd[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (pipefd[0] >= 0) {
+        pipefd[1] = pipefd[0];
+        ret = 0;
+    }
+#endif
     if (ret < 0) {
-        return NULL;
+        /* fallback to pipe */
+        ret = pipe(pipefd);
+        if (ret < 0) {
+            return NULL;
+        }
+        fcntl(pipefd[0],F_SETFL,O_NONBLOCK);
+        fcntl(pipefd[1],F_SETFL,O_NONBLOCK);
     }
     p = calloc(1, sizeof(CO_NotifyPipe_t));
     if (p == NULL) {
+        close(pipefd[0]);
+        if (pipefd[1] != pipefd[0]) {
+            close(pipefd[1]);
+        }
         return NULL;
     }
     p->m_receiveFd = pipefd[0];
     p->m_sendFd = pipefd[1];
-    fcntl(p->m_sendFd,F_SETFL,O_NONBLOCK);
     return p;
 }
 
@@ -36,7 +56,9 @@ void CO_NotifyPipeFree(CO_NotifyPipe_t *p)
     if (p == NULL) {
         return;
     }
-    close(p->m_sendFd);
+    if (p->m_sendFd != p->m_receiveFd) {
+        close(p->m_sendFd);
+    }
     close(p->m_receiveFd);
     free(p);
 }
@@ -53,8 +75,39 @@ int CO_NotifyPipeGetFd(CO_NotifyPipe_t *p)
 
 void CO_NotifyPipeSend(CO_NotifyPipe_t *p)
 {
+    ssize_t ret;
+
     if (p == NULL) {
         return;
     }
-    write(p->m_sendFd,"1",1);
+    if (p->m_sendFd == p->m_receiveFd) {
+        /* eventfd, adds to counter */
+        uint64_t one = 1;
+        ret = write(p->m_sendFd,&one,sizeof(one));
+    }
+    else {
+        /* a full pipe already means "pending", ignore EAGAIN */
+        ret = write(p->m_sendFd,"1",1);
+    }
+    (void)ret;
+}
+
+
+void CO_NotifyPipeDrain(CO_NotifyPipe_t *p)
+{
+    if (p == NULL) {
+        return;
+    }
+    if (p->m_sendFd == p->m_receiveFd) {
+        /* eventfd, one read resets counter */
+        uint64_t cnt;
+        ssize_t ret = read(p->m_receiveFd,&cnt,sizeof(cnt));
+        (void)ret;
+    }
+    else {
+        char buf[64];
+        while (read(p->m_receiveFd,buf,sizeof(buf)) == (ssize_t)sizeof(buf)) {
+            /* pipe holds more bytes */
+        }
+    }
 }
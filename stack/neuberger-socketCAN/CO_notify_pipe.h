@@ -58,8 +58,18 @@ extern "C" {
  * @{
  *
  * This is needed to wake up the can socket when blocking in select
+ *
+ * On Linux an eventfd is used. Notifications are coalesced into a counter,
+ * so sending never blocks or fills up a buffer and a single read drains all
+ * pending notifications. If eventfd is not available, or if
+ * #CO_NOTIFY_PIPE_NO_EVENTFD is defined, a non-blocking pipe is used instead.
  */
 
+/**
+ * Use pipe instead of eventfd
+ */
+//#define CO_NOTIFY_PIPE_NO_EVENTFD
+
 /**
  * Object
  */
@@ -93,6 +103,16 @@ int CO_NotifyPipeGetFd(CO_NotifyPipe_t *p);
  */
 void CO_NotifyPipeSend(CO_NotifyPipe_t *p);
 
+/**
+ * Drain all pending events
+ *
+ * Must be called after the file descriptor was reported readable, otherwise
+ * it stays readable.
+ *
+ * @param p pointer to object
+ */
+void CO_NotifyPipeDrain(CO_NotifyPipe_t *p);
+
 /** @} */
 
 #ifdef __cplusplus
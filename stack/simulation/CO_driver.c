@@ -0,0 +1,819 @@
+/*
+ * CAN module object for deterministic simulation of CAN networks.
+ *
+ * @file        CO_driver.c
+ * @ingroup     CO_driver
+ * @author      Janez Paternoster
+ * @copyright   2004 - 2015 Janez Paternoster, 2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include <string.h>
+
+#include "CO_driver.h"
+#include "CO_Emergency.h"
+#include "CO_tracepoint.h"
+#include "CO_statistics.h"
+
+
+/* Simulated CAN bus */
+typedef struct{
+    bool_t              used;
+    int32_t             CANbaseAddress;
+    uint16_t            pending;        /* Number of full mailboxes, which wait for arbitration */
+    bool_t              busy;           /* Frame is on the bus */
+    CO_CANmodule_t     *sender;         /* Sender of the frame on the bus or NULL, if disabled */
+    CO_CANrxMsg_t       frame;          /* Frame on the bus */
+    uint16_t            bitRate;        /* Bit rate of the frame on the bus */
+    uint32_t            bits;           /* Length of the frame on the bus */
+    uint64_t            start_ns;       /* Start of the frame on the bus */
+    uint64_t            end_ns;         /* End of the frame on the bus */
+    uint64_t            mailbox_ns;     /* Time, frame on the bus was put into the mailbox */
+    uint64_t            idle_ns;        /* End of the previous frame */
+    CO_simStatistics_t  statistics;
+}CO_sim_bus_t;
+
+/* Receive buffer of a module, which accepts an identifier */
+typedef struct{
+    uint16_t            slot;           /* Index in CO_sim_modules */
+    uint16_t            index;          /* Index in rxArray */
+    uint32_t            next;           /* Next entry + 1 or 0 */
+}CO_sim_rxEntry_t;
+
+static CO_CANmodule_t *CO_sim_modules[CO_SIM_MAX_MODULES];
+static uint16_t CO_sim_moduleCount = 0U;   /* highest used index + 1 */
+static CO_sim_bus_t CO_sim_buses[CO_SIM_MAX_BUSES];
+static uint64_t CO_sim_now_ns = 0U;
+
+/* For each bus and identifier with rtr bit the first entry + 1 or 0. Built
+ * from the receive buffers of all modules, when they have changed. If there
+ * are more than CO_SIM_MAX_RX_ENTRIES, receive buffers are searched. */
+static uint32_t CO_sim_rxTable[CO_SIM_MAX_BUSES][0x1000U];
+static CO_sim_rxEntry_t CO_sim_rxEntries[CO_SIM_MAX_RX_ENTRIES];
+static bool_t CO_sim_rxTableValid = false;
+static bool_t CO_sim_rxTableChanged = true;
+
+
+/*
+ * Length of the frame on the bus in bits: SOF, arbitration, control, data
+ * and CRC field with stuff bits, then CRC delimiter, ACK, EOF and interframe
+ * space.
+ */
+static uint32_t CO_sim_frameBits(const CO_CANrxMsg_t *msg){
+    uint8_t bits[34U + 64U];
+    uint16_t n = 0U;
+    uint16_t crc = 0U;
+    uint16_t i;
+    uint8_t run, last;
+    uint32_t stuff = 0U;
+    uint16_t ident = (uint16_t)(msg->ident & 0x07FFU);
+    bool_t rtr = ((msg->ident & 0x0800U) != 0U) ? true : false;
+    uint8_t DLC = msg->DLC & 0x0FU;
+    uint8_t length = rtr ? 0U : ((DLC > 8U) ? 8U : DLC);
+
+    bits[n++] = 0U;                                 /* SOF */
+    for(i=11U; i>0U; i--){
+        bits[n++] = (uint8_t)((ident >> (i - 1U)) & 1U);
+    }
+    bits[n++] = rtr ? 1U : 0U;                      /* RTR */
+    bits[n++] = 0U;                                 /* IDE */
+    bits[n++] = 0U;                                 /* r0 */
+    for(i=4U; i>0U; i--){
+        bits[n++] = (uint8_t)((DLC >> (i - 1U)) & 1U);
+    }
+    for(i=0U; i<(uint16_t)length*8U; i++){
+        bits[n++] = (uint8_t)((msg->data[i / 8U] >> (7U - (i % 8U))) & 1U);
+    }
+
+    /* CRC-15, polynomial 0x4599 */
+    for(i=0U; i<n; i++){
+        uint8_t crcNext = (uint8_t)(bits[i] ^ ((crc >> 14) & 1U));
+
+        crc = (uint16_t)((crc << 1) & 0x7FFFU);
+        if(crcNext != 0U){
+            crc ^= 0x4599U;
+        }
+    }
+    for(i=15U; i>0U; i--){
+        bits[n++] = (uint8_t)((crc >> (i - 1U)) & 1U);
+    }
+
+    /* After five equal bits a complementary stuff bit is inserted */
+    run = 1U;
+    last = bits[0];
+    for(i=1U; i<n; i++){
+        if(bits[i] == last){
+            run++;
+            if(run == 5U){
+                stuff++;
+                last = (uint8_t)(last ^ 1U);
+                run = 1U;
+            }
+        }
+        else{
+            last = bits[i];
+            run = 1U;
+        }
+    }
+
+    return (uint32_t)n + stuff + 13U;
+}
+
+
+/*
+ * Put message into the transmit mailbox of the module.
+ */
+static void CO_sim_loadMailbox(CO_CANmodule_t *CANmodule, const CO_CANtx_t *buffer){
+    CANmodule->txMailbox.ident = buffer->ident;
+    CANmodule->txMailbox.DLC = buffer->DLC;
+    memcpy(CANmodule->txMailbox.data, buffer->data, sizeof(CANmodule->txMailbox.data));
+    CANmodule->txMailboxFull = true;
+    CANmodule->txMailboxTime_ns = CO_sim_now_ns;
+    CANmodule->bufferInhibitFlag = buffer->syncFlag;
+    CO_sim_buses[CANmodule->bus].pending++;
+}
+
+
+/*
+ * Move the first message waiting in transmit buffers into the free mailbox.
+ */
+static void CO_sim_sendPending(CO_CANmodule_t *CANmodule){
+    CO_CANtx_t *buffer = &CANmodule->txArray[0];
+    uint16_t i;
+
+    if(CANmodule->txMailboxFull || (CANmodule->CANtxCount == 0U)){
+        return;
+    }
+    for(i = CANmodule->txSize; i > 0U; i--){
+        if(buffer->bufferFull){
+            buffer->bufferFull = false;
+            CANmodule->CANtxCount--;
+            CO_sim_loadMailbox(CANmodule, buffer);
+            return;
+        }
+        buffer++;
+    }
+    /* Clear counter if no more messages */
+    CANmodule->CANtxCount = 0U;
+}
+
+
+/*
+ * Remove message from the mailbox, if it is not on the bus.
+ */
+static bool_t CO_sim_abortMailbox(CO_CANmodule_t *CANmodule){
+    CO_sim_bus_t *bus = &CO_sim_buses[CANmodule->bus];
+
+    if(!CANmodule->txMailboxFull || (bus->busy && (bus->sender == CANmodule))){
+        return false;
+    }
+    CANmodule->txMailboxFull = false;
+    bus->pending--;
+    return true;
+}
+
+
+/*
+ * Build CO_sim_rxTable from the receive buffers of all modules. Like the
+ * search in CO_sim_receive(), only the first matching buffer of a module
+ * receives the identifier.
+ */
+static void CO_sim_rxTableBuild(void){
+    static uint32_t tail[0x1000U];
+    static uint16_t stamp[0x1000U];
+    uint32_t count = 0U;
+    uint16_t bus, slot, i;
+
+    CO_sim_rxTableChanged = false;
+    CO_sim_rxTableValid = false;
+    memset(CO_sim_rxTable, 0, sizeof(CO_sim_rxTable));
+
+    for(bus=0U; bus<CO_SIM_MAX_BUSES; bus++){
+        if(!CO_sim_buses[bus].used){
+            continue;
+        }
+        memset(stamp, 0, sizeof(stamp));
+        for(slot=0U; slot<CO_sim_moduleCount; slot++){
+            CO_CANmodule_t *CANmodule = CO_sim_modules[slot];
+
+            if((CANmodule == NULL) || (CANmodule->bus != bus)){
+                continue;
+            }
+            for(i=0U; i<CANmodule->rxSize; i++){
+                const CO_CANrx_t *buffer = &CANmodule->rxArray[i];
+                uint16_t free = (uint16_t)(~buffer->mask) & 0x0FFFU;
+                uint16_t sub = 0U;
+
+                /* all identifiers, which match ident in the bits of mask */
+                do{
+                    uint16_t ident = (buffer->ident & buffer->mask & 0x0FFFU) | sub;
+
+                    if(stamp[ident] != (slot + 1U)){
+                        stamp[ident] = slot + 1U;
+                        if(buffer->pFunct != NULL){
+                            if(count == CO_SIM_MAX_RX_ENTRIES){
+                                return;
+                            }
+                            CO_sim_rxEntries[count].slot = slot;
+                            CO_sim_rxEntries[count].index = i;
+                            CO_sim_rxEntries[count].next = 0U;
+                            count++;
+                            if(CO_sim_rxTable[bus][ident] == 0U){
+                                CO_sim_rxTable[bus][ident] = count;
+                            }
+                            else{
+                                CO_sim_rxEntries[tail[ident] - 1U].next = count;
+                            }
+                            tail[ident] = count;
+                        }
+                    }
+                    sub = (uint16_t)(sub - free) & free;
+                }while(sub != 0U);
+            }
+        }
+    }
+    CO_sim_rxTableValid = true;
+}
+
+
+/*
+ * Call function of the receive buffer.
+ */
+static void CO_sim_rxCallback(CO_CANmodule_t *CANmodule, CO_CANrx_t *buffer, const CO_CANrxMsg_t *rcvMsg){
+    CO_TP_BEGIN(CO_TP_RX_CALLBACK, buffer - CANmodule->rxArray);
+    CO_STAT_RX(CANmodule, buffer - CANmodule->rxArray);
+    buffer->pFunct(buffer->object, rcvMsg);
+    CO_TP_END(CO_TP_RX_CALLBACK, buffer - CANmodule->rxArray);
+}
+
+
+/*
+ * Search receive buffer for the message and call its function.
+ */
+static void CO_sim_receive(CO_CANmodule_t *CANmodule, const CO_CANrxMsg_t *rcvMsg){
+    CO_CANrx_t *buffer = &CANmodule->rxArray[0];
+    uint16_t index;
+
+    for(index = CANmodule->rxSize; index > 0U; index--){
+        if((((uint16_t)rcvMsg->ident ^ buffer->ident) & buffer->mask) == 0U){
+            if(buffer->pFunct != NULL){
+                CO_sim_rxCallback(CANmodule, buffer, rcvMsg);
+            }
+            break;
+        }
+        buffer++;
+    }
+}
+
+
+/*
+ * Start transmission of the mailbox with the highest priority on the idle
+ * bus. Returns false, if no module in normal mode has a message.
+ */
+static bool_t CO_sim_arbitrate(uint16_t busIndex){
+    CO_sim_bus_t *bus = &CO_sim_buses[busIndex];
+    CO_CANmodule_t *winner = NULL;
+    uint32_t winnerKey = 0xFFFFFFFFU;
+    uint16_t i;
+
+    for(i=0U; i<CO_sim_moduleCount; i++){
+        CO_CANmodule_t *CANmodule = CO_sim_modules[i];
+
+        if((CANmodule != NULL) && (CANmodule->bus == busIndex) &&
+           CANmodule->txMailboxFull && CANmodule->CANnormal)
+        {
+            /* identifier bits first, then dominant RTR bit of data frame */
+            uint32_t key = ((CANmodule->txMailbox.ident & 0x07FFU) << 1)
+                         | ((CANmodule->txMailbox.ident & 0x0800U) >> 11);
+
+            if(key < winnerKey){
+                winnerKey = key;
+                winner = CANmodule;
+            }
+        }
+    }
+    if(winner == NULL){
+        return false;
+    }
+
+    bus->pending--;
+    bus->busy = true;
+    bus->sender = winner;
+    bus->frame = winner->txMailbox;
+    bus->bitRate = winner->CANbitRate;
+    bus->bits = CO_sim_frameBits(&bus->frame);
+    bus->start_ns = CO_sim_now_ns;
+    bus->end_ns = CO_sim_now_ns + ((uint64_t)bus->bits * 1000000U) / winner->CANbitRate;
+    bus->mailbox_ns = winner->txMailboxTime_ns;
+
+    return true;
+}
+
+
+/*
+ * End of frame: transmit interrupt of the sender, then reception by all
+ * other modules on the bus.
+ */
+static void CO_sim_complete(uint16_t busIndex){
+    CO_sim_bus_t *bus = &CO_sim_buses[busIndex];
+    CO_CANmodule_t *sender = bus->sender;
+    CO_CANrxMsg_t frame = bus->frame;
+    uint16_t bitRate = bus->bitRate;
+    uint16_t i;
+
+    bus->busy = false;
+    bus->sender = NULL;
+    bus->idle_ns = CO_sim_now_ns;
+    bus->statistics.frames++;
+    bus->statistics.bits += bus->bits;
+    bus->statistics.busyTime_ns += bus->end_ns - bus->start_ns;
+    if((bus->end_ns - bus->mailbox_ns) > bus->statistics.maxLatency_ns){
+        bus->statistics.maxLatency_ns = bus->end_ns - bus->mailbox_ns;
+    }
+
+    if(sender != NULL){
+        CO_LOCK_CAN_SEND();
+        /* First CAN message (bootup) was sent successfully */
+        sender->firstCANtxMessage = false;
+        /* clear flag from previous message */
+        sender->bufferInhibitFlag = false;
+        sender->txMailboxFull = false;
+        CO_sim_sendPending(sender);
+        CO_UNLOCK_CAN_SEND();
+    }
+
+    if(CO_sim_rxTableChanged){
+        CO_sim_rxTableBuild();
+    }
+
+    /* modules with other bit rate see only errors */
+#ifdef CO_USE_STATISTICS
+    for(i=0U; i<CO_sim_moduleCount; i++){
+        CO_CANmodule_t *CANmodule = CO_sim_modules[i];
+
+        if((CANmodule != NULL) && (CANmodule != sender) && (CANmodule->bus == busIndex) &&
+           CANmodule->CANnormal && (CANmodule->CANbitRate == bitRate))
+        {
+            CO_STAT_BUS(CANmodule, frame.DLC);
+        }
+    }
+#endif
+    if(CO_sim_rxTableValid){
+        uint32_t entry = CO_sim_rxTable[busIndex][frame.ident & 0x0FFFU];
+
+        while(entry != 0U){
+            const CO_sim_rxEntry_t *e = &CO_sim_rxEntries[entry - 1U];
+            CO_CANmodule_t *CANmodule = CO_sim_modules[e->slot];
+
+            /* callback may have disabled or initialized a module */
+            if((CANmodule != NULL) && (CANmodule != sender) && (CANmodule->bus == busIndex) &&
+               CANmodule->CANnormal && (CANmodule->CANbitRate == bitRate) &&
+               (e->index < CANmodule->rxSize) && (CANmodule->rxArray[e->index].pFunct != NULL))
+            {
+                CO_sim_rxCallback(CANmodule, &CANmodule->rxArray[e->index], &frame);
+            }
+            entry = e->next;
+        }
+        return;
+    }
+    for(i=0U; i<CO_sim_moduleCount; i++){
+        CO_CANmodule_t *CANmodule = CO_sim_modules[i];
+
+        if((CANmodule != NULL) && (CANmodule != sender) && (CANmodule->bus == busIndex) &&
+           CANmodule->CANnormal && (CANmodule->CANbitRate == bitRate))
+        {
+            CO_sim_receive(CANmodule, &frame);
+        }
+    }
+}
+
+
+/******************************************************************************/
+void CO_CANsetConfigurationMode(int32_t CANbaseAddress){
+    /* CANbaseAddress is the bus, which is shared by many modules. Module is
+     * in configuration mode after CO_CANmodule_init() anyway. */
+    (void)CANbaseAddress;
+}
+
+
+/******************************************************************************/
+void CO_CANsetNormalMode(CO_CANmodule_t *CANmodule){
+    CANmodule->CANnormal = true;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANmodule_init(
+        CO_CANmodule_t         *CANmodule,
+        int32_t                 CANbaseAddress,
+        CO_CANrx_t              rxArray[],
+        uint16_t                rxSize,
+        CO_CANtx_t              txArray[],
+        uint16_t                txSize,
+        uint16_t                CANbitRate)
+{
+    uint16_t i, slot = CO_SIM_MAX_MODULES, bus = CO_SIM_MAX_BUSES;
+
+    /* verify arguments */
+    if(CANmodule==NULL || rxArray==NULL || txArray==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* module is initialized again, remove it from the bus first */
+    for(i=0U; i<CO_sim_moduleCount; i++){
+        if(CO_sim_modules[i] == CANmodule){
+            CO_CANmodule_disable(CANmodule);
+            break;
+        }
+    }
+
+    /* connect to the bus */
+    for(i=0U; i<CO_SIM_MAX_BUSES; i++){
+        if(CO_sim_buses[i].used && (CO_sim_buses[i].CANbaseAddress == CANbaseAddress)){
+            bus = i;
+            break;
+        }
+        if(!CO_sim_buses[i].used && (bus == CO_SIM_MAX_BUSES)){
+            bus = i;
+        }
+    }
+    for(i=0U; i<CO_SIM_MAX_MODULES; i++){
+        if(CO_sim_modules[i] == NULL){
+            slot = i;
+            break;
+        }
+    }
+    if((bus == CO_SIM_MAX_BUSES) || (slot == CO_SIM_MAX_MODULES)){
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+    if(!CO_sim_buses[bus].used){
+        memset(&CO_sim_buses[bus], 0, sizeof(CO_sim_buses[bus]));
+        CO_sim_buses[bus].used = true;
+        CO_sim_buses[bus].CANbaseAddress = CANbaseAddress;
+        CO_sim_buses[bus].idle_ns = CO_sim_now_ns;
+    }
+    CO_sim_modules[slot] = CANmodule;
+    if(slot >= CO_sim_moduleCount){
+        CO_sim_moduleCount = slot + 1U;
+    }
+
+    /* Configure object variables */
+    CANmodule->CANbaseAddress = CANbaseAddress;
+    CANmodule->bus = bus;
+    switch(CANbitRate){
+        case 10: case 20: case 50: case 125: case 250: case 500: case 800: case 1000:
+            CANmodule->CANbitRate = CANbitRate;
+            break;
+        default:
+            CANmodule->CANbitRate = 125U;
+            break;
+    }
+    CANmodule->rxArray = rxArray;
+    CANmodule->rxSize = rxSize;
+    CANmodule->txArray = txArray;
+    CANmodule->txSize = txSize;
+    CANmodule->CANnormal = false;
+    CANmodule->useCANrxFilters = false;
+    CANmodule->bufferInhibitFlag = false;
+    CANmodule->firstCANtxMessage = true;
+    CANmodule->CANtxCount = 0U;
+    CANmodule->errOld = 0U;
+    CANmodule->em = NULL;
+    CANmodule->txMailboxFull = false;
+    CANmodule->txMailboxTime_ns = 0U;
+    CO_sim_rxTableChanged = true;
+
+    for(i=0U; i<rxSize; i++){
+        rxArray[i].ident = 0U;
+        rxArray[i].mask = 0xFFFFU;
+        rxArray[i].object = NULL;
+        rxArray[i].pFunct = NULL;
+    }
+    for(i=0U; i<txSize; i++){
+        txArray[i].bufferFull = false;
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_CANmodule_disable(CO_CANmodule_t *CANmodule){
+    CO_sim_bus_t *bus;
+    uint16_t i;
+
+    for(i=0U; i<CO_sim_moduleCount; i++){
+        if(CO_sim_modules[i] == CANmodule){
+            break;
+        }
+    }
+    if(i == CO_sim_moduleCount){
+        return;
+    }
+    CO_sim_modules[i] = NULL;
+    CO_sim_rxTableChanged = true;
+    while((CO_sim_moduleCount > 0U) && (CO_sim_modules[CO_sim_moduleCount - 1U] == NULL)){
+        CO_sim_moduleCount--;
+    }
+
+    /* frame on the bus is completed without the sender */
+    bus = &CO_sim_buses[CANmodule->bus];
+    if(bus->busy && (bus->sender == CANmodule)){
+        bus->sender = NULL;
+    }
+    else if(CANmodule->txMailboxFull){
+        bus->pending--;
+    }
+    CANmodule->txMailboxFull = false;
+    CANmodule->CANnormal = false;
+}
+
+
+/******************************************************************************/
+uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg){
+    return (uint16_t) rxMsg->ident;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANrxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        uint16_t                ident,
+        uint16_t                mask,
+        bool_t                  rtr,
+        void                   *object,
+        void                  (*pFunct)(void *object, const CO_CANrxMsg_t *message))
+{
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    if((CANmodule!=NULL) && (object!=NULL) && (pFunct!=NULL) && (index < CANmodule->rxSize)){
+        CO_CANrx_t *buffer = &CANmodule->rxArray[index];
+
+        buffer->object = object;
+        buffer->pFunct = pFunct;
+        buffer->ident = ident & 0x07FFU;
+        if(rtr){
+            buffer->ident |= 0x0800U;
+        }
+        buffer->mask = (mask & 0x07FFU) | 0x0800U;
+        CO_sim_rxTableChanged = true;
+    }
+    else{
+        ret = CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    return ret;
+}
+
+
+/******************************************************************************/
+CO_CANtx_t *CO_CANtxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        uint16_t                ident,
+        bool_t                  rtr,
+        uint8_t                 noOfBytes,
+        bool_t                  syncFlag)
+{
+    CO_CANtx_t *buffer = NULL;
+
+    if((CANmodule != NULL) && (index < CANmodule->txSize)){
+        buffer = &CANmodule->txArray[index];
+
+        /* CAN identifier and rtr with the same alignment as receive buffers */
+        buffer->ident = ((uint32_t)ident & 0x07FFU) | ((uint32_t)(rtr ? 0x0800U : 0U));
+        buffer->DLC = noOfBytes;
+
+        buffer->bufferFull = false;
+        buffer->syncFlag = syncFlag;
+    }
+
+    return buffer;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
+    CO_ReturnError_t err = CO_ERROR_NO;
+
+    /* Verify overflow */
+    if(buffer->bufferFull){
+        if(!CANmodule->firstCANtxMessage){
+            /* don't set error, if bootup message is still on buffers */
+            CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, buffer->ident);
+        }
+        err = CO_ERROR_TX_OVERFLOW;
+    }
+    CO_STAT_TX(CANmodule, buffer - CANmodule->txArray);
+    CO_STAT_BUS(CANmodule, buffer->DLC);
+
+    CO_LOCK_CAN_SEND();
+    /* if mailbox is free, copy message to it */
+    if(!CANmodule->txMailboxFull && (CANmodule->CANtxCount == 0U)){
+        CO_sim_loadMailbox(CANmodule, buffer);
+    }
+    /* message will be sent after the end of the frame in the mailbox */
+    else if(!buffer->bufferFull){
+        buffer->bufferFull = true;
+        CANmodule->CANtxCount++;
+    }
+    CO_UNLOCK_CAN_SEND();
+
+    return err;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANCheckSend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
+    /* one buffer per message type, like the driver template */
+    return CO_CANsend(CANmodule, buffer);
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANsendFromISR(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
+    CO_ReturnError_t err = CO_ERROR_NO;
+
+    CO_LOCK_CAN_SEND();
+    /* overtake messages waiting for the mailbox */
+    if(!CANmodule->txMailboxFull && !buffer->bufferFull){
+        CO_STAT_TX(CANmodule, buffer - CANmodule->txArray);
+        CO_STAT_BUS(CANmodule, buffer->DLC);
+        CO_sim_loadMailbox(CANmodule, buffer);
+        CO_UNLOCK_CAN_SEND();
+    }
+    else{
+        CO_UNLOCK_CAN_SEND();
+        err = CO_CANsend(CANmodule, buffer);
+    }
+
+    return err;
+}
+
+
+/******************************************************************************/
+void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule){
+    uint32_t tpdoDeleted = 0U;
+
+    CO_LOCK_CAN_SEND();
+    /* Abort message from mailbox, if it is synchronous TPDO and not on the bus */
+    if(CANmodule->bufferInhibitFlag && CO_sim_abortMailbox(CANmodule)){
+        CANmodule->bufferInhibitFlag = false;
+        tpdoDeleted = 1U;
+    }
+    /* delete also pending synchronous TPDOs in TX buffers */
+    if(CANmodule->CANtxCount != 0U){
+        uint16_t i;
+        CO_CANtx_t *buffer = &CANmodule->txArray[0];
+        for(i = CANmodule->txSize; i > 0U; i--){
+            if(buffer->bufferFull && buffer->syncFlag){
+                buffer->bufferFull = false;
+                CANmodule->CANtxCount--;
+                tpdoDeleted = 2U;
+            }
+            buffer++;
+        }
+    }
+    CO_sim_sendPending(CANmodule);
+    CO_UNLOCK_CAN_SEND();
+
+
+    if(tpdoDeleted != 0U){
+        CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_TPDO_OUTSIDE_WINDOW, CO_EMC_COMMUNICATION, tpdoDeleted);
+    }
+}
+
+
+/******************************************************************************/
+void CO_CANverifyErrors(CO_CANmodule_t *CANmodule){
+    /* simulated bus has no errors */
+    (void)CANmodule;
+}
+
+
+/******************************************************************************/
+void CO_CANinterrupt(CO_CANmodule_t *CANmodule){
+    /* messages are received and transmitted by CO_sim_run() */
+    (void)CANmodule;
+}
+
+
+/******************************************************************************/
+void CO_sim_reset(void){
+    memset(CO_sim_modules, 0, sizeof(CO_sim_modules));
+    memset(CO_sim_buses, 0, sizeof(CO_sim_buses));
+    CO_sim_moduleCount = 0U;
+    CO_sim_now_ns = 0U;
+    CO_sim_rxTableValid = false;
+    CO_sim_rxTableChanged = true;
+}
+
+
+/******************************************************************************/
+uint32_t CO_sim_run(uint32_t time_us){
+    uint64_t end_ns = CO_sim_now_ns + (uint64_t)time_us * 1000U;
+    bool_t blocked[CO_SIM_MAX_BUSES];
+    uint32_t count = 0U;
+    uint16_t i;
+
+    memset(blocked, 0, sizeof(blocked));
+
+    /* process events of all buses in time order */
+    for(;;){
+        uint16_t next = CO_SIM_MAX_BUSES;
+        uint64_t next_ns = 0U;
+
+        for(i=0U; i<CO_SIM_MAX_BUSES; i++){
+            CO_sim_bus_t *bus = &CO_sim_buses[i];
+            uint64_t t;
+
+            if(bus->busy){
+                t = bus->end_ns;
+            }
+            else if((bus->pending > 0U) && !blocked[i]){
+                t = (bus->idle_ns > CO_sim_now_ns) ? bus->idle_ns : CO_sim_now_ns;
+            }
+            else{
+                continue;
+            }
+            if((t <= end_ns) && ((next == CO_SIM_MAX_BUSES) || (t < next_ns))){
+                next = i;
+                next_ns = t;
+            }
+        }
+        if(next == CO_SIM_MAX_BUSES){
+            break;
+        }
+
+        CO_sim_now_ns = next_ns;
+        if(CO_sim_buses[next].busy){
+            CO_sim_complete(next);
+            count++;
+            memset(blocked, 0, sizeof(blocked));
+        }
+        else if(!CO_sim_arbitrate(next)){
+            /* only modules in configuration mode have messages */
+            blocked[next] = true;
+        }
+    }
+    CO_sim_now_ns = end_ns;
+
+    return count;
+}
+
+
+/******************************************************************************/
+uint64_t CO_sim_time_us(void){
+    return CO_sim_now_ns / 1000U;
+}
+
+
+/******************************************************************************/
+void CO_sim_getStatistics(int32_t CANbaseAddress, CO_simStatistics_t *statistics){
+    uint16_t i;
+
+    memset(statistics, 0, sizeof(*statistics));
+    for(i=0U; i<CO_SIM_MAX_BUSES; i++){
+        if(CO_sim_buses[i].used && (CO_sim_buses[i].CANbaseAddress == CANbaseAddress)){
+            *statistics = CO_sim_buses[i].statistics;
+            break;
+        }
+    }
+}
@@ -33,11 +33,70 @@
 #include <stdio.h>
 #include <string.h>     /* for memcpy */
 #include <stdlib.h>     /* for malloc, free */
+#include <unistd.h>     /* for fsync */
+#include <fcntl.h>      /* for open */
+#include <sys/mman.h>   /* for mmap, msync */
+#include <sys/stat.h>   /* for fstat */
 
 
 #define RETURN_SUCCESS  0
 #define RETURN_ERROR   -1
 
+/* Size of one slot in memory mapped file: data, sequence number and CRC. */
+#define CO_OD_STORAGE_SLOT_SIZE(odSize)  ((odSize) + 6U)
+
+
+/*
+ * Copy memory block into the older slot of memory mapped file and flush it
+ * with msync() flags MS_SYNC or MS_ASYNC.
+ */
+static CO_ReturnError_t CO_OD_storage_saveMapped(CO_OD_storage_t *odStor, int flags) {
+    uint8_t slot = odStor->slot ^ 1U;
+    uint8_t *p = &odStor->map[slot * CO_OD_STORAGE_SLOT_SIZE(odStor->odSize)];
+    uint32_t sequence = odStor->sequence + 1U;
+    uint16_t CRC;
+
+    if(sequence == 0U) {
+        sequence = 1U;
+    }
+
+    CO_LOCK_OD();
+    memcpy(p, odStor->odAddress, odStor->odSize);
+    CO_UNLOCK_OD();
+
+    memcpy(&p[odStor->odSize], &sequence, 4);
+    CRC = crc16_ccitt((unsigned char*)p, odStor->odSize + 4U, 0);
+    memcpy(&p[odStor->odSize + 4U], &CRC, 2);
+
+    odStor->slot = slot;
+    odStor->sequence = sequence;
+
+    /* only dirty pages are written */
+    if(msync(odStor->map, odStor->mapSize, flags) != 0) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    return CO_ERROR_NO;
+}
+
+
+/*
+ * Invalidate both slots of memory mapped file, so default values are used
+ * after next startup.
+ */
+static CO_ReturnError_t CO_OD_storage_restoreMapped(CO_OD_storage_t *odStor) {
+    uint32_t slotSize = CO_OD_STORAGE_SLOT_SIZE(odStor->odSize);
+
+    memset(&odStor->map[odStor->odSize], 0, 4);
+    memset(&odStor->map[slotSize + odStor->odSize], 0, 4);
+    odStor->sequence = 0U;
+    odStor->dirty = false;
+
+    if(msync(odStor->map, odStor->mapSize, MS_SYNC) != 0) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    return CO_ERROR_NO;
+}
+
 
 /******************************************************************************/
 CO_SDO_abortCode_t CO_ODF_1010(CO_ODF_arg_t *ODF_arg) {
@@ -55,9 +114,17 @@ CO_SDO_abortCode_t CO_ODF_1010(CO_ODF_arg_t *ODF_arg) {
         if(ODF_arg->subIndex == 1) {
             /* store parameters */
             if(value == 0x65766173UL) {
-                if(CO_OD_storage_saveSecure(odStor->odAddress, odStor->odSize, odStor->filename) != 0) {
+                /* don't interfere with the autoSave writer thread */
+                pthread_mutex_lock(&odStor->mtx);
+                if(odStor->map != NULL) {
+                    if(CO_OD_storage_saveMapped(odStor, MS_SYNC) != CO_ERROR_NO) {
+                        ret = CO_SDO_AB_HW;
+                    }
+                }
+                else if(CO_OD_storage_saveSecure(odStor->odAddress, odStor->odSize, odStor->filename) != 0) {
                     ret = CO_SDO_AB_HW;
                 }
+                pthread_mutex_unlock(&odStor->mtx);
             }
             else {
                 ret = CO_SDO_AB_DATA_TRANSF;
@@ -85,9 +152,16 @@ CO_SDO_abortCode_t CO_ODF_1011(CO_ODF_arg_t *ODF_arg) {
         if(ODF_arg->subIndex >= 1) {
             /* restore default parameters */
             if(value == 0x64616F6CUL) {
-                if(CO_OD_storage_restoreSecure(odStor->filename) != 0) {
+                pthread_mutex_lock(&odStor->mtx);
+                if(odStor->map != NULL) {
+                    if(CO_OD_storage_restoreMapped(odStor) != CO_ERROR_NO) {
+                        ret = CO_SDO_AB_HW;
+                    }
+                }
+                else if(CO_OD_storage_restoreSecure(odStor->filename) != 0) {
                     ret = CO_SDO_AB_HW;
                 }
+                pthread_mutex_unlock(&odStor->mtx);
             }
             else {
                 ret = CO_SDO_AB_DATA_TRANSF;
@@ -229,26 +303,36 @@ CO_ReturnError_t CO_OD_storage_init(
         char                   *filename)
 {
     CO_ReturnError_t ret = CO_ERROR_NO;
-    void *buf = NULL;
+    uint8_t *buf = NULL;
 
     /* verify arguments */
     if(odStor==NULL || odAddress==NULL) {
-        ret = CO_ERROR_ILLEGAL_ARGUMENT;
+        return CO_ERROR_ILLEGAL_ARGUMENT;
     }
 
-    /* configure object variables and allocate buffer */
-    if(ret == CO_ERROR_NO) {
-        odStor->odAddress = odAddress;
-        odStor->odSize = odSize;
-        odStor->filename = filename;
-        odStor->fp = NULL;
-        odStor->tmr1msPrev = 0;
-        odStor->lastSavedMs = 0;
-
-        buf = malloc(odStor->odSize);
-        if(buf == NULL) {
-            ret = CO_ERROR_OUT_OF_MEMORY;
-        }
+    /* configure object variables and allocate buffers */
+    odStor->odAddress = odAddress;
+    odStor->odSize = odSize;
+    odStor->filename = filename;
+    odStor->tmr1msPrev = 0;
+    odStor->lastSavedMs = 0;
+    odStor->dirty = false;
+    odStor->threadRunning = false;
+    odStor->threadTerminate = false;
+    odStor->writePending = false;
+    odStor->writeResult = CO_ERROR_NO;
+    odStor->map = NULL;
+    odStor->mapSize = 0;
+    odStor->slot = 0;
+    odStor->sequence = 0;
+    pthread_mutex_init(&odStor->mtx, NULL);
+    pthread_cond_init(&odStor->cond, NULL);
+
+    odStor->shadow = malloc(odStor->odSize);
+    odStor->writeBuf = malloc(odStor->odSize);
+    buf = odStor->writeBuf;
+    if(odStor->shadow == NULL || buf == NULL) {
+        ret = CO_ERROR_OUT_OF_MEMORY;
     }
 
     /* read data from the file and verify CRC */
@@ -269,6 +353,7 @@ CO_ReturnError_t CO_OD_storage_init(
         if(cnt == 2 && *((char*)buf) == '-') {
             /* file is empty, default values will be used, no error */
             ret = CO_ERROR_NO;
+            odStor->dirty = true;
         }
         else if(cnt != (odStor->odSize + 2)) {
             /* file length does not match */
@@ -284,87 +369,289 @@ CO_ReturnError_t CO_OD_storage_init(
         }
     }
 
-    free(buf);
+    /* autoSave compares against this copy instead of reading the file */
+    if(odStor->shadow != NULL) {
+        memcpy(odStor->shadow, odStor->odAddress, odStor->odSize);
+    }
 
     return ret;
 }
 
 
+/*
+ * Verify slot of memory mapped file. Returns its sequence number or 0, if the
+ * slot is empty or its CRC does not match (then crcError is set).
+ */
+static uint32_t CO_OD_storage_slotSequence(
+        const CO_OD_storage_t  *odStor,
+        uint8_t                 slot,
+        bool_t                 *crcError)
+{
+    const uint8_t *p = &odStor->map[slot * CO_OD_STORAGE_SLOT_SIZE(odStor->odSize)];
+    uint32_t sequence;
+    uint16_t CRC;
+
+    memcpy(&sequence, &p[odStor->odSize], 4);
+    memcpy(&CRC, &p[odStor->odSize + 4U], 2);
+    if(sequence == 0U) {
+        return 0U;
+    }
+    if(CRC != crc16_ccitt((const unsigned char*)p, odStor->odSize + 4U, 0)) {
+        *crcError = true;
+        return 0U;
+    }
+    return sequence;
+}
+
+
 /******************************************************************************/
-CO_ReturnError_t CO_OD_storage_autoSave(
+CO_ReturnError_t CO_OD_storage_initMapped(
         CO_OD_storage_t        *odStor,
-        uint16_t                timer1ms,
-        uint16_t                delay)
+        uint8_t                *odAddress,
+        uint32_t                odSize,
+        char                   *filename)
 {
     CO_ReturnError_t ret = CO_ERROR_NO;
+    struct stat st;
+    void *map;
+    int fd;
 
     /* verify arguments */
-    if(odStor==NULL || odStor->odAddress==NULL) {
-        ret = CO_ERROR_ILLEGAL_ARGUMENT;
+    if(odStor==NULL || odAddress==NULL || odSize==0) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
     }
 
-    /* don't save file more often than delay */
-    if(odStor->lastSavedMs < delay) {
-        odStor->lastSavedMs += timer1ms - odStor->tmr1msPrev;
+    /* configure object variables, mapped slot is used instead of buffers */
+    odStor->odAddress = odAddress;
+    odStor->odSize = odSize;
+    odStor->filename = filename;
+    odStor->tmr1msPrev = 0;
+    odStor->lastSavedMs = 0;
+    odStor->shadow = NULL;
+    odStor->writeBuf = NULL;
+    odStor->dirty = false;
+    odStor->threadRunning = false;
+    odStor->threadTerminate = false;
+    odStor->writePending = false;
+    odStor->writeResult = CO_ERROR_NO;
+    odStor->map = NULL;
+    odStor->mapSize = 2U * CO_OD_STORAGE_SLOT_SIZE(odSize);
+    odStor->slot = 0;
+    odStor->sequence = 0;
+    pthread_mutex_init(&odStor->mtx, NULL);
+    pthread_cond_init(&odStor->cond, NULL);
+
+    fd = open(odStor->filename, O_RDWR | O_CREAT, 0644);
+    if(fd < 0) {
+        return CO_ERROR_DATA_CORRUPT;
     }
-    else {
-        void *buf = NULL;
-        bool_t saveData = false;
 
-        /* allocate buffer and open file if necessary */
-        if(ret == CO_ERROR_NO) {
-            buf = malloc(odStor->odSize);
-            if(odStor->fp == NULL) {
-                odStor->fp = fopen(odStor->filename, "r+");
-            }
-            if(buf == NULL || odStor->fp == NULL) {
-                ret = CO_ERROR_OUT_OF_MEMORY;
-            }
+    /* new file or file from different Object dictionary, start empty */
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    if(st.st_size != (off_t)odStor->mapSize) {
+        if(st.st_size != 0) {
+            ret = CO_ERROR_DATA_CORRUPT;
         }
+        if(ftruncate(fd, 0) != 0 || ftruncate(fd, odStor->mapSize) != 0) {
+            close(fd);
+            return CO_ERROR_DATA_CORRUPT;
+        }
+    }
 
-        /* read data from the beginning of the file */
-        if(ret == CO_ERROR_NO) {
-            uint32_t cnt = 0;
-
-            rewind(odStor->fp);
-            cnt = fread(buf, 1, odStor->odSize, odStor->fp);
-
-            if(cnt == 2 && *((char*)buf) == '-') {
-                /* file is empty, data will be saved. */
-                saveData = true;
+    map = mmap(NULL, odStor->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    odStor->map = (uint8_t*)map;
+
+    /* load newer valid slot into Object dictionary */
+    {
+        bool_t crcError = false;
+        uint32_t seq0 = CO_OD_storage_slotSequence(odStor, 0, &crcError);
+        uint32_t seq1 = CO_OD_storage_slotSequence(odStor, 1, &crcError);
+
+        if(seq0 == 0U && seq1 == 0U) {
+            /* default values will be used */
+            if(crcError && ret == CO_ERROR_NO) {
+                ret = CO_ERROR_CRC;
             }
-            else if(cnt == odStor->odSize) {
-                /* verify, if data differs */
-                if(memcmp((const void *)buf, (const void *)odStor->odAddress, odStor->odSize) != 0) {
-                    saveData = true;
-                }
+            odStor->dirty = true;
+        }
+        else {
+            if(seq0 == 0U || (seq1 != 0U && (int32_t)(seq1 - seq0) > 0)) {
+                odStor->slot = 1;
+                odStor->sequence = seq1;
             }
             else {
-                /* file length does not match */
-                ret = CO_ERROR_DATA_CORRUPT;
+                odStor->slot = 0;
+                odStor->sequence = seq0;
             }
+            memcpy(odStor->odAddress,
+                   &odStor->map[odStor->slot * CO_OD_STORAGE_SLOT_SIZE(odSize)], odSize);
         }
+    }
 
-        /* Save the data to the file only if data differs. */
-        if(ret == CO_ERROR_NO && saveData) {
-            uint16_t CRC;
+    return ret;
+}
 
-            /* copy data to temporary buffer */
-            memcpy(buf, odStor->odAddress, odStor->odSize);
 
-            rewind(odStor->fp);
-            fwrite((const void *)buf, 1, odStor->odSize, odStor->fp);
+/*
+ * Write data with CRC to a temporary file and rename it to filename, so the
+ * file always contains either the old or the new data.
+ */
+static CO_ReturnError_t CO_OD_storage_writeAtomic(
+        const uint8_t          *data,
+        uint32_t                size,
+        const char             *filename)
+{
+    CO_ReturnError_t ret = CO_ERROR_NO;
+    char *filename_tmp;
+    FILE *fp;
+    uint16_t CRC;
+
+    filename_tmp = malloc(strlen(filename)+10);
+    if(filename_tmp == NULL) {
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+    strcpy(filename_tmp, filename);
+    strcat(filename_tmp, ".tmp");
+
+    fp = fopen(filename_tmp, "w");
+    if(fp == NULL) {
+        ret = CO_ERROR_DATA_CORRUPT;
+    }
+    else {
+        CRC = crc16_ccitt((const unsigned char*)data, size, 0);
+        if(fwrite((const void *)data, 1, size, fp) != size ||
+           fwrite((const void *)&CRC, 1, 2, fp) != 2 ||
+           fflush(fp) != 0 || fsync(fileno(fp)) != 0)
+        {
+            ret = CO_ERROR_DATA_CORRUPT;
+        }
+        if(fclose(fp) != 0) {
+            ret = CO_ERROR_DATA_CORRUPT;
+        }
+    }
+
+    if(ret == CO_ERROR_NO && rename(filename_tmp, filename) != 0) {
+        ret = CO_ERROR_DATA_CORRUPT;
+    }
+    if(ret != CO_ERROR_NO) {
+        remove(filename_tmp);
+    }
 
-            /* write also CRC */
-            CRC = crc16_ccitt((unsigned char*)buf, odStor->odSize, 0);
-            fwrite((const void *)&CRC, 1, 2, odStor->fp);
+    free(filename_tmp);
 
-            fflush(odStor->fp);
+    return ret;
+}
 
-            odStor->lastSavedMs = 0;
+
+/*
+ * Writer thread for CO_OD_storage_autoSave(). Holds mtx, except while waiting.
+ */
+static void* CO_OD_storage_thread(void *arg) {
+    CO_OD_storage_t *odStor = (CO_OD_storage_t*) arg;
+
+    pthread_mutex_lock(&odStor->mtx);
+    for(;;) {
+        while(!odStor->writePending && !odStor->threadTerminate) {
+            pthread_cond_wait(&odStor->cond, &odStor->mtx);
+        }
+        if(!odStor->writePending) {
+            break;
         }
 
-        free(buf);
+        odStor->writeResult = CO_OD_storage_writeAtomic(odStor->writeBuf,
+                odStor->odSize, odStor->filename);
+        odStor->writePending = false;
+    }
+    pthread_mutex_unlock(&odStor->mtx);
+
+    return NULL;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_OD_storage_autoSave(
+        CO_OD_storage_t        *odStor,
+        uint16_t                timer1ms,
+        uint16_t                delay)
+{
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    /* memory mapped file: slot is the copy of the data last saved */
+    if(odStor!=NULL && odStor->map!=NULL) {
+        if(odStor->lastSavedMs < delay) {
+            odStor->lastSavedMs += timer1ms - odStor->tmr1msPrev;
+        }
+        else {
+            const uint8_t *saved = &odStor->map[odStor->slot * CO_OD_STORAGE_SLOT_SIZE(odStor->odSize)];
+
+            CO_LOCK_OD();
+            if(memcmp((const void *)saved, (const void *)odStor->odAddress, odStor->odSize) != 0) {
+                odStor->dirty = true;
+            }
+            CO_UNLOCK_OD();
+
+            /* flush of dirty pages is only started, it doesn't block */
+            if(odStor->dirty && pthread_mutex_trylock(&odStor->mtx) == 0) {
+                ret = CO_OD_storage_saveMapped(odStor, MS_ASYNC);
+                odStor->dirty = (ret != CO_ERROR_NO) ? true : false;
+                odStor->lastSavedMs = 0;
+                pthread_mutex_unlock(&odStor->mtx);
+            }
+        }
+        odStor->tmr1msPrev = timer1ms;
+        return ret;
+    }
+
+    /* verify arguments */
+    if(odStor==NULL || odStor->odAddress==NULL || odStor->shadow==NULL || odStor->writeBuf==NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* start writer thread */
+    if(!odStor->threadRunning) {
+        if(pthread_create(&odStor->thread, NULL, CO_OD_storage_thread, odStor) != 0) {
+            return CO_ERROR_OUT_OF_MEMORY;
+        }
+        odStor->threadRunning = true;
+    }
+
+    /* don't save file more often than delay */
+    if(odStor->lastSavedMs < delay) {
+        odStor->lastSavedMs += timer1ms - odStor->tmr1msPrev;
+    }
+    else {
+        /* verify, if data differs from the data last saved */
+        CO_LOCK_OD();
+        if(memcmp((const void *)odStor->shadow, (const void *)odStor->odAddress, odStor->odSize) != 0) {
+            memcpy(odStor->shadow, odStor->odAddress, odStor->odSize);
+            odStor->dirty = true;
+        }
+        CO_UNLOCK_OD();
+
+        /* If writer thread is busy with the disk, try again next time. */
+        if(pthread_mutex_trylock(&odStor->mtx) == 0) {
+            if(odStor->writeResult != CO_ERROR_NO) {
+                /* repeat failed write */
+                ret = odStor->writeResult;
+                odStor->writeResult = CO_ERROR_NO;
+                odStor->dirty = true;
+            }
+            if(odStor->dirty && !odStor->writePending) {
+                memcpy(odStor->writeBuf, odStor->shadow, odStor->odSize);
+                odStor->writePending = true;
+                odStor->dirty = false;
+                odStor->lastSavedMs = 0;
+                pthread_cond_signal(&odStor->cond);
+            }
+            pthread_mutex_unlock(&odStor->mtx);
+        }
     }
 
     odStor->tmr1msPrev = timer1ms;
@@ -373,7 +660,21 @@ CO_ReturnError_t CO_OD_storage_autoSave(
 }
 
 void CO_OD_storage_autoSaveClose(CO_OD_storage_t *odStor) {
-    if(odStor->fp != NULL) {
-        fclose(odStor->fp);
+    if(odStor->threadRunning) {
+        pthread_mutex_lock(&odStor->mtx);
+        odStor->threadTerminate = true;
+        pthread_cond_signal(&odStor->cond);
+        pthread_mutex_unlock(&odStor->mtx);
+        pthread_join(odStor->thread, NULL);
+        odStor->threadRunning = false;
+    }
+    if(odStor->map != NULL) {
+        msync(odStor->map, odStor->mapSize, MS_SYNC);
+        munmap(odStor->map, odStor->mapSize);
+        odStor->map = NULL;
     }
+    free(odStor->shadow);
+    free(odStor->writeBuf);
+    odStor->shadow = NULL;
+    odStor->writeBuf = NULL;
 }
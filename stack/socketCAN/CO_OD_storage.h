@@ -93,10 +93,26 @@ typedef struct {
     uint8_t    *odAddress;      /**< From CO_OD_storage_init() */
     uint32_t    odSize;         /**< From CO_OD_storage_init() */
     char       *filename;       /**< From CO_OD_storage_init() */
-    /** If CO_OD_storage_autoSave() is used, file stays opened and fp is stored here. */
-    FILE       *fp;
     uint16_t    tmr1msPrev;     /**< used with CO_OD_storage_autoSave. */
     uint32_t    lastSavedMs;    /**< used with CO_OD_storage_autoSave. */
+    /** Copy of the data last passed to the writer thread, used with CO_OD_storage_autoSave. */
+    uint8_t    *shadow;
+    /** Data, which are written by the writer thread. Protected by mtx. */
+    uint8_t    *writeBuf;
+    bool_t      dirty;          /**< shadow differs from file */
+    /** Writer thread, started by CO_OD_storage_autoSave(). It holds mtx while writing. */
+    pthread_t   thread;
+    pthread_mutex_t mtx;        /**< Protects the following variables and file access */
+    pthread_cond_t cond;        /**< Signals writePending or threadTerminate */
+    bool_t      threadRunning;  /**< Writer thread was created */
+    bool_t      threadTerminate;/**< Request writer thread to exit */
+    bool_t      writePending;   /**< writeBuf contains data to be written */
+    CO_ReturnError_t writeResult;/**< Result of the last write by the writer thread */
+    /** Memory mapped file, if initialized by CO_OD_storage_initMapped(), else NULL. */
+    uint8_t    *map;
+    uint32_t    mapSize;        /**< Size of the mapped file, two slots */
+    uint8_t     slot;           /**< Slot with the data last saved, 0 or 1 */
+    uint32_t    sequence;       /**< Sequence number of the data last saved, 0 if none */
 } CO_OD_storage_t;
 
 
@@ -104,7 +120,8 @@ typedef struct {
  * Initialize OD storage object and load data from file.
  *
  * Called after program startup. Load storage file and copy data to Object
- * Dictionary variables.
+ * Dictionary variables. Buffers for CO_OD_storage_autoSave() are allocated
+ * here and stay allocated until CO_OD_storage_autoSaveClose().
  *
  * @param odStor This object will be initialized.
  * @param odAddress Address of the memory block from Object dictionary, where data will be copied.
@@ -122,19 +139,56 @@ CO_ReturnError_t CO_OD_storage_init(
         char                   *filename);
 
 
+/**
+ * Initialize OD storage object with memory mapped file and load data from it.
+ *
+ * Alternative to CO_OD_storage_init(). File is mapped into memory and
+ * contains two slots, each with a copy of the memory block, a sequence number
+ * and two bytes of CRC. Store writes the older slot and flushes it with
+ * msync(), so the file always contains the data saved before, if the store is
+ * interrupted. Slot with valid CRC and higher sequence number is loaded.
+ *
+ * Mapped slot is also the copy of the data last saved, so no buffers are
+ * allocated and no writer thread is used. CO_OD_storage_autoSave() copies
+ * changed data into the mapping and starts an asynchronous flush of the dirty
+ * pages, object 1010 flushes synchronously. File format differs from the one
+ * of CO_OD_storage_init(). Missing file or file of a different size is
+ * created new.
+ *
+ * @param odStor This object will be initialized.
+ * @param odAddress Address of the memory block from Object dictionary, where data will be copied.
+ * @param odSize Size of the above memory block.
+ * @param filename Name of the file, where data are stored.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_DATA_CORRUPT (file size did
+ * not match or file can't be mapped), CO_ERROR_CRC (no slot with valid CRC) or
+ * CO_ERROR_ILLEGAL_ARGUMENT. Default values are used on error.
+ */
+CO_ReturnError_t CO_OD_storage_initMapped(
+        CO_OD_storage_t        *odStor,
+        uint8_t                *odAddress,
+        uint32_t                odSize,
+        char                   *filename);
+
+
 /**
  * Automatically save memory block if differs from file.
  *
- * Should be called cyclically by program. It first verifies, if memory block
- * differs from file and if it does, it saves it to file with two additional
- * CRC bytes. File remains opened.
+ * Should be called cyclically by program. It verifies, if memory block differs
+ * from the data last saved (a copy is kept in RAM). If it does, copy of the
+ * data is passed to a writer thread, which saves it with two additional CRC
+ * bytes to a temporary file and renames it to the file. Function itself
+ * doesn't access the disk and doesn't block on it. The writer thread is
+ * started with the first call. See CO_OD_storage_initMapped() for the memory
+ * mapped file.
  *
  * @param odStor OD storage object.
  * @param timer1ms Variable, which must increment each millisecond.
  * @param delay Delay (inhibit) time between writes to disk in milliseconds (60000 for example).
  *
- * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_DATA_CORRUPT (Data in file corrupt),
- * CO_ERROR_ILLEGAL_ARGUMENT or CO_ERROR_OUT_OF_MEMORY (malloc failed).
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_DATA_CORRUPT (previous write
+ * to file failed, will be repeated), CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_OUT_OF_MEMORY (thread creation failed).
  */
 CO_ReturnError_t CO_OD_storage_autoSave(
         CO_OD_storage_t        *odStor,
@@ -143,7 +197,9 @@ CO_ReturnError_t CO_OD_storage_autoSave(
 
 
 /**
- * Closes file opened by CO_OD_storage_autoSave.
+ * Stops the writer thread of CO_OD_storage_autoSave and frees buffers.
+ *
+ * Pending write is finished before. Memory mapped file is flushed and unmapped.
  *
  * @param odStor OD storage object.
  */
@@ -0,0 +1,235 @@
+/*
+ * Shared memory view of the Object Dictionary for Linux SocketCAN.
+ *
+ * @file        CO_ODshm.c
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_ODshm.h"
+
+#include <string.h>     /* for memcpy */
+#include <fcntl.h>      /* for O_* constants */
+#include <sched.h>      /* for sched_yield */
+#include <sys/mman.h>   /* for shm_open, mmap */
+#include <sys/stat.h>   /* for fstat */
+
+#ifdef CO_SINGLE_THREAD
+    #error CO_ODshm needs CO_LOCK_OD(), it can not be used with CO_SINGLE_THREAD.
+#endif
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_ODshm_create(
+        CO_ODshm_t             *shm,
+        const char             *name,
+        const uint32_t          sectionSize[],
+        uint8_t                 sectionCount)
+{
+    CO_ODshm_header_t *header;
+    uint32_t size;
+    uint8_t i;
+    void *map;
+    int fd;
+
+    /* verify arguments */
+    if(shm==NULL || name==NULL || sectionSize==NULL ||
+       sectionCount==0 || sectionCount>CO_ODSHM_MAX_SECTIONS) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    shm->header = NULL;
+    shm->size = 0;
+    shm->name = name;
+    shm->owner = false;
+
+    size = (sizeof(CO_ODshm_header_t) + 7U) & ~7U;
+    for(i=0; i<sectionCount; i++) {
+        size += (sectionSize[i] + 7U) & ~7U;
+    }
+
+    /* new zeroed segment */
+    shm_unlink(name);
+    fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(fd < 0) {
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+    if(ftruncate(fd, size) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+    map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) {
+        shm_unlink(name);
+        return CO_ERROR_OUT_OF_MEMORY;
+    }
+
+    header = (CO_ODshm_header_t*)map;
+    header->size = size;
+    header->sequence = 0;
+    header->sectionCount = sectionCount;
+    size = (sizeof(CO_ODshm_header_t) + 7U) & ~7U;
+    for(i=0; i<sectionCount; i++) {
+        header->section[i].offset = size;
+        header->section[i].size = sectionSize[i];
+        size += (sectionSize[i] + 7U) & ~7U;
+    }
+    /* readers verify magic last */
+    __sync_synchronize();
+    header->magic = CO_ODSHM_MAGIC;
+
+    shm->header = header;
+    shm->size = size;
+    shm->owner = true;
+
+    /* not with CO_LOCK_OD(), it would change the counter */
+    pthread_mutex_lock(&CO_OD_mtx);
+    CO_OD_sequence = &header->sequence;
+    pthread_mutex_unlock(&CO_OD_mtx);
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void *CO_ODshm_getSection(CO_ODshm_t *shm, uint8_t section) {
+    if(shm==NULL || shm->header==NULL || section>=shm->header->sectionCount) {
+        return NULL;
+    }
+    return (uint8_t*)shm->header + shm->header->section[section].offset;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_ODshm_open(CO_ODshm_t *shm, const char *name) {
+    CO_ODshm_header_t *header;
+    struct stat st;
+    void *map;
+    int fd;
+    uint32_t i;
+
+    /* verify arguments */
+    if(shm==NULL || name==NULL) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    shm->header = NULL;
+    shm->size = 0;
+    shm->name = name;
+    shm->owner = false;
+
+    fd = shm_open(name, O_RDONLY, 0);
+    if(fd < 0) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(CO_ODshm_header_t)) {
+        close(fd);
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+
+    /* verify layout, so CO_ODshm_read() stays inside the segment */
+    header = (CO_ODshm_header_t*)map;
+    if(header->magic != CO_ODSHM_MAGIC || header->size != (uint32_t)st.st_size ||
+       header->sectionCount == 0 || header->sectionCount > CO_ODSHM_MAX_SECTIONS) {
+        munmap(map, st.st_size);
+        return CO_ERROR_DATA_CORRUPT;
+    }
+    __sync_synchronize();
+    for(i=0; i<header->sectionCount; i++) {
+        if(header->section[i].offset > header->size ||
+           header->section[i].size > header->size - header->section[i].offset) {
+            munmap(map, st.st_size);
+            return CO_ERROR_DATA_CORRUPT;
+        }
+    }
+
+    shm->header = header;
+    shm->size = (uint32_t)st.st_size;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_ODshm_read(
+        const CO_ODshm_t       *shm,
+        uint8_t                 section,
+        uint32_t                offset,
+        void                   *data,
+        uint32_t                size)
+{
+    const CO_ODshm_header_t *header;
+    const uint8_t *src;
+    uint32_t retry;
+
+    /* verify arguments */
+    if(shm==NULL || shm->header==NULL || data==NULL ||
+       section>=shm->header->sectionCount) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    header = shm->header;
+    if(offset > header->section[section].size ||
+       size > header->section[section].size - offset) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    src = (const uint8_t*)header + header->section[section].offset + offset;
+
+    for(retry=0; retry<CO_ODSHM_READ_RETRIES; retry++) {
+        uint32_t seq = header->sequence;
+
+        if((seq & 1U) == 0U) {
+            __sync_synchronize();
+            memcpy(data, src, size);
+            __sync_synchronize();
+            if(header->sequence == seq) {
+                return CO_ERROR_NO;
+            }
+        }
+        /* let the CANopen process finish, if it runs on the same CPU */
+        sched_yield();
+    }
+
+    return CO_ERROR_TIMEOUT;
+}
+
+
+/******************************************************************************/
+void CO_ODshm_close(CO_ODshm_t *shm) {
+    if(shm==NULL || shm->header==NULL) {
+        return;
+    }
+    if(shm->owner) {
+        pthread_mutex_lock(&CO_OD_mtx);
+        if(CO_OD_sequence == &shm->header->sequence) {
+            CO_OD_sequence = NULL;
+        }
+        pthread_mutex_unlock(&CO_OD_mtx);
+        shm_unlink(shm->name);
+    }
+    munmap((void*)shm->header, shm->size);
+    shm->header = NULL;
+    shm->size = 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * Shared memory view of the Object Dictionary for Linux SocketCAN.
+ *
+ * @file        CO_ODshm.h
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_ODSHM_H
+#define CO_ODSHM_H
+
+
+#include "CO_driver.h"
+
+
+/**
+ * Shared memory view of the Object Dictionary.
+ *
+ * RAM sections of the Object dictionary of a CANopen instance are placed in a
+ * POSIX shared memory segment, so other processes on the same machine (HMI,
+ * logging) read process data directly, without SDO or IPC to the CANopen
+ * process.
+ *
+ * CANopen process creates the segment and moves the variables into it:
+ *
+ *     uint32_t sizes[2] = {sizeof(struct sCO_OD_RAM), sizeof(struct sCO_OD_EEPROM)};
+ *
+ *     CO_newInstance(&CO);
+ *     CO_ODshm_create(&shm, "/canopen", sizes, 2);
+ *     CO_setODmemory(CO, CO_ODshm_getSection(&shm, 0), CO_ODshm_getSection(&shm, 1));
+ *
+ * Other process, built with the same CO_OD.h, opens the segment and reads
+ * with CO_ODshm_read(), for example at offsetof(struct sCO_OD_RAM, ...).
+ *
+ * Consistency is provided by a sequence counter (seqlock) in the segment. It
+ * is incremented by CO_LOCK_OD() and CO_UNLOCK_OD(), so it is odd, while the
+ * Object dictionary is locked. Reader copies the data and repeats, if the
+ * counter was odd or has changed. Readers never block the CANopen process.
+ * SDO server and PDO processing in the RT thread access the Object dictionary
+ * with the lock. Application must also write variables, which are read as
+ * a group, with the lock. One counter is used for all sections, because all
+ * of them are written under the same lock.
+ *
+ * Not available with CO_SINGLE_THREAD.
+ */
+
+
+/** Value of CO_ODshm_header_t::magic */
+#define CO_ODSHM_MAGIC              0x4D48534FUL
+
+/** Maximum number of sections in the segment. */
+#ifndef CO_ODSHM_MAX_SECTIONS
+    #define CO_ODSHM_MAX_SECTIONS   4U
+#endif
+
+/** Number of attempts of CO_ODshm_read() to get consistent data. */
+#ifndef CO_ODSHM_READ_RETRIES
+    #define CO_ODSHM_READ_RETRIES   1000U
+#endif
+
+
+/**
+ * Header at the start of the shared memory segment.
+ */
+typedef struct {
+    uint32_t            magic;      /**< CO_ODSHM_MAGIC */
+    uint32_t            size;       /**< Size of the segment in bytes */
+    volatile uint32_t   sequence;   /**< Sequence counter, odd while Object dictionary is locked */
+    uint32_t            sectionCount;/**< Number of sections */
+    /** Offset from the start of the segment and size of each section */
+    struct {
+        uint32_t        offset;
+        uint32_t        size;
+    } section[CO_ODSHM_MAX_SECTIONS];
+} CO_ODshm_header_t;
+
+
+/**
+ * Shared memory view object, used by the CANopen process and by readers.
+ */
+typedef struct {
+    CO_ODshm_header_t  *header;     /**< Mapped segment or NULL */
+    uint32_t            size;       /**< Size of the mapped segment */
+    const char         *name;       /**< From CO_ODshm_create() or CO_ODshm_open() */
+    bool_t              owner;      /**< True, if created by this process */
+} CO_ODshm_t;
+
+
+/**
+ * Create shared memory segment in the CANopen process.
+ *
+ * Existing segment with the same name is replaced. Sections are zeroed and
+ * 8 byte aligned. Sequence counter is connected to CO_LOCK_OD().
+ *
+ * @param shm This object will be initialized.
+ * @param name Name of the segment for shm_open(), for example "/canopen".
+ * @param sectionSize Size of each section.
+ * @param sectionCount Number of sections, 1 to #CO_ODSHM_MAX_SECTIONS.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_OUT_OF_MEMORY (segment can't be created).
+ */
+CO_ReturnError_t CO_ODshm_create(
+        CO_ODshm_t             *shm,
+        const char             *name,
+        const uint32_t          sectionSize[],
+        uint8_t                 sectionCount);
+
+
+/**
+ * Get memory of a section, see CO_setODmemory().
+ *
+ * @param shm This object.
+ * @param section Index of the section.
+ *
+ * @return Pointer to the section or NULL.
+ */
+void *CO_ODshm_getSection(CO_ODshm_t *shm, uint8_t section);
+
+
+/**
+ * Open existing shared memory segment in a reader process.
+ *
+ * Segment is mapped read only.
+ *
+ * @param shm This object will be initialized.
+ * @param name Name of the segment, same as by CO_ODshm_create().
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT (segment
+ * does not exist) or CO_ERROR_DATA_CORRUPT (not a valid segment).
+ */
+CO_ReturnError_t CO_ODshm_open(CO_ODshm_t *shm, const char *name);
+
+
+/**
+ * Read consistent data from a section.
+ *
+ * Function does not block, it repeats the copy, while the Object dictionary
+ * is locked or was locked during the copy.
+ *
+ * @param shm This object.
+ * @param section Index of the section.
+ * @param offset Offset of the data in the section.
+ * @param [out] data Buffer for the data.
+ * @param size Number of bytes to read.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT or
+ * CO_ERROR_TIMEOUT (no consistent copy after #CO_ODSHM_READ_RETRIES
+ * attempts).
+ */
+CO_ReturnError_t CO_ODshm_read(
+        const CO_ODshm_t       *shm,
+        uint8_t                 section,
+        uint32_t                offset,
+        void                   *data,
+        uint32_t                size);
+
+
+/**
+ * Unmap the segment. If created by this process, it is also removed and
+ * disconnected from CO_LOCK_OD(). Object dictionary must not be used in
+ * the segment any more, see CO_deleteInstance().
+ *
+ * @param shm This object.
+ */
+void CO_ODshm_close(CO_ODshm_t *shm);
+
+#endif
@@ -26,6 +26,9 @@
 
 #include "CO_driver.h"
 #include "CO_Emergency.h"
+#include "CO_CANfilter.h"
+#include "CO_tracepoint.h"
+#include "CO_statistics.h"
 #include <string.h> /* for memcpy */
 #include <stdlib.h> /* for malloc, free */
 #include <errno.h>
@@ -36,6 +39,7 @@
 #ifndef CO_SINGLE_THREAD
     pthread_mutex_t CO_EMCY_mtx = PTHREAD_MUTEX_INITIALIZER;
     pthread_mutex_t CO_OD_mtx = PTHREAD_MUTEX_INITIALIZER;
+    volatile uint32_t *CO_OD_sequence = NULL;
 #endif
 
 
@@ -45,11 +49,11 @@ static CO_ReturnError_t setFilters(CO_CANmodule_t *CANmodule){
 
     if(CANmodule->useCANrxFilters){
         int nFiltersIn, nFiltersOut;
-        struct can_filter *filtersOut;
+        CO_CANfilter_t *filtersOut; /* binary compatible to struct can_filter */
 
         nFiltersIn = CANmodule->rxSize;
         nFiltersOut = 0;
-        filtersOut = (struct can_filter *) calloc(nFiltersIn, sizeof(struct can_filter));
+        filtersOut = (CO_CANfilter_t *) calloc(nFiltersIn, sizeof(CO_CANfilter_t));
 
         if(filtersOut == NULL){
             ret = CO_ERROR_OUT_OF_MEMORY;
@@ -67,16 +71,19 @@ static CO_ReturnError_t setFilters(CO_CANmodule_t *CANmodule){
                     idZeroCnt++;
                 }
                 if(fin->can_id != 0 || idZeroCnt == 1){
-                    struct can_filter *fout;
+                    CO_CANfilter_t *fout;
 
                     fout = &filtersOut[nFiltersOut++];
-                    fout->can_id = fin->can_id;
-                    fout->can_mask = fin->can_mask;
+                    fout->ident = fin->can_id;
+                    fout->mask = fin->can_mask;
                 }
             }
 
+            /* Remove duplicate and covered filters. */
+            nFiltersOut = CO_CANfilter_merge(filtersOut, nFiltersOut, nFiltersOut);
+
             if(setsockopt(CANmodule->fd, SOL_CAN_RAW, CAN_RAW_FILTER,
-                          filtersOut, sizeof(struct can_filter) * nFiltersOut) != 0)
+                          filtersOut, sizeof(CO_CANfilter_t) * nFiltersOut) != 0)
             {
                 ret = CO_ERROR_ILLEGAL_ARGUMENT;
             }
@@ -317,6 +324,10 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
         CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, n);
         err = CO_ERROR_TX_OVERFLOW;
     }
+    else{
+        CO_STAT_TX(CANmodule, buffer - CANmodule->txArray);
+        CO_STAT_BUS(CANmodule, buffer->DLC);
+    }
 
     return err;
 }
@@ -419,6 +430,7 @@ void CO_CANrxWait(CO_CANmodule_t *CANmodule){
 
             rcvMsg = (CO_CANrxMsg_t *) &msg;
             rcvMsgIdent = rcvMsg->ident;
+            CO_STAT_BUS(CANmodule, rcvMsg->DLC);
 
             /* Search rxArray form CANmodule for the matching CAN-ID. */
             buffer = &CANmodule->rxArray[0];
@@ -432,7 +444,10 @@ void CO_CANrxWait(CO_CANmodule_t *CANmodule){
 
             /* Call specific function, which will process the message */
             if(msgMatched && (buffer->pFunct != NULL)){
+                CO_TP_BEGIN(CO_TP_RX_CALLBACK, buffer - CANmodule->rxArray);
+                CO_STAT_RX(CANmodule, buffer - CANmodule->rxArray);
                 buffer->pFunct(buffer->object, rcvMsg);
+                CO_TP_END(CO_TP_RX_CALLBACK, buffer - CANmodule->rxArray);
             }
 
 #ifdef CO_LOG_CAN_MESSAGES
@@ -71,13 +71,22 @@
     #define CO_LOCK_EMCY()          {if(pthread_mutex_lock(&CO_EMCY_mtx) != 0) CO_errExit("Mutex lock CO_EMCY_mtx failed");}
     #define CO_UNLOCK_EMCY()        {if(pthread_mutex_unlock(&CO_EMCY_mtx) != 0) CO_errExit("Mutex unlock CO_EMCY_mtx failed");}
 
+    /* Sequence counter of the shared memory OD view (see CO_ODshm.h) or NULL.
+     * It is odd while CO_OD_mtx is locked. */
+    extern volatile uint32_t *CO_OD_sequence;
     extern pthread_mutex_t CO_OD_mtx;
-    #define CO_LOCK_OD()            {if(pthread_mutex_lock(&CO_OD_mtx) != 0) CO_errExit("Mutex lock CO_OD_mtx failed");}
-    #define CO_UNLOCK_OD()          {if(pthread_mutex_unlock(&CO_OD_mtx) != 0) CO_errExit("Mutex unlock CO_OD_mtx failed");}
+    #define CO_LOCK_OD()            {if(pthread_mutex_lock(&CO_OD_mtx) != 0) CO_errExit("Mutex lock CO_OD_mtx failed"); \
+                                     if(CO_OD_sequence != NULL) {(*CO_OD_sequence)++; __sync_synchronize();}}
+    #define CO_UNLOCK_OD()          {if(CO_OD_sequence != NULL) {__sync_synchronize(); (*CO_OD_sequence)++;} \
+                                     if(pthread_mutex_unlock(&CO_OD_mtx) != 0) CO_errExit("Mutex unlock CO_OD_mtx failed");}
 
     #define CANrxMemoryBarrier()    {__sync_synchronize();}
 #endif
 
+/* receive runs in a thread */
+#define CO_LOCK_OD_RX()             CO_LOCK_OD()
+#define CO_UNLOCK_OD_RX()           CO_UNLOCK_OD()
+
 /* Syncronisation functions */
 #define IS_CANrxNew(rxNew) ((int)rxNew)
 #define SET_CANrxNew(rxNew) {CANrxMemoryBarrier(); rxNew = (void*)1L;}
@@ -0,0 +1,808 @@
+/*
+ * CiA 309-3 ASCII gateway over TCP for Linux.
+ *
+ * @file        CO_gateway.c
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     /* for accept4() */
+#endif
+
+#include "CO_gateway.h"
+
+#include <stdio.h>      /* for snprintf */
+#include <stdarg.h>     /* for va_list */
+#include <stdlib.h>     /* for strtoull */
+#include <string.h>     /* for memchr, memmove */
+#include <strings.h>    /* for strcasecmp */
+#include <errno.h>
+#include <unistd.h>     /* for close */
+#include <netinet/in.h> /* for sockaddr_in */
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+#if CO_NO_SDO_CLIENT == 0
+    #error CO_gateway needs SDO client objects, CO_NO_SDO_CLIENT must be > 0.
+#endif
+
+
+/* Kind of datatypes, value of CO_gatewayRequest_t::dataType is the index
+ * into CO_gateway_dataTypes. */
+#define CO_GW_BOOL      0U
+#define CO_GW_INT       1U
+#define CO_GW_UINT      2U
+#define CO_GW_HEX       3U
+#define CO_GW_REAL      4U
+#define CO_GW_STRING    5U
+
+static const struct {
+    const char *name;
+    uint8_t     kind;
+    uint8_t     size;   /* 0 for variable length */
+} CO_gateway_dataTypes[] = {
+    {"b",   CO_GW_BOOL,   1}, {"vs",  CO_GW_STRING, 0},
+    {"i8",  CO_GW_INT,    1}, {"i16", CO_GW_INT,    2},
+    {"i32", CO_GW_INT,    4}, {"i64", CO_GW_INT,    8},
+    {"u8",  CO_GW_UINT,   1}, {"u16", CO_GW_UINT,   2},
+    {"u32", CO_GW_UINT,   4}, {"u64", CO_GW_UINT,   8},
+    {"x8",  CO_GW_HEX,    1}, {"x16", CO_GW_HEX,    2},
+    {"x32", CO_GW_HEX,    4}, {"x64", CO_GW_HEX,    8},
+    {"r32", CO_GW_REAL,   4}, {"r64", CO_GW_REAL,   8}
+};
+
+#define CO_GW_DATATYPE_COUNT (sizeof(CO_gateway_dataTypes) / sizeof(CO_gateway_dataTypes[0]))
+
+
+/*
+ * Update events of the connection in epoll: reading unless suspended,
+ * writing while responses are pending.
+ */
+static void CO_gateway_epoll(CO_gateway_t *gw, uint16_t i){
+    CO_gatewayConn_t *conn = &gw->conn[i];
+    struct epoll_event ev;
+    uint32_t events;
+
+    if(gw->fdEpoll < 0 || conn->fd < 0){
+        return;
+    }
+    events = (conn->suspended ? 0U : (uint32_t)EPOLLIN) |
+             (conn->txLength != 0U ? (uint32_t)EPOLLOUT : 0U);
+    if(events != conn->events){
+        ev.events = events;
+        ev.data.fd = conn->fd;
+        (void)epoll_ctl(gw->fdEpoll, EPOLL_CTL_MOD, conn->fd, &ev);
+        conn->events = events;
+    }
+}
+
+
+/*
+ * Close the connection. Its requests in progress stay in the CO_SDOqueue,
+ * their responses are discarded.
+ */
+static void CO_gateway_closeConn(CO_gateway_t *gw, uint16_t i){
+    CO_gatewayConn_t *conn = &gw->conn[i];
+    uint16_t j;
+
+    if(conn->fd < 0){
+        return;
+    }
+    if(gw->fdEpoll >= 0){
+        (void)epoll_ctl(gw->fdEpoll, EPOLL_CTL_DEL, conn->fd, NULL);
+    }
+    close(conn->fd);
+    conn->fd = -1;
+
+    for(j=0; j<CO_GATEWAY_MAX_REQUESTS; j++){
+        if(gw->request[j].conn == (int16_t)i){
+            gw->request[j].conn = -1;
+        }
+    }
+}
+
+
+/*
+ * Send pending responses, as much as the socket accepts.
+ */
+static void CO_gateway_flush(CO_gateway_t *gw, uint16_t i){
+    CO_gatewayConn_t *conn = &gw->conn[i];
+    ssize_t n;
+
+    if(conn->fd < 0 || conn->txLength == 0U){
+        return;
+    }
+    n = send(conn->fd, conn->tx, conn->txLength, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if(n > 0){
+        conn->txLength -= (uint16_t)n;
+        memmove(conn->tx, &conn->tx[n], conn->txLength);
+    }
+    else if(n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+        CO_gateway_closeConn(gw, i);
+    }
+}
+
+
+/*
+ * Append response line to the transmit buffer of the connection. If client
+ * does not read its responses and the buffer is full, connection is closed.
+ */
+static void CO_gateway_respond(
+        CO_gateway_t           *gw,
+        int16_t                 i,
+        uint32_t                sequence,
+        const char             *format,
+        ...)
+{
+    CO_gatewayConn_t *conn;
+    char line[CO_GATEWAY_DATA_SIZE + 48U];
+    va_list args;
+    int len, n;
+
+    if(i < 0 || gw->conn[i].fd < 0){
+        return;
+    }
+    conn = &gw->conn[i];
+
+    len = snprintf(line, sizeof(line), "[%lu] ", (unsigned long)sequence);
+    va_start(args, format);
+    n = vsnprintf(&line[len], sizeof(line) - (size_t)len - 2U, format, args);
+    va_end(args);
+    if(n < 0){
+        return;
+    }
+    len += n;
+    if(len > (int)sizeof(line) - 3){
+        len = (int)sizeof(line) - 3;
+    }
+    line[len++] = '\r';
+    line[len++] = '\n';
+
+    if(conn->txLength + (uint32_t)len > CO_GATEWAY_TX_SIZE){
+        CO_gateway_flush(gw, (uint16_t)i);
+        if(conn->fd < 0 || conn->txLength + (uint32_t)len > CO_GATEWAY_TX_SIZE){
+            CO_gateway_closeConn(gw, (uint16_t)i);
+            return;
+        }
+    }
+    memcpy(&conn->tx[conn->txLength], line, (size_t)len);
+    conn->txLength += (uint16_t)len;
+}
+
+
+/*
+ * Respond with the result of the transfer. Callback of the CO_SDOqueueJob_t.
+ */
+static void CO_gateway_jobDone(
+        CO_SDOqueueJob_t       *job,
+        CO_SDOclient_return_t   ret,
+        uint32_t                abortCode,
+        uint32_t                dataSize)
+{
+    CO_gateway_t *gw = (CO_gateway_t*)job->object;
+    CO_gatewayRequest_t *req = (CO_gatewayRequest_t*)job;
+    uint8_t kind = CO_gateway_dataTypes[req->dataType].kind;
+    uint8_t size = CO_gateway_dataTypes[req->dataType].size;
+    uint64_t value = 0;
+    uint32_t i;
+
+    req->used = false;
+
+    if(ret != CO_SDOcli_ok_communicationEnd){
+        if(abortCode != 0U){
+            CO_gateway_respond(gw, req->conn, req->sequence, "ERROR: 0x%08lX", (unsigned long)abortCode);
+        }
+        else{
+            CO_gateway_respond(gw, req->conn, req->sequence, "ERROR: %d",
+                    ret == CO_SDOcli_endedWithTimeout ? CO_GATEWAY_ERR_TIMEOUT : CO_GATEWAY_ERR_STATE);
+        }
+        return;
+    }
+    if(job->download){
+        CO_gateway_respond(gw, req->conn, req->sequence, "OK");
+        return;
+    }
+
+    /* format uploaded value, CANopen is little endian */
+    if(kind == CO_GW_STRING){
+        req->data[dataSize < CO_GATEWAY_DATA_SIZE ? dataSize : CO_GATEWAY_DATA_SIZE - 1U] = 0;
+        CO_gateway_respond(gw, req->conn, req->sequence, "%s", (char*)req->data);
+        return;
+    }
+    if(dataSize > size){
+        dataSize = size;
+    }
+    for(i=0; i<dataSize; i++){
+        value |= (uint64_t)req->data[i] << (8U * i);
+    }
+    switch(kind){
+        case CO_GW_INT:
+            if(size < 8U && (value & (1ULL << (8U * size - 1U))) != 0U){
+                value |= ~0ULL << (8U * size);
+            }
+            CO_gateway_respond(gw, req->conn, req->sequence, "%lld", (long long)value);
+            break;
+        case CO_GW_HEX:
+            CO_gateway_respond(gw, req->conn, req->sequence, "0x%0*llX", 2 * size, (unsigned long long)value);
+            break;
+        case CO_GW_REAL:
+            if(size == 4U){
+                float f;
+                uint32_t v32 = (uint32_t)value;
+                memcpy(&f, &v32, sizeof(f));
+                CO_gateway_respond(gw, req->conn, req->sequence, "%.9g", (double)f);
+            }
+            else{
+                double d;
+                memcpy(&d, &value, sizeof(d));
+                CO_gateway_respond(gw, req->conn, req->sequence, "%.17g", d);
+            }
+            break;
+        default:
+            CO_gateway_respond(gw, req->conn, req->sequence, "%llu", (unsigned long long)value);
+            break;
+    }
+}
+
+
+/*
+ * Get next token of the line, separated by white space. Token is terminated
+ * in the line.
+ *
+ * @return Token or NULL at the end of the line.
+ */
+static char *CO_gateway_token(char **line){
+    char *token = *line;
+
+    while(*token == ' ' || *token == '\t'){
+        token++;
+    }
+    if(*token == 0){
+        *line = token;
+        return NULL;
+    }
+    *line = token;
+    while(**line != 0 && **line != ' ' && **line != '\t'){
+        (*line)++;
+    }
+    if(**line != 0){
+        *(*line)++ = 0;
+    }
+    return token;
+}
+
+
+/*
+ * Convert number token.
+ *
+ * @return True, if token is a complete number not larger than max.
+ */
+static bool_t CO_gateway_number(const char *token, uint64_t max, uint64_t *value){
+    char *end;
+
+    if(token == NULL || *token < '0' || *token > '9'){
+        return false;
+    }
+    errno = 0;
+    *value = strtoull(token, &end, 0);
+    return errno == 0 && *end == 0 && *value <= max;
+}
+
+
+/*
+ * Convert value of write command into CANopen data.
+ *
+ * @return Size of data or 0, if value is not valid.
+ */
+static uint32_t CO_gateway_value(uint8_t dataType, char *value, uint8_t *data){
+    uint8_t kind = CO_gateway_dataTypes[dataType].kind;
+    uint8_t size = CO_gateway_dataTypes[dataType].size;
+    uint64_t v;
+    uint8_t i;
+    char *token;
+    char *end;
+
+    if(kind == CO_GW_STRING){
+        size_t len;
+
+        if(*value == '"'){
+            char *quote = strchr(++value, '"');
+            if(quote == NULL){
+                return 0;
+            }
+            *quote = 0;
+        }
+        len = strlen(value);
+        if(len == 0U || len >= CO_GATEWAY_DATA_SIZE){
+            return 0;
+        }
+        memcpy(data, value, len);
+        return (uint32_t)len;
+    }
+
+    token = CO_gateway_token(&value);
+    if(token == NULL || CO_gateway_token(&value) != NULL){
+        return 0;
+    }
+    value = token;
+    errno = 0;
+    if(kind == CO_GW_REAL){
+        if(size == 4U){
+            float f = strtof(value, &end);
+            uint32_t v32;
+            memcpy(&v32, &f, sizeof(v32));
+            v = v32;
+        }
+        else{
+            double d = strtod(value, &end);
+            memcpy(&v, &d, sizeof(v));
+        }
+    }
+    else if(kind == CO_GW_INT){
+        int64_t s = strtoll(value, &end, 0);
+        if(size < 8U && (s < -(1LL << (8U * size - 1U)) || s >= (1LL << (8U * size - 1U)))){
+            return 0;
+        }
+        v = (uint64_t)s;
+    }
+    else{
+        if(*value == '-'){
+            return 0;
+        }
+        v = strtoull(value, &end, 0);
+        if((size < 8U && v >= (1ULL << (8U * size))) || (kind == CO_GW_BOOL && v > 1U)){
+            return 0;
+        }
+    }
+    if(errno != 0 || end == value || *end != 0){
+        return 0;
+    }
+
+    for(i=0; i<size; i++){
+        data[i] = (uint8_t)(v >> (8U * i));
+    }
+    return size;
+}
+
+
+/*
+ * Execute one request line of the connection.
+ */
+static void CO_gateway_command(CO_gateway_t *gw, uint16_t connIdx, char *line){
+    CO_gatewayConn_t *conn = &gw->conn[connIdx];
+    CO_gatewayRequest_t *req = NULL;
+    uint64_t number[2];
+    uint8_t numberCount = 0;
+    uint32_t sequence;
+    uint64_t node;
+    uint64_t index, subIndex;
+    uint8_t dataType;
+    char *token;
+    uint16_t i;
+    int error = CO_GATEWAY_ERR_SYNTAX;
+
+    /* sequence number */
+    token = CO_gateway_token(&line);
+    if(token == NULL){
+        return; /* empty line */
+    }
+    if(token[0] != '[' || token[strlen(token) - 1U] != ']'){
+        CO_gateway_respond(gw, (int16_t)connIdx, 0, "ERROR: %d", CO_GATEWAY_ERR_SYNTAX);
+        return;
+    }
+    token[strlen(token) - 1U] = 0;
+    if(!CO_gateway_number(&token[1], 0xFFFFFFFFUL, &number[0])){
+        CO_gateway_respond(gw, (int16_t)connIdx, 0, "ERROR: %d", CO_GATEWAY_ERR_SYNTAX);
+        return;
+    }
+    sequence = (uint32_t)number[0];
+
+    /* optional net and node */
+    token = CO_gateway_token(&line);
+    while(numberCount < 2U && CO_gateway_number(token, 0xFFFFFFFFUL, &number[numberCount])){
+        numberCount++;
+        token = CO_gateway_token(&line);
+    }
+    if(token == NULL){
+        CO_gateway_respond(gw, (int16_t)connIdx, sequence, "ERROR: %d", CO_GATEWAY_ERR_SYNTAX);
+        return;
+    }
+    if(numberCount == 2U && number[0] != 1U){
+        CO_gateway_respond(gw, (int16_t)connIdx, sequence, "ERROR: %d", CO_GATEWAY_ERR_NET);
+        return;
+    }
+    node = (numberCount != 0U) ? number[numberCount - 1U] : conn->node;
+
+    /* commands without node */
+    if(strcasecmp(token, "set") == 0){
+        uint64_t value;
+
+        if(numberCount == 2U){
+            error = CO_GATEWAY_ERR_SYNTAX;
+        }
+        else if(numberCount == 1U && number[0] != 1U){
+            error = CO_GATEWAY_ERR_NET;
+        }
+        else if((token = CO_gateway_token(&line)) == NULL ||
+                !CO_gateway_number(CO_gateway_token(&line), 0xFFFFU, &value) ||
+                CO_gateway_token(&line) != NULL)
+        {
+            error = CO_GATEWAY_ERR_SYNTAX;
+        }
+        else if(strcasecmp(token, "node") == 0){
+            error = (value >= 1U && value <= 127U) ? 0 : CO_GATEWAY_ERR_NODE;
+            if(error == 0){
+                conn->node = (uint8_t)value;
+            }
+        }
+        else if(strcasecmp(token, "sdo_timeout") == 0){
+            error = (value != 0U) ? 0 : CO_GATEWAY_ERR_SYNTAX;
+            if(error == 0){
+                gw->SDOqueue->SDOtimeoutTime = (uint16_t)value;
+            }
+        }
+        else{
+            error = CO_GATEWAY_ERR_REQUEST;
+        }
+    }
+
+    /* NMT commands, node 0 is all nodes */
+    else if(strcasecmp(token, "start") == 0 || strcasecmp(token, "stop") == 0 ||
+            strncasecmp(token, "preop", 5) == 0 || strcasecmp(token, "reset") == 0)
+    {
+        uint8_t command = 0;
+
+        if(strcasecmp(token, "start") == 0){
+            command = CO_NMT_ENTER_OPERATIONAL;
+        }
+        else if(strcasecmp(token, "stop") == 0){
+            command = CO_NMT_ENTER_STOPPED;
+        }
+        else if(strcasecmp(token, "preop") == 0 || strcasecmp(token, "preoperational") == 0){
+            command = CO_NMT_ENTER_PRE_OPERATIONAL;
+        }
+        else if(strcasecmp(token, "reset") == 0){
+            token = CO_gateway_token(&line);
+            if(token != NULL && strcasecmp(token, "node") == 0){
+                command = CO_NMT_RESET_NODE;
+            }
+            else if(token != NULL && (strcasecmp(token, "comm") == 0 ||
+                                      strcasecmp(token, "communication") == 0)){
+                command = CO_NMT_RESET_COMMUNICATION;
+            }
+        }
+        if(command == 0U || CO_gateway_token(&line) != NULL){
+            error = CO_GATEWAY_ERR_SYNTAX;
+        }
+        else if(numberCount == 0U && node == 0U){
+            error = CO_GATEWAY_ERR_NO_NODE;
+        }
+        else if(node > 127U){
+            error = CO_GATEWAY_ERR_NODE;
+        }
+        else{
+#if CO_NO_NMT_MASTER == 1
+            error = (CO_sendNMTcommand(gw->CO, command, (uint8_t)node) == CO_ERROR_NO) ?
+                    0 : CO_GATEWAY_ERR_STATE;
+#else
+            error = CO_GATEWAY_ERR_REQUEST;
+#endif
+        }
+    }
+
+    /* SDO commands */
+    else if(strcasecmp(token, "r") == 0 || strcasecmp(token, "read") == 0 ||
+            strcasecmp(token, "w") == 0 || strcasecmp(token, "write") == 0)
+    {
+        bool_t download = (token[0] == 'w' || token[0] == 'W');
+
+        if(numberCount == 0U && node == 0U){
+            error = CO_GATEWAY_ERR_NO_NODE;
+        }
+        else if(node < 1U || node > 127U){
+            error = CO_GATEWAY_ERR_NODE;
+        }
+        else if(!CO_gateway_number(CO_gateway_token(&line), 0xFFFFU, &index) ||
+                !CO_gateway_number(CO_gateway_token(&line), 0xFFU, &subIndex) ||
+                (token = CO_gateway_token(&line)) == NULL)
+        {
+            error = CO_GATEWAY_ERR_SYNTAX;
+        }
+        else{
+            for(dataType=0; dataType<CO_GW_DATATYPE_COUNT; dataType++){
+                if(strcasecmp(token, CO_gateway_dataTypes[dataType].name) == 0){
+                    break;
+                }
+            }
+            for(i=0; i<CO_GATEWAY_MAX_REQUESTS; i++){
+                if(!gw->request[i].used){
+                    req = &gw->request[i];
+                    break;
+                }
+            }
+
+            if(dataType == CO_GW_DATATYPE_COUNT){
+                error = CO_GATEWAY_ERR_SYNTAX;
+            }
+            else if(req == NULL){
+                error = CO_GATEWAY_ERR_STATE;
+            }
+            else{
+                CO_SDOqueueJob_t *job = &req->job;
+
+                job->nodeId = (uint8_t)node;
+                job->index = (uint16_t)index;
+                job->subIndex = (uint8_t)subIndex;
+                job->download = download;
+                job->buffer = req->data;
+                job->pFunctSignal = CO_gateway_jobDone;
+                job->object = gw;
+                if(download){
+                    job->bufferSize = CO_gateway_value(dataType, line, req->data);
+                }
+                else{
+                    job->bufferSize = CO_gateway_dataTypes[dataType].size;
+                    if(job->bufferSize == 0U){
+                        job->bufferSize = CO_GATEWAY_DATA_SIZE - 1U;
+                    }
+                    if(CO_gateway_token(&line) != NULL){
+                        job->bufferSize = 0;
+                    }
+                }
+
+                if(job->bufferSize == 0U){
+                    error = CO_GATEWAY_ERR_SYNTAX;
+                }
+                else if(CO_SDOqueue_submit(gw->SDOqueue, job, 1) != CO_ERROR_NO){
+                    error = CO_GATEWAY_ERR_STATE;
+                }
+                else{
+                    req->conn = (int16_t)connIdx;
+                    req->used = true;
+                    req->dataType = dataType;
+                    req->sequence = sequence;
+                    return; /* response follows from CO_gateway_jobDone() */
+                }
+            }
+        }
+    }
+
+    else{
+        error = CO_GATEWAY_ERR_REQUEST;
+    }
+
+    if(error == 0){
+        CO_gateway_respond(gw, (int16_t)connIdx, sequence, "OK");
+    }
+    else{
+        CO_gateway_respond(gw, (int16_t)connIdx, sequence, "ERROR: %d", error);
+    }
+}
+
+
+/*
+ * Execute received lines of the connection and read more. Reading is
+ * suspended, while no request is free, data stay in the socket.
+ */
+static void CO_gateway_receive(CO_gateway_t *gw, uint16_t i){
+    CO_gatewayConn_t *conn = &gw->conn[i];
+
+    while(conn->fd >= 0){
+        char *newline;
+        ssize_t n;
+
+        while((newline = memchr(conn->rx, '\n', conn->rxLength)) != NULL){
+            uint16_t length = (uint16_t)(newline - conn->rx) + 1U;
+            uint16_t j;
+
+            for(j=0; j<CO_GATEWAY_MAX_REQUESTS; j++){
+                if(!gw->request[j].used){
+                    break;
+                }
+            }
+            if(j == CO_GATEWAY_MAX_REQUESTS){
+                conn->suspended = true;
+                return;
+            }
+
+            *newline = 0;
+            if(length > 1U && newline[-1] == '\r'){
+                newline[-1] = 0;
+            }
+            CO_gateway_command(gw, i, conn->rx);
+            if(conn->fd < 0){
+                return;
+            }
+            conn->rxLength -= length;
+            memmove(conn->rx, &conn->rx[length], conn->rxLength);
+        }
+        conn->suspended = false;
+
+        /* line too long */
+        if(conn->rxLength == CO_GATEWAY_LINE_SIZE){
+            CO_gateway_respond(gw, (int16_t)i, 0, "ERROR: %d", CO_GATEWAY_ERR_SYNTAX);
+            conn->rxLength = 0;
+        }
+
+        n = recv(conn->fd, &conn->rx[conn->rxLength],
+                 CO_GATEWAY_LINE_SIZE - conn->rxLength, MSG_DONTWAIT);
+        if(n > 0){
+            conn->rxLength += (uint16_t)n;
+        }
+        else if(n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)){
+            CO_gateway_closeConn(gw, i);
+        }
+        else{
+            break;
+        }
+    }
+}
+
+
+/*
+ * Accept new connections.
+ */
+static void CO_gateway_accept(CO_gateway_t *gw){
+    for(;;){
+        struct epoll_event ev;
+        uint16_t i;
+        int fd;
+
+        fd = accept4(gw->fdListen, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd < 0){
+            return;
+        }
+        for(i=0; i<CO_GATEWAY_MAX_CONNECTIONS; i++){
+            if(gw->conn[i].fd < 0){
+                break;
+            }
+        }
+        if(i == CO_GATEWAY_MAX_CONNECTIONS){
+            close(fd);
+            continue;
+        }
+
+        gw->conn[i].fd = fd;
+        gw->conn[i].node = 0;
+        gw->conn[i].suspended = false;
+        gw->conn[i].events = EPOLLIN;
+        gw->conn[i].rxLength = 0;
+        gw->conn[i].txLength = 0;
+        if(gw->fdEpoll >= 0){
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            if(epoll_ctl(gw->fdEpoll, EPOLL_CTL_ADD, fd, &ev) != 0){
+                close(fd);
+                gw->conn[i].fd = -1;
+            }
+        }
+    }
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_gateway_init(
+        CO_gateway_t           *gw,
+        CO_t                   *CO,
+        CO_SDOqueue_t          *SDOqueue,
+        uint16_t                port,
+        int                     fdEpoll)
+{
+    struct sockaddr_in addr;
+    struct epoll_event ev;
+    int one = 1;
+    uint16_t i;
+
+    /* verify arguments */
+    if(gw==NULL || CO==NULL || SDOqueue==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    gw->CO = CO;
+    gw->SDOqueue = SDOqueue;
+    gw->fdEpoll = fdEpoll;
+    for(i=0; i<CO_GATEWAY_MAX_CONNECTIONS; i++){
+        gw->conn[i].fd = -1;
+    }
+    for(i=0; i<CO_GATEWAY_MAX_REQUESTS; i++){
+        gw->request[i].used = false;
+        gw->request[i].conn = -1;
+    }
+
+    /* listening socket */
+    gw->fdListen = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(gw->fdListen < 0){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+    (void)setsockopt(gw->fdListen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if(bind(gw->fdListen, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+       listen(gw->fdListen, CO_GATEWAY_MAX_CONNECTIONS) != 0)
+    {
+        close(gw->fdListen);
+        gw->fdListen = -1;
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    if(fdEpoll >= 0){
+        ev.events = EPOLLIN;
+        ev.data.fd = gw->fdListen;
+        if(epoll_ctl(fdEpoll, EPOLL_CTL_ADD, gw->fdListen, &ev) != 0){
+            close(gw->fdListen);
+            gw->fdListen = -1;
+            return CO_ERROR_ILLEGAL_ARGUMENT;
+        }
+    }
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_gateway_close(CO_gateway_t *gw){
+    uint16_t i;
+
+    if(gw == NULL){
+        return;
+    }
+    for(i=0; i<CO_GATEWAY_MAX_CONNECTIONS; i++){
+        CO_gateway_closeConn(gw, i);
+    }
+    CO_SDOqueue_cancel(gw->SDOqueue);
+    if(gw->fdListen >= 0){
+        if(gw->fdEpoll >= 0){
+            (void)epoll_ctl(gw->fdEpoll, EPOLL_CTL_DEL, gw->fdListen, NULL);
+        }
+        close(gw->fdListen);
+        gw->fdListen = -1;
+    }
+}
+
+
+/******************************************************************************/
+void CO_gateway_process(
+        CO_gateway_t           *gw,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms)
+{
+    uint16_t i;
+
+    CO_gateway_accept(gw);
+
+    /* finished transfers respond and free their requests */
+    CO_SDOqueue_process(gw->SDOqueue, timeDifference_ms, timerNext_ms);
+
+    for(i=0; i<CO_GATEWAY_MAX_CONNECTIONS; i++){
+        CO_gateway_receive(gw, i);
+    }
+
+    /* start new requests immediately */
+    CO_SDOqueue_process(gw->SDOqueue, 0, timerNext_ms);
+
+    for(i=0; i<CO_GATEWAY_MAX_CONNECTIONS; i++){
+        CO_gateway_flush(gw, i);
+        CO_gateway_epoll(gw, i);
+    }
+}
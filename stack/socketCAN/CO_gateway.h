@@ -0,0 +1,215 @@
+/**
+ * CiA 309-3 ASCII gateway over TCP for Linux.
+ *
+ * @file        CO_gateway.h
+ * @copyright   2019 Neuberger Gebäudeautomation GmbH
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_GATEWAY_H
+#define CO_GATEWAY_H
+
+
+#include "CANopen.h"
+#include "CO_SDOqueue.h"
+
+
+/**
+ * CiA 309-3 ASCII gateway.
+ *
+ * Supervisory systems connect over TCP and send one command per line:
+ *
+ *     [<sequence>] [[<net>] <node>] r[ead] <index> <subindex> <datatype>
+ *     [<sequence>] [[<net>] <node>] w[rite] <index> <subindex> <datatype> <value>
+ *     [<sequence>] [[<net>] <node>] start | stop | preop[erational]
+ *     [<sequence>] [[<net>] <node>] reset node | reset comm[unication]
+ *     [<sequence>] [<net>] set node <node>
+ *     [<sequence>] [<net>] set sdo_timeout <milliseconds>
+ *
+ * Datatypes are b, i8, i16, i32, i64, u8, u16, u32, u64, x8, x16, x32, x64,
+ * r32, r64 and vs. Only net 1 exists. Each response line starts with the
+ * sequence number of its request: "[<sequence>] OK", "[<sequence>] <value>",
+ * "[<sequence>] ERROR: <code>" with CiA 309-3 error code (100 to 107) or
+ * "[<sequence>] ERROR: 0x<SDO abort code>".
+ *
+ * Clients may send further requests without waiting for responses
+ * (pipelining). SDO requests of all connections are submitted to a
+ * CO_SDOqueue, which executes transfers to different nodes in parallel on
+ * its SDO client channels. Requests to the same node keep their order, so
+ * responses of one node arrive in request order, responses of different
+ * nodes may be reordered. NMT commands are sent immediately. Default node
+ * ("set node") is per connection, SDO timeout is the one of the CO_SDOqueue.
+ * If all #CO_GATEWAY_MAX_REQUESTS are in progress, reading from connections
+ * is suspended until a request finishes.
+ *
+ * Gateway must run in the thread which calls CO_process(), because SDO
+ * client transfers to the own node ID access the own SDO server. Example
+ * with the epoll loop of CO_Linux_tasks.h:
+ *
+ *     CO_SDOqueue_init(&queue, CO->SDOclient, activeJobs, CO_NO_SDO_CLIENT, 1000);
+ *     for(i=0; i<CO_NO_SDO_CLIENT; i++)
+ *         CO_SDOclient_initCallback(CO->SDOclient[i], taskMain_cbSignal);
+ *     CO_gateway_init(&gw, CO, &queue, 60000, fdEpoll);
+ *
+ *     while(reset == CO_RESET_NOT){
+ *         uint16_t timerNext = 50;
+ *         epoll_wait(fdEpoll, &ev, 1, -1);
+ *         if(!taskMain_process(ev.data.fd, &reset, CO_timer1ms))
+ *             CANrx_taskTmr_process(ev.data.fd);
+ *         CO_gateway_process(&gw, diff, &timerNext);
+ *     }
+ *
+ * Uses only POSIX sockets, so it is also used with the neuberger-socketCAN
+ * driver. Needs CO_NO_SDO_CLIENT > 0, NMT commands need CO_NO_NMT_MASTER.
+ */
+
+
+/** Maximum number of TCP connections. */
+#ifndef CO_GATEWAY_MAX_CONNECTIONS
+    #define CO_GATEWAY_MAX_CONNECTIONS  8U
+#endif
+
+/** Maximum number of requests in progress, for all connections together. */
+#ifndef CO_GATEWAY_MAX_REQUESTS
+    #define CO_GATEWAY_MAX_REQUESTS     32U
+#endif
+
+/** Maximum length of a request line. */
+#ifndef CO_GATEWAY_LINE_SIZE
+    #define CO_GATEWAY_LINE_SIZE        256U
+#endif
+
+/** Size of the transmit buffer of each connection. */
+#ifndef CO_GATEWAY_TX_SIZE
+    #define CO_GATEWAY_TX_SIZE          2048U
+#endif
+
+/** Size of the data of each request, longest visible string. */
+#ifndef CO_GATEWAY_DATA_SIZE
+    #define CO_GATEWAY_DATA_SIZE        128U
+#endif
+
+
+/**
+ * CiA 309-3 error codes, used in "ERROR: <code>" responses.
+ */
+typedef enum {
+    CO_GATEWAY_ERR_REQUEST      = 100,  /**< Request not supported */
+    CO_GATEWAY_ERR_SYNTAX       = 101,  /**< Syntax error */
+    CO_GATEWAY_ERR_STATE        = 102,  /**< Request not processed due to internal state */
+    CO_GATEWAY_ERR_TIMEOUT      = 103,  /**< Time-out */
+    CO_GATEWAY_ERR_NO_NET       = 104,  /**< No default net set */
+    CO_GATEWAY_ERR_NO_NODE      = 105,  /**< No default node set */
+    CO_GATEWAY_ERR_NET          = 106,  /**< Unsupported net */
+    CO_GATEWAY_ERR_NODE         = 107   /**< Unsupported node */
+} CO_gateway_error_t;
+
+
+/**
+ * TCP connection of the gateway.
+ */
+typedef struct {
+    int                 fd;         /**< Socket or -1, if not used */
+    uint8_t             node;       /**< Default node, 0 if not set */
+    bool_t              suspended;  /**< Reading suspended, no free request */
+    uint32_t            events;     /**< Events registered in epoll */
+    uint16_t            rxLength;   /**< Number of bytes in rx */
+    uint16_t            txLength;   /**< Number of bytes in tx */
+    char                rx[CO_GATEWAY_LINE_SIZE];   /**< Incomplete lines */
+    char                tx[CO_GATEWAY_TX_SIZE];     /**< Unsent responses */
+} CO_gatewayConn_t;
+
+
+/**
+ * Request in progress, job of the CO_SDOqueue.
+ */
+typedef struct {
+    CO_SDOqueueJob_t    job;        /**< Job, job.object is the gateway */
+    int16_t             conn;       /**< Index of connection, -1 if closed or not used */
+    bool_t              used;       /**< True while job is in the CO_SDOqueue */
+    uint8_t             dataType;   /**< Internal datatype of the value */
+    uint32_t            sequence;   /**< Sequence number of the request */
+    uint8_t             data[CO_GATEWAY_DATA_SIZE]; /**< Buffer of the job */
+} CO_gatewayRequest_t;
+
+
+/**
+ * CiA 309-3 gateway object.
+ */
+typedef struct {
+    CO_t               *CO;         /**< From CO_gateway_init() */
+    CO_SDOqueue_t      *SDOqueue;   /**< From CO_gateway_init() */
+    int                 fdEpoll;    /**< From CO_gateway_init() */
+    int                 fdListen;   /**< Listening socket */
+    CO_gatewayConn_t    conn[CO_GATEWAY_MAX_CONNECTIONS];   /**< Connections */
+    CO_gatewayRequest_t request[CO_GATEWAY_MAX_REQUESTS];   /**< Requests */
+} CO_gateway_t;
+
+
+/**
+ * Initialize gateway and listen for TCP connections.
+ *
+ * @param gw This object will be initialized.
+ * @param CO CANopen object for NMT commands.
+ * @param SDOqueue Initialized SDO client request queue. SDO timeout of the
+ * queue is changed by "set sdo_timeout".
+ * @param port TCP port.
+ * @param fdEpoll File descriptor for Linux epoll API or -1. If set, the
+ * sockets are added to it, so epoll_wait() returns on new connections and
+ * requests.
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT (also
+ * if port can't be opened).
+ */
+CO_ReturnError_t CO_gateway_init(
+        CO_gateway_t           *gw,
+        CO_t                   *CO,
+        CO_SDOqueue_t          *SDOqueue,
+        uint16_t                port,
+        int                     fdEpoll);
+
+
+/**
+ * Close all connections and the listening socket.
+ *
+ * Requests in progress are cancelled with CO_SDOqueue_cancel().
+ *
+ * @param gw This object.
+ */
+void CO_gateway_close(CO_gateway_t *gw);
+
+
+/**
+ * Process gateway.
+ *
+ * Function must be called cyclically and after each epoll event. It accepts
+ * connections, reads and executes requests, processes the CO_SDOqueue and
+ * sends responses. It does not block.
+ *
+ * @param gw This object.
+ * @param timeDifference_ms Time difference from previous function call in [milliseconds].
+ * @param timerNext_ms Return value - info to OS - see CO_process().
+ */
+void CO_gateway_process(
+        CO_gateway_t           *gw,
+        uint16_t                timeDifference_ms,
+        uint16_t               *timerNext_ms);
+
+#endif